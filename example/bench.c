@@ -0,0 +1,480 @@
+/*
+ * Copyright 2023 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Joulescope driver hot path microbenchmarks.
+ *
+ * Each benchmark runs repeatedly for at least the configured duration
+ * and reports samples/s and ns/sample as JSON on stdout.
+ */
+
+#include "jsdrv.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/version.h"
+#include "jsdrv_prv/buffer_signal.h"
+#include "jsdrv_prv/downsample.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/js110_sample_processor.h"
+#include "jsdrv_prv/json.h"
+#include "jsdrv_prv/pubsub.h"
+#include "jsdrv_prv/sample_buffer_f32.h"
+#include "jsdrv_prv/simd_f32.h"
+#include "jsdrv_prv/statistics.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define ARG_CONSUME() --argc; ++argv
+#define ARG_REQUIRE()  if (argc <= 0) {return usage();}
+#define ARRAY_SIZE(x) ( sizeof(x) / sizeof((x)[0]) )
+
+#define BLOCK_SIZE (65536U)
+#define PUBSUB_BLOCK_SIZE (1024U)
+#define PUBSUB_TOPIC "b/bench/value"
+
+
+/**
+ * @brief Run one benchmark iteration.
+ *
+ * @param user_data The benchmark instance.
+ * @return The number of samples processed.
+ */
+typedef uint64_t (*bench_fn)(void * user_data);
+
+struct bench_s {
+    const char * name;
+    int32_t (*setup)(struct bench_s * self);
+    bench_fn run;
+    void (*teardown)(struct bench_s * self);
+    void * user_data;
+};
+
+static float samples_[BLOCK_SIZE];
+static struct jsdrv_context_s * context_ = NULL;
+static uint64_t pubsub_count_ = 0;
+
+
+static double time_now(void) {
+#if _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return ((double) counter.QuadPart) / ((double) frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((double) ts.tv_sec) + ((double) ts.tv_nsec) * 1e-9;
+#endif
+}
+
+static void samples_fill(void) {
+    uint32_t x = 1;
+    for (uint32_t i = 0; i < BLOCK_SIZE; ++i) {
+        x = x * 1664525U + 1013904223U;  // LCG for repeatable data
+        samples_[i] = ((float) (x >> 8)) * 0x1p-24f - 0.5f;
+    }
+}
+
+// --- downsample ---
+
+static int32_t downsample_setup(struct bench_s * self) {
+    self->user_data = jsdrv_downsample_alloc(2000000, 1000, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND);
+    return (NULL == self->user_data) ? JSDRV_ERROR_NOT_ENOUGH_MEMORY : 0;
+}
+
+static void downsample_teardown(struct bench_s * self) {
+    jsdrv_downsample_free((struct jsdrv_downsample_s *) self->user_data);
+    self->user_data = NULL;
+}
+
+static uint64_t downsample_run(void * user_data) {
+    static uint64_t sample_id = 0;
+    float y;
+    for (uint32_t i = 0; i < BLOCK_SIZE; ++i) {
+        jsdrv_downsample_add_f32((struct jsdrv_downsample_s *) user_data, sample_id++, samples_[i], &y);
+    }
+    return BLOCK_SIZE;
+}
+
+static uint64_t downsample_block_run(void * user_data) {
+    static uint64_t sample_id = 0;
+    static float y[BLOCK_SIZE];
+    uint32_t n_out = 0;
+    jsdrv_downsample_add_f32_block((struct jsdrv_downsample_s *) user_data, sample_id, samples_, BLOCK_SIZE, y, &n_out);
+    sample_id += BLOCK_SIZE;
+    return BLOCK_SIZE;
+}
+
+// --- sbuf_f32_mult ---
+
+struct sbuf_bench_s {
+    struct sbuf_f32_s i;
+    struct sbuf_f32_s v;
+    struct sbuf_f32_s p;
+    uint64_t sample_id;
+};
+
+static int32_t sbuf_setup(struct bench_s * self) {
+    struct sbuf_bench_s * s = calloc(1, sizeof(struct sbuf_bench_s));
+    if (NULL == s) {
+        return JSDRV_ERROR_NOT_ENOUGH_MEMORY;
+    }
+    sbuf_f32_clear(&s->i);
+    sbuf_f32_clear(&s->v);
+    sbuf_f32_clear(&s->p);
+    self->user_data = s;
+    return 0;
+}
+
+static void sbuf_teardown(struct bench_s * self) {
+    free(self->user_data);
+    self->user_data = NULL;
+}
+
+static uint64_t sbuf_run(void * user_data) {
+    struct sbuf_bench_s * s = (struct sbuf_bench_s *) user_data;
+    uint64_t count = 0;
+    const uint32_t n = 500;  // odd offset relative to the ring, exercises wrap
+    for (uint32_t k = 0; (k + n) <= BLOCK_SIZE; k += n) {
+        sbuf_f32_add(&s->i, s->sample_id, samples_ + k, n);
+        sbuf_f32_add(&s->v, s->sample_id, samples_ + k, n);
+        s->sample_id += n * s->i.sample_id_decimate;
+        sbuf_f32_mult(&s->p, &s->i, &s->v);
+        count += sbuf_f32_length(&s->p);
+    }
+    return count;
+}
+
+// --- statistics ---
+
+static uint64_t statistics_run(void * user_data) {
+    (void) user_data;
+    struct jsdrv_statistics_accum_s s;
+    jsdrv_statistics_reset(&s);
+    jsdrv_statistics_compute_f32(&s, samples_, BLOCK_SIZE);
+    return BLOCK_SIZE;
+}
+
+// --- bufsig ---
+
+struct bufsig_bench_s {
+    struct bufsig_s b;
+    struct jsdrv_stream_signal_s s;
+};
+
+static int32_t bufsig_setup(struct bench_s * self) {
+    struct bufsig_bench_s * s = calloc(1, sizeof(struct bufsig_bench_s));
+    if (NULL == s) {
+        return JSDRV_ERROR_NOT_ENOUGH_MEMORY;
+    }
+    struct bufsig_s * b = &s->b;
+    jsdrv_cstr_copy(b->topic, "u/js220/0/s/i/!data", sizeof(b->topic));
+    b->hdr.field_id = JSDRV_FIELD_CURRENT;
+    b->hdr.element_type = JSDRV_DATA_TYPE_FLOAT;
+    b->hdr.element_size_bits = 32;
+    b->hdr.decimate_factor = 1;
+    b->hdr.sample_rate = 1000000;
+    b->time_map.counter_rate = (double) b->hdr.sample_rate;
+    b->active = true;
+    jsdrv_bufsig_alloc(b, 1024 * 1024 * 4, 1024, 32);
+
+    s->s.field_id = JSDRV_FIELD_CURRENT;
+    s->s.element_type = JSDRV_DATA_TYPE_FLOAT;
+    s->s.element_size_bits = 32;
+    s->s.element_count = JSDRV_STREAM_DATA_SIZE / sizeof(float);
+    s->s.sample_rate = 1000000;
+    s->s.decimate_factor = 1;
+    s->s.time_map.offset_time = JSDRV_TIME_HOUR;
+    s->s.time_map.counter_rate = s->s.sample_rate;
+    memcpy(s->s.data, samples_, JSDRV_STREAM_DATA_SIZE);
+    self->user_data = s;
+    return 0;
+}
+
+static void bufsig_teardown(struct bench_s * self) {
+    struct bufsig_bench_s * s = (struct bufsig_bench_s *) self->user_data;
+    jsdrv_bufsig_free(&s->b);
+    free(s);
+    self->user_data = NULL;
+}
+
+static uint64_t bufsig_run(void * user_data) {
+    struct bufsig_bench_s * s = (struct bufsig_bench_s *) user_data;
+    jsdrv_bufsig_recv_data(&s->b, &s->s);
+    s->s.sample_id += s->s.element_count;
+    return s->s.element_count;
+}
+
+// --- js110_sp_process ---
+
+static int32_t js110_sp_setup(struct bench_s * self) {
+    struct js110_sp_s * s = calloc(1, sizeof(struct js110_sp_s));
+    if (NULL == s) {
+        return JSDRV_ERROR_NOT_ENOUGH_MEMORY;
+    }
+    js110_sp_initialize(s);
+    for (int i = 0; i < 9; ++i) {
+        s->cal[0][0][i] = (i + 1) * 100.0;
+        s->cal[0][1][i] = pow(10, -3 - i);
+    }
+    for (int i = 0; i < 2; ++i) {
+        s->cal[1][0][i] = (i + 1) * -100.0;
+        s->cal[1][1][i] = pow(10, -4 - i);
+    }
+    self->user_data = s;
+    return 0;
+}
+
+static void js110_sp_teardown(struct bench_s * self) {
+    free(self->user_data);
+    self->user_data = NULL;
+}
+
+static uint64_t js110_sp_run(void * user_data) {
+    struct js110_sp_s * s = (struct js110_sp_s *) user_data;
+    float sum = 0.0f;
+    for (uint32_t k = 0; k < BLOCK_SIZE; ++k) {
+        uint32_t current = 2000 + (k & 0x3ff);
+        uint32_t voltage = 3000 + (k & 0x1ff);
+        uint32_t sample_in =
+                ((current & 0x3fff) << 2)
+                | ((voltage & 0x3fff) << 18)
+                | ((k & 0x1000) ? 1 : 2)       // occasional range change
+                | ((k & 1) ? 0x20000 : 0);     // toggle bit
+        struct js110_sample_s sample = js110_sp_process(s, sample_in, 0);
+        sum += sample.p;
+    }
+    (void) sum;
+    return BLOCK_SIZE;
+}
+
+static uint64_t js110_sp_block_run(void * user_data) {
+    struct js110_sp_s * s = (struct js110_sp_s *) user_data;
+    static uint32_t x[BLOCK_SIZE];
+    static float i[BLOCK_SIZE];
+    static float v[BLOCK_SIZE];
+    static float p[BLOCK_SIZE];
+    static uint8_t current_range[BLOCK_SIZE];
+    static uint8_t gpi0[BLOCK_SIZE];
+    static uint8_t gpi1[BLOCK_SIZE];
+    struct js110_sp_block_s dst = {
+        .i = i, .v = v, .p = p,
+        .current_range = current_range, .gpi0 = gpi0, .gpi1 = gpi1,
+    };
+    for (uint32_t k = 0; k < BLOCK_SIZE; ++k) {
+        uint32_t current = 2000 + (k & 0x3ff);
+        uint32_t voltage = 3000 + (k & 0x1ff);
+        x[k] = ((current & 0x3fff) << 2)
+                | ((voltage & 0x3fff) << 18)
+                | ((k & 0x1000) ? 1 : 2)
+                | ((k & 1) ? 0x20000 : 0);
+    }
+    js110_sp_process_block(s, x, BLOCK_SIZE, 0, &dst);
+    return BLOCK_SIZE;
+}
+
+// --- jsdrv_json_parse ---
+
+static const char JSON_META[] = "{"
+    "\"dtype\": \"u32\","
+    "\"brief\": \"The current range selection.\","
+    "\"detail\": \"Select \\\"auto\\\" for normal operation.  Fixed ranges are useful for debug.\","
+    "\"default\": 128,"
+    "\"options\": ["
+        "[128, \"auto\"],"
+        "[1, \"10 A\", \"10A\"],"
+        "[2, \"180 mA\", \"180mA\"],"
+        "[4, \"18 mA\", \"18mA\"],"
+        "[8, \"1.8 mA\", \"1.8mA\"],"
+        "[16, \"180 \\u00b5A\", \"180uA\"],"
+        "[0, \"off\"]"
+    "],"
+    "\"range\": [0, 255, 1],"
+    "\"flags\": []"
+"}";
+
+static int32_t on_json_token(void * user_data, const struct jsdrv_union_s * token) {
+    (*(uint64_t *) user_data) += token->op;
+    return 0;
+}
+
+static uint64_t json_parse_run(void * user_data) {
+    (void) user_data;
+    uint64_t tokens = 0;
+    for (uint32_t k = 0; k < 64; ++k) {
+        jsdrv_json_parse(JSON_META, on_json_token, &tokens);
+    }
+    return 64 * (sizeof(JSON_META) - 1);  // bytes
+}
+
+// --- jsdrv_pubsub_process ---
+
+static uint8_t on_pubsub(void * user_data, struct jsdrvp_msg_s * msg) {
+    (void) user_data;
+    (void) msg;
+    ++pubsub_count_;
+    return 0;
+}
+
+static int32_t pubsub_setup(struct bench_s * self) {
+    if (NULL == context_) {
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    struct jsdrv_pubsub_s * p = jsdrv_pubsub_initialize(context_);
+    if (NULL == p) {
+        return JSDRV_ERROR_NOT_ENOUGH_MEMORY;
+    }
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context_);
+    jsdrv_cstr_copy(m->topic, JSDRV_PUBSUB_SUBSCRIBE, sizeof(m->topic));
+    m->value.type = JSDRV_UNION_BIN;
+    m->value.value.bin = m->payload.bin;
+    m->value.app = JSDRV_PAYLOAD_TYPE_SUB;
+    jsdrv_cstr_copy(m->payload.sub.topic, PUBSUB_TOPIC, sizeof(m->payload.sub.topic));
+    m->payload.sub.subscriber.is_internal = 1;
+    m->payload.sub.subscriber.internal_fn = on_pubsub;
+    m->payload.sub.subscriber.user_data = NULL;
+    m->payload.sub.subscriber.flags = JSDRV_SFLAG_PUB;
+    jsdrv_pubsub_publish(p, m);
+    jsdrv_pubsub_process(p);
+    self->user_data = p;
+    return 0;
+}
+
+static void pubsub_teardown(struct bench_s * self) {
+    jsdrv_pubsub_finalize((struct jsdrv_pubsub_s *) self->user_data);
+    self->user_data = NULL;
+}
+
+static uint64_t pubsub_run(void * user_data) {
+    struct jsdrv_pubsub_s * p = (struct jsdrv_pubsub_s *) user_data;
+    uint64_t count = pubsub_count_;
+    for (uint32_t k = 0; k < PUBSUB_BLOCK_SIZE; ++k) {
+        jsdrv_pubsub_publish(p, jsdrvp_msg_alloc_value(context_, PUBSUB_TOPIC, &jsdrv_union_u32(k)));
+    }
+    jsdrv_pubsub_process(p);
+    return pubsub_count_ - count;  // delivered messages
+}
+
+static struct bench_s benchmarks_[] = {
+    {"jsdrv_downsample_add_f32", downsample_setup, downsample_run, downsample_teardown, NULL},
+    {"jsdrv_downsample_add_f32_block", downsample_setup, downsample_block_run, downsample_teardown, NULL},
+    {"sbuf_f32_mult", sbuf_setup, sbuf_run, sbuf_teardown, NULL},
+    {"jsdrv_statistics_compute_f32", NULL, statistics_run, NULL, NULL},
+    {"jsdrv_bufsig_recv_data", bufsig_setup, bufsig_run, bufsig_teardown, NULL},
+    {"js110_sp_process", js110_sp_setup, js110_sp_run, js110_sp_teardown, NULL},
+    {"js110_sp_process_block", js110_sp_setup, js110_sp_block_run, js110_sp_teardown, NULL},
+    {"jsdrv_pubsub_process", pubsub_setup, pubsub_run, pubsub_teardown, NULL},
+    {"jsdrv_json_parse", NULL, json_parse_run, NULL, NULL},
+};
+
+static int32_t bench_run(struct bench_s * self, double duration, bool first) {
+    int32_t rc = 0;
+    if (self->setup) {
+        rc = self->setup(self);
+    }
+    if (rc) {
+        printf("%s\n    {\"name\": \"%s\", \"error\": \"%s\"}",
+               first ? "" : ",", self->name, jsdrv_error_code_name(rc));
+        return rc;
+    }
+    self->run(self->user_data);  // warm up caches
+    uint64_t samples = 0;
+    uint32_t iterations = 0;
+    double t_start = time_now();
+    double t_elapsed = 0.0;
+    while (t_elapsed < duration) {
+        samples += self->run(self->user_data);
+        ++iterations;
+        t_elapsed = time_now() - t_start;
+    }
+    if (self->teardown) {
+        self->teardown(self);
+    }
+    printf("%s\n    {\"name\": \"%s\", \"iterations\": %" PRIu32 ", \"samples\": %" PRIu64
+           ", \"duration\": %.6f, \"samples_per_second\": %.1f, \"ns_per_sample\": %.3f}",
+           first ? "" : ",", self->name, iterations, samples, t_elapsed,
+           samples / t_elapsed, (t_elapsed * 1e9) / samples);
+    return 0;
+}
+
+static int usage(void) {
+    printf(
+        "usage: jsdrv_bench [--<arg> <value>]\n"
+        "Run the Joulescope driver microbenchmarks and display JSON results.\n"
+        "\n"
+        "Optional arguments:\n"
+        "  duration_ms  The minimum duration for each benchmark in milliseconds.\n"
+        "               Defaults to 1000.\n"
+        "  filter       Only run benchmarks whose name contains this string.\n"
+    );
+    return 1;
+}
+
+int main(int argc, char * argv[]) {
+    uint32_t duration_ms = 1000;
+    const char * filter = NULL;
+
+    ARG_CONSUME();  // argv[0] == executable path
+    while (argc) {
+        if (0 == strcmp("--duration_ms", argv[0])) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            if (jsdrv_cstr_to_u32(argv[0], &duration_ms) || (0 == duration_ms)) {
+                return usage();
+            }
+            ARG_CONSUME();
+        } else if (0 == strcmp("--filter", argv[0])) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            filter = argv[0];
+            ARG_CONSUME();
+        } else {
+            return usage();
+        }
+    }
+
+    samples_fill();
+    if (jsdrv_initialize(&context_, NULL, 1000)) {
+        context_ = NULL;  // pubsub benchmark reports an error
+    }
+
+    printf("{\n  \"version\": \"%s\",\n  \"simd\": \"%s\",\n  \"results\": [", JSDRV_VERSION_STR, jsdrv_f32_impl());
+    bool first = true;
+    for (size_t i = 0; i < ARRAY_SIZE(benchmarks_); ++i) {
+        if (filter && (NULL == strstr(benchmarks_[i].name, filter))) {
+            continue;
+        }
+        bench_run(&benchmarks_[i], duration_ms * 1e-3, first);
+        first = false;
+    }
+    printf("\n  ]\n}\n");
+
+    if (context_) {
+        jsdrv_finalize(context_, 1000);
+    }
+    return 0;
+}
@@ -284,9 +284,9 @@ static int32_t t_buffer_req(struct app_s * self) {
     struct jsdrv_buffer_request_s req = {
             .version = 1,
             .time_type = JSDRV_TIME_SAMPLES,
-            .rsv1_u8 = 0,
-            .rsv2_u8 = 0,
-            .rsv3_u32 = 0,
+            .flags = 0,
+            .op = JSDRV_BUFFER_REQUEST_OP_DEFAULT,
+            .threshold = 0.0f,
             .time = {.samples = info->time_range_samples},
             .rsp_topic = {'r', '/', 't', 0},
             .rsp_id = 0,
@@ -0,0 +1,573 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * End-to-end throughput benchmark.
+ *
+ * Stream from multiple devices through the full driver pipeline and
+ * report the sustained rate, thread CPU usage, drops and stream
+ * latency as JSON on stdout.
+ */
+
+#include "jsdrv_prv.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/time.h"
+#include "jsdrv/topic.h"
+#include "jsdrv/version.h"
+#include "jsdrv_prv/thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+
+
+#define BENCH_DEVICES_MAX (16U)
+#define BENCH_SIGNALS_MAX (8U)
+#define BENCH_THREADS_MAX (64U)
+#define LATENCY_SAMPLES_MAX (1U << 20)
+#define BENCH_TIMEOUT_MS (JSDRV_TIMEOUT_MS_INIT)  // commands queue behind stream data
+
+enum latency_stage_e {
+    STAGE_DECODE,
+    STAGE_QUEUE,
+    STAGE_DELIVER,
+    STAGE_TOTAL,
+    STAGE_COUNT,
+};
+
+static const char * STAGE_NAMES[STAGE_COUNT] = {"decode", "queue", "deliver", "total"};
+
+struct latency_s {
+    uint32_t count;
+    uint32_t alloc;
+    uint32_t * us;
+};
+
+struct bench_s;
+
+struct bench_signal_s {
+    struct bench_s * parent;
+    char name[JSDRV_TOPIC_LENGTH_MAX];
+    char topic[JSDRV_TOPIC_LENGTH_MAX];     // the !data topic
+    // updated by the frontend thread, read by the main thread
+    volatile uint64_t samples;
+    volatile uint64_t messages;
+    volatile uint64_t gaps;
+    volatile uint64_t gap_samples;
+    uint64_t sample_id_next;
+    uint64_t samples_start;                 // at the measurement start
+    uint64_t samples_end;                   // at the measurement end
+};
+
+struct bench_device_s {
+    char prefix[JSDRV_TOPIC_LENGTH_MAX];
+    bool is_open;
+    struct bench_signal_s signals[BENCH_SIGNALS_MAX];
+};
+
+struct bench_s {
+    struct app_s * app;
+    uint32_t device_count;
+    uint32_t signal_count;
+    struct bench_device_s devices[BENCH_DEVICES_MAX];
+    volatile bool measure;                  // record latency during the measurement
+    struct latency_s latency[STAGE_COUNT];  // frontend thread only
+};
+
+static void latency_add(struct latency_s * l, int64_t duration) {
+    if (l->count >= LATENCY_SAMPLES_MAX) {
+        return;
+    }
+    if (l->count >= l->alloc) {
+        uint32_t alloc = l->alloc ? (l->alloc * 2) : 4096;
+        uint32_t * us = realloc(l->us, alloc * sizeof(uint32_t));
+        if (NULL == us) {
+            return;
+        }
+        l->us = us;
+        l->alloc = alloc;
+    }
+    int64_t us = (duration < 0) ? 0 : (duration / JSDRV_TIME_MICROSECOND);
+    l->us[l->count++] = (us > UINT32_MAX) ? UINT32_MAX : (uint32_t) us;
+}
+
+static int u32_compare(const void * a, const void * b) {
+    uint32_t x = *((const uint32_t *) a);
+    uint32_t y = *((const uint32_t *) b);
+    return (x > y) - (x < y);
+}
+
+// requires sorted samples
+static uint32_t latency_percentile(const struct latency_s * l, uint32_t ppt) {
+    if (0 == l->count) {
+        return 0;
+    }
+    uint64_t idx = ((uint64_t) l->count * ppt) / 1000;
+    if (idx >= l->count) {
+        idx = l->count - 1;
+    }
+    return l->us[idx];
+}
+
+static void on_data(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    (void) topic;
+    int64_t now = jsdrv_time_monotonic();
+    struct bench_signal_s * s = (struct bench_signal_s *) user_data;
+    struct bench_s * self = s->parent;
+    if ((value->type != JSDRV_UNION_BIN) || (value->size < JSDRV_STREAM_HEADER_SIZE)) {
+        return;
+    }
+    const struct jsdrv_stream_signal_s * m = (const struct jsdrv_stream_signal_s *) value->value.bin;
+    uint32_t decimate_factor = m->decimate_factor ? m->decimate_factor : 1;
+    if (s->messages && (m->sample_id != s->sample_id_next)) {
+        ++s->gaps;
+        if (m->sample_id > s->sample_id_next) {
+            s->gap_samples += (m->sample_id - s->sample_id_next) / decimate_factor;
+        }
+    }
+    s->sample_id_next = m->sample_id + (uint64_t) m->element_count * decimate_factor;
+    s->samples += m->element_count;
+    ++s->messages;
+
+    uint32_t offset = JSDRV_STREAM_HEADER_SIZE + (uint32_t) (((uint64_t) m->element_count * m->element_size_bits + 7) / 8);
+    offset = (offset + 7) & ~7U;
+    if (self->measure && (value->size == (offset + sizeof(struct jsdrv_stream_latency_s)))) {
+        struct jsdrv_stream_latency_s t;
+        memcpy(&t, value->value.bin + offset, sizeof(t));
+        if (t.usb) {
+            latency_add(&self->latency[STAGE_DECODE], t.decode - t.usb);
+            latency_add(&self->latency[STAGE_QUEUE], t.dispatch - t.decode);
+            latency_add(&self->latency[STAGE_DELIVER], now - t.dispatch);
+            latency_add(&self->latency[STAGE_TOTAL], now - t.usb);
+        }
+    }
+}
+
+static int32_t publish(struct app_s * self, const char * topic, const struct jsdrv_union_s * value) {
+    int32_t rc = jsdrv_publish(self->context, topic, value, BENCH_TIMEOUT_MS);
+    if (rc) {
+        fprintf(stderr, "publish %s failed with %d %s\n", topic, (int) rc, jsdrv_error_code_name(rc));
+    }
+    return rc;
+}
+
+static int32_t device_publish(struct app_s * self, const char * device, const char * topic, const struct jsdrv_union_s * value) {
+    struct jsdrv_topic_s t;
+    jsdrv_topic_set(&t, device);
+    jsdrv_topic_append(&t, topic);
+    return publish(self, t.topic, value);
+}
+
+static int32_t signals_parse(struct bench_s * self, const char * str) {
+    char names[BENCH_SIGNALS_MAX][JSDRV_TOPIC_LENGTH_MAX];
+    uint32_t count = 0;
+    const char * p = str;
+    while (p && *p) {
+        const char * end = strchr(p, ',');
+        size_t sz = end ? (size_t) (end - p) : strlen(p);
+        if ((0 == sz) || (sz >= JSDRV_TOPIC_LENGTH_MAX) || (count >= BENCH_SIGNALS_MAX)) {
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+        memcpy(names[count], p, sz);
+        names[count][sz] = 0;
+        ++count;
+        p = end ? (end + 1) : NULL;
+    }
+    if (0 == count) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    for (uint32_t i = 0; i < BENCH_DEVICES_MAX; ++i) {
+        for (uint32_t k = 0; k < count; ++k) {
+            jsdrv_cstr_copy(self->devices[i].signals[k].name, names[k], JSDRV_TOPIC_LENGTH_MAX);
+        }
+    }
+    self->signal_count = count;
+    return 0;
+}
+
+static int32_t devices_find(struct bench_s * self, const char * filter, uint32_t count) {
+    struct app_s * app = self->app;
+    ROE(app_scan(app));
+    char * d = app->devices;
+    size_t sz = strlen(d);
+    for (size_t i = 0; (i <= sz) && (self->device_count < count); ++i) {
+        if ((',' == app->devices[i]) || (0 == app->devices[i])) {
+            app->devices[i] = 0;
+            if (d[0] && ((NULL == filter) || jsdrv_cstr_starts_with(d, filter))) {
+                jsdrv_cstr_copy(self->devices[self->device_count++].prefix, d, JSDRV_TOPIC_LENGTH_MAX);
+            }
+            d = &app->devices[i + 1];
+        }
+    }
+    if (0 == self->device_count) {
+        fprintf(stderr, "No matching device found\n");
+        return JSDRV_ERROR_NOT_FOUND;
+    }
+    return 0;
+}
+
+static int32_t emulated_initialize(struct app_s * app, uint32_t js220, uint32_t js110, uint32_t speed) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(js220)},
+            {.topic=JSDRV_ARG_EMULATED_JS110, .value=jsdrv_union_u32(js110)},
+            {.topic=JSDRV_ARG_EMULATED_SPEED, .value=jsdrv_union_u32(speed)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    jsdrv_finalize(app->context, 1000);
+    app->context = NULL;
+    int32_t rc = jsdrv_initialize(&app->context, args, 1000);
+    if (rc) {
+        fprintf(stderr, "jsdrv_initialize failed: %d %s\n", (int) rc, jsdrv_error_code_name(rc));
+    }
+    return rc;
+}
+
+static void signal_topic(struct jsdrv_topic_s * t, const char * device, const struct bench_signal_s * s, const char * leaf) {
+    jsdrv_topic_set(t, device);
+    jsdrv_topic_append(t, "s");
+    jsdrv_topic_append(t, s->name);
+    jsdrv_topic_append(t, leaf);
+}
+
+static int32_t stream_start(struct bench_s * self, uint32_t fs) {
+    struct app_s * app = self->app;
+    struct jsdrv_topic_s t;
+    for (uint32_t i = 0; i < self->device_count; ++i) {
+        struct bench_device_s * d = &self->devices[i];
+        ROE(jsdrv_open(app->context, d->prefix, JSDRV_DEVICE_OPEN_MODE_DEFAULTS));
+        d->is_open = true;
+        if (fs) {
+            ROE(device_publish(app, d->prefix, "h/fs", &jsdrv_union_u32_r(fs)));
+        }
+        for (uint32_t k = 0; k < self->signal_count; ++k) {
+            struct bench_signal_s * s = &d->signals[k];
+            s->parent = self;
+            signal_topic(&t, d->prefix, s, "!data");
+            jsdrv_cstr_copy(s->topic, t.topic, sizeof(s->topic));
+            ROE(jsdrv_subscribe(app->context, s->topic, JSDRV_SFLAG_PUB, on_data, s, JSDRV_TIMEOUT_MS_DEFAULT));
+        }
+    }
+    for (uint32_t i = 0; i < self->device_count; ++i) {
+        struct bench_device_s * d = &self->devices[i];
+        for (uint32_t k = 0; k < self->signal_count; ++k) {
+            signal_topic(&t, d->prefix, &d->signals[k], "ctrl");
+            ROE(publish(app, t.topic, &jsdrv_union_u32_r(1)));
+        }
+    }
+    return 0;
+}
+
+static void stream_stop(struct bench_s * self) {
+    struct app_s * app = self->app;
+    struct jsdrv_topic_s t;
+    for (uint32_t i = 0; i < self->device_count; ++i) {
+        struct bench_device_s * d = &self->devices[i];
+        if (!d->is_open) {
+            continue;
+        }
+        for (uint32_t k = 0; k < self->signal_count; ++k) {
+            signal_topic(&t, d->prefix, &d->signals[k], "ctrl");
+            publish(app, t.topic, &jsdrv_union_u32_r(0));
+            if (d->signals[k].topic[0]) {
+                jsdrv_unsubscribe(app->context, d->signals[k].topic, on_data, &d->signals[k], BENCH_TIMEOUT_MS);
+            }
+        }
+        jsdrv_close(app->context, d->prefix);
+        d->is_open = false;
+    }
+}
+
+static int32_t buffer_start(struct bench_s * self, uint64_t size) {
+    struct app_s * app = self->app;
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    uint32_t signal_id = 1;
+    ROE(publish(app, "m/@/!add", &jsdrv_union_u8_r(1)));
+    for (uint32_t i = 0; i < self->device_count; ++i) {
+        for (uint32_t k = 0; k < self->signal_count; ++k) {
+            struct bench_signal_s * s = &self->devices[i].signals[k];
+            ROE(publish(app, "m/001/a/!add", &jsdrv_union_u8_r((uint8_t) signal_id)));
+            snprintf(topic, sizeof(topic), "m/001/s/%03" PRIu32 "/topic", signal_id);
+            ROE(publish(app, topic, &jsdrv_union_cstr_r(s->topic)));
+            ++signal_id;
+        }
+    }
+    return publish(app, "m/001/g/size", &jsdrv_union_u64_r(size));
+}
+
+static int32_t record_start(struct bench_s * self, const char * path) {
+    struct app_s * app = self->app;
+    char signals[JSDRV_TOPIC_LENGTH_MAX * BENCH_DEVICES_MAX * BENCH_SIGNALS_MAX];
+    signals[0] = 0;
+    for (uint32_t i = 0; i < self->device_count; ++i) {
+        for (uint32_t k = 0; k < self->signal_count; ++k) {
+            if (signals[0]) {
+                jsdrv_cstr_join(signals, signals, ",", sizeof(signals));
+            }
+            jsdrv_cstr_join(signals, signals, self->devices[i].signals[k].topic, sizeof(signals));
+        }
+    }
+    // the recorder only returns codes for actions, and commands apply in order
+    ROE(jsdrv_publish(app->context, "r/001/signals", &jsdrv_union_cstr_r(signals), 0));
+    return publish(app, "r/001/!open", &jsdrv_union_cstr_r(path));
+}
+
+static void samples_snapshot(struct bench_s * self, bool end) {
+    for (uint32_t i = 0; i < self->device_count; ++i) {
+        for (uint32_t k = 0; k < self->signal_count; ++k) {
+            struct bench_signal_s * s = &self->devices[i].signals[k];
+            if (end) {
+                s->samples_end = s->samples;
+            } else {
+                s->samples_start = s->samples;
+            }
+        }
+    }
+}
+
+static void report(struct bench_s * self, double duration_s, const char * config,
+                   const struct jsdrv_thread_cpu_s * cpu0, uint32_t cpu0_count,
+                   const struct jsdrv_thread_cpu_s * cpu1, uint32_t cpu1_count) {
+    uint64_t total_samples = 0;
+    uint64_t total_gaps = 0;
+    uint64_t total_gap_samples = 0;
+    printf("{\n  \"version\": \"%s\",\n  \"platform\": \"%s\",\n", JSDRV_VERSION_STR, PLATFORM);
+    printf("  \"config\": {%s},\n", config);
+    printf("  \"duration_s\": %.3f,\n  \"devices\": [", duration_s);
+    for (uint32_t i = 0; i < self->device_count; ++i) {
+        struct bench_device_s * d = &self->devices[i];
+        printf("%s\n    {\"device\": \"%s\", \"signals\": [", i ? "," : "", d->prefix);
+        for (uint32_t k = 0; k < self->signal_count; ++k) {
+            struct bench_signal_s * s = &d->signals[k];
+            uint64_t samples = s->samples_end - s->samples_start;
+            total_samples += samples;
+            total_gaps += s->gaps;
+            total_gap_samples += s->gap_samples;
+            printf("%s\n      {\"signal\": \"%s\", \"samples_per_s\": %.1f, \"messages\": %" PRIu64
+                   ", \"gaps\": %" PRIu64 ", \"dropped_samples\": %" PRIu64 "}",
+                   k ? "," : "", s->name, samples / duration_s, s->messages, s->gaps, s->gap_samples);
+        }
+        printf("]}");
+    }
+    printf("],\n  \"total\": {\"samples_per_s\": %.1f, \"gaps\": %" PRIu64 ", \"dropped_samples\": %" PRIu64 "},\n",
+           total_samples / duration_s, total_gaps, total_gap_samples);
+
+    printf("  \"threads\": [");
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < cpu1_count; ++i) {
+        const struct jsdrv_thread_cpu_s * t1 = &cpu1[i];
+        int64_t t0 = -1;
+        for (uint32_t j = 0; j < cpu0_count; ++j) {
+            if (cpu0[j].id == t1->id) {
+                t0 = cpu0[j].cpu_time;
+                break;
+            }
+        }
+        if ((t0 < 0) || (t1->cpu_time < 0)) {
+            continue;  // started during the measurement or unavailable
+        }
+        const char * role = jsdrv_thread_role_name(t1->role);
+        printf("%s\n    {\"role\": \"%s\", \"id\": %" PRId64 ", \"cpu_pct\": %.2f}",
+               n++ ? "," : "", role ? role : "unknown", t1->id,
+               100.0 * JSDRV_TIME_TO_F64(t1->cpu_time - t0) / duration_s);
+    }
+    printf("],\n  \"latency_us\": {");
+    for (uint32_t stage = 0; stage < STAGE_COUNT; ++stage) {
+        struct latency_s * l = &self->latency[stage];
+        qsort(l->us, l->count, sizeof(uint32_t), u32_compare);
+        printf("%s\n    \"%s\": {\"count\": %" PRIu32 ", \"p50\": %" PRIu32 ", \"p99\": %" PRIu32
+               ", \"p999\": %" PRIu32 ", \"max\": %" PRIu32 "}",
+               stage ? "," : "", STAGE_NAMES[stage], l->count, latency_percentile(l, 500),
+               latency_percentile(l, 990), latency_percentile(l, 999), l->count ? l->us[l->count - 1] : 0);
+    }
+    printf("}\n}\n");
+}
+
+static int usage(void) {
+    printf("usage: jsdrv_util bench [<option> <value>]\n"
+           "\n"
+           "Stream from devices through the full driver pipeline and\n"
+           "report throughput, thread CPU, drops and latency as JSON.\n"
+           "\n"
+           "Options:\n"
+           "    --emulated      The number of emulated JS220 instruments.\n"
+           "    --js110         The number of emulated JS110 instruments.\n"
+           "    --speed         The emulated speed in percent, 0 for\n"
+           "                    as fast as possible, default 100.\n"
+           "    --devices       The maximum number of devices, default all.\n"
+           "    --filter        The device prefix filter.\n"
+           "    -d, --duration  The measurement duration in milliseconds,\n"
+           "                    default 10000.\n"
+           "    --warmup        The warmup duration in milliseconds,\n"
+           "                    default 500.\n"
+           "    --signals       The comma-separated signals, default i,v.\n"
+           "    -f, --frequency The sampling frequency in Hz.\n"
+           "    --buffer        Also buffer all signals with this size in MiB.\n"
+           "    --record        Also record all signals to this JLS path.\n"
+           );
+    return 1;
+}
+
+int on_bench(struct app_s * self, int argc, char * argv[]) {
+    static struct bench_s bench;
+    struct bench_s * b = &bench;
+    uint32_t js220 = 0;
+    uint32_t js110 = 0;
+    uint32_t speed = 100;
+    uint32_t devices_max = BENCH_DEVICES_MAX;
+    uint32_t warmup_ms = 500;
+    uint32_t fs = 0;
+    uint32_t buffer_mib = 0;
+    const char * filter = NULL;
+    const char * record = NULL;
+    const char * signals = "i,v";
+    memset(b, 0, sizeof(*b));
+    b->app = self;
+    self->duration_ms = 10000;
+
+    while (argc) {
+        if (argv[0][0] != '-') {
+            return usage();
+        } else if (0 == strcmp(argv[0], "--emulated")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            ROE(jsdrv_cstr_to_u32(argv[0], &js220));
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--js110")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            ROE(jsdrv_cstr_to_u32(argv[0], &js110));
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--speed")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            ROE(jsdrv_cstr_to_u32(argv[0], &speed));
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--devices")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            ROE(jsdrv_cstr_to_u32(argv[0], &devices_max));
+            if ((0 == devices_max) || (devices_max > BENCH_DEVICES_MAX)) {
+                return usage();
+            }
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--filter")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            filter = argv[0];
+            ARG_CONSUME();
+        } else if ((0 == strcmp(argv[0], "-d")) || (0 == strcmp(argv[0], "--duration"))) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            ROE(jsdrv_cstr_to_u32(argv[0], &self->duration_ms));
+            if (0 == self->duration_ms) {
+                return usage();
+            }
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--warmup")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            ROE(jsdrv_cstr_to_u32(argv[0], &warmup_ms));
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--signals")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            signals = argv[0];
+            ARG_CONSUME();
+        } else if ((0 == strcmp(argv[0], "-f")) || (0 == strcmp(argv[0], "--frequency"))) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            ROE(jsdrv_cstr_to_u32(argv[0], &fs));
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--buffer")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            ROE(jsdrv_cstr_to_u32(argv[0], &buffer_mib));
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--record")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            record = argv[0];
+            ARG_CONSUME();
+        } else {
+            return usage();
+        }
+    }
+    if (signals_parse(b, signals)) {
+        return usage();
+    }
+    if (js220 || js110) {
+        ROE(emulated_initialize(self, js220, js110, speed));
+    }
+    ROE(devices_find(b, filter, devices_max));
+
+    char config[512];
+    snprintf(config, sizeof(config),
+                 "\"emulated\": %" PRIu32 ", \"js110\": %" PRIu32 ", \"speed\": %" PRIu32
+                 ", \"signals\": \"%s\", \"frequency\": %" PRIu32
+                 ", \"buffer_mib\": %" PRIu32 ", \"record\": %s",
+                 js220, js110, speed, signals, fs, buffer_mib, record ? "true" : "false");
+
+    struct jsdrv_thread_cpu_s cpu0[BENCH_THREADS_MAX];
+    struct jsdrv_thread_cpu_s cpu1[BENCH_THREADS_MAX];
+    uint32_t cpu0_count = 0;
+    uint32_t cpu1_count = 0;
+    int64_t t_start = 0;
+    int64_t t_end = 0;
+
+    publish(self, JSDRV_MSG_LATENCY "/trailer", &jsdrv_union_u8_r(1));
+    int32_t rc = stream_start(b, fs);
+    if (!rc && buffer_mib) {
+        rc = buffer_start(b, ((uint64_t) buffer_mib) << 20);
+    }
+    if (!rc && record) {
+        rc = record_start(b, record);
+    }
+    if (!rc) {
+        int64_t t_warmup = jsdrv_time_monotonic() + warmup_ms * JSDRV_TIME_MILLISECOND;
+        while (!quit_ && (jsdrv_time_monotonic() < t_warmup)) {
+            jsdrv_thread_sleep_ms(10);
+        }
+        samples_snapshot(b, false);
+        cpu0_count = jsdrv_thread_cpu_get(cpu0, BENCH_THREADS_MAX);
+        b->measure = true;
+        t_start = jsdrv_time_monotonic();
+        int64_t t_stop = t_start + self->duration_ms * JSDRV_TIME_MILLISECOND;
+        while (!quit_ && (jsdrv_time_monotonic() < t_stop)) {
+            jsdrv_thread_sleep_ms(10);
+        }
+        t_end = jsdrv_time_monotonic();
+        cpu1_count = jsdrv_thread_cpu_get(cpu1, BENCH_THREADS_MAX);
+        samples_snapshot(b, true);
+        b->measure = false;
+    }
+    if (record) {
+        publish(self, "r/001/!close", &jsdrv_union_i32_r(0));
+    }
+    stream_stop(b);
+    if (buffer_mib) {
+        publish(self, "m/@/!remove", &jsdrv_union_u8_r(1));
+    }
+    publish(self, JSDRV_MSG_LATENCY "/trailer", &jsdrv_union_u8_r(0));
+
+    if (!rc) {
+        report(b, JSDRV_TIME_TO_F64(t_end - t_start), config, cpu0, cpu0_count, cpu1, cpu1_count);
+    }
+    for (uint32_t stage = 0; stage < STAGE_COUNT; ++stage) {
+        free(b->latency[stage].us);
+    }
+    return rc;
+}
@@ -16,13 +16,17 @@
 
 #include "jsdrv_prv.h"
 #include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
 #include "jsdrv/time.h"
 #include "jsdrv/topic.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/file_writer.h"
 #include "jsdrv_prv/log.h"
 #include "jsdrv_prv/platform.h"
 #include "jsdrv_prv/thread.h"
 #include <stdio.h>
 #include <inttypes.h>
+#include <string.h>
 
 
 static int32_t publish(struct app_s * self, const char * device, const char * topic, const struct jsdrv_union_s * value, uint32_t timeout_ms) {
@@ -39,9 +43,17 @@ static int32_t publish(struct app_s * self, const char * device, const char * to
     return rc;
 }
 
+struct capture_file_s {
+    const char * channel;
+    const char * filename;
+    struct jsdrv_file_writer_s * writer;
+    uint64_t drop_count;            // frontend thread only
+    uint64_t bytes_written_prev;    // for the throughput report
+};
+
 static void data_fn(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
     (void) topic;
-    FILE * f = (FILE *) user_data;
+    struct capture_file_s * f = (struct capture_file_s *) user_data;
     if (value->type != JSDRV_UNION_BIN) {
         printf("data_fn: unsupported type\n");
         return;
@@ -51,67 +63,107 @@ static void data_fn(void * user_data, const char * topic, const struct jsdrv_uni
         printf("data_fn: unsupported data type\n");
         return;
     }
-    fwrite(s->data, 1, (s->element_count * s->element_size_bits) / 8, f);
+    // copy only: the writer thread performs the file I/O
+    if (jsdrv_file_writer_write(f->writer, s->data, (s->element_count * s->element_size_bits) / 8)) {
+        ++f->drop_count;
+    }
 }
 
-static FILE * channel_init(struct app_s * self, const char * device, const char * channel, const char * filename) {
+static int32_t channel_init(struct app_s * self, const char * device, struct capture_file_s * f,
+                            const struct jsdrv_file_writer_config_s * config) {
     int32_t rc;
     struct jsdrv_topic_s t;
-    if (NULL == filename) {
-        return NULL;
+    if (NULL == f->filename) {
+        return 0;
     }
-    FILE * f = fopen(filename, "wb");
-    if (NULL == f) {
-        return NULL;
+    f->writer = jsdrv_file_writer_open(f->filename, config);
+    if (NULL == f->writer) {
+        printf("could not open %s\n", f->filename);
+        return JSDRV_ERROR_IO;
     }
     jsdrv_topic_set(&t, device);
     jsdrv_topic_append(&t, "s");
-    jsdrv_topic_append(&t, channel);
+    jsdrv_topic_append(&t, f->channel);
     jsdrv_topic_append(&t, "ctrl");
     rc = jsdrv_publish(self->context, t.topic, &jsdrv_union_u32_r(1), 0);
     if (rc) {
-        fclose(f);
-        return NULL;
+        jsdrv_file_writer_close(f->writer);
+        f->writer = NULL;
+        return rc;
     }
 
     jsdrv_topic_set(&t, device);
     jsdrv_topic_append(&t, "s");
-    jsdrv_topic_append(&t, channel);
+    jsdrv_topic_append(&t, f->channel);
     jsdrv_topic_append(&t, "!data");
-    rc = jsdrv_subscribe(self->context, t.topic, JSDRV_SFLAG_PUB, data_fn, (void *) f, 0);
+    rc = jsdrv_subscribe(self->context, t.topic, JSDRV_SFLAG_PUB, data_fn, f, 0);
     if (rc) {
-        fclose(f);
-        return NULL;
+        jsdrv_file_writer_close(f->writer);
+        f->writer = NULL;
+        return rc;
+    }
+    return 0;
+}
+
+static void channel_report(struct capture_file_s * f, double duration_s, bool final) {
+    struct jsdrv_file_writer_status_s status;
+    if (NULL == f->writer) {
+        return;
+    }
+    if (final) {
+        jsdrv_file_writer_flush(f->writer);
+        jsdrv_file_writer_status(f->writer, &status);
+        while (status.backlog) {  // report the complete file
+            jsdrv_thread_sleep_ms(1);
+            jsdrv_file_writer_status(f->writer, &status);
+        }
+    } else {
+        jsdrv_file_writer_status(f->writer, &status);
     }
-    return f;
+    uint64_t bytes = final ? status.bytes_written : (status.bytes_written - f->bytes_written_prev);
+    f->bytes_written_prev = status.bytes_written;
+    double buffer_mb = jsdrv_file_writer_buffer_size(f->writer) / 1e6;
+    double write_s = JSDRV_TIME_TO_F64(status.write_time);
+    printf("%s: %.2f MB/s, %.1f MB written, backlog %" PRIu32 " (peak %" PRIu32 ") x %.1f MB, "
+           "write max %.1f ms, device %.2f MB/s, %" PRIu64 " dropped%s\n",
+           f->channel, (bytes / 1e6) / duration_s, status.bytes_written / 1e6,
+           status.backlog, status.backlog_max, buffer_mb,
+           JSDRV_TIME_TO_F64(status.write_time_max) * 1000.0,
+           (write_s > 0.0) ? ((status.bytes_written / 1e6) / write_s) : 0.0,
+           f->drop_count, status.error ? ", WRITE ERROR" : "");
 }
 
-static void channel_finalize(struct app_s * self, const char * device, const char * channel, FILE * f) {
+static void channel_finalize(struct app_s * self, const char * device, struct capture_file_s * f, double duration_s) {
     int32_t rc;
     struct jsdrv_topic_s t;
-    if (f == NULL) {
+    if (f->writer == NULL) {
         return;
     }
 
     jsdrv_topic_set(&t, device);
     jsdrv_topic_append(&t, "s");
-    jsdrv_topic_append(&t, channel);
+    jsdrv_topic_append(&t, f->channel);
     jsdrv_topic_append(&t, "!data");
-    rc = jsdrv_unsubscribe(self->context, t.topic, data_fn, (void *) f, 0);
+    rc = jsdrv_unsubscribe(self->context, t.topic, data_fn, f, 0);
     if (rc) {
         printf("jsdrv_unsubscribe failed with %d\n", rc);
     }
 
     jsdrv_topic_set(&t, device);
     jsdrv_topic_append(&t, "s");
-    jsdrv_topic_append(&t, channel);
+    jsdrv_topic_append(&t, f->channel);
     jsdrv_topic_append(&t, "ctrl");
     rc = jsdrv_publish(self->context, t.topic, &jsdrv_union_u32_r(0), JSDRV_TIMEOUT_MS_DEFAULT);
     if (rc) {
         printf("jsdrv_publish failed with %d\n", rc);
     }
 
-    fclose(f);
+    channel_report(f, duration_s, true);
+    rc = jsdrv_file_writer_close(f->writer);
+    if (rc) {
+        printf("%s: close failed with %d\n", f->filename, rc);
+    }
+    f->writer = NULL;
 }
 
 
@@ -122,23 +174,39 @@ static int usage(void) {
            "    -d, --duration  The duration in milliseconds.\n"
            "                    0 (default) runs until CTRL-C\n"
            "    -f, --frequency The sampling frequency in Hz.\n"
-           "    --filter        Downsample filter type uint32.\n"
+           "    --filter        Downsample filter type uint32: 0 wideband,\n"
+           "                    1 sinc1, 2 cic, 3 cic_comp.\n"
            "    -i, --current   The capture filename for current.\n"
            "    -v, --voltage   The capture filename for voltage.\n"
            "    -p, --power     The capture filename for power.\n"
+           "    --buffer-size   The write buffer size in KiB, default 4096.\n"
+           "    --buffers       The number of write buffers, default 8.\n"
+           "    --direct        Bypass the OS cache when supported.\n"
+           "    --preallocate   Reserve file storage in MiB for each file.\n"
+           "    --fsync         Flush to storage: none (default), close,\n"
+           "                    interval or buffer.\n"
+           "    --fsync-interval\n"
+           "                    The interval fsync period in milliseconds.\n"
+           "    --report        The status report period in milliseconds.\n"
+           "                    0 reports only on close, default 1000.\n"
            "\n");
     return 1;
 }
 
 int on_capture(struct app_s * self, int argc, char * argv[]) {
+    static const char * const sync_names[] = {"none", "close", "interval", "buffer", NULL};
     uint32_t frequency = 0;
     uint32_t filter = 0;
-    char * filename_i = NULL;
-    char * filename_v = NULL;
-    char * filename_p = NULL;
-    FILE * file_i = NULL;
-    FILE * file_v = NULL;
-    FILE * file_p = NULL;
+    uint32_t value = 0;
+    uint32_t report_ms = 1000;
+    int sync = JSDRV_FILE_WRITER_SYNC_NONE;
+    struct jsdrv_file_writer_config_s config;
+    struct capture_file_s files[] = {
+        {.channel = "i"},
+        {.channel = "v"},
+        {.channel = "p"},
+    };
+    memset(&config, 0, sizeof(config));
 
     while (argc) {
         if (argv[0][0] != '-') {
@@ -161,17 +229,58 @@ int on_capture(struct app_s * self, int argc, char * argv[]) {
         } else if ((0 == strcmp(argv[0], "-i")) || (0 == strcmp(argv[0], "--current"))) {
             ARG_CONSUME();
             ARG_REQUIRE();
-            filename_i = argv[0];
+            files[0].filename = argv[0];
             ARG_CONSUME();
         } else if ((0 == strcmp(argv[0], "-v")) || (0 == strcmp(argv[0], "--voltage"))) {
             ARG_CONSUME();
             ARG_REQUIRE();
-            filename_v = argv[0];
+            files[1].filename = argv[0];
             ARG_CONSUME();
         } else if ((0 == strcmp(argv[0], "-p")) || (0 == strcmp(argv[0], "--power"))) {
             ARG_CONSUME();
             ARG_REQUIRE();
-            filename_p = argv[0];
+            files[2].filename = argv[0];
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--buffer-size")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            ROE(jsdrv_cstr_to_u32(argv[0], &value));
+            if ((0 == value) || (value > (1024U * 1024U))) {
+                return usage();
+            }
+            config.buffer_size = value * 1024U;
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--buffers")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            ROE(jsdrv_cstr_to_u32(argv[0], &config.buffer_count));
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--direct")) {
+            ARG_CONSUME();
+            config.flags |= JSDRV_FILE_WRITER_FLAG_DIRECT;
+        } else if (0 == strcmp(argv[0], "--preallocate")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            ROE(jsdrv_cstr_to_u32(argv[0], &value));
+            config.preallocate = ((uint64_t) value) * 1024U * 1024U;
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--fsync")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            if (jsdrv_cstr_to_index(argv[0], sync_names, &sync)) {
+                return usage();
+            }
+            config.sync = (uint32_t) sync;
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--fsync-interval")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            ROE(jsdrv_cstr_to_u32(argv[0], &config.sync_interval_ms));
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--report")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            ROE(jsdrv_cstr_to_u32(argv[0], &report_ms));
             ARG_CONSUME();
         } else {
             return usage();
@@ -193,21 +302,32 @@ int on_capture(struct app_s * self, int argc, char * argv[]) {
         ROE(publish(self, device, "h/fs", &jsdrv_union_u32_r(frequency), 0));
     }
 
-    file_i = channel_init(self, device, "i", filename_i);
-    file_v = channel_init(self, device, "v", filename_v);
-    file_p = channel_init(self, device, "p", filename_p);
+    int32_t rc = 0;
+    for (uint32_t k = 0; !rc && (k < JSDRV_ARRAY_SIZE(files)); ++k) {
+        rc = channel_init(self, device, &files[k], &config);
+    }
 
-    int64_t t_end = jsdrv_time_utc() + JSDRV_TIME_MILLISECOND * (int64_t) self->duration_ms;
-    while (!quit_) {
+    int64_t t_start = jsdrv_time_utc();
+    int64_t t_end = t_start + JSDRV_TIME_MILLISECOND * (int64_t) self->duration_ms;
+    int64_t t_report = t_start;
+    while (!rc && !quit_) {
         jsdrv_thread_sleep_ms(1); // do nothing
-        if (self->duration_ms && (jsdrv_time_utc() >= t_end)) {
+        int64_t t_now = jsdrv_time_utc();
+        if (report_ms && ((t_now - t_report) >= (JSDRV_TIME_MILLISECOND * (int64_t) report_ms))) {
+            for (uint32_t k = 0; k < JSDRV_ARRAY_SIZE(files); ++k) {
+                channel_report(&files[k], JSDRV_TIME_TO_F64(t_now - t_report), false);
+            }
+            t_report = t_now;
+        }
+        if (self->duration_ms && (t_now >= t_end)) {
             break;
         }
     }
 
-    channel_finalize(self, device, "i", file_i);
-    channel_finalize(self, device, "v", file_v);
-    channel_finalize(self, device, "p", file_p);
+    double duration_s = JSDRV_TIME_TO_F64(jsdrv_time_utc() - t_start);
+    for (uint32_t k = 0; k < JSDRV_ARRAY_SIZE(files); ++k) {
+        channel_finalize(self, device, &files[k], duration_s);
+    }
     ROE(publish(self, device, JSDRV_MSG_CLOSE, &jsdrv_union_i32(0), JSDRV_TIMEOUT_MS_DEFAULT));
-    return 0;
+    return rc;
 }
@@ -122,6 +122,7 @@ int32_t app_match(struct app_s * self, const char * filter) {
 }
 
 const struct command_s COMMANDS[] = {
+        {"bench", on_bench, "Benchmark end-to-end streaming throughput"},
         {"capture", on_capture, "Capture sample data to a file"},
         {"demo", on_demo, "Demonstrate streaming"},
         {"dev",  on_dev,  "Developer tools"},
@@ -132,6 +133,7 @@ const struct command_s COMMANDS[] = {
         {"mem_write", on_mem_write, "Write memory region"},
         {"reset", on_reset, "Reset to target"},
         {"scan", on_scan, "List connected devices"},
+        {"server", on_server, "Serve the pubsub tree over TCP"},
         {"set",  on_set,  "Set parameters"},
         {"statistics",  on_statistics,  "Display statistics from all connected devices"},
         {"stream_buffer",  on_stream_buffer,  "Demonstrate stream buffer"},
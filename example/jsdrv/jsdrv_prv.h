@@ -77,6 +77,7 @@ int32_t app_match(struct app_s * self, const char * filter);
 typedef int (*command_fn)(struct app_s * self, int argc, char * argv[]);
 
 int on_help(struct app_s * self, int argc, char * argv[]);
+int on_bench(struct app_s * self, int argc, char * argv[]);
 int on_capture(struct app_s * self, int argc, char * argv[]);
 int on_demo(struct app_s * self, int argc, char * argv[]);
 int on_dev(struct app_s * self, int argc, char * argv[]);
@@ -87,6 +88,7 @@ int on_mem_read(struct app_s * self, int argc, char * argv[]);
 int on_mem_write(struct app_s * self, int argc, char * argv[]);
 int on_reset(struct app_s * self, int argc, char * argv[]);
 int on_scan(struct app_s * self, int argc, char * argv[]);
+int on_server(struct app_s * self, int argc, char * argv[]);
 int on_set(struct app_s * self, int argc, char * argv[]);
 int on_statistics(struct app_s * self, int argc, char * argv[]);
 int on_stream_buffer(struct app_s * self, int argc, char * argv[]);
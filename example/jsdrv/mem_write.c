@@ -26,50 +26,16 @@
 
 
 static int usage() {
-    printf("usage: jsdrv_util mem_write [--device {device_path}] [--timeout {timeout_ms}] {region} {file}\n");
+    printf("usage: jsdrv_util mem_write [--device {device_path}] [--timeout {timeout_ms}] [--verify] {region} {file}\n");
     return 1;
 }
 
-static int32_t file_read(const char * filename, uint8_t ** data, uint32_t * size) {
-    FILE * fh = fopen(filename, "rb");
-    if (NULL == fh) {
-        printf("Could not open file: %s\n", filename);
-        return 1;
-    }
-    if (fseek(fh, 0, SEEK_END)) {
-        printf("Could not seek to end\n");
-        return 1;
-    }
-    long sz = ftell(fh);
-    uint8_t * p = malloc(sz);
-    if (NULL == p) {
-        printf("Could not allocate memory for file data\n");
-        return 1;
-    }
-    if (fseek(fh, 0, SEEK_SET)) {
-        printf("Could not seek to beginning\n");
-        return 1;
-    }
-
-    size_t sz_read = fread(p, 1, sz, fh);
-    fclose(fh);
-
-    if (sz_read != (size_t) sz) {
-        printf("Could not read entire file: %d != %d\n", (int) sz_read, (int) sz);
-        return 1;
-    }
-
-    *data = p;
-    *size = (uint32_t) sz;
-    return 0;
-}
-
-
 int on_mem_write(struct app_s * self, int argc, char * argv[]) {
     char * device = NULL;
     char * region = NULL;
     int npos = 0;
     uint32_t write_timeout_ms = WRITE_TIMEOUT_MS;
+    bool verify = false;
 
     while (argc) {
         if (argv[0][0] != '-') {
@@ -96,6 +62,9 @@ int on_mem_write(struct app_s * self, int argc, char * argv[]) {
             }
             device = argv[0];
             ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--verify")) {
+            verify = true;
+            ARG_CONSUME();
         } else if ((0 == strcmp(argv[0], "--verbose")) || (0 == strcmp(argv[0], "-v"))) {
             self->verbose++;
             ARG_CONSUME();
@@ -110,13 +79,6 @@ int on_mem_write(struct app_s * self, int argc, char * argv[]) {
 
     ROE(app_match(self, device));
 
-    uint8_t * data;
-    uint32_t data_size;
-    if (file_read(self->filename, &data, &data_size)) {
-        printf("File read failed\n");
-        return usage();
-    }
-
     struct jsdrv_topic_s topic;
     jsdrv_topic_set(&topic, self->device.topic);
 
@@ -128,8 +90,15 @@ int on_mem_write(struct app_s * self, int argc, char * argv[]) {
     jsdrv_topic_append(&topic, "h/mem");
     jsdrv_topic_append(&topic, region);
     jsdrv_topic_append(&topic, "!write");
-    ROE(jsdrv_publish(self->context, topic.topic, &jsdrv_union_bin(data, data_size), write_timeout_ms));
-    free(data);
+    // The driver streams the file in chunks, see h/mem/{xx}/!write
+    ROE(jsdrv_publish(self->context, topic.topic, &jsdrv_union_cstr(self->filename), write_timeout_ms));
+
+    if (verify) {
+        // Uses the instrument hash when supported, otherwise reads back
+        jsdrv_topic_remove(&topic);
+        jsdrv_topic_append(&topic, "!verify");
+        ROE(jsdrv_publish(self->context, topic.topic, &jsdrv_union_cstr(self->filename), write_timeout_ms));
+    }
 
     jsdrv_topic_set(&topic, self->device.topic);
     jsdrv_topic_append(&topic, JSDRV_MSG_CLOSE);
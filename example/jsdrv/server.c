@@ -0,0 +1,96 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/net.h"
+#include <stdio.h>
+#include <string.h>
+
+static int usage(void) {
+    printf("usage: jsdrv_util server [--host <HOST>] [--port <PORT>] [--queue <BYTES>] [--read-only]\n"
+           "\n"
+           "Serve the driver pubsub tree to remote clients over TCP.\n"
+           "Other processes share the devices using jsdrv_net_client_open().\n"
+           "WARNING: the server has no authentication or encryption.  Any peer\n"
+           "that connects can publish to any topic and control the devices.\n"
+           "--host: The local address to bind.  Default is 127.0.0.1, which only\n"
+           "    accepts local clients.  Use 0.0.0.0 to expose the server on all\n"
+           "    interfaces, and only on trusted networks.\n"
+           "--port: The TCP port.  Default is %u.\n"
+           "--queue: The transmit queue size for each client in bytes.\n"
+           "    Stream data is discarded for clients that fall behind.\n"
+           "--read-only: Reject publish from clients, which may still query\n"
+           "    and subscribe.\n",
+           (unsigned int) JSDRV_NET_PORT_DEFAULT);
+    return 1;
+}
+
+int on_server(struct app_s * self, int argc, char * argv[]) {
+    struct jsdrv_net_server_config_s config = {
+        .host = NULL,
+        .port = JSDRV_NET_PORT_DEFAULT,
+        .queue_size = 0,
+        .read_only = 0,
+    };
+    struct jsdrv_net_server_s * server = NULL;
+    uint32_t value;
+
+    while (argc) {
+        if (argv[0][0] != '-') {
+            return usage();
+        } else if (0 == strcmp(argv[0], "--host")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            config.host = argv[0];
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--port")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            if (jsdrv_cstr_to_u32(argv[0], &value) || (value > 65535)) {
+                return usage();
+            }
+            config.port = (uint16_t) value;
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--queue")) {
+            ARG_CONSUME();
+            ARG_REQUIRE();
+            ROE(jsdrv_cstr_to_u32(argv[0], &config.queue_size));
+            ARG_CONSUME();
+        } else if (0 == strcmp(argv[0], "--read-only")) {
+            ARG_CONSUME();
+            config.read_only = 1;
+        } else {
+            return usage();
+        }
+    }
+
+    int32_t rc = jsdrv_net_server_open(self->context, &config, &server);
+    if (rc) {
+        printf("Could not start server: %s\n", jsdrv_error_code_name(rc));
+        return rc;
+    }
+    printf("# Serving on %s port %u%s.\n", config.host ? config.host : "127.0.0.1",
+           (unsigned int) jsdrv_net_server_port(server), config.read_only ? ", read-only" : "");
+    printf("# Press CTRL-C to exit.\n");
+    while (!quit_) {
+        jsdrv_thread_sleep_ms(10);
+    }
+    jsdrv_net_server_close(server);
+    return 0;
+}
@@ -27,6 +27,7 @@
 #include "jsdrv/union.h"
 #include "jsdrv/time.h"
 #include <stdint.h>
+#include <stddef.h>
 
 /**
  * @defgroup jsdrv jsdrv
@@ -126,8 +127,29 @@
 #define JSDRV_PAYLOAD_LENGTH_MAX        (1024U)
 /// The header size of jsdrv_stream_signal_s before the data field.
 #define JSDRV_STREAM_HEADER_SIZE        (48U)
-/// The size of data in jsdrv_stream_signal_s.
+/**
+ * @brief The size of data in jsdrv_stream_signal_s.
+ *
+ * The JSDRV_PROFILE "embedded" CMake build profile reduces this size.
+ * Code that includes this header must use the same value as the library.
+ */
+#ifndef JSDRV_STREAM_DATA_SIZE
 #define JSDRV_STREAM_DATA_SIZE          (1024 * 64)    // 64 kB max
+#endif
+/// The maximum number of channels in jsdrv_stream_frame_s.
+#define JSDRV_STREAM_FRAME_CHANNELS_MAX (12U)
+/// The header size of jsdrv_stream_frame_s before the data field.
+#define JSDRV_STREAM_FRAME_HEADER_SIZE  (48U + 8U * JSDRV_STREAM_FRAME_CHANNELS_MAX)
+/// The size of data in jsdrv_stream_frame_s, which matches the jsdrv_stream_signal_s total size.
+#define JSDRV_STREAM_FRAME_DATA_SIZE    (JSDRV_STREAM_HEADER_SIZE + JSDRV_STREAM_DATA_SIZE - JSDRV_STREAM_FRAME_HEADER_SIZE)
+/// The maximum number of sources for the time alignment service.
+#define JSDRV_ALIGN_SOURCES_MAX         (8U)
+/// The maximum number of devices in jsdrv_statistics_all_s.
+#define JSDRV_STATISTICS_ALL_DEVICES_MAX (32U)
+/// The maximum JSDRV_MSG_STATISTICS_HISTORY records for each device.
+#define JSDRV_STATISTICS_HISTORY_MAX (65536U)
+/// The maximum records in each jsdrv_statistics_history_response_s.
+#define JSDRV_STATISTICS_HISTORY_RESPONSE_COUNT (256U)
 
 /**
  * @defgroup jsdrv_topis Topics
@@ -183,6 +205,170 @@
 #define JSDRV_MSG_VERSION               "@/version"     ///< Driver version: subscribe only JSDRV version (u32)
 #define JSDRV_MSG_TIMEOUT               "@/timeout"     ///< UnhandledDriver version: subscribe only JSDRV version (u32)
 
+/**
+ * @brief Message pool telemetry topic prefixes.
+ *
+ * Each pool publishes the u32 subtopics "alloc" (allocated messages),
+ * "in_use", "peak" (in_use high-water mark) and "heap" (heap
+ * fallbacks on empty pool), such as "@/pool/msg/in_use".
+ * The small pool holds the return codes and retained scalar values.
+ * The data pool has size classes "1k", "8k" and "64k", such as
+ * "@/pool/data/64k/in_use".
+ * The values are subscribe only and update at most once per second.
+ */
+#define JSDRV_MSG_POOL_MSG              "@/pool/msg"    ///< Normal message pool telemetry prefix
+#define JSDRV_MSG_POOL_SMALL            "@/pool/small"  ///< Small message pool telemetry prefix
+#define JSDRV_MSG_POOL_DATA             "@/pool/data"   ///< Stream data message pool size class telemetry prefix
+
+/**
+ * @brief Driver performance counter topic prefix.
+ *
+ * Each counter publishes a u64 subtopic, such as "@/perf/rx".
+ * The counters are process-wide and monotonic:
+ * - "xfer": USB bulk in transfers completed.
+ * - "rx": USB bulk in bytes received.
+ * - "loan/0" through "loan/7": histogram of the time the backend
+ *   waits for each bulk in buffer to return before it can resubmit
+ *   the buffer, in power-of-4 bins from < 16 us to >= 64 ms.
+ * - "be_max": maximum backend messages drained in one frontend wake.
+ * - "be_ctl", "be_data": maximum backend control and data lane depth
+ *   at a frontend wake.
+ * - "ps_msg", "ps_us": pubsub messages processed and total time (us).
+ * - "data": stream data messages published.
+ * - "buf_us": memory buffer insert time (us).
+ * - "ds_us": downsample filter time (us).
+ * - "q_cache": jsdrv_query() calls served without a frontend round trip.
+ * - "pub_dir": jsdrv_publish() calls sent directly to the device.
+ * The values are subscribe only and update at most once per second.
+ * Builds with JSDRV_PERF_ENABLE=0 do not publish these values.
+ */
+#define JSDRV_MSG_PERF                  "@/perf"        ///< Performance counter telemetry prefix
+
+/**
+ * @brief Driver memory accounting topic prefix.
+ *
+ * Each allocation category publishes the u64 subtopics "bytes" (in
+ * use, including allocator overhead), "count" (allocations in use) and
+ * "peak" (bytes high-water mark), such as "@/alloc/buffer/bytes".
+ * The categories are "other", "msg" (messages and message pools),
+ * "pubsub" (topics, metadata, retained values and subscribers),
+ * "buffer" (memory buffer rings and summaries), "log" and "xfer"
+ * (USB transfer buffers).
+ * The totals are process-wide, subscribe only and update at most once
+ * per second.
+ *
+ * Publish 1 to "@/alloc/!trace" to record the call stack of each new
+ * allocation, or 0 to stop.  Publish a file path str to
+ * "@/alloc/!dump" to write the outstanding traced allocations as JSON.
+ * Tracing slows every allocation, so only enable it for leak and
+ * growth analysis.
+ */
+#define JSDRV_MSG_ALLOC                 "@/alloc"       ///< Memory accounting telemetry prefix
+
+/**
+ * @brief Driver thread policy topic prefix.
+ *
+ * Each thread role has the subtopics "policy" (u8: 0=default,
+ * 1=other, 2=fifo, 3=rr), "prio" (i32: nice -20 to 19 for other,
+ * 1 to 99 for fifo and rr) and "cpus" (u64 CPU affinity bit mask,
+ * 0 leaves the affinity unchanged), such as "@/threads/usb/cpus".
+ * The roles are "front" (frontend), "usb", "device" (sample decode),
+ * "buffer", "disp" (data dispatch), "writer", "net" and "log".
+ * A change applies immediately to all running threads of the role
+ * and to threads that start later.  The default policy leaves the
+ * operating system scheduling unchanged.
+ */
+#define JSDRV_MSG_THREADS               "@/threads"     ///< Thread policy prefix
+
+/**
+ * @brief Stream latency telemetry topic prefix.
+ *
+ * Each stage has the subtopics "count" (u64 messages), "p50",
+ * "p99" and "p999" (u64 microseconds) computed over the messages
+ * since the previous update, such as "@/latency/total/p99".
+ * The stages are "decode" (USB completion to device send, which
+ * includes message batching), "queue" (device send to pubsub
+ * dispatch), "deliver" (pubsub dispatch to the subscriber callback)
+ * and "total" (USB completion to the subscriber callback).
+ * The values update at most once per second while streaming, and
+ * percentiles have 8 bins per octave resolution.
+ *
+ * Publish 1 to the "trailer" subtopic, "@/latency/trailer", to
+ * append struct jsdrv_stream_latency_s to stream messages.
+ * Builds with JSDRV_PERF_ENABLE=0 do not trace latency.
+ */
+#define JSDRV_MSG_LATENCY               "@/latency"     ///< Stream latency telemetry prefix
+
+/**
+ * @brief Thread activity trace topic prefix.
+ *
+ * Publish a u32 to "@/trace/!start" to record the main loop stages of
+ * the frontend, USB backend, device, buffer and dispatch threads.  The
+ * value is the events kept per thread, or 0 for the default 65536.
+ * Each thread keeps its most recent events.  Publish a file path str
+ * to "@/trace/!stop" to stop and write the trace in the Chrome trace
+ * event JSON format, which chrome://tracing and ui.perfetto.dev load.
+ * An empty str stops without writing.  The frontend writes the file
+ * before processing further messages.
+ * Builds with JSDRV_PERF_ENABLE=0 do not record traces.
+ */
+#define JSDRV_MSG_TRACE                 "@/trace"       ///< Thread activity trace prefix
+
+/**
+ * @brief Combined device statistics topics.
+ *
+ * Publish a nonzero period in milliseconds to JSDRV_MSG_STATISTICS_PERIOD
+ * to combine the latest "s/stats/value" from every device into a single
+ * jsdrv_statistics_all_s message on JSDRV_MSG_STATISTICS_ALL.  The driver
+ * publishes when a device statistics update arrives and at least the
+ * period elapsed since the previous publish.  Each device contributes
+ * its most recent update, ordered by the UTC time of the block end,
+ * until the device is removed.  The default period of 0 disables
+ * the combined statistics.
+ */
+#define JSDRV_MSG_STATISTICS_PERIOD     "@/stats/period"  ///< Combined statistics period in milliseconds (u32)
+#define JSDRV_MSG_STATISTICS_ALL        "@/stats/!all"    ///< Combined statistics: bin jsdrv_statistics_all_s
+
+/**
+ * @brief Device statistics history topics.
+ *
+ * Publish a nonzero record count to JSDRV_MSG_STATISTICS_HISTORY to
+ * retain the most recent "s/stats/value" updates from each device,
+ * up to JSDRV_STATISTICS_HISTORY_MAX.  Changes discard the retained
+ * records, and the driver discards the records of a device when it
+ * is removed.  The default count of 0 disables the history.
+ *
+ * Publish a jsdrv_statistics_history_request_s to
+ * JSDRV_MSG_STATISTICS_HISTORY_REQ to query the records of one device.
+ * The driver publishes one or more jsdrv_statistics_history_response_s
+ * to the request rsp_topic, so clients do not need to remain
+ * subscribed to "s/stats/value" to see recent statistics.
+ */
+#define JSDRV_MSG_STATISTICS_HISTORY     "@/stats/history"   ///< Statistics history records for each device (u32)
+#define JSDRV_MSG_STATISTICS_HISTORY_REQ "@/stats/!hist"     ///< Statistics history request: bin jsdrv_statistics_history_request_s
+
+/**
+ * @brief Automatic device reconnect window.
+ *
+ * Publish a nonzero u32 window in milliseconds to reopen devices that
+ * are removed while open, such as by a USB disconnect or a brief loss
+ * of power.  When a device with the same prefix, which includes the
+ * serial number, returns within the window, the driver publishes
+ * JSDRV_MSG_OPEN with the previous open mode and then replays the
+ * retained values of the writable device parameters as a single batch.
+ * The device applies the parameters in order once the open completes.
+ * JSDRV_MSG_DEVICE_REMOVE and JSDRV_MSG_DEVICE_ADD still publish so that
+ * the application observes the gap.  Publishing JSDRV_MSG_CLOSE to the
+ * removed device cancels the reconnect.  Devices opened with
+ * JSDRV_DEVICE_OPEN_MODE_RAW do not reconnect.  The default of 0
+ * disables reconnect.
+ *
+ * The instrument sample_id restarts when the instrument loses power,
+ * so the samples after a reconnect are not continuous with the samples
+ * before.
+ */
+#define JSDRV_MSG_REOPEN                "@/reopen"        ///< Reconnect window in milliseconds (u32)
+
 
 // device-specific commands in format {device}/{command}
 #define JSDRV_MSG_OPEN                  "@/!open"       ///< Device open: use only with device prefix
@@ -215,6 +401,47 @@ struct jsdrv_context_s;
  */
 typedef void (*jsdrv_subscribe_fn)(void * user_data, const char * topic, const struct jsdrv_union_s * value);
 
+/// The maximum number of messages for each jsdrv_subscribe_batch_fn call.
+#define JSDRV_SUBSCRIBE_BATCH_SIZE_MAX (64U)
+
+/// A topic update for jsdrv_subscribe_batch_fn.
+struct jsdrv_subscribe_msg_s {
+    const char * topic;                  ///< The topic for this update.
+    const struct jsdrv_union_s * value;  ///< The value for this update.
+};
+
+/**
+ * @brief Function called with a batch of topic updates.
+ *
+ * @param user_data The arbitrary user data.
+ * @param msgs The topic updates in publish order.
+ * @param count The number of msgs, from 1 to JSDRV_SUBSCRIBE_BATCH_SIZE_MAX.
+ *
+ * This function will be called from the Joulescope driver frontend thread,
+ * like jsdrv_subscribe_fn.  The msgs array and each topic and value only
+ * remain valid for the duration of the callback.
+ */
+typedef void (*jsdrv_subscribe_batch_fn)(void * user_data, const struct jsdrv_subscribe_msg_s * msgs, uint32_t count);
+
+/**
+ * @brief Function called when an asynchronous operation completes.
+ *
+ * @param user_data The arbitrary user data.
+ * @param topic The topic provided to jsdrv_publish_async() or jsdrv_query_async().
+ * @param return_code 0 or error code.  #JSDRV_ERROR_TIMED_OUT when the
+ *      operation did not complete in time and #JSDRV_ERROR_ABORTED when
+ *      the driver finalized first.
+ * @param value For jsdrv_query_async(), the caller's value which now holds
+ *      the result on success.  NULL for jsdrv_publish_async().
+ *
+ * This function will be called from the Joulescope driver frontend thread,
+ * exactly once for each operation that was successfully started.
+ * Like #jsdrv_subscribe_fn, it must not block and must not call
+ * jsdrv_finalize() or any blocking API function.
+ */
+typedef void (*jsdrv_async_fn)(void * user_data, const char * topic, int32_t return_code,
+                               struct jsdrv_union_s * value);
+
 /**
  * @brief The payload type for jsdrv_union_s.app.
  */
@@ -225,6 +452,18 @@ enum jsdrv_payload_type_e {
     JSDRV_PAYLOAD_TYPE_BUFFER_INFO  = 3,    // bin with jsdrv_buffer_info_s
     JSDRV_PAYLOAD_TYPE_BUFFER_REQ   = 4,    // bin with jsdrv_buffer_request_s
     JSDRV_PAYLOAD_TYPE_BUFFER_RSP   = 5,    // bin with jsdrv_buffer_response_s
+    JSDRV_PAYLOAD_TYPE_ALIGN_MAP    = 6,    // bin with jsdrv_align_map_s
+    JSDRV_PAYLOAD_TYPE_ALIGN_FRAME  = 7,    // bin with jsdrv_align_frame_s
+    JSDRV_PAYLOAD_TYPE_TRIGGER      = 8,    // bin with jsdrv_trigger_event_s
+    JSDRV_PAYLOAD_TYPE_STREAM_EVENT = 9,    // bin with jsdrv_stream_signal_s containing jsdrv_stream_event_s
+    JSDRV_PAYLOAD_TYPE_STATISTICS_ALL = 10, // bin with jsdrv_statistics_all_s
+    JSDRV_PAYLOAD_TYPE_BUFFER_MULTI_REQ = 11, // bin with jsdrv_buffer_multi_request_s
+    JSDRV_PAYLOAD_TYPE_BUFFER_MULTI_RSP = 12, // bin with jsdrv_buffer_multi_response_s
+    JSDRV_PAYLOAD_TYPE_HOST_DERIVED = 13,   // bin with jsdrv_host_derived_s
+    JSDRV_PAYLOAD_TYPE_CONTINUITY   = 14,   // bin with jsdrv_continuity_s
+    JSDRV_PAYLOAD_TYPE_STREAM_FRAME = 15,   // bin with jsdrv_stream_frame_s
+    JSDRV_PAYLOAD_TYPE_STATISTICS_HISTORY_REQ = 16, // bin with jsdrv_statistics_history_request_s
+    JSDRV_PAYLOAD_TYPE_STATISTICS_HISTORY_RSP = 17, // bin with jsdrv_statistics_history_response_s
 };
 
 /**
@@ -271,6 +510,82 @@ struct jsdrv_stream_signal_s {
     uint8_t data[JSDRV_STREAM_DATA_SIZE];   ///< The channel data.
 };
 
+/**
+ * @brief A value change for event-encoded stream messages.
+ *
+ * When "h/stream/event" is 1, devices publish the sub-byte current
+ * range and GPI signals as JSDRV_PAYLOAD_TYPE_STREAM_EVENT messages.
+ * The jsdrv_stream_signal_s header is unchanged, and element_count
+ * is the number of samples that the message spans.  The data holds
+ * (value.size - JSDRV_STREAM_HEADER_SIZE) / sizeof(jsdrv_stream_event_s)
+ * events in increasing offset order.  The first event has offset 0
+ * and provides the value at sample_id.  Each value holds until the
+ * next event or the end of the message.
+ */
+struct jsdrv_stream_event_s {
+    uint32_t offset;                        ///< The element offset from sample_id, in decimated samples.
+    uint32_t value;                         ///< The new element value.
+};
+
+/**
+ * @brief The optional latency trailer for stream messages.
+ *
+ * When JSDRV_MSG_LATENCY "/trailer" is 1, stream messages end with
+ * this structure at the first 8-byte aligned offset after the
+ * element data, JSDRV_STREAM_HEADER_SIZE +
+ * (element_count * element_size_bits + 7) / 8, and the value size
+ * includes the trailer.  Messages without room for the trailer
+ * are delivered unmodified.  All times are jsdrv_time_monotonic(),
+ * so a subscriber computes its delivery latency by calling
+ * jsdrv_time_monotonic() in its callback.
+ */
+struct jsdrv_stream_latency_s {
+    int64_t usb;                            ///< USB bulk in completion for the first contributing transfer.
+    int64_t decode;                         ///< The device sent the decoded message to the frontend.
+    int64_t dispatch;                       ///< Pubsub dispatched the message to subscribers.
+};
+
+/**
+ * @brief A channel entry for jsdrv_stream_frame_s.
+ */
+struct jsdrv_stream_frame_channel_s {
+    uint8_t field_id;                       ///< jsdrv_field_e
+    uint8_t index;                          ///< The channel index within the field.
+    uint8_t element_type;                   ///< jsdrv_element_type_e
+    uint8_t element_size_bits;              ///< The element size in bits, 32 for float and 8 for integers.
+    uint32_t offset;                        ///< The byte offset of the channel samples in data.
+};
+
+/**
+ * @brief The combined multi-channel stream frame.
+ *
+ * When "h/stream/frame" is 1, devices also publish the enabled
+ * channels together to "s/frame/!data".  Each channel holds
+ * element_count samples for the same sample_id range, one channel
+ * after another.  Integer channels, like the current range and GPI,
+ * are unpacked to one sample per byte.  Channel k sample j is
+ * at data[channels[k].offset + j * channels[k].element_size_bits / 8].
+ * Each offset is a multiple of 8.
+ *
+ * The first channel defines sample_id and decimate_factor.  Other
+ * channels provide their most recent sample at or before each
+ * sample_id, which selects every Nth sample of a channel with an
+ * N times higher sample rate.
+ */
+struct jsdrv_stream_frame_s {
+    uint64_t sample_id;                     ///< The starting sample id, which increments by decimate_factor.
+    uint8_t version;                        ///< The version, only 1 currently supported
+    uint8_t channel_count;                  ///< The number of channels.
+    uint8_t rsv1_u8;                        ///< Reserved = 0
+    uint8_t rsv2_u8;                        ///< Reserved = 0
+    uint32_t element_count;                 ///< The number of samples for each channel.
+    uint32_t sample_rate;                   ///< The frequency for sample_id.
+    uint32_t decimate_factor;               ///< The decimation factor from sample_id to data samples.
+    struct jsdrv_time_map_s time_map;       ///< The time map between sample_id (before decimate_factor) and UTC.
+    struct jsdrv_stream_frame_channel_s channels[JSDRV_STREAM_FRAME_CHANNELS_MAX];  ///< The channels.
+    uint8_t data[JSDRV_STREAM_FRAME_DATA_SIZE];  ///< The channel data.
+};
+
 /**
  * @brief The payload data structure for statistics updates.
  */
@@ -303,6 +618,166 @@ struct jsdrv_statistics_s {
     struct jsdrv_time_map_s time_map;  ///< The time map between sample_id and UTC.
 };
 
+/// The lowest histogram octave, 2**-30 (about 1e-9), in jsdrv_host_derived_s.
+#define JSDRV_HOST_HIST_OCTAVE_MIN (-30)
+/// The histogram octave limit, 2**10, in jsdrv_host_derived_s.
+#define JSDRV_HOST_HIST_OCTAVE_MAX (10)
+/// The histogram bins for each octave in jsdrv_host_derived_s.
+#define JSDRV_HOST_HIST_BINS_PER_OCTAVE (4)
+/// The histogram bins, including the underflow and overflow bins.
+#define JSDRV_HOST_HIST_BIN_COUNT \
+    ((JSDRV_HOST_HIST_OCTAVE_MAX - JSDRV_HOST_HIST_OCTAVE_MIN) * JSDRV_HOST_HIST_BINS_PER_OCTAVE + 2)
+
+/**
+ * @brief The payload data structure for derived host statistics.
+ *
+ * When "h/stats/derived" is enabled, devices publish this structure to
+ * "s/stats/host/derived" after each jsdrv_statistics_s window.
+ * The RMS and crest factor cover the same window.
+ *
+ * The histograms count the samples since hist_sample_id.  Bin 0
+ * counts samples below 2**JSDRV_HOST_HIST_OCTAVE_MIN, including zero
+ * and negative samples.  The last bin counts samples at or above
+ * 2**JSDRV_HOST_HIST_OCTAVE_MAX.  Bin k between covers octave
+ * JSDRV_HOST_HIST_OCTAVE_MIN + (k - 1) / JSDRV_HOST_HIST_BINS_PER_OCTAVE,
+ * which the bins divide linearly.
+ */
+struct jsdrv_host_derived_s {
+    uint8_t version;             ///< The version, only 1 currently supported
+    uint8_t bins_per_octave;     ///< JSDRV_HOST_HIST_BINS_PER_OCTAVE
+    int8_t octave_min;           ///< JSDRV_HOST_HIST_OCTAVE_MIN
+    int8_t octave_max;           ///< JSDRV_HOST_HIST_OCTAVE_MAX
+    uint32_t bin_count;          ///< JSDRV_HOST_HIST_BIN_COUNT
+    uint64_t block_sample_id;    ///< The first sample in the window, matches jsdrv_statistics_s.
+    uint64_t hist_sample_id;     ///< The first sample in the histograms.
+    double i_rms;                ///< The RMS current over the window.
+    double i_crest;              ///< The current crest factor, max(|min|, |max|) / RMS.
+    double v_rms;                ///< The RMS voltage over the window.
+    double v_crest;              ///< The voltage crest factor.
+    double p_rms;                ///< The RMS power over the window.
+    double p_crest;              ///< The power crest factor.
+    uint64_t i_hist[JSDRV_HOST_HIST_BIN_COUNT];  ///< The current histogram.
+    uint64_t v_hist[JSDRV_HOST_HIST_BIN_COUNT];  ///< The voltage histogram.
+    uint64_t p_hist[JSDRV_HOST_HIST_BIN_COUNT];  ///< The power histogram.
+};
+
+/// The most recent gaps in jsdrv_continuity_s.
+#define JSDRV_CONTINUITY_GAP_COUNT (16)
+
+/// A range of missing samples in jsdrv_continuity_s.
+struct jsdrv_continuity_gap_s {
+    uint64_t sample_id;          ///< The first missing sample_id.
+    uint64_t length;             ///< The number of missing sample_id values.
+};
+
+/**
+ * @brief The payload data structure for stream continuity.
+ *
+ * Devices publish this retained structure to "s/{signal}/gaps"
+ * for JS220 ports and to "s/gaps" for the single JS110 stream.
+ * Devices publish at most once per second, and only after a change.
+ * "h/gaps/!clear" resets all counters and gaps.
+ *
+ * All sample_id values and lengths use the stream sample_id units
+ * of jsdrv_stream_signal_s, which include the decimate_factor.
+ */
+struct jsdrv_continuity_s {
+    uint8_t version;             ///< The version, only 1 currently supported
+    uint8_t gap_count;           ///< The valid gaps, up to JSDRV_CONTINUITY_GAP_COUNT.
+    uint8_t rsv1_u8;             ///< Reserved, set to 0.
+    uint8_t rsv2_u8;             ///< Reserved, set to 0.
+    uint32_t rsv3_u32;           ///< Reserved, set to 0.
+    uint64_t sample_id;          ///< The next expected sample_id.
+    uint64_t skip_count;         ///< The number of gaps.
+    uint64_t skip_length;        ///< The total missing sample_id values over all gaps.
+    uint64_t dup_count;          ///< The number of received frames with duplicate data.
+    uint64_t dup_length;         ///< The total duplicate sample_id values discarded.
+    uint64_t resync_count;       ///< The number of resynchronizations after lost sync.
+    uint64_t drop_count;         ///< The number of frames discarded without sample_id.
+    struct jsdrv_continuity_gap_s gaps[JSDRV_CONTINUITY_GAP_COUNT];  ///< The most recent gaps, oldest first.
+};
+
+/**
+ * @brief The payload data structure for trigger events.
+ *
+ * Devices publish this structure to "h/trig/N/!event" when trigger N
+ * matches.  See the "h/trig/N/..." metadata for the configuration.
+ */
+struct jsdrv_trigger_event_s {
+    uint8_t version;             ///< The version, only 1 currently supported
+    uint8_t trigger;             ///< The trigger index N.
+    uint8_t source;              ///< The "h/trig/N/source" signal.
+    uint8_t edge;                ///< The matching edge: 0=rising, 1=falling.
+    float value;                 ///< The sample value at sample_id.
+    uint64_t sample_id;          ///< The first sample past the level.
+    int64_t utc;                 ///< The UTC time for sample_id from the device time map, 0 if unavailable.
+    uint32_t sample_rate;        ///< The frequency for sample_id.
+    uint32_t decimate_factor;    ///< The sample_id increment for each source sample.
+};
+
+/**
+ * @brief The latest statistics for one device in jsdrv_statistics_all_s.
+ */
+struct jsdrv_statistics_all_entry_s {
+    char device[JSDRV_TOPIC_LENGTH_MAX];  ///< The device prefix, such as "u/js220/000415".
+    int64_t utc;                          ///< The UTC time at the end of the statistics block, from its time map.
+    struct jsdrv_statistics_s statistics; ///< The latest device statistics.
+};
+
+/**
+ * @brief The payload data structure for the combined device statistics.
+ *
+ * The driver publishes this structure to JSDRV_MSG_STATISTICS_ALL.
+ * The message only contains the first count entries.
+ */
+struct jsdrv_statistics_all_s {
+    uint8_t version;             ///< The version, only 1 currently supported
+    uint8_t count;               ///< The number of entries.
+    uint8_t rsv1_u8;             ///< Reserved = 0
+    uint8_t rsv2_u8;             ///< Reserved = 0
+    uint32_t rsv3_u32;           ///< Reserved = 0
+    int64_t utc;                 ///< The host UTC time when published.
+    struct jsdrv_statistics_all_entry_s entries[JSDRV_STATISTICS_ALL_DEVICES_MAX];  ///< The devices, ordered by utc.
+};
+
+/**
+ * @brief The common timebase mapping for the time alignment service.
+ *
+ * Each source maps its sample_id to UTC, which is the common timebase.
+ * Source 0 is the master that defines jsdrv_align_frame_s sample_id.
+ */
+struct jsdrv_align_map_s {
+    uint8_t version;             ///< The version, only 1 currently supported
+    uint8_t source_count;        ///< The number of sources.
+    uint8_t rsv1_u8;             ///< Reserved = 0
+    uint8_t rsv2_u8;             ///< Reserved = 0
+    uint32_t rsv3_u32;           ///< Reserved = 0
+    uint32_t sample_rate[JSDRV_ALIGN_SOURCES_MAX];       ///< The frequency for each source's sample_id.
+    uint32_t decimate_factor[JSDRV_ALIGN_SOURCES_MAX];   ///< The sample_id increment for each source's sample.
+    struct jsdrv_time_map_s time_map[JSDRV_ALIGN_SOURCES_MAX];  ///< The map between each source's sample_id and UTC.
+};
+
+/**
+ * @brief The sample-aligned multi-device frame.
+ *
+ * All sources are resampled to the master source 0 samples.  The data
+ * holds element_count f32 samples for each source, source-major, so
+ * source k sample j is data[k * element_count + j].  Samples not
+ * available from a source are NaN.
+ */
+struct jsdrv_align_frame_s {
+    uint64_t sample_id;                     ///< The master starting sample id, which increments by decimate_factor.
+    uint8_t version;                        ///< The version, only 1 currently supported
+    uint8_t source_count;                   ///< The number of sources.
+    uint8_t rsv1_u8;                        ///< Reserved = 0
+    uint8_t rsv2_u8;                        ///< Reserved = 0
+    uint32_t element_count;                 ///< The number of samples for each source.
+    uint32_t sample_rate;                   ///< The master frequency for sample_id.
+    uint32_t decimate_factor;               ///< The master decimation factor from sample_id to data samples.
+    struct jsdrv_time_map_s time_map;       ///< The master time map between sample_id and UTC.
+    float data[JSDRV_STREAM_DATA_SIZE / sizeof(float)];  ///< The source-major sample data.
+};
+
 /**
  * @brief The time specification type.
  */
@@ -368,6 +843,181 @@ union jsdrv_buffer_request_time_range_u {
     struct jsdrv_time_range_samples_s samples;
 };
 
+/**
+ * @brief The buffer request flags for jsdrv_buffer_request_s.flags.
+ */
+enum jsdrv_buffer_request_flags_e {
+    /**
+     * @brief Stream the response as a sequence of messages.
+     *
+     * Requests that exceed one message return successive
+     * jsdrv_buffer_response_s chunks with increasing seq values.
+     * The last chunk sets JSDRV_BUFFER_RESPONSE_FLAG_FINAL.
+     * Without this flag, the response is clipped to one message.
+     */
+    JSDRV_BUFFER_REQUEST_FLAG_STREAM = (1 << 0),
+
+    /**
+     * @brief Read from the snapshot rather than the live buffer.
+     *
+     * Publish to "m/BBB/g/!snap" to take a snapshot.  The request
+     * fails when "m/BBB/g/snap" is not 2 (ready).
+     */
+    JSDRV_BUFFER_REQUEST_FLAG_SNAPSHOT = (1 << 1),
+
+    /**
+     * @brief Return the integral over the time range.
+     *
+     * The response is JSDRV_BUFFER_RESPONSE_INTEGRAL with a single
+     * jsdrv_buffer_integral_s over the inclusive range from start
+     * to end, or start to start + length - 1 when end is 0.
+     * Only float signals support integrals.  Set "m/BBB/g/intgrl"
+     * to answer in constant time regardless of the range duration.
+     */
+    JSDRV_BUFFER_REQUEST_FLAG_INTEGRAL = (1 << 2),
+
+    /**
+     * @brief Only compute the summary envelope and mean.
+     *
+     * Summary responses skip the variance and set every
+     * jsdrv_summary_entry_s.std to NaN.  The avg, min and max
+     * match a full summary request.  Use for display requests that
+     * only draw the envelope.
+     */
+    JSDRV_BUFFER_REQUEST_FLAG_ENVELOPE = (1 << 3),
+
+    /**
+     * @brief Return point samples rather than summary statistics.
+     *
+     * For requests with start, end and length that would return a
+     * summary, the response is JSDRV_BUFFER_RESPONSE_STRIDED with
+     * the sample at the start of each increment, in the same
+     * increments as the summary.  Other requests are unchanged.
+     */
+    JSDRV_BUFFER_REQUEST_FLAG_STRIDE = (1 << 4),
+
+    /**
+     * @brief Return the missing sample ranges.
+     *
+     * The response is JSDRV_BUFFER_RESPONSE_GAPS with the
+     * jsdrv_time_range_samples_s ranges of skipped samples within
+     * the inclusive range from start to end, or start to
+     * start + length - 1 when end is 0.  Other responses set
+     * JSDRV_BUFFER_RESPONSE_FLAG_GAP when they contain missing
+     * samples, so consumers only need this request to locate them.
+     */
+    JSDRV_BUFFER_REQUEST_FLAG_GAPS = (1 << 5),
+
+    /**
+     * @brief Keep a summary request open and send new entries.
+     *
+     * The request specifies a summary viewport with start, end and
+     * length.  The buffer first responds with the newest length
+     * entries, then responds with only the newly completed entries
+     * as samples arrive, at most at "m/BBB/g/info_hz" or 20 Hz when
+     * 0, or at the fastest JSDRV_BUFFER_REQUEST_FLAG_DISPLAY frame
+     * rate.  The entries continue past end with the same increment.
+     * Each response increments seq and never sets
+     * JSDRV_BUFFER_RESPONSE_FLAG_FINAL.  Publish the rsp_id to
+     * "m/BBB/s/ZZZ/!cancel" to stop the request.  Snapshot, integral
+     * and gap requests are not supported.
+     */
+    JSDRV_BUFFER_REQUEST_FLAG_STANDING = (1 << 6),
+
+    /**
+     * @brief Keep a summary request open and send display frames.
+     *
+     * The request specifies the pixel width as length and the time
+     * span as end - start + 1, usually JSDRV_TIME_SAMPLES with start 0.
+     * The buffer responds with the newest length entries, one
+     * min/max/mean envelope per pixel, at the frame rate in threshold
+     * Hz, and only when new entries complete.  Threshold 0 sends a
+     * frame on each JSDRV_BUFFER_REQUEST_FLAG_STANDING update.
+     * Otherwise, the threshold must be at least
+     * JSDRV_BUFFER_DISPLAY_RATE_MIN, and larger values are limited to
+     * JSDRV_BUFFER_DISPLAY_RATE_MAX.  The buffer ignores requests with
+     * a negative, NaN or smaller positive threshold.  Entries align to start, so
+     * pixels do not shift between frames.  Each frame is one response
+     * with length up to one response of summary entries.  Each
+     * response increments seq and never sets
+     * JSDRV_BUFFER_RESPONSE_FLAG_FINAL.  Combine with
+     * JSDRV_BUFFER_REQUEST_FLAG_ENVELOPE to skip the variance.  Publish
+     * the rsp_id to "m/BBB/s/ZZZ/!cancel" to stop the request.
+     * Snapshot, integral and gap requests are not supported.
+     */
+    JSDRV_BUFFER_REQUEST_FLAG_DISPLAY = (1 << 7),
+};
+
+/// The minimum nonzero JSDRV_BUFFER_REQUEST_FLAG_DISPLAY frame rate in Hz.
+#define JSDRV_BUFFER_DISPLAY_RATE_MIN (1U)
+
+/// The maximum JSDRV_BUFFER_REQUEST_FLAG_DISPLAY frame rate in Hz.
+#define JSDRV_BUFFER_DISPLAY_RATE_MAX (240U)
+
+/**
+ * @brief The buffer request operation for jsdrv_buffer_request_s.op.
+ *
+ * The bits in JSDRV_BUFFER_REQUEST_OP_MASK select the operation.
+ * The remaining bits are options for that operation.
+ */
+enum jsdrv_buffer_request_op_e {
+    /// Return samples or summaries, see jsdrv_buffer_request_s.
+    JSDRV_BUFFER_REQUEST_OP_DEFAULT = 0,
+
+    /**
+     * @brief Search for threshold crossings.
+     *
+     * The response is JSDRV_BUFFER_RESPONSE_CROSSINGS with the
+     * sample ids of the crossings within the inclusive range from
+     * start to end, or start to start + length - 1 when end is 0.
+     * A rising crossing is the first sample above threshold, and
+     * a falling crossing is the first sample at or below threshold.
+     * OR the jsdrv_buffer_search_e options into op to select the
+     * edges and crossings.  The search skips summary entries whose
+     * min and max cannot cross, so it is logarithmic in the range
+     * duration rather than linear.  NaN samples are ignored.
+     */
+    JSDRV_BUFFER_REQUEST_OP_SEARCH = 1,
+
+    /**
+     * @brief Compute approximate quantiles.
+     *
+     * The response is JSDRV_BUFFER_RESPONSE_QUANTILES with length
+     * float quantiles evenly spaced from the minimum to the maximum
+     * over the inclusive range from start to end.  Entry i is the
+     * i / (length - 1) quantile, so 1001 includes p99.9.  Length 0
+     * returns the 101 percentiles.  The quantiles interpolate within
+     * log-spaced bins that split each octave from 2**-26 to 2**5.
+     * Only float signals support quantiles.  Set "m/BBB/g/hist"
+     * to answer in time logarithmic in the range duration.
+     * NaN samples are ignored.
+     */
+    JSDRV_BUFFER_REQUEST_OP_QUANTILE = 2,
+
+    /// The op bits that select the operation.
+    JSDRV_BUFFER_REQUEST_OP_MASK = 0x0f,
+};
+
+/**
+ * @brief The JSDRV_BUFFER_REQUEST_OP_SEARCH options.
+ *
+ * With neither RISING nor FALLING, the search finds both edges.
+ * With neither LAST nor ALL, the search finds the first crossing.
+ */
+enum jsdrv_buffer_search_e {
+    JSDRV_BUFFER_SEARCH_RISING = (1 << 4),   ///< Find crossings above the threshold.
+    JSDRV_BUFFER_SEARCH_FALLING = (1 << 5),  ///< Find crossings to at or below the threshold.
+    JSDRV_BUFFER_SEARCH_LAST = (1 << 6),     ///< Find the last crossing.
+
+    /**
+     * @brief Find all crossings.
+     *
+     * When the crossings exceed one response, the response ends at
+     * the last returned crossing.  Continue the search from end + 1.
+     */
+    JSDRV_BUFFER_SEARCH_ALL = (1 << 7),
+};
+
 /**
  * @brief Request data from the streaming sample buffer.
  *
@@ -391,14 +1041,17 @@ union jsdrv_buffer_request_time_range_u {
  *       sample_id_incr = (sample_id_end - sample_id_start) / (length - 1)
  *
  * The buffer implementation may deduplicate requests using
- * the combination rsp_topic and rsp_id.
+ * the combination rsp_topic and rsp_id.  Publish the rsp_id to
+ * "m/BBB/s/ZZZ/!cancel" to cancel a pending request.  When
+ * "m/BBB/g/latest" is 1, a new request replaces any pending
+ * request with the same rsp_topic.
  */
 struct jsdrv_buffer_request_s {
     uint8_t version;                     ///< The request format version == 1.
     int8_t time_type;                    ///< jsdrv_time_type_e
-    uint8_t rsv1_u8;                     ///< Reserved, set to 0.
-    uint8_t rsv2_u8;                     ///< Reserved, set to 0.
-    uint32_t rsv3_u32;                   ///< Reserved, set to 0.
+    uint8_t flags;                       ///< jsdrv_buffer_request_flags_e bitmap, default 0.
+    uint8_t op;                          ///< jsdrv_buffer_request_op_e and options, default 0.
+    float threshold;                     ///< The JSDRV_BUFFER_REQUEST_OP_SEARCH threshold, JSDRV_BUFFER_REQUEST_FLAG_DISPLAY frame rate in Hz (0 or JSDRV_BUFFER_DISPLAY_RATE_MIN to JSDRV_BUFFER_DISPLAY_RATE_MAX), otherwise 0.
     union jsdrv_buffer_request_time_range_u time;
     char rsp_topic[JSDRV_TOPIC_LENGTH_MAX]; ///< The topic for this response.
     int64_t rsp_id;                         ///< The additional identifier to include in the response.
@@ -410,6 +1063,23 @@ struct jsdrv_buffer_request_s {
 enum jsdrv_buffer_response_type_e {
     JSDRV_BUFFER_RESPONSE_SAMPLES = 1,   ///< Data contains samples.
     JSDRV_BUFFER_RESPONSE_SUMMARY = 2,   ///< Data contains summary statistics.
+    JSDRV_BUFFER_RESPONSE_INTEGRAL = 3,  ///< Data contains jsdrv_buffer_integral_s.
+    JSDRV_BUFFER_RESPONSE_STRIDED = 4,   ///< Data contains every increment'th sample.
+    JSDRV_BUFFER_RESPONSE_GAPS = 5,      ///< Data contains jsdrv_time_range_samples_s missing ranges.
+    JSDRV_BUFFER_RESPONSE_CROSSINGS = 6, ///< Data contains uint64_t crossing sample ids.
+    JSDRV_BUFFER_RESPONSE_QUANTILES = 7, ///< Data contains float quantiles.
+};
+
+/**
+ * @brief The buffer response flags for jsdrv_buffer_response_s.flags.
+ */
+enum jsdrv_buffer_response_flags_e {
+    /// The last response for the request.
+    JSDRV_BUFFER_RESPONSE_FLAG_FINAL = (1 << 0),
+    /// The response range contains missing samples, which are NaN for float and 0 for unsigned.
+    JSDRV_BUFFER_RESPONSE_FLAG_GAP = (1 << 1),
+    /// Some summary entries precede level 0 and come from the coarser trend history.
+    JSDRV_BUFFER_RESPONSE_FLAG_TREND = (1 << 2),
 };
 
 /**
@@ -422,6 +1092,18 @@ struct jsdrv_summary_entry_s {
     float max;                  ///< The minimum value over the window.
 };
 
+/**
+ * @brief The integral for JSDRV_BUFFER_REQUEST_FLAG_INTEGRAL.
+ *
+ * The sum is exact for the samples as rounded to the fixed-point scale,
+ * so adjacent ranges add without accumulating float32 error.
+ */
+struct jsdrv_buffer_integral_s {
+    uint64_t sum_i128[2];       ///< The sample sum as a 128-bit signed integer with 2**-31 scale.
+    uint64_t sample_count;      ///< The number of summed samples, excluding missing (NaN) samples.
+    double integral;            ///< The integral in signal units * seconds, such as C for current.
+};
+
 /**
  * @brief The response to jsdrv_buffer_request_s produced by the memory buffer.
  *
@@ -434,13 +1116,35 @@ struct jsdrv_summary_entry_s {
  *
  * For response_type JSDRV_BUFFER_RESPONSE_SAMPLES, the data type depends
  * upon info.element_type and info.element_size_bits.
+ *
+ * For response_type JSDRV_BUFFER_RESPONSE_STRIDED, the data is packed
+ * like JSDRV_BUFFER_RESPONSE_SAMPLES.  Each sample is the first sample
+ * of (end - start + 1) / length samples, like the summary entries.
+ * Float samples outside the buffer are NaN, and unsigned samples are 0.
+ *
+ * For response_type JSDRV_BUFFER_RESPONSE_INTEGRAL, the data is
+ * jsdrv_buffer_integral_s[1] and the length values are 1.  The start
+ * and end specify the integrated range, clipped to the buffer contents.
+ *
+ * For response_type JSDRV_BUFFER_RESPONSE_GAPS, the data is
+ * jsdrv_time_range_samples_s[info.time_range_samples.length] in
+ * increasing order, and the start and end specify the searched range.
+ * Each gap end is inclusive and clipped to the searched range.
+ *
+ * For response_type JSDRV_BUFFER_RESPONSE_CROSSINGS, the data is
+ * uint64_t[info.time_range_samples.length] crossing sample ids in
+ * increasing order, and the start and end specify the searched range.
+ *
+ * For response_type JSDRV_BUFFER_RESPONSE_QUANTILES, the data is
+ * float[info.time_range_samples.length] quantiles in increasing order,
+ * and the start and end specify the range clipped to the buffer.
  */
 struct jsdrv_buffer_response_s {
     uint8_t version;                        ///< The response format version == 1.
     uint8_t response_type;                  ///< jsdrv_buffer_response_type_e
-    uint8_t rsv1_u8;                        ///< Reserved, set to 0.
+    uint8_t flags;                          ///< jsdrv_buffer_response_flags_e bitmap.
     uint8_t rsv2_u8;                        ///< Reserved, set to 0.
-    uint32_t rsv3_u32;                      ///< Reserved, set to 0.
+    uint32_t seq;                           ///< The chunk index for JSDRV_BUFFER_REQUEST_FLAG_STREAM, otherwise 0.
     int64_t rsp_id;                         ///< The value provided to jsdrv_buffer_request_s.
     struct jsdrv_buffer_info_s info;        ///< The response information.
 
@@ -462,6 +1166,128 @@ struct jsdrv_buffer_response_s {
     uint64_t data[];
 };
 
+/// The maximum number of signals for jsdrv_buffer_multi_request_s.
+#define JSDRV_BUFFER_MULTI_SIGNALS_MAX (8U)
+
+/**
+ * @brief Request the same time range from several buffer signals.
+ *
+ * Publish to "m/BBB/g/!req" to receive a single
+ * jsdrv_buffer_multi_response_s on req.rsp_topic.  The buffer
+ * processes every signal against one consistent cut of the buffer
+ * contents.  When the range extends past the newest sample of any
+ * signal, the range is clipped to the newest sample common to all
+ * signals, keeping the summary increment, so the responses are
+ * time-aligned.
+ *
+ * The signals share one message, so each response holds at most
+ * 1 / signal_count of the data of a single-signal request.  Summary
+ * requests that do not fit return an empty response.
+ * JSDRV_BUFFER_REQUEST_FLAG_STREAM is ignored.
+ */
+struct jsdrv_buffer_multi_request_s {
+    uint8_t version;                     ///< The request format version == 1.
+    uint8_t signal_count;                ///< The number of signal_ids.
+    uint8_t rsv1_u8;                     ///< Reserved, set to 0.
+    uint8_t rsv2_u8;                     ///< Reserved, set to 0.
+    uint32_t rsv3_u32;                   ///< Reserved, set to 0.
+    uint8_t signal_ids[JSDRV_BUFFER_MULTI_SIGNALS_MAX];  ///< The ZZZ for each "m/BBB/s/ZZZ" signal.
+    struct jsdrv_buffer_request_s req;   ///< The request for all signals.
+};
+
+/**
+ * @brief The response to jsdrv_buffer_multi_request_s.
+ *
+ * Each signal's jsdrv_buffer_response_s starts at the 8-byte aligned
+ * offset[i] bytes into data.  Signals with a nonzero status have
+ * only the fixed jsdrv_buffer_response_s fields.
+ */
+struct jsdrv_buffer_multi_response_s {
+    uint8_t version;                        ///< The response format version == 1.
+    uint8_t signal_count;                   ///< The number of signal responses.
+    uint8_t rsv1_u8;                        ///< Reserved, set to 0.
+    uint8_t rsv2_u8;                        ///< Reserved, set to 0.
+    uint32_t rsv3_u32;                      ///< Reserved, set to 0.
+    int64_t rsp_id;                         ///< The value provided to jsdrv_buffer_request_s.
+    uint8_t signal_ids[JSDRV_BUFFER_MULTI_SIGNALS_MAX];  ///< The requested signal ids.
+    int32_t status[JSDRV_BUFFER_MULTI_SIGNALS_MAX];      ///< 0 or the error code for each signal.
+    uint32_t offset[JSDRV_BUFFER_MULTI_SIGNALS_MAX];     ///< The byte offset into data for each signal.
+    uint64_t data[];                        ///< The jsdrv_buffer_response_s for each signal.
+};
+
+/**
+ * @brief Request the statistics history of one device.
+ *
+ * Publish to JSDRV_MSG_STATISTICS_HISTORY_REQ.  For JSDRV_TIME_SAMPLES,
+ * each record matches by its block_sample_id.  For JSDRV_TIME_UTC,
+ * each record matches by the UTC time of its block_sample_id from its
+ * time map.  The range is inclusive, and end 0 selects the newest
+ * record.  A nonzero length returns only the most recent length
+ * matching records.
+ */
+struct jsdrv_statistics_history_request_s {
+    uint8_t version;                        ///< The request format version == 1.
+    int8_t time_type;                       ///< jsdrv_time_type_e
+    uint8_t rsv1_u8;                        ///< Reserved, set to 0.
+    uint8_t rsv2_u8;                        ///< Reserved, set to 0.
+    uint32_t rsv3_u32;                      ///< Reserved, set to 0.
+    union jsdrv_buffer_request_time_range_u time;  ///< The time range.
+    char device[JSDRV_TOPIC_LENGTH_MAX];    ///< The device prefix, such as "u/js220/000415".
+    char rsp_topic[JSDRV_TOPIC_LENGTH_MAX]; ///< The topic for the responses.
+    int64_t rsp_id;                         ///< The additional identifier to include in the responses.
+};
+
+/**
+ * @brief The response to jsdrv_statistics_history_request_s.
+ *
+ * The matching records span one or more responses, oldest first,
+ * with up to JSDRV_STATISTICS_HISTORY_RESPONSE_COUNT records each.
+ * The message only contains the first count records.  The last
+ * response sets JSDRV_BUFFER_RESPONSE_FLAG_FINAL, and a request
+ * without matching records receives a single empty response.
+ */
+struct jsdrv_statistics_history_response_s {
+    uint8_t version;                        ///< The response format version == 1.
+    uint8_t flags;                          ///< jsdrv_buffer_response_flags_e bitmap.
+    uint8_t rsv1_u8;                        ///< Reserved, set to 0.
+    uint8_t rsv2_u8;                        ///< Reserved, set to 0.
+    uint32_t seq;                           ///< The response index for this request, starting from 0.
+    int64_t rsp_id;                         ///< The value provided to jsdrv_statistics_history_request_s.
+    uint64_t total;                         ///< The matching records over all responses.
+    uint32_t count;                         ///< The number of records in this response.
+    uint32_t rsv3_u32;                      ///< Reserved, set to 0.
+    struct jsdrv_statistics_s data[JSDRV_STATISTICS_HISTORY_RESPONSE_COUNT];  ///< The records, oldest first.
+};
+
+/// The file path size for jsdrv_buffer_export_s, including the terminator.
+#define JSDRV_BUFFER_EXPORT_PATH_MAX (256U)
+
+/**
+ * @brief Export a buffer signal time range to a file.
+ *
+ * Publish to "m/BBB/s/ZZZ/!export" to write the samples from start
+ * to end, inclusive, as a stream record file with the "r/NNN"
+ * recorder format.  For JSDRV_TIME_SAMPLES, end 0 selects the
+ * newest sample and the range is clipped to the retained samples.
+ * The buffer reads the range one stream chunk at a time, and a
+ * writer thread writes the file, so the export runs at storage
+ * speed without a client round trip.
+ *
+ * The buffer publishes the f32 progress from 0 to 1 to
+ * "m/BBB/s/ZZZ/export".  The final value is 1 on success or NaN
+ * on failure.  Publish -1 to "m/BBB/s/ZZZ/!cancel" to stop the
+ * exports of the signal.
+ */
+struct jsdrv_buffer_export_s {
+    uint8_t version;                     ///< The export format version == 1.
+    int8_t time_type;                    ///< jsdrv_time_type_e
+    uint8_t rsv1_u8;                     ///< Reserved, set to 0.
+    uint8_t rsv2_u8;                     ///< Reserved, set to 0.
+    uint32_t rsv3_u32;                   ///< Reserved, set to 0.
+    union jsdrv_buffer_request_time_range_u time;  ///< The time range, length is ignored.
+    char path[JSDRV_BUFFER_EXPORT_PATH_MAX];      ///< The nul-terminated file path to create or truncate.
+};
+
 /// The subscriber flags for jsdrv_subscribe().
 enum jsdrv_subscribe_flag_e {
     /// No flags (always 0).
@@ -480,8 +1306,23 @@ enum jsdrv_subscribe_flag_e {
     JSDRV_SFLAG_QUERY_RSP = (1 << 5),
     /// Subscribe to receive return code messages like "a/b/c#".
     JSDRV_SFLAG_RETURN_CODE = (1 << 6),
+    /// Deliver through a bounded queue on a dedicated thread, see jsdrv_subscribe_queued().
+    JSDRV_SFLAG_QUEUED = (1 << 7),
 };
 
+/// The delivery queue policy for JSDRV_SFLAG_QUEUED subscribers.
+enum jsdrv_subscribe_queue_policy_e {
+    /// When full, the publisher waits for space.  No messages are lost.
+    JSDRV_SUBSCRIBE_QUEUE_BLOCK = 0,
+    /// When full, drop the oldest queued message.
+    JSDRV_SUBSCRIBE_QUEUE_DROP_OLDEST = 1,
+    /// Replace any queued message for the same topic, and drop the oldest when full.
+    JSDRV_SUBSCRIBE_QUEUE_COALESCE = 2,
+};
+
+/// The default queue depth for JSDRV_SFLAG_QUEUED subscribers.
+#define JSDRV_SUBSCRIBE_QUEUE_DEPTH_DEFAULT (64U)
+
 /// The driver mode for device open.
 enum jsdrv_device_open_mode_e {
     /// Restore the device to its default, power-on state.
@@ -500,6 +1341,219 @@ struct jsdrv_arg_s {
     struct jsdrv_union_s value;  ///< The argument value.
 };
 
+/**
+ * @brief The number of libusb backend event threads (u32, default 1).
+ *
+ * Hosts with many instruments may shard the devices across multiple
+ * threads, each with its own libusb context.  Each device is served
+ * by exactly one thread.  Ignored by the WinUSB backend, which
+ * already uses a thread per device.
+ */
+#define JSDRV_ARG_USB_THREADS          "usb/threads"
+
+/**
+ * @brief The CPU affinity mask for the libusb backend threads (u64, default 0).
+ *
+ * When nonzero, thread k is pinned to the k-th set bit, wrapping
+ * as needed.  Only supported on Linux, ignored elsewhere.
+ */
+#define JSDRV_ARG_USB_AFFINITY         "usb/affinity"
+
+/**
+ * @brief The USB trace directory (str, default disabled).
+ *
+ * When provided, the libusb and emulation backends record all
+ * control, bulk out and bulk in transfers for each open device to
+ * "{dir}/{model}_{serial}.usbtrace", such as "js220_000415.usbtrace".
+ * Each device open replaces the previous trace for that device.
+ * The directory must already exist.  Ignored by the WinUSB backend.
+ */
+#define JSDRV_ARG_USB_TRACE            "usb/trace"
+
+/**
+ * @brief The USB trace file to replay (str, default disabled).
+ *
+ * When provided, the replay backend adds the traced device as
+ * "y/{model}/{serial}".  The normal upper-level driver opens the
+ * device, and the replay backend answers control in transfers
+ * from the trace, accepts all out transfers, and replays the
+ * traced bulk in data once the upper-level driver opens the stream.
+ * Each traced bulk in transfer waits for the upper-level driver to
+ * issue as many control and bulk out transfers as preceded it during
+ * the capture, but the bulk in data never depends on their contents.
+ */
+#define JSDRV_ARG_USB_REPLAY           "usb/replay"
+
+/**
+ * @brief The USB trace replay speed in percent of real time (u32).
+ *
+ * Default is 100, which reproduces the traced bulk in timing.
+ * 0 replays as fast as the host consumes the data, which measures
+ * the full host-side processing cost.
+ */
+#define JSDRV_ARG_USB_REPLAY_SPEED     "usb/replay_speed"
+
+/**
+ * @brief The number of frontend data-plane threads (u32, default 0).
+ *
+ * By default, the frontend thread calls all subscriber callbacks.
+ * When nonzero, dedicated threads call the external subscriber
+ * callbacks for stream and statistics data, so that slow
+ * subscribers do not delay control topics, such as parameter
+ * publishes and API timeouts.  Each device is delivered by a
+ * single thread, which preserves per-device message order.
+ * Devices are assigned to threads round-robin, up to 32 threads,
+ * so one thread per device scales delivery with the device count.
+ * Subscribers to multiple devices, such as "" or "u/", may be
+ * called concurrently from different threads.
+ */
+#define JSDRV_ARG_FRONTEND_DATA_THREADS "frontend/data_threads"
+
+/**
+ * @brief The number of shared device driver threads (u32, default 0).
+ *
+ * By default, each JS220 upper-level driver has its own thread.
+ * When nonzero, the JS220 drivers instead run as tasks on a shared
+ * pool of this many threads, up to 64, such as the CPU count.
+ * Each device still runs on at most one thread at a time, but
+ * any idle thread may process any ready device.  Racks with many
+ * instruments then use far fewer threads.  The JS110 driver
+ * always uses its own thread.
+ */
+#define JSDRV_ARG_DEVICE_THREADS       "device/threads"
+
+/**
+ * @brief The JS110 calibration cache directory (str, default disabled).
+ *
+ * When provided, JS110 open reads only the calibration header and
+ * loads the calibration record from this directory when a file
+ * matches the device serial number and calibration crc32.
+ * Otherwise, open reads the full record from the device and saves
+ * it to this directory.  The directory must already exist.
+ */
+#define JSDRV_ARG_JS110_CAL_CACHE      "js110/cal_cache"
+
+/**
+ * @brief The number of messages to preallocate for each message pool (u32).
+ *
+ * The driver allocates messages from pools.  When a pool is empty,
+ * the driver allocates from the heap and counts a heap fallback.
+ * The data value applies to each data message size class.
+ */
+#define JSDRV_ARG_POOL_MSG_PREALLOC    "pool/msg/prealloc"
+#define JSDRV_ARG_POOL_SMALL_PREALLOC  "pool/small/prealloc"
+#define JSDRV_ARG_POOL_DATA_PREALLOC   "pool/data/prealloc"
+
+/**
+ * @brief The maximum number of messages retained by each message pool (u32).
+ *
+ * Allocation never fails, so bursts beyond this limit still succeed.
+ * However, freed messages beyond this limit return to the heap,
+ * which bounds the memory held by the pool.  0 is unlimited.
+ * The data value applies to each data message size class.
+ */
+#define JSDRV_ARG_POOL_MSG_MAX         "pool/msg/max"
+#define JSDRV_ARG_POOL_SMALL_MAX       "pool/small/max"
+#define JSDRV_ARG_POOL_DATA_MAX        "pool/data/max"
+
+/**
+ * @brief The number of emulated JS220 instruments (u32).
+ *
+ * The emulation backend adds each instrument as "z/js220/EMU001",
+ * "z/js220/EMU002", ... which the normal JS220 driver then opens and
+ * streams like an attached instrument.  Default is 0.
+ */
+#define JSDRV_ARG_EMULATED_JS220       "emulated/js220"
+
+/// The number of emulated JS110 instruments as "z/js110/EMU001"... (u32).
+#define JSDRV_ARG_EMULATED_JS110       "emulated/js110"
+
+/// The emulated sample data jsdrv_emulated_pattern_e (u32).
+#define JSDRV_ARG_EMULATED_PATTERN     "emulated/pattern"
+
+/**
+ * @brief The emulated streaming speed in percent of real time (u32).
+ *
+ * Default is 100.  0 streams as fast as the host consumes the data.
+ * Paced instruments that fall over 100 ms behind drop samples
+ * like the real instrument FIFO overflow.
+ */
+#define JSDRV_ARG_EMULATED_SPEED       "emulated/speed"
+
+/// Drop every Nth emulated bulk in data frame, 0 to disable (u32).
+#define JSDRV_ARG_EMULATED_SKIP        "emulated/skip"
+
+/// Duplicate every Nth emulated bulk in data frame, 0 to disable (u32).
+#define JSDRV_ARG_EMULATED_DUP         "emulated/dup"
+
+/// Stall the emulated bulk in endpoint after every Nth transfer, 0 to disable (u32).
+#define JSDRV_ARG_EMULATED_STALL       "emulated/stall"
+
+/// The emulated bulk in stall duration in milliseconds, default 100 (u32).
+#define JSDRV_ARG_EMULATED_STALL_MS    "emulated/stall_ms"
+
+/**
+ * @brief Compress emulated JS220 data port frames, 0 to disable (u32).
+ *
+ * Frames use the lossless codecs that the host decodes, and fall
+ * back to raw frames when the encoding does not fit.
+ */
+#define JSDRV_ARG_EMULATED_CODEC       "emulated/codec"
+
+/// The emulated sample data patterns for JSDRV_ARG_EMULATED_PATTERN.
+enum jsdrv_emulated_pattern_e {
+    /// 1 kHz sine current around 100 mA and cosine voltage around 3.3 V.
+    JSDRV_EMULATED_PATTERN_SINE = 0,
+    /// Deterministic ramps computed from the sample_id for data validation.
+    JSDRV_EMULATED_PATTERN_RAMP = 1,
+};
+
+/**
+ * @brief Allocate memory for the driver.
+ *
+ * @param user_data The jsdrv_allocator_s user_data.
+ * @param size_bytes The number of bytes to allocate.
+ * @return The allocated memory or NULL on out of memory.
+ *
+ * The returned memory must be aligned for any type, like malloc().
+ * This function may be called from any thread.
+ */
+typedef void * (*jsdrv_alloc_fn)(void * user_data, size_t size_bytes);
+
+/**
+ * @brief Free memory provided by jsdrv_alloc_fn.
+ *
+ * @param user_data The jsdrv_allocator_s user_data.
+ * @param ptr The memory to free.
+ *
+ * This function may be called from any thread.
+ */
+typedef void (*jsdrv_free_fn)(void * user_data, void * ptr);
+
+/// The allocator for all driver heap memory.
+struct jsdrv_allocator_s {
+    jsdrv_alloc_fn alloc;   ///< The allocate function.
+    jsdrv_free_fn free;     ///< The free function.
+    void * user_data;       ///< The arbitrary data for alloc and free.
+};
+
+/**
+ * @brief Set the allocator for all driver heap memory.
+ *
+ * @param allocator The allocator, which is copied.  NULL restores
+ *      the default malloc() and free() allocator.
+ * @return 0, JSDRV_ERROR_PARAMETER_INVALID or JSDRV_ERROR_BUSY when
+ *      memory from the existing allocator is still in use.
+ *
+ * The driver holds small allocations in size-class free lists and
+ * per-thread caches, so the allocator sees mostly large, long-lived
+ * requests.  Call this function before jsdrv_initialize() and any
+ * other driver function, or after every jsdrv_finalize() completes.
+ * Large sample buffers use jsdrv_os_mem_alloc() and do not use the
+ * allocator.
+ */
+JSDRV_API int32_t jsdrv_allocator_set(const struct jsdrv_allocator_s * allocator);
+
 /**
  * @brief Initialize the Joulescope driver (synchronous).
  *
@@ -543,11 +1597,36 @@ JSDRV_API void jsdrv_finalize(struct jsdrv_context_s * context, uint32_t timeout
  *      the result.  When nonzero, block awaiting the return code message.
  * @return 0 or error code.  All calls may return #JSDRV_ERROR_PARAMETER_INVALID.
  *      Each topic may return other error codes.
+ *
+ * When no other commands are in flight, a scalar value for a device
+ * parameter that pubsub would forward unmodified goes directly from
+ * the calling thread to the device.  The frontend updates the retained
+ * value afterwards, so jsdrv_query() still returns the new value.
  */
 JSDRV_API int32_t jsdrv_publish(struct jsdrv_context_s * context,
         const char * topic, const struct jsdrv_union_s * value,
         uint32_t timeout_ms);
 
+/**
+ * @brief Publish multiple values with a single frontend wakeup.
+ *
+ * @param context The Joulescope driver context.
+ * @param topics The array of topics to publish.
+ * @param values The array of new topic values, one per topic.
+ * @param count The number of entries in topics and values.
+ * @param timeout_ms When 0, publish asynchronously without awaiting
+ *      the result.  When nonzero, block awaiting all return code messages.
+ * @return 0 or the first error code.  On timeout, return
+ *      #JSDRV_ERROR_TIMED_OUT when any entry did not complete.
+ *
+ * The frontend processes the messages in array order and forwards
+ * them to each device back-to-back, so configuring many parameters
+ * costs one round trip rather than one per parameter.
+ */
+JSDRV_API int32_t jsdrv_publish_batch(struct jsdrv_context_s * context,
+        const char * const * topics, const struct jsdrv_union_s * values,
+        uint32_t count, uint32_t timeout_ms);
+
 /**
  * @brief Query a retained value.
  *
@@ -564,17 +1643,91 @@ JSDRV_API int32_t jsdrv_publish(struct jsdrv_context_s * context,
  *      When nonzero, override the default timeout.
  * @return 0 or error code.  All calls may return #JSDRV_ERROR_PARAMETER_INVALID
  *      and #JSDRV_ERROR_TIMED_OUT.
+ *
+ * Retained scalar values are read directly from a lock-free snapshot
+ * when no API commands are in flight, which avoids the frontend round
+ * trip.  The result is the same as the round trip would return.
  */
 JSDRV_API int32_t jsdrv_query(struct jsdrv_context_s * context,
                               const char * topic, struct jsdrv_union_s * value,
                               uint32_t timeout_ms);
 
+/**
+ * @brief Query all retained values and metadata under a topic as one JSON document.
+ *
+ * @param context The Joulescope driver context.
+ * @param topic The topic prefix, such as the device prefix.  Use "" for all topics.
+ * @param flags The #jsdrv_subscribe_flag_e bitmap.  Include #JSDRV_SFLAG_PUB for
+ *      the retained values and #JSDRV_SFLAG_METADATA_RSP for the metadata.
+ * @param[inout] value The JSON document.  The caller must provide a
+ *      str or JSON value with an allocated buffer and size set to the
+ *      buffer size.  On success, value has type JSON with size including
+ *      the terminator.  On #JSDRV_ERROR_TOO_SMALL, size is the required
+ *      buffer size.
+ * @param timeout_ms This function is always blocking and waits for up to
+ *      timeout_ms for the operation to complete.
+ *      When 0, use the default timeout [recommended].
+ * @return 0 or error code.
+ *
+ * The document is a single JSON object produced in one traversal on the
+ * frontend thread.  Each key is the full topic name for a retained value
+ * or the topic name with the '$' suffix for metadata.  Binary values
+ * have no JSON representation and are omitted.  Non-finite floats are null.
+ */
+JSDRV_API int32_t jsdrv_query_snapshot(struct jsdrv_context_s * context,
+                                       const char * topic, uint8_t flags,
+                                       struct jsdrv_union_s * value,
+                                       uint32_t timeout_ms);
+
+/**
+ * @brief Publish a new value and receive the return code by callback.
+ *
+ * @param context The Joulescope driver context.
+ * @param topic The topic to publish.
+ * @param value The new topic value, copied before this function returns.
+ * @param cbk_fn The function called with the return code.
+ * @param cbk_user_data The arbitrary data provided to cbk_fn.
+ * @param timeout_ms The time to await the return code before calling
+ *      cbk_fn with #JSDRV_ERROR_TIMED_OUT.  When 0, use the default timeout.
+ * @return 0 when started or error code.  On error, cbk_fn is not called.
+ *
+ * This function never blocks, so event-loop applications can issue
+ * many concurrent operations from a single thread.  It may be called
+ * from any thread, including subscriber callbacks.  Operations from the
+ * same thread complete in the order they were issued.
+ */
+JSDRV_API int32_t jsdrv_publish_async(struct jsdrv_context_s * context,
+        const char * topic, const struct jsdrv_union_s * value,
+        jsdrv_async_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms);
+
+/**
+ * @brief Query a retained value and receive the result by callback.
+ *
+ * @param context The Joulescope driver context.
+ * @param topic The topic to query.
+ * @param[inout] value The topic value, as for jsdrv_query().  The caller
+ *      owns value and any buffer, which must remain valid until cbk_fn is called.
+ * @param cbk_fn The function called with the return code and value.
+ * @param cbk_user_data The arbitrary data provided to cbk_fn.
+ * @param timeout_ms The time to await the result before calling
+ *      cbk_fn with #JSDRV_ERROR_TIMED_OUT.  When 0, use the default timeout.
+ * @return 0 when started or error code.  On error, cbk_fn is not called.
+ *
+ * See jsdrv_publish_async().
+ */
+JSDRV_API int32_t jsdrv_query_async(struct jsdrv_context_s * context,
+        const char * topic, struct jsdrv_union_s * value,
+        jsdrv_async_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms);
+
 /**
  * @brief Subscribe to topic updates.
  *
  * @param context The Joulescope driver context.
  * @param topic The subscription topic.  The cbk_fn will be called whenever
- *      this topic or a child is updated.
+ *      this topic or a child is updated.  The topic may also contain
+ *      "+" levels, which match any single level, and a final "#" level,
+ *      which matches any remaining levels, such as "u/+/+/s/+/!data".
+ *      See jsdrv_topic_match().  Unsubscribe with the same topic.
  * @param flags The #jsdrv_subscribe_flag_e bitmap. 0 (#JSDRV_SFLAG_NONE) for no flags.
  * @param cbk_fn The function to call with topic updates.  When called, this function
  *      will be invoked from the Joulescope driver thread.  The function must NOT
@@ -592,6 +1745,95 @@ JSDRV_API int32_t jsdrv_subscribe(struct jsdrv_context_s * context, const char *
         jsdrv_subscribe_fn cbk_fn, void * cbk_user_data,
         uint32_t timeout_ms);
 
+/**
+ * @brief Subscribe to topic updates through a bounded delivery queue.
+ *
+ * @param context The Joulescope driver context.
+ * @param topic The subscription topic.
+ * @param flags The #jsdrv_subscribe_flag_e bitmap.  This function
+ *      adds #JSDRV_SFLAG_QUEUED.
+ * @param policy The #jsdrv_subscribe_queue_policy_e used when the queue is full.
+ * @param depth The maximum number of queued messages, or 0 for
+ *      #JSDRV_SUBSCRIBE_QUEUE_DEPTH_DEFAULT.
+ * @param cbk_fn The function to call with topic updates.  This function
+ *      is called from a thread dedicated to this subscription.
+ * @param cbk_user_data The arbitrary data provided to cbk_fn.
+ * @param timeout_ms When 0, subscribe asynchronously.  When nonzero, block awaiting
+ *      the subscription operation to complete.
+ * @return 0 or error code.
+ *
+ * Each queued subscription has its own queue and thread, so a slow
+ * queued subscriber does not delay other subscribers, except with
+ * #JSDRV_SUBSCRIBE_QUEUE_BLOCK.  Use #JSDRV_SUBSCRIBE_QUEUE_COALESCE
+ * for subscribers that only need the latest value, such as statistics.
+ * jsdrv_subscribe() with #JSDRV_SFLAG_QUEUED uses #JSDRV_SUBSCRIBE_QUEUE_BLOCK
+ * with the default depth.  Retained values are queued before the
+ * subscribe operation completes, but may be delivered later.
+ *
+ * Each queued subscription publishes its topic to "@/subq/{id}/topic"
+ * and its dropped and coalesced message count to "@/subq/{id}/drop" (u32),
+ * where {id} is a decimal number.  The drop count updates at most once
+ * per second.
+ *
+ * Unsubscribe with jsdrv_unsubscribe() or jsdrv_unsubscribe_all().
+ * When called with a timeout, these functions return after the
+ * queue delivers its pending messages and stops.
+ */
+JSDRV_API int32_t jsdrv_subscribe_queued(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
+        uint8_t policy, uint32_t depth,
+        jsdrv_subscribe_fn cbk_fn, void * cbk_user_data,
+        uint32_t timeout_ms);
+
+/**
+ * @brief Subscribe to topic updates delivered in batches.
+ *
+ * @param context The Joulescope driver context.
+ * @param topic The subscription topic, as for jsdrv_subscribe().
+ * @param flags The #jsdrv_subscribe_flag_e bitmap, which must not
+ *      contain #JSDRV_SFLAG_QUEUED.
+ * @param cbk_fn The function to call with each batch of topic updates.
+ * @param cbk_user_data The arbitrary data provided to cbk_fn.
+ * @param timeout_ms When 0, subscribe asynchronously.  When nonzero, block awaiting
+ *      the subscription operation to complete.
+ * @return 0 or error code.
+ *
+ * The driver accumulates the matching updates for each cbk_fn and
+ * cbk_user_data pair, across all of its batch subscriptions, while it
+ * processes its pending messages.  It then calls cbk_fn once with the
+ * accumulated updates, or more often when they exceed
+ * #JSDRV_SUBSCRIBE_BATCH_SIZE_MAX.  Callers, such as language bindings,
+ * can then take locks or make system calls once per batch rather than
+ * once per update.  The driver delivers any accumulated updates before
+ * each subscribe and unsubscribe operation completes, so synchronous
+ * subscription with #JSDRV_SFLAG_RETAIN still completes after cbk_fn
+ * receives the retained values.  Batch subscribers always receive
+ * data on the frontend thread, even when frontend data threads are
+ * enabled.
+ *
+ * Unsubscribe with jsdrv_unsubscribe_batch().
+ */
+JSDRV_API int32_t jsdrv_subscribe_batch(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
+        jsdrv_subscribe_batch_fn cbk_fn, void * cbk_user_data,
+        uint32_t timeout_ms);
+
+/**
+ * @brief Unsubscribe batch topic updates.
+ *
+ * @param context The Joulescope driver context.
+ * @param topic The subscription topic for unsubscription, or NULL
+ *      to unsubscribe from all topics.
+ * @param cbk_fn The previous subscribed function.
+ * @param cbk_user_data The arbitrary data provided to cbk_fn which must match
+ *      the value provided to jsdrv_subscribe_batch().
+ * @param timeout_ms When 0, unsubscribe asynchronously.
+ *      When nonzero, block awaiting the unsubscribe operation to complete.
+ * @return 0 or error code.
+ * @see jsdrv_unsubscribe
+ */
+JSDRV_API int32_t jsdrv_unsubscribe_batch(struct jsdrv_context_s * context, const char * topic,
+        jsdrv_subscribe_batch_fn cbk_fn, void * cbk_user_data,
+        uint32_t timeout_ms);
+
 /**
  * @brief Unsubscribe to topic updates.
  *
@@ -650,6 +1892,26 @@ JSDRV_API int32_t jsdrv_unsubscribe_all(struct jsdrv_context_s * context,
  */
 JSDRV_API int32_t jsdrv_open(struct jsdrv_context_s * context, const char * device_prefix, int32_t mode);
 
+/**
+ * @brief Open multiple devices concurrently.
+ *
+ * @param context The Joulescope driver context.
+ * @param device_prefixes The array of device prefix strings.
+ * @param count The number of entries in device_prefixes.
+ * @param mode The #jsdrv_device_open_mode_e for all devices.
+ * @param timeout_ms When 0, start the opens and return immediately.
+ *      When nonzero, block until all devices complete.
+ * @return 0 or the first error code.
+ *
+ * Each device opens on its own driver thread, so the total time is
+ * that of the slowest device rather than the sum.  To learn about each
+ * completion as it arrives, subscribe to "{device_prefix}/@/!open#"
+ * with #JSDRV_SFLAG_RETURN_CODE before calling this function.
+ */
+JSDRV_API int32_t jsdrv_open_many(struct jsdrv_context_s * context,
+        const char * const * device_prefixes, uint32_t count,
+        int32_t mode, uint32_t timeout_ms);
+
 /**
  * @brief Close a device.
  *
@@ -664,6 +1926,100 @@ JSDRV_API int32_t jsdrv_open(struct jsdrv_context_s * context, const char * devi
  */
 JSDRV_API int32_t jsdrv_close(struct jsdrv_context_s * context, const char * device_prefix);
 
+/// The jsdrv_buffer_read() working space in bytes that follows the response data.
+#define JSDRV_BUFFER_READ_SLACK (64U)
+
+/**
+ * @brief Read from a memory buffer signal directly into caller memory.
+ *
+ * @param context The Joulescope driver context.
+ * @param buffer_id The buffer id for "m/BBB".
+ * @param signal_id The signal id for "m/BBB/s/ZZZ".
+ * @param req The request, which is normalized in place to
+ *      JSDRV_TIME_SAMPLES.  rsp_topic is ignored, and the
+ *      JSDRV_BUFFER_REQUEST_FLAG_STREAM,
+ *      JSDRV_BUFFER_REQUEST_FLAG_STANDING and
+ *      JSDRV_BUFFER_REQUEST_FLAG_DISPLAY flags are ignored.
+ * @param rsp The 8-byte aligned response memory.
+ * @param rsp_size The rsp memory size in bytes.  The data capacity is
+ *      rsp_size - sizeof(jsdrv_buffer_response_s) - JSDRV_BUFFER_READ_SLACK.
+ *      Sample responses are clipped to fit, and summary responses that
+ *      do not fit are empty.
+ * @return 0 or error code.
+ *
+ * This function processes the request like "m/BBB/s/ZZZ/!req", but
+ * on the calling thread without any messages, so the response size
+ * is only limited by rsp_size.  It reads from a snapshot of the signal
+ * without blocking ingestion.  Call from any thread, including
+ * concurrently, but do not remove the buffer during the call.
+ */
+JSDRV_API int32_t jsdrv_buffer_read(struct jsdrv_context_s * context, uint8_t buffer_id, uint8_t signal_id,
+        struct jsdrv_buffer_request_s * req, struct jsdrv_buffer_response_s * rsp, uint64_t rsp_size);
+
+/**
+ * @brief Read samples from a memory buffer signal.
+ *
+ * @param context The Joulescope driver context.
+ * @param buffer_id The buffer id for "m/BBB".
+ * @param signal_id The signal id for "m/BBB/s/ZZZ".
+ * @param start The first sample id, in the signal's decimated samples.
+ * @param length The number of samples.
+ * @param rsp The response memory, see jsdrv_buffer_read().
+ * @param rsp_size The rsp memory size in bytes.
+ * @return 0 or error code.
+ *
+ * This is a convenience function that wraps jsdrv_buffer_read().
+ */
+JSDRV_API int32_t jsdrv_buffer_read_samples(struct jsdrv_context_s * context, uint8_t buffer_id, uint8_t signal_id,
+        uint64_t start, uint64_t length, struct jsdrv_buffer_response_s * rsp, uint64_t rsp_size);
+
+/**
+ * @brief Read summary entries from a memory buffer signal.
+ *
+ * @param context The Joulescope driver context.
+ * @param buffer_id The buffer id for "m/BBB".
+ * @param signal_id The signal id for "m/BBB/s/ZZZ".
+ * @param start The first sample id, in the signal's decimated samples.
+ * @param end The last sample id, inclusive.
+ * @param length The number of jsdrv_summary_entry_s.
+ * @param rsp The response memory, see jsdrv_buffer_read().
+ * @param rsp_size The rsp memory size in bytes.
+ * @return 0 or error code.
+ *
+ * This is a convenience function that wraps jsdrv_buffer_read().
+ * When length is at least half the samples, the response contains
+ * samples instead, like "m/BBB/s/ZZZ/!req".
+ */
+JSDRV_API int32_t jsdrv_buffer_read_summary(struct jsdrv_context_s * context, uint8_t buffer_id, uint8_t signal_id,
+        uint64_t start, uint64_t end, uint64_t length,
+        struct jsdrv_buffer_response_s * rsp, uint64_t rsp_size);
+
+/**
+ * @brief Measure one exact statistics window.
+ *
+ * @param context The Joulescope driver context.
+ * @param device The device prefix, such as "u/js220/000415".
+ * @param sample_count The window duration in 1 Msps samples.
+ * @param[out] statistics The statistics over the window, including
+ *      the exact charge and energy, min, max and std for current,
+ *      voltage and power.
+ * @param timeout_ms The time to wait beyond the window duration.
+ *      0 uses JSDRV_TIMEOUT_MS_DEFAULT.
+ * @return 0, JSDRV_ERROR_TIMED_OUT or error code.
+ *
+ * This is a convenience function for devices with host statistics
+ * (h/stats/ctrl), currently the JS220.  It configures one tumbling
+ * window of sample_count, enables the current, voltage and power
+ * streams, waits for the first s/stats/host/value, and then restores
+ * the previous settings.  The driver thread computes the statistics,
+ * so the caller never handles the sample data.
+ *
+ * This function blocks, so do not call it from a subscriber callback.
+ * Concurrent measurements on the same device conflict.
+ */
+JSDRV_API int32_t jsdrv_measure(struct jsdrv_context_s * context, const char * device, uint32_t sample_count,
+        struct jsdrv_statistics_s * statistics, uint32_t timeout_ms);
+
 /**
  * @brief Compute the calibration hash.
  *
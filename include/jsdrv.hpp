@@ -0,0 +1,952 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Joulescope host driver C++ wrapper.
+ */
+
+#ifndef JSDRV_INCLUDE_HPP_
+#define JSDRV_INCLUDE_HPP_
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"  // C flexible array members
+#endif
+#include "jsdrv.h"
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+#include "jsdrv/error_code.h"
+#include "jsdrv/topic.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define JSDRV_CPP_COROUTINE 1
+#include <coroutine>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+#endif
+#endif
+
+/**
+ * @ingroup jsdrv
+ * @defgroup jsdrv_cpp C++ wrapper
+ *
+ * @brief Header-only C++11 wrapper for the Joulescope driver API.
+ *
+ * Context, Device and Subscription own their C resources and release
+ * them on destruction.  They are move-only.  Like the C API, all
+ * operations return 0 or a #jsdrv_error_code_e rather than throwing.
+ *
+ * Subscriptions dispatch into any callable through a template
+ * trampoline.  Each subscription makes one allocation to hold the
+ * callable, and each callback is a direct call with no type erasure.
+ * StreamView and PackedView provide typed access to the stream
+ * message data without copying.  Like the message, they are only
+ * valid for the duration of the callback.
+ *
+ * Destroy all Subscription and Device instances before their Context.
+ * Declaring them after the Context ensures this order.
+ *
+ * With C++20 coroutines, Context::async() and Device::async() provide
+ * awaitable publish and query operations, and Buffer provides
+ * awaitable buffer requests.  See Executor.
+ *
+ * @{
+ */
+
+namespace jsdrv {
+
+/// Construct an f32 value.
+inline jsdrv_union_s value(float x) {
+    jsdrv_union_s v; std::memset(&v, 0, sizeof(v)); v.type = JSDRV_UNION_F32; v.value.f32 = x; return v;
+}
+
+/// Construct an f64 value.
+inline jsdrv_union_s value(double x) {
+    jsdrv_union_s v; std::memset(&v, 0, sizeof(v)); v.type = JSDRV_UNION_F64; v.value.f64 = x; return v;
+}
+
+/// Construct a u8 value.
+inline jsdrv_union_s value(uint8_t x) {
+    jsdrv_union_s v; std::memset(&v, 0, sizeof(v)); v.type = JSDRV_UNION_U8; v.value.u8 = x; return v;
+}
+
+/// Construct a u16 value.
+inline jsdrv_union_s value(uint16_t x) {
+    jsdrv_union_s v; std::memset(&v, 0, sizeof(v)); v.type = JSDRV_UNION_U16; v.value.u16 = x; return v;
+}
+
+/// Construct a u32 value.
+inline jsdrv_union_s value(uint32_t x) {
+    jsdrv_union_s v; std::memset(&v, 0, sizeof(v)); v.type = JSDRV_UNION_U32; v.value.u32 = x; return v;
+}
+
+/// Construct a u64 value.
+inline jsdrv_union_s value(uint64_t x) {
+    jsdrv_union_s v; std::memset(&v, 0, sizeof(v)); v.type = JSDRV_UNION_U64; v.value.u64 = x; return v;
+}
+
+/// Construct an i8 value.
+inline jsdrv_union_s value(int8_t x) {
+    jsdrv_union_s v; std::memset(&v, 0, sizeof(v)); v.type = JSDRV_UNION_I8; v.value.i8 = x; return v;
+}
+
+/// Construct an i16 value.
+inline jsdrv_union_s value(int16_t x) {
+    jsdrv_union_s v; std::memset(&v, 0, sizeof(v)); v.type = JSDRV_UNION_I16; v.value.i16 = x; return v;
+}
+
+/// Construct an i32 value.
+inline jsdrv_union_s value(int32_t x) {
+    jsdrv_union_s v; std::memset(&v, 0, sizeof(v)); v.type = JSDRV_UNION_I32; v.value.i32 = x; return v;
+}
+
+/// Construct an i64 value.
+inline jsdrv_union_s value(int64_t x) {
+    jsdrv_union_s v; std::memset(&v, 0, sizeof(v)); v.type = JSDRV_UNION_I64; v.value.i64 = x; return v;
+}
+
+/// Construct a string value that references str.
+inline jsdrv_union_s value(const char * str) {
+    jsdrv_union_s v; std::memset(&v, 0, sizeof(v));
+    v.type = JSDRV_UNION_STR;
+    v.value.str = str;
+    v.size = static_cast<uint32_t>(std::strlen(str) + 1);
+    return v;
+}
+
+/// Construct a JSON value that references str.
+inline jsdrv_union_s value_json(const char * str) {
+    jsdrv_union_s v = value(str);
+    v.type = JSDRV_UNION_JSON;
+    return v;
+}
+
+/**
+ * @brief Convert a numeric value.
+ *
+ * @param v The value.
+ * @param[out] x The converted value.
+ * @return 0 or error code.
+ */
+template <typename T> int32_t value_as(const jsdrv_union_s & v, T & x);
+
+#define JSDRV_CPP_VALUE_AS(_type, _union_type, _field)                      \
+template <> inline int32_t value_as<_type>(const jsdrv_union_s & v, _type & x) { \
+    jsdrv_union_s c = v;                                                    \
+    int32_t rc = jsdrv_union_as_type(&c, _union_type);                      \
+    if (0 == rc) {                                                          \
+        x = c.value._field;                                                 \
+    }                                                                       \
+    return rc;                                                              \
+}
+JSDRV_CPP_VALUE_AS(float, JSDRV_UNION_F32, f32)
+JSDRV_CPP_VALUE_AS(double, JSDRV_UNION_F64, f64)
+JSDRV_CPP_VALUE_AS(uint8_t, JSDRV_UNION_U8, u8)
+JSDRV_CPP_VALUE_AS(uint16_t, JSDRV_UNION_U16, u16)
+JSDRV_CPP_VALUE_AS(uint32_t, JSDRV_UNION_U32, u32)
+JSDRV_CPP_VALUE_AS(uint64_t, JSDRV_UNION_U64, u64)
+JSDRV_CPP_VALUE_AS(int8_t, JSDRV_UNION_I8, i8)
+JSDRV_CPP_VALUE_AS(int16_t, JSDRV_UNION_I16, i16)
+JSDRV_CPP_VALUE_AS(int32_t, JSDRV_UNION_I32, i32)
+JSDRV_CPP_VALUE_AS(int64_t, JSDRV_UNION_I64, i64)
+#undef JSDRV_CPP_VALUE_AS
+
+/// The stream element type for StreamView.
+template <typename T> struct element_traits;
+#define JSDRV_CPP_ELEMENT(_type, _element_type)                             \
+template <> struct element_traits<_type> {                                  \
+    static const uint8_t type = _element_type;                              \
+    static const uint8_t bits = 8 * sizeof(_type);                          \
+};
+JSDRV_CPP_ELEMENT(float, JSDRV_DATA_TYPE_FLOAT)
+JSDRV_CPP_ELEMENT(double, JSDRV_DATA_TYPE_FLOAT)
+JSDRV_CPP_ELEMENT(uint8_t, JSDRV_DATA_TYPE_UINT)
+JSDRV_CPP_ELEMENT(uint16_t, JSDRV_DATA_TYPE_UINT)
+JSDRV_CPP_ELEMENT(uint32_t, JSDRV_DATA_TYPE_UINT)
+JSDRV_CPP_ELEMENT(uint64_t, JSDRV_DATA_TYPE_UINT)
+JSDRV_CPP_ELEMENT(int8_t, JSDRV_DATA_TYPE_INT)
+JSDRV_CPP_ELEMENT(int16_t, JSDRV_DATA_TYPE_INT)
+JSDRV_CPP_ELEMENT(int32_t, JSDRV_DATA_TYPE_INT)
+JSDRV_CPP_ELEMENT(int64_t, JSDRV_DATA_TYPE_INT)
+#undef JSDRV_CPP_ELEMENT
+
+/// The 1-bit unsigned element tag for PackedView, such as the GPI signals.
+struct u1 { static const uint8_t type = JSDRV_DATA_TYPE_UINT; static const uint8_t bits = 1; };
+/// The 4-bit unsigned element tag for PackedView, such as the current range.
+struct u4 { static const uint8_t type = JSDRV_DATA_TYPE_UINT; static const uint8_t bits = 4; };
+
+/// The stream message header accessors common to all views.
+class StreamHeader {
+public:
+    explicit StreamHeader(const jsdrv_stream_signal_s * s) : s_(s) {}
+    /// The stream message.
+    const jsdrv_stream_signal_s & signal() const { return *s_; }
+    /// The sample_id of the first element.
+    uint64_t sample_id() const { return s_->sample_id; }
+    /// The sample_id increment for each element.
+    uint32_t decimate_factor() const { return s_->decimate_factor; }
+    /// The sample_id frequency.
+    uint32_t sample_rate() const { return s_->sample_rate; }
+    /// The number of elements.
+    std::size_t size() const { return s_->element_count; }
+    /// True when there are no elements.
+    bool empty() const { return 0 == s_->element_count; }
+protected:
+    const jsdrv_stream_signal_s * s_;
+};
+
+/**
+ * @brief A typed view of the stream message data.
+ *
+ * @tparam T The element type, such as float.
+ */
+template <typename T>
+class StreamView : public StreamHeader {
+public:
+    typedef T value_type;
+    typedef element_traits<T> traits;
+    typedef const T * const_iterator;
+    explicit StreamView(const jsdrv_stream_signal_s * s) : StreamHeader(s) {}
+    /// The elements.
+    const T * data() const { return reinterpret_cast<const T *>(s_->data); }
+    const T & operator[](std::size_t idx) const { return data()[idx]; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size(); }
+};
+
+/**
+ * @brief A view of packed sub-byte stream message data.
+ *
+ * @tparam E The element tag, u1 or u4.
+ *
+ * Element 0 occupies the least significant bits of the first byte.
+ */
+template <typename E>
+class PackedView : public StreamHeader {
+public:
+    typedef uint8_t value_type;
+    typedef E traits;
+    explicit PackedView(const jsdrv_stream_signal_s * s) : StreamHeader(s) {}
+    /// The packed bytes.
+    const uint8_t * data() const { return s_->data; }
+    uint8_t operator[](std::size_t idx) const {
+        std::size_t bit = idx * E::bits;
+        return static_cast<uint8_t>((s_->data[bit >> 3] >> (bit & 7)) & ((1U << E::bits) - 1));
+    }
+};
+
+/// Internal trampolines.
+namespace detail {
+
+/// Join the prefix, which may be empty, and the topic.
+inline void topic_join(jsdrv_topic_s & t, const jsdrv_topic_s & prefix, const char * topic) {
+    if (prefix.length) {
+        t = prefix;
+        jsdrv_topic_append(&t, topic);
+    } else {
+        jsdrv_topic_set(&t, topic);
+    }
+}
+
+template <typename F>
+struct Holder {
+    explicit Holder(F && f) : fn(std::move(f)) {}
+    F fn;
+    static void destroy(void * self) {
+        delete static_cast<Holder *>(self);
+    }
+    static void on_pub(void * self, const char * topic, const jsdrv_union_s * value) {
+        static_cast<Holder *>(self)->fn(topic, *value);
+    }
+};
+
+template <typename V, typename F>
+struct StreamHolder {
+    explicit StreamHolder(F && f) : fn(std::move(f)) {}
+    F fn;
+    static void destroy(void * self) {
+        delete static_cast<StreamHolder *>(self);
+    }
+    static void on_pub(void * self, const char * topic, const jsdrv_union_s * value) {
+        (void) topic;
+        if ((JSDRV_UNION_BIN != value->type) || (JSDRV_PAYLOAD_TYPE_STREAM != value->app)
+                || (value->size < JSDRV_STREAM_HEADER_SIZE)) {
+            return;
+        }
+        const jsdrv_stream_signal_s * s = reinterpret_cast<const jsdrv_stream_signal_s *>(value->value.bin);
+        typedef typename V::traits traits;
+        if ((s->element_type != traits::type) || (s->element_size_bits != traits::bits)
+                || ((value->size - JSDRV_STREAM_HEADER_SIZE) < (static_cast<uint64_t>(s->element_count) * traits::bits + 7) / 8)) {
+            return;
+        }
+        static_cast<StreamHolder *>(self)->fn(V(s));
+    }
+};
+
+}  // namespace detail
+
+/**
+ * @brief A topic subscription.
+ *
+ * Destruction or reset() unsubscribes and blocks until the callback
+ * can no longer be called.
+ */
+class Subscription {
+public:
+    Subscription() : context_(NULL), fn_(NULL), user_data_(NULL), destroy_(NULL) { topic_.topic[0] = 0; }
+    ~Subscription() { reset(); }
+    Subscription(Subscription && other) : Subscription() { swap(other); }
+    Subscription & operator=(Subscription && other) {
+        if (this != &other) {
+            reset();
+            swap(other);
+        }
+        return *this;
+    }
+    Subscription(const Subscription &) = delete;
+    Subscription & operator=(const Subscription &) = delete;
+
+    /// True when subscribed.
+    explicit operator bool() const { return NULL != context_; }
+
+    /// The subscription topic.
+    const char * topic() const { return topic_.topic; }
+
+    /**
+     * @brief Unsubscribe.
+     *
+     * @return 0 or error code.  On #JSDRV_ERROR_TIMED_OUT, the callback
+     *      may still run, so the callable is intentionally leaked.
+     */
+    int32_t reset() {
+        int32_t rc = 0;
+        if (context_) {
+            rc = jsdrv_unsubscribe(context_, topic_.topic, fn_, user_data_, JSDRV_TIMEOUT_MS_DEFAULT);
+            if (JSDRV_ERROR_TIMED_OUT != rc) {
+                destroy_(user_data_);
+            }
+            context_ = NULL;
+            fn_ = NULL;
+            user_data_ = NULL;
+            destroy_ = NULL;
+        }
+        return rc;
+    }
+
+    void swap(Subscription & other) {
+        std::swap(context_, other.context_);
+        std::swap(topic_, other.topic_);
+        std::swap(fn_, other.fn_);
+        std::swap(user_data_, other.user_data_);
+        std::swap(destroy_, other.destroy_);
+    }
+
+    /// Subscribe, called by Context and Device.
+    int32_t subscribe(jsdrv_context_s * context, const char * topic, uint8_t flags,
+                      jsdrv_subscribe_fn fn, void * user_data, void (*destroy)(void *)) {
+        reset();
+        int32_t rc = jsdrv_subscribe(context, topic, flags, fn, user_data, JSDRV_TIMEOUT_MS_DEFAULT);
+        if (rc) {
+            destroy(user_data);
+            return rc;
+        }
+        context_ = context;
+        jsdrv_topic_set(&topic_, topic);
+        fn_ = fn;
+        user_data_ = user_data;
+        destroy_ = destroy;
+        return 0;
+    }
+
+private:
+    jsdrv_context_s * context_;
+    jsdrv_topic_s topic_;
+    jsdrv_subscribe_fn fn_;
+    void * user_data_;
+    void (*destroy_)(void *);
+};
+
+#if JSDRV_CPP_COROUTINE
+
+/**
+ * @brief Resume coroutines after their operation completes.
+ *
+ * The driver completes operations on its own threads.  When post is
+ * set, the completion calls post(user_data, handle), which must
+ * arrange for handle.resume() on an application thread, such as by
+ * queueing the handle to a thread pool.  When post is NULL, the
+ * coroutine resumes on the driver thread, where it must not call
+ * blocking API functions or jsdrv_finalize().
+ */
+struct Executor {
+    void (*post)(void * user_data, std::coroutine_handle<> handle) = nullptr;
+    void * user_data = nullptr;
+
+    void resume(std::coroutine_handle<> handle) const {
+        if (post) {
+            post(user_data, handle);
+        } else {
+            handle.resume();
+        }
+    }
+};
+
+/// The result of co_await on a query.
+struct QueryResult {
+    int32_t rc;             ///< 0 or error code.
+    jsdrv_union_s value;    ///< The value when rc is 0.
+};
+
+namespace detail {
+
+/// The common completion for jsdrv_publish_async() and jsdrv_query_async().
+class AsyncAwaiter {
+public:
+    bool await_ready() const noexcept { return false; }
+
+protected:
+    AsyncAwaiter(jsdrv_context_s * context, const jsdrv_topic_s & prefix, const char * topic,
+                 const Executor & executor, uint32_t timeout_ms)
+            : context_(context), executor_(executor), timeout_ms_(timeout_ms), rc_(0) {
+        topic_join(topic_, prefix, topic);
+    }
+
+    static void on_done(void * user_data, const char * topic, int32_t return_code, jsdrv_union_s * value) {
+        (void) topic;
+        (void) value;  // already in the awaiter
+        AsyncAwaiter * self = static_cast<AsyncAwaiter *>(user_data);
+        self->rc_ = return_code;
+        Executor executor = self->executor_;
+        executor.resume(self->handle_);  // self may be gone after resume
+    }
+
+    jsdrv_context_s * context_;
+    jsdrv_topic_s topic_;
+    Executor executor_;
+    uint32_t timeout_ms_;
+    int32_t rc_;
+    std::coroutine_handle<> handle_;
+};
+
+}  // namespace detail
+
+/// The awaitable for Async::publish(), which returns 0 or error code.
+class PublishAwaiter : public detail::AsyncAwaiter {
+public:
+    PublishAwaiter(jsdrv_context_s * context, const jsdrv_topic_s & prefix, const char * topic,
+                   const jsdrv_union_s & v, const Executor & executor, uint32_t timeout_ms)
+            : AsyncAwaiter(context, prefix, topic, executor, timeout_ms), value_(v) {}
+
+    bool await_suspend(std::coroutine_handle<> handle) noexcept {
+        handle_ = handle;
+        int32_t rc = jsdrv_publish_async(context_, topic_.topic, &value_, &on_done, this, timeout_ms_);
+        if (rc) {
+            rc_ = rc;  // on_done is never called
+            return false;
+        }
+        return true;
+    }
+
+    int32_t await_resume() const noexcept { return rc_; }
+
+private:
+    jsdrv_union_s value_;
+};
+
+/// The awaitable for Async::query(), which returns the QueryResult.
+class QueryAwaiter : public detail::AsyncAwaiter {
+public:
+    QueryAwaiter(jsdrv_context_s * context, const jsdrv_topic_s & prefix, const char * topic,
+                 const Executor & executor, uint32_t timeout_ms)
+            : AsyncAwaiter(context, prefix, topic, executor, timeout_ms) {
+        std::memset(&value_, 0, sizeof(value_));
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) noexcept {
+        handle_ = handle;
+        int32_t rc = jsdrv_query_async(context_, topic_.topic, &value_, &on_done, this, timeout_ms_);
+        if (rc) {
+            rc_ = rc;
+            return false;
+        }
+        return true;
+    }
+
+    QueryResult await_resume() const noexcept { return QueryResult{rc_, value_}; }
+
+private:
+    jsdrv_union_s value_;
+};
+
+/**
+ * @brief The awaitable operations from Context::async() and Device::async().
+ *
+ * Each operation starts when awaited and never blocks the awaiting
+ * thread.  Query only supports scalar values.
+ */
+class Async {
+public:
+    Async(jsdrv_context_s * context, const jsdrv_topic_s & prefix, const Executor & executor)
+            : context_(context), prefix_(prefix), executor_(executor) {}
+
+    /// Publish a value, see jsdrv_publish_async().
+    PublishAwaiter publish(const char * topic, const jsdrv_union_s & v, uint32_t timeout_ms = 0) const {
+        return PublishAwaiter(context_, prefix_, topic, v, executor_, timeout_ms);
+    }
+
+    /// Publish a numeric or string value, see jsdrv_publish_async().
+    template <typename T>
+    PublishAwaiter publish(const char * topic, T x, uint32_t timeout_ms = 0) const {
+        return publish(topic, value(x), timeout_ms);
+    }
+
+    /// Query a retained scalar value, see jsdrv_query_async().
+    QueryAwaiter query(const char * topic, uint32_t timeout_ms = 0) const {
+        return QueryAwaiter(context_, prefix_, topic, executor_, timeout_ms);
+    }
+
+private:
+    jsdrv_context_s * context_;
+    jsdrv_topic_s prefix_;
+    Executor executor_;
+};
+
+#endif
+
+/**
+ * @brief The common topic operations for Context and Device.
+ *
+ * Device prefixes each topic with the device prefix.
+ */
+class Topics {
+public:
+    /// The C context for direct use of the C API.
+    jsdrv_context_s * get() const { return context_; }
+
+#if JSDRV_CPP_COROUTINE
+    /// The awaitable operations that resume on executor.
+    Async async(const Executor & executor = Executor()) const {
+        return Async(context_, prefix_, executor);
+    }
+#endif
+
+    /// Publish a value, see jsdrv_publish().
+    int32_t publish(const char * topic, const jsdrv_union_s & v,
+                    uint32_t timeout_ms = JSDRV_TIMEOUT_MS_DEFAULT) const {
+        jsdrv_topic_s t;
+        full_topic(t, topic);
+        return jsdrv_publish(context_, t.topic, &v, timeout_ms);
+    }
+
+    /// Publish a numeric or string value, see jsdrv_publish().
+    template <typename T>
+    int32_t publish(const char * topic, T x, uint32_t timeout_ms = JSDRV_TIMEOUT_MS_DEFAULT) const {
+        return publish(topic, value(x), timeout_ms);
+    }
+
+    /// Query a retained value, see jsdrv_query().
+    int32_t query(const char * topic, jsdrv_union_s & v, uint32_t timeout_ms = 0) const {
+        jsdrv_topic_s t;
+        full_topic(t, topic);
+        return jsdrv_query(context_, t.topic, &v, timeout_ms);
+    }
+
+    /// Query a retained numeric value and convert it to T.
+    template <typename T>
+    int32_t query(const char * topic, T & x, uint32_t timeout_ms = 0) const {
+        jsdrv_union_s v;
+        std::memset(&v, 0, sizeof(v));
+        int32_t rc = query(topic, v, timeout_ms);
+        return rc ? rc : value_as(v, x);
+    }
+
+    /**
+     * @brief Subscribe to topic updates.
+     *
+     * @param topic The subscription topic.
+     * @param flags The #jsdrv_subscribe_flag_e bitmap.
+     * @param fn The callable invoked as fn(const char * topic, const jsdrv_union_s & value)
+     *      from the driver thread.
+     * @param[out] sub The subscription, which unsubscribes on destruction.
+     * @return 0 or error code.
+     */
+    template <typename F>
+    int32_t subscribe(const char * topic, uint8_t flags, F fn, Subscription & sub) const {
+        typedef detail::Holder<F> H;
+        jsdrv_topic_s t;
+        full_topic(t, topic);
+        return sub.subscribe(context_, t.topic, flags, &H::on_pub, new H(std::move(fn)), &H::destroy);
+    }
+
+    /**
+     * @brief Subscribe to typed stream data.
+     *
+     * @tparam V The view type, such as StreamView<float> or PackedView<u4>.
+     * @param topic The stream data topic, such as "s/i/!data".
+     * @param fn The callable invoked as fn(V view) from the driver thread.
+     *      The view is only valid for the duration of the call.
+     * @param[out] sub The subscription, which unsubscribes on destruction.
+     * @return 0 or error code.
+     *
+     * Messages with a different element type or size, including
+     * event-encoded messages, do not call fn.
+     */
+    template <typename V, typename F>
+    int32_t subscribe_stream(const char * topic, F fn, Subscription & sub) const {
+        typedef detail::StreamHolder<V, F> H;
+        jsdrv_topic_s t;
+        full_topic(t, topic);
+        return sub.subscribe(context_, t.topic, JSDRV_SFLAG_PUB, &H::on_pub, new H(std::move(fn)), &H::destroy);
+    }
+
+protected:
+    Topics() : context_(NULL) { prefix_.topic[0] = 0; prefix_.length = 0; }
+
+    void full_topic(jsdrv_topic_s & t, const char * topic) const {
+        detail::topic_join(t, prefix_, topic);
+    }
+
+    void swap(Topics & other) {
+        std::swap(context_, other.context_);
+        std::swap(prefix_, other.prefix_);
+    }
+
+    jsdrv_context_s * context_;
+    jsdrv_topic_s prefix_;
+};
+
+/**
+ * @brief The driver context.
+ */
+class Context : public Topics {
+public:
+    Context() {}
+    ~Context() { finalize(); }
+    Context(Context && other) : Topics() { swap(other); }
+    Context & operator=(Context && other) {
+        if (this != &other) {
+            finalize();
+            swap(other);
+        }
+        return *this;
+    }
+    Context(const Context &) = delete;
+    Context & operator=(const Context &) = delete;
+
+    /// True when initialized.
+    explicit operator bool() const { return NULL != context_; }
+
+    /// Initialize the driver, see jsdrv_initialize().
+    int32_t initialize(const jsdrv_arg_s * args = NULL, uint32_t timeout_ms = 0) {
+        finalize();
+        return jsdrv_initialize(&context_, args, timeout_ms);
+    }
+
+    /// Finalize the driver, see jsdrv_finalize().
+    void finalize(uint32_t timeout_ms = 0) {
+        if (context_) {
+            jsdrv_finalize(context_, timeout_ms);
+            context_ = NULL;
+        }
+    }
+};
+
+/**
+ * @brief An open device.
+ *
+ * All topics are relative to the device prefix, such as "s/i/!data".
+ */
+class Device : public Topics {
+public:
+    Device() {}
+    ~Device() { close(); }
+    Device(Device && other) : Topics() { swap(other); }
+    Device & operator=(Device && other) {
+        if (this != &other) {
+            close();
+            swap(other);
+        }
+        return *this;
+    }
+    Device(const Device &) = delete;
+    Device & operator=(const Device &) = delete;
+
+    /// True when open.
+    explicit operator bool() const { return NULL != context_; }
+
+    /// The device prefix, such as "u/js220/000415".
+    const char * prefix() const { return prefix_.topic; }
+
+    /**
+     * @brief Open a device.
+     *
+     * @param context The initialized context.
+     * @param device_prefix The device prefix.
+     * @param mode The #jsdrv_device_open_mode_e.
+     * @return 0 or error code.
+     */
+    int32_t open(const Context & context, const char * device_prefix, int32_t mode = JSDRV_DEVICE_OPEN_MODE_DEFAULTS) {
+        close();
+        jsdrv_topic_s t;
+        jsdrv_topic_set(&t, device_prefix);
+        jsdrv_topic_append(&t, JSDRV_MSG_OPEN);
+        jsdrv_union_s v = value(mode);
+        int32_t rc = jsdrv_publish(context.get(), t.topic, &v, JSDRV_TIMEOUT_MS_DEFAULT);
+        if (0 == rc) {
+            context_ = context.get();
+            jsdrv_topic_set(&prefix_, device_prefix);
+        }
+        return rc;
+    }
+
+    /// Close the device.
+    int32_t close() {
+        int32_t rc = 0;
+        if (context_) {
+            rc = publish(JSDRV_MSG_CLOSE, int32_t(0));
+            context_ = NULL;
+            prefix_.topic[0] = 0;
+            prefix_.length = 0;
+        }
+        return rc;
+    }
+};
+
+#if JSDRV_CPP_COROUTINE
+
+class Buffer;
+
+/// The result of co_await on a Buffer request.
+class BufferResult {
+public:
+    int32_t rc = 0;                 ///< 0 or error code, #JSDRV_ERROR_ABORTED when closed while pending.
+    std::vector<uint8_t> data;      ///< The jsdrv_buffer_response_s when rc is 0.
+
+    /// The response or NULL.
+    const jsdrv_buffer_response_s * response() const {
+        return data.empty() ? nullptr : reinterpret_cast<const jsdrv_buffer_response_s *>(data.data());
+    }
+    /// The number of response data elements.
+    std::size_t size() const {
+        return data.empty() ? 0 : response()->info.time_range_samples.length;
+    }
+    /// The summary entries for JSDRV_BUFFER_RESPONSE_SUMMARY.
+    const jsdrv_summary_entry_s * summary() const {
+        return data.empty() ? nullptr : reinterpret_cast<const jsdrv_summary_entry_s *>(response()->data);
+    }
+};
+
+/// The awaitable for Buffer requests, which returns the BufferResult.
+class BufferAwaiter {
+public:
+    BufferAwaiter(Buffer * buffer, uint8_t signal_id, const jsdrv_buffer_request_s & req)
+            : buffer_(buffer), signal_id_(signal_id), req_(req), next_(nullptr) {}
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle) noexcept;
+    BufferResult await_resume() noexcept { return std::move(result_); }
+
+private:
+    friend class Buffer;
+    Buffer * buffer_;
+    uint8_t signal_id_;
+    jsdrv_buffer_request_s req_;
+    BufferAwaiter * next_;
+    std::coroutine_handle<> handle_;
+    BufferResult result_;
+};
+
+/**
+ * @brief Awaitable requests to a memory buffer.
+ *
+ * Each request publishes a jsdrv_buffer_request_s to
+ * "{buffer}/s/{signal_id}/!req" and resumes on the executor when the
+ * buffer responds on rsp_topic, so many requests may be in flight
+ * from one thread.  The rsp_topic must be unique to this instance.
+ * Requests return a single response, so the stream and standing
+ * request flags are cleared.  The buffer does not respond to some
+ * invalid requests, which then remain pending until close().
+ *
+ * The instance must outlive its pending requests and cannot move.
+ */
+class Buffer {
+public:
+    Buffer() = default;
+    ~Buffer() { close(); }
+    Buffer(const Buffer &) = delete;
+    Buffer & operator=(const Buffer &) = delete;
+
+    /**
+     * @brief Start receiving responses.
+     *
+     * @param context The initialized context.
+     * @param buffer_prefix The buffer prefix, such as "m/001".
+     * @param rsp_topic The response topic for all requests.
+     * @param executor The executor for completions.
+     * @return 0 or error code.
+     */
+    int32_t open(const Context & context, const char * buffer_prefix, const char * rsp_topic,
+                 const Executor & executor = Executor()) {
+        close();
+        jsdrv_topic_set(&prefix_, buffer_prefix);
+        std::snprintf(rsp_topic_, sizeof(rsp_topic_), "%s", rsp_topic);
+        executor_ = executor;
+        int32_t rc = context.subscribe(rsp_topic, JSDRV_SFLAG_PUB, [this](const char * topic, const jsdrv_union_s & value) {
+            (void) topic;
+            on_rsp(value);
+        }, sub_);
+        if (0 == rc) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            context_ = context.get();
+        }
+        return rc;
+    }
+
+    /// Stop receiving responses and complete pending requests with #JSDRV_ERROR_ABORTED.
+    void close() {
+        sub_.reset();
+        BufferAwaiter * a;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            context_ = nullptr;
+            a = pending_;
+            pending_ = nullptr;
+        }
+        while (a) {
+            BufferAwaiter * next = a->next_;
+            a->result_.rc = JSDRV_ERROR_ABORTED;
+            executor_.resume(a->handle_);
+            a = next;
+        }
+    }
+
+    /// Send a request, see jsdrv_buffer_request_s.
+    BufferAwaiter request(uint8_t signal_id, const jsdrv_buffer_request_s & req) {
+        return BufferAwaiter(this, signal_id, req);
+    }
+
+    /**
+     * @brief Request summary entries over a UTC time range.
+     *
+     * @param signal_id The buffer signal id.
+     * @param t0 The UTC time for the first entry.
+     * @param t1 The UTC time for the last entry.
+     * @param length The number of entries.
+     */
+    BufferAwaiter summary(uint8_t signal_id, int64_t t0, int64_t t1, uint32_t length) {
+        jsdrv_buffer_request_s req;
+        std::memset(&req, 0, sizeof(req));
+        req.version = 1;
+        req.time_type = JSDRV_TIME_UTC;
+        req.time.utc.start = t0;
+        req.time.utc.end = t1;
+        req.time.utc.length = length;
+        return request(signal_id, req);
+    }
+
+private:
+    friend class BufferAwaiter;
+
+    int32_t start(BufferAwaiter * a) {
+        jsdrv_buffer_request_s & req = a->req_;
+        req.flags &= ~(JSDRV_BUFFER_REQUEST_FLAG_STREAM | JSDRV_BUFFER_REQUEST_FLAG_STANDING);
+        std::snprintf(req.rsp_topic, sizeof(req.rsp_topic), "%s", rsp_topic_);
+        char signal_id[4];
+        std::snprintf(signal_id, sizeof(signal_id), "%03u", static_cast<unsigned>(a->signal_id_));
+        jsdrv_topic_s topic = prefix_;
+        jsdrv_topic_append(&topic, "s");
+        jsdrv_topic_append(&topic, signal_id);
+        jsdrv_topic_append(&topic, "!req");
+        jsdrv_union_s v;
+        std::memset(&v, 0, sizeof(v));
+        v.type = JSDRV_UNION_BIN;
+        v.value.bin = reinterpret_cast<const uint8_t *>(&req);
+        v.size = sizeof(req);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!context_) {
+                return JSDRV_ERROR_CLOSED;
+            }
+            req.rsp_id = rsp_id_next_++;
+            a->next_ = pending_;
+            pending_ = a;
+        }
+        int32_t rc = jsdrv_publish(context_, topic.topic, &v, 0);
+        if (rc && remove(req.rsp_id)) {
+            return rc;
+        }
+        return 0;  // a may already be complete
+    }
+
+    BufferAwaiter * remove(int64_t rsp_id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (BufferAwaiter ** p = &pending_; *p; p = &(*p)->next_) {
+            BufferAwaiter * a = *p;
+            if (a->req_.rsp_id == rsp_id) {
+                *p = a->next_;
+                return a;
+            }
+        }
+        return nullptr;
+    }
+
+    void on_rsp(const jsdrv_union_s & value) {
+        if ((JSDRV_UNION_BIN != value.type) || (value.size < sizeof(jsdrv_buffer_response_s))) {
+            return;
+        }
+        const jsdrv_buffer_response_s * rsp = reinterpret_cast<const jsdrv_buffer_response_s *>(value.value.bin);
+        BufferAwaiter * a = remove(rsp->rsp_id);
+        if (a) {
+            a->result_.data.assign(value.value.bin, value.value.bin + value.size);
+            executor_.resume(a->handle_);
+        }
+    }
+
+    jsdrv_context_s * context_ = nullptr;
+    jsdrv_topic_s prefix_{};
+    char rsp_topic_[JSDRV_TOPIC_LENGTH_MAX] = {0};
+    Executor executor_;
+    Subscription sub_;
+    std::mutex mutex_;
+    BufferAwaiter * pending_ = nullptr;
+    int64_t rsp_id_next_ = 1;
+};
+
+inline bool BufferAwaiter::await_suspend(std::coroutine_handle<> handle) noexcept {
+    handle_ = handle;
+    int32_t rc = buffer_->start(this);
+    if (rc) {
+        result_.rc = rc;
+        return false;
+    }
+    return true;
+}
+
+#endif
+
+}  // namespace jsdrv
+
+/** @} */
+
+#endif  /* JSDRV_INCLUDE_HPP_ */
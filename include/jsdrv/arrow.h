@@ -0,0 +1,177 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Export stream and buffer data as Arrow record batches.
+ */
+
+#ifndef JSDRV_ARROW_H_
+#define JSDRV_ARROW_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv
+ * @defgroup jsdrv_arrow Arrow record batches
+ *
+ * @brief Accumulate samples into Arrow C Data Interface record batches.
+ *
+ * The batcher copies the samples from stream messages or buffer
+ * responses into columns until each batch contains row_count rows.
+ * The caller then takes ownership of the completed batch as an
+ * ArrowSchema and ArrowArray struct pair, which Arrow consumers,
+ * such as pyarrow, Polars and DuckDB, import without copying.
+ *
+ * Each row contains:
+ * - sample_id: uint64 "L", the sample id.
+ * - utc: timestamp "tsn:UTC", the UNIX time in nanoseconds from the
+ *   time_map.
+ * - value: the sample value.  Float signals use float32 "f".  Unsigned
+ *   integer signals, including packed u1 and u4, use uint8 "C",
+ *   uint16 "S" or uint32 "I".  Signed integer signals use int8 "c",
+ *   int16 "s" or int32 "i".
+ *
+ * Summary buffer responses replace value with the float32 avg, std,
+ * min and max columns, with the sample_id of the first sample in each
+ * summary window.
+ *
+ * Stream messages use undecimated sample ids, while buffer responses
+ * use the buffer's decimated sample ids, so use a separate batcher for
+ * each source.  A change in the value format completes the
+ * current batch early.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+/// The Arrow C Data Interface schema, see arrow.apache.org.
+struct ArrowSchema {
+    const char * format;
+    const char * name;
+    const char * metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema ** children;
+    struct ArrowSchema * dictionary;
+    void (*release)(struct ArrowSchema *);
+    void * private_data;
+};
+
+/// The Arrow C Data Interface array, see arrow.apache.org.
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void ** buffers;
+    struct ArrowArray ** children;
+    struct ArrowArray * dictionary;
+    void (*release)(struct ArrowArray *);
+    void * private_data;
+};
+
+#endif  /* ARROW_C_DATA_INTERFACE */
+
+/// The maximum rows for each batch.
+#define JSDRV_ARROW_ROWS_MAX (1U << 24)
+
+/// The opaque batcher instance.
+struct jsdrv_arrow_batcher_s;
+
+/**
+ * @brief Allocate a new batcher.
+ *
+ * @param row_count The rows for each completed batch, 1 to
+ *      JSDRV_ARROW_ROWS_MAX.
+ * @return The new instance, or NULL on invalid row_count.
+ */
+JSDRV_API struct jsdrv_arrow_batcher_s * jsdrv_arrow_batcher_alloc(uint32_t row_count);
+
+/**
+ * @brief Free a batcher and any batches it still owns.
+ *
+ * @param self The instance from jsdrv_arrow_batcher_alloc() or NULL.
+ *
+ * Batches already popped remain valid until their release callback.
+ */
+JSDRV_API void jsdrv_arrow_batcher_free(struct jsdrv_arrow_batcher_s * self);
+
+/**
+ * @brief Add the samples from a stream message.
+ *
+ * @param self The instance.
+ * @param stream The stream message.
+ * @return 0 or JSDRV_ERROR_PARAMETER_INVALID for unsupported types.
+ */
+JSDRV_API int32_t jsdrv_arrow_batcher_add_stream(struct jsdrv_arrow_batcher_s * self,
+                                                 const struct jsdrv_stream_signal_s * stream);
+
+/**
+ * @brief Add the samples or summaries from a buffer response.
+ *
+ * @param self The instance.
+ * @param rsp The buffer response.
+ * @return 0, JSDRV_ERROR_NOT_SUPPORTED for responses other than
+ *      samples and summaries, or JSDRV_ERROR_PARAMETER_INVALID for
+ *      unsupported types.
+ */
+JSDRV_API int32_t jsdrv_arrow_batcher_add_buffer_rsp(struct jsdrv_arrow_batcher_s * self,
+                                                     const struct jsdrv_buffer_response_s * rsp);
+
+/**
+ * @brief Get the number of completed batches.
+ *
+ * @param self The instance.
+ * @return The batches that jsdrv_arrow_batcher_pop() returns without
+ *      partial.
+ */
+JSDRV_API uint32_t jsdrv_arrow_batcher_ready(struct jsdrv_arrow_batcher_s * self);
+
+/**
+ * @brief Take ownership of the oldest batch.
+ *
+ * @param self The instance.
+ * @param[out] schema The struct "+s" schema for the batch.
+ * @param[out] array The struct array for the batch.
+ * @param partial When no batch is complete, also return the pending
+ *      rows, if any, as a shorter batch.
+ * @return 0 or JSDRV_ERROR_UNAVAILABLE when no batch is available.
+ *
+ * The caller, or the Arrow consumer that imports them, must call the
+ * schema and array release callbacks.
+ */
+JSDRV_API int32_t jsdrv_arrow_batcher_pop(struct jsdrv_arrow_batcher_s * self,
+                                          struct ArrowSchema * schema, struct ArrowArray * array, bool partial);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_ARROW_H_ */
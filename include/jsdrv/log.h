@@ -25,6 +25,7 @@
 
 #include "jsdrv/cmacro_inc.h"
 #include <stdint.h>
+#include <stdbool.h>
 
 #ifndef JSDRV_LOG_FILENAME_SIZE_MAX
 /// The filename maximum size, including the null terminator character.
@@ -168,6 +169,32 @@ JSDRV_API void jsdrv_log_level_set(int8_t level);
  */
 JSDRV_API int8_t jsdrv_log_level_get();
 
+/**
+ * @brief Enable or disable deferred log formatting.
+ *
+ * @param enable True to format driver log messages on the log thread.
+ *
+ * By default, each message formats in the calling thread under a global
+ * lock and then notifies the log thread.  In deferred mode, the driver's
+ * internal log macros instead copy the format string pointer and the
+ * arguments into a lock-free ring owned by the calling thread.  The log
+ * thread formats and dispatches the messages, and each batch wakes the
+ * log thread only once.  Use deferred mode at DEBUG levels where logging
+ * would otherwise perturb stream timing.
+ *
+ * jsdrv_log_publish() always formats immediately, since the caller's
+ * format string may not outlive the call.  Deferred messages from
+ * different threads may dispatch out of order.
+ */
+JSDRV_API void jsdrv_log_deferred_set(bool enable);
+
+/**
+ * @brief Get the deferred log formatting mode.
+ *
+ * @return True when deferred log formatting is enabled.
+ */
+JSDRV_API bool jsdrv_log_deferred_get();
+
 /**
  * @brief Initialize the singleton log handler.
  *
@@ -75,6 +75,69 @@ JSDRV_API int32_t jsdrv_meta_default(const char * meta, struct jsdrv_union_s * v
  */
 JSDRV_API int32_t jsdrv_meta_value(const char * meta, struct jsdrv_union_s * value);
 
+/// The schema dtype is "bool" and values convert to u8 0 or 1.
+#define JSDRV_META_SCHEMA_FLAG_BOOL     (0x01)
+/// The schema contains a "range".
+#define JSDRV_META_SCHEMA_FLAG_RANGE    (0x02)
+/// The schema contains "options".
+#define JSDRV_META_SCHEMA_FLAG_OPTIONS  (0x04)
+
+/**
+ * @brief A single option alias.
+ *
+ * Each "options" entry [value, alias1, ...] produces one
+ * jsdrv_meta_option_s for the value and one for each alias.
+ */
+struct jsdrv_meta_option_s {
+    struct jsdrv_union_s token;         ///< The JSON token, which references the metadata string.
+    union jsdrv_union_inner_u value;    ///< The canonical value in the schema dtype.
+};
+
+/**
+ * @brief The compiled metadata for fast value validation.
+ *
+ * The schema references strings in the JSON metadata, which must
+ * remain valid until jsdrv_meta_schema_free().
+ */
+struct jsdrv_meta_schema_s {
+    int32_t status;                         ///< The compile status returned by every validation.
+    uint8_t dtype;                          ///< The jsdrv_union_e data type or JSDRV_UNION_NULL.
+    uint8_t flags;                          ///< The JSDRV_META_SCHEMA_FLAG_* bitmap.
+    uint8_t range_count;                    ///< The number of range entries.
+    union jsdrv_union_inner_u range[3];     ///< The [min, max, step] range, not enforced.
+    uint32_t option_count;                  ///< The number of options entries.
+    uint32_t option_size;                   ///< The allocated options entries.
+    struct jsdrv_meta_option_s * options;   ///< The options table in metadata order.
+};
+
+/**
+ * @brief Compile the metadata into a schema.
+ *
+ * @param meta The JSON metadata.
+ * @param[out] schema The compiled schema.  Call jsdrv_meta_schema_free()
+ *      when done, even when this function returns an error.
+ * @return 0 or error code.  On error, jsdrv_meta_schema_value() also
+ *      returns this error code.
+ */
+JSDRV_API int32_t jsdrv_meta_compile(const char * meta, struct jsdrv_meta_schema_s * schema);
+
+/**
+ * @brief Validate a parameter value using the compiled schema.
+ *
+ * @param schema The schema from jsdrv_meta_compile().
+ * @param[inout] value The value, which is modified in place.
+ * @return 0 or error code.
+ * @see jsdrv_meta_value()
+ */
+JSDRV_API int32_t jsdrv_meta_schema_value(const struct jsdrv_meta_schema_s * schema, struct jsdrv_union_s * value);
+
+/**
+ * @brief Free the schema resources.
+ *
+ * @param schema The schema from jsdrv_meta_compile().
+ */
+JSDRV_API void jsdrv_meta_schema_free(struct jsdrv_meta_schema_s * schema);
+
 JSDRV_CPP_GUARD_END
 
 /** @} */
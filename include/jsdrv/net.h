@@ -0,0 +1,317 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Network access to the driver pubsub tree.
+ */
+
+#ifndef JSDRV_NET_H_
+#define JSDRV_NET_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include "jsdrv/union.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv
+ * @defgroup jsdrv_net Network server
+ *
+ * @brief Publish, query and subscribe to a driver instance over TCP.
+ *
+ * Only one process can open each device.  Run the server, such as
+ * "jsdrv_util server --host 127.0.0.1", in the process that owns the
+ * devices, and connect other local or remote processes with
+ * jsdrv_net_client_open().
+ *
+ * The server accepts TCP connections and exchanges frames in both
+ * directions.  Each frame starts with jsdrv_net_header_s, followed by
+ * topic_size topic bytes, followed by the value.  The topic is nul
+ * terminated and padded with nul to a multiple of 8 bytes so that the
+ * value stays 8-byte aligned.  All fields are little endian.  Pointer
+ * values (str, json and bin) contain the jsdrv_union_s size bytes.
+ * Null values contain no bytes, and other values contain 8 bytes
+ * holding the jsdrv_union_s value.
+ *
+ * Clients send:
+ * - JSDRV_NET_FRAME_PUBLISH: jsdrv_publish().
+ * - JSDRV_NET_FRAME_QUERY: jsdrv_query(), value is ignored.
+ * - JSDRV_NET_FRAME_SUBSCRIBE: jsdrv_subscribe() with the header
+ *   flags as jsdrv_subscribe_flag_e, and codec as the
+ *   jsdrv_net_codec_e for all stream data sent to this client.
+ * - JSDRV_NET_FRAME_UNSUBSCRIBE: jsdrv_unsubscribe().
+ *
+ * The server responds to each client frame, in order, with a
+ * JSDRV_NET_FRAME_RETURN_CODE frame for the same topic containing an
+ * i32 error code with op set to the request frame type.  Queries
+ * that succeed respond with JSDRV_NET_FRAME_QUERY including the value
+ * instead.  The server publishes asynchronously, so the publish return
+ * code only indicates that the driver accepted the value.  Subscribe with
+ * JSDRV_SFLAG_RETURN_CODE to receive the device return codes.  The server
+ * sends JSDRV_NET_FRAME_PUBLISH for each subscription update.
+ *
+ * The subscription topic filters the updates sent to each client.
+ * Each client has a bounded transmit queue.  When a client falls behind,
+ * the server discards stream data and other binary payloads for that
+ * client rather than delaying the driver or other clients.  The server
+ * never discards parameter or return code updates.
+ *
+ * The server does not authenticate or encrypt connections.  Any peer
+ * that connects can publish to any topic, which controls and reconfigures
+ * the devices.  The server binds to the loopback address by default.
+ * Bind other addresses only on trusted networks, and consider read_only
+ * to reject client publish frames.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The default TCP port.
+#define JSDRV_NET_PORT_DEFAULT          (7411U)
+/// The default transmit queue size for each client, in bytes.
+#define JSDRV_NET_QUEUE_SIZE_DEFAULT    (32U * 1024U * 1024U)
+/// The maximum number of simultaneous clients.
+#define JSDRV_NET_CLIENTS_MAX           (8U)
+/// The maximum frame size in bytes.
+#define JSDRV_NET_FRAME_SIZE_MAX        (256U * 1024U)
+
+/// The frame types.
+enum jsdrv_net_frame_e {
+    JSDRV_NET_FRAME_PUBLISH = 1,        ///< Publish or subscription update.
+    JSDRV_NET_FRAME_QUERY = 2,          ///< Query a retained value.
+    JSDRV_NET_FRAME_SUBSCRIBE = 3,      ///< Subscribe to a topic.
+    JSDRV_NET_FRAME_UNSUBSCRIBE = 4,    ///< Unsubscribe from a topic.
+    JSDRV_NET_FRAME_RETURN_CODE = 5,    ///< The i32 result of a client frame.
+};
+
+/**
+ * @brief The stream data codecs.
+ *
+ * The codecs apply only to the data of JSDRV_PAYLOAD_TYPE_STREAM
+ * values.  The jsdrv_stream_signal_s header remains uncompressed.
+ * The server falls back to JSDRV_NET_CODEC_RAW for each frame that
+ * does not compress.
+ */
+enum jsdrv_net_codec_e {
+    JSDRV_NET_CODEC_RAW = 0,            ///< Uncompressed.
+    JSDRV_NET_CODEC_COMPRESS = 1,       ///< Subscribe only: select by element type.
+    JSDRV_NET_CODEC_RLE8 = 2,           ///< Byte run-length, for u1, u4 and u8 samples.
+    JSDRV_NET_CODEC_XOR_F32 = 3,        ///< XOR with the previous f32 sample.
+};
+
+/// The frame header.
+struct jsdrv_net_header_s {
+    uint32_t length;        ///< The total frame length in bytes, including this header.
+    uint8_t frame_type;     ///< jsdrv_net_frame_e
+    uint8_t codec;          ///< jsdrv_net_codec_e
+    uint16_t topic_size;    ///< The padded topic size in bytes, a multiple of 8.
+    uint8_t type;           ///< The jsdrv_union_s type.
+    uint8_t flags;          ///< The jsdrv_union_s flags, or subscribe flags.
+    uint8_t op;             ///< The jsdrv_union_s op.
+    uint8_t app;            ///< The jsdrv_union_s app.
+    uint32_t size;          ///< The jsdrv_union_s size, before compression.
+};
+
+/// A decoded frame.
+struct jsdrv_net_frame_s {
+    uint8_t frame_type;     ///< jsdrv_net_frame_e
+    uint8_t codec;          ///< jsdrv_net_codec_e, only for JSDRV_NET_FRAME_SUBSCRIBE.
+    const char * topic;     ///< The topic.
+    struct jsdrv_union_s value;  ///< The value, which may reference the frame or scratch buffer.
+};
+
+/**
+ * @brief Encode a frame.
+ *
+ * @param frame_type The jsdrv_net_frame_e.
+ * @param topic The topic.
+ * @param value The value, or NULL for null.
+ * @param codec The jsdrv_net_codec_e for stream data.
+ * @param[out] buf The destination buffer.
+ * @param buf_size The size of buf in bytes.
+ * @return The frame length, or 0 if buf_size is too small or the
+ *      parameters are invalid.
+ */
+JSDRV_API uint32_t jsdrv_net_encode(uint8_t frame_type, const char * topic,
+                                    const struct jsdrv_union_s * value, uint8_t codec,
+                                    uint8_t * buf, uint32_t buf_size);
+
+/**
+ * @brief Decode a frame.
+ *
+ * @param buf The frame from jsdrv_net_encode().
+ * @param size The frame length in bytes.
+ * @param[out] frame The decoded frame.
+ * @param scratch The buffer for decompressed stream data, which must hold
+ *      a full jsdrv_stream_signal_s.  NULL if not needed.
+ * @param scratch_size The size of scratch in bytes.
+ * @return 0, JSDRV_ERROR_TOO_SMALL when size does not contain the
+ *      full frame, or JSDRV_ERROR_PARAMETER_INVALID for corrupt frames.
+ */
+JSDRV_API int32_t jsdrv_net_decode(const uint8_t * buf, uint32_t size, struct jsdrv_net_frame_s * frame,
+                                   uint8_t * scratch, uint32_t scratch_size);
+
+/// The server configuration.
+struct jsdrv_net_server_config_s {
+    const char * host;      ///< The local address to bind, NULL for 127.0.0.1, "0.0.0.0" for all interfaces.
+    uint16_t port;          ///< The TCP port, 0 for any available port.
+    uint32_t queue_size;    ///< The transmit queue size for each client, 0 for default.
+    uint8_t read_only;      ///< Nonzero to reject client publish frames with JSDRV_ERROR_PERMISSIONS.
+};
+
+// opaque server instance
+struct jsdrv_net_server_s;
+struct jsdrv_context_s;
+
+/**
+ * @brief Start a network server.
+ *
+ * @param context The driver context.
+ * @param config The configuration.
+ * @param[out] server The server instance.
+ * @return 0 or error code.
+ */
+JSDRV_API int32_t jsdrv_net_server_open(struct jsdrv_context_s * context,
+                                        const struct jsdrv_net_server_config_s * config,
+                                        struct jsdrv_net_server_s ** server);
+
+/**
+ * @brief Get the server TCP port.
+ *
+ * @param server The server instance.
+ * @return The bound port, which is useful when the configured port is 0.
+ */
+JSDRV_API uint16_t jsdrv_net_server_port(struct jsdrv_net_server_s * server);
+
+/**
+ * @brief Stop a network server.
+ *
+ * @param server The server instance, which is freed.
+ *
+ * Disconnects all clients and removes their subscriptions.
+ * Call before jsdrv_finalize().
+ */
+JSDRV_API void jsdrv_net_server_close(struct jsdrv_net_server_s * server);
+
+/// The client configuration.
+struct jsdrv_net_client_config_s {
+    const char * host;      ///< The server address, NULL for 127.0.0.1.
+    uint16_t port;          ///< The server TCP port, 0 for JSDRV_NET_PORT_DEFAULT.
+    uint8_t codec;          ///< The jsdrv_net_codec_e for stream data.
+};
+
+// opaque client instance
+struct jsdrv_net_client_s;
+
+/**
+ * @brief Connect to a network server.
+ *
+ * @param config The configuration.
+ * @param[out] client The client instance.
+ * @return 0 or error code.
+ *
+ * The client functions mirror jsdrv_publish(), jsdrv_query(),
+ * jsdrv_subscribe() and jsdrv_unsubscribe(), so that several processes
+ * can share one driver instance, and its devices, through a single
+ * server.  Each stream is decoded once by the server process.  Local
+ * clients that need the full sample rate without the TCP copies can
+ * publish to the x/NNN shared memory export topics, see jsdrv_shm,
+ * and read the data with jsdrv_shm_reader_open().
+ */
+JSDRV_API int32_t jsdrv_net_client_open(const struct jsdrv_net_client_config_s * config,
+                                        struct jsdrv_net_client_s ** client);
+
+/**
+ * @brief Disconnect from the server.
+ *
+ * @param client The client instance, which is freed.  NULL is ignored.
+ *
+ * The server removes all subscriptions for this client.
+ */
+JSDRV_API void jsdrv_net_client_close(struct jsdrv_net_client_s * client);
+
+/**
+ * @brief Publish a value to the server, like jsdrv_publish().
+ *
+ * @param client The client instance.
+ * @param topic The topic.
+ * @param value The value.
+ * @param timeout_ms The maximum time to wait for the server to accept the
+ *      value, or 0 to return without waiting.
+ * @return 0 or error code.
+ */
+JSDRV_API int32_t jsdrv_net_client_publish(struct jsdrv_net_client_s * client, const char * topic,
+                                           const struct jsdrv_union_s * value, uint32_t timeout_ms);
+
+/**
+ * @brief Query a retained value from the server, like jsdrv_query().
+ *
+ * @param client The client instance.
+ * @param topic The topic.
+ * @param[inout] value The value.  For str, json and bin values, provide
+ *      the buffer in value.bin with its size in value.size.
+ * @param timeout_ms The maximum time to wait, which must be nonzero.
+ * @return 0 or error code.
+ */
+JSDRV_API int32_t jsdrv_net_client_query(struct jsdrv_net_client_s * client, const char * topic,
+                                         struct jsdrv_union_s * value, uint32_t timeout_ms);
+
+/**
+ * @brief Subscribe to a topic on the server, like jsdrv_subscribe().
+ *
+ * @param client The client instance.
+ * @param topic The topic or wildcard pattern.
+ * @param flags The jsdrv_subscribe_flag_e bitmap.
+ * @param cbk_fn The function to call on each update.
+ * @param cbk_user_data The arbitrary data for cbk_fn.
+ * @param timeout_ms The maximum time to wait, or 0 to return without waiting.
+ * @return 0 or error code.
+ *
+ * The client only forwards the topics not already included by another
+ * subscription, with the combined flags, and delivers each update to
+ * all matching subscribers.  Subscribing with JSDRV_SFLAG_RETAIN
+ * resubscribes the forwarded topic, so the other subscribers within
+ * that topic may receive the retained values again.  Overlapping
+ * wildcard subscriptions may receive an update more than once.
+ * cbk_fn runs on the client receive thread and must not call the
+ * jsdrv_net_client functions.
+ */
+JSDRV_API int32_t jsdrv_net_client_subscribe(struct jsdrv_net_client_s * client, const char * topic, uint8_t flags,
+                                             jsdrv_subscribe_fn cbk_fn, void * cbk_user_data,
+                                             uint32_t timeout_ms);
+
+/**
+ * @brief Unsubscribe from a topic on the server, like jsdrv_unsubscribe().
+ *
+ * @param client The client instance.
+ * @param topic The topic provided to jsdrv_net_client_subscribe().
+ * @param cbk_fn The function provided to jsdrv_net_client_subscribe().
+ * @param cbk_user_data The data provided to jsdrv_net_client_subscribe().
+ * @param timeout_ms The maximum time to wait, or 0 to return without waiting.
+ * @return 0 or error code.
+ */
+JSDRV_API int32_t jsdrv_net_client_unsubscribe(struct jsdrv_net_client_s * client, const char * topic,
+                                               jsdrv_subscribe_fn cbk_fn, void * cbk_user_data,
+                                               uint32_t timeout_ms);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_NET_H_ */
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Read stream data exported to shared memory.
+ */
+
+#ifndef JSDRV_SHM_H_
+#define JSDRV_SHM_H_
+
+#include "jsdrv/cmacro_inc.h"
+#include "jsdrv/time.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv
+ * @defgroup jsdrv_shm Shared memory stream export
+ *
+ * @brief Read stream data from other processes without copies.
+ *
+ * The driver exports a stream data topic to a named shared memory
+ * region.  Configure x/NNN/signal, x/NNN/size, and then publish the
+ * region name to x/NNN/!open, where NNN is 001 to 004.
+ *
+ * The region starts with jsdrv_shm_header_s followed by a ring of
+ * capacity elements at header_size.  The driver unpacks u1 and u4
+ * samples to one sample per byte.  Element write_count - 1 is the newest,
+ * and the ring contains the elements from
+ * max(0, write_count - capacity) to write_count - 1.  Element k is at
+ * data index k % capacity and corresponds to sample id
+ * sample_id - (write_count - k) * decimate_factor.  When the stream
+ * skips samples, the driver fills the gap with NaN for floats and
+ * 0 otherwise.
+ *
+ * The header uses a sequence lock.  The driver increments seq before
+ * and after each update, so seq is odd during an update.  Readers copy
+ * the header and retry when seq changed or was odd.  After reading elements
+ * from the ring, readers confirm that the writer did not overwrite
+ * them using a fresh header.  jsdrv_shm_reader_header() and
+ * jsdrv_shm_reader_read() implement this protocol.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The jsdrv_shm_header_s magic value.
+#define JSDRV_SHM_MAGIC             "jsdrvshm"
+/// The shared memory format version.
+#define JSDRV_SHM_VERSION           (1U)
+/// The offset to the ring data, in bytes.
+#define JSDRV_SHM_HEADER_SIZE       (256U)
+/// The maximum topic length including the nul terminator.
+#define JSDRV_SHM_TOPIC_LENGTH_MAX  (64U)
+
+/// The shared memory header.
+struct jsdrv_shm_header_s {
+    char magic[8];                  ///< JSDRV_SHM_MAGIC without the nul terminator.
+    uint32_t version;               ///< JSDRV_SHM_VERSION.
+    uint32_t header_size;           ///< The offset to the ring data, JSDRV_SHM_HEADER_SIZE.
+    volatile int32_t seq;           ///< The sequence lock, odd during updates.
+    uint32_t rsv1_u32;              ///< Reserved, 0.
+    uint64_t capacity;              ///< The ring size in elements.
+    uint64_t write_count;           ///< The total number of elements written.
+    uint64_t sample_id;             ///< The sample id for element write_count.
+    struct jsdrv_time_map_s time_map;   ///< The most recent time map.
+    uint32_t sample_rate;           ///< The device sample rate in Hz.
+    uint32_t decimate_factor;       ///< The sample id increment between elements.
+    uint8_t field_id;               ///< jsdrv_field_e
+    uint8_t index;                  ///< The channel index within the field.
+    uint8_t element_type;           ///< jsdrv_element_type_e, 0 before the first data.
+    uint8_t element_size_bits;      ///< The ring element size in bits, 8, 16, 32 or 64.
+    uint32_t rsv2_u32;              ///< Reserved, 0.
+    char topic[JSDRV_SHM_TOPIC_LENGTH_MAX];  ///< The exported stream data topic.
+};
+
+// opaque reader instance
+struct jsdrv_shm_reader_s;
+
+/**
+ * @brief Open a shared memory stream export.
+ *
+ * @param name The region name published to x/NNN/!open.
+ * @param[out] reader The reader instance.
+ * @return 0, JSDRV_ERROR_NOT_FOUND, or JSDRV_ERROR_NOT_SUPPORTED
+ *      for an incompatible region.
+ */
+JSDRV_API int32_t jsdrv_shm_reader_open(const char * name, struct jsdrv_shm_reader_s ** reader);
+
+/**
+ * @brief Close a reader.
+ *
+ * @param reader The reader instance, which is freed.
+ *
+ * The export remains valid for other readers.
+ */
+JSDRV_API void jsdrv_shm_reader_close(struct jsdrv_shm_reader_s * reader);
+
+/**
+ * @brief Get a consistent copy of the header.
+ *
+ * @param reader The reader instance.
+ * @param[out] header The header copy.
+ * @return 0 or JSDRV_ERROR_BUSY when the writer stopped mid-update.
+ */
+JSDRV_API int32_t jsdrv_shm_reader_header(struct jsdrv_shm_reader_s * reader, struct jsdrv_shm_header_s * header);
+
+/**
+ * @brief Get the ring data for direct access.
+ *
+ * @param reader The reader instance.
+ * @return The pointer to the capacity ring elements.
+ *
+ * Elements may be overwritten at any time.  Confirm that the writer
+ * did not overwrite them using jsdrv_shm_reader_header() after access.
+ */
+JSDRV_API const void * jsdrv_shm_reader_data(struct jsdrv_shm_reader_s * reader);
+
+/**
+ * @brief Copy elements from the ring.
+ *
+ * @param reader The reader instance.
+ * @param sample_id The sample id of the first element.
+ * @param count The number of elements.
+ * @param[out] data The destination for count elements.
+ * @return 0, JSDRV_ERROR_UNAVAILABLE when the elements are not yet written
+ *      or overwritten, JSDRV_ERROR_PARAMETER_INVALID when sample_id does
+ *      not correspond to an element, or JSDRV_ERROR_BUSY.
+ */
+JSDRV_API int32_t jsdrv_shm_reader_read(struct jsdrv_shm_reader_s * reader,
+                                        uint64_t sample_id, uint64_t count, void * data);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_SHM_H_ */
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Blocking reads of aligned stream samples.
+ */
+
+#ifndef JSDRV_STREAM_READER_H_
+#define JSDRV_STREAM_READER_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv
+ * @defgroup jsdrv_stream_reader Stream reader
+ *
+ * @brief Pull aligned samples from stream topics into caller arrays.
+ *
+ * The reader subscribes to each "!data" topic and copies the samples
+ * into a separate single-producer, single-consumer ring for each
+ * channel.  jsdrv_stream_reader_read() then waits until the requested
+ * samples are available for every channel and copies them, aligned
+ * by sample id, into the caller's preallocated arrays.
+ *
+ * Float channels produce float32 samples.  Unsigned integer channels,
+ * including packed u1 and u4 and event-encoded signals, produce one
+ * uint8 per sample.  The reader fills missing samples, including the
+ * samples dropped when a ring is full, with NaN or 0 so that the
+ * channels always remain aligned.
+ *
+ * All channels must have the same decimated sample rate.  The
+ * jsdrv_stream_reader_read() caller must be a single thread, which
+ * may be any thread other than the jsdrv frontend thread.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The maximum number of channels for each reader.
+#define JSDRV_STREAM_READER_CHANNELS_MAX (16U)
+
+/// The maximum ring capacity in samples for each channel.
+#define JSDRV_STREAM_READER_CAPACITY_MAX (1U << 28)
+
+/// The opaque reader instance.
+struct jsdrv_stream_reader_s;
+
+/// The information for each jsdrv_stream_reader_read().
+struct jsdrv_stream_reader_info_s {
+    uint64_t sample_id;         ///< The undecimated sample id of the first sample.
+    uint32_t decimate_factor;   ///< The sample id increment for each sample.
+    uint32_t sample_rate;       ///< The sample rate for sample_id, before decimate_factor.
+    uint32_t sample_count;      ///< The number of samples copied for each channel.
+    uint32_t rsv1_u32;
+    uint64_t gap_count;         ///< The samples filled with NaN or 0 since the last read, for all channels.
+    uint64_t overrun_count;     ///< The samples dropped on full rings since the last read, for all channels.
+};
+
+/**
+ * @brief Open a stream reader.
+ *
+ * @param context The driver context.
+ * @param topics The "!data" topics, one for each channel.
+ * @param element_types The jsdrv_element_type_e for each channel,
+ *      JSDRV_DATA_TYPE_FLOAT or JSDRV_DATA_TYPE_UINT.
+ *      NULL selects JSDRV_DATA_TYPE_FLOAT for all channels.
+ * @param channel_count The number of channels, 1 to
+ *      JSDRV_STREAM_READER_CHANNELS_MAX.
+ * @param capacity The minimum ring capacity in samples for each channel,
+ *      up to JSDRV_STREAM_READER_CAPACITY_MAX.
+ * @param[out] reader The reader instance.
+ * @return 0 or error code.
+ *
+ * Messages with a different element type than the channel are dropped
+ * and counted as overruns.
+ */
+JSDRV_API int32_t jsdrv_stream_reader_open(struct jsdrv_context_s * context,
+                                           const char * const * topics, const uint8_t * element_types,
+                                           uint32_t channel_count, uint32_t capacity,
+                                           struct jsdrv_stream_reader_s ** reader);
+
+/**
+ * @brief Close a reader.
+ *
+ * @param reader The reader instance, which is freed.  NULL is ignored.
+ *
+ * Do not call while another thread is in jsdrv_stream_reader_read().
+ */
+JSDRV_API void jsdrv_stream_reader_close(struct jsdrv_stream_reader_s * reader);
+
+/**
+ * @brief Read aligned samples for all channels.
+ *
+ * @param reader The reader instance.
+ * @param out The destination arrays, one for each channel, with room
+ *      for sample_count float32 or uint8 samples.
+ * @param sample_count The number of samples to read for each channel,
+ *      up to the ring capacity, which is the open capacity rounded up
+ *      to a power of 2.
+ * @param timeout_ms The maximum time to wait.  0 copies only the
+ *      samples that are already available.
+ * @param[out] info The information for the copied samples.  NULL is ignored.
+ * @return 0 when all sample_count samples were copied,
+ *      JSDRV_ERROR_TIMED_OUT when fewer were copied, as indicated
+ *      by info->sample_count, JSDRV_ERROR_NOT_SUPPORTED when the
+ *      channels have different decimate factors, or
+ *      JSDRV_ERROR_PARAMETER_INVALID when sample_count exceeds the
+ *      ring capacity.
+ */
+JSDRV_API int32_t jsdrv_stream_reader_read(struct jsdrv_stream_reader_s * reader,
+                                           void * const * out, uint32_t sample_count, uint32_t timeout_ms,
+                                           struct jsdrv_stream_reader_info_s * info);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_STREAM_READER_H_ */
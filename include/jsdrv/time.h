@@ -403,6 +403,18 @@ JSDRV_INLINE_FN int64_t jsdrv_time_max(int64_t a, int64_t b) {
  */
 JSDRV_API int32_t jsdrv_time_to_str(int64_t t, char * str, size_t size);
 
+/**
+ * @brief Get the monotonic time.
+ *
+ * @return The current monotonic time in JSDRV time units (34Q30).
+ *
+ * The epoch is arbitrary and the time never steps, which makes this
+ * suitable for measuring durations within a process, such as the
+ * stream message latency stamps in struct jsdrv_stream_latency_s.
+ * Use jsdrv_time_utc() for wall-clock time.
+ */
+JSDRV_API int64_t jsdrv_time_monotonic(void);
+
 /**
  * @brief Define a mapping between JSDRV time and a counter.
  *
@@ -427,6 +439,36 @@ struct jsdrv_time_map_s {
  */
 JSDRV_API int64_t jsdrv_time_from_counter(const struct jsdrv_time_map_s * self, uint64_t counter);
 
+/**
+ * @brief Convert a range of counter values to JSDRV time.
+ *
+ * @param self The time mapping instance.
+ * @param counter The first counter value u64.
+ * @param incr The counter increment between elements, such as the
+ *      sample_id decimate factor.
+ * @param[out] time64 The JSDRV time i64 for each counter value.
+ * @param count The number of elements.
+ *
+ * time64[k] equals jsdrv_time_from_counter(self, counter + k * incr)
+ * exactly.  The function uses SIMD instructions when the host CPU
+ * supports them.
+ */
+JSDRV_API void jsdrv_time_from_counter_range(const struct jsdrv_time_map_s * self, uint64_t counter, uint32_t incr,
+                                             int64_t * time64, size_t count);
+
+/**
+ * @brief Convert a range of counter values to JSDRV time in seconds.
+ *
+ * @param self The time mapping instance.
+ * @param counter The first counter value u64.
+ * @param incr The counter increment between elements.
+ * @param[out] t The JSDRV time in double precision seconds, which is
+ *      JSDRV_TIME_TO_F64() of each jsdrv_time_from_counter_range() value.
+ * @param count The number of elements.
+ */
+JSDRV_API void jsdrv_time_from_counter_range_f64(const struct jsdrv_time_map_s * self, uint64_t counter, uint32_t incr,
+                                                 double * t, size_t count);
+
 /**
  * @brief Convert time from JSDRV time to a counter value.
  *
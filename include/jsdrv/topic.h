@@ -120,6 +120,27 @@ JSDRV_API void jsdrv_topic_suffix_add(struct jsdrv_topic_s * topic, char ch);
  */
 JSDRV_API char jsdrv_topic_suffix_remove(struct jsdrv_topic_s * topic);
 
+/**
+ * @brief Check if a subscription topic contains wildcards.
+ *
+ * @param pattern The subscription topic.
+ * @return True if any level of pattern is "+" or the last level is "#".
+ */
+JSDRV_API bool jsdrv_topic_is_wildcard(const char * pattern);
+
+/**
+ * @brief Match a topic against a wildcard subscription topic.
+ *
+ * @param pattern The subscription topic.  A "+" level matches any
+ *      single level.  A "#" last level matches zero or more levels.
+ *      All other levels must match exactly.
+ * @param topic The full topic name without a suffix character.
+ * @return True if topic matches pattern.
+ *
+ * Unlike a normal subscription, a pattern without "#" does not
+ * match the children of the matched topics.
+ */
+JSDRV_API bool jsdrv_topic_match(const char * pattern, const char * topic);
 
 JSDRV_CPP_GUARD_END
 
@@ -169,6 +169,53 @@ JSDRV_API bool jsdrv_union_eq(const struct jsdrv_union_s * v1, const struct jsdr
  */
 JSDRV_API bool jsdrv_union_eq_exact(const struct jsdrv_union_s * v1, const struct jsdrv_union_s * v2);
 
+/**
+ * @brief Check if two values are equal with bounded pointer comparisons.
+ *
+ * @param v1 The first value.
+ * @param v2 The second value.
+ * @param size_max The maximum STR, JSON, or BIN size in bytes to compare.
+ *      Larger values compare as not equal without examining the payload.
+ * @return True if equal, false if not equal or too large to compare.
+ *
+ * This function compares numeric values inline and checks the
+ * type, size, and pointer before comparing any payload.
+ * Use it for de-duplication, where a false "not equal" only costs
+ * a redundant publish.
+ * @see jsdrv_union_eq()
+ */
+static inline bool jsdrv_union_eq_bounded(const struct jsdrv_union_s * v1, const struct jsdrv_union_s * v2,
+                                          uint32_t size_max) {
+    if (v1->type != v2->type) {
+        return false;
+    }
+    switch (v1->type) {
+        case JSDRV_UNION_NULL: return true;
+        case JSDRV_UNION_F32: return v1->value.f32 == v2->value.f32;
+        case JSDRV_UNION_F64: return v1->value.f64 == v2->value.f64;
+        case JSDRV_UNION_U8:  return v1->value.u8 == v2->value.u8;
+        case JSDRV_UNION_U16: return v1->value.u16 == v2->value.u16;
+        case JSDRV_UNION_U32: return v1->value.u32 == v2->value.u32;
+        case JSDRV_UNION_U64: return v1->value.u64 == v2->value.u64;
+        case JSDRV_UNION_I8:  return v1->value.i8 == v2->value.i8;
+        case JSDRV_UNION_I16: return v1->value.i16 == v2->value.i16;
+        case JSDRV_UNION_I32: return v1->value.i32 == v2->value.i32;
+        case JSDRV_UNION_I64: return v1->value.i64 == v2->value.i64;
+        case JSDRV_UNION_STR:   // intentional fall-through
+        case JSDRV_UNION_JSON:  // intentional fall-through
+        case JSDRV_UNION_BIN:
+            if ((v1->size != v2->size) || (v1->size > size_max)) {
+                return false;
+            }
+            if (v1->value.bin == v2->value.bin) {
+                return true;
+            }
+            return jsdrv_union_eq(v1, v2);
+        default:
+            return false;
+    }
+}
+
 /**
  * @brief Check if two values are equivalent.
  *
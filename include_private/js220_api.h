@@ -196,15 +196,25 @@ struct js220_port0_timemap_s {
  * [15:0]   frame_id[15:0], increments with each frame.
  * [24:16]  payload_length[8:0] in bytes, excluding these 4 bytes, 511 bytes max.
  * [29:25]  port_id[4:0]
- * [31:30]  reserved[1:0]
+ * [31:30]  codec[1:0], the jsdrv_codec_e for data ports 16 and above, 0 otherwise.
+ *
+ * A data port frame with a nonzero codec has the payload:
+ *
+ * [31:0]   sample_id[31:0], identical to uncompressed frames.
+ * [15:0]   decoded_length[15:0] in bytes, JS220_PORT_DECODE_SIZE_MAX max.
+ * [31:16]  reserved[15:0]
+ *          The encoded samples.
  */
 struct js220_frame_hdr_s {
     uint32_t frame_id:16;       ///< The frame identifier that increments with each frame.
     uint32_t length:9;          ///< The length of the payload in bytes.
     uint32_t port_id:5;         ///< The port_id for this message.
-    uint32_t rsv:2;             ///< Reserved.  Set to 0.
+    uint32_t codec:2;           ///< The data port codec.  0 for uncompressed.
 };
 
+/// The maximum decoded data port sample bytes for one compressed frame.
+#define JS220_PORT_DECODE_SIZE_MAX (8192U)
+
 union js220_frame_hdr_u {
     struct js220_frame_hdr_s h;
     uint32_t u32;
@@ -228,6 +238,10 @@ static inline uint8_t js220_frame_hdr_extract_port_id(uint32_t hdr) {
     return ((uint8_t) ((hdr >> 25) & 0x1f));
 }
 
+static inline uint8_t js220_frame_hdr_extract_codec(uint32_t hdr) {
+    return ((uint8_t) ((hdr >> 30) & 0x3));
+}
+
 union js220_port0_payload_u {
     struct js220_port0_connect_s connect;
     struct js220_port0_timesync_s timesync;
@@ -272,6 +286,7 @@ enum js220_port3_op_e {
     JS220_PORT3_OP_WRITE_FINALIZE   = 5, // OUT
     JS220_PORT3_OP_READ_REQ         = 6, // OUT
     JS220_PORT3_OP_READ_DATA        = 7, // IN
+    JS220_PORT3_OP_HASH_REQ         = 8, // OUT, ACK data is the u32[16] calibration hash of length bytes, 0xff padded to 32
     JS220_PORT3_OP_BOOT             = 15, // OUT, arg contains boot_target_e
 };
 
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Multi-device time alignment.
+ */
+
+#ifndef JSDRV_PRV_ALIGN_H_
+#define JSDRV_PRV_ALIGN_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_align Time alignment
+ *
+ * @brief Align stream samples from multiple devices to a common timebase.
+ *
+ * Each device maps its sample_id to UTC using the time map in every
+ * stream message.  The alignment service collects the latest time map
+ * from each source to publish the common timebase mapping.  When
+ * frames are enabled, the service also linearly interpolates each
+ * f32 source at the times of the master source 0 samples and publishes
+ * sample-aligned frames.
+ *
+ * Topics:
+ * - t/!add: str source stream data topic, such as "u/js220/000415/s/i/!data".
+ * - t/!remove: str source stream data topic.
+ * - t/list: str comma-separated source topics, master first.
+ * - t/frames: u8 1 to publish aligned frames on t/!data, 0 to disable.
+ * - t/map: bin jsdrv_align_map_s, published once per second.
+ * - t/!data: bin jsdrv_align_frame_s.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+#ifndef JSDRV_ALIGN_RING_SIZE
+/// The samples retained for each source, which must be a power of 2.
+#define JSDRV_ALIGN_RING_SIZE (1U << 18)
+#endif
+
+#define JSDRV_ALIGN_MSG_ADD         "t/!add"
+#define JSDRV_ALIGN_MSG_REMOVE      "t/!remove"
+#define JSDRV_ALIGN_MSG_LIST        "t/list"
+#define JSDRV_ALIGN_MSG_FRAMES      "t/frames"
+#define JSDRV_ALIGN_MSG_MAP         "t/map"
+#define JSDRV_ALIGN_MSG_DATA        "t/!data"
+
+// forward declarations
+struct jsdrv_context_s;
+struct jsdrv_align_s;
+
+/**
+ * @brief The function called for each aligned frame.
+ *
+ * @param user_data The arbitrary user data.
+ * @param frame The aligned frame, which is only valid for the duration
+ *      of the callback.
+ * @param size The frame size in bytes, including only element_count
+ *      samples for each source.
+ */
+typedef void (*jsdrv_align_frame_fn)(void * user_data, const struct jsdrv_align_frame_s * frame, uint32_t size);
+
+/**
+ * @brief Allocate a new alignment instance.
+ *
+ * @param frame_fn The function called for each aligned frame.
+ * @param user_data The arbitrary data for frame_fn.
+ * @return The new instance with no sources and frames disabled.
+ */
+struct jsdrv_align_s * jsdrv_align_alloc(jsdrv_align_frame_fn frame_fn, void * user_data);
+
+/**
+ * @brief Free an alignment instance.
+ *
+ * @param self The instance from jsdrv_align_alloc().
+ */
+void jsdrv_align_free(struct jsdrv_align_s * self);
+
+/**
+ * @brief Set the number of sources.
+ *
+ * @param self The instance.
+ * @param source_count The number of sources, up to JSDRV_ALIGN_SOURCES_MAX.
+ * @return 0 or JSDRV_ERROR_PARAMETER_INVALID.
+ *
+ * Changing the sources clears all retained samples and time maps.
+ */
+int32_t jsdrv_align_source_count_set(struct jsdrv_align_s * self, uint8_t source_count);
+
+/**
+ * @brief Enable or disable aligned frames.
+ *
+ * @param self The instance.
+ * @param enable True to retain samples and produce frames.
+ *
+ * Disabling frames frees the retained samples.  The time maps
+ * remain available to jsdrv_align_map().
+ */
+void jsdrv_align_frames_enable(struct jsdrv_align_s * self, bool enable);
+
+/**
+ * @brief Receive a stream message.
+ *
+ * @param self The instance.
+ * @param source_idx The source index.
+ * @param signal The stream message.
+ * @return 0, JSDRV_ERROR_PARAMETER_INVALID or JSDRV_ERROR_NOT_SUPPORTED
+ *      for non-f32 data with frames enabled.
+ *
+ * Calls frame_fn zero or more times for the frames completed by this
+ * message.  A frame completes when every source has samples beyond the
+ * frame end.  When a source stalls for more than half of
+ * JSDRV_ALIGN_RING_SIZE master samples, the frames proceed using NaN
+ * for the unavailable samples.
+ */
+int32_t jsdrv_align_recv(struct jsdrv_align_s * self, uint8_t source_idx, const struct jsdrv_stream_signal_s * signal);
+
+/**
+ * @brief Get the common timebase mapping.
+ *
+ * @param self The instance.
+ * @param map[out] The mapping.
+ * @return 0 or JSDRV_ERROR_UNAVAILABLE until every source receives data.
+ */
+int32_t jsdrv_align_map(struct jsdrv_align_s * self, struct jsdrv_align_map_s * map);
+
+/// The opaque alignment service instance.
+struct jsdrv_align_svc_s;
+
+/**
+ * @brief Initialize the alignment service.
+ *
+ * @param context The driver context.
+ * @param[out] instance The new alignment service instance.
+ * @return 0 or error code.
+ */
+int32_t jsdrv_align_initialize(struct jsdrv_context_s * context, struct jsdrv_align_svc_s ** instance);
+
+/**
+ * @brief Finalize the alignment service.
+ *
+ * @param instance The instance from jsdrv_align_initialize() or NULL.
+ */
+void jsdrv_align_finalize(struct jsdrv_align_svc_s * instance);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_ALIGN_H_ */
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Size-class heap allocator.
+ */
+
+#ifndef JSDRV_PRV_ALLOC_H_
+#define JSDRV_PRV_ALLOC_H_
+
+#include "jsdrv/cmacro_inc.h"
+#include "jsdrv_prv/platform.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_alloc Heap allocator
+ *
+ * @brief Implement jsdrv_alloc() and jsdrv_free() over jsdrv_allocator_s.
+ *
+ * Requests up to JSDRV_ALLOC_SMALL_MAX bytes round up to a power of 2
+ * size class.  Freed small blocks return to a global free list for
+ * their class, up to JSDRV_ALLOC_GLOBAL_MAX blocks, and are reused
+ * without calling the allocator.  Threads that call
+ * jsdrv_alloc_thread_cache_start() also keep up to
+ * JSDRV_ALLOC_CACHE_MAX blocks per class without any lock, and move
+ * blocks to and from the global lists in batches.  Larger requests
+ * go directly to the allocator.
+ *
+ * Each allocation has a jsdrv_alloc_cat_e category that accounts its
+ * live bytes and count, which the frontend publishes under
+ * JSDRV_MSG_ALLOC.  jsdrv_alloc() uses JSDRV_ALLOC_CAT_OTHER.  With
+ * tracing enabled, new allocations bypass the size classes and record
+ * their call stack until freed.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The number of size classes, from 64 to 4096 bytes.
+#define JSDRV_ALLOC_CLASS_COUNT (7U)
+
+/// The largest request served from the size classes.
+#define JSDRV_ALLOC_SMALL_MAX (4096U - 16U)
+
+/// The maximum blocks per class in a thread cache.
+#define JSDRV_ALLOC_CACHE_MAX (32U)
+
+/// The maximum blocks per class in the global free lists.
+#define JSDRV_ALLOC_GLOBAL_MAX (1024U)
+
+/// The allocator statistics.
+struct jsdrv_alloc_stats_s {
+    int32_t outstanding;    ///< The blocks currently held from the allocator.
+    uint32_t free_count;    ///< The blocks in the global free lists.
+};
+
+/// The call stack frames recorded for each traced allocation.
+#define JSDRV_ALLOC_TRACE_DEPTH (12U)
+
+/// The allocation categories.
+enum jsdrv_alloc_cat_e {
+    JSDRV_ALLOC_CAT_OTHER,      ///< Uncategorized allocations.
+    JSDRV_ALLOC_CAT_MSG,        ///< Messages, message pools and their heap payloads.
+    JSDRV_ALLOC_CAT_PUBSUB,     ///< Pubsub topics, metadata, retained values and subscribers.
+    JSDRV_ALLOC_CAT_BUFFER,     ///< Memory buffer rings, summary pyramids and requests.
+    JSDRV_ALLOC_CAT_LOG,        ///< Log messages and rings.
+    JSDRV_ALLOC_CAT_XFER,       ///< USB transfer buffers and queues.
+    JSDRV_ALLOC_CAT_COUNT,      ///< The number of categories.
+};
+
+/// The live totals for one allocation category.
+struct jsdrv_alloc_cat_stats_s {
+    uint64_t bytes;     ///< The bytes in use, including headers and size class rounding.
+    uint64_t count;     ///< The allocations in use.
+    uint64_t peak;      ///< The bytes high-water mark.
+};
+
+/**
+ * @brief Allocate memory from the heap for a category.
+ *
+ * @param size_bytes The number of bytes to allocate.
+ * @param cat The jsdrv_alloc_cat_e category.
+ * @return The pointer to the allocated memory.  Free with jsdrv_free().
+ */
+JSDRV_COMPILER_ALLOC(jsdrv_free) void * jsdrv_alloc_cat(size_t size_bytes, uint8_t cat);
+
+/**
+ * @brief Allocate memory from the heap for a category and clear to 0.
+ *
+ * @param size_bytes The number of bytes to allocate.
+ * @param cat The jsdrv_alloc_cat_e category.
+ * @return The pointer to the allocated memory.  Free with jsdrv_free().
+ */
+JSDRV_COMPILER_ALLOC(jsdrv_free) JSDRV_INLINE_FN void * jsdrv_alloc_clr_cat(size_t size_bytes, uint8_t cat) {
+    void * ptr = jsdrv_alloc_cat(size_bytes, cat);
+    jsdrv_memset(ptr, 0, size_bytes);
+    return ptr;
+}
+
+/**
+ * @brief Get the category name.
+ *
+ * @param cat The jsdrv_alloc_cat_e category.
+ * @return The topic subtopic name, or NULL if cat is invalid.
+ */
+const char * jsdrv_alloc_cat_name(uint32_t cat);
+
+/**
+ * @brief Get the live totals for a category.
+ *
+ * @param cat The jsdrv_alloc_cat_e category.
+ * @param[out] stats The totals, all 0 if cat is invalid.
+ */
+void jsdrv_alloc_cat_stats_get(uint32_t cat, struct jsdrv_alloc_cat_stats_s * stats);
+
+/**
+ * @brief Enable or disable allocation tracing.
+ *
+ * @param enable True to record the call stack of new allocations.
+ *      Allocations already traced remain traced until freed.
+ *
+ * Traced allocations take a lock and capture a stack, so only enable
+ * tracing for leak and growth analysis.
+ */
+void jsdrv_alloc_trace_enable(bool enable);
+
+/// Check if allocation tracing is enabled.
+bool jsdrv_alloc_trace_is_enabled(void);
+
+/**
+ * @brief Write the outstanding traced allocations.
+ *
+ * @param path The JSON output file path.
+ * @return 0 or error code.
+ *
+ * The file contains "count" and the "allocations" array, newest first.
+ * Each allocation has its "category", requested "size" and call stack
+ * "frames", as symbols where the platform provides them and addresses
+ * otherwise.
+ */
+int32_t jsdrv_alloc_trace_write(const char * path);
+
+/**
+ * @brief Enable the lock-free cache for the calling thread.
+ *
+ * jsdrv_thread_register() calls this function for all driver threads.
+ */
+void jsdrv_alloc_thread_cache_start(void);
+
+/**
+ * @brief Return the calling thread's cached blocks and disable its cache.
+ *
+ * jsdrv_thread_unregister() calls this function for all driver threads.
+ */
+void jsdrv_alloc_thread_cache_stop(void);
+
+/**
+ * @brief Get the allocator statistics.
+ *
+ * @param[out] stats The statistics.
+ */
+void jsdrv_alloc_stats_get(struct jsdrv_alloc_stats_s * stats);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_ALLOC_H_ */
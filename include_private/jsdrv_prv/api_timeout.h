@@ -0,0 +1,109 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Pending API timeouts indexed by deadline and topic.
+ */
+
+#ifndef JSDRV_PRV_API_TIMEOUT_H_
+#define JSDRV_PRV_API_TIMEOUT_H_
+
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/list.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_api_timeout API timeouts
+ *
+ * @brief Track the pending blocking API calls in the frontend thread.
+ *
+ * A min-heap orders the pending calls by deadline, and a hash table
+ * on the return code topic resolves completions.  Add, complete and
+ * expire are O(log n), independent of the number of pending calls.
+ * Calls that share a topic complete in the order they were added.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The number of topic hash buckets, a power of 2.
+#define JSDRV_API_TIMEOUT_BUCKETS (64U)
+
+/// The pending API timeouts.
+struct jsdrv_api_timeouts_s {
+    struct jsdrvp_api_timeout_s ** heap;    ///< The min-heap by deadline.
+    uint32_t count;                         ///< The number of pending timeouts.
+    uint32_t capacity;                      ///< The heap capacity.
+    struct jsdrv_list_s buckets[JSDRV_API_TIMEOUT_BUCKETS];  ///< By topic hash.
+};
+
+/**
+ * @brief Initialize the instance.
+ *
+ * @param self The instance.
+ */
+void jsdrv_api_timeouts_initialize(struct jsdrv_api_timeouts_s * self);
+
+/**
+ * @brief Free the instance storage.
+ *
+ * @param self The instance, which must be empty.
+ */
+void jsdrv_api_timeouts_finalize(struct jsdrv_api_timeouts_s * self);
+
+/**
+ * @brief Add a pending timeout.
+ *
+ * @param self The instance.
+ * @param timeout The timeout with topic and timeout populated.
+ */
+void jsdrv_api_timeouts_add(struct jsdrv_api_timeouts_s * self, struct jsdrvp_api_timeout_s * timeout);
+
+/**
+ * @brief Get the pending timeout with the earliest deadline.
+ *
+ * @param self The instance.
+ * @return The timeout or NULL if empty.
+ */
+struct jsdrvp_api_timeout_s * jsdrv_api_timeouts_peek(struct jsdrv_api_timeouts_s * self);
+
+/**
+ * @brief Find the oldest pending timeout for a return code topic.
+ *
+ * @param self The instance.
+ * @param topic The return code topic.
+ * @return The timeout or NULL if not found.
+ */
+struct jsdrvp_api_timeout_s * jsdrv_api_timeouts_find(struct jsdrv_api_timeouts_s * self, const char * topic);
+
+/**
+ * @brief Remove a pending timeout.
+ *
+ * @param self The instance.
+ * @param timeout The pending timeout.
+ */
+void jsdrv_api_timeouts_remove(struct jsdrv_api_timeouts_s * self, struct jsdrvp_api_timeout_s * timeout);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_API_TIMEOUT_H_ */
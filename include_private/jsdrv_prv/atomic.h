@@ -0,0 +1,121 @@
+/*
+ * Copyright 2023 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Atomic integer operations.
+ */
+
+#ifndef JSDRV_PRV_ATOMIC_H__
+#define JSDRV_PRV_ATOMIC_H__
+
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+#if _WIN32
+#include <windows.h>
+#endif
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_atomic Atomic operations
+ *
+ * @brief Provide a minimal, portable set of atomic integer operations.
+ *
+ * All operations are sequentially consistent.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/**
+ * @brief Atomically load a value.
+ *
+ * @param ptr The pointer to the value.
+ * @return The current value.
+ */
+JSDRV_INLINE_FN int32_t jsdrv_atomic_load(volatile int32_t * ptr) {
+#if _WIN32
+    return InterlockedCompareExchange((volatile LONG *) ptr, 0, 0);
+#else
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/**
+ * @brief Atomically store a value.
+ *
+ * @param ptr The pointer to the value.
+ * @param value The new value.
+ */
+JSDRV_INLINE_FN void jsdrv_atomic_store(volatile int32_t * ptr, int32_t value) {
+#if _WIN32
+    InterlockedExchange((volatile LONG *) ptr, value);
+#else
+    __atomic_store_n(ptr, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/**
+ * @brief Atomically add to a value.
+ *
+ * @param ptr The pointer to the value.
+ * @param value The value to add, which may be negative.
+ * @return The new value after the addition.
+ */
+JSDRV_INLINE_FN int32_t jsdrv_atomic_add(volatile int32_t * ptr, int32_t value) {
+#if _WIN32
+    return InterlockedExchangeAdd((volatile LONG *) ptr, value) + value;
+#else
+    return __atomic_add_fetch(ptr, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/**
+ * @brief Atomically exchange a value.
+ *
+ * @param ptr The pointer to the value.
+ * @param value The new value.
+ * @return The previous value.
+ */
+JSDRV_INLINE_FN int32_t jsdrv_atomic_exchange(volatile int32_t * ptr, int32_t value) {
+#if _WIN32
+    return InterlockedExchange((volatile LONG *) ptr, value);
+#else
+    return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/**
+ * @brief Order all memory accesses before the fence before all after.
+ *
+ * Use with plain data protected by a sequence counter.
+ */
+JSDRV_INLINE_FN void jsdrv_atomic_fence(void) {
+#if _WIN32
+    MemoryBarrier();
+#else
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_ATOMIC_H__ */
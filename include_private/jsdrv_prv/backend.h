@@ -24,6 +24,7 @@
 #define JSDRV_PRV_BACKEND_H_
 
 #include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
 
 
 #define JSDRV_USBBK_MSG_CTRL_IN                 "!ctrl_in"
@@ -33,6 +34,14 @@
 #define JSDRV_USBBK_MSG_BULK_IN_STREAM_CLOSE    "bulk/in/s/!close"
 #define JSDRV_USBBK_MSG_BULK_OUT_DATA           "bulk/out/!data"
 
+#define JSDRV_USBBK_BULK_IN_FRAME_LENGTH        (512U)
+#define JSDRV_USBBK_BULK_IN_DEPTH_DEFAULT       (4U)
+#define JSDRV_USBBK_BULK_IN_DEPTH_MAX           (64U)
+#define JSDRV_USBBK_BULK_IN_SPARE_DEFAULT       (4U)
+#define JSDRV_USBBK_BULK_IN_SPARE_MAX           (64U)
+#define JSDRV_USBBK_BULK_IN_SIZE_DEFAULT        (64U * JSDRV_USBBK_BULK_IN_FRAME_LENGTH)
+#define JSDRV_USBBK_BULK_IN_SIZE_MAX            (2048U * JSDRV_USBBK_BULK_IN_FRAME_LENGTH)
+
 JSDRV_CPP_GUARD_START
 
 enum jsdrvbk_status_e {
@@ -57,6 +66,58 @@ int32_t jsdrv_unittest_backend_factory(struct jsdrv_context_s * context, struct
 
 int32_t jsdrv_emulation_backend_factory(struct jsdrv_context_s * context, struct jsdrvbk_s ** backend);
 
+int32_t jsdrv_usb_replay_backend_factory(struct jsdrv_context_s * context, struct jsdrvbk_s ** backend);
+
+/**
+ * @brief Get the bulk in transfer depth to use.
+ *
+ * @param depth The requested number of outstanding transfers, 0 for default.
+ * @return The depth, limited to the supported range.
+ */
+JSDRV_INLINE_FN uint32_t jsdrv_usbbk_bulk_in_depth(uint32_t depth) {
+    if (0 == depth) {
+        return JSDRV_USBBK_BULK_IN_DEPTH_DEFAULT;
+    } else if (depth > JSDRV_USBBK_BULK_IN_DEPTH_MAX) {
+        return JSDRV_USBBK_BULK_IN_DEPTH_MAX;
+    }
+    return depth;
+}
+
+/**
+ * @brief Get the bulk in spare transfer count to use.
+ *
+ * @param spare The requested number of preallocated transfers beyond
+ *      the depth, 0 for default.
+ * @return The spare count, limited to the supported range.
+ *
+ * Spare transfers replace completed transfers while the upper layer
+ * holds their data, so reads never wait for an allocation.
+ */
+JSDRV_INLINE_FN uint32_t jsdrv_usbbk_bulk_in_spare(uint32_t spare) {
+    if (0 == spare) {
+        return JSDRV_USBBK_BULK_IN_SPARE_DEFAULT;
+    } else if (spare > JSDRV_USBBK_BULK_IN_SPARE_MAX) {
+        return JSDRV_USBBK_BULK_IN_SPARE_MAX;
+    }
+    return spare;
+}
+
+/**
+ * @brief Get the bulk in transfer size to use.
+ *
+ * @param size The requested transfer size in bytes, 0 for default.
+ * @return The size, rounded up to a whole number of frames and
+ *      limited to the supported range.
+ */
+JSDRV_INLINE_FN uint32_t jsdrv_usbbk_bulk_in_size(uint32_t size) {
+    if (0 == size) {
+        return JSDRV_USBBK_BULK_IN_SIZE_DEFAULT;
+    } else if (size > JSDRV_USBBK_BULK_IN_SIZE_MAX) {
+        return JSDRV_USBBK_BULK_IN_SIZE_MAX;
+    }
+    return ((size + JSDRV_USBBK_BULK_IN_FRAME_LENGTH - 1) / JSDRV_USBBK_BULK_IN_FRAME_LENGTH) * JSDRV_USBBK_BULK_IN_FRAME_LENGTH;
+}
+
 JSDRV_CPP_GUARD_END
 
 #endif  /* JSDRV_PRV_BACKEND_H_ */
@@ -28,6 +28,13 @@
 
 // Forward declarations from "jsdrv.h"
 struct jsdrv_context_s;
+struct jsdrv_buffer_request_s;
+struct jsdrv_buffer_response_s;
+
+/// 0 builds the driver without the memory buffer, see the JSDRV_BUFFER CMake option.
+#ifndef JSDRV_BUFFER_ENABLE
+#define JSDRV_BUFFER_ENABLE                          1
+#endif
 
 #ifndef JSDRV_BUFFER_COUNT_MAX
 #define JSDRV_BUFFER_COUNT_MAX                       16
@@ -37,6 +44,27 @@ struct jsdrv_context_s;
 #define JSDRV_BUFSIG_COUNT_MAX                       255
 #endif
 
+#ifndef JSDRV_BUFFER_WORKERS_MAX
+#define JSDRV_BUFFER_WORKERS_MAX                     8
+#endif
+
+#ifndef JSDRV_BUFFER_CODEC_SPAN
+#define JSDRV_BUFFER_CODEC_SPAN                      4   // compressed history multiple
+#endif
+
+#define JSDRV_BUFFER_R0_MIN                          4
+#define JSDRV_BUFFER_R0_MAX                          4096  // JSDRV_BUFSIG_BLOCK_SAMPLES for the codec
+#define JSDRV_BUFFER_RN_MIN                          4
+#define JSDRV_BUFFER_RN_MAX                          256
+
+#ifndef JSDRV_BUFFER_TILE_CACHE_MAX
+#define JSDRV_BUFFER_TILE_CACHE_MAX                  1024  // summary tiles per signal
+#endif
+
+#ifndef JSDRV_BUFFER_STORAGE_PATH_MAX
+#define JSDRV_BUFFER_STORAGE_PATH_MAX                256
+#endif
+
 // topics for the buffer manager: add/remove buffers
 #define JSDRV_BUFFER_MGR_MSG_ACTION_ADD               "m/@/!add"      // u8: 1 <= id <= JSDRV_BUFFER_COUNT_MAX
 #define JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE            "m/@/!remove"   // u8 id
@@ -46,27 +74,81 @@ struct jsdrv_context_s;
 #define JSDRV_BUFFER_MSG_ACTION_SIGNAL_ADD            "a/!add"          // u8 id, 1 <= id <= JSDRV_BUFSIG_COUNT_MAX
 #define JSDRV_BUFFER_MSG_ACTION_SIGNAL_REMOVE         "a/!remove"       // u8 id
 #define JSDRV_BUFFER_MSG_ACTION_CLEAR                 "g/!clear"        // Clear the buffer
+#define JSDRV_BUFFER_MSG_ACTION_SAVE                  "g/!save"         // str: write the signals and their summaries to this file path
+#define JSDRV_BUFFER_MSG_ACTION_LOAD                  "g/!load"         // str: replace the added signals from a g/!save file path
 #define JSDRV_BUFFER_MSG_LIST                         "g/list"          // bin ro: u8[N] ids
 #define JSDRV_BUFFER_MSG_SIZE                         "g/size"          // u64 size in bytes
 #define JSDRV_BUFFER_MSG_HOLD                         "g/hold"          // u8: 0=run (default), 1=hold, clear on 1->0
 #define JSDRV_BUFFER_MSG_MODE                         "g/mode"          // 0:continuous, 1:fill & hold
+#define JSDRV_BUFFER_MSG_INFO_RATE                    "g/info_hz"       // u32 max signal info rate in Hz, 0=every update, default 20
+#define JSDRV_BUFFER_MSG_WORKERS                      "g/workers"       // u32 ingest threads, 0=buffer thread (default)
+#define JSDRV_BUFFER_MSG_STORAGE_PATH                 "g/path"          // str: directory for file-backed sample storage, "" for RAM (default)
+#define JSDRV_BUFFER_MSG_MEM_FLAGS                    "g/mem"           // u32 jsdrv_os_mem_flags_e: 1=huge pages, 2=prefault, default 0
+#define JSDRV_BUFFER_MSG_CODEC                        "g/codec"         // u8: 1=losslessly compress samples, default 0
+#define JSDRV_BUFFER_MSG_INTEGRAL                     "g/intgrl"        // u8: 1=index float signals for constant-time integrals, default 0
+#define JSDRV_BUFFER_MSG_HISTOGRAM                    "g/hist"          // u8: 1=index float signals for fast quantiles, default 0
+#define JSDRV_BUFFER_MSG_TREND                        "g/trend"         // u32: retain trend summaries for this multiple of the level 0 duration, default 0
+#define JSDRV_BUFFER_MSG_TREND_LEVEL                  "g/trendlv"       // u32: the trend summary level, default 2
+#define JSDRV_BUFFER_MSG_TILE_CACHE                   "g/tiles"         // u32: cached summary tiles per signal, default 0
+#define JSDRV_BUFFER_MSG_R0                           "g/r0"            // u32: samples per level 1 entry, power of 2, 0=default (128 float, 1024 uint)
+#define JSDRV_BUFFER_MSG_RN                           "g/rN"            // u32: entries per upper level entry, power of 2, 0=default (32)
+#define JSDRV_BUFFER_MSG_NUMA_NODE                    "g/numa"          // i32 preferred NUMA node for samples, -1=default
+#define JSDRV_BUFFER_MSG_REBALANCE                    "g/rebal"         // u8: 1=shrink the signals to fit added signals within g/size, default 0
+#define JSDRV_BUFFER_MSG_REQ_LATEST                   "g/latest"        // u8: 1=process only the newest pending request per rsp_topic, default 0
+#define JSDRV_BUFFER_MSG_PREFETCH                     "g/prefch"        // u8: 1=speculatively compute g/tiles cache tiles near recent summary requests, default 0
+#define JSDRV_BUFFER_MSG_MULTI_REQ                    "g/!req"          // jsdrv_buffer_multi_request_s
+#define JSDRV_BUFFER_MSG_SNAP                         "g/!snap"         // take a snapshot after the g/post duration
+#define JSDRV_BUFFER_MSG_SNAP_POST                    "g/post"          // u32 post-trigger duration in milliseconds, default 0
+#define JSDRV_BUFFER_MSG_SNAP_STATE                   "g/snap"          // u8 ro: 0=none, 1=post-trigger capture, 2=ready
 #define JSDRV_BUFFER_MSG_SIGNAL_TOPIC                 "s/ZZZ/topic"     // str: source data topic
 #define JSDRV_BUFFER_MSG_SIGNAL_INFO                  "s/ZZZ/info"      // ro: jsdrv_buffer_info_s
+#define JSDRV_BUFFER_MSG_SIGNAL_SNAP_INFO             "s/ZZZ/snap"      // ro: jsdrv_buffer_info_s for the snapshot
 #define JSDRV_BUFFER_MSG_SIGNAL_SAMPLE_REQ            "s/ZZZ/!req"      // jsdrv_buffer_request_s
+#define JSDRV_BUFFER_MSG_SIGNAL_CANCEL                "s/ZZZ/!cancel"   // i64: cancel pending requests with this rsp_id
+#define JSDRV_BUFFER_MSG_SIGNAL_EXPORT                "s/ZZZ/!export"   // jsdrv_buffer_export_s
+#define JSDRV_BUFFER_MSG_SIGNAL_EXPORT_PROGRESS       "s/ZZZ/export"    // f32 ro: 0 to 1, NaN on failure
 
 JSDRV_CPP_GUARD_START
 
+/// The opaque memory buffer manager instance.
+struct jsdrv_buffer_mgr_s;
+
 /**
- * @brief Initialize the singleton memory buffer manager.
+ * @brief Initialize the memory buffer manager for a driver context.
  *
+ * @param context The driver context.
+ * @param[out] instance The new buffer manager instance.
  * @return 0 or error code.
  */
-int32_t jsdrv_buffer_initialize(struct jsdrv_context_s * context);
+int32_t jsdrv_buffer_initialize(struct jsdrv_context_s * context, struct jsdrv_buffer_mgr_s ** instance);
 
 /**
- * @brief Finalize the singleton buffer manager.
+ * @brief Finalize the buffer manager.
+ *
+ * @param instance The instance from jsdrv_buffer_initialize() or NULL.
+ */
+void jsdrv_buffer_finalize(struct jsdrv_buffer_mgr_s * instance);
+
+/**
+ * @brief Process a buffer request directly into caller memory.
+ *
+ * @param instance The buffer manager instance.
+ * @param buffer_id The buffer id, 1 to JSDRV_BUFFER_COUNT_MAX.
+ * @param signal_id The signal id, 1 to JSDRV_BUFSIG_COUNT_MAX - 1.
+ * @param req The request, which is normalized in place.  The
+ *      stream, standing and display flags are ignored.
+ * @param rsp The response.
+ * @param data_size The rsp->data capacity in bytes, excluding
+ *      JSDRV_BUFSIG_RSP_SLACK.
+ * @return 0 or error code.
+ *
+ * Like the reader thread, this function reads from a snapshot of the
+ * signal without blocking ingestion.  It may run on any thread, but
+ * the caller must not concurrently remove the buffer.
  */
-void jsdrv_buffer_finalize(void);
+int32_t jsdrv_buffer_mgr_read(struct jsdrv_buffer_mgr_s * instance, uint8_t buffer_id, uint8_t signal_id,
+                              struct jsdrv_buffer_request_s * req, struct jsdrv_buffer_response_s * rsp,
+                              uint64_t data_size);
 
 
 
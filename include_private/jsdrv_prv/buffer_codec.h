@@ -0,0 +1,102 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Lossless codecs for memory buffer sample blocks.
+ */
+
+#ifndef JSDRV_PRV_BUFFER_CODEC_H_
+#define JSDRV_PRV_BUFFER_CODEC_H_
+
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_buffer_codec Buffer codecs
+ *
+ * @brief Compress memory buffer level 0 sample blocks.
+ *
+ * Each encoder returns 0 when the encoded block does not fit in
+ * dst_size.  The caller then stores the block raw, which bounds
+ * the worst case to the raw size.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The block codec identifiers.
+enum jsdrv_codec_e {
+    JSDRV_CODEC_RAW = 0,        ///< Uncompressed.
+    JSDRV_CODEC_RLE8 = 1,       ///< Byte run-length, for packed u1 and u4 samples.
+    JSDRV_CODEC_XOR_F32 = 2,    ///< Gorilla-style XOR with the previous f32 sample.
+};
+
+/**
+ * @brief Encode bytes with run-length encoding.
+ *
+ * @param src The source bytes.
+ * @param src_size The number of source bytes.
+ * @param dst The destination buffer.
+ * @param dst_size The size of dst in bytes.
+ * @return The number of encoded bytes, or 0 if dst_size is too small.
+ */
+uint32_t jsdrv_codec_rle8_encode(const uint8_t * src, uint32_t src_size, uint8_t * dst, uint32_t dst_size);
+
+/**
+ * @brief Decode bytes from jsdrv_codec_rle8_encode().
+ *
+ * @param src The encoded bytes.
+ * @param src_size The number of encoded bytes.
+ * @param dst The destination buffer.
+ * @param dst_size The number of decoded bytes expected.
+ * @return 0 or JSDRV_ERROR_PARAMETER_INVALID for corrupt data.
+ */
+int32_t jsdrv_codec_rle8_decode(const uint8_t * src, uint32_t src_size, uint8_t * dst, uint32_t dst_size);
+
+/**
+ * @brief Encode f32 samples with XOR delta encoding.
+ *
+ * @param src The source samples.
+ * @param count The number of source samples.
+ * @param dst The destination buffer.
+ * @param dst_size The size of dst in bytes.
+ * @return The number of encoded bytes, or 0 if dst_size is too small.
+ *
+ * The encoding operates on the bit patterns, so NaN and all other
+ * values round trip exactly.
+ */
+uint32_t jsdrv_codec_xor_f32_encode(const float * src, uint32_t count, uint8_t * dst, uint32_t dst_size);
+
+/**
+ * @brief Decode samples from jsdrv_codec_xor_f32_encode().
+ *
+ * @param src The encoded bytes.
+ * @param src_size The number of encoded bytes.
+ * @param dst The destination samples.
+ * @param count The number of samples expected.
+ * @return 0 or JSDRV_ERROR_PARAMETER_INVALID for corrupt data.
+ */
+int32_t jsdrv_codec_xor_f32_decode(const uint8_t * src, uint32_t src_size, float * dst, uint32_t count);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_BUFFER_CODEC_H_ */
@@ -25,12 +25,22 @@
 
 #include "jsdrv/cmacro_inc.h"
 #include "jsdrv.h"
+#include "jsdrv_prv/js220_i128.h"
 #include "jsdrv_prv/list.h"
 #include "jsdrv_prv/msg_queue.h"
 #include <stdint.h>
+#include <stdio.h>
 
 
 #define JSDRV_BUFSIG_LEVELS_MAX 32
+#define JSDRV_BUFSIG_BLOCK_SAMPLES 4096   // compressed level 0 block size
+#define JSDRV_BUFSIG_RSP_SLACK (8 * sizeof(uint64_t))  // response data space for shift and overrun
+#define JSDRV_BUFSIG_TILE_ENTRIES 64      // summary entries per cached tile
+#define JSDRV_BUFSIG_GAP_MAX 32           // missing sample ranges per signal
+#define JSDRV_BUFSIG_GAP_FILL 1024        // samples in the level 0 read substitute for gaps
+#define JSDRV_BUFSIG_HIST_BINS 64         // log-spaced histogram bins per summary entry
+#define JSDRV_BUFSIG_INGEST_THREADS_MAX 16  // jsdrv_bufsig_ingest() summary threads
+#define JSDRV_BUFSIG_SUMMARY_BATCH 65536  // level 0 samples per level 1 summary batch
 
 
 struct buffer_s;
@@ -53,6 +63,45 @@ struct bufsig_level_s {
     struct jsdrv_summary_entry_s * data;
 };
 
+/// A compressed level 0 block.
+struct bufsig_block_s {
+    uint8_t * data;     ///< The encoded data, NULL when empty.
+    uint32_t size;      ///< The encoded size in bytes.
+    uint8_t codec;      ///< jsdrv_codec_e
+    uint64_t seq;       ///< The unique store sequence number, for the decode cache.
+};
+
+/// The running sample totals at the boundaries of a level 1 entry.
+struct bufsig_integral_s {
+    js220_i128 start;       ///< The sum before this entry with 2**-31 scale.
+    js220_i128 end;         ///< The sum through this entry with 2**-31 scale.
+    uint64_t count_start;   ///< The valid sample count before this entry.
+    uint64_t count_end;     ///< The valid sample count through this entry.
+};
+
+/// A cached run of summary entries starting at sample_id with incr samples per entry.
+struct bufsig_tile_s {
+    uint64_t generation;    ///< The bufsig_s.generation when computed, 0 for empty.
+    uint64_t sample_id;     ///< The first sample id.
+    uint64_t incr;          ///< The samples per entry.
+    uint64_t used;          ///< The bufsig_s.tile_clock on last use, for LRU replacement.
+    bool envelope;          ///< The entries are from JSDRV_BUFFER_REQUEST_FLAG_ENVELOPE without std.
+    struct jsdrv_summary_entry_s entries[JSDRV_BUFSIG_TILE_ENTRIES];
+};
+
+/// A range of missing samples.
+struct bufsig_gap_s {
+    uint64_t start;         ///< The first missing sample id.
+    uint64_t end;           ///< The sample id after the last missing sample.
+};
+
+/// The level 0 sample storage allocator.
+enum bufsig_storage_e {
+    BUFSIG_STORAGE_HEAP,    ///< jsdrv_alloc()
+    BUFSIG_STORAGE_MEM,     ///< jsdrv_os_mem_alloc()
+    BUFSIG_STORAGE_FILE,    ///< jsdrv_os_file_map_alloc()
+};
+
 struct bufsig_s {
     uint32_t idx;
     bool active;
@@ -70,12 +119,61 @@ struct bufsig_s {
 
     // todo summary data.
     struct bufsig_level_s levels[JSDRV_BUFSIG_LEVELS_MAX];
+    uint64_t summary_dirty[JSDRV_BUFSIG_LEVELS_MAX];  // levels[i] omits the newest samples
 
     // level 0, length N
     uint64_t level0_head;     // next insert point (also tail when full)
     uint64_t level0_size;     // the number of valid entries
     uint64_t sample_id_head;  // the next expected sample id (last valid + 1)
     void * level0_data;       // the data
+    size_t level0_mapped_size;  // nonzero when level0_data is from the OS
+    uint8_t level0_storage;   // bufsig_storage_e
+    const char * storage_dir; // file-backed level 0 directory, NULL or "" for RAM
+    uint32_t mem_flags;       // jsdrv_os_mem_flags_e for RAM level 0
+    int32_t numa_node;        // preferred NUMA node for RAM level 0, -1 for default
+
+    // compressed level 0, level0_data is the raw open block at level0_head
+    uint8_t codec;                  // 1 requests compressed level 0 blocks
+    uint64_t level0_budget;         // max compressed level 0 bytes, 0 for N raw
+    struct bufsig_block_s * blocks; // N / JSDRV_BUFSIG_BLOCK_SAMPLES, NULL when raw
+    uint64_t block_count;
+    uint64_t block_tail;            // the oldest retained block index
+    uint64_t blocks_size;           // total encoded bytes
+    uint64_t block_seq;             // the last assigned bufsig_block_s.seq
+    uint8_t * block_scratch;        // encode buffer
+    uint8_t * block_cache;          // one decoded block
+    uint64_t block_cache_seq;       // the cached bufsig_block_s.seq, 0 for none
+    uint64_t generation;      // incremented when the data is reset or reallocated
+
+    // integral index, difference two entries for the sum over the level 1 entries between them
+    uint8_t integral;                           // 1 requests the integral index for float signals
+    struct bufsig_integral_s * integral_index;  // levels[0].k entries, NULL when disabled
+    js220_i128 integral_sum;                    // the running sum through the last level 1 entry
+    uint64_t integral_count;                    // the running valid sample count
+
+    // histogram index, JSDRV_BUFSIG_HIST_BINS sample counts for each summary entry
+    uint8_t histogram;                          // 1 requests the histogram index for float signals
+    uint16_t * hist_level1;                     // levels[0].k entries, NULL when disabled
+    uint32_t * hist_levels[JSDRV_BUFSIG_LEVELS_MAX];  // levels[i].k entries for i >= 1, NULL above 2**32 samples
+
+    // trend history, trend_level entries retained after level 0 overwrites their samples
+    uint8_t trend_level;                        // the summary level to retain, 0 to disable
+    uint64_t trend_k;                           // the trend ring entries, 0 to disable
+    struct jsdrv_summary_entry_s * trend;       // trend_k entries, NULL when disabled
+    uint64_t trend_spe;                         // samples per trend entry
+    uint64_t trend_head;                        // the next insert point
+    uint64_t trend_size;                        // the number of valid entries
+    uint64_t trend_sample_id;                   // the sample id after the newest entry
+
+    // summary tile cache, a tile is valid while its range stays within the ring
+    uint32_t tile_count;            // the number of cached tiles, 0 to disable
+    struct bufsig_tile_s * tiles;   // tile_count entries, NULL when disabled
+    uint64_t tile_clock;            // the last assigned bufsig_tile_s.used
+
+    // missing samples, level 0 reads within a gap return gap_fill rather than the stored data
+    struct bufsig_gap_s gaps[JSDRV_BUFSIG_GAP_MAX];  // sorted, oldest first
+    uint32_t gap_count;
+    void * gap_fill;                // JSDRV_BUFSIG_GAP_FILL samples of NaN or 0, allocated on the first gap
 };
 
 /**
@@ -85,6 +183,55 @@ struct bufsig_s {
  * @param N The total number of samples to store.
  * @param r0 The number of samples in the first reduction.
  * @param rN The number of samples in subsequent reductions.
+ *
+ * When storage_dir is set, level 0 sample data is mapped from a
+ * temporary file in that directory so that the buffer may exceed
+ * physical RAM.  The summary levels always remain in RAM.  If the
+ * mapping fails, level 0 falls back to RAM.  Otherwise, when mem_flags
+ * or numa_node are set, level 0 allocates with jsdrv_os_mem_alloc()
+ * for huge pages, NUMA placement and prefaulting.
+ *
+ * When codec is set, N is a multiple of JSDRV_BUFSIG_BLOCK_SAMPLES
+ * and r0 divides JSDRV_BUFSIG_BLOCK_SAMPLES, level 0 stores losslessly
+ * compressed blocks from the heap instead.  The oldest blocks are
+ * evicted to keep the encoded size within level0_budget, so the
+ * available history varies between level0_budget raw bytes and N
+ * samples depending upon the data.
+ *
+ * When integral is set for a float signal, each level 1 entry also
+ * stores the running fixed-point sample sum at its boundaries.
+ * JSDRV_BUFFER_REQUEST_FLAG_INTEGRAL then differences two entries and
+ * only sums the partial entries at each end from level 0.
+ *
+ * When histogram is set for a float signal, each summary entry also
+ * stores its sample counts in JSDRV_BUFSIG_HIST_BINS log-spaced bins.
+ * JSDRV_BUFFER_REQUEST_OP_QUANTILE then merges the entries that fit
+ * within the range and only bins the partial entries at each end
+ * from level 0.
+ *
+ * When trend_level and trend_k are set, the completed entries of that
+ * summary level are also appended to a separate ring of trend_k
+ * entries.  The trend ring continues after level 0 overwrites their
+ * samples, so summary requests for the older ranges still return
+ * entries at the trend resolution.  The trend persists across
+ * discontinuities, which fill the missing entries with NaN.
+ *
+ * When tile_count is set, summary requests compute their entries in
+ * tiles of JSDRV_BUFSIG_TILE_ENTRIES aligned to the increment and
+ * cache up to tile_count tiles with LRU replacement.  Repeated and
+ * panned requests at the same increment then only compute the tiles
+ * at the edges.  Tiles that extend past the newest sample are never
+ * cached, and cached tiles expire once new data overwrites the start
+ * of their range.
+ *
+ * Ingestion summarizes level 1 in batches of JSDRV_BUFSIG_SUMMARY_BATCH
+ * samples across messages, except that compressed level 0 and multiple
+ * ingest threads summarize each write.  The summary levels record the newest
+ * samples that they do not yet include in summary_dirty, and complete
+ * in bulk with jsdrv_bufsig_summary_update(), which requests call for
+ * the levels that they read.  Ingestion also completes them before the
+ * pending samples reach N / 4, so the lower level entries they combine
+ * are never overwritten.
  */
 void jsdrv_bufsig_alloc(struct bufsig_s * self, uint64_t N, uint64_t r0, uint64_t rN);
 
@@ -92,8 +239,174 @@ void jsdrv_bufsig_free(struct bufsig_s * self);
 
 void jsdrv_bufsig_clear(struct bufsig_s * self);
 
+/**
+ * @brief Complete the lazy summary levels.
+ *
+ * @param self The buffer instance.
+ * @param level The highest summary level to complete,
+ *      JSDRV_BUFSIG_LEVELS_MAX for all.
+ *
+ * The caller excludes ingestion.  Complete all levels before taking a
+ * snapshot, since reads from the snapshot would otherwise complete them
+ * in the shared storage.
+ */
+void jsdrv_bufsig_summary_update(struct bufsig_s * self, uint8_t level);
+
+/**
+ * @brief Check for lazy summary levels.
+ *
+ * @param self The buffer instance.
+ * @return True when any summary level omits samples.
+ */
+bool jsdrv_bufsig_summary_pending(struct bufsig_s * self);
+
+/**
+ * @brief Compute one uncached summary tile for a range.
+ *
+ * @param self The buffer instance.
+ * @param sample_id The first sample id, which sets the tile phase.
+ * @param incr The samples per summary entry.
+ * @param entries_length The number of summary entries.
+ * @param envelope True for JSDRV_BUFFER_REQUEST_FLAG_ENVELOPE tiles.
+ * @return True when a tile was computed.  False when tile_count is 0
+ *      or the cache already holds every complete tile in the range.
+ *
+ * This speculatively fills the tiles that a later summary request
+ * for the same range and increment would use.  Each call computes at
+ * most one tile, so the caller can yield to other work between calls.
+ */
+bool jsdrv_bufsig_tile_prefetch(struct bufsig_s * self, uint64_t sample_id, uint64_t incr, uint64_t entries_length,
+                                bool envelope);
+
+/**
+ * @brief Freeze the signal data and continue with the spare storage.
+ *
+ * @param self The live signal.
+ * @param frozen The frozen signal, which receives the live data.
+ *
+ * This ping-pong swaps the storage without copying samples.  The
+ * live signal continues at the next sample_id with the previous
+ * frozen storage, which is reused when it has the same dimensions
+ * and reallocated otherwise.  frozen keeps the data until the next
+ * call or jsdrv_bufsig_free().  The caller excludes readers of both.
+ */
+void jsdrv_bufsig_freeze(struct bufsig_s * self, struct bufsig_s * frozen);
+
+/**
+ * @brief Replace the storage of a live signal.
+ *
+ * @param self The live signal.
+ * @param other The signal allocated with jsdrv_bufsig_alloc(), which
+ *      receives the previous storage for jsdrv_bufsig_free().
+ *
+ * The live signal keeps its index, active state, topic, parent and
+ * storage directory.  The caller excludes readers and ingestion.
+ */
+void jsdrv_bufsig_replace(struct bufsig_s * self, struct bufsig_s * other);
+
+/**
+ * @brief Append the samples from another signal.
+ *
+ * @param self The signal allocated with jsdrv_bufsig_alloc().
+ * @param src The source signal with the same sample format.
+ * @param sample_id_end The sample id after the last sample to copy.
+ * @return true on success.  false if src no longer holds the
+ *      samples following those in self.
+ *
+ * When self is empty, the copy starts with the newest samples that
+ * fit in self.  Otherwise, the copy continues at self's
+ * sample_id_head, so that a copy from a snapshot can catch up with
+ * the live signal.  The summaries are recomputed for self.  When
+ * self is empty and both signals retain the same trend level, self
+ * also receives the src trend entries before the copied samples.
+ */
+bool jsdrv_bufsig_copy(struct bufsig_s * self, struct bufsig_s * src, uint64_t sample_id_end);
+
+/// The jsdrv_bufsig_save() format version.
+#define JSDRV_BUFSIG_FILE_VERSION (1)
+
+/**
+ * @brief Write the signal storage to a file.
+ *
+ * @param self The signal.
+ * @param f The file opened for binary writes.
+ * @return 0, JSDRV_ERROR_NOT_SUPPORTED for compressed level 0 or
+ *      unallocated signals, or JSDRV_ERROR_IO.
+ *
+ * The record holds the ring state, gaps and time map, followed by
+ * level 0, each summary level and the optional integral, histogram
+ * and trend arrays.  Each array is one large write in native byte
+ * order, so the save runs at disk bandwidth.  The caller excludes
+ * ingestion.
+ */
+int32_t jsdrv_bufsig_save(struct bufsig_s * self, FILE * f);
+
+/**
+ * @brief Read a signal written by jsdrv_bufsig_save().
+ *
+ * @param self The unallocated signal.  Its storage_dir, mem_flags and
+ *      numa_node select the level 0 storage.
+ * @param f The file opened for binary reads.
+ * @param[out] idx The saved signal index.
+ * @return 0, JSDRV_ERROR_PARAMETER_INVALID for an unsupported record,
+ *      or JSDRV_ERROR_IO.
+ *
+ * The summary levels are read rather than recomputed.  On error,
+ * the caller frees self with jsdrv_bufsig_free().
+ */
+int32_t jsdrv_bufsig_load(struct bufsig_s * self, FILE * f, uint32_t * idx);
+
+/**
+ * @brief Receive a sample stream message.
+ *
+ * @param self The signal.
+ * @param s The JSDRV_PAYLOAD_TYPE_STREAM message.
+ *
+ * Skipped samples up to the buffer size are recorded as a gap.
+ * Raw level 0 storage does not write the whole level 1 entries
+ * within the gap, and their summaries are missing without computation.
+ * Sample requests return NaN for float and 0 for unsigned samples in
+ * gaps, and JSDRV_BUFFER_REQUEST_FLAG_GAPS returns the ranges.
+ */
 void jsdrv_bufsig_recv_data(struct bufsig_s * self, struct jsdrv_stream_signal_s * s);
 
+/**
+ * @brief Add recorded samples to a signal.
+ *
+ * @param self The allocated signal, with hdr describing the samples.
+ * @param sample_id The first sample id, divided by the decimate factor.
+ * @param data The samples in the hdr element format.
+ * @param length The number of samples.
+ * @param thread_count The threads that compute the level 1 summaries,
+ *      up to JSDRV_BUFSIG_INGEST_THREADS_MAX.  0 and 1 use the
+ *      caller's thread.
+ * @return 0, JSDRV_ERROR_UNAVAILABLE when self is not allocated, or
+ *      JSDRV_ERROR_PARAMETER_INVALID for samples before the head.
+ *
+ * Feed large arrays, such as a recorded capture, without stream
+ * messages.  Gaps and summaries match jsdrv_bufsig_recv_data() for
+ * the same samples.  Each ring segment splits its level 1 entries
+ * across the threads, then computes the higher levels, the integral
+ * prefix and the trend in order.  Compressed level 0 summarizes on
+ * the caller's thread.  When length exceeds N, only the newest
+ * samples are written.  The caller sets the time map afterwards and
+ * excludes requests during ingest.
+ */
+int32_t jsdrv_bufsig_ingest(struct bufsig_s * self, uint64_t sample_id, const void * data, uint64_t length,
+                            uint32_t thread_count);
+
+/**
+ * @brief Receive an event-encoded stream message.
+ *
+ * @param self The signal.
+ * @param s The JSDRV_PAYLOAD_TYPE_STREAM_EVENT message.
+ * @param event_count The number of jsdrv_stream_event_s entries in s->data.
+ *
+ * Expands the value runs into the level 0 samples, so that requests
+ * and summaries are identical to jsdrv_bufsig_recv_data().
+ */
+void jsdrv_bufsig_recv_events(struct bufsig_s * self, struct jsdrv_stream_signal_s * s, uint32_t event_count);
+
 bool jsdrv_bufsig_info(struct bufsig_s * self, struct jsdrv_buffer_info_s * info);
 
 /**
@@ -112,6 +425,130 @@ int32_t jsdrv_bufsig_process_request(
         struct jsdrv_buffer_request_s * req,
         struct jsdrv_buffer_response_s * rsp);
 
+/**
+ * @brief Process a request into a response with a specific capacity.
+ *
+ * @param self The buffer instance.
+ * @param req The request to process.
+ * @param rsp The response, see jsdrv_bufsig_process_request().
+ * @param data_size The rsp->data capacity in bytes, excluding
+ *      JSDRV_BUFSIG_RSP_SLACK.  Sample responses are clipped to fit,
+ *      and summary responses that do not fit are empty.
+ * @return 0 or error code.
+ */
+int32_t jsdrv_bufsig_process_request_sz(
+        struct bufsig_s * self,
+        struct jsdrv_buffer_request_s * req,
+        struct jsdrv_buffer_response_s * rsp,
+        uint64_t data_size);
+
+/**
+ * @brief Prepare a request for a streamed response.
+ *
+ * @param self The buffer instance.
+ * @param req The request, which is normalized in place to
+ *      JSDRV_TIME_SAMPLES with start, end and length all set.
+ * @return The number of response chunks or 0 if the request is invalid.
+ */
+uint64_t jsdrv_bufsig_stream_plan(struct bufsig_s * self, struct jsdrv_buffer_request_s * req);
+
+/**
+ * @brief Get the request for one response chunk.
+ *
+ * @param self The buffer instance.
+ * @param req The request normalized by jsdrv_bufsig_stream_plan().
+ * @param seq The chunk index.
+ * @param chunk The request for chunk seq, which fits in one response.
+ */
+void jsdrv_bufsig_stream_chunk(struct bufsig_s * self, const struct jsdrv_buffer_request_s * req,
+                               uint64_t seq, struct jsdrv_buffer_request_s * chunk);
+
+/**
+ * @brief Prepare a standing summary request.
+ *
+ * @param self The buffer instance.
+ * @param req The summary request with start, end and length, which is
+ *      normalized in place to JSDRV_TIME_SAMPLES.  The entries repeat
+ *      past end with the same increment.  Display requests must fit
+ *      length entries in one response.
+ * @return The samples per entry or 0 if the request is invalid.
+ */
+uint64_t jsdrv_bufsig_standing_plan(struct bufsig_s * self, struct jsdrv_buffer_request_s * req);
+
+/**
+ * @brief Get the request for the newly completed standing entries.
+ *
+ * @param self The buffer instance.
+ * @param req The request normalized by jsdrv_bufsig_standing_plan().
+ * @param[inout] next The index of the next entry to send, relative to
+ *      req start.  Initialize to UINT64_MAX, which first sends the
+ *      newest req length entries.
+ * @param chunk The request for the entries, which fits in one response.
+ * @return true if chunk contains new entries, false if none.
+ *
+ * Entries that leave the buffer or fall more than req length behind
+ * the newest entry are skipped.  Call repeatedly until false.  The
+ * caller excludes ingestion.
+ */
+bool jsdrv_bufsig_standing_chunk(struct bufsig_s * self, const struct jsdrv_buffer_request_s * req,
+                                 uint64_t * next, struct jsdrv_buffer_request_s * chunk);
+
+/**
+ * @brief Get the request for the next display frame.
+ *
+ * @param self The buffer instance.
+ * @param req The JSDRV_BUFFER_REQUEST_FLAG_DISPLAY request normalized
+ *      by jsdrv_bufsig_standing_plan().
+ * @param[inout] next The index of the entry after the last frame,
+ *      relative to req start.  Initialize to UINT64_MAX.
+ * @param chunk The request for the newest req length entries.
+ * @return true if chunk contains a new frame, false if no entries
+ *      completed since the last frame.
+ *
+ * The caller excludes ingestion.
+ */
+bool jsdrv_bufsig_display_chunk(struct bufsig_s * self, const struct jsdrv_buffer_request_s * req,
+                                uint64_t * next, struct jsdrv_buffer_request_s * chunk);
+
+/**
+ * @brief Get the response size.
+ *
+ * @param rsp The response from jsdrv_bufsig_process_request().
+ * @return The size in bytes including the jsdrv_buffer_response_s header.
+ */
+uint32_t jsdrv_bufsig_response_size(const struct jsdrv_buffer_response_s * rsp);
+
+/**
+ * @brief Clip a request to the newest sample common to several signals.
+ *
+ * @param signals The signals, which may contain NULL entries.
+ * @param count The number of signals.
+ * @param req The request to clip in place.
+ *
+ * Summary requests keep their increment and return fewer entries.
+ * Empty signals are ignored.  The caller excludes ingestion
+ * for all signals.
+ */
+void jsdrv_bufsig_multi_clip(struct bufsig_s * const * signals, uint32_t count, struct jsdrv_buffer_request_s * req);
+
+/**
+ * @brief Check a request processed on a snapshot against the live signal.
+ *
+ * @param snapshot The copy of the signal used by jsdrv_bufsig_process_request().
+ * @param self The live signal instance, locked by the caller.
+ * @param rsp The response computed from snapshot.
+ * @return true if ingestion may have overwritten data that the request read,
+ *      so the response is invalid.  false if the response is valid.
+ *
+ * Ingestion only writes ahead of sample_id_head, which overwrites the oldest
+ * samples once the buffer is full.  A snapshot read remains valid as long
+ * as the oldest sample in the response is still in the live buffer.
+ */
+bool jsdrv_bufsig_snapshot_overwritten(
+        const struct bufsig_s * snapshot,
+        const struct bufsig_s * self,
+        const struct jsdrv_buffer_response_s * rsp);
+
 JSDRV_CPP_GUARD_END
 
 #endif  /* JSDRV_PRV_BUFFER_SIGNAL_H_ */
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Incremental calibration hash.
+ */
+
+#ifndef JSDRV_PRV_CALIBRATION_HASH_H_
+#define JSDRV_PRV_CALIBRATION_HASH_H_
+
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_calibration_hash Calibration hash
+ *
+ * @brief Compute jsdrv_calibration_hash() over a message in pieces.
+ *
+ * The hash only chains its u32[16] result between 32-byte blocks,
+ * so a caller may hash a large message, such as a firmware image
+ * streamed from a file, without holding the entire message.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The hash block size in bytes.
+#define JSDRV_CALIBRATION_HASH_BLOCK_SIZE (32U)
+
+/// The hash size in u32 words.
+#define JSDRV_CALIBRATION_HASH_U32_SIZE (16U)
+
+/**
+ * @brief Initialize the hash.
+ *
+ * @param hash[out] The u32[16] hash.
+ */
+void jsdrv_calibration_hash_init(uint32_t * hash);
+
+/**
+ * @brief Add the next message piece to the hash.
+ *
+ * @param hash[inout] The u32[16] hash from jsdrv_calibration_hash_init().
+ * @param offset The byte offset of msg within the full message, which
+ *      must be a multiple of JSDRV_CALIBRATION_HASH_BLOCK_SIZE.
+ * @param msg The message piece.
+ * @param length The length of msg in bytes, which must be a multiple of
+ *      JSDRV_CALIBRATION_HASH_BLOCK_SIZE.
+ *
+ * Pieces must be added in order.  The result matches
+ * jsdrv_calibration_hash() over the concatenated message.
+ */
+void jsdrv_calibration_hash_update(uint32_t * hash, uint32_t offset, const uint32_t * msg, uint32_t length);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_CALIBRATION_HASH_H_ */
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Stream continuity accounting.
+ */
+
+#ifndef JSDRV_PRV_CONTINUITY_H_
+#define JSDRV_PRV_CONTINUITY_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_continuity Stream continuity
+ *
+ * @brief Count skips, duplicates and resyncs for jsdrv_continuity_s.
+ *
+ * Drivers update the counters as they process each frame, and
+ * jsdrv_continuity_publish_ready() limits the publish rate.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The minimum time between publishes.
+#define JSDRV_CONTINUITY_PUBLISH_INTERVAL (JSDRV_TIME_SECOND)
+
+/// The continuity instance.
+struct jsdrv_continuity_tracker_s {
+    struct jsdrv_continuity_s value;
+    bool changed;               ///< Modified since the last publish.
+    int64_t publish_time;       ///< jsdrv_time_monotonic() of the last publish, 0 for never.
+};
+
+/**
+ * @brief Reset all counters and gaps.
+ *
+ * @param self The instance.
+ *
+ * The next jsdrv_continuity_publish_ready() returns true so that
+ * subscribers see the reset.
+ */
+void jsdrv_continuity_clear(struct jsdrv_continuity_tracker_s * self);
+
+/**
+ * @brief Record missing samples.
+ *
+ * @param self The instance.
+ * @param sample_id The first missing sample_id.
+ * @param length The number of missing sample_id values.
+ *
+ * Discards the oldest gap when JSDRV_CONTINUITY_GAP_COUNT gaps are already present.
+ */
+void jsdrv_continuity_skip(struct jsdrv_continuity_tracker_s * self, uint64_t sample_id, uint64_t length);
+
+/**
+ * @brief Record duplicate samples that the driver discarded.
+ *
+ * @param self The instance.
+ * @param length The number of duplicate sample_id values.
+ */
+void jsdrv_continuity_dup(struct jsdrv_continuity_tracker_s * self, uint64_t length);
+
+/**
+ * @brief Record a resynchronization after lost sync.
+ *
+ * @param self The instance.
+ */
+void jsdrv_continuity_resync(struct jsdrv_continuity_tracker_s * self);
+
+/**
+ * @brief Record a frame discarded without a known sample_id.
+ *
+ * @param self The instance.
+ */
+void jsdrv_continuity_drop(struct jsdrv_continuity_tracker_s * self);
+
+/**
+ * @brief Check if the value should be published now.
+ *
+ * @param self The instance.
+ * @param sample_id The next expected sample_id.
+ * @param now The current jsdrv_time_monotonic().
+ * @return True when the value changed and JSDRV_CONTINUITY_PUBLISH_INTERVAL
+ *      elapsed since the last publish.  The caller must then publish
+ *      self->value.  The function updates value.sample_id and the
+ *      publish state.
+ */
+bool jsdrv_continuity_publish_ready(struct jsdrv_continuity_tracker_s * self, uint64_t sample_id, int64_t now);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_CONTINUITY_H_ */
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Host CPU feature detection.
+ */
+
+#ifndef JSDRV_PRV_CPU_H__
+#define JSDRV_PRV_CPU_H__
+
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_cpu CPU features
+ *
+ * @brief Detect the SIMD instruction sets for runtime kernel dispatch.
+ *
+ * The SIMD kernels compile each variant with a function target
+ * attribute, so the library runs on any CPU of its architecture.
+ * jsdrv_initialize() selects the kernels once from
+ * jsdrv_cpu_features().  Set the JSDRV_CPU_ENV environment
+ * variable to limit the selection, such as "scalar" to
+ * benchmark the portable code.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The environment variable that limits the CPU features.
+#define JSDRV_CPU_ENV "JSDRV_SIMD"
+
+/// The CPU feature flags.
+enum jsdrv_cpu_feature_e {
+    JSDRV_CPU_SSE2 = (1U << 0),     ///< x86 SSE2.
+    JSDRV_CPU_SSE42 = (1U << 1),    ///< x86 SSE4.2.
+    JSDRV_CPU_AVX2 = (1U << 2),     ///< x86 AVX2 with operating system YMM support.
+    JSDRV_CPU_AVX512 = (1U << 3),   ///< x86 AVX-512F with operating system ZMM support.
+    JSDRV_CPU_NEON = (1U << 8),     ///< ARM NEON.
+};
+
+/**
+ * @brief Detect the host CPU features.
+ *
+ * @return The jsdrv_cpu_feature_e flags supported by the CPU.
+ */
+uint32_t jsdrv_cpu_detect(void);
+
+/**
+ * @brief Get the feature mask for a limit name.
+ *
+ * @param name The highest feature to allow: "scalar", "sse2",
+ *      "sse4.2", "avx2", "avx512" or "neon".  NULL or "" allows
+ *      all features.
+ * @param[out] mask The jsdrv_cpu_feature_e flags allowed by name.
+ * @return 0 or JSDRV_ERROR_PARAMETER_INVALID.
+ */
+int32_t jsdrv_cpu_mask(const char * name, uint32_t * mask);
+
+/**
+ * @brief Get the CPU features for kernel selection.
+ *
+ * @return The jsdrv_cpu_detect() flags limited by JSDRV_CPU_ENV.
+ *
+ * The first call reads the environment, and later calls return
+ * the same value.
+ */
+uint32_t jsdrv_cpu_features(void);
+
+/**
+ * @brief Get the feature names.
+ *
+ * @param features The jsdrv_cpu_feature_e flags.
+ * @param[out] str The space-separated names, or "scalar" for none.
+ * @param size The size of str in bytes.
+ */
+void jsdrv_cpu_features_to_str(uint32_t features, char * str, uint32_t size);
+
+/**
+ * @brief Get the number of online logical processors.
+ *
+ * @return The processor count, which is at least 1.
+ */
+uint32_t jsdrv_cpu_count(void);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_CPU_H__ */
@@ -0,0 +1,106 @@
+/*
+* Copyright 2023 Jetperch LLC
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file
+ *
+ * @brief Data-plane subscriber dispatch threads.
+ */
+
+#ifndef JSDRV_PRV_DISPATCH_H_
+#define JSDRV_PRV_DISPATCH_H_
+
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_dispatch Data-plane dispatch
+ *
+ * @brief Deliver stream and statistics messages on dedicated threads.
+ *
+ * The frontend thread handles control topics, timeouts and
+ * internal subscribers.  When enabled, this module delivers
+ * stream and statistics data to external subscribers on one or
+ * more separate threads, so that slow user callbacks do not
+ * stall the control plane.  All topics of one device map to
+ * exactly one thread, which preserves per-device message order.
+ * Devices are assigned to threads round-robin, so each device
+ * has its own thread when there are enough threads.
+ *
+ * This module also owns the bounded delivery queues for
+ * JSDRV_SFLAG_QUEUED subscribers.  Each queue has its own thread
+ * and applies the subscriber's jsdrv_subscribe_queue_policy_e
+ * when full.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+// Forward declarations from "jsdrv.h" and "jsdrv_prv/pubsub.h"
+struct jsdrv_context_s;
+struct jsdrv_pubsub_dispatch_s;
+
+/// The opaque dispatcher instance.
+struct jsdrv_dispatch_s;
+
+/// The maximum number of dispatch threads.
+#define JSDRV_DISPATCH_THREADS_MAX (32U)
+
+/**
+ * @brief Create the dispatcher and start its threads.
+ *
+ * @param context The driver context.
+ * @param thread_count The number of data-plane threads, clamped to
+ *      JSDRV_DISPATCH_THREADS_MAX.  0 delivers data on the frontend
+ *      thread but still supports queued subscribers.
+ * @return The new instance or NULL on error.
+ */
+struct jsdrv_dispatch_s * jsdrv_dispatch_initialize(struct jsdrv_context_s * context, uint32_t thread_count);
+
+/**
+ * @brief Stop the threads and free the instance.
+ *
+ * @param self The dispatcher instance or NULL.
+ *
+ * Pending messages are released without delivery.  Call only
+ * after the frontend thread exits.
+ */
+void jsdrv_dispatch_finalize(struct jsdrv_dispatch_s * self);
+
+/**
+ * @brief Get the pubsub registration for this dispatcher.
+ *
+ * @param self The dispatcher instance.
+ * @return The value for jsdrv_pubsub_dispatch_register().
+ */
+const struct jsdrv_pubsub_dispatch_s * jsdrv_dispatch_pubsub(struct jsdrv_dispatch_s * self);
+
+/**
+ * @brief Check if the caller runs on a dispatch thread.
+ *
+ * @param self The dispatcher instance or NULL.
+ * @return True when called from a subscriber callback on a dispatch thread.
+ */
+bool jsdrv_dispatch_is_current(struct jsdrv_dispatch_s * self);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_DISPATCH_H_ */
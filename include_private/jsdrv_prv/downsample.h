@@ -42,6 +42,45 @@ JSDRV_CPP_GUARD_START
 enum jsdrv_downsample_mode_e {
     JSDRV_DOWNSAMPLE_MODE_AVERAGE = 0,
     JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND = 1,
+    /**
+     * @brief Output the most frequent value in each window.
+     *
+     * Intended for u4 and u1 channels, such as the current range,
+     * where averaging produces values that never occurred.  The u8
+     * functions use the lower 4 bits of each sample and resolve ties
+     * to the smallest value.  The f32 functions average.
+     */
+    JSDRV_DOWNSAMPLE_MODE_MAJORITY = 2,
+    /**
+     * @brief Resample by any rational ratio sample_rate_out / sample_rate_in.
+     *
+     * The FLAT_PASSBAND stages first reduce the rate while it remains
+     * at least 4 times sample_rate_out.  A polyphase filter then
+     * resamples by L / M, such as 441 / 2000 for 44.1 kHz from 200 kHz.
+     * Instances with the same ratio share the filter coefficients,
+     * which are designed on first use.  The first input sample_id
+     * aligns to the period where the output and input sample times
+     * coincide.  The u8 functions round to the nearest value.
+     */
+    JSDRV_DOWNSAMPLE_MODE_RATIONAL = 3,
+    /**
+     * @brief Decimate with a 3-stage cascaded integrator comb filter.
+     *
+     * Each input sample costs 3 integrator additions regardless of
+     * the decimate factor, which suits very high ratios, such as
+     * 1 Msps to 10 sps.  The response is sinc^3, which droops in the
+     * passband and attenuates the first alias by about 40 dB. The
+     * decimate factor may be any integer up to 2^21.
+     */
+    JSDRV_DOWNSAMPLE_MODE_CIC = 4,
+    /**
+     * @brief JSDRV_DOWNSAMPLE_MODE_CIC followed by a 3-tap FIR.
+     *
+     * The FIR runs at the output rate and reduces the sinc^3 passband
+     * droop to under 1 dB through 0.2 times the output sample rate,
+     * for one output sample of additional delay.
+     */
+    JSDRV_DOWNSAMPLE_MODE_CIC_COMPENSATED = 5,
 };
 
 /// Opaque object
@@ -50,10 +89,112 @@ struct jsdrv_downsample_s;
 struct jsdrv_downsample_s * jsdrv_downsample_alloc(uint32_t sample_rate_in, uint32_t sample_rate_out, int mode);
 void jsdrv_downsample_free(struct jsdrv_downsample_s * self);
 void jsdrv_downsample_clear(struct jsdrv_downsample_s * self);
+
+/**
+ * @brief Get the decimate factor.
+ *
+ * @param self The downsample instance or NULL.
+ * @return The sample_rate_in / sample_rate_out ratio, 1 when self is
+ *      NULL, or 0 for JSDRV_DOWNSAMPLE_MODE_RATIONAL with a non-integer ratio.
+ */
 uint32_t jsdrv_downsample_decimate_factor(struct jsdrv_downsample_s * self);
+
+/**
+ * @brief Get the filter delay.
+ *
+ * @param self The downsample instance or NULL.
+ * @return The delay from an input sample to its full effect on the
+ *      output, in input samples.  0 when self is NULL.
+ */
+uint32_t jsdrv_downsample_sample_delay(struct jsdrv_downsample_s * self);
+
 bool jsdrv_downsample_add_f32(struct jsdrv_downsample_s * self, uint64_t sample_id, float x_in, float * x_out);
+
+/**
+ * @brief Downsample a block of contiguous float32 samples.
+ *
+ * @param self The downsample instance.
+ * @param sample_id The sample id for x[0].  Sample x[i] has sample id
+ *      sample_id + i.
+ * @param x The input samples.
+ * @param n The number of input samples.
+ * @param[out] y The output samples, which must have space for n samples.
+ *      y may equal x to downsample in place.
+ * @param[out] n_out The number of output samples written to y.
+ *
+ * The results are identical to calling jsdrv_downsample_add_f32()
+ * for each sample, but without the per-sample call overhead.
+ */
+void jsdrv_downsample_add_f32_block(struct jsdrv_downsample_s * self, uint64_t sample_id,
+                                    const float * x, uint32_t n, float * y, uint32_t * n_out);
 bool jsdrv_downsample_add_u8(struct jsdrv_downsample_s * self, uint64_t sample_id, uint8_t x_in, uint8_t * x_out);
 
+/**
+ * @brief Downsample a block of contiguous uint8 samples.
+ *
+ * @param self The downsample instance.
+ * @param sample_id The sample id for x[0].  Sample x[i] has sample id
+ *      sample_id + i.
+ * @param x The input samples.
+ * @param n The number of input samples.
+ * @param[out] y The output samples, which must have space for n samples.
+ *      y may equal x to downsample in place.
+ * @param[out] n_out The number of output samples written to y.
+ *
+ * The results are identical to calling jsdrv_downsample_add_u8()
+ * for each sample.
+ */
+void jsdrv_downsample_add_u8_block(struct jsdrv_downsample_s * self, uint64_t sample_id,
+                                   const uint8_t * x, uint32_t n, uint8_t * y, uint32_t * n_out);
+
+/// The maximum number of channels for the multi-channel downsampler.
+#define JSDRV_DOWNSAMPLE_MC_CHANNELS_MAX (8U)
+
+/**
+ * @brief Opaque multi-channel downsampler.
+ *
+ * Downsample up to JSDRV_DOWNSAMPLE_MC_CHANNELS_MAX channels that share
+ * the same sample_id sequence, such as current, voltage and power.
+ * The filter state is interleaved by channel so that each filter tap
+ * processes all channels together, which the compiler vectorizes.
+ * Each channel produces the same output as its own jsdrv_downsample_s
+ * with jsdrv_downsample_add_f32_block().
+ */
+struct jsdrv_downsample_mc_s;
+
+/**
+ * @brief Allocate a multi-channel downsampler.
+ *
+ * @param sample_rate_in The input sample rate.
+ * @param sample_rate_out The output sample rate.
+ * @param mode The jsdrv_downsample_mode_e.  JSDRV_DOWNSAMPLE_MODE_MAJORITY
+ *      averages, like jsdrv_downsample_add_f32().
+ * @param channel_count The number of channels, 1 to
+ *      JSDRV_DOWNSAMPLE_MC_CHANNELS_MAX.
+ * @return The new instance or NULL on invalid arguments.
+ */
+struct jsdrv_downsample_mc_s * jsdrv_downsample_mc_alloc(uint32_t sample_rate_in, uint32_t sample_rate_out,
+                                                         int mode, uint32_t channel_count);
+void jsdrv_downsample_mc_free(struct jsdrv_downsample_mc_s * self);
+void jsdrv_downsample_mc_clear(struct jsdrv_downsample_mc_s * self);
+uint32_t jsdrv_downsample_mc_decimate_factor(struct jsdrv_downsample_mc_s * self);
+uint32_t jsdrv_downsample_mc_sample_delay(struct jsdrv_downsample_mc_s * self);
+
+/**
+ * @brief Downsample a block of contiguous float32 samples for all channels.
+ *
+ * @param self The multi-channel downsample instance.
+ * @param sample_id The sample id for x[c][0].
+ * @param x The input samples, one array of n samples for each channel.
+ * @param n The number of input samples in each channel.
+ * @param[out] y The output samples, one array for each channel, which
+ *      must have space for n samples.  y[c] may equal x[c] to
+ *      downsample in place.
+ * @param[out] n_out The number of output samples written to each y[c].
+ */
+void jsdrv_downsample_mc_add_f32_block(struct jsdrv_downsample_mc_s * self, uint64_t sample_id,
+                                       const float * const * x, uint32_t n, float * const * y, uint32_t * n_out);
+
 JSDRV_CPP_GUARD_END
 
 #endif // JSDRV_DOWNSAMPLE_H__
@@ -37,6 +37,17 @@
  *
  * @brief Provide a simple event abstraction.
  *
+ * On POSIX, the event is a file descriptor that poll() reports as
+ * readable while signaled, so that threads can wait on events together
+ * with other descriptors, such as libusb.  Linux uses an eventfd, and
+ * other platforms use a pipe.  Only the first signal after a reset
+ * writes to the descriptor, so repeated signals cost an atomic
+ * operation rather than a system call.  Reset clears the signaled flag,
+ * then drains the descriptor with non-blocking reads, and writes again
+ * if a racing signal set the flag during the drain.  A race may
+ * cause a spurious wakeup but never loses a signal, so waiters must
+ * recheck their state after a reset.
+ *
  * @{
  */
 
@@ -49,7 +60,8 @@ typedef HANDLE jsdrv_os_event_t;
 struct jsdrv_os_event_s {
     int fd_poll;
     int events;
-    int fd_signal;
+    int fd_signal;              // same as fd_poll for eventfd
+    volatile int32_t signaled;  // 1 when fd_poll is, or is about to be, readable
 };
 typedef struct jsdrv_os_event_s * jsdrv_os_event_t;
 #endif
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Shared worker pool for upper-level device drivers.
+ */
+
+#ifndef JSDRV_PRV_EXECUTOR_H_
+#define JSDRV_PRV_EXECUTOR_H_
+
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_executor Executor
+ *
+ * @brief Run event-driven tasks on a fixed pool of threads.
+ *
+ * By default, each upper-level device driver has its own thread.
+ * The executor instead runs each driver as a task on a shared pool
+ * of worker threads.  A task runs when signalled, usually by
+ * msg_queue_notify_set(), or when its timer expires.  Any idle
+ * worker takes the next ready task from the shared ready list, so
+ * a device busy with a long decode burst does not delay the other
+ * devices.  A task never runs on two workers at the same time, and
+ * a signal that arrives while the task runs schedules it again.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The opaque executor instance.
+struct jsdrv_executor_s;
+
+/// The opaque task instance.
+struct jsdrv_executor_task_s;
+
+/// The maximum number of worker threads.
+#define JSDRV_EXECUTOR_THREADS_MAX (64U)
+
+/**
+ * @brief The task function.
+ *
+ * @param user_data The arbitrary user data.
+ * @return The milliseconds until the task should run again when
+ *      not signalled, or -1 to wait only for signals.
+ */
+typedef int32_t (*jsdrv_executor_fn)(void * user_data);
+
+/**
+ * @brief Create the executor and start its worker threads.
+ *
+ * @param thread_count The number of worker threads, clamped to
+ *      1 to JSDRV_EXECUTOR_THREADS_MAX.
+ * @return The new instance or NULL on error.
+ */
+struct jsdrv_executor_s * jsdrv_executor_initialize(uint32_t thread_count);
+
+/**
+ * @brief Stop the worker threads and free the instance.
+ *
+ * @param self The executor instance or NULL.
+ *
+ * Remove all tasks first.
+ */
+void jsdrv_executor_finalize(struct jsdrv_executor_s * self);
+
+/**
+ * @brief Get the number of worker threads.
+ *
+ * @param self The executor instance.
+ * @return The number of worker threads.
+ */
+uint32_t jsdrv_executor_thread_count(struct jsdrv_executor_s * self);
+
+/**
+ * @brief Add a task.
+ *
+ * @param self The executor instance.
+ * @param fn The task function.
+ * @param user_data The arbitrary data for fn.
+ * @return The new task, which is scheduled to run once.
+ */
+struct jsdrv_executor_task_s * jsdrv_executor_task_add(struct jsdrv_executor_s * self,
+                                                       jsdrv_executor_fn fn, void * user_data);
+
+/**
+ * @brief Schedule a task to run.
+ *
+ * @param task The task.
+ *
+ * Safe to call from any thread.  The signature matches
+ * msg_queue_notify_fn.
+ */
+void jsdrv_executor_task_signal(void * task);
+
+/**
+ * @brief Remove a task and free it.
+ *
+ * @param task The task or NULL.
+ *
+ * Blocks until any in-progress run completes, after which the task
+ * never runs again.  Do not call from the task function.
+ */
+void jsdrv_executor_task_remove(struct jsdrv_executor_task_s * task);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_EXECUTOR_H_ */
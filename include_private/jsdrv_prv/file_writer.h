@@ -0,0 +1,175 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Asynchronous multi-buffered file writer.
+ */
+
+#ifndef JSDRV_PRV_FILE_WRITER_H_
+#define JSDRV_PRV_FILE_WRITER_H_
+
+#include "jsdrv/cmacro_inc.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_file_writer File writer
+ *
+ * @brief Append to a file from a single producer without blocking on storage.
+ *
+ * The producer copies data into large, page-aligned buffers.  A
+ * dedicated writer thread writes each full buffer to the file with a
+ * single write, so storage latency never stalls the producer.  When
+ * the writer falls behind and every buffer is full, jsdrv_file_writer_reserve()
+ * fails and the producer decides whether to drop or retry.
+ *
+ * With JSDRV_FILE_WRITER_FLAG_URING on Linux, the writer registers the
+ * buffers with io_uring once and submits every full buffer with a single
+ * system call, which keeps multiple writes in flight to the storage device.
+ *
+ * All functions except jsdrv_file_writer_status() must be called from
+ * the same producer thread.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The default buffer size in bytes.
+#define JSDRV_FILE_WRITER_BUFFER_SIZE   (4U * 1024U * 1024U)
+/// The default number of buffers.
+#define JSDRV_FILE_WRITER_BUFFER_COUNT  (8U)
+/// The buffer size granularity, which accommodates all page sizes for direct writes.
+#define JSDRV_FILE_WRITER_BUFFER_ALIGN  (64U * 1024U)
+
+/// The jsdrv_file_writer_config_s option flags.
+enum jsdrv_file_writer_flags_e {
+    JSDRV_FILE_WRITER_FLAG_DIRECT = (1 << 0),   ///< Request unbuffered writes that bypass the OS cache.
+    JSDRV_FILE_WRITER_FLAG_URING = (1 << 1),    ///< Request batched io_uring writes on Linux.
+};
+
+/// The policies for flushing written data to the storage device.
+enum jsdrv_file_writer_sync_e {
+    JSDRV_FILE_WRITER_SYNC_NONE = 0,        ///< Never, the OS writes back at its discretion.
+    JSDRV_FILE_WRITER_SYNC_CLOSE = 1,       ///< Once on close.
+    JSDRV_FILE_WRITER_SYNC_INTERVAL = 2,    ///< After a write at most every sync_interval_ms, and on close.
+    JSDRV_FILE_WRITER_SYNC_BUFFER = 3,      ///< After every buffer write.
+};
+
+/// The writer configuration.  Zero selects the default for each field.
+struct jsdrv_file_writer_config_s {
+    uint32_t buffer_size;       ///< The buffer size, rounded up to JSDRV_FILE_WRITER_BUFFER_ALIGN.
+    uint32_t buffer_count;      ///< The number of buffers, at least 2.
+    uint32_t flags;             ///< The jsdrv_file_writer_flags_e bitmap.
+    uint32_t sync;              ///< The jsdrv_file_writer_sync_e policy.
+    uint32_t sync_interval_ms;  ///< The interval for JSDRV_FILE_WRITER_SYNC_INTERVAL, default 1000.
+    uint64_t preallocate;       ///< The file storage to reserve on open in bytes.
+};
+
+/// The writer status.
+struct jsdrv_file_writer_status_s {
+    uint64_t bytes_reserved;    ///< The bytes provided to the producer.
+    uint64_t bytes_written;     ///< The bytes written to the file.
+    uint64_t reserve_fail;      ///< The number of failed reservations.
+    uint32_t backlog;           ///< The buffers waiting for the writer.
+    uint32_t backlog_max;       ///< The peak buffers waiting for the writer.
+    uint32_t batch_max;         ///< The peak buffers in a single write.
+    int64_t write_time;         ///< The total time in write and sync calls as 34Q30.
+    int64_t write_time_max;     ///< The longest single write and sync as 34Q30.
+    int32_t error;              ///< The first write error, or 0.
+    bool uring;                 ///< The writer uses io_uring.
+};
+
+// opaque instance
+struct jsdrv_file_writer_s;
+
+/**
+ * @brief Create or truncate a file and start the writer thread.
+ *
+ * @param path The file path.
+ * @param config The configuration or NULL for the defaults.
+ * @return The writer or NULL on error.
+ *
+ * Direct writes, io_uring and preallocation are hints.  When unavailable,
+ * the writer logs a warning and continues without them.
+ */
+struct jsdrv_file_writer_s * jsdrv_file_writer_open(const char * path, const struct jsdrv_file_writer_config_s * config);
+
+/**
+ * @brief Get the configured buffer size.
+ *
+ * @param self The writer.
+ * @return The buffer size in bytes, which is the maximum reservation.
+ */
+uint32_t jsdrv_file_writer_buffer_size(struct jsdrv_file_writer_s * self);
+
+/**
+ * @brief Reserve contiguous space at the end of the file.
+ *
+ * @param self The writer.
+ * @param size The number of bytes, up to jsdrv_file_writer_buffer_size().
+ * @return The pointer to fill with size bytes, or NULL when all buffers
+ *      are waiting for the writer.  The pointer is valid until the next
+ *      call to any function other than jsdrv_file_writer_status().
+ */
+uint8_t * jsdrv_file_writer_reserve(struct jsdrv_file_writer_s * self, uint32_t size);
+
+/**
+ * @brief Append data to the file.
+ *
+ * @param self The writer.
+ * @param data The data to copy.
+ * @param size The number of bytes, up to jsdrv_file_writer_buffer_size().
+ * @return 0, JSDRV_ERROR_FULL when dropped or JSDRV_ERROR_PARAMETER_INVALID.
+ */
+int32_t jsdrv_file_writer_write(struct jsdrv_file_writer_s * self, const void * data, uint32_t size);
+
+/**
+ * @brief Submit the partially filled buffer to the writer.
+ *
+ * @param self The writer.
+ *
+ * The writer normally submits each buffer when full.  Flushing earlier
+ * bounds the data at risk for slow producers, at the cost of smaller writes.
+ */
+void jsdrv_file_writer_flush(struct jsdrv_file_writer_s * self);
+
+/**
+ * @brief Get the writer status.
+ *
+ * @param self The writer.
+ * @param status[out] The status.
+ *
+ * This function may be called from any thread.
+ */
+void jsdrv_file_writer_status(struct jsdrv_file_writer_s * self, struct jsdrv_file_writer_status_s * status);
+
+/**
+ * @brief Write all data, stop the writer thread and close the file.
+ *
+ * @param self The writer, which is freed.
+ * @return 0 or the first write, sync or close error.
+ */
+int32_t jsdrv_file_writer_close(struct jsdrv_file_writer_s * self);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_FILE_WRITER_H_ */
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Combine device channels into multi-channel stream frames.
+ */
+
+#ifndef JSDRV_PRV_FRAMER_H_
+#define JSDRV_PRV_FRAMER_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_framer Stream framer
+ *
+ * @brief Assemble jsdrv_stream_frame_s from the channels of one device.
+ *
+ * The device adds each channel's samples as it produces them.  The
+ * framer retains the samples until every channel covers the same
+ * sample_id range, then packs that range into a single frame.
+ * Channel 0 defines the frame sample_id and decimate_factor.  The
+ * other channels hold their most recent sample at or before each
+ * channel 0 sample.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+#ifndef JSDRV_FRAMER_SAMPLES_MAX
+/// The samples retained for each channel.
+#define JSDRV_FRAMER_SAMPLES_MAX (1U << 15)
+#endif
+
+/// The opaque framer instance.
+struct jsdrv_framer_s;
+
+/**
+ * @brief Allocate a new framer.
+ *
+ * @return The new instance with no channels.
+ */
+struct jsdrv_framer_s * jsdrv_framer_alloc(void);
+
+/**
+ * @brief Free a framer.
+ *
+ * @param self The instance from jsdrv_framer_alloc() or NULL.
+ */
+void jsdrv_framer_free(struct jsdrv_framer_s * self);
+
+/**
+ * @brief Configure the channels.
+ *
+ * @param self The instance.
+ * @param channels The channels using their input format: float with
+ *      32 bits or unsigned integers with 1, 4 or 8 bits.  The offset
+ *      is ignored.
+ * @param channel_count The number of channels, up to
+ *      JSDRV_STREAM_FRAME_CHANNELS_MAX.
+ * @return 0 or JSDRV_ERROR_PARAMETER_INVALID.
+ *
+ * Changing the channels discards all retained samples.
+ */
+int32_t jsdrv_framer_configure(struct jsdrv_framer_s * self, const struct jsdrv_stream_frame_channel_s * channels,
+                               uint8_t channel_count);
+
+/**
+ * @brief Discard all retained samples.
+ *
+ * @param self The instance.
+ */
+void jsdrv_framer_clear(struct jsdrv_framer_s * self);
+
+/**
+ * @brief Add samples to a channel.
+ *
+ * @param self The instance.
+ * @param channel The channel index.
+ * @param sample_id The sample id for the first sample.
+ * @param decimate_factor The sample_id increment for each sample.
+ * @param data The samples in the channel input format.  Packed
+ *      integers start in the least significant bits of data[0].
+ * @param count The number of samples.
+ * @return 0 or JSDRV_ERROR_PARAMETER_INVALID.
+ *
+ * Samples that do not continue the channel restart it.  When a
+ * channel exceeds JSDRV_FRAMER_SAMPLES_MAX, its oldest samples are
+ * discarded.
+ */
+int32_t jsdrv_framer_add(struct jsdrv_framer_s * self, uint8_t channel, uint64_t sample_id,
+                         uint32_t decimate_factor, const void * data, uint32_t count);
+
+/**
+ * @brief Get the channel 0 decimate factor.
+ *
+ * @param self The instance.
+ * @return The decimate factor, or 0 before channel 0 has samples.
+ */
+uint32_t jsdrv_framer_decimate_factor(struct jsdrv_framer_s * self);
+
+/**
+ * @brief Pack the next frame.
+ *
+ * @param self The instance.
+ * @param[out] frame The frame.  The caller provides sample_rate and
+ *      time_map.
+ * @param element_count The samples for each channel.  Frames limited
+ *      by JSDRV_STREAM_FRAME_DATA_SIZE contain fewer samples.
+ * @return The frame size in bytes, or 0 when the channels do not
+ *      yet cover the frame.
+ */
+uint32_t jsdrv_framer_pop(struct jsdrv_framer_s * self, struct jsdrv_stream_frame_s * frame, uint32_t element_count);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_FRAMER_H_ */
@@ -41,6 +41,17 @@ enum jsdrvp_payload_type_e {     // for jsdrv_union_s.app
 #define JSDRV_MSG_TYPE_NORMAL   0x55aa1234U
 #define JSDRV_MSG_TYPE_DATA     0xaa55F00FU
 
+/**
+ * @brief The message quality of service, see msg_queue_qos_enable().
+ *
+ * Devices assign their h/qos parameter to each message they send.
+ */
+enum jsdrvp_qos_e {
+    JSDRVP_QOS_BACKGROUND = 0,  // after all other messages
+    JSDRVP_QOS_NORMAL = 1,      // the default, in order
+    JSDRVP_QOS_CRITICAL = 2,    // before all other data lane messages
+};
+
 struct jsdrvp_payload_subscribe_s {  // also for unsubscribe
     char topic[JSDRV_TOPIC_LENGTH_MAX];
     struct jsdrv_pubsub_subscriber_s subscriber;
@@ -49,6 +60,16 @@ struct jsdrvp_payload_subscribe_s {  // also for unsubscribe
 struct jsdrvp_payload_query_s {
     char topic[JSDRV_TOPIC_LENGTH_MAX];
     struct jsdrv_union_s * value;  // for the return, buffer for str, json, bin
+    uint8_t flags;                 // JSDRV_PUBSUB_SNAPSHOT only, jsdrv_subscribe_flag_e
+};
+
+// data-plane envelope, see jsdrv_pubsub_dispatch_s and the memory buffer signal data
+struct jsdrvp_payload_dispatch_s {
+    struct jsdrvp_msg_s * msg;          // the retained data message or NULL
+    struct jsdrvp_msg_s * rsp;          // the barrier return code message or NULL
+    volatile int32_t * barrier_pending; // threads that have not yet reached the barrier
+    uint32_t count;
+    struct jsdrv_pubsub_subscriber_s subscribers[JSDRV_PUBSUB_DISPATCH_SUBSCRIBERS_MAX];
 };
 
 // lower-level (backend) device driver API
@@ -66,7 +87,6 @@ struct jsdrvp_ul_device_s {
 // create and bind to ll
 int32_t jsdrvp_ul_js110_usb_factory(struct jsdrvp_ul_device_s ** device, struct jsdrv_context_s * context, struct jsdrvp_ll_device_s * ll);
 int32_t jsdrvp_ul_js220_usb_factory(struct jsdrvp_ul_device_s ** device, struct jsdrv_context_s * context, struct jsdrvp_ll_device_s * ll);
-int32_t jsdrvp_ul_emu_factory(struct jsdrvp_ul_device_s ** device, struct jsdrv_context_s * context, struct jsdrvp_ll_device_s * ll);
 
 
 struct jsdrvp_msg_extra_frontend_s {
@@ -80,6 +100,12 @@ struct jsdrvp_msg_extra_backend_usb_control_s {
 
 struct jsdrvp_msg_extra_backend_usb_stream_s {
     uint8_t endpoint;
+    uint32_t transfer_depth;    // bulk in open: outstanding transfers, 0 for default; stream in data: current
+    uint32_t transfer_depth_max;  // bulk in open: adaptive depth limit, 0 or <= transfer_depth for fixed
+    uint32_t transfer_size;     // bulk in open: bytes per transfer, 0 for default
+    uint32_t transfer_spare;    // bulk in open: spare transfers, 0 for default
+    uint32_t transfer_skip;     // stream in data return: nonzero when the upper layer detected a skip
+    void * owner;               // stream in data: backend transfer, return unchanged
 };
 
 union jsdrvp_msg_extra_s {
@@ -93,27 +119,43 @@ union jsdrvp_payload_u {
     char str[JSDRV_PAYLOAD_LENGTH_MAX];         // string or json string
     struct jsdrvp_payload_subscribe_s sub;
     struct jsdrvp_payload_query_s query;
+    struct jsdrvp_payload_dispatch_s dispatch;
     struct jsdrvp_ll_device_s device;           // for @/add from backend
 };
 
+struct jsdrvp_api_async_s;
+
 struct jsdrvp_api_timeout_s {
     struct jsdrv_list_s item;                   // for putting into list
     char topic[JSDRV_TOPIC_LENGTH_MAX];  // to match
     int64_t timeout;                            // timeout time as fbp_time_utc()
     jsdrv_os_event_t ev;                        // The event to signal upon completion or timeout
     volatile int32_t return_code;               // The return code for the operation.
+    struct jsdrvp_api_timeout_s * batch;        // The shared completion for jsdrv_publish_batch() or NULL
+    uint32_t batch_pending;                     // For the batch completion, the incomplete entries
+    uint32_t topic_hash;                        // jsdrv_pubsub_topic_hash(topic), see jsdrv_prv/api_timeout.h
+    uint32_t heap_index;                        // The deadline heap index, see jsdrv_prv/api_timeout.h
+    struct jsdrvp_api_async_s * async;          // The jsdrv_publish_async() completion or NULL
 };
 
+/// The jsdrvp_msg_s source for an API value sent directly to the device.
+#define JSDRVP_MSG_SOURCE_DIRECT (2U)
+
 struct jsdrvp_msg_s {
     struct jsdrv_list_s item;                   // queue support (internal use) - MUST BE FIRST
     uint32_t inner_msg_type;                    // jsdrvp_msg_type_e (internal use, do not edit)
-    uint32_t source;                            // 0=backend/frontend/internal, 1=api
+    uint32_t source;                            // 0=backend/frontend/internal, 1=api, JSDRVP_MSG_SOURCE_DIRECT
     uint32_t u32_a;                             // temporary storage variable, available for message processing
     uint32_t u32_b;                             // temporary storage variable, available for message processing
     char topic[JSDRV_TOPIC_LENGTH_MAX];    // the topic name or device identifier
+    uint32_t topic_hash;                        // jsdrv_pubsub_topic_hash(topic) or 0 (not computed)
     struct jsdrv_union_s value;                 // the value as a union type
     union jsdrvp_msg_extra_s extra;
+    struct jsdrv_stream_latency_s latency;      // stream latency stamps or 0, see jsdrv_prv/latency.h
+    uint32_t qos;                               // jsdrvp_qos_e
     struct jsdrvp_api_timeout_s * timeout;
+    volatile int32_t refcnt;                    // reference count (internal use), see jsdrvp_msg_retain()
+    uint32_t capacity;                          // payload capacity in bytes (internal use, do not edit)
     union jsdrvp_payload_u payload;             // must be last
     // do not place any fields after payload!
 };
@@ -124,6 +166,37 @@ struct jsdrvp_param_s {
     const char * meta;
 };
 
+/**
+ * @brief A precomputed topic for repeated publishes.
+ *
+ * Devices publish stream data and statistics to the same topics for
+ * every message.  Compute this once with jsdrvp_topic_init() and then
+ * assign it with jsdrvp_msg_topic_set(), which skips the formatting.
+ */
+struct jsdrvp_topic_s {
+    char topic[JSDRV_TOPIC_LENGTH_MAX];    // the full topic name
+    uint32_t length;                       // strlen(topic), excluding the terminator
+    uint32_t hash;                         // jsdrv_pubsub_topic_hash(topic)
+};
+
+/**
+ * @brief Initialize a precomputed topic.
+ *
+ * @param topic The topic to initialize.
+ * @param prefix The device prefix, such as "u/js220/000415".
+ * @param subtopic The topic relative to the prefix, such as "s/i/!data".
+ */
+void jsdrvp_topic_init(struct jsdrvp_topic_s * topic, const char * prefix, const char * subtopic);
+
+/**
+ * @brief Assign a precomputed topic to a message.
+ *
+ * @param msg The message.
+ * @param topic The topic from jsdrvp_topic_init(), which also
+ *      sets msg->topic_hash.
+ */
+void jsdrvp_msg_topic_set(struct jsdrvp_msg_s * msg, const struct jsdrvp_topic_s * topic);
+
 /**
  * @brief Allocate a new message.
  *
@@ -133,6 +206,38 @@ struct jsdrvp_param_s {
  */
 struct jsdrvp_msg_s * jsdrvp_msg_alloc(struct jsdrv_context_s * context);
 
+/// The payload capacity for jsdrvp_msg_alloc_small() in bytes.
+#define JSDRVP_MSG_SMALL_PAYLOAD_SIZE (64U)
+
+/**
+ * @brief Allocate a new small message.
+ *
+ * @param context The Joulescope driver context.
+ * @return The message with msg->capacity set to
+ *      JSDRVP_MSG_SMALL_PAYLOAD_SIZE.
+ * @throw assert on out of memory
+ *
+ * Small messages end after JSDRVP_MSG_SMALL_PAYLOAD_SIZE payload
+ * bytes, so they are a fraction of the normal message size.  Use
+ * them for return codes and scalar values that the frontend
+ * publishes.  Never access the payload beyond msg->capacity.
+ * jsdrvp_msg_clone() always returns a normal message.
+ */
+struct jsdrvp_msg_s * jsdrvp_msg_alloc_small(struct jsdrv_context_s * context);
+
+/**
+ * @brief Move a message into a small message when the value fits.
+ *
+ * @param context The Joulescope driver context.
+ * @param msg The normal message, which the caller owns.
+ * @return msg, or the new small message after freeing msg.
+ *
+ * Only unshared messages with a scalar value or an inline value
+ * of at most JSDRVP_MSG_SMALL_PAYLOAD_SIZE bytes move.  Pubsub
+ * calls this for retained values, which live for the topic lifetime.
+ */
+struct jsdrvp_msg_s * jsdrvp_msg_compact(struct jsdrv_context_s * context, struct jsdrvp_msg_s * msg);
+
 /**
  * @brief Allocate a large binary data message.
  *
@@ -145,6 +250,23 @@ struct jsdrvp_msg_s * jsdrvp_msg_alloc(struct jsdrv_context_s * context);
  */
 struct jsdrvp_msg_s * jsdrvp_msg_alloc_data(struct jsdrv_context_s * context, const char * topic);
 
+/**
+ * @brief Allocate a binary data message sized for the expected data.
+ *
+ * @param context The Joulescope driver context.
+ * @param topic The topic for the message.
+ * @param size The required payload size in bytes, which includes
+ *      JSDRV_STREAM_HEADER_SIZE for stream messages.
+ * @return The message from the smallest size class that holds size,
+ *      limited to sizeof(struct jsdrv_stream_signal_s).
+ *      msg->capacity contains the actual payload capacity.
+ * @throw assert on out of memory
+ *
+ * Low-rate and small-element channels use far less than the full
+ * stream message, and smaller messages reduce the working set.
+ */
+struct jsdrvp_msg_s * jsdrvp_msg_alloc_data_sz(struct jsdrv_context_s * context, const char * topic, uint32_t size);
+
 /**
  * @brief Allocation a new message and populate with same contents as another message.
  *
@@ -167,7 +289,26 @@ struct jsdrvp_msg_s * jsdrvp_msg_clone(struct jsdrv_context_s * context, const s
 struct jsdrvp_msg_s * jsdrvp_msg_alloc_value(struct jsdrv_context_s * context, const char * topic, const struct jsdrv_union_s * value);
 
 /**
- * @brief Free a message to the free list.
+ * @brief Add a reference to a message.
+ *
+ * @param msg The message to retain.
+ * @return msg.
+ *
+ * All messages are allocated with a single reference.  Each
+ * call to this function adds a reference which must be released
+ * using jsdrvp_msg_free().  The message returns to the free list
+ * only when the last reference is released.  This function allows
+ * large stream data messages to be shared by multiple consumers,
+ * possibly on different threads, without copying.  Shared messages
+ * must be treated as read-only.
+ *
+ * The message contains a single list item, so only one holder
+ * may place the message into a queue at a time.
+ */
+struct jsdrvp_msg_s * jsdrvp_msg_retain(struct jsdrvp_msg_s * msg);
+
+/**
+ * @brief Release a message reference, and free to the free list on last release.
  *
  * @param msg The message to free.
  */
@@ -192,6 +333,37 @@ void jsdrvp_backend_send(struct jsdrv_context_s * context, struct jsdrvp_msg_s *
  */
 void jsdrvp_send_finalize_msg(struct jsdrv_context_s * context, struct msg_queue_s * q, const char * topic);
 
+/**
+ * @brief Get an initialization argument.
+ *
+ * @param context The Joulescope driver context.
+ * @param topic The argument topic, such as JSDRV_ARG_USB_THREADS.
+ * @return The argument value or NULL if not provided.
+ *
+ * The arguments are only valid while the driver initializes,
+ * which includes the backend factory functions.
+ */
+const struct jsdrv_union_s * jsdrvp_arg_get(struct jsdrv_context_s * context, const char * topic);
+
+/**
+ * @brief Get the calibration cache directory.
+ *
+ * @param context The Joulescope driver context.
+ * @return The JSDRV_ARG_JS110_CAL_CACHE directory or NULL when disabled.
+ */
+const char * jsdrvp_cal_cache_path(struct jsdrv_context_s * context);
+
+// forward declaration for "jsdrv_prv/executor.h"
+struct jsdrv_executor_s;
+
+/**
+ * @brief Get the shared device driver executor.
+ *
+ * @param context The Joulescope driver context.
+ * @return The JSDRV_ARG_DEVICE_THREADS executor or NULL when disabled.
+ */
+struct jsdrv_executor_s * jsdrvp_executor(struct jsdrv_context_s * context);
+
 /**
  * @brief Subscribe a device to an additional topics.
  *
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief GPI-gated host-side accumulators.
+ */
+
+#ifndef JSDRV_PRV_GATE_H_
+#define JSDRV_PRV_GATE_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_gate GPI gate
+ *
+ * @brief Accumulate current, voltage and power while the GPI match a level.
+ *
+ * The gate is active while (gpi & mask) == (level & mask), where bit N
+ * is the general purpose input N.  Each span of active samples is one
+ * gate interval.  When the interval ends, the gate computes its
+ * jsdrv_statistics_s with the charge and energy over the interval.
+ *
+ * The device adds the GPI samples and the aligned i, v and p samples
+ * separately as it receives them.  The GPI samples only retain their
+ * level changes.  The i, v and p samples wait, up to
+ * JSDRV_GATE_WINDOW samples, until every GPI in mask covers them.
+ * When the GPI fall further behind, the gate discards the oldest
+ * samples, counts them as overruns, and ends any active interval.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The number of GPI bits for the mask and level.
+#define JSDRV_GATE_GPI_COUNT (8U)
+
+/// The maximum retained i, v and p samples awaiting the GPI, a power of 2.
+#ifndef JSDRV_GATE_WINDOW
+#define JSDRV_GATE_WINDOW (1U << 15)
+#endif
+
+/// The maximum retained level changes for each GPI.
+#define JSDRV_GATE_EDGES (256U)
+
+/**
+ * @brief The function called at the end of each gate interval.
+ *
+ * @param user_data The arbitrary user data.
+ * @param stats The statistics over the interval.  block_sample_id and
+ *      accum_sample_id are the first active sample, block_sample_count
+ *      is the active samples, and charge and energy integrate over
+ *      the interval only.  The caller populates time_map.  The
+ *      pointer remains valid only for the duration of the call.
+ */
+typedef void (*jsdrv_gate_fn)(void * user_data, struct jsdrv_statistics_s * stats);
+
+/// The opaque instance.
+struct jsdrv_gate_s;
+
+/**
+ * @brief Allocate a new instance.
+ *
+ * @param sample_freq The sample_id frequency.
+ * @param decimate_factor The sample_id increment for each i, v and p sample.
+ * @param fn The function called for each gate interval.
+ * @param user_data The arbitrary data for fn.
+ * @return The new instance, disabled with mask 0.
+ */
+struct jsdrv_gate_s * jsdrv_gate_alloc(uint32_t sample_freq, uint8_t decimate_factor,
+                                       jsdrv_gate_fn fn, void * user_data);
+
+/**
+ * @brief Free an instance.
+ *
+ * @param self The instance from jsdrv_gate_alloc() or NULL.
+ */
+void jsdrv_gate_free(struct jsdrv_gate_s * self);
+
+/**
+ * @brief Discard the retained samples and any active interval.
+ *
+ * @param self The instance.
+ *
+ * Call on stream restart.  The overrun count continues.
+ */
+void jsdrv_gate_clear(struct jsdrv_gate_s * self);
+
+/**
+ * @brief Configure the gate.
+ *
+ * @param self The instance.
+ * @param mask The GPI bits that control the gate, or 0 to disable.
+ * @param level The GPI levels for mask that activate the gate.
+ *
+ * Changes clear the instance.
+ */
+void jsdrv_gate_config(struct jsdrv_gate_s * self, uint8_t mask, uint8_t level);
+
+/**
+ * @brief Get the configured mask.
+ *
+ * @param self The instance.
+ * @return The GPI mask, 0 when disabled.
+ */
+uint8_t jsdrv_gate_mask(struct jsdrv_gate_s * self);
+
+/**
+ * @brief Get the overrun count.
+ *
+ * @param self The instance.
+ * @return The total i, v and p samples discarded because the GPI fell
+ *      more than JSDRV_GATE_WINDOW samples behind.
+ */
+uint64_t jsdrv_gate_overrun(struct jsdrv_gate_s * self);
+
+/**
+ * @brief Add samples for one GPI.
+ *
+ * @param self The instance.
+ * @param gpi The GPI index, 0 to JSDRV_GATE_GPI_COUNT - 1.
+ * @param sample_id The sample_id of the first sample.
+ * @param decimate_factor The sample_id increment for each sample.
+ * @param x The packed u1 samples, least significant bit first.
+ * @param count The number of samples in x.
+ *
+ * A sample_id discontinuity holds the previous level until sample_id.
+ * GPI outside mask are ignored.
+ */
+void jsdrv_gate_add_gpi(struct jsdrv_gate_s * self, uint8_t gpi, uint64_t sample_id, uint32_t decimate_factor,
+                        const uint8_t * x, uint32_t count);
+
+/**
+ * @brief Add aligned current, voltage and power samples.
+ *
+ * @param self The instance.
+ * @param sample_id The sample_id of the first sample.
+ * @param i The current samples in A.
+ * @param v The voltage samples in V.
+ * @param p The power samples in W.
+ * @param count The number of samples.
+ *
+ * Samples where any of i, v or p is NaN count towards the interval
+ * duration, but not its statistics.  A sample_id discontinuity ends
+ * any active interval.
+ */
+void jsdrv_gate_add(struct jsdrv_gate_s * self, uint64_t sample_id,
+                    const float * i, const float * v, const float * p, uint32_t count);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_GATE_H_ */
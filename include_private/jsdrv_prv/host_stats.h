@@ -0,0 +1,148 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Host-side statistics over sample streams.
+ */
+
+#ifndef JSDRV_PRV_HOST_STATS_H_
+#define JSDRV_PRV_HOST_STATS_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include "jsdrv_prv/statistics.h"
+#include "js220_api.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_host_stats Host statistics
+ *
+ * @brief Compute windowed statistics over current, voltage and power.
+ *
+ * The window of "window" samples advances by "hop" samples.  Tumbling
+ * windows use hop == window, and sliding windows use a hop that evenly
+ * divides the window.  Each hop-sized segment keeps its own statistics
+ * which combine into the window statistics, so the cost per sample is
+ * independent of the window length.
+ *
+ * The optional derived statistics add the window RMS and crest factor
+ * and running histograms, see jsdrv_host_derived_s.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+#ifndef JSDRV_HOST_STATS_SEGMENTS_MAX
+/// The maximum number of hop segments in each window.
+#define JSDRV_HOST_STATS_SEGMENTS_MAX (64U)
+#endif
+
+/// The host statistics instance.
+struct jsdrv_host_stats_s {
+    struct jsdrv_statistics_s statistics;
+    uint32_t window;            ///< The samples per window.
+    uint32_t hop;               ///< The samples between each output.
+    uint32_t seg_count;         ///< window / hop
+    uint32_t seg_head;          ///< The next segment index to write.
+    uint32_t seg_valid;         ///< The number of completed segments, up to seg_count.
+    uint32_t seg_fill;          ///< The samples in the current segment.
+    uint64_t sample_id_next;    ///< The sample_id for the next sample, 0 before the first.
+    struct jsdrv_statistics_accum_s seg[JSDRV_HOST_STATS_SEGMENTS_MAX][3];
+    struct jsdrv_statistics_accum_s cur[3];
+    js220_i128 charge;          ///< Current sum from accum_sample_id, Q31.
+    js220_i128 energy;          ///< Power sum from accum_sample_id, Q31.
+    bool derived_enable;        ///< Compute the derived statistics.
+    struct jsdrv_host_derived_s derived;
+};
+
+/**
+ * @brief Initialize the instance.
+ *
+ * @param self The instance.
+ * @param sample_freq The sample_id frequency.
+ * @param decimate_factor The sample_id increment for each sample.
+ *
+ * The default configuration uses tumbling windows of 0.1 seconds.
+ */
+void jsdrv_host_stats_initialize(struct jsdrv_host_stats_s * self, uint32_t sample_freq, uint8_t decimate_factor);
+
+/**
+ * @brief Configure the window.
+ *
+ * @param self The instance.
+ * @param window The number of samples in each window.
+ * @param hop The number of samples between each output, or 0 for
+ *      tumbling windows (hop = window).
+ * @return 0 or JSDRV_ERROR_PARAMETER_INVALID.  The window must be a
+ *      multiple of hop with at most JSDRV_HOST_STATS_SEGMENTS_MAX hops.
+ *
+ * Reconfiguring clears all partial computations.
+ */
+int32_t jsdrv_host_stats_config(struct jsdrv_host_stats_s * self, uint32_t window, uint32_t hop);
+
+/**
+ * @brief Clear the partial window and the charge and energy integration.
+ *
+ * @param self The instance.
+ *
+ * Also clears the derived histograms.
+ */
+void jsdrv_host_stats_clear(struct jsdrv_host_stats_s * self);
+
+/**
+ * @brief Enable the derived statistics.
+ *
+ * @param self The instance.
+ * @param enable True to compute jsdrv_host_derived_s for each window.
+ *
+ * Enabling clears the histograms.
+ */
+void jsdrv_host_stats_derived_enable(struct jsdrv_host_stats_s * self, bool enable);
+
+/**
+ * @brief Add contiguous samples.
+ *
+ * @param self The instance.
+ * @param sample_id The sample_id for the first sample.
+ * @param i The current samples in A.
+ * @param v The voltage samples in V.
+ * @param p The power samples in W.
+ * @param count The number of samples.
+ * @param stats[out] NULL or the statistics structure when the consumed
+ *      samples complete a window.  The structure remains valid until the
+ *      next call with self.  When derived is enabled, self->derived
+ *      holds the matching derived statistics.
+ * @return The number of samples consumed, which stops at each output.
+ *      Call again with the remaining samples.
+ *
+ * Samples where any of i, v or p is NaN do not contribute to the
+ * statistics.  A sample_id discontinuity restarts the window but
+ * continues the charge and energy integration.
+ */
+uint32_t jsdrv_host_stats_add(struct jsdrv_host_stats_s * self, uint64_t sample_id,
+        const float * i, const float * v, const float * p, uint32_t count,
+        struct jsdrv_statistics_s ** stats);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_HOST_STATS_H_ */
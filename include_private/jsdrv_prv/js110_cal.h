@@ -54,6 +54,36 @@ struct js110_cal_header_s {
  */
 int32_t js110_cal_parse(const uint8_t * data, double cal[2][2][9]);
 
+/// The maximum calibration record size accepted from the device or cache.
+#define JS110_CAL_LENGTH_MAX (1024U * 1024U)
+
+/**
+ * @brief Load a calibration record from the on-disk cache.
+ *
+ * @param path The cache directory.
+ * @param serial_number The device serial number.
+ * @param hdr The calibration header read from the device.
+ * @param[out] data The calibration record, including the header.
+ *      The caller must jsdrv_free() this buffer on success.
+ * @return 0 or JSDRV_ERROR_NOT_FOUND when the cache does not hold
+ *      a record that matches hdr.
+ *
+ * The cache entry is keyed by serial_number and the header crc32.
+ * The length, version and crc32 must all match hdr.
+ */
+int32_t js110_cal_cache_load(const char * path, const char * serial_number,
+                             const struct js110_cal_header_s * hdr, uint8_t ** data);
+
+/**
+ * @brief Save a calibration record to the on-disk cache.
+ *
+ * @param path The cache directory, which must exist.
+ * @param serial_number The device serial number.
+ * @param data The calibration record, including the header.
+ * @return 0 or error code.
+ */
+int32_t js110_cal_cache_save(const char * path, const char * serial_number, const uint8_t * data);
+
 
 JSDRV_CPP_GUARD_END
 
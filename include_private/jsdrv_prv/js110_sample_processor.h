@@ -57,6 +57,16 @@ struct js110_sample_s {
     uint8_t reserved_u8;
 };
 
+/// The js110_sp_process_block() output arrays, each with at least count entries.
+struct js110_sp_block_s {
+    float * i;
+    float * v;
+    float * p;
+    uint8_t * current_range;
+    uint8_t * gpi0;
+    uint8_t * gpi1;
+};
+
 struct js110_sp_s {
     double cal[2][2][9];  // current/voltage, offset/gain
 
@@ -95,6 +105,23 @@ void js110_sp_reset(struct js110_sp_s * self);
 
 struct js110_sample_s js110_sp_process(struct js110_sp_s * self, uint32_t sample_u32, uint8_t v_range);
 
+/**
+ * @brief Process a block of raw samples.
+ *
+ * @param self The sample processor instance.
+ * @param samples The raw samples.
+ * @param count The number of samples.
+ * @param v_range The voltage range for all samples.
+ * @param[out] dst The output arrays, which receive count entries.
+ *
+ * The output is identical to calling js110_sp_process() on each sample.
+ * Runs of valid samples with the same current range outside of a
+ * suppression window calibrate in a tight loop directly into dst.
+ * Range transitions and missing samples use the per-sample path.
+ */
+void js110_sp_process_block(struct js110_sp_s * self, const uint32_t * samples, uint32_t count,
+                            uint8_t v_range, struct js110_sp_block_s * dst);
+
 int32_t js110_sp_suppress_win(struct js110_sp_s * self, uint8_t window);
 
 JSDRV_CPP_GUARD_END
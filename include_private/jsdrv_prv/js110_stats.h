@@ -95,6 +95,28 @@ void js110_stats_sample_count_set(struct js110_stats_s * self, uint32_t sample_c
  */
 struct jsdrv_statistics_s * js110_stats_compute(struct js110_stats_s * self, float i, float v, float p);
 
+/**
+ * @brief Compute statistics over a block of samples.
+ *
+ * @param self[in] The stats instance.
+ * @param i The current samples in A.
+ * @param v The voltage samples in V.
+ * @param p The power samples in W.
+ * @param count The number of samples.
+ * @param stats[out] NULL or the statistics structure when the consumed
+ *      samples complete a statistics block.  The structure remains valid
+ *      until the next compute call with self.
+ * @return The number of samples consumed, which stops at the end of each
+ *      statistics block.  Call again with the remaining samples.
+ *
+ * The result is bit-identical to calling js110_stats_compute() for each
+ * sample.  The sum of squares accumulates exactly in 64-bit partial sums
+ * that promote to 128-bit once per chunk rather than once per sample.
+ */
+uint32_t js110_stats_compute_block(struct js110_stats_s * self,
+        const float * i, const float * v, const float * p, uint32_t count,
+        struct jsdrv_statistics_s ** stats);
+
 
 JSDRV_CPP_GUARD_END
 
@@ -24,6 +24,7 @@
 #include "js220_api.h"
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifndef JSDRV_JS220_I128_MATH_H__
 #define JSDRV_JS220_I128_MATH_H__
@@ -34,25 +35,182 @@
  *
  * @brief Perform i128 math.
  *
+ * The core operations are static inline so that the statistics
+ * computations inline them.  GCC and clang use __int128, MSVC x64 uses
+ * the _addcarry_u64, _umul128 and _udiv128 intrinsics, and all other
+ * targets use portable 64-bit math.  Define JS220_I128_PORTABLE to force
+ * the portable implementation.
+ *
  * @{
  */
 
+#if defined(JS220_I128_PORTABLE)
+#define JS220_I128_IMPL_PORTABLE 1
+#elif defined(__clang__) || defined(__GNUC__)
+#define JS220_I128_IMPL_NATIVE 1
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define JS220_I128_IMPL_MSVC 1
+#include <intrin.h>
+#else
+#define JS220_I128_IMPL_PORTABLE 1
+#endif
 
 JSDRV_CPP_GUARD_START
 
-js220_i128 js220_i128_init_i64(int64_t a);
-js220_i128 js220_i128_add(js220_i128 a, js220_i128 b);
-js220_i128 js220_i128_sub(js220_i128 a, js220_i128 b);
-js220_i128 js220_i128_square_i64(int64_t a);
-js220_i128 js220_i128_neg(js220_i128 x);
-js220_i128 js220_i128_udiv(js220_i128 dividend, uint64_t divisor, uint64_t * remainder);
-js220_i128 js220_i128_lshift(js220_i128 x, int32_t shift);
-js220_i128 js220_i128_rshift(js220_i128 x, int32_t shift);
+static inline js220_i128 js220_i128_init_i64(int64_t a) {
+    js220_i128 r;
+    r.i64[0] = a;
+    r.i64[1] = (a >= 0) ? 0 : -1;
+    return r;
+}
+
+static inline js220_i128 js220_i128_add(js220_i128 a, js220_i128 b) {
+#if JS220_I128_IMPL_NATIVE
+    a.i128 = a.i128 + b.i128;
+    return a;
+#elif JS220_I128_IMPL_MSVC
+    js220_i128 r;
+    unsigned char c = _addcarry_u64(0, a.u64[0], b.u64[0], &r.u64[0]);
+    _addcarry_u64(c, a.u64[1], b.u64[1], &r.u64[1]);
+    return r;
+#else
+    js220_i128 r;
+    r.u64[0] = a.u64[0] + b.u64[0];
+    r.u64[1] = a.u64[1] + b.u64[1] + ((r.u64[0] < a.u64[0]) ? 1 : 0);
+    return r;
+#endif
+}
+
+static inline js220_i128 js220_i128_sub(js220_i128 a, js220_i128 b) {
+#if JS220_I128_IMPL_NATIVE
+    a.i128 = a.i128 - b.i128;
+    return a;
+#elif JS220_I128_IMPL_MSVC
+    js220_i128 r;
+    unsigned char c = _subborrow_u64(0, a.u64[0], b.u64[0], &r.u64[0]);
+    _subborrow_u64(c, a.u64[1], b.u64[1], &r.u64[1]);
+    return r;
+#else
+    js220_i128 r;
+    r.u64[0] = a.u64[0] - b.u64[0];
+    r.u64[1] = a.u64[1] - b.u64[1] - ((a.u64[0] < b.u64[0]) ? 1 : 0);
+    return r;
+#endif
+}
+
+static inline js220_i128 js220_i128_square_i64(int64_t a) {
+    js220_i128 r;
+#if JS220_I128_IMPL_NATIVE
+    r.i128 = a;
+    r.i128 = r.i128 * r.i128;
+#else
+    uint64_t u = (a < 0) ? (0 - (uint64_t) a) : (uint64_t) a;
+#if JS220_I128_IMPL_MSVC
+    r.u64[0] = _umul128(u, u, &r.u64[1]);
+#else
+    uint64_t lo = u & 0xffffffffU;
+    uint64_t hi = u >> 32;
+    uint64_t lo_lo = lo * lo;
+    uint64_t hi_lo = hi * lo;
+    uint64_t mid = (lo_lo >> 32) + ((hi_lo & 0xffffffffU) << 1);
+    r.u64[0] = (lo_lo & 0xffffffffU) | (mid << 32);
+    r.u64[1] = hi * hi + ((hi_lo >> 32) << 1) + (mid >> 32);
+#endif
+#endif
+    return r;
+}
+
+static inline js220_i128 js220_i128_neg(js220_i128 x) {
+#if JS220_I128_IMPL_NATIVE
+    x.i128 = -x.i128;
+#else
+    x.u64[1] = ~x.u64[1];
+    x.u64[0] = ~x.u64[0] + 1LLU;
+    if (0 == x.u64[0]) {
+        x.u64[1] += 1LLU;
+    }
+#endif
+    return x;
+}
+
+/**
+ * @brief Divide an unsigned 128-bit value.
+ *
+ * @param dividend The non-negative dividend.
+ * @param divisor The divisor.
+ * @param remainder[out] The remainder, or NULL to ignore.
+ * @return The quotient.
+ */
+static inline js220_i128 js220_i128_udiv(js220_i128 dividend, uint64_t divisor, uint64_t * remainder) {
+    js220_i128 result;
+    uint64_t r;
+#if JS220_I128_IMPL_NATIVE
+    __extension__ unsigned __int128 u = (__extension__ (unsigned __int128) dividend.i128);
+    __extension__ unsigned __int128 q = u / divisor;
+    result.i128 = (__extension__ (__int128) q);
+    r = (uint64_t) (u - (q * divisor));
+#else
+    result.u64[1] = dividend.u64[1] / divisor;
+    dividend.u64[1] -= result.u64[1] * divisor;
+#if JS220_I128_IMPL_MSVC
+    result.u64[0] = _udiv128(dividend.u64[1], dividend.u64[0], divisor, &r);
+#else
+    uint64_t q = 0;
+    r = dividend.u64[1];  // < divisor
+    for (int32_t i = 63; i >= 0; --i) {
+        uint64_t carry = r >> 63;
+        r = (r << 1) | ((dividend.u64[0] >> i) & 1);
+        q <<= 1;
+        if (carry || (r >= divisor)) {
+            r -= divisor;
+            q |= 1;
+        }
+    }
+    result.u64[0] = q;
+#endif
+#endif
+    if (NULL != remainder) {
+        *remainder = r;
+    }
+    return result;
+}
+
+/**
+ * @brief Shift a 128-bit value.
+ *
+ * @param x The value.
+ * @param shift The left shift amount in bits from -63 to 63.
+ *      Negative values perform a signed right shift.
+ * @return The shifted value.
+ */
+static inline js220_i128 js220_i128_lshift(js220_i128 x, int32_t shift) {
+    if (shift > 0) {
+        x.u64[1] = (x.u64[1] << shift) | (x.u64[0] >> (64 - shift));
+        x.u64[0] = x.u64[0] << shift;
+    } else if (0 == shift) {
+        // no operation
+    } else {  // right shift signed
+        shift = -shift;
+        x.u64[0] = (x.u64[0] >> shift) | (x.u64[1] << (64 - shift));
+        x.i64[1] = x.i64[1] >> shift;
+    }
+    return x;
+}
+
+static inline js220_i128 js220_i128_rshift(js220_i128 x, int32_t shift) {
+    return js220_i128_lshift(x, -shift);
+}
+
+static inline bool js220_i128_is_neg(js220_i128 x) {
+    return x.i64[1] < 0;
+}
+
 double js220_i128_to_f64(js220_i128 x, uint32_t q);
-bool js220_i128_is_neg(js220_i128 x);
 double js220_i128_compute_std(int64_t x1, js220_i128 x2, uint64_t n, uint32_t q);
 js220_i128 js220_i128_compute_integral(js220_i128 x, uint64_t n);
 
 JSDRV_CPP_GUARD_END
 
-#endif // JSDRV_JS220_I128_MATH_H__
\ No newline at end of file
+/** @} */
+
+#endif // JSDRV_JS220_I128_MATH_H__
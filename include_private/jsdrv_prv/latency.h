@@ -0,0 +1,160 @@
+/*
+* Copyright 2026 Jetperch LLC
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file
+ *
+ * @brief Stream message latency tracing.
+ */
+
+#ifndef JSDRV_PRV_LATENCY_H__
+#define JSDRV_PRV_LATENCY_H__
+
+#include "jsdrv/cmacro_inc.h"
+#include "jsdrv/time.h"
+#include "jsdrv_prv/perf.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_latency Latency tracing
+ *
+ * @brief Trace stream messages from USB completion to subscriber.
+ *
+ * The USB backend stamps each bulk in message at completion, the
+ * upper-level device copies that stamp into each stream message
+ * and stamps the send, pubsub stamps the dispatch, and the external
+ * subscriber call completes the trace.  All stamps use
+ * jsdrv_time_monotonic().  Each stage accumulates into a process-wide,
+ * log-linear histogram with 8 bins per octave, and the frontend
+ * publishes the percentiles under JSDRV_MSG_LATENCY.
+ *
+ * Stamping shares JSDRV_PERF_ENABLE with the performance counters.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+struct jsdrvp_msg_s;
+
+/// The latency stages.
+enum jsdrv_latency_stage_e {
+    JSDRV_LATENCY_DECODE,       ///< USB completion to device send, includes message batching.
+    JSDRV_LATENCY_QUEUE,        ///< Device send to pubsub dispatch.
+    JSDRV_LATENCY_DELIVER,      ///< Pubsub dispatch to subscriber callback.
+    JSDRV_LATENCY_TOTAL,        ///< USB completion to subscriber callback.
+    JSDRV_LATENCY_STAGE_COUNT,  ///< The number of stages.
+};
+
+/// The number of histogram bins, which span 0 us to 2**32 us.
+#define JSDRV_LATENCY_BINS (240U)
+
+/// The histogram storage, indexed by jsdrv_latency_stage_e.
+extern volatile uint64_t jsdrv_latency_bins[JSDRV_LATENCY_STAGE_COUNT][JSDRV_LATENCY_BINS];
+
+#if JSDRV_PERF_ENABLE
+#define JSDRV_LATENCY_STAMP(t)      (t) = jsdrv_time_monotonic()
+#else
+#define JSDRV_LATENCY_STAMP(t)
+#endif
+
+/**
+ * @brief Get the stage name.
+ *
+ * @param stage The jsdrv_latency_stage_e identifier.
+ * @return The topic subtopic name, or NULL if stage is invalid.
+ */
+const char * jsdrv_latency_stage_name(uint32_t stage);
+
+/**
+ * @brief Get the histogram bin for a duration.
+ *
+ * @param us The duration in microseconds.
+ * @return The bin index.  Durations under 16 us have one bin
+ *      per microsecond, and longer durations have 8 bins per octave.
+ */
+uint32_t jsdrv_latency_bin(uint64_t us);
+
+/**
+ * @brief Get the duration represented by a histogram bin.
+ *
+ * @param bin The bin index.
+ * @return The largest duration in microseconds that maps to bin.
+ */
+uint64_t jsdrv_latency_bin_value(uint32_t bin);
+
+/**
+ * @brief Add a duration to a stage histogram.
+ *
+ * @param stage The jsdrv_latency_stage_e identifier.
+ * @param duration The duration in jsdrv time units.  Negative
+ *      durations count as 0.
+ */
+void jsdrv_latency_add(uint32_t stage, int64_t duration);
+
+/**
+ * @brief Copy a stage histogram.
+ *
+ * @param stage The jsdrv_latency_stage_e identifier.
+ * @param bins The JSDRV_LATENCY_BINS output counts.
+ * @return The total count, or 0 if stage is invalid.
+ */
+uint64_t jsdrv_latency_get(uint32_t stage, uint64_t * bins);
+
+/**
+ * @brief Compute a percentile from a histogram.
+ *
+ * @param bins The JSDRV_LATENCY_BINS counts.
+ * @param ppt The percentile in parts per thousand, such as 999 for p99.9.
+ * @return The duration in microseconds, from jsdrv_latency_bin_value(),
+ *      or 0 if the histogram is empty.
+ */
+uint64_t jsdrv_latency_percentile(const uint64_t * bins, uint32_t ppt);
+
+/// Reset all histograms to zero and disable the trailer.
+void jsdrv_latency_reset(void);
+
+/**
+ * @brief Enable the stream message latency trailer.
+ *
+ * @param enable True to append struct jsdrv_stream_latency_s
+ *      to stream messages at dispatch.
+ */
+void jsdrv_latency_trailer_set(bool enable);
+
+/**
+ * @brief Record the dispatch of a stream message.
+ *
+ * @param msg The stream message.  Messages without a USB stamp are
+ *      ignored.  When enabled, also appends the trailer.
+ */
+void jsdrv_latency_dispatch(struct jsdrvp_msg_s * msg);
+
+/**
+ * @brief Record the delivery of a stream message to a subscriber.
+ *
+ * @param msg The stream message.  Messages without a USB stamp are
+ *      ignored.
+ */
+void jsdrv_latency_deliver(const struct jsdrvp_msg_s * msg);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_LATENCY_H__ */
@@ -92,6 +92,22 @@ JSDRV_CPP_GUARD_START
  */
 void jsdrv_log_publish(uint8_t level, const char * filename, uint32_t line, const char * format, ...);
 
+/**
+ * @brief Publish a log message with a static format string.
+ *
+ * @param level The fbp_log_level_e.
+ * @param filename The source filename, which must have static storage.
+ * @param line The source line in filename.
+ * @param format The printf-compatible format specification, which must
+ *      have static storage.
+ * @param ... The formatting arguments.
+ *
+ * Identical to jsdrv_log_publish(), except that formatting occurs on
+ * the log thread when jsdrv_log_deferred_set() is enabled.
+ * This implementation is thread safe.
+ */
+void jsdrv_log_publish_static(uint8_t level, const char * filename, uint32_t line, const char * format, ...);
+
 /**
  * @brief The printf-style variadic arguments define to handle log messages.
  *
@@ -100,7 +116,7 @@ void jsdrv_log_publish(uint8_t level, const char * filename, uint32_t line, cons
  * @param ... The arguments for the formatting string
  */
 #define JSDRV_LOG_PRINTF(level, format, ...) \
-    jsdrv_log_publish(level, __FILENAME__, __LINE__, format, __VA_ARGS__)
+    jsdrv_log_publish_static(level, __FILENAME__, __LINE__, format, __VA_ARGS__)
 
 
 /** Detailed messages for the software developer. */
@@ -133,6 +149,25 @@ extern char const jsdrv_log_level_char[JSDRV_LOG_LEVEL_ALL + 1];
  */
 #define JSDRV_LOG_LEVEL_CHECK(level, cfg_level) (level <= cfg_level)
 
+/**
+ * @brief The active runtime log level.
+ *
+ * Use JSDRV_LOG_ENABLED() rather than accessing this directly.
+ * Set with jsdrv_log_level_set().
+ */
+extern volatile int8_t jsdrv_log_level_;
+
+/**
+ * @brief Check a log level against the static and runtime configuration.
+ *
+ * @param level The level to query.
+ * @return True if a message at level will be published.
+ *
+ * Use this check to skip costly argument formatting, such as
+ * jsdrv_union_value_to_str(), for messages that would be discarded.
+ */
+#define JSDRV_LOG_ENABLED(level) (JSDRV_LOG_CHECK_STATIC(level) && ((level) <= jsdrv_log_level_))
+
 /*!
  * \brief Macro to log a printf-compatible formatted string.
  *
@@ -141,12 +176,70 @@ extern char const jsdrv_log_level_char[JSDRV_LOG_LEVEL_ALL + 1];
  * \param ... The arguments to the formatting string.
  */
 #define JSDRV_LOG(level, format, ...) do {            \
-    if (JSDRV_LOG_CHECK_STATIC(level)) {              \
+    if (JSDRV_LOG_ENABLED(level)) {                   \
         JSDRV_LOG_PRINTF(level, format, __VA_ARGS__); \
     }                                               \
 } while (0)
 
 
+/// The JSDRV_LOG_RATE() interval in milliseconds.
+#define JSDRV_LOG_RATE_INTERVAL_MS (1000)
+
+/// The JSDRV_LOG_RATE() messages per call site and interval before suppression.
+#define JSDRV_LOG_RATE_BURST (5)
+
+/**
+ * @brief The per call site state for JSDRV_LOG_RATE().
+ *
+ * Only JSDRV_LOG_RATE() should define instances, which have static storage.
+ */
+struct jsdrv_log_rate_s {
+    uint8_t level;                  ///< The jsdrv_log_level_e.
+    uint32_t line;                  ///< The source line.
+    const char * filename;          ///< The source filename, static storage.
+    const char * format;            ///< The format string, static storage.
+    volatile int32_t registered;    ///< Nonzero once added to the summary list.
+    volatile int32_t start_ms;      ///< The jsdrv_time_ms_u32() for the current interval.
+    volatile int32_t count;         ///< The messages in the current interval.
+    volatile int32_t suppressed;    ///< The suppressed messages not yet summarized.
+    uint32_t summary_ms;            ///< The last summary time, log thread only.
+};
+
+/**
+ * @brief Check a JSDRV_LOG_RATE() call site.
+ *
+ * @param self The call site.
+ * @return True to publish the message, false to suppress it.
+ *
+ * This function is thread safe and does not lock.  The log thread
+ * publishes the count of suppressed messages for each call site at
+ * most once per JSDRV_LOG_RATE_INTERVAL_MS, and on jsdrv_log_finalize().
+ */
+bool jsdrv_log_rate_allow(struct jsdrv_log_rate_s * self);
+
+/**
+ * @brief Log a printf-compatible formatted string with a rate limit.
+ *
+ * @param level The jsdrv_log_level_e, a constant.
+ * @param format The printf-compatible formatting string literal.
+ * @param ... The arguments to the formatting string.
+ *
+ * Each call site publishes at most JSDRV_LOG_RATE_BURST messages
+ * per JSDRV_LOG_RATE_INTERVAL_MS and counts the remainder, which the
+ * log thread later publishes as a single summary message.  Use for
+ * messages that may repeat for every frame or transfer, such as
+ * stream skips during a USB disruption.
+ */
+#define JSDRV_LOG_RATE(level, format, ...) do {                         \
+    if (JSDRV_LOG_ENABLED(level)) {                                     \
+        static struct jsdrv_log_rate_s jsdrv_log_rate_site_ = {         \
+            (level), __LINE__, __FILENAME__, (format), 0, 0, 0, 0, 0};  \
+        if (jsdrv_log_rate_allow(&jsdrv_log_rate_site_)) {              \
+            JSDRV_LOG_PRINTF(level, format, __VA_ARGS__);               \
+        }                                                               \
+    }                                                                   \
+} while (0)
+
 #ifdef _MSC_VER
 /* Microsoft Visual Studio compiler support */
 /** Log a emergency using printf-style arguments. */
@@ -169,6 +262,12 @@ extern char const jsdrv_log_level_char[JSDRV_LOG_LEVEL_ALL + 1];
 #define JSDRV_LOG_DEBUG2(format, ...)    JSDRV_LOG(JSDRV_LOG_LEVEL_DEBUG2,  format, __VA_ARGS__)
 /** Log an insanely detailed debug message using printf-style arguments. */
 #define JSDRV_LOG_DEBUG3(format, ...)    JSDRV_LOG(JSDRV_LOG_LEVEL_DEBUG3,  format, __VA_ARGS__)
+/** Log an error with the JSDRV_LOG_RATE() limit. */
+#define JSDRV_LOGE_RATE(format, ...)     JSDRV_LOG_RATE(JSDRV_LOG_LEVEL_ERROR, format, __VA_ARGS__)
+/** Log a warning with the JSDRV_LOG_RATE() limit. */
+#define JSDRV_LOGW_RATE(format, ...)     JSDRV_LOG_RATE(JSDRV_LOG_LEVEL_WARNING, format, __VA_ARGS__)
+/** Log an informative message with the JSDRV_LOG_RATE() limit. */
+#define JSDRV_LOGI_RATE(format, ...)     JSDRV_LOG_RATE(JSDRV_LOG_LEVEL_INFO, format, __VA_ARGS__)
 
 #else
 /* GCC compiler support */
@@ -200,6 +299,17 @@ extern char const jsdrv_log_level_char[JSDRV_LOG_LEVEL_ALL + 1];
 #define JSDRV_LOG_DEBUG2(...)    _JSDRV_LOG_DISPATCH(JSDRV_LOG_LEVEL_DEBUG2,  __VA_ARGS__)
 /** Log an insanely detailed debug message using printf-style arguments. */
 #define JSDRV_LOG_DEBUG3(...)    _JSDRV_LOG_DISPATCH(JSDRV_LOG_LEVEL_DEBUG3,  __VA_ARGS__)
+
+#define _JSDRV_LOG_RATE_1(level, message) JSDRV_LOG_RATE(level, "%s", message)
+#define _JSDRV_LOG_RATE_N(level, format, ...) JSDRV_LOG_RATE(level, format, __VA_ARGS__)
+#define _JSDRV_LOG_RATE_DISPATCH(level, ...)  _JSDRV_LOG_SELECT(_JSDRV_LOG_RATE, __VA_ARGS__, N, N, N, N, N, N, N, N, N, N, 1, 0)(level, __VA_ARGS__)
+
+/** Log an error with the JSDRV_LOG_RATE() limit. */
+#define JSDRV_LOGE_RATE(...)     _JSDRV_LOG_RATE_DISPATCH(JSDRV_LOG_LEVEL_ERROR, __VA_ARGS__)
+/** Log a warning with the JSDRV_LOG_RATE() limit. */
+#define JSDRV_LOGW_RATE(...)     _JSDRV_LOG_RATE_DISPATCH(JSDRV_LOG_LEVEL_WARNING, __VA_ARGS__)
+/** Log an informative message with the JSDRV_LOG_RATE() limit. */
+#define JSDRV_LOGI_RATE(...)     _JSDRV_LOG_RATE_DISPATCH(JSDRV_LOG_LEVEL_INFO, __VA_ARGS__)
 #endif
 
 /** Log an error using printf-style arguments.  Alias for JSDRV_LOG_ERROR. */
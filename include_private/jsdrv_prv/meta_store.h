@@ -0,0 +1,116 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * @file
+ *
+ * @brief Interned, precompiled metadata shared between topics.
+ */
+
+#ifndef JSDRV_PRV_META_STORE_H_
+#define JSDRV_PRV_META_STORE_H_
+
+#include "jsdrv/cmacro_inc.h"
+#include "jsdrv/meta.h"
+#include "jsdrv_prv/list.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_meta_store Metadata store
+ *
+ * @brief Deduplicate metadata JSON by content.
+ *
+ * Each device instance publishes the same metadata for every parameter,
+ * so identical devices repeat the same JSON strings.  The store keeps a
+ * single immutable copy of each distinct JSON string along with its
+ * compiled jsdrv_meta_schema_s.  Topics hold a reference to the entry.
+ * Interning metadata that is already present only costs a hash and a
+ * compare, and skips the JSON parse.
+ *
+ * The store is not thread-safe.  The pubsub instance owns it.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+#ifndef JSDRV_META_STORE_BUCKETS
+/// The number of content hash buckets, a power of 2.
+#define JSDRV_META_STORE_BUCKETS (256U)
+#endif
+
+/// An immutable, interned metadata entry.
+struct jsdrv_meta_entry_s {
+    struct jsdrv_list_s item;               ///< The bucket list item, private.
+    uint32_t hash;                          ///< The content hash of json.
+    uint32_t refcnt;                        ///< The reference count, private.
+    uint32_t size;                          ///< The json size including the terminator.
+    struct jsdrv_meta_schema_s schema;      ///< The schema compiled from json.
+    char json[];                            ///< The JSON metadata string.
+};
+
+/// The opaque store instance.
+struct jsdrv_meta_store_s;
+
+/**
+ * @brief Allocate a new, empty store.
+ *
+ * @return The new instance.
+ */
+struct jsdrv_meta_store_s * jsdrv_meta_store_alloc(void);
+
+/**
+ * @brief Free a store and all remaining entries.
+ *
+ * @param self The instance from jsdrv_meta_store_alloc() or NULL.
+ */
+void jsdrv_meta_store_free(struct jsdrv_meta_store_s * self);
+
+/**
+ * @brief Get the entry for metadata, adding it when needed.
+ *
+ * @param self The instance.
+ * @param json The JSON metadata string.
+ * @return The retained entry.  Call jsdrv_meta_store_release() when done.
+ *
+ * New entries copy json and compile the schema.  Invalid metadata still
+ * produces an entry whose schema.status holds the compile error.
+ */
+const struct jsdrv_meta_entry_s * jsdrv_meta_store_intern(struct jsdrv_meta_store_s * self, const char * json);
+
+/**
+ * @brief Release an entry from jsdrv_meta_store_intern().
+ *
+ * @param self The instance.
+ * @param entry The entry or NULL.  The last release frees the entry.
+ */
+void jsdrv_meta_store_release(struct jsdrv_meta_store_s * self, const struct jsdrv_meta_entry_s * entry);
+
+/**
+ * @brief Get the number of distinct entries.
+ *
+ * @param self The instance.
+ * @return The number of entries.
+ */
+uint32_t jsdrv_meta_store_count(struct jsdrv_meta_store_s * self);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_META_STORE_H_ */
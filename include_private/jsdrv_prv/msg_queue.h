@@ -39,23 +39,122 @@ JSDRV_CPP_GUARD_START
 // opaque handle
 struct msg_queue_s;
 
-// forward declaration for "jsdrv/frontend.h"
+// forward declarations for "jsdrv/frontend.h" and "jsdrv_prv/list.h"
 struct jsdrvp_msg_s;
+struct jsdrv_list_s;
 
 struct msg_queue_s * msg_queue_init(void);
 
+/// The default capacity for msg_queue_init_spsc().
+#define MSG_QUEUE_SPSC_CAPACITY_DEFAULT (256U)
+
+/**
+ * @brief Initialize a single-producer, single-consumer message queue.
+ *
+ * @param capacity The lock-free ring capacity, rounded up to a power of 2.
+ * @return The new queue or NULL.
+ *
+ * At any time, at most one thread may push and at most one thread
+ * may pop.  Push and pop do not lock, and the event is only signalled
+ * on the empty to non-empty transition.  When the ring is full,
+ * push falls back to a locked overflow list, so push never fails.
+ */
+struct msg_queue_s * msg_queue_init_spsc(uint32_t capacity);
+
+/// The message queue lanes, see msg_queue_lanes_enable() and msg_queue_qos_enable().
+enum msg_queue_lane_e {
+    MSG_QUEUE_LANE_CONTROL = 0,     ///< Control, return code and metadata messages.
+    MSG_QUEUE_LANE_DATA = 1,        ///< Stream data messages.
+    MSG_QUEUE_LANE_CRITICAL = 2,    ///< Data lane messages with JSDRVP_QOS_CRITICAL.
+    MSG_QUEUE_LANE_BACKGROUND = 3,  ///< Data lane messages with JSDRVP_QOS_BACKGROUND.
+    MSG_QUEUE_LANE_COUNT = 4,
+};
+
+/**
+ * @brief Give control messages priority over data messages.
+ *
+ * @param queue The queue, before the first push.
+ *
+ * The control lane holds return codes, metadata, USB control
+ * transfer responses, the open responses and the direct API values,
+ * JSDRVP_MSG_SOURCE_DIRECT, so that each value precedes its device
+ * return code.  All other messages use
+ * the data lane, including JSDRV_MSG_TYPE_DATA, USB stream in data,
+ * and the messages that must remain ordered with the data, such
+ * as trigger events, close and JSDRV_MSG_FINALIZE.  Pop returns
+ * control lane messages first.  Each lane remains FIFO, but messages
+ * no longer keep their order across lanes.
+ */
+void msg_queue_lanes_enable(struct msg_queue_s * queue);
+
+/**
+ * @brief Order the data lane by the message QoS.
+ * @param queue The queue, before the first push.
+ * Messages that would use the data lane select the critical, data
+ * or background lane from jsdrvp_msg_s.qos.  Pop returns control,
+ * critical, data and then background lane messages.  Devices assign
+ * the same QoS to all of their messages, so each device remains FIFO.
+ * Changing a device QoS lets its new messages overtake the messages
+ * already queued at the previous QoS.
+ */
+void msg_queue_qos_enable(struct msg_queue_s * queue);
+
+/**
+ * @brief Get the number of messages in a lane.
+ *
+ * @param queue The queue.
+ * @param lane The msg_queue_lane_e.
+ * @return The approximate number of messages in the lane, which is
+ *      always 0 for queues without lanes.
+ */
+uint32_t msg_queue_depth(struct msg_queue_s * queue, uint8_t lane);
+
 void msg_queue_finalize(struct msg_queue_s * queue);
 
 bool msg_queue_is_empty(struct msg_queue_s* queue);
 
 void msg_queue_push(struct msg_queue_s * queue, struct jsdrvp_msg_s * msg);
 
+/**
+ * @brief Push a list of messages.
+ *
+ * @param queue The queue.
+ * @param list The list of jsdrvp_msg_s items, which is empty on return.
+ *
+ * For locked queues, all messages are added under a single lock
+ * with one event signal.
+ */
+void msg_queue_push_list(struct msg_queue_s * queue, struct jsdrv_list_s * list);
+
 struct jsdrvp_msg_s * msg_queue_pop_immediate(struct msg_queue_s* queue);
 
 int32_t msg_queue_pop(struct msg_queue_s* queue, struct jsdrvp_msg_s ** msg, uint32_t timeout_ms);
 
 msg_handle msg_queue_handle_get(struct msg_queue_s* queue);
 
+/**
+ * @brief The function called when a queue becomes non-empty.
+ *
+ * @param user_data The arbitrary user data.
+ */
+typedef void (*msg_queue_notify_fn)(void * user_data);
+
+/**
+ * @brief Set the function to call along with the event signal.
+ *
+ * @param queue The queue.
+ * @param fn The function called from the pushing thread, or NULL to clear.
+ *      The function must not push to this queue.
+ * @param user_data The arbitrary data for fn.
+ *
+ * The notification lets an executor schedule the consumer without
+ * a thread blocked on msg_queue_handle_get().  Like the event, SPSC
+ * queues only notify on the empty to non-empty transition.  When
+ * this function returns NULL fn, no call to the previous fn is in
+ * progress, so user_data may be freed.
+ */
+void msg_queue_notify_set(struct msg_queue_s * queue, msg_queue_notify_fn fn, void * user_data);
+
 JSDRV_CPP_GUARD_END
 
 #endif  /* JSDRV_MSG_QUEUE_H_ */
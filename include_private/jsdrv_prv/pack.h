@@ -0,0 +1,137 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Convert and summarize sub-byte stream data.
+ */
+
+#ifndef JSDRV_PRV_PACK_H__
+#define JSDRV_PRV_PACK_H__
+
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_pack Sub-byte packing
+ *
+ * @brief Convert one sample per byte to and from the u4 and u1 stream formats.
+ *
+ * The stream formats store the first sample in the least significant
+ * bits of each byte.  The kernels use SSE2 or NEON when available and
+ * 64-bit word operations otherwise, 16 to 64 samples at a time.
+ * The sum kernels compute the summary statistics directly from the
+ * packed samples.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The accumulated statistics for jsdrv_sum_u4() and jsdrv_sum_u1().
+struct jsdrv_u_sum_s {
+    uint64_t x1;    ///< The sum of the samples.
+    uint64_t x2;    ///< The sum of the squared samples.
+    uint8_t min;    ///< The minimum sample, 0xff when empty.
+    uint8_t max;    ///< The maximum sample, 0 when empty.
+};
+
+/**
+ * @brief Pack samples into 4-bit nibbles.
+ *
+ * @param y The output array with space for (n + 1) / 2 bytes.
+ * @param x The input samples, one per byte.  Only the lower
+ *      4 bits of each sample are used.
+ * @param n The number of samples.
+ *
+ * For odd n, the upper nibble of the last output byte is 0.
+ */
+void jsdrv_pack_u4(uint8_t * y, const uint8_t * x, uint32_t n);
+
+/**
+ * @brief Pack samples into bits.
+ *
+ * @param y The output array with space for (n + 7) / 8 bytes.
+ * @param x The input samples, one per byte.  Only the least
+ *      significant bit of each sample is used.
+ * @param n The number of samples.
+ *
+ * When n is not a multiple of 8, the unused upper bits of the
+ * last output byte are 0.
+ */
+void jsdrv_pack_u1(uint8_t * y, const uint8_t * x, uint32_t n);
+
+/**
+ * @brief Unpack 4-bit nibbles into samples.
+ *
+ * @param y The output array with space for n samples, one per byte.
+ * @param x The packed input with (n + 1) / 2 bytes.
+ * @param n The number of samples, which may be odd.
+ */
+void jsdrv_unpack_u4(uint8_t * y, const uint8_t * x, uint32_t n);
+
+/**
+ * @brief Unpack bits into samples.
+ *
+ * @param y The output array with space for n samples, each 0 or 1.
+ * @param x The packed input with (n + 7) / 8 bytes.
+ * @param n The number of samples.
+ */
+void jsdrv_unpack_u1(uint8_t * y, const uint8_t * x, uint32_t n);
+
+/**
+ * @brief Reset the accumulated statistics.
+ *
+ * @param s The statistics to reset.
+ */
+void jsdrv_u_sum_reset(struct jsdrv_u_sum_s * s);
+
+/**
+ * @brief Accumulate the statistics of packed 4-bit samples.
+ *
+ * @param s The statistics to update.
+ * @param x The packed input.
+ * @param offset The index of the first sample in x, which may be odd.
+ * @param n The number of samples.
+ */
+void jsdrv_sum_u4(struct jsdrv_u_sum_s * s, const uint8_t * x, uint64_t offset, uint64_t n);
+
+/**
+ * @brief Accumulate the statistics of packed 1-bit samples.
+ *
+ * @param s The statistics to update.
+ * @param x The packed input.
+ * @param offset The index of the first sample in x, which may be any bit.
+ * @param n The number of samples.
+ *
+ * The sum is the population count, which also equals the sum of squares.
+ */
+void jsdrv_sum_u1(struct jsdrv_u_sum_s * s, const uint8_t * x, uint64_t offset, uint64_t n);
+
+/**
+ * @brief Get the name of the compiled kernel implementation.
+ *
+ * @return One of "sse2", "neon" or "scalar".
+ */
+const char * jsdrv_pack_impl(void);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_PACK_H__ */
@@ -0,0 +1,172 @@
+/*
+* Copyright 2026 Jetperch LLC
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+/**
+ * @file
+ *
+ * @brief Hot-path performance counters.
+ */
+
+#ifndef JSDRV_PRV_PERF_H__
+#define JSDRV_PRV_PERF_H__
+
+#include "jsdrv/cmacro_inc.h"
+#include "jsdrv_prv/platform.h"
+#include <stdint.h>
+
+#if _WIN32
+#include <windows.h>
+#endif
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_perf Performance counters
+ *
+ * @brief Count hot-path events with a relaxed atomic per event.
+ *
+ * The counters are process-wide and monotonic.  The frontend
+ * publishes them under JSDRV_MSG_PERF.  Build with
+ * JSDRV_PERF_ENABLE=0 to remove all instrumentation.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+#ifndef JSDRV_PERF_ENABLE
+#define JSDRV_PERF_ENABLE (1)
+#endif
+
+/// The performance counter identifiers.
+enum jsdrv_perf_e {
+    JSDRV_PERF_USB_XFER,        ///< USB bulk in transfers completed.
+    JSDRV_PERF_USB_RX,          ///< USB bulk in bytes received.
+    JSDRV_PERF_LOAN_0,          ///< Bulk in buffer loan time < 16 us.
+    JSDRV_PERF_LOAN_1,          ///< Bulk in buffer loan time < 64 us.
+    JSDRV_PERF_LOAN_2,          ///< Bulk in buffer loan time < 256 us.
+    JSDRV_PERF_LOAN_3,          ///< Bulk in buffer loan time < 1 ms.
+    JSDRV_PERF_LOAN_4,          ///< Bulk in buffer loan time < 4 ms.
+    JSDRV_PERF_LOAN_5,          ///< Bulk in buffer loan time < 16 ms.
+    JSDRV_PERF_LOAN_6,          ///< Bulk in buffer loan time < 64 ms.
+    JSDRV_PERF_LOAN_7,          ///< Bulk in buffer loan time >= 64 ms.
+    JSDRV_PERF_BACKEND_MAX,     ///< Maximum backend messages drained in one frontend wake.
+    JSDRV_PERF_BACKEND_CONTROL_MAX,  ///< Maximum backend control lane depth at frontend wake.
+    JSDRV_PERF_BACKEND_DATA_MAX,     ///< Maximum backend data lane depth at frontend wake.
+    JSDRV_PERF_PUBSUB_MSG,      ///< Messages processed by pubsub.
+    JSDRV_PERF_PUBSUB_TIME,     ///< Pubsub message processing time.
+    JSDRV_PERF_DATA_MSG,        ///< Stream data messages published.
+    JSDRV_PERF_BUF_TIME,        ///< Buffer signal insert time.
+    JSDRV_PERF_DS_TIME,         ///< Downsample filter time.
+    JSDRV_PERF_QUERY_CACHED,    ///< jsdrv_query() served from the retained value cache.
+    JSDRV_PERF_PUBLISH_DIRECT,  ///< jsdrv_publish() sent directly to the device command queue.
+    JSDRV_PERF_COUNT,           ///< The number of counters.
+};
+
+/// The counter storage, indexed by jsdrv_perf_e.
+extern volatile uint64_t jsdrv_perf_counters[JSDRV_PERF_COUNT];
+
+/**
+ * @brief Get the counter name.
+ *
+ * @param id The jsdrv_perf_e counter identifier.
+ * @return The topic subtopic name, or NULL if id is invalid.
+ */
+const char * jsdrv_perf_name(uint32_t id);
+
+/**
+ * @brief Get the counter value.
+ *
+ * @param id The jsdrv_perf_e counter identifier.
+ * @return The current value.  Time counters are in microseconds.
+ */
+uint64_t jsdrv_perf_get(uint32_t id);
+
+/// Reset all counters to zero.
+void jsdrv_perf_reset(void);
+
+/**
+ * @brief Add to a counter.
+ *
+ * @param id The jsdrv_perf_e counter identifier.
+ * @param value The value to add.
+ */
+JSDRV_INLINE_FN void jsdrv_perf_add(uint32_t id, uint64_t value) {
+#if _WIN32
+    InterlockedExchangeAdd64((volatile LONG64 *) &jsdrv_perf_counters[id], (LONG64) value);
+#else
+    __atomic_fetch_add(&jsdrv_perf_counters[id], value, __ATOMIC_RELAXED);
+#endif
+}
+
+/**
+ * @brief Raise a counter to at least value.
+ *
+ * @param id The jsdrv_perf_e counter identifier.
+ * @param value The candidate maximum.
+ */
+JSDRV_INLINE_FN void jsdrv_perf_max(uint32_t id, uint64_t value) {
+#if _WIN32
+    volatile LONG64 * p = (volatile LONG64 *) &jsdrv_perf_counters[id];
+    LONG64 v = *p;
+    while ((uint64_t) v < value) {
+        LONG64 prev = InterlockedCompareExchange64(p, (LONG64) value, v);
+        if (prev == v) {
+            break;
+        }
+        v = prev;
+    }
+#else
+    uint64_t v = __atomic_load_n(&jsdrv_perf_counters[id], __ATOMIC_RELAXED);
+    while ((v < value) && !__atomic_compare_exchange_n(&jsdrv_perf_counters[id], &v, value,
+            true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        ;
+    }
+#endif
+}
+
+/**
+ * @brief Add a duration to the JSDRV_PERF_LOAN_* histogram.
+ *
+ * @param duration The duration in jsdrv_time_utc() units.
+ */
+JSDRV_INLINE_FN void jsdrv_perf_loan(int64_t duration) {
+    int64_t us = (duration * 1000000LL) >> 30;
+    uint32_t idx = 0;
+    for (int64_t limit = 16; (us >= limit) && (idx < 7); limit *= 4) {
+        ++idx;
+    }
+    jsdrv_perf_add(JSDRV_PERF_LOAN_0 + idx, 1);
+}
+
+#if JSDRV_PERF_ENABLE
+#define JSDRV_PERF_ADD(id, value)       jsdrv_perf_add((id), (value))
+#define JSDRV_PERF_MAX(id, value)       jsdrv_perf_max((id), (value))
+#define JSDRV_PERF_LOAN(duration)       jsdrv_perf_loan(duration)
+#define JSDRV_PERF_TIME_START(name)     int64_t name = jsdrv_time_utc()
+#define JSDRV_PERF_TIME_END(id, name)   jsdrv_perf_add((id), (uint64_t) (jsdrv_time_utc() - (name)))
+#else
+#define JSDRV_PERF_ADD(id, value)
+#define JSDRV_PERF_MAX(id, value)
+#define JSDRV_PERF_LOAN(duration)
+#define JSDRV_PERF_TIME_START(name)
+#define JSDRV_PERF_TIME_END(id, name)
+#endif
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_PERF_H__ */
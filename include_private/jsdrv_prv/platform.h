@@ -129,6 +129,263 @@ JSDRV_COMPILER_ALLOC(jsdrv_free) JSDRV_INLINE_FN void * jsdrv_alloc_clr(size_t s
     return ptr;
 }
 
+/// The jsdrv_os_mem_alloc() option flags.
+enum jsdrv_os_mem_flags_e {
+    JSDRV_OS_MEM_FLAG_HUGE = (1 << 0),      ///< Prefer huge (large) pages.
+    JSDRV_OS_MEM_FLAG_PREFAULT = (1 << 1),  ///< Touch every page before returning.
+};
+
+/**
+ * @brief Allocate a large, page-aligned memory region from the OS.
+ *
+ * @param size_bytes The number of bytes to allocate.
+ * @param flags The jsdrv_os_mem_flags_e bitmap.
+ * @param numa_node The preferred NUMA node, or -1 for the default policy.
+ * @return The pointer to the memory or NULL on error.
+ *
+ * Huge pages and NUMA placement are hints.  When the OS cannot honor
+ * them, this function falls back to regular pages and the default
+ * placement.  Without a numa_node, prefaulting places pages on the
+ * caller's node under a first-touch policy.  Use jsdrv_os_mem_free()
+ * to free.
+ */
+void * jsdrv_os_mem_alloc(size_t size_bytes, uint32_t flags, int32_t numa_node);
+
+/**
+ * @brief Free memory provided by jsdrv_os_mem_alloc().
+ *
+ * @param ptr The pointer to the memory.
+ * @param size_bytes The size_bytes provided to jsdrv_os_mem_alloc().
+ */
+void jsdrv_os_mem_free(void * ptr, size_t size_bytes);
+
+/**
+ * @brief Map a large memory region backed by a temporary file.
+ *
+ * @param size_bytes The number of bytes to map.
+ * @param dir The directory for the backing file, preferably on fast storage.
+ * @return The page-aligned pointer to the mapped memory or NULL on error.
+ *
+ * The operating system writes dirty pages back to the file asynchronously
+ * and reclaims clean pages under memory pressure, so the region may
+ * exceed physical RAM.  The file is deleted when the region is freed
+ * or the process exits.  Use jsdrv_os_file_map_free() to free.
+ */
+void * jsdrv_os_file_map_alloc(size_t size_bytes, const char * dir);
+
+/**
+ * @brief Free memory provided by jsdrv_os_file_map_alloc().
+ *
+ * @param ptr The pointer to the mapped memory.
+ * @param size_bytes The size_bytes provided to jsdrv_os_file_map_alloc().
+ */
+void jsdrv_os_file_map_free(void * ptr, size_t size_bytes);
+
+/// The jsdrv_os_file_open() option flags.
+enum jsdrv_os_file_flags_e {
+    JSDRV_OS_FILE_FLAG_DIRECT = (1 << 0),   ///< Prefer unbuffered writes that bypass the OS cache.
+    JSDRV_OS_FILE_FLAG_URING = (1 << 1),    ///< Prefer io_uring batched writes on Linux.
+};
+
+/// A jsdrv_os_file_write_batch() entry.
+struct jsdrv_os_file_chunk_s {
+    const void * ptr;       ///< The data to write.
+    size_t size_bytes;      ///< The number of bytes to write.
+};
+
+// opaque file handle
+struct jsdrv_os_file_s;
+
+/**
+ * @brief Create or truncate a file for sequential writes.
+ *
+ * @param path The file path.
+ * @param flags The jsdrv_os_file_flags_e bitmap.
+ * @return The file or NULL on error.
+ *
+ * Direct writes and io_uring are hints.  When the OS or file system
+ * does not support them, the file uses normal buffered writes.  Use
+ * jsdrv_os_file_close() to close.
+ */
+struct jsdrv_os_file_s * jsdrv_os_file_open(const char * path, uint32_t flags);
+
+/**
+ * @brief Write to the end of a file.
+ *
+ * @param f The file from jsdrv_os_file_open().
+ * @param ptr The data to write.
+ * @param size_bytes The number of bytes to write.
+ * @return 0 or JSDRV_ERROR_IO.
+ *
+ * Direct writes require a page-aligned ptr and a size_bytes that is a
+ * multiple of the page size.  The first write that violates either
+ * constraint switches the file to buffered writes, which allows
+ * a final partial write.
+ */
+int32_t jsdrv_os_file_write(struct jsdrv_os_file_s * f, const void * ptr, size_t size_bytes);
+
+/**
+ * @brief Write multiple chunks to the end of a file.
+ *
+ * @param f The file from jsdrv_os_file_open().
+ * @param chunks The chunks to write in order.
+ * @param count The number of chunks.
+ * @return 0 or JSDRV_ERROR_IO.
+ *
+ * With io_uring, a single submission writes all chunks and
+ * returns when they complete.  Otherwise, this function calls
+ * jsdrv_os_file_write() for each chunk.
+ */
+int32_t jsdrv_os_file_write_batch(struct jsdrv_os_file_s * f, const struct jsdrv_os_file_chunk_s * chunks, uint32_t count);
+
+/**
+ * @brief Register the memory that holds all future write data.
+ *
+ * @param f The file from jsdrv_os_file_open().
+ * @param ptr The page-aligned memory.
+ * @param size_bytes The memory size in bytes.
+ * @return 0 or JSDRV_ERROR_NOT_SUPPORTED when the file does not use io_uring.
+ *
+ * io_uring pins registered memory once, rather than mapping the
+ * pages for each write.  When registration fails, io_uring remains
+ * available without registered buffers.
+ */
+int32_t jsdrv_os_file_register(struct jsdrv_os_file_s * f, void * ptr, size_t size_bytes);
+
+/**
+ * @brief Reserve file storage without changing the file size.
+ *
+ * @param f The file from jsdrv_os_file_open().
+ * @param size_bytes The total number of bytes to reserve.
+ * @return 0, JSDRV_ERROR_NOT_SUPPORTED or JSDRV_ERROR_IO.
+ *
+ * Reserving storage up front reduces fragmentation and the file system
+ * metadata updates for each write.  jsdrv_os_file_close() releases any
+ * unused reservation.
+ */
+int32_t jsdrv_os_file_preallocate(struct jsdrv_os_file_s * f, uint64_t size_bytes);
+
+/**
+ * @brief Flush written data to the storage device.
+ *
+ * @param f The file from jsdrv_os_file_open().
+ * @return 0 or JSDRV_ERROR_IO.
+ */
+int32_t jsdrv_os_file_sync(struct jsdrv_os_file_s * f);
+
+/**
+ * @brief Close a file.
+ *
+ * @param f The file from jsdrv_os_file_open().
+ * @return 0 or JSDRV_ERROR_IO.
+ */
+int32_t jsdrv_os_file_close(struct jsdrv_os_file_s * f);
+
+// opaque shared memory handle
+struct jsdrv_os_shm_s;
+
+/**
+ * @brief Create a named shared memory region for other processes.
+ *
+ * @param name The region name using only letters, digits, '_', '-' and '.'.
+ * @param size_bytes The region size in bytes.
+ * @return The region or NULL on error.
+ *
+ * The memory is zero-initialized.  Any existing region with the same
+ * name is replaced.  Use jsdrv_os_shm_close() to unmap and remove
+ * the region.  Processes that still map the region keep their mapping.
+ */
+struct jsdrv_os_shm_s * jsdrv_os_shm_create(const char * name, size_t size_bytes);
+
+/**
+ * @brief Map an existing named shared memory region read-only.
+ *
+ * @param name The region name provided to jsdrv_os_shm_create().
+ * @return The region or NULL on error.
+ */
+struct jsdrv_os_shm_s * jsdrv_os_shm_open(const char * name);
+
+/**
+ * @brief Get the mapped shared memory.
+ *
+ * @param shm The region.
+ * @param[out] size_bytes The region size in bytes.
+ * @return The page-aligned pointer to the mapped memory.
+ */
+void * jsdrv_os_shm_ptr(struct jsdrv_os_shm_s * shm, size_t * size_bytes);
+
+/**
+ * @brief Close a shared memory region.
+ *
+ * @param shm The region from jsdrv_os_shm_create() or jsdrv_os_shm_open().
+ *
+ * Closing a region from jsdrv_os_shm_create() also removes its name.
+ */
+void jsdrv_os_shm_close(struct jsdrv_os_shm_s * shm);
+
+// opaque TCP socket handle
+struct jsdrv_os_socket_s;
+
+/**
+ * @brief Listen for TCP connections.
+ *
+ * @param host The local IPv4 address or host name to bind,
+ *      or NULL for all interfaces.
+ * @param[inout] port The port to bind, 0 for any available port.
+ *      On success, updated with the bound port.
+ * @return The listening socket or NULL on error.
+ */
+struct jsdrv_os_socket_s * jsdrv_os_socket_listen(const char * host, uint16_t * port);
+
+/**
+ * @brief Accept a TCP connection.
+ *
+ * @param s The listening socket from jsdrv_os_socket_listen().
+ * @param timeout_ms The maximum time to wait.
+ * @return The connected socket or NULL on timeout or error.
+ */
+struct jsdrv_os_socket_s * jsdrv_os_socket_accept(struct jsdrv_os_socket_s * s, uint32_t timeout_ms);
+
+/**
+ * @brief Connect to a TCP server.
+ *
+ * @param host The server IPv4 address or host name.
+ * @param port The server port.
+ * @return The connected socket or NULL on error.
+ */
+struct jsdrv_os_socket_s * jsdrv_os_socket_connect(const char * host, uint16_t port);
+
+/**
+ * @brief Send data.
+ *
+ * @param s The connected socket.
+ * @param ptr The data to send.
+ * @param size_bytes The size of ptr in bytes.
+ * @return 0 once all data is sent, or JSDRV_ERROR_IO.
+ */
+int32_t jsdrv_os_socket_send(struct jsdrv_os_socket_s * s, const void * ptr, size_t size_bytes);
+
+/**
+ * @brief Receive available data.
+ *
+ * @param s The connected socket.
+ * @param[out] ptr The destination buffer.
+ * @param size_bytes The size of ptr in bytes.
+ * @param timeout_ms The maximum time to wait for data.
+ * @param[out] received The number of bytes received.
+ * @return 0, JSDRV_ERROR_TIMED_OUT, JSDRV_ERROR_CLOSED when the peer
+ *      closed the connection, or JSDRV_ERROR_IO.
+ */
+int32_t jsdrv_os_socket_recv(struct jsdrv_os_socket_s * s, void * ptr, size_t size_bytes,
+                             uint32_t timeout_ms, size_t * received);
+
+/**
+ * @brief Close a socket.
+ *
+ * @param s The socket, which is freed.  NULL is ignored.
+ */
+void jsdrv_os_socket_close(struct jsdrv_os_socket_s * s);
+
 /**
  * @brief Get the UTC time as a 34Q30 fixed point number.
  *
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Align current and voltage samples to compute power.
+ */
+
+#ifndef JSDRV_PRV_POWER_ALIGN_H_
+#define JSDRV_PRV_POWER_ALIGN_H_
+
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_power_align Power alignment
+ *
+ * @brief Multiply current and voltage samples with the same sample_id.
+ *
+ * The device adds the current and voltage samples of each frame
+ * payload as it receives them.  Only the channel that leads retains
+ * its samples, up to the alignment window.  When the other channel's
+ * samples arrive, the aligner multiplies them directly from the
+ * caller's payload with the retained samples, so neither channel
+ * is buffered twice.
+ *
+ * When the lagging channel falls more than the window behind, the
+ * aligner discards the oldest retained samples and counts them as
+ * overruns.  A skip in the leading channel produces NaN power
+ * samples, and the lagging channel discards the retained samples
+ * that it skips.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The default alignment window in samples.
+#define JSDRV_POWER_ALIGN_WINDOW_DEFAULT (1U << 16)
+
+/// The minimum alignment window in samples.
+#define JSDRV_POWER_ALIGN_WINDOW_MIN (1U << 10)
+
+/// The maximum alignment window in samples.
+#define JSDRV_POWER_ALIGN_WINDOW_MAX (1U << 22)
+
+/// The channels for jsdrv_power_align_add().
+enum jsdrv_power_align_channel_e {
+    JSDRV_POWER_ALIGN_CURRENT = 0,
+    JSDRV_POWER_ALIGN_VOLTAGE = 1,
+};
+
+/**
+ * @brief The function called for each span of aligned samples.
+ *
+ * @param user_data The arbitrary user data.
+ * @param sample_id The sample_id of the first sample.
+ * @param i The current samples.
+ * @param v The voltage samples.
+ * @param p The power samples.  The 32-bit word before p is scratch
+ *      that the callee may overwrite, such as to prepend a sample_id
+ *      header in place.
+ * @param count The number of samples for i, v and p.
+ *
+ * The pointers remain valid only for the duration of the call.
+ */
+typedef void (*jsdrv_power_align_fn)(void * user_data, uint64_t sample_id,
+                                     const float * i, const float * v, float * p, uint32_t count);
+
+/// The opaque instance.
+struct jsdrv_power_align_s;
+
+/**
+ * @brief Allocate a new instance.
+ *
+ * @param window The alignment window in samples, rounded up to a power
+ *      of 2 and limited to JSDRV_POWER_ALIGN_WINDOW_MIN through
+ *      JSDRV_POWER_ALIGN_WINDOW_MAX.
+ * @param fn The function called for each span of power samples.
+ * @param user_data The arbitrary data for fn.
+ * @return The new instance.
+ */
+struct jsdrv_power_align_s * jsdrv_power_align_alloc(uint32_t window, jsdrv_power_align_fn fn, void * user_data);
+
+/**
+ * @brief Free an instance.
+ *
+ * @param self The instance from jsdrv_power_align_alloc() or NULL.
+ */
+void jsdrv_power_align_free(struct jsdrv_power_align_s * self);
+
+/**
+ * @brief Discard the retained samples.
+ *
+ * @param self The instance.
+ *
+ * The overrun count continues.
+ */
+void jsdrv_power_align_clear(struct jsdrv_power_align_s * self);
+
+/**
+ * @brief Get the alignment window.
+ *
+ * @param self The instance.
+ * @return The window in samples.
+ */
+uint32_t jsdrv_power_align_window(struct jsdrv_power_align_s * self);
+
+/**
+ * @brief Get the overrun count.
+ *
+ * @param self The instance.
+ * @return The total samples discarded because the other channel fell
+ *      more than the window behind.
+ */
+uint64_t jsdrv_power_align_overrun(struct jsdrv_power_align_s * self);
+
+/**
+ * @brief Add samples for one channel.
+ *
+ * @param self The instance.
+ * @param channel The jsdrv_power_align_channel_e.
+ * @param sample_id The sample_id of the first sample.
+ * @param decimate_factor The sample_id increment for each sample.  A
+ *      change discards the retained samples.
+ * @param x The samples, which are only accessed during this call.
+ * @param count The number of samples in x.
+ */
+void jsdrv_power_align_add(struct jsdrv_power_align_s * self, uint8_t channel,
+                           uint64_t sample_id, uint32_t decimate_factor,
+                           const float * x, uint32_t count);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_POWER_ALIGN_H_ */
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Host-side signal processing chains.
+ */
+
+#ifndef JSDRV_PRV_PROC_H_
+#define JSDRV_PRV_PROC_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_proc Processing chains
+ *
+ * @brief Process float signals in the device decode loop.
+ *
+ * Each float signal (current, voltage, power) has a chain of
+ * JSDRV_PROC_STAGE_COUNT stages configured by
+ * "h/proc/{i, v, p}/N/{type, a, b, n}".  The stages run in order on
+ * each block of scaled samples before publication, so the stream
+ * and any memory buffer receive the processed signal.  The sample
+ * buffers, triggers, host statistics and host power computation
+ * continue to use the unprocessed samples.
+ *
+ * The decimate and rms stages reduce the sample rate by n.  A chain
+ * that reduces the sample rate replaces host downsampling for that
+ * signal.  Each reduced sample has the sample_id of the first
+ * sample in its window.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+struct jsdrv_context_s;
+
+/// The number of stages in each chain.
+#define JSDRV_PROC_STAGE_COUNT (4U)
+
+/// The maximum combined rate reduction for a chain.
+#define JSDRV_PROC_DECIMATE_MAX (1000000U)
+
+/// The processed signals, in "h/proc/{i, v, p}" order.
+enum jsdrv_proc_signal_e {
+    JSDRV_PROC_SIGNAL_CURRENT = 0,
+    JSDRV_PROC_SIGNAL_VOLTAGE = 1,
+    JSDRV_PROC_SIGNAL_POWER = 2,
+    JSDRV_PROC_SIGNAL_COUNT,
+};
+
+/// The stage types, the "h/proc/S/N/type" options.
+enum jsdrv_proc_type_e {
+    JSDRV_PROC_TYPE_OFF = 0,        ///< Pass samples unchanged.
+    JSDRV_PROC_TYPE_SCALE = 1,      ///< y = a * x + b
+    JSDRV_PROC_TYPE_LOWPASS = 2,    ///< Single-pole IIR with cutoff a Hz.
+    JSDRV_PROC_TYPE_DECIMATE = 3,   ///< Mean of each n samples.
+    JSDRV_PROC_TYPE_RMS = 4,        ///< RMS of each n samples.
+    JSDRV_PROC_TYPE_THRESHOLD = 5,  ///< 1 at or above a, 0 below a - b.
+    JSDRV_PROC_TYPE_COUNT,
+};
+
+/// The stage configuration fields, in "h/proc/S/N/" topic order.
+enum jsdrv_proc_field_e {
+    JSDRV_PROC_FIELD_TYPE,
+    JSDRV_PROC_FIELD_A,
+    JSDRV_PROC_FIELD_B,
+    JSDRV_PROC_FIELD_N,
+    JSDRV_PROC_FIELD_COUNT,
+};
+
+/// A processing stage.
+struct jsdrv_proc_stage_s {
+    uint8_t type;               ///< jsdrv_proc_type_e
+    float a;                    ///< The first coefficient, see jsdrv_proc_type_e.
+    float b;                    ///< The second coefficient, see jsdrv_proc_type_e.
+    uint32_t n;                 ///< The window length for decimate and rms.
+    double acc;                 ///< The window accumulator.
+    uint32_t count;             ///< The samples in the window accumulator.
+    float y;                    ///< The lowpass or threshold output state.
+    bool valid;                 ///< True when y holds state.
+};
+
+/// The processing chain for one signal.
+struct jsdrv_proc_s {
+    struct jsdrv_proc_stage_s stages[JSDRV_PROC_STAGE_COUNT];
+    uint32_t decimate_factor;   ///< The combined rate reduction.
+    uint32_t phase;             ///< The samples consumed towards the next output.
+    bool active;                ///< True when any stage is not off.
+};
+
+/**
+ * @brief Initialize the instance to the default, pass-through configuration.
+ *
+ * @param self The instance.
+ */
+void jsdrv_proc_initialize(struct jsdrv_proc_s * self);
+
+/**
+ * @brief Clear the processing state.
+ *
+ * @param self The instance.
+ *
+ * Call on stream restart and sample discontinuities.
+ */
+void jsdrv_proc_clear(struct jsdrv_proc_s * self);
+
+/**
+ * @brief Get the topic name for a configuration field.
+ *
+ * @param field The jsdrv_proc_field_e.
+ * @return The name, or NULL if field is invalid.
+ */
+const char * jsdrv_proc_field_name(uint8_t field);
+
+/**
+ * @brief Configure a stage.
+ *
+ * @param procs The JSDRV_PROC_SIGNAL_COUNT chain instances.
+ * @param topic The device topic "h/proc/{i, v, p}/N/{field}".
+ * @param value The new value.
+ * @return 0 or JSDRV_ERROR_PARAMETER_INVALID.
+ *
+ * Changes clear the processing state of that chain.
+ */
+int32_t jsdrv_proc_param(struct jsdrv_proc_s * procs, const char * topic, const struct jsdrv_union_s * value);
+
+/**
+ * @brief Process contiguous samples in place.
+ *
+ * @param self The instance.
+ * @param sample_rate The input sample rate in Hz.
+ * @param x[inout] The input samples, overwritten with the output samples.
+ * @param count The number of input samples.
+ * @return The number of output samples, at most count.
+ */
+uint32_t jsdrv_proc_process(struct jsdrv_proc_s * self, float sample_rate, float * x, uint32_t count);
+
+/**
+ * @brief Publish the "h/proc/..." metadata for a device.
+ *
+ * @param context The driver context.
+ * @param prefix The device prefix.
+ */
+void jsdrv_proc_meta_publish(struct jsdrv_context_s * context, const char * prefix);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_PROC_H_ */
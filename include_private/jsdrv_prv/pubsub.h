@@ -50,12 +50,18 @@
 
 JSDRV_CPP_GUARD_START
 
+/// 0 discards all "$" metadata, see the JSDRV_META CMake option.
+#ifndef JSDRV_META_ENABLE
+#define JSDRV_META_ENABLE             1
+#endif
+
 /// The topic prefix for local topics (no distributed pubsub).
 #define JSDRV_PUBSUB_COMMAND_PREFIX   '_'
 #define JSDRV_PUBSUB_SUBSCRIBE        "_/!sub"
 #define JSDRV_PUBSUB_UNSUBSCRIBE      "_/!unsub"
 #define JSDRV_PUBSUB_UNSUBSCRIBE_ALL  "_/!unsub+"
 #define JSDRV_PUBSUB_QUERY            "_/!query"
+#define JSDRV_PUBSUB_SNAPSHOT         "_/!snapshot"
 
 /// The opaque PubSub instance.
 struct jsdrv_pubsub_s;
@@ -77,23 +83,46 @@ struct jsdrv_context_s;
  */
 typedef uint8_t (*jsdrv_pubsub_subscribe_fn)(void * user_data, struct jsdrvp_msg_s * msg);
 
+/**
+ * @brief A subscriber delivery queue.
+ *
+ * Queued subscribers, see JSDRV_SFLAG_QUEUED, receive messages through
+ * their own bounded queue and delivery thread.  The pubsub instance
+ * pushes each message for the subscriber to its queue.
+ */
+struct jsdrv_pubsub_queue_s {
+    /**
+     * @brief Push a message to the queue.
+     *
+     * @param self The queue instance.
+     * @param msg The message.  Call jsdrvp_msg_retain() to keep it.
+     */
+    void (*push)(struct jsdrv_pubsub_queue_s * self, struct jsdrvp_msg_s * msg);
+};
+
 /**
  * @brief The subscriber structure.
  *
  * This pubsub instance supports two types of subscribers.
- * External subscribers get topic + value.  Internal subscribers
+ * External subscribers get topic + value, individually or in
+ * batches at the end of jsdrv_pubsub_process().  Internal subscribers
  * get the raw message.  This structure unifies the
  * subscriber specification.
  */
 struct jsdrv_pubsub_subscriber_s {
     union {
         jsdrv_subscribe_fn external_fn;
+        jsdrv_subscribe_batch_fn batch_fn;
         jsdrv_pubsub_subscribe_fn internal_fn;
         void * void_fn;
     };
     void * user_data;
     uint8_t is_internal;
+    uint8_t is_batch;       ///< External batch_fn, see jsdrv_subscribe_batch()
     uint8_t flags;          ///< jsdrv_subscribe_flag_e
+    uint8_t queue_policy;   ///< jsdrv_subscribe_queue_policy_e for JSDRV_SFLAG_QUEUED
+    uint32_t queue_depth;   ///< The queue depth for JSDRV_SFLAG_QUEUED, 0 for default
+    struct jsdrv_pubsub_queue_s * queue;  ///< The delivery queue or NULL (internal use)
 };
 
 struct jsdrv_pubsub_subscriber_internal_s {
@@ -101,6 +130,96 @@ struct jsdrv_pubsub_subscriber_internal_s {
     void * user_data;
 };
 
+/// The maximum number of subscribers for each jsdrv_pubsub_dispatch_s.data call.
+#define JSDRV_PUBSUB_DISPATCH_SUBSCRIBERS_MAX  (32U)
+
+/**
+ * @brief The optional data-plane dispatcher.
+ *
+ * When registered, the pubsub instance hands stream and statistics
+ * messages for external subscribers to the dispatcher rather than
+ * calling the subscribers directly.  Internal subscribers are
+ * always called directly.  The dispatcher also provides the
+ * delivery queues for JSDRV_SFLAG_QUEUED subscribers.
+ */
+struct jsdrv_pubsub_dispatch_s {
+    /// The arbitrary data passed to each function.
+    void * user_data;
+
+    /**
+     * @brief Deliver a data message to external subscribers.
+     *
+     * @param user_data The arbitrary user data.
+     * @param msg The data message.  Call jsdrvp_msg_retain() to keep it.
+     * @param hash The topic shard, see jsdrv_pubsub_shard_hash().
+     *      Messages with the same shard must be delivered in order.
+     * @param subscribers The external subscribers to call.
+     * @param count The number of subscribers, at most
+     *      JSDRV_PUBSUB_DISPATCH_SUBSCRIBERS_MAX.
+     */
+    void (*data)(void * user_data, struct jsdrvp_msg_s * msg, uint32_t hash,
+                 const struct jsdrv_pubsub_subscriber_s * subscribers, uint32_t count);
+
+    /**
+     * @brief Open a delivery queue for a queued subscriber.
+     *
+     * @param user_data The arbitrary user data.
+     * @param topic The subscription topic.
+     * @param subscriber The external subscriber.
+     * @return The new queue or NULL to call the subscriber directly.
+     *
+     * Close the queue with barrier().
+     */
+    struct jsdrv_pubsub_queue_s * (*queue_open)(void * user_data, const char * topic,
+            const struct jsdrv_pubsub_subscriber_s * subscriber);
+
+    /**
+     * @brief Close queues and complete a return code after all prior deliveries.
+     *
+     * @param user_data The arbitrary user data.
+     * @param rsp The return code message, such as "_/!unsub#", or NULL.
+     *      The dispatcher takes ownership and must pass rsp back to
+     *      jsdrv_pubsub_publish() on the pubsub thread once all
+     *      messages dispatched before this call were delivered.
+     * @param queues The queues of the removed subscribers to close.
+     *      Each queue delivers its pending messages and then stops.
+     * @param count The number of queues.
+     *
+     * Unsubscribe uses this barrier so that external subscribers are
+     * never called after their unsubscribe completes.
+     */
+    void (*barrier)(void * user_data, struct jsdrvp_msg_s * rsp,
+                    struct jsdrv_pubsub_queue_s * const * queues, uint32_t count);
+};
+
+/**
+ * @brief Compute the topic handle.
+ *
+ * @param topic The full topic name.
+ * @return The nonzero topic hash.
+ *
+ * Producers that publish to the same topic repeatedly, such as
+ * stream data, may compute this value once and assign it to
+ * jsdrvp_msg_s.topic_hash.  The pubsub instance then resolves the
+ * topic with a single hash probe.  This function is thread-safe.
+ */
+uint32_t jsdrv_pubsub_topic_hash(const char * topic);
+
+/// The number of topic levels that identify a device, such as "u/js220/000415".
+#define JSDRV_PUBSUB_SHARD_LEVELS (3U)
+
+/**
+ * @brief Compute the delivery shard for a topic.
+ *
+ * @param topic The full topic name.
+ * @return The nonzero jsdrv_pubsub_topic_hash() of the first
+ *      JSDRV_PUBSUB_SHARD_LEVELS levels of topic.
+ *
+ * All topics of one device share a shard, which the data-plane
+ * dispatcher uses to deliver each device on a single thread.
+ */
+uint32_t jsdrv_pubsub_shard_hash(const char * topic);
+
 /**
  * @brief Create and initialize a new PubSub instance.
  *
@@ -115,6 +234,27 @@ struct jsdrv_pubsub_s * jsdrv_pubsub_initialize(struct jsdrv_context_s * context
  */
 void jsdrv_pubsub_finalize(struct jsdrv_pubsub_s * self);
 
+/**
+ * @brief Call an external subscriber with a message.
+ *
+ * @param subscriber The external subscriber.
+ * @param msg The message.
+ *
+ * This function converts the message to the external
+ * topic and value representation.  It does not access
+ * the pubsub instance and is safe to call from any thread.
+ */
+void jsdrv_pubsub_external_call(const struct jsdrv_pubsub_subscriber_s * subscriber, struct jsdrvp_msg_s * msg);
+
+/**
+ * @brief Register the data-plane dispatcher.
+ *
+ * @param self The PubSub instance.
+ * @param dispatch The dispatcher, which must remain valid until
+ *      unregistered, or NULL to call subscribers directly.
+ */
+void jsdrv_pubsub_dispatch_register(struct jsdrv_pubsub_s * self, const struct jsdrv_pubsub_dispatch_s * dispatch);
+
 /**
  * @brief Publish to a topic.
  *
@@ -133,9 +273,39 @@ int32_t jsdrv_pubsub_publish(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s *
  * @brief Process all outstanding topic updates.
  *
  * @param self The PubSub instance to process.
+ *
+ * Batch subscribers receive their accumulated messages before this
+ * function returns.
  */
 void jsdrv_pubsub_process(struct jsdrv_pubsub_s * self);
 
+/**
+ * @brief Query a retained scalar value without the pubsub thread.
+ *
+ * @param self The PubSub instance.
+ * @param topic The full topic name.
+ * @param[out] value The retained value.
+ * @return 0 or JSDRV_ERROR_UNAVAILABLE when the value is not cached.
+ *
+ * This function is thread-safe and never blocks.  The result reflects
+ * the messages that jsdrv_pubsub_process() has completed.  See
+ * jsdrv_prv/value_cache.h.
+ */
+int32_t jsdrv_pubsub_query_cached(struct jsdrv_pubsub_s * self, const char * topic, struct jsdrv_union_s * value);
+
+/**
+ * @brief Check whether a topic may bypass pubsub validation.
+ *
+ * @param self The PubSub instance.
+ * @param topic The full topic name.
+ * @param[out] value The retained value or JSDRV_UNION_NULL.
+ * @return 0 when the topic has metadata that passes scalar, non-string
+ *      values unmodified, otherwise JSDRV_ERROR_UNAVAILABLE.
+ *
+ * This function is thread-safe and never blocks.
+ */
+int32_t jsdrv_pubsub_query_direct(struct jsdrv_pubsub_s * self, const char * topic, struct jsdrv_union_s * value);
+
 JSDRV_CPP_GUARD_END
 
 /** @} */
@@ -0,0 +1,217 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Record stream data to disk from within the driver.
+ */
+
+#ifndef JSDRV_PRV_RECORD_H_
+#define JSDRV_PRV_RECORD_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_record Stream recorder
+ *
+ * @brief Write stream data messages to a raw chunked file.
+ *
+ * The recorder copies each stream message into the large, page-aligned
+ * buffers of a jsdrv_file_writer_s on the frontend thread.  A dedicated
+ * writer thread writes each full buffer to the file with a single
+ * write, optionally bypassing the OS cache.  When the writer falls
+ * behind and every buffer is full, the recorder drops the message
+ * rather than blocking the frontend thread.  Readers detect the gap
+ * from the sample_id of the following data chunk.
+ *
+ * The file starts with jsdrv_record_header_s followed by chunks.
+ * Each chunk is a jsdrv_record_chunk_s followed by payload_size bytes
+ * and zero padding to the next multiple of 8 bytes.  All values are
+ * little endian.  The chunk types are:
+ * - SIGNAL: the nul-terminated stream data topic for signal_idx.
+ * - DATA: the jsdrv_stream_signal_s header and element data for signal_idx.
+ * - END: jsdrv_record_status_s, which only exists after a clean close.
+ *
+ * Topics, where NNN is 001 to JSDRV_RECORD_INSTANCES_MAX:
+ * - r/NNN/signals: str comma-separated stream data topics to record.
+ * - r/NNN/direct: bool 1 to request unbuffered writes.
+ * - r/NNN/uring: bool 1 to request batched io_uring writes on Linux.
+ * - r/NNN/!open: str file path to start recording.
+ * - r/NNN/!close: any value to stop recording.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+#ifndef JSDRV_RECORD_BUFFER_SIZE
+/// The write buffer size in bytes, see jsdrv_file_writer_config_s.
+#define JSDRV_RECORD_BUFFER_SIZE (4U * 1024U * 1024U)
+#endif
+
+#ifndef JSDRV_RECORD_BUFFER_COUNT
+/// The number of write buffers.
+#define JSDRV_RECORD_BUFFER_COUNT (8U)
+#endif
+
+/// The number of recorder instances.
+#define JSDRV_RECORD_INSTANCES_MAX  (4U)
+/// The maximum number of signals for each recording.
+#define JSDRV_RECORD_SIGNALS_MAX    (16U)
+/// The jsdrv_record_header_s magic value.
+#define JSDRV_RECORD_MAGIC          "jsdrvrec"
+/// The file format version.
+#define JSDRV_RECORD_VERSION        (1U)
+
+/// The jsdrv_record_open() option flags.
+enum jsdrv_record_flags_e {
+    JSDRV_RECORD_FLAG_DIRECT = (1 << 0),    ///< Request unbuffered writes.
+    JSDRV_RECORD_FLAG_URING = (1 << 1),     ///< Request batched io_uring writes on Linux.
+};
+
+/// The chunk types.
+enum jsdrv_record_chunk_type_e {
+    JSDRV_RECORD_CHUNK_SIGNAL = 1,
+    JSDRV_RECORD_CHUNK_DATA = 2,
+    JSDRV_RECORD_CHUNK_END = 3,
+};
+
+/// The file header.
+struct jsdrv_record_header_s {
+    char magic[8];          ///< JSDRV_RECORD_MAGIC without the nul terminator.
+    uint32_t version;       ///< JSDRV_RECORD_VERSION.
+    uint32_t header_size;   ///< sizeof(struct jsdrv_record_header_s).
+    int64_t utc;            ///< The open time as 34Q30 UTC.
+};
+
+/// The chunk header.
+struct jsdrv_record_chunk_s {
+    uint8_t type;           ///< The jsdrv_record_chunk_type_e.
+    uint8_t signal_idx;     ///< The signal index, or 0 for END.
+    uint16_t rsv;           ///< Reserved, write 0.
+    uint32_t payload_size;  ///< The payload size in bytes, excluding padding.
+};
+
+/// The recording status.
+struct jsdrv_record_status_s {
+    uint64_t msg_count;     ///< The number of recorded data messages.
+    uint64_t drop_count;    ///< The number of dropped data messages.
+    uint64_t bytes_written; ///< The bytes written to the file, or in END, the bytes preceding END.
+};
+
+// forward declarations
+struct jsdrv_context_s;
+struct jsdrv_record_s;
+
+/**
+ * @brief Start a new recording.
+ *
+ * @param path The file path, which is created or truncated.
+ * @param flags The jsdrv_record_flags_e bitmap.
+ * @return The recorder or NULL on error.
+ */
+struct jsdrv_record_s * jsdrv_record_open(const char * path, uint32_t flags);
+
+/**
+ * @brief Define a signal.
+ *
+ * @param self The recorder.
+ * @param signal_idx The signal index, less than JSDRV_RECORD_SIGNALS_MAX.
+ * @param topic The stream data topic.
+ * @return 0, JSDRV_ERROR_PARAMETER_INVALID or JSDRV_ERROR_FULL.
+ */
+int32_t jsdrv_record_signal(struct jsdrv_record_s * self, uint8_t signal_idx, const char * topic);
+
+/**
+ * @brief Record a stream data message.
+ *
+ * @param self The recorder.
+ * @param signal_idx The signal index.
+ * @param signal The stream data, which is copied.
+ * @param size The valid size of signal in bytes.
+ * @return 0, JSDRV_ERROR_PARAMETER_INVALID, JSDRV_ERROR_FULL when
+ *      dropped or JSDRV_ERROR_IO after a write failure.
+ *
+ * This function never blocks on the file.
+ */
+int32_t jsdrv_record_write(struct jsdrv_record_s * self, uint8_t signal_idx,
+                           const struct jsdrv_stream_signal_s * signal, uint32_t size);
+
+/**
+ * @brief Record a stream data message that the caller retries when full.
+ *
+ * @param self The recorder.
+ * @param signal_idx The signal index.
+ * @param signal The stream data, which is copied.
+ * @param size The valid size of signal in bytes.
+ * @return 0, JSDRV_ERROR_PARAMETER_INVALID, JSDRV_ERROR_FULL when
+ *      the writer is behind or JSDRV_ERROR_IO after a write failure.
+ *
+ * Unlike jsdrv_record_write(), a full writer does not count as a
+ * drop.  Use for producers that can wait, such as buffer exports.
+ */
+int32_t jsdrv_record_append(struct jsdrv_record_s * self, uint8_t signal_idx,
+                            const struct jsdrv_stream_signal_s * signal, uint32_t size);
+
+/**
+ * @brief Get the recording status.
+ *
+ * @param self The recorder.
+ * @param status[out] The status.
+ */
+void jsdrv_record_status(struct jsdrv_record_s * self, struct jsdrv_record_status_s * status);
+
+/**
+ * @brief Stop a recording.
+ *
+ * @param self The recorder, which is freed.
+ * @return 0 or JSDRV_ERROR_IO when any write failed.
+ *
+ * Blocks until the writer thread writes all buffered data.
+ */
+int32_t jsdrv_record_close(struct jsdrv_record_s * self);
+
+/// The opaque recorder service instance.
+struct jsdrv_record_svc_s;
+
+/**
+ * @brief Initialize the recorder service.
+ *
+ * @param context The driver context.
+ * @param[out] instance The new recorder service instance.
+ * @return 0 or error code.
+ */
+int32_t jsdrv_record_initialize(struct jsdrv_context_s * context, struct jsdrv_record_svc_s ** instance);
+
+/**
+ * @brief Finalize the recorder service.
+ *
+ * Closes any open recordings.
+ *
+ * @param instance The instance from jsdrv_record_initialize() or NULL.
+ */
+void jsdrv_record_finalize(struct jsdrv_record_svc_s * instance);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_RECORD_H_ */
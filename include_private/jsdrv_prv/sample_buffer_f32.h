@@ -20,7 +20,7 @@
 #include "jsdrv/cmacro_inc.h"
 #include <stdint.h>
 
-#define SAMPLE_BUFFER_LENGTH (1024)  // must be power of 2
+#define SAMPLE_BUFFER_LENGTH (4096)  // must be power of 2
 #define SAMPLE_BUFFER_MASK (SAMPLE_BUFFER_LENGTH - 1)
 
 JSDRV_CPP_GUARD_START
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Export stream data to shared memory.
+ */
+
+#ifndef JSDRV_PRV_SHM_H_
+#define JSDRV_PRV_SHM_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include "jsdrv/shm.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_shm Shared memory stream export
+ *
+ * @brief Write stream data to a named shared memory ring, see jsdrv_shm.
+ *
+ * The writer creates the region on the first stream message, when it
+ * knows the element size.  Writes never block on readers.
+ *
+ * Topics, where NNN is 001 to JSDRV_SHM_INSTANCES_MAX:
+ * - x/NNN/signal: str stream data topic to export.
+ * - x/NNN/size: u32 ring capacity in elements.
+ * - x/NNN/!open: str region name to start exporting.
+ * - x/NNN/!close: any value to stop exporting and remove the region.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The number of export instances.
+#define JSDRV_SHM_INSTANCES_MAX     (4U)
+/// The default ring capacity in elements.
+#define JSDRV_SHM_CAPACITY_DEFAULT  (1U << 22)
+
+// forward declarations
+struct jsdrv_context_s;
+struct jsdrv_shm_writer_s;
+
+/**
+ * @brief Start a new export.
+ *
+ * @param name The region name.
+ * @param topic The exported stream data topic.
+ * @param capacity The ring capacity in elements.
+ * @return The writer or NULL on invalid parameters.
+ */
+struct jsdrv_shm_writer_s * jsdrv_shm_writer_open(const char * name, const char * topic, uint64_t capacity);
+
+/**
+ * @brief Append stream data.
+ *
+ * @param self The writer.
+ * @param signal The stream data.
+ * @return 0, JSDRV_ERROR_NOT_SUPPORTED for an element type change,
+ *      or JSDRV_ERROR_IO when the region could not be created.
+ */
+int32_t jsdrv_shm_writer_write(struct jsdrv_shm_writer_s * self, const struct jsdrv_stream_signal_s * signal);
+
+/**
+ * @brief Stop an export and remove the region.
+ *
+ * @param self The writer, which is freed.
+ */
+void jsdrv_shm_writer_close(struct jsdrv_shm_writer_s * self);
+
+/// The opaque export service instance.
+struct jsdrv_shm_svc_s;
+
+/**
+ * @brief Initialize the export service.
+ *
+ * @param context The driver context.
+ * @param[out] instance The new export service instance.
+ * @return 0 or error code.
+ */
+int32_t jsdrv_shm_initialize(struct jsdrv_context_s * context, struct jsdrv_shm_svc_s ** instance);
+
+/**
+ * @brief Finalize the export service.
+ *
+ * Closes any open exports.
+ *
+ * @param instance The instance from jsdrv_shm_initialize() or NULL.
+ */
+void jsdrv_shm_finalize(struct jsdrv_shm_svc_s * instance);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_SHM_H_ */
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2023 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Vectorized float32 array kernels.
+ */
+
+#ifndef JSDRV_PRV_SIMD_F32_H__
+#define JSDRV_PRV_SIMD_F32_H__
+
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_simd_f32 Vectorized float32 kernels
+ *
+ * @brief Provide SIMD float32 kernels selected at runtime.
+ *
+ * jsdrv_initialize() selects the best kernels supported by the
+ * host CPU from jsdrv_cpu_features(): AVX-512, AVX2, SSE2, NEON or
+ * portable scalar code.  Without jsdrv_initialize(), the first
+ * call selects.
+ * The element-wise kernels produce results identical to the
+ * scalar code.  The statistics kernels accumulate in double
+ * precision in a kernel-specific order, so their results may
+ * differ from the scalar code by double precision rounding.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+// Forward declaration from "jsdrv.h"
+struct jsdrv_summary_entry_s;
+
+/// The accumulated statistics for jsdrv_f32_sum().
+struct jsdrv_f32_sum_s {
+    uint64_t count;     ///< The number of non-NaN elements.
+    double sum;         ///< The sum of the non-NaN elements.
+    float min;          ///< The minimum non-NaN element.
+    float max;          ///< The maximum non-NaN element.
+};
+
+/**
+ * @brief Multiply two arrays, element by element.
+ *
+ * @param y The output array, y[i] = a[i] * b[i] * scale.
+ *      May alias a or b.
+ * @param a The first input array.
+ * @param b The second input array.
+ * @param scale The scale factor applied to each product.
+ * @param n The number of elements.
+ */
+void jsdrv_f32_mult(float * y, const float * a, const float * b, float scale, uint32_t n);
+
+/**
+ * @brief Scale an array in place.
+ *
+ * @param x The array, x[i] = x[i] * scale.
+ * @param scale The scale factor.
+ * @param n The number of elements.
+ */
+void jsdrv_f32_scale(float * x, float scale, uint32_t n);
+
+/**
+ * @brief Reset the accumulated statistics.
+ *
+ * @param s The statistics to reset to count 0, sum 0, min FLT_MAX
+ *      and max -FLT_MAX.
+ */
+void jsdrv_f32_sum_reset(struct jsdrv_f32_sum_s * s);
+
+/**
+ * @brief Accumulate the sum, minimum and maximum of an array.
+ *
+ * @param s The statistics, which this function updates.
+ * @param x The input array.  NaN elements are skipped.
+ * @param n The number of elements.
+ *
+ * Call repeatedly to accumulate non-contiguous segments.
+ */
+void jsdrv_f32_sum(struct jsdrv_f32_sum_s * s, const float * x, uint32_t n);
+
+/**
+ * @brief Compute the sum of squared differences from the mean.
+ *
+ * @param x The input array.  NaN elements are skipped.
+ * @param n The number of elements.
+ * @param mean The mean, usually from jsdrv_f32_sum().
+ * @return The sum of (x[i] - mean)^2, the second pass of a
+ *      two-pass variance computation.
+ */
+double jsdrv_f32_sum_sq_diff(const float * x, uint32_t n, double mean);
+
+/**
+ * @brief Combine equally weighted summary entries.
+ *
+ * @param y The output combined entry.
+ * @param x The input entries.
+ * @param n The number of input entries.
+ * @return 0 on success.  Returns 1 without modifying y if n is 0 or
+ *      any entry contains NaN.
+ *
+ * The result matches successive jsdrv_statistics_combine() of each
+ * entry with a unit weight: the average of the averages, the
+ * standard deviation of all entries with (n - 1) in the
+ * denominator, and the overall minimum and maximum.
+ */
+int32_t jsdrv_f32_summary_combine(struct jsdrv_summary_entry_s * y, const struct jsdrv_summary_entry_s * x, uint32_t n);
+
+/**
+ * @brief Select the kernel implementation.
+ *
+ * @param features The jsdrv_cpu_feature_e flags to allow, usually
+ *      from jsdrv_cpu_features().  The caller ensures the host CPU
+ *      supports each flag.
+ */
+void jsdrv_f32_select(uint32_t features);
+
+/**
+ * @brief Get the name of the selected kernel implementation.
+ *
+ * @return One of "avx512", "avx2", "sse2", "neon" or "scalar".
+ */
+const char * jsdrv_f32_impl(void);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_SIMD_F32_H__ */
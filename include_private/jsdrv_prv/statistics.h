@@ -66,6 +66,15 @@ void jsdrv_statistics_reset(struct jsdrv_statistics_accum_s * s);
  */
 void jsdrv_statistics_adjust_k(struct jsdrv_statistics_accum_s * s, uint64_t k);
 
+/// The number of elements per cache-resident block for the compute functions.
+#define JSDRV_STATISTICS_BLOCK_SIZE (4096U)
+
+/// The minimum number of elements per thread for the parallel compute functions.
+#define JSDRV_STATISTICS_PARALLEL_MIN (1U << 20)
+
+/// The maximum number of threads for the parallel compute functions.
+#define JSDRV_STATISTICS_THREADS_MAX (64U)
+
 /**
  * @brief Compute the statistics over an array.
  *
@@ -73,8 +82,14 @@ void jsdrv_statistics_adjust_k(struct jsdrv_statistics_accum_s * s, uint64_t k);
  * @param x The value array.
  * @param length The number of elements in x.
  *
- * Use the "traditional" two pass method.  Compute mean in first pass,
- * then variance in second pass.
+ * Process the array in blocks of JSDRV_STATISTICS_BLOCK_SIZE
+ * elements.  Each block uses the "traditional" two pass method
+ * with the SIMD kernels while the block is in cache, then merges
+ * into the result using jsdrv_statistics_combine().  This reads
+ * the array from memory only once.
+ *
+ * NaN values produce a NaN mean and variance, but min and max
+ * ignore them.
  */
 void jsdrv_statistics_compute_f32(struct jsdrv_statistics_accum_s * s, const float * x, uint64_t length);
 
@@ -84,9 +99,44 @@ void jsdrv_statistics_compute_f32(struct jsdrv_statistics_accum_s * s, const flo
  * @param s The statistics instance.
  * @param x The value array.
  * @param length The number of elements in x.
+ *
+ * @see jsdrv_statistics_compute_f32()
  */
 void jsdrv_statistics_compute_f64(struct jsdrv_statistics_accum_s * s, const double * x, uint64_t length);
 
+/**
+ * @brief Compute the statistics over a large array using multiple threads.
+ *
+ * @param s The statistics instance.
+ * @param x The value array.
+ * @param length The number of elements in x.
+ * @param threads The maximum number of threads, including the caller.
+ *      0 uses jsdrv_cpu_count().
+ *
+ * Split the array on block boundaries, compute each part with
+ * jsdrv_statistics_compute_f32(), and merge the parts.  Each thread
+ * processes at least JSDRV_STATISTICS_PARALLEL_MIN elements, so
+ * smaller arrays compute on the calling thread only.  Starting
+ * threads costs far more than a small array, so use this function
+ * only for arrays of many millions of elements.
+ */
+void jsdrv_statistics_compute_f32_parallel(struct jsdrv_statistics_accum_s * s, const float * x,
+                                           uint64_t length, uint32_t threads);
+
+/**
+ * @brief Compute the statistics over a large array using multiple threads.
+ *
+ * @param s The statistics instance.
+ * @param x The value array.
+ * @param length The number of elements in x.
+ * @param threads The maximum number of threads, including the caller.
+ *      0 uses jsdrv_cpu_count().
+ *
+ * @see jsdrv_statistics_compute_f32_parallel()
+ */
+void jsdrv_statistics_compute_f64_parallel(struct jsdrv_statistics_accum_s * s, const double * x,
+                                           uint64_t length, uint32_t threads);
+
 /**
  * @brief Add a new sample into the statistics.
  *
@@ -127,6 +177,20 @@ void jsdrv_statistics_combine(struct jsdrv_statistics_accum_s * tgt,
                              struct jsdrv_statistics_accum_s const * a,
                              struct jsdrv_statistics_accum_s const * b);
 
+/**
+ * @brief Compute the combined mean, min and max over two statistics instances.
+ *
+ * @param tgt The target statistics instance.  It is safe to use a or b for tgt.
+ * @param a The first statistics instance to combine.
+ * @param b The second statistics instance to combine.
+ *
+ * Like jsdrv_statistics_combine() without the variance, and
+ * tgt->s is NaN.
+ */
+void jsdrv_statistics_combine_envelope(struct jsdrv_statistics_accum_s * tgt,
+                                      struct jsdrv_statistics_accum_s const * a,
+                                      struct jsdrv_statistics_accum_s const * b);
+
 struct jsdrv_summary_entry_s;
 void jsdrv_statistics_from_entry(struct jsdrv_statistics_accum_s * s, struct jsdrv_summary_entry_s const * e, uint64_t k);
 void jsdrv_statistics_to_entry(struct jsdrv_statistics_accum_s const * s, struct jsdrv_summary_entry_s * e);
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Combined statistics from all devices.
+ */
+
+#ifndef JSDRV_PRV_STATS_ALL_H_
+#define JSDRV_PRV_STATS_ALL_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_stats_all Combined statistics
+ *
+ * @brief Combine the latest statistics from all devices into one message.
+ *
+ * Dashboards with many devices otherwise receive a separate callback
+ * for every device statistics update.  This service subscribes to
+ * "u/+/+/s/stats/value" while JSDRV_MSG_STATISTICS_PERIOD is nonzero
+ * and publishes jsdrv_statistics_all_s to JSDRV_MSG_STATISTICS_ALL.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/**
+ * @brief Clear all entries.
+ *
+ * @param self The combined statistics.
+ */
+void jsdrv_stats_all_clear(struct jsdrv_statistics_all_s * self);
+
+/**
+ * @brief Update the entry for a device.
+ *
+ * @param self The combined statistics.
+ * @param device The device prefix.
+ * @param statistics The latest device statistics.
+ * @return 0, JSDRV_ERROR_PARAMETER_INVALID or JSDRV_ERROR_FULL.
+ *
+ * The entries remain ordered by jsdrv_statistics_all_entry_s.utc.
+ */
+int32_t jsdrv_stats_all_update(struct jsdrv_statistics_all_s * self, const char * device,
+                               const struct jsdrv_statistics_s * statistics);
+
+/**
+ * @brief Remove the entry for a device.
+ *
+ * @param self The combined statistics.
+ * @param device The device prefix.
+ * @return 0 or JSDRV_ERROR_NOT_FOUND.
+ */
+int32_t jsdrv_stats_all_remove(struct jsdrv_statistics_all_s * self, const char * device);
+
+/**
+ * @brief Get the message size.
+ *
+ * @param self The combined statistics.
+ * @return The size in bytes for only the valid entries.
+ */
+uint32_t jsdrv_stats_all_size(const struct jsdrv_statistics_all_s * self);
+
+/// The opaque combined statistics service instance.
+struct jsdrv_stats_all_svc_s;
+
+/**
+ * @brief Initialize the combined statistics service.
+ *
+ * @param context The driver context.
+ * @param[out] instance The new combined statistics service instance.
+ * @return 0 or error code.
+ */
+int32_t jsdrv_stats_all_initialize(struct jsdrv_context_s * context, struct jsdrv_stats_all_svc_s ** instance);
+
+/**
+ * @brief Finalize the combined statistics service.
+ *
+ * @param instance The instance from jsdrv_stats_all_initialize() or NULL.
+ */
+void jsdrv_stats_all_finalize(struct jsdrv_stats_all_svc_s * instance);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_STATS_ALL_H_ */
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Device statistics history.
+ */
+
+#ifndef JSDRV_PRV_STATS_HISTORY_H_
+#define JSDRV_PRV_STATS_HISTORY_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_stats_history Statistics history
+ *
+ * @brief Retain recent device statistics for range queries.
+ *
+ * While JSDRV_MSG_STATISTICS_HISTORY is nonzero, this service
+ * subscribes to "u/+/+/s/stats/value" and retains the most recent
+ * updates from each device in a ring of fixed-size
+ * jsdrv_statistics_s records.  It answers
+ * JSDRV_MSG_STATISTICS_HISTORY_REQ from the ring.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The maximum number of devices with history.
+#define JSDRV_STATS_HISTORY_DEVICES_MAX (32U)
+
+/// The opaque history ring for one device.
+struct jsdrv_stats_history_s;
+
+/**
+ * @brief The function called for each response.
+ *
+ * @param user_data The arbitrary user data.
+ * @param rsp The response with the first rsp->count records populated.
+ *      The pointer remains valid only for the duration of the call.
+ */
+typedef void (*jsdrv_stats_history_rsp_fn)(void * user_data, struct jsdrv_statistics_history_response_s * rsp);
+
+/**
+ * @brief Allocate a new history ring.
+ *
+ * @param capacity The maximum records, 1 to JSDRV_STATISTICS_HISTORY_MAX.
+ * @return The new instance or NULL.
+ */
+struct jsdrv_stats_history_s * jsdrv_stats_history_alloc(uint32_t capacity);
+
+/**
+ * @brief Free a history ring.
+ *
+ * @param self The instance from jsdrv_stats_history_alloc() or NULL.
+ */
+void jsdrv_stats_history_free(struct jsdrv_stats_history_s * self);
+
+/**
+ * @brief Add a record, which replaces the oldest record when full.
+ *
+ * @param self The instance.
+ * @param statistics The statistics to copy.
+ */
+void jsdrv_stats_history_add(struct jsdrv_stats_history_s * self, const struct jsdrv_statistics_s * statistics);
+
+/**
+ * @brief Get the number of retained records.
+ *
+ * @param self The instance or NULL.
+ * @return The number of records.
+ */
+uint32_t jsdrv_stats_history_size(struct jsdrv_stats_history_s * self);
+
+/**
+ * @brief Query the retained records.
+ *
+ * @param self The instance or NULL for no records.
+ * @param req The request.
+ * @param rsp The response workspace.
+ * @param fn The function called for each response.
+ * @param user_data The arbitrary data for fn.
+ * @return 0 or JSDRV_ERROR_PARAMETER_INVALID.
+ *
+ * On success, calls fn at least once, with JSDRV_BUFFER_RESPONSE_FLAG_FINAL
+ * set on the last call.
+ */
+int32_t jsdrv_stats_history_query(struct jsdrv_stats_history_s * self,
+                                  const struct jsdrv_statistics_history_request_s * req,
+                                  struct jsdrv_statistics_history_response_s * rsp,
+                                  jsdrv_stats_history_rsp_fn fn, void * user_data);
+
+/// The opaque statistics history service instance.
+struct jsdrv_stats_history_svc_s;
+
+/**
+ * @brief Initialize the statistics history service.
+ *
+ * @param context The driver context.
+ * @param[out] instance The new statistics history service instance.
+ * @return 0 or error code.
+ */
+int32_t jsdrv_stats_history_initialize(struct jsdrv_context_s * context, struct jsdrv_stats_history_svc_s ** instance);
+
+/**
+ * @brief Finalize the statistics history service.
+ *
+ * @param instance The instance from jsdrv_stats_history_initialize() or NULL.
+ */
+void jsdrv_stats_history_finalize(struct jsdrv_stats_history_svc_s * instance);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_STATS_HISTORY_H_ */
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Event-encoded (change-only) stream messages.
+ */
+
+#ifndef JSDRV_PRV_STREAM_EVENT_H__
+#define JSDRV_PRV_STREAM_EVENT_H__
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_stream_event Stream events
+ *
+ * @brief Encode sub-byte signals as value changes.
+ *
+ * The current range and GPI signals rarely change, but the packed
+ * stream format still carries every sample.  The event format
+ * carries only the changes as jsdrv_stream_event_s entries, see
+ * JSDRV_PAYLOAD_TYPE_STREAM_EVENT.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The maximum number of events in each message.
+#define JSDRV_STREAM_EVENT_COUNT_MAX (256U)
+
+/// The message value size for JSDRV_STREAM_EVENT_COUNT_MAX events.
+#define JSDRV_STREAM_EVENT_SIZE_MAX \
+    (JSDRV_STREAM_HEADER_SIZE + JSDRV_STREAM_EVENT_COUNT_MAX * sizeof(struct jsdrv_stream_event_s))
+
+/// The maximum duration of each message at the default stream latency.
+#define JSDRV_STREAM_EVENT_SPAN_MS (1000U)
+
+/**
+ * @brief Get the number of events in a message.
+ *
+ * @param size The message value size in bytes.
+ * @return The number of jsdrv_stream_event_s entries.
+ */
+static inline uint32_t jsdrv_stream_event_count(uint32_t size) {
+    if (size <= JSDRV_STREAM_HEADER_SIZE) {
+        return 0;
+    }
+    return (size - JSDRV_STREAM_HEADER_SIZE) / (uint32_t) sizeof(struct jsdrv_stream_event_s);
+}
+
+/**
+ * @brief Add packed samples to an event-encoded message.
+ *
+ * @param s The message with element_size_bits of 1, 2, 4 or 8.
+ *      element_count advances by the consumed samples.
+ * @param size[inout] The message value size in bytes, including the header.
+ * @param capacity The message capacity in bytes.
+ * @param x The samples packed in the stream format with the
+ *      first sample in the least significant bits.
+ * @param offset The index of the first sample to add in x.
+ * @param n The number of samples to add.
+ * @return The number of samples consumed.  When less than n, the
+ *      next sample changes the value but the message is full.
+ *      Send the message and add the remaining samples to a new one.
+ */
+uint32_t jsdrv_stream_event_add_packed(struct jsdrv_stream_signal_s * s, uint32_t * size, uint32_t capacity,
+                                       const uint8_t * x, uint32_t offset, uint32_t n);
+
+/**
+ * @brief Add samples with one sample per byte to an event-encoded message.
+ *
+ * @param s The message.  Only the lower element_size_bits of each sample are used.
+ * @param size[inout] The message value size in bytes, including the header.
+ * @param capacity The message capacity in bytes.
+ * @param x The samples, one per byte.
+ * @param n The number of samples.
+ * @return The number of samples consumed.
+ *
+ * @see jsdrv_stream_event_add_packed
+ */
+uint32_t jsdrv_stream_event_add_u8(struct jsdrv_stream_signal_s * s, uint32_t * size, uint32_t capacity,
+                                   const uint8_t * x, uint32_t n);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_STREAM_EVENT_H__ */
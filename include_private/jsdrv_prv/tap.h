@@ -0,0 +1,149 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Additional lower-rate outputs for a signal.
+ */
+
+#ifndef JSDRV_PRV_TAP_H_
+#define JSDRV_PRV_TAP_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_tap Output taps
+ *
+ * @brief Publish a float signal at additional, lower sample rates.
+ *
+ * A device publishes each float signal (current, voltage, power)
+ * at the host sample rate "h/fs" to "s/{i, v, p}/!data".  Setting
+ * "h/tap/N/fs" to a nonzero rate also publishes each enabled
+ * signal to "s/{i, v, p}/tap/N/!data" at that rate.  Each tap
+ * downsamples the published stream, so the expensive early
+ * filter stages run once, at the full rate, for all outputs.
+ * A low-rate consumer, like a dashboard, then receives only the
+ * samples it needs while a recorder receives the full rate.
+ *
+ * A tap rate must evenly divide the published stream rate.  A tap
+ * that cannot downsample its input publishes nothing.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+struct jsdrv_context_s;
+struct jsdrv_downsample_s;
+
+/// The number of taps for each signal.
+#define JSDRV_TAP_COUNT (2U)
+
+/// The tap state for one signal.
+struct jsdrv_tap_s {
+    uint32_t fs;                ///< The output sample rate, 0 when off.
+    int mode;                   ///< The jsdrv_downsample_mode_e for downsample.
+    uint32_t input_factor;      ///< The input decimate factor relative to the base sample rate.
+    struct jsdrv_downsample_s * downsample;  ///< The downsampler, NULL when off or invalid.
+    uint64_t sample_id_next;    ///< The next expected input sample index.
+};
+
+/**
+ * @brief Initialize the instance to off.
+ *
+ * @param self The instance.
+ */
+void jsdrv_tap_initialize(struct jsdrv_tap_s * self);
+
+/**
+ * @brief Free the instance resources.
+ *
+ * @param self The instance, which is off on return.
+ */
+void jsdrv_tap_finalize(struct jsdrv_tap_s * self);
+
+/**
+ * @brief Clear the downsampling state.
+ *
+ * @param self The instance.
+ *
+ * Call on stream restart.  jsdrv_tap_process() also clears on
+ * input discontinuities.
+ */
+void jsdrv_tap_clear(struct jsdrv_tap_s * self);
+
+/**
+ * @brief Configure a tap sample rate.
+ *
+ * @param fs The JSDRV_TAP_COUNT tap sample rates.
+ * @param topic The device topic "h/tap/N/fs".
+ * @param value The new sample rate, 0 for off.
+ * @return 0 or JSDRV_ERROR_PARAMETER_INVALID.
+ */
+int32_t jsdrv_tap_param(uint32_t * fs, const char * topic, const struct jsdrv_union_s * value);
+
+/**
+ * @brief Configure the tap for its input.
+ *
+ * @param self The instance.
+ * @param sample_rate The base sample rate in Hz.
+ * @param fs The tap output sample rate in Hz, 0 for off.
+ * @param mode The jsdrv_downsample_mode_e.
+ * @param input_factor The decimate factor of the input samples
+ *      relative to sample_rate.
+ * @return The output decimate factor relative to sample_rate, or 0
+ *      when the tap is off or cannot downsample its input.
+ *
+ * Call before each jsdrv_tap_process().  A change to fs, mode or
+ * input_factor reallocates the downsampler.
+ */
+uint32_t jsdrv_tap_configure(struct jsdrv_tap_s * self, uint32_t sample_rate, uint32_t fs, int mode,
+                             uint32_t input_factor);
+
+/**
+ * @brief Downsample contiguous samples.
+ *
+ * @param self The instance.
+ * @param sample_id The base sample rate sample id for x[0].  Sample x[i]
+ *      has sample id sample_id + i * input_factor.
+ * @param x The input samples.
+ * @param n The number of input samples.
+ * @param[out] y The output samples, which must have space for n samples.
+ * @param[out] y_sample_id The base sample rate sample id for y[0],
+ *      only valid when the return value is nonzero.
+ * @return The number of output samples written to y.
+ */
+uint32_t jsdrv_tap_process(struct jsdrv_tap_s * self, uint64_t sample_id, const float * x, uint32_t n,
+                           float * y, uint64_t * y_sample_id);
+
+/**
+ * @brief Publish the "h/tap/..." metadata for a device.
+ *
+ * @param context The driver context.
+ * @param prefix The device prefix.
+ */
+void jsdrv_tap_meta_publish(struct jsdrv_context_s * context, const char * prefix);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_TAP_H_ */
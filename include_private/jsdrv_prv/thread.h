@@ -31,6 +31,7 @@
 #include <pthread.h>
 #endif
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
  * @ingroup jsdrv_prv
@@ -38,6 +39,14 @@
  *
  * @brief Provide a simple thread abstraction.
  *
+ * Each long-running driver thread registers itself with its role
+ * using jsdrv_thread_register().  jsdrv_thread_policy_set() then
+ * applies a scheduling policy, priority and CPU affinity to all
+ * registered threads of a role, including threads started later.
+ * The frontend exposes the policy for each role as
+ * "@/threads/{role}/policy", "@/threads/{role}/prio" and
+ * "@/threads/{role}/cpus".
+ *
  * @{
  */
 
@@ -83,6 +92,131 @@ JSDRV_API int32_t jsdrv_thread_join(jsdrv_thread_t * thread, uint32_t timeout_ms
 JSDRV_API bool jsdrv_thread_is_current(jsdrv_thread_t const * thread);
 JSDRV_API void jsdrv_thread_sleep_ms(uint32_t duration_ms);
 
+/// The thread roles for the thread policy.
+enum jsdrv_thread_role_e {
+    JSDRV_THREAD_ROLE_FRONTEND = 0, ///< The frontend pubsub thread.
+    JSDRV_THREAD_ROLE_USB = 1,      ///< The USB backend threads, including emulation and replay.
+    JSDRV_THREAD_ROLE_DEVICE = 2,   ///< The js220_usb and js110_usb driver threads that decode samples.
+    JSDRV_THREAD_ROLE_BUFFER = 3,   ///< The memory buffer threads.
+    JSDRV_THREAD_ROLE_DISPATCH = 4, ///< The frontend data and queued subscriber threads.
+    JSDRV_THREAD_ROLE_WRITER = 5,   ///< The file writer threads.
+    JSDRV_THREAD_ROLE_NET = 6,      ///< The network client and server threads.
+    JSDRV_THREAD_ROLE_LOG = 7,      ///< The log thread.
+    JSDRV_THREAD_ROLE_COUNT,
+};
+
+/// The scheduling policies.
+enum jsdrv_thread_sched_e {
+    JSDRV_THREAD_SCHED_DEFAULT = 0, ///< Do not change the scheduling policy or priority.
+    JSDRV_THREAD_SCHED_OTHER = 1,   ///< Time sharing, priority is the nice value from -20 (highest) to 19.
+    JSDRV_THREAD_SCHED_FIFO = 2,    ///< Real-time first in, first out, priority 1 to 99 (highest).
+    JSDRV_THREAD_SCHED_RR = 3,      ///< Real-time round robin, priority 1 to 99 (highest).
+};
+
+/// The thread policy for a role.
+struct jsdrv_thread_policy_s {
+    uint8_t sched;          ///< The jsdrv_thread_sched_e.
+    int32_t priority;       ///< The priority, which depends upon sched.
+    uint64_t affinity;      ///< The CPU bit mask, or 0 to leave unchanged.
+};
+
+/**
+ * @brief Get the role name.
+ *
+ * @param role The jsdrv_thread_role_e.
+ * @return The name, like "usb", or NULL if invalid.
+ */
+JSDRV_API const char * jsdrv_thread_role_name(uint8_t role);
+
+/**
+ * @brief Register the calling thread.
+ *
+ * @param role The jsdrv_thread_role_e.
+ *
+ * Applies the current role policy to the calling thread.  Call
+ * jsdrv_thread_unregister() from the same thread before it exits.
+ */
+JSDRV_API void jsdrv_thread_register(uint8_t role);
+
+/// Unregister the calling thread.
+JSDRV_API void jsdrv_thread_unregister(void);
+
+/**
+ * @brief Set the policy for a thread role.
+ *
+ * @param role The jsdrv_thread_role_e.
+ * @param policy The new policy.
+ * @return 0, JSDRV_ERROR_PARAMETER_INVALID, JSDRV_ERROR_PERMISSIONS or
+ *      JSDRV_ERROR_NOT_SUPPORTED.
+ *
+ * The policy is stored and applied to all registered threads for the
+ * role, even when one fails.  Real-time policies and negative nice
+ * values usually need elevated privileges, such as CAP_SYS_NICE or
+ * RLIMIT_RTPRIO on Linux.  Windows maps the policy to the nearest
+ * SetThreadPriority level.  macOS does not support affinity or nice.
+ */
+JSDRV_API int32_t jsdrv_thread_policy_set(uint8_t role, const struct jsdrv_thread_policy_s * policy);
+
+/**
+ * @brief Get the policy for a thread role.
+ *
+ * @param role The jsdrv_thread_role_e.
+ * @param[out] policy The current policy.
+ * @return 0 or JSDRV_ERROR_PARAMETER_INVALID.
+ */
+JSDRV_API int32_t jsdrv_thread_policy_get(uint8_t role, struct jsdrv_thread_policy_s * policy);
+
+/**
+ * @brief Get the number of registered threads for a role.
+ *
+ * @param role The jsdrv_thread_role_e.
+ * @return The number of registered threads.
+ */
+JSDRV_API uint32_t jsdrv_thread_role_count(uint8_t role);
+
+/// The CPU time of a registered thread.
+struct jsdrv_thread_cpu_s {
+    uint8_t role;           ///< The jsdrv_thread_role_e.
+    int64_t id;             ///< The operating system thread id.
+    int64_t cpu_time;       ///< The user and system CPU time in JSDRV time units, or -1 if unavailable.
+};
+
+/**
+ * @brief Get the CPU time for all registered threads.
+ *
+ * @param[out] threads The thread CPU times.
+ * @param threads_max The maximum number of entries in threads.
+ * @return The number of entries written to threads.
+ *
+ * Sample twice and match entries by id to measure the CPU usage
+ * over an interval.
+ */
+JSDRV_API uint32_t jsdrv_thread_cpu_get(struct jsdrv_thread_cpu_s * threads, uint32_t threads_max);
+
+struct jsdrv_context_s;
+
+/// The opaque "@/threads" frontend service instance.
+struct jsdrv_thread_svc_s;
+
+/**
+ * @brief Initialize the "@/threads" frontend service.
+ *
+ * @param context The driver context.
+ * @param[out] instance The new service instance.
+ * @return 0 or error code.
+ *
+ * The thread policies are process-wide, so each context's service
+ * configures the same policies.
+ */
+int32_t jsdrv_thread_policy_initialize(struct jsdrv_context_s * context, struct jsdrv_thread_svc_s ** instance);
+
+/**
+ * @brief Finalize the "@/threads" frontend service.
+ *
+ * @param instance The instance from jsdrv_thread_policy_initialize() or NULL.
+ */
+void jsdrv_thread_policy_finalize(struct jsdrv_thread_svc_s * instance);
+
 JSDRV_CPP_GUARD_END
 
 /** @} */
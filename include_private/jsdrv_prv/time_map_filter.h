@@ -25,6 +25,7 @@
 #define JSDRV_TIME_MAP_FILTER_H__
 
 #include "jsdrv/time.h"
+#include <stdbool.h>
 
 /**
  * @ingroup jsdrv_prv
@@ -65,6 +66,19 @@ void jsdrv_tmf_free(struct jsdrv_tmf_s * self);
  */
 void jsdrv_tmf_clear(struct jsdrv_tmf_s * self);
 
+/**
+ * @brief Enable least-squares counter drift estimation.
+ *
+ * @param self The instance.
+ * @param enable True to update counter_rate from a least-squares fit
+ *      over the saved points.  False to use the counter_rate provided to
+ *      jsdrv_tmf_new().
+ *
+ * The rate estimate applies once every "points" additions and ignores
+ * estimates more than 1000 ppm from the nominal rate.
+ */
+void jsdrv_tmf_drift_set(struct jsdrv_tmf_s * self, bool enable);
+
 /**
  * @brief Add a new entry.
  *
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Sorted topic lookup for constant parameter tables.
+ */
+
+#ifndef JSDRV_PRV_TOPIC_INDEX_H_
+#define JSDRV_PRV_TOPIC_INDEX_H_
+
+#include "jsdrv/cmacro_inc.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_topic_index Topic index
+ *
+ * @brief Find table entries by topic using binary search.
+ *
+ * The device drivers define constant tables of structures that each
+ * contain a topic string.  The index sorts the entry indices by topic
+ * once, so that each lookup takes O(log n) string compares rather than
+ * comparing the topic against every entry.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The topic index instance.
+struct jsdrv_topic_index_s {
+    const uint8_t * table;      ///< The first table entry.
+    size_t stride;              ///< The size of each table entry in bytes.
+    size_t offset;              ///< The offset to the "const char *" topic in each entry.
+    uint16_t count;             ///< The number of indexed entries.
+    uint16_t * idx;             ///< The entry indices sorted by topic, count entries.
+};
+
+/**
+ * @brief Initialize a topic index.
+ *
+ * @param self The instance.
+ * @param table The table of entries.
+ * @param stride The size of each entry, usually sizeof(table[0]).
+ * @param offset The offset of the topic in each entry, usually offsetof().
+ * @param count The number of table entries.  Entries with a NULL topic
+ *      are not indexed.
+ * @param idx The storage for count entry indices.
+ */
+void jsdrv_topic_index_init(struct jsdrv_topic_index_s * self, const void * table,
+        size_t stride, size_t offset, uint16_t count, uint16_t * idx);
+
+/**
+ * @brief Find a table entry by topic.
+ *
+ * @param self The instance.
+ * @param topic The exact topic to find.
+ * @return The table entry index or -1 if not found.
+ */
+int32_t jsdrv_topic_index_find(const struct jsdrv_topic_index_s * self, const char * topic);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_TOPIC_INDEX_H_ */
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Driver thread activity trace.
+ */
+
+#ifndef JSDRV_PRV_TRACE_H_
+#define JSDRV_PRV_TRACE_H_
+
+#include "jsdrv/cmacro_inc.h"
+#include "jsdrv_prv/atomic.h"
+#include "jsdrv_prv/perf.h"
+#include "jsdrv/time.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_trace Thread activity trace
+ *
+ * @brief Record the main loop stages of the driver threads over time.
+ *
+ * Each thread records spans into its own ring buffer, which it
+ * allocates on its first span after jsdrv_trace_start().  Recording
+ * takes no lock and keeps the most recent events per thread.
+ * The buffers outlive their threads until the next
+ * jsdrv_trace_start() or jsdrv_trace_release(), so the trace still
+ * contains device threads that exited before the dump.
+ * jsdrv_trace_write() dumps all threads in the Chrome trace event
+ * JSON format, which chrome://tracing and ui.perfetto.dev load.
+ *
+ * The frontend controls the trace with JSDRV_MSG_TRACE.  Tracing
+ * shares JSDRV_PERF_ENABLE with the performance counters.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The default events per thread.
+#define JSDRV_TRACE_EVENTS_DEFAULT (65536U)
+
+/// The maximum events per thread.
+#define JSDRV_TRACE_EVENTS_MAX (1U << 24)
+
+/// The maximum number of traced threads.
+#define JSDRV_TRACE_THREAD_MAX (64U)
+
+/// A recorded span.
+struct jsdrv_trace_event_s {
+    int64_t start;          ///< The jsdrv_time_monotonic() start time.
+    int64_t duration;       ///< The duration in jsdrv time units.
+    const char * name;      ///< The span name, which must be a static string.
+    uint64_t arg;           ///< The span argument, such as the number of messages processed.
+};
+
+/// Nonzero while recording, read with jsdrv_trace_is_active().
+extern volatile int32_t jsdrv_trace_active;
+
+/// Check if the trace is recording.
+JSDRV_INLINE_FN bool jsdrv_trace_is_active(void) {
+    return 0 != jsdrv_atomic_load(&jsdrv_trace_active);
+}
+
+/**
+ * @brief Start recording.
+ *
+ * @param events_per_thread The ring buffer size for each thread, which
+ *      rounds up to a power of 2.  0 selects JSDRV_TRACE_EVENTS_DEFAULT.
+ * @return 0 or error code.
+ *
+ * Discards any previous trace.
+ */
+int32_t jsdrv_trace_start(uint32_t events_per_thread);
+
+/// Stop recording and keep the trace for jsdrv_trace_write().
+void jsdrv_trace_stop(void);
+
+/**
+ * @brief Write the trace as Chrome trace event JSON.
+ *
+ * @param path The output file path.
+ * @return 0 or error code.  JSDRV_ERROR_BUSY while recording.
+ */
+int32_t jsdrv_trace_write(const char * path);
+
+/**
+ * @brief Get the number of events in the trace.
+ *
+ * @return The total events over all threads available to jsdrv_trace_write().
+ */
+uint64_t jsdrv_trace_event_count(void);
+
+/// Free the buffers of exited threads, which jsdrv_finalize() calls.
+void jsdrv_trace_release(void);
+
+/**
+ * @brief Associate the calling thread with a role.
+ *
+ * @param role The jsdrv_thread_role_e for the trace thread name.
+ *
+ * jsdrv_thread_register() calls this function for all driver threads.
+ */
+void jsdrv_trace_thread_start(uint8_t role);
+
+/**
+ * @brief Detach the calling thread from its buffer.
+ *
+ * The buffer remains in the trace.  jsdrv_thread_unregister() calls
+ * this function for all driver threads.
+ */
+void jsdrv_trace_thread_stop(void);
+
+/**
+ * @brief Record a span for the calling thread.
+ *
+ * @param name The span name, which must be a static string.
+ * @param start The jsdrv_time_monotonic() start time.
+ * @param arg The span argument.
+ */
+void jsdrv_trace_span(const char * name, int64_t start, uint64_t arg);
+
+#if JSDRV_PERF_ENABLE
+#define JSDRV_TRACE_START(var)              int64_t var = jsdrv_trace_is_active() ? jsdrv_time_monotonic() : 0
+#define JSDRV_TRACE_END(name, var, arg)     do { if (var) { jsdrv_trace_span((name), (var), (arg)); } } while (0)
+#else
+#define JSDRV_TRACE_START(var)
+#define JSDRV_TRACE_END(name, var, arg)     (void) (arg)
+#endif
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_TRACE_H_ */
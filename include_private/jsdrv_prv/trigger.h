@@ -0,0 +1,203 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Host-side level triggers over sample streams.
+ */
+
+#ifndef JSDRV_PRV_TRIGGER_H_
+#define JSDRV_PRV_TRIGGER_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_trigger Triggers
+ *
+ * @brief Detect level crossings in the device decode loop.
+ *
+ * Each device provides JSDRV_TRIGGER_COUNT triggers configured by
+ * "h/trig/N/{source, level, edge, hyst, dur, snap}".  A trigger
+ * watches one signal for a crossing of level with hysteresis.  The
+ * crossing matches once the signal stays past the level for dur
+ * seconds, and the device publishes jsdrv_trigger_event_s to
+ * "h/trig/N/!event".  A nonzero snap also snapshots that memory buffer.
+ *
+ * The hysteresis band is [level - hyst, level] for rising edges,
+ * [level, level + hyst] for falling edges, and centered on level
+ * for both edges.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+struct jsdrv_context_s;
+
+/// The number of triggers for each device.
+#define JSDRV_TRIGGER_COUNT (4U)
+
+/// The trigger source signals, the "h/trig/N/source" options.
+enum jsdrv_trigger_source_e {
+    JSDRV_TRIGGER_SOURCE_OFF = 0,
+    JSDRV_TRIGGER_SOURCE_CURRENT = 1,
+    JSDRV_TRIGGER_SOURCE_VOLTAGE = 2,
+    JSDRV_TRIGGER_SOURCE_POWER = 3,
+    JSDRV_TRIGGER_SOURCE_GPI0 = 4,
+    JSDRV_TRIGGER_SOURCE_GPI1 = 5,
+    JSDRV_TRIGGER_SOURCE_COUNT,
+};
+
+/// The trigger edges, the "h/trig/N/edge" options.
+enum jsdrv_trigger_edge_e {
+    JSDRV_TRIGGER_EDGE_RISING = 0,
+    JSDRV_TRIGGER_EDGE_FALLING = 1,
+    JSDRV_TRIGGER_EDGE_BOTH = 2,
+};
+
+/// The trigger configuration fields, in "h/trig/N/" topic order.
+enum jsdrv_trigger_field_e {
+    JSDRV_TRIGGER_FIELD_SOURCE,
+    JSDRV_TRIGGER_FIELD_LEVEL,
+    JSDRV_TRIGGER_FIELD_EDGE,
+    JSDRV_TRIGGER_FIELD_HYST,
+    JSDRV_TRIGGER_FIELD_DUR,
+    JSDRV_TRIGGER_FIELD_SNAP,
+    JSDRV_TRIGGER_FIELD_COUNT,
+};
+
+/// The trigger instance.
+struct jsdrv_trigger_s {
+    uint8_t index;              ///< The trigger index N.
+    uint8_t source;             ///< jsdrv_trigger_source_e
+    uint8_t edge;               ///< jsdrv_trigger_edge_e
+    uint8_t snap;               ///< The memory buffer id to snapshot on match, or 0.
+    float level;                ///< The level in signal units.
+    float hyst;                 ///< The hysteresis in signal units.
+    float duration;             ///< The time past the level to match, in seconds.
+    int8_t state;               ///< -1 unknown, 0 below, 1 above.
+    uint8_t pending;            ///< 1 when a crossing awaits duration.
+    uint64_t pending_count;     ///< The samples past the level for the pending crossing.
+    uint64_t sample_id_next;    ///< The sample_id for the next sample, 0 before the first.
+    struct jsdrv_trigger_event_s event;
+};
+
+/**
+ * @brief Initialize the instance to the default, disabled configuration.
+ *
+ * @param self The instance.
+ * @param index The trigger index N.
+ */
+void jsdrv_trigger_initialize(struct jsdrv_trigger_s * self, uint8_t index);
+
+/**
+ * @brief Clear the detection state.
+ *
+ * @param self The instance.
+ *
+ * Call on stream restart.  The next sample establishes the state
+ * without matching.
+ */
+void jsdrv_trigger_clear(struct jsdrv_trigger_s * self);
+
+/**
+ * @brief Get the topic name for a configuration field.
+ *
+ * @param field The jsdrv_trigger_field_e.
+ * @return The name, or NULL if field is invalid.
+ */
+const char * jsdrv_trigger_field_name(uint8_t field);
+
+/**
+ * @brief Get the JSON metadata for a configuration field.
+ *
+ * @param field The jsdrv_trigger_field_e.
+ * @return The metadata, or NULL if field is invalid.
+ */
+const char * jsdrv_trigger_field_meta(uint8_t field);
+
+/**
+ * @brief Configure a trigger.
+ *
+ * @param triggers The JSDRV_TRIGGER_COUNT trigger instances.
+ * @param topic The device topic "h/trig/N/{field}".
+ * @param value The new value.
+ * @return 0 or JSDRV_ERROR_PARAMETER_INVALID.
+ *
+ * Changes clear the detection state of that trigger.
+ */
+int32_t jsdrv_trigger_param(struct jsdrv_trigger_s * triggers, const char * topic, const struct jsdrv_union_s * value);
+
+/**
+ * @brief Add contiguous f32 samples.
+ *
+ * @param self The instance.
+ * @param sample_id The sample_id for the first sample.
+ * @param sample_rate The sample_id frequency.
+ * @param decimate_factor The sample_id increment for each sample.
+ * @param x The samples.  NaN samples are ignored.
+ * @param count The number of samples.
+ * @param event[out] NULL or the event when the consumed samples
+ *      complete a match.  The caller populates utc.  The event
+ *      remains valid until the next call with self.
+ * @return The number of samples consumed, which stops at each match.
+ *      Call again with the remaining samples.
+ *
+ * A sample_id discontinuity clears the detection state.
+ */
+uint32_t jsdrv_trigger_add_f32(struct jsdrv_trigger_s * self, uint64_t sample_id,
+        uint32_t sample_rate, uint32_t decimate_factor,
+        const float * x, uint32_t count, struct jsdrv_trigger_event_s ** event);
+
+/**
+ * @brief Add contiguous u8 samples, one sample per byte.
+ *
+ * @see jsdrv_trigger_add_f32
+ */
+uint32_t jsdrv_trigger_add_u8(struct jsdrv_trigger_s * self, uint64_t sample_id,
+        uint32_t sample_rate, uint32_t decimate_factor,
+        const uint8_t * x, uint32_t count, struct jsdrv_trigger_event_s ** event);
+
+/**
+ * @brief Publish the "h/trig/N/..." metadata for a device.
+ *
+ * @param context The driver context.
+ * @param prefix The device prefix.
+ */
+void jsdrv_trigger_meta_publish(struct jsdrv_context_s * context, const char * prefix);
+
+/**
+ * @brief Publish the event for a match.
+ *
+ * @param context The driver context.
+ * @param prefix The device prefix.
+ * @param self The instance with the populated event.
+ *
+ * Publishes self->event to "{prefix}/h/trig/N/!event" and, when
+ * configured, snapshots the memory buffer.
+ */
+void jsdrv_trigger_event_publish(struct jsdrv_context_s * context, const char * prefix,
+                                 const struct jsdrv_trigger_s * self);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_TRIGGER_H_ */
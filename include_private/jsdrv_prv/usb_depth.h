@@ -0,0 +1,114 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Adapt the USB bulk in transfer depth.
+ */
+
+#ifndef JSDRV_PRV_USB_DEPTH_H_
+#define JSDRV_PRV_USB_DEPTH_H_
+
+#include "jsdrv/cmacro_inc.h"
+#include "jsdrv/time.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_usb_depth Adaptive USB bulk in depth
+ *
+ * @brief Select the number of outstanding bulk in transfers.
+ *
+ * The backend reports pressure when the host falls behind: all
+ * outstanding transfers completed before the backend resubmitted
+ * any, the upper layer holds too many completed transfers, or the
+ * upper layer detected a sample skip.  Each pressure event doubles
+ * the depth up to the maximum.  Pressure during the hold time after
+ * a grow is ignored, so that a single stall grows the depth once.
+ * After each quiet time without pressure, the depth decreases by
+ * one towards the minimum.
+ *
+ * The caller provides the time, normally jsdrv_time_monotonic(),
+ * and owns all synchronization.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The time after a grow that ignores further pressure.
+#define JSDRV_USB_DEPTH_HOLD (100 * JSDRV_TIME_MILLISECOND)
+
+/// The time without pressure for each depth decrease.
+#define JSDRV_USB_DEPTH_QUIET (10 * JSDRV_TIME_SECOND)
+
+/// The adaptive depth state.
+struct jsdrv_usb_depth_s {
+    uint32_t depth;         ///< The current depth.
+    uint32_t depth_min;     ///< The configured depth.
+    uint32_t depth_max;     ///< The maximum depth, equal to depth_min when fixed.
+    int64_t hold_end;       ///< The time that the last grow takes effect.
+    int64_t quiet_start;    ///< The time of the last pressure or decrease.
+};
+
+/**
+ * @brief Initialize the state.
+ *
+ * @param self The instance.
+ * @param depth_min The configured depth, which is also the initial depth.
+ * @param depth_max The maximum depth.  Values at or below depth_min
+ *      fix the depth at depth_min.
+ * @param now The current time.
+ */
+void jsdrv_usb_depth_init(struct jsdrv_usb_depth_s * self, uint32_t depth_min, uint32_t depth_max, int64_t now);
+
+/**
+ * @brief Check for adaptive operation.
+ *
+ * @param self The instance.
+ * @return True when the depth may change.
+ */
+static inline bool jsdrv_usb_depth_is_adaptive(const struct jsdrv_usb_depth_s * self) {
+    return self->depth_max > self->depth_min;
+}
+
+/**
+ * @brief Report pressure.
+ *
+ * @param self The instance.
+ * @param now The current time.
+ * @return The new depth.
+ */
+uint32_t jsdrv_usb_depth_pressure(struct jsdrv_usb_depth_s * self, int64_t now);
+
+/**
+ * @brief Decrease the depth after the quiet time.
+ *
+ * @param self The instance.
+ * @param now The current time.
+ * @return The new depth.
+ *
+ * Call periodically, such as on each transfer completion.
+ */
+uint32_t jsdrv_usb_depth_update(struct jsdrv_usb_depth_s * self, int64_t now);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_USB_DEPTH_H_ */
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Record and read low-level USB device traces.
+ */
+
+#ifndef JSDRV_PRV_USB_TRACE_H_
+#define JSDRV_PRV_USB_TRACE_H_
+
+#include "jsdrv.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_usb_trace USB trace
+ *
+ * @brief Capture the traffic between a USB backend and the upper-level driver.
+ *
+ * A backend with JSDRV_ARG_USB_TRACE records each completed control
+ * transfer, bulk out transfer and bulk in transfer for a device from
+ * open until close.  The trace contains exactly what the upper-level
+ * driver saw, so the replay backend can feed it back through the
+ * normal js220_usb and js110_usb drivers to reproduce host-side
+ * problems or to benchmark the host-side pipeline with real data.
+ *
+ * The writer copies each record into the buffers of a
+ * jsdrv_file_writer_s, so it never blocks the backend thread on
+ * storage.  When the writer falls behind, the trace drops the record
+ * and counts the drop in the END record.  The writer supports a single
+ * producer thread.
+ *
+ * The file starts with jsdrv_usb_trace_header_s followed by records.
+ * Each record is a jsdrv_usb_trace_record_s followed by payload_size
+ * bytes and zero padding to the next multiple of 8 bytes.  All values
+ * are little endian.  The END record contains jsdrv_usb_trace_status_s
+ * and only exists after a clean close.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The jsdrv_usb_trace_header_s magic value.
+#define JSDRV_USB_TRACE_MAGIC       "jsdrvusb"
+/// The file format version.
+#define JSDRV_USB_TRACE_VERSION     (1U)
+/// The trace file name extension.
+#define JSDRV_USB_TRACE_EXTENSION   ".usbtrace"
+/// The maximum record payload size in bytes.
+#define JSDRV_USB_TRACE_PAYLOAD_MAX (1024U * 1024U)
+
+/// The record types.
+enum jsdrv_usb_trace_type_e {
+    JSDRV_USB_TRACE_CTRL_IN = 1,    ///< Control in: setup, status and the received data.
+    JSDRV_USB_TRACE_CTRL_OUT = 2,   ///< Control out: setup, status and the sent data.
+    JSDRV_USB_TRACE_BULK_OUT = 3,   ///< Bulk out: endpoint, status and the sent data.
+    JSDRV_USB_TRACE_BULK_IN = 4,    ///< Bulk in: endpoint and the data loaned to the upper layer.
+    JSDRV_USB_TRACE_END = 5,        ///< jsdrv_usb_trace_status_s.
+};
+
+/// The file header.
+struct jsdrv_usb_trace_header_s {
+    char magic[8];          ///< JSDRV_USB_TRACE_MAGIC without the nul terminator.
+    uint32_t version;       ///< JSDRV_USB_TRACE_VERSION.
+    uint32_t header_size;   ///< sizeof(struct jsdrv_usb_trace_header_s).
+    int64_t utc;            ///< The open time as 34Q30 UTC.
+    char prefix[JSDRV_TOPIC_LENGTH_MAX];  ///< The nul-terminated device prefix, like "u/js220/000415".
+};
+
+/// The record header.
+struct jsdrv_usb_trace_record_s {
+    uint8_t type;           ///< The jsdrv_usb_trace_type_e.
+    uint8_t endpoint;       ///< The bulk endpoint, or 0 for control and END.
+    uint16_t rsv;           ///< Reserved, write 0.
+    uint32_t payload_size;  ///< The payload size in bytes, excluding padding.
+    int64_t time;           ///< The completion time as 34Q30 UTC.
+    uint64_t setup;         ///< The usb_setup_t for control transfers, otherwise 0.
+    int32_t status;         ///< The transfer status as a JSDRV_ERROR_* code.
+    uint32_t rsv2;          ///< Reserved, write 0.
+};
+
+/// The trace status.
+struct jsdrv_usb_trace_status_s {
+    uint64_t record_count;  ///< The number of recorded transfers.
+    uint64_t drop_count;    ///< The number of dropped transfers.
+    uint64_t bytes_written; ///< The bytes appended, or in END, the bytes preceding END.
+};
+
+// opaque instances
+struct jsdrv_usb_trace_s;
+struct jsdrv_usb_trace_reader_s;
+
+/**
+ * @brief Construct the trace file path for a device.
+ *
+ * @param dir The JSDRV_ARG_USB_TRACE directory.
+ * @param prefix The device prefix, like "u/js220/000415".
+ * @param[out] path The path, like "{dir}/js220_000415.usbtrace".
+ * @param path_size The size of path in bytes.
+ * @return 0 or JSDRV_ERROR_TOO_SMALL.
+ */
+int32_t jsdrv_usb_trace_path(const char * dir, const char * prefix, char * path, size_t path_size);
+
+/**
+ * @brief Start a new trace.
+ *
+ * @param path The file path, which is created or truncated.
+ * @param prefix The device prefix.
+ * @return The trace or NULL on error.
+ */
+struct jsdrv_usb_trace_s * jsdrv_usb_trace_open(const char * path, const char * prefix);
+
+/**
+ * @brief Record a transfer.
+ *
+ * @param self The trace.  NULL is allowed and ignored.
+ * @param type The jsdrv_usb_trace_type_e.
+ * @param endpoint The bulk endpoint, or 0 for control transfers.
+ * @param setup The usb_setup_t u64 for control transfers, otherwise 0.
+ * @param status The transfer status as a JSDRV_ERROR_* code.
+ * @param data The transfer data, which is copied.
+ * @param size The size of data in bytes.
+ * @return 0, JSDRV_ERROR_PARAMETER_INVALID or JSDRV_ERROR_FULL when dropped.
+ *
+ * This function never blocks on the file.
+ */
+int32_t jsdrv_usb_trace_write(struct jsdrv_usb_trace_s * self, uint8_t type, uint8_t endpoint,
+                              uint64_t setup, int32_t status, const void * data, uint32_t size);
+
+/**
+ * @brief Get the trace status.
+ *
+ * @param self The trace.
+ * @param status[out] The status.
+ */
+void jsdrv_usb_trace_status(struct jsdrv_usb_trace_s * self, struct jsdrv_usb_trace_status_s * status);
+
+/**
+ * @brief Stop a trace.
+ *
+ * @param self The trace, which is freed.  NULL is allowed and ignored.
+ * @return 0 or JSDRV_ERROR_IO when any write failed.
+ *
+ * Blocks until the writer thread writes all buffered data.
+ */
+int32_t jsdrv_usb_trace_close(struct jsdrv_usb_trace_s * self);
+
+/**
+ * @brief Open a trace for reading.
+ *
+ * @param path The file path.
+ * @param[out] header The file header.
+ * @return The reader or NULL on error.
+ */
+struct jsdrv_usb_trace_reader_s * jsdrv_usb_trace_reader_open(const char * path,
+                                                              struct jsdrv_usb_trace_header_s * header);
+
+/**
+ * @brief Read the next record.
+ *
+ * @param self The reader.
+ * @param[out] record The record header.
+ * @param[out] payload The payload, valid until the next call.  NULL to
+ *      skip the payload without reading it.
+ * @return 0, JSDRV_ERROR_UNAVAILABLE at the end of the trace, or
+ *      JSDRV_ERROR_IO for truncated or corrupt files.
+ *
+ * The END record is returned like any other record.
+ */
+int32_t jsdrv_usb_trace_reader_next(struct jsdrv_usb_trace_reader_s * self,
+                                    struct jsdrv_usb_trace_record_s * record, const uint8_t ** payload);
+
+/**
+ * @brief Restart reading from the first record.
+ *
+ * @param self The reader.
+ * @return 0 or JSDRV_ERROR_IO.
+ */
+int32_t jsdrv_usb_trace_reader_rewind(struct jsdrv_usb_trace_reader_s * self);
+
+/**
+ * @brief Close a reader.
+ *
+ * @param self The reader, which is freed.  NULL is allowed and ignored.
+ */
+void jsdrv_usb_trace_reader_close(struct jsdrv_usb_trace_reader_s * self);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_USB_TRACE_H_ */
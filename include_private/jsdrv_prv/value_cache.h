@@ -0,0 +1,132 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief Lock-free snapshot of retained scalar values.
+ */
+
+#ifndef JSDRV_PRV_VALUE_CACHE_H_
+#define JSDRV_PRV_VALUE_CACHE_H_
+
+#include "jsdrv/union.h"
+#include "jsdrv/cmacro_inc.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @ingroup jsdrv_prv
+ * @defgroup jsdrv_prv_value_cache Retained value cache
+ *
+ * @brief Read retained scalar values from any thread without locks.
+ *
+ * The pubsub instance, the single writer, mirrors each retained scalar
+ * value into a fixed-size, open-addressed table.  Each entry has a
+ * sequence counter which is odd during an update, so readers copy the
+ * value and retry when the counter changed.  Entries are never removed,
+ * only invalidated, so probe sequences remain stable for concurrent
+ * readers.  Pointer values (str, json, bin) are not cached.
+ *
+ * Each entry also records whether the topic's metadata passes scalar
+ * values through validation unmodified.  The frontend uses this flag
+ * to route device commands directly from the API thread.
+ *
+ * @{
+ */
+
+JSDRV_CPP_GUARD_START
+
+/// The number of entries, a power of 2.
+#define JSDRV_VALUE_CACHE_SIZE (2048U)
+
+/// The opaque instance.
+struct jsdrv_value_cache_s;
+
+/**
+ * @brief Allocate a new instance.
+ *
+ * @return The new instance.
+ */
+struct jsdrv_value_cache_s * jsdrv_value_cache_alloc(void);
+
+/**
+ * @brief Free an instance.
+ *
+ * @param self The instance.  No readers may be active.
+ */
+void jsdrv_value_cache_free(struct jsdrv_value_cache_s * self);
+
+/**
+ * @brief Update the retained value for a topic.
+ *
+ * @param self The instance.
+ * @param topic The full topic name.
+ * @param hash The jsdrv_pubsub_topic_hash() for topic.
+ * @param value The retained value, or NULL to invalidate.
+ *
+ * Call only from the writer thread.  When the table is full, new
+ * topics are not cached.
+ */
+void jsdrv_value_cache_set(struct jsdrv_value_cache_s * self, const char * topic, uint32_t hash,
+                           const struct jsdrv_union_s * value);
+
+/**
+ * @brief Get the retained value for a topic.
+ *
+ * @param self The instance.
+ * @param topic The full topic name.
+ * @param[out] value The retained value.
+ * @return 0 or JSDRV_ERROR_UNAVAILABLE when not cached.
+ *
+ * This function is thread-safe and never blocks.
+ */
+int32_t jsdrv_value_cache_get(struct jsdrv_value_cache_s * self, const char * topic,
+                              struct jsdrv_union_s * value);
+
+/**
+ * @brief Update the direct flag for a topic.
+ *
+ * @param self The instance.
+ * @param topic The full topic name.
+ * @param hash The jsdrv_pubsub_topic_hash() for topic.
+ * @param direct True when validation never modifies or rejects a
+ *      scalar, non-string value for this topic.
+ *
+ * Call only from the writer thread.
+ */
+void jsdrv_value_cache_direct_set(struct jsdrv_value_cache_s * self, const char * topic, uint32_t hash,
+                                  bool direct);
+
+/**
+ * @brief Get the retained value for a direct topic.
+ *
+ * @param self The instance.
+ * @param topic The full topic name.
+ * @param[out] value The retained value or JSDRV_UNION_NULL when the
+ *      topic has no cached value.
+ * @return 0 or JSDRV_ERROR_UNAVAILABLE when the topic is not direct.
+ *
+ * This function is thread-safe and never blocks.
+ */
+int32_t jsdrv_value_cache_direct_get(struct jsdrv_value_cache_s * self, const char * topic,
+                                     struct jsdrv_union_s * value);
+
+JSDRV_CPP_GUARD_END
+
+/** @} */
+
+#endif  /* JSDRV_PRV_VALUE_CACHE_H_ */
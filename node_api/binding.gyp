@@ -5,12 +5,24 @@
       'sources': [
         'src/addon.cc',
         'src/joulescope_driver.cc',
+        '../src/align.c',
+        '../src/alloc.c',
+        '../src/api_timeout.c',
         '../src/buffer.c',
+        '../src/buffer_codec.c',
         '../src/buffer_signal.c',
+        '../src/continuity.c',
+        '../src/cpu.c',
         '../src/cstr.c',
         '../src/devices.c',
+        '../src/dispatch.c',
+        '../src/executor.c',
         '../src/downsample.c',
+        '../src/emulated.c',
         '../src/error_code.c',
+        '../src/file_writer.c',
+        '../src/framer.c',
+        '../src/host_stats.c',
         '../src/js110_cal.c',
         '../src/js110_sample_processor.c',
         '../src/js110_stats.c',
@@ -20,16 +32,36 @@
         '../src/js220_usb.c',
         '../src/js220_stats.c',
         '../src/jsdrv.c',
+        '../src/net.c',
         '../src/json.c',
+        '../src/latency.c',
         '../src/log.c',
+        '../src/pack.c',
+        '../src/perf.c',
+        '../src/proc.c',
         '../src/pubsub.c',
+        '../src/record.c',
         '../src/meta.c',
+        '../src/meta_store.c',
         '../src/sample_buffer_f32.c',
+        '../src/shm.c',
+        '../src/simd_f32.c',
         '../src/statistics.c',
+        '../src/stats_all.c',
+        '../src/stats_history.c',
+        '../src/stream_event.c',
+        '../src/tap.c',
+        '../src/thread_policy.c',
         '../src/time.c',
         '../src/time_map_filter.c',
         '../src/topic.c',
+        '../src/topic_index.c',
+        '../src/trace.c',
+        '../src/trigger.c',
         '../src/union.c',
+        '../src/usb_replay.c',
+        '../src/usb_trace.c',
+        '../src/value_cache.c',
         '../src/version.c',
         '../third-party/tinyprintf/tinyprintf.c'
       ],
@@ -41,7 +73,7 @@
             '../src/backend/winusb/msg_queue.c',
             '../src/backend/windows.c'
           ],
-          'libraries': ['Setupapi', 'Winusb', 'user32', 'winmm']
+          'libraries': ['Setupapi', 'Winusb', 'user32', 'winmm', 'Ws2_32']
         }],
         ["OS!='win'", {
           'sources': [
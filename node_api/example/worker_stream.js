@@ -0,0 +1,70 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Run the driver in a worker thread and transfer current samples to
+// the main thread without copying them again.
+
+const { Worker, isMainThread, parentPort } = require('worker_threads');
+const JoulescopeDriver = require("joulescope_driver");
+
+async function worker() {
+    const drv = new JoulescopeDriver();
+    const device_path = drv.device_paths().find((p) => p.includes("/js220/"));
+    if (device_path === undefined) {
+        parentPort.postMessage(null);
+        drv.finalize();
+        return;
+    }
+    drv.open(device_path);
+    let stop = false;
+    parentPort.on('message', () => { stop = true; });
+    const stream = drv.stream(device_path.concat("/s/i/!data"), {
+        highWaterMark: 8,
+        overflow: 'coalesce',
+        transferable: true,
+    });
+    drv.publish(device_path.concat("/s/i/ctrl"), 1, 0);
+    for await (const [topic, value] of stream) {
+        const buffer = value.data.buffer;
+        parentPort.postMessage({topic, value, stats: stream.stats()}, [buffer]);
+        if (stop) {
+            break;
+        }
+    }
+    drv.publish(device_path.concat("/s/i/ctrl"), 0, 0);
+    drv.close(device_path);
+    drv.finalize();
+}
+
+function main() {
+    const w = new Worker(__filename);
+    w.on('message', (msg) => {
+        if (msg === null) {
+            console.log('no JS220 found');
+            return;
+        }
+        const data = msg.value.data;
+        console.log(msg.topic + ': ' + data.length + ' samples from ' + msg.value.sample_id
+            + ', dropped=' + msg.stats.dropped + ', coalesced=' + msg.stats.coalesced);
+    });
+    process.on('SIGINT', () => w.postMessage('stop'));
+}
+
+if (isMainThread) {
+    main();
+} else {
+    worker();
+}
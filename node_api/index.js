@@ -15,11 +15,19 @@
  */
 
 const addon = require('node-gyp-build')(__dirname);
+const { ReadableStream } = require('stream/web');
 
 
 class JoulescopeDriver {
-    constructor() {
-        this.jsdrv = new addon.JoulescopeDriver()
+    /**
+     * Create and initialize a new driver instance.
+     *
+     * @param args The optional initialization arguments object that
+     *      maps each jsdrv_arg_s name to its unsigned integer value,
+     *      such as {'emulated/js220': 1}.
+     */
+    constructor(args={}) {
+        this.jsdrv = new addon.JoulescopeDriver(args)
     }
 
     /**
@@ -85,15 +93,134 @@ class JoulescopeDriver {
     /**
      * Subscribe to a topic.
      *
-     * @param topic
-     * @param flags
-     * @param fn
-     * @param timeout
-     * @returns Callable to unsubscribe.
+     * The driver converts values on its own thread and queues them for
+     * the JavaScript thread, which handles every queued value in a
+     * single event loop turn.  Stream data arrays wrap the driver's
+     * copy without another copy when the runtime permits external
+     * ArrayBuffers.
+     *
+     * @param topic The topic string.
+     * @param flags The jsdrv_subscribe_flags_e bitmap.
+     * @param fn The callback, called as fn(topic, value).  With
+     *      options.batch, called as fn([[topic, value], ...]).
+     * @param timeout The optional integer timeout in milliseconds.
+     *      -1 (default) use the default timeout value.
+     * @param options The optional options object:
+     *      - batch: true to receive all queued values in one call.
+     *      - stats: 'object' (default) for nested statistics objects,
+     *        or 'typed' for a Float64Array indexed by STATS_LAYOUT.
+     *      - highWaterMark: The maximum queued values, 0 (default)
+     *        for unlimited.
+     *      - overflow: 'drop' (default) discards new values beyond
+     *        highWaterMark.  'coalesce' replaces the newest queued
+     *        value for the same topic, or else the oldest value.
+     *      - transferable: true to copy stream data into ArrayBuffers
+     *        that postMessage can transfer to another thread.
+     *      - pull: true to queue values until read() rather than call
+     *        fn with them.  fn() is called without arguments after
+     *        arm() when a value arrives.
+     * @returns Callable to unsubscribe, with the methods:
+     *      - stats(): returns {dropped, coalesced, pending}.
+     *      - read(max), pull only: returns up to max queued values
+     *        as [[topic, value], ...].
+     *      - arm(), pull only: returns true when values are queued,
+     *        or false to call fn() on the next value.
+     */
+    subscribe(topic, flags, fn, timeout=-1, options={}) {
+        return this.jsdrv.subscribe(topic, flags, fn, timeout, options);
+    }
+
+    /**
+     * Stream a topic with backpressure.
+     *
+     * The driver queues up to options.highWaterMark values.  The
+     * stream reads them as the consumer pulls, so a slow consumer
+     * drops or coalesces values in the driver rather than growing
+     * the JavaScript heap.  Iterate with "for await" and break, or
+     * cancel the stream, to unsubscribe.
+     *
+     * @param topic The topic string.
+     * @param options The optional subscribe options object, except
+     *      batch and pull, and:
+     *      - flags: The jsdrv_subscribe_flags_e bitmap, default 2 (PUB).
+     *      - timeout: The integer timeout in milliseconds.
+     *      highWaterMark defaults to 16.
+     * @returns The ReadableStream of [topic, value] with a stats()
+     *      method, see subscribe().
      */
-    subscribe(topic, flags, fn, timeout=-1) {
-        return this.jsdrv.subscribe(topic, flags, fn, timeout);
+    stream(topic, options={}) {
+        const flags = (options.flags === undefined) ? 2 : options.flags;
+        const timeout = (options.timeout === undefined) ? -1 : options.timeout;
+        const sub_options = Object.assign({highWaterMark: 16}, options, {batch: false, pull: true});
+        let wake = null;
+        const unsub = this.jsdrv.subscribe(topic, flags, () => {
+            if (wake) {
+                const resolve = wake;
+                wake = null;
+                resolve();
+            }
+        }, timeout, sub_options);
+        const stream = new ReadableStream({
+            async pull(controller) {
+                for (;;) {
+                    const entries = unsub.read(Math.max(1, controller.desiredSize));
+                    if (entries.length) {
+                        entries.forEach((entry) => controller.enqueue(entry));
+                        return;
+                    }
+                    const waiting = new Promise((resolve) => { wake = resolve; });
+                    if (!unsub.arm()) {
+                        await waiting;
+                    }
+                    wake = null;
+                }
+            },
+            cancel() {
+                unsub();
+            },
+        }, {highWaterMark: 1});
+        stream.stats = () => unsub.stats();
+        return stream;
+    }
+
+    /**
+     * Measure one exact statistics window.
+     *
+     * The driver configures the device host statistics, enables the
+     * current, voltage and power streams, computes the exact charge
+     * and energy over the window, and then restores the previous
+     * settings.  The device must support "h/stats/ctrl".
+     *
+     * @param device The device path, such as "u/js220/000415".
+     * @param options The options object with exactly one of:
+     *      - duration: The window duration in seconds.
+     *      - sample_count: The window duration in 1 Msps samples.
+     *      and optionally:
+     *      - timeout: The integer time to wait beyond the window in
+     *        milliseconds.  -1 (default) uses the default timeout.
+     * @returns The Promise for the statistics object, like
+     *      "s/stats/host/value".
+     */
+    measure(device, options={}) {
+        let sample_count = options.sample_count;
+        if ((options.duration === undefined) === (sample_count === undefined)) {
+            throw new TypeError("Specify exactly one of duration or sample_count");
+        }
+        if (sample_count === undefined) {
+            sample_count = Math.round(options.duration * 1000000);
+        }
+        if (!(sample_count >= 1 && sample_count <= 4294967295)) {
+            throw new RangeError("Invalid measure duration");
+        }
+        const timeout = (options.timeout === undefined) ? -1 : options.timeout;
+        return this.jsdrv.measure(device, sample_count, timeout);
     }
 }
 
+/**
+ * The Float64Array indices for statistics with subscribe options
+ * {stats: 'typed'}.  UTC times are in milliseconds.
+ */
+JoulescopeDriver.STATS_LAYOUT = addon.STATS_LAYOUT;
+
 module.exports = JoulescopeDriver
@@ -16,12 +16,21 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <algorithm>  // std::min
+#include <cstddef>  // offsetof
 #include <cstring>  // memset
+#include <memory>
+#include <mutex>
+#include <vector>
 #include "joulescope_driver.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv_prv/pack.h"
 
 static const uint32_t _TIMEOUT_MS_INIT = 5000;
 static const uint32_t _TIMEOUT_MS = 2000;
 
+static Napi::Object stats_layout(Napi::Env env);
+
 
 Napi::Object JoulescopeDriver::Init(Napi::Env env, Napi::Object exports) {
     Napi::Function func =
@@ -29,6 +38,7 @@ Napi::Object JoulescopeDriver::Init(Napi::Env env, Napi::Object exports) {
                 InstanceMethod("publish", &JoulescopeDriver::publish),
                 InstanceMethod("query", &JoulescopeDriver::query),
                 InstanceMethod("subscribe", &JoulescopeDriver::subscribe),
+                InstanceMethod("measure", &JoulescopeDriver::measure),
                 InstanceMethod("finalize", &JoulescopeDriver::finalize)
             });
 
@@ -37,6 +47,7 @@ Napi::Object JoulescopeDriver::Init(Napi::Env env, Napi::Object exports) {
     env.SetInstanceData(constructor);
 
     exports.Set("JoulescopeDriver", func);
+    exports.Set("STATS_LAYOUT", stats_layout(env));
     return exports;
 }
 
@@ -44,7 +55,33 @@ JoulescopeDriver::JoulescopeDriver(const Napi::CallbackInfo& info)
         : Napi::ObjectWrap<JoulescopeDriver>(info) {
     Napi::Env env = info.Env();
     this->context_ = NULL;
-    int32_t status = jsdrv_initialize(&this->context_, NULL, _TIMEOUT_MS_INIT);
+    std::vector<std::string> names;
+    std::vector<struct jsdrv_arg_s> args;
+    if ((info.Length() >= 1) && info[0].IsObject()) {  // {name: number, ...}
+        Napi::Object obj = info[0].As<Napi::Object>();
+        Napi::Array keys = obj.GetPropertyNames();
+        names.reserve(keys.Length());
+        for (uint32_t idx = 0; idx < keys.Length(); ++idx) {
+            Napi::Value v = obj.Get(keys.Get(idx));
+            if (!v.IsNumber()) {
+                Napi::TypeError::New(env, "Initialize arguments must be numbers").ThrowAsJavaScriptException();
+                return;
+            }
+            names.push_back(keys.Get(idx).As<Napi::String>());
+            struct jsdrv_arg_s arg;
+            memset(&arg, 0, sizeof(arg));
+            arg.value.type = JSDRV_UNION_U32;
+            arg.value.value.u32 = v.As<Napi::Number>().Uint32Value();
+            args.push_back(arg);
+        }
+        for (size_t idx = 0; idx < args.size(); ++idx) {
+            args[idx].topic = names[idx].c_str();
+        }
+        struct jsdrv_arg_s end;  // NULL topic terminates
+        memset(&end, 0, sizeof(end));
+        args.push_back(end);
+    }
+    int32_t status = jsdrv_initialize(&this->context_, args.empty() ? NULL : args.data(), _TIMEOUT_MS_INIT);
     if (status) {
         napi_throw_error(env, NULL, "jsdrv_initialize failed");
         return;
@@ -146,7 +183,32 @@ static double time64_to_ms(int64_t t) {
     return (double) t_ms;
 }
 
-static Napi::Value stream_to_js(Napi::Env env, const struct jsdrv_union_s * value) {
+static void buffer_free(napi_env env, void * data, void * hint) {
+    (void) env;
+    (void) data;
+    free(hint);
+}
+
+/*
+ * Get an ArrayBuffer for data.  When owner is not NULL, the ArrayBuffer
+ * wraps data without a copy and becomes responsible for freeing owner.
+ * Runtimes with a V8 memory cage, such as Electron, do not allow external
+ * buffers, so fall back to a copy.
+ */
+static Napi::ArrayBuffer data_buffer(Napi::Env env, void * data, size_t size, void ** owner) {
+    if (owner && *owner) {
+        napi_value ab;
+        if (napi_ok == napi_create_external_arraybuffer(env, data, size, buffer_free, *owner, &ab)) {
+            *owner = NULL;
+            return Napi::ArrayBuffer(env, ab);
+        }
+    }
+    Napi::ArrayBuffer ab = Napi::ArrayBuffer::New(env, size);
+    memcpy(ab.Data(), data, size);
+    return ab;
+}
+
+static Napi::Value stream_to_js(Napi::Env env, const struct jsdrv_union_s * value, void ** owner) {
     const struct jsdrv_stream_signal_s * s = (const struct jsdrv_stream_signal_s *) value->value.bin;
     Napi::Object obj = Napi::Object::New(env);
     obj.Set("sample_id", s->sample_id);
@@ -156,58 +218,56 @@ static Napi::Value stream_to_js(Napi::Env env, const struct jsdrv_union_s * valu
     obj.Set("sample_rate", s->sample_rate);
     obj.Set("decimate_factor", s->decimate_factor);
     obj.Set("time_map", obj_time_map(env, &s->time_map));
+    size_t n = s->element_count;
+    void * data = (void *) s->data;
     if (JSDRV_DATA_TYPE_FLOAT == s->element_type) {
         if (32 == s->element_size_bits) {
-            Napi::Float32Array data = Napi::Float32Array::New(env, s->element_count);
-            float * data_src = (float *) s->data;
-            for (size_t idx = 0; idx < s->element_count; ++idx) {
-                data[idx] = data_src[idx];
-            }
-            obj.Set("data", data);
+            obj.Set("data", Napi::Float32Array::New(env, n, data_buffer(env, data, n * sizeof(float), owner), 0));
         } else if (64 == s->element_size_bits) {
-            Napi::Float64Array data = Napi::Float64Array::New(env, s->element_count);
-            double * data_src = (double *) s->data;
-            for (size_t idx = 0; idx < s->element_count; ++idx) {
-                data[idx] = data_src[idx];
-            }
-            obj.Set("data", data);
+            obj.Set("data", Napi::Float64Array::New(env, n, data_buffer(env, data, n * sizeof(double), owner), 0));
         }
     } else if (JSDRV_DATA_TYPE_UINT == s->element_type) {
         if (1 == s->element_size_bits) {
-            Napi::Uint8Array data = Napi::Uint8Array::New(env, s->element_count);
-            uint8_t * data_src = (uint8_t *) s->data;
-            for (size_t idx = 0; idx < s->element_count; ++idx) {
-                data[idx] = (data_src[idx >> 3] >> (idx & 7)) & 1;
-            }
-            obj.Set("data", data);
+            Napi::Uint8Array u8 = Napi::Uint8Array::New(env, n);
+            jsdrv_unpack_u1(u8.Data(), s->data, (uint32_t) n);
+            obj.Set("data", u8);
         } else if (4 == s->element_size_bits) {
-            Napi::Uint8Array data = Napi::Uint8Array::New(env, s->element_count);
-            uint8_t * data_src = (uint8_t *) s->data;
-            for (size_t idx = 0; idx < s->element_count; ++idx) {
-                data[idx] = (data_src[idx >> 1] >> (4 * (idx & 1))) & 0x0f;
-            }
-            obj.Set("data", data);
+            Napi::Uint8Array u8 = Napi::Uint8Array::New(env, n);
+            jsdrv_unpack_u4(u8.Data(), s->data, (uint32_t) n);
+            obj.Set("data", u8);
         } else if (8 == s->element_size_bits) {
-            Napi::Uint8Array data = Napi::Uint8Array::New(env, s->element_count);
-            uint8_t * data_src = (uint8_t *) s->data;
-            for (size_t idx = 0; idx < s->element_count; ++idx) {
-                data[idx] = data_src[idx];
-            }
-            obj.Set("data", data);
+            obj.Set("data", Napi::Uint8Array::New(env, n, data_buffer(env, data, n, owner), 0));
         }
     } else if (JSDRV_DATA_TYPE_INT == s->element_type) {
         if (16 == s->element_size_bits) {
-            Napi::Int16Array data = Napi::Int16Array::New(env, s->element_count);
-            int16_t * data_src = (int16_t *) s->data;
-            for (size_t idx = 0; idx < s->element_count; ++idx) {
-                data[idx] = data_src[idx];
-            }
-            obj.Set("data", data);
+            obj.Set("data", Napi::Int16Array::New(env, n, data_buffer(env, data, n * sizeof(int16_t), owner), 0));
         }
     }
     return obj;
 }
 
+static Napi::Value stream_event_to_js(Napi::Env env, const struct jsdrv_union_s * value) {
+    const struct jsdrv_stream_signal_s * s = (const struct jsdrv_stream_signal_s *) value->value.bin;
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("sample_id", s->sample_id);
+    obj.Set("utc", time64_to_ms(jsdrv_time_from_counter(&s->time_map, s->sample_id)));
+    obj.Set("field_id", s->field_id);
+    obj.Set("index", s->index);
+    obj.Set("sample_rate", s->sample_rate);
+    obj.Set("decimate_factor", s->decimate_factor);
+    obj.Set("element_count", s->element_count);
+    obj.Set("time_map", obj_time_map(env, &s->time_map));
+    size_t n = 0;
+    if (value->size > JSDRV_STREAM_HEADER_SIZE) {
+        n = (value->size - JSDRV_STREAM_HEADER_SIZE) / sizeof(struct jsdrv_stream_event_s);
+    }
+    // [offset, value] pairs, offset in decimated samples from sample_id
+    Napi::Uint32Array events = Napi::Uint32Array::New(env, n * 2);
+    memcpy(events.Data(), s->data, n * sizeof(struct jsdrv_stream_event_s));
+    obj.Set("events", events);
+    return obj;
+}
+
 static Napi::Value stats_to_js(Napi::Env env, const struct jsdrv_union_s * value) {
     const struct jsdrv_statistics_s * s =(const struct jsdrv_statistics_s *) value->value.bin;
     uint32_t sample_freq = s->sample_freq;
@@ -271,6 +331,82 @@ static Napi::Value stats_to_js(Napi::Env env, const struct jsdrv_union_s * value
     return obj;
 }
 
+// The Float64Array layout for the "typed" statistics format.
+enum stats_idx_e {
+    STATS_SAMPLE_ID_START,
+    STATS_SAMPLE_ID_END,
+    STATS_SAMPLE_FREQ,
+    STATS_UTC_START,        // ms
+    STATS_UTC_END,          // ms
+    STATS_DECIMATE_FACTOR,
+    STATS_BLOCK_SAMPLE_COUNT,
+    STATS_ACCUM_SAMPLE_ID,
+    STATS_I_AVG,
+    STATS_I_STD,
+    STATS_I_MIN,
+    STATS_I_MAX,
+    STATS_V_AVG,
+    STATS_V_STD,
+    STATS_V_MIN,
+    STATS_V_MAX,
+    STATS_P_AVG,
+    STATS_P_STD,
+    STATS_P_MIN,
+    STATS_P_MAX,
+    STATS_CHARGE,           // C
+    STATS_ENERGY,           // J
+    STATS_COUNT,
+};
+
+static const char * stats_names[STATS_COUNT] = {
+    "sample_id_start", "sample_id_end", "sample_freq", "utc_start", "utc_end",
+    "decimate_factor", "block_sample_count", "accum_sample_id",
+    "i_avg", "i_std", "i_min", "i_max",
+    "v_avg", "v_std", "v_min", "v_max",
+    "p_avg", "p_std", "p_min", "p_max",
+    "charge", "energy",
+};
+
+static Napi::Object stats_layout(Napi::Env env) {
+    Napi::Object obj = Napi::Object::New(env);
+    for (uint32_t idx = 0; idx < STATS_COUNT; ++idx) {
+        obj.Set(stats_names[idx], idx);
+    }
+    obj.Set("length", (uint32_t) STATS_COUNT);
+    return obj;
+}
+
+static Napi::Value stats_to_typed_js(Napi::Env env, const struct jsdrv_union_s * value) {
+    const struct jsdrv_statistics_s * s = (const struct jsdrv_statistics_s *) value->value.bin;
+    uint64_t sample_id_start = s->block_sample_id;
+    uint64_t sample_id_end = s->block_sample_id + s->block_sample_count * (uint64_t) s->decimate_factor;
+    Napi::Float64Array a = Napi::Float64Array::New(env, STATS_COUNT);
+    double * y = a.Data();
+    y[STATS_SAMPLE_ID_START] = (double) sample_id_start;
+    y[STATS_SAMPLE_ID_END] = (double) sample_id_end;
+    y[STATS_SAMPLE_FREQ] = (double) s->sample_freq;
+    y[STATS_UTC_START] = time64_to_ms(jsdrv_time_from_counter(&s->time_map, sample_id_start));
+    y[STATS_UTC_END] = time64_to_ms(jsdrv_time_from_counter(&s->time_map, sample_id_end));
+    y[STATS_DECIMATE_FACTOR] = (double) s->decimate_factor;
+    y[STATS_BLOCK_SAMPLE_COUNT] = (double) s->block_sample_count;
+    y[STATS_ACCUM_SAMPLE_ID] = (double) s->accum_sample_id;
+    y[STATS_I_AVG] = s->i_avg;
+    y[STATS_I_STD] = s->i_std;
+    y[STATS_I_MIN] = s->i_min;
+    y[STATS_I_MAX] = s->i_max;
+    y[STATS_V_AVG] = s->v_avg;
+    y[STATS_V_STD] = s->v_std;
+    y[STATS_V_MIN] = s->v_min;
+    y[STATS_V_MAX] = s->v_max;
+    y[STATS_P_AVG] = s->p_avg;
+    y[STATS_P_STD] = s->p_std;
+    y[STATS_P_MIN] = s->p_min;
+    y[STATS_P_MAX] = s->p_max;
+    y[STATS_CHARGE] = s->charge_f64;
+    y[STATS_ENERGY] = s->energy_f64;
+    return a;
+}
+
 static Napi::Value buffer_info_to_js(Napi::Env env, const struct jsdrv_union_s * value) {
     return env.Undefined(); // todo
 }
@@ -279,10 +415,12 @@ static Napi::Value buffer_rsp_to_js(Napi::Env env, const struct jsdrv_union_s *
     return env.Undefined(); // todo
 }
 
-static Napi::Value bin_to_js(Napi::Env env, const struct jsdrv_union_s * value) {
+static Napi::Value bin_to_js(Napi::Env env, const struct jsdrv_union_s * value, void ** owner, bool stats_typed) {
     switch (value->app) {
-        case JSDRV_PAYLOAD_TYPE_STREAM: return stream_to_js(env, value);
-        case JSDRV_PAYLOAD_TYPE_STATISTICS: return stats_to_js(env, value);
+        case JSDRV_PAYLOAD_TYPE_STREAM: return stream_to_js(env, value, owner);
+        case JSDRV_PAYLOAD_TYPE_STREAM_EVENT: return stream_event_to_js(env, value);
+        case JSDRV_PAYLOAD_TYPE_STATISTICS:
+            return stats_typed ? stats_to_typed_js(env, value) : stats_to_js(env, value);
         case JSDRV_PAYLOAD_TYPE_BUFFER_INFO: return buffer_info_to_js(env, value);
         case JSDRV_PAYLOAD_TYPE_BUFFER_RSP: return buffer_rsp_to_js(env, value);
         default:
@@ -291,7 +429,13 @@ static Napi::Value bin_to_js(Napi::Env env, const struct jsdrv_union_s * value)
 }
 
 
-static Napi::Value union_to_js(Napi::Env env, const struct jsdrv_union_s * value) {
+/*
+ * Convert a value to JavaScript.  When owner is not NULL, it is the
+ * allocation containing value, which the result may take over.
+ * Otherwise, the caller frees owner.
+ */
+static Napi::Value union_to_js(Napi::Env env, const struct jsdrv_union_s * value,
+                               void ** owner = NULL, bool stats_typed = false) {
     // https://github.com/nodejs/node-addon-api/blob/main/doc/value.md
     // printf("union_to_js type=%d\n", value->type);
     switch (value->type) {
@@ -303,7 +447,7 @@ static Napi::Value union_to_js(Napi::Env env, const struct jsdrv_union_s * value
             Napi::Function parse = json.Get("parse").As<Napi::Function>();
             return parse.Call(json, { json_string }).As<Napi::Object>();
         }
-        case JSDRV_UNION_BIN: return bin_to_js(env, value);
+        case JSDRV_UNION_BIN: return bin_to_js(env, value, owner, stats_typed);
         case JSDRV_UNION_F32: return Napi::Number::New(env, static_cast<double>(value->value.f32));
         case JSDRV_UNION_F64: return Napi::Number::New(env, static_cast<double>(value->value.f64));
         case JSDRV_UNION_U8:  return Napi::Number::New(env, static_cast<double>(value->value.u8));
@@ -341,68 +485,381 @@ Napi::Value JoulescopeDriver::query(const Napi::CallbackInfo& info) {
     return union_to_js(env, &v);
 }
 
+struct subscribe_item {
+    std::string topic;
+    struct jsdrv_union_s * value;  // allocated with malloc, includes the payload
+};
+
 struct subscribe_context {
     public:
     subscribe_context() {}
     std::string topic;
     uint8_t flags;
+    bool batch;
+    bool stats_typed;
+    bool transferable;          // copy data into ArrayBuffers that postMessage can transfer
+    bool pull;                  // JavaScript reads the pending values, fn only notifies
+    bool coalesce;              // on overflow, replace a pending value rather than drop the new one
+    uint32_t high_water_mark;   // the maximum pending values, 0 for unlimited
     Napi::ThreadSafeFunction fn;
+    std::mutex mutex;
+    std::vector<subscribe_item> pending;  // under mutex
+    bool armed = false;                   // under mutex, pull notifies on the next value
+    uint64_t dropped = 0;                 // under mutex
+    uint64_t coalesced = 0;               // under mutex
 };
 
-void _subscribe_fn(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
-    struct subscribe_context * context = (struct subscribe_context *) user_data;
-    std::string topic_str = topic;
-    struct jsdrv_union_s * value_cpy = (struct jsdrv_union_s *) malloc(sizeof(*value) + value->size);
-    if (NULL == value_cpy) {
+static Napi::Value item_to_js(Napi::Env env, subscribe_item & item, subscribe_context * context) {
+    void * owner = item.value;
+    Napi::Value value = union_to_js(env, item.value, context->transferable ? NULL : &owner, context->stats_typed);
+    free(owner);  // NULL when an external ArrayBuffer took ownership
+    return value;
+}
+
+static Napi::Array items_to_js(Napi::Env env, std::vector<subscribe_item> & items, subscribe_context * context) {
+    Napi::Array batch = Napi::Array::New(env, items.size());
+    for (size_t idx = 0; idx < items.size(); ++idx) {
+        Napi::Array entry = Napi::Array::New(env, 2);
+        entry.Set((uint32_t) 0, Napi::String::New(env, items[idx].topic));
+        entry.Set((uint32_t) 1, item_to_js(env, items[idx], context));
+        batch.Set((uint32_t) idx, entry);
+    }
+    return batch;
+}
+
+static void _subscribe_drain(Napi::Env env, Napi::Function js_fn, subscribe_context * context) {
+    std::vector<subscribe_item> items;
+    {
+        std::lock_guard<std::mutex> lock(context->mutex);
+        items.swap(context->pending);
+    }
+    if (context->batch) {
+        if (items.size()) {
+            js_fn.Call({items_to_js(env, items, context)});
+        }
         return;
     }
-    *value_cpy = *value;
+    for (size_t idx = 0; idx < items.size(); ++idx) {
+        Napi::String topic = Napi::String::New(env, items[idx].topic);
+        Napi::Value value = item_to_js(env, items[idx], context);
+        js_fn.Call({topic, value});
+    }
+}
+
+static void _subscribe_notify(Napi::Env env, Napi::Function js_fn, subscribe_context * context) {
+    (void) env;
+    (void) context;
+    js_fn.Call({});
+}
 
+/*
+ * Apply the high-water mark under the context mutex.
+ * Return true to append value, false when it replaced a pending value
+ * or was dropped.
+ */
+static bool _subscribe_overflow(subscribe_context * context, const char * topic, struct jsdrv_union_s * value) {
+    if (!context->high_water_mark || (context->pending.size() < context->high_water_mark)) {
+        return true;
+    } else if (!context->coalesce) {
+        ++context->dropped;
+        free(value);
+        return false;
+    }
+    // Replace the newest pending value for topic, or else the oldest value.
+    ++context->coalesced;
+    for (size_t idx = context->pending.size(); idx > 0; --idx) {
+        subscribe_item & item = context->pending[idx - 1];
+        if (item.topic == topic) {
+            free(item.value);
+            item.value = value;
+            return false;
+        }
+    }
+    free(context->pending.front().value);
+    context->pending.erase(context->pending.begin());
+    context->pending.push_back({topic, value});
+    return false;
+}
+
+/*
+ * Copy the value on the jsdrv frontend thread.  To minimize the work on the
+ * JavaScript thread, unpack u1 and u4 stream data here, so that the
+ * JavaScript thread only wraps the copy.
+ */
+static struct jsdrv_union_s * _value_copy(const struct jsdrv_union_s * value) {
+    struct jsdrv_union_s * value_cpy;
+    const struct jsdrv_stream_signal_s * s = (const struct jsdrv_stream_signal_s *) value->value.bin;
+    if ((JSDRV_UNION_BIN == value->type) && (JSDRV_PAYLOAD_TYPE_STREAM == value->app)
+            && (JSDRV_DATA_TYPE_UINT == s->element_type)
+            && ((1 == s->element_size_bits) || (4 == s->element_size_bits))) {
+        size_t hdr_size = offsetof(struct jsdrv_stream_signal_s, data);
+        size_t size = hdr_size + s->element_count;
+        value_cpy = (struct jsdrv_union_s *) malloc(sizeof(*value) + size);
+        if (NULL == value_cpy) {
+            return NULL;
+        }
+        *value_cpy = *value;
+        struct jsdrv_stream_signal_s * s_cpy = (struct jsdrv_stream_signal_s *) &value_cpy[1];
+        memcpy(s_cpy, s, hdr_size);
+        if (1 == s->element_size_bits) {
+            jsdrv_unpack_u1(s_cpy->data, s->data, s->element_count);
+        } else {
+            jsdrv_unpack_u4(s_cpy->data, s->data, s->element_count);
+        }
+        s_cpy->element_size_bits = 8;
+        value_cpy->value.bin = (const uint8_t *) s_cpy;
+        value_cpy->size = (uint32_t) size;
+        return value_cpy;
+    }
+
+    value_cpy = (struct jsdrv_union_s *) malloc(sizeof(*value) + value->size);
+    if (NULL == value_cpy) {
+        return NULL;
+    }
+    *value_cpy = *value;
     if (value->size) {
         uint8_t *ptr = (uint8_t *) &value_cpy[1];
         value_cpy->value.bin = ptr;
         memcpy(ptr, value->value.bin, value->size);
     }
+    return value_cpy;
+}
 
-    auto callback = [topic_str]( Napi::Env env, Napi::Function jsCallback, const struct jsdrv_union_s * value) {
-        jsCallback.Call( {Napi::String::New(env, topic_str), union_to_js(env, value)} );
-        free((void *) value);
-    };
+void _subscribe_fn(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    struct subscribe_context * context = (struct subscribe_context *) user_data;
+    struct jsdrv_union_s * value_cpy = _value_copy(value);
+    if (NULL == value_cpy) {
+        return;
+    }
+    bool first;
+    {
+        std::lock_guard<std::mutex> lock(context->mutex);
+        if (!_subscribe_overflow(context, topic, value_cpy)) {
+            return;
+        }
+        first = context->pending.empty();
+        context->pending.push_back({topic, value_cpy});
+        if (context->pull) {
+            first = context->armed;
+            context->armed = false;
+        }
+    }
+    if (first && context->pull) {
+        context->fn.NonBlockingCall(context, _subscribe_notify);  // values remain pending on failure
+    } else if (first) {
+        // one call drains every message queued until the JavaScript thread runs
+        if (napi_ok != context->fn.NonBlockingCall(context, _subscribe_drain)) {
+            std::lock_guard<std::mutex> lock(context->mutex);
+            for (auto & item: context->pending) {
+                free(item.value);
+            }
+            context->pending.clear();
+        }
+    }
+}
 
-    context->fn.NonBlockingCall(value_cpy, callback);
+static void _subscribe_finalize(Napi::Env env, void * data, subscribe_context * context) {
+    (void) env;
+    (void) data;
+    for (auto & item: context->pending) {
+        free(item.value);
+    }
+    delete context;
 }
 
-Napi::Value JoulescopeDriver::subscribe(const Napi::CallbackInfo& info) {  // topic, flags, fn, timeout
+static bool parse_subscribe_options(Napi::Env env, Napi::Value value, subscribe_context * context) {
+    context->batch = false;
+    context->stats_typed = false;
+    context->transferable = false;
+    context->pull = false;
+    context->coalesce = false;
+    context->high_water_mark = 0;
+    if (value.IsUndefined() || value.IsNull()) {
+        return true;
+    } else if (!value.IsObject()) {
+        Napi::TypeError::New(env, "options invalid type").ThrowAsJavaScriptException();
+        return false;
+    }
+    Napi::Object options = value.As<Napi::Object>();
+    if (options.Has("batch")) {
+        context->batch = options.Get("batch").ToBoolean().Value();
+    }
+    if (options.Has("stats")) {
+        Napi::Value stats = options.Get("stats");
+        if (stats.IsString() && (stats.As<Napi::String>().Utf8Value() == "typed")) {
+            context->stats_typed = true;
+        } else if (!(stats.IsString() && (stats.As<Napi::String>().Utf8Value() == "object"))) {
+            Napi::TypeError::New(env, "options.stats must be 'object' or 'typed'").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+    if (options.Has("transferable")) {
+        context->transferable = options.Get("transferable").ToBoolean().Value();
+    }
+    if (options.Has("pull")) {
+        context->pull = options.Get("pull").ToBoolean().Value();
+    }
+    if (options.Has("highWaterMark")) {
+        Napi::Value hwm = options.Get("highWaterMark");
+        if (!hwm.IsNumber() || (hwm.As<Napi::Number>().DoubleValue() < 0)) {
+            Napi::TypeError::New(env, "options.highWaterMark must be a non-negative number").ThrowAsJavaScriptException();
+            return false;
+        }
+        context->high_water_mark = hwm.As<Napi::Number>().Uint32Value();
+    }
+    if (options.Has("overflow")) {
+        Napi::Value overflow = options.Get("overflow");
+        if (overflow.IsString() && (overflow.As<Napi::String>().Utf8Value() == "coalesce")) {
+            context->coalesce = true;
+        } else if (!(overflow.IsString() && (overflow.As<Napi::String>().Utf8Value() == "drop"))) {
+            Napi::TypeError::New(env, "options.overflow must be 'drop' or 'coalesce'").ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+    return true;
+}
+
+Napi::Value JoulescopeDriver::subscribe(const Napi::CallbackInfo& info) {  // topic, flags, fn, timeout, options
     // JSDRV_API int32_t jsdrv_subscribe(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
     //        jsdrv_subscribe_fn cbk_fn, void * cbk_user_data,
     //        uint32_t timeout_ms);
     Napi::Env env = info.Env();
-    if (info.Length() != 4) {
+    if ((info.Length() < 4) || (info.Length() > 5)) {
         Napi::TypeError::New(env, "Wrong number of arguments").ThrowAsJavaScriptException();
         return env.Undefined();
     }
     subscribe_context * context = new subscribe_context();
+    if (!parse_subscribe_options(env, info[4], context)) {
+        delete context;
+        return env.Undefined();
+    }
     context->topic = info[0].As<Napi::String>();
     context->flags = (uint8_t) (info[1].As<Napi::Number>().Uint32Value());
     Napi::Function fn = info[2].As<Napi::Function>();
     uint32_t timeout_ms = parse_timeout(env, info[3]);
-    context->fn = Napi::ThreadSafeFunction::New(env, fn, "jsdrv_subscribe_fn", 0, 1);
+    // The finalizer frees the context after the last queued call completes.
+    context->fn = Napi::ThreadSafeFunction::New(env, fn, "jsdrv_subscribe_fn", 0, 1,
+                                                context, _subscribe_finalize, (void *) NULL);
     int32_t status = jsdrv_subscribe(this->context_, context->topic.c_str(), context->flags,
                                      _subscribe_fn, context, timeout_ms);
     if (status) {
-        delete context;
+        context->fn.Release();
         napi_throw_error(env, NULL, "jsdrv_subscribe failed");
         return env.Undefined();
     }
     struct jsdrv_context_s * jsdrv_context = this->context_;
 
-    auto unsub_fn = [env, jsdrv_context, context, timeout_ms](const Napi::CallbackInfo& info) -> Napi::Value {
+    auto active = std::make_shared<bool>(true);
+
+    auto unsub_fn = [env, jsdrv_context, context, timeout_ms, active](const Napi::CallbackInfo& info) -> Napi::Value {
+        (void) info;
+        if (!*active) {
+            return env.Undefined();
+        }
+        *active = false;
         jsdrv_unsubscribe(jsdrv_context, context->topic.c_str(), _subscribe_fn, context, timeout_ms);
-        context->fn.Release();
-        delete context;
+        context->fn.Release();  // deferred free in _subscribe_finalize
         return env.Undefined();
     };
-    return Napi::Function::New(env, unsub_fn);
+    Napi::Function unsub = Napi::Function::New(env, unsub_fn);
+
+    // The context remains valid while active, since the finalizer runs after Release.
+    auto stats_fn = [context, active](const Napi::CallbackInfo& info) -> Napi::Value {
+        Napi::Object obj = Napi::Object::New(info.Env());
+        if (*active) {
+            std::lock_guard<std::mutex> lock(context->mutex);
+            obj.Set("dropped", (double) context->dropped);
+            obj.Set("coalesced", (double) context->coalesced);
+            obj.Set("pending", (double) context->pending.size());
+        }
+        return obj;
+    };
+    unsub.Set("stats", Napi::Function::New(env, stats_fn));
+    if (context->pull) {
+        auto read_fn = [context, active](const Napi::CallbackInfo& info) -> Napi::Value {  // max
+            std::vector<subscribe_item> items;
+            size_t count = SIZE_MAX;
+            if ((info.Length() >= 1) && info[0].IsNumber() && (info[0].As<Napi::Number>().DoubleValue() >= 1)) {
+                count = (size_t) info[0].As<Napi::Number>().DoubleValue();
+            }
+            if (*active) {
+                std::lock_guard<std::mutex> lock(context->mutex);
+                count = std::min(count, context->pending.size());
+                items.assign(context->pending.begin(), context->pending.begin() + count);
+                context->pending.erase(context->pending.begin(), context->pending.begin() + count);
+            }
+            return items_to_js(info.Env(), items, context);
+        };
+        auto arm_fn = [context, active](const Napi::CallbackInfo& info) -> Napi::Value {
+            bool ready = false;
+            if (*active) {
+                std::lock_guard<std::mutex> lock(context->mutex);
+                ready = !context->pending.empty();
+                context->armed = !ready;
+            }
+            return Napi::Boolean::New(info.Env(), ready);
+        };
+        unsub.Set("read", Napi::Function::New(env, read_fn));
+        unsub.Set("arm", Napi::Function::New(env, arm_fn));
+    }
+    return unsub;
+}
+
+class MeasureWorker : public Napi::AsyncWorker {
+    public:
+    MeasureWorker(Napi::Env env, struct jsdrv_context_s * context, const std::string & device,
+                  uint32_t sample_count, uint32_t timeout_ms)
+            : Napi::AsyncWorker(env), deferred_(Napi::Promise::Deferred::New(env)), context_(context),
+              device_(device), sample_count_(sample_count), timeout_ms_(timeout_ms), status_(0) {
+        memset(&stats_, 0, sizeof(stats_));
+    }
+
+    Napi::Promise Promise() { return deferred_.Promise(); }
+
+    void Execute() override {  // worker thread, blocks for the measurement
+        status_ = jsdrv_measure(context_, device_.c_str(), sample_count_, &stats_, timeout_ms_);
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        if (status_) {
+            std::string msg = "jsdrv_measure failed: ";
+            msg += jsdrv_error_code_name(status_);
+            deferred_.Reject(Napi::Error::New(env, msg).Value());
+            return;
+        }
+        struct jsdrv_union_s v;
+        memset(&v, 0, sizeof(v));
+        v.type = JSDRV_UNION_BIN;
+        v.app = JSDRV_PAYLOAD_TYPE_STATISTICS;
+        v.value.bin = (const uint8_t *) &stats_;
+        v.size = sizeof(stats_);
+        deferred_.Resolve(stats_to_js(env, &v));
+    }
+
+    private:
+    Napi::Promise::Deferred deferred_;
+    struct jsdrv_context_s * context_;
+    std::string device_;
+    uint32_t sample_count_;
+    uint32_t timeout_ms_;
+    int32_t status_;
+    struct jsdrv_statistics_s stats_;
+};
+
+Napi::Value JoulescopeDriver::measure(const Napi::CallbackInfo& info) {  // device, sample_count, timeout
+    Napi::Env env = info.Env();
+    if ((info.Length() != 3) || !info[0].IsString() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Wrong arguments").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    std::string device = info[0].As<Napi::String>();
+    uint32_t sample_count = info[1].As<Napi::Number>().Uint32Value();
+    uint32_t timeout_ms = parse_timeout(env, info[2]);
+    MeasureWorker * worker = new MeasureWorker(env, this->context_, device, sample_count, timeout_ms);
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();  // deleted by node-addon-api after OnOK
+    return promise;
 }
 
 Napi::Value JoulescopeDriver::finalize(const Napi::CallbackInfo& info) {
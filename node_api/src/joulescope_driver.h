@@ -31,6 +31,7 @@ class JoulescopeDriver : public Napi::ObjectWrap<JoulescopeDriver> {
         Napi::Value subscribe(const Napi::CallbackInfo& info);
         Napi::Value unsubscribe(const Napi::CallbackInfo& info);
         Napi::Value unsubscribe_all(const Napi::CallbackInfo& info);
+        Napi::Value measure(const Napi::CallbackInfo& info);
         Napi::Value finalize(const Napi::CallbackInfo& info);
 
         struct jsdrv_context_s * context_;
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measure the stream_to_js and stats_to_js delivery rates using an
+// emulated JS220.  Prints JSON to stdout.
+//
+//     npm run benchmark -- [duration_seconds]
+
+const JoulescopeDriver = require("..");
+
+const SFLAG_PUB = 2;
+const STREAMS = [
+    // name, topic
+    ['f32', 's/i/!data'],
+    ['u4', 's/i/range/!data'],
+    ['u1', 's/gpi/0/!data'],
+];
+const MODES = [
+    // name, subscribe options
+    ['object', {}],
+    ['typed', {stats: 'typed'}],
+    ['batch', {batch: true}],
+];
+
+const sleep = (delay) => new Promise((resolve) => setTimeout(resolve, delay));
+
+function rate(count, elapsed) {
+    return (elapsed > 0) ? (count / elapsed) : 0.0;
+}
+
+async function run(drv, device, options, duration) {
+    let state = {};
+    let unsubs = [];
+    const on_value = (topic, value) => {
+        let s = state[topic];
+        s.messages += 1;
+        if (value && value.data) {
+            s.samples += value.data.length;
+        }
+    };
+    const fn = options.batch ? (values) => values.forEach(([t, v]) => on_value(t, v)) : on_value;
+    const ctrls = [];
+    for (const [name, subtopic] of STREAMS) {
+        const topic = device.concat('/', subtopic);
+        state[topic] = {name: name, messages: 0, samples: 0};
+        unsubs.push(drv.subscribe(topic, SFLAG_PUB, fn, -1, options));
+        ctrls.push(device.concat('/', subtopic.replace('/!data', '/ctrl')));
+    }
+    const stats_topic = device.concat('/s/stats/value');
+    state[stats_topic] = {name: 'statistics', messages: 0, samples: 0};
+    unsubs.push(drv.subscribe(stats_topic, SFLAG_PUB, fn, -1, options));
+    ctrls.push(device.concat('/s/stats/ctrl'));
+
+    ctrls.forEach((ctrl) => drv.publish(ctrl, 1));
+    await sleep(250);  // reach steady state
+    Object.values(state).forEach((s) => { s.messages = 0; s.samples = 0; });
+    const t0 = process.hrtime.bigint();
+    await sleep(duration * 1000);
+    const elapsed = Number(process.hrtime.bigint() - t0) * 1e-9;
+    const snapshot = Object.values(state).map((s) => ({...s}));
+    ctrls.forEach((ctrl) => drv.publish(ctrl, 0));
+    unsubs.forEach((unsub) => unsub());
+
+    let results = {};
+    snapshot.forEach((s) => {
+        results[s.name] = {
+            messages_per_s: rate(s.messages, elapsed),
+            samples_per_s: rate(s.samples, elapsed),
+        };
+    });
+    return results;
+}
+
+async function main() {
+    const duration = parseFloat(process.argv[2] || '1.0');
+    const drv = new JoulescopeDriver({'emulated/js220': 1});
+    let results = {
+        node: process.version,
+        platform: process.platform,
+        arch: process.arch,
+        modes: {},
+    };
+    try {
+        const devices = drv.device_paths().filter((p) => p.startsWith('z/'));
+        if (0 == devices.length) {
+            throw new Error('emulated device not found');
+        }
+        const device = devices[0];
+        drv.open(device);
+        try {
+            const mem0 = process.memoryUsage();
+            for (const [name, options] of MODES) {
+                results.modes[name] = await run(drv, device, options, duration);
+            }
+            const mem1 = process.memoryUsage();
+            results.memory = {
+                rss_delta: mem1.rss - mem0.rss,
+                external_delta: mem1.external - mem0.external,
+            };
+        } finally {
+            drv.close(device);
+        }
+    } finally {
+        drv.finalize();
+    }
+    console.log(JSON.stringify(results, null, 2));
+}
+
+main().catch((err) => {
+    console.error(err);
+    process.exitCode = 1;
+});
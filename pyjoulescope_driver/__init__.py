@@ -17,15 +17,18 @@ from . import time64
 from .record import Record
 
 try:
-    from .binding import Driver, ElementType, Field, ErrorCode, LogLevel, SubscribeFlags, calibration_hash
+    from .binding import Driver, ElementType, Field, ErrorCode, LogLevel, StreamRing, SubscribeFlags, calibration_hash
+    from .binding import time_from_counter
+    from .binding import ArrowBatch, ArrowBatcher, StatisticsBatcher, STATISTICS_DTYPE, StreamReader
 except (ModuleNotFoundError, ImportError):
     print('Could not import cython binding')
 
 
 __all__ = [
-    'Driver', 'Record',
-    'ElementType', 'Field', 'ErrorCode', 'LogLevel', 'SubscribeFlags',
-    'calibration_hash',
+    'Driver', 'Record', 'ArrowBatch', 'ArrowBatcher',
+    'ElementType', 'Field', 'ErrorCode', 'LogLevel', 'StreamRing', 'SubscribeFlags',
+    'StatisticsBatcher', 'STATISTICS_DTYPE', 'StreamReader',
+    'calibration_hash', 'time_from_counter',
     'time64',
     '__version__', '__title__', '__description__', '__url__',
     '__author__', '__author_email__', '__license__',
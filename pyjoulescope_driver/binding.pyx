@@ -14,6 +14,13 @@
 
 """
 Python binding for the native Joulescope driver implementation.
+
+The module supports free-threaded CPython without the GIL.  Locks
+protect the shared module and :class:`Driver` state.  The driver calls
+each subscriber from its frontend thread, so the StreamRing, ArrowBatcher
+and StatisticsBatcher instances are only safe to read from the callback.
+Subscribe with batch=True to process on a dedicated thread for each
+subscriber, which runs in parallel with the others when free-threaded.
 """
 
 # See https://cython.readthedocs.io/en/latest/index.html
@@ -25,19 +32,25 @@ Python binding for the native Joulescope driver implementation.
 from libc.stdint cimport uint8_t, uint16_t, uint32_t, uint64_t, int8_t, int16_t, int32_t, int64_t
 from libc.float cimport DBL_MAX
 from libc.math cimport isfinite, NAN
-from libc.string cimport memset, strcpy
+from libc.stdlib cimport calloc, free, malloc
+from libc.string cimport memcpy, memset, strcpy
+from cpython.pycapsule cimport PyCapsule_New, PyCapsule_GetPointer
+from cpython.ref cimport Py_INCREF, Py_DECREF
 
 from collections.abc import Mapping
 import json
 import logging
 import numpy as np
+import threading
 include "module.pxi"
 import time
+import weakref
 cimport numpy as np
 from . cimport c_jsdrv
+from . import time64
 
 
-__all__ = ['Driver', 'calibration_hash']
+__all__ = ['Driver', 'StreamRing', 'calibration_hash', 'time_from_counter']
 np.import_array()                           # initialize numpy before use
 _log_c_name = 'jsdrv'
 _log_c = logging.getLogger(_log_c_name)
@@ -134,14 +147,23 @@ cdef object _parse_buffer_info(c_jsdrv.jsdrv_buffer_info_s * info):
 
 cdef object _parse_buffer_rsp(c_jsdrv.jsdrv_buffer_response_s * r):
     cdef np.npy_intp shape[2]
+    cdef c_jsdrv.jsdrv_buffer_integral_s * y
+    cdef c_jsdrv.jsdrv_time_range_samples_s * g
     v = {
         'version': r[0].version,
         'rsp_id': r[0].rsp_id,
+        'seq': r[0].seq,
+        'final': bool(r[0].flags & c_jsdrv.JSDRV_BUFFER_RESPONSE_FLAG_FINAL),
+        'gap': bool(r[0].flags & c_jsdrv.JSDRV_BUFFER_RESPONSE_FLAG_GAP),
+        'trend': bool(r[0].flags & c_jsdrv.JSDRV_BUFFER_RESPONSE_FLAG_TREND),
         'info': _parse_buffer_info(&r[0].info),
     }
     length = v['info']['time_range_samples']['length']
-    if r[0].response_type == c_jsdrv.JSDRV_BUFFER_RESPONSE_SAMPLES:
-        v['response_type'] = 'samples'
+    if r[0].response_type in (c_jsdrv.JSDRV_BUFFER_RESPONSE_SAMPLES, c_jsdrv.JSDRV_BUFFER_RESPONSE_STRIDED):
+        if r[0].response_type == c_jsdrv.JSDRV_BUFFER_RESPONSE_SAMPLES:
+            v['response_type'] = 'samples'
+        else:
+            v['response_type'] = 'strided'
         info = v['info']
         element_type = info['element_type']
         if element_type == 'f32':
@@ -164,11 +186,276 @@ cdef object _parse_buffer_rsp(c_jsdrv.jsdrv_buffer_response_s * r):
         shape[1] = <np.npy_intp> 4
         ndarray = np.PyArray_SimpleNewFromData(2, shape, np.NPY_FLOAT32, <void *> &r[0].data[0])
         v['data'] = ndarray.copy()
+    elif r[0].response_type == c_jsdrv.JSDRV_BUFFER_RESPONSE_INTEGRAL:
+        v['response_type'] = 'integral'
+        y = <c_jsdrv.jsdrv_buffer_integral_s *> &r[0].data[0]
+        v['data'] = {
+            'integral': y[0].integral,
+            'int_value': _i128_to_int(y[0].sum_i128[1], y[0].sum_i128[0]),
+            'int_scale': 2 ** -31,
+            'sample_count': y[0].sample_count,
+        }
+    elif r[0].response_type == c_jsdrv.JSDRV_BUFFER_RESPONSE_GAPS:
+        v['response_type'] = 'gaps'
+        g = <c_jsdrv.jsdrv_time_range_samples_s *> &r[0].data[0]
+        v['data'] = [(g[idx].start, g[idx].end) for idx in range(length)]
+    elif r[0].response_type == c_jsdrv.JSDRV_BUFFER_RESPONSE_CROSSINGS:
+        v['response_type'] = 'crossings'
+        shape[0] = <np.npy_intp> length
+        ndarray = np.PyArray_SimpleNewFromData(1, shape, np.NPY_UINT64, <void *> &r[0].data[0])
+        v['data'] = ndarray.copy()
+    elif r[0].response_type == c_jsdrv.JSDRV_BUFFER_RESPONSE_QUANTILES:
+        v['response_type'] = 'quantiles'
+        shape[0] = <np.npy_intp> length
+        ndarray = np.PyArray_SimpleNewFromData(1, shape, np.NPY_FLOAT32, <void *> &r[0].data[0])
+        v['data'] = ndarray.copy()
     else:
         _log_c.error(f'unsupported response_type {r[0].response_type}')
     return v
 
 
+cdef object _parse_buffer_multi_rsp(c_jsdrv.jsdrv_buffer_multi_response_s * r):
+    cdef uint8_t * u8_ptr = <uint8_t *> &r[0].data[0]
+    signals = []
+    for idx in range(r[0].signal_count):
+        s = {'signal_id': r[0].signal_ids[idx], 'status': r[0].status[idx]}
+        if r[0].status[idx] == 0:
+            s.update(_parse_buffer_rsp(<c_jsdrv.jsdrv_buffer_response_s *> &u8_ptr[r[0].offset[idx]]))
+        signals.append(s)
+    return {
+        'version': r[0].version,
+        'rsp_id': r[0].rsp_id,
+        'signals': signals,
+    }
+
+
+cdef object _time_map_to_py(c_jsdrv.jsdrv_time_map_s * t):
+    return {
+        'offset_time': t[0].offset_time,
+        'offset_counter': t[0].offset_counter,
+        'counter_rate': t[0].counter_rate,
+    }
+
+
+cdef object _parse_statistics(c_jsdrv.jsdrv_statistics_s * stats):
+    sample_freq = stats[0].sample_freq
+    samples_full_rate = stats[0].block_sample_count * stats[0].decimate_factor
+    sample_id_start = stats[0].block_sample_id
+    sample_id_end = stats[0].block_sample_id + samples_full_rate
+    t_start = sample_id_start / sample_freq
+    t_delta = samples_full_rate / sample_freq
+    charge = _i128_to_int(stats[0].charge_i128[1], stats[0].charge_i128[0])
+    energy = _i128_to_int(stats[0].energy_i128[1], stats[0].energy_i128[0])
+    return {
+        'time': {
+            'samples': {'value': [sample_id_start, sample_id_end], 'units': 'samples'},
+            'utc': {
+                'value': [
+                    c_jsdrv.jsdrv_time_from_counter(&stats[0].time_map, sample_id_start),
+                    c_jsdrv.jsdrv_time_from_counter(&stats[0].time_map, sample_id_end),
+                ],
+                'units': 'time64',
+            },
+            'sample_freq': {'value': sample_freq, 'units': 'Hz'},
+            'range': {'value': [t_start, t_start + t_delta], 'units': 's'},
+            'delta': {'value': t_delta, 'units': 's'},
+            'decimate_factor': {'value': stats[0].decimate_factor, 'units': 'samples'},
+            'decimate_sample_count': {'value': stats[0].block_sample_count, 'units': 'samples'},
+            'accum_samples': {'value': [stats[0].accum_sample_id, sample_id_end], 'units': 'samples'},
+            'time_map': {
+                'offset_time': stats[0].time_map.offset_time,
+                'offset_counter': stats[0].time_map.offset_counter,
+                'counter_rate': stats[0].time_map.counter_rate,
+            }
+        },
+        'signals': {
+            'current': {
+                'avg': {'value': stats[0].i_avg, 'units': 'A'},
+                'std': {'value': stats[0].i_std, 'units': 'A'},
+                'min': {'value': stats[0].i_min, 'units': 'A'},
+                'max': {'value': stats[0].i_max, 'units': 'A'},
+                'p2p': {'value': stats[0].i_max - stats[0].i_min, 'units': 'A'},
+                'integral': {'value': stats[0].i_avg * t_delta, 'units': 'C'},
+            },
+            'voltage': {
+                'avg': {'value': stats[0].v_avg, 'units': 'V'},
+                'std': {'value': stats[0].v_std, 'units': 'V'},
+                'min': {'value': stats[0].v_min, 'units': 'V'},
+                'max': {'value': stats[0].v_max, 'units': 'V'},
+                'p2p': {'value': stats[0].v_max - stats[0].v_min, 'units': 'V'},
+            },
+            'power': {
+                'avg': {'value': stats[0].p_avg, 'units': 'W'},
+                'std': {'value': stats[0].p_std, 'units': 'W'},
+                'min': {'value': stats[0].p_min, 'units': 'W'},
+                'max': {'value': stats[0].p_max, 'units': 'W'},
+                'p2p': {'value': stats[0].p_max - stats[0].p_min, 'units': 'W'},
+                'integral': {'value': stats[0].p_avg * t_delta, 'units': 'J'},
+            },
+        },
+        'accumulators': {
+            'charge': {
+                'value': stats[0].charge_f64,
+                'int_value': charge,
+                'int_scale': 2 ** -31,
+                'units': 'C',
+            },
+            'energy': {
+                'value': stats[0].energy_f64,
+                'int_value': energy,
+                'int_scale': 2 ** -27,
+                'units': 'J',
+            },
+        },
+        'source': 'sensor',
+    }
+
+
+cdef object _parse_statistics_all(c_jsdrv.jsdrv_statistics_all_s * all_stats):
+    cdef c_jsdrv.jsdrv_statistics_all_entry_s * e
+    entries = []
+    for idx in range(all_stats[0].count):
+        e = &all_stats[0].entries[idx]
+        entries.append({
+            'device': e[0].device.decode('utf-8'),
+            'utc': e[0].utc,
+            'statistics': _parse_statistics(&e[0].statistics),
+        })
+    return entries
+
+
+cdef object _parse_statistics_history(c_jsdrv.jsdrv_statistics_history_response_s * rsp):
+    data = np.empty(rsp[0].count, dtype=STATISTICS_DTYPE)
+    memcpy(np.PyArray_DATA(<np.ndarray> data), &rsp[0].data[0],
+           <size_t> rsp[0].count * sizeof(c_jsdrv.jsdrv_statistics_s))
+    return {
+        'version': rsp[0].version,
+        'flags': rsp[0].flags,
+        'seq': rsp[0].seq,
+        'rsp_id': rsp[0].rsp_id,
+        'total': rsp[0].total,
+        'data': data,
+    }
+
+
+cdef object _parse_host_derived(c_jsdrv.jsdrv_host_derived_s * d):
+    n = d[0].bin_count
+    # bin k covers octave (octave_min + (k - 1) / bins_per_octave), bins 0 and n - 1 are under and overflow
+    edges = 2.0 ** (d[0].octave_min + np.arange(n - 1, dtype=np.float64) / d[0].bins_per_octave)
+    return {
+        'version': d[0].version,
+        'block_sample_id': d[0].block_sample_id,
+        'hist_sample_id': d[0].hist_sample_id,
+        'hist_edges': edges,
+        'signals': {
+            'current': {'rms': d[0].i_rms, 'crest': d[0].i_crest,
+                        'hist': np.array([d[0].i_hist[k] for k in range(n)], dtype=np.uint64)},
+            'voltage': {'rms': d[0].v_rms, 'crest': d[0].v_crest,
+                        'hist': np.array([d[0].v_hist[k] for k in range(n)], dtype=np.uint64)},
+            'power': {'rms': d[0].p_rms, 'crest': d[0].p_crest,
+                      'hist': np.array([d[0].p_hist[k] for k in range(n)], dtype=np.uint64)},
+        },
+    }
+
+
+cdef object _parse_stream_frame(c_jsdrv.jsdrv_stream_frame_s * f):
+    cdef np.npy_intp shape[1]
+    cdef c_jsdrv.jsdrv_stream_frame_channel_s * c
+    shape[0] = <np.npy_intp> f[0].element_count
+    channels = []
+    for idx in range(f[0].channel_count):
+        c = &f[0].channels[idx]
+        dtype = np.NPY_FLOAT32 if c[0].element_type == c_jsdrv.JSDRV_DATA_TYPE_FLOAT else np.NPY_UINT8
+        ndarray = np.PyArray_SimpleNewFromData(1, shape, dtype, <void *> &f[0].data[c[0].offset])
+        channels.append({
+            'field_id': c[0].field_id,
+            'index': c[0].index,
+            'data': ndarray.copy(),
+        })
+    return {
+        'version': f[0].version,
+        'sample_id': f[0].sample_id,
+        'utc': c_jsdrv.jsdrv_time_from_counter(&f[0].time_map, f[0].sample_id),
+        'sample_rate': f[0].sample_rate,
+        'decimate_factor': f[0].decimate_factor,
+        'time_map': _time_map_to_py(&f[0].time_map),
+        'channels': channels,
+    }
+
+
+cdef object _parse_continuity(c_jsdrv.jsdrv_continuity_s * c):
+    return {
+        'version': c[0].version,
+        'sample_id': c[0].sample_id,
+        'skip': {'count': c[0].skip_count, 'length': c[0].skip_length},
+        'dup': {'count': c[0].dup_count, 'length': c[0].dup_length},
+        'resync_count': c[0].resync_count,
+        'drop_count': c[0].drop_count,
+        'gaps': [(c[0].gaps[k].sample_id, c[0].gaps[k].length) for k in range(c[0].gap_count)],
+    }
+
+
+cdef object _parse_trigger_event(c_jsdrv.jsdrv_trigger_event_s * e):
+    return {
+        'version': e[0].version,
+        'trigger': e[0].trigger,
+        'source': e[0].source,
+        'edge': 'falling' if e[0].edge else 'rising',
+        'value': e[0].value,
+        'sample_id': e[0].sample_id,
+        'utc': e[0].utc,
+        'sample_rate': e[0].sample_rate,
+        'decimate_factor': e[0].decimate_factor,
+    }
+
+
+cdef object _parse_stream_event(c_jsdrv.jsdrv_stream_signal_s * stream, uint32_t size):
+    cdef np.npy_intp shape[1]
+    cdef uint32_t hdr_size = <uint32_t> (<uint8_t *> stream[0].data - <uint8_t *> stream)
+    cdef uint32_t event_count = (size - hdr_size) // sizeof(c_jsdrv.jsdrv_stream_event_s) if size > hdr_size else 0
+    shape[0] = <np.npy_intp> (event_count * 2)
+    ndarray = np.PyArray_SimpleNewFromData(1, shape, np.NPY_UINT32, <void *> stream[0].data)
+    return {
+        'sample_id': stream[0].sample_id,
+        'utc': c_jsdrv.jsdrv_time_from_counter(&stream[0].time_map, stream[0].sample_id),
+        'field_id': stream[0].field_id,
+        'index': stream[0].index,
+        'sample_rate': stream[0].sample_rate,
+        'decimate_factor': stream[0].decimate_factor,
+        'element_count': stream[0].element_count,
+        'time_map': _time_map_to_py(&stream[0].time_map),
+        'events': ndarray.copy().reshape((-1, 2)),  # [offset, value] in decimated samples from sample_id
+    }
+
+
+cdef object _parse_align_map(c_jsdrv.jsdrv_align_map_s * m):
+    return {
+        'version': m[0].version,
+        'sources': [
+            {
+                'sample_rate': m[0].sample_rate[idx],
+                'decimate_factor': m[0].decimate_factor[idx],
+                'time_map': _time_map_to_py(&m[0].time_map[idx]),
+            } for idx in range(m[0].source_count)],
+    }
+
+
+cdef object _parse_align_frame(c_jsdrv.jsdrv_align_frame_s * f):
+    cdef np.npy_intp shape[2]
+    shape[0] = <np.npy_intp> f[0].source_count
+    shape[1] = <np.npy_intp> f[0].element_count
+    ndarray = np.PyArray_SimpleNewFromData(2, shape, np.NPY_FLOAT32, <void *> &f[0].data[0])
+    return {
+        'version': f[0].version,
+        'sample_id': f[0].sample_id,
+        'utc': c_jsdrv.jsdrv_time_from_counter(&f[0].time_map, f[0].sample_id),
+        'sample_rate': f[0].sample_rate,
+        'decimate_factor': f[0].decimate_factor,
+        'time_map': _time_map_to_py(&f[0].time_map),
+        'data': ndarray.copy(),
+    }
+
+
 cdef object _pack_buffer_req(r):
     cdef const uint8_t[:] rsp_topic_str = r['rsp_topic'].encode('utf-8')
     cdef c_jsdrv.jsdrv_buffer_request_s s
@@ -188,9 +475,46 @@ cdef object _pack_buffer_req(r):
         s.time.samples.length = r.get('length', 0)
     else:
         raise ValueError(f'invalid time type: {time_type}')
-    s.rsv1_u8 = 0
-    s.rsv2_u8 = 0
-    s.rsv3_u32 = 0
+    s.flags = c_jsdrv.JSDRV_BUFFER_REQUEST_FLAG_STREAM if r.get('stream', False) else 0
+    if r.get('snapshot', False):
+        s.flags |= c_jsdrv.JSDRV_BUFFER_REQUEST_FLAG_SNAPSHOT
+    if r.get('integral', False):
+        s.flags |= c_jsdrv.JSDRV_BUFFER_REQUEST_FLAG_INTEGRAL
+    if r.get('envelope', False):
+        s.flags |= c_jsdrv.JSDRV_BUFFER_REQUEST_FLAG_ENVELOPE
+    if r.get('stride', False):
+        s.flags |= c_jsdrv.JSDRV_BUFFER_REQUEST_FLAG_STRIDE
+    if r.get('gaps', False):
+        s.flags |= c_jsdrv.JSDRV_BUFFER_REQUEST_FLAG_GAPS
+    s.op = c_jsdrv.JSDRV_BUFFER_REQUEST_OP_DEFAULT
+    s.threshold = 0.0
+    display = r.get('display')  # the frame rate in Hz, True or 0 for the standing rate
+    if display is not None and display is not False:
+        s.flags |= c_jsdrv.JSDRV_BUFFER_REQUEST_FLAG_DISPLAY
+        rate = 0.0 if display is True else float(display)
+        if rate != 0.0 and not rate >= 1.0:  # JSDRV_BUFFER_DISPLAY_RATE_MIN
+            raise ValueError(f'invalid display frame rate: {display}')
+        s.threshold = rate
+    search = r.get('search')
+    if search is not None:
+        s.op = c_jsdrv.JSDRV_BUFFER_REQUEST_OP_SEARCH
+        s.threshold = float(search['threshold'])
+        edge = search.get('edge', 'both')
+        if edge == 'rising':
+            s.op |= c_jsdrv.JSDRV_BUFFER_SEARCH_RISING
+        elif edge == 'falling':
+            s.op |= c_jsdrv.JSDRV_BUFFER_SEARCH_FALLING
+        elif edge != 'both':
+            raise ValueError(f'invalid search edge: {edge}')
+        mode = search.get('mode', 'first')
+        if mode == 'last':
+            s.op |= c_jsdrv.JSDRV_BUFFER_SEARCH_LAST
+        elif mode == 'all':
+            s.op |= c_jsdrv.JSDRV_BUFFER_SEARCH_ALL
+        elif mode != 'first':
+            raise ValueError(f'invalid search mode: {mode}')
+    elif r.get('quantiles', False):
+        s.op = c_jsdrv.JSDRV_BUFFER_REQUEST_OP_QUANTILE
     strcpy(s.rsp_topic, <const char *> &rsp_topic_str[0])
     s.rsp_id = int(r['rsp_id'])
 
@@ -198,8 +522,55 @@ cdef object _pack_buffer_req(r):
     return bytes(u8_ptr[:sizeof(s)])
 
 
+cdef object _pack_buffer_multi_req(r):
+    cdef c_jsdrv.jsdrv_buffer_multi_request_s m
+    cdef const uint8_t[:] req_bytes = _pack_buffer_req(r)
+    cdef uint8_t * u8_ptr
+    signal_ids = list(r['signal_ids'])
+    if not 1 <= len(signal_ids) <= sizeof(m.signal_ids):
+        raise ValueError(f'invalid signal_ids length: {len(signal_ids)}')
+    memset(&m, 0, sizeof(m))
+    m.version = 1
+    m.signal_count = <uint8_t> len(signal_ids)
+    for idx, signal_id in enumerate(signal_ids):
+        m.signal_ids[idx] = <uint8_t> signal_id
+    memcpy(&m.req, &req_bytes[0], sizeof(m.req))
+    u8_ptr = <uint8_t *> &m;
+    return bytes(u8_ptr[:sizeof(m)])
+
+
+cdef object _pack_statistics_history_req(r):
+    cdef const uint8_t[:] device_str = r['device'].encode('utf-8')
+    cdef const uint8_t[:] rsp_topic_str = r['rsp_topic'].encode('utf-8')
+    cdef c_jsdrv.jsdrv_statistics_history_request_s s
+    cdef uint8_t * u8_ptr
+
+    if not 0 < len(device_str) < sizeof(s.device) or not 0 < len(rsp_topic_str) < sizeof(s.rsp_topic):
+        raise ValueError('invalid device or rsp_topic length')
+    memset(&s, 0, sizeof(s))
+    s.version = 1
+    time_type = r.get('time_type', 'samples').lower()
+    if time_type == 'utc':
+        s.time_type = c_jsdrv.JSDRV_TIME_UTC
+        s.time.utc.start = r.get('start', 0)
+        s.time.utc.end = r.get('end', 0)
+        s.time.utc.length = r.get('length', 0)
+    elif time_type == 'samples':
+        s.time_type = c_jsdrv.JSDRV_TIME_SAMPLES
+        s.time.samples.start = r.get('start', 0)
+        s.time.samples.end = r.get('end', 0)
+        s.time.samples.length = r.get('length', 0)
+    else:
+        raise ValueError(f'invalid time type: {time_type}')
+    memcpy(s.device, &device_str[0], len(device_str))
+    memcpy(s.rsp_topic, &rsp_topic_str[0], len(rsp_topic_str))
+    s.rsp_id = int(r.get('rsp_id', 0))
+    u8_ptr = <uint8_t *> &s;
+    return bytes(u8_ptr[:sizeof(s)])
+
 
-cdef object _jsdrv_union_to_py(const c_jsdrv.jsdrv_union_s * value):
+
+cdef object _jsdrv_union_to_py(const c_jsdrv.jsdrv_union_s * value, bint u4_packed=False):
     cdef c_jsdrv.jsdrv_stream_signal_s * stream;
     cdef np.npy_intp shape[1]
     cdef uint8_t[:] u8_mem
@@ -247,95 +618,44 @@ cdef object _jsdrv_union_to_py(const c_jsdrv.jsdrv_union_s * value):
                     shape[0] = <np.npy_intp> stream[0].element_count
                     ndarray = np.PyArray_SimpleNewFromData(1, shape, np.NPY_UINT8, <void *> stream[0].data)
                     v['data'] = ndarray.copy()
+                elif el == (c_jsdrv.JSDRV_DATA_TYPE_UINT, 4) and u4_packed:  # uint4, 2 per uint8
+                    shape[0] = <np.npy_intp> ((stream[0].element_count + 1) / 2)
+                    ndarray = np.PyArray_SimpleNewFromData(1, shape, np.NPY_UINT8, <void *> stream[0].data)
+                    v['data'] = ndarray.copy()
                 elif el == (c_jsdrv.JSDRV_DATA_TYPE_UINT, 4):  # uint4 -> uint8
                     # unpack to make i/range support easy
-                    # future uses may want to leave packed, so may need to check JSDRV_FIELD_RANGE
                     ndarray = np.empty(stream[0].element_count, dtype=np.uint8)
-                    u8_mem = ndarray
-                    for idx in range(0, stream[0].element_count >> 1):
-                        u8_mem[2 * idx] = stream[0].data[idx] & 0x0f
-                        u8_mem[2 * idx + 1] = (stream[0].data[idx] >> 4) & 0x0f
+                    c_jsdrv.jsdrv_unpack_u4(<uint8_t *> np.PyArray_DATA(<np.ndarray> ndarray), stream[0].data, stream[0].element_count)
                     v['data'] = ndarray
                 else:
                     print('jsdrv._jsdrv_union_to_py: unsupported data type')
                     v['data'] = None
             elif value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_STATISTICS:
-                stats = <c_jsdrv.jsdrv_statistics_s *> &(value[0].value.bin[0])
-                sample_freq = stats[0].sample_freq
-                samples_full_rate = stats[0].block_sample_count * stats[0].decimate_factor
-                sample_id_start = stats[0].block_sample_id
-                sample_id_end = stats[0].block_sample_id + samples_full_rate
-                t_start = sample_id_start / sample_freq
-                t_delta = samples_full_rate / sample_freq
-                charge = _i128_to_int(stats[0].charge_i128[1], stats[0].charge_i128[0])
-                energy = _i128_to_int(stats[0].energy_i128[1], stats[0].energy_i128[0])
-                v = {
-                    'time': {
-                        'samples': {'value': [sample_id_start, sample_id_end], 'units': 'samples'},
-                        'utc': {
-                            'value': [
-                                c_jsdrv.jsdrv_time_from_counter(&stats[0].time_map, sample_id_start),
-                                c_jsdrv.jsdrv_time_from_counter(&stats[0].time_map, sample_id_end),
-                            ],
-                            'units': 'time64',
-                        },
-                        'sample_freq': {'value': sample_freq, 'units': 'Hz'},
-                        'range': {'value': [t_start, t_start + t_delta], 'units': 's'},
-                        'delta': {'value': t_delta, 'units': 's'},
-                        'decimate_factor': {'value': stats[0].decimate_factor, 'units': 'samples'},
-                        'decimate_sample_count': {'value': stats[0].block_sample_count, 'units': 'samples'},
-                        'accum_samples': {'value': [stats[0].accum_sample_id, sample_id_end], 'units': 'samples'},
-                        'time_map': {
-                            'offset_time': stats[0].time_map.offset_time,
-                            'offset_counter': stats[0].time_map.offset_counter,
-                            'counter_rate': stats[0].time_map.counter_rate,
-                        }
-                    },
-                    'signals': {
-                        'current': {
-                            'avg': {'value': stats[0].i_avg, 'units': 'A'},
-                            'std': {'value': stats[0].i_std, 'units': 'A'},
-                            'min': {'value': stats[0].i_min, 'units': 'A'},
-                            'max': {'value': stats[0].i_max, 'units': 'A'},
-                            'p2p': {'value': stats[0].i_max - stats[0].i_min, 'units': 'A'},
-                            'integral': {'value': stats[0].i_avg * t_delta, 'units': 'C'},
-                        },
-                        'voltage': {
-                            'avg': {'value': stats[0].v_avg, 'units': 'V'},
-                            'std': {'value': stats[0].v_std, 'units': 'V'},
-                            'min': {'value': stats[0].v_min, 'units': 'V'},
-                            'max': {'value': stats[0].v_max, 'units': 'V'},
-                            'p2p': {'value': stats[0].v_max - stats[0].v_min, 'units': 'V'},
-                        },
-                        'power': {
-                            'avg': {'value': stats[0].p_avg, 'units': 'W'},
-                            'std': {'value': stats[0].p_std, 'units': 'W'},
-                            'min': {'value': stats[0].p_min, 'units': 'W'},
-                            'max': {'value': stats[0].p_max, 'units': 'W'},
-                            'p2p': {'value': stats[0].p_max - stats[0].p_min, 'units': 'W'},
-                            'integral': {'value': stats[0].p_avg * t_delta, 'units': 'J'},
-                        },
-                    },
-                    'accumulators': {
-                        'charge': {
-                            'value': stats[0].charge_f64,
-                            'int_value': charge,
-                            'int_scale': 2 ** -31,
-                            'units': 'C',
-                        },
-                        'energy': {
-                            'value': stats[0].energy_f64,
-                            'int_value': energy,
-                            'int_scale': 2 ** -27,
-                            'units': 'J',
-                        },
-                    },
-                    'source': 'sensor',
-                }
+                v = _parse_statistics(<c_jsdrv.jsdrv_statistics_s *> &(value[0].value.bin[0]))
+            elif value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_STATISTICS_ALL:
+                v = _parse_statistics_all(<c_jsdrv.jsdrv_statistics_all_s *> &(value[0].value.bin[0]))
+            elif value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_STATISTICS_HISTORY_RSP:
+                v = _parse_statistics_history(<c_jsdrv.jsdrv_statistics_history_response_s *> &(value[0].value.bin[0]))
             elif value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_BUFFER_INFO:
                 v = _parse_buffer_info(<c_jsdrv.jsdrv_buffer_info_s *> &(value[0].value.bin[0]))
             elif value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_BUFFER_RSP:
                 v = _parse_buffer_rsp(<c_jsdrv.jsdrv_buffer_response_s *> &(value[0].value.bin[0]))
+            elif value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_BUFFER_MULTI_RSP:
+                v = _parse_buffer_multi_rsp(<c_jsdrv.jsdrv_buffer_multi_response_s *> &(value[0].value.bin[0]))
+            elif value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_ALIGN_MAP:
+                v = _parse_align_map(<c_jsdrv.jsdrv_align_map_s *> &(value[0].value.bin[0]))
+            elif value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_ALIGN_FRAME:
+                v = _parse_align_frame(<c_jsdrv.jsdrv_align_frame_s *> &(value[0].value.bin[0]))
+            elif value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_HOST_DERIVED:
+                v = _parse_host_derived(<c_jsdrv.jsdrv_host_derived_s *> &(value[0].value.bin[0]))
+            elif value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_CONTINUITY:
+                v = _parse_continuity(<c_jsdrv.jsdrv_continuity_s *> &(value[0].value.bin[0]))
+            elif value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_STREAM_FRAME:
+                v = _parse_stream_frame(<c_jsdrv.jsdrv_stream_frame_s *> &(value[0].value.bin[0]))
+            elif value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_TRIGGER:
+                v = _parse_trigger_event(<c_jsdrv.jsdrv_trigger_event_s *> &(value[0].value.bin[0]))
+            elif value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_STREAM_EVENT:
+                v = _parse_stream_event(<c_jsdrv.jsdrv_stream_signal_s *> &(value[0].value.bin[0]), value[0].size)
             else:
                 v = value[0].value.bin[:value[0].size]
         elif t == c_jsdrv.JSDRV_UNION_F32:
@@ -366,6 +686,88 @@ cdef object _jsdrv_union_to_py(const c_jsdrv.jsdrv_union_s * value):
     return v
 
 
+_BENCHMARK_STREAM_TYPES = {
+    'f32': (c_jsdrv.JSDRV_DATA_TYPE_FLOAT, 32, False),
+    'u1': (c_jsdrv.JSDRV_DATA_TYPE_UINT, 1, False),
+    'u4': (c_jsdrv.JSDRV_DATA_TYPE_UINT, 4, False),
+    'u4_packed': (c_jsdrv.JSDRV_DATA_TYPE_UINT, 4, True),
+    'i16': (c_jsdrv.JSDRV_DATA_TYPE_INT, 16, False),
+}
+
+
+def _benchmark_convert(name, length, count):
+    """Convert a synthetic message with the binding internals.
+
+    :param name: The conversion, which is one of the _BENCHMARK_STREAM_TYPES
+        keys, 'statistics', 'buffer_rsp' or 'buffer_req'.
+    :param length: The number of stream samples or summary entries.
+    :param count: The number of conversions.
+    :return: The last converted value.
+
+    This function only exists for pyjoulescope_driver.test.benchmark,
+    which measures the per-message conversion cost without the driver.
+    """
+    cdef c_jsdrv.jsdrv_union_s v
+    cdef c_jsdrv.jsdrv_stream_signal_s * stream
+    cdef c_jsdrv.jsdrv_statistics_s * stats
+    cdef c_jsdrv.jsdrv_buffer_response_s * rsp
+    cdef uint8_t[:] mem
+    cdef bint u4_packed = False
+    x = None
+    if name == 'buffer_req':
+        req = {'time_type': 'utc', 'start': 0, 'end': 1000000, 'length': length,
+               'rsp_topic': 'a/bench/!rsp', 'rsp_id': 1}
+        for _ in range(count):
+            x = _pack_buffer_req(req)
+        return x
+
+    buf = bytearray(sizeof(c_jsdrv.jsdrv_stream_signal_s))
+    mem = buf
+    memset(&v, 0, sizeof(v))
+    v.type = c_jsdrv.JSDRV_UNION_BIN
+    v.value.bin = &mem[0]
+    v.size = <uint32_t> len(buf)
+    if name in _BENCHMARK_STREAM_TYPES:
+        element_type, element_size_bits, u4_packed = _BENCHMARK_STREAM_TYPES[name]
+        if length * element_size_bits > 8 * JSDRV_STREAM_PAYLOAD_LENGTH_MAX:
+            raise ValueError(f'length too large: {length}')
+        stream = <c_jsdrv.jsdrv_stream_signal_s *> &mem[0]
+        stream[0].element_type = element_type
+        stream[0].element_size_bits = element_size_bits
+        stream[0].element_count = length
+        stream[0].sample_rate = 1000000
+        stream[0].decimate_factor = 1
+        stream[0].time_map.counter_rate = 1000000.0
+        v.app = c_jsdrv.JSDRV_PAYLOAD_TYPE_STREAM
+    elif name == 'statistics':
+        stats = <c_jsdrv.jsdrv_statistics_s *> &mem[0]
+        stats[0].version = 1
+        stats[0].decimate_factor = 1
+        stats[0].block_sample_count = 500000
+        stats[0].sample_freq = 1000000
+        stats[0].time_map.counter_rate = 1000000.0
+        v.app = c_jsdrv.JSDRV_PAYLOAD_TYPE_STATISTICS
+    elif name == 'buffer_rsp':
+        if sizeof(c_jsdrv.jsdrv_buffer_response_s) + 16 * length > len(buf):
+            raise ValueError(f'length too large: {length}')
+        rsp = <c_jsdrv.jsdrv_buffer_response_s *> &mem[0]
+        rsp[0].version = 1
+        rsp[0].response_type = c_jsdrv.JSDRV_BUFFER_RESPONSE_SUMMARY
+        rsp[0].flags = c_jsdrv.JSDRV_BUFFER_RESPONSE_FLAG_FINAL
+        rsp[0].info.field_id = c_jsdrv.JSDRV_FIELD_CURRENT
+        rsp[0].info.element_type = c_jsdrv.JSDRV_DATA_TYPE_FLOAT
+        rsp[0].info.element_size_bits = 32
+        rsp[0].info.time_range_samples.length = length
+        rsp[0].info.time_range_utc.length = length
+        rsp[0].info.time_map.counter_rate = 1000000.0
+        v.app = c_jsdrv.JSDRV_PAYLOAD_TYPE_BUFFER_RSP
+    else:
+        raise ValueError(f'invalid conversion: {name}')
+    for _ in range(count):
+        x = _jsdrv_union_to_py(&v, u4_packed)
+    return x
+
+
 class ErrorCode:
     """The error code enumeration."""
     # automatically maintained by error_code_update.py
@@ -557,6 +959,574 @@ _SUBSCRIBE_FLAG_LOOKUP = {
 }
 
 
+cdef enum _ring_type_e:
+    _RING_TYPE_F32 = 0
+    _RING_TYPE_U8 = 1
+    _RING_TYPE_I16 = 2
+
+
+cdef class StreamRing:
+    """A preallocated sample ring for allocation-free stream callbacks.
+
+    :param length: The ring length in elements, which must hold at least
+        one stream message.
+    :param dtype: The ring element type, which must match the subscribed
+        stream: np.float32 for float32 signals, np.int16 for int16
+        signals, or np.uint8 for u8, u4 (one per byte, or 2 per byte
+        when subscribed with packed=True) and u1 (packed 8 per byte)
+        signals.
+
+    Provide an instance to :meth:`Driver.subscribe` with ring=.  For
+    each stream message, the driver copies the samples into :attr:`data`
+    with a single memcpy, updates the attributes from the message
+    header, and then calls fn(topic, ring).  Unlike the default
+    subscription, this does not allocate an ndarray or a dict for
+    each message.
+
+    The samples of the most recent message are contiguous at
+    data[offset:offset + size], which :attr:`latest` returns as a view.
+    The ring wraps to index 0 when a message does not fit before the
+    end, so the samples remain valid until later messages overwrite
+    them.  Copy any samples retained longer.  The data array is
+    read-only to Python.
+    """
+    cdef readonly object data           #: The np.ndarray ring storage.
+    cdef uint8_t * _ptr
+    cdef _ring_type_e _type
+    cdef uint32_t _itemsize
+    cdef uint32_t _offset_next
+    cdef readonly uint32_t length       #: The ring length in elements.
+    cdef readonly uint32_t offset       #: The data index for the most recent message.
+    cdef readonly uint32_t size         #: The data elements for the most recent message.
+    cdef readonly uint32_t element_count  #: The samples in the most recent message.
+    cdef readonly uint64_t sample_id    #: The sample_id for the first sample of the most recent message.
+    cdef readonly uint8_t field_id
+    cdef readonly uint8_t index
+    cdef readonly uint32_t sample_rate
+    cdef readonly uint32_t decimate_factor
+    cdef readonly uint64_t message_count  #: The total messages written.
+    cdef readonly uint64_t drop_count   #: The messages skipped due to type or size mismatch.
+    cdef c_jsdrv.jsdrv_time_map_s _time_map
+
+    def __init__(self, length, dtype=np.float32):
+        dtype = np.dtype(dtype)
+        if dtype == np.float32:
+            self._type = _RING_TYPE_F32
+        elif dtype == np.uint8:
+            self._type = _RING_TYPE_U8
+        elif dtype == np.int16:
+            self._type = _RING_TYPE_I16
+        else:
+            raise ValueError(f'unsupported dtype: {dtype}')
+        length = int(length)
+        if length <= 0:
+            raise ValueError(f'invalid length: {length}')
+        data = np.zeros(length, dtype=dtype)
+        self._ptr = <uint8_t *> np.PyArray_DATA(<np.ndarray> data)
+        data.flags.writeable = False
+        self.data = data
+        self._itemsize = dtype.itemsize
+        self.length = length
+        memset(&self._time_map, 0, sizeof(self._time_map))
+
+    @property
+    def latest(self):
+        """The read-only view of the most recent message samples."""
+        return self.data[self.offset:self.offset + self.size]
+
+    @property
+    def utc(self):
+        """The i64 UTC time for :attr:`sample_id`."""
+        return c_jsdrv.jsdrv_time_from_counter(&self._time_map, self.sample_id)
+
+    @property
+    def time_map(self):
+        """The time map dict for the most recent message."""
+        return {
+            'offset_time': self._time_map.offset_time,
+            'offset_counter': self._time_map.offset_counter,
+            'counter_rate': self._time_map.counter_rate,
+        }
+
+    cdef int32_t _recv(self, const c_jsdrv.jsdrv_stream_signal_s * s, bint packed) noexcept nogil:
+        cdef uint32_t n = s[0].element_count
+        cdef uint32_t size = n
+        cdef uint8_t * dst
+        cdef bint valid
+        cdef bint unpack_u4 = False
+        if s[0].element_type == c_jsdrv.JSDRV_DATA_TYPE_FLOAT and s[0].element_size_bits == 32:
+            valid = self._type == _RING_TYPE_F32
+        elif s[0].element_type == c_jsdrv.JSDRV_DATA_TYPE_INT and s[0].element_size_bits == 16:
+            valid = self._type == _RING_TYPE_I16
+        elif s[0].element_type == c_jsdrv.JSDRV_DATA_TYPE_UINT and s[0].element_size_bits == 8:
+            valid = self._type == _RING_TYPE_U8
+        elif s[0].element_type == c_jsdrv.JSDRV_DATA_TYPE_UINT and s[0].element_size_bits == 4:
+            valid = self._type == _RING_TYPE_U8
+            if packed:
+                size = (n + 1) // 2
+            else:
+                unpack_u4 = True
+        elif s[0].element_type == c_jsdrv.JSDRV_DATA_TYPE_UINT and s[0].element_size_bits == 1:
+            valid = self._type == _RING_TYPE_U8
+            size = (n + 7) // 8
+        else:
+            valid = False
+        if not valid or size > self.length:
+            self.drop_count += 1
+            return 1
+        if (self._offset_next + size) > self.length:
+            self._offset_next = 0
+        dst = self._ptr + <size_t> self._offset_next * self._itemsize
+        if unpack_u4:
+            c_jsdrv.jsdrv_unpack_u4(dst, s[0].data, n)
+        else:
+            memcpy(dst, s[0].data, <size_t> size * self._itemsize)
+        self.offset = self._offset_next
+        self._offset_next += size
+        self.size = size
+        self.element_count = n
+        self.sample_id = s[0].sample_id
+        self.field_id = s[0].field_id
+        self.index = s[0].index
+        self.sample_rate = s[0].sample_rate
+        self.decimate_factor = s[0].decimate_factor
+        self._time_map = s[0].time_map
+        self.message_count += 1
+        return 0
+
+
+cdef void _arrow_schema_capsule_free(object capsule) noexcept:
+    cdef c_jsdrv.ArrowSchema * schema = <c_jsdrv.ArrowSchema *> PyCapsule_GetPointer(capsule, 'arrow_schema')
+    if schema[0].release != NULL:  # not imported
+        schema[0].release(schema)
+    free(schema)
+
+
+cdef void _arrow_array_capsule_free(object capsule) noexcept:
+    cdef c_jsdrv.ArrowArray * array = <c_jsdrv.ArrowArray *> PyCapsule_GetPointer(capsule, 'arrow_array')
+    if array[0].release != NULL:  # not imported
+        array[0].release(array)
+    free(array)
+
+
+cdef class ArrowBatch:
+    """One Arrow record batch from :class:`ArrowBatcher`.
+
+    The batch implements the Arrow PyCapsule interface, so pyarrow,
+    Polars and other Arrow consumers import the columns without a copy,
+    for example with pyarrow.record_batch(batch).  Each batch can be
+    imported once.
+    """
+    cdef c_jsdrv.ArrowSchema * _schema
+    cdef c_jsdrv.ArrowArray * _array
+    cdef readonly int64_t length        #: The number of rows.
+
+    def __dealloc__(self):
+        if self._schema != NULL:
+            if self._schema[0].release != NULL:
+                self._schema[0].release(self._schema)
+            free(self._schema)
+            self._schema = NULL
+        if self._array != NULL:
+            if self._array[0].release != NULL:
+                self._array[0].release(self._array)
+            free(self._array)
+            self._array = NULL
+
+    def __len__(self):
+        return self.length
+
+    def __arrow_c_array__(self, requested_schema=None):
+        """Export the batch as (schema, array) PyCapsules."""
+        if self._array == NULL:
+            raise RuntimeError('ArrowBatch already exported')
+        schema_capsule = PyCapsule_New(<void *> self._schema, 'arrow_schema', _arrow_schema_capsule_free)
+        self._schema = NULL
+        array_capsule = PyCapsule_New(<void *> self._array, 'arrow_array', _arrow_array_capsule_free)
+        self._array = NULL
+        return schema_capsule, array_capsule
+
+    def to_pyarrow(self):
+        """Import the batch as a pyarrow.RecordBatch."""
+        import pyarrow
+        return pyarrow.record_batch(self)
+
+
+cdef class ArrowBatcher:
+    """Accumulate samples natively into Arrow record batches.
+
+    :param row_count: The rows for each batch.
+
+    Provide an instance to :meth:`Driver.subscribe` with arrow=.  The
+    driver copies the samples from each stream message or buffer
+    response into the pending batch, and calls fn(topic, batch) with
+    each completed :class:`ArrowBatch`.  The columns are sample_id,
+    utc in UNIX nanoseconds from the time_map, and value, or avg,
+    std, min and max for summary responses.  Use one instance for
+    each signal.  See jsdrv/arrow.h.
+    """
+    cdef c_jsdrv.jsdrv_arrow_batcher_s * _batcher
+    cdef readonly uint32_t row_count    #: The rows for each batch.
+    cdef readonly uint64_t drop_count   #: The messages skipped due to unsupported types.
+
+    def __init__(self, row_count):
+        row_count = int(row_count)
+        self._batcher = c_jsdrv.jsdrv_arrow_batcher_alloc(row_count) if row_count > 0 else NULL
+        if self._batcher == NULL:
+            raise ValueError(f'invalid row_count: {row_count}')
+        self.row_count = row_count
+
+    def __dealloc__(self):
+        c_jsdrv.jsdrv_arrow_batcher_free(self._batcher)
+        self._batcher = NULL
+
+    @property
+    def ready(self):
+        """The number of completed batches."""
+        return c_jsdrv.jsdrv_arrow_batcher_ready(self._batcher)
+
+    cdef int32_t _recv(self, const c_jsdrv.jsdrv_union_s * value) noexcept nogil:
+        cdef int32_t rc
+        if value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_STREAM:
+            rc = c_jsdrv.jsdrv_arrow_batcher_add_stream(
+                self._batcher, <const c_jsdrv.jsdrv_stream_signal_s *> &(value[0].value.bin[0]))
+        else:
+            rc = c_jsdrv.jsdrv_arrow_batcher_add_buffer_rsp(
+                self._batcher, <const c_jsdrv.jsdrv_buffer_response_s *> &(value[0].value.bin[0]))
+        if rc:
+            self.drop_count += 1
+        return rc
+
+    def pop(self, partial=False):
+        """Get the oldest completed batch.
+
+        :param partial: When True and no batch is complete, return the
+            pending rows as a shorter batch.
+        :return: The :class:`ArrowBatch` or None.
+        """
+        cdef ArrowBatch batch = ArrowBatch.__new__(ArrowBatch)
+        cdef bint c_partial = bool(partial)
+        batch._schema = <c_jsdrv.ArrowSchema *> malloc(sizeof(c_jsdrv.ArrowSchema))
+        batch._array = <c_jsdrv.ArrowArray *> malloc(sizeof(c_jsdrv.ArrowArray))
+        if batch._schema == NULL or batch._array == NULL:
+            raise MemoryError()
+        batch._schema[0].release = NULL
+        batch._array[0].release = NULL
+        if c_jsdrv.jsdrv_arrow_batcher_pop(self._batcher, batch._schema, batch._array, c_partial):
+            return None
+        batch.length = batch._array[0].length
+        return batch
+
+
+STATISTICS_DTYPE = np.dtype([
+    ('version', np.uint8),
+    ('rsv1_u8', np.uint8),
+    ('rsv2_u8', np.uint8),
+    ('decimate_factor', np.uint8),
+    ('block_sample_count', np.uint32),
+    ('sample_freq', np.uint32),
+    ('rsv3_u8', np.uint32),
+    ('block_sample_id', np.uint64),
+    ('accum_sample_id', np.uint64),
+    ('i_avg', np.float64),
+    ('i_std', np.float64),
+    ('i_min', np.float64),
+    ('i_max', np.float64),
+    ('v_avg', np.float64),
+    ('v_std', np.float64),
+    ('v_min', np.float64),
+    ('v_max', np.float64),
+    ('p_avg', np.float64),
+    ('p_std', np.float64),
+    ('p_min', np.float64),
+    ('p_max', np.float64),
+    ('charge_f64', np.float64),
+    ('energy_f64', np.float64),
+    ('charge_i128', np.uint64, (2,)),
+    ('energy_i128', np.uint64, (2,)),
+    ('offset_time', np.int64),
+    ('offset_counter', np.uint64),
+    ('counter_rate', np.float64),
+])  #: The NumPy structured dtype matching struct jsdrv_statistics_s.
+
+if STATISTICS_DTYPE.itemsize != sizeof(c_jsdrv.jsdrv_statistics_s):
+    raise ImportError('STATISTICS_DTYPE does not match jsdrv_statistics_s')
+
+
+cdef class StatisticsBatcher:
+    """Deliver statistics as NumPy structured arrays.
+
+    :param count: The statistics updates for each delivery.
+
+    Provide an instance to :meth:`Driver.subscribe` with statistics=.
+    Each statistics message copies into the next row of a
+    :data:`STATISTICS_DTYPE` array with a single memcpy.  When the
+    array has count rows, the driver calls fn(topic, array).  With
+    count=1, the driver calls fn(topic, value) with the structured
+    scalar instead.  Unlike the default subscription, this does not
+    construct nested dicts for each update.  Compute utc from the
+    offset_time, offset_counter and counter_rate fields, see
+    jsdrv_time_from_counter().
+    """
+    cdef readonly uint32_t count        #: The rows for each delivery.
+    cdef readonly uint32_t length       #: The rows pending delivery.
+    cdef readonly uint64_t message_count  #: The total statistics received.
+    cdef object _data
+    cdef uint8_t * _ptr
+
+    def __init__(self, count=1):
+        count = int(count)
+        if count <= 0:
+            raise ValueError(f'invalid count: {count}')
+        self.count = count
+        self._alloc()
+
+    cdef _alloc(self):
+        self._data = np.empty(self.count, dtype=STATISTICS_DTYPE)
+        self._ptr = <uint8_t *> np.PyArray_DATA(<np.ndarray> self._data)
+        self.length = 0
+
+    cdef object _recv(self, const c_jsdrv.jsdrv_statistics_s * stats):
+        memcpy(self._ptr + <size_t> self.length * sizeof(c_jsdrv.jsdrv_statistics_s), stats,
+               sizeof(c_jsdrv.jsdrv_statistics_s))
+        self.length += 1
+        self.message_count += 1
+        if self.length < self.count:
+            return None
+        data = self._data
+        self._alloc()
+        return data[0] if self.count == 1 else data
+
+    def flush(self):
+        """Get the pending rows.
+
+        :return: The array with fewer than count rows, or None when
+            no rows are pending.
+        """
+        if self.length == 0:
+            return None
+        data = self._data[:self.length].copy()
+        self.length = 0
+        return data
+
+
+cdef class _Subscriber:
+    cdef object fn
+    cdef StreamRing ring
+    cdef ArrowBatcher arrow
+    cdef StatisticsBatcher statistics
+    cdef bint packed
+
+    def __init__(self, fn, StreamRing ring, packed, ArrowBatcher arrow=None, StatisticsBatcher statistics=None):
+        self.fn = fn
+        self.ring = ring
+        self.arrow = arrow
+        self.statistics = statistics
+        self.packed = bool(packed)
+
+
+cdef struct _batch_queue_s:
+    c_jsdrv.jsdrv_context_s * context
+    c_jsdrv.msg_queue_s * queue
+
+
+_BATCH_SIZE_MAX = 1024
+_BATCH_POLL_MS = 100
+
+
+cdef class _BatchSubscriber:
+    """Deliver messages to fn(list) from a dedicated Python thread.
+
+    The driver callback copies each message into a pooled driver
+    message and queues it without acquiring the GIL.  The thread
+    acquires the GIL once per batch.
+    """
+    cdef _batch_queue_s _q
+    cdef object fn
+    cdef bint packed
+    cdef bint _quit
+    cdef object _thread
+
+    def __init__(self, fn, packed):
+        self.fn = fn
+        self.packed = bool(packed)
+        self._q.context = NULL
+        self._q.queue = c_jsdrv.msg_queue_init()
+        self._quit = False
+        self._thread = None
+
+    cdef void * user_data(self):
+        return <void *> &self._q
+
+    def start(self):
+        self._thread = threading.Thread(name='jsdrv_batch', target=self._run, daemon=True)
+        self._thread.start()
+
+    def _run(self):
+        cdef c_jsdrv.jsdrvp_msg_s * msg = NULL
+        cdef int32_t rc
+        cdef uint32_t timeout_ms = _BATCH_POLL_MS
+        while not self._quit:
+            with nogil:
+                rc = c_jsdrv.msg_queue_pop(self._q.queue, &msg, timeout_ms)
+            if rc == 0:
+                self._deliver(msg)
+
+    cdef _deliver(self, c_jsdrv.jsdrvp_msg_s * msg):
+        batch = []
+        while msg != NULL:
+            try:
+                batch.append((msg[0].topic.decode('utf-8'), _jsdrv_union_to_py(&msg[0].value, self.packed)))
+            except Exception:
+                _log_c.exception('_BatchSubscriber could not convert message')
+            c_jsdrv.jsdrvp_msg_free(self._q.context, msg)
+            if len(batch) >= _BATCH_SIZE_MAX:
+                break
+            msg = c_jsdrv.msg_queue_pop_immediate(self._q.queue)
+        if len(batch):
+            try:
+                self.fn(batch)
+            except Exception:
+                _log_c.exception('_BatchSubscriber callback')
+
+    def stop(self):
+        """Stop the thread and release pending messages.
+
+        Call only after unsubscribing so that no more messages arrive.
+        """
+        cdef c_jsdrv.jsdrvp_msg_s * msg
+        self._quit = True
+        if self._thread is not None:
+            self._thread.join()
+            self._thread = None
+        if self._q.queue != NULL:
+            msg = c_jsdrv.msg_queue_pop_immediate(self._q.queue)
+            while msg != NULL:
+                c_jsdrv.jsdrvp_msg_free(self._q.context, msg)
+                msg = c_jsdrv.msg_queue_pop_immediate(self._q.queue)
+            c_jsdrv.msg_queue_finalize(self._q.queue)
+            self._q.queue = NULL
+
+
+cdef enum _buffer_read_format_e:
+    _BUFFER_READ_F32 = 0
+    _BUFFER_READ_U8 = 1
+    _BUFFER_READ_SUMMARY = 2
+
+
+cdef struct _buffer_read_signal_s:
+    uint8_t * dst
+    uint64_t dst_length         # in elements, which are 4 floats for summary
+    uint8_t dst_format          # _buffer_read_format_e
+    uint8_t done
+    int32_t status
+    uint64_t start              # the first written element
+    uint64_t end                # one past the last written element
+
+
+cdef struct _buffer_read_s:
+    c_jsdrv.jsdrv_context_s * context
+    c_jsdrv.msg_queue_s * done_q
+    uint64_t t0
+    uint64_t incr
+    uint32_t signal_count
+    uint32_t pending            # modified only on the frontend thread
+    _buffer_read_signal_s * signals
+
+
+_BUFFER_READ_TIMEOUT_MS_DEFAULT = 10000
+_buffer_read_count = 0
+_statistics_history_count = 0
+
+
+cdef void _buffer_read_copy(_buffer_read_s * r, _buffer_read_signal_s * s,
+                            const c_jsdrv.jsdrv_buffer_response_s * rsp) noexcept nogil:
+    cdef uint64_t start = rsp[0].info.time_range_samples.start
+    cdef uint64_t length = rsp[0].info.time_range_samples.length
+    cdef const uint8_t * src = <const uint8_t *> &rsp[0].data[0]
+    cdef float * dst_f32
+    cdef uint64_t pos
+    cdef uint64_t k
+    cdef uint8_t bits = rsp[0].info.element_size_bits
+
+    if start < r[0].t0:
+        return
+    pos = (start - r[0].t0) // r[0].incr
+    if pos >= s[0].dst_length:
+        return
+    if length > (s[0].dst_length - pos):
+        length = s[0].dst_length - pos
+    if length == 0:
+        return
+
+    if rsp[0].response_type == c_jsdrv.JSDRV_BUFFER_RESPONSE_SUMMARY:
+        if s[0].dst_format != _BUFFER_READ_SUMMARY:
+            s[0].status = c_jsdrv.JSDRV_ERROR_PARAMETER_INVALID
+            return
+        memcpy(s[0].dst + pos * sizeof(c_jsdrv.jsdrv_summary_entry_s), src,
+               length * sizeof(c_jsdrv.jsdrv_summary_entry_s))
+    elif rsp[0].response_type != c_jsdrv.JSDRV_BUFFER_RESPONSE_SAMPLES:
+        s[0].status = c_jsdrv.JSDRV_ERROR_NOT_SUPPORTED
+        return
+    elif rsp[0].info.element_type == c_jsdrv.JSDRV_DATA_TYPE_FLOAT and bits == 32:
+        if s[0].dst_format != _BUFFER_READ_F32:
+            s[0].status = c_jsdrv.JSDRV_ERROR_PARAMETER_INVALID
+            return
+        memcpy(s[0].dst + pos * sizeof(float), src, length * sizeof(float))
+    elif rsp[0].info.element_type == c_jsdrv.JSDRV_DATA_TYPE_UINT and (bits == 1 or bits == 4):
+        if s[0].dst_format == _BUFFER_READ_U8:
+            if bits == 1:
+                c_jsdrv.jsdrv_unpack_u1(s[0].dst + pos, src, <uint32_t> length)
+            else:
+                c_jsdrv.jsdrv_unpack_u4(s[0].dst + pos, src, <uint32_t> length)
+        elif s[0].dst_format == _BUFFER_READ_F32:
+            dst_f32 = (<float *> s[0].dst) + pos
+            if bits == 1:
+                for k in range(length):
+                    dst_f32[k] = <float> ((src[k >> 3] >> (k & 7)) & 1)
+            else:
+                for k in range(length):
+                    dst_f32[k] = <float> ((src[k >> 1] >> ((k & 1) * 4)) & 0x0f)
+        else:
+            s[0].status = c_jsdrv.JSDRV_ERROR_PARAMETER_INVALID
+            return
+    else:
+        s[0].status = c_jsdrv.JSDRV_ERROR_NOT_SUPPORTED
+        return
+
+    if s[0].start == s[0].end:
+        s[0].start = pos
+        s[0].end = pos + length
+    else:
+        if pos < s[0].start:
+            s[0].start = pos
+        if (pos + length) > s[0].end:
+            s[0].end = pos + length
+
+
+cdef void _on_buffer_read_cbk(void * user_data, const char * topic,
+                              const c_jsdrv.jsdrv_union_s * value) noexcept nogil:
+    cdef _buffer_read_s * r = <_buffer_read_s *> user_data
+    cdef const c_jsdrv.jsdrv_buffer_response_s * rsp
+    cdef _buffer_read_signal_s * s
+    cdef c_jsdrv.jsdrv_union_s v
+    if value[0].type != c_jsdrv.JSDRV_UNION_BIN or value[0].app != c_jsdrv.JSDRV_PAYLOAD_TYPE_BUFFER_RSP:
+        return
+    rsp = <const c_jsdrv.jsdrv_buffer_response_s *> &(value[0].value.bin[0])
+    if rsp[0].rsp_id < 0 or rsp[0].rsp_id >= <int64_t> r[0].signal_count:
+        return
+    s = &r[0].signals[rsp[0].rsp_id]
+    if s[0].done:
+        return
+    _buffer_read_copy(r, s, rsp)
+    if rsp[0].flags & c_jsdrv.JSDRV_BUFFER_RESPONSE_FLAG_FINAL:
+        s[0].done = 1
+        r[0].pending -= 1
+        if r[0].pending == 0:
+            memset(&v, 0, sizeof(v))
+            c_jsdrv.msg_queue_push(r[0].done_q, c_jsdrv.jsdrvp_msg_alloc_value(r[0].context, topic, &v))
+
+
 _DEVICE_OPEN_MODES = {
     0: 0,
     'defaults': 0,
@@ -569,6 +1539,7 @@ _DEVICE_OPEN_MODES = {
 
 
 cdef int32_t _driver_count = 0
+_module_lock = threading.Lock()     # protects _driver_count and the response topic counters
 _TIMEOUT_MS_DEFAULT = 1000
 _TIMEOUT_MS_INIT = 5000
 
@@ -595,28 +1566,128 @@ def _handle_rc(rc, src, cause=None):
             raise RuntimeError(f'{src} failed {rc} {name} | {description}{cause}')
 
 
+cdef object _publish_value(topic, value, c_jsdrv.jsdrv_union_s * v):
+    """Populate v for publishing value to topic.
+
+    :return: The object that owns any buffer referenced by v, which
+        must remain alive until the publish call returns.
+    """
+    cdef char * byte_str
+    cdef object owner = None
+    memset(v, 0, sizeof(v[0]))
+    if isinstance(value, str):
+        owner = value.encode('utf-8')
+        byte_str = owner
+        v[0].type = c_jsdrv.JSDRV_UNION_STR
+        v[0].value.str = &byte_str[0]
+    elif isinstance(value, int):
+        if (value >= 0) and (value < 4294967296LL):
+            v[0].type = c_jsdrv.JSDRV_UNION_U32
+            v[0].value.u64 = value
+        elif value >= 0:
+            v[0].type = c_jsdrv.JSDRV_UNION_U64
+            v[0].value.u64 = value
+        elif value >= -2147483648LL:
+            v[0].type = c_jsdrv.JSDRV_UNION_I32
+            v[0].value.i64 = value
+        else:
+            v[0].type = c_jsdrv.JSDRV_UNION_I64
+            v[0].value.i64 = value
+    elif topic.startswith('m/') and topic.endswith('/g/!req'):
+        owner = _pack_buffer_multi_req(value)
+        byte_str = owner
+        v[0].type = c_jsdrv.JSDRV_UNION_BIN
+        v[0].value.bin = <const uint8_t *> byte_str
+        v[0].app = c_jsdrv.JSDRV_PAYLOAD_TYPE_BUFFER_MULTI_REQ
+        v[0].size = <uint32_t> len(owner)
+    elif topic == '@/stats/!hist':
+        owner = _pack_statistics_history_req(value)
+        byte_str = owner
+        v[0].type = c_jsdrv.JSDRV_UNION_BIN
+        v[0].value.bin = <const uint8_t *> byte_str
+        v[0].app = c_jsdrv.JSDRV_PAYLOAD_TYPE_STATISTICS_HISTORY_REQ
+        v[0].size = <uint32_t> len(owner)
+    elif topic.startswith('m/') and topic.endswith('/!req'):
+        owner = _pack_buffer_req(value)
+        byte_str = owner
+        v[0].type = c_jsdrv.JSDRV_UNION_BIN
+        v[0].value.bin = <const uint8_t *> byte_str
+        v[0].app = c_jsdrv.JSDRV_PAYLOAD_TYPE_BUFFER_REQ
+        v[0].size = <uint32_t> len(owner)
+    elif isinstance(value, bytes):
+        owner = value
+        byte_str = owner
+        v[0].type = c_jsdrv.JSDRV_UNION_BIN
+        v[0].value.bin = <const uint8_t *> byte_str
+        v[0].size = <uint32_t> len(owner)
+    elif isinstance(value, float):
+        v[0].type = c_jsdrv.JSDRV_UNION_F64
+        v[0].value.f64 = value
+    else:
+        raise ValueError(f'Unsupported value type: {type(value)}')
+    if '!' not in topic:
+        v[0].flags = c_jsdrv.JSDRV_UNION_FLAG_RETAIN
+    return owner
+
+
+cdef class _AsyncOp:
+    """The state for one publish_async() or query_async() operation."""
+    cdef object fn
+    cdef c_jsdrv.jsdrv_union_s v
+    cdef char buf[1024]
+
+    def __init__(self, fn):
+        self.fn = fn
+        self.v.type = c_jsdrv.JSDRV_UNION_BIN
+        self.v.size = sizeof(self.buf)
+        self.v.value.str = self.buf
+
+
 cdef class Driver:
     """The Joulescope driver class.
 
     :param timeout: The optional timeout for open.
         None (default) uses the default timeout.
+    :param args: The optional map of jsdrv_initialize() argument names
+        to values, such as {'emulated/js220': 1}.
     """
     cdef c_jsdrv.jsdrv_context_s * _context
+    cdef object _lock                   # protects the subscriber containers
     cdef object _subscribers
+    cdef object _opt_subscribers
+    cdef object _batch_subscribers
+    cdef object _stream_readers
 
-    def __init__(self, timeout=None):
+    def __init__(self, timeout=None, args=None):
         global _driver_count
         self._context = NULL
         cdef int32_t rc
+        cdef c_jsdrv.jsdrv_arg_s * c_args = NULL
         timeout_ms = _timeout_validate(timeout, _TIMEOUT_MS_INIT)
-        with nogil:
-            rc = c_jsdrv.jsdrv_initialize(&self._context, NULL, timeout_ms)
+        owners = []  # keep argument strings alive until initialized
+        if args:
+            c_args = <c_jsdrv.jsdrv_arg_s *> calloc(len(args) + 1, sizeof(c_jsdrv.jsdrv_arg_s))  # NULL topic terminates
+            for idx, (name, value) in enumerate(args.items()):
+                name_bytes = name.encode('utf-8')
+                owners.append(name_bytes)
+                c_args[idx].topic = name_bytes
+                owners.append(_publish_value(name, value, &c_args[idx].value))
+        try:
+            with nogil:
+                rc = c_jsdrv.jsdrv_initialize(&self._context, c_args, timeout_ms)
+        finally:
+            free(c_args)
         _handle_rc(rc, 'jsdrv_initialize')
+        self._lock = threading.Lock()
         self._subscribers = set()  # (topic, fn)
-        if _driver_count == 0:
-            c_jsdrv.jsdrv_log_initialize()
-            c_jsdrv.jsdrv_log_register(_on_log_recv, NULL)
-        _driver_count += 1
+        self._opt_subscribers = {}  # (topic, fn) -> _Subscriber
+        self._batch_subscribers = {}  # (topic, fn) -> _BatchSubscriber
+        self._stream_readers = weakref.WeakSet()
+        with _module_lock:
+            if _driver_count == 0:
+                c_jsdrv.jsdrv_log_initialize()
+                c_jsdrv.jsdrv_log_register(_on_log_recv, NULL)
+            _driver_count += 1
 
     def __enter__(self):
         return self
@@ -651,10 +1722,21 @@ cdef class Driver:
         global _driver_count
         cdef c_jsdrv.jsdrv_context_s * context = self._context
         timeout_ms = _timeout_validate(timeout)
+        with self._lock:
+            batch_keys = list(self._batch_subscribers.keys())
+            stream_readers = list(self._stream_readers)
+        for reader in stream_readers:
+            reader.close()
+        for topic, fn in batch_keys:
+            try:
+                self.unsubscribe(topic, fn, timeout)
+            except Exception:
+                _log_c.exception(f'finalize unsubscribe {topic}')
         with nogil:
             c_jsdrv.jsdrv_finalize(context, timeout_ms)
+        with _module_lock:
             c_jsdrv.jsdrv_log_finalize()
-        _driver_count -= 1
+            _driver_count -= 1
 
     def publish(self, topic: str, value, timeout=None):
         """Publish a value to a topic.
@@ -666,48 +1748,9 @@ cdef class Driver:
         :raise: On error.
         """
         cdef c_jsdrv.jsdrv_union_s v
-        cdef char * byte_str
         cdef const uint8_t[:] topic_str = topic.encode('utf-8')
         cdef int32_t timeout_ms = _timeout_validate(timeout)
-
-        memset(&v, 0, sizeof(v))
-        if isinstance(value, str):
-            py_byte_str = value.encode('utf-8')
-            byte_str = py_byte_str
-            v.type = c_jsdrv.JSDRV_UNION_STR
-            v.value.str = &byte_str[0]
-        elif isinstance(value, int):
-            if (value >= 0) and (value < 4294967296LL):
-                v.type = c_jsdrv.JSDRV_UNION_U32
-                v.value.u64 = value
-            elif value >= 0:
-                v.type = c_jsdrv.JSDRV_UNION_U64
-                v.value.u64 = value
-            elif value >= -2147483648LL:
-                v.type = c_jsdrv.JSDRV_UNION_I32
-                v.value.i64 = value
-            else:
-                v.type = c_jsdrv.JSDRV_UNION_I64
-                v.value.i64 = value
-        elif topic.startswith('m/') and topic.endswith('/!req'):
-            value = _pack_buffer_req(value)
-            byte_str = value
-            v.type = c_jsdrv.JSDRV_UNION_BIN
-            v.value.bin = <const uint8_t *> byte_str
-            v.app = c_jsdrv.JSDRV_PAYLOAD_TYPE_BUFFER_REQ
-            v.size = <uint32_t> len(value)
-        elif isinstance(value, bytes):
-            byte_str = value
-            v.type = c_jsdrv.JSDRV_UNION_BIN
-            v.value.bin = <const uint8_t *> byte_str
-            v.size = <uint32_t> len(value)
-        elif isinstance(value, float):
-            v.type = c_jsdrv.JSDRV_UNION_F64
-            v.value.f64 = value
-        else:
-            raise ValueError(f'Unsupported value type: {type(value)}')
-        if '!' not in topic:
-            v.flags = c_jsdrv.JSDRV_UNION_FLAG_RETAIN
+        owner = _publish_value(topic, value, &v)
         with nogil:
             rc = c_jsdrv.jsdrv_publish(self._context, <char *> &topic_str[0], &v, timeout_ms)
         _handle_rc(rc, 'jsdrv_publish', topic)
@@ -734,6 +1777,99 @@ cdef class Driver:
         _handle_rc(rc, 'jsdrv_query', topic)
         return _jsdrv_union_to_py(&v)
 
+    def publish_async(self, topic: str, value, callback, timeout=None):
+        """Publish a value to a topic without blocking.
+
+        :param topic: The topic string.
+        :param value: The value, which must pass validation for the topic.
+        :param callback: The callable(topic, return_code) called from the
+            driver thread on completion.  Asyncio applications should use
+            loop.call_soon_threadsafe() to resolve a future.
+        :param timeout: The timeout in seconds.  None (default) uses
+            the default timeout.
+        :raise: On error starting the operation.
+        """
+        cdef c_jsdrv.jsdrv_union_s v
+        cdef const uint8_t[:] topic_str = topic.encode('utf-8')
+        cdef int32_t timeout_ms = _timeout_validate(timeout)
+        cdef _AsyncOp op = _AsyncOp(callback)
+        cdef void * op_ptr = <void *> op
+        owner = _publish_value(topic, value, &v)
+        Py_INCREF(op)  # released in _on_async_cbk
+        with nogil:
+            rc = c_jsdrv.jsdrv_publish_async(self._context, <char *> &topic_str[0], &v,
+                                             _on_async_cbk, op_ptr, timeout_ms)
+        if rc:
+            Py_DECREF(op)
+        _handle_rc(rc, 'jsdrv_publish_async', topic)
+
+    def query_async(self, topic: str, callback, timeout=None):
+        """Query the value for a topic without blocking.
+
+        :param topic: The topic name.
+        :param callback: The callable(topic, return_code, value) called from
+            the driver thread on completion.  value is None on error.
+        :param timeout: The timeout in seconds.  None (default) uses
+            the default timeout.
+        :raise: On error starting the operation.
+        """
+        cdef const uint8_t[:] topic_str = topic.encode('utf-8')
+        cdef int32_t timeout_ms = _timeout_validate(timeout)
+        cdef _AsyncOp op = _AsyncOp(callback)
+        cdef void * op_ptr = <void *> op
+        cdef c_jsdrv.jsdrv_union_s * v_ptr = &op.v
+        Py_INCREF(op)  # released in _on_async_cbk
+        with nogil:
+            rc = c_jsdrv.jsdrv_query_async(self._context, <char *> &topic_str[0], v_ptr,
+                                           _on_async_cbk, op_ptr, timeout_ms)
+        if rc:
+            Py_DECREF(op)
+        _handle_rc(rc, 'jsdrv_query_async', topic)
+
+    def query_snapshot(self, topic: str, flags=None, timeout=None):
+        """Query all retained values and metadata under a topic at once.
+
+        :param topic: The topic prefix, such as the device path.
+            Use '' for all topics.
+        :param flags: The flags or list of flags, see :meth:`subscribe`.
+            None (default) is ['pub', 'metadata_rsp'].
+        :param timeout: The timeout in seconds.  None (default) uses
+            the default timeout.
+        :return: The dict mapping each topic to its retained value.
+            Metadata keys have the '$' suffix.
+        :raise: On error.
+
+        Unlike :meth:`subscribe` with retain, this produces the whole
+        state in one frontend traversal with a single return.
+        """
+        cdef c_jsdrv.jsdrv_union_s v
+        cdef const uint8_t[:] topic_str = topic.encode('utf-8')
+        cdef int32_t timeout_ms = _timeout_validate(timeout)
+        cdef uint8_t c_flags = 0
+        cdef uint8_t[::1] buf
+        if flags is None:
+            flags = ['pub', 'metadata_rsp']
+        if isinstance(flags, str):
+            c_flags = _SUBSCRIBE_FLAG_LOOKUP[flags.lower()]
+        elif isinstance(flags, (list, tuple)):
+            for f in flags:
+                c_flags |= _SUBSCRIBE_FLAG_LOOKUP[f.lower()]
+        else:
+            c_flags = <uint8_t> int(flags)
+        size = 65536
+        for _ in range(2):
+            buf = np.empty(size, dtype=np.uint8)
+            v.type = c_jsdrv.JSDRV_UNION_JSON
+            v.size = size
+            v.value.bin = &buf[0]
+            with nogil:
+                rc = c_jsdrv.jsdrv_query_snapshot(self._context, <char *> &topic_str[0], c_flags, &v, timeout_ms)
+            if rc != ErrorCode.TOO_SMALL:
+                break
+            size = v.size  # retry with the required size
+        _handle_rc(rc, 'jsdrv_query_snapshot', topic)
+        return json.loads(bytes(buf[:v.size - 1]).decode('utf-8'))
+
     def device_paths(self, timeout=None):
         """List the currently connected devices.
 
@@ -746,7 +1882,8 @@ cdef class Driver:
             return []
         return sorted(s.split(','))
 
-    def subscribe(self, topic: str, flags, fn, timeout=None):
+    def subscribe(self, topic: str, flags, fn, timeout=None, ring=None, packed=False, batch=False, arrow=None,
+                  statistics=None):
         """Subscribe to receive topic updates.
 
         :param self: The driver instance.
@@ -774,12 +1911,43 @@ cdef class Driver:
         :param timeout: The timeout in float seconds to wait for this operation
             to complete.  None waits the default amount.
             0 does not wait and subscription will occur asynchronously.
+        :param ring: The optional :class:`StreamRing` instance.  When
+            provided, stream messages call fn(topic, ring) after copying
+            the samples into the ring, which avoids constructing a
+            dict and ndarray for each message.  Other messages
+            call fn(topic, value) as usual.
+        :param packed: When True, provide u4 stream data, such as the
+            current range, packed 2 samples per byte with the first
+            sample in the lower nibble.  The default False unpacks to
+            one sample per byte.  Each (topic, fn) pair supports at
+            most one subscription with ring, packed or batch.
+        :param batch: When True, call fn(messages) from a dedicated
+            Python thread, where messages is the list of (topic, value)
+            received since the previous call.  The driver thread
+            queues each message without acquiring the GIL, so slow
+            Python code does not stall the driver.  Messages queue
+            without bound, so fn must keep up on average.  Not
+            compatible with ring.
+        :param arrow: The optional :class:`ArrowBatcher` instance.  When
+            provided, stream messages and buffer responses add their
+            samples to the batcher, and each completed batch calls
+            fn(topic, batch) with an :class:`ArrowBatch`.  Other
+            messages call fn(topic, value) as usual.  Not compatible
+            with ring or batch.
+        :param statistics: The optional :class:`StatisticsBatcher`
+            instance.  When provided, statistics messages call
+            fn(topic, value) with NumPy structured values from the
+            batcher rather than dicts.  Other messages call
+            fn(topic, value) as usual.  Not compatible with batch.
         :raise RuntimeError: on subscribe failure.
         """
         cdef const uint8_t[:] topic_str = topic.encode('utf-8')
         cdef int32_t timeout_ms = _timeout_validate(timeout)
         cdef int32_t c_flags = 0
         cdef void * fn_ptr = <void *> fn
+        cdef c_jsdrv.jsdrv_subscribe_fn cbk_fn = _on_cmd_publish_cbk
+        cdef _Subscriber subscriber
+        cdef _BatchSubscriber batch_subscriber
 
         if isinstance(flags, str):
             c_flags = _SUBSCRIBE_FLAG_LOOKUP[flags.lower()]
@@ -788,9 +1956,41 @@ cdef class Driver:
                 c_flags |= _SUBSCRIBE_FLAG_LOOKUP[f.lower()]
         else:
             c_flags = <int32_t> int(flags)
-        self._subscribers.add((topic, fn))
+        if arrow is not None and not isinstance(arrow, ArrowBatcher):
+            raise TypeError('arrow must be an ArrowBatcher')
+        if statistics is not None and not isinstance(statistics, StatisticsBatcher):
+            raise TypeError('statistics must be a StatisticsBatcher')
+        if batch:
+            if ring is not None or arrow is not None or statistics is not None:
+                raise ValueError('batch does not support ring, arrow or statistics')
+            batch_subscriber = _BatchSubscriber(fn, packed)
+            batch_subscriber._q.context = self._context
+            with self._lock:
+                if (topic, fn) in self._batch_subscribers or (topic, fn) in self._opt_subscribers:
+                    raise ValueError(f'already subscribed: {topic}')
+                self._batch_subscribers[(topic, fn)] = batch_subscriber
+            batch_subscriber.start()
+            cbk_fn = _on_cmd_publish_batch_cbk
+            fn_ptr = batch_subscriber.user_data()
+        elif ring is not None or packed or arrow is not None or statistics is not None:
+            if ring is not None and not isinstance(ring, StreamRing):
+                raise TypeError('ring must be a StreamRing')
+            if ring is not None and arrow is not None:
+                raise ValueError('arrow does not support ring')
+            subscriber = _Subscriber(fn, ring, packed, arrow, statistics)
+            with self._lock:
+                if (topic, fn) in self._batch_subscribers or (topic, fn) in self._opt_subscribers:
+                    raise ValueError(f'already subscribed: {topic}')
+                self._opt_subscribers[(topic, fn)] = subscriber
+            cbk_fn = _on_cmd_publish_opt_cbk
+            fn_ptr = <void *> subscriber
+        else:
+            with self._lock:
+                if (topic, fn) in self._batch_subscribers:
+                    raise ValueError(f'already subscribed: {topic}')
+                self._subscribers.add((topic, fn))
         with nogil:
-            rc = c_jsdrv.jsdrv_subscribe(self._context, <char *> &topic_str[0], c_flags, _on_cmd_publish_cbk, fn_ptr, timeout_ms)
+            rc = c_jsdrv.jsdrv_subscribe(self._context, <char *> &topic_str[0], c_flags, cbk_fn, fn_ptr, timeout_ms)
         _handle_rc(rc, 'jsdrv_subscribe', topic)
 
     def unsubscribe(self, topic, fn, timeout=None):
@@ -805,10 +2005,31 @@ cdef class Driver:
         cdef const uint8_t[:] topic_str = topic.encode('utf-8')
         cdef int32_t timeout_ms = _timeout_validate(timeout)
         cdef void * fn_ptr = <void *> fn
-
+        cdef c_jsdrv.jsdrv_subscribe_fn cbk_fn = _on_cmd_publish_cbk
+
+        cdef _BatchSubscriber batch_subscriber
+
+        with self._lock:
+            batch_subscriber = self._batch_subscribers.pop((topic, fn), None)
+            subscriber = self._opt_subscribers.get((topic, fn))
+        if batch_subscriber is not None:
+            cbk_fn = _on_cmd_publish_batch_cbk
+            fn_ptr = batch_subscriber.user_data()
+            if timeout_ms == 0:
+                timeout_ms = _TIMEOUT_MS_DEFAULT  # must complete before stop
+        elif subscriber is not None:
+            cbk_fn = _on_cmd_publish_opt_cbk
+            fn_ptr = <void *> subscriber
         with nogil:
-            rc = c_jsdrv.jsdrv_unsubscribe(self._context, <char *> &topic_str[0], _on_cmd_publish_cbk, fn_ptr, timeout_ms)
-        self._subscribers.discard((topic, fn))
+            rc = c_jsdrv.jsdrv_unsubscribe(self._context, <char *> &topic_str[0], cbk_fn, fn_ptr, timeout_ms)
+        if batch_subscriber is not None:
+            batch_subscriber.stop()
+        elif subscriber is not None:
+            with self._lock:
+                self._opt_subscribers.pop((topic, fn), None)
+        else:
+            with self._lock:
+                self._subscribers.discard((topic, fn))
         _handle_rc(rc, 'jsdrv_unsubscribe', topic)
 
     def unsubscribe_all(self, fn, timeout=None):
@@ -820,12 +2041,27 @@ cdef class Driver:
         :raise: On error.
         """
         cdef int32_t timeout_ms = _timeout_validate(timeout)
+        cdef int32_t ring_rc
+        cdef void * fn_ptr
 
         with nogil:
             rc = c_jsdrv.jsdrv_unsubscribe_all(self._context, _on_cmd_publish_cbk, <void *> fn, timeout_ms)
-        remove_list = [(t, f) for t, f in self._subscribers if f == fn]
-        for item in remove_list:
-            self._subscribers.discard(item)
+        with self._lock:
+            remove_list = [(t, f) for t, f in self._subscribers if f == fn]
+            for item in remove_list:
+                self._subscribers.discard(item)
+            opt_list = [(item, s) for item, s in self._opt_subscribers.items() if item[1] == fn]
+            for item, _ in opt_list:
+                del self._opt_subscribers[item]
+            batch_list = [(t, f) for t, f in self._batch_subscribers.keys() if f == fn]
+        for item, subscriber in opt_list:
+            fn_ptr = <void *> subscriber
+            with nogil:
+                ring_rc = c_jsdrv.jsdrv_unsubscribe_all(self._context, _on_cmd_publish_opt_cbk, fn_ptr, timeout_ms)
+            if not rc:
+                rc = ring_rc
+        for t, f in batch_list:
+            self.unsubscribe(t, f, timeout)
         _handle_rc(rc, 'jsdrv_unsubscribe_all')
 
     def open(self, device_prefix, mode=None, timeout=None):
@@ -882,6 +2118,423 @@ cdef class Driver:
         _handle_rc(rc, 'jsdrv_close', device_prefix)
 
 
+    def buffer_read(self, buffer_id, signal_ids, t0, t1, incr=None, out=None, timeout=None):
+        """Read multiple signals from a memory buffer.
+
+        :param buffer_id: The memory buffer id, from 1 to 16.
+        :param signal_ids: The list of signal ids in the buffer.
+        :param t0: The starting sample id, inclusive.
+        :param t1: The ending sample id, exclusive.
+        :param incr: The sample id increment between returned entries.
+            None (default) or 1 reads samples.  Values greater than 1
+            read summary statistics, one (avg, std, min, max) entry
+            per incr samples.
+        :param out: The optional list of C-contiguous, writeable
+            np.ndarray, one for each signal, for the results.
+            Sample reads require float32 or uint8 arrays with at
+            least (t1 - t0) entries.  uint8 arrays only support
+            u1 and u4 signals, which are unpacked to one sample
+            per byte.  Summary reads require float32 arrays with
+            shape (N, 4) where N >= (t1 - t0) // incr.
+            None (default) allocates float32 arrays.
+        :param timeout: The timeout in float seconds for the entire read.
+            None waits 10 seconds.
+        :return: The list of (sample_id, data) for each signal, where
+            sample_id is the first sample id and data is the view into
+            the out array containing the available data.  When the
+            buffer no longer contains part of the requested range,
+            data is shorter than requested.
+        :raise TimeoutError: If the read does not complete in time.
+        :raise RuntimeError: On other errors.
+
+        This method submits all requests together using
+        response streaming, and then waits without the GIL for the
+        last response.  The driver thread copies each response
+        directly into the out arrays, which avoids constructing a
+        Python object for each response.
+        """
+        global _buffer_read_count
+        cdef int32_t timeout_ms = _timeout_validate(timeout, _BUFFER_READ_TIMEOUT_MS_DEFAULT)
+        cdef int32_t rc
+        cdef int32_t unsub_rc
+        cdef uint32_t idx
+        cdef uint32_t signal_count = <uint32_t> len(signal_ids)
+        cdef uint64_t length
+        cdef _buffer_read_s * r
+        cdef _buffer_read_signal_s * s
+        cdef c_jsdrv.jsdrv_buffer_request_s req
+        cdef c_jsdrv.jsdrv_union_s v
+        cdef c_jsdrv.jsdrvp_msg_s * msg = NULL
+        cdef const uint8_t[:] topic_str
+        cdef const uint8_t[:] rsp_topic_str
+        cdef np.ndarray arr
+
+        incr = 1 if incr is None else int(incr)
+        t0 = int(t0)
+        t1 = int(t1)
+        if incr < 1:
+            raise ValueError(f'invalid incr {incr}')
+        if t0 < 0 or t1 <= t0:
+            raise ValueError(f'invalid range {t0}, {t1}')
+        if signal_count == 0:
+            return []
+        length = (t1 - t0) // incr
+        if length == 0:
+            raise ValueError(f'range {t0}, {t1} less than incr {incr}')
+        summary = incr > 1
+        if out is None:
+            shape = (length, 4) if summary else (length, )
+            out = [np.empty(shape, dtype=np.float32) for _ in range(signal_count)]
+        elif len(out) != signal_count:
+            raise ValueError('out must have one array for each signal')
+
+        r = <_buffer_read_s *> calloc(1, sizeof(_buffer_read_s))
+        if r == NULL:
+            raise MemoryError()
+        r[0].signals = <_buffer_read_signal_s *> calloc(signal_count, sizeof(_buffer_read_signal_s))
+        if r[0].signals == NULL:
+            free(r)
+            raise MemoryError()
+        r[0].context = self._context
+        r[0].t0 = t0
+        r[0].incr = incr
+        r[0].signal_count = signal_count
+        r[0].pending = signal_count
+        try:
+            for idx in range(signal_count):
+                arr = out[idx]
+                if not arr.flags.c_contiguous or not arr.flags.writeable:
+                    raise ValueError(f'out[{idx}] must be C-contiguous and writeable')
+                if summary:
+                    if arr.dtype != np.float32 or arr.ndim != 2 or arr.shape[1] != 4:
+                        raise ValueError(f'out[{idx}] must be float32 with shape (N, 4)')
+                    r[0].signals[idx].dst_format = _BUFFER_READ_SUMMARY
+                elif arr.dtype == np.float32 and arr.ndim == 1:
+                    r[0].signals[idx].dst_format = _BUFFER_READ_F32
+                elif arr.dtype == np.uint8 and arr.ndim == 1:
+                    r[0].signals[idx].dst_format = _BUFFER_READ_U8
+                else:
+                    raise ValueError(f'out[{idx}] must be 1D float32 or uint8')
+                if <uint64_t> arr.shape[0] < length:
+                    raise ValueError(f'out[{idx}] too small: {arr.shape[0]} < {length}')
+                r[0].signals[idx].dst = <uint8_t *> np.PyArray_DATA(arr)
+                r[0].signals[idx].dst_length = length
+        except Exception:
+            free(r[0].signals)
+            free(r)
+            raise
+
+        r[0].done_q = c_jsdrv.msg_queue_init()
+        with _module_lock:
+            rsp_topic = f'_/buffer_read/{_buffer_read_count}'
+            _buffer_read_count += 1
+        rsp_topic_str = rsp_topic.encode('utf-8')
+        with nogil:
+            rc = c_jsdrv.jsdrv_subscribe(self._context, <char *> &rsp_topic_str[0], c_jsdrv.JSDRV_SFLAG_PUB,
+                                         _on_buffer_read_cbk, <void *> r, _TIMEOUT_MS_DEFAULT)
+        if rc:
+            c_jsdrv.msg_queue_finalize(r[0].done_q)
+            free(r[0].signals)
+            free(r)
+            _handle_rc(rc, 'buffer_read subscribe', rsp_topic)
+
+        # Use a unique response topic for each signal, since "m/BBB/g/latest"
+        # replaces pending requests with the same response topic.
+        memset(&req, 0, sizeof(req))
+        req.version = 1
+        req.time_type = c_jsdrv.JSDRV_TIME_SAMPLES
+        req.flags = c_jsdrv.JSDRV_BUFFER_REQUEST_FLAG_STREAM
+        req.time.samples.start = t0
+        if summary:
+            req.time.samples.end = t0 + length * incr - 1
+            req.time.samples.length = length
+        else:
+            req.time.samples.end = 0
+            req.time.samples.length = length
+        memset(&v, 0, sizeof(v))
+        v.type = c_jsdrv.JSDRV_UNION_BIN
+        v.app = c_jsdrv.JSDRV_PAYLOAD_TYPE_BUFFER_REQ
+        v.value.bin = <const uint8_t *> &req
+        v.size = <uint32_t> sizeof(req)
+        rc = 0
+        for idx in range(signal_count):
+            topic_str = f'{rsp_topic}/{idx:03d}'.encode('utf-8')
+            strcpy(req.rsp_topic, <const char *> &topic_str[0])
+            req.rsp_id = idx
+            topic_str = f'm/{int(buffer_id):03d}/s/{int(signal_ids[idx]):03d}/!req'.encode('utf-8')
+            with nogil:
+                rc = c_jsdrv.jsdrv_publish(self._context, <char *> &topic_str[0], &v, 0)
+            if rc:
+                break
+        if not rc:
+            with nogil:
+                rc = c_jsdrv.msg_queue_pop(r[0].done_q, &msg, timeout_ms)
+            if rc == 0:
+                c_jsdrv.jsdrvp_msg_free(self._context, msg)
+            else:
+                rc = ErrorCode.TIMED_OUT
+                self._buffer_read_cancel(r, buffer_id, signal_ids)
+
+        with nogil:
+            unsub_rc = c_jsdrv.jsdrv_unsubscribe(self._context, <char *> &rsp_topic_str[0],
+                                                 _on_buffer_read_cbk, <void *> r, _TIMEOUT_MS_DEFAULT)
+        result = []
+        for idx in range(signal_count):
+            s = &r[0].signals[idx]
+            if not rc:
+                rc = s[0].status
+            result.append((t0 + s[0].start * incr, out[idx][s[0].start:s[0].end]))
+        if unsub_rc:
+            _log_c.warning('buffer_read unsubscribe failed, leak %s', rsp_topic)
+        else:
+            msg = c_jsdrv.msg_queue_pop_immediate(r[0].done_q)
+            while msg != NULL:
+                c_jsdrv.jsdrvp_msg_free(self._context, msg)
+                msg = c_jsdrv.msg_queue_pop_immediate(r[0].done_q)
+            c_jsdrv.msg_queue_finalize(r[0].done_q)
+            free(r[0].signals)
+            free(r)
+        _handle_rc(rc, 'buffer_read', f'm/{int(buffer_id):03d}')
+        return result
+
+    def statistics_history(self, device, start=0, end=0, length=0, time_type=None, timeout=None):
+        """Get the retained statistics history for a device.
+
+        :param device: The device prefix, such as 'u/js220/000415'.
+        :param start: The first block_sample_id or i64 UTC time, inclusive.
+        :param end: The last block_sample_id or i64 UTC time, inclusive.
+            0 (default) selects the newest record.
+        :param length: The maximum number of most recent records to return.
+            0 (default) returns all matching records.
+        :param time_type: 'samples' (default) or 'utc'.
+        :param timeout: The timeout in float seconds.  None waits the default.
+        :return: The :data:`STATISTICS_DTYPE` array of records, oldest first.
+        :raise TimeoutError: If the response does not arrive in time.
+
+        The driver only retains statistics while "@/stats/history"
+        is nonzero.
+        """
+        global _statistics_history_count
+        cdef int32_t timeout_ms = _timeout_validate(timeout)
+        with _module_lock:
+            rsp_topic = f'a/hist/{_statistics_history_count}'
+            _statistics_history_count += 1
+        chunks = []
+        done = threading.Event()
+
+        def on_rsp(topic, value):
+            chunks.append(value['data'])
+            if value['flags'] & c_jsdrv.JSDRV_BUFFER_RESPONSE_FLAG_FINAL:
+                done.set()
+
+        req = {
+            'device': device,
+            'time_type': 'samples' if time_type is None else time_type,
+            'start': int(start),
+            'end': int(end),
+            'length': int(length),
+            'rsp_topic': rsp_topic,
+        }
+        self.subscribe(rsp_topic, 'pub', on_rsp, timeout)
+        try:
+            self.publish('@/stats/!hist', req, timeout)
+            if not done.wait(timeout_ms / 1000.0):
+                raise TimeoutError(f'statistics_history timed out | {device}')
+        finally:
+            self.unsubscribe(rsp_topic, on_rsp, timeout)
+        if not chunks:
+            return np.empty(0, dtype=STATISTICS_DTYPE)
+        return np.concatenate(chunks)
+
+    def measure(self, device, duration=None, sample_count=None, timeout=None):
+        """Measure one exact statistics window.
+
+        :param device: The device prefix, such as 'u/js220/000415'.
+        :param duration: The window duration in float seconds.
+        :param sample_count: The window duration in 1 Msps samples,
+            as an alternative to duration.
+        :param timeout: The time to wait beyond the window duration in
+            float seconds.  None waits the default.
+        :return: The statistics dict, like "s/stats/host/value".
+        :raise TimeoutError: If the statistics do not arrive in time.
+
+        The driver thread configures the host statistics, enables the
+        current, voltage and power streams, computes the exact charge
+        and energy over the window, and then restores the previous
+        settings.  The device must support "h/stats/ctrl".
+        """
+        cdef c_jsdrv.jsdrv_statistics_s stats
+        cdef const uint8_t[:] device_str = device.encode('utf-8')
+        cdef int32_t timeout_ms = _timeout_validate(timeout)
+        cdef uint32_t count
+        if (duration is None) == (sample_count is None):
+            raise ValueError('Specify exactly one of duration or sample_count')
+        if sample_count is None:
+            sample_count = int(round(duration * 1000000))
+        if not 1 <= sample_count <= 0xffffffff:
+            raise ValueError(f'Invalid measure duration: {sample_count} samples')
+        count = sample_count
+        with nogil:
+            rc = c_jsdrv.jsdrv_measure(self._context, <char *> &device_str[0], count, &stats, timeout_ms)
+        _handle_rc(rc, 'jsdrv_measure', device)
+        return _parse_statistics(&stats)
+
+    cdef _buffer_read_cancel(self, _buffer_read_s * r, buffer_id, signal_ids):
+        cdef c_jsdrv.jsdrv_union_s v
+        cdef const uint8_t[:] topic_str
+        cdef uint32_t idx
+        memset(&v, 0, sizeof(v))
+        v.type = c_jsdrv.JSDRV_UNION_I64
+        for idx in range(r[0].signal_count):
+            if r[0].signals[idx].done:
+                continue
+            v.value.i64 = idx
+            topic_str = f'm/{int(buffer_id):03d}/s/{int(signal_ids[idx]):03d}/!cancel'.encode('utf-8')
+            with nogil:
+                c_jsdrv.jsdrv_publish(self._context, <char *> &topic_str[0], &v, 0)
+
+
+cdef class StreamReader:
+    """Read aligned stream samples into preallocated arrays.
+
+    :param driver: The :class:`Driver` instance.
+    :param topics: The list of "!data" stream topics, one for each channel.
+    :param element_types: The list of :class:`ElementType` for each
+        channel, FLOAT or UINT.  None (default) selects FLOAT
+        for the "i", "v" and "p" signals and UINT for all others.
+    :param capacity: The ring capacity in samples for each channel.
+        None (default) holds 1 second at 1 MHz.
+
+    The driver thread copies each stream message directly into a
+    lock-free ring for each channel without the GIL.  :meth:`read`
+    then waits without the GIL and copies aligned samples for all
+    channels into the caller's arrays.  Float channels produce float32
+    samples, and integer channels produce one uint8 for each sample.
+    Use a single thread to call :meth:`read`.
+    """
+    cdef Driver _driver
+    cdef c_jsdrv.jsdrv_stream_reader_s * _reader
+    cdef readonly object topics
+    cdef readonly object dtypes
+    cdef object __weakref__
+
+    def __init__(self, Driver driver, topics, element_types=None, capacity=None):
+        cdef const char * c_topics[c_jsdrv.JSDRV_STREAM_READER_CHANNELS_MAX]
+        cdef uint8_t c_types[c_jsdrv.JSDRV_STREAM_READER_CHANNELS_MAX]
+        cdef uint32_t channel_count = <uint32_t> len(topics)
+        cdef uint32_t c_capacity = 1000000 if capacity is None else int(capacity)
+        cdef int32_t rc
+        cdef uint32_t idx
+        self._reader = NULL
+        if channel_count == 0 or channel_count > c_jsdrv.JSDRV_STREAM_READER_CHANNELS_MAX:
+            raise ValueError(f'invalid channel count {channel_count}')
+        if element_types is None:
+            element_types = []
+            for topic in topics:
+                signal = topic.split('/s/')[-1].split('/')[0]
+                element_types.append(ElementType.FLOAT if signal in ('i', 'v', 'p') else ElementType.UINT)
+        elif len(element_types) != channel_count:
+            raise ValueError('element_types must have one entry for each topic')
+        self.topics = [str(t) for t in topics]
+        topics_bytes = [t.encode('utf-8') for t in self.topics]
+        for idx in range(channel_count):
+            c_topics[idx] = topics_bytes[idx]
+            c_types[idx] = <uint8_t> int(element_types[idx])
+        self.dtypes = [np.float32 if t == ElementType.FLOAT else np.uint8 for t in element_types]
+        self._driver = driver
+        with nogil:
+            rc = c_jsdrv.jsdrv_stream_reader_open(driver._context, c_topics, c_types, channel_count,
+                                                  c_capacity, &self._reader)
+        _handle_rc(rc, 'jsdrv_stream_reader_open', self.topics[0])
+        with driver._lock:
+            driver._stream_readers.add(self)
+
+    def __dealloc__(self):
+        if self._reader != NULL:
+            c_jsdrv.jsdrv_stream_reader_close(self._reader)
+            self._reader = NULL
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, type, value, traceback):
+        self.close()
+
+    def close(self):
+        """Close the reader and unsubscribe from the topics."""
+        cdef c_jsdrv.jsdrv_stream_reader_s * reader = self._reader
+        if reader == NULL:
+            return
+        self._reader = NULL
+        with self._driver._lock:
+            self._driver._stream_readers.discard(self)
+        with nogil:
+            c_jsdrv.jsdrv_stream_reader_close(reader)
+
+    def empty(self, sample_count):
+        """Allocate the destination arrays for :meth:`read`.
+
+        :param sample_count: The number of samples for each channel.
+        :return: The list of arrays, one for each channel.
+        """
+        return [np.empty(int(sample_count), dtype=dtype) for dtype in self.dtypes]
+
+    def read(self, out, sample_count=None, timeout=None):
+        """Read aligned samples for all channels.
+
+        :param out: The list of C-contiguous, writeable destination arrays
+            from :meth:`empty`, one for each channel.
+        :param sample_count: The number of samples to read for each
+            channel, up to the ring capacity.  None (default) fills the
+            out arrays.
+        :param timeout: The maximum time to wait in seconds.  0 copies the
+            samples that are already available.  None (default) uses
+            the default timeout.
+        :return: The dict with sample_id, decimate_factor, sample_rate,
+            sample_count, gap_count and overrun_count.  sample_count is
+            less than requested on timeout.  gap_count is the number of
+            samples filled with NaN or 0, and overrun_count is the number
+            of samples dropped because a ring was full, both summed over
+            all channels since the previous read.
+        :raise RuntimeError: When the channels have different sample rates.
+        """
+        cdef void * ptrs[c_jsdrv.JSDRV_STREAM_READER_CHANNELS_MAX]
+        cdef c_jsdrv.jsdrv_stream_reader_info_s info
+        cdef int32_t timeout_ms = _timeout_validate(timeout)
+        cdef uint32_t n
+        cdef uint32_t idx
+        cdef int32_t rc
+        cdef np.ndarray arr
+        if self._reader == NULL:
+            raise RuntimeError('stream reader closed')
+        if len(out) != len(self.dtypes):
+            raise ValueError('out must have one array for each topic')
+        if sample_count is None:
+            sample_count = min([a.shape[0] for a in out])
+        n = <uint32_t> int(sample_count)
+        for idx in range(len(self.dtypes)):
+            arr = out[idx]
+            if not arr.flags.c_contiguous or not arr.flags.writeable:
+                raise ValueError(f'out[{idx}] must be C-contiguous and writeable')
+            if arr.ndim != 1 or arr.dtype != self.dtypes[idx]:
+                raise ValueError(f'out[{idx}] must be 1D {np.dtype(self.dtypes[idx]).name}')
+            if <uint32_t> arr.shape[0] < n:
+                raise ValueError(f'out[{idx}] too small: {arr.shape[0]} < {n}')
+            ptrs[idx] = np.PyArray_DATA(arr)
+        with nogil:
+            rc = c_jsdrv.jsdrv_stream_reader_read(self._reader, ptrs, n, <uint32_t> timeout_ms, &info)
+        if rc and rc != ErrorCode.TIMED_OUT:
+            _handle_rc(rc, 'jsdrv_stream_reader_read', self.topics[0])
+        return {
+            'sample_id': info.sample_id,
+            'decimate_factor': info.decimate_factor,
+            'sample_rate': info.sample_rate,
+            'sample_count': info.sample_count,
+            'gap_count': info.gap_count,
+            'overrun_count': info.overrun_count,
+        }
+
+
 cdef void _on_cmd_publish_cbk(void * user_data, const char * topic,
                               const c_jsdrv.jsdrv_union_s * value) noexcept with gil:
     cdef object fn = <object> user_data
@@ -898,6 +2551,62 @@ cdef void _on_cmd_publish_cbk(void * user_data, const char * topic,
         _log_c.exception(f'_on_cmd_publish_cbk({topic_str})')
 
 
+cdef void _on_async_cbk(void * user_data, const char * topic, int32_t return_code,
+                        c_jsdrv.jsdrv_union_s * value) noexcept with gil:
+    cdef _AsyncOp op = <_AsyncOp> user_data
+    Py_DECREF(op)  # the local reference keeps op alive until return
+    try:
+        topic_str = topic.decode('utf-8')
+        if value == NULL:
+            op.fn(topic_str, return_code)
+        else:
+            v = _jsdrv_union_to_py(value) if return_code == 0 else None
+            op.fn(topic_str, return_code, v)
+    except:
+        _log_c.exception('_on_async_cbk')
+
+
+cdef void _on_cmd_publish_opt_cbk(void * user_data, const char * topic,
+                                  const c_jsdrv.jsdrv_union_s * value) noexcept with gil:
+    cdef _Subscriber subscriber = <_Subscriber> user_data
+    cdef const c_jsdrv.jsdrv_stream_signal_s * stream
+    try:
+        topic_str = topic.decode('utf-8')
+    except:
+        _log_c.exception('_on_cmd_publish_opt_cbk could not convert topic to utf-8')
+        return
+    try:
+        if (subscriber.statistics is not None and value[0].type == c_jsdrv.JSDRV_UNION_BIN
+                and value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_STATISTICS):
+            v = subscriber.statistics._recv(<const c_jsdrv.jsdrv_statistics_s *> &(value[0].value.bin[0]))
+            if v is not None:
+                subscriber.fn(topic_str, v)
+        elif (subscriber.arrow is not None and value[0].type == c_jsdrv.JSDRV_UNION_BIN
+                and (value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_STREAM
+                     or value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_BUFFER_RSP)):
+            subscriber.arrow._recv(value)
+            batch = subscriber.arrow.pop()
+            while batch is not None:
+                subscriber.fn(topic_str, batch)
+                batch = subscriber.arrow.pop()
+        elif (subscriber.ring is not None and value[0].type == c_jsdrv.JSDRV_UNION_BIN
+                and value[0].app == c_jsdrv.JSDRV_PAYLOAD_TYPE_STREAM):
+            stream = <const c_jsdrv.jsdrv_stream_signal_s *> &(value[0].value.bin[0])
+            if subscriber.ring._recv(stream, subscriber.packed) == 0:
+                subscriber.fn(topic_str, subscriber.ring)
+        else:
+            subscriber.fn(topic_str, _jsdrv_union_to_py(value, subscriber.packed))
+    except:
+        _log_c.exception(f'_on_cmd_publish_opt_cbk({topic_str})')
+
+
+cdef void _on_cmd_publish_batch_cbk(void * user_data, const char * topic,
+                                    const c_jsdrv.jsdrv_union_s * value) noexcept nogil:
+    cdef _batch_queue_s * q = <_batch_queue_s *> user_data
+    cdef c_jsdrv.jsdrvp_msg_s * msg = c_jsdrv.jsdrvp_msg_alloc_value(q[0].context, topic, value)
+    c_jsdrv.msg_queue_push(q[0].queue, msg)
+
+
 cdef void _on_log_recv(void * user_data, const c_jsdrv.jsdrv_log_header_s * header,
                        const char * filename, const char * message) noexcept with gil:
     lvl = _log_level_c_to_py[header[0].level]
@@ -923,3 +2632,48 @@ def calibration_hash(msg):
     hash_u32 = hash
     c_jsdrv.jsdrv_calibration_hash(&msg_u32[0], len(msg), &hash_u32[0])
     return hash
+
+
+def time_from_counter(time_map, sample_id, count, incr=None, out=None, timestamp=None):
+    """Compute the timestamp for each sample in a sample_id range.
+
+    :param time_map: The time map dict with offset_time, offset_counter
+        and counter_rate, such as from a stream value or
+        :attr:`StreamRing.time_map`.
+    :param sample_id: The first sample_id.
+    :param count: The number of samples.
+    :param incr: The sample_id increment between samples, such as the
+        stream value decimate_factor.  None (default) is 1.
+    :param out: The optional contiguous output array with count elements.
+        None (default) allocates a new array.
+    :param timestamp: False (default) to return np.int64 time64 values,
+        identical to the scalar per-sample conversion.
+        True to return np.float64 python (POSIX) timestamps in seconds.
+    :return: The output array.
+    """
+    cdef c_jsdrv.jsdrv_time_map_s t
+    cdef int64_t[::1] out_i64
+    cdef double[::1] out_f64
+    cdef uint64_t c_sample_id = sample_id
+    cdef uint32_t c_incr = 1 if incr is None else incr
+    cdef size_t c_count = count
+    t.offset_time = time_map['offset_time']
+    t.offset_counter = time_map['offset_counter']
+    t.counter_rate = time_map['counter_rate']
+    dtype = np.float64 if timestamp else np.int64
+    if out is None:
+        out = np.empty(c_count, dtype=dtype)
+    elif out.dtype != dtype or len(out) != c_count:
+        raise ValueError(f'out must be {np.dtype(dtype).name} with {c_count} elements')
+    if c_count == 0:
+        return out
+    if timestamp:
+        out_f64 = out
+        with nogil:
+            c_jsdrv.jsdrv_time_from_counter_range_f64(&t, c_sample_id, c_incr, &out_f64[0], c_count)
+        out += time64.EPOCH
+    else:
+        out_i64 = out
+        with nogil:
+            c_jsdrv.jsdrv_time_from_counter_range(&t, c_sample_id, c_incr, &out_i64[0], c_count)
+    return out
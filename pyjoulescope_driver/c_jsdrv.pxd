@@ -20,9 +20,19 @@ DEF JSDRV_TOPIC_LENGTH_MAX = 64
 DEF JSDRV_PAYLOAD_LENGTH_MAX    = (1024U)
 DEF JSDRV_STREAM_DATA_SIZE      = (1024 * 64)
 DEF JSDRV_STREAM_PAYLOAD_LENGTH_MAX = (JSDRV_STREAM_DATA_SIZE - 16)
+DEF JSDRV_ALIGN_SOURCES_MAX     = 8
+DEF JSDRV_STREAM_FRAME_CHANNELS_MAX = 12
+DEF JSDRV_STATISTICS_ALL_DEVICES_MAX = 32
+DEF JSDRV_STATISTICS_HISTORY_RESPONSE_COUNT = 256
+DEF JSDRV_BUFFER_MULTI_SIGNALS_MAX = 8
+DEF JSDRV_HOST_HIST_BIN_COUNT = 162
+DEF JSDRV_CONTINUITY_GAP_COUNT = 16
 
 
 cdef extern from "jsdrv/error_code.h":
+    enum jsdrv_error_code_e:
+        JSDRV_ERROR_NOT_SUPPORTED = 3
+        JSDRV_ERROR_PARAMETER_INVALID = 5
     const char * jsdrv_error_code_name(int ec)
     const char * jsdrv_error_code_description(int ec)
 
@@ -33,9 +43,18 @@ cdef extern from "jsdrv/time.h":
         uint64_t offset_counter
         double counter_rate
     int64_t jsdrv_time_from_counter(jsdrv_time_map_s * self, uint64_t counter)
+    void jsdrv_time_from_counter_range(const jsdrv_time_map_s * self, uint64_t counter, uint32_t incr,
+                                       int64_t * time64, size_t count) nogil
+    void jsdrv_time_from_counter_range_f64(const jsdrv_time_map_s * self, uint64_t counter, uint32_t incr,
+                                           double * t, size_t count) nogil
     uint64_t jsdrv_time_to_counter(jsdrv_time_map_s * self, int64_t time64)
 
 
+cdef extern from "jsdrv_prv/pack.h":
+    void jsdrv_unpack_u4(uint8_t * y, const uint8_t * x, uint32_t n) nogil
+    void jsdrv_unpack_u1(uint8_t * y, const uint8_t * x, uint32_t n) nogil
+
+
 cdef extern from "jsdrv/union.h":
     enum jsdrv_union_e:
         JSDRV_UNION_NULL = 0  # NULL value.  Also used to clear existing value.
@@ -87,6 +106,7 @@ cdef extern from "jsdrv.h":
 
     struct jsdrv_context_s
     ctypedef void (*jsdrv_subscribe_fn)(void * user_data, const char * topic, const jsdrv_union_s * value) nogil
+    ctypedef void (*jsdrv_async_fn)(void * user_data, const char * topic, int32_t return_code, jsdrv_union_s * value) nogil
     enum jsdrv_payload_type_e:
         JSDRV_PAYLOAD_TYPE_UNION  = 0
         JSDRV_PAYLOAD_TYPE_STREAM = 1
@@ -94,6 +114,18 @@ cdef extern from "jsdrv.h":
         JSDRV_PAYLOAD_TYPE_BUFFER_INFO = 3
         JSDRV_PAYLOAD_TYPE_BUFFER_REQ = 4
         JSDRV_PAYLOAD_TYPE_BUFFER_RSP = 5
+        JSDRV_PAYLOAD_TYPE_ALIGN_MAP = 6
+        JSDRV_PAYLOAD_TYPE_ALIGN_FRAME = 7
+        JSDRV_PAYLOAD_TYPE_TRIGGER = 8
+        JSDRV_PAYLOAD_TYPE_STREAM_EVENT = 9
+        JSDRV_PAYLOAD_TYPE_STATISTICS_ALL = 10
+        JSDRV_PAYLOAD_TYPE_BUFFER_MULTI_REQ = 11
+        JSDRV_PAYLOAD_TYPE_BUFFER_MULTI_RSP = 12
+        JSDRV_PAYLOAD_TYPE_HOST_DERIVED = 13
+        JSDRV_PAYLOAD_TYPE_CONTINUITY = 14
+        JSDRV_PAYLOAD_TYPE_STREAM_FRAME = 15
+        JSDRV_PAYLOAD_TYPE_STATISTICS_HISTORY_REQ = 16
+        JSDRV_PAYLOAD_TYPE_STATISTICS_HISTORY_RSP = 17
     enum jsdrv_element_type_e:
         JSDRV_DATA_TYPE_UNDEFINED = 0
         JSDRV_DATA_TYPE_INT = 2
@@ -119,6 +151,27 @@ cdef extern from "jsdrv.h":
         uint32_t decimate_factor
         jsdrv_time_map_s time_map
         uint8_t data[JSDRV_STREAM_PAYLOAD_LENGTH_MAX]
+    struct jsdrv_stream_event_s:
+        uint32_t offset
+        uint32_t value
+    struct jsdrv_stream_frame_channel_s:
+        uint8_t field_id
+        uint8_t index
+        uint8_t element_type
+        uint8_t element_size_bits
+        uint32_t offset
+    struct jsdrv_stream_frame_s:
+        uint64_t sample_id
+        uint8_t version
+        uint8_t channel_count
+        uint8_t rsv1_u8
+        uint8_t rsv2_u8
+        uint32_t element_count
+        uint32_t sample_rate
+        uint32_t decimate_factor
+        jsdrv_time_map_s time_map
+        jsdrv_stream_frame_channel_s channels[JSDRV_STREAM_FRAME_CHANNELS_MAX]
+        uint8_t data[1]
     struct jsdrv_statistics_s:
         uint8_t version
         uint8_t rsv1_u8
@@ -146,6 +199,82 @@ cdef extern from "jsdrv.h":
         uint64_t charge_i128[2]
         uint64_t energy_i128[2]
         jsdrv_time_map_s time_map
+    struct jsdrv_host_derived_s:
+        uint8_t version
+        uint8_t bins_per_octave
+        int8_t octave_min
+        int8_t octave_max
+        uint32_t bin_count
+        uint64_t block_sample_id
+        uint64_t hist_sample_id
+        double i_rms
+        double i_crest
+        double v_rms
+        double v_crest
+        double p_rms
+        double p_crest
+        uint64_t i_hist[JSDRV_HOST_HIST_BIN_COUNT]
+        uint64_t v_hist[JSDRV_HOST_HIST_BIN_COUNT]
+        uint64_t p_hist[JSDRV_HOST_HIST_BIN_COUNT]
+    struct jsdrv_continuity_gap_s:
+        uint64_t sample_id
+        uint64_t length
+    struct jsdrv_continuity_s:
+        uint8_t version
+        uint8_t gap_count
+        uint8_t rsv1_u8
+        uint8_t rsv2_u8
+        uint32_t rsv3_u32
+        uint64_t sample_id
+        uint64_t skip_count
+        uint64_t skip_length
+        uint64_t dup_count
+        uint64_t dup_length
+        uint64_t resync_count
+        uint64_t drop_count
+        jsdrv_continuity_gap_s gaps[JSDRV_CONTINUITY_GAP_COUNT]
+    struct jsdrv_statistics_all_entry_s:
+        char device[JSDRV_TOPIC_LENGTH_MAX]
+        int64_t utc
+        jsdrv_statistics_s statistics
+    struct jsdrv_statistics_all_s:
+        uint8_t version
+        uint8_t count
+        uint8_t rsv1_u8
+        uint8_t rsv2_u8
+        uint32_t rsv3_u32
+        int64_t utc
+        jsdrv_statistics_all_entry_s entries[JSDRV_STATISTICS_ALL_DEVICES_MAX]
+    struct jsdrv_trigger_event_s:
+        uint8_t version
+        uint8_t trigger
+        uint8_t source
+        uint8_t edge
+        float value
+        uint64_t sample_id
+        int64_t utc
+        uint32_t sample_rate
+        uint32_t decimate_factor
+    struct jsdrv_align_map_s:
+        uint8_t version
+        uint8_t source_count
+        uint8_t rsv1_u8
+        uint8_t rsv2_u8
+        uint32_t rsv3_u32
+        uint32_t sample_rate[JSDRV_ALIGN_SOURCES_MAX]
+        uint32_t decimate_factor[JSDRV_ALIGN_SOURCES_MAX]
+        jsdrv_time_map_s time_map[JSDRV_ALIGN_SOURCES_MAX]
+    struct jsdrv_align_frame_s:
+        uint64_t sample_id
+        uint8_t version
+        uint8_t source_count
+        uint8_t rsv1_u8
+        uint8_t rsv2_u8
+        uint32_t element_count
+        uint32_t sample_rate
+        uint32_t decimate_factor
+        jsdrv_time_map_s time_map
+        float data[JSDRV_STREAM_DATA_SIZE // 4]
     enum jsdrv_time_type_e:
         JSDRV_TIME_UTC = 0
         JSDRV_TIME_SAMPLES = 1
@@ -178,15 +307,47 @@ cdef extern from "jsdrv.h":
     struct jsdrv_buffer_request_s:
         uint8_t version
         int8_t time_type
-        uint8_t rsv1_u8
-        uint8_t rsv2_u8
-        uint32_t rsv3_u32
+        uint8_t flags
+        uint8_t op
+        float threshold
         jsdrv_buffer_request_time_range_u time
         char rsp_topic[JSDRV_TOPIC_LENGTH_MAX]
         int64_t rsp_id
+    enum jsdrv_buffer_request_flags_e:
+        JSDRV_BUFFER_REQUEST_FLAG_STREAM = 1
+        JSDRV_BUFFER_REQUEST_FLAG_SNAPSHOT = 2
+        JSDRV_BUFFER_REQUEST_FLAG_INTEGRAL = 4
+        JSDRV_BUFFER_REQUEST_FLAG_ENVELOPE = 8
+        JSDRV_BUFFER_REQUEST_FLAG_STRIDE = 16
+        JSDRV_BUFFER_REQUEST_FLAG_GAPS = 32
+        JSDRV_BUFFER_REQUEST_FLAG_STANDING = 64
+        JSDRV_BUFFER_REQUEST_FLAG_DISPLAY = 128
+    enum jsdrv_buffer_request_op_e:
+        JSDRV_BUFFER_REQUEST_OP_DEFAULT = 0
+        JSDRV_BUFFER_REQUEST_OP_SEARCH = 1
+        JSDRV_BUFFER_REQUEST_OP_QUANTILE = 2
+        JSDRV_BUFFER_REQUEST_OP_MASK = 0x0f
+    enum jsdrv_buffer_search_e:
+        JSDRV_BUFFER_SEARCH_RISING = 16
+        JSDRV_BUFFER_SEARCH_FALLING = 32
+        JSDRV_BUFFER_SEARCH_LAST = 64
+        JSDRV_BUFFER_SEARCH_ALL = 128
     enum jsdrv_buffer_response_type_e:
         JSDRV_BUFFER_RESPONSE_SAMPLES = 1
         JSDRV_BUFFER_RESPONSE_SUMMARY = 2
+        JSDRV_BUFFER_RESPONSE_INTEGRAL = 3
+        JSDRV_BUFFER_RESPONSE_STRIDED = 4
+        JSDRV_BUFFER_RESPONSE_GAPS = 5
+        JSDRV_BUFFER_RESPONSE_CROSSINGS = 6
+        JSDRV_BUFFER_RESPONSE_QUANTILES = 7
+    enum jsdrv_buffer_response_flags_e:
+        JSDRV_BUFFER_RESPONSE_FLAG_FINAL = 1
+        JSDRV_BUFFER_RESPONSE_FLAG_GAP = 2
+        JSDRV_BUFFER_RESPONSE_FLAG_TREND = 4
+    struct jsdrv_buffer_integral_s:
+        uint64_t sum_i128[2]
+        uint64_t sample_count
+        double integral
     struct jsdrv_summary_entry_s:
         float avg
         float std
@@ -195,12 +356,52 @@ cdef extern from "jsdrv.h":
     struct jsdrv_buffer_response_s:
         uint8_t version
         uint8_t response_type
+        uint8_t flags
+        uint8_t rsv2_u8
+        uint32_t seq
+        int64_t rsp_id
+        jsdrv_buffer_info_s info
+        uint64_t data[0]
+    struct jsdrv_buffer_multi_request_s:
+        uint8_t version
+        uint8_t signal_count
+        uint8_t rsv1_u8
+        uint8_t rsv2_u8
+        uint32_t rsv3_u32
+        uint8_t signal_ids[JSDRV_BUFFER_MULTI_SIGNALS_MAX]
+        jsdrv_buffer_request_s req
+    struct jsdrv_buffer_multi_response_s:
+        uint8_t version
+        uint8_t signal_count
         uint8_t rsv1_u8
         uint8_t rsv2_u8
         uint32_t rsv3_u32
         int64_t rsp_id
-        jsdrv_buffer_info_s info
+        uint8_t signal_ids[JSDRV_BUFFER_MULTI_SIGNALS_MAX]
+        int32_t status[JSDRV_BUFFER_MULTI_SIGNALS_MAX]
+        uint32_t offset[JSDRV_BUFFER_MULTI_SIGNALS_MAX]
         uint64_t data[0]
+    struct jsdrv_statistics_history_request_s:
+        uint8_t version
+        int8_t time_type
+        uint8_t rsv1_u8
+        uint8_t rsv2_u8
+        uint32_t rsv3_u32
+        jsdrv_buffer_request_time_range_u time
+        char device[JSDRV_TOPIC_LENGTH_MAX]
+        char rsp_topic[JSDRV_TOPIC_LENGTH_MAX]
+        int64_t rsp_id
+    struct jsdrv_statistics_history_response_s:
+        uint8_t version
+        uint8_t flags
+        uint8_t rsv1_u8
+        uint8_t rsv2_u8
+        uint32_t seq
+        int64_t rsp_id
+        uint64_t total
+        uint32_t count
+        uint32_t rsv3_u32
+        jsdrv_statistics_s data[JSDRV_STATISTICS_HISTORY_RESPONSE_COUNT]
     enum jsdrv_subscribe_flag_e:
         JSDRV_SFLAG_NONE = 0                    # No flags (always 0).
         JSDRV_SFLAG_RETAIN = (1 << 0)           # Immediately forward retained PUB and/or METADATA, depending upon JSDRV_PUBSUB_SFLAG_PUB and JSDRV_PUBSUB_SFLAG_METADATA_RSP.
@@ -221,12 +422,57 @@ cdef extern from "jsdrv.h":
     void jsdrv_finalize(jsdrv_context_s * context, uint32_t timeout_ms) nogil
     int32_t jsdrv_publish(jsdrv_context_s * context, const char * topic, const jsdrv_union_s * value, uint32_t timeout_ms) nogil
     int32_t jsdrv_query(jsdrv_context_s * context, const char * topic, jsdrv_union_s * value, uint32_t timeout_ms) nogil
+    int32_t jsdrv_query_snapshot(jsdrv_context_s * context, const char * topic, uint8_t flags, jsdrv_union_s * value, uint32_t timeout_ms) nogil
+    int32_t jsdrv_publish_async(jsdrv_context_s * context, const char * topic, const jsdrv_union_s * value, jsdrv_async_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) nogil
+    int32_t jsdrv_query_async(jsdrv_context_s * context, const char * topic, jsdrv_union_s * value, jsdrv_async_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) nogil
     int32_t jsdrv_subscribe(jsdrv_context_s * context, const char * topic, uint8_t flags, jsdrv_subscribe_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) nogil
     int32_t jsdrv_unsubscribe(jsdrv_context_s * context, const char * topic, jsdrv_subscribe_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) nogil
     int32_t jsdrv_unsubscribe_all(jsdrv_context_s * context, jsdrv_subscribe_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) nogil
+    int32_t jsdrv_measure(jsdrv_context_s * context, const char * device, uint32_t sample_count, jsdrv_statistics_s * statistics, uint32_t timeout_ms) nogil
     void jsdrv_calibration_hash(const uint32_t * msg, uint32_t length, uint32_t * hash) nogil
 
 
+cdef extern from "jsdrv/arrow.h":
+    struct ArrowSchema:
+        const char * format
+        const char * name
+        int64_t n_children
+        void (*release)(ArrowSchema *) noexcept nogil
+    struct ArrowArray:
+        int64_t length
+        int64_t n_children
+        void (*release)(ArrowArray *) noexcept nogil
+    struct jsdrv_arrow_batcher_s
+    jsdrv_arrow_batcher_s * jsdrv_arrow_batcher_alloc(uint32_t row_count) nogil
+    void jsdrv_arrow_batcher_free(jsdrv_arrow_batcher_s * self) nogil
+    int32_t jsdrv_arrow_batcher_add_stream(jsdrv_arrow_batcher_s * self, const jsdrv_stream_signal_s * stream) nogil
+    int32_t jsdrv_arrow_batcher_add_buffer_rsp(jsdrv_arrow_batcher_s * self, const jsdrv_buffer_response_s * rsp) nogil
+    uint32_t jsdrv_arrow_batcher_ready(jsdrv_arrow_batcher_s * self) nogil
+    int32_t jsdrv_arrow_batcher_pop(jsdrv_arrow_batcher_s * self, ArrowSchema * schema, ArrowArray * array,
+                                    bint partial) nogil
+
+
+
+cdef extern from "jsdrv/stream_reader.h":
+    enum:
+        JSDRV_STREAM_READER_CHANNELS_MAX
+        JSDRV_STREAM_READER_CAPACITY_MAX
+    struct jsdrv_stream_reader_s
+    struct jsdrv_stream_reader_info_s:
+        uint64_t sample_id
+        uint32_t decimate_factor
+        uint32_t sample_rate
+        uint32_t sample_count
+        uint64_t gap_count
+        uint64_t overrun_count
+    int32_t jsdrv_stream_reader_open(jsdrv_context_s * context, const char * const * topics,
+                                     const uint8_t * element_types, uint32_t channel_count, uint32_t capacity,
+                                     jsdrv_stream_reader_s ** reader) nogil
+    void jsdrv_stream_reader_close(jsdrv_stream_reader_s * reader) nogil
+    int32_t jsdrv_stream_reader_read(jsdrv_stream_reader_s * reader, void * const * out, uint32_t sample_count,
+                                     uint32_t timeout_ms, jsdrv_stream_reader_info_s * info) nogil
+
+
 cdef extern from "jsdrv/log.h":
     struct jsdrv_log_header_s:
         uint8_t version
@@ -245,3 +491,20 @@ cdef extern from "jsdrv/log.h":
     int8_t jsdrv_log_level_get() nogil
     void jsdrv_log_initialize() nogil
     void jsdrv_log_finalize() nogil
+
+
+cdef extern from "jsdrv_prv/frontend.h":
+    struct jsdrvp_msg_s:
+        char topic[JSDRV_TOPIC_LENGTH_MAX]
+        jsdrv_union_s value
+    jsdrvp_msg_s * jsdrvp_msg_alloc_value(jsdrv_context_s * context, const char * topic, const jsdrv_union_s * value) nogil
+    void jsdrvp_msg_free(jsdrv_context_s * context, jsdrvp_msg_s * msg) nogil
+
+
+cdef extern from "jsdrv_prv/msg_queue.h":
+    struct msg_queue_s
+    msg_queue_s * msg_queue_init() nogil
+    void msg_queue_finalize(msg_queue_s * queue) nogil
+    void msg_queue_push(msg_queue_s * queue, jsdrvp_msg_s * msg) nogil
+    jsdrvp_msg_s * msg_queue_pop_immediate(msg_queue_s * queue) nogil
+    int32_t msg_queue_pop(msg_queue_s * queue, jsdrvp_msg_s ** msg, uint32_t timeout_ms) nogil
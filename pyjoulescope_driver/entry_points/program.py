@@ -13,7 +13,7 @@
 # limitations under the License.
 
 from pyjoulescope_driver import Driver
-from pyjoulescope_driver.program import release_program
+from pyjoulescope_driver.program import release_program, release_program_fleet
 from pyjoulescope_driver.release import release_get
 import sys
 
@@ -25,6 +25,9 @@ def parser_config(p):
                    help='Maturity target to program which is one of alpha, beta, stable.')
     p.add_argument('--device-path',
                    help='The target device for this command.')
+    p.add_argument('--all',
+                   action='store_true',
+                   help='Program all connected JS220 devices concurrently.')
     p.add_argument('--force-download',
                    action='store_true',
                    help='Force release download.')
@@ -65,9 +68,40 @@ def _on_progress(fract, message):
     sys.stdout.flush()
 
 
+def _on_fleet_progress(device_path, fract, message):
+    if fract >= 1.0 or 'wrote' in message:
+        print(f'{device_path}: {int(round(100.0 * fract)):3d}% {message}')
+
+
+def _on_cmd_all(d, args):
+    device_paths = [p for p in d.device_paths() if '/js220/' in p]
+    if not len(device_paths):
+        print('No device found')
+        return 1
+    image = release_get(args.maturity, force_download=args.force_download)
+    results = release_program_fleet(d, device_paths, image,
+                                    force_program=args.force_program,
+                                    progress=_on_fleet_progress)
+    rc = 0
+    print('\nProgramming completed:')
+    for device_path, rv in results.items():
+        if isinstance(rv, Exception):
+            print(f'  {device_path}: FAILED {rv}')
+            rc = 1
+            continue
+        versions_before = dict(rv[0])
+        print(f'  {device_path}:')
+        for key, value in rv[1]:
+            v = versions_before.get(key, '?.?.?')
+            print(f'    {key:10s}  {v} => {value}')
+    return rc
+
+
 def on_cmd(args):
     with Driver() as d:
         d.log_level = args.jsdrv_log_level
+        if args.all:
+            return _on_cmd_all(d, args)
         device_paths = d.device_paths()
         if args.device_path is not None:
             if args.device_path not in device_paths:
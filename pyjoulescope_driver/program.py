@@ -28,6 +28,7 @@ from pyjoulescope_driver.release import release_to_segments, \
     SUBTYPE_CTRL_APP, SUBTYPE_CTRL_UPDATER2, \
     SUBTYPE_CTRL_UPDATER1, SUBTYPE_SENSOR_FPGA, \
     TARGETS
+from concurrent.futures import ThreadPoolExecutor
 import logging
 import time
 
@@ -136,7 +137,13 @@ class Programmer:
             progress(p1, progress_msg + ' erase' + attempt_msg)
             self.publish(target['mem_region'] + '/!erase', 0, timeout=10)
             progress(p2, progress_msg + ' write' + attempt_msg)
+            t_start = time.time()
             self.publish(target['mem_region'] + '/!write', segment['img'], timeout=10)
+            duration = max(time.time() - t_start, 1e-3)
+            rate = len(segment['img']) / duration
+            _log.info('%s wrote %d bytes in %.1f s at %.1f kB/s',
+                      self._path, len(segment['img']), duration, rate / 1000)
+            progress(p2, progress_msg + f' wrote {rate / 1000:.0f} kB/s' + attempt_msg)
             reset_to = SUBTYPE_RESET[subtype]
             if reset_to is None:
                 return None
@@ -252,3 +259,75 @@ def release_program(driver: Driver, device_path: str, image: bytes,
     _log.info('Updated to versions: %s', v)
     progress(1.0, 'Complete')
     return versions_before, versions_after
+
+
+def _release_matches(driver: Driver, device_path: str, segments):
+    """Check the running app and sensor FPGA versions without a reset."""
+    programmer = Programmer(driver, device_path)
+    if not programmer.is_in_app:
+        return None
+    versions = {
+        SUBTYPE_CTRL_APP: programmer.version,
+        SUBTYPE_SENSOR_FPGA: programmer.fpga_version,
+    }
+    for subtype, version in versions.items():
+        segment = segments.get(subtype)
+        if segment is not None and segment['version'] != version:
+            return None
+    return [
+        ['app', version_to_str(versions[SUBTYPE_CTRL_APP])],
+        ['fpga', version_to_str(versions[SUBTYPE_SENSOR_FPGA])],
+    ]
+
+
+def release_program_fleet(driver: Driver, device_paths, image: bytes,
+                          force_program=None, progress=None, max_workers=None):
+    """Program multiple devices with an official release concurrently.
+
+    :param driver: The driver instance.
+    :param device_paths: The list of device path strings for the target
+        devices, which must be closed.
+    :param image: The binary release image to program.  See
+        :func:`pyjoulescope_driver.release.release_get`.
+    :param force_program: Force device programming for all segments.
+        Normally, devices already running the release app and sensor FPGA
+        versions are skipped without resetting, and programming for
+        segments with matching versions are skipped.
+    :param progress: An optional callable(device_path: str, completion: float, msg: str)
+        callback, which may be called from any thread.
+        See :func:`release_program`.
+    :param max_workers: The maximum number of devices to program
+        at the same time.  None (default) programs all devices together.
+    :return: The map of device_path to either the
+        (versions_before, versions_after) tuple or the raised exception.
+    """
+    if progress is None:
+        progress = lambda path, x, y: None
+    device_paths = list(device_paths)
+    if not len(device_paths):
+        return {}
+    segments = release_to_segments(image)
+
+    def program_one(device_path):
+        driver.open(device_path)
+        versions = None if force_program else _release_matches(driver, device_path, segments)
+        if versions is not None:
+            driver.close(device_path)
+            _log.info('%s already up to date', device_path)
+            progress(device_path, 1.0, 'Up to date')
+            return versions, versions
+        return release_program(driver, device_path, image, force_program=force_program,
+                               progress=lambda x, y: progress(device_path, x, y))
+
+    if max_workers is None:
+        max_workers = len(device_paths)
+    results = {}
+    with ThreadPoolExecutor(max_workers=max_workers) as executor:
+        futures = {p: executor.submit(program_one, p) for p in device_paths}
+        for device_path, future in futures.items():
+            try:
+                results[device_path] = future.result()
+            except Exception as ex:
+                _log.warning('%s programming failed: %s', device_path, ex)
+                results[device_path] = ex
+    return results
@@ -0,0 +1,267 @@
+# Copyright 2026 Jetperch LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Measure the Python binding overhead.
+
+The conversion benchmarks call the binding internals directly with
+synthetic messages.  The driver benchmarks use an emulated JS220, so
+they need no hardware.  The results are JSON, for example:
+
+    python -m pyjoulescope_driver.test.benchmark --duration 2 --out bench.json
+"""
+
+from pyjoulescope_driver import Driver, __version__
+from pyjoulescope_driver import binding
+import argparse
+import json
+import platform
+import sys
+import threading
+import time
+
+
+CONVERSIONS = [
+    # name, length
+    ('f32', 8192),
+    ('i16', 8192),
+    ('u4', 16384),
+    ('u4_packed', 16384),
+    ('u1', 65536),
+    ('statistics', 1),
+    ('buffer_rsp', 1000),
+    ('buffer_req', 1000),
+]
+
+STREAMS = [
+    # name, topic
+    ('f32', 's/i/!data'),
+    ('u4', 's/i/range/!data'),
+    ('u1', 's/gpi/0/!data'),
+]
+
+BUFFER_SIGNAL_ID = 1
+BUFFER_RSP_TOPIC = 'a/bench/!rsp'
+
+
+def get_parser():
+    p = argparse.ArgumentParser(description='Python binding benchmarks.')
+    p.add_argument('--duration', '-d', type=float, default=1.0,
+                   help='The duration in seconds for each driver benchmark.')
+    p.add_argument('--count', type=int, default=1000,
+                   help='The number of iterations for each conversion benchmark.')
+    p.add_argument('--conversions-only', action='store_true',
+                   help='Skip the driver benchmarks.')
+    p.add_argument('--out', '-o',
+                   help='The JSON output path.  Default is stdout.')
+    return p
+
+
+def _rate(count, elapsed):
+    return count / elapsed if elapsed > 0 else 0.0
+
+
+def bench_conversions(count):
+    results = {}
+    for name, length in CONVERSIONS:
+        binding._benchmark_convert(name, length, 10)  # warm up
+        t0 = time.perf_counter()
+        binding._benchmark_convert(name, length, count)
+        elapsed = time.perf_counter() - t0
+        results[name] = {
+            'length': length,
+            'count': count,
+            'ns_per_msg': 1e9 * elapsed / count,
+            'samples_per_s': _rate(count * length, elapsed),
+        }
+    return results
+
+
+def bench_pubsub(d, duration):
+    """Measure the per-message subscriber callback overhead."""
+    topic = 'a/bench/!msg'
+    state = {'count': 0}
+    done = threading.Event()
+
+    def on_msg(t, value):
+        state['count'] += 1
+        if value == 0:
+            done.set()
+
+    d.subscribe(topic, 'pub', on_msg)
+    try:
+        sent = 0
+        t0 = time.perf_counter()
+        t_end = t0 + duration
+        while time.perf_counter() < t_end:
+            for _ in range(100):
+                sent += 1
+                d.publish(topic, sent, timeout=0)
+        d.publish(topic, 0, timeout=0)
+        done.wait(duration + 5.0)
+        elapsed = time.perf_counter() - t0
+    finally:
+        d.unsubscribe(topic, on_msg)
+    return {
+        'sent': sent,
+        'received': state['count'] - 1,
+        'us_per_msg': 1e6 * elapsed / max(1, state['count']),
+        'msgs_per_s': _rate(state['count'], elapsed),
+    }
+
+
+def bench_streams(d, device, duration):
+    """Measure the sustained stream and statistics delivery."""
+    state = {}
+
+    def on_data(topic, value):
+        s = state[topic]
+        s['messages'] += 1
+        s['samples'] += len(value['data'])
+
+    def on_stats(topic, value):
+        state[topic]['messages'] += 1
+
+    fns = []
+    for name, subtopic in STREAMS:
+        topic = f'{device}/{subtopic}'
+        state[topic] = {'name': name, 'messages': 0, 'samples': 0}
+        fns.append((topic, on_data))
+    stats_topic = f'{device}/s/stats/value'
+    state[stats_topic] = {'name': 'statistics', 'messages': 0, 'samples': 0}
+    fns.append((stats_topic, on_stats))
+    for topic, fn in fns:
+        d.subscribe(topic, 'pub', fn)
+    ctrls = [f'{device}/{subtopic.rsplit("/", 1)[0]}/ctrl' for _, subtopic in STREAMS]
+    ctrls.append(f'{device}/s/stats/ctrl')
+    try:
+        for ctrl in ctrls:
+            d.publish(ctrl, 1)
+        time.sleep(0.25)  # reach steady state
+        for s in state.values():
+            s['messages'] = 0
+            s['samples'] = 0
+        t0 = time.perf_counter()
+        time.sleep(duration)
+        elapsed = time.perf_counter() - t0
+        snapshot = {s['name']: dict(s) for s in state.values()}
+    finally:
+        for ctrl in ctrls:
+            d.publish(ctrl, 0)
+        for topic, fn in fns:
+            d.unsubscribe(topic, fn)
+    results = {}
+    for name, s in snapshot.items():
+        results[name] = {
+            'messages_per_s': _rate(s['messages'], elapsed),
+            'samples_per_s': _rate(s['samples'], elapsed),
+        }
+    return results
+
+
+def bench_buffer(d, device, duration):
+    """Measure buffer request round trips through the binding."""
+    rsp = {'count': 0, 'value': None}
+    ready = threading.Event()
+    info = {}
+
+    def on_info(topic, value):
+        info['value'] = value
+
+    def on_rsp(topic, value):
+        rsp['value'] = value
+        rsp['count'] += 1
+        ready.set()
+
+    signal = f'm/001/s/{BUFFER_SIGNAL_ID:03d}'
+    d.publish('m/@/!add', 1)
+    d.publish('m/001/a/!add', BUFFER_SIGNAL_ID)
+    d.publish(f'{signal}/topic', f'{device}/s/i/!data')
+    d.publish('m/001/g/size', 200_000_000)
+    d.subscribe(f'{signal}/info', 'pub', on_info)
+    d.subscribe(BUFFER_RSP_TOPIC, 'pub', on_rsp)
+    ctrl = f'{device}/s/i/ctrl'
+    try:
+        d.publish(ctrl, 1)
+        time.sleep(0.5)  # fill the buffer
+        d.publish(ctrl, 0)
+        time.sleep(0.1)
+        r = info['value']['time_range_samples']
+        req = {
+            'time_type': 'samples',
+            'start': r['start'],
+            'end': r['end'],
+            'length': 1000,
+            'rsp_topic': BUFFER_RSP_TOPIC,
+            'rsp_id': 0,
+        }
+        count = 0
+        t0 = time.perf_counter()
+        t_end = t0 + duration
+        while time.perf_counter() < t_end:
+            ready.clear()
+            req['rsp_id'] = count
+            d.publish(f'{signal}/!req', req, timeout=0)
+            if not ready.wait(1.0):
+                raise TimeoutError('buffer response')
+            count += 1
+        elapsed = time.perf_counter() - t0
+    finally:
+        d.publish(ctrl, 0)
+        d.unsubscribe(BUFFER_RSP_TOPIC, on_rsp)
+        d.unsubscribe(f'{signal}/info', on_info)
+        d.publish('m/@/!remove', 1)
+    return {
+        'length': req['length'],
+        'round_trips': count,
+        'us_per_round_trip': 1e6 * elapsed / max(1, count),
+    }
+
+
+def run(args):
+    results = {
+        'version': __version__,
+        'python': platform.python_version(),
+        'platform': platform.platform(),
+        'conversions': bench_conversions(args.count),
+    }
+    if not args.conversions_only:
+        with Driver(args={'emulated/js220': 1}) as d:
+            devices = [p for p in d.device_paths() if p.startswith('z/')]
+            if not devices:
+                raise RuntimeError('emulated device not found')
+            device = devices[0]
+            d.open(device)
+            try:
+                results['pubsub'] = bench_pubsub(d, args.duration)
+                results['streams'] = bench_streams(d, device, args.duration)
+                results['buffer'] = bench_buffer(d, device, args.duration)
+            finally:
+                d.close(device)
+    return results
+
+
+def main():
+    args = get_parser().parse_args()
+    results = run(args)
+    s = json.dumps(results, indent=2)
+    if args.out:
+        with open(args.out, 'wt') as f:
+            f.write(s + '\n')
+    else:
+        print(s)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
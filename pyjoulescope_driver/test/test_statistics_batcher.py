@@ -0,0 +1,34 @@
+# Copyright 2026 Jetperch LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import unittest
+from pyjoulescope_driver import StatisticsBatcher, STATISTICS_DTYPE
+
+
+class TestStatisticsBatcher(unittest.TestCase):
+
+    def test_dtype(self):
+        self.assertEqual(216, STATISTICS_DTYPE.itemsize)
+        self.assertEqual(32, STATISTICS_DTYPE.fields['i_avg'][1])
+
+    def test_alloc(self):
+        b = StatisticsBatcher(10)
+        self.assertEqual(10, b.count)
+        self.assertEqual(0, b.length)
+        self.assertIsNone(b.flush())
+        self.assertEqual(1, StatisticsBatcher().count)
+
+    def test_invalid(self):
+        with self.assertRaises(ValueError):
+            StatisticsBatcher(0)
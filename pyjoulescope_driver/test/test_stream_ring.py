@@ -0,0 +1,40 @@
+# Copyright 2026 Jetperch LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import unittest
+from pyjoulescope_driver import StreamRing
+import numpy as np
+
+
+class TestStreamRing(unittest.TestCase):
+
+    def test_alloc(self):
+        r = StreamRing(1000)
+        self.assertEqual(1000, r.length)
+        self.assertEqual(np.float32, r.data.dtype)
+        self.assertEqual(0, r.message_count)
+        self.assertEqual(0, len(r.latest))
+        self.assertEqual(np.int16, StreamRing(10, np.int16).data.dtype)
+        self.assertEqual(np.uint8, StreamRing(10, np.uint8).data.dtype)
+
+    def test_read_only(self):
+        r = StreamRing(10)
+        with self.assertRaises(ValueError):
+            r.data[0] = 1.0
+
+    def test_invalid(self):
+        with self.assertRaises(ValueError):
+            StreamRing(0)
+        with self.assertRaises(ValueError):
+            StreamRing(10, np.float64)
@@ -0,0 +1,61 @@
+# Copyright 2026 Jetperch LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import unittest
+from pyjoulescope_driver import time_from_counter, time64
+import math
+import numpy as np
+
+
+def _scalar(time_map, sample_id):
+    # jsdrv_time_from_counter() with C round(), ties away from zero
+    x = (time64.SECOND / time_map['counter_rate']) * float(sample_id - time_map['offset_counter'])
+    return int(math.copysign(math.floor(abs(x) + 0.5), x)) + time_map['offset_time']
+
+
+class TestTimeFromCounter(unittest.TestCase):
+
+    def setUp(self):
+        self.time_map = {
+            'offset_time': time64.HOUR,
+            'offset_counter': 1_000_000_000,
+            'counter_rate': 1_000_000.0,
+        }
+
+    def test_i64(self):
+        t = time_from_counter(self.time_map, 999_999_990, 1000, incr=2)
+        self.assertEqual(np.int64, t.dtype)
+        self.assertEqual(1000, len(t))
+        for k in [0, 1, 4, 5, 999]:
+            self.assertEqual(_scalar(self.time_map, 999_999_990 + 2 * k), t[k])
+
+    def test_ties(self):
+        self.time_map['counter_rate'] = 2.0 * time64.SECOND
+        t = time_from_counter(self.time_map, self.time_map['offset_counter'] - 3, 7)
+        self.assertEqual([-2, -1, -1, 0, 1, 1, 2], list(t - self.time_map['offset_time']))
+
+    def test_timestamp(self):
+        t = time_from_counter(self.time_map, self.time_map['offset_counter'], 10, timestamp=True)
+        self.assertEqual(np.float64, t.dtype)
+        self.assertAlmostEqual(time64.as_timestamp(time64.HOUR), t[0], places=6)
+        self.assertAlmostEqual(9e-6, t[9] - t[0], delta=1e-6)
+
+    def test_out(self):
+        out = np.zeros(10, dtype=np.int64)
+        self.assertIs(out, time_from_counter(self.time_map, 0, 10, out=out))
+        with self.assertRaises(ValueError):
+            time_from_counter(self.time_map, 0, 11, out=out)
+        with self.assertRaises(ValueError):
+            time_from_counter(self.time_map, 0, 10, out=out, timestamp=True)
+        self.assertEqual(0, len(time_from_counter(self.time_map, 0, 0)))
@@ -78,7 +78,7 @@ if platform.system() == 'Windows':
         'src/backend/winusb/msg_queue.c',
         'src/backend/windows.c',
     ]
-    libraries = ['Setupapi', 'Winusb', 'user32', 'winmm']
+    libraries = ['Setupapi', 'Winusb', 'user32', 'winmm', 'Ws2_32']
     extra_compile_args = []
 elif 'armv7' in platform.machine():
     sources = posix_sources
@@ -123,15 +123,26 @@ extensions = [
     setuptools.Extension('pyjoulescope_driver.binding',
                          sources=[
                                      'pyjoulescope_driver/binding' + ext,
+                                     'src/align.c',
+                                     'src/alloc.c',
+                                     'src/api_timeout.c',
+                                     'src/arrow.c',
                                      'src/buffer.c',
+                                     'src/buffer_codec.c',
                                      'src/buffer_signal.c',
                                      'src/calibration_hash.c',
+                                     'src/continuity.c',
+                                     'src/cpu.c',
                                      'src/cstr.c',
                                      'src/devices.c',
+                                     'src/dispatch.c',
+                                     'src/executor.c',
                                      'src/downsample.c',
-                                     #'src/emu.c',
-                                     #'src/emulated.c',
+                                     'src/emulated.c',
                                      'src/error_code.c',
+                                     'src/file_writer.c',
+                                     'src/framer.c',
+                                     'src/host_stats.c',
                                      'src/js110_cal.c',
                                      'src/js110_sample_processor.c',
                                      'src/js110_stats.c',
@@ -141,16 +152,38 @@ extensions = [
                                      'src/js220_usb.c',
                                      'src/js220_stats.c',
                                      'src/jsdrv.c',
+                                     'src/net.c',
                                      'src/json.c',
+                                     'src/latency.c',
                                      'src/log.c',
+                                     'src/pack.c',
+                                     'src/perf.c',
+                                     'src/power_align.c',
+                                     'src/proc.c',
                                      'src/pubsub.c',
+                                     'src/record.c',
                                      'src/meta.c',
+                                     'src/meta_store.c',
                                      'src/sample_buffer_f32.c',
+                                     'src/shm.c',
+                                     'src/simd_f32.c',
                                      'src/statistics.c',
+                                     'src/stats_all.c',
+                                     'src/stats_history.c',
+                                     'src/stream_event.c',
+                                     'src/stream_reader.c',
+                                     'src/tap.c',
+                                     'src/thread_policy.c',
                                      'src/time.c',
                                      'src/time_map_filter.c',
                                      'src/topic.c',
+                                     'src/topic_index.c',
+                                     'src/trace.c',
+                                     'src/trigger.c',
                                      'src/union.c',
+                                     'src/usb_replay.c',
+                                     'src/usb_trace.c',
+                                     'src/value_cache.c',
                                      'src/version.c',
                                      'third-party/tinyprintf/tinyprintf.c',
                                      ] + sources,
@@ -163,7 +196,10 @@ extensions = [
 
 if USE_CYTHON:
     from Cython.Build import cythonize
-    extensions = cythonize(extensions, compiler_directives={'language_level': '3'})  # , annotate=True)
+    extensions = cythonize(extensions, compiler_directives={
+        'language_level': '3',
+        'freethreading_compatible': True,  # does not require the GIL on free-threaded CPython
+    })  # , annotate=True)
 
 
 # Get the long description from the README file
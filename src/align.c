@@ -0,0 +1,613 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/align.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/dbc.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/time.h"
+#include "jsdrv/topic.h"
+#include "tinyprintf.h"
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+
+
+#define RING_MASK               (JSDRV_ALIGN_RING_SIZE - 1)
+#define STALL_THRESHOLD         (JSDRV_ALIGN_RING_SIZE / 2)
+#define FRAME_HEADER_SIZE       (offsetof(struct jsdrv_align_frame_s, data))
+#define FRAME_SAMPLES_MAX       (JSDRV_STREAM_DATA_SIZE / sizeof(float))
+#define MAP_PERIOD              (JSDRV_TIME_SECOND)
+JSDRV_STATIC_ASSERT(0 == (JSDRV_ALIGN_RING_SIZE & RING_MASK), ring_size_power_of_2);
+JSDRV_STATIC_ASSERT(JSDRV_STREAM_HEADER_SIZE == offsetof(struct jsdrv_align_frame_s, data), frame_header_size);
+
+
+struct source_s {
+    bool time_map_valid;
+    bool data_valid;
+    uint32_t sample_rate;
+    uint32_t decimate_factor;
+    struct jsdrv_time_map_s time_map;
+    float * ring;       // NULL when frames are disabled
+    int64_t head;       // the next sample index, sample_id / decimate_factor
+    int64_t tail;       // the oldest retained sample index
+};
+
+struct jsdrv_align_s {
+    jsdrv_align_frame_fn frame_fn;
+    void * user_data;
+    uint8_t source_count;
+    bool frames;
+    bool master_started;
+    int64_t master_next;  // the next master sample index for frames
+    struct source_s sources[JSDRV_ALIGN_SOURCES_MAX];
+    struct jsdrv_align_frame_s frame;
+};
+
+/// The position of a master sample in another source's samples.
+struct position_s {
+    int64_t idx;        // the sample index
+    double frac;        // the fractional part in [0, 1)
+};
+
+static void source_reset(struct source_s * s) {
+    s->data_valid = false;
+    s->head = 0;
+    s->tail = 0;
+}
+
+static void source_free(struct source_s * s) {
+    if (s->ring) {
+        jsdrv_free(s->ring);
+        s->ring = NULL;
+    }
+    source_reset(s);
+}
+
+static void sources_clear(struct jsdrv_align_s * self) {
+    for (uint32_t k = 0; k < JSDRV_ALIGN_SOURCES_MAX; ++k) {
+        struct source_s * s = &self->sources[k];
+        source_free(s);
+        memset(s, 0, sizeof(*s));
+    }
+    self->master_started = false;
+    self->master_next = 0;
+}
+
+struct jsdrv_align_s * jsdrv_align_alloc(jsdrv_align_frame_fn frame_fn, void * user_data) {
+    struct jsdrv_align_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_align_s));
+    self->frame_fn = frame_fn;
+    self->user_data = user_data;
+    return self;
+}
+
+void jsdrv_align_free(struct jsdrv_align_s * self) {
+    if (self) {
+        sources_clear(self);
+        jsdrv_free(self);
+    }
+}
+
+int32_t jsdrv_align_source_count_set(struct jsdrv_align_s * self, uint8_t source_count) {
+    if (source_count > JSDRV_ALIGN_SOURCES_MAX) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    sources_clear(self);
+    self->source_count = source_count;
+    return 0;
+}
+
+void jsdrv_align_frames_enable(struct jsdrv_align_s * self, bool enable) {
+    if (enable == self->frames) {
+        return;
+    }
+    for (uint32_t k = 0; k < JSDRV_ALIGN_SOURCES_MAX; ++k) {
+        source_free(&self->sources[k]);
+    }
+    self->master_started = false;
+    self->frames = enable;
+}
+
+static void ring_write(struct source_s * s, const float * data, uint32_t count) {
+    if (count > JSDRV_ALIGN_RING_SIZE) {
+        data += count - JSDRV_ALIGN_RING_SIZE;
+        s->head += count - JSDRV_ALIGN_RING_SIZE;
+        count = JSDRV_ALIGN_RING_SIZE;
+    }
+    uint32_t offset = (uint32_t) (s->head & RING_MASK);
+    uint32_t sz = JSDRV_ALIGN_RING_SIZE - offset;
+    sz = (sz > count) ? count : sz;
+    memcpy(s->ring + offset, data, sz * sizeof(float));
+    memcpy(s->ring, data + sz, (count - sz) * sizeof(float));
+    s->head += count;
+    if ((s->head - s->tail) > JSDRV_ALIGN_RING_SIZE) {
+        s->tail = s->head - JSDRV_ALIGN_RING_SIZE;
+    }
+}
+
+static void ring_fill_nan(struct source_s * s, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        s->ring[(s->head + i) & RING_MASK] = NAN;
+    }
+    s->head += count;
+    if ((s->head - s->tail) > JSDRV_ALIGN_RING_SIZE) {
+        s->tail = s->head - JSDRV_ALIGN_RING_SIZE;
+    }
+}
+
+static int32_t ring_recv(struct source_s * s, const struct jsdrv_stream_signal_s * signal) {
+    if ((JSDRV_DATA_TYPE_FLOAT != signal->element_type) || (32 != signal->element_size_bits)) {
+        return JSDRV_ERROR_NOT_SUPPORTED;
+    }
+    if (NULL == s->ring) {
+        s->ring = jsdrv_alloc(JSDRV_ALIGN_RING_SIZE * sizeof(float));
+    }
+    const float * data = (const float *) signal->data;
+    uint32_t count = signal->element_count;
+    if (count > FRAME_SAMPLES_MAX) {
+        count = FRAME_SAMPLES_MAX;
+    }
+    int64_t idx = (int64_t) (signal->sample_id / signal->decimate_factor);
+    if (!s->data_valid) {
+        s->head = idx;
+        s->tail = idx;
+        s->data_valid = true;
+    } else if (idx < s->head) {  // overlap
+        int64_t skip = s->head - idx;
+        if (skip >= (int64_t) count) {
+            return 0;
+        }
+        data += skip;
+        count -= (uint32_t) skip;
+    } else if (idx > s->head) {  // skipped samples
+        int64_t gap = idx - s->head;
+        if (gap >= JSDRV_ALIGN_RING_SIZE) {
+            s->head = idx;
+            s->tail = idx;
+        } else {
+            ring_fill_nan(s, (uint32_t) gap);
+        }
+    }
+    ring_write(s, data, count);
+    return 0;
+}
+
+/*
+ * Map master sample index m to the sample position in source s.
+ * Each step remains relative to the time map offsets so that the
+ * double computations only span the time since the last offset update.
+ */
+static struct position_s position(const struct source_s * master, const struct source_s * s, int64_t m) {
+    const struct jsdrv_time_map_s * t0 = &master->time_map;
+    const struct jsdrv_time_map_s * tk = &s->time_map;
+    uint64_t counter = (uint64_t) m * master->decimate_factor;
+    double dt = ((double) (int64_t) (counter - t0->offset_counter)) / t0->counter_rate
+            + ((double) (t0->offset_time - tk->offset_time)) / (double) JSDRV_TIME_SECOND;
+    double dc = dt * tk->counter_rate;
+    double dc_int = floor(dc);
+    int64_t c = (int64_t) tk->offset_counter + (int64_t) dc_int;
+    int64_t dec = (int64_t) s->decimate_factor;
+    int64_t idx = c / dec;
+    int64_t rem = c - idx * dec;
+    if (rem < 0) {
+        --idx;
+        rem += dec;
+    }
+    struct position_s p = {
+        .idx = idx,
+        .frac = ((double) rem + (dc - dc_int)) / (double) dec,
+    };
+    return p;
+}
+
+static double slope(const struct source_s * master, const struct source_s * s) {
+    return (((double) master->decimate_factor) / master->time_map.counter_rate)
+        * (s->time_map.counter_rate / (double) s->decimate_factor);
+}
+
+// The number of master samples, up to n, that source s can interpolate.
+static uint32_t source_available(const struct source_s * s, struct position_s p, double m, uint32_t n) {
+    double limit = (double) (s->head - 1 - p.idx) - p.frac;
+    if (limit <= 0.0) {
+        return 0;
+    }
+    double k = ceil(limit / m);
+    return (k >= (double) n) ? n : (uint32_t) k;
+}
+
+static void source_interpolate(const struct source_s * s, struct position_s p, double m, uint32_t n, float * y) {
+    const float * r = s->ring;
+    for (uint32_t j = 0; j < n; ++j) {
+        double x = p.frac + m * j;
+        double x_int = floor(x);
+        double f = x - x_int;
+        int64_t idx = p.idx + (int64_t) x_int;
+        if (idx < s->tail) {
+            y[j] = NAN;
+        } else if ((idx + 1) >= s->head) {
+            y[j] = (((idx + 1) == s->head) && (0.0 == f)) ? r[idx & RING_MASK] : NAN;
+        } else {
+            double y0 = r[idx & RING_MASK];
+            double y1 = r[(idx + 1) & RING_MASK];
+            y[j] = (float) (y0 + (y1 - y0) * f);
+        }
+    }
+}
+
+static bool sources_ready(struct jsdrv_align_s * self) {
+    if (0 == self->source_count) {
+        return false;
+    }
+    for (uint32_t k = 0; k < self->source_count; ++k) {
+        struct source_s * s = &self->sources[k];
+        if (!s->time_map_valid || !s->data_valid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void frames_process(struct jsdrv_align_s * self) {
+    if (!sources_ready(self)) {
+        return;
+    }
+    struct source_s * master = &self->sources[0];
+    struct jsdrv_align_frame_s * frame = &self->frame;
+    uint32_t source_count = self->source_count;
+    uint32_t n_max = (uint32_t) (FRAME_SAMPLES_MAX / source_count);
+    if (!self->master_started || (self->master_next < master->tail)) {
+        self->master_next = master->tail;
+        self->master_started = true;
+    }
+
+    while (1) {
+        int64_t avail = master->head - self->master_next;
+        if (avail <= 0) {
+            break;
+        }
+        uint32_t n = (avail > n_max) ? n_max : (uint32_t) avail;
+        struct position_s p[JSDRV_ALIGN_SOURCES_MAX];
+        double m[JSDRV_ALIGN_SOURCES_MAX];
+        uint32_t n_ok = n;
+        for (uint32_t k = 1; k < source_count; ++k) {
+            p[k] = position(master, &self->sources[k], self->master_next);
+            m[k] = slope(master, &self->sources[k]);
+            uint32_t n_k = source_available(&self->sources[k], p[k], m[k], n);
+            n_ok = (n_k < n_ok) ? n_k : n_ok;
+        }
+        if (n_ok < n) {
+            if (avail < STALL_THRESHOLD) {
+                if (0 == n_ok) {
+                    break;  // wait for the other sources
+                }
+                n = n_ok;
+            }
+            // else a source stalled, proceed with NaN
+        }
+
+        frame->sample_id = (uint64_t) self->master_next * master->decimate_factor;
+        frame->version = 1;
+        frame->source_count = (uint8_t) source_count;
+        frame->rsv1_u8 = 0;
+        frame->rsv2_u8 = 0;
+        frame->element_count = n;
+        frame->sample_rate = master->sample_rate;
+        frame->decimate_factor = master->decimate_factor;
+        frame->time_map = master->time_map;
+        for (uint32_t j = 0; j < n; ++j) {
+            frame->data[j] = master->ring[(self->master_next + j) & RING_MASK];
+        }
+        for (uint32_t k = 1; k < source_count; ++k) {
+            source_interpolate(&self->sources[k], p[k], m[k], n, frame->data + k * n);
+        }
+        self->master_next += n;
+        if (self->frame_fn) {
+            self->frame_fn(self->user_data, frame, (uint32_t) (FRAME_HEADER_SIZE + n * source_count * sizeof(float)));
+        }
+    }
+}
+
+int32_t jsdrv_align_recv(struct jsdrv_align_s * self, uint8_t source_idx, const struct jsdrv_stream_signal_s * signal) {
+    if ((source_idx >= self->source_count) || (0 == signal->decimate_factor) || (0 == signal->sample_rate)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct source_s * s = &self->sources[source_idx];
+    if ((s->sample_rate != signal->sample_rate) || (s->decimate_factor != signal->decimate_factor)) {
+        source_reset(s);
+        s->sample_rate = signal->sample_rate;
+        s->decimate_factor = signal->decimate_factor;
+        if (0 == source_idx) {
+            self->master_started = false;
+        }
+    }
+    if (signal->time_map.counter_rate > 0.0) {
+        s->time_map = signal->time_map;
+        s->time_map_valid = true;
+    }
+    if (!self->frames) {
+        s->data_valid = true;
+        return 0;
+    }
+    int32_t rc = ring_recv(s, signal);
+    if (0 == rc) {
+        frames_process(self);
+    }
+    return rc;
+}
+
+int32_t jsdrv_align_map(struct jsdrv_align_s * self, struct jsdrv_align_map_s * map) {
+    memset(map, 0, sizeof(*map));
+    if (!sources_ready(self)) {
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    map->version = 1;
+    map->source_count = self->source_count;
+    for (uint32_t k = 0; k < self->source_count; ++k) {
+        map->sample_rate[k] = self->sources[k].sample_rate;
+        map->decimate_factor[k] = self->sources[k].decimate_factor;
+        map->time_map[k] = self->sources[k].time_map;
+    }
+    return 0;
+}
+
+
+// -- Driver service --
+
+static const char * action_add_meta = "{"
+    "\"dtype\": \"str\","
+    "\"brief\": \"Add a stream data topic to align.\","
+    "\"detail\": \"The first source is the master timebase for aligned frames.\""
+"}";
+
+static const char * action_remove_meta = "{"
+    "\"dtype\": \"str\","
+    "\"brief\": \"Remove a stream data topic.\""
+"}";
+
+static const char * list_meta = "{"
+    "\"dtype\": \"str\","
+    "\"brief\": \"The comma-separated source topics, master first.\","
+    "\"flags\": [\"ro\"]"
+"}";
+
+static const char * frames_meta = "{"
+    "\"dtype\": \"bool\","
+    "\"brief\": \"Publish f32 samples aligned to the master on t/!data.\","
+    "\"default\": 0"
+"}";
+
+struct jsdrv_align_svc_s;
+
+// The subscriber user_data for each source.
+struct align_source_s {
+    struct jsdrv_align_svc_s * parent;
+    uint8_t idx;
+};
+
+struct jsdrv_align_svc_s {
+    struct jsdrv_context_s * context;
+    struct jsdrv_align_s * align;
+    uint8_t source_count;
+    char topics[JSDRV_ALIGN_SOURCES_MAX][JSDRV_TOPIC_LENGTH_MAX];
+    struct align_source_s sources[JSDRV_ALIGN_SOURCES_MAX];
+    int64_t map_time;
+};
+
+static void send_to_frontend(struct jsdrv_align_svc_s * self, const char * topic, const struct jsdrv_union_s * value) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, topic, value);
+    jsdrvp_backend_send(self->context, m);
+}
+
+static int32_t subscribe(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
+                         jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
+    jsdrv_cstr_copy(m->topic, JSDRV_PUBSUB_SUBSCRIBE, sizeof(m->topic));
+    m->value.type = JSDRV_UNION_BIN;
+    m->value.value.bin = m->payload.bin;
+    m->value.app = JSDRV_PAYLOAD_TYPE_SUB;
+    jsdrv_cstr_copy(m->payload.sub.topic, topic, sizeof(m->payload.sub.topic));
+    m->payload.sub.subscriber.internal_fn = cbk_fn;
+    m->payload.sub.subscriber.user_data = cbk_user_data;
+    m->payload.sub.subscriber.is_internal = 1;
+    m->payload.sub.subscriber.flags = flags;
+    jsdrvp_backend_send(context, m);
+    return 0;
+}
+
+static int32_t unsubscribe(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
+                           jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
+    jsdrv_cstr_copy(m->topic, JSDRV_PUBSUB_UNSUBSCRIBE, sizeof(m->topic));
+    m->value.type = JSDRV_UNION_BIN;
+    m->value.value.bin = m->payload.bin;
+    m->value.app = JSDRV_PAYLOAD_TYPE_SUB;
+    jsdrv_cstr_copy(m->payload.sub.topic, topic, sizeof(m->payload.sub.topic));
+    m->payload.sub.subscriber.internal_fn = cbk_fn;
+    m->payload.sub.subscriber.user_data = cbk_user_data;
+    m->payload.sub.subscriber.is_internal = 1;
+    m->payload.sub.subscriber.flags = flags;
+    jsdrvp_backend_send(context, m);
+    return 0;
+}
+
+static int32_t send_return_code_to_frontend(struct jsdrv_context_s * context, const char * topic, int32_t rc,
+        jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
+    struct jsdrvp_msg_s * m;
+    m = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_i32(rc));
+    tfp_snprintf(m->topic, sizeof(m->topic), "%s%c", topic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
+    m->extra.frontend.subscriber.internal_fn = cbk_fn;
+    m->extra.frontend.subscriber.user_data = cbk_user_data;
+    m->extra.frontend.subscriber.is_internal = 1;
+    jsdrvp_backend_send(context, m);
+    return rc;
+}
+
+static void on_frame(void * user_data, const struct jsdrv_align_frame_s * frame, uint32_t size) {
+    struct jsdrv_align_svc_s * self = (struct jsdrv_align_svc_s *) user_data;
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_data_sz(self->context, JSDRV_ALIGN_MSG_DATA, size);
+    memcpy(m->payload.bin, frame, size);
+    m->value.size = size;
+    m->value.app = JSDRV_PAYLOAD_TYPE_ALIGN_FRAME;
+    jsdrvp_backend_send(self->context, m);
+}
+
+static void map_publish(struct jsdrv_align_svc_s * self) {
+    struct jsdrv_align_map_s map;
+    int64_t t = jsdrv_time_utc();
+    if ((t - self->map_time) < MAP_PERIOD) {
+        return;
+    }
+    if (jsdrv_align_map(self->align, &map)) {
+        return;
+    }
+    self->map_time = t;
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, JSDRV_ALIGN_MSG_MAP,
+            &jsdrv_union_cbin_r((uint8_t *) &map, sizeof(map)));
+    m->value.app = JSDRV_PAYLOAD_TYPE_ALIGN_MAP;
+    jsdrvp_backend_send(self->context, m);
+}
+
+static uint8_t _align_recv_data(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct align_source_s * source = (struct align_source_s *) user_data;
+    struct jsdrv_align_svc_s * self = source->parent;
+    if ((JSDRV_UNION_BIN != msg->value.type) || (JSDRV_PAYLOAD_TYPE_STREAM != msg->value.app)) {
+        return 0;
+    }
+    const struct jsdrv_stream_signal_s * signal = (const struct jsdrv_stream_signal_s *) msg->value.value.bin;
+    int32_t rc = jsdrv_align_recv(self->align, source->idx, signal);
+    if (rc) {
+        JSDRV_LOGW("align source %s: %" PRId32, msg->topic, rc);
+    }
+    map_publish(self);
+    return 0;
+}
+
+static void sources_unsubscribe(struct jsdrv_align_svc_s * self) {
+    for (uint32_t k = 0; k < self->source_count; ++k) {
+        unsubscribe(self->context, self->topics[k], JSDRV_SFLAG_PUB, _align_recv_data, &self->sources[k]);
+    }
+}
+
+static void sources_subscribe(struct jsdrv_align_svc_s * self) {
+    char list[JSDRV_PAYLOAD_LENGTH_MAX];
+    list[0] = 0;
+    for (uint32_t k = 0; k < self->source_count; ++k) {
+        subscribe(self->context, self->topics[k], JSDRV_SFLAG_PUB, _align_recv_data, &self->sources[k]);
+        if (k) {
+            jsdrv_cstr_join(list, list, ",", sizeof(list));
+        }
+        jsdrv_cstr_join(list, list, self->topics[k], sizeof(list));
+    }
+    jsdrv_align_source_count_set(self->align, self->source_count);
+    self->map_time = 0;
+    send_to_frontend(self, JSDRV_ALIGN_MSG_LIST, &jsdrv_union_cstr_r(list));
+}
+
+static int32_t source_find(struct jsdrv_align_svc_s * self, const char * topic) {
+    for (uint32_t k = 0; k < self->source_count; ++k) {
+        if (0 == strcmp(self->topics[k], topic)) {
+            return (int32_t) k;
+        }
+    }
+    return -1;
+}
+
+static uint8_t _align_add(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct jsdrv_align_svc_s * self = (struct jsdrv_align_svc_s *) user_data;
+    const char * topic = msg->value.value.str;
+    if ((JSDRV_UNION_STR != msg->value.type) || (NULL == topic) || (0 == topic[0])
+            || (strlen(topic) >= JSDRV_TOPIC_LENGTH_MAX)) {
+        return (uint8_t) send_return_code_to_frontend(self->context, JSDRV_ALIGN_MSG_ADD, JSDRV_ERROR_PARAMETER_INVALID, _align_add, self);
+    } else if (source_find(self, topic) >= 0) {
+        return (uint8_t) send_return_code_to_frontend(self->context, JSDRV_ALIGN_MSG_ADD, JSDRV_ERROR_ALREADY_EXISTS, _align_add, self);
+    } else if (self->source_count >= JSDRV_ALIGN_SOURCES_MAX) {
+        return (uint8_t) send_return_code_to_frontend(self->context, JSDRV_ALIGN_MSG_ADD, JSDRV_ERROR_FULL, _align_add, self);
+    }
+    JSDRV_LOGI("align add %s", topic);
+    sources_unsubscribe(self);
+    jsdrv_cstr_copy(self->topics[self->source_count++], topic, JSDRV_TOPIC_LENGTH_MAX);
+    sources_subscribe(self);
+    return (uint8_t) send_return_code_to_frontend(self->context, JSDRV_ALIGN_MSG_ADD, 0, _align_add, self);
+}
+
+static uint8_t _align_remove(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct jsdrv_align_svc_s * self = (struct jsdrv_align_svc_s *) user_data;
+    int32_t idx = -1;
+    if (JSDRV_UNION_STR == msg->value.type) {
+        idx = source_find(self, msg->value.value.str);
+    }
+    if (idx < 0) {
+        return (uint8_t) send_return_code_to_frontend(self->context, JSDRV_ALIGN_MSG_REMOVE, JSDRV_ERROR_NOT_FOUND, _align_remove, self);
+    }
+    JSDRV_LOGI("align remove %s", msg->value.value.str);
+    sources_unsubscribe(self);
+    for (uint32_t k = (uint32_t) idx + 1; k < self->source_count; ++k) {
+        jsdrv_cstr_copy(self->topics[k - 1], self->topics[k], JSDRV_TOPIC_LENGTH_MAX);
+    }
+    self->topics[--self->source_count][0] = 0;
+    sources_subscribe(self);
+    return (uint8_t) send_return_code_to_frontend(self->context, JSDRV_ALIGN_MSG_REMOVE, 0, _align_remove, self);
+}
+
+static uint8_t _align_frames(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct jsdrv_align_svc_s * self = (struct jsdrv_align_svc_s *) user_data;
+    bool enable = false;
+    if (jsdrv_union_to_bool(&msg->value, &enable)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    jsdrv_align_frames_enable(self->align, enable);
+    return 0;
+}
+
+int32_t jsdrv_align_initialize(struct jsdrv_context_s * context, struct jsdrv_align_svc_s ** instance) {
+    JSDRV_DBC_NOT_NULL(context);
+    JSDRV_DBC_NOT_NULL(instance);
+    struct jsdrv_align_svc_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_align_svc_s));
+    self->context = context;
+    self->align = jsdrv_align_alloc(on_frame, self);
+    for (uint8_t k = 0; k < JSDRV_ALIGN_SOURCES_MAX; ++k) {
+        self->sources[k].parent = self;
+        self->sources[k].idx = k;
+    }
+
+    send_to_frontend(self, JSDRV_ALIGN_MSG_ADD "$", &jsdrv_union_cjson_r(action_add_meta));
+    send_to_frontend(self, JSDRV_ALIGN_MSG_REMOVE "$", &jsdrv_union_cjson_r(action_remove_meta));
+    send_to_frontend(self, JSDRV_ALIGN_MSG_LIST "$", &jsdrv_union_cjson_r(list_meta));
+    send_to_frontend(self, JSDRV_ALIGN_MSG_FRAMES "$", &jsdrv_union_cjson_r(frames_meta));
+    send_to_frontend(self, JSDRV_ALIGN_MSG_LIST, &jsdrv_union_cstr_r(""));
+    send_to_frontend(self, JSDRV_ALIGN_MSG_FRAMES, &jsdrv_union_u8_r(0));
+
+    subscribe(self->context, JSDRV_ALIGN_MSG_ADD, JSDRV_SFLAG_PUB, _align_add, self);
+    subscribe(self->context, JSDRV_ALIGN_MSG_REMOVE, JSDRV_SFLAG_PUB, _align_remove, self);
+    subscribe(self->context, JSDRV_ALIGN_MSG_FRAMES, JSDRV_SFLAG_PUB, _align_frames, self);
+    *instance = self;
+    return 0;
+}
+
+void jsdrv_align_finalize(struct jsdrv_align_svc_s * self) {
+    if (self) {
+        unsubscribe(self->context, JSDRV_ALIGN_MSG_ADD, JSDRV_SFLAG_PUB, _align_add, self);
+        unsubscribe(self->context, JSDRV_ALIGN_MSG_REMOVE, JSDRV_SFLAG_PUB, _align_remove, self);
+        unsubscribe(self->context, JSDRV_ALIGN_MSG_FRAMES, JSDRV_SFLAG_PUB, _align_frames, self);
+        sources_unsubscribe(self);
+        jsdrv_align_free(self->align);
+        jsdrv_free(self);
+    }
+}
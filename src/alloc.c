@@ -0,0 +1,513 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv.h"
+#include "jsdrv_prv/alloc.h"
+#include "jsdrv_prv/atomic.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv/error_code.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#if _WIN32
+#include <windows.h>
+#define THREAD_LOCAL __declspec(thread)
+#define LOCK() AcquireSRWLockExclusive(&lock_)
+#define UNLOCK() ReleaseSRWLockExclusive(&lock_)
+#define TRACE_LOCK() AcquireSRWLockExclusive(&trace_lock_)
+#define TRACE_UNLOCK() ReleaseSRWLockExclusive(&trace_lock_)
+#else
+#include <pthread.h>
+#define THREAD_LOCAL _Thread_local
+#define LOCK() pthread_mutex_lock(&lock_)
+#define UNLOCK() pthread_mutex_unlock(&lock_)
+#define TRACE_LOCK() pthread_mutex_lock(&trace_lock_)
+#define TRACE_UNLOCK() pthread_mutex_unlock(&trace_lock_)
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define BACKTRACE_ENABLE (1)
+#endif
+#endif
+#ifndef BACKTRACE_ENABLE
+#define BACKTRACE_ENABLE (0)
+#endif
+
+
+#define HEADER_SIZE (16U)
+#define CLASS_SIZE_LOG2_MIN (6U)
+#define CLASS_LARGE (0xffU)
+#define CLASS_TRACED (0xfeU)
+#define HEADER_MAGIC (0x4a53414cU)  // "JSAL"
+#define CACHE_BATCH (JSDRV_ALLOC_CACHE_MAX / 2U)
+
+// Precedes each block, keeps the payload aligned for any type.
+struct header_s {
+    uint32_t magic;
+    uint8_t cls;
+    uint8_t cat;
+    uint16_t rsv;
+    uint64_t size;      // the bytes accounted to cat
+};
+
+// Precedes the header of traced blocks, which bypass the size classes.
+struct trace_s {
+    struct trace_s * prev;
+    struct trace_s * next;
+    size_t size_bytes;
+    uint32_t frame_count;
+    void * frames[JSDRV_ALLOC_TRACE_DEPTH];
+};
+
+#define TRACE_SIZE ((sizeof(struct trace_s) + HEADER_SIZE - 1) & ~((size_t) (HEADER_SIZE - 1)))
+
+// Overlays the payload of free blocks.
+struct free_s {
+    struct free_s * next;
+};
+
+struct thread_cache_s {
+    struct free_s * head[JSDRV_ALLOC_CLASS_COUNT];
+    uint32_t count[JSDRV_ALLOC_CLASS_COUNT];
+};
+
+// The lock uses the OS primitive directly since jsdrv_os_mutex_alloc() allocates.
+#if _WIN32
+static SRWLOCK lock_ = SRWLOCK_INIT;
+static SRWLOCK trace_lock_ = SRWLOCK_INIT;
+#else
+static pthread_mutex_t lock_ = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t trace_lock_ = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static struct free_s * free_head_[JSDRV_ALLOC_CLASS_COUNT];     // guarded by lock_
+static uint32_t free_count_[JSDRV_ALLOC_CLASS_COUNT];           // guarded by lock_
+static volatile int32_t outstanding_ = 0;
+static THREAD_LOCAL struct thread_cache_s * cache_ = NULL;
+static volatile uint64_t cat_bytes_[JSDRV_ALLOC_CAT_COUNT];
+static volatile uint64_t cat_count_[JSDRV_ALLOC_CAT_COUNT];
+static volatile uint64_t cat_peak_[JSDRV_ALLOC_CAT_COUNT];
+static volatile int32_t trace_enable_ = 0;
+static struct trace_s * trace_head_ = NULL;                     // guarded by trace_lock_, newest first
+static uint32_t trace_count_ = 0;                               // guarded by trace_lock_
+
+static const char * CAT_NAMES[JSDRV_ALLOC_CAT_COUNT] = {  // <= 7 chars per level
+    [JSDRV_ALLOC_CAT_OTHER] = "other",
+    [JSDRV_ALLOC_CAT_MSG] = "msg",
+    [JSDRV_ALLOC_CAT_PUBSUB] = "pubsub",
+    [JSDRV_ALLOC_CAT_BUFFER] = "buffer",
+    [JSDRV_ALLOC_CAT_LOG] = "log",
+    [JSDRV_ALLOC_CAT_XFER] = "xfer",
+};
+
+static void * default_alloc(void * user_data, size_t size_bytes) {
+    (void) user_data;
+    return malloc(size_bytes);
+}
+
+static void default_free(void * user_data, void * ptr) {
+    (void) user_data;
+    free(ptr);
+}
+
+static struct jsdrv_allocator_s allocator_ = {
+    .alloc = default_alloc,
+    .free = default_free,
+    .user_data = NULL,
+};
+
+static inline uint64_t u64_add(volatile uint64_t * ptr, uint64_t value) {
+#if _WIN32
+    return (uint64_t) InterlockedExchangeAdd64((volatile LONG64 *) ptr, (LONG64) value) + value;
+#else
+    return __atomic_add_fetch(ptr, value, __ATOMIC_RELAXED);
+#endif
+}
+
+static inline uint64_t u64_load(volatile uint64_t * ptr) {
+#if _WIN32
+    return (uint64_t) InterlockedCompareExchange64((volatile LONG64 *) ptr, 0, 0);
+#else
+    return __atomic_load_n(ptr, __ATOMIC_RELAXED);
+#endif
+}
+
+static inline void u64_max(volatile uint64_t * ptr, uint64_t value) {
+    uint64_t v = u64_load(ptr);
+    while (value > v) {
+#if _WIN32
+        uint64_t prev = (uint64_t) InterlockedCompareExchange64((volatile LONG64 *) ptr, (LONG64) value, (LONG64) v);
+        if (prev == v) {
+            break;
+        }
+        v = prev;
+#else
+        if (__atomic_compare_exchange_n(ptr, &v, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+#endif
+    }
+}
+
+static inline void cat_add(uint8_t cat, uint64_t size) {
+    u64_add(&cat_count_[cat], 1);
+    u64_max(&cat_peak_[cat], u64_add(&cat_bytes_[cat], size));
+}
+
+static inline void cat_sub(uint8_t cat, uint64_t size) {
+    u64_add(&cat_count_[cat], (uint64_t) -1);
+    u64_add(&cat_bytes_[cat], (uint64_t) 0 - size);
+}
+
+static inline size_t class_size(uint32_t cls) {
+    return ((size_t) 1U) << (cls + CLASS_SIZE_LOG2_MIN);
+}
+
+static inline uint32_t class_of(size_t size_bytes) {
+    if (size_bytes > JSDRV_ALLOC_SMALL_MAX) {
+        return CLASS_LARGE;
+    }
+    uint32_t cls = 0;
+    size_t sz = size_bytes + HEADER_SIZE;
+    while (class_size(cls) < sz) {
+        ++cls;
+    }
+    return cls;
+}
+
+static void * hook_alloc(size_t size_bytes) {
+    void * ptr = allocator_.alloc(allocator_.user_data, size_bytes);
+    if (!ptr) {
+        JSDRV_FATAL("out of memory");
+    }
+    jsdrv_atomic_add(&outstanding_, 1);
+    return ptr;
+}
+
+static void hook_free(void * ptr) {
+    jsdrv_atomic_add(&outstanding_, -1);
+    allocator_.free(allocator_.user_data, ptr);
+}
+
+// Move a NULL-terminated list into the global free list, releasing any excess.
+static void global_push(uint32_t cls, struct free_s * head) {
+    LOCK();
+    while (head && (free_count_[cls] < JSDRV_ALLOC_GLOBAL_MAX)) {
+        struct free_s * next = head->next;
+        head->next = free_head_[cls];
+        free_head_[cls] = head;
+        ++free_count_[cls];
+        head = next;
+    }
+    UNLOCK();
+    while (head) {
+        struct free_s * next = head->next;
+        hook_free(head);
+        head = next;
+    }
+}
+
+// Take up to count blocks from the global free list as a NULL-terminated list.
+static struct free_s * global_pop(uint32_t cls, uint32_t count, uint32_t * actual) {
+    struct free_s * head = NULL;
+    uint32_t n = 0;
+    LOCK();
+    while ((n < count) && free_head_[cls]) {
+        struct free_s * b = free_head_[cls];
+        free_head_[cls] = b->next;
+        b->next = head;
+        head = b;
+        ++n;
+    }
+    free_count_[cls] -= n;
+    UNLOCK();
+    *actual = n;
+    return head;
+}
+
+static struct header_s * block_alloc(uint32_t cls) {
+    struct thread_cache_s * c = cache_;
+    struct free_s * b = NULL;
+    if (c) {
+        if (!c->head[cls]) {
+            c->head[cls] = global_pop(cls, CACHE_BATCH, &c->count[cls]);
+        }
+        b = c->head[cls];
+        if (b) {
+            c->head[cls] = b->next;
+            --c->count[cls];
+        }
+    } else {
+        uint32_t n;
+        b = global_pop(cls, 1, &n);
+    }
+    if (!b) {
+        b = hook_alloc(class_size(cls));
+    }
+    return (struct header_s *) b;
+}
+
+static void block_free(uint32_t cls, struct header_s * hdr) {
+    struct free_s * b = (struct free_s *) hdr;
+    struct thread_cache_s * c = cache_;
+    if (!c) {
+        b->next = NULL;
+        global_push(cls, b);
+        return;
+    }
+    b->next = c->head[cls];
+    c->head[cls] = b;
+    if (++c->count[cls] > JSDRV_ALLOC_CACHE_MAX) {
+        // return the oldest half in one batch, keep the recently used blocks
+        struct free_s * tail = c->head[cls];
+        for (uint32_t idx = 1; idx < (JSDRV_ALLOC_CACHE_MAX - CACHE_BATCH); ++idx) {
+            tail = tail->next;
+        }
+        struct free_s * batch = tail->next;
+        tail->next = NULL;
+        c->count[cls] = JSDRV_ALLOC_CACHE_MAX - CACHE_BATCH;
+        global_push(cls, batch);
+    }
+}
+
+static uint32_t frames_capture(void ** frames) {
+#if _WIN32
+    return CaptureStackBackTrace(2, JSDRV_ALLOC_TRACE_DEPTH, frames, NULL);
+#elif BACKTRACE_ENABLE
+    void * f[JSDRV_ALLOC_TRACE_DEPTH + 2];
+    int n = backtrace(f, (int) JSDRV_ARRAY_SIZE(f));
+    uint32_t count = (n > 2) ? (uint32_t) (n - 2) : 0;  // skip this function and the allocator
+    for (uint32_t idx = 0; idx < count; ++idx) {
+        frames[idx] = f[idx + 2];
+    }
+    return count;
+#else
+    frames[0] = __builtin_return_address(0);
+    return 1;
+#endif
+}
+
+static struct header_s * traced_alloc(size_t size_bytes) {
+    uint8_t * block = hook_alloc(TRACE_SIZE + HEADER_SIZE + size_bytes);
+    struct trace_s * t = (struct trace_s *) block;
+    t->size_bytes = size_bytes;
+    t->frame_count = frames_capture(t->frames);
+    t->prev = NULL;
+    TRACE_LOCK();
+    t->next = trace_head_;
+    if (trace_head_) {
+        trace_head_->prev = t;
+    }
+    trace_head_ = t;
+    ++trace_count_;
+    TRACE_UNLOCK();
+    return (struct header_s *) (block + TRACE_SIZE);
+}
+
+static void traced_free(struct header_s * hdr) {
+    struct trace_s * t = (struct trace_s *) (((uint8_t *) hdr) - TRACE_SIZE);
+    TRACE_LOCK();
+    if (t->prev) {
+        t->prev->next = t->next;
+    } else {
+        trace_head_ = t->next;
+    }
+    if (t->next) {
+        t->next->prev = t->prev;
+    }
+    --trace_count_;
+    TRACE_UNLOCK();
+    hook_free(t);
+}
+
+void * jsdrv_alloc_cat(size_t size_bytes, uint8_t cat) {
+    uint32_t cls = class_of(size_bytes);
+    struct header_s * hdr;
+    uint64_t size;
+    if (cat >= JSDRV_ALLOC_CAT_COUNT) {
+        cat = JSDRV_ALLOC_CAT_OTHER;
+    }
+    if (jsdrv_atomic_load(&trace_enable_)) {
+        cls = CLASS_TRACED;
+        size = TRACE_SIZE + HEADER_SIZE + size_bytes;
+        hdr = traced_alloc(size_bytes);
+    } else if (CLASS_LARGE == cls) {
+        size = size_bytes + HEADER_SIZE;
+        hdr = hook_alloc(size);
+    } else {
+        size = class_size(cls);
+        hdr = block_alloc(cls);
+    }
+    hdr->magic = HEADER_MAGIC;
+    hdr->cls = (uint8_t) cls;
+    hdr->cat = cat;
+    hdr->size = size;
+    cat_add(cat, size);
+    return ((uint8_t *) hdr) + HEADER_SIZE;
+}
+
+void * jsdrv_alloc(size_t size_bytes) {
+    return jsdrv_alloc_cat(size_bytes, JSDRV_ALLOC_CAT_OTHER);
+}
+
+void jsdrv_free(void * ptr) {
+    if (NULL == ptr) {
+        return;
+    }
+    struct header_s * hdr = (struct header_s *) (((uint8_t *) ptr) - HEADER_SIZE);
+    if (HEADER_MAGIC != hdr->magic) {
+        JSDRV_FATAL("jsdrv_free invalid pointer");
+        return;
+    }
+    uint32_t cls = hdr->cls;
+    hdr->magic = 0;  // detect double free
+    cat_sub(hdr->cat, hdr->size);
+    if (CLASS_LARGE == cls) {
+        hook_free(hdr);
+    } else if (CLASS_TRACED == cls) {
+        traced_free(hdr);
+    } else {
+        block_free(cls, hdr);
+    }
+}
+
+void jsdrv_alloc_thread_cache_start(void) {
+    if (NULL == cache_) {
+        struct thread_cache_s * c = hook_alloc(sizeof(struct thread_cache_s));
+        jsdrv_memset(c, 0, sizeof(*c));
+        cache_ = c;
+    }
+}
+
+void jsdrv_alloc_thread_cache_stop(void) {
+    struct thread_cache_s * c = cache_;
+    if (NULL == c) {
+        return;
+    }
+    cache_ = NULL;
+    for (uint32_t cls = 0; cls < JSDRV_ALLOC_CLASS_COUNT; ++cls) {
+        global_push(cls, c->head[cls]);
+    }
+    hook_free(c);
+}
+
+void jsdrv_alloc_stats_get(struct jsdrv_alloc_stats_s * stats) {
+    stats->outstanding = jsdrv_atomic_load(&outstanding_);
+    stats->free_count = 0;
+    LOCK();
+    for (uint32_t cls = 0; cls < JSDRV_ALLOC_CLASS_COUNT; ++cls) {
+        stats->free_count += free_count_[cls];
+    }
+    UNLOCK();
+}
+
+const char * jsdrv_alloc_cat_name(uint32_t cat) {
+    if (cat >= JSDRV_ALLOC_CAT_COUNT) {
+        return NULL;
+    }
+    return CAT_NAMES[cat];
+}
+
+void jsdrv_alloc_cat_stats_get(uint32_t cat, struct jsdrv_alloc_cat_stats_s * stats) {
+    if (cat >= JSDRV_ALLOC_CAT_COUNT) {
+        jsdrv_memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    stats->bytes = u64_load(&cat_bytes_[cat]);
+    stats->count = u64_load(&cat_count_[cat]);
+    stats->peak = u64_load(&cat_peak_[cat]);
+}
+
+void jsdrv_alloc_trace_enable(bool enable) {
+    jsdrv_atomic_store(&trace_enable_, enable ? 1 : 0);
+}
+
+bool jsdrv_alloc_trace_is_enabled(void) {
+    return 0 != jsdrv_atomic_load(&trace_enable_);
+}
+
+int32_t jsdrv_alloc_trace_write(const char * path) {
+    FILE * f = fopen(path, "wb");
+    if (NULL == f) {
+        JSDRV_LOGW("alloc trace write could not open %s", path);
+        return JSDRV_ERROR_IO;
+    }
+    TRACE_LOCK();  // blocks traced allocations while writing
+    fprintf(f, "{\"count\":%" PRIu32 ",\"allocations\":[", trace_count_);
+    for (struct trace_s * t = trace_head_; t; t = t->next) {
+        struct header_s * hdr = (struct header_s *) (((uint8_t *) t) + TRACE_SIZE);
+        fprintf(f, "%s\n{\"category\":\"%s\",\"size\":%" PRIu64 ",\"frames\":[",
+                (t == trace_head_) ? "" : ",", CAT_NAMES[hdr->cat], (uint64_t) t->size_bytes);
+#if BACKTRACE_ENABLE
+        char ** symbols = backtrace_symbols(t->frames, (int) t->frame_count);
+#endif
+        for (uint32_t idx = 0; idx < t->frame_count; ++idx) {
+            const char * sep = idx ? "," : "";
+#if BACKTRACE_ENABLE
+            if (symbols) {
+                fprintf(f, "%s\"", sep);
+                for (const char * c = symbols[idx]; *c; ++c) {
+                    if ((*c >= ' ') && (*c != '"') && (*c != '\\')) {
+                        fputc(*c, f);
+                    }
+                }
+                fputc('"', f);
+                continue;
+            }
+#endif
+            fprintf(f, "%s\"%p\"", sep, t->frames[idx]);
+        }
+#if BACKTRACE_ENABLE
+        free(symbols);
+#endif
+        fprintf(f, "]}");
+    }
+    TRACE_UNLOCK();
+    fprintf(f, "\n]}\n");
+    int32_t rc = (0 == ferror(f)) ? 0 : JSDRV_ERROR_IO;
+    if (fclose(f)) {
+        rc = JSDRV_ERROR_IO;
+    }
+    JSDRV_LOGI("alloc trace write %s: rc=%" PRId32, path, rc);
+    return rc;
+}
+
+int32_t jsdrv_allocator_set(const struct jsdrv_allocator_s * allocator) {
+    if (allocator && (!allocator->alloc || !allocator->free)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    int32_t rv = 0;
+    LOCK();
+    for (uint32_t cls = 0; cls < JSDRV_ALLOC_CLASS_COUNT; ++cls) {
+        while (free_head_[cls]) {
+            struct free_s * b = free_head_[cls];
+            free_head_[cls] = b->next;
+            hook_free(b);
+        }
+        free_count_[cls] = 0;
+    }
+    if (jsdrv_atomic_load(&outstanding_)) {
+        rv = JSDRV_ERROR_BUSY;
+    } else if (allocator) {
+        allocator_ = *allocator;
+    } else {
+        allocator_.alloc = default_alloc;
+        allocator_.free = default_free;
+        allocator_.user_data = NULL;
+    }
+    UNLOCK();
+    return rv;
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/api_timeout.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/pubsub.h"
+#include <string.h>
+
+
+#define HEAP_CAPACITY_INIT (16U)
+
+static inline struct jsdrv_list_s * bucket(struct jsdrv_api_timeouts_s * self, uint32_t hash) {
+    return &self->buckets[hash & (JSDRV_API_TIMEOUT_BUCKETS - 1)];
+}
+
+static inline void heap_set(struct jsdrv_api_timeouts_s * self, uint32_t idx, struct jsdrvp_api_timeout_s * t) {
+    self->heap[idx] = t;
+    t->heap_index = idx;
+}
+
+static void heap_up(struct jsdrv_api_timeouts_s * self, uint32_t idx) {
+    struct jsdrvp_api_timeout_s * t = self->heap[idx];
+    while (idx) {
+        uint32_t parent = (idx - 1) / 2;
+        if (self->heap[parent]->timeout <= t->timeout) {
+            break;
+        }
+        heap_set(self, idx, self->heap[parent]);
+        idx = parent;
+    }
+    heap_set(self, idx, t);
+}
+
+static void heap_down(struct jsdrv_api_timeouts_s * self, uint32_t idx) {
+    struct jsdrvp_api_timeout_s * t = self->heap[idx];
+    while (1) {
+        uint32_t child = 2 * idx + 1;
+        if (child >= self->count) {
+            break;
+        }
+        if (((child + 1) < self->count) && (self->heap[child + 1]->timeout < self->heap[child]->timeout)) {
+            ++child;
+        }
+        if (t->timeout <= self->heap[child]->timeout) {
+            break;
+        }
+        heap_set(self, idx, self->heap[child]);
+        idx = child;
+    }
+    heap_set(self, idx, t);
+}
+
+void jsdrv_api_timeouts_initialize(struct jsdrv_api_timeouts_s * self) {
+    memset(self, 0, sizeof(*self));
+    for (uint32_t idx = 0; idx < JSDRV_API_TIMEOUT_BUCKETS; ++idx) {
+        jsdrv_list_initialize(&self->buckets[idx]);
+    }
+}
+
+void jsdrv_api_timeouts_finalize(struct jsdrv_api_timeouts_s * self) {
+    if (self->heap) {
+        jsdrv_free(self->heap);
+    }
+    jsdrv_api_timeouts_initialize(self);
+}
+
+void jsdrv_api_timeouts_add(struct jsdrv_api_timeouts_s * self, struct jsdrvp_api_timeout_s * timeout) {
+    if (self->count >= self->capacity) {
+        uint32_t capacity = self->capacity ? (2 * self->capacity) : HEAP_CAPACITY_INIT;
+        struct jsdrvp_api_timeout_s ** heap = jsdrv_alloc(capacity * sizeof(*heap));
+        if (self->heap) {
+            memcpy(heap, self->heap, self->count * sizeof(*heap));
+            jsdrv_free(self->heap);
+        }
+        self->heap = heap;
+        self->capacity = capacity;
+    }
+    timeout->topic_hash = jsdrv_pubsub_topic_hash(timeout->topic);
+    jsdrv_list_initialize(&timeout->item);
+    jsdrv_list_add_tail(bucket(self, timeout->topic_hash), &timeout->item);
+    self->heap[self->count] = timeout;
+    heap_up(self, self->count++);
+}
+
+struct jsdrvp_api_timeout_s * jsdrv_api_timeouts_peek(struct jsdrv_api_timeouts_s * self) {
+    return self->count ? self->heap[0] : NULL;
+}
+
+struct jsdrvp_api_timeout_s * jsdrv_api_timeouts_find(struct jsdrv_api_timeouts_s * self, const char * topic) {
+    uint32_t hash = jsdrv_pubsub_topic_hash(topic);
+    struct jsdrv_list_s * item;
+    jsdrv_list_foreach(bucket(self, hash), item) {
+        struct jsdrvp_api_timeout_s * t = JSDRV_CONTAINER_OF(item, struct jsdrvp_api_timeout_s, item);
+        if ((t->topic_hash == hash) && (0 == strcmp(t->topic, topic))) {
+            return t;
+        }
+    }
+    return NULL;
+}
+
+void jsdrv_api_timeouts_remove(struct jsdrv_api_timeouts_s * self, struct jsdrvp_api_timeout_s * timeout) {
+    uint32_t idx = timeout->heap_index;
+    jsdrv_list_remove(&timeout->item);
+    struct jsdrvp_api_timeout_s * last = self->heap[--self->count];
+    if (idx < self->count) {
+        heap_set(self, idx, last);
+        heap_up(self, idx);
+        heap_down(self, last->heap_index);
+    }
+}
@@ -0,0 +1,421 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv/arrow.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/time.h"
+#include "jsdrv_prv/atomic.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/list.h"
+#include "jsdrv_prv/pack.h"
+#include "jsdrv_prv/platform.h"
+#include <string.h>
+
+
+#define COLUMNS_MAX             (6U)
+#define ALIGN64(x)              (((x) + 63U) & ~((size_t) 63U))
+#define NS_PER_SECOND           (1000000000LL)
+
+enum kind_e {
+    KIND_VALUE = 0,     // sample_id, utc, value
+    KIND_SUMMARY = 1,   // sample_id, utc, avg, std, min, max
+};
+
+static const char * const NAMES[2][COLUMNS_MAX] = {
+    {"sample_id", "utc", "value", NULL, NULL, NULL},
+    {"sample_id", "utc", "avg", "std", "min", "max"},
+};
+
+struct source_s {
+    const uint8_t * data;
+    uint8_t kind;
+    uint8_t bits;                   // the source bits per value
+    uint8_t value_size;             // the column bytes per value
+    const char * value_format;
+    uint64_t sample_id;             // for the first row
+    uint64_t incr;                  // the sample_id increment for each row
+    const struct jsdrv_time_map_s * time_map;
+};
+
+struct batch_s {
+    struct jsdrv_list_s item;
+    volatile int32_t refcnt;        // the parent and each unreleased child
+    uint8_t kind;
+    uint8_t value_size;
+    const char * value_format;
+    uint32_t column_count;
+    uint32_t capacity;
+    uint32_t length;
+    uint8_t * columns[COLUMNS_MAX];
+    const void * parent_buffers[1];
+    const void * buffers[COLUMNS_MAX][2];
+    struct ArrowArray children[COLUMNS_MAX];
+    struct ArrowArray * child_ptrs[COLUMNS_MAX];
+};
+
+struct schema_s {
+    struct ArrowSchema children[COLUMNS_MAX];
+    struct ArrowSchema * child_ptrs[COLUMNS_MAX];
+};
+
+struct jsdrv_arrow_batcher_s {
+    uint32_t row_count;
+    uint32_t ready_count;
+    struct batch_s * batch;         // the pending batch or NULL
+    struct jsdrv_list_s ready;
+};
+
+static uint32_t column_size(uint8_t kind, uint8_t value_size, uint32_t column) {
+    if (column < 2) {
+        return 8;
+    }
+    return (KIND_SUMMARY == kind) ? 4 : value_size;
+}
+
+static const char * value_format(uint8_t element_type, uint8_t element_size_bits, uint8_t * value_size) {
+    switch (element_type) {
+        case JSDRV_DATA_TYPE_FLOAT:
+            if (32 == element_size_bits) { *value_size = 4; return "f"; }
+            if (64 == element_size_bits) { *value_size = 8; return "g"; }
+            break;
+        case JSDRV_DATA_TYPE_UINT:
+            switch (element_size_bits) {
+                case 1:  // intentional fall-through
+                case 4:  // intentional fall-through
+                case 8: *value_size = 1; return "C";
+                case 16: *value_size = 2; return "S";
+                case 32: *value_size = 4; return "I";
+                default: break;
+            }
+            break;
+        case JSDRV_DATA_TYPE_INT:
+            switch (element_size_bits) {
+                case 8: *value_size = 1; return "c";
+                case 16: *value_size = 2; return "s";
+                case 32: *value_size = 4; return "i";
+                default: break;
+            }
+            break;
+        default:
+            break;
+    }
+    return NULL;
+}
+
+static void batch_unref(struct batch_s * b) {
+    if (0 == jsdrv_atomic_add(&b->refcnt, -1)) {
+        jsdrv_free(b);
+    }
+}
+
+static void batch_child_release(struct ArrowArray * array) {
+    struct batch_s * b = (struct batch_s *) array->private_data;
+    array->release = NULL;
+    batch_unref(b);
+}
+
+static void batch_release(struct ArrowArray * array) {
+    struct batch_s * b = (struct batch_s *) array->private_data;
+    for (uint32_t idx = 0; idx < b->column_count; ++idx) {
+        struct ArrowArray * child = b->child_ptrs[idx];
+        if (NULL != child->release) {  // not moved by the consumer
+            child->release(child);
+        }
+    }
+    array->release = NULL;
+    batch_unref(b);
+}
+
+static struct batch_s * batch_alloc(uint32_t capacity, const struct source_s * src) {
+    uint32_t column_count = (KIND_SUMMARY == src->kind) ? 6 : 3;
+    size_t sz = sizeof(struct batch_s) + 63;
+    for (uint32_t idx = 0; idx < column_count; ++idx) {
+        sz += ALIGN64((size_t) capacity * column_size(src->kind, src->value_size, idx));
+    }
+    struct batch_s * b = jsdrv_alloc(sz);
+    memset(b, 0, sizeof(*b));
+    jsdrv_list_initialize(&b->item);
+    b->kind = src->kind;
+    b->value_size = src->value_size;
+    b->value_format = src->value_format;
+    b->column_count = column_count;
+    b->capacity = capacity;
+    uint8_t * p = (uint8_t *) ALIGN64((uintptr_t) (b + 1));
+    for (uint32_t idx = 0; idx < column_count; ++idx) {
+        b->columns[idx] = p;
+        p += ALIGN64((size_t) capacity * column_size(src->kind, src->value_size, idx));
+    }
+    return b;
+}
+
+static bool batch_matches(const struct batch_s * b, const struct source_s * src) {
+    return (b->kind == src->kind) && (0 == strcmp(b->value_format, src->value_format));
+}
+
+static void batch_complete(struct jsdrv_arrow_batcher_s * self) {
+    if (NULL != self->batch) {
+        jsdrv_list_add_tail(&self->ready, &self->batch->item);
+        self->batch = NULL;
+        ++self->ready_count;
+    }
+}
+
+static int64_t utc_ns(const struct jsdrv_time_map_s * time_map, uint64_t sample_id) {
+    int64_t t = jsdrv_time_from_counter(time_map, sample_id);
+    return JSDRV_TIME_TO_NANOSECONDS(t) + JSDRV_TIME_EPOCH_UNIX_OFFSET_SECONDS * NS_PER_SECOND;
+}
+
+static void unpack_bits(uint8_t * y, const uint8_t * x, uint64_t offset, uint32_t n, uint8_t bits) {
+    if (4 == bits) {
+        if (0 == (offset & 1)) {
+            jsdrv_unpack_u4(y, x + (offset >> 1), n);
+        } else {
+            for (uint32_t k = 0; k < n; ++k) {
+                uint64_t i = offset + k;
+                y[k] = (x[i >> 1] >> ((i & 1) * 4)) & 0x0f;
+            }
+        }
+    } else if (0 == (offset & 7)) {
+        jsdrv_unpack_u1(y, x + (offset >> 3), n);
+    } else {
+        for (uint32_t k = 0; k < n; ++k) {
+            uint64_t i = offset + k;
+            y[k] = (x[i >> 3] >> (i & 7)) & 1;
+        }
+    }
+}
+
+// Write n rows starting at source row offset to the end of the batch.
+static void batch_write(struct batch_s * b, const struct source_s * src, uint64_t offset, uint32_t n) {
+    uint32_t row = b->length;
+    uint64_t * sample_id = ((uint64_t *) b->columns[0]) + row;
+    int64_t * utc = ((int64_t *) b->columns[1]) + row;
+    uint64_t s0 = src->sample_id + offset * src->incr;
+    int64_t t0 = utc_ns(src->time_map, s0);
+    double dt = 0.0;
+    if (src->time_map->counter_rate > 0.0) {
+        dt = ((double) NS_PER_SECOND) * ((double) src->incr) / src->time_map->counter_rate;
+    }
+    for (uint32_t k = 0; k < n; ++k) {
+        sample_id[k] = s0 + k * src->incr;
+        utc[k] = t0 + (int64_t) (dt * k);
+    }
+
+    if (KIND_SUMMARY == src->kind) {
+        const struct jsdrv_summary_entry_s * e = ((const struct jsdrv_summary_entry_s *) src->data) + offset;
+        float * avg = ((float *) b->columns[2]) + row;
+        float * std = ((float *) b->columns[3]) + row;
+        float * v_min = ((float *) b->columns[4]) + row;
+        float * v_max = ((float *) b->columns[5]) + row;
+        for (uint32_t k = 0; k < n; ++k) {
+            avg[k] = e[k].avg;
+            std[k] = e[k].std;
+            v_min[k] = e[k].min;
+            v_max[k] = e[k].max;
+        }
+    } else if (src->bits < 8) {
+        unpack_bits(b->columns[2] + row, src->data, offset, n, src->bits);
+    } else {
+        memcpy(b->columns[2] + (size_t) row * src->value_size, src->data + offset * src->value_size,
+               (size_t) n * src->value_size);
+    }
+    b->length += n;
+}
+
+static void rows_add(struct jsdrv_arrow_batcher_s * self, const struct source_s * src, uint64_t length) {
+    uint64_t offset = 0;
+    if ((NULL != self->batch) && !batch_matches(self->batch, src)) {
+        batch_complete(self);
+    }
+    while (offset < length) {
+        if (NULL == self->batch) {
+            self->batch = batch_alloc(self->row_count, src);
+        }
+        struct batch_s * b = self->batch;
+        uint64_t n = length - offset;
+        if (n > (b->capacity - b->length)) {
+            n = b->capacity - b->length;
+        }
+        batch_write(b, src, offset, (uint32_t) n);
+        offset += n;
+        if (b->length >= b->capacity) {
+            batch_complete(self);
+        }
+    }
+}
+
+struct jsdrv_arrow_batcher_s * jsdrv_arrow_batcher_alloc(uint32_t row_count) {
+    if ((0 == row_count) || (row_count > JSDRV_ARROW_ROWS_MAX)) {
+        return NULL;
+    }
+    struct jsdrv_arrow_batcher_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_arrow_batcher_s));
+    self->row_count = row_count;
+    jsdrv_list_initialize(&self->ready);
+    return self;
+}
+
+void jsdrv_arrow_batcher_free(struct jsdrv_arrow_batcher_s * self) {
+    if (NULL == self) {
+        return;
+    }
+    batch_complete(self);
+    while (1) {
+        struct jsdrv_list_s * item = jsdrv_list_remove_head(&self->ready);
+        if (NULL == item) {
+            break;
+        }
+        jsdrv_free(JSDRV_CONTAINER_OF(item, struct batch_s, item));
+    }
+    jsdrv_free(self);
+}
+
+int32_t jsdrv_arrow_batcher_add_stream(struct jsdrv_arrow_batcher_s * self,
+                                       const struct jsdrv_stream_signal_s * stream) {
+    struct source_s src;
+    memset(&src, 0, sizeof(src));
+    src.value_format = value_format(stream->element_type, stream->element_size_bits, &src.value_size);
+    if (NULL == src.value_format) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    src.data = stream->data;
+    src.kind = KIND_VALUE;
+    src.bits = stream->element_size_bits;
+    src.sample_id = stream->sample_id;
+    src.incr = stream->decimate_factor ? stream->decimate_factor : 1;
+    src.time_map = &stream->time_map;
+    rows_add(self, &src, stream->element_count);
+    return 0;
+}
+
+int32_t jsdrv_arrow_batcher_add_buffer_rsp(struct jsdrv_arrow_batcher_s * self,
+                                           const struct jsdrv_buffer_response_s * rsp) {
+    const struct jsdrv_buffer_info_s * info = &rsp->info;
+    const struct jsdrv_time_range_samples_s * r = &info->time_range_samples;
+    struct source_s src;
+    memset(&src, 0, sizeof(src));
+    src.data = (const uint8_t *) rsp->data;
+    src.sample_id = r->start;
+    src.incr = 1;
+    src.time_map = &info->time_map;
+    if (JSDRV_BUFFER_RESPONSE_SUMMARY == rsp->response_type) {
+        src.kind = KIND_SUMMARY;
+        src.value_format = "f";
+        src.value_size = 4;
+        src.bits = 32;
+        if (r->length && (r->end >= r->start)) {
+            src.incr = (r->end - r->start + 1) / r->length;
+            if (0 == src.incr) {
+                src.incr = 1;
+            }
+        }
+    } else if (JSDRV_BUFFER_RESPONSE_SAMPLES == rsp->response_type) {
+        src.kind = KIND_VALUE;
+        src.value_format = value_format(info->element_type, info->element_size_bits, &src.value_size);
+        src.bits = info->element_size_bits;
+    } else {
+        return JSDRV_ERROR_NOT_SUPPORTED;
+    }
+    if (0 == r->length) {
+        return 0;
+    } else if (NULL == src.value_format) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    rows_add(self, &src, r->length);
+    return 0;
+}
+
+uint32_t jsdrv_arrow_batcher_ready(struct jsdrv_arrow_batcher_s * self) {
+    return self->ready_count;
+}
+
+static void schema_child_release(struct ArrowSchema * schema) {
+    schema->release = NULL;  // owned by the parent
+}
+
+static void schema_release(struct ArrowSchema * schema) {
+    struct schema_s * s = (struct schema_s *) schema->private_data;
+    for (int64_t idx = 0; idx < schema->n_children; ++idx) {
+        struct ArrowSchema * child = s->child_ptrs[idx];
+        if (NULL != child->release) {
+            child->release(child);
+        }
+    }
+    schema->release = NULL;
+    jsdrv_free(s);
+}
+
+static void schema_export(const struct batch_s * b, struct ArrowSchema * schema) {
+    struct schema_s * s = jsdrv_alloc_clr(sizeof(struct schema_s));
+    for (uint32_t idx = 0; idx < b->column_count; ++idx) {
+        struct ArrowSchema * c = &s->children[idx];
+        s->child_ptrs[idx] = c;
+        switch (idx) {
+            case 0: c->format = "L"; break;
+            case 1: c->format = "tsn:UTC"; break;
+            default: c->format = b->value_format; break;
+        }
+        c->name = NAMES[b->kind][idx];
+        c->release = schema_child_release;
+    }
+    memset(schema, 0, sizeof(*schema));
+    schema->format = "+s";
+    schema->name = "";
+    schema->n_children = b->column_count;
+    schema->children = s->child_ptrs;
+    schema->release = schema_release;
+    schema->private_data = s;
+}
+
+static void array_export(struct batch_s * b, struct ArrowArray * array) {
+    b->refcnt = (int32_t) (1 + b->column_count);
+    b->parent_buffers[0] = NULL;  // no validity bitmap
+    for (uint32_t idx = 0; idx < b->column_count; ++idx) {
+        struct ArrowArray * c = &b->children[idx];
+        b->child_ptrs[idx] = c;
+        b->buffers[idx][0] = NULL;
+        b->buffers[idx][1] = b->columns[idx];
+        memset(c, 0, sizeof(*c));
+        c->length = b->length;
+        c->n_buffers = 2;
+        c->buffers = b->buffers[idx];
+        c->release = batch_child_release;
+        c->private_data = b;
+    }
+    memset(array, 0, sizeof(*array));
+    array->length = b->length;
+    array->n_buffers = 1;
+    array->buffers = b->parent_buffers;
+    array->n_children = b->column_count;
+    array->children = b->child_ptrs;
+    array->release = batch_release;
+    array->private_data = b;
+}
+
+int32_t jsdrv_arrow_batcher_pop(struct jsdrv_arrow_batcher_s * self,
+                                struct ArrowSchema * schema, struct ArrowArray * array, bool partial) {
+    if (partial && (0 == self->ready_count) && (NULL != self->batch) && self->batch->length) {
+        batch_complete(self);
+    }
+    struct jsdrv_list_s * item = jsdrv_list_remove_head(&self->ready);
+    if (NULL == item) {
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    --self->ready_count;
+    struct batch_s * b = JSDRV_CONTAINER_OF(item, struct batch_s, item);
+    schema_export(b, schema);
+    array_export(b, array);
+    return 0;
+}
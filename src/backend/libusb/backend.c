@@ -21,33 +21,56 @@
  */
 
 #define JSDRV_LOG_LEVEL JSDRV_LOG_LEVEL_ALL
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // pthread_setaffinity_np
+#endif
 #include "jsdrv.h"
 #include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/alloc.h"
 #include "jsdrv_prv/assert.h"
+#include "jsdrv_prv/atomic.h"
 #include "jsdrv_prv/backend.h"
 #include "jsdrv_prv/cdef.h"
 #include "jsdrv_prv/devices.h"
 #include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/latency.h"
 #include "jsdrv_prv/list.h"
 #include "jsdrv_prv/log.h"
 #include "jsdrv_prv/msg_queue.h"
+#include "jsdrv_prv/perf.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv_prv/trace.h"
+#include "jsdrv_prv/usb_depth.h"
+#include "jsdrv_prv/usb_trace.h"
 #include "jsdrv/error_code.h"
 #include "jsdrv/cstr.h"
 #include "tinyprintf.h"
 #include <stdio.h>
+#include <errno.h>
 #include <inttypes.h>
 #include <pthread.h>
 #include "libusb.h"
 
+#if defined(__linux__)
+#include <sys/epoll.h>
+#define EVLOOP_EPOLL 1
+#elif defined(__APPLE__)
+#include <sys/event.h>
+#define EVLOOP_KQUEUE 1
+#endif
+
 
 #define CTRL_TIMEOUT_MS                 (1000U)
 #define DEVICES_MAX                     (127U)  // Setting too large breaks "select".  See https://forum.joulescope.com/t/joulescope-breaking-pyserial-on-macos/552
 #define BULK_OUT_TIMEOUT_MS             (250U)
 #define BULK_IN_TIMEOUT_MS              (0U)    // no timeout
-#define BULK_IN_FRAME_LENGTH            (512U)
-#define BULK_IN_TRANSFER_SIZE           (64U * BULK_IN_FRAME_LENGTH)
-#define BULK_IN_TRANSFER_OUTSTANDING    (4U)
+#define TRANSFER_BUFFER_SIZE_MIN        (JSDRV_USBBK_BULK_IN_SIZE_DEFAULT)  // also holds control transfers
 #define ENDPOINT_COUNT                  (256U)
+#define BACKEND_POLL_TIMEOUT_MS         (HOTPLUG_RESCAN_INTERVAL_MS)  // upper bound, see backend_timeout_ms
+#define EVLOOP_EVENTS_MAX               (64U)
+#define WORKERS_MAX                     (16U)
+#define HOTPLUG_EVENTS_MAX              (64U)   // pending events before falling back to a rescan
+#define HOTPLUG_RESCAN_INTERVAL_MS      (10000U)
 
 
 enum device_mark_e {
@@ -63,6 +86,17 @@ enum device_mode_e {
     DEVICE_MODE_CLOSING,
 };
 
+enum evloop_source_e {  // event source tag, upper 32 bits
+    EVLOOP_SRC_BACKEND = 1, // backend command queue
+    EVLOOP_SRC_HOTPLUG,     // hotplug event
+    EVLOOP_SRC_LIBUSB,      // libusb file descriptor
+    EVLOOP_SRC_DEVICE,      // device command queue, lower 32 bits is the device index
+};
+
+#define EVLOOP_TAG(src_, idx_)  ((((uint64_t) (src_)) << 32) | ((uint64_t) (idx_)))
+#define EVLOOP_TAG_SRC(tag_)    ((uint32_t) ((tag_) >> 32))
+#define EVLOOP_TAG_IDX(tag_)    ((uint32_t) ((tag_) & 0xffffffffU))
+
 enum endpoint_mode_e {
     EP_MODE_OFF = 0,
     EP_MODE_BULK_OUT = 0x01,
@@ -70,14 +104,20 @@ enum endpoint_mode_e {
 };
 
 struct dev_s;
+struct worker_s;
 struct backend_s;
 
 struct transfer_s {
     struct libusb_transfer * transfer;      // user_data points to the transfer_s instance
     struct jsdrvp_msg_s * msg;              // not for BULK IN
+    struct jsdrvp_msg_s * msg_in;           // BULK IN loan message, owned by this transfer
     struct dev_s * device;
-    uint8_t buffer[BULK_IN_TRANSFER_SIZE];  // OUT uses msg->value.value.bin
     struct jsdrv_list_s item;
+    int64_t loan_time;                      // BULK IN loan start, for JSDRV_PERF_LOAN
+    libusb_device_handle * dev_mem;         // handle that owns buffer device memory, or NULL
+    uint8_t * buffer;                       // storage or device memory
+    uint32_t buffer_size;
+    uint8_t storage[];                      // OUT uses msg->value.value.bin, must be last
 };
 
 struct dev_s {
@@ -85,12 +125,20 @@ struct dev_s {
     libusb_device * usb_device;
     libusb_device_handle * handle;
     struct backend_s * backend;
+    struct worker_s * worker;  // owns this device slot
     const struct device_type_s * device_type;
     struct libusb_device_descriptor device_descriptor;
     char serial_number[JSDRV_TOPIC_LENGTH_MAX];
     uint8_t mode;  // device_mode_e
     uint8_t mark;
     uint8_t endpoint_mode[ENDPOINT_COUNT];
+    uint32_t bulk_in_depth;  // outstanding bulk in transfers per endpoint
+    uint32_t bulk_in_size;   // bytes per bulk in transfer
+    uint32_t bulk_in_spare;  // preallocated bulk in transfers beyond the depth
+    uint32_t bulk_in_active; // submitted bulk in transfers that have not completed
+    struct jsdrv_usb_depth_s bulk_in_adapt;  // adjusts bulk_in_depth when adaptive
+    bool dev_mem;            // try libusb_dev_mem_alloc() for bulk in buffers
+    struct jsdrv_usb_trace_s * trace;  // JSDRV_ARG_USB_TRACE, owned by the worker thread
 
     struct jsdrv_list_s transfers_pending;
     struct jsdrv_list_s transfers_free;
@@ -98,31 +146,111 @@ struct dev_s {
     struct jsdrv_list_s item;
 };
 
-struct backend_s {
-    struct jsdrvbk_s backend;
-    struct jsdrv_context_s * context;
+struct hotplug_event_s {
+    libusb_device * usb_device;  // referenced while pending
+    bool arrived;                // true for arrived, false for left
+};
+
+/**
+ * @brief A backend event thread with its own libusb context.
+ *
+ * Worker k owns the device slots i where (i % worker_count) == k,
+ * so device state is never shared between threads.  Worker 0 also
+ * handles the backend command queue.
+ */
+struct worker_s {
+    struct backend_s * backend;
+    uint32_t index;
+    int cpu;  // CPU affinity, -1 for none
 
     libusb_context * ctx;
     libusb_hotplug_callback_handle hotplug_callback_handle;
 
-    struct dev_s devices[DEVICES_MAX];
     struct jsdrv_list_s devices_free;
     struct jsdrv_list_s devices_active;
 
     jsdrv_os_event_t hotplug_event;
-    volatile bool do_exit;
+    struct hotplug_event_s hotplug_events[HOTPLUG_EVENTS_MAX];  // Joulescope events from on_hotplug
+    uint32_t hotplug_count;
+    bool hotplug_rescan;      // hotplug_events overflowed
+    uint32_t scan_time_ms;    // jsdrv_time_ms_u32() of the last full scan
+    int evloop_fd;  // epoll or kqueue descriptor, -1 when using poll
     pthread_t thread_id;
 };
 
-static struct transfer_s * transfer_alloc(struct dev_s * d) {
+struct backend_s {
+    struct jsdrvbk_s backend;
+    struct jsdrv_context_s * context;
+    char * trace_dir;  // JSDRV_ARG_USB_TRACE or NULL
+
+    struct dev_s devices[DEVICES_MAX];
+    struct worker_s workers[WORKERS_MAX];
+    uint32_t worker_count;
+    volatile int32_t init_pending;  // workers still initializing
+    volatile int32_t init_status;
+    volatile bool do_exit;
+};
+
+static void transfer_destroy(struct transfer_s * t) {
+    if (NULL != t->transfer) {
+        libusb_free_transfer(t->transfer);
+        t->transfer = NULL;
+    }
+    if (NULL != t->msg_in) {
+        jsdrvp_msg_free(t->device->backend->context, t->msg_in);
+        t->msg_in = NULL;
+    }
+    if (NULL != t->dev_mem) {
+        // The handle may already be closed for a late loan return.  Linux,
+        // the only backend with device memory, only unmaps and ignores the handle.
+        libusb_device_handle * h = (t->dev_mem == t->device->handle) ? t->dev_mem : NULL;
+        libusb_dev_mem_free(h, t->buffer, t->buffer_size);
+        t->dev_mem = NULL;
+    }
+    t->device = NULL;
+    jsdrv_free(t);
+}
+
+static struct transfer_s * transfer_new(struct dev_s * d, uint32_t buffer_size, bool dev_mem) {
     struct transfer_s * t;
+    uint8_t * mem = NULL;
+    if (dev_mem && d->dev_mem && (NULL != d->handle)) {
+        mem = libusb_dev_mem_alloc(d->handle, buffer_size);
+        if (NULL == mem) {
+            // unsupported platform or usbfs_memory_mb exhausted, do not retry until reopen
+            JSDRV_LOGI("device memory unavailable(%s), use heap bulk in buffers", d->ll_device.prefix);
+            d->dev_mem = false;
+        }
+    }
+    if (NULL == mem) {
+        t = jsdrv_alloc_clr_cat(sizeof(struct transfer_s) + buffer_size, JSDRV_ALLOC_CAT_XFER);
+        t->buffer = t->storage;
+    } else {
+        t = jsdrv_alloc_clr_cat(sizeof(struct transfer_s), JSDRV_ALLOC_CAT_XFER);
+        t->dev_mem = d->handle;
+        t->buffer = mem;
+    }
+    jsdrv_list_initialize(&t->item);
+    t->transfer = libusb_alloc_transfer(0);
+    t->buffer_size = buffer_size;
+    return t;
+}
+
+static struct transfer_s * transfer_alloc(struct dev_s * d, uint32_t buffer_size, bool dev_mem) {
+    struct transfer_s * t = NULL;
+    if (buffer_size < TRANSFER_BUFFER_SIZE_MIN) {
+        buffer_size = TRANSFER_BUFFER_SIZE_MIN;
+    }
     struct jsdrv_list_s * item = jsdrv_list_remove_head(&d->transfers_free);
     if (NULL != item) {
         t = JSDRV_CONTAINER_OF(item, struct transfer_s, item);
-    } else {
-        t = jsdrv_alloc_clr(sizeof(struct transfer_s));
-        jsdrv_list_initialize(&t->item);
-        t->transfer = libusb_alloc_transfer(0);
+        if (t->buffer_size < buffer_size) {
+            transfer_destroy(t);  // too small, bulk in size increased
+            t = NULL;
+        }
+    }
+    if (NULL == t) {
+        t = transfer_new(d, buffer_size, dev_mem);
     }
     t->device = d;
     jsdrv_list_add_tail(&d->transfers_pending, &t->item);
@@ -135,32 +263,64 @@ static void transfer_free(struct transfer_s * t) {
     }
     t->msg = NULL;  // do not free, must do externally.
     jsdrv_list_remove(&t->item);
-    if (NULL != t->device->handle) {
-        jsdrv_list_add_tail(&t->device->transfers_free, &t->item);
+    struct dev_s * d = t->device;
+    if ((NULL != d->handle) && ((NULL == t->dev_mem) || (t->dev_mem == d->handle))) {
+        jsdrv_list_add_tail(&d->transfers_free, &t->item);
     } else {
-        if (NULL != t->transfer) {
-            libusb_free_transfer(t->transfer);
-            t->transfer = NULL;
+        transfer_destroy(t);  // closed, or device memory from a previous handle
+    }
+}
+
+// Release free transfers before libusb_close(), which invalidates device memory.
+static void transfers_free_destroy(struct dev_s * d) {
+    struct jsdrv_list_s * item;
+    while (NULL != (item = jsdrv_list_remove_head(&d->transfers_free))) {
+        transfer_destroy(JSDRV_CONTAINER_OF(item, struct transfer_s, item));
+    }
+}
+
+static bool worker_owns(struct worker_s * w, libusb_device * usb_device) {
+    // physical port is stable across re-enumeration, unlike the address
+    uint32_t key = (((uint32_t) libusb_get_bus_number(usb_device)) << 8) | libusb_get_port_number(usb_device);
+    return (key % w->backend->worker_count) == w->index;
+}
+
+static const struct device_type_s * device_type_find(const struct libusb_device_descriptor * descriptor) {
+    for (const struct device_type_s * dt = device_types; dt->device_type; ++dt) {
+        if ((dt->vendor_id == descriptor->idVendor) && (dt->product_id == descriptor->idProduct)) {
+            return dt;
         }
-        t->device = NULL;
-        jsdrv_free(t);
     }
+    return NULL;
 }
 
 static int on_hotplug(libusb_context *ctx, libusb_device *device, libusb_hotplug_event event, void *user_data) {
     (void) ctx;
-    JSDRV_LOGI("hotplug %p: inserted=%d, remove=%d",
-               device,
-               (event & LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED) ? 1 : 0,
-               (event & LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT) ? 1 : 0);
-    struct backend_s * s = (struct backend_s *) user_data;
-    jsdrv_os_event_signal(s->hotplug_event);
+    struct worker_s * w = (struct worker_s *) user_data;
+    struct libusb_device_descriptor descriptor;
+    // libusb caches the device descriptor, so this is safe for left devices, too
+    if (libusb_get_device_descriptor(device, &descriptor) || !device_type_find(&descriptor)) {
+        return 0;  // not a Joulescope, ignore
+    }
+    if (!worker_owns(w, device)) {
+        return 0;  // served by another worker
+    }
+    bool arrived = (event & LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED) ? true : false;
+    JSDRV_LOGI("hotplug %p: %s", device, arrived ? "arrived" : "left");
+    if (w->hotplug_count >= HOTPLUG_EVENTS_MAX) {
+        w->hotplug_rescan = true;
+    } else {
+        struct hotplug_event_s * e = &w->hotplug_events[w->hotplug_count++];
+        e->usb_device = libusb_ref_device(device);
+        e->arrived = arrived;
+    }
+    jsdrv_os_event_signal(w->hotplug_event);
     return 0;
 }
 
-static struct dev_s * device_lookup_by_usb_device(struct backend_s * s, libusb_device * usb_device) {
+static struct dev_s * device_lookup_by_usb_device(struct worker_s * w, libusb_device * usb_device) {
     struct jsdrv_list_s * item;
-    jsdrv_list_foreach(&s->devices_active, item) {
+    jsdrv_list_foreach(&w->devices_active, item) {
         struct dev_s * d = JSDRV_CONTAINER_OF(item, struct dev_s, item);
         if (d->usb_device == usb_device) {
             return d;
@@ -180,9 +340,26 @@ static void device_add_announce(struct backend_s * s, struct dev_s * d) {
     jsdrvp_backend_send(s->context, msg);
 }
 
+static void trace_close(struct dev_s * d) {
+    if (NULL != d->trace) {
+        jsdrv_usb_trace_close(d->trace);
+        d->trace = NULL;
+    }
+}
+
+static void trace_open(struct dev_s * d) {
+    char path[1024];
+    const char * dir = d->backend->trace_dir;
+    trace_close(d);
+    if ((NULL != dir) && (0 == jsdrv_usb_trace_path(dir, d->ll_device.prefix, path, sizeof(path)))) {
+        d->trace = jsdrv_usb_trace_open(path, d->ll_device.prefix);
+    }
+}
+
 static void device_close(struct dev_s * d) {
     struct jsdrv_list_s * item;
     struct transfer_s * t;
+    trace_close(d);
     if (d->handle && (d->mode == DEVICE_MODE_OPEN)) {
         JSDRV_LOGI("device_close(%s)", d->ll_device.prefix);
         jsdrv_list_foreach_reverse(&d->transfers_pending, item) {
@@ -204,6 +381,7 @@ static int32_t device_open(struct dev_s * d) {
     int rc;
     device_close(d);
     JSDRV_LOGI("device_open(%s)", d->ll_device.prefix);
+    d->dev_mem = true;
     rc = libusb_open(d->usb_device, &d->handle);
     if (rc) {
         if (rc == LIBUSB_ERROR_ACCESS) {
@@ -230,6 +408,7 @@ static int32_t device_open(struct dev_s * d) {
         return (int32_t) rc;
     }
     d->mode = DEVICE_MODE_OPEN;
+    trace_open(d);
     return (int32_t) rc;
 }
 
@@ -246,7 +425,7 @@ static const char * transfer_status_to_str(int32_t status) {
     }
 }
 
-static void submit_transfer(struct transfer_s * t) {
+static int submit_transfer(struct transfer_s * t) {
     int rc = libusb_submit_transfer(t->transfer);
     if (rc) {
         JSDRV_LOGW("libusb_submit_transfer returned %d", rc);
@@ -261,6 +440,7 @@ static void submit_transfer(struct transfer_s * t) {
         }
         transfer_free(t);
     }
+    return rc;
 }
 
 static void device_rsp(struct dev_s * d, struct jsdrvp_msg_s * msg) {
@@ -287,12 +467,14 @@ static void on_bulk_out_done(struct libusb_transfer * transfer) {
         }
         JSDRV_LOGW("bulk out returned %d %s", transfer->status, transfer_status_to_str(transfer->status));
     }
+    jsdrv_usb_trace_write(t->device->trace, JSDRV_USB_TRACE_BULK_OUT, transfer->endpoint, 0, rc,
+                          t->msg->payload.bin, t->msg->value.size);
     t->msg->value = jsdrv_union_i32(rc);
     device_rsp_transfer(t);
 }
 
 static void bulk_out_send(struct dev_s * d, struct jsdrvp_msg_s * msg) {
-    struct transfer_s * t = transfer_alloc(d);
+    struct transfer_s * t = transfer_alloc(d, 0, false);
     t->msg = msg;
     JSDRV_LOGI("bulk_out_send(%s) %d bytes", d->ll_device.prefix, (int) msg->value.size);
     uint8_t ep = msg->extra.bkusb_stream.endpoint;
@@ -317,11 +499,13 @@ static void on_ctrl_in_done(struct libusb_transfer * transfer) {
         t->msg->value = jsdrv_union_bin(t->msg->payload.bin, transfer->actual_length);
     }
     t->msg->extra.bkusb_ctrl.status = rc;
+    jsdrv_usb_trace_write(t->device->trace, JSDRV_USB_TRACE_CTRL_IN, 0, t->msg->extra.bkusb_ctrl.setup.u64, rc,
+                          t->buffer + 8, rc ? 0 : (uint32_t) transfer->actual_length);
     device_rsp_transfer(t);
 }
 
 static void ctrl_in_start(struct dev_s * d, struct jsdrvp_msg_s * msg) {
-    struct transfer_s * t = transfer_alloc(d);
+    struct transfer_s * t = transfer_alloc(d, 0, false);
     t->msg = msg;
     JSDRV_LOGD3("ctrl_in_start(%s)", d->ll_device.prefix);
     uint64_t * setup = (uint64_t * ) t->buffer;
@@ -343,11 +527,13 @@ static void on_ctrl_out_done(struct libusb_transfer * transfer) {
         }
     }
     t->msg->extra.bkusb_ctrl.status = rc;
+    jsdrv_usb_trace_write(t->device->trace, JSDRV_USB_TRACE_CTRL_OUT, 0, t->msg->extra.bkusb_ctrl.setup.u64, rc,
+                          t->buffer + 8, t->msg->value.size);
     device_rsp_transfer(t);
 }
 
 static void ctrl_out_start(struct dev_s * d, struct jsdrvp_msg_s * msg) {
-    struct transfer_s * t = transfer_alloc(d);
+    struct transfer_s * t = transfer_alloc(d, 0, false);
     t->msg = msg;
     JSDRV_LOGD3("ctrl_out_start(%s) %d bytes", d->ll_device.prefix, (int) msg->value.size);
     uint64_t * setup = (uint64_t * ) t->buffer;
@@ -366,6 +552,31 @@ static void ctrl_out_start(struct dev_s * d, struct jsdrvp_msg_s * msg) {
 
 static void bulk_in_start(struct dev_s * d, uint8_t pipe_id);
 
+// Submit bulk in transfers until bulk_in_depth are outstanding.
+static void bulk_in_fill(struct dev_s * d, uint8_t pipe_id) {
+    uint32_t active = d->bulk_in_active;
+    while (d->bulk_in_active < d->bulk_in_depth) {
+        bulk_in_start(d, pipe_id);
+        if (d->bulk_in_active == active) {
+            break;  // not started
+        }
+        active = d->bulk_in_active;
+    }
+}
+
+static void bulk_in_adapt(struct dev_s * d, bool pressure) {
+    if (!jsdrv_usb_depth_is_adaptive(&d->bulk_in_adapt)) {
+        return;
+    }
+    int64_t now = jsdrv_time_monotonic();
+    uint32_t depth = pressure ? jsdrv_usb_depth_pressure(&d->bulk_in_adapt, now)
+                              : jsdrv_usb_depth_update(&d->bulk_in_adapt, now);
+    if (depth != d->bulk_in_depth) {
+        JSDRV_LOGI("bulk_in_depth(%s) %" PRIu32 " -> %" PRIu32, d->ll_device.prefix, d->bulk_in_depth, depth);
+        d->bulk_in_depth = depth;
+    }
+}
+
 static void on_bulk_in_done(struct libusb_transfer * transfer) {
     struct transfer_s *t = (struct transfer_s *) transfer->user_data;
     struct dev_s * d = t->device;
@@ -373,23 +584,45 @@ static void on_bulk_in_done(struct libusb_transfer * transfer) {
     struct jsdrvp_msg_s * m;
     JSDRV_LOGD3("bulk_in_done(%s) status=%d, length=%d",
                 d->ll_device.prefix, transfer->status, t->transfer->actual_length);
+    if (d->bulk_in_active) {
+        --d->bulk_in_active;
+    }
     switch (transfer->status) {
         case LIBUSB_TRANSFER_COMPLETED:
-            bulk_in_start(t->device, pipe_id);
+            // pressure when the pipeline ran dry or the upper layer falls behind
+            bulk_in_adapt(d, (0 == d->bulk_in_active)
+                || (msg_queue_depth(d->ll_device.rsp_q, MSG_QUEUE_LANE_DATA) >= d->bulk_in_depth));
+            bulk_in_fill(d, pipe_id);
             if (0 == t->transfer->actual_length) {
                 JSDRV_LOGW("zero length bulk in transfer");
                 transfer_free(t);
             } else {
                 jsdrv_list_remove(&t->item); // not pending or free, temporary loan to upper layer
-                m = jsdrvp_msg_alloc(t->device->backend->context);
-                jsdrv_cstr_copy(m->topic, JSDRV_USBBK_MSG_STREAM_IN_DATA, sizeof(m->topic));
+                m = t->msg_in;
+                if (NULL == m) {
+                    // allocate once, then reuse for each completion of this transfer
+                    m = jsdrvp_msg_alloc(t->device->backend->context);
+                    jsdrv_cstr_copy(m->topic, JSDRV_USBBK_MSG_STREAM_IN_DATA, sizeof(m->topic));
+                    t->msg_in = m;
+                }
                 m->value = jsdrv_union_bin(t->buffer, t->transfer->actual_length);
                 m->extra.bkusb_stream.endpoint = t->transfer->endpoint;
+                m->extra.bkusb_stream.transfer_depth = d->bulk_in_depth;
+                m->extra.bkusb_stream.transfer_skip = 0;
+                m->extra.bkusb_stream.owner = t;
+                JSDRV_LATENCY_STAMP(m->latency.usb);
+                jsdrv_usb_trace_write(d->trace, JSDRV_USB_TRACE_BULK_IN, t->transfer->endpoint, 0, 0,
+                                      t->buffer, (uint32_t) t->transfer->actual_length);
+                JSDRV_PERF_ADD(JSDRV_PERF_USB_XFER, 1);
+                JSDRV_PERF_ADD(JSDRV_PERF_USB_RX, (uint64_t) t->transfer->actual_length);
+#if JSDRV_PERF_ENABLE
+                t->loan_time = jsdrv_time_utc();
+#endif
                 device_rsp(d, m);
             }
             break;
         case LIBUSB_TRANSFER_TIMED_OUT:
-            bulk_in_start(t->device, pipe_id);
+            bulk_in_fill(d, pipe_id);
             transfer_free(t);
             break;
         case LIBUSB_TRANSFER_CANCELLED:
@@ -413,25 +646,42 @@ static void bulk_in_start(struct dev_s * d, uint8_t pipe_id) {
     if (d->endpoint_mode[pipe_id] != EP_MODE_BULK_IN) {
         return;
     }
-    struct transfer_s * t = transfer_alloc(d);
+    struct transfer_s * t = transfer_alloc(d, d->bulk_in_size, true);
     libusb_fill_bulk_transfer(t->transfer, d->handle,
-                              pipe_id, t->buffer, sizeof(t->buffer),
+                              pipe_id, t->buffer, (int) d->bulk_in_size,
                               on_bulk_in_done, t, BULK_IN_TIMEOUT_MS);
-    submit_transfer(t);
+    if (0 == submit_transfer(t)) {
+        ++d->bulk_in_active;
+    }
 }
 
 static void bulk_in_open(struct dev_s * d, struct jsdrvp_msg_s * msg) {
     uint8_t ep = msg->extra.bkusb_stream.endpoint;
     uint8_t pipe_id = ep | 0x80;
-    JSDRV_LOGI("bulk_in_open(%d, endpoint=0x%02x)", d->ll_device.prefix, (int) ep);
+    d->bulk_in_depth = jsdrv_usbbk_bulk_in_depth(msg->extra.bkusb_stream.transfer_depth);
+    d->bulk_in_size = jsdrv_usbbk_bulk_in_size(msg->extra.bkusb_stream.transfer_size);
+    d->bulk_in_spare = jsdrv_usbbk_bulk_in_spare(msg->extra.bkusb_stream.transfer_spare);
+    uint32_t depth_max = msg->extra.bkusb_stream.transfer_depth_max;
+    if (depth_max) {
+        depth_max = jsdrv_usbbk_bulk_in_depth(depth_max);
+    }
+    jsdrv_usb_depth_init(&d->bulk_in_adapt, d->bulk_in_depth, depth_max, jsdrv_time_monotonic());
+    JSDRV_LOGI("bulk_in_open(%s, endpoint=0x%02x, depth=%" PRIu32 ", depth_max=%" PRIu32 ", size=%" PRIu32 ", spare=%" PRIu32 ")",
+               d->ll_device.prefix, (int) ep, d->bulk_in_depth, d->bulk_in_adapt.depth_max, d->bulk_in_size, d->bulk_in_spare);
     d->endpoint_mode[pipe_id] = EP_MODE_BULK_IN;
     int rv = libusb_clear_halt(d->handle, pipe_id);
     if (rv) {
         JSDRV_LOGW("bulk_in_open clear_halt failed with %d", rv);
     }
-    for (uint32_t i = 0; i < BULK_IN_TRANSFER_OUTSTANDING; ++i) {
-        bulk_in_start(d, pipe_id);
+    // preallocate spares so that on_bulk_in_done() never waits for an allocation
+    struct transfer_s * spares[JSDRV_USBBK_BULK_IN_SPARE_MAX];
+    for (uint32_t i = 0; i < d->bulk_in_spare; ++i) {
+        spares[i] = transfer_alloc(d, d->bulk_in_size, true);
+    }
+    for (uint32_t i = 0; i < d->bulk_in_spare; ++i) {
+        transfer_free(spares[i]);
     }
+    bulk_in_fill(d, pipe_id);
     msg->value = jsdrv_union_i32(0);  // return code
     device_rsp(d, msg);
 }
@@ -462,9 +712,21 @@ static bool device_handle_msg(struct dev_s * d, struct jsdrvp_msg_s * msg) {
     }
     if (0 == strcmp(JSDRV_USBBK_MSG_STREAM_IN_DATA, msg->topic)) {
         struct transfer_s * t;
-        t = JSDRV_CONTAINER_OF(msg->value.value.bin, struct transfer_s, buffer);
-        transfer_free(t);
-        jsdrvp_msg_free(d->backend->context, msg);
+        t = (struct transfer_s *) msg->extra.bkusb_stream.owner;
+        bool skip = msg->extra.bkusb_stream.transfer_skip != 0;
+        if ((NULL == t) || (t->msg_in != msg)) {
+            JSDRV_LOGW("stream_in_data message not owned by transfer");
+            jsdrvp_msg_free(d->backend->context, msg);
+            if (NULL == t) {
+                return true;
+            }
+        }
+        JSDRV_PERF_LOAN(jsdrv_time_utc() - t->loan_time);
+        if (skip) {
+            bulk_in_adapt(d, true);
+            bulk_in_fill(d, t->transfer->endpoint);
+        }
+        transfer_free(t);  // retains t->msg_in for reuse
     } else if (0 == strcmp(JSDRV_USBBK_MSG_BULK_OUT_DATA, msg->topic)) {
         bulk_out_send(d, msg);
     } else if (msg->topic[0] == JSDRV_MSG_COMMAND_PREFIX_CHAR) {
@@ -503,36 +765,11 @@ static bool device_handle_msg(struct dev_s * d, struct jsdrvp_msg_s * msg) {
     return true;
 }
 
-static void process_devices(struct backend_s * s) {
-    struct jsdrv_list_s * item;
-    struct dev_s * d;
-    struct jsdrvp_msg_s * msg = NULL;
-    jsdrv_list_foreach(&s->devices_active, item) {
-        d = JSDRV_CONTAINER_OF(item, struct dev_s, item);
-        do {
-            msg = msg_queue_pop_immediate(d->ll_device.cmd_q);
-            device_handle_msg(d, msg);
-        } while (NULL != msg);
-    }
-    jsdrv_list_foreach(&s->devices_free, item) {
-        d = JSDRV_CONTAINER_OF(item, struct dev_s, item);
-        while (1) {
-            msg = msg_queue_pop_immediate(d->ll_device.cmd_q);
-            if (NULL == msg) {
-                break;
-            }
-            JSDRV_LOGW("device closed, but message %s", msg->topic);
-            msg->value = jsdrv_union_i32(JSDRV_ERROR_CLOSED);
-            msg_queue_push(d->ll_device.rsp_q, msg);
-        };
-    }
-
-}
-
-static int32_t device_add(struct backend_s * s, libusb_device * usb_device, struct libusb_device_descriptor * descriptor) {
+static int32_t device_add(struct worker_s * w, libusb_device * usb_device, struct libusb_device_descriptor * descriptor) {
+    struct backend_s * s = w->backend;
     struct dev_s * d;
     struct jsdrv_list_s * item;
-    item = jsdrv_list_remove_head(&s->devices_free);
+    item = jsdrv_list_remove_head(&w->devices_free);
     if (!item) {
         JSDRV_LOGW("device_add but too many devices");
         return 1;
@@ -540,34 +777,31 @@ static int32_t device_add(struct backend_s * s, libusb_device * usb_device, stru
     d = JSDRV_CONTAINER_OF(item, struct dev_s, item);
     jsdrv_list_initialize(&d->item);
 
-    const struct device_type_s * dt = device_types;
-    while (dt->device_type) {
-        if ((dt->vendor_id == descriptor->idVendor) && (dt->product_id == descriptor->idProduct)) {
-            // device matches device_type
-            d->mark = DEVICE_MARK_ADDED;
-            d->device_type = dt;
-            d->usb_device = usb_device;
-            d->device_descriptor = *descriptor;
-            int rc = libusb_get_serial_string_descriptor_ascii(d->usb_device, (uint8_t *) d->serial_number, sizeof(d->serial_number));
-            if (rc < 0) {
-                JSDRV_LOGW("Could not get serial number string");
-                tfp_snprintf(d->serial_number, sizeof(d->serial_number), "unknown");
-            } else {
-                unsigned long slen = strlen(d->serial_number);
-                while (slen && (d->serial_number[slen - 1] == '\n')) {
-                    d->serial_number[--slen] = 0;
-                }
+    const struct device_type_s * dt = device_type_find(descriptor);
+    if (dt) {
+        // device matches device_type
+        d->mark = DEVICE_MARK_ADDED;
+        d->device_type = dt;
+        d->usb_device = usb_device;
+        d->device_descriptor = *descriptor;
+        int rc = libusb_get_serial_string_descriptor_ascii(d->usb_device, (uint8_t *) d->serial_number, sizeof(d->serial_number));
+        if (rc < 0) {
+            JSDRV_LOGW("Could not get serial number string");
+            tfp_snprintf(d->serial_number, sizeof(d->serial_number), "unknown");
+        } else {
+            unsigned long slen = strlen(d->serial_number);
+            while (slen && (d->serial_number[slen - 1] == '\n')) {
+                d->serial_number[--slen] = 0;
             }
-            tfp_snprintf(d->ll_device.prefix, sizeof(d->ll_device.prefix), "%c/%s/%s",
-                         s->backend.prefix, d->device_type->model, d->serial_number);
-            jsdrv_list_add_tail(&s->devices_active, &d->item);
-            d->mode = DEVICE_MODE_CLOSED;
-            device_add_announce(s, d);
-            return 0;
         }
-        ++dt;
+        tfp_snprintf(d->ll_device.prefix, sizeof(d->ll_device.prefix), "%c/%s/%s",
+                     s->backend.prefix, d->device_type->model, d->serial_number);
+        jsdrv_list_add_tail(&w->devices_active, &d->item);
+        d->mode = DEVICE_MODE_CLOSED;
+        device_add_announce(s, d);
+        return 0;
     }
-    jsdrv_list_add_tail(&s->devices_free, &d->item);
+    jsdrv_list_add_tail(&w->devices_free, &d->item);
     return 1;
 }
 
@@ -594,36 +828,40 @@ static void device_remove(struct backend_s * s, struct dev_s * d) {
     }
     d->mode = DEVICE_MODE_UNASSIGNED;
     device_remove_announce(s, d);
-    jsdrv_list_add_tail(&s->devices_free, &d->item);
+    jsdrv_list_add_tail(&d->worker->devices_free, &d->item);
 }
 
-static void handle_hotplug(struct backend_s * s) {
+static void device_scan(struct worker_s * w) {
+    struct backend_s * s = w->backend;
     struct libusb_device_descriptor descriptor;
     libusb_device ** device_list;
     struct dev_s * d;
     struct jsdrv_list_s * item;
-    jsdrv_os_event_reset(s->hotplug_event);
-    jsdrv_list_foreach(&s->devices_active, item) {
+    w->scan_time_ms = jsdrv_time_ms_u32();
+    w->hotplug_rescan = false;
+    jsdrv_list_foreach(&w->devices_active, item) {
         d = JSDRV_CONTAINER_OF(item, struct dev_s, item);
         d->mark = DEVICE_MARK_NONE;
     }
-    ssize_t n = libusb_get_device_list(s->ctx, &device_list);
+    ssize_t n = libusb_get_device_list(w->ctx, &device_list);
     for (ssize_t i = 0; i < n; ++i) {
         libusb_device * usbd = device_list[i];
-        d = device_lookup_by_usb_device(s, usbd);
+        d = device_lookup_by_usb_device(w, usbd);
         if (NULL != d) {
-            JSDRV_LOGI("Found device: %p %s", usbd, d->serial_number);
+            JSDRV_LOGD1("Found device: %p %s", (void *) usbd, d->serial_number);
             d->mark = DEVICE_MARK_FOUND;
+        } else if (!worker_owns(w, usbd)) {
+            // served by another worker
         } else if (libusb_get_device_descriptor(usbd, &descriptor)) {
             JSDRV_LOGW("could not get device descriptor for %p", d);
-        } else if (0 == device_add(s, usbd, &descriptor)) {
+        } else if (0 == device_add(w, usbd, &descriptor)) {
             continue;  // success, keep device reference
         }
         libusb_unref_device(usbd);
     }
     libusb_free_device_list(device_list, 0);
 
-    jsdrv_list_foreach(&s->devices_active, item) {
+    jsdrv_list_foreach(&w->devices_active, item) {
         d = JSDRV_CONTAINER_OF(item, struct dev_s, item);
         if (d->mark == DEVICE_MARK_NONE) {
             device_remove(s, d);
@@ -631,6 +869,43 @@ static void handle_hotplug(struct backend_s * s) {
     }
 }
 
+/**
+ * @brief Process the pending Joulescope hotplug events.
+ *
+ * on_hotplug already filters by device type and worker, so this
+ * avoids walking the full USB device list on every notification.
+ * The full device_scan() remains for hotplug event overflow and
+ * as a periodic fallback.
+ */
+static void handle_hotplug(struct worker_s * w) {
+    struct backend_s * s = w->backend;
+    struct libusb_device_descriptor descriptor;
+    jsdrv_os_event_reset(w->hotplug_event);
+    for (uint32_t i = 0; i < w->hotplug_count; ++i) {
+        struct hotplug_event_s * e = &w->hotplug_events[i];
+        struct dev_s * d = device_lookup_by_usb_device(w, e->usb_device);
+        if (!e->arrived) {
+            if (d) {
+                device_remove(s, d);
+            }
+        } else if (d) {
+            // already found by device_scan
+        } else if (libusb_get_device_descriptor(e->usb_device, &descriptor)) {
+            JSDRV_LOGW("could not get device descriptor for %p", (void *) e->usb_device);
+        } else if (0 == device_add(w, e->usb_device, &descriptor)) {
+            e->usb_device = NULL;  // success, device keeps the reference
+        }
+        if (e->usb_device) {
+            libusb_unref_device(e->usb_device);
+            e->usb_device = NULL;
+        }
+    }
+    w->hotplug_count = 0;
+    if (w->hotplug_rescan) {
+        device_scan(w);
+    }
+}
+
 static bool handle_msg(struct backend_s * s, struct jsdrvp_msg_s * msg) {
     bool rv = true;
     if (!msg) {
@@ -653,8 +928,19 @@ static void backend_init_done(struct backend_s * s, int32_t status) {
     jsdrvp_backend_send(s->context, msg);
 }
 
-static bool are_all_devices_idle(struct backend_s * s) {
-    for (uint32_t i = 0; i < DEVICES_MAX; ++i) {
+static void worker_init_done(struct worker_s * w, int32_t status) {
+    struct backend_s * s = w->backend;
+    if (status) {
+        jsdrv_atomic_store(&s->init_status, status);
+    }
+    if (0 == jsdrv_atomic_add(&s->init_pending, -1)) {
+        backend_init_done(s, jsdrv_atomic_load(&s->init_status));
+    }
+}
+
+static bool are_all_devices_idle(struct worker_s * w) {
+    struct backend_s * s = w->backend;
+    for (uint32_t i = w->index; i < DEVICES_MAX; i += s->worker_count) {
         struct dev_s *d = &s->devices[i];
         if (!jsdrv_list_is_empty(&d->transfers_pending)) {
             return false;
@@ -663,13 +949,14 @@ static bool are_all_devices_idle(struct backend_s * s) {
     return true;
 }
 
-static void handle_device_close(struct backend_s * s) {
+static void handle_device_close(struct worker_s * w) {
     struct jsdrv_list_s * item;
     struct dev_s * d;
-    jsdrv_list_foreach(&s->devices_active, item) {
+    jsdrv_list_foreach(&w->devices_active, item) {
         d = JSDRV_CONTAINER_OF(item, struct dev_s, item);
         if ((d->mode == DEVICE_MODE_CLOSING) && (jsdrv_list_is_empty(&d->transfers_pending))) {
             if (d->handle) {
+                transfers_free_destroy(d);
                 libusb_close(d->handle);
                 d->handle = NULL;
             }
@@ -678,23 +965,25 @@ static void handle_device_close(struct backend_s * s) {
     }
 }
 
-static void device_close_all(struct backend_s * s) {
+static void device_close_all(struct worker_s * w) {
+    struct backend_s * s = w->backend;
     struct timeval libusb_timeout_tv = {.tv_sec=1, .tv_usec=20000};
-    for (uint32_t i = 0; i < DEVICES_MAX; ++i) {
+    for (uint32_t i = w->index; i < DEVICES_MAX; i += s->worker_count) {
         struct dev_s *d = &s->devices[i];
         if (d->handle) {
             device_close(d);
         }
     }
-    while (!are_all_devices_idle(s)) {
-        libusb_handle_events_timeout_completed(s->ctx, &libusb_timeout_tv, NULL);
-        handle_device_close(s);
+    while (!are_all_devices_idle(w)) {
+        libusb_handle_events_timeout_completed(w->ctx, &libusb_timeout_tv, NULL);
+        handle_device_close(w);
         // todo timeout?
     }
-    for (uint32_t i = 0; i < DEVICES_MAX; ++i) {
+    for (uint32_t i = w->index; i < DEVICES_MAX; i += s->worker_count) {
         struct dev_s *d = &s->devices[i];
         if (NULL != d->handle) {
             JSDRV_LOGI("closing idle device %s", d->serial_number);
+            transfers_free_destroy(d);
             libusb_close(d->handle);
             d->handle = NULL;
         }
@@ -705,88 +994,336 @@ static void device_close_all(struct backend_s * s) {
     }
 }
 
+static void device_process(struct dev_s * d) {
+    struct jsdrvp_msg_s * msg;
+    while (NULL != (msg = msg_queue_pop_immediate(d->ll_device.cmd_q))) {
+        if (NULL != d->usb_device) {  // in devices_active
+            device_handle_msg(d, msg);
+        } else {
+            JSDRV_LOGW("device closed, but message %s", msg->topic);
+            msg->value = jsdrv_union_i32(JSDRV_ERROR_CLOSED);
+            msg_queue_push(d->ll_device.rsp_q, msg);
+        }
+    }
+}
+
+#if EVLOOP_EPOLL || EVLOOP_KQUEUE
+
+static void evloop_add(struct worker_s * w, int fd, short events, uint64_t tag) {
+#if EVLOOP_EPOLL
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = ((events & POLLIN) ? EPOLLIN : 0) | ((events & POLLOUT) ? EPOLLOUT : 0);
+    ev.data.u64 = tag;
+    if (epoll_ctl(w->evloop_fd, EPOLL_CTL_ADD, fd, &ev)) {
+        JSDRV_LOGW("epoll_ctl add fd=%d failed %d", fd, errno);
+    }
+#else
+    struct kevent kev[2];
+    int n = 0;
+    if (events & POLLIN) {
+        EV_SET(&kev[n++], fd, EVFILT_READ, EV_ADD, 0, 0, (void *) (uintptr_t) tag);
+    }
+    if (events & POLLOUT) {
+        EV_SET(&kev[n++], fd, EVFILT_WRITE, EV_ADD, 0, 0, (void *) (uintptr_t) tag);
+    }
+    if (kevent(w->evloop_fd, kev, n, NULL, 0, NULL) < 0) {
+        JSDRV_LOGW("kevent add fd=%d failed %d", fd, errno);
+    }
+#endif
+}
+
+static void evloop_remove(struct worker_s * w, int fd) {
+#if EVLOOP_EPOLL
+    struct epoll_event ev;  // non-NULL for kernels before 2.6.9
+    memset(&ev, 0, sizeof(ev));
+    epoll_ctl(w->evloop_fd, EPOLL_CTL_DEL, fd, &ev);
+#else
+    struct kevent kev;
+    EV_SET(&kev, fd, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+    kevent(w->evloop_fd, &kev, 1, NULL, 0, NULL);  // ignore error when not registered
+    EV_SET(&kev, fd, EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
+    kevent(w->evloop_fd, &kev, 1, NULL, 0, NULL);
+#endif
+}
+
+static void on_libusb_pollfd_added(int fd, short events, void * user_data) {
+    struct worker_s * w = (struct worker_s *) user_data;
+    evloop_add(w, fd, events, EVLOOP_TAG(EVLOOP_SRC_LIBUSB, 0));
+}
+
+static void on_libusb_pollfd_removed(int fd, void * user_data) {
+    struct worker_s * w = (struct worker_s *) user_data;
+    evloop_remove(w, fd);
+}
+
+static int32_t evloop_open(struct worker_s * w) {
+    struct backend_s * s = w->backend;
+#if EVLOOP_EPOLL
+    w->evloop_fd = epoll_create1(EPOLL_CLOEXEC);
+#else
+    w->evloop_fd = kqueue();
+#endif
+    if (w->evloop_fd < 0) {
+        JSDRV_LOGW("event loop create failed %d, use poll", errno);
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    if (0 == w->index) {
+        evloop_add(w, msg_queue_handle_get(s->backend.cmd_q), POLLIN, EVLOOP_TAG(EVLOOP_SRC_BACKEND, 0));
+    }
+    evloop_add(w, w->hotplug_event->fd_poll, w->hotplug_event->events, EVLOOP_TAG(EVLOOP_SRC_HOTPLUG, 0));
+    for (uint32_t i = w->index; i < DEVICES_MAX; i += s->worker_count) {
+        evloop_add(w, msg_queue_handle_get(s->devices[i].ll_device.cmd_q), POLLIN, EVLOOP_TAG(EVLOOP_SRC_DEVICE, i));
+    }
+    libusb_set_pollfd_notifiers(w->ctx, on_libusb_pollfd_added, on_libusb_pollfd_removed, w);
+    const struct libusb_pollfd ** libusb_fds = libusb_get_pollfds(w->ctx);
+    for (int i = 0; libusb_fds && libusb_fds[i]; ++i) {
+        on_libusb_pollfd_added(libusb_fds[i]->fd, libusb_fds[i]->events, w);
+    }
+    libusb_free_pollfds(libusb_fds);
+    return 0;
+}
+
+static void evloop_close(struct worker_s * w) {
+    if (w->evloop_fd >= 0) {
+        libusb_set_pollfd_notifiers(w->ctx, NULL, NULL, NULL);
+        close(w->evloop_fd);
+        w->evloop_fd = -1;
+    }
+}
+
+/**
+ * @brief Wait for events.
+ *
+ * @param w The worker instance.
+ * @param tags The output event source tags, EVLOOP_EVENTS_MAX long.
+ * @param timeout_ms The maximum time to wait.
+ * @return The number of tags, which may contain duplicates.
+ *
+ * Only the sources with pending events are returned, so the cost
+ * scales with activity rather than with DEVICES_MAX.
+ */
+static uint32_t evloop_wait(struct worker_s * w, uint64_t * tags, int timeout_ms) {
+    int count;
+#if EVLOOP_EPOLL
+    struct epoll_event events[EVLOOP_EVENTS_MAX];
+    count = epoll_wait(w->evloop_fd, events, EVLOOP_EVENTS_MAX, timeout_ms);
+    for (int i = 0; i < count; ++i) {
+        tags[i] = events[i].data.u64;
+    }
+#else
+    struct kevent events[EVLOOP_EVENTS_MAX];
+    struct timespec ts = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_nsec = (timeout_ms % 1000) * 1000000L,
+    };
+    count = kevent(w->evloop_fd, NULL, 0, events, EVLOOP_EVENTS_MAX, &ts);
+    for (int i = 0; i < count; ++i) {
+        tags[i] = (uint64_t) (uintptr_t) events[i].udata;
+    }
+#endif
+    return (count > 0) ? (uint32_t) count : 0U;
+}
+
+#else  // poll() fallback for other POSIX platforms
+
+static int32_t evloop_open(struct worker_s * w) {
+    w->evloop_fd = -1;
+    return JSDRV_ERROR_UNAVAILABLE;
+}
+
+static void evloop_close(struct worker_s * w) {
+    (void) w;
+}
+
+static uint32_t evloop_wait(struct worker_s * w, uint64_t * tags, int timeout_ms) {
+    (void) w;
+    (void) tags;
+    (void) timeout_ms;
+    return 0;
+}
+
+#endif
+
+/**
+ * @brief Wait for events using poll(), which rebuilds the descriptor list each call.
+ *
+ * @see evloop_wait
+ */
+static uint32_t poll_wait(struct worker_s * w, uint64_t * tags, int timeout_ms) {
+    struct backend_s * s = w->backend;
+    struct pollfd fds[3 + DEVICES_MAX + EVLOOP_EVENTS_MAX];
+    uint64_t fds_tags[JSDRV_ARRAY_SIZE(fds)];
+    nfds_t nfds = 0;
+    uint32_t count = 0;
+
+    if (0 == w->index) {
+        fds[nfds].fd = msg_queue_handle_get(s->backend.cmd_q);
+        fds[nfds].events = POLLIN;
+        fds_tags[nfds++] = EVLOOP_TAG(EVLOOP_SRC_BACKEND, 0);
+    }
+
+    fds[nfds].fd = w->hotplug_event->fd_poll;
+    fds[nfds].events = (short) w->hotplug_event->events;
+    fds_tags[nfds++] = EVLOOP_TAG(EVLOOP_SRC_HOTPLUG, 0);
+
+    for (uint32_t i = w->index; i < DEVICES_MAX; i += s->worker_count) {
+        fds[nfds].fd = msg_queue_handle_get(s->devices[i].ll_device.cmd_q);
+        fds[nfds].events = POLLIN;
+        fds_tags[nfds++] = EVLOOP_TAG(EVLOOP_SRC_DEVICE, i);
+    }
+
+    const struct libusb_pollfd ** libusb_fds = libusb_get_pollfds(w->ctx);
+    for (int i = 0; libusb_fds && libusb_fds[i] && (nfds < JSDRV_ARRAY_SIZE(fds)); ++i) {
+        fds[nfds].fd = libusb_fds[i]->fd;
+        fds[nfds].events = libusb_fds[i]->events;
+        fds_tags[nfds++] = EVLOOP_TAG(EVLOOP_SRC_LIBUSB, 0);
+    }
+    libusb_free_pollfds(libusb_fds);
+
+    for (nfds_t i = 0; i < nfds; ++i) {
+        fds[i].revents = 0;
+    }
+    if (poll(fds, nfds, timeout_ms) > 0) {
+        for (nfds_t i = 0; (i < nfds) && (count < EVLOOP_EVENTS_MAX); ++i) {
+            if (fds[i].revents) {
+                tags[count++] = fds_tags[i];
+            }
+        }
+    }
+    return count;
+}
+
+static int backend_timeout_ms(struct worker_s * w) {
+    struct timeval tv;
+    int timeout_ms = BACKEND_POLL_TIMEOUT_MS;
+    uint32_t scan_elapsed_ms = jsdrv_time_ms_u32() - w->scan_time_ms;
+    int scan_ms = (scan_elapsed_ms >= HOTPLUG_RESCAN_INTERVAL_MS) ? 0 : (int) (HOTPLUG_RESCAN_INTERVAL_MS - scan_elapsed_ms);
+    if (scan_ms < timeout_ms) {
+        timeout_ms = scan_ms;  // wake for the fallback rescan deadline only
+    }
+    if (!libusb_pollfds_handle_timeouts(w->ctx) && (1 == libusb_get_next_timeout(w->ctx, &tv))) {
+        int64_t t = ((int64_t) tv.tv_sec) * 1000 + (tv.tv_usec + 999) / 1000;
+        if (t < timeout_ms) {
+            timeout_ms = (int) t;
+        }
+    }
+    return timeout_ms;
+}
+
+static void worker_affinity_set(struct worker_s * w) {
+    if (w->cpu < 0) {
+        return;
+    }
+#if defined(__linux__)
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(w->cpu, &cpuset);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if (rc) {
+        JSDRV_LOGW("worker %u: pthread_setaffinity_np(%d) failed %d", w->index, w->cpu, rc);
+    }
+#else
+    JSDRV_LOGI("worker %u: thread affinity not supported, ignore", w->index);
+#endif
+}
+
 void * backend_thread(void * arg) {
-    struct pollfd fds[1024];
-    nfds_t nfds;
+    uint64_t tags[EVLOOP_EVENTS_MAX];
+    uint32_t tags_count;
+    bool use_evloop;
     struct timeval libusb_timeout_tv = {.tv_sec=0, .tv_usec=0};
-    JSDRV_LOGI("jsdrv_usb_backend_thread start");
-    struct backend_s * s = (struct backend_s *) arg;
-    int rc = libusb_init(&s->ctx);
+    struct worker_s * w = (struct worker_s *) arg;
+    struct backend_s * s = w->backend;
+    JSDRV_LOGI("jsdrv_usb_backend_thread %u start", w->index);
+    w->evloop_fd = -1;
+    worker_affinity_set(w);
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_USB);  // role affinity, when set, replaces the worker pin
+    int rc = libusb_init(&w->ctx);
     if (rc) {
         JSDRV_LOGE("libusb_init failed: %d", rc);
-        backend_init_done(s, JSDRV_ERROR_IO);
+        worker_init_done(w, JSDRV_ERROR_IO);
+        jsdrv_thread_unregister();
         return NULL;
     }
 
     rc = libusb_hotplug_register_callback(
-            s->ctx,
+            w->ctx,
             LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
             0,                              // flags
             LIBUSB_HOTPLUG_MATCH_ANY,       // vid
             LIBUSB_HOTPLUG_MATCH_ANY,       // pid
             LIBUSB_HOTPLUG_MATCH_ANY,       // device class
             on_hotplug,                     // callback
-            s,                              // callback argument
-            &s->hotplug_callback_handle     // allocated callback handle
+            w,                              // callback argument
+            &w->hotplug_callback_handle     // allocated callback handle
     );
     if (LIBUSB_SUCCESS != rc) {
         JSDRV_LOGE("libusb_hotplug_register_callback returned %d", rc);
+        worker_init_done(w, JSDRV_ERROR_IO);
         goto exit;
     }
 
-    handle_hotplug(s);  // perform an initial scan
-    backend_init_done(s, 0);
+    use_evloop = (0 == evloop_open(w));
+    device_scan(w);  // perform an initial scan
+    worker_init_done(w, 0);
 
     while (!s->do_exit) {
-        nfds = 0;
-
-        // Add primary backend command queue descriptor.
-        fds[nfds].fd = msg_queue_handle_get(s->backend.cmd_q);
-        fds[nfds].events = POLLIN;
-        fds[nfds++].revents = 0;
-
-        // Add hotplug command queue descriptor.
-        fds[nfds].fd = s->hotplug_event->fd_poll;
-        fds[nfds].events = s->hotplug_event->events;
-        fds[nfds++].revents = 0;
-
-        // Add libusb file descriptors.
-        const struct libusb_pollfd ** libusb_fds = libusb_get_pollfds(s->ctx);
-        for (int i = 0; libusb_fds[i]; ++i) {
-            fds[nfds].fd = libusb_fds[i]->fd;
-            fds[nfds].events = libusb_fds[i]->events;
-            fds[nfds++].revents = 0;
-        }
-        libusb_free_pollfds(libusb_fds);
-
-        // Add file descriptors for each device command queue.
-        for (size_t i = 0; i < JSDRV_ARRAY_SIZE(s->devices); ++i) {
-            fds[nfds].fd = msg_queue_handle_get(s->devices[i].ll_device.cmd_q);
-            fds[nfds].events = POLLIN;
-            fds[nfds++].revents = 0;
+        if (use_evloop) {
+            tags_count = evloop_wait(w, tags, backend_timeout_ms(w));
+        } else {
+            tags_count = poll_wait(w, tags, backend_timeout_ms(w));
         }
-
-        if (nfds > JSDRV_ARRAY_SIZE(fds)) {
-            JSDRV_LOG_CRITICAL("nfds too large");
+        JSDRV_TRACE_START(t_events);
+        libusb_handle_events_timeout_completed(w->ctx, &libusb_timeout_tv, NULL);
+        JSDRV_TRACE_END("usb_events", t_events, tags_count);
+
+        bool is_hotplug = false;
+        for (uint32_t i = 0; i < tags_count; ++i) {
+            uint32_t idx = EVLOOP_TAG_IDX(tags[i]);
+            switch (EVLOOP_TAG_SRC(tags[i])) {
+                case EVLOOP_SRC_BACKEND: {
+                    JSDRV_TRACE_START(t_cmd);
+                    while (handle_msg(s, msg_queue_pop_immediate(s->backend.cmd_q))) {
+                        ; //
+                    }
+                    JSDRV_TRACE_END("usb_cmd", t_cmd, 0);
+                    break;
+                }
+                case EVLOOP_SRC_HOTPLUG:
+                    is_hotplug = true;
+                    break;
+                case EVLOOP_SRC_DEVICE:
+                    if (idx < DEVICES_MAX) {
+                        JSDRV_TRACE_START(t_dev);
+                        device_process(&s->devices[idx]);
+                        JSDRV_TRACE_END("usb_device", t_dev, idx);
+                    }
+                    break;
+                default:
+                    break;  // libusb, already handled
+            }
         }
-
-        rc = poll(fds, nfds, 5000);
-        rc = libusb_handle_events_timeout_completed(s->ctx, &libusb_timeout_tv, NULL);
-        while (handle_msg(s, msg_queue_pop_immediate(s->backend.cmd_q))) {
-            ; //
+        if ((is_hotplug || w->hotplug_count) && !s->do_exit) {
+            handle_hotplug(w);
         }
-        process_devices(s);
-        if (fds[1].revents) {
-            handle_hotplug(s);
+        if (!s->do_exit && ((jsdrv_time_ms_u32() - w->scan_time_ms) >= HOTPLUG_RESCAN_INTERVAL_MS)) {
+            device_scan(w);  // fallback for missed hotplug events
         }
-        handle_device_close(s);
+        handle_device_close(w);
     }
 
 exit:
-    libusb_hotplug_deregister_callback(s->ctx, s->hotplug_callback_handle);
-    device_close_all(s);
-    libusb_exit(s->ctx);
-    JSDRV_LOGI("jsdrv_usb_backend_thread exit");
+    evloop_close(w);
+    libusb_hotplug_deregister_callback(w->ctx, w->hotplug_callback_handle);
+    for (uint32_t i = 0; i < w->hotplug_count; ++i) {
+        libusb_unref_device(w->hotplug_events[i].usb_device);
+    }
+    w->hotplug_count = 0;
+    device_close_all(w);
+    libusb_exit(w->ctx);
+    JSDRV_LOGI("jsdrv_usb_backend_thread %u exit", w->index);
+    jsdrv_thread_unregister();
     return NULL;
 }
 
@@ -795,13 +1332,23 @@ static void finalize(struct jsdrvbk_s * backend) {
     char topic[2] = {backend->prefix, 0};
     s->do_exit = true;
     JSDRV_LOGI("backend finalize");
-    if (s->thread_id) {
+    if (s->workers[0].thread_id) {
         jsdrvp_send_finalize_msg(s->context, s->backend.cmd_q, topic);
-        int rv = pthread_join(s->thread_id, NULL);
-        if (rv) {
-            JSDRV_LOGW("pthread_join returned %d", rv);
+    }
+    for (uint32_t k = 0; k < s->worker_count; ++k) {
+        struct worker_s * w = &s->workers[k];
+        if (w->thread_id) {
+            jsdrv_os_event_signal(w->hotplug_event);  // wake to observe do_exit
+            int rv = pthread_join(w->thread_id, NULL);
+            if (rv) {
+                JSDRV_LOGW("pthread_join returned %d", rv);
+            }
+            w->thread_id = 0;
+        }
+        if (w->hotplug_event) {
+            jsdrv_os_event_free(w->hotplug_event);
+            w->hotplug_event = NULL;
         }
-        s->thread_id = 0;
     }
     if (s->backend.cmd_q) {
         msg_queue_finalize(s->backend.cmd_q);
@@ -818,27 +1365,89 @@ static void finalize(struct jsdrvbk_s * backend) {
             d->ll_device.rsp_q = NULL;
         }
     }
+    if (s->trace_dir) {
+        jsdrv_free(s->trace_dir);
+    }
     jsdrv_free(s);
 }
 
+static bool arg_get(struct jsdrv_context_s * context, const char * topic, uint8_t type, struct jsdrv_union_s * value) {
+    const struct jsdrv_union_s * arg = jsdrvp_arg_get(context, topic);
+    if (NULL == arg) {
+        return false;
+    }
+    *value = *arg;
+    if (jsdrv_union_as_type(value, type)) {
+        JSDRV_LOGW("invalid argument type for %s", topic);
+        return false;
+    }
+    return true;
+}
+
+static int cpu_from_affinity(uint64_t affinity, uint32_t index) {
+    int bits[64];
+    uint32_t count = 0;
+    for (int i = 0; i < 64; ++i) {
+        if (affinity & (1ULL << i)) {
+            bits[count++] = i;
+        }
+    }
+    return count ? bits[index % count] : -1;
+}
+
 int32_t jsdrv_usb_backend_factory(struct jsdrv_context_s * context, struct jsdrvbk_s ** backend) {
     JSDRV_LOGI("jsdrv_usb_backend_factory");
+    struct jsdrv_union_s arg;
+    uint32_t worker_count = 1;
+    uint64_t affinity = 0;
+    if (arg_get(context, JSDRV_ARG_USB_THREADS, JSDRV_UNION_U32, &arg)) {
+        worker_count = arg.value.u32;
+    }
+    if (worker_count < 1) {
+        worker_count = 1;
+    } else if (worker_count > WORKERS_MAX) {
+        JSDRV_LOGW("usb threads %u exceeds max, use %u", worker_count, WORKERS_MAX);
+        worker_count = WORKERS_MAX;
+    }
+    if (arg_get(context, JSDRV_ARG_USB_AFFINITY, JSDRV_UNION_U64, &arg)) {
+        affinity = arg.value.u64;
+    }
+    const struct jsdrv_union_s * trace_dir = jsdrvp_arg_get(context, JSDRV_ARG_USB_TRACE);
+
     struct backend_s * s = jsdrv_alloc_clr(sizeof(struct backend_s));
     s->context = context;
     s->backend.prefix = 'u';
     s->backend.finalize = finalize;
+    if ((NULL != trace_dir) && (JSDRV_UNION_STR == trace_dir->type) && trace_dir->value.str && trace_dir->value.str[0]) {
+        size_t sz = strlen(trace_dir->value.str) + 1;
+        s->trace_dir = jsdrv_alloc(sz);
+        memcpy(s->trace_dir, trace_dir->value.str, sz);
+    } else if (NULL != trace_dir) {
+        JSDRV_LOGW("invalid argument type for %s", JSDRV_ARG_USB_TRACE);
+    }
     s->backend.cmd_q = msg_queue_init();
-    jsdrv_list_initialize(&s->devices_active);
-    jsdrv_list_initialize(&s->devices_free);
+    s->worker_count = worker_count;
+    s->init_pending = (int32_t) worker_count;
+    for (uint32_t k = 0; k < worker_count; ++k) {
+        struct worker_s * w = &s->workers[k];
+        w->backend = s;
+        w->index = k;
+        w->cpu = cpu_from_affinity(affinity, k);
+        w->evloop_fd = -1;
+        jsdrv_list_initialize(&w->devices_active);
+        jsdrv_list_initialize(&w->devices_free);
+    }
     for (uint32_t i = 0; i < DEVICES_MAX; ++i) {
         struct dev_s * d = &s->devices[i];
         d->backend = s;
-        d->ll_device.cmd_q = msg_queue_init();
-        d->ll_device.rsp_q = msg_queue_init();
+        d->worker = &s->workers[i % worker_count];
+        d->ll_device.cmd_q = msg_queue_init_spsc(MSG_QUEUE_SPSC_CAPACITY_DEFAULT);
+        d->ll_device.rsp_q = msg_queue_init_spsc(MSG_QUEUE_SPSC_CAPACITY_DEFAULT);
+        msg_queue_lanes_enable(d->ll_device.rsp_q);
         jsdrv_list_initialize(&d->transfers_pending);
         jsdrv_list_initialize(&d->transfers_free);
         jsdrv_list_initialize(&d->item);
-        jsdrv_list_add_tail(&s->devices_free, &d->item);
+        jsdrv_list_add_tail(&d->worker->devices_free, &d->item);
     }
 
     if (!libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) {
@@ -846,17 +1455,20 @@ int32_t jsdrv_usb_backend_factory(struct jsdrv_context_s * context, struct jsdrv
         return JSDRV_ERROR_UNAVAILABLE;
     }
 
-    s->hotplug_event = jsdrv_os_event_alloc();
-
-    int rc = pthread_create(&s->thread_id, NULL, backend_thread, s);
-    if (rc) {
-        JSDRV_LOGE("pthread_create failed: %d", rc);
-        finalize(&s->backend);
-        return JSDRV_ERROR_UNSPECIFIED;
+    for (uint32_t k = 0; k < worker_count; ++k) {
+        s->workers[k].hotplug_event = jsdrv_os_event_alloc();
+    }
+    for (uint32_t k = 0; k < worker_count; ++k) {
+        int rc = pthread_create(&s->workers[k].thread_id, NULL, backend_thread, &s->workers[k]);
+        if (rc) {
+            JSDRV_LOGE("pthread_create failed: %d", rc);
+            s->workers[k].thread_id = 0;
+            finalize(&s->backend);
+            return JSDRV_ERROR_UNSPECIFIED;
+        }
     }
     // todo set thread priority if possible
 
     *backend = &s->backend;
     return 0;
 }
-
@@ -21,18 +21,21 @@
  */
 
 #include "jsdrv_prv/msg_queue.h"
+#include "jsdrv_prv/atomic.h"
 #include "jsdrv_prv/cdef.h"
 #include "jsdrv_prv/event.h"
 #include "jsdrv_prv/log.h"
 #include "jsdrv_prv/platform.h"
 #include "jsdrv_prv/list.h"
 #include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/backend.h"
 #include "jsdrv_prv/dbc.h"
 #include "jsdrv/error_code.h"
 #include <unistd.h>
 #include <pthread.h>
 #include <poll.h>
 #include <errno.h>
+#include <string.h>
 
 
 
@@ -42,10 +45,75 @@
 
 struct msg_queue_s {
     jsdrv_os_event_t event;
-    struct jsdrv_list_s items;
+    struct jsdrv_list_s items;              // locked mode, also SPSC overflow
     pthread_mutex_t mutex;
+
+    // lane modes, see msg_queue_lanes_enable() and msg_queue_qos_enable()
+    bool lanes;
+    bool qos;
+    struct jsdrv_list_s items_lane[MSG_QUEUE_LANE_COUNT];  // lanes except data, guarded by mutex
+    volatile int32_t depth[MSG_QUEUE_LANE_COUNT];
+
+    // single-producer, single-consumer mode, when ring is not NULL
+    struct jsdrvp_msg_s ** ring;
+    uint32_t ring_mask;
+    volatile int32_t ring_head;             // written only by the producer
+    volatile int32_t ring_tail;             // written only by the consumer
+    volatile int32_t overflow;              // items in the overflow list
+    volatile int32_t count;                 // items in the queue, signal on 0 -> 1
+
+    msg_queue_notify_fn volatile notify_fn; // guarded by mutex, see msg_queue_notify_set()
+    void * notify_user_data;
 };
 
+// Call with the mutex held.
+static inline void notify_locked(struct msg_queue_s * q) {
+    if (q->notify_fn) {
+        q->notify_fn(q->notify_user_data);
+    }
+}
+
+static uint8_t lane_classify(const struct jsdrvp_msg_s * msg) {
+    const char * topic = msg->topic;
+    if ((JSDRV_MSG_TYPE_DATA == msg->inner_msg_type) || !topic[0]) {
+        return MSG_QUEUE_LANE_DATA;
+    } else if ((topic[0] == '!') || (JSDRVP_MSG_SOURCE_DIRECT == msg->source)) {
+        return MSG_QUEUE_LANE_CONTROL;  // USB control transfer responses, direct API values
+    }
+    size_t sz = strlen(topic);
+    char c = topic[sz - 1];
+    if ((c == JSDRV_TOPIC_SUFFIX_RETURN_CODE) || (c == JSDRV_TOPIC_SUFFIX_METADATA_RSP)
+            || (0 == strcmp(JSDRV_MSG_OPEN, topic))
+            || (0 == strcmp(JSDRV_USBBK_MSG_BULK_IN_STREAM_OPEN, topic))) {
+        return MSG_QUEUE_LANE_CONTROL;
+    }
+    return MSG_QUEUE_LANE_DATA;  // stream data and messages ordered with it
+}
+
+static inline bool lanes_tracked(const struct msg_queue_s * q) {
+    return q->lanes || q->qos;
+}
+
+static uint8_t lane_get(const struct msg_queue_s * q, const struct jsdrvp_msg_s * msg) {
+    uint8_t lane = q->lanes ? lane_classify(msg) : MSG_QUEUE_LANE_DATA;
+    if (q->qos && (MSG_QUEUE_LANE_DATA == lane)) {
+        if (JSDRVP_QOS_CRITICAL == msg->qos) {
+            lane = MSG_QUEUE_LANE_CRITICAL;
+        } else if (JSDRVP_QOS_BACKGROUND == msg->qos) {
+            lane = MSG_QUEUE_LANE_BACKGROUND;
+        }
+    }
+    return lane;
+}
+
+static void notify(struct msg_queue_s * q) {
+    if (q->notify_fn) {  // unlocked check, most queues do not notify
+        pthread_mutex_lock(&q->mutex);
+        notify_locked(q);
+        pthread_mutex_unlock(&q->mutex);
+    }
+}
+
 struct msg_queue_s * msg_queue_init(void) {
     struct msg_queue_s * q = jsdrv_alloc_clr(sizeof(struct msg_queue_s));
     if (pthread_mutex_init(&q->mutex, NULL)) {
@@ -59,23 +127,123 @@ struct msg_queue_s * msg_queue_init(void) {
     }
     //JSDRV_LOGI("msg_queue_init %p %p", q, q->available_event);
     jsdrv_list_initialize(&q->items);
+    for (uint32_t lane = 0; lane < MSG_QUEUE_LANE_COUNT; ++lane) {
+        jsdrv_list_initialize(&q->items_lane[lane]);
+    }
+    return q;
+}
+
+void msg_queue_lanes_enable(struct msg_queue_s * queue) {
+    queue->lanes = true;
+}
+
+void msg_queue_qos_enable(struct msg_queue_s * queue) {
+    queue->qos = true;
+}
+
+uint32_t msg_queue_depth(struct msg_queue_s * queue, uint8_t lane) {
+    if ((NULL == queue) || (lane >= MSG_QUEUE_LANE_COUNT)) {
+        return 0;
+    }
+    int32_t depth = jsdrv_atomic_load(&queue->depth[lane]);
+    return (depth > 0) ? (uint32_t) depth : 0;
+}
+
+struct msg_queue_s * msg_queue_init_spsc(uint32_t capacity) {
+    uint32_t sz = 2;
+    while (sz < capacity) {
+        sz <<= 1;
+    }
+    struct msg_queue_s * q = msg_queue_init();
+    if (NULL != q) {
+        q->ring = jsdrv_alloc_clr(sz * sizeof(struct jsdrvp_msg_s *));
+        q->ring_mask = sz - 1;
+    }
     return q;
 }
 
+static bool ring_push(struct msg_queue_s * q, struct jsdrvp_msg_s * msg) {
+    uint32_t head = (uint32_t) q->ring_head;  // only modified by this thread
+    uint32_t tail = (uint32_t) jsdrv_atomic_load(&q->ring_tail);
+    if ((head - tail) > q->ring_mask) {
+        return false;  // full
+    }
+    q->ring[head & q->ring_mask] = msg;
+    jsdrv_atomic_store(&q->ring_head, (int32_t) (head + 1));  // publish
+    return true;
+}
+
+static struct jsdrvp_msg_s * ring_pop(struct msg_queue_s * q) {
+    uint32_t tail = (uint32_t) q->ring_tail;  // only modified by this thread
+    uint32_t head = (uint32_t) jsdrv_atomic_load(&q->ring_head);
+    if (head == tail) {
+        return NULL;  // empty
+    }
+    struct jsdrvp_msg_s * msg = q->ring[tail & q->ring_mask];
+    jsdrv_atomic_store(&q->ring_tail, (int32_t) (tail + 1));  // release slot
+    return msg;
+}
+
+static struct jsdrvp_msg_s * overflow_pop(struct msg_queue_s * q) {
+    struct jsdrv_list_s * item;
+    struct jsdrvp_msg_s * msg = NULL;
+    pthread_mutex_lock(&q->mutex);
+    item = jsdrv_list_remove_head(&q->items);
+    if (item) {
+        msg = JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item);
+        jsdrv_atomic_add(&q->overflow, -1);
+    }
+    pthread_mutex_unlock(&q->mutex);
+    return msg;
+}
+
+// Call with the mutex held.
+static struct jsdrvp_msg_s * locked_pop(struct jsdrv_list_s * list) {
+    struct jsdrv_list_s * item = jsdrv_list_remove_head(list);
+    return item ? JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item) : NULL;
+}
+
+// Call with the mutex held.
+static struct jsdrvp_msg_s * locked_lane_pop(struct msg_queue_s * q, uint8_t lane) {
+    struct jsdrvp_msg_s * msg = locked_pop(&q->items_lane[lane]);
+    if (msg) {
+        jsdrv_atomic_add(&q->depth[lane], -1);
+    }
+    return msg;
+}
+
+static struct jsdrvp_msg_s * lane_pop(struct msg_queue_s * q, uint8_t lane) {
+    struct jsdrvp_msg_s * msg = NULL;
+    if (0 != jsdrv_atomic_load(&q->depth[lane])) {
+        pthread_mutex_lock(&q->mutex);
+        msg = locked_lane_pop(q, lane);
+        pthread_mutex_unlock(&q->mutex);
+    }
+    return msg;
+}
+
+static void list_free(struct jsdrv_list_s * list) {
+    struct jsdrv_list_s * item;
+    while (NULL != (item = jsdrv_list_remove_tail(list))) {
+        jsdrv_free(JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item));  // presumes heap allocated
+    }
+}
+
 void msg_queue_finalize(struct msg_queue_s * queue) {
     struct jsdrvp_msg_s * msg;
     if (queue) {
-        pthread_mutex_lock(&queue->mutex);
-        while (1) {
-            // return items in the queue.
-            struct jsdrv_list_s * item = jsdrv_list_remove_tail(&queue->items);
-            if (item) {
-                msg = JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item);
+        if (queue->ring) {
+            while (NULL != (msg = ring_pop(queue))) {
                 jsdrv_free(msg);  // presumes heap allocated
-            } else {
-                break;
             }
+            jsdrv_free(queue->ring);
+            queue->ring = NULL;
+        }
+        pthread_mutex_lock(&queue->mutex);
+        for (uint32_t lane = 0; lane < MSG_QUEUE_LANE_COUNT; ++lane) {
+            list_free(&queue->items_lane[lane]);
         }
+        list_free(&queue->items);
         pthread_mutex_unlock(&queue->mutex);
         pthread_mutex_destroy(&queue->mutex);
         jsdrv_os_event_free(queue->event);
@@ -85,29 +253,153 @@ void msg_queue_finalize(struct msg_queue_s * queue) {
 
 bool msg_queue_is_empty(struct msg_queue_s* queue) {
     bool rv;
+    if (queue->ring) {
+        return (jsdrv_atomic_load(&queue->ring_head) == jsdrv_atomic_load(&queue->ring_tail))
+            && (0 == jsdrv_atomic_load(&queue->overflow))
+            && (0 == jsdrv_atomic_load(&queue->depth[MSG_QUEUE_LANE_CONTROL]))
+            && (0 == jsdrv_atomic_load(&queue->depth[MSG_QUEUE_LANE_CRITICAL]))
+            && (0 == jsdrv_atomic_load(&queue->depth[MSG_QUEUE_LANE_BACKGROUND]));
+    }
     pthread_mutex_lock(&queue->mutex);
     rv = jsdrv_list_is_empty(&queue->items);
+    for (uint32_t lane = 0; lane < MSG_QUEUE_LANE_COUNT; ++lane) {
+        rv = rv && jsdrv_list_is_empty(&queue->items_lane[lane]);
+    }
     pthread_mutex_unlock(&queue->mutex);
     return rv;
 }
 
+// Call with the mutex held.
+static void locked_add(struct msg_queue_s * q, struct jsdrvp_msg_s * msg) {
+    uint8_t lane = lane_get(q, msg);
+    if (MSG_QUEUE_LANE_DATA == lane) {
+        jsdrv_list_add_tail(&q->items, &msg->item);
+    } else {
+        jsdrv_list_add_tail(&q->items_lane[lane], &msg->item);
+    }
+    if (lanes_tracked(q)) {
+        jsdrv_atomic_add(&q->depth[lane], 1);
+    }
+}
+
+static void spsc_push(struct msg_queue_s * queue, struct jsdrvp_msg_s * msg) {
+    uint8_t lane = lane_get(queue, msg);
+    if (MSG_QUEUE_LANE_DATA != lane) {
+        pthread_mutex_lock(&queue->mutex);
+        jsdrv_list_add_tail(&queue->items_lane[lane], &msg->item);
+        jsdrv_atomic_add(&queue->depth[lane], 1);
+        pthread_mutex_unlock(&queue->mutex);
+    } else {
+        if (lanes_tracked(queue)) {
+            jsdrv_atomic_add(&queue->depth[MSG_QUEUE_LANE_DATA], 1);
+        }
+        // Once overflowed, continue to overflow until drained to preserve order.
+        if ((0 != jsdrv_atomic_load(&queue->overflow)) || !ring_push(queue, msg)) {
+            pthread_mutex_lock(&queue->mutex);
+            jsdrv_list_add_tail(&queue->items, &msg->item);
+            jsdrv_atomic_add(&queue->overflow, 1);
+            pthread_mutex_unlock(&queue->mutex);
+        }
+    }
+    if (1 == jsdrv_atomic_add(&queue->count, 1)) {
+        jsdrv_os_event_signal(queue->event);  // only on empty -> non-empty
+        notify(queue);
+    }
+}
+
 void msg_queue_push(struct msg_queue_s * queue, struct jsdrvp_msg_s * msg) {
     JSDRV_DBC_NOT_NULL(msg);
     jsdrv_list_remove(&msg->item);  // remove from any existing list
+    if (queue->ring) {
+        spsc_push(queue, msg);
+        return;
+    }
     pthread_mutex_lock(&queue->mutex);
-    jsdrv_list_add_tail(&queue->items, &msg->item);
+    locked_add(queue, msg);
+    notify_locked(queue);
     pthread_mutex_unlock(&queue->mutex);
     jsdrv_os_event_signal(queue->event);
 }
 
-struct jsdrvp_msg_s * msg_queue_pop_immediate(struct msg_queue_s* queue) {
+void msg_queue_push_list(struct msg_queue_s * queue, struct jsdrv_list_s * list) {
     struct jsdrv_list_s * item;
-    struct jsdrvp_msg_s * msg = NULL;
+    if (queue->ring) {
+        while (NULL != (item = jsdrv_list_remove_head(list))) {
+            spsc_push(queue, JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item));
+        }
+        return;
+    }
+    if (jsdrv_list_is_empty(list)) {
+        return;
+    }
     pthread_mutex_lock(&queue->mutex);
-    jsdrv_os_event_reset(queue->event);
-    item = jsdrv_list_remove_head(&queue->items);
-    if (item) {
-        msg = JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item);
+    if (lanes_tracked(queue)) {
+        while (NULL != (item = jsdrv_list_remove_head(list))) {
+            locked_add(queue, JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item));
+        }
+    } else {
+        jsdrv_list_append(&queue->items, list);
+    }
+    notify_locked(queue);
+    pthread_mutex_unlock(&queue->mutex);
+    jsdrv_os_event_signal(queue->event);
+}
+
+static struct jsdrvp_msg_s * spsc_pop_immediate(struct msg_queue_s * queue) {
+    struct jsdrvp_msg_s * msg = lane_pop(queue, MSG_QUEUE_LANE_CONTROL);  // control lane overtakes data
+    if (NULL == msg) {
+        msg = lane_pop(queue, MSG_QUEUE_LANE_CRITICAL);
+    }
+    if (NULL == msg) {
+        msg = ring_pop(queue);
+        if ((NULL == msg) && (0 != jsdrv_atomic_load(&queue->overflow))) {
+            msg = overflow_pop(queue);  // ring items always precede overflow items
+        }
+        if ((NULL != msg) && lanes_tracked(queue)) {
+            jsdrv_atomic_add(&queue->depth[MSG_QUEUE_LANE_DATA], -1);
+        }
+    }
+    if (NULL == msg) {
+        msg = lane_pop(queue, MSG_QUEUE_LANE_BACKGROUND);
+    }
+    if (NULL != msg) {
+        // The count may briefly go negative when the consumer takes a
+        // message before the producer increments the count.
+        jsdrv_atomic_add(&queue->count, -1);
+    } else {
+        // Reset only when drained.  Reassert if the producer added
+        // a message that arrived after our empty check.
+        jsdrv_os_event_reset(queue->event);
+        if (jsdrv_atomic_load(&queue->count) > 0) {
+            jsdrv_os_event_signal(queue->event);
+        }
+    }
+    return msg;
+}
+
+struct jsdrvp_msg_s * msg_queue_pop_immediate(struct msg_queue_s* queue) {
+    struct jsdrvp_msg_s * msg;
+    if (queue->ring) {
+        return spsc_pop_immediate(queue);
+    }
+    pthread_mutex_lock(&queue->mutex);
+    msg = locked_lane_pop(queue, MSG_QUEUE_LANE_CONTROL);
+    if (!msg) {
+        msg = locked_lane_pop(queue, MSG_QUEUE_LANE_CRITICAL);
+    }
+    if (!msg) {
+        msg = locked_pop(&queue->items);
+        if (msg && lanes_tracked(queue)) {
+            jsdrv_atomic_add(&queue->depth[MSG_QUEUE_LANE_DATA], -1);
+        }
+    }
+    if (!msg) {
+        msg = locked_lane_pop(queue, MSG_QUEUE_LANE_BACKGROUND);
+    }
+    if (!msg) {
+        // Reset only when drained.  Producers add under the mutex
+        // before they signal, so a later push signals again.
+        jsdrv_os_event_reset(queue->event);
     }
     pthread_mutex_unlock(&queue->mutex);
     return msg;
@@ -133,8 +425,7 @@ int32_t msg_queue_pop(struct msg_queue_s* queue, struct jsdrvp_msg_s ** msg, uin
                 return JSDRV_SUCCESS;
             }
         } else if (0 == rv) {
-            JSDRV_LOGE("msg_queue_pop timed out");
-            return JSDRV_ERROR_TIMED_OUT;
+            return JSDRV_ERROR_TIMED_OUT;  // expected when polling, as on Windows
         } else {
             JSDRV_LOGE("msg_queue_pop error %d", errno);
             return JSDRV_ERROR_IO;
@@ -146,3 +437,10 @@ int32_t msg_queue_pop(struct msg_queue_s* queue, struct jsdrvp_msg_s ** msg, uin
 msg_handle msg_queue_handle_get(struct msg_queue_s* queue) {
     return queue->event->fd_poll;
 }
+
+void msg_queue_notify_set(struct msg_queue_s * queue, msg_queue_notify_fn fn, void * user_data) {
+    pthread_mutex_lock(&queue->mutex);
+    queue->notify_fn = fn;
+    queue->notify_user_data = user_data;
+    pthread_mutex_unlock(&queue->mutex);
+}
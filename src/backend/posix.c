@@ -14,24 +14,52 @@
 * limitations under the License.
 */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  // O_DIRECT
+#endif
+#include "jsdrv_prv/alloc.h"
 #include "jsdrv_prv/assert.h"
+#include "jsdrv_prv/atomic.h"
 #include "jsdrv/cstr.h"
 #include "jsdrv/error_code.h"
 #include "jsdrv_prv/log.h"
+#include "jsdrv_prv/platform.h"
 #include "jsdrv_prv/event.h"
 #include "jsdrv_prv/mutex.h"
 #include "jsdrv_prv/thread.h"
+#include "jsdrv_prv/trace.h"
 #include "jsdrv/time.h"
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <fcntl.h>
 #include <pthread.h>
 #include <poll.h>
+#include <sched.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 #include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+#ifndef JSDRV_URING_ENABLE
+#define JSDRV_URING_ENABLE 0  // CMake enables on Linux with io_uring headers
+#endif
+#if JSDRV_URING_ENABLE
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+#endif
 
 int64_t jsdrv_time_utc(void) {
     struct timespec ts;
@@ -41,6 +69,14 @@ int64_t jsdrv_time_utc(void) {
     return t;
 }
 
+int64_t jsdrv_time_monotonic(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    int64_t t = JSDRV_TIME_SECOND * (int64_t) ts.tv_sec;
+    t += JSDRV_NANOSECONDS_TO_TIME(ts.tv_nsec);
+    return t;
+}
+
 uint32_t jsdrv_time_ms_u32(void) {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
@@ -97,40 +133,73 @@ void jsdrv_fatal(const char * file, uint32_t line, const char * msg) {
 }
 
 void jsdrv_os_event_free(jsdrv_os_event_t ev) {
-    close(ev->fd_signal);
+    if (ev->fd_signal != ev->fd_poll) {
+        close(ev->fd_signal);
+    }
     close(ev->fd_poll);
     jsdrv_free(ev);
 }
 
 jsdrv_os_event_t jsdrv_os_event_alloc(void) {
-    int pipefd[2];
     jsdrv_os_event_t ev;
     ev = jsdrv_alloc_clr(sizeof(*ev));
     if (!ev) {
         return NULL;
     }
+#if defined(__linux__)
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) {
+        jsdrv_free(ev);
+        return NULL;
+    }
+    ev->fd_poll = fd;
+    ev->fd_signal = fd;
+#else
+    int pipefd[2];
     if (pipe(pipefd)) {
         jsdrv_free(ev);
         return NULL;
     }
     ev->fd_poll = pipefd[0];
-    ev->events = POLLIN;
     ev->fd_signal = pipefd[1];
     fcntl(ev->fd_poll, F_SETFL, O_NONBLOCK);
+#endif
+    ev->events = POLLIN;
     return ev;
 }
 
-void jsdrv_os_event_signal(jsdrv_os_event_t ev) {
-    uint8_t wr_buf[1] = {1};
-    if (write(ev->fd_signal, wr_buf, 1) <= 0) {
+static void event_write(jsdrv_os_event_t ev) {
+    uint64_t wr_buf = 1;  // eventfd requires 8 bytes, a pipe only needs 1
+#if defined(__linux__)
+    size_t sz = sizeof(wr_buf);
+#else
+    size_t sz = 1;
+#endif
+    if (write(ev->fd_signal, &wr_buf, sz) <= 0) {
         JSDRV_LOGE("jsdrv_os_event_signal failed %d", errno);
     }
 }
 
+void jsdrv_os_event_signal(jsdrv_os_event_t ev) {
+    if (jsdrv_atomic_exchange(&ev->signaled, 1)) {
+        return;  // already signaled, coalesce
+    }
+    event_write(ev);
+}
+
 void jsdrv_os_event_reset(jsdrv_os_event_t ev) {
-    uint8_t rd_buf[1024];
-    if (read(ev->fd_poll, rd_buf, sizeof(rd_buf)) < 0) {
-        ; // reset even on error.
+    uint64_t rd_buf;
+    // Clear the flag before draining, so a concurrent signal either
+    // coalesces into the write being drained or sets the flag again.
+    // Always drain, since a signal that set the flag before the clear
+    // may write after it.  Callers recheck their state after a reset,
+    // so a spurious wakeup is harmless, but a lost one is not.
+    jsdrv_atomic_exchange(&ev->signaled, 0);
+    while (read(ev->fd_poll, &rd_buf, sizeof(rd_buf)) > 0) {
+        // discard pending writes
+    }
+    if (jsdrv_atomic_load(&ev->signaled)) {
+        event_write(ev);  // a racing signal may have written before the drain
     }
 }
 
@@ -171,26 +240,894 @@ void jsdrv_thread_sleep_ms(uint32_t duration_ms) {
     nanosleep(&ts, NULL);
 }
 
-static jsdrv_os_mutex_t heap_mutex = NULL;
+#define THREAD_REGISTRY_MAX (256U)
+
+struct thread_entry_s {
+    pthread_t thread;
+    int32_t tid;        // Linux kernel thread id for per-thread nice
+    uint8_t role;
+    bool active;
+};
+
+static pthread_mutex_t thread_mutex_ = PTHREAD_MUTEX_INITIALIZER;
+static struct thread_entry_s thread_entries_[THREAD_REGISTRY_MAX];
+static struct jsdrv_thread_policy_s thread_policies_[JSDRV_THREAD_ROLE_COUNT];
+
+static int32_t thread_errno_to_error(int err) {
+    switch (err) {
+        case 0: return 0;
+        case EPERM:  // intentional fall-through
+        case EACCES: return JSDRV_ERROR_PERMISSIONS;
+        case EINVAL: return JSDRV_ERROR_PARAMETER_INVALID;
+        case ENOSYS: return JSDRV_ERROR_NOT_SUPPORTED;
+        default: return JSDRV_ERROR_UNSPECIFIED;
+    }
+}
+
+static int32_t thread_policy_apply(struct thread_entry_s * e, const struct jsdrv_thread_policy_s * p) {
+    int32_t rv = 0;
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    switch (p->sched) {
+        case JSDRV_THREAD_SCHED_DEFAULT:
+            break;
+        case JSDRV_THREAD_SCHED_OTHER:
+            rv = thread_errno_to_error(pthread_setschedparam(e->thread, SCHED_OTHER, &param));
+#if defined(__linux__)
+            if (!rv && setpriority(PRIO_PROCESS, (id_t) e->tid, p->priority)) {
+                rv = thread_errno_to_error(errno);
+            }
+#else
+            if (!rv && p->priority) {
+                rv = JSDRV_ERROR_NOT_SUPPORTED;  // nice applies to the whole process
+            }
+#endif
+            break;
+        default:
+            param.sched_priority = p->priority;
+            rv = thread_errno_to_error(pthread_setschedparam(
+                e->thread, (JSDRV_THREAD_SCHED_FIFO == p->sched) ? SCHED_FIFO : SCHED_RR, &param));
+            break;
+    }
+    if (p->affinity) {
+#if defined(__linux__)
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        for (int i = 0; i < 64; ++i) {
+            if (p->affinity & (1ULL << i)) {
+                CPU_SET(i, &cpuset);
+            }
+        }
+        int32_t rc = thread_errno_to_error(pthread_setaffinity_np(e->thread, sizeof(cpuset), &cpuset));
+#else
+        int32_t rc = JSDRV_ERROR_NOT_SUPPORTED;
+#endif
+        rv = rv ? rv : rc;
+    }
+    return rv;
+}
+
+void jsdrv_thread_register(uint8_t role) {
+    struct thread_entry_s * e = NULL;
+    struct jsdrv_thread_policy_s policy;
+    int32_t rc = 0;
+    if (role >= JSDRV_THREAD_ROLE_COUNT) {
+        return;
+    }
+    jsdrv_alloc_thread_cache_start();
+    jsdrv_trace_thread_start(role);
+    pthread_mutex_lock(&thread_mutex_);
+    for (uint32_t i = 0; i < THREAD_REGISTRY_MAX; ++i) {
+        if (!thread_entries_[i].active) {
+            e = &thread_entries_[i];
+            e->thread = pthread_self();
+#if defined(__linux__)
+            e->tid = (int32_t) syscall(SYS_gettid);
+#endif
+            e->role = role;
+            e->active = true;
+            policy = thread_policies_[role];
+            rc = thread_policy_apply(e, &policy);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&thread_mutex_);
+    if (NULL == e) {
+        JSDRV_LOGW("thread register role %d: registry full", (int) role);
+    } else if (rc) {
+        JSDRV_LOGW("thread register role %d: policy failed %d", (int) role, (int) rc);
+    }
+}
+
+void jsdrv_thread_unregister(void) {
+    pthread_t self = pthread_self();
+    pthread_mutex_lock(&thread_mutex_);
+    for (uint32_t i = 0; i < THREAD_REGISTRY_MAX; ++i) {
+        struct thread_entry_s * e = &thread_entries_[i];
+        if (e->active && pthread_equal(e->thread, self)) {
+            e->active = false;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&thread_mutex_);
+    jsdrv_trace_thread_stop();
+    jsdrv_alloc_thread_cache_stop();
+}
+
+int32_t jsdrv_thread_policy_set(uint8_t role, const struct jsdrv_thread_policy_s * policy) {
+    int32_t rv = 0;
+    if ((role >= JSDRV_THREAD_ROLE_COUNT) || (policy->sched > JSDRV_THREAD_SCHED_RR)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    } else if ((JSDRV_THREAD_SCHED_OTHER == policy->sched) && ((policy->priority < -20) || (policy->priority > 19))) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    } else if ((policy->sched >= JSDRV_THREAD_SCHED_FIFO) && ((policy->priority < 1) || (policy->priority > 99))) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    pthread_mutex_lock(&thread_mutex_);
+    thread_policies_[role] = *policy;
+    for (uint32_t i = 0; i < THREAD_REGISTRY_MAX; ++i) {
+        struct thread_entry_s * e = &thread_entries_[i];
+        if (e->active && (e->role == role)) {
+            int32_t rc = thread_policy_apply(e, policy);
+            rv = rv ? rv : rc;
+        }
+    }
+    pthread_mutex_unlock(&thread_mutex_);
+    if (rv) {
+        JSDRV_LOGW("thread policy role %d: failed %d", (int) role, (int) rv);
+    }
+    return rv;
+}
+
+int32_t jsdrv_thread_policy_get(uint8_t role, struct jsdrv_thread_policy_s * policy) {
+    if (role >= JSDRV_THREAD_ROLE_COUNT) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    pthread_mutex_lock(&thread_mutex_);
+    *policy = thread_policies_[role];
+    pthread_mutex_unlock(&thread_mutex_);
+    return 0;
+}
+
+uint32_t jsdrv_thread_role_count(uint8_t role) {
+    uint32_t count = 0;
+    pthread_mutex_lock(&thread_mutex_);
+    for (uint32_t i = 0; i < THREAD_REGISTRY_MAX; ++i) {
+        if (thread_entries_[i].active && (thread_entries_[i].role == role)) {
+            ++count;
+        }
+    }
+    pthread_mutex_unlock(&thread_mutex_);
+    return count;
+}
+
+static int64_t thread_cpu_time(struct thread_entry_s * e) {
+#if defined(__APPLE__)
+    (void) e;
+    return -1;  // no pthread_getcpuclockid()
+#else
+    clockid_t clock_id;
+    struct timespec ts;
+    if (pthread_getcpuclockid(e->thread, &clock_id) || clock_gettime(clock_id, &ts)) {
+        return -1;
+    }
+    return JSDRV_TIME_SECOND * (int64_t) ts.tv_sec + JSDRV_NANOSECONDS_TO_TIME((uint64_t) ts.tv_nsec);
+#endif
+}
+
+uint32_t jsdrv_thread_cpu_get(struct jsdrv_thread_cpu_s * threads, uint32_t threads_max) {
+    uint32_t count = 0;
+    pthread_mutex_lock(&thread_mutex_);
+    for (uint32_t i = 0; (i < THREAD_REGISTRY_MAX) && (count < threads_max); ++i) {
+        struct thread_entry_s * e = &thread_entries_[i];
+        if (e->active) {
+            struct jsdrv_thread_cpu_s * t = &threads[count++];
+            t->role = e->role;
+#if defined(__linux__)
+            t->id = e->tid;
+#else
+            t->id = (int64_t) (uintptr_t) e->thread;
+#endif
+            t->cpu_time = thread_cpu_time(e);
+        }
+    }
+    pthread_mutex_unlock(&thread_mutex_);
+    return count;
+}
+
+void * jsdrv_os_file_map_alloc(size_t size_bytes, const char * dir) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/jsdrv_XXXXXX", dir);
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        JSDRV_LOGE("file map create failed in %s: %d", dir, errno);
+        return NULL;
+    }
+    unlink(path);  // delete on close, even on crash
+    if (ftruncate(fd, (off_t) size_bytes)) {
+        JSDRV_LOGE("file map resize to %zu failed: %d", size_bytes, errno);
+        close(fd);
+        return NULL;
+    }
+    void * ptr = mmap(NULL, size_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // mapping holds the reference
+    if (MAP_FAILED == ptr) {
+        JSDRV_LOGE("file map of %zu bytes failed: %d", size_bytes, errno);
+        return NULL;
+    }
+    JSDRV_LOGI("file map %zu bytes in %s", size_bytes, dir);
+    return ptr;
+}
+
+void jsdrv_os_file_map_free(void * ptr, size_t size_bytes) {
+    if (NULL != ptr) {
+        munmap(ptr, size_bytes);
+    }
+}
+
+struct jsdrv_os_shm_s {
+    void * ptr;
+    size_t size;
+    bool owner;
+    char name[72];  // "/" + name
+};
+
+static int32_t shm_name(struct jsdrv_os_shm_s * shm, const char * name) {
+    size_t sz = name ? strlen(name) : 0;
+    if ((0 == sz) || ((sz + 2) > sizeof(shm->name))) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    for (size_t i = 0; i < sz; ++i) {
+        char c = name[i];
+        if (!(((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9'))
+                || (c == '_') || (c == '-') || (c == '.'))) {
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+    }
+    shm->name[0] = '/';
+    memcpy(shm->name + 1, name, sz + 1);
+    return 0;
+}
+
+struct jsdrv_os_shm_s * jsdrv_os_shm_create(const char * name, size_t size_bytes) {
+    struct jsdrv_os_shm_s * shm = jsdrv_alloc_clr(sizeof(struct jsdrv_os_shm_s));
+    if (shm_name(shm, name) || (0 == size_bytes)) {
+        jsdrv_free(shm);
+        return NULL;
+    }
+    shm_unlink(shm->name);  // replace any stale region
+    int fd = shm_open(shm->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        JSDRV_LOGE("shm create %s failed: %d", shm->name, errno);
+        jsdrv_free(shm);
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t) size_bytes)) {
+        JSDRV_LOGE("shm %s resize to %zu failed: %d", shm->name, size_bytes, errno);
+        close(fd);
+        shm_unlink(shm->name);
+        jsdrv_free(shm);
+        return NULL;
+    }
+    shm->ptr = mmap(NULL, size_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // mapping holds the reference
+    if (MAP_FAILED == shm->ptr) {
+        JSDRV_LOGE("shm %s map of %zu bytes failed: %d", shm->name, size_bytes, errno);
+        shm_unlink(shm->name);
+        jsdrv_free(shm);
+        return NULL;
+    }
+    shm->size = size_bytes;
+    shm->owner = true;
+    return shm;
+}
+
+struct jsdrv_os_shm_s * jsdrv_os_shm_open(const char * name) {
+    struct stat st;
+    struct jsdrv_os_shm_s * shm = jsdrv_alloc_clr(sizeof(struct jsdrv_os_shm_s));
+    if (shm_name(shm, name)) {
+        jsdrv_free(shm);
+        return NULL;
+    }
+    int fd = shm_open(shm->name, O_RDONLY, 0);
+    if (fd < 0) {
+        jsdrv_free(shm);
+        return NULL;
+    }
+    if (fstat(fd, &st) || (st.st_size <= 0)) {
+        close(fd);
+        jsdrv_free(shm);
+        return NULL;
+    }
+    shm->size = (size_t) st.st_size;
+    shm->ptr = mmap(NULL, shm->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == shm->ptr) {
+        jsdrv_free(shm);
+        return NULL;
+    }
+    return shm;
+}
+
+void * jsdrv_os_shm_ptr(struct jsdrv_os_shm_s * shm, size_t * size_bytes) {
+    if (size_bytes) {
+        *size_bytes = shm->size;
+    }
+    return shm->ptr;
+}
+
+void jsdrv_os_shm_close(struct jsdrv_os_shm_s * shm) {
+    if (NULL == shm) {
+        return;
+    }
+    munmap(shm->ptr, shm->size);
+    if (shm->owner) {
+        shm_unlink(shm->name);
+    }
+    jsdrv_free(shm);
+}
+
+#if JSDRV_URING_ENABLE
+#define URING_ENTRIES (32U)
+
+struct uring_s {
+    int fd;
+    void * sq_ring;
+    size_t sq_ring_size;
+    void * cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe * sqes;
+    size_t sqes_size;
+    uint32_t * sq_head;
+    uint32_t * sq_tail;
+    uint32_t * sq_array;
+    uint32_t sq_mask;
+    uint32_t * cq_head;
+    uint32_t * cq_tail;
+    struct io_uring_cqe * cqes;
+    uint32_t cq_mask;
+    const uint8_t * buf;    // the registered buffer or NULL
+    size_t buf_size;
+};
+#endif
+
+struct jsdrv_os_file_s {
+    int fd;
+    bool direct;
+    bool preallocated;
+    uint64_t offset;        // the end of the written data
+#if JSDRV_URING_ENABLE
+    struct uring_s * uring;
+#endif
+};
+
+#if JSDRV_URING_ENABLE
+
+static void uring_close(struct uring_s * u) {
+    if (NULL == u) {
+        return;
+    }
+    if (u->sqes) {
+        munmap(u->sqes, u->sqes_size);
+    }
+    if (u->cq_ring) {
+        munmap(u->cq_ring, u->cq_ring_size);
+    }
+    if (u->sq_ring) {
+        munmap(u->sq_ring, u->sq_ring_size);
+    }
+    if (u->fd >= 0) {
+        close(u->fd);
+    }
+    jsdrv_free(u);
+}
+
+static void * uring_map(int fd, size_t size, off_t offset) {
+    void * p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return (MAP_FAILED == p) ? NULL : p;
+}
+
+static struct uring_s * uring_open(void) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int) syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+    if (fd < 0) {
+        JSDRV_LOGW("io_uring unavailable: %d", errno);  // ENOSYS, or EPERM when disabled
+        return NULL;
+    }
+    struct uring_s * u = jsdrv_alloc_clr(sizeof(struct uring_s));
+    u->fd = fd;
+    u->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    u->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    u->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    u->sq_ring = uring_map(fd, u->sq_ring_size, IORING_OFF_SQ_RING);
+    u->cq_ring = uring_map(fd, u->cq_ring_size, IORING_OFF_CQ_RING);
+    u->sqes = (struct io_uring_sqe *) uring_map(fd, u->sqes_size, IORING_OFF_SQES);
+    if ((NULL == u->sq_ring) || (NULL == u->cq_ring) || (NULL == u->sqes)) {
+        JSDRV_LOGW("io_uring map failed: %d", errno);
+        uring_close(u);
+        return NULL;
+    }
+    uint8_t * sq = (uint8_t *) u->sq_ring;
+    uint8_t * cq = (uint8_t *) u->cq_ring;
+    u->sq_head = (uint32_t *) (sq + params.sq_off.head);
+    u->sq_tail = (uint32_t *) (sq + params.sq_off.tail);
+    u->sq_array = (uint32_t *) (sq + params.sq_off.array);
+    u->sq_mask = *(uint32_t *) (sq + params.sq_off.ring_mask);
+    u->cq_head = (uint32_t *) (cq + params.cq_off.head);
+    u->cq_tail = (uint32_t *) (cq + params.cq_off.tail);
+    u->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+    u->cq_mask = *(uint32_t *) (cq + params.cq_off.ring_mask);
+    return u;
+}
+
+static int32_t pwrite_all(int fd, const uint8_t * p, size_t size_bytes, uint64_t offset) {
+    while (size_bytes) {
+        ssize_t sz = pwrite(fd, p, size_bytes, (off_t) offset);
+        if (sz < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            JSDRV_LOGE("file write failed: %d", errno);
+            return JSDRV_ERROR_IO;
+        }
+        p += sz;
+        offset += (uint64_t) sz;
+        size_bytes -= (size_t) sz;
+    }
+    return 0;
+}
+
+/*
+ * Submit up to URING_ENTRIES writes at consecutive offsets with a single
+ * io_uring_enter, then wait for all of them.  Completions may arrive
+ * in any order, so each completion finishes any short write itself.
+ */
+static int32_t uring_write(struct jsdrv_os_file_s * f, const struct jsdrv_os_file_chunk_s * chunks, uint32_t count) {
+    struct uring_s * u = f->uring;
+    uint64_t offsets[URING_ENTRIES];
+    uint32_t tail = *u->sq_tail;
+    uint64_t offset = f->offset;
+    for (uint32_t k = 0; k < count; ++k) {
+        const uint8_t * p = (const uint8_t *) chunks[k].ptr;
+        uint32_t idx = (tail + k) & u->sq_mask;
+        struct io_uring_sqe * sqe = &u->sqes[idx];
+        memset(sqe, 0, sizeof(*sqe));
+        bool fixed = u->buf && (p >= u->buf) && ((p + chunks[k].size_bytes) <= (u->buf + u->buf_size));
+        sqe->opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        sqe->fd = f->fd;
+        sqe->off = offset;
+        sqe->addr = (uint64_t) (uintptr_t) p;
+        sqe->len = (uint32_t) chunks[k].size_bytes;
+        sqe->buf_index = 0;
+        sqe->user_data = k;
+        u->sq_array[idx] = idx;
+        offsets[k] = offset;
+        offset += chunks[k].size_bytes;
+    }
+    __atomic_store_n(u->sq_tail, tail + count, __ATOMIC_RELEASE);
+
+    int32_t rv = 0;
+    uint32_t done = 0;
+    while (done < count) {
+        uint32_t to_submit = (tail + count) - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE);
+        int rc = (int) syscall(__NR_io_uring_enter, u->fd, to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if ((rc < 0) && (EINTR != errno)) {
+            JSDRV_LOGE("io_uring_enter failed: %d", errno);
+            return JSDRV_ERROR_IO;  // the ring is unusable with writes in flight
+        }
+        uint32_t head = *u->cq_head;
+        while (head != __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE)) {
+            struct io_uring_cqe * cqe = &u->cqes[head & u->cq_mask];
+            uint32_t k = (uint32_t) cqe->user_data;
+            int32_t res = cqe->res;
+            ++head;
+            ++done;
+            if (res < 0) {
+                JSDRV_LOGE("file write failed: %d", -res);
+                rv = JSDRV_ERROR_IO;
+            } else if ((size_t) res < chunks[k].size_bytes) {
+                const uint8_t * p = (const uint8_t *) chunks[k].ptr;
+                int32_t rc_remain = pwrite_all(f->fd, p + res, chunks[k].size_bytes - (size_t) res,
+                                               offsets[k] + (uint64_t) res);
+                rv = rv ? rv : rc_remain;
+            }
+        }
+        __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+    }
+    if (0 == rv) {
+        f->offset = offset;
+    }
+    return rv;
+}
+
+#endif
+
+struct jsdrv_os_file_s * jsdrv_os_file_open(const char * path, uint32_t flags) {
+    int oflags = O_WRONLY | O_CREAT | O_TRUNC;
+    int fd = -1;
+    bool direct = false;
+#ifdef O_DIRECT
+    if (flags & JSDRV_OS_FILE_FLAG_DIRECT) {
+        fd = open(path, oflags | O_DIRECT, 0644);
+        direct = (fd >= 0);  // EINVAL when the file system does not support O_DIRECT
+    }
+#endif
+    if (fd < 0) {
+        fd = open(path, oflags, 0644);
+    }
+    if (fd < 0) {
+        JSDRV_LOGE("file open failed %s: %d", path, errno);
+        return NULL;
+    }
+#if defined(F_NOCACHE)
+    if ((flags & JSDRV_OS_FILE_FLAG_DIRECT) && (0 == fcntl(fd, F_NOCACHE, 1))) {
+        direct = true;  // macOS: no alignment constraints
+    }
+#endif
+    struct jsdrv_os_file_s * f = jsdrv_alloc_clr(sizeof(struct jsdrv_os_file_s));
+    f->fd = fd;
+    f->direct = direct;
+#if JSDRV_URING_ENABLE
+    if (flags & JSDRV_OS_FILE_FLAG_URING) {
+        f->uring = uring_open();
+    }
+#endif
+    return f;
+}
+
+int32_t jsdrv_os_file_write(struct jsdrv_os_file_s * f, const void * ptr, size_t size_bytes) {
+    const uint8_t * p = (const uint8_t *) ptr;
+#ifdef O_DIRECT
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+    if (f->direct && ((((uintptr_t) p) | size_bytes) & (page_size - 1))) {
+        int oflags = fcntl(f->fd, F_GETFL);
+        if ((oflags < 0) || fcntl(f->fd, F_SETFL, oflags & ~O_DIRECT)) {
+            JSDRV_LOGE("file O_DIRECT clear failed: %d", errno);
+            return JSDRV_ERROR_IO;
+        }
+        f->direct = false;
+    }
+#endif
+    while (size_bytes) {
+        ssize_t sz = pwrite(f->fd, p, size_bytes, (off_t) f->offset);
+        if (sz < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            JSDRV_LOGE("file write failed: %d", errno);
+            return JSDRV_ERROR_IO;
+        }
+        p += sz;
+        f->offset += (uint64_t) sz;
+        size_bytes -= (size_t) sz;
+    }
+    return 0;
+}
+
+int32_t jsdrv_os_file_write_batch(struct jsdrv_os_file_s * f, const struct jsdrv_os_file_chunk_s * chunks, uint32_t count) {
+#if JSDRV_URING_ENABLE
+    if (f->uring) {
+        size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+        bool aligned = true;
+        for (uint32_t k = 0; k < count; ++k) {
+            aligned &= (0 == ((((uintptr_t) chunks[k].ptr) | chunks[k].size_bytes) & (page_size - 1)));
+        }
+        while (aligned && count) {  // jsdrv_os_file_write() handles the unaligned O_DIRECT writes
+            uint32_t n = (count > URING_ENTRIES) ? URING_ENTRIES : count;
+            int32_t rc = uring_write(f, chunks, n);
+            if (rc) {
+                return rc;
+            }
+            chunks += n;
+            count -= n;
+        }
+    }
+#endif
+    for (uint32_t k = 0; k < count; ++k) {
+        int32_t rc = jsdrv_os_file_write(f, chunks[k].ptr, chunks[k].size_bytes);
+        if (rc) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
+int32_t jsdrv_os_file_register(struct jsdrv_os_file_s * f, void * ptr, size_t size_bytes) {
+#if JSDRV_URING_ENABLE
+    if (f->uring) {
+        struct iovec iov = {.iov_base = ptr, .iov_len = size_bytes};
+        if (syscall(__NR_io_uring_register, f->uring->fd, IORING_REGISTER_BUFFERS, &iov, 1)) {
+            JSDRV_LOGW("io_uring register buffers failed: %d", errno);  // ENOMEM from RLIMIT_MEMLOCK
+        } else {
+            f->uring->buf = (const uint8_t *) ptr;
+            f->uring->buf_size = size_bytes;
+        }
+        return 0;
+    }
+#else
+    (void) f;
+    (void) ptr;
+    (void) size_bytes;
+#endif
+    return JSDRV_ERROR_NOT_SUPPORTED;
+}
+
+int32_t jsdrv_os_file_preallocate(struct jsdrv_os_file_s * f, uint64_t size_bytes) {
+#if defined(FALLOC_FL_KEEP_SIZE)
+    if (fallocate(f->fd, FALLOC_FL_KEEP_SIZE, 0, (off_t) size_bytes)) {
+        if (EOPNOTSUPP == errno) {
+            return JSDRV_ERROR_NOT_SUPPORTED;
+        }
+        JSDRV_LOGW("file preallocate %" PRIu64 " failed: %d", size_bytes, errno);
+        return JSDRV_ERROR_IO;
+    }
+#elif defined(F_PREALLOCATE)
+    fstore_t store = {F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0, (off_t) size_bytes, 0};
+    if (-1 == fcntl(f->fd, F_PREALLOCATE, &store)) {
+        store.fst_flags = F_ALLOCATEALL;  // retry without contiguous
+        if (-1 == fcntl(f->fd, F_PREALLOCATE, &store)) {
+            JSDRV_LOGW("file preallocate %" PRIu64 " failed: %d", size_bytes, errno);
+            return JSDRV_ERROR_IO;
+        }
+    }
+#else
+    (void) size_bytes;
+    return JSDRV_ERROR_NOT_SUPPORTED;
+#endif
+    f->preallocated = true;
+    return 0;
+}
+
+int32_t jsdrv_os_file_sync(struct jsdrv_os_file_s * f) {
+#if defined(__linux__)
+    int rc = fdatasync(f->fd);
+#else
+    int rc = fsync(f->fd);
+#endif
+    if (rc) {
+        JSDRV_LOGE("file sync failed: %d", errno);
+        return JSDRV_ERROR_IO;
+    }
+    return 0;
+}
+
+int32_t jsdrv_os_file_close(struct jsdrv_os_file_s * f) {
+    int32_t rc = 0;
+    if (NULL == f) {
+        return 0;
+    }
+#if JSDRV_URING_ENABLE
+    uring_close(f->uring);
+#endif
+    if (f->preallocated) {
+        if (ftruncate(f->fd, (off_t) f->offset)) {  // release the unused reservation
+            JSDRV_LOGW("file truncate failed: %d", errno);
+        }
+    }
+    if (close(f->fd)) {
+        JSDRV_LOGE("file close failed: %d", errno);
+        rc = JSDRV_ERROR_IO;
+    }
+    jsdrv_free(f);
+    return rc;
+}
+
+struct jsdrv_os_socket_s {
+    int fd;
+};
+
+#ifdef MSG_NOSIGNAL
+#define SOCKET_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SOCKET_SEND_FLAGS 0
+#endif
+
+static int32_t socket_addr(const char * host, uint16_t port, struct sockaddr_in * addr) {
+    struct addrinfo hints;
+    struct addrinfo * info = NULL;
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(port);
+    if ((NULL == host) || (0 == host[0])) {
+        addr->sin_addr.s_addr = htonl(INADDR_ANY);
+        return 0;
+    }
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, NULL, &hints, &info) || (NULL == info)) {
+        JSDRV_LOGW("socket host not found: %s", host);
+        return JSDRV_ERROR_NOT_FOUND;
+    }
+    addr->sin_addr = ((struct sockaddr_in *) info->ai_addr)->sin_addr;
+    freeaddrinfo(info);
+    return 0;
+}
+
+static struct jsdrv_os_socket_s * socket_alloc(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    struct jsdrv_os_socket_s * s = jsdrv_alloc_clr(sizeof(struct jsdrv_os_socket_s));
+    s->fd = fd;
+    return s;
+}
+
+static int socket_wait(int fd, short events, uint32_t timeout_ms) {
+    struct pollfd fds = {
+            .fd = fd,
+            .events = events,
+            .revents = 0,
+    };
+    return poll(&fds, 1, (int) timeout_ms);
+}
+
+struct jsdrv_os_socket_s * jsdrv_os_socket_listen(const char * host, uint16_t * port) {
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    int one = 1;
+    if (socket_addr(host, *port, &addr)) {
+        return NULL;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        JSDRV_LOGE("socket create failed: %d", errno);
+        return NULL;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) || listen(fd, 8)
+            || getsockname(fd, (struct sockaddr *) &addr, &addr_len)) {
+        JSDRV_LOGE("socket listen on port %u failed: %d", (unsigned int) *port, errno);
+        close(fd);
+        return NULL;
+    }
+    *port = ntohs(addr.sin_port);
+    struct jsdrv_os_socket_s * s = jsdrv_alloc_clr(sizeof(struct jsdrv_os_socket_s));
+    s->fd = fd;
+    return s;
+}
+
+struct jsdrv_os_socket_s * jsdrv_os_socket_accept(struct jsdrv_os_socket_s * s, uint32_t timeout_ms) {
+    if (socket_wait(s->fd, POLLIN, timeout_ms) <= 0) {
+        return NULL;
+    }
+    int fd = accept(s->fd, NULL, NULL);
+    if (fd < 0) {
+        JSDRV_LOGW("socket accept failed: %d", errno);
+        return NULL;
+    }
+    return socket_alloc(fd);
+}
+
+struct jsdrv_os_socket_s * jsdrv_os_socket_connect(const char * host, uint16_t port) {
+    struct sockaddr_in addr;
+    if ((NULL == host) || socket_addr(host, port, &addr)) {
+        return NULL;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        JSDRV_LOGE("socket create failed: %d", errno);
+        return NULL;
+    }
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr))) {
+        JSDRV_LOGW("socket connect to %s:%u failed: %d", host, (unsigned int) port, errno);
+        close(fd);
+        return NULL;
+    }
+    return socket_alloc(fd);
+}
+
+int32_t jsdrv_os_socket_send(struct jsdrv_os_socket_s * s, const void * ptr, size_t size_bytes) {
+    const uint8_t * p = (const uint8_t *) ptr;
+    while (size_bytes) {
+        ssize_t sz = send(s->fd, p, size_bytes, SOCKET_SEND_FLAGS);
+        if (sz < 0) {
+            if (EINTR == errno) {
+                continue;
+            }
+            JSDRV_LOGW("socket send failed: %d", errno);
+            return JSDRV_ERROR_IO;
+        }
+        p += sz;
+        size_bytes -= (size_t) sz;
+    }
+    return 0;
+}
 
-void jsdrv_free(void * ptr) {
-    jsdrv_os_mutex_lock(heap_mutex);
-    free(ptr);
-    jsdrv_os_mutex_unlock(heap_mutex);
+int32_t jsdrv_os_socket_recv(struct jsdrv_os_socket_s * s, void * ptr, size_t size_bytes,
+                             uint32_t timeout_ms, size_t * received) {
+    *received = 0;
+    int rv = socket_wait(s->fd, POLLIN, timeout_ms);
+    if (0 == rv) {
+        return JSDRV_ERROR_TIMED_OUT;
+    } else if (rv < 0) {
+        return (EINTR == errno) ? JSDRV_ERROR_TIMED_OUT : JSDRV_ERROR_IO;
+    }
+    ssize_t sz = recv(s->fd, ptr, size_bytes, 0);
+    if (0 == sz) {
+        return JSDRV_ERROR_CLOSED;
+    } else if (sz < 0) {
+        return (EINTR == errno) ? JSDRV_ERROR_TIMED_OUT : JSDRV_ERROR_IO;
+    }
+    *received = (size_t) sz;
+    return 0;
 }
 
-void * jsdrv_alloc(size_t size_bytes) {
-    jsdrv_os_mutex_lock(heap_mutex);
-    void * ptr = malloc(size_bytes);
-    if (!ptr) {
-        JSDRV_FATAL("out of memory");
+void jsdrv_os_socket_close(struct jsdrv_os_socket_s * s) {
+    if (NULL == s) {
+        return;
+    }
+    shutdown(s->fd, SHUT_RDWR);
+    close(s->fd);
+    jsdrv_free(s);
+}
+
+#define HUGE_PAGE_SIZE (2U * 1024U * 1024U)
+
+static size_t mem_size_round(size_t size_bytes) {
+    // round to the huge page size so that free matches alloc regardless of flags
+    return (size_bytes + HUGE_PAGE_SIZE - 1) & ~((size_t) HUGE_PAGE_SIZE - 1);
+}
+
+void * jsdrv_os_mem_alloc(size_t size_bytes, uint32_t flags, int32_t numa_node) {
+    size_t sz = mem_size_round(size_bytes);
+    void * ptr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (flags & JSDRV_OS_MEM_FLAG_HUGE) {
+        ptr = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (MAP_FAILED == ptr) {
+            JSDRV_LOGI("explicit huge pages unavailable: %d", errno);
+        }
+    }
+#endif
+    if (MAP_FAILED == ptr) {
+        ptr = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == ptr) {
+            JSDRV_LOGE("mem alloc of %zu bytes failed: %d", sz, errno);
+            return NULL;
+        }
+#ifdef MADV_HUGEPAGE
+        if ((flags & JSDRV_OS_MEM_FLAG_HUGE) && madvise(ptr, sz, MADV_HUGEPAGE)) {
+            JSDRV_LOGI("transparent huge pages unavailable: %d", errno);
+        }
+#endif
+    }
+    if (numa_node >= 0) {
+#if defined(SYS_mbind)
+        unsigned long mask[(64 + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long))] = {0};
+        const long mpol_preferred = 1;  // numaif.h MPOL_PREFERRED, without the libnuma dependency
+        if (numa_node >= 64) {
+            JSDRV_LOGW("numa node %d out of range", (int) numa_node);
+        } else {
+            mask[numa_node / (8 * sizeof(unsigned long))] |= 1UL << (numa_node % (8 * sizeof(unsigned long)));
+            if (syscall(SYS_mbind, ptr, sz, mpol_preferred, mask, (unsigned long) (8 * sizeof(mask)), 0)) {
+                JSDRV_LOGW("numa node %d bind failed: %d", (int) numa_node, errno);
+            }
+        }
+#else
+        JSDRV_LOGW("numa node binding not supported");
+#endif
+    }
+    if (flags & JSDRV_OS_MEM_FLAG_PREFAULT) {
+        size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+        volatile uint8_t * p = (volatile uint8_t *) ptr;
+        for (size_t offset = 0; offset < sz; offset += page_size) {
+            p[offset] = 0;
+        }
     }
-    jsdrv_os_mutex_unlock(heap_mutex);
     return ptr;
 }
 
+void jsdrv_os_mem_free(void * ptr, size_t size_bytes) {
+    if (NULL != ptr) {
+        munmap(ptr, mem_size_round(size_bytes));
+    }
+}
+
 int32_t jsdrv_platform_initialize(void) {
-    heap_mutex = jsdrv_os_mutex_alloc("heap");
     struct rlimit limit = {
         .rlim_cur = 0,
         .rlim_max = 0,
@@ -14,14 +14,20 @@
 * limitations under the License.
 */
 
+#include <winsock2.h>  // before windows.h
+#include <ws2tcpip.h>
 #include "jsdrv_prv/windows.h"
 #include "jsdrv/error_code.h"
+#include "jsdrv_prv/alloc.h"
 #include "jsdrv_prv/assert.h"
 #include "jsdrv/cstr.h"
 #include "jsdrv_prv/event.h"
 #include "jsdrv_prv/mutex.h"
+#include "jsdrv_prv/platform.h"
 #include "jsdrv_prv/thread.h"
+#include "jsdrv_prv/trace.h"
 #include "jsdrv/time.h"
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -72,6 +78,16 @@ int64_t jsdrv_time_utc(void) {
     return JSDRV_COUNTER_TO_TIME(t, frequency);
 }
 
+int64_t jsdrv_time_monotonic(void) {
+    static LARGE_INTEGER frequency = {.QuadPart = 0};
+    LARGE_INTEGER counter;
+    if (0 == frequency.QuadPart) {
+        QueryPerformanceFrequency(&frequency);  // fixed at boot
+    }
+    QueryPerformanceCounter(&counter);
+    return JSDRV_COUNTER_TO_TIME((uint64_t) counter.QuadPart, (uint64_t) frequency.QuadPart);
+}
+
 uint32_t jsdrv_time_ms_u32(void) {
     return GetTickCount();
 }
@@ -199,26 +215,601 @@ void jsdrv_thread_sleep_ms(uint32_t duration_ms) {
     Sleep(duration_ms);
 }
 
-static jsdrv_os_mutex_t heap_mutex = NULL;
+#define THREAD_REGISTRY_MAX (256U)
+
+struct thread_entry_s {
+    HANDLE thread;      // duplicated handle owned by the registry
+    DWORD thread_id;
+    uint8_t role;
+    bool active;
+};
+
+static SRWLOCK thread_lock_ = SRWLOCK_INIT;
+static struct thread_entry_s thread_entries_[THREAD_REGISTRY_MAX];
+static struct jsdrv_thread_policy_s thread_policies_[JSDRV_THREAD_ROLE_COUNT];
+
+static int32_t thread_last_error(void) {
+    return (ERROR_ACCESS_DENIED == GetLastError()) ? JSDRV_ERROR_PERMISSIONS : JSDRV_ERROR_UNSPECIFIED;
+}
+
+static int thread_priority_level(const struct jsdrv_thread_policy_s * p) {
+    if (JSDRV_THREAD_SCHED_OTHER == p->sched) {
+        // map nice to the nearest relative priority level
+        if (p->priority <= -15) {
+            return THREAD_PRIORITY_HIGHEST;
+        } else if (p->priority <= -5) {
+            return THREAD_PRIORITY_ABOVE_NORMAL;
+        } else if (p->priority < 5) {
+            return THREAD_PRIORITY_NORMAL;
+        } else if (p->priority < 15) {
+            return THREAD_PRIORITY_BELOW_NORMAL;
+        }
+        return THREAD_PRIORITY_LOWEST;
+    }
+    return (p->priority >= 50) ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+}
+
+static int32_t thread_policy_apply(struct thread_entry_s * e, const struct jsdrv_thread_policy_s * p) {
+    int32_t rv = 0;
+    if ((JSDRV_THREAD_SCHED_DEFAULT != p->sched) && !SetThreadPriority(e->thread, thread_priority_level(p))) {
+        rv = thread_last_error();
+    }
+    if (p->affinity && !SetThreadAffinityMask(e->thread, (DWORD_PTR) p->affinity)) {
+        rv = rv ? rv : thread_last_error();
+    }
+    return rv;
+}
+
+void jsdrv_thread_register(uint8_t role) {
+    struct thread_entry_s * e = NULL;
+    struct jsdrv_thread_policy_s policy;
+    HANDLE thread = NULL;
+    int32_t rc = 0;
+    if (role >= JSDRV_THREAD_ROLE_COUNT) {
+        return;
+    }
+    jsdrv_alloc_thread_cache_start();
+    jsdrv_trace_thread_start(role);
+    if (!DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &thread,
+                         0, FALSE, DUPLICATE_SAME_ACCESS)) {
+        WINDOWS_LOGE("%s", "DuplicateHandle");
+        return;
+    }
+    AcquireSRWLockExclusive(&thread_lock_);
+    for (uint32_t i = 0; i < THREAD_REGISTRY_MAX; ++i) {
+        if (!thread_entries_[i].active) {
+            e = &thread_entries_[i];
+            e->thread = thread;
+            e->thread_id = GetCurrentThreadId();
+            e->role = role;
+            e->active = true;
+            policy = thread_policies_[role];
+            rc = thread_policy_apply(e, &policy);
+            break;
+        }
+    }
+    ReleaseSRWLockExclusive(&thread_lock_);
+    if (NULL == e) {
+        CloseHandle(thread);
+        JSDRV_LOGW("thread register role %d: registry full", (int) role);
+    } else if (rc) {
+        JSDRV_LOGW("thread register role %d: policy failed %d", (int) role, (int) rc);
+    }
+}
+
+void jsdrv_thread_unregister(void) {
+    HANDLE thread = NULL;
+    DWORD thread_id = GetCurrentThreadId();
+    AcquireSRWLockExclusive(&thread_lock_);
+    for (uint32_t i = 0; i < THREAD_REGISTRY_MAX; ++i) {
+        struct thread_entry_s * e = &thread_entries_[i];
+        if (e->active && (e->thread_id == thread_id)) {
+            thread = e->thread;
+            e->thread = NULL;
+            e->active = false;
+            break;
+        }
+    }
+    ReleaseSRWLockExclusive(&thread_lock_);
+    if (NULL != thread) {
+        CloseHandle(thread);
+    }
+    jsdrv_trace_thread_stop();
+    jsdrv_alloc_thread_cache_stop();
+}
+
+int32_t jsdrv_thread_policy_set(uint8_t role, const struct jsdrv_thread_policy_s * policy) {
+    int32_t rv = 0;
+    if ((role >= JSDRV_THREAD_ROLE_COUNT) || (policy->sched > JSDRV_THREAD_SCHED_RR)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    } else if ((JSDRV_THREAD_SCHED_OTHER == policy->sched) && ((policy->priority < -20) || (policy->priority > 19))) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    } else if ((policy->sched >= JSDRV_THREAD_SCHED_FIFO) && ((policy->priority < 1) || (policy->priority > 99))) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    AcquireSRWLockExclusive(&thread_lock_);
+    thread_policies_[role] = *policy;
+    for (uint32_t i = 0; i < THREAD_REGISTRY_MAX; ++i) {
+        struct thread_entry_s * e = &thread_entries_[i];
+        if (e->active && (e->role == role)) {
+            int32_t rc = thread_policy_apply(e, policy);
+            rv = rv ? rv : rc;
+        }
+    }
+    ReleaseSRWLockExclusive(&thread_lock_);
+    if (rv) {
+        JSDRV_LOGW("thread policy role %d: failed %d", (int) role, (int) rv);
+    }
+    return rv;
+}
+
+int32_t jsdrv_thread_policy_get(uint8_t role, struct jsdrv_thread_policy_s * policy) {
+    if (role >= JSDRV_THREAD_ROLE_COUNT) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    AcquireSRWLockShared(&thread_lock_);
+    *policy = thread_policies_[role];
+    ReleaseSRWLockShared(&thread_lock_);
+    return 0;
+}
+
+uint32_t jsdrv_thread_role_count(uint8_t role) {
+    uint32_t count = 0;
+    AcquireSRWLockShared(&thread_lock_);
+    for (uint32_t i = 0; i < THREAD_REGISTRY_MAX; ++i) {
+        if (thread_entries_[i].active && (thread_entries_[i].role == role)) {
+            ++count;
+        }
+    }
+    ReleaseSRWLockShared(&thread_lock_);
+    return count;
+}
 
-void jsdrv_free(void * ptr) {
-    jsdrv_os_mutex_lock(heap_mutex);
-    free(ptr);
-    jsdrv_os_mutex_unlock(heap_mutex);
+uint32_t jsdrv_thread_cpu_get(struct jsdrv_thread_cpu_s * threads, uint32_t threads_max) {
+    uint32_t count = 0;
+    FILETIME t_create;
+    FILETIME t_exit;
+    FILETIME t_kernel;
+    FILETIME t_user;
+    AcquireSRWLockShared(&thread_lock_);
+    for (uint32_t i = 0; (i < THREAD_REGISTRY_MAX) && (count < threads_max); ++i) {
+        struct thread_entry_s * e = &thread_entries_[i];
+        if (e->active) {
+            struct jsdrv_thread_cpu_s * t = &threads[count++];
+            t->role = e->role;
+            t->id = e->thread_id;
+            t->cpu_time = -1;
+            if (GetThreadTimes(e->thread, &t_create, &t_exit, &t_kernel, &t_user)) {
+                uint64_t k = (((uint64_t) t_kernel.dwHighDateTime) << 32) | t_kernel.dwLowDateTime;
+                uint64_t u = (((uint64_t) t_user.dwHighDateTime) << 32) | t_user.dwLowDateTime;
+                t->cpu_time = JSDRV_COUNTER_TO_TIME(k + u, 10000000ULL);  // 100 ns units
+            }
+        }
+    }
+    ReleaseSRWLockShared(&thread_lock_);
+    return count;
 }
 
-void * jsdrv_alloc(size_t size_bytes) {
-    jsdrv_os_mutex_lock(heap_mutex);
-    void * ptr = malloc(size_bytes);
-    if (!ptr) {
-        JSDRV_FATAL("out of memory");
+void * jsdrv_os_mem_alloc(size_t size_bytes, uint32_t flags, int32_t numa_node) {
+    void * ptr = NULL;
+    HANDLE process = GetCurrentProcess();
+    if (flags & JSDRV_OS_MEM_FLAG_HUGE) {
+        // requires SeLockMemoryPrivilege, large pages are committed and locked
+        size_t large = GetLargePageMinimum();
+        if (large) {
+            size_t sz = (size_bytes + large - 1) & ~(large - 1);
+            DWORD type = MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES;
+            if (numa_node >= 0) {
+                ptr = VirtualAllocExNuma(process, NULL, sz, type, PAGE_READWRITE, (DWORD) numa_node);
+            } else {
+                ptr = VirtualAlloc(NULL, sz, type, PAGE_READWRITE);
+            }
+        }
+        if (NULL == ptr) {
+            JSDRV_LOGI("large pages unavailable: %lu", GetLastError());
+        }
+    }
+    if (NULL == ptr) {
+        DWORD type = MEM_RESERVE | MEM_COMMIT;
+        if (numa_node >= 0) {
+            ptr = VirtualAllocExNuma(process, NULL, size_bytes, type, PAGE_READWRITE, (DWORD) numa_node);
+        } else {
+            ptr = VirtualAlloc(NULL, size_bytes, type, PAGE_READWRITE);
+        }
+        if (NULL == ptr) {
+            WINDOWS_LOGE("mem alloc of %zu bytes failed", size_bytes);
+            return NULL;
+        }
+    }
+    if (flags & JSDRV_OS_MEM_FLAG_PREFAULT) {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        volatile uint8_t * p = (volatile uint8_t *) ptr;
+        for (size_t offset = 0; offset < size_bytes; offset += info.dwPageSize) {
+            p[offset] = 0;
+        }
     }
-    jsdrv_os_mutex_unlock(heap_mutex);
     return ptr;
 }
 
+void jsdrv_os_mem_free(void * ptr, size_t size_bytes) {
+    (void) size_bytes;
+    if (NULL != ptr) {
+        VirtualFree(ptr, 0, MEM_RELEASE);
+    }
+}
+
+void * jsdrv_os_file_map_alloc(size_t size_bytes, const char * dir) {
+    char path[MAX_PATH];
+    if (0 == GetTempFileNameA(dir, "jsd", 0, path)) {
+        WINDOWS_LOGE("file map create failed in %s", dir);
+        return NULL;
+    }
+    HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+    if (INVALID_HANDLE_VALUE == file) {
+        WINDOWS_LOGE("file map open failed: %s", path);
+        DeleteFileA(path);
+        return NULL;
+    }
+    uint64_t sz = (uint64_t) size_bytes;
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+                                        (DWORD) (sz >> 32), (DWORD) (sz & 0xffffffffU), NULL);
+    void * ptr = NULL;
+    if (NULL == mapping) {
+        WINDOWS_LOGE("file map mapping failed: %s", path);
+    } else {
+        ptr = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size_bytes);
+        if (NULL == ptr) {
+            WINDOWS_LOGE("file map view failed: %s", path);
+        }
+        CloseHandle(mapping);  // view holds the reference
+    }
+    CloseHandle(file);         // deleted after the view is unmapped
+    return ptr;
+}
+
+void jsdrv_os_file_map_free(void * ptr, size_t size_bytes) {
+    (void) size_bytes;
+    if (NULL != ptr) {
+        UnmapViewOfFile(ptr);
+    }
+}
+
+struct jsdrv_os_shm_s {
+    HANDLE h;
+    void * ptr;
+    size_t size;
+};
+
+static int32_t shm_name(char * tgt, size_t tgt_size, const char * name) {
+    size_t sz = name ? strlen(name) : 0;
+    if ((0 == sz) || ((sz + 7) > tgt_size)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    for (size_t i = 0; i < sz; ++i) {
+        char c = name[i];
+        if (!(((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9'))
+                || (c == '_') || (c == '-') || (c == '.'))) {
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+    }
+    snprintf(tgt, tgt_size, "Local\\%s", name);
+    return 0;
+}
+
+struct jsdrv_os_shm_s * jsdrv_os_shm_create(const char * name, size_t size_bytes) {
+    char path[80];
+    if (shm_name(path, sizeof(path), name) || (0 == size_bytes)) {
+        return NULL;
+    }
+    // The pagefile-backed mapping is zero-initialized and removed with the last handle.
+    HANDLE h = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                  (DWORD) (((uint64_t) size_bytes) >> 32), (DWORD) size_bytes, path);
+    if (NULL == h) {
+        JSDRV_LOGE("shm create %s failed: %lu", path, GetLastError());
+        return NULL;
+    } else if (ERROR_ALREADY_EXISTS == GetLastError()) {
+        JSDRV_LOGE("shm %s in use", path);
+        CloseHandle(h);
+        return NULL;
+    }
+    void * ptr = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, size_bytes);
+    if (NULL == ptr) {
+        JSDRV_LOGE("shm %s map of %zu bytes failed: %lu", path, size_bytes, GetLastError());
+        CloseHandle(h);
+        return NULL;
+    }
+    struct jsdrv_os_shm_s * shm = jsdrv_alloc_clr(sizeof(struct jsdrv_os_shm_s));
+    shm->h = h;
+    shm->ptr = ptr;
+    shm->size = size_bytes;
+    return shm;
+}
+
+struct jsdrv_os_shm_s * jsdrv_os_shm_open(const char * name) {
+    char path[80];
+    MEMORY_BASIC_INFORMATION info;
+    if (shm_name(path, sizeof(path), name)) {
+        return NULL;
+    }
+    HANDLE h = OpenFileMappingA(FILE_MAP_READ, FALSE, path);
+    if (NULL == h) {
+        return NULL;
+    }
+    void * ptr = MapViewOfFile(h, FILE_MAP_READ, 0, 0, 0);
+    if ((NULL == ptr) || (0 == VirtualQuery(ptr, &info, sizeof(info)))) {
+        if (ptr) {
+            UnmapViewOfFile(ptr);
+        }
+        CloseHandle(h);
+        return NULL;
+    }
+    struct jsdrv_os_shm_s * shm = jsdrv_alloc_clr(sizeof(struct jsdrv_os_shm_s));
+    shm->h = h;
+    shm->ptr = ptr;
+    shm->size = info.RegionSize;  // rounded up to the page size
+    return shm;
+}
+
+void * jsdrv_os_shm_ptr(struct jsdrv_os_shm_s * shm, size_t * size_bytes) {
+    if (size_bytes) {
+        *size_bytes = shm->size;
+    }
+    return shm->ptr;
+}
+
+void jsdrv_os_shm_close(struct jsdrv_os_shm_s * shm) {
+    if (NULL == shm) {
+        return;
+    }
+    UnmapViewOfFile(shm->ptr);
+    CloseHandle(shm->h);
+    jsdrv_free(shm);
+}
+
+struct jsdrv_os_file_s {
+    HANDLE h;
+};
+
+struct jsdrv_os_file_s * jsdrv_os_file_open(const char * path, uint32_t flags) {
+    // FILE_FLAG_NO_BUFFERING cannot be cleared for the final partial write,
+    // so direct writes use write-through with the sequential access hint.
+    DWORD attr = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN;
+    if (flags & JSDRV_OS_FILE_FLAG_DIRECT) {
+        attr |= FILE_FLAG_WRITE_THROUGH;
+    }
+    HANDLE h = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, attr, NULL);
+    if (INVALID_HANDLE_VALUE == h) {
+        WINDOWS_LOGE("file open failed: %s", path);
+        return NULL;
+    }
+    struct jsdrv_os_file_s * f = jsdrv_alloc_clr(sizeof(struct jsdrv_os_file_s));
+    f->h = h;
+    return f;
+}
+
+int32_t jsdrv_os_file_write(struct jsdrv_os_file_s * f, const void * ptr, size_t size_bytes) {
+    const uint8_t * p = (const uint8_t *) ptr;
+    while (size_bytes) {
+        DWORD sz = (size_bytes > 0x40000000U) ? 0x40000000U : (DWORD) size_bytes;
+        DWORD written = 0;
+        if (!WriteFile(f->h, p, sz, &written, NULL)) {
+            WINDOWS_LOGE("file write failed: %zu", size_bytes);
+            return JSDRV_ERROR_IO;
+        }
+        p += written;
+        size_bytes -= written;
+    }
+    return 0;
+}
+
+int32_t jsdrv_os_file_write_batch(struct jsdrv_os_file_s * f, const struct jsdrv_os_file_chunk_s * chunks, uint32_t count) {
+    for (uint32_t k = 0; k < count; ++k) {
+        int32_t rc = jsdrv_os_file_write(f, chunks[k].ptr, chunks[k].size_bytes);
+        if (rc) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
+int32_t jsdrv_os_file_register(struct jsdrv_os_file_s * f, void * ptr, size_t size_bytes) {
+    (void) f;
+    (void) ptr;
+    (void) size_bytes;
+    return JSDRV_ERROR_NOT_SUPPORTED;
+}
+
+int32_t jsdrv_os_file_preallocate(struct jsdrv_os_file_s * f, uint64_t size_bytes) {
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize.QuadPart = (LONGLONG) size_bytes;
+    if (!SetFileInformationByHandle(f->h, FileAllocationInfo, &info, sizeof(info))) {
+        WINDOWS_LOGE("file preallocate failed: %" PRIu64, size_bytes);
+        return JSDRV_ERROR_IO;
+    }
+    return 0;  // NTFS releases the unused allocation on close
+}
+
+int32_t jsdrv_os_file_sync(struct jsdrv_os_file_s * f) {
+    if (!FlushFileBuffers(f->h)) {
+        WINDOWS_LOGE("file sync failed: %p", f->h);
+        return JSDRV_ERROR_IO;
+    }
+    return 0;
+}
+
+int32_t jsdrv_os_file_close(struct jsdrv_os_file_s * f) {
+    int32_t rc = 0;
+    if (NULL == f) {
+        return 0;
+    }
+    if (!CloseHandle(f->h)) {
+        WINDOWS_LOGE("file close failed: %p", f->h);
+        rc = JSDRV_ERROR_IO;
+    }
+    jsdrv_free(f);
+    return rc;
+}
+
+struct jsdrv_os_socket_s {
+    SOCKET s;
+};
+
+static int32_t socket_addr(const char * host, uint16_t port, struct sockaddr_in * addr) {
+    struct addrinfo hints;
+    struct addrinfo * info = NULL;
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(port);
+    if ((NULL == host) || (0 == host[0])) {
+        addr->sin_addr.s_addr = htonl(INADDR_ANY);
+        return 0;
+    }
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, NULL, &hints, &info) || (NULL == info)) {
+        JSDRV_LOGW("socket host not found: %s", host);
+        return JSDRV_ERROR_NOT_FOUND;
+    }
+    addr->sin_addr = ((struct sockaddr_in *) info->ai_addr)->sin_addr;
+    freeaddrinfo(info);
+    return 0;
+}
+
+static SOCKET socket_create(void) {
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data)) {  // paired with WSACleanup in close
+        JSDRV_LOGE("WSAStartup failed");
+        return INVALID_SOCKET;
+    }
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (INVALID_SOCKET == s) {
+        JSDRV_LOGE("socket create failed: %d", WSAGetLastError());
+        WSACleanup();
+    }
+    return s;
+}
+
+static struct jsdrv_os_socket_s * socket_alloc(SOCKET s) {
+    BOOL one = TRUE;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char *) &one, sizeof(one));
+    struct jsdrv_os_socket_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_os_socket_s));
+    self->s = s;
+    return self;
+}
+
+static int socket_wait(SOCKET s, uint32_t timeout_ms) {
+    WSAPOLLFD fds = {
+            .fd = s,
+            .events = POLLRDNORM,
+            .revents = 0,
+    };
+    return WSAPoll(&fds, 1, (INT) timeout_ms);
+}
+
+struct jsdrv_os_socket_s * jsdrv_os_socket_listen(const char * host, uint16_t * port) {
+    struct sockaddr_in addr;
+    int addr_len = sizeof(addr);
+    if (socket_addr(host, *port, &addr)) {
+        return NULL;
+    }
+    SOCKET s = socket_create();
+    if (INVALID_SOCKET == s) {
+        return NULL;
+    }
+    if (bind(s, (struct sockaddr *) &addr, sizeof(addr)) || listen(s, 8)
+            || getsockname(s, (struct sockaddr *) &addr, &addr_len)) {
+        JSDRV_LOGE("socket listen on port %u failed: %d", (unsigned int) *port, WSAGetLastError());
+        closesocket(s);
+        WSACleanup();
+        return NULL;
+    }
+    *port = ntohs(addr.sin_port);
+    struct jsdrv_os_socket_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_os_socket_s));
+    self->s = s;
+    return self;
+}
+
+struct jsdrv_os_socket_s * jsdrv_os_socket_accept(struct jsdrv_os_socket_s * self, uint32_t timeout_ms) {
+    WSADATA wsa_data;
+    if (socket_wait(self->s, timeout_ms) <= 0) {
+        return NULL;
+    }
+    SOCKET s = accept(self->s, NULL, NULL);
+    if (INVALID_SOCKET == s) {
+        JSDRV_LOGW("socket accept failed: %d", WSAGetLastError());
+        return NULL;
+    }
+    WSAStartup(MAKEWORD(2, 2), &wsa_data);  // paired with WSACleanup in close
+    return socket_alloc(s);
+}
+
+struct jsdrv_os_socket_s * jsdrv_os_socket_connect(const char * host, uint16_t port) {
+    struct sockaddr_in addr;
+    if ((NULL == host) || socket_addr(host, port, &addr)) {
+        return NULL;
+    }
+    SOCKET s = socket_create();
+    if (INVALID_SOCKET == s) {
+        return NULL;
+    }
+    if (connect(s, (struct sockaddr *) &addr, sizeof(addr))) {
+        JSDRV_LOGW("socket connect to %s:%u failed: %d", host, (unsigned int) port, WSAGetLastError());
+        closesocket(s);
+        WSACleanup();
+        return NULL;
+    }
+    return socket_alloc(s);
+}
+
+int32_t jsdrv_os_socket_send(struct jsdrv_os_socket_s * self, const void * ptr, size_t size_bytes) {
+    const char * p = (const char *) ptr;
+    while (size_bytes) {
+        int sz = (size_bytes > 0x40000000U) ? 0x40000000 : (int) size_bytes;
+        sz = send(self->s, p, sz, 0);
+        if (SOCKET_ERROR == sz) {
+            JSDRV_LOGW("socket send failed: %d", WSAGetLastError());
+            return JSDRV_ERROR_IO;
+        }
+        p += sz;
+        size_bytes -= (size_t) sz;
+    }
+    return 0;
+}
+
+int32_t jsdrv_os_socket_recv(struct jsdrv_os_socket_s * self, void * ptr, size_t size_bytes,
+                             uint32_t timeout_ms, size_t * received) {
+    *received = 0;
+    int rv = socket_wait(self->s, timeout_ms);
+    if (0 == rv) {
+        return JSDRV_ERROR_TIMED_OUT;
+    } else if (rv < 0) {
+        return JSDRV_ERROR_IO;
+    }
+    int sz = (size_bytes > 0x40000000U) ? 0x40000000 : (int) size_bytes;
+    sz = recv(self->s, (char *) ptr, sz, 0);
+    if (0 == sz) {
+        return JSDRV_ERROR_CLOSED;
+    } else if (SOCKET_ERROR == sz) {
+        return (WSAECONNRESET == WSAGetLastError()) ? JSDRV_ERROR_CLOSED : JSDRV_ERROR_IO;
+    }
+    *received = (size_t) sz;
+    return 0;
+}
+
+void jsdrv_os_socket_close(struct jsdrv_os_socket_s * self) {
+    if (NULL == self) {
+        return;
+    }
+    shutdown(self->s, SD_BOTH);
+    closesocket(self->s);
+    WSACleanup();
+    jsdrv_free(self);
+}
+
 int32_t jsdrv_platform_initialize(void) {
-    heap_mutex = jsdrv_os_mutex_alloc("heap");
 
     if (!SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS)) {
         WINDOWS_LOGE("Could not raise process priority using %s", "SetPriorityClass");
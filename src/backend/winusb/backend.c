@@ -23,13 +23,18 @@
 #define JSDRV_LOG_LEVEL JSDRV_LOG_LEVEL_INFO
 #include "jsdrv.h"
 #include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/alloc.h"
 #include "jsdrv_prv/assert.h"
 #include "jsdrv_prv/backend.h"
 #include "jsdrv_prv/cdef.h"
 #include "jsdrv_prv/devices.h"
 #include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/latency.h"
 #include "jsdrv_prv/windows.h"
 #include "jsdrv_prv/msg_queue.h"
+#include "jsdrv_prv/perf.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv_prv/usb_depth.h"
 #include "device_change_notifier.h"
 #include "jsdrv/error_code.h"
 #include "jsdrv/cstr.h"
@@ -45,9 +50,17 @@
 #define DEVICES_MAX                     (256U)
 #define DEVICE_PATH_MAX                 (256U)
 #define CONTROL_TIMEOUT_MS              (1000)
-#define BULK_IN_FRAME_LENGTH            (512)
-#define BULK_IN_TRANSFER_SIZE           (64 * BULK_IN_FRAME_LENGTH)
-#define BULK_IN_TRANSFER_OUTSTANDING    (4)
+#define IOCP_THREAD_COUNT               (2U)
+#define IOCP_ENTRIES_MAX                (16U)
+#define IOCP_KEY_EXIT                   ((ULONG_PTR) 1)
+#define BULK_IN_CLOSE_TIMEOUT_MS        (1000U)
+
+/*
+ * The device file handles are associated with the backend's I/O completion
+ * port to complete bulk in reads.  Setting the low-order bit of hEvent
+ * prevents the other overlapped operations from queueing completion packets.
+ */
+#define IOCP_SKIP(event)                ((HANDLE) (((ULONG_PTR) (event)) | 1))
 
 enum device_mark_e {        // for scan add/remove mark & sweep
     DEVICE_MARK_NONE = 0,
@@ -76,14 +89,24 @@ struct endpoint_s {
 struct bulk_in_transfer_s {
     struct bulk_in_s * bulk;
     OVERLAPPED overlapped;
+    struct jsdrvp_msg_s * msg;  // loan message, owned by this transfer
     struct jsdrv_list_s item;
-    uint8_t buffer[BULK_IN_TRANSFER_SIZE];
+    bool done;                  // completed, waiting for prior transfers
+    DWORD status;               // the completion error code
+    ULONG size;                 // the completion size in bytes
+    int64_t loan_time;          // loan start, for JSDRV_PERF_LOAN
+    uint8_t buffer[];           // bulk_in_s.transfer_size, must be last
 };
 
 struct bulk_in_s {
     struct endpoint_s ep;
+    uint32_t transfer_depth;    // outstanding transfers
+    uint32_t transfer_size;     // bytes per transfer
+    uint32_t transfer_spare;    // preallocated transfers beyond the depth
+    struct jsdrv_usb_depth_s adapt;  // adjusts transfer_depth when adaptive
     struct jsdrv_list_s transfers_pending;
     struct jsdrv_list_s transfers_free;
+    bool closing;               // discard completions, do not pend
 };
 
 struct bulk_out_s {
@@ -112,6 +135,8 @@ struct dev_s {
     HANDLE ctrl_event;
     struct jsdrv_list_s ctrl_list;  // jsdrvp_msg_s
 
+    HANDLE iocp;                // the backend I/O completion port
+    CRITICAL_SECTION lock;      // endpoints_active and bulk in transfers
     struct endpoint_s * endpoints[256];
     struct jsdrv_list_s endpoints_active;  // struct endpoint_s
 
@@ -123,18 +148,24 @@ struct dev_s {
 //# BULK IN STREAMING ENDPOINT                                                #
 //#############################################################################
 
+/*
+ * The device thread opens, closes and recycles bulk in transfers.
+ * The backend I/O completion port threads complete and pend them.
+ * Both hold dev_s.lock.
+ */
+
 static struct bulk_in_transfer_s * bulk_in_transfer_alloc(struct bulk_in_s * b) {
     struct jsdrv_list_s * item = jsdrv_list_remove_head(&b->transfers_free);
     struct bulk_in_transfer_s * t;
     if (item) {
         t = JSDRV_CONTAINER_OF(item, struct bulk_in_transfer_s, item);
     } else {
-        t = jsdrv_alloc_clr(sizeof(struct bulk_in_transfer_s));
+        t = jsdrv_alloc_clr_cat(sizeof(struct bulk_in_transfer_s) + b->transfer_size, JSDRV_ALLOC_CAT_XFER);
         jsdrv_list_initialize(&t->item);
     }
     t->bulk = b;
-    memset(&t->overlapped, 0, sizeof(t->overlapped));
-    t->overlapped.hEvent = b->ep.event;
+    t->done = false;
+    memset(&t->overlapped, 0, sizeof(t->overlapped));  // no hEvent, completes to the iocp
     JSDRV_LOGD3("bulk_in_transfer_alloc %p", &t->overlapped);
     return t;
 }
@@ -146,36 +177,44 @@ static void bulk_in_transfer_free(struct bulk_in_transfer_s * t) {
 
 static void bulk_in_finalize(struct endpoint_s * ep) {
     struct bulk_in_s * b = (struct bulk_in_s *) ep;
+    struct dev_s * d = b->ep.dev;
     JSDRV_LOGI("bulk_in_finalize ep=0x%02x", b->ep.pipe_id);
-    WinUsb_AbortPipe(b->ep.dev->winusb, b->ep.pipe_id);
-    while (!jsdrv_list_is_empty(&b->transfers_pending)) {
-        struct jsdrv_list_s * item = jsdrv_list_remove_head(&b->transfers_pending);
-        struct bulk_in_transfer_s * t = JSDRV_CONTAINER_OF(item, struct bulk_in_transfer_s, item);
-        ULONG sz = 0;
-        WinUsb_GetOverlappedResult(b->ep.dev->winusb, &t->overlapped, &sz, TRUE);
-        jsdrv_list_add_tail(&b->transfers_free, &t->item);
+    EnterCriticalSection(&d->lock);
+    b->closing = true;
+    LeaveCriticalSection(&d->lock);
+    WinUsb_AbortPipe(d->winusb, b->ep.pipe_id);
+
+    // the iocp threads return the aborted transfers
+    bool pending = true;
+    for (uint32_t i = 0; pending && (i < BULK_IN_CLOSE_TIMEOUT_MS); ++i) {
+        EnterCriticalSection(&d->lock);
+        pending = !jsdrv_list_is_empty(&b->transfers_pending);
+        LeaveCriticalSection(&d->lock);
+        if (pending) {
+            Sleep(1);
+        }
+    }
+    if (pending) {
+        // leak the transfers, since the driver still owns their buffers
+        JSDRV_LOGE("bulk_in_finalize ep=0x%02x transfers not aborted", b->ep.pipe_id);
+        jsdrv_list_initialize(&b->transfers_pending);
     }
 
     while (!jsdrv_list_is_empty(&b->transfers_free)) {
         struct jsdrv_list_s * item = jsdrv_list_remove_head(&b->transfers_free);
         struct bulk_in_transfer_s * t = JSDRV_CONTAINER_OF(item, struct bulk_in_transfer_s, item);
+        jsdrvp_msg_free(d->context, t->msg);
         jsdrv_free(t);
     }
-
-    if (b->ep.event) {
-        CloseHandle(b->ep.event);
-    }
-    b->ep.event = NULL;
-    jsdrv_free(b);
 }
 
 static int32_t bulk_in_pend(struct bulk_in_s * b) {
     JSDRV_LOGD2("bulk_in_pend");
     // Pend read operations
     size_t pending = jsdrv_list_length(&b->transfers_pending);
-    for (size_t idx = pending; idx < BULK_IN_TRANSFER_OUTSTANDING; ++idx) {
+    for (size_t idx = pending; idx < b->transfer_depth; ++idx) {
         struct bulk_in_transfer_s * t = bulk_in_transfer_alloc(b);
-        if (!WinUsb_ReadPipe(b->ep.dev->winusb, b->ep.pipe_id, t->buffer, BULK_IN_TRANSFER_SIZE, NULL, &t->overlapped)) {
+        if (!WinUsb_ReadPipe(b->ep.dev->winusb, b->ep.pipe_id, t->buffer, b->transfer_size, NULL, &t->overlapped)) {
             DWORD ec = GetLastError();
             if (ec != ERROR_IO_PENDING) {
                 WINDOWS_LOGE("%s", "bulk_in_pend WinUsb_ReadPipe error");
@@ -189,69 +228,150 @@ static int32_t bulk_in_pend(struct bulk_in_s * b) {
     return 0;
 }
 
-static int32_t bulk_in_process(struct endpoint_s * ep) {
-    JSDRV_LOGD2("bulk_in_process");
-    struct bulk_in_s * b = (struct bulk_in_s *) ep;
-    ResetEvent(b->ep.event);
+static void bulk_in_adapt(struct bulk_in_s * b, bool pressure) {
+    if (!jsdrv_usb_depth_is_adaptive(&b->adapt)) {
+        return;
+    }
+    int64_t now = jsdrv_time_monotonic();
+    uint32_t depth = pressure ? jsdrv_usb_depth_pressure(&b->adapt, now)
+                              : jsdrv_usb_depth_update(&b->adapt, now);
+    if (depth != b->transfer_depth) {
+        JSDRV_LOGI("bulk_in_adapt pipe_id=0x%02x depth %" PRIu32 " -> %" PRIu32, b->ep.pipe_id, b->transfer_depth, depth);
+        b->transfer_depth = depth;
+    }
+}
+
+static void bulk_in_deliver(struct bulk_in_s * b, struct bulk_in_transfer_s * t) {
+    JSDRV_LOGD3("bulk_in_deliver %p ready, %lu bytes",  &t->overlapped, t->size);
+    struct jsdrvp_msg_s * m = t->msg;
+    if (NULL == m) {
+        // allocate once, then reuse for each completion of this transfer
+        m = jsdrvp_msg_alloc(b->ep.dev->context);
+        jsdrv_cstr_copy(m->topic, JSDRV_USBBK_MSG_STREAM_IN_DATA, sizeof(m->topic));
+        t->msg = m;
+    }
+    m->value = jsdrv_union_bin(t->buffer, t->size);
+    m->extra.bkusb_stream.endpoint = b->ep.pipe_id;
+    m->extra.bkusb_stream.transfer_depth = b->transfer_depth;
+    m->extra.bkusb_stream.transfer_skip = 0;
+    JSDRV_LATENCY_STAMP(m->latency.usb);
+    JSDRV_PERF_ADD(JSDRV_PERF_USB_XFER, 1);
+    JSDRV_PERF_ADD(JSDRV_PERF_USB_RX, (uint64_t) t->size);
+#if JSDRV_PERF_ENABLE
+    t->loan_time = jsdrv_time_utc();
+#endif
+    msg_queue_push(b->ep.dev->device.rsp_q, m);
+}
+
+static void bulk_in_complete(struct bulk_in_transfer_s * t) {
+    struct bulk_in_s * b = t->bulk;
+    struct jsdrv_list_s done;
     int32_t rc = 0;
+    t->done = true;
+    jsdrv_list_initialize(&done);
 
-    // Handle completed read operations
+    // Complete in submission order, since the iocp threads may
+    // dequeue the completions of one endpoint out of order.
     while (1) {
         struct jsdrv_list_s * item = jsdrv_list_peek_head(&b->transfers_pending);
         if (!item) {
             break;
         }
-        struct bulk_in_transfer_s * t = JSDRV_CONTAINER_OF(item, struct bulk_in_transfer_s, item);
-        ULONG sz = 0;
-        if (WinUsb_GetOverlappedResult(b->ep.dev->winusb, &t->overlapped, &sz, FALSE)) {
-            JSDRV_LOGD3("bulk_in_process %p ready, %zu bytes",  &t->overlapped, sz);
-            jsdrv_list_remove_head(&b->transfers_pending);
-            struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(b->ep.dev->context);
-            jsdrv_cstr_copy(m->topic, JSDRV_USBBK_MSG_STREAM_IN_DATA, sizeof(m->topic));
-            m->value = jsdrv_union_bin(t->buffer, sz);
-            m->extra.bkusb_stream.endpoint = b->ep.pipe_id;
-            msg_queue_push(b->ep.dev->device.rsp_q, m);
+        t = JSDRV_CONTAINER_OF(item, struct bulk_in_transfer_s, item);
+        if (!t->done) {
+            break;
+        }
+        jsdrv_list_remove_head(&b->transfers_pending);
+        jsdrv_list_add_tail(&done, &t->item);
+        if ((ERROR_SUCCESS != t->status) && (ERROR_SEM_TIMEOUT != t->status)) {
+            rc = 1;
+        }
+    }
+
+    // Resubmit from the spare transfers before lending the completed
+    // transfers to the upper layer, to minimize the gap between reads.
+    if (!rc && !b->closing) {
+        // pressure when the pipeline ran dry or the upper layer falls behind
+        bulk_in_adapt(b, jsdrv_list_is_empty(&b->transfers_pending)
+            || (msg_queue_depth(b->ep.dev->device.rsp_q, MSG_QUEUE_LANE_DATA) >= b->transfer_depth));
+        bulk_in_pend(b);
+    }
+
+    while (1) {
+        struct jsdrv_list_s * item = jsdrv_list_remove_head(&done);
+        if (!item) {
+            break;
+        }
+        t = JSDRV_CONTAINER_OF(item, struct bulk_in_transfer_s, item);
+        if (b->closing) {
+            bulk_in_transfer_free(t);
+        } else if (ERROR_SUCCESS == t->status) {
+            bulk_in_deliver(b, t);
+        } else if (t->status == ERROR_SEM_TIMEOUT) {
+            JSDRV_LOGD1("bulk_in_complete timeout");
+            bulk_in_transfer_free(t);  // timeout ok
         } else {
-            DWORD ec = GetLastError();
-            if ((ec == ERROR_IO_INCOMPLETE) || (ec == ERROR_IO_PENDING)) {
-                break;  // ok, not done yet
-            } else if (ec == ERROR_SEM_TIMEOUT) {
-                JSDRV_LOGD1("bulk_in_process timeout");
-                bulk_in_transfer_free(t);  // timeout ok
-            } else {
-                WINDOWS_LOG(JSDRV_LOGW, "%s", "bulk_in_process WinUsb_GetOverlappedResult error");
-                bulk_in_transfer_free(t);
-                rc = 1;
+            JSDRV_LOGW("bulk_in_complete ep=0x%02x error %lu", b->ep.pipe_id, t->status);
+            bulk_in_transfer_free(t);
+        }
+    }
+}
+
+static struct bulk_in_transfer_s * bulk_in_transfer_find(struct dev_s * d, OVERLAPPED * overlapped) {
+    struct jsdrv_list_s * ep_item;
+    struct jsdrv_list_s * t_item;
+    jsdrv_list_foreach(&d->endpoints_active, ep_item) {
+        struct endpoint_s * ep = JSDRV_CONTAINER_OF(ep_item, struct endpoint_s, item);
+        if (ep->finalize != bulk_in_finalize) {
+            continue;
+        }
+        struct bulk_in_s * b = (struct bulk_in_s *) ep;
+        jsdrv_list_foreach(&b->transfers_pending, t_item) {
+            struct bulk_in_transfer_s * t = JSDRV_CONTAINER_OF(t_item, struct bulk_in_transfer_s, item);
+            if (&t->overlapped == overlapped) {
+                return t;
             }
         }
     }
+    return NULL;
+}
 
-    if (rc) {
-        return rc;
+static void iocp_process(struct dev_s * d, OVERLAPPED * overlapped) {
+    EnterCriticalSection(&d->lock);
+    // WinUSB may complete its own internal operations to the port.
+    struct bulk_in_transfer_s * t = bulk_in_transfer_find(d, overlapped);
+    if (NULL == t) {
+        JSDRV_LOGD1("iocp_process ignore %p", overlapped);
     } else {
-        return bulk_in_pend(b);
+        t->size = 0;
+        if (WinUsb_GetOverlappedResult(d->winusb, overlapped, &t->size, FALSE)) {
+            t->status = ERROR_SUCCESS;
+        } else {
+            t->status = GetLastError();
+        }
+        bulk_in_complete(t);
     }
+    LeaveCriticalSection(&d->lock);
 }
 
-static struct bulk_in_s * bulk_in_initialize(struct dev_s * dev, uint8_t pipe_id) {
+static struct bulk_in_s * bulk_in_initialize(struct dev_s * dev, uint8_t pipe_id,
+                                             uint32_t depth, uint32_t depth_max, uint32_t size, uint32_t spare) {
     pipe_id |= 0x80;  // force IN
-    JSDRV_LOGI("bulk_in_initialize pipe_id=0x%02x", pipe_id);
     struct bulk_in_s * b = jsdrv_alloc_clr(sizeof(struct bulk_in_s));
+    b->transfer_depth = jsdrv_usbbk_bulk_in_depth(depth);
+    b->transfer_size = jsdrv_usbbk_bulk_in_size(size);
+    b->transfer_spare = jsdrv_usbbk_bulk_in_spare(spare);
+    if (depth_max) {
+        depth_max = jsdrv_usbbk_bulk_in_depth(depth_max);
+    }
+    jsdrv_usb_depth_init(&b->adapt, b->transfer_depth, depth_max, jsdrv_time_monotonic());
+    JSDRV_LOGI("bulk_in_initialize pipe_id=0x%02x, depth=%" PRIu32 ", depth_max=%" PRIu32 ", size=%" PRIu32 ", spare=%" PRIu32,
+               pipe_id, b->transfer_depth, b->adapt.depth_max, b->transfer_size, b->transfer_spare);
     b->ep.dev = dev;
     b->ep.pipe_id = pipe_id;
-    b->ep.process = bulk_in_process;
+    b->ep.process = NULL;     // completes on the iocp threads
     b->ep.finalize = bulk_in_finalize;
-    b->ep.event = CreateEvent(
-            NULL,  // default security attributes
-            TRUE,  // manual reset event
-            TRUE,  // start signalled to pend initial transactions
-            NULL   // no name
-    );
-    if (!b->ep.event) {
-        JSDRV_LOGE("CreateEvent failed");
-        free(b);
-        return NULL;
-    }
+    b->ep.event = NULL;
     jsdrv_list_initialize(&b->ep.item);
     jsdrv_list_initialize(&b->transfers_pending);
     jsdrv_list_initialize(&b->transfers_free);
@@ -263,6 +383,11 @@ static struct bulk_in_s * bulk_in_initialize(struct dev_s * dev, uint8_t pipe_id
         WINDOWS_LOGE("%s", "WinUsb_GetPipePolicy MAXIMUM_TRANSFER_SIZE");
     } else {
         JSDRV_LOGI("MAXIMUM_TRANSFER_SIZE pipe_id=0x%02x bytes=%d", pipe_id, (int) value);
+        if ((value >= JSDRV_USBBK_BULK_IN_FRAME_LENGTH) && (b->transfer_size > value)) {
+            // RAW_IO requires transfers no larger than MAXIMUM_TRANSFER_SIZE
+            b->transfer_size = (value / JSDRV_USBBK_BULK_IN_FRAME_LENGTH) * JSDRV_USBBK_BULK_IN_FRAME_LENGTH;
+            JSDRV_LOGW("bulk_in_initialize size limited to %" PRIu32, b->transfer_size);
+        }
     }
 
     //value = TRUE;
@@ -280,6 +405,17 @@ static struct bulk_in_s * bulk_in_initialize(struct dev_s * dev, uint8_t pipe_id
     //    WINDOWS_LOGE("%s", "WinUsb_SetPipePolicy PIPE_TRANSFER_TIMEOUT");
     //}
 
+    // Preallocate the transfers, with their loan messages, so that
+    // bulk_in_complete() never waits on an allocation to resubmit.
+    for (uint32_t i = 0; i < (b->transfer_depth + b->transfer_spare); ++i) {
+        struct bulk_in_transfer_s * t = jsdrv_alloc_clr_cat(sizeof(struct bulk_in_transfer_s) + b->transfer_size, JSDRV_ALLOC_CAT_XFER);
+        jsdrv_list_initialize(&t->item);
+        t->bulk = b;
+        t->msg = jsdrvp_msg_alloc(dev->context);
+        jsdrv_cstr_copy(t->msg->topic, JSDRV_USBBK_MSG_STREAM_IN_DATA, sizeof(t->msg->topic));
+        bulk_in_transfer_free(t);
+    }
+
     return b;
 }
 
@@ -307,8 +443,6 @@ static void bulk_out_finalize(struct endpoint_s * ep) {
         CloseHandle(b->ep.event);
         b->ep.event = NULL;
     }
-
-    jsdrv_free(b);
 }
 
 static bool bulk_out_complete_next(struct bulk_out_s * b) {
@@ -337,7 +471,7 @@ static int32_t bulk_out_send_next(struct bulk_out_s * b) {
         struct jsdrv_list_s * item = jsdrv_list_peek_head(&b->msg_pending);
         struct jsdrvp_msg_s * m = JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item);
         memset(&b->overlapped, 0, sizeof(b->overlapped));
-        b->overlapped.hEvent = b->ep.event;
+        b->overlapped.hEvent = IOCP_SKIP(b->ep.event);
         if (!WinUsb_WritePipe(b->ep.dev->winusb, b->ep.pipe_id, (uint8_t *) m->value.value.bin, m->value.size, NULL, &b->overlapped)) {
             DWORD ec = GetLastError();
             if (ec != ERROR_IO_PENDING) {
@@ -427,6 +561,14 @@ static int32_t device_open(struct dev_s * d) {
         d->file = INVALID_HANDLE_VALUE;
         return 1;
     }
+    if (NULL == CreateIoCompletionPort(d->file, d->iocp, (ULONG_PTR) d, 0)) {
+        WINDOWS_LOGE("CreateIoCompletionPort %s", d->device.prefix);
+        WinUsb_Free(d->winusb);
+        d->winusb = INVALID_HANDLE_VALUE;
+        CloseHandle(d->file);
+        d->file = INVALID_HANDLE_VALUE;
+        return 1;
+    }
     DWORD ctrl_timeout = CONTROL_TIMEOUT_MS;
     if (!WinUsb_SetPipePolicy(d->winusb, 0, PIPE_TRANSFER_TIMEOUT, sizeof(ctrl_timeout), &ctrl_timeout)) {
         JSDRV_LOGW("WinUsb_SetPipePolicy failed");
@@ -437,10 +579,14 @@ static int32_t device_open(struct dev_s * d) {
 }
 
 static void ep_finalize_by_id(struct dev_s * d, uint8_t ep_id) {
-    if (d->endpoints[ep_id]) {
-        jsdrv_list_remove(&d->endpoints[ep_id]->item);
-        d->endpoints[ep_id]->finalize(d->endpoints[ep_id]);
+    struct endpoint_s * ep = d->endpoints[ep_id];
+    if (ep) {
+        ep->finalize(ep);  // bulk in remains active until its transfers return
+        EnterCriticalSection(&d->lock);
+        jsdrv_list_remove(&ep->item);
         d->endpoints[ep_id] = NULL;
+        LeaveCriticalSection(&d->lock);
+        jsdrv_free(ep);
     }
 }
 
@@ -480,7 +626,7 @@ static void ctrl_start_next(struct dev_s * d) {
     struct jsdrvp_msg_s * msg = JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item);
 
     memset(&d->ctrl_overlapped, 0, sizeof(d->ctrl_overlapped));
-    d->ctrl_overlapped.hEvent = d->ctrl_event;
+    d->ctrl_overlapped.hEvent = IOCP_SKIP(d->ctrl_event);
     ULONG buf_sz = msg->extra.bkusb_ctrl.setup.s.wLength;
     ULONG sz = 0;
     WINUSB_SETUP_PACKET setup = *((WINUSB_SETUP_PACKET *) &msg->extra.bkusb_ctrl.setup.u64);
@@ -541,8 +687,19 @@ static bool device_handle_msg(struct dev_s * d, struct jsdrvp_msg_s * msg) {
     }
     if (0 == strcmp(JSDRV_USBBK_MSG_STREAM_IN_DATA, msg->topic)) {
         struct bulk_in_transfer_s * t = JSDRV_CONTAINER_OF(msg->value.value.bin, struct bulk_in_transfer_s, buffer);
-        bulk_in_transfer_free(t);
-        jsdrvp_msg_free(d->context, msg);
+        bool skip = msg->extra.bkusb_stream.transfer_skip != 0;
+        if (t->msg != msg) {
+            JSDRV_LOGW("stream_in_data message not owned by transfer");
+            jsdrvp_msg_free(d->context, msg);
+        }
+        JSDRV_PERF_LOAN(jsdrv_time_utc() - t->loan_time);
+        EnterCriticalSection(&d->lock);
+        bulk_in_transfer_free(t);  // retains t->msg for reuse
+        if (skip && !t->bulk->closing) {
+            bulk_in_adapt(t->bulk, true);
+            bulk_in_pend(t->bulk);
+        }
+        LeaveCriticalSection(&d->lock);
     } else if (0 == strcmp(JSDRV_USBBK_MSG_BULK_OUT_DATA, msg->topic)) {
         bulk_out_send(d, msg);
     } else if (msg->topic[0] == JSDRV_MSG_COMMAND_PREFIX_CHAR) {
@@ -571,11 +728,20 @@ static bool device_handle_msg(struct dev_s * d, struct jsdrvp_msg_s * msg) {
         uint8_t ep = msg->extra.bkusb_stream.endpoint;
         JSDRV_LOGI("bulk_in_stream_open %d", (int) ep);
         ep_finalize_by_id(d, ep);
-        struct bulk_in_s * b = bulk_in_initialize(d, ep);
-        d->endpoints[ep] = &b->ep;
-        jsdrv_list_add_tail(&d->endpoints_active, &b->ep.item);
-        d->update_handles = true;
-        msg->value = jsdrv_union_i32(0);  // return code
+        struct bulk_in_s * b = bulk_in_initialize(d, ep,
+                                                  msg->extra.bkusb_stream.transfer_depth,
+                                                  msg->extra.bkusb_stream.transfer_depth_max,
+                                                  msg->extra.bkusb_stream.transfer_size,
+                                                  msg->extra.bkusb_stream.transfer_spare);
+        int32_t rc = JSDRV_ERROR_NOT_ENOUGH_MEMORY;
+        if (b) {
+            EnterCriticalSection(&d->lock);
+            d->endpoints[ep] = &b->ep;
+            jsdrv_list_add_tail(&d->endpoints_active, &b->ep.item);
+            rc = bulk_in_pend(b) ? JSDRV_ERROR_IO : 0;
+            LeaveCriticalSection(&d->lock);
+        }
+        msg->value = jsdrv_union_i32(rc);  // return code
         msg_queue_push(d->device.rsp_q, msg);
     } else if (0 == strcmp(JSDRV_USBBK_MSG_BULK_IN_STREAM_CLOSE, msg->topic)) {
         uint8_t ep = msg->extra.bkusb_stream.endpoint;
@@ -595,6 +761,7 @@ static bool device_handle_msg(struct dev_s * d, struct jsdrvp_msg_s * msg) {
 static DWORD WINAPI device_thread(LPVOID lpParam) {
     struct dev_s *d = (struct dev_s *) lpParam;
     JSDRV_LOGI("USB device_thread started %s", d->device.prefix);
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_USB);
     d->update_handles = true;
     struct jsdrv_list_s * item;
     struct endpoint_s * ep;
@@ -628,8 +795,8 @@ static DWORD WINAPI device_thread(LPVOID lpParam) {
         }
         jsdrv_list_foreach(&d->endpoints_active, item) {
             ep = JSDRV_CONTAINER_OF(item, struct endpoint_s, item);
-            if (WAIT_OBJECT_0 == WaitForSingleObject(ep->event, 0)) {
-                ep->process(ep);
+            if (ep->event && (WAIT_OBJECT_0 == WaitForSingleObject(ep->event, 0))) {
+                ep->process(ep);  // events for bulk out only
             }
         }
     }
@@ -638,6 +805,7 @@ static DWORD WINAPI device_thread(LPVOID lpParam) {
     device_close(d);
     jsdrvp_send_finalize_msg(d->context, d->device.rsp_q, d->device.prefix);
     JSDRV_LOGI("USB device_thread closed %s", d->device.prefix);
+    jsdrv_thread_unregister();
     return 0;
 }
 
@@ -657,8 +825,36 @@ struct backend_s {
     bool do_exit;
     HANDLE thread;
     DWORD thread_id;
+
+    HANDLE iocp;       // bulk in completions for all devices
+    HANDLE iocp_threads[IOCP_THREAD_COUNT];
 };
 
+static DWORD WINAPI iocp_thread(LPVOID lpParam) {
+    struct backend_s * s = (struct backend_s *) lpParam;
+    OVERLAPPED_ENTRY entries[IOCP_ENTRIES_MAX];
+    ULONG count = 0;
+    JSDRV_LOGI("USB iocp_thread started");
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_USB);
+
+    while (1) {
+        if (!GetQueuedCompletionStatusEx(s->iocp, entries, IOCP_ENTRIES_MAX, &count, INFINITE, FALSE)) {
+            WINDOWS_LOGE("%s", "GetQueuedCompletionStatusEx");
+            break;
+        }
+        for (ULONG i = 0; i < count; ++i) {
+            if (IOCP_KEY_EXIT == entries[i].lpCompletionKey) {
+                JSDRV_LOGI("USB iocp_thread done");
+                jsdrv_thread_unregister();
+                return 0;
+            }
+            iocp_process((struct dev_s *) entries[i].lpCompletionKey, entries[i].lpOverlapped);
+        }
+    }
+    jsdrv_thread_unregister();
+    return 0;
+}
+
 static void on_device_change(void* cookie) {
     struct backend_s * s = (struct backend_s *) cookie;
     JSDRV_LOGD1("on_device_change");
@@ -804,6 +1000,10 @@ static void device_free(struct backend_s * s, struct dev_s * d) {
         CloseHandle(d->ctrl_event);
         d->ctrl_event = NULL;
     }
+    if (d->iocp) {
+        DeleteCriticalSection(&d->lock);
+        d->iocp = NULL;
+    }
 
     d->device_type = NULL;
     d->device_path[0] = 0;
@@ -895,6 +1095,7 @@ static void backend_ready(struct backend_s * s) {
 static DWORD WINAPI backend_thread(LPVOID lpParam) {
     struct backend_s * s = (struct backend_s *) lpParam;
     JSDRV_LOGI("USB backend_thread started");
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_USB);
 
     HANDLE handles[MAXIMUM_WAIT_OBJECTS];
     DWORD handle_count = 0;
@@ -920,6 +1121,7 @@ static DWORD WINAPI backend_thread(LPVOID lpParam) {
     }
 
     JSDRV_LOGI("USB backend_thread done");
+    jsdrv_thread_unregister();
     return 0;
 }
 
@@ -953,6 +1155,25 @@ static void finalize(struct jsdrvbk_s * backend) {
             device_free(s, d);
         }
 
+        for (uint32_t i = 0; i < IOCP_THREAD_COUNT; ++i) {
+            if (s->iocp_threads[i]) {
+                PostQueuedCompletionStatus(s->iocp, 0, IOCP_KEY_EXIT, NULL);
+            }
+        }
+        for (uint32_t i = 0; i < IOCP_THREAD_COUNT; ++i) {
+            if (s->iocp_threads[i]) {
+                if (WAIT_OBJECT_0 != WaitForSingleObject(s->iocp_threads[i], 1000)) {
+                    JSDRV_LOGE("winusb iocp thread not closed cleanly.");
+                }
+                CloseHandle(s->iocp_threads[i]);
+                s->iocp_threads[i] = NULL;
+            }
+        }
+        if (s->iocp) {
+            CloseHandle(s->iocp);
+            s->iocp = NULL;
+        }
+
         jsdrv_free(s);
     }
 }
@@ -967,6 +1188,13 @@ int32_t jsdrv_usb_backend_factory(struct jsdrv_context_s * context, struct jsdrv
 
     jsdrv_list_initialize(&s->devices_free);
     jsdrv_list_initialize(&s->devices_active);
+    s->iocp = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, IOCP_THREAD_COUNT);
+    if (!s->iocp) {
+        WINDOWS_LOGE("%s", "CreateIoCompletionPort");
+        msg_queue_finalize(s->backend.cmd_q);
+        jsdrv_free(s);
+        return JSDRV_ERROR_UNSPECIFIED;
+    }
     for (uint16_t i = 0; i < DEVICES_MAX; ++i) {
         struct dev_s * d = &s->devices[i];
         d->winusb = INVALID_HANDLE_VALUE;
@@ -974,6 +1202,7 @@ int32_t jsdrv_usb_backend_factory(struct jsdrv_context_s * context, struct jsdrv
         d->context = context;
         d->device.cmd_q = msg_queue_init();
         d->device.rsp_q = msg_queue_init();
+        msg_queue_lanes_enable(d->device.rsp_q);
         d->ctrl_event = CreateEvent(
                 NULL,  // default security attributes
                 TRUE,  // manual reset event
@@ -981,6 +1210,8 @@ int32_t jsdrv_usb_backend_factory(struct jsdrv_context_s * context, struct jsdrv
                 NULL   // no name
         );
         JSDRV_ASSERT(d->ctrl_event);
+        d->iocp = s->iocp;
+        InitializeCriticalSection(&d->lock);
         jsdrv_list_initialize(&d->item);
         jsdrv_list_add_tail(&s->devices_free, &d->item);
         jsdrv_list_initialize(&d->ctrl_list);
@@ -998,6 +1229,18 @@ int32_t jsdrv_usb_backend_factory(struct jsdrv_context_s * context, struct jsdrv
         return JSDRV_ERROR_UNSPECIFIED;
     }
 
+    for (uint32_t i = 0; i < IOCP_THREAD_COUNT; ++i) {
+        s->iocp_threads[i] = CreateThread(NULL, 0, iocp_thread, s, 0, NULL);
+        if (s->iocp_threads[i] == NULL) {
+            JSDRV_LOGE("CreateThread iocp failed");
+            finalize(&s->backend);
+            return JSDRV_ERROR_UNSPECIFIED;
+        }
+        if (!SetThreadPriority(s->iocp_threads[i], THREAD_PRIORITY_HIGHEST)) {
+            WINDOWS_LOGE("%s", "SetThreadPriority");
+        }
+    }
+
     if (device_change_notifier_initialize(on_device_change, s)) {
         JSDRV_LOGE("device_change_notifier_initialize failed");
         finalize(&s->backend);
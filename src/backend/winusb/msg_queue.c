@@ -21,14 +21,17 @@
  */
 
 #include "jsdrv_prv/msg_queue.h"
+#include "jsdrv_prv/atomic.h"
 #include "jsdrv_prv/cdef.h"
 #include "jsdrv_prv/log.h"
 #include "jsdrv_prv/platform.h"
 #include "jsdrv_prv/list.h"
 #include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/backend.h"
 #include "jsdrv_prv/dbc.h"
 #include "jsdrv/error_code.h"
 #include <windows.h>
+#include <string.h>
 
 
 // ----------------------------------------------------------------------------
@@ -37,10 +40,104 @@
 
 struct msg_queue_s {
     HANDLE available_event;           // event
-    struct jsdrv_list_s items;
+    struct jsdrv_list_s items;              // all items, or data lane items with lanes, also SPSC overflow
+    struct jsdrv_list_s items_lane[MSG_QUEUE_LANE_COUNT];  // lanes except data
+    bool lanes;                             // see msg_queue_lanes_enable()
+    bool qos;                               // see msg_queue_qos_enable()
+    volatile int32_t depth[MSG_QUEUE_LANE_COUNT];
     CRITICAL_SECTION critical_section;
+
+    // single-producer, single-consumer mode, when ring is not NULL
+    struct jsdrvp_msg_s ** ring;
+    uint32_t ring_mask;
+    volatile int32_t ring_head;             // written only by the producer
+    volatile int32_t ring_tail;             // written only by the consumer
+    volatile int32_t overflow;              // items in the overflow list
+    volatile int32_t count;                 // items in the queue, signal on 0 -> 1
+
+    msg_queue_notify_fn notify_fn;    // guarded by critical_section, see msg_queue_notify_set()
+    void * notify_user_data;
 };
 
+static uint8_t lane_classify(const struct jsdrvp_msg_s * msg) {
+    const char * topic = msg->topic;
+    if ((JSDRV_MSG_TYPE_DATA == msg->inner_msg_type) || !topic[0]) {
+        return MSG_QUEUE_LANE_DATA;
+    } else if (topic[0] == '!') {
+        return MSG_QUEUE_LANE_CONTROL;  // USB control transfer responses
+    }
+    size_t sz = strlen(topic);
+    char c = topic[sz - 1];
+    if ((c == JSDRV_TOPIC_SUFFIX_RETURN_CODE) || (c == JSDRV_TOPIC_SUFFIX_METADATA_RSP)
+            || (0 == strcmp(JSDRV_MSG_OPEN, topic))
+            || (0 == strcmp(JSDRV_USBBK_MSG_BULK_IN_STREAM_OPEN, topic))) {
+        return MSG_QUEUE_LANE_CONTROL;
+    }
+    return MSG_QUEUE_LANE_DATA;  // stream data and messages ordered with it
+}
+
+static inline bool lanes_tracked(const struct msg_queue_s * q) {
+    return q->lanes || q->qos;
+}
+
+static uint8_t lane_get(const struct msg_queue_s * q, const struct jsdrvp_msg_s * msg) {
+    uint8_t lane = q->lanes ? lane_classify(msg) : MSG_QUEUE_LANE_DATA;
+    if (q->qos && (MSG_QUEUE_LANE_DATA == lane)) {
+        if (JSDRVP_QOS_CRITICAL == msg->qos) {
+            lane = MSG_QUEUE_LANE_CRITICAL;
+        } else if (JSDRVP_QOS_BACKGROUND == msg->qos) {
+            lane = MSG_QUEUE_LANE_BACKGROUND;
+        }
+    }
+    return lane;
+}
+
+static inline struct jsdrv_list_s * lane_list(struct msg_queue_s * q, uint8_t lane) {
+    return (MSG_QUEUE_LANE_DATA == lane) ? &q->items : &q->items_lane[lane];
+}
+
+// Call with the critical section held.
+static void locked_add(struct msg_queue_s * q, struct jsdrvp_msg_s * msg) {
+    uint8_t lane = lane_get(q, msg);
+    jsdrv_list_add_tail(lane_list(q, lane), &msg->item);
+    if (lanes_tracked(q)) {
+        jsdrv_atomic_add(&q->depth[lane], 1);
+    }
+}
+
+// Call with the critical section held.
+static struct jsdrvp_msg_s * locked_pop(struct msg_queue_s * q) {
+    static const uint8_t order[] = {
+        MSG_QUEUE_LANE_CONTROL, MSG_QUEUE_LANE_CRITICAL, MSG_QUEUE_LANE_DATA, MSG_QUEUE_LANE_BACKGROUND,
+    };
+    for (uint32_t idx = 0; idx < JSDRV_ARRAY_SIZE(order); ++idx) {
+        struct jsdrv_list_s * item = jsdrv_list_remove_head(lane_list(q, order[idx]));
+        if (item) {
+            if (lanes_tracked(q)) {
+                jsdrv_atomic_add(&q->depth[order[idx]], -1);
+            }
+            return JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item);
+        }
+    }
+    return NULL;
+}
+
+// Call with the critical section held.
+static bool locked_is_empty(struct msg_queue_s * q) {
+    bool rv = jsdrv_list_is_empty(&q->items);
+    for (uint32_t lane = 0; lane < MSG_QUEUE_LANE_COUNT; ++lane) {
+        rv = rv && jsdrv_list_is_empty(&q->items_lane[lane]);
+    }
+    return rv;
+}
+
+static void list_free(struct jsdrv_list_s * list) {
+    struct jsdrv_list_s * item;
+    while (NULL != (item = jsdrv_list_remove_tail(list))) {
+        jsdrv_free(JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item));
+    }
+}
+
 struct msg_queue_s * msg_queue_init() {
     struct msg_queue_s * q = jsdrv_alloc_clr(sizeof(struct msg_queue_s));
     InitializeCriticalSection(&q->critical_section);
@@ -55,24 +152,172 @@ struct msg_queue_s * msg_queue_init() {
     }
     //JSDRV_LOGI("msg_queue alloc %p %p", q, q->available_event);
     jsdrv_list_initialize(&q->items);
+    for (uint32_t lane = 0; lane < MSG_QUEUE_LANE_COUNT; ++lane) {
+        jsdrv_list_initialize(&q->items_lane[lane]);
+    }
     return q;
 }
 
+void msg_queue_lanes_enable(struct msg_queue_s * queue) {
+    queue->lanes = true;
+}
+
+void msg_queue_qos_enable(struct msg_queue_s * queue) {
+    queue->qos = true;
+}
+
+uint32_t msg_queue_depth(struct msg_queue_s * queue, uint8_t lane) {
+    if ((NULL == queue) || (lane >= MSG_QUEUE_LANE_COUNT)) {
+        return 0;
+    }
+    int32_t depth = jsdrv_atomic_load(&queue->depth[lane]);
+    return (depth > 0) ? (uint32_t) depth : 0;
+}
+
+struct msg_queue_s * msg_queue_init_spsc(uint32_t capacity) {
+    uint32_t sz = 2;
+    while (sz < capacity) {
+        sz <<= 1;
+    }
+    struct msg_queue_s * q = msg_queue_init();
+    if (NULL != q) {
+        q->ring = jsdrv_alloc_clr(sz * sizeof(struct jsdrvp_msg_s *));
+        q->ring_mask = sz - 1;
+    }
+    return q;
+}
+
+static void notify(struct msg_queue_s * q) {
+    if (q->notify_fn) {  // unlocked check, most queues do not notify
+        EnterCriticalSection(&q->critical_section);
+        if (q->notify_fn) {
+            q->notify_fn(q->notify_user_data);
+        }
+        LeaveCriticalSection(&q->critical_section);
+    }
+}
+
+static bool ring_push(struct msg_queue_s * q, struct jsdrvp_msg_s * msg) {
+    uint32_t head = (uint32_t) q->ring_head;  // only modified by this thread
+    uint32_t tail = (uint32_t) jsdrv_atomic_load(&q->ring_tail);
+    if ((head - tail) > q->ring_mask) {
+        return false;  // full
+    }
+    q->ring[head & q->ring_mask] = msg;
+    jsdrv_atomic_store(&q->ring_head, (int32_t) (head + 1));  // publish
+    return true;
+}
+
+static struct jsdrvp_msg_s * ring_pop(struct msg_queue_s * q) {
+    uint32_t tail = (uint32_t) q->ring_tail;  // only modified by this thread
+    uint32_t head = (uint32_t) jsdrv_atomic_load(&q->ring_head);
+    if (head == tail) {
+        return NULL;  // empty
+    }
+    struct jsdrvp_msg_s * msg = q->ring[tail & q->ring_mask];
+    jsdrv_atomic_store(&q->ring_tail, (int32_t) (tail + 1));  // release slot
+    return msg;
+}
+
+static struct jsdrvp_msg_s * overflow_pop(struct msg_queue_s * q) {
+    struct jsdrv_list_s * item;
+    struct jsdrvp_msg_s * msg = NULL;
+    EnterCriticalSection(&q->critical_section);
+    item = jsdrv_list_remove_head(&q->items);
+    if (item) {
+        msg = JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item);
+        jsdrv_atomic_add(&q->overflow, -1);
+    }
+    LeaveCriticalSection(&q->critical_section);
+    return msg;
+}
+
+static struct jsdrvp_msg_s * lane_pop(struct msg_queue_s * q, uint8_t lane) {
+    struct jsdrv_list_s * item = NULL;
+    if (0 != jsdrv_atomic_load(&q->depth[lane])) {
+        EnterCriticalSection(&q->critical_section);
+        item = jsdrv_list_remove_head(&q->items_lane[lane]);
+        if (item) {
+            jsdrv_atomic_add(&q->depth[lane], -1);
+        }
+        LeaveCriticalSection(&q->critical_section);
+    }
+    return item ? JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item) : NULL;
+}
+
+static void spsc_push(struct msg_queue_s * queue, struct jsdrvp_msg_s * msg) {
+    uint8_t lane = lane_get(queue, msg);
+    if (MSG_QUEUE_LANE_DATA != lane) {
+        EnterCriticalSection(&queue->critical_section);
+        jsdrv_list_add_tail(&queue->items_lane[lane], &msg->item);
+        jsdrv_atomic_add(&queue->depth[lane], 1);
+        LeaveCriticalSection(&queue->critical_section);
+    } else {
+        if (lanes_tracked(queue)) {
+            jsdrv_atomic_add(&queue->depth[MSG_QUEUE_LANE_DATA], 1);
+        }
+        // Once overflowed, continue to overflow until drained to preserve order.
+        if ((0 != jsdrv_atomic_load(&queue->overflow)) || !ring_push(queue, msg)) {
+            EnterCriticalSection(&queue->critical_section);
+            jsdrv_list_add_tail(&queue->items, &msg->item);
+            jsdrv_atomic_add(&queue->overflow, 1);
+            LeaveCriticalSection(&queue->critical_section);
+        }
+    }
+    if (1 == jsdrv_atomic_add(&queue->count, 1)) {
+        SetEvent(queue->available_event);  // only on empty -> non-empty
+        notify(queue);
+    }
+}
+
+static struct jsdrvp_msg_s * spsc_pop_immediate(struct msg_queue_s * queue) {
+    struct jsdrvp_msg_s * msg = lane_pop(queue, MSG_QUEUE_LANE_CONTROL);  // control lane overtakes data
+    if (NULL == msg) {
+        msg = lane_pop(queue, MSG_QUEUE_LANE_CRITICAL);
+    }
+    if (NULL == msg) {
+        msg = ring_pop(queue);
+        if ((NULL == msg) && (0 != jsdrv_atomic_load(&queue->overflow))) {
+            msg = overflow_pop(queue);  // ring items always precede overflow items
+        }
+        if ((NULL != msg) && lanes_tracked(queue)) {
+            jsdrv_atomic_add(&queue->depth[MSG_QUEUE_LANE_DATA], -1);
+        }
+    }
+    if (NULL == msg) {
+        msg = lane_pop(queue, MSG_QUEUE_LANE_BACKGROUND);
+    }
+    if (NULL != msg) {
+        // The count may briefly go negative when the consumer takes a
+        // message before the producer increments the count.
+        jsdrv_atomic_add(&queue->count, -1);
+    } else {
+        // Reset only when drained.  Reassert if the producer added
+        // a message that arrived after our empty check.
+        ResetEvent(queue->available_event);
+        if (jsdrv_atomic_load(&queue->count) > 0) {
+            SetEvent(queue->available_event);
+        }
+    }
+    return msg;
+}
+
 void msg_queue_finalize(struct msg_queue_s * queue) {
     struct jsdrvp_msg_s * msg;
     if (NULL != queue) {
         //JSDRV_LOGI("msg_queue free %p %p", queue, queue->available_event);
-        EnterCriticalSection(&queue->critical_section);
-        while (1) {
-            // return items in the queue.
-            struct jsdrv_list_s * item = jsdrv_list_remove_tail(&queue->items);
-            if (item) {
-                msg = JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item);
+        if (queue->ring) {
+            while (NULL != (msg = ring_pop(queue))) {
                 jsdrv_free(msg);
-            } else {
-                break;
             }
+            jsdrv_free(queue->ring);
+            queue->ring = NULL;
+        }
+        EnterCriticalSection(&queue->critical_section);
+        for (uint32_t lane = 0; lane < MSG_QUEUE_LANE_COUNT; ++lane) {
+            list_free(&queue->items_lane[lane]);
         }
+        list_free(&queue->items);
         LeaveCriticalSection(&queue->critical_section);
         DeleteCriticalSection(&queue->critical_section);
         CloseHandle(queue->available_event);
@@ -86,8 +331,15 @@ bool msg_queue_is_empty(struct msg_queue_s* queue) {
     if (NULL == queue) {
         return true;
     }
+    if (queue->ring) {
+        return (jsdrv_atomic_load(&queue->ring_head) == jsdrv_atomic_load(&queue->ring_tail))
+            && (0 == jsdrv_atomic_load(&queue->overflow))
+            && (0 == jsdrv_atomic_load(&queue->depth[MSG_QUEUE_LANE_CONTROL]))
+            && (0 == jsdrv_atomic_load(&queue->depth[MSG_QUEUE_LANE_CRITICAL]))
+            && (0 == jsdrv_atomic_load(&queue->depth[MSG_QUEUE_LANE_BACKGROUND]));
+    }
     EnterCriticalSection(&queue->critical_section);
-    rv = jsdrv_list_is_empty(&queue->items);
+    rv = locked_is_empty(queue);
     LeaveCriticalSection(&queue->critical_section);
     return rv;
 }
@@ -95,27 +347,60 @@ bool msg_queue_is_empty(struct msg_queue_s* queue) {
 void msg_queue_push(struct msg_queue_s * queue, struct jsdrvp_msg_s * msg) {
     JSDRV_DBC_NOT_NULL(queue);
     JSDRV_DBC_NOT_NULL(msg);
+    if (queue->ring) {
+        jsdrv_list_remove(&msg->item);  // remove from any existing list
+        spsc_push(queue, msg);
+        return;
+    }
     EnterCriticalSection(&queue->critical_section);
     jsdrv_list_remove(&msg->item);  // remove from any existing list
-    jsdrv_list_add_tail(&queue->items, &msg->item);
+    locked_add(queue, msg);
     SetEvent(queue->available_event);
+    if (queue->notify_fn) {
+        queue->notify_fn(queue->notify_user_data);
+    }
     LeaveCriticalSection(&queue->critical_section);
 }
 
-struct jsdrvp_msg_s * msg_queue_pop_immediate(struct msg_queue_s* queue) {
+void msg_queue_push_list(struct msg_queue_s * queue, struct jsdrv_list_s * list) {
+    JSDRV_DBC_NOT_NULL(queue);
+    JSDRV_DBC_NOT_NULL(list);
     struct jsdrv_list_s * item;
-    struct jsdrvp_msg_s * msg = NULL;
-    if (NULL == queue) {
-        return NULL;
+    if (queue->ring) {
+        while (NULL != (item = jsdrv_list_remove_head(list))) {
+            spsc_push(queue, JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item));
+        }
+        return;
+    }
+    if (jsdrv_list_is_empty(list)) {
+        return;
     }
     EnterCriticalSection(&queue->critical_section);
-    item = jsdrv_list_remove_head(&queue->items);
-    if (item) {
-        msg = JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item);
-        if (jsdrv_list_is_empty(&queue->items)) {
-            ResetEvent(queue->available_event);
+    if (lanes_tracked(queue)) {
+        while (NULL != (item = jsdrv_list_remove_head(list))) {
+            locked_add(queue, JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item));
         }
     } else {
+        jsdrv_list_append(&queue->items, list);
+    }
+    SetEvent(queue->available_event);
+    if (queue->notify_fn) {
+        queue->notify_fn(queue->notify_user_data);
+    }
+    LeaveCriticalSection(&queue->critical_section);
+}
+
+struct jsdrvp_msg_s * msg_queue_pop_immediate(struct msg_queue_s* queue) {
+    struct jsdrvp_msg_s * msg;
+    if (NULL == queue) {
+        return NULL;
+    }
+    if (queue->ring) {
+        return spsc_pop_immediate(queue);
+    }
+    EnterCriticalSection(&queue->critical_section);
+    msg = locked_pop(queue);
+    if (locked_is_empty(queue)) {
         ResetEvent(queue->available_event);
     }
     LeaveCriticalSection(&queue->critical_section);
@@ -153,3 +438,10 @@ int32_t msg_queue_pop(struct msg_queue_s* queue, struct jsdrvp_msg_s ** msg, uin
 msg_handle msg_queue_handle_get(struct msg_queue_s* queue) {
     return (NULL == queue) ? NULL : queue->available_event;
 }
+
+void msg_queue_notify_set(struct msg_queue_s * queue, msg_queue_notify_fn fn, void * user_data) {
+    EnterCriticalSection(&queue->critical_section);
+    queue->notify_fn = fn;
+    queue->notify_user_data = user_data;
+    LeaveCriticalSection(&queue->critical_section);
+}
@@ -15,6 +15,8 @@
 */
 
 #include "jsdrv_prv/buffer.h"
+#include "jsdrv_prv/alloc.h"
+#include "jsdrv_prv/atomic.h"
 #include "jsdrv_prv/buffer_signal.h"
 #include "jsdrv_prv/cdef.h"
 #include "jsdrv_prv/dbc.h"
@@ -26,14 +28,28 @@
 #include "jsdrv_prv/list.h"
 #include "jsdrv_prv/log.h"
 #include "jsdrv_prv/msg_queue.h"
+#include "jsdrv_prv/mutex.h"
+#include "jsdrv_prv/perf.h"
+#include "jsdrv_prv/record.h"
+#include "jsdrv_prv/stream_event.h"
 #include "jsdrv_prv/thread.h"
+#include "jsdrv_prv/trace.h"
 #include "jsdrv.h"
 #include "tinyprintf.h"
 #include <math.h>
 #include <inttypes.h>
 
 
-#define BUFFER_THREAD_WAIT_TIMEOUT_MS  (50)
+#define BUFFER_THREAD_WAIT_TIMEOUT_MS  (50)   // snapshot completion check
+#define BUFFER_INFO_RATE_DEFAULT       (20)   // Hz
+#define BUFFER_READ_RETRIES            (3)    // snapshot reads before reading under lock
+#define BUFFER_SUMMARY_IDLE_MS         (20)   // idle time before completing the lazy summary levels
+#define BUFFER_PREFETCH_CLIENTS        (8)    // tracked rsp_topic clients for g/prefch
+#define BUFFER_PREFETCH_WINDOWS        (4)    // speculative windows per summary request
+#define REQ_FLAGS_STANDING             (JSDRV_BUFFER_REQUEST_FLAG_STANDING | JSDRV_BUFFER_REQUEST_FLAG_DISPLAY)
+#define RSP_DATA_SIZE                  (sizeof(struct jsdrv_stream_signal_s) \
+                                        - sizeof(struct jsdrv_buffer_response_s) \
+                                        - JSDRV_BUFSIG_RSP_SLACK)  // response message data capacity
 JSDRV_STATIC_ASSERT(16 == sizeof(struct jsdrv_summary_entry_s), entry_size_one);
 JSDRV_STATIC_ASSERT(32 == sizeof(struct jsdrv_summary_entry_s[2]), entry_size_two);
 JSDRV_STATIC_ASSERT(JSDRV_BUFSIG_COUNT_MAX <= 256, bufsig_fits_in_u8); // assumed for add/remove/list operations
@@ -71,35 +87,150 @@ enum buffer_state_s {
     ST_ACTIVE,
 };
 
+enum snap_state_e {
+    SNAP_NONE = 0,
+    SNAP_POST = 1,          // capturing the post-trigger duration
+    SNAP_READY = 2,
+};
+
+enum req_msg_e {
+    REQ_MSG_POST = 0,       // value is jsdrv_buffer_request_s
+    REQ_MSG_CANCEL = 1,     // value is the i64 rsp_id
+    REQ_MSG_MULTI = 2,      // value is jsdrv_buffer_multi_request_s
+    REQ_MSG_ALLOC = 3,      // value is alloc_req_s
+    REQ_MSG_STANDING = 4,   // new samples for the standing requests
+    REQ_MSG_EXPORT = 5,     // value is export_post_s
+};
+
+// A jsdrv_buffer_export_s in progress, owned by the reader thread.
+struct export_s {
+    struct jsdrv_record_s * record;
+    uint32_t percent;                   // the last published progress
+    struct jsdrv_stream_signal_s signal;  // the chunk to write
+};
+
+// REQ_MSG_EXPORT: start an export on the reader thread.
+struct export_post_s {
+    struct jsdrv_buffer_request_s req;  // the stream request for the range
+    struct export_s * export;
+};
+
+// The most recent summary window for one rsp_topic, owned by the reader thread.
+struct prefetch_s {
+    char rsp_topic[JSDRV_TOPIC_LENGTH_MAX];  // "" when unused
+    uint32_t signal_id;
+    bool envelope;                      // JSDRV_BUFFER_REQUEST_FLAG_ENVELOPE
+    uint64_t start;                     // the first sample id
+    uint64_t incr;                      // samples per entry
+    uint64_t length;                    // entries
+    int64_t velocity;                   // the last pan in samples, 0 for none
+    int8_t zoom;                        // the last zoom: 1 out, -1 in, 0 none
+    uint8_t window;                     // the next speculative window, BUFFER_PREFETCH_WINDOWS when done
+    uint32_t budget;                    // the remaining tiles to compute
+    uint64_t used;                      // buffer_s.prefetch_clock on the last request
+};
+
 struct req_s {
     uint32_t signal_id;
     struct jsdrv_buffer_request_s req;
+    uint64_t stream_seq;                // the next chunk for JSDRV_BUFFER_REQUEST_FLAG_STREAM
+    uint64_t stream_count;              // the total chunks, 0 before planning
+    uint64_t standing_next;             // the next entry for JSDRV_BUFFER_REQUEST_FLAG_STANDING
+    int64_t frame_time;                 // the last JSDRV_BUFFER_REQUEST_FLAG_DISPLAY frame
+    struct export_s * export;           // writes the stream chunks to a file, NULL to respond
     struct jsdrv_list_s item;
 };
 
+// The signal allocation configuration.
+struct buffer_cfg_s {
+    uint64_t size;
+    char storage_dir[JSDRV_BUFFER_STORAGE_PATH_MAX];  // file-backed level 0, "" for RAM
+    uint32_t mem_flags;                              // jsdrv_os_mem_flags_e for level 0
+    int32_t numa_node;                               // preferred level 0 NUMA node, -1 for default
+    uint8_t codec;                                   // 1 compresses level 0
+    uint8_t integral;                                // 1 indexes float signals for integrals
+    uint8_t histogram;                               // 1 indexes float signals for quantiles
+    uint8_t trend_level;                             // trend summary level, 0 for the default
+    uint32_t trend;                                  // trend history as a multiple of level 0, 0 to disable
+    uint32_t tile_cache;                             // cached summary tiles per signal, 0 to disable
+    uint32_t r0;                                     // samples per level 1 entry, 0 for the default
+    uint32_t rN;                                     // entries per upper level entry, 0 for the default
+};
+
+// REQ_MSG_ALLOC: allocate an added signal on the reader thread.
+struct alloc_req_s {
+    struct buffer_cfg_s cfg;                         // the buffer thread's copy
+    uint64_t cfg_gen;                                // discard the allocation if changed
+    double duration;                                 // the allocated seconds per signal
+    uint8_t rebalance;
+    struct bufsig_stream_header_s hdr;               // from the signal's first data
+};
+JSDRV_STATIC_ASSERT(sizeof(struct alloc_req_s) <= JSDRV_PAYLOAD_LENGTH_MAX, alloc_req_fits_in_payload);
+JSDRV_STATIC_ASSERT(JSDRV_BUFFER_READ_SLACK == JSDRV_BUFSIG_RSP_SLACK, buffer_read_slack);
+
+struct buffer_s;
+
+// Ingests the signals with (signal_idx % worker_count) == worker index.
+struct buffer_worker_s {
+    struct buffer_s * parent;
+    struct msg_queue_s * q;                          // buffer thread to worker
+    jsdrv_os_mutex_t mutex;                          // protects the worker's signals
+    jsdrv_thread_t thread;
+    uint8_t summary_pending;                         // 1 after ingestion until the idle summary update
+    volatile uint8_t do_exit;
+};
+
 struct buffer_s {
     uint8_t idx;
     uint8_t hold;
     enum buffer_state_s state;
     char topic[JSDRV_TOPIC_LENGTH_MAX];
     struct jsdrv_context_s * context;
-    uint64_t size;
+    struct buffer_cfg_s cfg;                         // written by the buffer thread only
+    uint64_t cfg_gen;                                // incremented by buffer_free, under all signal locks
+    double duration;                                 // the allocated seconds per signal
+    uint8_t rebalance;                               // 1 shrinks the signals to fit an added signal
+    volatile uint8_t alloc_pending[JSDRV_BUFSIG_COUNT_MAX];  // 1 while the reader allocates the signal
     struct msg_queue_s * cmd_q;
-    struct jsdrv_list_s req_pending;
-    struct jsdrv_list_s req_free;
+    struct msg_queue_s * req_q;                      // buffer thread to reader thread
+    struct jsdrv_list_s req_pending;                 // owned by the reader thread
+    struct jsdrv_list_s req_free;                    // owned by the reader thread
+    struct jsdrv_list_s req_standing;                // owned by the reader thread
+    volatile int32_t standing_count;                 // req_standing entries, written by the reader thread
+    volatile int32_t standing_acks;                  // standing requests posted, written by the reader thread
+    int32_t standing_posts;                          // standing requests forwarded, written by the buffer thread
+    int64_t standing_time;                           // last standing request update
+    uint64_t standing_head[JSDRV_BUFSIG_COUNT_MAX];  // sample_id_head at the last standing request update
+    volatile uint32_t display_rate;                  // the fastest display frame rate in Hz, written by the reader thread
+    volatile uint8_t req_latest;                     // 1 keeps only the newest request per rsp_topic
+    volatile uint8_t prefetch;                       // 1 speculatively computes summary tiles near recent requests
+    struct prefetch_s prefetch_clients[BUFFER_PREFETCH_CLIENTS];  // owned by the reader thread
+    uint64_t prefetch_clock;                         // the last assigned prefetch_s.used
+    uint32_t snap_post_ms;                           // post-trigger duration for g/!snap
+    uint8_t snap_state;                              // snap_state_e
+    uint64_t snap_end[JSDRV_BUFSIG_COUNT_MAX];       // the sample_id_head that completes SNAP_POST
+    struct bufsig_s * snap;                          // frozen signals[JSDRV_BUFSIG_COUNT_MAX], NULL for none
+    uint32_t info_rate;                              // Hz, 0 publishes on every update
+    int64_t info_time;                               // last rate-limited info publish
+    uint8_t info_pending[JSDRV_BUFSIG_COUNT_MAX];    // 1 when info changed since publish
+    uint32_t worker_count;                           // 0 ingests on the buffer thread
+    uint8_t summary_pending;                         // 1 after buffer thread ingestion until the idle summary update
+    struct buffer_worker_s workers[JSDRV_BUFFER_WORKERS_MAX];
+    jsdrv_os_mutex_t mutex;                          // protects the signals without workers
+    jsdrv_os_mutex_t read_mutex;                     // held by the reader to exclude reconfiguration
     jsdrv_thread_t thread;
+    jsdrv_thread_t reader_thread;
     volatile uint8_t do_exit;
+    volatile uint8_t reader_exit;
     struct bufsig_s signals[JSDRV_BUFSIG_COUNT_MAX];  // 0 is reserved
 };
 
-struct buffer_mgr_s {
+struct jsdrv_buffer_mgr_s {
     struct jsdrv_context_s * context;
     struct buffer_s buffers[JSDRV_BUFFER_COUNT_MAX];
 };
 
 
-static struct buffer_mgr_s instance_ = {.context = NULL};
-
 static uint8_t _buffer_recv(void * user_data, struct jsdrvp_msg_s * msg);
 static uint8_t _buffer_recv_data(void * user_data, struct jsdrvp_msg_s * msg);
 
@@ -107,11 +238,41 @@ static bool is_buffer_idx_valid(uint64_t buffer_idx) {
     return ((buffer_idx >= 1) && (buffer_idx <= JSDRV_BUFFER_COUNT_MAX));
 }
 
-static bool is_signal_idx_valid(uint64_t signal_idx) {
-    return ((signal_idx >= 1) && (signal_idx <= JSDRV_BUFSIG_COUNT_MAX));
+/*
+ * Locking: the ingesting thread holds the signal mutex while it modifies
+ * a signal.  The reader holds read_mutex while it processes a request and
+ * only briefly takes the signal mutex to snapshot and validate.
+ * Reconfiguration takes read_mutex and then all signal mutexes.
+ */
+
+static jsdrv_os_mutex_t bufsig_mutex(struct buffer_s * self, uint32_t signal_idx) {
+    if (0 == self->worker_count) {
+        return self->mutex;
+    }
+    return self->workers[signal_idx % self->worker_count].mutex;
 }
 
-static void send_to_frontend(struct buffer_mgr_s * self, const char * topic, const struct jsdrv_union_s * value) {
+static void bufsig_lock_all(struct buffer_s * self) {
+    jsdrv_os_mutex_lock(self->read_mutex);
+    if (0 == self->worker_count) {
+        jsdrv_os_mutex_lock(self->mutex);
+    }
+    for (uint32_t i = 0; i < self->worker_count; ++i) {
+        jsdrv_os_mutex_lock(self->workers[i].mutex);
+    }
+}
+
+static void bufsig_unlock_all(struct buffer_s * self) {
+    for (uint32_t i = self->worker_count; i > 0; --i) {
+        jsdrv_os_mutex_unlock(self->workers[i - 1].mutex);
+    }
+    if (0 == self->worker_count) {
+        jsdrv_os_mutex_unlock(self->mutex);
+    }
+    jsdrv_os_mutex_unlock(self->read_mutex);
+}
+
+static void send_to_frontend(struct jsdrv_buffer_mgr_s * self, const char * topic, const struct jsdrv_union_s * value) {
     struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, topic, value);
     jsdrvp_backend_send(self->context, m);
 }
@@ -150,8 +311,7 @@ static int32_t unsubscribe(struct jsdrv_context_s * context, const char * topic,
 
 static void bufsig_unsub(struct bufsig_s * b) {
     if (b->topic[0]) {
-        intptr_t v = ((((intptr_t) (b->idx)) & 0xffff) << 16) | (b->parent->idx & 0xffff);
-        unsubscribe(b->parent->context, b->topic, JSDRV_SFLAG_PUB, _buffer_recv_data, (void *) v);
+        unsubscribe(b->parent->context, b->topic, JSDRV_SFLAG_PUB, _buffer_recv_data, b);
         b->topic[0] = 0;
     }
 }
@@ -159,8 +319,7 @@ static void bufsig_unsub(struct bufsig_s * b) {
 static void bufsig_sub(struct bufsig_s * b, const char * topic) {
     bufsig_unsub(b);
     jsdrv_cstr_copy(b->topic, topic, sizeof(b->topic));
-    intptr_t v = ((((intptr_t) (b->idx)) & 0xffff) << 16) | (b->parent->idx & 0xffff);
-    subscribe(b->parent->context, b->topic, JSDRV_SFLAG_PUB, _buffer_recv_data, (void *) v);
+    subscribe(b->parent->context, b->topic, JSDRV_SFLAG_PUB, _buffer_recv_data, b);
 }
 
 static void buf_publish_signal_list(struct buffer_s * self) {
@@ -190,6 +349,7 @@ static bool await_check(struct buffer_s * self) {
 static void bufsig_publish_info(struct bufsig_s * self) {
     struct jsdrv_context_s * context = self->parent->context;
     struct jsdrv_buffer_info_s info;
+    self->parent->info_pending[self->idx] = 0;
     if (jsdrv_bufsig_info(self, &info)) {
         struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(context, "",
                 &jsdrv_union_cbin_r((uint8_t *) &info, sizeof(info)));
@@ -199,164 +359,1481 @@ static void bufsig_publish_info(struct bufsig_s * self) {
     }
 }
 
-static void buffer_alloc(struct buffer_s * self) {
-    double coef_f32 = sizeof(float);
-    double coef_u = 0.0;
-    JSDRV_LOGI("buffer_alloc %" PRIu64, self->size);
-    size_t summary_entry_sz = sizeof(struct jsdrv_summary_entry_s);
+static void info_process(struct buffer_s * self) {
+    if (0 == self->info_rate) {
+        return;
+    }
+    int64_t t = jsdrv_time_utc();
+    if ((t - self->info_time) < (JSDRV_TIME_SECOND / self->info_rate)) {
+        return;
+    }
+    self->info_time = t;
+    for (uint32_t idx = 1; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
+        if (self->info_pending[idx]) {
+            jsdrv_os_mutex_t mutex = bufsig_mutex(self, idx);
+            jsdrv_os_mutex_lock(mutex);
+            if (self->info_pending[idx]) {
+                bufsig_publish_info(&self->signals[idx]);
+            }
+            jsdrv_os_mutex_unlock(mutex);
+        }
+    }
+}
+
+static uint32_t standing_rate(struct buffer_s * self) {
+    uint32_t rate = self->info_rate ? self->info_rate : BUFFER_INFO_RATE_DEFAULT;
+    uint32_t display_rate = self->display_rate;
+    return (display_rate > rate) ? display_rate : rate;
+}
+
+static bool standing_is_active(struct buffer_s * self) {
+    return (jsdrv_atomic_load(&self->standing_count) > 0)
+        || (jsdrv_atomic_load(&self->standing_acks) != self->standing_posts);
+}
+
+// Wake the reader thread for standing requests when any signal received samples.
+static void standing_wake(struct buffer_s * self) {
+    if ((self->state != ST_ACTIVE) || !standing_is_active(self)) {
+        return;
+    }
+    int64_t t = jsdrv_time_utc();
+    if ((t - self->standing_time) < (JSDRV_TIME_SECOND / standing_rate(self))) {
+        return;
+    }
+    self->standing_time = t;
+    bool changed = false;
+    for (uint32_t idx = 1; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
+        struct bufsig_s * b = &self->signals[idx];
+        if (!b->active) {
+            continue;
+        }
+        jsdrv_os_mutex_t mutex = bufsig_mutex(self, idx);
+        jsdrv_os_mutex_lock(mutex);
+        uint64_t head = b->sample_id_head;
+        jsdrv_os_mutex_unlock(mutex);
+        if (head != self->standing_head[idx]) {
+            self->standing_head[idx] = head;
+            changed = true;
+        }
+    }
+    if (changed) {
+        struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc_value(self->context, "", &jsdrv_union_u32(0));
+        msg->u32_b = REQ_MSG_STANDING;
+        msg_queue_push(self->req_q, msg);
+    }
+}
+
+static void snap_state_publish(struct buffer_s * self, uint8_t state) {
+    self->snap_state = state;
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, "", &jsdrv_union_u8_r(state));
+    tfp_snprintf(m->topic, sizeof(m->topic), "%s/%s", self->topic, JSDRV_BUFFER_MSG_SNAP_STATE);
+    jsdrvp_backend_send(self->context, m);
+}
+
+static void snap_publish_info(struct buffer_s * self, struct bufsig_s * b) {
+    struct jsdrv_buffer_info_s info;
+    if (jsdrv_bufsig_info(b, &info)) {
+        struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, "",
+                &jsdrv_union_cbin_r((uint8_t *) &info, sizeof(info)));
+        tfp_snprintf(m->topic, sizeof(m->topic), "m/%03d/s/%03d/snap", self->idx, b->idx);
+        m->value.app = JSDRV_PAYLOAD_TYPE_BUFFER_INFO;
+        jsdrvp_backend_send(self->context, m);
+    }
+}
+
+// Call with all signals locked.
+static void snap_free(struct buffer_s * self) {
+    if (NULL != self->snap) {
+        for (uint32_t idx = 0; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
+            jsdrv_bufsig_free(&self->snap[idx]);
+        }
+        jsdrv_free(self->snap);
+        self->snap = NULL;
+    }
+    if (SNAP_NONE != self->snap_state) {
+        snap_state_publish(self, SNAP_NONE);
+    }
+}
+
+static void snap_freeze(struct buffer_s * self) {
+    bufsig_lock_all(self);
+    if (NULL == self->snap) {
+        self->snap = jsdrv_alloc_clr_cat(JSDRV_BUFSIG_COUNT_MAX * sizeof(struct bufsig_s), JSDRV_ALLOC_CAT_BUFFER);
+    }
+    for (uint32_t idx = 1; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
+        struct bufsig_s * b = &self->signals[idx];
+        struct bufsig_s * f = &self->snap[idx];
+        if (b->active && (NULL != b->level0_data)) {
+            jsdrv_bufsig_freeze(b, f);
+        } else {
+            jsdrv_bufsig_free(f);
+            f->active = false;
+        }
+    }
+    bufsig_unlock_all(self);
+    JSDRV_LOGI("%s snapshot ready", self->topic);
+    for (uint32_t idx = 1; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
+        if (self->snap[idx].active) {
+            snap_publish_info(self, &self->snap[idx]);
+        }
+    }
+    snap_state_publish(self, SNAP_READY);
+}
+
+static int32_t snap_start(struct buffer_s * self) {
+    if (self->state != ST_ACTIVE) {
+        return JSDRV_ERROR_UNAVAILABLE;
+    } else if (SNAP_POST == self->snap_state) {
+        return JSDRV_ERROR_BUSY;
+    }
+    for (uint32_t idx = 1; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
+        struct bufsig_s * b = &self->signals[idx];
+        if (!b->active || (0 == b->hdr.sample_rate)) {
+            continue;
+        }
+        jsdrv_os_mutex_t mutex = bufsig_mutex(self, idx);
+        jsdrv_os_mutex_lock(mutex);
+        uint64_t rate = b->hdr.sample_rate / b->hdr.decimate_factor;
+        self->snap_end[idx] = b->sample_id_head + ((uint64_t) self->snap_post_ms * rate) / 1000;
+        jsdrv_os_mutex_unlock(mutex);
+    }
+    JSDRV_LOGI("%s snapshot in %u ms", self->topic, (unsigned int) self->snap_post_ms);
+    snap_state_publish(self, SNAP_POST);
+    return 0;
+}
+
+// Freeze once every signal received the post-trigger samples.
+static void snap_process(struct buffer_s * self) {
+    if ((SNAP_POST != self->snap_state) || (self->state != ST_ACTIVE)) {
+        return;
+    }
+    for (uint32_t idx = 1; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
+        struct bufsig_s * b = &self->signals[idx];
+        if (!b->active) {
+            continue;
+        }
+        jsdrv_os_mutex_t mutex = bufsig_mutex(self, idx);
+        jsdrv_os_mutex_lock(mutex);
+        bool pending = b->sample_id_head < self->snap_end[idx];
+        jsdrv_os_mutex_unlock(mutex);
+        if (pending) {
+            return;
+        }
+    }
+    snap_freeze(self);
+}
+
+static bool hdr_is_f32(const struct bufsig_stream_header_s * hdr) {
+    return (hdr->element_type == JSDRV_DATA_TYPE_FLOAT) && (hdr->element_size_bits == 32);
+}
+
+static uint64_t cfg_r0(const struct buffer_cfg_s * cfg, bool is_f32) {
+    if (cfg->r0) {
+        return cfg->r0;
+    }
+    return is_f32 ? 128 : 1024;
+}
+
+static uint64_t cfg_rN(const struct buffer_cfg_s * cfg) {
+    return cfg->rN ? cfg->rN : 32;
+}
+
+// The summary level bytes per sample.
+static uint8_t cfg_trend_level(const struct buffer_cfg_s * cfg) {
+    return cfg->trend_level ? cfg->trend_level : 2;
+}
+
+// The samples per trend entry.
+static uint64_t cfg_trend_spe(const struct buffer_cfg_s * cfg, bool is_f32) {
+    uint64_t spe = cfg_r0(cfg, is_f32);
+    for (uint8_t lvl = 1; lvl < cfg_trend_level(cfg); ++lvl) {
+        spe *= cfg_rN(cfg);
+    }
+    return spe;
+}
+
+static double summary_coef(uint64_t r0, uint64_t rN) {
+    double coef = 0.0;
+    double samples_per_entry = (double) r0;
     for (uint32_t lvl = 1; lvl < 8; ++lvl) {
-        double pow_lvl = pow(32.0, lvl - 1);
-        coef_f32 += summary_entry_sz / (128 * pow_lvl);
-        coef_u += summary_entry_sz / (1024 * pow_lvl);
+        coef += sizeof(struct jsdrv_summary_entry_s) / samples_per_entry;
+        samples_per_entry *= rN;
+    }
+    return coef;
+}
+
+static bool reduction_valid(uint32_t r, uint32_t r_min, uint32_t r_max) {
+    return (0 == r) || ((r >= r_min) && (r <= r_max) && (0 == (r & (r - 1))));
+}
+
+// The storage bytes per second for a signal.
+static double bufsig_rate(const struct buffer_cfg_s * cfg, const struct bufsig_stream_header_s * hdr) {
+    bool is_f32 = hdr_is_f32(hdr);
+    double coef = summary_coef(cfg_r0(cfg, is_f32), cfg_rN(cfg));
+    uint32_t sample_rate = hdr->sample_rate / hdr->decimate_factor;
+    if (cfg->trend) {  // trend entries retained for trend times the level 0 duration
+        coef += (sizeof(struct jsdrv_summary_entry_s) * (double) cfg->trend) / cfg_trend_spe(cfg, is_f32);
+    }
+    if (is_f32) {
+        if (cfg->histogram) {  // u16 level 1 bins and u32 upper level bins
+            double r0 = (double) cfg_r0(cfg, is_f32);
+            coef += JSDRV_BUFSIG_HIST_BINS * (2.0 / r0 + 4.0 / (r0 * (cfg_rN(cfg) - 1)));
+        }
+        return sample_rate * (sizeof(float) + coef);
+    }
+    return sample_rate * ((hdr->element_size_bits / 8.0) + coef);
+}
+
+// The sample count to store duration seconds.
+static uint64_t bufsig_plan(const struct buffer_cfg_s * cfg, const struct bufsig_stream_header_s * hdr,
+                            double duration, uint64_t * level0_budget) {
+    uint32_t sample_rate = hdr->sample_rate / hdr->decimate_factor;
+    double N = duration * sample_rate;
+    uint64_t r0 = cfg_r0(cfg, hdr_is_f32(hdr));
+    uint64_t rN = cfg_rN(cfg);
+    int64_t level = (int64_t) (ceil(log2(N / (double) (r0 * (rN * rN - 1))) / log2((double) rN) + 1.0));
+    if (level < 1) {
+        level = 1;
+    }
+    uint64_t rZ = r0;
+    for (int i = 1; i <= level; ++i) {
+        rZ *= rN;
+    }
+    uint64_t k = (uint64_t) (round(N / rZ));
+    if (k == 0) {
+        k = 1;
+    }
+    uint64_t Np = k * rZ;
+    *level0_budget = 0;
+    if (cfg->codec) {
+        // same level 0 budget, up to JSDRV_BUFFER_CODEC_SPAN times the history
+        *level0_budget = (Np * hdr->element_size_bits + 7) / 8;
+        Np *= JSDRV_BUFFER_CODEC_SPAN;
+    }
+    return Np;
+}
+
+// Configure and allocate a signal with its hdr to store duration seconds.
+static void bufsig_cfg_alloc(const struct buffer_cfg_s * cfg, struct bufsig_s * b, double duration) {
+    uint64_t level0_budget = 0;
+    uint64_t N = bufsig_plan(cfg, &b->hdr, duration, &level0_budget);
+    b->codec = cfg->codec;
+    b->level0_budget = level0_budget;
+    b->integral = cfg->integral;
+    b->histogram = cfg->histogram;
+    b->trend_level = cfg->trend ? cfg_trend_level(cfg) : 0;
+    b->trend_k = ((level0_budget ? (N / JSDRV_BUFFER_CODEC_SPAN) : N) * cfg->trend)
+            / cfg_trend_spe(cfg, hdr_is_f32(&b->hdr));
+    b->tile_count = cfg->tile_cache;
+    b->storage_dir = cfg->storage_dir;
+    b->mem_flags = cfg->mem_flags;
+    b->numa_node = cfg->numa_node;
+    jsdrv_bufsig_alloc(b, N, cfg_r0(cfg, hdr_is_f32(&b->hdr)), cfg_rN(cfg));
+}
+
+// Call with all signals locked.
+static void buffer_alloc(struct buffer_s * self) {
+    JSDRV_LOGI("buffer_alloc %" PRIu64, self->cfg.size);
+
+    // determine size in bytes per second
+    double sz_per_s = 0.0;
+    for (uint32_t idx = 1; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
+        struct bufsig_s *b = &self->signals[idx];
+        if (b->active) {
+            sz_per_s += bufsig_rate(&self->cfg, &b->hdr);
+        }
+    }
+    // determine sample count for each signal, allocate, and publish duration
+    self->duration = self->cfg.size / sz_per_s;
+    JSDRV_LOGI("%d B/s -> %d seconds", (int) sz_per_s, (int) self->duration);
+    for (uint32_t idx = 1; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
+        struct bufsig_s *b = &self->signals[idx];
+        if (b->active) {
+            bufsig_cfg_alloc(&self->cfg, b, self->duration);
+            bufsig_publish_info(b);
+        }
+    }
+    self->info_time = jsdrv_time_utc();
+}
+
+static void buffer_free(struct buffer_s * self) {
+    bufsig_lock_all(self);
+    ++self->cfg_gen;  // discard allocations in progress
+    if (self->state == ST_ACTIVE) {
+        self->state = ST_AWAIT;
+    }
+    for (uint32_t idx = 0; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
+        struct bufsig_s *b = &self->signals[idx];
+        jsdrv_bufsig_clear(b);
+        bufsig_publish_info(b);
+        jsdrv_bufsig_free(b);
+    }
+    snap_free(self);
+    bufsig_unlock_all(self);
+}
+
+#define BUFFER_FILE_MAGIC (0x465542565244534ALLU)  // "JSDRVBUF" little endian
+
+// The g/!save file header, followed by signal_count jsdrv_bufsig_save() records.
+struct buffer_file_s {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t signal_count;
+};
+
+static int32_t buffer_save(struct buffer_s * self, const char * path) {
+    struct buffer_file_s h = {.magic = BUFFER_FILE_MAGIC, .version = JSDRV_BUFSIG_FILE_VERSION, .signal_count = 0};
+    int32_t rc = 0;
+    bufsig_lock_all(self);
+    for (uint32_t idx = 1; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
+        struct bufsig_s * b = &self->signals[idx];
+        if (b->active && (NULL != b->level0_data)) {
+            if (NULL != b->blocks) {
+                rc = JSDRV_ERROR_NOT_SUPPORTED;
+            }
+            ++h.signal_count;
+        }
+    }
+    FILE * f = rc ? NULL : fopen(path, "wb");
+    if (0 == rc) {
+        if (NULL == f) {
+            rc = JSDRV_ERROR_IO;
+        } else if (1 != fwrite(&h, sizeof(h), 1, f)) {
+            rc = JSDRV_ERROR_IO;
+        }
+    }
+    for (uint32_t idx = 1; (0 == rc) && (idx < JSDRV_BUFSIG_COUNT_MAX); ++idx) {
+        struct bufsig_s * b = &self->signals[idx];
+        if (b->active && (NULL != b->level0_data)) {
+            rc = jsdrv_bufsig_save(b, f);
+        }
+    }
+    bufsig_unlock_all(self);
+    if ((NULL != f) && fclose(f) && (0 == rc)) {
+        rc = JSDRV_ERROR_IO;
+    }
+    JSDRV_LOGI("save %u signals to %s: %d", (unsigned int) h.signal_count, path, (int) rc);
+    return rc;
+}
+
+static int32_t buffer_load(struct buffer_s * self, const char * path) {
+    struct buffer_file_s h;
+    FILE * f = fopen(path, "rb");
+    if (NULL == f) {
+        return JSDRV_ERROR_IO;
+    }
+    int32_t rc = 0;
+    if (1 != fread(&h, sizeof(h), 1, f)) {
+        rc = JSDRV_ERROR_IO;
+    } else if ((BUFFER_FILE_MAGIC != h.magic) || (JSDRV_BUFSIG_FILE_VERSION != h.version)) {
+        rc = JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    uint32_t loaded = 0;
+    for (uint32_t i = 0; (0 == rc) && (i < h.signal_count); ++i) {
+        uint32_t idx = 0;
+        struct bufsig_s * staged = jsdrv_alloc_clr_cat(sizeof(struct bufsig_s), JSDRV_ALLOC_CAT_BUFFER);
+        staged->storage_dir = self->cfg.storage_dir;
+        staged->mem_flags = self->cfg.mem_flags;
+        staged->numa_node = self->cfg.numa_node;
+        rc = jsdrv_bufsig_load(staged, f, &idx);
+        if (rc) {
+            JSDRV_LOGW("load signal %u failed: %d", (unsigned int) i, (int) rc);
+        } else if ((idx == 0) || (idx >= JSDRV_BUFSIG_COUNT_MAX) || !self->signals[idx].active) {
+            JSDRV_LOGW("load signal %u skipped: not added", (unsigned int) idx);
+        } else {
+            struct bufsig_s * b = &self->signals[idx];
+            jsdrv_os_mutex_lock(self->read_mutex);
+            jsdrv_os_mutex_t mutex = bufsig_mutex(self, idx);
+            jsdrv_os_mutex_lock(mutex);
+            jsdrv_bufsig_replace(b, staged);
+            bufsig_publish_info(b);
+            jsdrv_os_mutex_unlock(mutex);
+            jsdrv_os_mutex_unlock(self->read_mutex);
+            ++loaded;
+        }
+        jsdrv_bufsig_free(staged);  // the previous or discarded storage
+        jsdrv_free(staged);
+    }
+    fclose(f);
+    if (loaded) {
+        self->state = ST_ACTIVE;
+    }
+    JSDRV_LOGI("load %u signals from %s: %d", (unsigned int) loaded, path, (int) rc);
+    return rc;
+}
+
+static struct req_s * req_alloc(struct buffer_s * self) {
+    struct req_s * r;
+    struct jsdrv_list_s * item = jsdrv_list_remove_head(&self->req_free);
+    if (NULL != item) {
+        r = JSDRV_CONTAINER_OF(item, struct req_s, item);
+    } else {
+        JSDRV_LOGD1("create request");
+        r = jsdrv_alloc_clr_cat(sizeof(struct req_s), JSDRV_ALLOC_CAT_BUFFER);
+        jsdrv_list_initialize(&r->item);
+    }
+    return r;
+}
+
+static void req_post(struct buffer_s * self, uint32_t bufsig_idx, struct jsdrv_buffer_request_s * req) {
+    struct jsdrv_list_s * item;
+    struct req_s * r;
+
+    // Search for existing request
+    jsdrv_list_foreach(&self->req_pending, item) {
+        r = JSDRV_CONTAINER_OF(item, struct req_s, item);
+        if ((NULL != r->export) || (0 != strcmp(r->req.rsp_topic, req->rsp_topic))) {
+            continue;
+        } else if ((r->signal_id == bufsig_idx) && (r->req.rsp_id == req->rsp_id)) {
+            JSDRV_LOGD1("dedup rsp_id %lld", req->rsp_id);
+        } else if (self->req_latest) {
+            JSDRV_LOGD1("rsp_id %lld supersedes %lld", req->rsp_id, r->req.rsp_id);
+        } else {
+            continue;
+        }
+        // found existing request still pending; update request.
+        r->signal_id = bufsig_idx;
+        r->req = *req;
+        r->stream_seq = 0;
+        r->stream_count = 0;
+        return;
+    }
+
+    // No existing request found; create new request.
+    r = req_alloc(self);
+    r->signal_id = bufsig_idx;
+    r->req = *req;
+    r->stream_seq = 0;
+    r->stream_count = 0;
+    r->export = NULL;
+    jsdrv_list_add_tail(&self->req_pending, &r->item);
+}
+
+static int32_t req_process(struct buffer_s * self, struct bufsig_s * b,
+                           struct jsdrv_buffer_request_s * req, struct jsdrv_buffer_response_s * rsp,
+                           uint64_t data_size) {
+    struct bufsig_s snapshot;
+    int32_t rc;
+    bool overwritten;
+    jsdrv_os_mutex_t mutex = bufsig_mutex(self, b->idx);
+
+    if (b != &self->signals[b->idx]) {
+        // frozen signals only change under read_mutex, held by the caller
+        return jsdrv_bufsig_process_request_sz(b, req, rsp, data_size);
+    }
+
+    // Read from a snapshot without blocking ingestion.
+    // Compressed blocks are freed on eviction and share a decode cache, so always lock.
+    for (uint32_t retry = 0; (retry < BUFFER_READ_RETRIES) && (NULL == b->blocks); ++retry) {
+        jsdrv_os_mutex_lock(mutex);
+        jsdrv_bufsig_summary_update(b, JSDRV_BUFSIG_LEVELS_MAX);  // the snapshot shares the storage
+        snapshot = *b;
+        jsdrv_os_mutex_unlock(mutex);
+        rc = jsdrv_bufsig_process_request_sz(&snapshot, req, rsp, data_size);
+        jsdrv_os_mutex_lock(mutex);
+        overwritten = jsdrv_bufsig_snapshot_overwritten(&snapshot, b, rsp);
+        if (snapshot.generation == b->generation) {
+            b->tile_clock = snapshot.tile_clock;  // the snapshot shares the tiles
+        }
+        jsdrv_os_mutex_unlock(mutex);
+        if (!overwritten) {
+            return rc;
+        }
+        JSDRV_LOGD1("request %s overwritten, retry", b->topic);
+    }
+
+    // Ingestion keeps overwriting the requested range or compressed, so read under the lock.
+    jsdrv_os_mutex_lock(mutex);
+    rc = jsdrv_bufsig_process_request_sz(b, req, rsp, data_size);
+    jsdrv_os_mutex_unlock(mutex);
+    return rc;
+}
+
+// Track the summary window for each rsp_topic, and restart its speculative windows.
+static void prefetch_track(struct buffer_s * self, uint32_t signal_id, const struct jsdrv_buffer_request_s * req,
+                           const struct jsdrv_buffer_response_s * rsp) {
+    const struct jsdrv_time_range_samples_s * r = &rsp->info.time_range_samples;
+    if (!self->prefetch || (0 == self->signals[signal_id].tile_count) || (0 == req->rsp_topic[0])
+            || (JSDRV_BUFFER_RESPONSE_SUMMARY != rsp->response_type) || (0 == r->length)) {
+        return;
+    }
+    struct prefetch_s * c = NULL;
+    struct prefetch_s * victim = &self->prefetch_clients[0];
+    for (uint32_t i = 0; (i < BUFFER_PREFETCH_CLIENTS) && (NULL == c); ++i) {
+        struct prefetch_s * p = &self->prefetch_clients[i];
+        if (0 == strcmp(p->rsp_topic, req->rsp_topic)) {
+            c = p;
+        } else if (p->used < victim->used) {
+            victim = p;
+        }
+    }
+    uint64_t incr = (r->end - r->start) / r->length;
+    if (NULL == c) {
+        c = victim;
+        memset(c, 0, sizeof(*c));
+        jsdrv_cstr_copy(c->rsp_topic, req->rsp_topic, sizeof(c->rsp_topic));
+    } else if (c->signal_id != signal_id) {
+        c->velocity = 0;
+        c->zoom = 0;
+    } else if (c->incr == incr) {
+        c->velocity = (int64_t) (r->start - c->start);
+    } else {
+        c->velocity = 0;
+        c->zoom = (incr > c->incr) ? 1 : -1;
+    }
+    c->signal_id = signal_id;
+    c->envelope = 0 != (req->flags & JSDRV_BUFFER_REQUEST_FLAG_ENVELOPE);
+    c->start = r->start;
+    c->incr = incr;
+    c->length = r->length;
+    c->window = 0;
+    c->budget = self->signals[signal_id].tile_count / 2;  // keep room for the displayed tiles
+    c->used = ++self->prefetch_clock;
+}
+
+// Get speculative window k, nearest first: pan ahead, pan behind, then zoom 2x
+// in the last zoom direction (default in) and the other direction.
+static bool prefetch_window(const struct prefetch_s * c, uint8_t k, uint64_t * start, uint64_t * incr) {
+    uint64_t span = c->incr * c->length;
+    *incr = c->incr;
+    if (k < 2) {
+        if ((0 == k) == (c->velocity < 0)) {
+            if (c->start < span) {
+                return false;
+            }
+            *start = c->start - span;
+        } else {
+            *start = c->start + span;
+        }
+        return true;
+    } else if (k < BUFFER_PREFETCH_WINDOWS) {
+        if ((2 == k) == (c->zoom > 0)) {  // out, centered
+            *incr = c->incr * 2;
+            *start = (c->start < (span / 2)) ? 0 : (c->start - span / 2);
+        } else if (c->incr < 2) {
+            return false;
+        } else {  // in, centered
+            *incr = c->incr / 2;
+            *start = c->start + span / 4;
+        }
+        return true;
+    }
+    return false;
+}
+
+// Compute one uncached tile for a window without blocking ingestion, like req_process().
+static bool prefetch_tile(struct buffer_s * self, const struct prefetch_s * c, uint64_t start, uint64_t incr) {
+    struct bufsig_s * b = &self->signals[c->signal_id];
+    struct bufsig_s snapshot;
+    bool rv = false;
+    jsdrv_os_mutex_t mutex = bufsig_mutex(self, c->signal_id);
+    jsdrv_os_mutex_lock(self->read_mutex);
+    if (b->active && (NULL != b->level0_data) && (NULL != b->tiles)) {
+        jsdrv_os_mutex_lock(mutex);
+        if (NULL != b->blocks) {
+            rv = jsdrv_bufsig_tile_prefetch(b, start, incr, c->length, c->envelope);
+        } else {
+            jsdrv_bufsig_summary_update(b, JSDRV_BUFSIG_LEVELS_MAX);  // the snapshot shares the storage
+            snapshot = *b;
+            jsdrv_os_mutex_unlock(mutex);
+            // Tiles with overwritten samples start before the tail, so they expire unused.
+            rv = jsdrv_bufsig_tile_prefetch(&snapshot, start, incr, c->length, c->envelope);
+            jsdrv_os_mutex_lock(mutex);
+            if (snapshot.generation == b->generation) {
+                b->tile_clock = snapshot.tile_clock;
+            }
+        }
+        jsdrv_os_mutex_unlock(mutex);
+    }
+    jsdrv_os_mutex_unlock(self->read_mutex);
+    return rv;
+}
+
+// Compute one speculative tile for the most recent client with remaining work.
+static bool prefetch_step(struct buffer_s * self) {
+    uint64_t start;
+    uint64_t incr;
+    if (!self->prefetch) {
+        return false;
+    }
+    while (1) {
+        struct prefetch_s * c = NULL;
+        for (uint32_t i = 0; i < BUFFER_PREFETCH_CLIENTS; ++i) {
+            struct prefetch_s * p = &self->prefetch_clients[i];
+            if (p->rsp_topic[0] && p->budget && (p->window < BUFFER_PREFETCH_WINDOWS)
+                    && ((NULL == c) || (p->used > c->used))) {
+                c = p;
+            }
+        }
+        if (NULL == c) {
+            return false;
+        }
+        if (prefetch_window(c, c->window, &start, &incr) && prefetch_tile(self, c, start, incr)) {
+            --c->budget;
+            return true;
+        }
+        ++c->window;  // cached, empty or out of range
+    }
+}
+
+// Process all signals under the ingestion locks, so that every response sees the same sample_id_head.
+static void req_multi_process(struct buffer_s * self, const struct jsdrvp_msg_s * req_msg) {
+    struct jsdrv_buffer_multi_request_s m;
+    struct bufsig_s * signals[JSDRV_BUFFER_MULTI_SIGNALS_MAX];
+    if ((req_msg->value.type != JSDRV_UNION_BIN) || (req_msg->value.size < sizeof(m))) {
+        JSDRV_LOGW("multi request: invalid size %u", (unsigned int) req_msg->value.size);
+        return;
+    }
+    memcpy(&m, req_msg->value.value.bin, sizeof(m));
+    if ((1 != m.version) || (0 == m.signal_count) || (m.signal_count > JSDRV_BUFFER_MULTI_SIGNALS_MAX)) {
+        JSDRV_LOGW("multi request: invalid version %u or signal_count %u",
+                   (unsigned int) m.version, (unsigned int) m.signal_count);
+        return;
+    }
+    bool snapshot = 0 != (m.req.flags & JSDRV_BUFFER_REQUEST_FLAG_SNAPSHOT);
+    m.req.flags &= ~JSDRV_BUFFER_REQUEST_FLAG_STREAM;
+
+    struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc_data(self->context, m.req.rsp_topic);
+    struct jsdrv_buffer_multi_response_s * rsp = (struct jsdrv_buffer_multi_response_s *) msg->value.value.bin;
+    memset(rsp, 0, sizeof(*rsp));
+    rsp->version = 1;
+    rsp->signal_count = m.signal_count;
+    rsp->rsp_id = m.req.rsp_id;
+    uint32_t share = (uint32_t) ((sizeof(struct jsdrv_stream_signal_s) - sizeof(*rsp)) / m.signal_count) & ~7U;
+    uint32_t data_size = share - (uint32_t) (sizeof(struct jsdrv_buffer_response_s) + JSDRV_BUFSIG_RSP_SLACK);
+
+    if (snapshot) {
+        jsdrv_os_mutex_lock(self->read_mutex);  // frozen signals only change under read_mutex
+    } else {
+        bufsig_lock_all(self);
+    }
+    for (uint32_t i = 0; i < m.signal_count; ++i) {
+        uint8_t idx = m.signal_ids[i];
+        struct bufsig_s * b = NULL;
+        if ((idx > 0) && (idx < JSDRV_BUFSIG_COUNT_MAX)) {
+            b = snapshot ? ((NULL == self->snap) ? NULL : &self->snap[idx]) : &self->signals[idx];
+        }
+        signals[i] = ((NULL != b) && b->active) ? b : NULL;
+    }
+    jsdrv_bufsig_multi_clip(signals, m.signal_count, &m.req);
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < m.signal_count; ++i) {
+        struct jsdrv_buffer_request_s req = m.req;  // processing modifies the request
+        struct jsdrv_buffer_response_s * r = (struct jsdrv_buffer_response_s *) (((uint8_t *) rsp->data) + offset);
+        rsp->signal_ids[i] = m.signal_ids[i];
+        rsp->offset[i] = offset;
+        if (NULL == signals[i]) {
+            memset(r, 0, sizeof(*r));
+            r->version = 1;
+            r->rsp_id = m.req.rsp_id;
+            rsp->status[i] = JSDRV_ERROR_NOT_FOUND;
+        } else {
+            rsp->status[i] = jsdrv_bufsig_process_request_sz(signals[i], &req, r, data_size);
+        }
+        uint32_t sz = rsp->status[i] ? (uint32_t) sizeof(*r) : jsdrv_bufsig_response_size(r);
+        offset += (sz + 7) & ~7U;
+    }
+    if (snapshot) {
+        jsdrv_os_mutex_unlock(self->read_mutex);
+    } else {
+        bufsig_unlock_all(self);
+    }
+
+    msg->value.size = (uint32_t) sizeof(*rsp) + offset;
+    msg->value.app = JSDRV_PAYLOAD_TYPE_BUFFER_MULTI_RSP;
+    jsdrvp_backend_send(self->context, msg);
+}
+
+// The frame rate in Hz, 0 or within [MIN, MAX] as validated by standing_post().
+static uint32_t display_rate(const struct jsdrv_buffer_request_s * req) {
+    return (uint32_t) ceilf(req->threshold);
+}
+
+// Wake the standing requests at the fastest display frame rate.
+static void display_rate_update(struct buffer_s * self) {
+    uint32_t rate = 0;
+    struct jsdrv_list_s * item;
+    jsdrv_list_foreach(&self->req_standing, item) {
+        struct req_s * r = JSDRV_CONTAINER_OF(item, struct req_s, item);
+        if ((r->req.flags & JSDRV_BUFFER_REQUEST_FLAG_DISPLAY) && (display_rate(&r->req) > rate)) {
+            rate = display_rate(&r->req);
+        }
+    }
+    self->display_rate = rate;
+}
+
+static void standing_remove(struct buffer_s * self, struct req_s * r) {
+    jsdrv_list_remove(&r->item);
+    jsdrv_list_add_tail(&self->req_free, &r->item);
+    jsdrv_atomic_store(&self->standing_count, jsdrv_atomic_load(&self->standing_count) - 1);
+    display_rate_update(self);
+}
+
+static void export_publish(struct buffer_s * self, uint32_t signal_idx, float progress) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, "", &jsdrv_union_f32(progress));
+    tfp_snprintf(m->topic, sizeof(m->topic), "m/%03d/s/%03d/export", self->idx, (int) signal_idx);
+    jsdrvp_backend_send(self->context, m);
+}
+
+// Publish the progress of the next chunk, at most every percent.
+static void export_progress(struct buffer_s * self, struct req_s * req) {
+    uint32_t percent = (uint32_t) (((req->stream_seq + 1) * 100) / req->stream_count);
+    if (percent > req->export->percent) {
+        req->export->percent = percent;
+        export_publish(self, req->signal_id, (float) percent / 100.0f);
+    }
+}
+
+// Close the export file and publish the final progress.
+static void export_end(struct buffer_s * self, struct req_s * req, bool ok) {
+    struct export_s * e = req->export;
+    req->export = NULL;
+    if (jsdrv_record_close(e->record)) {
+        ok = false;
+    }
+    JSDRV_LOGI("export %u %s", req->signal_id, ok ? "done" : "failed");
+    export_publish(self, req->signal_id, ok ? 1.0f : NAN);
+    jsdrv_free(e);
+}
+
+// Return a request to the free list, which fails any export in progress.
+static void req_release(struct buffer_s * self, struct req_s * req) {
+    if (NULL != req->export) {
+        export_end(self, req, false);
+    }
+    jsdrv_list_add_tail(&self->req_free, &req->item);
+}
+
+// Write a stream chunk response to the export file.
+static int32_t export_write(struct bufsig_s * b, struct export_s * e, const struct jsdrv_buffer_response_s * rsp) {
+    const struct jsdrv_buffer_info_s * info = &rsp->info;
+    uint64_t length = info->time_range_samples.length;
+    if ((JSDRV_BUFFER_RESPONSE_SAMPLES != rsp->response_type) || (0 == length)) {
+        return 0;
+    }
+    struct jsdrv_stream_signal_s * s = &e->signal;
+    uint32_t decimate_factor = b->hdr.decimate_factor ? b->hdr.decimate_factor : 1;
+    s->sample_id = info->time_range_samples.start * decimate_factor;
+    s->field_id = info->field_id;
+    s->index = info->index;
+    s->element_type = info->element_type;
+    s->element_size_bits = info->element_size_bits;
+    s->element_count = (uint32_t) length;
+    s->sample_rate = b->hdr.sample_rate;
+    s->decimate_factor = decimate_factor;
+    s->time_map = info->time_map;
+    s->time_map.offset_counter *= decimate_factor;  // before decimation, like the source stream
+    s->time_map.counter_rate *= decimate_factor;
+    uint32_t data_size = (uint32_t) ((length * info->element_size_bits + 7) / 8);
+    memcpy(s->data, rsp->data, data_size);
+    return jsdrv_record_append(e->record, 0, s, JSDRV_STREAM_HEADER_SIZE + data_size);
+}
+
+static void export_post(struct buffer_s * self, uint32_t bufsig_idx, const struct export_post_s * post) {
+    struct req_s * r = req_alloc(self);
+    r->signal_id = bufsig_idx;
+    r->req = post->req;
+    r->stream_seq = 0;
+    r->stream_count = 0;
+    r->export = post->export;
+    export_publish(self, bufsig_idx, 0.0f);
+    jsdrv_list_add_tail(&self->req_pending, &r->item);
+}
+
+static void req_cancel(struct buffer_s * self, uint32_t bufsig_idx, int64_t rsp_id) {
+    struct jsdrv_list_s * item;
+    jsdrv_list_foreach(&self->req_pending, item) {
+        struct req_s * r = JSDRV_CONTAINER_OF(item, struct req_s, item);
+        if ((r->signal_id == bufsig_idx) && (r->req.rsp_id == rsp_id)) {
+            JSDRV_LOGD1("cancel rsp_id %lld", rsp_id);
+            jsdrv_list_remove(item);
+            req_release(self, r);
+        }
+    }
+    jsdrv_list_foreach(&self->req_standing, item) {
+        struct req_s * r = JSDRV_CONTAINER_OF(item, struct req_s, item);
+        if ((r->signal_id == bufsig_idx) && (r->req.rsp_id == rsp_id)) {
+            JSDRV_LOGD1("cancel standing rsp_id %lld", rsp_id);
+            standing_remove(self, r);
+        }
+    }
+}
+
+static bool req_handle_one(struct buffer_s * self) {
+    struct jsdrv_list_s * item = jsdrv_list_remove_head(&self->req_pending);
+    if (NULL == item) {
+        return false;
+    }
+    struct req_s * req = JSDRV_CONTAINER_OF(item, struct req_s, item);
+    struct bufsig_s * b = &self->signals[req->signal_id];
+    if (!b->active) {
+        req_release(self, req);
+        return false;
+    }
+    struct jsdrv_buffer_request_s * r = &req->req;
+    struct jsdrv_buffer_request_s chunk;
+    bool final = true;
+    jsdrv_os_mutex_lock(self->read_mutex);
+
+    if (r->flags & JSDRV_BUFFER_REQUEST_FLAG_SNAPSHOT) {
+        b = (NULL == self->snap) ? NULL : &self->snap[req->signal_id];
+        if ((NULL == b) || !b->active) {
+            JSDRV_LOGW("snapshot request rsp_id %lld but no snapshot", r->rsp_id);
+            jsdrv_os_mutex_unlock(self->read_mutex);
+            req_release(self, req);
+            return true;
+        }
+    }
+
+    if (r->flags & JSDRV_BUFFER_REQUEST_FLAG_STREAM) {
+        // Process one chunk at a time, so other requests interleave.
+        jsdrv_os_mutex_t mutex = bufsig_mutex(self, b->idx);
+        jsdrv_os_mutex_lock(mutex);
+        if (0 == req->stream_count) {
+            req->stream_count = jsdrv_bufsig_stream_plan(b, r);
+        }
+        if (req->stream_count) {
+            jsdrv_bufsig_stream_chunk(b, r, req->stream_seq, &chunk);
+        }
+        jsdrv_os_mutex_unlock(mutex);
+        if (0 == req->stream_count) {
+            JSDRV_LOGW("invalid stream request rsp_id %lld", r->rsp_id);
+            jsdrv_os_mutex_unlock(self->read_mutex);
+            req_release(self, req);
+            return true;
+        }
+        final = (req->stream_seq + 1) >= req->stream_count;
+        r = &chunk;
+    }
+
+    struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc_data(self->context, r->rsp_topic);
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) msg->value.value.bin;
+    int32_t rc = req_process(self, b, r, rsp, RSP_DATA_SIZE);
+    jsdrv_os_mutex_unlock(self->read_mutex);
+    if (NULL != req->export) {
+        if (0 == rc) {
+            rc = export_write(b, req->export, rsp);
+        }
+        jsdrvp_msg_free(self->context, msg);
+        if (JSDRV_ERROR_FULL == rc) {
+            jsdrv_thread_sleep_ms(1);  // the writer is behind, retry this chunk
+            jsdrv_list_add_tail(&self->req_pending, item);
+            return true;
+        } else if (rc) {
+            JSDRV_LOGW("export %u failed: %d", req->signal_id, (int) rc);
+            final = true;
+        } else if (final) {
+            export_end(self, req, true);
+        } else {
+            export_progress(self, req);
+        }
+    } else if (rc) {
+        jsdrvp_msg_free(self->context, msg);
+        final = true;  // abort the stream
+    } else {
+        rsp->seq = (uint32_t) req->stream_seq;
+        if (final) {
+            rsp->flags |= JSDRV_BUFFER_RESPONSE_FLAG_FINAL;
+        }
+        if (0 == (req->req.flags & (JSDRV_BUFFER_REQUEST_FLAG_SNAPSHOT | JSDRV_BUFFER_REQUEST_FLAG_STREAM))) {
+            prefetch_track(self, req->signal_id, r, rsp);
+        }
+        msg->value.app = JSDRV_PAYLOAD_TYPE_BUFFER_RSP;
+        jsdrvp_backend_send(self->context, msg);
+    }
+    if (final) {
+        req_release(self, req);
+    } else {
+        ++req->stream_seq;
+        jsdrv_list_add_tail(&self->req_pending, item);
+    }
+    return true;
+}
+
+// Send the newly completed entries for a standing request, or the next display frame.
+static void standing_send(struct buffer_s * self, struct req_s * req) {
+    struct bufsig_s * b = &self->signals[req->signal_id];
+    struct jsdrv_buffer_request_s chunk;
+    jsdrv_os_mutex_t mutex = bufsig_mutex(self, req->signal_id);
+    bool display = 0 != (req->req.flags & JSDRV_BUFFER_REQUEST_FLAG_DISPLAY);
+    int64_t t = jsdrv_time_utc();
+    if (display && req->req.threshold > 0) {
+        int64_t period = (int64_t) (JSDRV_TIME_SECOND / req->req.threshold);  // at most one second
+        if ((t - req->frame_time) < (period - period / 4)) {  // tolerate wake jitter
+            return;
+        }
+    }
+    jsdrv_os_mutex_lock(self->read_mutex);
+    while (1) {
+        jsdrv_os_mutex_lock(mutex);
+        bool ready = display
+            ? jsdrv_bufsig_display_chunk(b, &req->req, &req->standing_next, &chunk)
+            : jsdrv_bufsig_standing_chunk(b, &req->req, &req->standing_next, &chunk);
+        jsdrv_os_mutex_unlock(mutex);
+        if (!ready) {
+            break;
+        }
+        struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc_data(self->context, chunk.rsp_topic);
+        struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) msg->value.value.bin;
+        if (req_process(self, b, &chunk, rsp, RSP_DATA_SIZE)) {
+            jsdrvp_msg_free(self->context, msg);
+            break;
+        }
+        rsp->seq = (uint32_t) req->stream_seq++;
+        msg->value.app = JSDRV_PAYLOAD_TYPE_BUFFER_RSP;
+        jsdrvp_backend_send(self->context, msg);
+        if (display) {
+            req->frame_time = t;
+            break;  // one frame per update
+        }
+    }
+    jsdrv_os_mutex_unlock(self->read_mutex);
+}
+
+static void standing_post(struct buffer_s * self, uint32_t bufsig_idx, const struct jsdrv_buffer_request_s * req) {
+    struct jsdrv_buffer_request_s plan = *req;
+    struct jsdrv_list_s * item;
+    struct req_s * r = NULL;
+    jsdrv_os_mutex_t mutex = bufsig_mutex(self, bufsig_idx);
+    jsdrv_os_mutex_lock(mutex);
+    uint64_t incr = jsdrv_bufsig_standing_plan(&self->signals[bufsig_idx], &plan);
+    jsdrv_os_mutex_unlock(mutex);
+    if (plan.flags & JSDRV_BUFFER_REQUEST_FLAG_DISPLAY) {
+        if ((0.0f != plan.threshold) && !(plan.threshold >= JSDRV_BUFFER_DISPLAY_RATE_MIN)) {
+            incr = 0;  // negative, NaN or too small to convert to a frame period
+        } else if (plan.threshold > JSDRV_BUFFER_DISPLAY_RATE_MAX) {
+            plan.threshold = JSDRV_BUFFER_DISPLAY_RATE_MAX;  // including infinity
+        }
+    }
+    if (0 == incr) {
+        JSDRV_LOGW("invalid standing request rsp_id %lld", req->rsp_id);
+        return;
+    }
+
+    jsdrv_list_foreach(&self->req_standing, item) {
+        struct req_s * s = JSDRV_CONTAINER_OF(item, struct req_s, item);
+        if ((s->signal_id == bufsig_idx) && (s->req.rsp_id == req->rsp_id)
+                && (0 == strcmp(s->req.rsp_topic, req->rsp_topic))) {
+            JSDRV_LOGD1("update standing rsp_id %lld", req->rsp_id);
+            r = s;
+        }
+    }
+    if (NULL == r) {
+        r = req_alloc(self);
+        jsdrv_list_add_tail(&self->req_standing, &r->item);
+        jsdrv_atomic_store(&self->standing_count, jsdrv_atomic_load(&self->standing_count) + 1);
+    }
+    r->signal_id = bufsig_idx;
+    r->req = plan;
+    r->stream_seq = 0;
+    r->stream_count = 0;
+    r->standing_next = UINT64_MAX;
+    r->frame_time = 0;
+    display_rate_update(self);
+    standing_send(self, r);  // the initial viewport
+}
+
+static void standing_process(struct buffer_s * self) {
+    struct jsdrv_list_s * item;
+    jsdrv_list_foreach(&self->req_standing, item) {
+        struct req_s * r = JSDRV_CONTAINER_OF(item, struct req_s, item);
+        if (!self->signals[r->signal_id].active) {
+            JSDRV_LOGD1("signal removed, end standing rsp_id %lld", r->req.rsp_id);
+            standing_remove(self, r);
+        } else {
+            standing_send(self, r);
+        }
+    }
+}
+
+static void req_list_free(struct buffer_s * self, struct jsdrv_list_s * list) {
+    while (1) {
+        struct jsdrv_list_s * item = jsdrv_list_remove_head(list);
+        if (NULL == item) {
+            break;
+        }
+        struct req_s * req = JSDRV_CONTAINER_OF(item, struct req_s, item);
+        if (NULL != req->export) {
+            export_end(self, req, false);
+        }
+        jsdrv_free(req);
+    }
+}
+
+static int32_t send_return_code_to_frontend(struct jsdrv_context_s * context, const char * topic, int32_t rc,
+        jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
+    struct jsdrvp_msg_s * m;
+    m = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_i32(rc));
+    tfp_snprintf(m->topic, sizeof(m->topic), "%s%c", topic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
+    m->extra.frontend.subscriber.internal_fn = cbk_fn;
+    m->extra.frontend.subscriber.user_data = cbk_user_data;
+    m->extra.frontend.subscriber.is_internal = 1;
+    jsdrvp_backend_send(context, m);
+    return rc;
+}
+
+static int32_t buffer_recv_complete(struct buffer_s * self, const char * subtopic, int32_t rc) {
+    if (rc >= 0) {
+        struct jsdrvp_msg_s *m;
+        m = jsdrvp_msg_alloc_value(self->context, "", &jsdrv_union_i32(rc));
+        tfp_snprintf(m->topic, sizeof(m->topic), "m/%03d/%s%c", self->idx,
+                     subtopic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
+        m->extra.frontend.subscriber.internal_fn = _buffer_recv;
+        m->extra.frontend.subscriber.user_data = NULL;
+        m->extra.frontend.subscriber.is_internal = 1;
+        jsdrvp_backend_send(self->context, m);
+    }
+    return rc;
+}
+
+/*
+ * Signal allocation on the reader thread: allocate without any lock,
+ * then install under the signal lock, so that ingestion only waits to
+ * swap the storage.  Shrinking also copies the newest samples from a
+ * snapshot under read_mutex, which excludes reconfiguration, and only
+ * catches up with the samples ingested during the copy under the
+ * signal lock.  A buffer_free() in between, detected by cfg_gen,
+ * discards the allocation.
+ */
+
+// Shrink an allocated signal to duration seconds, and keep its newest samples.
+static void signal_shrink(struct buffer_s * self, uint32_t idx, const struct alloc_req_s * r, double duration) {
+    struct bufsig_s * b = &self->signals[idx];
+    struct bufsig_s snapshot;
+    uint64_t level0_budget;
+    jsdrv_os_mutex_t mutex;
+
+    jsdrv_os_mutex_lock(self->read_mutex);
+    bool valid = (r->cfg_gen == self->cfg_gen);
+    mutex = bufsig_mutex(self, idx);
+    jsdrv_os_mutex_lock(mutex);
+    snapshot = *b;
+    jsdrv_os_mutex_unlock(mutex);
+    jsdrv_os_mutex_unlock(self->read_mutex);
+    if (!valid || !snapshot.active || (NULL == snapshot.level0_data)
+            || (bufsig_plan(&r->cfg, &snapshot.hdr, duration, &level0_budget) >= snapshot.N)) {
+        return;
+    }
+
+    struct bufsig_s * staged = jsdrv_alloc_clr_cat(sizeof(struct bufsig_s), JSDRV_ALLOC_CAT_BUFFER);
+    staged->idx = idx;
+    staged->parent = self;
+    staged->hdr = snapshot.hdr;
+    jsdrv_cstr_copy(staged->topic, snapshot.topic, sizeof(staged->topic));
+    bufsig_cfg_alloc(&r->cfg, staged, duration);
+
+    jsdrv_os_mutex_lock(self->read_mutex);
+    mutex = bufsig_mutex(self, idx);
+    if ((r->cfg_gen == self->cfg_gen) && b->active && (NULL != b->level0_data)) {  // stable under read_mutex
+        jsdrv_os_mutex_lock(mutex);
+        jsdrv_bufsig_summary_update(b, JSDRV_BUFSIG_LEVELS_MAX);  // the snapshot shares the storage
+        snapshot = *b;
+        jsdrv_os_mutex_unlock(mutex);
+        if (NULL == snapshot.blocks) {  // compressed blocks share the decode cache, so copy under the lock
+            jsdrv_bufsig_copy(staged, &snapshot, snapshot.sample_id_head);
+        }
+        jsdrv_os_mutex_lock(mutex);
+        bool overwritten = (b->generation != snapshot.generation)
+                || ((b->sample_id_head - b->level0_size) > (staged->sample_id_head - staged->level0_size));
+        if (overwritten || !jsdrv_bufsig_copy(staged, b, b->sample_id_head)) {
+            JSDRV_LOGD1("signal %u shrink overwritten, copy under lock", (unsigned int) idx);
+            jsdrv_bufsig_clear(staged);
+            jsdrv_bufsig_copy(staged, b, b->sample_id_head);
+        }
+        JSDRV_LOGI("signal %u shrink %" PRIu64 " -> %" PRIu64, (unsigned int) idx, b->N, staged->N);
+        jsdrv_bufsig_replace(b, staged);
+        bufsig_publish_info(b);
+        jsdrv_os_mutex_unlock(mutex);
+    }
+    jsdrv_os_mutex_unlock(self->read_mutex);
+    jsdrv_bufsig_free(staged);  // the previous or discarded storage
+    jsdrv_free(staged);
+}
+
+// Allocate an added signal, and optionally shrink the others to fit within the size.
+static void signal_alloc(struct buffer_s * self, uint32_t idx, const struct jsdrvp_msg_s * msg) {
+    struct alloc_req_s r;
+    struct bufsig_s * b = &self->signals[idx];
+    memcpy(&r, msg->value.value.bin, sizeof(r));
+
+    jsdrv_os_mutex_lock(self->read_mutex);
+    double duration = self->duration;
+    double sz_per_s = bufsig_rate(&r.cfg, &r.hdr);
+    for (uint32_t i = 1; r.rebalance && (i < JSDRV_BUFSIG_COUNT_MAX); ++i) {
+        struct bufsig_s * s = &self->signals[i];
+        jsdrv_os_mutex_t mutex = bufsig_mutex(self, i);
+        jsdrv_os_mutex_lock(mutex);
+        if ((i != idx) && s->active && (NULL != s->level0_data)) {
+            sz_per_s += bufsig_rate(&r.cfg, &s->hdr);
+        }
+        jsdrv_os_mutex_unlock(mutex);
+    }
+    jsdrv_os_mutex_unlock(self->read_mutex);
+
+    if (r.rebalance && ((r.cfg.size / sz_per_s) < duration)) {
+        duration = r.cfg.size / sz_per_s;
+        JSDRV_LOGI("signal %u rebalance %d B/s -> %d seconds", (unsigned int) idx, (int) sz_per_s, (int) duration);
+        for (uint32_t i = 1; i < JSDRV_BUFSIG_COUNT_MAX; ++i) {
+            if (i != idx) {
+                signal_shrink(self, i, &r, duration);
+            }
+        }
+    }
+
+    struct bufsig_s * staged = jsdrv_alloc_clr_cat(sizeof(struct bufsig_s), JSDRV_ALLOC_CAT_BUFFER);
+    staged->idx = idx;
+    staged->parent = self;
+    staged->hdr = r.hdr;
+    bufsig_cfg_alloc(&r.cfg, staged, duration);
+
+    jsdrv_os_mutex_lock(self->read_mutex);
+    jsdrv_os_mutex_t mutex = bufsig_mutex(self, idx);
+    jsdrv_os_mutex_lock(mutex);
+    if ((r.cfg_gen == self->cfg_gen) && b->active && (NULL == b->level0_data)
+            && ((0 == b->hdr.sample_rate) || ((b->hdr.element_type == r.hdr.element_type)
+                && (b->hdr.element_size_bits == r.hdr.element_size_bits)
+                && (b->hdr.sample_rate == r.hdr.sample_rate) && (b->hdr.decimate_factor == r.hdr.decimate_factor)))) {
+        JSDRV_LOGI("signal %u allocated", (unsigned int) idx);
+        jsdrv_bufsig_replace(b, staged);
+        bufsig_publish_info(b);
+        if (r.rebalance) {
+            self->duration = duration;
+        }
+    }
+    self->alloc_pending[idx] = 0;
+    jsdrv_os_mutex_unlock(mutex);
+    jsdrv_os_mutex_unlock(self->read_mutex);
+    jsdrv_bufsig_free(staged);  // the previous or discarded storage
+    jsdrv_free(staged);
+}
+
+static bool reader_handle_q(struct buffer_s * self) {
+    struct jsdrvp_msg_s * msg = msg_queue_pop_immediate(self->req_q);
+    if (NULL == msg) {
+        return false;
+    }
+    if (0 == strcmp(JSDRV_MSG_FINALIZE, msg->topic)) {
+        self->reader_exit = 1;
+        jsdrvp_msg_free(self->context, msg);
+        return false;
+    }
+    if (REQ_MSG_CANCEL == msg->u32_b) {
+        req_cancel(self, msg->u32_a, msg->value.value.i64);
+    } else if (REQ_MSG_STANDING == msg->u32_b) {
+        standing_process(self);
+    } else if (REQ_MSG_MULTI == msg->u32_b) {
+        req_multi_process(self, msg);
+    } else if (REQ_MSG_ALLOC == msg->u32_b) {
+        signal_alloc(self, msg->u32_a, msg);
+    } else if (REQ_MSG_EXPORT == msg->u32_b) {
+        export_post(self, msg->u32_a, (const struct export_post_s *) msg->value.value.bin);
+    } else {
+        struct jsdrv_buffer_request_s * req = (struct jsdrv_buffer_request_s *) msg->value.value.bin;
+        if (req->flags & REQ_FLAGS_STANDING) {
+            standing_post(self, msg->u32_a, req);
+            jsdrv_atomic_store(&self->standing_acks, jsdrv_atomic_load(&self->standing_acks) + 1);
+        } else {
+            req_post(self, msg->u32_a, req);
+        }
+    }
+    jsdrvp_msg_free(self->context, msg);
+    return true;
+}
+
+static THREAD_RETURN_TYPE reader_thread(THREAD_ARG_TYPE lpParam) {
+    struct buffer_s * self = (struct buffer_s *) lpParam;
+    JSDRV_LOGI("buffer reader thread started: %s", self->topic);
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_BUFFER);
+
+#if _WIN32
+    HANDLE handles[1];
+    handles[0] = msg_queue_handle_get(self->req_q);
+#else
+    struct pollfd fds[1];
+    fds[0].fd = msg_queue_handle_get(self->req_q);
+    fds[0].events = POLLIN;
+#endif
+
+    bool prefetch = false;
+    while (!self->reader_exit) {
+        // With prefetch work, only check for new requests.
+#if _WIN32
+        WaitForMultipleObjects(1, handles, false, prefetch ? 0 : INFINITE);
+#else
+        poll(fds, 1, prefetch ? 0 : -1);
+#endif
+        // note: ResetEvent handled automatically by msg_queue_pop_immediate
+        do {
+            while (reader_handle_q(self)) {  // dedup against newly posted requests
+                ;
+            }
+            JSDRV_TRACE_START(t_req);
+            req_handle_one(self);
+            JSDRV_TRACE_END("buf_req", t_req, 0);
+        } while (!self->reader_exit && !jsdrv_list_is_empty(&self->req_pending));
+        prefetch = !self->reader_exit && prefetch_step(self);  // one tile, so requests pre-empt
+    }
+
+    req_list_free(self, &self->req_pending);
+    req_list_free(self, &self->req_standing);
+    jsdrv_atomic_store(&self->standing_count, 0);
+    req_list_free(self, &self->req_free);
+    JSDRV_LOGI("buffer reader thread done: %s", self->topic);
+    jsdrv_thread_unregister();
+    THREAD_RETURN();
+}
+
+static void bufsig_recv(struct bufsig_s * b, const struct jsdrv_union_s * value) {
+    struct jsdrv_stream_signal_s * signal = (struct jsdrv_stream_signal_s *) value->value.bin;
+    if (JSDRV_PAYLOAD_TYPE_STREAM_EVENT == value->app) {
+        jsdrv_bufsig_recv_events(b, signal, jsdrv_stream_event_count(value->size));
+    } else {
+        jsdrv_bufsig_recv_data(b, signal);
     }
+}
 
-    // determine size in bytes per second
-    double sz_per_s = 0.0;
-    for (uint32_t idx = 1; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
-        struct bufsig_s *b = &self->signals[idx];
-        if (!b->active) {
-            continue;
-        }
-        uint32_t sample_rate = b->hdr.sample_rate / b->hdr.decimate_factor;
-        if ((b->hdr.element_type == JSDRV_DATA_TYPE_FLOAT) && (b->hdr.element_size_bits == 32)) {
-            sz_per_s +=sample_rate * coef_f32;
+static void worker_recv_data(struct buffer_worker_s * w, struct jsdrvp_msg_s * msg) {
+    struct buffer_s * self = w->parent;
+    struct bufsig_s * b = &self->signals[msg->u32_a];
+    jsdrv_os_mutex_lock(w->mutex);
+    if ((self->state == ST_ACTIVE) && b->active) {  // else discard data queued before buffer_free or remove
+        JSDRV_PERF_TIME_START(t_start);
+        JSDRV_TRACE_START(t_trace);
+        bufsig_recv(b, &msg->value);
+        JSDRV_TRACE_END("buf_recv", t_trace, msg->u32_a);
+        JSDRV_PERF_TIME_END(JSDRV_PERF_BUF_TIME, t_start);
+        w->summary_pending = 1;
+        jsdrvp_msg_free(self->context, msg->payload.dispatch.msg);  // release shared data before publish
+        msg->payload.dispatch.msg = NULL;
+        if (0 == self->info_rate) {
+            bufsig_publish_info(b);
         } else {
-            sz_per_s += sample_rate * ((b->hdr.element_size_bits / 8.0) + coef_u);
+            self->info_pending[b->idx] = 1;
         }
     }
-    // determine sample count for each signal, allocate, and publish duration
-    double duration = self->size / sz_per_s;
-    JSDRV_LOGI("%d B/s -> %d seconds", (int) sz_per_s, (int) duration);
+    jsdrv_os_mutex_unlock(w->mutex);
+    jsdrvp_msg_free(self->context, msg->payload.dispatch.msg);  // NULL if already released
+    jsdrvp_msg_free(self->context, msg);
+}
+
+// Complete the lazy summary levels of the signals that ingest under mutex.
+static void summary_idle(struct buffer_s * self, jsdrv_os_mutex_t mutex) {
+    jsdrv_os_mutex_lock(mutex);
     for (uint32_t idx = 1; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
-        struct bufsig_s *b = &self->signals[idx];
-        if (!b->active) {
-            continue;
-        }
-        uint32_t sample_rate = b->hdr.sample_rate / b->hdr.decimate_factor;
-        double N = duration * sample_rate;
-        uint64_t r0;        // power of 2
-        uint64_t rN = 32;   // power of 2
-        if ((b->hdr.element_type == JSDRV_DATA_TYPE_FLOAT) && (b->hdr.element_size_bits == 32)) {
-            r0 = 128;
-        } else {
-            r0 = 1024;
-        }
-        int64_t level = (int64_t) (ceil(log2(N / (double) (r0 * (rN * rN - 1))) / log2((double) rN) + 1.0));
-        if (level < 1) {
-            level = 1;
+        if (bufsig_mutex(self, idx) == mutex) {
+            jsdrv_bufsig_summary_update(&self->signals[idx], JSDRV_BUFSIG_LEVELS_MAX);
         }
-        uint64_t rZ = r0;
-        for (int i = 1; i <= level; ++i) {
-            rZ *= rN;
+    }
+    jsdrv_os_mutex_unlock(mutex);
+}
+
+static bool worker_handle_q(struct buffer_worker_s * w) {
+    struct jsdrvp_msg_s * msg = msg_queue_pop_immediate(w->q);
+    if (NULL == msg) {
+        return false;
+    }
+    if (0 == strcmp(JSDRV_MSG_FINALIZE, msg->topic)) {
+        w->do_exit = 1;
+        jsdrvp_msg_free(w->parent->context, msg);
+        return false;
+    }
+    worker_recv_data(w, msg);
+    return true;
+}
+
+static THREAD_RETURN_TYPE worker_thread(THREAD_ARG_TYPE lpParam) {
+    struct buffer_worker_s * w = (struct buffer_worker_s *) lpParam;
+    JSDRV_LOGI("buffer worker thread started: %s", w->parent->topic);
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_BUFFER);
+
+#if _WIN32
+    HANDLE handles[1];
+    handles[0] = msg_queue_handle_get(w->q);
+#else
+    struct pollfd fds[1];
+    fds[0].fd = msg_queue_handle_get(w->q);
+    fds[0].events = POLLIN;
+#endif
+
+    while (!w->do_exit) {
+        int32_t timeout_ms = w->summary_pending ? BUFFER_SUMMARY_IDLE_MS : -1;
+#if _WIN32
+        WaitForMultipleObjects(1, handles, false, (timeout_ms < 0) ? INFINITE : (DWORD) timeout_ms);
+#else
+        poll(fds, 1, timeout_ms);
+#endif
+        // note: ResetEvent handled automatically by msg_queue_pop_immediate
+        bool idle = true;
+        while (worker_handle_q(w)) {
+            idle = false;
         }
-        uint64_t k = (uint64_t) (round(N / rZ));
-        if (k == 0) {
-            k = 1;
+        if (idle && w->summary_pending) {
+            w->summary_pending = 0;
+            summary_idle(w->parent, w->mutex);
         }
-        uint64_t Np = k * rZ;
-        jsdrv_bufsig_alloc(b, Np, r0, rN);
-        bufsig_publish_info(b);
     }
+    JSDRV_LOGI("buffer worker thread done: %s", w->parent->topic);
+    jsdrv_thread_unregister();
+    THREAD_RETURN();
 }
 
-static void buffer_free(struct buffer_s * self) {
-    if (self->state == ST_ACTIVE) {
-        self->state = ST_AWAIT;
+static void workers_stop(struct buffer_s * self) {
+    // Pending data precedes finalize in each queue, so ingestion completes.
+    for (uint32_t i = 0; i < self->worker_count; ++i) {
+        struct buffer_worker_s * w = &self->workers[i];
+        msg_queue_push(w->q, jsdrvp_msg_alloc_value(self->context, JSDRV_MSG_FINALIZE, &jsdrv_union_u8(0)));
     }
-    for (uint32_t idx = 0; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
-        struct bufsig_s *b = &self->signals[idx];
-        jsdrv_bufsig_clear(b);
-        bufsig_publish_info(b);
-        jsdrv_bufsig_free(b);
+    for (uint32_t i = 0; i < self->worker_count; ++i) {
+        struct buffer_worker_s * w = &self->workers[i];
+        jsdrv_thread_join(&w->thread, 1000);
+        msg_queue_finalize(w->q);
+        jsdrv_os_mutex_free(w->mutex);
+        memset(w, 0, sizeof(*w));
     }
+    self->worker_count = 0;
 }
 
-static void req_post(struct buffer_s * self, uint32_t bufsig_idx, struct jsdrv_buffer_request_s * req) {
-    struct jsdrv_list_s * item;
-    struct req_s * r;
-
-    // Search for existing request
-    jsdrv_list_foreach(&self->req_pending, item) {
-        r = JSDRV_CONTAINER_OF(item, struct req_s, item);
-        if ((r->signal_id == bufsig_idx) && (r->req.rsp_id == req->rsp_id) && (0 == strcmp(r->req.rsp_topic, req->rsp_topic))) {
-            JSDRV_LOGD1("dedup rsp_id %lld", req->rsp_id);
-            // found existing request still pending; update request.
-            r->req = *req;
-            return;
+static int32_t workers_start(struct buffer_s * self, uint32_t count) {
+    char name[32];
+    for (uint32_t i = 0; i < count; ++i) {
+        struct buffer_worker_s * w = &self->workers[i];
+        w->parent = self;
+        w->do_exit = 0;
+        tfp_snprintf(name, sizeof(name), "%s/w%u", self->topic, (unsigned int) i);
+        w->mutex = jsdrv_os_mutex_alloc(name);
+        w->q = msg_queue_init_spsc(MSG_QUEUE_SPSC_CAPACITY_DEFAULT);
+        if ((NULL == w->mutex) || jsdrv_thread_create(&w->thread, worker_thread, w, -1)) {
+            JSDRV_LOGE("%s worker %u start failed", self->topic, (unsigned int) i);
+            msg_queue_finalize(w->q);
+            jsdrv_os_mutex_free(w->mutex);
+            memset(w, 0, sizeof(*w));
+            workers_stop(self);
+            return JSDRV_ERROR_UNSPECIFIED;
         }
+        self->worker_count = i + 1;
     }
+    return 0;
+}
 
-    // No existing request found; create new request.
-    item = jsdrv_list_remove_head(&self->req_free);
-    if (NULL != item) {
-        r = JSDRV_CONTAINER_OF(item, struct req_s, item);
-    } else {
-        JSDRV_LOGD1("create request");
-        r = jsdrv_alloc_clr(sizeof(struct req_s));
-        jsdrv_list_initialize(&r->item);
+// Request storage for an active signal added after allocation, see signal_alloc().
+static void signal_alloc_post(struct buffer_s * self, struct bufsig_s * b, const struct jsdrv_union_s * value) {
+    const struct jsdrv_stream_signal_s * signal = (const struct jsdrv_stream_signal_s *) value->value.bin;
+    if (!b->active || self->alloc_pending[b->idx] || (NULL != b->level0_data) || (0 == signal->sample_rate)) {
+        return;
     }
-    r->signal_id = bufsig_idx;
-    r->req = *req;
-    jsdrv_list_add_tail(&self->req_pending, &r->item);
+    struct alloc_req_s r;
+    memset(&r, 0, sizeof(r));
+    r.cfg = self->cfg;
+    r.cfg_gen = self->cfg_gen;
+    r.rebalance = self->rebalance;
+    r.hdr.sample_id = signal->sample_id;
+    r.hdr.field_id = signal->field_id;
+    r.hdr.index = signal->index;
+    r.hdr.element_type = signal->element_type;
+    r.hdr.element_size_bits = signal->element_size_bits;
+    r.hdr.element_count = signal->element_count;
+    r.hdr.sample_rate = signal->sample_rate;
+    r.hdr.decimate_factor = signal->decimate_factor;
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, JSDRV_BUFFER_MSG_ACTION_SIGNAL_ADD,
+                                                     &jsdrv_union_bin((uint8_t *) &r, sizeof(r)));
+    m->u32_a = b->idx;
+    m->u32_b = REQ_MSG_ALLOC;
+    self->alloc_pending[b->idx] = 1;
+    msg_queue_push(self->req_q, m);
 }
 
-static bool req_handle_one(struct buffer_s * self) {
-    struct jsdrv_list_s * item = jsdrv_list_remove_head(&self->req_pending);
-    if (NULL == item) {
-        return false;
+// Free one signal, and keep the data of the others.
+static void signal_free(struct buffer_s * self, struct bufsig_s * b) {
+    bool any = false;
+    bufsig_lock_all(self);
+    b->active = false;
+    jsdrv_bufsig_clear(b);
+    bufsig_publish_info(b);
+    jsdrv_bufsig_free(b);
+    if (NULL != self->snap) {
+        jsdrv_bufsig_free(&self->snap[b->idx]);
+        self->snap[b->idx].active = false;
     }
-    struct req_s * req = JSDRV_CONTAINER_OF(item, struct req_s, item);
-    struct bufsig_s * b = &self->signals[req->signal_id];
-    if (!b->active) {
-        return false;
+    for (uint32_t idx = 1; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
+        any |= self->signals[idx].active;
     }
-    struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc_data(self->context, req->req.rsp_topic);
-    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) msg->value.value.bin;
-    if (jsdrv_bufsig_process_request(b, &req->req, rsp)) {
-        jsdrvp_msg_free(self->context, msg);
-    } else {
-        msg->value.app = JSDRV_PAYLOAD_TYPE_BUFFER_RSP;
-        jsdrvp_backend_send(self->context, msg);
-        jsdrv_list_add_tail(&self->req_free, item);
+    if (!any && (self->state == ST_ACTIVE)) {
+        self->state = ST_AWAIT;  // allocate the full size for the next signals
     }
-    return true;
+    bufsig_unlock_all(self);
 }
 
-static void req_list_free(struct jsdrv_list_s * list) {
-    while (1) {
-        struct jsdrv_list_s * item = jsdrv_list_remove_head(list);
-        if (NULL == item) {
-            break;
+// Open the export file and forward the export stream to the reader thread.
+static int32_t export_start(struct buffer_s * self, struct bufsig_s * b, const struct jsdrv_union_s * value) {
+    const struct jsdrv_buffer_export_s * x = (const struct jsdrv_buffer_export_s *) value->value.bin;
+    if ((value->type != JSDRV_UNION_BIN) || (value->size < sizeof(*x)) || (1 != x->version)
+            || (NULL == memchr(x->path, 0, sizeof(x->path))) || (0 == x->path[0])) {
+        JSDRV_LOGW("invalid export");
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct export_post_s post;
+    memset(&post, 0, sizeof(post));
+    struct jsdrv_buffer_request_s * req = &post.req;
+    req->version = 1;
+    req->time_type = x->time_type;
+    req->flags = JSDRV_BUFFER_REQUEST_FLAG_STREAM;
+    req->time = x->time;
+    req->rsp_id = -1;
+    tfp_snprintf(req->rsp_topic, sizeof(req->rsp_topic), "m/%03d/s/%03d/export", self->idx, (int) b->idx);
+
+    int32_t rc = 0;
+    jsdrv_os_mutex_t mutex = bufsig_mutex(self, b->idx);
+    jsdrv_os_mutex_lock(mutex);
+    if (!b->active || (NULL == b->level0_data) || (0 == b->level0_size)) {
+        rc = JSDRV_ERROR_UNAVAILABLE;
+    } else if (JSDRV_TIME_SAMPLES == req->time_type) {
+        struct jsdrv_time_range_samples_s * r = &req->time.samples;
+        uint64_t tail = b->sample_id_head - b->level0_size;
+        if ((0 == r->end) || (r->end >= b->sample_id_head)) {
+            r->end = b->sample_id_head - 1;
         }
-        struct req_s * req = JSDRV_CONTAINER_OF(item, struct req_s, item);
-        jsdrv_free(req);
+        if (r->start < tail) {
+            r->start = tail;
+        }
+        if (r->end < r->start) {
+            rc = JSDRV_ERROR_PARAMETER_INVALID;
+        }
+        r->length = 0;
+    } else if (JSDRV_TIME_UTC == req->time_type) {
+        if (req->time.utc.end <= req->time.utc.start) {
+            rc = JSDRV_ERROR_PARAMETER_INVALID;
+        }
+        req->time.utc.length = 0;
+    } else {
+        rc = JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    jsdrv_os_mutex_unlock(mutex);
+    if (rc) {
+        JSDRV_LOGW("export %d unavailable: %d", (int) b->idx, (int) rc);
+        return rc;
     }
-}
-
-static int32_t send_return_code_to_frontend(struct jsdrv_context_s * context, const char * topic, int32_t rc,
-        jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
-    struct jsdrvp_msg_s * m;
-    m = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_i32(rc));
-    tfp_snprintf(m->topic, sizeof(m->topic), "%s%c", topic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
-    m->extra.frontend.subscriber.internal_fn = cbk_fn;
-    m->extra.frontend.subscriber.user_data = cbk_user_data;
-    m->extra.frontend.subscriber.is_internal = 1;
-    jsdrvp_backend_send(context, m);
-    return rc;
-}
 
-static int32_t buffer_recv_complete(struct buffer_s * self, const char * subtopic, int32_t rc) {
-    if (rc >= 0) {
-        struct jsdrvp_msg_s *m;
-        m = jsdrvp_msg_alloc_value(self->context, "", &jsdrv_union_i32(rc));
-        tfp_snprintf(m->topic, sizeof(m->topic), "m/%03d/%s%c", self->idx,
-                     subtopic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
-        m->extra.frontend.subscriber.internal_fn = _buffer_recv;
-        m->extra.frontend.subscriber.user_data = NULL;
-        m->extra.frontend.subscriber.is_internal = 1;
-        jsdrvp_backend_send(self->context, m);
+    struct export_s * e = jsdrv_alloc_clr_cat(sizeof(struct export_s), JSDRV_ALLOC_CAT_BUFFER);
+    e->record = jsdrv_record_open(x->path, 0);
+    if (NULL == e->record) {
+        JSDRV_LOGW("export %d could not open %s", (int) b->idx, x->path);
+        jsdrv_free(e);
+        return JSDRV_ERROR_IO;
     }
-    return rc;
+    rc = jsdrv_record_signal(e->record, 0, b->topic);
+    if (rc) {
+        jsdrv_record_close(e->record);
+        jsdrv_free(e);
+        return rc;
+    }
+    post.export = e;
+    JSDRV_LOGI("export %d to %s", (int) b->idx, x->path);
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, JSDRV_BUFFER_MSG_SIGNAL_EXPORT,
+                                                     &jsdrv_union_bin((uint8_t *) &post, sizeof(post)));
+    m->u32_a = b->idx;
+    m->u32_b = REQ_MSG_EXPORT;
+    msg_queue_push(self->req_q, m);
+    return 0;
 }
 
 static bool handle_cmd_q(struct buffer_s * self) {
@@ -371,19 +1848,43 @@ static bool handle_cmd_q(struct buffer_s * self) {
 
     const char * s = msg->topic;
     if ((msg->u32_a > 0) && (msg->u32_a < JSDRV_BUFSIG_COUNT_MAX)) {
-        if ((self->state == ST_ACTIVE) || (self->state == ST_AWAIT)) {
+        if (self->state == ST_ACTIVE) {
+            signal_alloc_post(self, &self->signals[msg->u32_a], &msg->value);
+        }
+        if (self->worker_count && (self->state == ST_ACTIVE)) {
+            msg_queue_push(self->workers[msg->u32_a % self->worker_count].q, msg);
+            return true;
+        } else if (self->signals[msg->u32_a].active
+                && ((self->state == ST_ACTIVE) || (self->state == ST_AWAIT))) {
             struct bufsig_s *b = &self->signals[msg->u32_a];
-            struct jsdrv_stream_signal_s * signal = (struct jsdrv_stream_signal_s *) msg->value.value.bin;
-            jsdrv_bufsig_recv_data(b, signal);
+            jsdrv_os_mutex_t mutex = bufsig_mutex(self, b->idx);
+            JSDRV_PERF_TIME_START(t_start);
+            JSDRV_TRACE_START(t_trace);
+            jsdrv_os_mutex_lock(mutex);
+            bufsig_recv(b, &msg->value);
+            jsdrv_os_mutex_unlock(mutex);
+            self->summary_pending = 1;
+            JSDRV_TRACE_END("buf_recv", t_trace, msg->u32_a);
+            JSDRV_PERF_TIME_END(JSDRV_PERF_BUF_TIME, t_start);
+            jsdrvp_msg_free(self->context, msg->payload.dispatch.msg);  // release shared data before publish
+            msg->payload.dispatch.msg = NULL;
             if (self->state == ST_AWAIT) {
                 if (await_check(self)) {
+                    bufsig_lock_all(self);
+                    JSDRV_TRACE_START(t_alloc);
                     buffer_alloc(self);
+                    JSDRV_TRACE_END("buf_alloc", t_alloc, 0);
                     self->state = ST_ACTIVE;
+                    bufsig_unlock_all(self);
                 }
-            } else {
+            } else if (0 == self->info_rate) {
                 bufsig_publish_info(b);
+            } else {
+                self->info_pending[b->idx] = 1;
             }
         }
+        jsdrvp_msg_free(self->context, msg->payload.dispatch.msg);  // NULL if already released
+        msg->payload.dispatch.msg = NULL;
     } else if (msg->u32_a != 0) {
         JSDRV_LOGW("Invalid buffer index: %s", msg->u32_a);
         rc = JSDRV_ERROR_NOT_FOUND;
@@ -402,17 +1903,17 @@ static bool handle_cmd_q(struct buffer_s * self) {
                 JSDRV_LOGW("signal already active: %u", idx);
                 rc = JSDRV_ERROR_BUSY;
             } else {
-                JSDRV_LOGI("signal add %d", (int) msg->u32_a);
-                buffer_free(self);
+                // allocate on the first data, see signal_alloc_post()
+                JSDRV_LOGI("signal add %u", idx);
+                self->snap_end[idx] = 0;
                 b->active = true;
                 buf_publish_signal_list(self);
                 rc = 0;
             }
         } else if (0 == strcmp(s, "!remove")) {
-            JSDRV_LOGI("signal remove %d", (int) msg->u32_a);
+            JSDRV_LOGI("signal remove %u", idx);
             bufsig_unsub(b);
-            b->active = false;
-            buffer_free(self);
+            signal_free(self, b);
             buf_publish_signal_list(self);
             rc = 0;
         } else {
@@ -441,13 +1942,34 @@ static bool handle_cmd_q(struct buffer_s * self) {
                 if (msg->value.app != JSDRV_PAYLOAD_TYPE_BUFFER_REQ) {
                     JSDRV_LOGI("buffer request but app field is %d", (int) msg->value.app);
                 }
-                req_post(self, idx, (struct jsdrv_buffer_request_s *) msg->value.value.bin);
-                rc = 0;
+                // forward to the reader thread, which owns the request lists
+                const struct jsdrv_buffer_request_s * req = (const struct jsdrv_buffer_request_s *) msg->value.value.bin;
+                if ((msg->value.size >= sizeof(*req)) && (req->flags & REQ_FLAGS_STANDING)) {
+                    ++self->standing_posts;  // wake for updates until the reader counts the request
+                }
+                buffer_recv_complete(self, msg->topic, 0);
+                msg->u32_a = idx;
+                msg->u32_b = REQ_MSG_POST;
+                msg_queue_push(self->req_q, msg);
+                return true;
+            } else if (0 == strcmp(s, "!cancel")) {
+                if (jsdrv_union_as_type(&msg->value, JSDRV_UNION_I64)) {
+                    JSDRV_LOGW("invalid cancel rsp_id: %s", msg->topic);
+                    rc = JSDRV_ERROR_PARAMETER_INVALID;
+                } else {
+                    buffer_recv_complete(self, msg->topic, 0);
+                    msg->u32_a = idx;
+                    msg->u32_b = REQ_MSG_CANCEL;
+                    msg_queue_push(self->req_q, msg);
+                    return true;
+                }
+            } else if (0 == strcmp(s, "!export")) {
+                rc = export_start(self, b, &msg->value);
             } else if (0 == strcmp(s, "topic")) {
                 JSDRV_LOGI("buffer %d set topic %s", idx, msg->value.value.str);
                 bufsig_sub(b, msg->value.value.str);
                 rc = 0;
-            } else if (0 == strcmp(s, "info")) {
+            } else if ((0 == strcmp(s, "info")) || (0 == strcmp(s, "snap")) || (0 == strcmp(s, "export"))) {
                 // published by us, ignore
             } else {
                 JSDRV_LOGW("ignore %s", msg->topic);
@@ -462,11 +1984,11 @@ static bool handle_cmd_q(struct buffer_s * self) {
             uint64_t sz = v.value.u64;
             JSDRV_LOGI("buffer set size start: %" PRIu64, sz);
             buffer_free(self);
-            self->size = sz;
-            self->state = (0 == self->size) ? ST_IDLE : ST_AWAIT;
+            self->cfg.size = sz;
+            self->state = (0 == self->cfg.size) ? ST_IDLE : ST_AWAIT;
             JSDRV_LOGI("buffer set size done %d: %" PRIu64, self->state, sz);
             rc = 0;
-        } else if (0 == strcmp(s, "list")) {
+        } else if ((0 == strcmp(s, "list")) || (0 == strcmp(s, "snap"))) {
             // published by us, ignore
         } else if (0 == strcmp(s, "hold")) {
             bool bool_v = false;
@@ -474,6 +1996,171 @@ static bool handle_cmd_q(struct buffer_s * self) {
             self->hold = bool_v ? 1 : 0;
             JSDRV_LOGI("hold %s", self->hold ? "on" : "off");
             rc = 0;
+        } else if (0 == strcmp(s, "!req")) {
+            if (msg->value.app != JSDRV_PAYLOAD_TYPE_BUFFER_MULTI_REQ) {
+                JSDRV_LOGI("buffer multi request but app field is %d", (int) msg->value.app);
+            }
+            buffer_recv_complete(self, msg->topic, 0);
+            msg->u32_a = 0;
+            msg->u32_b = REQ_MSG_MULTI;
+            msg_queue_push(self->req_q, msg);
+            return true;
+        } else if (0 == strcmp(s, "!snap")) {
+            rc = snap_start(self);
+            if (0 == rc) {
+                snap_process(self);
+            }
+        } else if (0 == strcmp(s, "post")) {
+            struct jsdrv_union_s v = msg->value;
+            if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+                rc = JSDRV_ERROR_PARAMETER_INVALID;
+            } else {
+                self->snap_post_ms = v.value.u32;
+                JSDRV_LOGI("snapshot post-trigger %u ms", self->snap_post_ms);
+                rc = 0;
+            }
+        } else if (0 == strcmp(s, "info_hz")) {
+            struct jsdrv_union_s v = msg->value;
+            if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+                rc = JSDRV_ERROR_PARAMETER_INVALID;
+            } else {
+                self->info_rate = v.value.u32;
+                JSDRV_LOGI("info rate %u Hz", self->info_rate);
+                rc = 0;
+            }
+        } else if (0 == strcmp(s, "rebal")) {
+            bool bool_v = false;
+            jsdrv_union_to_bool(&msg->value, &bool_v);
+            self->rebalance = bool_v ? 1 : 0;
+            JSDRV_LOGI("rebalance %s", self->rebalance ? "on" : "off");
+            rc = 0;
+        } else if (0 == strcmp(s, "latest")) {
+            bool bool_v = false;
+            jsdrv_union_to_bool(&msg->value, &bool_v);
+            self->req_latest = bool_v ? 1 : 0;
+            JSDRV_LOGI("latest request only %s", self->req_latest ? "on" : "off");
+            rc = 0;
+        } else if (0 == strcmp(s, "prefch")) {
+            bool bool_v = false;
+            jsdrv_union_to_bool(&msg->value, &bool_v);
+            self->prefetch = bool_v ? 1 : 0;
+            JSDRV_LOGI("tile prefetch %s", self->prefetch ? "on" : "off");
+            rc = 0;
+        } else if (0 == strcmp(s, "workers")) {
+            struct jsdrv_union_s v = msg->value;
+            if (jsdrv_union_as_type(&v, JSDRV_UNION_U32) || (v.value.u32 > JSDRV_BUFFER_WORKERS_MAX)) {
+                rc = JSDRV_ERROR_PARAMETER_INVALID;
+            } else {
+                jsdrv_os_mutex_lock(self->read_mutex);  // reader maps signals to worker mutexes
+                workers_stop(self);
+                rc = workers_start(self, v.value.u32);
+                jsdrv_os_mutex_unlock(self->read_mutex);
+                JSDRV_LOGI("workers %u", self->worker_count);
+            }
+        } else if (0 == strcmp(s, "path")) {
+            if ((msg->value.type != JSDRV_UNION_STR) && (msg->value.type != JSDRV_UNION_JSON)) {
+                rc = JSDRV_ERROR_PARAMETER_INVALID;
+            } else if (strlen(msg->value.value.str) >= sizeof(self->cfg.storage_dir)) {
+                rc = JSDRV_ERROR_TOO_BIG;
+            } else {
+                JSDRV_LOGI("storage path \"%s\"", msg->value.value.str);
+                buffer_free(self);  // reallocate on the next data
+                jsdrv_cstr_copy(self->cfg.storage_dir, msg->value.value.str, sizeof(self->cfg.storage_dir));
+                rc = 0;
+            }
+        } else if (0 == strcmp(s, "mem")) {
+            struct jsdrv_union_s v = msg->value;
+            if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)
+                    || (v.value.u32 & ~(uint32_t) (JSDRV_OS_MEM_FLAG_HUGE | JSDRV_OS_MEM_FLAG_PREFAULT))) {
+                rc = JSDRV_ERROR_PARAMETER_INVALID;
+            } else {
+                JSDRV_LOGI("mem flags 0x%02x", v.value.u32);
+                buffer_free(self);  // reallocate on the next data
+                self->cfg.mem_flags = v.value.u32;
+                rc = 0;
+            }
+        } else if (0 == strcmp(s, "codec")) {
+            bool bool_v = false;
+            jsdrv_union_to_bool(&msg->value, &bool_v);
+            JSDRV_LOGI("codec %s", bool_v ? "on" : "off");
+            buffer_free(self);  // reallocate on the next data
+            self->cfg.codec = bool_v ? 1 : 0;
+            rc = 0;
+        } else if (0 == strcmp(s, "intgrl")) {
+            bool bool_v = false;
+            jsdrv_union_to_bool(&msg->value, &bool_v);
+            JSDRV_LOGI("integral index %s", bool_v ? "on" : "off");
+            buffer_free(self);  // reallocate on the next data
+            self->cfg.integral = bool_v ? 1 : 0;
+            rc = 0;
+        } else if (0 == strcmp(s, "hist")) {
+            bool bool_v = false;
+            jsdrv_union_to_bool(&msg->value, &bool_v);
+            JSDRV_LOGI("histogram index %s", bool_v ? "on" : "off");
+            buffer_free(self);  // reallocate on the next data
+            self->cfg.histogram = bool_v ? 1 : 0;
+            rc = 0;
+        } else if ((0 == strcmp(s, "trend")) || (0 == strcmp(s, "trendlv"))) {
+            struct jsdrv_union_s v = msg->value;
+            bool is_level = (0 != strcmp(s, "trend"));
+            if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)
+                    || (is_level && (v.value.u32 > JSDRV_BUFSIG_LEVELS_MAX))) {
+                rc = JSDRV_ERROR_PARAMETER_INVALID;
+            } else {
+                JSDRV_LOGI("%s %" PRIu32, s, v.value.u32);
+                buffer_free(self);  // reallocate on the next data
+                if (is_level) {
+                    self->cfg.trend_level = (uint8_t) v.value.u32;
+                } else {
+                    self->cfg.trend = v.value.u32;
+                }
+                rc = 0;
+            }
+        } else if ((0 == strcmp(s, "r0")) || (0 == strcmp(s, "rN"))) {
+            struct jsdrv_union_s v = msg->value;
+            bool is_r0 = ('0' == s[1]);
+            if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)
+                    || (is_r0 && !reduction_valid(v.value.u32, JSDRV_BUFFER_R0_MIN, JSDRV_BUFFER_R0_MAX))
+                    || (!is_r0 && !reduction_valid(v.value.u32, JSDRV_BUFFER_RN_MIN, JSDRV_BUFFER_RN_MAX))) {
+                rc = JSDRV_ERROR_PARAMETER_INVALID;
+            } else {
+                JSDRV_LOGI("%s %" PRIu32, s, v.value.u32);
+                buffer_free(self);  // reallocate on the next data
+                if (is_r0) {
+                    self->cfg.r0 = v.value.u32;
+                } else {
+                    self->cfg.rN = v.value.u32;
+                }
+                rc = 0;
+            }
+        } else if (0 == strcmp(s, "tiles")) {
+            struct jsdrv_union_s v = msg->value;
+            if (jsdrv_union_as_type(&v, JSDRV_UNION_U32) || (v.value.u32 > JSDRV_BUFFER_TILE_CACHE_MAX)) {
+                rc = JSDRV_ERROR_PARAMETER_INVALID;
+            } else {
+                JSDRV_LOGI("tile cache %" PRIu32, v.value.u32);
+                buffer_free(self);  // reallocate on the next data
+                self->cfg.tile_cache = v.value.u32;
+                rc = 0;
+            }
+        } else if (0 == strcmp(s, "numa")) {
+            struct jsdrv_union_s v = msg->value;
+            if (jsdrv_union_as_type(&v, JSDRV_UNION_I32) || (v.value.i32 < -1)) {
+                rc = JSDRV_ERROR_PARAMETER_INVALID;
+            } else {
+                JSDRV_LOGI("numa node %d", (int) v.value.i32);
+                buffer_free(self);  // reallocate on the next data
+                self->cfg.numa_node = v.value.i32;
+                rc = 0;
+            }
+        } else if ((0 == strcmp(s, "!save")) || (0 == strcmp(s, "!load"))) {
+            if ((msg->value.type != JSDRV_UNION_STR) && (msg->value.type != JSDRV_UNION_JSON)) {
+                rc = JSDRV_ERROR_PARAMETER_INVALID;
+            } else if ('s' == s[1]) {
+                rc = buffer_save(self, msg->value.value.str);
+            } else {
+                rc = buffer_load(self, msg->value.value.str);
+            }
         } else if (0 == strcmp(s, "!clear")) {
             JSDRV_LOGI("clear");
             buffer_free(self);
@@ -496,9 +2183,74 @@ static bool handle_cmd_q(struct buffer_s * self) {
     return rv;
 }
 
+static int32_t deadline_ms(int64_t t_last, uint32_t rate) {
+    int64_t remaining = t_last + JSDRV_TIME_SECOND / rate - jsdrv_time_utc();
+    if (remaining <= 0) {
+        return 0;
+    }
+    return (int32_t) JSDRV_TIME_TO_MILLISECONDS(remaining) + 1;  // round up
+}
+
+static int32_t info_timeout_ms(struct buffer_s * self) {
+    if (0 == self->info_rate) {
+        return -1;  // published on each update
+    }
+    if (0 == self->worker_count) {
+        bool pending = false;
+        for (uint32_t idx = 1; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
+            pending |= (0 != self->info_pending[idx]);
+        }
+        if (!pending) {
+            return -1;  // only this thread sets info_pending
+        }
+    }
+    return deadline_ms(self->info_time, self->info_rate);
+}
+
+/*
+ * Get the buffer thread wait time, or -1 to block until the next
+ * command.  Worker ingestion does not signal this thread, so the
+ * snapshot completion check, rate-limited info publish and standing
+ * request updates use deadlines while data may arrive through the workers.
+ * After ingestion on this thread, the lazy summary levels complete once
+ * no command arrives for BUFFER_SUMMARY_IDLE_MS.
+ */
+static int32_t buffer_timeout_ms(struct buffer_s * self) {
+    if (self->state != ST_ACTIVE) {
+        return -1;
+    }
+    if (SNAP_POST == self->snap_state) {
+        return BUFFER_THREAD_WAIT_TIMEOUT_MS;
+    }
+    int32_t timeout_ms = info_timeout_ms(self);
+    if (standing_is_active(self)) {
+        int32_t standing_ms = deadline_ms(self->standing_time, standing_rate(self));
+        if ((timeout_ms < 0) || (standing_ms < timeout_ms)) {
+            timeout_ms = standing_ms;
+        }
+    }
+    if (self->summary_pending && ((timeout_ms < 0) || (BUFFER_SUMMARY_IDLE_MS < timeout_ms))) {
+        timeout_ms = BUFFER_SUMMARY_IDLE_MS;
+    }
+    return timeout_ms;
+}
+
 static THREAD_RETURN_TYPE buffer_thread(THREAD_ARG_TYPE lpParam) {
     struct buffer_s * self = (struct buffer_s *) lpParam;
     JSDRV_LOGI("buffer thread started: %s", self->topic);
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_BUFFER);
+    char name[32];
+    tfp_snprintf(name, sizeof(name), "%s/sig", self->topic);
+    self->mutex = jsdrv_os_mutex_alloc(name);
+    tfp_snprintf(name, sizeof(name), "%s/read", self->topic);
+    self->read_mutex = jsdrv_os_mutex_alloc(name);
+    self->req_q = msg_queue_init_spsc(MSG_QUEUE_SPSC_CAPACITY_DEFAULT);
+    self->reader_exit = 0;
+    bool reader_ok = (0 == jsdrv_thread_create(&self->reader_thread, reader_thread, self, -1));
+    if (!reader_ok) {
+        JSDRV_LOGE("%s reader thread create failed", self->topic);
+        self->do_exit = 1;
+    }
 
 #if _WIN32
     HANDLE handles[1];
@@ -512,18 +2264,31 @@ static THREAD_RETURN_TYPE buffer_thread(THREAD_ARG_TYPE lpParam) {
 #endif
 
     while (!self->do_exit) {
+        int32_t timeout_ms = buffer_timeout_ms(self);
 #if _WIN32
-        WaitForMultipleObjects(handle_count, handles, false, BUFFER_THREAD_WAIT_TIMEOUT_MS);
+        WaitForMultipleObjects(handle_count, handles, false, (timeout_ms < 0) ? INFINITE : (DWORD) timeout_ms);
 #else
-        poll(fds, 1, BUFFER_THREAD_WAIT_TIMEOUT_MS);
+        poll(fds, 1, timeout_ms);
 #endif
         JSDRV_LOGD2("buffer thread tick");
-        do {
-            while (handle_cmd_q(self)) { ;
-            }
-            req_handle_one(self);
-        } while (!self->do_exit && !jsdrv_list_is_empty(&self->req_pending));
+        bool idle = true;
+        while (handle_cmd_q(self)) {
+            idle = false;
+        }
+        if (idle && self->summary_pending) {
+            self->summary_pending = 0;
+            summary_idle(self, self->mutex);
+        }
+        snap_process(self);
+        info_process(self);
+        standing_wake(self);
+    }
+
+    if (reader_ok) {
+        msg_queue_push(self->req_q, jsdrvp_msg_alloc_value(self->context, JSDRV_MSG_FINALIZE, &jsdrv_union_u8(0)));
+        jsdrv_thread_join(&self->reader_thread, 1000);
     }
+    workers_stop(self);
 
     // Clear all signals.
     for (uint32_t idx = 0; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
@@ -534,14 +2299,26 @@ static THREAD_RETURN_TYPE buffer_thread(THREAD_ARG_TYPE lpParam) {
             jsdrv_bufsig_free(s);
         }
     }
+    if (NULL != self->snap) {
+        for (uint32_t idx = 0; idx < JSDRV_BUFSIG_COUNT_MAX; ++idx) {
+            jsdrv_bufsig_free(&self->snap[idx]);
+        }
+        jsdrv_free(self->snap);
+        self->snap = NULL;
+    }
 
-    req_list_free(&self->req_pending);
-    req_list_free(&self->req_free);
+    msg_queue_finalize(self->req_q);
+    self->req_q = NULL;
+    jsdrv_os_mutex_free(self->read_mutex);
+    self->read_mutex = NULL;
+    jsdrv_os_mutex_free(self->mutex);
+    self->mutex = NULL;
     JSDRV_LOGI("buffer thread done: %s", self->topic);
+    jsdrv_thread_unregister();
     THREAD_RETURN();
 }
 
-static void _send_buffer_list(struct buffer_mgr_s * self) {
+static void _send_buffer_list(struct jsdrv_buffer_mgr_s * self) {
     struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_LIST, &jsdrv_union_cbin_r(NULL, 0));
     for (uint8_t buffer_idx = 1; buffer_idx <= JSDRV_BUFFER_COUNT_MAX; ++buffer_idx) {
         if (NULL != self->buffers[buffer_idx - 1].cmd_q) {
@@ -553,29 +2330,7 @@ static void _send_buffer_list(struct buffer_mgr_s * self) {
 }
 
 static uint8_t _buffer_recv(void * user_data, struct jsdrvp_msg_s * msg) {
-    (void) user_data;
-
-    // topic should be "m/xxx/..."
-    if (!jsdrv_cstr_starts_with(msg->topic, "m/")) {
-        JSDRV_LOGE("unexpected topic %s", msg->topic);
-        return 1;
-    }
-    uint32_t buffer_idx = 0;
-    for (char * p = &msg->topic[2]; (*p && (*p != '/')); ++p) {
-        if ((*p >= '0') && (*p <= '9')) {
-            buffer_idx = buffer_idx * 10 + (*p - '0');
-        } else {
-            JSDRV_LOGE("buffer_idx parse failed: %s", msg->topic);
-            return 1;
-        }
-    }
-
-    if (!is_buffer_idx_valid(buffer_idx)) {
-        JSDRV_LOGE("buffer_idx not valid: %s", msg->topic);
-        return 1;
-    }
-
-    struct buffer_s * b = &instance_.buffers[buffer_idx - 1];
+    struct buffer_s * b = (struct buffer_s *) user_data;
     if (jsdrv_cstr_ends_with(msg->topic, "!rsp")) {
         // allow external to register to our !rsp topic.
         return 0;
@@ -595,27 +2350,21 @@ static uint8_t _buffer_recv(void * user_data, struct jsdrvp_msg_s * msg) {
 }
 
 static uint8_t _buffer_recv_data(void * user_data, struct jsdrvp_msg_s * msg) {
-    intptr_t v = (intptr_t) user_data;
-    uint32_t buffer_idx = v & 0xffff;
-    uint32_t signal_idx = (v >> 16) & 0xffff;
-
-    if (!is_buffer_idx_valid(buffer_idx)) {
-        JSDRV_LOGE("buffer_idx not valid: %s", msg->topic);
-        return 1;
-    }
-    if (!is_signal_idx_valid(signal_idx)) {
-        JSDRV_LOGE("signal_idx not valid: %s", msg->topic);
-        return 1;
-    }
-
-    struct bufsig_s * b = &instance_.buffers[buffer_idx - 1].signals[signal_idx];
+    struct bufsig_s * b = (struct bufsig_s *) user_data;
     struct jsdrv_stream_signal_s * signal = (struct jsdrv_stream_signal_s *) msg->value.value.bin;
     if (signal->element_count == 0) {
-        JSDRV_LOGW("empty stream signal message");
+        JSDRV_LOGW_RATE("empty stream signal message");
     } else if (NULL == b->parent->cmd_q) {
         // discard
     } else if (0 == b->parent->hold) {
-        struct jsdrvp_msg_s * m = jsdrvp_msg_clone(b->parent->context, msg);
+        // Share the read-only data message rather than copying the samples.
+        // The envelope provides the list item and signal index.
+        struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(b->parent->context);
+        jsdrv_cstr_copy(m->topic, msg->topic, sizeof(m->topic));
+        m->value = msg->value;
+        m->value.flags &= ~JSDRV_UNION_FLAG_HEAP_MEMORY;
+        m->payload.dispatch.msg = jsdrvp_msg_retain(msg);
+        m->qos = msg->qos;
         m->u32_a = b->idx;  // signal_id=0 (invalid), for main processing
         msg_queue_push(b->parent->cmd_q, m);
     }
@@ -623,33 +2372,36 @@ static uint8_t _buffer_recv_data(void * user_data, struct jsdrvp_msg_s * msg) {
 }
 
 static uint8_t _buffer_add(void * user_data, struct jsdrvp_msg_s * msg) {
-    (void) user_data;
-    struct buffer_mgr_s * self = &instance_;
+    struct jsdrv_buffer_mgr_s * self = (struct jsdrv_buffer_mgr_s *) user_data;
     struct jsdrv_union_s v = msg->value;
     jsdrv_union_widen(&v);
     uint64_t buffer_id_u64 = v.value.u64;
     if (!is_buffer_idx_valid(buffer_id_u64)) {
         JSDRV_LOGE("buffer_id %llu invalid", buffer_id_u64);
-        return send_return_code_to_frontend(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, JSDRV_ERROR_PARAMETER_INVALID, _buffer_add, NULL);
+        return send_return_code_to_frontend(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, JSDRV_ERROR_PARAMETER_INVALID, _buffer_add, self);
     }
 
     uint8_t buffer_id = (uint8_t) buffer_id_u64;
     struct buffer_s * b = &self->buffers[buffer_id - 1];
     if (NULL != b->cmd_q) {
         JSDRV_LOGE("buffer_id %u already exists", buffer_id);
-        return send_return_code_to_frontend(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, JSDRV_ERROR_ALREADY_EXISTS, _buffer_add, NULL);
+        return send_return_code_to_frontend(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, JSDRV_ERROR_ALREADY_EXISTS, _buffer_add, self);
     }
     JSDRV_LOGI("buffer_id %u add", buffer_id);
     memset(b, 0, sizeof(*b));
     b->idx = buffer_id;
     b->hold = 0;
     b->state = ST_IDLE;
+    b->info_rate = BUFFER_INFO_RATE_DEFAULT;
+    b->cfg.numa_node = -1;
     tfp_snprintf(b->topic, sizeof(b->topic), "m/%03u", buffer_id);
     b->context = self->context;
-    b->cmd_q = msg_queue_init();
+    b->cmd_q = msg_queue_init_spsc(MSG_QUEUE_SPSC_CAPACITY_DEFAULT);  // frontend thread to buffer thread
+    msg_queue_qos_enable(b->cmd_q);  // critical devices overtake background devices
     subscribe(b->context, b->topic, JSDRV_SFLAG_PUB, _buffer_recv, b);
     jsdrv_list_initialize(&b->req_pending);
     jsdrv_list_initialize(&b->req_free);
+    jsdrv_list_initialize(&b->req_standing);
     for (uint32_t i = 0; i < JSDRV_BUFSIG_COUNT_MAX; i++) {  // initialize 0 (invalid) just in case
         struct bufsig_s * s = &b->signals[i];
         s->idx = i;
@@ -660,14 +2412,14 @@ static uint8_t _buffer_add(void * user_data, struct jsdrvp_msg_s * msg) {
 
     if (jsdrv_thread_create(&b->thread, buffer_thread, b, -1)) {
         JSDRV_LOGE("buffer_id %u thread create failed", buffer_id);
-        return send_return_code_to_frontend(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, JSDRV_ERROR_UNSPECIFIED, _buffer_add, NULL);
+        return send_return_code_to_frontend(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, JSDRV_ERROR_UNSPECIFIED, _buffer_add, self);
     }
 
     _send_buffer_list(self);
-    return send_return_code_to_frontend(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, 0, _buffer_add, NULL);
+    return send_return_code_to_frontend(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, 0, _buffer_add, self);
 }
 
-static void _buffer_remove_inner(struct buffer_mgr_s * self, uint8_t buffer_id) {
+static void _buffer_remove_inner(struct jsdrv_buffer_mgr_s * self, uint8_t buffer_id) {
     struct buffer_s * b = &self->buffers[buffer_id - 1];
     if (NULL == b->cmd_q) {
         JSDRV_LOGE("buffer_id %u does not exist", buffer_id);
@@ -684,52 +2436,71 @@ static void _buffer_remove_inner(struct buffer_mgr_s * self, uint8_t buffer_id)
 }
 
 static uint8_t _buffer_remove(void * user_data, struct jsdrvp_msg_s * msg) {
-    (void) user_data;
-    struct buffer_mgr_s * self = &instance_;
+    struct jsdrv_buffer_mgr_s * self = (struct jsdrv_buffer_mgr_s *) user_data;
     struct jsdrv_union_s v = msg->value;
     jsdrv_union_widen(&v);
     uint64_t buffer_id_u64 = v.value.u64;
     if (!is_buffer_idx_valid(buffer_id_u64)) {
         JSDRV_LOGE("invalid buffer_id: %llu", buffer_id_u64);
-        return send_return_code_to_frontend(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, JSDRV_ERROR_NOT_FOUND, _buffer_remove, NULL);
+        return send_return_code_to_frontend(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, JSDRV_ERROR_NOT_FOUND, _buffer_remove, self);
     }
     _buffer_remove_inner(self, (uint8_t) buffer_id_u64);
-    return send_return_code_to_frontend(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, 0, _buffer_remove, NULL);
+    return send_return_code_to_frontend(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, 0, _buffer_remove, self);
 }
 
-int32_t jsdrv_buffer_initialize(struct jsdrv_context_s * context) {
+int32_t jsdrv_buffer_initialize(struct jsdrv_context_s * context, struct jsdrv_buffer_mgr_s ** instance) {
     JSDRV_DBC_NOT_NULL(context);
-    struct buffer_mgr_s * self = &instance_;
-    if (NULL != self->context) {
-        JSDRV_LOGE("jsdrv_buffer_initialize but context not NULL");
-        return JSDRV_ERROR_IN_USE;
-    }
-    memset(self, 0, sizeof(*self));
+    JSDRV_DBC_NOT_NULL(instance);
+    struct jsdrv_buffer_mgr_s * self = jsdrv_alloc_clr_cat(sizeof(struct jsdrv_buffer_mgr_s), JSDRV_ALLOC_CAT_BUFFER);
     self->context = context;
 
     send_to_frontend(self, JSDRV_BUFFER_MGR_MSG_ACTION_ADD "$", &jsdrv_union_cjson_r(action_add_meta));
     send_to_frontend(self, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE "$", &jsdrv_union_cjson_r(action_remove_meta));
     send_to_frontend(self, JSDRV_BUFFER_MGR_MSG_ACTION_LIST "$", &jsdrv_union_cjson_r(action_list_meta));
 
-    subscribe(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, JSDRV_SFLAG_PUB, _buffer_add, NULL);
-    subscribe(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, JSDRV_SFLAG_PUB, _buffer_remove, NULL);
+    subscribe(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, JSDRV_SFLAG_PUB, _buffer_add, self);
+    subscribe(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, JSDRV_SFLAG_PUB, _buffer_remove, self);
     _send_buffer_list(self);
-
+    *instance = self;
     return 0;
 }
 
-void jsdrv_buffer_finalize(void) {
-    struct buffer_mgr_s * self = &instance_;
-    if (self->context) {
-        unsubscribe(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, JSDRV_SFLAG_PUB, _buffer_add, NULL);
-        unsubscribe(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, JSDRV_SFLAG_PUB, _buffer_remove, NULL);
+int32_t jsdrv_buffer_mgr_read(struct jsdrv_buffer_mgr_s * self, uint8_t buffer_id, uint8_t signal_id,
+                              struct jsdrv_buffer_request_s * req, struct jsdrv_buffer_response_s * rsp,
+                              uint64_t data_size) {
+    if ((NULL == self) || !is_buffer_idx_valid(buffer_id)
+            || (0 == signal_id) || (signal_id >= JSDRV_BUFSIG_COUNT_MAX)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct buffer_s * buffer = &self->buffers[buffer_id - 1];
+    if (NULL == buffer->cmd_q) {
+        return JSDRV_ERROR_NOT_FOUND;
+    }
+    req->flags &= ~(JSDRV_BUFFER_REQUEST_FLAG_STREAM | REQ_FLAGS_STANDING);
+    int32_t rc = JSDRV_ERROR_NOT_FOUND;
+    jsdrv_os_mutex_lock(buffer->read_mutex);
+    struct bufsig_s * b = &buffer->signals[signal_id];
+    if (req->flags & JSDRV_BUFFER_REQUEST_FLAG_SNAPSHOT) {
+        b = (NULL == buffer->snap) ? NULL : &buffer->snap[signal_id];
+    }
+    if ((NULL != b) && b->active) {
+        rc = req_process(buffer, b, req, rsp, data_size);
+    }
+    jsdrv_os_mutex_unlock(buffer->read_mutex);
+    return rc;
+}
+
+void jsdrv_buffer_finalize(struct jsdrv_buffer_mgr_s * self) {
+    if (self) {
+        unsubscribe(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, JSDRV_SFLAG_PUB, _buffer_add, self);
+        unsubscribe(self->context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, JSDRV_SFLAG_PUB, _buffer_remove, self);
 
         // finalize all buffers
-        for (uint32_t buffer_idx = 1; buffer_idx < JSDRV_BUFFER_COUNT_MAX; ++buffer_idx) {
+        for (uint32_t buffer_idx = 1; buffer_idx <= JSDRV_BUFFER_COUNT_MAX; ++buffer_idx) {
             if (NULL != self->buffers[buffer_idx - 1].cmd_q) {
                 _buffer_remove_inner(self, buffer_idx);
             }
         }
-        self->context = NULL;
+        jsdrv_free(self);
     }
 }
@@ -0,0 +1,213 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/buffer_codec.h"
+#include "jsdrv/error_code.h"
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+struct bit_writer_s {
+    uint8_t * p;
+    uint8_t * end;
+    uint64_t acc;
+    uint32_t fill;
+    bool overflow;
+};
+
+struct bit_reader_s {
+    const uint8_t * p;
+    const uint8_t * end;
+    uint64_t acc;
+    uint32_t fill;
+    bool underflow;
+};
+
+static inline uint32_t clz32(uint32_t x) {  // x != 0
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanReverse(&idx, x);
+    return 31 - (uint32_t) idx;
+#else
+    return (uint32_t) __builtin_clz(x);
+#endif
+}
+
+static inline uint32_t ctz32(uint32_t x) {  // x != 0
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward(&idx, x);
+    return (uint32_t) idx;
+#else
+    return (uint32_t) __builtin_ctz(x);
+#endif
+}
+
+static inline uint32_t f32_bits(float f) {
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+static inline float bits_f32(uint32_t u) {
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+static inline void bits_put(struct bit_writer_s * w, uint32_t value, uint32_t bits) {
+    w->acc |= ((uint64_t) value & ((1ULL << bits) - 1)) << w->fill;
+    w->fill += bits;
+    while (w->fill >= 8) {
+        if (w->p >= w->end) {
+            w->overflow = true;
+            return;
+        }
+        *w->p++ = (uint8_t) w->acc;
+        w->acc >>= 8;
+        w->fill -= 8;
+    }
+}
+
+static inline uint32_t bits_get(struct bit_reader_s * r, uint32_t bits) {
+    while (r->fill < bits) {
+        if (r->p >= r->end) {
+            r->underflow = true;
+            return 0;
+        }
+        r->acc |= ((uint64_t) *r->p++) << r->fill;
+        r->fill += 8;
+    }
+    uint32_t v = (uint32_t) (r->acc & ((1ULL << bits) - 1));
+    r->acc >>= bits;
+    r->fill -= bits;
+    return v;
+}
+
+uint32_t jsdrv_codec_rle8_encode(const uint8_t * src, uint32_t src_size, uint8_t * dst, uint32_t dst_size) {
+    uint32_t sz = 0;
+    uint32_t i = 0;
+    while (i < src_size) {
+        uint8_t v = src[i];
+        uint32_t run = 1;
+        while (((i + run) < src_size) && (run < 256) && (src[i + run] == v)) {
+            ++run;
+        }
+        if ((sz + 2) > dst_size) {
+            return 0;
+        }
+        dst[sz++] = (uint8_t) (run - 1);
+        dst[sz++] = v;
+        i += run;
+    }
+    return sz;
+}
+
+int32_t jsdrv_codec_rle8_decode(const uint8_t * src, uint32_t src_size, uint8_t * dst, uint32_t dst_size) {
+    uint32_t sz = 0;
+    for (uint32_t i = 0; (i + 1) < src_size; i += 2) {
+        uint32_t run = (uint32_t) src[i] + 1;
+        if ((sz + run) > dst_size) {
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+        memset(dst + sz, src[i + 1], run);
+        sz += run;
+    }
+    return (sz == dst_size) ? 0 : JSDRV_ERROR_PARAMETER_INVALID;
+}
+
+/*
+ * Each sample after the first encodes x ^ x_prev as:
+ *   0                     identical to the previous sample
+ *   1 0 <bits>            meaningful bits fit the previous window
+ *   1 1 <lead:5> <len-1:5> <bits>   new window
+ */
+uint32_t jsdrv_codec_xor_f32_encode(const float * src, uint32_t count, uint8_t * dst, uint32_t dst_size) {
+    struct bit_writer_s w = {.p = dst, .end = dst + dst_size, .acc = 0, .fill = 0, .overflow = false};
+    if (0 == count) {
+        return 0;
+    }
+    uint32_t prev = f32_bits(src[0]);
+    uint32_t lead_prev = 0;
+    uint32_t trail_prev = 0;
+    bool window = false;
+    bits_put(&w, prev, 32);
+    for (uint32_t i = 1; (i < count) && !w.overflow; ++i) {
+        uint32_t x = f32_bits(src[i]);
+        uint32_t d = x ^ prev;
+        prev = x;
+        if (0 == d) {
+            bits_put(&w, 0, 1);
+            continue;
+        }
+        uint32_t lead = clz32(d);
+        uint32_t trail = ctz32(d);
+        uint32_t len = 32 - lead - trail;
+        uint32_t len_prev = 32 - lead_prev - trail_prev;
+        // reuse the previous window only when cheaper than a new 10-bit window header
+        if (window && (lead >= lead_prev) && (trail >= trail_prev) && (len_prev <= (len + 10))) {
+            bits_put(&w, 0x1, 2);
+            bits_put(&w, d >> trail_prev, len_prev);
+        } else {
+            bits_put(&w, 0x3, 2);
+            bits_put(&w, lead, 5);
+            bits_put(&w, len - 1, 5);
+            bits_put(&w, d >> trail, len);
+            lead_prev = lead;
+            trail_prev = trail;
+            window = true;
+        }
+    }
+    if (w.fill && !w.overflow) {
+        if (w.p >= w.end) {
+            w.overflow = true;
+        } else {
+            *w.p++ = (uint8_t) w.acc;
+        }
+    }
+    return w.overflow ? 0 : (uint32_t) (w.p - dst);
+}
+
+int32_t jsdrv_codec_xor_f32_decode(const uint8_t * src, uint32_t src_size, float * dst, uint32_t count) {
+    struct bit_reader_s r = {.p = src, .end = src + src_size, .acc = 0, .fill = 0, .underflow = false};
+    if (0 == count) {
+        return 0;
+    }
+    uint32_t prev = bits_get(&r, 32);
+    uint32_t lead = 0;
+    uint32_t len = 0;
+    dst[0] = bits_f32(prev);
+    for (uint32_t i = 1; (i < count) && !r.underflow; ++i) {
+        if (bits_get(&r, 1)) {
+            if (bits_get(&r, 1)) {
+                lead = bits_get(&r, 5);
+                len = bits_get(&r, 5) + 1;
+                if ((lead + len) > 32) {
+                    return JSDRV_ERROR_PARAMETER_INVALID;
+                }
+            } else if (0 == len) {
+                return JSDRV_ERROR_PARAMETER_INVALID;  // window reuse before first window
+            }
+            prev ^= bits_get(&r, len) << (32 - lead - len);
+        }
+        dst[i] = bits_f32(prev);
+    }
+    return r.underflow ? JSDRV_ERROR_PARAMETER_INVALID : 0;
+}
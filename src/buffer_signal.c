@@ -15,24 +15,39 @@
 */
 
 #include "jsdrv_prv/buffer_signal.h"
+#include "jsdrv_prv/alloc.h"
 #include "jsdrv_prv/assert.h"
+#include "jsdrv_prv/buffer_codec.h"
 #include "jsdrv/cstr.h"
 #include "jsdrv/error_code.h"
 #include "jsdrv_prv/frontend.h"
 #include "jsdrv_prv/log.h"
+#include "jsdrv_prv/pack.h"
 #include "jsdrv/time.h"
 #include "jsdrv_prv/js220_i128.h"
+#include "jsdrv_prv/simd_f32.h"
 #include "jsdrv_prv/statistics.h"
+#include "jsdrv_prv/thread.h"
 #include <inttypes.h>
 #include <math.h>
 #include <float.h>
 
 #define DATA_SIZE_MAX (sizeof(struct jsdrv_stream_signal_s) \
                        - sizeof(struct jsdrv_buffer_response_s) \
-                       - sizeof(uint64_t) * 8)  // extra space for shift and overrun
+                       - JSDRV_BUFSIG_RSP_SLACK)
 const uint64_t SUMMARY_LENGTH_MAX = DATA_SIZE_MAX / sizeof(struct jsdrv_summary_entry_s);
+#define LEVEL0_SEGMENT_MAX (0x40000000LLU)  // jsdrv_f32_sum() length limit per call
+#define INGEST_ENTRIES_MIN (1024)     // level 1 entries per ingest thread
+#define SUMMARY_DIRTY_DIV (4)         // complete the lazy summary levels within N / 4 samples
 
-static uint64_t summary_level0_get_by_idx(struct bufsig_s * self, uint64_t index, uint64_t incr, struct jsdrv_summary_entry_s * y);
+static uint64_t summary_level0_get_by_idx(struct bufsig_s * self, uint64_t index, uint64_t incr, bool envelope,
+                                          struct jsdrv_summary_entry_s * y);
+static void integral_update(struct bufsig_s * self, uint64_t level1_idx, uint64_t level0_idx);
+static void level0_f32_sum_i128(struct bufsig_s * self, uint64_t index, uint64_t incr,
+                                js220_i128 * sum, uint64_t * count);
+static void hist_update(struct bufsig_s * self, uint64_t level1_idx, uint64_t level0_idx);
+static void hist_merge(struct bufsig_s * self, uint8_t level, uint64_t lvl_up_idx, uint64_t lvl_dn_idx);
+static void trend_append(struct bufsig_s * self, const struct jsdrv_summary_entry_s * e, uint64_t sample_id_end);
 
 static void entry_clear(struct jsdrv_summary_entry_s * y) {
     y->avg = NAN;
@@ -52,6 +67,285 @@ static struct jsdrv_summary_entry_s * level_entry(struct bufsig_s * self, uint8_
     return &lvl->data[idx];
 }
 
+static void * level0_alloc(struct bufsig_s * self, size_t size_bytes) {
+    void * ptr;
+    self->level0_mapped_size = 0;
+    self->level0_storage = BUFSIG_STORAGE_HEAP;
+    if ((NULL != self->storage_dir) && self->storage_dir[0]) {
+        ptr = jsdrv_os_file_map_alloc(size_bytes, self->storage_dir);
+        if (NULL != ptr) {
+            self->level0_mapped_size = size_bytes;
+            self->level0_storage = BUFSIG_STORAGE_FILE;
+            return ptr;
+        }
+        JSDRV_LOGW("bufsig %d file map failed, use RAM", (int) self->idx);
+    }
+    if (self->mem_flags || (self->numa_node >= 0)) {
+        ptr = jsdrv_os_mem_alloc(size_bytes, self->mem_flags, self->numa_node);
+        if (NULL != ptr) {
+            self->level0_mapped_size = size_bytes;
+            self->level0_storage = BUFSIG_STORAGE_MEM;
+            return ptr;
+        }
+        JSDRV_LOGW("bufsig %d mem alloc failed, use heap", (int) self->idx);
+    }
+    return jsdrv_alloc_cat(size_bytes, JSDRV_ALLOC_CAT_BUFFER);
+}
+
+static size_t block_raw_size(struct bufsig_s * self) {
+    return (JSDRV_BUFSIG_BLOCK_SAMPLES * self->hdr.element_size_bits) / 8;
+}
+
+static uint64_t blocks_budget(struct bufsig_s * self) {
+    if (self->level0_budget) {
+        return self->level0_budget;
+    }
+    return (self->N * self->hdr.element_size_bits) / 8;
+}
+
+static void block_evict(struct bufsig_s * self, uint64_t idx) {
+    struct bufsig_block_s * blk = &self->blocks[idx];
+    if (NULL != blk->data) {
+        jsdrv_free(blk->data);
+        self->blocks_size -= blk->size;
+    }
+    if (blk->seq == self->block_cache_seq) {
+        self->block_cache_seq = 0;
+    }
+    blk->data = NULL;
+    blk->size = 0;
+    blk->codec = JSDRV_CODEC_RAW;
+    blk->seq = 0;
+}
+
+static void blocks_reset(struct bufsig_s * self) {
+    for (uint64_t idx = 0; idx < self->block_count; ++idx) {
+        block_evict(self, idx);
+    }
+    self->block_tail = 0;
+    self->block_cache_seq = 0;
+}
+
+static bool blocks_alloc(struct bufsig_s * self) {
+    if ((self->N % JSDRV_BUFSIG_BLOCK_SAMPLES) || (JSDRV_BUFSIG_BLOCK_SAMPLES % self->r0)) {
+        JSDRV_LOGW("bufsig %d N or r0 incompatible with codec blocks, use raw", (int) self->idx);
+        return false;
+    }
+    size_t raw_size = block_raw_size(self);
+    self->block_count = self->N / JSDRV_BUFSIG_BLOCK_SAMPLES;
+    self->blocks = jsdrv_alloc_clr_cat(self->block_count * sizeof(struct bufsig_block_s), JSDRV_ALLOC_CAT_BUFFER);
+    self->level0_data = jsdrv_alloc_cat(raw_size, JSDRV_ALLOC_CAT_BUFFER);
+    self->block_scratch = jsdrv_alloc_cat(raw_size, JSDRV_ALLOC_CAT_BUFFER);
+    self->block_cache = jsdrv_alloc_cat(raw_size, JSDRV_ALLOC_CAT_BUFFER);
+    self->blocks_size = 0;
+    blocks_reset(self);
+    return true;
+}
+
+static void blocks_free(struct bufsig_s * self) {
+    blocks_reset(self);
+    jsdrv_free(self->blocks);
+    jsdrv_free(self->block_scratch);
+    jsdrv_free(self->block_cache);
+    jsdrv_free(self->level0_data);
+    self->blocks = NULL;
+    self->block_scratch = NULL;
+    self->block_cache = NULL;
+    self->level0_data = NULL;
+    self->block_count = 0;
+}
+
+// Store the open block, then evict the oldest blocks to fit the budget and the next open block.
+static void block_close(struct bufsig_s * self, uint64_t idx) {
+    uint32_t raw_size = (uint32_t) block_raw_size(self);
+    uint32_t sz;
+    uint8_t codec;
+    if (JSDRV_DATA_TYPE_FLOAT == self->hdr.element_type) {
+        codec = JSDRV_CODEC_XOR_F32;
+        sz = jsdrv_codec_xor_f32_encode((const float *) self->level0_data, JSDRV_BUFSIG_BLOCK_SAMPLES,
+                                        self->block_scratch, raw_size);
+    } else {
+        codec = JSDRV_CODEC_RLE8;
+        sz = jsdrv_codec_rle8_encode((const uint8_t *) self->level0_data, raw_size,
+                                     self->block_scratch, raw_size);
+    }
+    const uint8_t * src = self->block_scratch;
+    if (0 == sz) {
+        codec = JSDRV_CODEC_RAW;
+        sz = raw_size;
+        src = (const uint8_t *) self->level0_data;
+    }
+    block_evict(self, idx);
+    struct bufsig_block_s * blk = &self->blocks[idx];
+    blk->data = jsdrv_alloc_cat(sz, JSDRV_ALLOC_CAT_BUFFER);
+    memcpy(blk->data, src, sz);
+    blk->size = sz;
+    blk->codec = codec;
+    blk->seq = ++self->block_seq;
+    self->blocks_size += sz;
+
+    while ((self->blocks_size > blocks_budget(self)) && (self->block_tail != idx)) {
+        block_evict(self, self->block_tail);
+        self->block_tail = (self->block_tail + 1) % self->block_count;
+    }
+    uint64_t next = (idx + 1) % self->block_count;
+    if ((next == self->block_tail) && (NULL != self->blocks[next].data)) {
+        block_evict(self, next);
+        self->block_tail = (next + 1) % self->block_count;
+    }
+}
+
+static uint64_t blocks_level0_size(struct bufsig_s * self) {
+    uint64_t head_idx = self->level0_head / JSDRV_BUFSIG_BLOCK_SAMPLES;
+    uint64_t blocks = (head_idx + self->block_count - self->block_tail) % self->block_count;
+    return blocks * JSDRV_BUFSIG_BLOCK_SAMPLES + (self->level0_head % JSDRV_BUFSIG_BLOCK_SAMPLES);
+}
+
+/*
+ * Get the raw level 0 data containing index.
+ *
+ * Element index is at local offset (index - *base), and the data is
+ * contiguous until *end.  Compressed blocks decode into a single
+ * block cache, so the pointer is valid until the next call.
+ */
+static const uint8_t * level0_block_stored(struct bufsig_s * self, uint64_t index, uint64_t * base, uint64_t * end) {
+    if (NULL == self->blocks) {
+        *base = 0;
+        *end = self->N;
+        return (const uint8_t *) self->level0_data;
+    }
+    uint64_t idx = index / JSDRV_BUFSIG_BLOCK_SAMPLES;
+    *base = idx * JSDRV_BUFSIG_BLOCK_SAMPLES;
+    *end = *base + JSDRV_BUFSIG_BLOCK_SAMPLES;
+    if (idx == (self->level0_head / JSDRV_BUFSIG_BLOCK_SAMPLES)) {
+        return (const uint8_t *) self->level0_data;  // the open block
+    }
+    struct bufsig_block_s * blk = &self->blocks[idx];
+    if ((NULL != blk->data) && (JSDRV_CODEC_RAW == blk->codec)) {
+        return blk->data;
+    }
+    if ((0 == blk->seq) || (blk->seq != self->block_cache_seq)) {
+        uint32_t raw_size = (uint32_t) block_raw_size(self);
+        int32_t rc = JSDRV_ERROR_UNAVAILABLE;
+        if (NULL == blk->data) {
+            // evicted, should not be in range
+        } else if (JSDRV_CODEC_XOR_F32 == blk->codec) {
+            rc = jsdrv_codec_xor_f32_decode(blk->data, blk->size, (float *) self->block_cache,
+                                            JSDRV_BUFSIG_BLOCK_SAMPLES);
+        } else if (JSDRV_CODEC_RLE8 == blk->codec) {
+            rc = jsdrv_codec_rle8_decode(blk->data, blk->size, self->block_cache, raw_size);
+        }
+        if (rc) {
+            JSDRV_LOGW_RATE("bufsig %d block %" PRIu64 " decode failed: %d", (int) self->idx, idx, (int) rc);
+            if (JSDRV_DATA_TYPE_FLOAT == self->hdr.element_type) {
+                float * f32 = (float *) self->block_cache;
+                for (uint32_t i = 0; i < JSDRV_BUFSIG_BLOCK_SAMPLES; ++i) {
+                    f32[i] = NAN;
+                }
+            } else {
+                memset(self->block_cache, 0, raw_size);
+            }
+            self->block_cache_seq = 0;
+        } else {
+            self->block_cache_seq = blk->seq;
+        }
+    }
+    return self->block_cache;
+}
+
+// Substitute gap_fill for the level 0 data within gaps, and end the data at the next gap.
+static const uint8_t * level0_gap_clip(struct bufsig_s * self, uint64_t index, uint64_t * base, uint64_t * end,
+                                       const uint8_t * data) {
+    uint64_t tail = (self->level0_head + self->N - self->level0_size) % self->N;
+    uint64_t sample_id = self->sample_id_head - self->level0_size + (index + self->N - tail) % self->N;
+    for (uint32_t i = 0; i < self->gap_count; ++i) {
+        const struct bufsig_gap_s * g = &self->gaps[i];
+        if (g->end <= sample_id) {
+            continue;
+        } else if (g->start > sample_id) {
+            uint64_t gap_index = index + (g->start - sample_id);
+            if (*end > gap_index) {
+                *end = gap_index;
+            }
+            return data;
+        }
+        uint64_t fill_base = index & ~63ULL;  // keep the sub-byte sample positions
+        uint64_t fill_end = fill_base + JSDRV_BUFSIG_GAP_FILL;
+        uint64_t gap_end = index + (g->end - sample_id);
+        if (fill_end > gap_end) {
+            fill_end = gap_end;
+        }
+        if (fill_end > *end) {
+            fill_end = *end;
+        }
+        *base = fill_base;
+        *end = fill_end;
+        return (const uint8_t *) self->gap_fill;
+    }
+    return data;
+}
+
+/*
+ * Get the level 0 data containing index, like level0_block_stored().
+ *
+ * Within a gap, the data is gap_fill.  Otherwise, the data ends at
+ * the next gap.
+ */
+static const uint8_t * level0_block(struct bufsig_s * self, uint64_t index, uint64_t * base, uint64_t * end) {
+    const uint8_t * data = level0_block_stored(self, index, base, end);
+    if (self->gap_count) {
+        data = level0_gap_clip(self, index, base, end, data);
+    }
+    return data;
+}
+
+// Get the raw level 0 data containing level0_head, with block semantics like level0_block().
+static uint8_t * level0_head_block(struct bufsig_s * self, uint64_t * base, uint64_t * end) {
+    if (NULL == self->blocks) {
+        *base = 0;
+        *end = self->N;
+    } else {
+        *base = (self->level0_head / JSDRV_BUFSIG_BLOCK_SAMPLES) * JSDRV_BUFSIG_BLOCK_SAMPLES;
+        *end = *base + JSDRV_BUFSIG_BLOCK_SAMPLES;
+    }
+    return (uint8_t *) self->level0_data;
+}
+
+static void level0_free(struct bufsig_s * self) {
+    if (NULL != self->blocks) {
+        blocks_free(self);
+        return;
+    }
+    switch (self->level0_storage) {
+        case BUFSIG_STORAGE_MEM: jsdrv_os_mem_free(self->level0_data, self->level0_mapped_size); break;
+        case BUFSIG_STORAGE_FILE: jsdrv_os_file_map_free(self->level0_data, self->level0_mapped_size); break;
+        default: jsdrv_free(self->level0_data); break;
+    }
+    self->level0_data = NULL;
+    self->level0_mapped_size = 0;
+    self->level0_storage = BUFSIG_STORAGE_HEAP;
+}
+
+// The raw level 0 size for N samples.
+static size_t level0_bytes(struct bufsig_s * self) {
+    size_t level0_bytes = 0;
+    if (JSDRV_DATA_TYPE_FLOAT == self->hdr.element_type) {
+        JSDRV_ASSERT(self->hdr.element_size_bits == 32);
+        level0_bytes = self->N * sizeof(float);
+    } else if (JSDRV_DATA_TYPE_UINT == self->hdr.element_type) {
+        if (1 == self->hdr.element_size_bits) {
+            level0_bytes = (self->N * self->hdr.element_size_bits + 7) / 8;
+        } else if (4 == self->hdr.element_size_bits) {
+            level0_bytes = (self->N * self->hdr.element_size_bits + 1) / 2;
+        } else {
+            JSDRV_ASSERT(false);
+        }
+    } else {
+        JSDRV_ASSERT(false);
+    }
+    return level0_bytes;
+}
+
 void jsdrv_bufsig_alloc(struct bufsig_s * self, uint64_t N, uint64_t r0, uint64_t rN) {
     JSDRV_LOGI("jsdrv_bufsig_alloc %d N=%" PRIu64 ", r0=%" PRIu64", rN=%" PRIu64,
                (int) self->idx, N, r0, rN);
@@ -72,22 +366,13 @@ void jsdrv_bufsig_alloc(struct bufsig_s * self, uint64_t N, uint64_t r0, uint64_
     self->time_map.counter_rate = ((double) self->hdr.sample_rate) / self->hdr.decimate_factor;
     self->size_in_utc = JSDRV_F64_TO_TIME(size_in_utc);
 
-    if (JSDRV_DATA_TYPE_FLOAT == self->hdr.element_type) {
-        JSDRV_ASSERT(self->hdr.element_size_bits == 32);
-        self->level0_data = jsdrv_alloc(self->N * sizeof(float));
-    } else if (JSDRV_DATA_TYPE_UINT == self->hdr.element_type) {
-        if (1 == self->hdr.element_size_bits) {
-            self->level0_data = jsdrv_alloc((self->N * self->hdr.element_size_bits + 7) / 8);
-        } else if (4 == self->hdr.element_size_bits) {
-            self->level0_data = jsdrv_alloc((self->N * self->hdr.element_size_bits + 1) / 2);
-        } else {
-            JSDRV_ASSERT(false);
-        }
-    } else {
-        JSDRV_ASSERT(false);
+    if (!self->codec || !blocks_alloc(self)) {
+        self->level0_data = level0_alloc(self, level0_bytes(self));
     }
     self->level0_head = 0;
     self->level0_size = 0;
+    memset(self->summary_dirty, 0, sizeof(self->summary_dirty));
+    ++self->generation;
 
     uint64_t samples_per_entry = 1;
     for (int i = 0; i < JSDRV_BUFSIG_LEVELS_MAX; ++i) {
@@ -102,23 +387,81 @@ void jsdrv_bufsig_alloc(struct bufsig_s * self, uint64_t N, uint64_t r0, uint64_
         lvl->r = r;
         lvl->samples_per_entry = samples_per_entry;
         JSDRV_LOGD3("alloc lvl=%d %" PRIu64, i + 1, k);
-        lvl->data = jsdrv_alloc(k * sizeof(struct jsdrv_summary_entry_s));
+        lvl->data = jsdrv_alloc_cat(k * sizeof(struct jsdrv_summary_entry_s), JSDRV_ALLOC_CAT_BUFFER);
+    }
+
+    self->integral_sum = js220_i128_init_i64(0);
+    self->integral_count = 0;
+    if (self->integral && (JSDRV_DATA_TYPE_FLOAT == self->hdr.element_type) && (NULL != self->levels[0].data)) {
+        self->integral_index = jsdrv_alloc_cat(self->levels[0].k * sizeof(struct bufsig_integral_s), JSDRV_ALLOC_CAT_BUFFER);
+    }
+    if (self->histogram && (JSDRV_DATA_TYPE_FLOAT == self->hdr.element_type) && (NULL != self->levels[0].data)) {
+        size_t bins = JSDRV_BUFSIG_HIST_BINS;
+        self->hist_level1 = jsdrv_alloc_clr_cat(self->levels[0].k * bins * sizeof(uint16_t), JSDRV_ALLOC_CAT_BUFFER);
+        for (int i = 1; (i < JSDRV_BUFSIG_LEVELS_MAX) && (NULL != self->levels[i].data); ++i) {
+            if (self->levels[i].samples_per_entry > UINT32_MAX) {
+                break;
+            }
+            self->hist_levels[i] = jsdrv_alloc_clr_cat(self->levels[i].k * bins * sizeof(uint32_t), JSDRV_ALLOC_CAT_BUFFER);
+        }
+    }
+    self->trend_head = 0;
+    self->trend_size = 0;
+    self->trend_sample_id = 0;
+    if (self->trend_k && self->trend_level && (self->trend_level <= JSDRV_BUFSIG_LEVELS_MAX)) {
+        struct bufsig_level_s * lvl = &self->levels[self->trend_level - 1];
+        if (NULL == lvl->data) {
+            JSDRV_LOGW("trend level %d unavailable for N=%" PRIu64, (int) self->trend_level, N);
+        } else {
+            self->trend_spe = lvl->samples_per_entry;
+            self->trend = jsdrv_alloc_cat(self->trend_k * sizeof(struct jsdrv_summary_entry_s), JSDRV_ALLOC_CAT_BUFFER);
+        }
+    }
+    self->tile_clock = 0;
+    if (self->tile_count) {
+        self->tiles = jsdrv_alloc_clr_cat(self->tile_count * sizeof(struct bufsig_tile_s), JSDRV_ALLOC_CAT_BUFFER);
     }
 }
 
 void jsdrv_bufsig_free(struct bufsig_s * self) {
+    jsdrv_free(self->gap_fill);
+    self->gap_fill = NULL;
+    self->gap_count = 0;
     for (int i = 0; i < JSDRV_BUFSIG_LEVELS_MAX; ++i) {
         if (NULL != self->levels[i].data) {
             jsdrv_free(self->levels[i].data);
             self->levels[i].data = NULL;
         }
     }
+    if (self->integral_index) {
+        jsdrv_free(self->integral_index);
+        self->integral_index = NULL;
+    }
+    if (self->hist_level1) {
+        jsdrv_free(self->hist_level1);
+        self->hist_level1 = NULL;
+    }
+    if (self->trend) {
+        jsdrv_free(self->trend);
+        self->trend = NULL;
+    }
+    for (int i = 0; i < JSDRV_BUFSIG_LEVELS_MAX; ++i) {
+        if (NULL != self->hist_levels[i]) {
+            jsdrv_free(self->hist_levels[i]);
+            self->hist_levels[i] = NULL;
+        }
+    }
+    if (self->tiles) {
+        jsdrv_free(self->tiles);
+        self->tiles = NULL;
+    }
     if (self->level0_data) {
         JSDRV_LOGI("jsdrv_bufsig_free %d", (int) self->idx);
-        jsdrv_free(self->level0_data);
-        self->level0_data = NULL;
+        level0_free(self);
     }
     memset(&self->hdr, 0, sizeof(self->hdr));
+    memset(self->summary_dirty, 0, sizeof(self->summary_dirty));
+    ++self->generation;
     self->N = 0;
     self->level_count = 0;
     self->sample_id_head = 0;
@@ -185,7 +528,9 @@ bool jsdrv_bufsig_info(struct bufsig_s * self, struct jsdrv_buffer_info_s * info
     return true;
 }
 
-static void summarizeN(struct bufsig_s * self, uint8_t level, uint64_t start_idx, uint64_t length) {
+// Summarize level + 1 from level for length samples from the level 0 index start_idx, which holds sample_id.
+static void summarize_level(struct bufsig_s * self, uint8_t level, uint64_t start_idx, uint64_t length,
+                            uint64_t sample_id) {
     struct bufsig_level_s * lvl_dn = &self->levels[level - 1];
     struct bufsig_level_s * lvl_up = &self->levels[level];
     if (NULL == lvl_up->data) {
@@ -202,22 +547,32 @@ static void summarizeN(struct bufsig_s * self, uint8_t level, uint64_t start_idx
     struct jsdrv_statistics_accum_s s_accum;
     struct jsdrv_statistics_accum_s s_tmp;
     while (length >= lvl_up->samples_per_entry) {
-        jsdrv_statistics_reset(&s_accum);
-        for (uint64_t i = 0; i < lvl_up->r; ++i) {
-            src = level_entry(self, level, lvl_dn_idx + i);
-            jsdrv_statistics_from_entry(&s_tmp, src, 1);  // unweighted, all entries equal
-            jsdrv_statistics_combine(&s_accum, &s_accum, &s_tmp);
-        }
         dst = level_entry(self, level + 1, lvl_up_idx);
-        jsdrv_statistics_to_entry(&s_accum, dst);
+        if (((lvl_dn_idx + lvl_up->r) > lvl_dn->k)
+                || jsdrv_f32_summary_combine(dst, level_entry(self, level, lvl_dn_idx), (uint32_t) lvl_up->r)) {
+            // wrapped or contains NaN: combine one entry at a time
+            jsdrv_statistics_reset(&s_accum);
+            for (uint64_t i = 0; i < lvl_up->r; ++i) {
+                src = level_entry(self, level, lvl_dn_idx + i);
+                jsdrv_statistics_from_entry(&s_tmp, src, 1);  // unweighted, all entries equal
+                jsdrv_statistics_combine(&s_accum, &s_accum, &s_tmp);
+            }
+            jsdrv_statistics_to_entry(&s_accum, dst);
+        }
+        if (NULL != self->hist_levels[level]) {
+            hist_merge(self, level, lvl_up_idx, lvl_dn_idx);
+        }
         lvl_up_idx = (lvl_up_idx + 1) % lvl_up->k;
         lvl_dn_idx = (lvl_dn_idx + lvl_up->r) % lvl_dn->k;
         length -= lvl_up->samples_per_entry;
+        if ((NULL != self->trend) && ((level + 1) == self->trend_level)) {
+            trend_append(self, dst, sample_id + length_orig - length);
+        }
     }
-    summarizeN(self, level + 1, start_idx, length_orig);
 }
 
-static void summarize(struct bufsig_s * self, uint64_t start_idx, uint64_t length) {
+// Summarize level 1 for length samples from the level 0 index start_idx, which holds sample_id.
+static void summarize(struct bufsig_s * self, uint64_t start_idx, uint64_t length, uint64_t sample_id) {
     struct bufsig_level_s * lvl1 = &self->levels[0];
     if (NULL == lvl1->data) {
         return;
@@ -229,18 +584,198 @@ static void summarize(struct bufsig_s * self, uint64_t start_idx, uint64_t lengt
     length += (start_idx - level0_idx);
     while (length >= self->r0) {
         struct jsdrv_summary_entry_s * y = level_entry(self, 1, level1_idx);
-        summary_level0_get_by_idx(self, level0_idx, self->r0, y);
+        summary_level0_get_by_idx(self, level0_idx, self->r0, false, y);
+        if (NULL != self->integral_index) {
+            integral_update(self, level1_idx, level0_idx);
+        }
+        if (NULL != self->hist_level1) {
+            hist_update(self, level1_idx, level0_idx);
+        }
         length -= self->r0;
         level1_idx = (level1_idx + 1) % lvl1->k;
         level0_idx = (level0_idx + self->r0) % self->N;
+        if ((NULL != self->trend) && (1 == self->trend_level)) {
+            trend_append(self, y, sample_id + length_orig - length);
+        }
+    }
+}
+
+struct ingest_worker_s {
+    struct bufsig_s * self;
+    uint64_t level1_idx;
+    uint64_t level0_idx;
+    uint64_t count;
+};
+
+// Summarize whole level 1 entries, with each integral_index entry holding only its own sum.
+static void ingest_level1(struct ingest_worker_s * w) {
+    struct bufsig_s * self = w->self;
+    uint64_t level1_idx = w->level1_idx;
+    uint64_t level0_idx = w->level0_idx;
+    for (uint64_t i = 0; i < w->count; ++i) {
+        summary_level0_get_by_idx(self, level0_idx, self->r0, false, level_entry(self, 1, level1_idx));
+        if (NULL != self->integral_index) {
+            struct bufsig_integral_s * e = &self->integral_index[level1_idx];
+            e->end = js220_i128_init_i64(0);
+            e->count_end = 0;
+            level0_f32_sum_i128(self, level0_idx, self->r0, &e->end, &e->count_end);
+        }
+        if (NULL != self->hist_level1) {
+            hist_update(self, level1_idx, level0_idx);
+        }
+        level1_idx = (level1_idx + 1) % self->levels[0].k;
+        level0_idx = (level0_idx + self->r0) % self->N;
+    }
+}
+
+static THREAD_RETURN_TYPE ingest_thread(THREAD_ARG_TYPE arg) {
+    ingest_level1((struct ingest_worker_s *) arg);
+    THREAD_RETURN();
+}
+
+/*
+ * Summarize like summarize() with the level 1 entries split across
+ * up to thread_count threads.  The level 1 entries only read level 0,
+ * so the threads are independent.  The integral prefix sums and the
+ * trend then complete in order on the caller.
+ */
+static void summarize_parallel(struct bufsig_s * self, uint64_t start_idx, uint64_t length, uint64_t sample_id,
+                               uint32_t thread_count) {
+    struct bufsig_level_s * lvl1 = &self->levels[0];
+    if (NULL == lvl1->data) {
+        return;
+    }
+    uint64_t level1_idx = start_idx / self->r0;
+    uint64_t level0_idx = level1_idx * self->r0;
+    uint64_t prefix = start_idx - level0_idx;
+    uint64_t entries = (length + prefix) / self->r0;
+    uint64_t per_thread = (entries + thread_count - 1) / thread_count;
+    if (per_thread < INGEST_ENTRIES_MIN) {
+        per_thread = INGEST_ENTRIES_MIN;
+    }
+    if ((NULL != self->blocks) || (entries <= per_thread)) {
+        summarize(self, start_idx, length, sample_id);
+        return;
+    }
+
+    struct ingest_worker_s workers[JSDRV_BUFSIG_INGEST_THREADS_MAX];
+    jsdrv_thread_t threads[JSDRV_BUFSIG_INGEST_THREADS_MAX];
+    bool started[JSDRV_BUFSIG_INGEST_THREADS_MAX];
+    uint32_t count = 0;
+    for (uint64_t offset = 0; offset < entries; offset += workers[count++].count) {
+        struct ingest_worker_s * w = &workers[count];
+        w->self = self;
+        w->level1_idx = (level1_idx + offset) % lvl1->k;
+        w->level0_idx = (level0_idx + offset * self->r0) % self->N;
+        w->count = ((entries - offset) < per_thread) ? (entries - offset) : per_thread;
+    }
+    for (uint32_t i = 1; i < count; ++i) {
+        started[i] = (0 == jsdrv_thread_create(&threads[i], ingest_thread, &workers[i], 0));
+    }
+    ingest_level1(&workers[0]);
+    for (uint32_t i = 1; i < count; ++i) {
+        if (started[i]) {
+            jsdrv_thread_join(&threads[i], 1000);
+        } else {
+            ingest_level1(&workers[i]);
+        }
+    }
+
+    for (uint64_t i = 0; i < entries; ++i) {
+        uint64_t idx = (level1_idx + i) % lvl1->k;
+        if (NULL != self->integral_index) {
+            struct bufsig_integral_s * e = &self->integral_index[idx];
+            e->start = self->integral_sum;
+            e->count_start = self->integral_count;
+            self->integral_sum = js220_i128_add(self->integral_sum, e->end);
+            self->integral_count += e->count_end;
+            e->end = self->integral_sum;
+            e->count_end = self->integral_count;
+        }
+        if ((NULL != self->trend) && (1 == self->trend_level)) {
+            trend_append(self, level_entry(self, 1, idx), sample_id + (i + 1) * self->r0 - prefix);
+        }
+    }
+}
+
+// Summarize level + 1 for the n samples before level0_head, split at the ring end like ingestion.
+static void summarize_range(struct bufsig_s * self, uint8_t level, uint64_t n, uint32_t thread_count) {
+    uint64_t start_idx = (self->level0_head + self->N - n) % self->N;
+    uint64_t sample_id = self->sample_id_head - n;
+    while (n) {
+        uint64_t k = self->N - start_idx;
+        k = (k > n) ? n : k;
+        if (level) {
+            summarize_level(self, level, start_idx, k, sample_id);
+        } else if (thread_count > 1) {
+            summarize_parallel(self, start_idx, k, sample_id, thread_count);
+        } else {
+            summarize(self, start_idx, k, sample_id);
+        }
+        start_idx = 0;
+        sample_id += k;
+        n -= k;
+    }
+}
+
+static uint64_t summary_dirty_max(struct bufsig_s * self) {
+    uint64_t n = 0;
+    for (int i = 0; i < JSDRV_BUFSIG_LEVELS_MAX; ++i) {
+        n = (self->summary_dirty[i] > n) ? self->summary_dirty[i] : n;
+    }
+    return n;
+}
+
+// Complete the levels through level, in order, from their omitted samples before level0_head.
+static void summary_update_threads(struct bufsig_s * self, uint8_t level, uint32_t thread_count) {
+    for (uint8_t i = 0; (i < level) && (i < JSDRV_BUFSIG_LEVELS_MAX); ++i) {
+        uint64_t n = self->summary_dirty[i];
+        if (0 == n) {
+            continue;
+        }
+        self->summary_dirty[i] = 0;
+        summarize_range(self, i, n, thread_count);
+    }
+}
+
+static void summary_update(struct bufsig_s * self, uint8_t level) {
+    summary_update_threads(self, level, 1);
+}
+
+// Record n samples ending at level0_head which the levels from levels[first] do not yet include.
+static void summary_defer(struct bufsig_s * self, uint8_t first, uint64_t n) {
+    for (int i = first; (i < JSDRV_BUFSIG_LEVELS_MAX) && (NULL != self->levels[i].data); ++i) {
+        self->summary_dirty[i] += n;
+    }
+}
+
+// Complete the lazy levels before n more samples would overwrite the lower level entries they combine.
+static void summary_reserve(struct bufsig_s * self, uint64_t n) {
+    if ((summary_dirty_max(self) + n) > (self->N / SUMMARY_DIRTY_DIV)) {
+        summary_update(self, JSDRV_BUFSIG_LEVELS_MAX);
     }
+}
+
+void jsdrv_bufsig_summary_update(struct bufsig_s * self, uint8_t level) {
+    summary_update(self, level);
+}
 
-    summarizeN(self, 1, start_idx, length_orig);
+bool jsdrv_bufsig_summary_pending(struct bufsig_s * self) {
+    return 0 != summary_dirty_max(self);
 }
 
 static void clear(struct bufsig_s * self, uint64_t sample_id) {
+    if (NULL != self->trend) {
+        summary_update(self, self->trend_level);  // the trend persists across discontinuities
+    }
+    memset(self->summary_dirty, 0, sizeof(self->summary_dirty));
+    ++self->generation;
+    if (NULL != self->blocks) {
+        blocks_reset(self);
+    }
     self->level0_head = 0;
     self->level0_size = 0;
+    self->gap_count = 0;
     self->sample_id_head = sample_id;
     self->time_map.offset_counter = sample_id;
     self->time_map.offset_time = jsdrv_time_utc();
@@ -248,9 +783,296 @@ static void clear(struct bufsig_s * self, uint64_t sample_id) {
 
 void jsdrv_bufsig_clear(struct bufsig_s * self) {
     clear(self, 0);
+    self->trend_head = 0;
+    self->trend_size = 0;
+    self->trend_sample_id = 0;
 }
 
-void jsdrv_bufsig_recv_data(struct bufsig_s * self, struct jsdrv_stream_signal_s * s) {
+void jsdrv_bufsig_freeze(struct bufsig_s * self, struct bufsig_s * frozen) {
+    summary_update(self, JSDRV_BUFSIG_LEVELS_MAX);
+    struct bufsig_s spare = *frozen;
+    *frozen = *self;
+    *self = spare;
+    bool reuse = (NULL != spare.level0_data)
+            && (spare.N == frozen->N) && (spare.r0 == frozen->r0) && (spare.rN == frozen->rN)
+            && ((NULL == spare.blocks) == (NULL == frozen->blocks))
+            && ((NULL == spare.integral_index) == (NULL == frozen->integral_index))
+            && ((NULL == spare.hist_level1) == (NULL == frozen->hist_level1))
+            && (spare.tile_count == frozen->tile_count)
+            && (spare.trend_k == frozen->trend_k) && (spare.trend_spe == frozen->trend_spe)
+            && ((NULL == spare.trend) == (NULL == frozen->trend))
+            && (spare.hdr.element_type == frozen->hdr.element_type)
+            && (spare.hdr.element_size_bits == frozen->hdr.element_size_bits)
+            && (spare.hdr.sample_rate == frozen->hdr.sample_rate)
+            && (spare.hdr.decimate_factor == frozen->hdr.decimate_factor);
+    if (!reuse) {
+        jsdrv_bufsig_free(self);
+    }
+
+    // the live configuration
+    self->idx = frozen->idx;
+    self->active = frozen->active;
+    memcpy(self->topic, frozen->topic, sizeof(self->topic));
+    self->parent = frozen->parent;
+    self->hdr = frozen->hdr;
+    self->storage_dir = frozen->storage_dir;
+    self->mem_flags = frozen->mem_flags;
+    self->numa_node = frozen->numa_node;
+    self->codec = frozen->codec;
+    self->level0_budget = frozen->level0_budget;
+    self->integral = frozen->integral;
+    self->histogram = frozen->histogram;
+    self->trend_level = frozen->trend_level;
+    self->trend_k = frozen->trend_k;
+    self->tile_count = frozen->tile_count;
+    self->generation = frozen->generation + 1;
+    if (!reuse) {
+        jsdrv_bufsig_alloc(self, frozen->N, frozen->r0, frozen->rN);
+    }
+    self->block_cache_seq = 0;
+    self->time_map = frozen->time_map;
+    clear(self, frozen->sample_id_head);
+    self->trend_head = 0;
+    self->trend_size = 0;
+    self->trend_sample_id = 0;
+}
+
+void jsdrv_bufsig_replace(struct bufsig_s * self, struct bufsig_s * other) {
+    struct bufsig_s prev = *self;
+    *self = *other;
+    *other = prev;
+
+    // the live identity
+    self->idx = prev.idx;
+    self->active = prev.active;
+    memcpy(self->topic, prev.topic, sizeof(self->topic));
+    self->parent = prev.parent;
+    self->storage_dir = prev.storage_dir;
+    self->generation = prev.generation + 1;
+}
+
+// Discard the gaps before the tail after k more samples at sample_id_head.
+static void gaps_trim(struct bufsig_s * self, uint64_t k) {
+    uint64_t size = self->level0_size + k;
+    if (size > self->N) {
+        size = self->N;
+    }
+    uint64_t sample_id_tail = self->sample_id_head + k - size;
+    uint32_t count = 0;
+    while ((count < self->gap_count) && (self->gaps[count].end <= sample_id_tail)) {
+        ++count;
+    }
+    if (count) {
+        self->gap_count -= count;
+        memmove(self->gaps, self->gaps + count, self->gap_count * sizeof(self->gaps[0]));
+    }
+    if (self->gap_count && (self->gaps[0].start < sample_id_tail)) {
+        self->gaps[0].start = sample_id_tail;
+    }
+}
+
+static void gap_fill_alloc(struct bufsig_s * self) {
+    if (NULL == self->gap_fill) {
+        self->gap_fill = jsdrv_alloc_cat(JSDRV_BUFSIG_GAP_FILL * sizeof(float), JSDRV_ALLOC_CAT_BUFFER);
+        if (JSDRV_DATA_TYPE_FLOAT == self->hdr.element_type) {
+            float * f32 = (float *) self->gap_fill;
+            for (uint32_t i = 0; i < JSDRV_BUFSIG_GAP_FILL; ++i) {
+                f32[i] = NAN;
+            }
+        } else {
+            memset(self->gap_fill, 0, JSDRV_BUFSIG_GAP_FILL * sizeof(float));
+        }
+    }
+}
+
+// Record the k missing samples at sample_id_head, and return false when the gap list is full.
+static bool gap_add(struct bufsig_s * self, uint64_t k) {
+    if (self->gap_count >= JSDRV_BUFSIG_GAP_MAX) {
+        gaps_trim(self, 0);
+        if (self->gap_count >= JSDRV_BUFSIG_GAP_MAX) {
+            return false;
+        }
+    }
+    gap_fill_alloc(self);
+    struct bufsig_gap_s * g = &self->gaps[self->gap_count++];
+    g->start = self->sample_id_head;
+    g->end = self->sample_id_head + k;
+    return true;
+}
+
+// Account for k samples written at level0_head, which must not cross the level0_head_block() end.
+static void level0_advance(struct bufsig_s * self, uint64_t k, uint32_t thread_count) {
+    uint64_t head = self->level0_head;
+    summary_reserve(self, k);
+    if (self->gap_count) {
+        gaps_trim(self, k);  // before summarize reads the overwritten samples
+    }
+    self->level0_head = (head + k) % self->N;
+    self->sample_id_head += k;
+    summary_defer(self, 0, k);
+    if ((NULL != self->blocks) || (thread_count > 1) || (self->summary_dirty[0] >= JSDRV_BUFSIG_SUMMARY_BATCH)) {
+        summary_update_threads(self, 1, thread_count);  // before closing the open block
+    }
+    if (NULL != self->blocks) {
+        if (0 == (self->level0_head % JSDRV_BUFSIG_BLOCK_SAMPLES)) {
+            block_close(self, head / JSDRV_BUFSIG_BLOCK_SAMPLES);
+        }
+        self->level0_size = blocks_level0_size(self);
+    } else {
+        self->level0_size += k;
+        if (self->level0_size > self->N) {
+            self->level0_size = self->N;
+        }
+    }
+}
+
+// Fill k skipped samples: NaN for float, 0 for integer types.
+static void level0_fill(struct bufsig_s * self, uint64_t k) {
+    while (k) {
+        uint64_t base;
+        uint64_t end;
+        uint8_t * dst = level0_head_block(self, &base, &end);
+        uint64_t local = self->level0_head - base;
+        uint64_t n = end - self->level0_head;
+        if (n > k) {
+            n = k;
+        }
+        if (JSDRV_DATA_TYPE_FLOAT == self->hdr.element_type) {
+            float * f32 = ((float *) dst) + local;
+            for (uint64_t i = 0; i < n; ++i) {
+                f32[i] = NAN;
+            }
+        } else {
+            uint64_t byte_start = (local * self->hdr.element_size_bits) / 8;
+            uint64_t byte_end = ((local + n) * self->hdr.element_size_bits + 7) / 8;
+            memset(dst + byte_start, 0, byte_end - byte_start);
+        }
+        level0_advance(self, n, 1);
+        k -= n;
+    }
+}
+
+// Account for n missing samples at the r0 aligned level0_head as missing level 1 entries.
+static void level0_skip(struct bufsig_s * self, uint64_t n) {
+    uint64_t head = self->level0_head;
+    uint64_t level1_idx = head / self->r0;
+    summary_reserve(self, n);
+    summary_update(self, 1);  // the integral index continues in order
+    gaps_trim(self, n);
+    for (uint64_t i = 0; i < (n / self->r0); ++i, ++level1_idx) {
+        entry_clear(level_entry(self, 1, level1_idx));
+        if (NULL != self->integral_index) {
+            struct bufsig_integral_s * e = &self->integral_index[level1_idx];
+            e->start = self->integral_sum;
+            e->end = self->integral_sum;
+            e->count_start = self->integral_count;
+            e->count_end = self->integral_count;
+        }
+        if (NULL != self->hist_level1) {
+            memset(&self->hist_level1[level1_idx * JSDRV_BUFSIG_HIST_BINS], 0,
+                   JSDRV_BUFSIG_HIST_BINS * sizeof(uint16_t));
+        }
+    }
+    self->level0_head = (head + n) % self->N;
+    summary_defer(self, 1, n);
+    self->level0_size += n;
+    if (self->level0_size > self->N) {
+        self->level0_size = self->N;
+    }
+    self->sample_id_head += n;
+}
+
+/*
+ * Record k skipped samples as a gap.
+ *
+ * Raw level 0 only fills the partial level 1 entries at each end.
+ * The whole entries are neither written nor summarized, and level 0
+ * reads return gap_fill for them.  Compressed level 0 fills the gap
+ * so that the blocks encode well.
+ */
+static void level0_gap(struct bufsig_s * self, uint64_t k) {
+    struct bufsig_level_s * lvl1 = &self->levels[0];
+    if (!gap_add(self, k) || (NULL != self->blocks) || (NULL == lvl1->data)) {
+        level0_fill(self, k);
+        return;
+    }
+    while (k) {
+        uint64_t head = self->level0_head;
+        uint64_t level1_idx = head / self->r0;
+        uint64_t n = 0;
+        if ((0 == (head % self->r0)) && (level1_idx < lvl1->k)) {
+            uint64_t entries = k / self->r0;
+            uint64_t entries_max = (self->N - head) / self->r0;  // until the ring wraps
+            if (entries_max > (lvl1->k - level1_idx)) {
+                entries_max = lvl1->k - level1_idx;
+            }
+            if (entries > entries_max) {
+                entries = entries_max;
+            }
+            n = entries * self->r0;
+        }
+        if (n) {
+            level0_skip(self, n);
+        } else {
+            n = self->r0 - (head % self->r0);
+            if (n > k) {
+                n = k;
+            }
+            level0_fill(self, n);
+        }
+        k -= n;
+    }
+}
+
+// Fill k samples of integer types with value, which preserves the prior samples in a partial byte.
+static void level0_fill_value(struct bufsig_s * self, uint64_t k, uint32_t value) {
+    uint32_t bits = self->hdr.element_size_bits;
+    while (k) {
+        uint64_t base;
+        uint64_t end;
+        uint8_t * dst = level0_head_block(self, &base, &end);
+        uint64_t local = self->level0_head - base;
+        uint64_t n = end - self->level0_head;
+        if (n > k) {
+            n = k;
+        }
+        if (JSDRV_DATA_TYPE_FLOAT == self->hdr.element_type) {
+            float * f32 = ((float *) dst) + local;
+            for (uint64_t i = 0; i < n; ++i) {
+                f32[i] = (float) value;
+            }
+        } else if (bits >= 8) {
+            uint32_t sz = bits / 8;
+            uint8_t * p = dst + local * sz;
+            for (uint64_t i = 0; i < n; ++i) {
+                for (uint32_t j = 0; j < sz; ++j) {
+                    *p++ = (j < sizeof(value)) ? (uint8_t) (value >> (8 * j)) : 0;
+                }
+            }
+        } else {
+            uint32_t mask = (1U << bits) - 1;
+            uint32_t per_byte = 8 / bits;
+            uint64_t idx = local;
+            uint64_t idx_end = local + n;
+            value &= mask;
+            for (; (idx < idx_end) && (idx % per_byte); ++idx) {
+                uint32_t shift = (uint32_t) ((idx % per_byte) * bits);
+                dst[idx / per_byte] = (uint8_t) ((dst[idx / per_byte] & ~(mask << shift)) | (value << shift));
+            }
+            uint64_t bytes = (idx_end - idx) / per_byte;
+            memset(dst + idx / per_byte, (int) (value * (0xffU / mask)), bytes);
+            for (idx += bytes * per_byte; idx < idx_end; ++idx) {
+                uint32_t shift = (uint32_t) ((idx % per_byte) * bits);
+                dst[idx / per_byte] = (uint8_t) ((dst[idx / per_byte] & ~(mask << shift)) | (value << shift));
+            }
+        }
+        level0_advance(self, n, 1);
+        k -= n;
+    }
+}
+
+// Synchronize to a received message, and return true to store its samples at sample_id_head.
+static bool recv_start(struct bufsig_s * self, struct jsdrv_stream_signal_s * s) {
     self->hdr.sample_id = s->sample_id;
     self->hdr.field_id = s->field_id;
     self->hdr.index = s->index;
@@ -260,13 +1082,11 @@ void jsdrv_bufsig_recv_data(struct bufsig_s * self, struct jsdrv_stream_signal_s
     self->hdr.sample_rate = s->sample_rate;
     self->hdr.decimate_factor = s->decimate_factor;
 
-    if (NULL == self->level0_data) {
-        return;
+    if ((NULL == self->level0_data) || (0 == s->element_count)) {
+        return false;
     }
 
     uint64_t length = s->element_count;
-    uint8_t * f_src =  s->data;
-    uint8_t * f_dst = (uint8_t *) self->level0_data;
     uint64_t sample_id = s->sample_id / self->hdr.decimate_factor;
     uint64_t sample_id_end = sample_id + length - 1;
     uint64_t sample_id_expect = self->sample_id_head;
@@ -277,67 +1097,24 @@ void jsdrv_bufsig_recv_data(struct bufsig_s * self, struct jsdrv_stream_signal_s
                    s->sample_id, sample_id, s->sample_rate, s->decimate_factor);
         clear(self, sample_id);
     } else if (sample_id_end < sample_id_expect) {
-        JSDRV_LOGI("bufsig_recv_data %s: duplicate rcv=[%" PRIu64 ", %" PRIu64 "] expect=%" PRIu64,
-                   self->topic, sample_id, sample_id_end, sample_id_expect);
+        JSDRV_LOGI_RATE("bufsig_recv_data %s: duplicate rcv=[%" PRIu64 ", %" PRIu64 "] expect=%" PRIu64,
+                        self->topic, sample_id, sample_id_end, sample_id_expect);
         if ((sample_id_expect - sample_id_end) < self->N) {
             clear(self, sample_id);
         }
-        return;
+        return false;
     } else if (sample_id < sample_id_expect) {
-        JSDRV_LOGI("bufsig_recv_data %s: overlap rcv=[%" PRIu64 ", %" PRIu64 "] expect=%" PRIu64,
-                   self->topic, sample_id, sample_id_end, sample_id_expect);
-        return;
+        JSDRV_LOGI_RATE("bufsig_recv_data %s: overlap rcv=[%" PRIu64 ", %" PRIu64 "] expect=%" PRIu64,
+                        self->topic, sample_id, sample_id_end, sample_id_expect);
+        return false;
     } else if (sample_id > sample_id_expect) {
-        JSDRV_LOGI("bufsig_recv_data %s: skip rcv=[%" PRIu64 ", %" PRIu64 "] expect=%" PRIu64,
-                   self->topic, sample_id, sample_id_end, sample_id_expect);
+        JSDRV_LOGI_RATE("bufsig_recv_data %s: skip rcv=[%" PRIu64 ", %" PRIu64 "] expect=%" PRIu64,
+                        self->topic, sample_id, sample_id_end, sample_id_expect);
         uint64_t k = sample_id - sample_id_expect;
         if (k > self->N) {
             clear(self, sample_id);
         } else {
-            if (s->element_type == JSDRV_DATA_TYPE_FLOAT) {
-                if (s->element_size_bits == 32) {
-                    // fill float32 with NaN
-                    uint64_t idx = self->level0_head;
-                    float *f32 = (float *) self->level0_data;
-                    for (uint64_t i = 0; i < k; ++i) {
-                        if (idx >= self->N) {
-                            idx = idx % self->N;
-                        }
-                        f32[idx] = NAN;
-                        ++idx;
-                    }
-                } else if (s->element_size_bits == 64) {
-                    // fill float64 with NaN
-                    uint64_t idx = self->level0_head;
-                    double *f64 = (double *) self->level0_data;
-                    for (uint64_t i = 0; i < k; ++i) {
-                        if (idx >= self->N) {
-                            idx = idx % self->N;
-                        }
-                        f64[idx] = NAN;
-                        ++idx;
-                    }
-                }
-            } else {
-                // fill integer types with zeros
-                uint64_t size = (k * s->element_size_bits + 7) / 8;
-                uint64_t head = (self->level0_head * self->hdr.element_size_bits) / 8;
-                if ((self->level0_head + size) > self->N) {
-                    uint64_t size1 = (self->N * s->element_size_bits) / 8 - head;
-                    uint64_t size2 = size - size1;
-                    memset(&f_dst[head], 0, size1);
-                    memset(&f_dst[0], 0, size2);
-                } else {
-                    memset(&f_dst[head], 0, size);
-                }
-            }
-            uint64_t start_idx = self->level0_head;
-            self->level0_size += k;
-            if (self->level0_size > self->N) {
-                self->level0_size = self->N;
-            }
-            self->level0_head = (self->level0_head + k) % self->N;
-            summarize(self, start_idx, k);
+            level0_gap(self, k);
         }
     } else {
         //JSDRV_LOGI("bufsig_recv_data %s: good rcv=[%" PRIu64 ", %" PRIu64 "] expect=%" PRIu64,
@@ -347,38 +1124,106 @@ void jsdrv_bufsig_recv_data(struct bufsig_s * self, struct jsdrv_stream_signal_s
     self->time_map.offset_time = s->time_map.offset_time;
     self->time_map.offset_counter = s->time_map.offset_counter / s->decimate_factor;
     self->time_map.counter_rate = s->time_map.counter_rate / s->decimate_factor;
-
-    // JSDRV_LOGI("bufsig_recv_data: sample_id=%" PRIu64 " length=%" PRIu64, s->sample_id, length);
     self->sample_id_head = sample_id;
+    return true;
+}
+
+// Write length samples at level0_head.
+static void level0_write(struct bufsig_s * self, const uint8_t * f_src, uint64_t length, uint32_t thread_count) {
     while (length) {
+        uint64_t base;
+        uint64_t end;
+        uint8_t * f_dst = level0_head_block(self, &base, &end);
         uint64_t head = self->level0_head;
-        uint64_t k = length;
-        uint64_t head_next = head + length;
-        if (head_next > self->N) {
-            k = self->N - head;
-            head_next = 0;
+        uint64_t k = end - head;
+        if (k > length) {
+            k = length;
         }
         uint64_t copy_size = (k * self->hdr.element_size_bits + 7) / 8;
-        memcpy(&f_dst[(head * self->hdr.element_size_bits) / 8], f_src, copy_size);
-        self->level0_size += k;
-        if (self->level0_size > self->N) {
-            self->level0_size = self->N;
-        }
+        memcpy(&f_dst[((head - base) * self->hdr.element_size_bits) / 8], f_src, copy_size);
         f_src += copy_size;
         length -= k;
-        self->level0_head = head_next;
-        self->sample_id_head += k;
-        sample_id += k;
-        summarize(self, head, k);
+        level0_advance(self, k, thread_count);
     }
 }
 
-static uint64_t level0_tail(struct bufsig_s * self) {
-    if (self->level0_size != self->N) {
+void jsdrv_bufsig_recv_data(struct bufsig_s * self, struct jsdrv_stream_signal_s * s) {
+    if (!recv_start(self, s)) {
+        return;
+    }
+    // JSDRV_LOGI("bufsig_recv_data: sample_id=%" PRIu64 " length=%" PRIu64, s->sample_id, length);
+    level0_write(self, s->data, s->element_count, 1);
+}
+
+int32_t jsdrv_bufsig_ingest(struct bufsig_s * self, uint64_t sample_id, const void * data, uint64_t length,
+                            uint32_t thread_count) {
+    if (NULL == self->level0_data) {
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    if ((NULL == data) && length) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (0 == length) {
         return 0;
-    } else {
-        return self->level0_head;
     }
+    if (0 == thread_count) {
+        thread_count = 1;
+    } else if (thread_count > JSDRV_BUFSIG_INGEST_THREADS_MAX) {
+        thread_count = JSDRV_BUFSIG_INGEST_THREADS_MAX;
+    }
+    const uint8_t * src = (const uint8_t *) data;
+    uint64_t skip = (length > self->N) ? (((length - self->N) / 8) * 8) : 0;  // whole bytes for packed types
+    if (skip) {
+        src += (skip * self->hdr.element_size_bits) / 8;
+        sample_id += skip;
+        length -= skip;
+        clear(self, sample_id);  // the ring only holds the newest samples
+    } else if (0 == self->sample_id_head) {
+        clear(self, sample_id);
+    } else if (sample_id < self->sample_id_head) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    } else if (sample_id > self->sample_id_head) {
+        uint64_t k = sample_id - self->sample_id_head;
+        if (k > self->N) {
+            clear(self, sample_id);
+        } else {
+            level0_gap(self, k);
+        }
+    }
+    level0_write(self, src, length, thread_count);
+    return 0;
+}
+
+void jsdrv_bufsig_recv_events(struct bufsig_s * self, struct jsdrv_stream_signal_s * s, uint32_t event_count) {
+    if (!recv_start(self, s)) {
+        return;
+    }
+    const struct jsdrv_stream_event_s * events = (const struct jsdrv_stream_event_s *) s->data;
+    uint64_t length = s->element_count;
+    uint64_t offset = 0;
+    uint32_t value = 0;  // before the first event, which normally has offset 0
+    for (uint32_t idx = 0; offset < length; ++idx) {
+        uint64_t offset_next = (idx < event_count) ? events[idx].offset : length;
+        if (offset_next > length) {
+            offset_next = length;
+        }
+        if (offset_next > offset) {
+            level0_fill_value(self, offset_next - offset, value);
+            offset = offset_next;
+        }
+        if (idx < event_count) {
+            value = events[idx].value;
+        }
+    }
+}
+
+static uint64_t level0_tail(struct bufsig_s * self) {
+    return (self->level0_head + self->N - self->level0_size) % self->N;
+}
+
+// Get the sample id of the oldest trend entry.
+static uint64_t trend_tail(struct bufsig_s * self) {
+    return self->trend_sample_id - self->trend_size * self->trend_spe;
 }
 
 static void rsp_empty(struct jsdrv_buffer_response_s * rsp) {
@@ -390,12 +1235,346 @@ static void rsp_empty(struct jsdrv_buffer_response_s * rsp) {
     rsp->info.time_range_utc.length = 0;
 }
 
-static void samples_get(struct bufsig_s * self, struct jsdrv_buffer_response_s * rsp) {
+// Overwrite the missing samples in dst, which holds the packed samples starting at sample_id.
+static void gaps_apply(struct bufsig_s * self, uint64_t sample_id, uint64_t length, uint8_t * dst) {
+    uint32_t bits = self->hdr.element_size_bits;
+    uint64_t sample_id_end = sample_id + length;
+    for (uint32_t i = 0; i < self->gap_count; ++i) {
+        uint64_t start = self->gaps[i].start;
+        uint64_t end = self->gaps[i].end;
+        if (start < sample_id) {
+            start = sample_id;
+        }
+        if (end > sample_id_end) {
+            end = sample_id_end;
+        }
+        if (start >= end) {
+            continue;
+        }
+        start -= sample_id;
+        end -= sample_id;
+        if (JSDRV_DATA_TYPE_FLOAT == self->hdr.element_type) {
+            float * f32 = (float *) dst;
+            for (uint64_t j = start; j < end; ++j) {
+                f32[j] = NAN;
+            }
+        } else {
+            uint64_t bit = start * bits;
+            uint64_t bit_end = end * bits;
+            for (; (bit < bit_end) && (bit & 7); bit += bits) {
+                dst[bit >> 3] &= (uint8_t) ~(((1U << bits) - 1) << (bit & 7));
+            }
+            uint64_t bytes = (bit_end - bit) >> 3;
+            memset(dst + (bit >> 3), 0, bytes);
+            for (bit += bytes * 8; bit < bit_end; bit += bits) {
+                dst[bit >> 3] &= (uint8_t) ~(((1U << bits) - 1) << (bit & 7));
+            }
+        }
+    }
+}
+
+// Copy length samples starting at sample_id to dst, which must be 8-byte aligned with JSDRV_BUFSIG_RSP_SLACK.
+static void level0_copy(struct bufsig_s * self, uint64_t sample_id, uint64_t length, uint8_t * dst) {
+    uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
+    uint64_t idx = (sample_id - sample_id_tail + level0_tail(self)) % self->N;
+    uint64_t length_total = length;
+
+    uint8_t shift = 0;
+    if (1 == self->hdr.element_size_bits) {
+        shift = idx & 7;
+    } else if (4 == self->hdr.element_size_bits) {
+        shift = (idx & 1) << 2;
+    }
+
+    uint8_t * p_dst = dst;
+    while (length) {
+        uint64_t base;
+        uint64_t end;
+        const uint8_t * data_buf = level0_block_stored(self, idx, &base, &end);  // gaps applied below
+        uint64_t k = end - idx;
+        if (k > length) {
+            k = length;
+        }
+        uint64_t local = idx - base;
+        uint64_t byte_start = (local * self->hdr.element_size_bits) / 8;
+        uint64_t byte_end = ((local + k) * self->hdr.element_size_bits + 7) / 8;
+        memcpy(p_dst, &data_buf[byte_start], byte_end - byte_start);
+        p_dst += byte_end - byte_start;
+        length -= k;
+        idx = (idx + k) % self->N;
+    }
+
+    if (shift) {
+        uint64_t u64_length = (length_total * self->hdr.element_size_bits + shift + 63) / 64;
+        uint8_t shift_left = 64 - shift;
+        uint64_t * p = (uint64_t *) dst;
+        uint64_t fwd = p[0];
+        for (uint64_t i = 1; i < u64_length; ++i) {
+            uint64_t z = p[i];
+            p[i - 1] = (fwd >> shift) | (z << shift_left);
+            fwd = z;
+        }
+        p[u64_length - 1] = fwd >> shift;
+    }
+    if (self->gap_count) {
+        gaps_apply(self, sample_id, length_total, dst);
+    }
+}
+
+// Copy the src trend entries that end at or before sample_id.
+static void trend_copy(struct bufsig_s * self, struct bufsig_s * src, uint64_t sample_id) {
+    if ((NULL == self->trend) || (0 == src->trend_size) || (self->trend_spe != src->trend_spe)) {
+        return;
+    }
+    summary_update(src, src->trend_level);
+    uint64_t t_start = trend_tail(src);
+    uint64_t n = (sample_id > t_start) ? ((sample_id - t_start) / src->trend_spe) : 0;
+    n = (n > src->trend_size) ? src->trend_size : n;
+    uint64_t skip = (n > self->trend_k) ? (n - self->trend_k) : 0;
+    uint64_t idx = (src->trend_head + src->trend_k - src->trend_size + skip) % src->trend_k;
+    for (uint64_t i = skip; i < n; ++i) {
+        self->trend[i - skip] = src->trend[idx];
+        idx = (idx + 1) % src->trend_k;
+    }
+    self->trend_size = n - skip;
+    self->trend_head = self->trend_size % self->trend_k;
+    self->trend_sample_id = t_start + n * src->trend_spe;
+}
+
+bool jsdrv_bufsig_copy(struct bufsig_s * self, struct bufsig_s * src, uint64_t sample_id_end) {
+    uint64_t src_tail = src->sample_id_head - src->level0_size;
+    uint64_t sample_id;
+    if (sample_id_end > src->sample_id_head) {
+        sample_id_end = src->sample_id_head;
+    }
+    if (self->level0_size) {
+        sample_id = self->sample_id_head;
+        if (sample_id < src_tail) {
+            return false;
+        }
+    } else {
+        sample_id = (sample_id_end > self->N) ? (sample_id_end - self->N) : 0;
+        if (sample_id < src_tail) {
+            sample_id = src_tail;
+        }
+        // keep the sub-byte sample positions of src, which ingestion assumes
+        uint64_t src_offset = src->sample_id_head - src->level0_head;
+        sample_id += (src_offset - sample_id) & 7;
+        trend_copy(self, src, sample_id);
+    }
+    if ((0 == src->level0_size) || (sample_id >= sample_id_end)) {
+        return true;
+    }
+
+    uint32_t bits = src->hdr.element_size_bits;
+    uint32_t decimate_factor = src->hdr.decimate_factor;
+    uint64_t chunk = ((JSDRV_STREAM_DATA_SIZE * 8ULL) / bits) & ~63ULL;
+    struct jsdrv_stream_signal_s * s = jsdrv_alloc_cat(sizeof(struct jsdrv_stream_signal_s) + JSDRV_BUFSIG_RSP_SLACK, JSDRV_ALLOC_CAT_BUFFER);
+    s->field_id = src->hdr.field_id;
+    s->index = src->hdr.index;
+    s->element_type = src->hdr.element_type;
+    s->element_size_bits = src->hdr.element_size_bits;
+    s->sample_rate = src->hdr.sample_rate;
+    s->decimate_factor = decimate_factor;
+    s->time_map.offset_time = src->time_map.offset_time;
+    s->time_map.offset_counter = src->time_map.offset_counter * decimate_factor;
+    s->time_map.counter_rate = src->time_map.counter_rate * decimate_factor;
+    while (sample_id < sample_id_end) {
+        uint64_t length = sample_id_end - sample_id;
+        if (length > chunk) {
+            length = chunk;
+        }
+        level0_copy(src, sample_id, length, s->data);
+        s->sample_id = sample_id * decimate_factor;
+        s->element_count = (uint32_t) length;
+        jsdrv_bufsig_recv_data(self, s);
+        sample_id += length;
+    }
+    jsdrv_free(s);
+    return true;
+}
+
+#define BUFSIG_FILE_MAGIC (0x474953465542534ALLU)  // "JSBUFSIG" little endian
+
+// The jsdrv_bufsig_save() record, followed by the arrays.
+struct bufsig_file_s {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t size;                  // sizeof(struct bufsig_file_s)
+    uint32_t idx;
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    struct bufsig_stream_header_s hdr;
+    struct jsdrv_time_map_s time_map;
+    int64_t size_in_utc;
+    uint64_t N;
+    uint64_t r0;
+    uint64_t rN;
+    uint64_t level0_head;
+    uint64_t level0_size;
+    uint64_t sample_id_head;
+    uint8_t integral;               // the arrays are present
+    uint8_t histogram;
+    uint8_t trend_level;
+    uint8_t rsv_u8;
+    uint32_t gap_count;
+    struct bufsig_gap_s gaps[JSDRV_BUFSIG_GAP_MAX];
+    js220_i128 integral_sum;
+    uint64_t integral_count;
+    uint64_t trend_k;
+    uint64_t trend_head;
+    uint64_t trend_size;
+    uint64_t trend_sample_id;
+};
+
+// The summary arrays in file order, and return the count.
+static uint32_t file_arrays(struct bufsig_s * self, void ** ptrs, size_t * sizes) {
+    uint32_t count = 0;
+    ptrs[count] = self->level0_data;
+    sizes[count++] = level0_bytes(self);
+    for (int i = 0; (i < JSDRV_BUFSIG_LEVELS_MAX) && (NULL != self->levels[i].data); ++i) {
+        ptrs[count] = self->levels[i].data;
+        sizes[count++] = self->levels[i].k * sizeof(struct jsdrv_summary_entry_s);
+    }
+    if (NULL != self->integral_index) {
+        ptrs[count] = self->integral_index;
+        sizes[count++] = self->levels[0].k * sizeof(struct bufsig_integral_s);
+    }
+    if (NULL != self->hist_level1) {
+        ptrs[count] = self->hist_level1;
+        sizes[count++] = self->levels[0].k * JSDRV_BUFSIG_HIST_BINS * sizeof(uint16_t);
+        for (int i = 1; (i < JSDRV_BUFSIG_LEVELS_MAX) && (NULL != self->hist_levels[i]); ++i) {
+            ptrs[count] = self->hist_levels[i];
+            sizes[count++] = self->levels[i].k * JSDRV_BUFSIG_HIST_BINS * sizeof(uint32_t);
+        }
+    }
+    if (NULL != self->trend) {
+        ptrs[count] = self->trend;
+        sizes[count++] = self->trend_k * sizeof(struct jsdrv_summary_entry_s);
+    }
+    return count;
+}
+
+static bool hdr_format_valid(const struct bufsig_stream_header_s * hdr) {
+    if (JSDRV_DATA_TYPE_FLOAT == hdr->element_type) {
+        return 32 == hdr->element_size_bits;
+    }
+    return (JSDRV_DATA_TYPE_UINT == hdr->element_type)
+        && ((1 == hdr->element_size_bits) || (4 == hdr->element_size_bits));
+}
+
+#define FILE_ARRAYS_MAX (2 + 2 * JSDRV_BUFSIG_LEVELS_MAX + 1)
+
+int32_t jsdrv_bufsig_save(struct bufsig_s * self, FILE * f) {
+    if ((NULL == self->level0_data) || (NULL != self->blocks)) {
+        return JSDRV_ERROR_NOT_SUPPORTED;
+    }
+    summary_update(self, JSDRV_BUFSIG_LEVELS_MAX);
+    struct bufsig_file_s * h = jsdrv_alloc_clr_cat(sizeof(struct bufsig_file_s), JSDRV_ALLOC_CAT_BUFFER);
+    h->magic = BUFSIG_FILE_MAGIC;
+    h->version = JSDRV_BUFSIG_FILE_VERSION;
+    h->size = sizeof(*h);
+    h->idx = self->idx;
+    memcpy(h->topic, self->topic, sizeof(h->topic));
+    h->hdr = self->hdr;
+    h->time_map = self->time_map;
+    h->size_in_utc = self->size_in_utc;
+    h->N = self->N;
+    h->r0 = self->r0;
+    h->rN = self->rN;
+    h->level0_head = self->level0_head;
+    h->level0_size = self->level0_size;
+    h->sample_id_head = self->sample_id_head;
+    h->integral = (NULL != self->integral_index) ? 1 : 0;
+    h->histogram = (NULL != self->hist_level1) ? 1 : 0;
+    h->trend_level = (NULL != self->trend) ? self->trend_level : 0;
+    h->gap_count = self->gap_count;
+    memcpy(h->gaps, self->gaps, sizeof(h->gaps));
+    h->integral_sum = self->integral_sum;
+    h->integral_count = self->integral_count;
+    h->trend_k = h->trend_level ? self->trend_k : 0;
+    h->trend_head = self->trend_head;
+    h->trend_size = self->trend_size;
+    h->trend_sample_id = self->trend_sample_id;
+    bool ok = (1 == fwrite(h, sizeof(*h), 1, f));
+    jsdrv_free(h);
+
+    void * ptrs[FILE_ARRAYS_MAX];
+    size_t sizes[FILE_ARRAYS_MAX];
+    uint32_t count = file_arrays(self, ptrs, sizes);
+    for (uint32_t i = 0; ok && (i < count); ++i) {
+        ok = (sizes[i] == fwrite(ptrs[i], 1, sizes[i], f));
+    }
+    return ok ? 0 : JSDRV_ERROR_IO;
+}
+
+int32_t jsdrv_bufsig_load(struct bufsig_s * self, FILE * f, uint32_t * idx) {
+    int32_t rc = 0;
+    struct bufsig_file_s * h = jsdrv_alloc_clr_cat(sizeof(struct bufsig_file_s), JSDRV_ALLOC_CAT_BUFFER);
+    if (1 != fread(h, sizeof(*h), 1, f)) {
+        rc = JSDRV_ERROR_IO;
+    } else if ((BUFSIG_FILE_MAGIC != h->magic) || (JSDRV_BUFSIG_FILE_VERSION != h->version)
+            || (sizeof(*h) != h->size) || (0 == h->N) || (0 == h->r0) || (0 == h->rN)
+            || (0 == h->hdr.decimate_factor) || !hdr_format_valid(&h->hdr)
+            || (h->level0_head >= h->N) || (h->level0_size > h->N) || (h->gap_count > JSDRV_BUFSIG_GAP_MAX)
+            || (h->trend_level > JSDRV_BUFSIG_LEVELS_MAX) || (h->trend_head > h->trend_k)
+            || (h->trend_size > h->trend_k)) {
+        rc = JSDRV_ERROR_PARAMETER_INVALID;
+    } else {
+        *idx = h->idx;
+        memcpy(self->topic, h->topic, sizeof(self->topic));
+        self->hdr = h->hdr;
+        self->codec = 0;
+        self->integral = h->integral;
+        self->histogram = h->histogram;
+        self->trend_level = h->trend_level;
+        self->trend_k = h->trend_k;
+        jsdrv_bufsig_alloc(self, h->N, h->r0, h->rN);
+        if (((0 != h->integral) != (NULL != self->integral_index))
+                || ((0 != h->histogram) != (NULL != self->hist_level1))
+                || ((0 != h->trend_level) != (NULL != self->trend))) {
+            rc = JSDRV_ERROR_PARAMETER_INVALID;
+        }
+    }
+    if (rc) {
+        jsdrv_free(h);
+        return rc;
+    }
+
+    void * ptrs[FILE_ARRAYS_MAX];
+    size_t sizes[FILE_ARRAYS_MAX];
+    uint32_t count = file_arrays(self, ptrs, sizes);
+    for (uint32_t i = 0; (0 == rc) && (i < count); ++i) {
+        if (sizes[i] != fread(ptrs[i], 1, sizes[i], f)) {
+            rc = JSDRV_ERROR_IO;
+        }
+    }
+    if (0 == rc) {
+        self->time_map = h->time_map;
+        self->size_in_utc = h->size_in_utc;
+        self->level0_head = h->level0_head;
+        self->level0_size = h->level0_size;
+        self->sample_id_head = h->sample_id_head;
+        self->gap_count = h->gap_count;
+        memcpy(self->gaps, h->gaps, sizeof(self->gaps));
+        if (self->gap_count) {
+            gap_fill_alloc(self);
+        }
+        self->integral_sum = h->integral_sum;
+        self->integral_count = h->integral_count;
+        self->trend_head = h->trend_head % (self->trend_k ? self->trend_k : 1);
+        self->trend_size = h->trend_size;
+        self->trend_sample_id = h->trend_sample_id;
+    }
+    jsdrv_free(h);
+    return rc;
+}
+
+static void samples_get(struct bufsig_s * self, struct jsdrv_buffer_response_s * rsp, uint64_t data_size) {
     rsp->response_type = JSDRV_BUFFER_RESPONSE_SAMPLES;
     uint64_t sample_id = rsp->info.time_range_samples.start;
     uint64_t length = rsp->info.time_range_samples.length;
     uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
-    uint64_t length_max = (DATA_SIZE_MAX * 8) / self->hdr.element_size_bits;
+    uint64_t length_max = (data_size * 8) / self->hdr.element_size_bits;
 
     if (self->level0_size == 0) {
         rsp_empty(rsp);
@@ -430,50 +1609,131 @@ static void samples_get(struct bufsig_s * self, struct jsdrv_buffer_response_s *
         rsp->info.time_range_samples.end = sample_id + length - 1;
     }
 
-    uint8_t * data_rsp = (uint8_t *) rsp->data;
-    uint8_t * data_buf = (uint8_t *) self->level0_data;
-    uint64_t idx = (sample_id - sample_id_tail + level0_tail(self)) % self->N;
+    level0_copy(self, sample_id, length, (uint8_t *) rsp->data);
+    samples_to_utc(self, &rsp->info.time_range_samples, &rsp->info.time_range_utc);
+}
 
-    uint8_t shift = 0;
-    if (1 == self->hdr.element_size_bits) {
-        shift = idx & 7;
-    } else if (4 == self->hdr.element_size_bits) {
-        shift = (idx & 1) << 2;
+// Gather the first sample of each increment, which fills gaps and samples outside the buffer.
+static void strided_get(struct bufsig_s * self, struct jsdrv_buffer_response_s * rsp, uint64_t data_size) {
+    rsp->response_type = JSDRV_BUFFER_RESPONSE_STRIDED;
+    struct jsdrv_time_range_samples_s * r = &rsp->info.time_range_samples;
+    uint32_t bits = self->hdr.element_size_bits;
+    uint64_t incr = (r->end + 1 - r->start) / r->length;
+    uint64_t length = (r->end + 1 - r->start) / incr;
+    uint64_t length_max = (data_size * 8) / bits;
+    if (self->level0_size == 0) {
+        rsp_empty(rsp);
+        return;
     }
-
-    while (length) {
-        uint64_t idx_next = idx + length;
-        uint64_t k = length;
-        if (idx_next >= self->N) {
-            k = self->N - idx;
-            idx_next = 0;
-        }
-        uint64_t copy_size = (k * self->hdr.element_size_bits + shift + 7) / 8;
-        memcpy(data_rsp, &data_buf[(idx * self->hdr.element_size_bits) / 8], copy_size);
-        data_rsp += copy_size;
-        length -= k;
-        idx = idx_next;
+    if (length > length_max) {
+        JSDRV_LOGD3("strided req too long, truncate %" PRIu64 " -> %" PRIu64, length, length_max);
+        length = length_max;
     }
+    r->length = length;
+    r->end = r->start + incr * length - 1;
 
-    if (shift) {
-        uint64_t u64_length = (rsp->info.time_range_samples.length * self->hdr.element_size_bits + shift + 63) / 64;
-        uint8_t shift_left = 64 - shift;
-        uint64_t * p = (uint64_t *) rsp->data;
-        uint64_t fwd = p[0];
-        for (uint64_t i = 1; i < u64_length; ++i) {
-            uint64_t z = p[i];
-            p[i - 1] = (fwd >> shift) | (z << shift_left);
-            fwd = z;
+    uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
+    uint64_t tail = level0_tail(self);
+    float * f32 = (float *) rsp->data;
+    uint8_t * u8 = (uint8_t *) rsp->data;
+    if (32 != bits) {
+        memset(u8, 0, (length * bits + 7) / 8);
+    }
+    const uint8_t * src = NULL;
+    uint64_t base = 0;
+    uint64_t end = 0;
+    uint64_t sample_id = r->start;
+    for (uint64_t i = 0; i < length; ++i, sample_id += incr) {
+        if ((sample_id < sample_id_tail) || (sample_id >= self->sample_id_head)) {
+            if (32 == bits) {
+                f32[i] = NAN;
+            }
+            continue;
+        }
+        uint64_t idx = (tail + (sample_id - sample_id_tail)) % self->N;
+        if ((NULL == src) || (idx < base) || (idx >= end)) {
+            src = level0_block(self, idx, &base, &end);
+        }
+        uint64_t local = idx - base;
+        if (32 == bits) {
+            f32[i] = ((const float *) src)[local];
+        } else if (4 == bits) {
+            uint8_t v = (src[local >> 1] >> ((local & 1) << 2)) & 0x0f;
+            u8[i >> 1] |= (uint8_t) (v << ((i & 1) << 2));
+        } else {
+            uint8_t v = (src[local >> 3] >> (local & 7)) & 1;
+            u8[i >> 3] |= (uint8_t) (v << (i & 7));
         }
-        p[u64_length - 1] = fwd >> shift;
     }
+    samples_to_utc(self, r, &rsp->info.time_range_utc);
+}
 
-    samples_to_utc(self, &rsp->info.time_range_samples, &rsp->info.time_range_utc);
+static const float * level0_f32_segment(struct bufsig_s * self, uint64_t index, uint64_t incr, uint32_t * count) {
+    uint64_t base;
+    uint64_t end;
+    const float * src_f32 = (const float *) level0_block(self, index, &base, &end);
+    uint64_t n = end - index;  // contiguous until wrap or block end
+    if (n > incr) {
+        n = incr;
+    }
+    if (n > LEVEL0_SEGMENT_MAX) {
+        n = LEVEL0_SEGMENT_MAX;
+    }
+    *count = (uint32_t) n;
+    return src_f32 + (index - base);
+}
+
+static void level0_f32_sum(struct bufsig_s * self, uint64_t index, uint64_t incr, struct jsdrv_f32_sum_s * s) {
+    uint32_t n;
+    while (incr) {
+        index %= self->N;
+        const float * src_f32 = level0_f32_segment(self, index, incr, &n);
+        jsdrv_f32_sum(s, src_f32, n);
+        index += n;
+        incr -= n;
+    }
+}
+
+static double level0_f32_sum_sq_diff(struct bufsig_s * self, uint64_t index, uint64_t incr, double mean) {
+    uint32_t n;
+    double d2 = 0.0;
+    while (incr) {
+        index %= self->N;
+        const float * src_f32 = level0_f32_segment(self, index, incr, &n);
+        d2 += jsdrv_f32_sum_sq_diff(src_f32, n, mean);
+        index += n;
+        incr -= n;
+    }
+    return d2;
+}
+
+// Accumulate the packed unsigned level 0 samples over the ring segments.
+static void level0_u_sum(struct bufsig_s * self, uint64_t index, uint64_t incr, struct jsdrv_u_sum_s * s) {
+    while (incr) {
+        index %= self->N;
+        uint64_t base;
+        uint64_t end;
+        const uint8_t * src_u8 = level0_block(self, index, &base, &end);
+        uint64_t n = end - index;  // contiguous until wrap, block end or gap
+        if (n > incr) {
+            n = incr;
+        }
+        if (1 == self->hdr.element_size_bits) {
+            jsdrv_sum_u1(s, src_u8, index - base, n);
+        } else if (4 == self->hdr.element_size_bits) {
+            jsdrv_sum_u4(s, src_u8, index - base, n);
+        } else {
+            // should never get here, only 1 & 4 bits supported
+            s->min = 0;
+        }
+        index += n;
+        incr -= n;
+    }
 }
 
-static uint64_t summary_level0_get_by_idx(struct bufsig_s * self, uint64_t index, uint64_t incr, struct jsdrv_summary_entry_s * y) {
+static uint64_t summary_level0_get_by_idx(struct bufsig_s * self, uint64_t index, uint64_t incr, bool envelope,
+                                          struct jsdrv_summary_entry_s * y) {
     uint64_t sample_count = 0;
-    const uint32_t Q = 30;
     JSDRV_ASSERT(index < self->N);
     JSDRV_ASSERT(incr <= self->N);
 
@@ -483,113 +1743,712 @@ static uint64_t summary_level0_get_by_idx(struct bufsig_s * self, uint64_t index
     }
 
     if (JSDRV_DATA_TYPE_FLOAT == self->hdr.element_type) {
-        float y_min = FLT_MAX;
-        float y_max = -FLT_MAX;
+        // two-pass mean and variance over the ring segments
+        struct jsdrv_f32_sum_s s;
+        jsdrv_f32_sum_reset(&s);
+        level0_f32_sum(self, index, incr, &s);
+        sample_count = s.count;
+        if (sample_count) {
+            double mean = s.sum / (double) sample_count;
+            y->avg = (float) mean;
+            if (envelope) {
+                y->std = NAN;  // skip the second pass
+            } else {
+                double d2 = level0_f32_sum_sq_diff(self, index, incr, mean);
+                y->std = (float) sqrt(d2 / (double) sample_count);
+            }
+            y->min = s.min;
+            y->max = s.max;
+        } else {
+            entry_clear(y);
+        }
+    } else {
+        struct jsdrv_u_sum_s s;
+        jsdrv_u_sum_reset(&s);
+        level0_u_sum(self, index, incr, &s);
+        y->avg = (float) (((double) s.x1) / (double) incr);
+        y->std = envelope ? NAN : (float) js220_i128_compute_std(
+                (int64_t) s.x1, js220_i128_init_i64((int64_t) s.x2), incr, 0);
+        y->min = s.min;
+        y->max = s.max;
+    }
+    return sample_count;
+}
+
+static uint64_t summary_level0_get(struct bufsig_s * self, uint64_t sample_id, uint64_t incr, bool envelope,
+                                   struct jsdrv_summary_entry_s * y) {
+    uint64_t src_idx;
+    uint64_t tail = level0_tail(self);
+    uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
+    uint64_t sample_id_end = sample_id + incr;  // exclusive, one past end
+    if ((incr == 0) || (sample_id_end <= sample_id_tail) || (sample_id >= self->sample_id_head)) {
+        entry_clear(y);
+        return 0;
+    }
+    if (sample_id < sample_id_tail) {
+        uint64_t k = sample_id_tail - sample_id;
+        sample_id += k;
+        incr -= k;
+    }
+    if (sample_id_end > self->sample_id_head) {
+        uint64_t k = sample_id_end - self->sample_id_head;
+        incr -= k;
+    }
+    if (incr == 0) {
+        entry_clear(y);
+        return 0;
+    }
+
+    JSDRV_ASSERT(sample_id >= sample_id_tail);
+    JSDRV_ASSERT((sample_id + incr) <= self->sample_id_head);
+    src_idx = tail + (sample_id - sample_id_tail);
+    src_idx = src_idx % self->N;
+    return summary_level0_get_by_idx(self, src_idx, incr, envelope, y);
+}
+
+#define INTEGRAL_Q (31)                          // fixed-point fraction bits
+#define INTEGRAL_SAMPLE_MAX (4611686018427387904.0)  // 2**62 with INTEGRAL_Q
 
-        js220_i128 x2;
-        x2.u64[0] = 0;
-        x2.u64[1] = 0;
-        float *src_f32 = (float *) self->level0_data;
-        int64_t x1 = 0;
+static inline int64_t integral_sample(float x) {
+    double v = ldexp((double) x, INTEGRAL_Q);
+    if (v >= INTEGRAL_SAMPLE_MAX) {
+        v = INTEGRAL_SAMPLE_MAX;
+    } else if (v <= -INTEGRAL_SAMPLE_MAX) {
+        v = -INTEGRAL_SAMPLE_MAX;
+    }
+    return (int64_t) llround(v);
+}
 
-        for (uint64_t k = 0; k < incr; ++k) {
-            if (index >= self->N) {
-                index %= self->N;
+// Add the fixed-point sum of the non-NaN level 0 float samples.
+static void level0_f32_sum_i128(struct bufsig_s * self, uint64_t index, uint64_t incr,
+                                js220_i128 * sum, uint64_t * count) {
+    uint32_t n;
+    while (incr) {
+        index %= self->N;
+        const float * src_f32 = level0_f32_segment(self, index, incr, &n);
+        for (uint32_t i = 0; i < n; ++i) {
+            float x = src_f32[i];
+            if (!isnan(x)) {
+                *sum = js220_i128_add(*sum, js220_i128_init_i64(integral_sample(x)));
+                ++*count;
             }
-            float f = src_f32[index++];
-            if (isnan(f)) {
-                continue;
+        }
+        index += n;
+        incr -= n;
+    }
+}
+
+static void integral_update(struct bufsig_s * self, uint64_t level1_idx, uint64_t level0_idx) {
+    struct bufsig_integral_s * e = &self->integral_index[level1_idx];
+    e->start = self->integral_sum;
+    e->count_start = self->integral_count;
+    level0_f32_sum_i128(self, level0_idx, self->r0, &self->integral_sum, &self->integral_count);
+    e->end = self->integral_sum;
+    e->count_end = self->integral_count;
+}
+
+#define HIST_EXP_MIN (-26)     // bin 1 starts at 2**-26, and bin 63 at 2**5
+
+/*
+ * Get the histogram bin for a sample that is not NaN.
+ *
+ * Bin 0 holds the samples below 2**HIST_EXP_MIN, including zero and
+ * negative values.  Bins 1 to 62 split each octave at 1.5, and bin
+ * 63 holds the samples at or above 2**(HIST_EXP_MIN + 31).
+ */
+static inline uint32_t hist_bin(float x) {
+    if (!(x >= (1.0f / (float) (1UL << -HIST_EXP_MIN)))) {
+        return 0;
+    }
+    uint32_t u;
+    memcpy(&u, &x, sizeof(u));
+    int32_t k = ((((int32_t) ((u >> 23) & 0xff)) - 127 - HIST_EXP_MIN) * 2) + (int32_t) ((u >> 22) & 1);
+    return (k >= 62) ? 63 : (uint32_t) (k + 1);
+}
+
+// Get the lower edge of bins 1 to 63.
+static double hist_edge(uint32_t bin) {
+    uint32_t k = bin - 1;
+    return ldexp((k & 1) ? 1.5 : 1.0, HIST_EXP_MIN + (int) (k >> 1));
+}
+
+static void hist_update(struct bufsig_s * self, uint64_t level1_idx, uint64_t level0_idx) {
+    uint16_t * h = &self->hist_level1[level1_idx * JSDRV_BUFSIG_HIST_BINS];
+    uint64_t incr = self->r0;
+    uint32_t n;
+    memset(h, 0, JSDRV_BUFSIG_HIST_BINS * sizeof(*h));
+    while (incr) {
+        level0_idx %= self->N;
+        const float * src_f32 = level0_f32_segment(self, level0_idx, incr, &n);
+        for (uint32_t i = 0; i < n; ++i) {
+            if (!isnan(src_f32[i])) {
+                ++h[hist_bin(src_f32[i])];
+            }
+        }
+        level0_idx += n;
+        incr -= n;
+    }
+}
+
+// Sum the histograms of the level entries for the level + 1 entry.
+static void hist_merge(struct bufsig_s * self, uint8_t level, uint64_t lvl_up_idx, uint64_t lvl_dn_idx) {
+    uint32_t * dst = &self->hist_levels[level][lvl_up_idx * JSDRV_BUFSIG_HIST_BINS];
+    const struct bufsig_level_s * lvl_dn = &self->levels[level - 1];
+    memset(dst, 0, JSDRV_BUFSIG_HIST_BINS * sizeof(*dst));
+    for (uint64_t i = 0; i < self->levels[level].r; ++i) {
+        uint64_t idx = ((lvl_dn_idx + i) % lvl_dn->k) * JSDRV_BUFSIG_HIST_BINS;
+        if (1 == level) {
+            const uint16_t * src = &self->hist_level1[idx];
+            for (uint32_t j = 0; j < JSDRV_BUFSIG_HIST_BINS; ++j) {
+                dst[j] += src[j];
             }
-            int64_t x_i64 = (int64_t) (f * (1 << Q));
-            x1 += x_i64;
-            x2 = js220_i128_add(x2, js220_i128_square_i64(x_i64));
-            ++sample_count;
-            if (f < y_min) {
-                y_min = f;
+        } else {
+            const uint32_t * src = &self->hist_levels[level - 1][idx];
+            for (uint32_t j = 0; j < JSDRV_BUFSIG_HIST_BINS; ++j) {
+                dst[j] += src[j];
             }
-            if (f > y_max) {
-                y_max = f;
+        }
+    }
+}
+
+// Append the completed trend level entry that ends before sample_id_end.
+static void trend_append(struct bufsig_s * self, const struct jsdrv_summary_entry_s * e, uint64_t sample_id_end) {
+    uint64_t sample_id = sample_id_end - self->trend_spe;
+    if (self->trend_size && (sample_id != self->trend_sample_id)) {
+        uint64_t n = (sample_id - self->trend_sample_id) / self->trend_spe;
+        if ((sample_id < self->trend_sample_id) || (n >= self->trend_k)) {
+            self->trend_size = 0;  // restart
+        }
+        for (uint64_t i = 0; self->trend_size && (i < n); ++i) {
+            entry_clear(&self->trend[self->trend_head]);  // missing
+            self->trend_head = (self->trend_head + 1) % self->trend_k;
+            if (self->trend_size < self->trend_k) {
+                ++self->trend_size;
             }
         }
-        if (sample_count) {
-            y->avg = (float) (((double) x1) / ((double) sample_count * (double) (1 << Q)));
-            y->std = (float) js220_i128_compute_std(x1, x2, sample_count, Q);
-            y->min = y_min;
-            y->max = y_max;
+    }
+    self->trend[self->trend_head] = *e;
+    self->trend_head = (self->trend_head + 1) % self->trend_k;
+    if (self->trend_size < self->trend_k) {
+        ++self->trend_size;
+    }
+    self->trend_sample_id = sample_id_end;
+}
+
+static int32_t integral_get(struct bufsig_s * self, struct jsdrv_buffer_response_s * rsp) {
+    rsp->response_type = JSDRV_BUFFER_RESPONSE_INTEGRAL;
+    struct jsdrv_time_range_samples_s * r = &rsp->info.time_range_samples;
+    struct jsdrv_buffer_integral_s * y = (struct jsdrv_buffer_integral_s *) rsp->data;
+    if ((JSDRV_DATA_TYPE_FLOAT != self->hdr.element_type) || (32 != self->hdr.element_size_bits)) {
+        JSDRV_LOGW("integral request: %s is not float", self->topic);
+        rsp_empty(rsp);
+        return JSDRV_ERROR_NOT_SUPPORTED;
+    }
+    uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
+    uint64_t sample_id_start = r->start;
+    uint64_t sample_id_end = r->end;
+    if (0 == sample_id_end) {
+        if (0 == r->length) {
+            rsp_empty(rsp);
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+        sample_id_end = sample_id_start + r->length - 1;
+    }
+    if (sample_id_start < sample_id_tail) {
+        sample_id_start = sample_id_tail;
+    }
+    if (sample_id_end >= self->sample_id_head) {
+        sample_id_end = self->sample_id_head - 1;
+    }
+    if ((0 == self->level0_size) || (sample_id_end < sample_id_start)) {
+        rsp_empty(rsp);
+        return 0;
+    }
+
+    summary_update(self, 1);
+    js220_i128 sum = js220_i128_init_i64(0);
+    uint64_t count = 0;
+    uint64_t index = (sample_id_start - sample_id_tail + level0_tail(self)) % self->N;
+    uint64_t length = sample_id_end + 1 - sample_id_start;
+    uint64_t r0 = self->r0;
+    uint64_t head = (r0 - (index % r0)) % r0;  // samples before the first full level 1 entry
+    if ((NULL != self->integral_index) && (length >= (head + r0))) {
+        uint64_t entries = (length - head) / r0;
+        uint64_t first = ((index + head) % self->N) / r0;
+        uint64_t last = (first + entries - 1) % self->levels[0].k;
+        const struct bufsig_integral_s * e0 = &self->integral_index[first];
+        const struct bufsig_integral_s * e1 = &self->integral_index[last];
+        level0_f32_sum_i128(self, index, head, &sum, &count);
+        sum = js220_i128_add(sum, js220_i128_sub(e1->end, e0->start));
+        count += e1->count_end - e0->count_start;
+        uint64_t offset = head + entries * r0;
+        level0_f32_sum_i128(self, index + offset, length - offset, &sum, &count);
+    } else {
+        level0_f32_sum_i128(self, index, length, &sum, &count);
+    }
+
+    r->start = sample_id_start;
+    r->end = sample_id_end;
+    r->length = 1;
+    samples_to_utc(self, r, &rsp->info.time_range_utc);
+    y->sum_i128[0] = sum.u64[0];
+    y->sum_i128[1] = sum.u64[1];
+    y->sample_count = count;
+    double sample_rate = ((double) self->hdr.sample_rate) / self->hdr.decimate_factor;
+    y->integral = js220_i128_to_f64(sum, INTEGRAL_Q) / sample_rate;
+    return 0;
+}
+
+// Get the gaps within the inclusive sample id range, up to length_max.
+static uint64_t gaps_find(struct bufsig_s * self, uint64_t start, uint64_t end,
+                          struct jsdrv_time_range_samples_s * ranges, uint64_t length_max) {
+    uint64_t count = 0;
+    for (uint32_t i = 0; (i < self->gap_count) && (count < length_max); ++i) {
+        uint64_t gap_start = self->gaps[i].start;
+        uint64_t gap_end = self->gaps[i].end - 1;
+        if ((gap_end < start) || (gap_start > end)) {
+            continue;
+        }
+        if (ranges) {
+            struct jsdrv_time_range_samples_s * g = &ranges[count];
+            g->start = (gap_start < start) ? start : gap_start;
+            g->end = (gap_end > end) ? end : gap_end;
+            g->length = g->end + 1 - g->start;
+        }
+        ++count;
+    }
+    return count;
+}
+
+static void gaps_get(struct bufsig_s * self, struct jsdrv_buffer_response_s * rsp, uint64_t data_size) {
+    rsp->response_type = JSDRV_BUFFER_RESPONSE_GAPS;
+    struct jsdrv_time_range_samples_s * r = &rsp->info.time_range_samples;
+    uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
+    uint64_t sample_id_start = r->start;
+    uint64_t sample_id_end = r->end;
+    if (0 == sample_id_end) {
+        sample_id_end = sample_id_start + (r->length ? r->length : 1) - 1;
+    }
+    if (sample_id_start < sample_id_tail) {
+        sample_id_start = sample_id_tail;
+    }
+    if (sample_id_end >= self->sample_id_head) {
+        sample_id_end = self->sample_id_head - 1;
+    }
+    if ((0 == self->level0_size) || (sample_id_end < sample_id_start)) {
+        rsp_empty(rsp);
+        return;
+    }
+    r->start = sample_id_start;
+    r->end = sample_id_end;
+    r->length = gaps_find(self, sample_id_start, sample_id_end, (struct jsdrv_time_range_samples_s *) rsp->data,
+                          data_size / sizeof(struct jsdrv_time_range_samples_s));
+    samples_to_utc(self, r, &rsp->info.time_range_utc);
+}
+
+#define SEARCH_CHUNK (256)  // level 0 samples per search read
+
+// The threshold search state at the boundary of the searched samples.
+struct search_s {
+    float threshold;
+    uint8_t edges;          // jsdrv_buffer_search_e RISING and FALLING
+    int8_t above;           // the adjacent sample is above threshold: 1, 0 or -1 when unknown
+    bool resolve;           // backward: the adjacent sample is the first valid sample at or after sample_id
+    uint64_t sample_id;     // backward: the adjacent sample id
+};
+
+static uint64_t search_index(struct bufsig_s * self, uint64_t sample_id) {
+    uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
+    return (level0_tail(self) + (sample_id - sample_id_tail)) % self->N;
+}
+
+// Get n <= SEARCH_CHUNK level 0 samples as float starting at sample_id.
+static void search_values(struct bufsig_s * self, uint64_t sample_id, uint32_t n, float * y) {
+    uint64_t index = search_index(self, sample_id);
+    uint32_t bits = self->hdr.element_size_bits;
+    while (n) {
+        uint64_t base;
+        uint64_t end;
+        index %= self->N;
+        const uint8_t * src = level0_block(self, index, &base, &end);
+        uint32_t k = ((end - index) < n) ? (uint32_t) (end - index) : n;
+        uint64_t offset = index - base;
+        if (JSDRV_DATA_TYPE_FLOAT == self->hdr.element_type) {
+            memcpy(y, ((const float *) src) + offset, k * sizeof(float));
         } else {
-            entry_clear(y);
+            for (uint32_t i = 0; i < k; ++i) {
+                uint64_t bit = (offset + i) * bits;
+                y[i] = (float) ((src[bit >> 3] >> (bit & 7)) & ((1U << bits) - 1));
+            }
+        }
+        y += k;
+        index += k;
+        n -= k;
+    }
+}
+
+// Get the highest summary level whose entry starts at index and fits within length, up to level_max.
+static uint8_t search_level(struct bufsig_s * self, uint64_t index, uint64_t length, uint8_t level_max) {
+    uint8_t level = 0;
+    for (uint8_t i = 0; (i < level_max) && (i < JSDRV_BUFSIG_LEVELS_MAX); ++i) {
+        const struct bufsig_level_s * lvl = &self->levels[i];
+        if ((0 == lvl->k) || (lvl->samples_per_entry > length) || (index % lvl->samples_per_entry)
+                || ((index / lvl->samples_per_entry) >= lvl->k)) {
+            break;
+        }
+        level = i + 1;
+    }
+    return level;
+}
+
+// Get the highest summary level whose entry ends at index_end and fits within length, up to level_max.
+static uint8_t search_level_back(struct bufsig_s * self, uint64_t index_end, uint64_t length, uint8_t level_max) {
+    uint8_t level = 0;
+    for (uint8_t i = 0; (i < level_max) && (i < JSDRV_BUFSIG_LEVELS_MAX); ++i) {
+        const struct bufsig_level_s * lvl = &self->levels[i];
+        if ((0 == lvl->k) || (lvl->samples_per_entry > length) || (index_end % lvl->samples_per_entry)
+                || ((index_end / lvl->samples_per_entry) > lvl->k)) {
+            break;
+        }
+        level = i + 1;
+    }
+    return level;
+}
+
+/*
+ * Skip a summary entry that cannot contain a wanted crossing.
+ *
+ * Return true and update the state when all entry samples are on one
+ * side of the threshold, without a wanted crossing at the first sample.
+ * Level 1 entries without valid samples are skipped.  Upper level
+ * entries with NaN may combine partially valid entries, so descend.
+ */
+static bool search_skip(struct search_s * s, const struct jsdrv_summary_entry_s * e, uint8_t level) {
+    if (isnan(e->min) || isnan(e->max)) {
+        return 1 == level;
+    } else if (e->min > s->threshold) {
+        if ((0 == s->above) && (s->edges & JSDRV_BUFFER_SEARCH_RISING)) {
+            return false;
+        }
+        s->above = 1;
+        return true;
+    } else if (e->max <= s->threshold) {
+        if ((1 == s->above) && (s->edges & JSDRV_BUFFER_SEARCH_FALLING)) {
+            return false;
+        }
+        s->above = 0;
+        return true;
+    }
+    return false;
+}
+
+// Update the state with the next sample, and return true for a wanted crossing.
+static bool search_step(struct search_s * s, float x) {
+    if (isnan(x)) {
+        return false;
+    }
+    int8_t above = (x > s->threshold) ? 1 : 0;
+    bool rv = (s->above >= 0) && (above != s->above)
+            && (s->edges & (above ? JSDRV_BUFFER_SEARCH_RISING : JSDRV_BUFFER_SEARCH_FALLING));
+    s->above = above;
+    return rv;
+}
+
+// Find the crossings from start to end, exclusive, up to length_max, and return the count.
+static uint64_t search_forward(struct bufsig_s * self, struct search_s * s, uint64_t start, uint64_t end,
+                               uint64_t * y, uint64_t length_max) {
+    float x[SEARCH_CHUNK];
+    uint64_t count = 0;
+    uint64_t sample_id = start;
+    uint8_t level_max = JSDRV_BUFSIG_LEVELS_MAX;
+    while (sample_id < end) {
+        uint64_t index = search_index(self, sample_id);
+        uint8_t level = search_level(self, index, end - sample_id, level_max);
+        if (level) {
+            const struct bufsig_level_s * lvl = &self->levels[level - 1];
+            if (search_skip(s, &lvl->data[index / lvl->samples_per_entry], level)) {
+                sample_id += lvl->samples_per_entry;
+                level_max = JSDRV_BUFSIG_LEVELS_MAX;
+            } else {
+                level_max = level - 1;  // descend
+            }
+            continue;
+        }
+        uint64_t n = self->r0 - (index % self->r0);  // until the next level 1 entry
+        n = (n > (end - sample_id)) ? (end - sample_id) : n;
+        n = (n > SEARCH_CHUNK) ? SEARCH_CHUNK : n;
+        search_values(self, sample_id, (uint32_t) n, x);
+        for (uint32_t i = 0; i < n; ++i) {
+            if (search_step(s, x[i])) {
+                y[count++] = sample_id + i;
+                if (count >= length_max) {
+                    return count;
+                }
+            }
+        }
+        sample_id += n;
+        level_max = JSDRV_BUFSIG_LEVELS_MAX;
+    }
+    return count;
+}
+
+// Get the backward crossing sample id.
+static uint64_t search_resolve(struct bufsig_s * self, struct search_s * s, uint64_t end) {
+    float x[SEARCH_CHUNK];
+    uint64_t sample_id = s->sample_id;
+    if (!s->resolve || (JSDRV_DATA_TYPE_FLOAT != self->hdr.element_type)) {
+        return sample_id;
+    }
+    while (sample_id < end) {  // skip the NaN samples at the start of the entry
+        uint64_t n = end - sample_id;
+        n = (n > SEARCH_CHUNK) ? SEARCH_CHUNK : n;
+        search_values(self, sample_id, (uint32_t) n, x);
+        for (uint32_t i = 0; i < n; ++i) {
+            if (!isnan(x[i])) {
+                return sample_id + i;
+            }
+        }
+        sample_id += n;
+    }
+    return s->sample_id;
+}
+
+// Find the last crossing from start to end, exclusive, and return true if found.
+static bool search_backward(struct bufsig_s * self, struct search_s * s, uint64_t start, uint64_t end,
+                            uint64_t * y) {
+    float x[SEARCH_CHUNK];
+    uint64_t sample_id = end;  // exclusive
+    uint8_t level_max = JSDRV_BUFSIG_LEVELS_MAX;
+    while (sample_id > start) {
+        uint64_t index_end = search_index(self, sample_id);
+        index_end = index_end ? index_end : self->N;
+        uint8_t level = search_level_back(self, index_end, sample_id - start, level_max);
+        if (level) {
+            const struct bufsig_level_s * lvl = &self->levels[level - 1];
+            const struct jsdrv_summary_entry_s * e = &lvl->data[index_end / lvl->samples_per_entry - 1];
+            int8_t above = s->above;
+            if (!isnan(e->min) && !isnan(e->max) && (above >= 0)
+                    && (((0 == above) && (e->min > s->threshold) && (s->edges & JSDRV_BUFFER_SEARCH_FALLING))
+                    || ((1 == above) && (e->max <= s->threshold) && (s->edges & JSDRV_BUFFER_SEARCH_RISING)))) {
+                *y = search_resolve(self, s, end);  // the entry is on the other side of the adjacent sample
+                return true;
+            }
+            s->above = -1;  // search_skip() checks forward crossings
+            if (search_skip(s, e, level)) {
+                sample_id -= lvl->samples_per_entry;
+                if (s->above < 0) {
+                    s->above = above;  // no valid samples
+                } else {
+                    s->sample_id = sample_id;
+                    s->resolve = true;
+                }
+                level_max = JSDRV_BUFSIG_LEVELS_MAX;
+            } else {
+                s->above = above;
+                level_max = level - 1;  // descend
+            }
+            continue;
+        }
+        uint64_t n = index_end % self->r0;  // since the previous level 1 entry
+        n = n ? n : self->r0;
+        n = (n > (sample_id - start)) ? (sample_id - start) : n;
+        n = (n > SEARCH_CHUNK) ? SEARCH_CHUNK : n;
+        sample_id -= n;
+        search_values(self, sample_id, (uint32_t) n, x);
+        for (uint32_t i = (uint32_t) n; i > 0; --i) {
+            float v = x[i - 1];
+            if (isnan(v)) {
+                continue;
+            }
+            int8_t above = (v > s->threshold) ? 1 : 0;
+            if ((s->above >= 0) && (above != s->above)
+                    && (s->edges & (s->above ? JSDRV_BUFFER_SEARCH_RISING : JSDRV_BUFFER_SEARCH_FALLING))) {
+                *y = search_resolve(self, s, end);
+                return true;
+            }
+            s->above = above;
+            s->sample_id = sample_id + i - 1;
+            s->resolve = false;
+        }
+        level_max = JSDRV_BUFSIG_LEVELS_MAX;
+    }
+    return false;
+}
+
+static void search_get(struct bufsig_s * self, struct jsdrv_buffer_request_s * req,
+                       struct jsdrv_buffer_response_s * rsp, uint64_t data_size) {
+    rsp->response_type = JSDRV_BUFFER_RESPONSE_CROSSINGS;
+    struct jsdrv_time_range_samples_s * r = &rsp->info.time_range_samples;
+    uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
+    uint64_t sample_id_start = r->start;
+    uint64_t sample_id_end = r->end;
+    if (0 == sample_id_end) {
+        sample_id_end = sample_id_start + (r->length ? r->length : 1) - 1;
+    }
+    if (sample_id_start < sample_id_tail) {
+        sample_id_start = sample_id_tail;
+    }
+    if (sample_id_end >= self->sample_id_head) {
+        sample_id_end = self->sample_id_head - 1;
+    }
+    if ((0 == self->level0_size) || (sample_id_end < sample_id_start)) {
+        rsp_empty(rsp);
+        return;
+    }
+
+    summary_update(self, JSDRV_BUFSIG_LEVELS_MAX);
+    struct search_s s = {
+        .threshold = req->threshold,
+        .edges = req->op & (JSDRV_BUFFER_SEARCH_RISING | JSDRV_BUFFER_SEARCH_FALLING),
+        .above = -1,
+        .resolve = false,
+        .sample_id = 0,
+    };
+    if (0 == s.edges) {
+        s.edges = JSDRV_BUFFER_SEARCH_RISING | JSDRV_BUFFER_SEARCH_FALLING;
+    }
+    // include the preceding sample, if available, for a crossing at start
+    uint64_t start = (sample_id_start > sample_id_tail) ? (sample_id_start - 1) : sample_id_start;
+    uint64_t * y = (uint64_t *) rsp->data;
+    uint64_t length = 0;
+    if (req->op & JSDRV_BUFFER_SEARCH_ALL) {
+        uint64_t length_max = data_size / sizeof(uint64_t);
+        length = search_forward(self, &s, start, sample_id_end + 1, y, length_max);
+        if (length && (length >= length_max)) {
+            sample_id_end = y[length - 1];  // continue from end + 1
+        }
+    } else if (req->op & JSDRV_BUFFER_SEARCH_LAST) {
+        length = search_backward(self, &s, start, sample_id_end + 1, y) ? 1 : 0;
+    } else {
+        length = search_forward(self, &s, start, sample_id_end + 1, y, 1);
+    }
+    r->start = sample_id_start;
+    r->end = sample_id_end;
+    r->length = length;
+    samples_to_utc(self, r, &rsp->info.time_range_utc);
+}
+
+// Add the entry min and max, which may be NaN, to the range.
+static void quantile_range(float * v_min, float * v_max, float e_min, float e_max) {
+    if (!isnan(e_min) && (e_min < *v_min)) {
+        *v_min = e_min;
+    }
+    if (!isnan(e_max) && (e_max > *v_max)) {
+        *v_max = e_max;
+    }
+}
+
+// Get the value at rank within the histogram, interpolated within its bin.
+static float quantile_value(const uint64_t * hist, double rank, float v_min, float v_max) {
+    uint64_t cumulative = 0;
+    uint32_t bin = 0;
+    for (; bin < (JSDRV_BUFSIG_HIST_BINS - 1); ++bin) {
+        if (rank < (double) (cumulative + hist[bin])) {
+            break;
         }
+        cumulative += hist[bin];
+    }
+    double lo = (0 == bin) ? v_min : hist_edge(bin);
+    double hi = ((JSDRV_BUFSIG_HIST_BINS - 1) == bin) ? v_max : hist_edge(bin + 1);
+    lo = (lo < v_min) ? v_min : lo;
+    hi = (hi > v_max) ? v_max : hi;
+    double frac = hist[bin] ? ((rank - (double) cumulative + 0.5) / (double) hist[bin]) : 0.5;
+    frac = (frac > 1.0) ? 1.0 : frac;
+    double v;
+    if ((lo > 0.0) && (hi > lo)) {
+        v = lo * pow(hi / lo, frac);  // log-spaced bins
     } else {
-        uint8_t * src_u8 = (uint8_t *) self->level0_data;
-        uint8_t x_u8;
-        uint8_t y_min = (uint8_t) ((1 << self->hdr.element_size_bits) - 1);
-        uint8_t y_max = 0x00;
-        uint64_t x1 = 0;
-        js220_i128 x2;
-        x2.u64[0] = 0;
-        x2.u64[1] = 0;
-        for (uint64_t k = 0; k < incr; ++k) {
-            if (index >= self->N) {
-                index = index % self->N;
-            }
-            if (1 == self->hdr.element_size_bits) {
-                x_u8 = (src_u8[index >> 3] >> (index & 7)) & 1;
-            } else if (4 == self->hdr.element_size_bits) {
-                x_u8 = src_u8[index >> 1];
-                if (index & 1) {
-                    x_u8 = (x_u8 >> 4);
-                }
-                x_u8 &= 0x0f;
-            } else {
-                // should never get here, only 1 & 4 bits supported
-                x_u8 = 0;
-            }
-            x1 += x_u8;
-            x2 = js220_i128_add(x2, js220_i128_square_i64(x_u8));
-            if (x_u8 < y_min) {
-                y_min = x_u8;
-            }
-            if (x_u8 > y_max) {
-                y_max = x_u8;
-            }
-            ++index;
-        }
-        y->avg = (float) (((double) x1) / (double) incr);
-        y->std = (float) js220_i128_compute_std(x1, x2, incr, 0);
-        y->min = y_min;
-        y->max = y_max;
+        v = lo + (hi - lo) * frac;
     }
-    return sample_count;
+    return (float) v;
 }
 
-static uint64_t summary_level0_get(struct bufsig_s * self, uint64_t sample_id, uint64_t incr, struct jsdrv_summary_entry_s * y) {
-    uint64_t src_idx;
-    uint64_t tail = level0_tail(self);
+static int32_t quantile_get(struct bufsig_s * self, struct jsdrv_buffer_response_s * rsp, uint64_t data_size) {
+    rsp->response_type = JSDRV_BUFFER_RESPONSE_QUANTILES;
+    struct jsdrv_time_range_samples_s * r = &rsp->info.time_range_samples;
+    if ((JSDRV_DATA_TYPE_FLOAT != self->hdr.element_type) || (32 != self->hdr.element_size_bits)) {
+        JSDRV_LOGW("quantile request: %s is not float", self->topic);
+        rsp_empty(rsp);
+        return JSDRV_ERROR_NOT_SUPPORTED;
+    }
+    uint64_t length = r->length ? r->length : 101;
+    if ((0 == r->end) || ((length * sizeof(float)) > data_size)) {
+        rsp_empty(rsp);
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
     uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
-    uint64_t sample_id_end = sample_id + incr;  // exclusive, one past end
-    if ((incr == 0) || (sample_id_end <= sample_id_tail) || (sample_id >= self->sample_id_head)) {
-        entry_clear(y);
+    uint64_t sample_id_start = (r->start < sample_id_tail) ? sample_id_tail : r->start;
+    uint64_t sample_id_end = (r->end >= self->sample_id_head) ? (self->sample_id_head - 1) : r->end;
+    if ((0 == self->level0_size) || (sample_id_end < sample_id_start)) {
+        rsp_empty(rsp);
         return 0;
     }
-    if (sample_id < sample_id_tail) {
-        uint64_t k = sample_id_tail - sample_id;
-        sample_id += k;
-        incr -= k;
-    }
-    if (sample_id_end > self->sample_id_head) {
-        uint64_t k = sample_id_end - self->sample_id_head;
-        incr -= k;
+
+    uint8_t level_max = 0;
+    if (NULL != self->hist_level1) {
+        level_max = 1;
+        while ((level_max < JSDRV_BUFSIG_LEVELS_MAX) && (NULL != self->hist_levels[level_max])) {
+            ++level_max;
+        }
     }
-    if (incr == 0) {
-        entry_clear(y);
-        return 0;
+    summary_update(self, level_max);
+    uint64_t hist[JSDRV_BUFSIG_HIST_BINS];
+    float x[SEARCH_CHUNK];
+    float v_min = INFINITY;
+    float v_max = -INFINITY;
+    memset(hist, 0, sizeof(hist));
+    uint64_t sample_id = sample_id_start;
+    uint64_t end = sample_id_end + 1;
+    while (sample_id < end) {
+        uint64_t index = search_index(self, sample_id);
+        uint8_t level = search_level(self, index, end - sample_id, level_max);
+        if (level) {
+            const struct bufsig_level_s * lvl = &self->levels[level - 1];
+            uint64_t idx = index / lvl->samples_per_entry;
+            const struct jsdrv_summary_entry_s * e = &lvl->data[idx];
+            quantile_range(&v_min, &v_max, e->min, e->max);
+            idx *= JSDRV_BUFSIG_HIST_BINS;
+            for (uint32_t j = 0; j < JSDRV_BUFSIG_HIST_BINS; ++j) {
+                hist[j] += (1 == level) ? self->hist_level1[idx + j] : self->hist_levels[level - 1][idx + j];
+            }
+            sample_id += lvl->samples_per_entry;
+            continue;
+        }
+        uint64_t n = self->r0 - (index % self->r0);  // until the next level 1 entry
+        n = (n > (end - sample_id)) ? (end - sample_id) : n;
+        n = (n > SEARCH_CHUNK) ? SEARCH_CHUNK : n;
+        search_values(self, sample_id, (uint32_t) n, x);
+        for (uint32_t i = 0; i < n; ++i) {
+            if (!isnan(x[i])) {
+                ++hist[hist_bin(x[i])];
+                quantile_range(&v_min, &v_max, x[i], x[i]);
+            }
+        }
+        sample_id += n;
     }
 
-    JSDRV_ASSERT(sample_id >= sample_id_tail);
-    JSDRV_ASSERT((sample_id + incr) <= self->sample_id_head);
-    src_idx = tail + (sample_id - sample_id_tail);
-    src_idx = src_idx % self->N;
-    return summary_level0_get_by_idx(self, src_idx, incr, y);
+    uint64_t total = 0;
+    for (uint32_t j = 0; j < JSDRV_BUFSIG_HIST_BINS; ++j) {
+        total += hist[j];
+    }
+    float * y = (float *) rsp->data;
+    for (uint64_t i = 0; i < length; ++i) {
+        double q = (length > 1) ? ((double) i / (double) (length - 1)) : 0.5;
+        if (0 == total) {
+            y[i] = NAN;
+        } else if (0.0 == q) {
+            y[i] = v_min;
+        } else if (1.0 == q) {
+            y[i] = v_max;
+        } else {
+            y[i] = quantile_value(hist, q * (double) (total - 1), v_min, v_max);
+        }
+    }
+    r->start = sample_id_start;
+    r->end = sample_id_end;
+    r->length = length;
+    samples_to_utc(self, r, &rsp->info.time_range_utc);
+    return 0;
 }
 
 static void rsp_clear(struct jsdrv_buffer_response_s * rsp) {
@@ -601,37 +2460,51 @@ static void rsp_clear(struct jsdrv_buffer_response_s * rsp) {
     rsp->info.time_range_utc.length = 0;
 }
 
-static void summary_get(struct bufsig_s * self, struct jsdrv_buffer_response_s * rsp) {
-    rsp->response_type = JSDRV_BUFFER_RESPONSE_SUMMARY;
-    uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
-    uint64_t sample_id_start = rsp->info.time_range_samples.start;
-    uint64_t sample_id_end = rsp->info.time_range_samples.end;
-    uint64_t entries_length = rsp->info.time_range_samples.length;
-
-    uint64_t range_req = sample_id_end + 1 - sample_id_start;
-    uint64_t incr = range_req / entries_length;
-    entries_length = range_req / incr;
-    rsp->info.time_range_samples.length = entries_length;
-    rsp->info.time_range_samples.end = sample_id_start + incr * entries_length;
+static inline void accum_combine(bool envelope, struct jsdrv_statistics_accum_s * tgt,
+                                 const struct jsdrv_statistics_accum_s * b) {
+    if (envelope) {
+        jsdrv_statistics_combine_envelope(tgt, tgt, b);
+    } else {
+        jsdrv_statistics_combine(tgt, tgt, b);
+    }
+}
 
-    if (self->level0_size == 0) {
-        JSDRV_LOGI("summary request: buffer empty");
-        rsp_clear(rsp);
-        return;
-    } else if (entries_length == 0) {
-        JSDRV_LOGI("summary request: length == 0");
-        rsp_clear(rsp);
-        return;
-    } else if (entries_length > SUMMARY_LENGTH_MAX) {
-        JSDRV_LOGI("summary request: length too long: %" PRIu64 " > %" PRIu64,
-                   entries_length, SUMMARY_LENGTH_MAX);
-        rsp_clear(rsp);
-        return;
+// Combine the trend entries that overlap [s_start, s_end), and return false when none do.
+static bool trend_summary(struct bufsig_s * self, uint64_t s_start, uint64_t s_end, bool envelope,
+                          struct jsdrv_summary_entry_s * dst) {
+    uint64_t t_start = trend_tail(self);
+    if ((0 == self->trend_size) || (s_end <= t_start) || (s_start >= self->trend_sample_id)) {
+        return false;
     }
+    if (s_end > self->trend_sample_id) {
+        s_end = self->trend_sample_id;
+    }
+    uint64_t j = (s_start > t_start) ? ((s_start - t_start) / self->trend_spe) : 0;
+    uint64_t j_end = (s_end - t_start + self->trend_spe - 1) / self->trend_spe;
+    uint64_t idx = (self->trend_head + self->trend_k - self->trend_size + j) % self->trend_k;
+    struct jsdrv_statistics_accum_s s_tmp;
+    struct jsdrv_statistics_accum_s s_accum;
+    jsdrv_statistics_reset(&s_accum);
+    for (; j < j_end; ++j) {
+        const struct jsdrv_summary_entry_s * e = &self->trend[idx];
+        if (!isnan(e->avg)) {
+            jsdrv_statistics_from_entry(&s_tmp, e, self->trend_spe);
+            accum_combine(envelope, &s_accum, &s_tmp);
+        }
+        idx = (idx + 1) % self->trend_k;
+    }
+    if (0 == s_accum.k) {
+        entry_clear(dst);
+    } else {
+        jsdrv_statistics_to_entry(&s_accum, dst);
+    }
+    return true;
+}
 
-    struct jsdrv_summary_entry_s * entries = (struct jsdrv_summary_entry_s *) rsp->data;
+static void summary_entries(struct bufsig_s * self, uint64_t sample_id, uint64_t incr, uint64_t entries_length,
+                            bool envelope, struct jsdrv_summary_entry_s * entries) {
+    uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
     struct jsdrv_summary_entry_s * src;
-    uint64_t sample_id = sample_id_start;
 
     struct jsdrv_statistics_accum_s s_tmp;
     struct jsdrv_statistics_accum_s s_accum;
@@ -647,6 +2520,7 @@ static void summary_get(struct bufsig_s * self, struct jsdrv_buffer_response_s *
             break;
         }
     }
+    summary_update(self, ((NULL != self->trend) && (self->trend_level > tgt_level)) ? self->trend_level : tgt_level);
 
     uint64_t remaining = incr;
     uint64_t idx;
@@ -662,12 +2536,14 @@ static void summary_get(struct bufsig_s * self, struct jsdrv_buffer_response_s *
         }
         struct jsdrv_summary_entry_s * dst = &entries[entry_idx];
         if ((s_end <= sample_id_tail) || (s_start >= self->sample_id_head)) {
-            // completely out of range
-            entry_clear(dst);
+            // completely out of level 0 range, older entries may remain in the trend
+            if ((s_start >= self->sample_id_head) || !trend_summary(self, s_start, s_end, envelope, dst)) {
+                entry_clear(dst);
+            }
             continue;
         }
         if (0 == tgt_level) {
-            summary_level0_get(self, s_start, incr, dst);
+            summary_level0_get(self, s_start, incr, envelope, dst);
             continue;
         }
 
@@ -684,7 +2560,7 @@ static void summary_get(struct bufsig_s * self, struct jsdrv_buffer_response_s *
                     sz0 = remaining;
                 }
                 struct jsdrv_summary_entry_s entry_tmp;
-                summary_level0_get(self, s_start, sz0, &entry_tmp);
+                summary_level0_get(self, s_start, sz0, envelope, &entry_tmp);
                 jsdrv_statistics_from_entry(&s_accum, &entry_tmp, sz0);
                 remaining -= sz0;
                 idx = idx_aligned % self->N;
@@ -706,7 +2582,7 @@ static void summary_get(struct bufsig_s * self, struct jsdrv_buffer_response_s *
                 } else if (level) {
                     src = level_entry(self, level, idx_lvl_dn);
                     jsdrv_statistics_from_entry(&s_tmp, src, lvl_dn_step);
-                    jsdrv_statistics_combine(&s_accum, &s_accum, &s_tmp);
+                    accum_combine(envelope, &s_accum, &s_tmp);
                     JSDRV_ASSERT(remaining >= lvl_dn_step);
                     remaining -= lvl_dn_step;
                     idx = (idx + lvl_dn_step) % self->N;
@@ -720,11 +2596,17 @@ static void summary_get(struct bufsig_s * self, struct jsdrv_buffer_response_s *
 
         uint64_t lvl_k = self->levels[level - 1].k;
         uint64_t lvl_step = self->levels[level - 1].samples_per_entry;
-        uint64_t lvl_idx = idx / lvl_step;
+        uint64_t lvl_idx;
+        if (1 == valid_count) {
+            lvl_idx = ((idx + lvl_step - 1) / lvl_step) % lvl_k;
+        } else {
+            // after the carried entry, which contains idx, even when idx is aligned
+            lvl_idx = ((idx / lvl_step) + 1) % lvl_k;
+        }
         while (remaining >= lvl_step) {
             src = level_entry(self, level, lvl_idx);
             jsdrv_statistics_from_entry(&s_tmp, src, lvl_step);
-            jsdrv_statistics_combine(&s_accum, &s_accum, &s_tmp);
+            accum_combine(envelope, &s_accum, &s_tmp);
             lvl_idx = (lvl_idx + 1) % lvl_k;
             JSDRV_ASSERT(remaining >= lvl_step);
             remaining -= lvl_step;
@@ -735,9 +2617,9 @@ static void summary_get(struct bufsig_s * self, struct jsdrv_buffer_response_s *
             while (remaining) {
                 if (level == 0) {
                     struct jsdrv_summary_entry_s entry_tmp;
-                    summary_level0_get(self, s_end - remaining, remaining, &entry_tmp);
+                    summary_level0_get(self, s_end - remaining, remaining, envelope, &entry_tmp);
                     jsdrv_statistics_from_entry(&s_tmp, &entry_tmp, remaining);
-                    jsdrv_statistics_combine(&s_accum, &s_accum, &s_tmp);
+                    accum_combine(envelope, &s_accum, &s_tmp);
                     remaining = 0;
                     break;
                 }
@@ -749,7 +2631,7 @@ static void summary_get(struct bufsig_s * self, struct jsdrv_buffer_response_s *
                 } else {
                     src = level_entry(self, level, lvl_idx);
                     jsdrv_statistics_from_entry(&s_tmp, src, lvl_step);
-                    jsdrv_statistics_combine(&s_accum, &s_accum, &s_tmp);
+                    accum_combine(envelope, &s_accum, &s_tmp);
                     JSDRV_ASSERT(remaining >= lvl_step);
                     remaining -= lvl_step;
                     lvl_idx = (lvl_idx + 1) % lvl->k;
@@ -763,7 +2645,7 @@ static void summary_get(struct bufsig_s * self, struct jsdrv_buffer_response_s *
             // complete this entry
             jsdrv_statistics_from_entry(&s_tmp, src, lvl_step);
             jsdrv_statistics_adjust_k(&s_tmp, remaining);
-            jsdrv_statistics_combine(&s_accum, &s_accum, &s_tmp);
+            accum_combine(envelope, &s_accum, &s_tmp);
             jsdrv_statistics_to_entry(&s_accum, dst);
 
             // and start the next entry
@@ -775,6 +2657,138 @@ static void summary_get(struct bufsig_s * self, struct jsdrv_buffer_response_s *
         }
     }
 
+}
+
+static bool tile_is_cached(struct bufsig_s * self, uint64_t sample_id, uint64_t incr, bool envelope) {
+    uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
+    for (uint32_t i = 0; i < self->tile_count; ++i) {
+        struct bufsig_tile_s * t = &self->tiles[i];
+        if ((t->generation == self->generation) && (t->sample_id >= sample_id_tail)
+                && (t->sample_id == sample_id) && (t->incr == incr) && (t->envelope == envelope)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static struct bufsig_tile_s * tile_get(struct bufsig_s * self, uint64_t sample_id, uint64_t incr, bool envelope) {
+    uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
+    struct bufsig_tile_s * victim = NULL;
+    for (uint32_t i = 0; i < self->tile_count; ++i) {
+        struct bufsig_tile_s * t = &self->tiles[i];
+        if ((t->generation != self->generation) || (t->sample_id < sample_id_tail)) {
+            t->generation = 0;  // expired
+        } else if ((t->sample_id == sample_id) && (t->incr == incr) && (t->envelope == envelope)) {
+            t->used = ++self->tile_clock;
+            return t;
+        }
+        if ((NULL == victim) || (victim->generation && ((0 == t->generation) || (t->used < victim->used)))) {
+            victim = t;
+        }
+    }
+    summary_entries(self, sample_id, incr, JSDRV_BUFSIG_TILE_ENTRIES, envelope, victim->entries);
+    victim->generation = self->generation;
+    victim->envelope = envelope;
+    victim->sample_id = sample_id;
+    victim->incr = incr;
+    victim->used = ++self->tile_clock;
+    return victim;
+}
+
+// Compute entries by tiles aligned to incr, starting from sample_id % incr.
+static void summary_tiles(struct bufsig_s * self, uint64_t sample_id, uint64_t incr, uint64_t entries_length,
+                          bool envelope, struct jsdrv_summary_entry_s * entries) {
+    uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
+    uint64_t phase = sample_id % incr;
+    uint64_t tile_incr = incr * JSDRV_BUFSIG_TILE_ENTRIES;
+    uint64_t j_start = sample_id / incr;
+    uint64_t j_end = j_start + entries_length;
+    uint64_t j = j_start;
+    while (j < j_end) {
+        uint64_t t0 = (j / JSDRV_BUFSIG_TILE_ENTRIES) * JSDRV_BUFSIG_TILE_ENTRIES;
+        uint64_t t1 = t0 + JSDRV_BUFSIG_TILE_ENTRIES;
+        uint64_t n = ((t1 < j_end) ? t1 : j_end) - j;
+        uint64_t tile_start = phase + t0 * incr;
+        struct jsdrv_summary_entry_s * dst = entries + (j - j_start);
+        if ((tile_start >= sample_id_tail) && ((tile_start + tile_incr) <= self->sample_id_head)) {
+            struct bufsig_tile_s * t = tile_get(self, tile_start, incr, envelope);
+            memcpy(dst, &t->entries[j - t0], n * sizeof(*dst));
+        } else {
+            summary_entries(self, phase + j * incr, incr, n, envelope, dst);  // partial, at the tail or head
+        }
+        j += n;
+    }
+}
+
+bool jsdrv_bufsig_tile_prefetch(struct bufsig_s * self, uint64_t sample_id, uint64_t incr, uint64_t entries_length,
+                                bool envelope) {
+    if ((NULL == self->tiles) || (0 == incr) || (0 == self->level0_size)) {
+        return false;
+    }
+    uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
+    uint64_t phase = sample_id % incr;
+    uint64_t tile_incr = incr * JSDRV_BUFSIG_TILE_ENTRIES;
+    uint64_t j_start = sample_id / incr;
+    uint64_t j_end = j_start + entries_length;
+    for (uint64_t t0 = (j_start / JSDRV_BUFSIG_TILE_ENTRIES) * JSDRV_BUFSIG_TILE_ENTRIES;
+            t0 < j_end; t0 += JSDRV_BUFSIG_TILE_ENTRIES) {
+        uint64_t tile_start = phase + t0 * incr;
+        if ((tile_start < sample_id_tail) || ((tile_start + tile_incr) > self->sample_id_head)) {
+            continue;  // summary_tiles() computes partial tiles without the cache
+        }
+        if (!tile_is_cached(self, tile_start, incr, envelope)) {
+            tile_get(self, tile_start, incr, envelope);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void summary_get(struct bufsig_s * self, struct jsdrv_buffer_response_s * rsp, uint64_t data_size, bool envelope) {
+    rsp->response_type = JSDRV_BUFFER_RESPONSE_SUMMARY;
+    uint64_t sample_id_start = rsp->info.time_range_samples.start;
+    uint64_t sample_id_end = rsp->info.time_range_samples.end;
+    uint64_t entries_length = rsp->info.time_range_samples.length;
+    uint64_t entries_max = data_size / sizeof(struct jsdrv_summary_entry_s);
+
+    uint64_t range_req = sample_id_end + 1 - sample_id_start;
+    uint64_t incr = range_req / entries_length;
+    entries_length = range_req / incr;
+    rsp->info.time_range_samples.length = entries_length;
+    rsp->info.time_range_samples.end = sample_id_start + incr * entries_length;
+
+    if (self->level0_size == 0) {
+        JSDRV_LOGI("summary request: buffer empty");
+        rsp_clear(rsp);
+        return;
+    } else if (entries_length == 0) {
+        JSDRV_LOGI("summary request: length == 0");
+        rsp_clear(rsp);
+        return;
+    } else if (entries_length > entries_max) {
+        JSDRV_LOGI("summary request: length too long: %" PRIu64 " > %" PRIu64,
+                   entries_length, entries_max);
+        rsp_clear(rsp);
+        return;
+    }
+
+    uint64_t sample_id_tail = self->sample_id_head - self->level0_size;
+    if (self->trend_size && ((sample_id_start + incr) <= sample_id_tail)
+            && (sample_id_start < self->trend_sample_id)
+            && ((sample_id_start + incr * entries_length) > trend_tail(self))) {
+        rsp->flags |= JSDRV_BUFFER_RESPONSE_FLAG_TREND;
+    }
+    struct jsdrv_summary_entry_s * entries = (struct jsdrv_summary_entry_s *) rsp->data;
+    if (NULL == self->tiles) {
+        summary_entries(self, sample_id_start, incr, entries_length, envelope, entries);
+    } else {
+        summary_tiles(self, sample_id_start, incr, entries_length, envelope, entries);
+    }
+    if (envelope) {
+        for (uint64_t i = 0; i < entries_length; ++i) {
+            entries[i].std = NAN;
+        }
+    }
     samples_to_utc(self, &rsp->info.time_range_samples, &rsp->info.time_range_utc);
 }
 
@@ -782,11 +2796,19 @@ int32_t jsdrv_bufsig_process_request(
         struct bufsig_s * self,
         struct jsdrv_buffer_request_s * req,
         struct jsdrv_buffer_response_s * rsp) {
+    return jsdrv_bufsig_process_request_sz(self, req, rsp, DATA_SIZE_MAX);
+}
+
+int32_t jsdrv_bufsig_process_request_sz(
+        struct bufsig_s * self,
+        struct jsdrv_buffer_request_s * req,
+        struct jsdrv_buffer_response_s * rsp,
+        uint64_t data_size) {
     rsp->version = 1;
     rsp->response_type = 0;
-    rsp->rsv1_u8 = 0;
+    rsp->flags = 0;
     rsp->rsv2_u8 = 0;
-    rsp->rsv3_u32 = 0;
+    rsp->seq = 0;
     rsp->rsp_id = req->rsp_id;
     jsdrv_bufsig_info(self, &rsp->info);
 
@@ -820,21 +2842,282 @@ int32_t jsdrv_bufsig_process_request(
         return JSDRV_ERROR_PARAMETER_INVALID;
     }
     rsp->info.time_range_samples = req->time.samples;
+    uint8_t op = req->op & JSDRV_BUFFER_REQUEST_OP_MASK;
+    if (JSDRV_BUFFER_REQUEST_OP_SEARCH == op) {
+        search_get(self, req, rsp, data_size);
+        return 0;
+    } else if (JSDRV_BUFFER_REQUEST_OP_QUANTILE == op) {
+        return quantile_get(self, rsp, data_size);
+    } else if (JSDRV_BUFFER_REQUEST_OP_DEFAULT != op) {
+        JSDRV_LOGW("invalid op: %d", (int) req->op);
+        rsp_clear(rsp);
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (req->flags & JSDRV_BUFFER_REQUEST_FLAG_GAPS) {
+        gaps_get(self, rsp, data_size);
+        return 0;
+    }
+    int32_t rc = 0;
     struct jsdrv_time_range_samples_s * r = &rsp->info.time_range_samples;
     uint64_t interval = r->end - r->start + 1;
-    if (r->length && r->end) {
+    if (req->flags & JSDRV_BUFFER_REQUEST_FLAG_INTEGRAL) {
+        rc = integral_get(self, rsp);
+    } else if (r->length && r->end) {
         if ((r->length * 2) > interval) {
             r->length = interval;
-            samples_get(self, rsp);
+            samples_get(self, rsp, data_size);
+        } else if (req->flags & JSDRV_BUFFER_REQUEST_FLAG_STRIDE) {
+            strided_get(self, rsp, data_size);
         } else {
-            summary_get(self, rsp);
+            summary_get(self, rsp, data_size, 0 != (req->flags & JSDRV_BUFFER_REQUEST_FLAG_ENVELOPE));
         }
     } else if (req->time.samples.length) {
         r->end = r->start + r->length - 1;
-        samples_get(self, rsp);
+        samples_get(self, rsp, data_size);
     } else {
         r->length = interval;
-        samples_get(self, rsp);
+        samples_get(self, rsp, data_size);
     }
-    return 0;
+    if (self->gap_count && r->length && gaps_find(self, r->start, r->end, NULL, 1)) {
+        rsp->flags |= JSDRV_BUFFER_RESPONSE_FLAG_GAP;
+    }
+    return rc;
+}
+
+uint32_t jsdrv_bufsig_response_size(const struct jsdrv_buffer_response_s * rsp) {
+    uint64_t length = rsp->info.time_range_samples.length;
+    uint64_t sz = 0;
+    switch (rsp->response_type) {
+        case JSDRV_BUFFER_RESPONSE_SAMPLES:
+        case JSDRV_BUFFER_RESPONSE_STRIDED: sz = (length * rsp->info.element_size_bits + 7) / 8; break;
+        case JSDRV_BUFFER_RESPONSE_SUMMARY: sz = length * sizeof(struct jsdrv_summary_entry_s); break;
+        case JSDRV_BUFFER_RESPONSE_INTEGRAL: sz = length ? sizeof(struct jsdrv_buffer_integral_s) : 0; break;
+        case JSDRV_BUFFER_RESPONSE_GAPS: sz = length * sizeof(struct jsdrv_time_range_samples_s); break;
+        case JSDRV_BUFFER_RESPONSE_CROSSINGS: sz = length * sizeof(uint64_t); break;
+        case JSDRV_BUFFER_RESPONSE_QUANTILES: sz = length * sizeof(float); break;
+        default: break;
+    }
+    return (uint32_t) (sizeof(struct jsdrv_buffer_response_s) + sz);
+}
+
+void jsdrv_bufsig_multi_clip(struct bufsig_s * const * signals, uint32_t count, struct jsdrv_buffer_request_s * req) {
+    uint64_t head = UINT64_MAX;
+    int64_t head_utc = INT64_MAX;
+    for (uint32_t i = 0; i < count; ++i) {
+        struct bufsig_s * b = signals[i];
+        if ((NULL == b) || (0 == b->level0_size)) {
+            continue;  // responds empty
+        }
+        if (b->sample_id_head < head) {
+            head = b->sample_id_head;
+        }
+        int64_t t = jsdrv_time_from_counter(&b->time_map, b->sample_id_head - 1);
+        if (t < head_utc) {
+            head_utc = t;
+        }
+    }
+    if (UINT64_MAX == head) {
+        return;
+    }
+
+    if (JSDRV_TIME_SAMPLES == req->time_type) {
+        struct jsdrv_time_range_samples_s * r = &req->time.samples;
+        uint64_t last = head - 1;
+        if (last < r->start) {
+            return;
+        } else if (r->end > last) {
+            if (r->length && ((r->length * 2) <= (r->end - r->start + 1))) {  // summary
+                uint64_t incr = (r->end - r->start + 1) / r->length;
+                uint64_t length = (last - r->start + 1) / incr;
+                if (0 == length) {
+                    return;
+                }
+                r->length = length;
+                r->end = r->start + incr * length - 1;
+            } else {
+                r->end = last;
+                r->length = r->length ? (last - r->start + 1) : 0;
+            }
+        } else if ((0 == r->end) && r->length && ((r->start + r->length - 1) > last)) {
+            r->length = last - r->start + 1;
+        }
+    } else if (JSDRV_TIME_UTC == req->time_type) {
+        struct jsdrv_time_range_utc_s * r = &req->time.utc;
+        if ((head_utc < r->start) || (r->end <= head_utc)) {
+            return;  // open-ended UTC requests specify samples by length
+        }
+        if ((r->length > 1) && (r->end > r->start)) {
+            double f = ((double) (head_utc - r->start)) / (double) (r->end - r->start);
+            uint64_t length = (uint64_t) (f * (double) r->length);
+            if (0 == length) {
+                return;
+            }
+            r->end = r->start + (int64_t) ((double) (r->end - r->start) * ((double) length / (double) r->length));
+            r->length = length;
+        } else {
+            r->end = head_utc;
+        }
+    }
+}
+
+bool jsdrv_bufsig_snapshot_overwritten(
+        const struct bufsig_s * snapshot,
+        const struct bufsig_s * self,
+        const struct jsdrv_buffer_response_s * rsp) {
+    if ((snapshot->generation != self->generation) || (snapshot->level0_data != self->level0_data)) {
+        return true;
+    }
+    if (0 == snapshot->level0_size) {
+        return false;
+    }
+    uint64_t sample_id = rsp->info.time_range_samples.start;
+    uint64_t sample_id_tail = snapshot->sample_id_head - snapshot->level0_size;
+    if (sample_id < sample_id_tail) {
+        sample_id = sample_id_tail;
+    }
+    return self->sample_id_head > (sample_id + self->N);
+}
+
+static bool stream_is_summary(const struct jsdrv_time_range_samples_s * r) {
+    uint64_t interval = r->end - r->start + 1;
+    return r->length && r->end && ((r->length * 2) <= interval);
+}
+
+// Normalize the request to JSDRV_TIME_SAMPLES, return false if invalid.
+static bool request_to_samples(struct bufsig_s * self, struct jsdrv_buffer_request_s * req) {
+    if (!self->active || (NULL == self->level0_data) || (0 == self->hdr.element_size_bits)) {
+        return false;
+    }
+    if (JSDRV_TIME_UTC == req->time_type) {
+        if (req->time.utc.end && (req->time.utc.end < req->time.utc.start)) {
+            return false;
+        }
+        utc_to_samples(self, &req->time.utc, &req->time.samples);
+        req->time_type = JSDRV_TIME_SAMPLES;
+    } else if (JSDRV_TIME_SAMPLES != req->time_type) {
+        return false;
+    }
+    return true;
+}
+
+uint64_t jsdrv_bufsig_stream_plan(struct bufsig_s * self, struct jsdrv_buffer_request_s * req) {
+    if (!request_to_samples(self, req)) {
+        return 0;
+    }
+
+    struct jsdrv_time_range_samples_s * r = &req->time.samples;
+    if (r->end && (r->end < r->start)) {
+        return 0;
+    } else if ((0 == r->end) && (0 == r->length)) {
+        return 0;
+    } else if ((req->flags & (JSDRV_BUFFER_REQUEST_FLAG_INTEGRAL | JSDRV_BUFFER_REQUEST_FLAG_GAPS)) || req->op) {
+        return 1;  // one response
+    }
+    uint64_t chunk_max;
+    if (stream_is_summary(r)) {
+        uint64_t interval = r->end - r->start + 1;
+        uint64_t incr = interval / r->length;
+        r->length = interval / incr;
+        r->end = r->start + incr * r->length - 1;
+        chunk_max = SUMMARY_LENGTH_MAX;
+    } else {
+        if (r->end) {
+            r->length = r->end - r->start + 1;
+        }
+        r->end = r->start + r->length - 1;
+        chunk_max = (DATA_SIZE_MAX * 8) / self->hdr.element_size_bits;
+    }
+    return (r->length + chunk_max - 1) / chunk_max;
+}
+
+void jsdrv_bufsig_stream_chunk(struct bufsig_s * self, const struct jsdrv_buffer_request_s * req,
+                               uint64_t seq, struct jsdrv_buffer_request_s * chunk) {
+    const struct jsdrv_time_range_samples_s * r = &req->time.samples;
+    struct jsdrv_time_range_samples_s * c = &chunk->time.samples;
+    *chunk = *req;
+    chunk->flags &= ~JSDRV_BUFFER_REQUEST_FLAG_STREAM;
+    if ((chunk->flags & (JSDRV_BUFFER_REQUEST_FLAG_INTEGRAL | JSDRV_BUFFER_REQUEST_FLAG_GAPS)) || chunk->op) {
+        return;
+    } else if (stream_is_summary(r)) {
+        uint64_t incr = (r->end - r->start + 1) / r->length;
+        uint64_t offset = seq * SUMMARY_LENGTH_MAX;
+        c->start = r->start + incr * offset;
+        c->length = r->length - offset;
+        if (c->length > SUMMARY_LENGTH_MAX) {
+            c->length = SUMMARY_LENGTH_MAX;
+        }
+        c->end = c->start + incr * c->length - 1;
+    } else {
+        uint64_t chunk_max = (DATA_SIZE_MAX * 8) / self->hdr.element_size_bits;
+        uint64_t offset = seq * chunk_max;
+        c->start = r->start + offset;
+        c->length = r->length - offset;
+        if (c->length > chunk_max) {
+            c->length = chunk_max;
+        }
+        c->end = 0;
+    }
+}
+
+uint64_t jsdrv_bufsig_standing_plan(struct bufsig_s * self, struct jsdrv_buffer_request_s * req) {
+    uint8_t unsupported = JSDRV_BUFFER_REQUEST_FLAG_SNAPSHOT | JSDRV_BUFFER_REQUEST_FLAG_INTEGRAL
+            | JSDRV_BUFFER_REQUEST_FLAG_GAPS;
+    if ((req->flags & unsupported) || req->op || !request_to_samples(self, req)) {
+        return 0;
+    }
+    struct jsdrv_time_range_samples_s * r = &req->time.samples;
+    if ((r->end < r->start) || !stream_is_summary(r)) {
+        return 0;
+    }
+    if ((req->flags & JSDRV_BUFFER_REQUEST_FLAG_DISPLAY) && (r->length > SUMMARY_LENGTH_MAX)) {
+        return 0;
+    }
+    uint64_t incr = (r->end - r->start + 1) / r->length;
+    r->end = r->start + incr * r->length - 1;
+    return incr;
+}
+
+bool jsdrv_bufsig_standing_chunk(struct bufsig_s * self, const struct jsdrv_buffer_request_s * req,
+                                 uint64_t * next, struct jsdrv_buffer_request_s * chunk) {
+    const struct jsdrv_time_range_samples_s * r = &req->time.samples;
+    if (!self->active || (0 == self->level0_size) || (self->sample_id_head <= r->start)) {
+        return false;
+    }
+    uint64_t incr = (r->end - r->start + 1) / r->length;
+    uint64_t k_head = (self->sample_id_head - r->start) / incr;  // the completed entries
+    uint64_t tail = self->sample_id_head - self->level0_size;
+    uint64_t k_tail = (tail > r->start) ? ((tail - r->start + incr - 1) / incr) : 0;
+    uint64_t k = *next;
+    if ((UINT64_MAX == k) || (k > k_head) || ((k_head - k) > r->length)) {
+        k = (k_head > r->length) ? (k_head - r->length) : 0;  // first, restarted or behind by a viewport
+    }
+    if (k < k_tail) {
+        k = k_tail;
+    }
+    if (k >= k_head) {
+        return false;
+    }
+    uint64_t length = k_head - k;
+    if (length > SUMMARY_LENGTH_MAX) {
+        length = SUMMARY_LENGTH_MAX;
+    }
+    struct jsdrv_time_range_samples_s * c = &chunk->time.samples;
+    *chunk = *req;
+    chunk->flags &= ~(JSDRV_BUFFER_REQUEST_FLAG_STREAM | JSDRV_BUFFER_REQUEST_FLAG_STANDING
+        | JSDRV_BUFFER_REQUEST_FLAG_DISPLAY);
+    c->start = r->start + incr * k;
+    c->length = length;
+    c->end = c->start + incr * length - 1;
+    *next = k + length;
+    return true;
+}
+
+bool jsdrv_bufsig_display_chunk(struct bufsig_s * self, const struct jsdrv_buffer_request_s * req,
+                                uint64_t * next, struct jsdrv_buffer_request_s * chunk) {
+    uint64_t head = UINT64_MAX;  // always the newest viewport
+    if (!jsdrv_bufsig_standing_chunk(self, req, &head, chunk) || (head == *next)) {
+        return false;
+    }
+    *next = head;
+    return true;
 }
@@ -17,6 +17,7 @@
 // https://en.wikipedia.org/wiki/Salsa20
 
 #include "jsdrv.h"
+#include "jsdrv_prv/calibration_hash.h"
 
 #define ROUNDS 20
 #define DOUBLE_ROUNDS (ROUNDS / 2)
@@ -77,23 +78,24 @@ static void copy_u32(uint32_t * dst, const uint32_t * src, uint32_t length) {
     }
 }
 
+void jsdrv_calibration_hash_init(uint32_t * hash) {
+    for (uint32_t i = 0; i < 16; ++i) {
+        hash[i] = 0;                            // Initialize hash to zero
+    }
+}
+
 // See https://en.wikipedia.org/wiki/One-way_compression_function
-void jsdrv_calibration_hash(const uint32_t * msg, uint32_t length, uint32_t * hash) {
+void jsdrv_calibration_hash_update(uint32_t * hash, uint32_t offset, const uint32_t * msg, uint32_t length) {
     uint32_t i, j;
     uint32_t h[16];
-    // assert(0 == (length & 0x1f));            // must be multiple of 32 bytes
+    const uint32_t offset_u32 = offset >> 2;
     const uint32_t length_u32 = length >> 2;    // Compute length in 32-bit words
 
-    for (i = 0; i < 16; ++i) {
-        hash[i] = 0;                            // Initialize hash to zero
-    }
-    copy_u32(&h[0], chacha20_constant, 4);      // Initialize chaining state
-
     // Each block operates on 32 message bytes
     for (i = 0; i < length_u32; i += 8) {
         copy_u32(&h[0], hash, 4);               // [3:0]  chaining, reuse from the previous result
         copy_u32(&h[4], chacha20_constant, 3);  // [6:4]  constant, reduce attack surface
-        h[7] = i;                               // [7]    offset counter, ensure order matters
+        h[7] = offset_u32 + i;                  // [7]    offset counter, ensure order matters
         copy_u32(&h[8], &msg[i], 8);            // [15:8] message chunk
         chacha20_block(h);
 
@@ -103,3 +105,9 @@ void jsdrv_calibration_hash(const uint32_t * msg, uint32_t length, uint32_t * ha
         }
     }
 }
+
+void jsdrv_calibration_hash(const uint32_t * msg, uint32_t length, uint32_t * hash) {
+    // assert(0 == (length & 0x1f));            // must be multiple of 32 bytes
+    jsdrv_calibration_hash_init(hash);
+    jsdrv_calibration_hash_update(hash, 0, msg, length);
+}
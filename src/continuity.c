@@ -0,0 +1,69 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/continuity.h"
+#include <string.h>
+
+
+void jsdrv_continuity_clear(struct jsdrv_continuity_tracker_s * self) {
+    uint64_t sample_id = self->value.sample_id;
+    memset(&self->value, 0, sizeof(self->value));
+    self->value.version = 1;
+    self->value.sample_id = sample_id;
+    self->changed = true;
+    self->publish_time = 0;
+}
+
+void jsdrv_continuity_skip(struct jsdrv_continuity_tracker_s * self, uint64_t sample_id, uint64_t length) {
+    struct jsdrv_continuity_s * v = &self->value;
+    if (v->gap_count >= JSDRV_CONTINUITY_GAP_COUNT) {
+        memmove(&v->gaps[0], &v->gaps[1], sizeof(v->gaps[0]) * (JSDRV_CONTINUITY_GAP_COUNT - 1));
+        v->gap_count = JSDRV_CONTINUITY_GAP_COUNT - 1;
+    }
+    v->gaps[v->gap_count].sample_id = sample_id;
+    v->gaps[v->gap_count].length = length;
+    ++v->gap_count;
+    ++v->skip_count;
+    v->skip_length += length;
+    self->changed = true;
+}
+
+void jsdrv_continuity_dup(struct jsdrv_continuity_tracker_s * self, uint64_t length) {
+    ++self->value.dup_count;
+    self->value.dup_length += length;
+    self->changed = true;
+}
+
+void jsdrv_continuity_resync(struct jsdrv_continuity_tracker_s * self) {
+    ++self->value.resync_count;
+    self->changed = true;
+}
+
+void jsdrv_continuity_drop(struct jsdrv_continuity_tracker_s * self) {
+    ++self->value.drop_count;
+    self->changed = true;
+}
+
+bool jsdrv_continuity_publish_ready(struct jsdrv_continuity_tracker_s * self, uint64_t sample_id, int64_t now) {
+    if (!self->changed || (self->publish_time && ((now - self->publish_time) < JSDRV_CONTINUITY_PUBLISH_INTERVAL))) {
+        return false;
+    }
+    self->value.version = 1;
+    self->value.sample_id = sample_id;
+    self->changed = false;
+    self->publish_time = now;
+    return true;
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/cpu.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include <stdlib.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CPU_X86 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define CPU_ARM64 1
+#elif defined(__arm__) && defined(__linux__)
+#define CPU_ARM32_LINUX 1
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+
+struct cpu_name_s {
+    const char * name;
+    uint32_t mask;  // the features allowed up to and including name
+};
+
+#define X86_SSE2 (JSDRV_CPU_SSE2)
+#define X86_SSE42 (X86_SSE2 | JSDRV_CPU_SSE42)
+#define X86_AVX2 (X86_SSE42 | JSDRV_CPU_AVX2)
+#define X86_AVX512 (X86_AVX2 | JSDRV_CPU_AVX512)
+
+static const struct cpu_name_s NAMES[] = {
+    {"scalar", 0},
+    {"sse2", X86_SSE2},
+    {"sse4.2", X86_SSE42},
+    {"avx2", X86_AVX2},
+    {"avx512", X86_AVX512},
+    {"neon", JSDRV_CPU_NEON},
+};
+
+static volatile int32_t features_valid_ = 0;
+static volatile uint32_t features_ = 0;
+
+#if CPU_X86 && defined(_MSC_VER) && !defined(__clang__)
+static uint32_t x86_detect(void) {
+    int info[4];
+    uint32_t f = 0;
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+    __cpuid(info, 1);
+    if (info[3] & (1 << 26)) {
+        f |= JSDRV_CPU_SSE2;
+    }
+    if (info[2] & (1 << 20)) {
+        f |= JSDRV_CPU_SSE42;
+    }
+    if (((info[2] & (1 << 27)) == 0) || (max_leaf < 7)) {  // OSXSAVE
+        return f;
+    }
+    uint64_t xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    if (((xcr0 & 0x6) == 0x6) && (info[1] & (1 << 5))) {  // XMM and YMM state
+        f |= JSDRV_CPU_AVX2;
+    }
+    if (((xcr0 & 0xe6) == 0xe6) && (info[1] & (1 << 16))) {  // and opmask, ZMM state
+        f |= JSDRV_CPU_AVX512;
+    }
+    return f;
+}
+#elif CPU_X86
+static uint32_t x86_detect(void) {
+    // checks the OS register state support for AVX and AVX-512
+    uint32_t f = 0;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        f |= JSDRV_CPU_SSE2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        f |= JSDRV_CPU_SSE42;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        f |= JSDRV_CPU_AVX2;
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        f |= JSDRV_CPU_AVX512;
+    }
+    return f;
+}
+#endif
+
+uint32_t jsdrv_cpu_detect(void) {
+#if CPU_X86
+    return x86_detect();
+#elif CPU_ARM64
+    return JSDRV_CPU_NEON;  // required by AArch64
+#elif CPU_ARM32_LINUX
+    return (getauxval(AT_HWCAP) & HWCAP_NEON) ? JSDRV_CPU_NEON : 0;
+#else
+    return 0;
+#endif
+}
+
+int32_t jsdrv_cpu_mask(const char * name, uint32_t * mask) {
+    if ((NULL == name) || (0 == name[0])) {
+        *mask = ~0U;
+        return 0;
+    }
+    for (uint32_t i = 0; i < JSDRV_ARRAY_SIZE(NAMES); ++i) {
+        if (0 == jsdrv_cstr_casecmp(name, NAMES[i].name)) {
+            *mask = NAMES[i].mask;
+            return 0;
+        }
+    }
+    return JSDRV_ERROR_PARAMETER_INVALID;
+}
+
+uint32_t jsdrv_cpu_features(void) {
+    if (features_valid_) {
+        return features_;
+    }
+    uint32_t features = jsdrv_cpu_detect();
+    uint32_t mask = ~0U;
+    const char * env = getenv(JSDRV_CPU_ENV);
+    if (jsdrv_cpu_mask(env, &mask)) {
+        JSDRV_LOGW("%s=%s invalid, ignored", JSDRV_CPU_ENV, env);
+        mask = ~0U;
+    }
+    features &= mask;
+    features_ = features;
+    features_valid_ = 1;  // detection is idempotent, so concurrent first calls are benign
+    return features;
+}
+
+void jsdrv_cpu_features_to_str(uint32_t features, char * str, uint32_t size) {
+    static const struct cpu_name_s FLAGS[] = {
+        {"sse2", JSDRV_CPU_SSE2},
+        {"sse4.2", JSDRV_CPU_SSE42},
+        {"avx2", JSDRV_CPU_AVX2},
+        {"avx512", JSDRV_CPU_AVX512},
+        {"neon", JSDRV_CPU_NEON},
+    };
+    if (0 == size) {
+        return;
+    }
+    str[0] = 0;
+    for (uint32_t i = 0; i < JSDRV_ARRAY_SIZE(FLAGS); ++i) {
+        if (features & FLAGS[i].mask) {
+            if (str[0]) {
+                jsdrv_cstr_join(str, str, " ", size);
+            }
+            jsdrv_cstr_join(str, str, FLAGS[i].name, size);
+        }
+    }
+    if (0 == str[0]) {
+        jsdrv_cstr_copy(str, "scalar", size);
+    }
+}
+
+uint32_t jsdrv_cpu_count(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    long count = (long) info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return (count < 1) ? 1 : (uint32_t) count;
+}
@@ -0,0 +1,572 @@
+/*
+* Copyright 2023 Jetperch LLC
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#define JSDRV_LOG_LEVEL JSDRV_LOG_LEVEL_ALL
+#include "jsdrv_prv/dispatch.h"
+#include "jsdrv_prv/atomic.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/event.h"
+#include "jsdrv_prv/list.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/msg_queue.h"
+#include "jsdrv_prv/mutex.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/pubsub.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv_prv/trace.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/time.h"
+#include "tinyprintf.h"
+#include <string.h>
+#if !_WIN32
+#include <poll.h>
+#endif
+
+
+#define DISPATCH_THREAD_POLL_MS  (1000)  // queue thread drop publish check
+#define QUEUE_BLOCK_POLL_MS      (100)
+#define QUEUE_DEPTH_MAX          (65536U)
+#define QUEUE_DROP_PUBLISH_INTERVAL  (JSDRV_TIME_SECOND)
+#define SHARD_MAP_SIZE           (128U)  // power of 2, at most half used
+
+
+struct dispatch_thread_s {
+    struct jsdrv_dispatch_s * parent;
+    struct msg_queue_s * q;             // frontend thread to this thread
+    jsdrv_thread_t thread;
+    volatile bool do_exit;
+};
+
+// Bounded delivery queue and thread for one JSDRV_SFLAG_QUEUED subscriber.
+struct dispatch_queue_s {
+    struct jsdrv_pubsub_queue_s api;        // must be first
+    struct jsdrv_dispatch_s * parent;
+    struct jsdrv_list_s item;               // parent->queues or parent->queues_closed
+    struct jsdrv_pubsub_subscriber_s sub;
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    uint32_t id;
+    uint8_t policy;                         // jsdrv_subscribe_queue_policy_e
+    uint32_t depth;
+
+    jsdrv_os_mutex_t mutex;                 // protects the fields below
+    struct jsdrvp_msg_s ** ring;
+    uint32_t head;                          // next write index
+    uint32_t count;
+    bool closing;
+    volatile int32_t * barrier_pending;
+    struct jsdrvp_msg_s * barrier_rsp;
+
+    jsdrv_os_event_t ev_msg;                // signalled on push and close
+    jsdrv_os_event_t ev_space;              // signalled on pop
+    volatile int32_t drops;                 // dropped and coalesced messages
+    volatile int32_t exited;
+    volatile bool do_exit;
+    jsdrv_thread_t thread;
+};
+
+// Assign each device shard to a thread, see jsdrv_pubsub_shard_hash().
+struct shard_s {
+    uint32_t hash;                          // 0 for unused
+    uint32_t thread_idx;
+};
+
+struct jsdrv_dispatch_s {
+    struct jsdrv_context_s * context;
+    struct jsdrv_pubsub_dispatch_s pubsub;
+    uint32_t thread_count;
+    struct dispatch_thread_s threads[JSDRV_DISPATCH_THREADS_MAX];
+    struct shard_s shards[SHARD_MAP_SIZE];  // frontend thread only
+    uint32_t shard_count;
+    jsdrv_os_mutex_t mutex;                 // protects the queue lists
+    struct jsdrv_list_s queues;             // dispatch_queue_s
+    struct jsdrv_list_s queues_closed;      // dispatch_queue_s awaiting join
+    uint32_t queue_id_next;
+};
+
+static void event_wait(jsdrv_os_event_t ev, uint32_t timeout_ms) {
+#if _WIN32
+    WaitForSingleObject(ev, timeout_ms);
+#else
+    struct pollfd fds = {
+            .fd = ev->fd_poll,
+            .events = ev->events,
+            .revents = 0,
+    };
+    poll(&fds, 1, (int) timeout_ms);
+#endif
+}
+
+static void barrier_arrive(struct jsdrv_dispatch_s * self, volatile int32_t * pending,
+                           struct jsdrvp_msg_s * rsp, bool deliver) {
+    if (0 != jsdrv_atomic_add(pending, -1)) {
+        return;
+    }
+    jsdrv_free((void *) pending);
+    if (NULL == rsp) {
+        // no return code requested
+    } else if (deliver) {
+        jsdrvp_backend_send(self->context, rsp);
+    } else {
+        jsdrvp_msg_free(self->context, rsp);
+    }
+}
+
+static struct jsdrvp_msg_s * envelope_alloc(struct jsdrv_dispatch_s * self) {
+    struct jsdrvp_msg_s * e = jsdrvp_msg_alloc(self->context);
+    e->value.type = JSDRV_UNION_BIN;
+    e->value.value.bin = e->payload.bin;
+    e->payload.dispatch.msg = NULL;
+    e->payload.dispatch.rsp = NULL;
+    e->payload.dispatch.barrier_pending = NULL;
+    e->payload.dispatch.count = 0;
+    return e;
+}
+
+static void envelope_process(struct jsdrv_dispatch_s * self, struct jsdrvp_msg_s * e, bool deliver) {
+    struct jsdrvp_payload_dispatch_s * d = &e->payload.dispatch;
+    if (d->msg) {
+        for (uint32_t idx = 0; deliver && (idx < d->count); ++idx) {
+            struct jsdrv_pubsub_subscriber_s * s = &d->subscribers[idx];
+            s->external_fn(s->user_data, d->msg->topic, &d->msg->value);
+        }
+        jsdrvp_msg_free(self->context, d->msg);
+    } else if (d->barrier_pending) {
+        barrier_arrive(self, d->barrier_pending, d->rsp, deliver);
+    }
+    jsdrvp_msg_free(self->context, e);
+}
+
+static bool handle_q(struct dispatch_thread_s * th) {
+    struct jsdrvp_msg_s * e = msg_queue_pop_immediate(th->q);
+    if (NULL == e) {
+        return false;
+    }
+    if (0 == strcmp(JSDRV_MSG_FINALIZE, e->topic)) {
+        th->do_exit = true;
+        jsdrvp_msg_free(th->parent->context, e);
+        return false;
+    }
+    JSDRV_TRACE_START(t_start);
+    envelope_process(th->parent, e, true);
+    JSDRV_TRACE_END("dispatch", t_start, 0);
+    return true;
+}
+
+static THREAD_RETURN_TYPE dispatch_thread(THREAD_ARG_TYPE lpParam) {
+    struct dispatch_thread_s * th = (struct dispatch_thread_s *) lpParam;
+    JSDRV_LOGI("dispatch thread started");
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_DISPATCH);
+
+#if _WIN32
+    HANDLE handles[1];
+    handles[0] = msg_queue_handle_get(th->q);
+#else
+    struct pollfd fds[1];
+    fds[0].fd = msg_queue_handle_get(th->q);
+    fds[0].events = POLLIN;
+#endif
+
+    while (!th->do_exit) {
+#if _WIN32
+        WaitForMultipleObjects(1, handles, false, INFINITE);  // exit is message-driven
+#else
+        poll(fds, 1, -1);
+#endif
+        // note: ResetEvent handled automatically by msg_queue_pop_immediate
+        while (handle_q(th)) {
+            ;
+        }
+    }
+    JSDRV_LOGI("dispatch thread done");
+    jsdrv_thread_unregister();
+    THREAD_RETURN();
+}
+
+/**
+ * @brief Get the thread for a shard.
+ *
+ * Shards are assigned to threads round-robin on first use, so
+ * that each device has a dedicated thread when thread_count is
+ * at least the device count.  Shards are never removed, which
+ * keeps the assignment stable across device reconnects.
+ */
+static uint32_t shard_thread_idx(struct jsdrv_dispatch_s * self, uint32_t hash) {
+    uint32_t idx = hash & (SHARD_MAP_SIZE - 1);
+    while (self->shards[idx].hash) {
+        if (self->shards[idx].hash == hash) {
+            return self->shards[idx].thread_idx;
+        }
+        idx = (idx + 1) & (SHARD_MAP_SIZE - 1);
+    }
+    if ((self->shard_count * 2) >= SHARD_MAP_SIZE) {
+        return hash % self->thread_count;  // map full
+    }
+    self->shards[idx].hash = hash;
+    self->shards[idx].thread_idx = self->shard_count++ % self->thread_count;
+    return self->shards[idx].thread_idx;
+}
+
+static void on_data(void * user_data, struct jsdrvp_msg_s * msg, uint32_t hash,
+                    const struct jsdrv_pubsub_subscriber_s * subscribers, uint32_t count) {
+    struct jsdrv_dispatch_s * self = (struct jsdrv_dispatch_s *) user_data;
+    struct dispatch_thread_s * th = &self->threads[shard_thread_idx(self, hash)];
+    struct jsdrvp_msg_s * e = envelope_alloc(self);
+    if (count > JSDRV_PUBSUB_DISPATCH_SUBSCRIBERS_MAX) {
+        count = JSDRV_PUBSUB_DISPATCH_SUBSCRIBERS_MAX;
+    }
+    e->payload.dispatch.msg = jsdrvp_msg_retain(msg);
+    e->payload.dispatch.count = count;
+    memcpy(e->payload.dispatch.subscribers, subscribers, count * sizeof(*subscribers));
+    msg_queue_push(th->q, e);
+}
+
+static void queue_publish(struct dispatch_queue_s * q, const char * subtopic, const struct jsdrv_union_s * value) {
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    tfp_snprintf(topic, sizeof(topic), "@/subq/%lu/%s", (unsigned long) q->id, subtopic);
+    jsdrv_publish(q->parent->context, topic, value, 0);
+}
+
+static struct jsdrvp_msg_s * queue_pop(struct dispatch_queue_s * q, bool * closing) {
+    struct jsdrvp_msg_s * msg = NULL;
+    jsdrv_os_mutex_lock(q->mutex);
+    if (q->count) {
+        uint32_t tail = (q->head + q->depth - q->count) % q->depth;
+        msg = q->ring[tail];
+        q->ring[tail] = NULL;
+        --q->count;
+    }
+    *closing = q->closing;
+    jsdrv_os_mutex_unlock(q->mutex);
+    if (msg) {
+        jsdrv_os_event_signal(q->ev_space);
+    }
+    return msg;
+}
+
+static THREAD_RETURN_TYPE queue_thread(THREAD_ARG_TYPE lpParam) {
+    struct dispatch_queue_s * q = (struct dispatch_queue_s *) lpParam;
+    struct jsdrv_dispatch_s * self = q->parent;
+    int32_t drops_published = 0;
+    int64_t drops_time = 0;
+    bool closing = false;
+    JSDRV_LOGI("queue %lu thread started: %s", (unsigned long) q->id, q->topic);
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_DISPATCH);
+    queue_publish(q, "topic", &jsdrv_union_cstr_r(q->topic));
+    queue_publish(q, "drop", &jsdrv_union_u32_r(0));
+
+    while (!q->do_exit) {
+        jsdrv_os_event_reset(q->ev_msg);
+        struct jsdrvp_msg_s * msg = queue_pop(q, &closing);
+        if (msg) {
+            jsdrv_pubsub_external_call(&q->sub, msg);
+            jsdrvp_msg_free(self->context, msg);
+            continue;
+        } else if (closing) {
+            break;
+        }
+        int32_t drops = jsdrv_atomic_load(&q->drops);
+        int64_t t = jsdrv_time_utc();
+        if ((drops != drops_published) && ((t - drops_time) >= QUEUE_DROP_PUBLISH_INTERVAL)) {
+            drops_published = drops;
+            drops_time = t;
+            queue_publish(q, "drop", &jsdrv_union_u32_r((uint32_t) drops));
+        }
+        event_wait(q->ev_msg, DISPATCH_THREAD_POLL_MS);
+    }
+
+    jsdrv_os_mutex_lock(q->mutex);
+    volatile int32_t * pending = q->barrier_pending;
+    struct jsdrvp_msg_s * rsp = q->barrier_rsp;
+    q->barrier_pending = NULL;
+    q->barrier_rsp = NULL;
+    jsdrv_os_mutex_unlock(q->mutex);
+    if (pending) {
+        barrier_arrive(self, pending, rsp, !q->do_exit);
+    }
+    JSDRV_LOGI("queue %lu thread done", (unsigned long) q->id);
+    jsdrv_thread_unregister();
+    jsdrv_atomic_store(&q->exited, 1);
+    THREAD_RETURN();
+}
+
+static void queue_push(struct jsdrv_pubsub_queue_s * api, struct jsdrvp_msg_s * msg) {
+    struct dispatch_queue_s * q = (struct dispatch_queue_s *) api;
+    struct jsdrvp_msg_s * drop = NULL;
+    while (1) {
+        if (q->policy == JSDRV_SUBSCRIBE_QUEUE_BLOCK) {
+            jsdrv_os_event_reset(q->ev_space);
+        }
+        jsdrv_os_mutex_lock(q->mutex);
+        if (q->closing || q->do_exit) {
+            jsdrv_os_mutex_unlock(q->mutex);
+            return;
+        }
+        if (q->policy == JSDRV_SUBSCRIBE_QUEUE_COALESCE) {
+            for (uint32_t i = 0; i < q->count; ++i) {
+                uint32_t idx = (q->head + q->depth - 1 - i) % q->depth;
+                if (0 == strcmp(q->ring[idx]->topic, msg->topic)) {
+                    drop = q->ring[idx];
+                    q->ring[idx] = jsdrvp_msg_retain(msg);
+                    jsdrv_os_mutex_unlock(q->mutex);
+                    jsdrv_atomic_add(&q->drops, 1);
+                    jsdrvp_msg_free(q->parent->context, drop);
+                    jsdrv_os_event_signal(q->ev_msg);
+                    return;
+                }
+            }
+        }
+        if (q->count < q->depth) {
+            break;
+        } else if (q->policy == JSDRV_SUBSCRIBE_QUEUE_BLOCK) {
+            jsdrv_os_mutex_unlock(q->mutex);
+            event_wait(q->ev_space, QUEUE_BLOCK_POLL_MS);
+        } else {  // drop oldest
+            uint32_t tail = (q->head + q->depth - q->count) % q->depth;
+            drop = q->ring[tail];
+            q->ring[tail] = NULL;
+            --q->count;
+            jsdrv_atomic_add(&q->drops, 1);
+            break;
+        }
+    }
+    q->ring[q->head] = jsdrvp_msg_retain(msg);
+    q->head = (q->head + 1) % q->depth;
+    ++q->count;
+    jsdrv_os_mutex_unlock(q->mutex);
+    if (drop) {
+        jsdrvp_msg_free(q->parent->context, drop);
+    }
+    jsdrv_os_event_signal(q->ev_msg);
+}
+
+static void queue_free(struct dispatch_queue_s * q) {
+    struct jsdrv_dispatch_s * self = q->parent;
+    if (q->ring) {
+        for (uint32_t i = 0; i < q->depth; ++i) {
+            if (q->ring[i]) {
+                jsdrvp_msg_free(self->context, q->ring[i]);
+            }
+        }
+        jsdrv_free(q->ring);
+    }
+    if (q->barrier_pending) {
+        barrier_arrive(self, q->barrier_pending, q->barrier_rsp, false);
+    }
+    if (q->ev_msg) {
+        jsdrv_os_event_free(q->ev_msg);
+    }
+    if (q->ev_space) {
+        jsdrv_os_event_free(q->ev_space);
+    }
+    if (q->mutex) {
+        jsdrv_os_mutex_free(q->mutex);
+    }
+    jsdrv_free(q);
+}
+
+static void queues_reap(struct jsdrv_dispatch_s * self) {
+    struct jsdrv_list_s * item;
+    struct jsdrv_list_s reap;
+    jsdrv_list_initialize(&reap);
+    jsdrv_os_mutex_lock(self->mutex);
+    jsdrv_list_foreach(&self->queues_closed, item) {
+        struct dispatch_queue_s * q = JSDRV_CONTAINER_OF(item, struct dispatch_queue_s, item);
+        if (jsdrv_atomic_load(&q->exited)) {
+            jsdrv_list_remove(item);
+            jsdrv_list_add_tail(&reap, item);
+        }
+    }
+    jsdrv_os_mutex_unlock(self->mutex);
+    while (NULL != (item = jsdrv_list_remove_head(&reap))) {
+        struct dispatch_queue_s * q = JSDRV_CONTAINER_OF(item, struct dispatch_queue_s, item);
+        jsdrv_thread_join(&q->thread, 1000);
+        queue_free(q);
+    }
+}
+
+static struct jsdrv_pubsub_queue_s * on_queue_open(void * user_data, const char * topic,
+        const struct jsdrv_pubsub_subscriber_s * subscriber) {
+    struct jsdrv_dispatch_s * self = (struct jsdrv_dispatch_s *) user_data;
+    queues_reap(self);
+    struct dispatch_queue_s * q = jsdrv_alloc_clr(sizeof(struct dispatch_queue_s));
+    q->api.push = queue_push;
+    q->parent = self;
+    jsdrv_list_initialize(&q->item);
+    q->sub = *subscriber;
+    q->sub.queue = NULL;
+    jsdrv_cstr_copy(q->topic, topic, sizeof(q->topic));
+    q->id = self->queue_id_next++;
+    q->policy = subscriber->queue_policy;
+    q->depth = subscriber->queue_depth ? subscriber->queue_depth : JSDRV_SUBSCRIBE_QUEUE_DEPTH_DEFAULT;
+    if (q->depth > QUEUE_DEPTH_MAX) {
+        q->depth = QUEUE_DEPTH_MAX;
+    }
+    q->ring = jsdrv_alloc_clr(q->depth * sizeof(struct jsdrvp_msg_s *));
+    q->mutex = jsdrv_os_mutex_alloc("dispatch_queue");
+    q->ev_msg = jsdrv_os_event_alloc();
+    q->ev_space = jsdrv_os_event_alloc();
+    if (!q->mutex || !q->ev_msg || !q->ev_space || jsdrv_thread_create(&q->thread, queue_thread, q, 0)) {
+        JSDRV_LOGE("queue %lu create failed: %s", (unsigned long) q->id, topic);
+        queue_free(q);
+        return NULL;
+    }
+    jsdrv_os_mutex_lock(self->mutex);
+    jsdrv_list_add_tail(&self->queues, &q->item);
+    jsdrv_os_mutex_unlock(self->mutex);
+    return &q->api;
+}
+
+static void on_barrier(void * user_data, struct jsdrvp_msg_s * rsp,
+                       struct jsdrv_pubsub_queue_s * const * queues, uint32_t count) {
+    struct jsdrv_dispatch_s * self = (struct jsdrv_dispatch_s *) user_data;
+    volatile int32_t * pending = jsdrv_alloc(sizeof(int32_t));
+    jsdrv_atomic_store(pending, (int32_t) (self->thread_count + count + 1));
+    for (uint32_t idx = 0; idx < count; ++idx) {
+        struct dispatch_queue_s * q = (struct dispatch_queue_s *) queues[idx];
+        jsdrv_os_mutex_lock(self->mutex);
+        jsdrv_list_remove(&q->item);
+        jsdrv_list_add_tail(&self->queues_closed, &q->item);
+        jsdrv_os_mutex_unlock(self->mutex);
+        jsdrv_os_mutex_lock(q->mutex);
+        q->closing = true;
+        q->barrier_pending = pending;
+        q->barrier_rsp = rsp;
+        jsdrv_os_mutex_unlock(q->mutex);
+        jsdrv_os_event_signal(q->ev_msg);
+    }
+    for (uint32_t idx = 0; idx < self->thread_count; ++idx) {
+        struct jsdrvp_msg_s * e = envelope_alloc(self);
+        e->payload.dispatch.rsp = rsp;
+        e->payload.dispatch.barrier_pending = pending;
+        msg_queue_push(self->threads[idx].q, e);
+    }
+    barrier_arrive(self, pending, rsp, true);  // this caller's reference
+    queues_reap(self);
+}
+
+struct jsdrv_dispatch_s * jsdrv_dispatch_initialize(struct jsdrv_context_s * context, uint32_t thread_count) {
+    if (thread_count > JSDRV_DISPATCH_THREADS_MAX) {
+        JSDRV_LOGW("dispatch thread_count %u clamped to %u", thread_count, JSDRV_DISPATCH_THREADS_MAX);
+        thread_count = JSDRV_DISPATCH_THREADS_MAX;
+    }
+    struct jsdrv_dispatch_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_dispatch_s));
+    self->context = context;
+    self->pubsub.user_data = self;
+    self->pubsub.data = thread_count ? on_data : NULL;
+    self->pubsub.queue_open = on_queue_open;
+    self->pubsub.barrier = on_barrier;
+    jsdrv_list_initialize(&self->queues);
+    jsdrv_list_initialize(&self->queues_closed);
+    self->mutex = jsdrv_os_mutex_alloc("dispatch");
+    if (NULL == self->mutex) {
+        jsdrv_free(self);
+        return NULL;
+    }
+    for (uint32_t idx = 0; idx < thread_count; ++idx) {
+        struct dispatch_thread_s * th = &self->threads[idx];
+        th->parent = self;
+        th->q = msg_queue_init_spsc(MSG_QUEUE_SPSC_CAPACITY_DEFAULT);
+        if ((NULL == th->q) || jsdrv_thread_create(&th->thread, dispatch_thread, th, 1)) {
+            JSDRV_LOGE("dispatch thread %u create failed", idx);
+            if (th->q) {
+                msg_queue_finalize(th->q);
+                th->q = NULL;
+            }
+            jsdrv_dispatch_finalize(self);
+            return NULL;
+        }
+        self->thread_count = idx + 1;
+    }
+    JSDRV_LOGI("dispatch initialized with %u threads", thread_count);
+    return self;
+}
+
+static void queues_finalize(struct jsdrv_dispatch_s * self, struct jsdrv_list_s * list) {
+    struct jsdrv_list_s * item;
+    while (NULL != (item = jsdrv_list_remove_head(list))) {
+        struct dispatch_queue_s * q = JSDRV_CONTAINER_OF(item, struct dispatch_queue_s, item);
+        q->do_exit = true;
+        jsdrv_os_event_signal(q->ev_msg);
+        jsdrv_os_event_signal(q->ev_space);
+        jsdrv_thread_join(&q->thread, 1000);
+        queue_free(q);
+    }
+    (void) self;
+}
+
+void jsdrv_dispatch_finalize(struct jsdrv_dispatch_s * self) {
+    if (NULL == self) {
+        return;
+    }
+    queues_finalize(self, &self->queues);
+    queues_finalize(self, &self->queues_closed);
+    for (uint32_t idx = 0; idx < self->thread_count; ++idx) {
+        struct dispatch_thread_s * th = &self->threads[idx];
+        struct jsdrvp_msg_s * e = jsdrvp_msg_alloc_value(self->context, JSDRV_MSG_FINALIZE, &jsdrv_union_u8(0));
+        msg_queue_push(th->q, e);
+    }
+    for (uint32_t idx = 0; idx < self->thread_count; ++idx) {
+        struct dispatch_thread_s * th = &self->threads[idx];
+        jsdrv_thread_join(&th->thread, 1000);
+    }
+    for (uint32_t idx = 0; idx < self->thread_count; ++idx) {
+        struct dispatch_thread_s * th = &self->threads[idx];
+        struct jsdrvp_msg_s * e;
+        while (NULL != (e = msg_queue_pop_immediate(th->q))) {
+            if (0 == strcmp(JSDRV_MSG_FINALIZE, e->topic)) {
+                jsdrvp_msg_free(self->context, e);
+            } else {
+                envelope_process(self, e, false);
+            }
+        }
+        msg_queue_finalize(th->q);
+        th->q = NULL;
+    }
+    jsdrv_os_mutex_free(self->mutex);
+    jsdrv_free(self);
+}
+
+const struct jsdrv_pubsub_dispatch_s * jsdrv_dispatch_pubsub(struct jsdrv_dispatch_s * self) {
+    return &self->pubsub;
+}
+
+static bool queues_is_current(struct jsdrv_list_s * list) {
+    struct jsdrv_list_s * item;
+    jsdrv_list_foreach(list, item) {
+        struct dispatch_queue_s * q = JSDRV_CONTAINER_OF(item, struct dispatch_queue_s, item);
+        if (jsdrv_thread_is_current(&q->thread)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool jsdrv_dispatch_is_current(struct jsdrv_dispatch_s * self) {
+    bool rv = false;
+    if (NULL == self) {
+        return false;
+    }
+    for (uint32_t idx = 0; idx < self->thread_count; ++idx) {
+        if (jsdrv_thread_is_current(&self->threads[idx].thread)) {
+            return true;
+        }
+    }
+    jsdrv_os_mutex_lock(self->mutex);
+    rv = queues_is_current(&self->queues) || queues_is_current(&self->queues_closed);
+    jsdrv_os_mutex_unlock(self->mutex);
+    return rv;
+}
@@ -22,13 +22,38 @@
 
 #include "jsdrv_prv/downsample.h"
 #include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/js220_i128.h"
 #include "jsdrv_prv/log.h"
 #include "jsdrv_prv/platform.h"
 #include <math.h>
 #include <limits.h>
+#if _WIN32
+#include <windows.h>
+#define LOCK() AcquireSRWLockExclusive(&lock_)
+#define UNLOCK() ReleaseSRWLockExclusive(&lock_)
+#else
+#include <pthread.h>
+#define LOCK() pthread_mutex_lock(&lock_)
+#define UNLOCK() pthread_mutex_unlock(&lock_)
+#endif
 
 #define BUFFER_SIZE (128U)              // must be power of 2, <= 256
 #define BUFFER_MASK (BUFFER_SIZE - 1U)
+#define NAN_AGE_MAX (255U)
+#define FILTERS_MAX (14U)              // enough to go from 2 Msps to 1 sps
+
+#define RATIONAL_L_MAX (4096U)         // the maximum interpolation factor
+#define RATIONAL_COEF_MAX (1U << 21)   // the maximum coefficients for one ratio
+#define RATIONAL_OVERSAMPLE (4U)       // the minimum polyphase input rate / output rate
+#define RATIONAL_ZERO_CROSSINGS (24U)  // windowed sinc zero crossings on each side
+#define RATIONAL_CUTOFF (0.85)         // the cutoff frequency relative to the output Nyquist
+#define RATIONAL_KAISER_BETA (8.0)
+
+#define CIC_STAGES (3U)
+#define CIC_DECIMATE_MAX (1U << 21)    // so that the gain, decimate_factor ** CIC_STAGES, fits in 64 bits
+#define CIC_COMP_SHIFT (5U)
+#define CIC_COMP_CENTER (42)           // 3-tap droop compensation [-5, 42, -5] / 32
+#define CIC_COMP_SIDE (-5)
 
 #define COEF_2_SIZE (39U)
 #define COEF_2_CENTER (COEF_2_SIZE >> 1)  // index
@@ -67,39 +92,363 @@ struct filter_s {
     uint8_t taps_length;
     uint8_t taps_center;
     uint8_t buffer_idx;
-    int64_t buffer[BUFFER_SIZE];
+    uint8_t nan_age;  // writes since the most recent NaN, saturating
+    // Each sample is written twice, at idx and idx + BUFFER_SIZE, so
+    // that the most recent taps_length samples are always contiguous.
+    int64_t buffer[2 * BUFFER_SIZE];
     uint32_t downsample_factor;
     uint32_t downsample_count;
 };
 
 
+/**
+ * @brief The polyphase filter coefficients for one ratio.
+ *
+ * Shared by all instances with the same ratio, see coef_acquire().
+ */
+struct rational_coef_s {
+    struct rational_coef_s * next;  // guarded by lock_
+    uint32_t refcount;              // guarded by lock_
+    uint32_t up;                    // L, the interpolation factor
+    uint32_t down;                  // M, the decimation factor
+    uint32_t taps;                  // K, the taps for each phase
+    float coef[];                   // [phase][taps], oldest sample first
+};
+
+// The polyphase stage for JSDRV_DOWNSAMPLE_MODE_RATIONAL, after the integer stages.
+struct rational_s {
+    struct rational_coef_s * table;
+    uint32_t phase;       // the next output phase, less than up
+    uint32_t wait;        // the inputs to skip before the next output
+    bool seeded;          // false until the first input after clear
+    uint32_t hist_idx;
+    float hist[];         // 2 * taps, each sample written at idx and idx + taps
+};
+
+/*
+ * The cascaded integrator comb stage for JSDRV_DOWNSAMPLE_MODE_CIC.
+ *
+ * The integrators grow without bound, so they add and subtract modulo
+ * 2^128.  The comb output is exact as long as it fits, and
+ * |x - offset| * gain always fits.
+ */
+struct cic_s {
+    js220_i128 integrator[CIC_STAGES];
+    js220_i128 comb[CIC_STAGES];  // the previous integrator output at each comb
+    uint64_t gain;      // decimate_factor ** CIC_STAGES
+    int64_t offset;     // the first input, subtracted to start at steady state
+    int64_t hold;       // the most recent non-NaN input - offset
+    uint32_t window;    // the impulse response length in input samples
+    uint32_t nan_age;   // inputs since the most recent NaN, saturating at window
+    uint32_t count;     // the inputs until the next output
+    bool compensate;    // JSDRV_DOWNSAMPLE_MODE_CIC_COMPENSATED
+    bool comp_seeded;
+    int64_t comp[3];    // the compensation FIR history, oldest first
+};
+
+#if _WIN32
+static SRWLOCK lock_ = SRWLOCK_INIT;
+#else
+static pthread_mutex_t lock_ = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static struct rational_coef_s * coef_cache_ = NULL;  // guarded by lock_
+
 struct jsdrv_downsample_s {
     enum jsdrv_downsample_mode_e mode;
     uint32_t sample_rate_in;
     uint32_t sample_rate_out;
-    uint32_t decimate_factor;
+    uint32_t decimate_factor;  // 0 for a non-integer ratio
+    uint32_t align;            // the first input sample_id is a multiple of align
     uint32_t sample_delay;
-    struct filter_s filters[14];  // enough to go from 2 Msps to 1 sps
+    struct rational_s * rational;  // JSDRV_DOWNSAMPLE_MODE_RATIONAL
+    struct cic_s cic;              // JSDRV_DOWNSAMPLE_MODE_CIC*
+    struct filter_s filters[FILTERS_MAX];
     uint64_t sample_count;
     int64_t avg;
+    uint32_t hist[16];  // JSDRV_DOWNSAMPLE_MODE_MAJORITY
 };
 
 
-struct jsdrv_downsample_s * jsdrv_downsample_alloc(uint32_t sample_rate_in, uint32_t sample_rate_out, int mode) {
+#define MC_LANES JSDRV_DOWNSAMPLE_MC_CHANNELS_MAX
+
+// The buffers for one multi-channel stage, interleaved by channel.
+struct filter_mc_s {
+    const int32_t * taps;
+    uint8_t taps_length;
+    uint8_t taps_center;
+    uint8_t buffer_idx;
+    uint8_t nan_age[MC_LANES];  // writes since the most recent NaN, saturating
+    uint32_t downsample_factor;
+    uint32_t downsample_count;
+    // buffer[idx * lanes + lane], each sample written at idx and idx + BUFFER_SIZE.
+    // NaN samples store 0 so that every lane computes without overflow.
+    int64_t buffer[2 * BUFFER_SIZE * MC_LANES];
+};
+
+struct jsdrv_downsample_mc_s {
+    enum jsdrv_downsample_mode_e mode;
+    uint32_t channel_count;
+    uint32_t lanes;  // channel_count rounded up to 4 or MC_LANES
+    uint32_t decimate_factor;
+    uint32_t sample_delay;
+    uint32_t filter_count;
+    uint64_t sample_count;
+    int64_t avg[MC_LANES];
+    struct filter_mc_s filters[];
+};
+
+/**
+ * @brief Factor the decimate_factor into the 2 and 5 filter stages.
+ *
+ * @param decimate_factor The total decimation.
+ * @param[out] count_2 The number of factor-2 stages.
+ * @param[out] count_5 The number of factor-5 stages.
+ * @return 0 or error code.
+ */
+static int32_t stages_factor(uint32_t decimate_factor, uint32_t * count_2, uint32_t * count_5) {
+    *count_2 = 0;
+    *count_5 = 0;
+    while (0 == (decimate_factor & 1)) {
+        decimate_factor >>= 1;
+        ++*count_2;
+    }
+    while (0 == (decimate_factor % 5)) {
+        decimate_factor /= 5;
+        ++*count_5;
+    }
+    if (1 != decimate_factor) {
+        JSDRV_LOGE("Cannot downsample: sample_rate_out * M != sample_rate_in");
+        return 1;
+    }
+    if ((*count_2 + *count_5) > FILTERS_MAX) {
+        JSDRV_LOGE("too much downsampling");
+        return 1;
+    }
+    return 0;
+}
+
+static uint32_t decimate_factor_get(uint32_t sample_rate_in, uint32_t sample_rate_out) {
     if (sample_rate_in < sample_rate_out) {
         JSDRV_LOGE("Not downsample: sample_rate_in < sample_rate_out: %lu < %lu",
                    sample_rate_in, sample_rate_out);
-        return NULL;
+        return 0;
     }
     if (0 == sample_rate_out) {
         JSDRV_LOGE("Cannot downsample: sample_rate_out cannot be 0");
-        return NULL;
+        return 0;
     }
-
     uint32_t decimate_factor = sample_rate_in / sample_rate_out;
     if ((sample_rate_out * decimate_factor) != sample_rate_in) {
         JSDRV_LOGE("Cannot downsample: sample_rate_out * M != sample_rate_in");
+        return 0;
+    }
+    return decimate_factor;
+}
+
+// Configure the integer filter stages and compute their delay.
+static void stages_configure(struct jsdrv_downsample_s * self, uint32_t count_2, uint32_t count_5) {
+    // Each stage computes taps_length multiplies per output, so a stage at
+    // input rate r costs r * taps_length / factor.  Running the stages in
+    // increasing taps_length / (factor - 1) minimizes the total cost, which
+    // places the factor-5 stages (89 / 4) before the factor-2 stages (39 / 1).
+    uint32_t rate_div = 1;
+    for (uint32_t idx = 0; idx < (count_2 + count_5); ++idx) {
+        struct filter_s * f = &self->filters[idx];
+        if (idx < count_5) {
+            f->taps = coef_5;
+            f->taps_length = COEF_5_SIZE;
+            f->taps_center = COEF_5_CENTER;
+            f->downsample_factor = 5;
+        } else {
+            f->taps = coef_2;
+            f->taps_length = COEF_2_SIZE;
+            f->taps_center = COEF_2_CENTER;
+            f->downsample_factor = 2;
+        }
+        self->sample_delay += f->taps_center * rate_div;
+        rate_div *= f->downsample_factor;
+    }
+}
+
+static uint32_t gcd_u32(uint32_t a, uint32_t b) {
+    while (b) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// The zeroth order modified Bessel function of the first kind.
+static double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (uint32_t k = 1; k < 200; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < (1e-15 * sum)) {
+            break;
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Design the Kaiser windowed sinc polyphase filter for a ratio.
+ *
+ * @param up The interpolation factor L.
+ * @param down The decimation factor M, at least up.
+ * @param taps The taps for each phase.
+ * @return The new coefficients with refcount 1.
+ *
+ * The prototype lowpass runs at up times the input rate with a cutoff
+ * at RATIONAL_CUTOFF of the output Nyquist frequency.  Each phase is
+ * normalized to unity DC gain.
+ */
+static struct rational_coef_s * coef_design(uint32_t up, uint32_t down, uint32_t taps) {
+    uint32_t n = up * taps;
+    struct rational_coef_s * t = jsdrv_alloc_clr(sizeof(struct rational_coef_s) + n * sizeof(float));
+    t->refcount = 1;
+    t->up = up;
+    t->down = down;
+    t->taps = taps;
+    double center = (n - 1) / 2.0;
+    double fc = RATIONAL_CUTOFF * 0.5 / down;  // cycles per upsampled sample
+    double i0_beta = bessel_i0(RATIONAL_KAISER_BETA);
+    for (uint32_t phase = 0; phase < up; ++phase) {
+        float * c = t->coef + phase * taps;
+        double sum = 0.0;
+        for (uint32_t k = 0; k < taps; ++k) {
+            uint32_t m = phase + (taps - 1 - k) * up;  // oldest sample first
+            double u = m - center;
+            double v = 2.0 * fc * u;
+            double h = (0.0 == v) ? 1.0 : (sin(M_PI * v) / (M_PI * v));
+            double w = u / (center + 0.5);
+            h *= bessel_i0(RATIONAL_KAISER_BETA * sqrt(1.0 - w * w)) / i0_beta;
+            c[k] = (float) h;
+            sum += h;
+        }
+        for (uint32_t k = 0; k < taps; ++k) {
+            c[k] = (float) (c[k] / sum);
+        }
+    }
+    return t;
+}
+
+// Get the cached coefficients for a ratio, designing them on first use.
+static struct rational_coef_s * coef_acquire(uint32_t up, uint32_t down, uint32_t taps) {
+    struct rational_coef_s * t;
+    LOCK();
+    for (t = coef_cache_; NULL != t; t = t->next) {
+        if ((t->up == up) && (t->down == down) && (t->taps == taps)) {
+            ++t->refcount;
+            break;
+        }
+    }
+    UNLOCK();
+    if (NULL != t) {
+        return t;
+    }
+    struct rational_coef_s * t_new = coef_design(up, down, taps);  // slow, outside the lock
+    LOCK();
+    for (t = coef_cache_; NULL != t; t = t->next) {
+        if ((t->up == up) && (t->down == down) && (t->taps == taps)) {
+            ++t->refcount;  // designed concurrently
+            break;
+        }
+    }
+    if (NULL == t) {
+        t = t_new;
+        t_new = NULL;
+        t->next = coef_cache_;
+        coef_cache_ = t;
+    }
+    UNLOCK();
+    if (NULL != t_new) {
+        jsdrv_free(t_new);
+    }
+    return t;
+}
+
+static void coef_release(struct rational_coef_s * t) {
+    bool do_free = false;
+    LOCK();
+    if (0 == --t->refcount) {
+        struct rational_coef_s ** p = &coef_cache_;
+        while (*p != t) {
+            p = &(*p)->next;
+        }
+        *p = t->next;
+        do_free = true;
+    }
+    UNLOCK();
+    if (do_free) {
+        jsdrv_free(t);
+    }
+}
+
+/*
+ * Configure JSDRV_DOWNSAMPLE_MODE_RATIONAL.  The integer stages reduce
+ * the rate while it remains at least RATIONAL_OVERSAMPLE times the
+ * output rate, then the polyphase stage resamples by up / down.
+ */
+static int32_t rational_configure(struct jsdrv_downsample_s * self) {
+    uint32_t rate_in = self->sample_rate_in;
+    uint64_t rate_min = (uint64_t) RATIONAL_OVERSAMPLE * self->sample_rate_out;
+    uint32_t d = 1;
+    uint32_t count_2 = 0;
+    uint32_t count_5 = 0;
+    while ((count_2 + count_5) < FILTERS_MAX) {
+        if ((0 == (rate_in % (d * 5))) && ((rate_in / (d * 5)) >= rate_min)) {
+            d *= 5;
+            ++count_5;
+        } else if ((0 == (rate_in % (d * 2))) && ((rate_in / (d * 2)) >= rate_min)) {
+            d *= 2;
+            ++count_2;
+        } else {
+            break;
+        }
+    }
+    stages_configure(self, count_2, count_5);
+
+    uint32_t rate_mid = rate_in / d;
+    uint32_t g = gcd_u32(rate_mid, self->sample_rate_out);
+    uint32_t up = self->sample_rate_out / g;
+    uint32_t down = rate_mid / g;
+    self->align = d * down;
+    if (1 == down) {
+        return 0;  // the integer stages are sufficient
+    }
+    if (up > RATIONAL_L_MAX) {
+        JSDRV_LOGE("Cannot resample: %lu / %lu interpolation factor %lu > %lu",
+                   self->sample_rate_out, self->sample_rate_in, up, RATIONAL_L_MAX);
+        return 1;
+    }
+    uint32_t n = (uint32_t) ceil(2.0 * RATIONAL_ZERO_CROSSINGS * down / RATIONAL_CUTOFF);
+    uint32_t taps = (n + up - 1) / up;
+    if (((uint64_t) taps * up) > RATIONAL_COEF_MAX) {
+        JSDRV_LOGE("Cannot resample: %lu / %lu needs too many coefficients",
+                   self->sample_rate_out, self->sample_rate_in);
+        return 1;
+    }
+    self->rational = jsdrv_alloc_clr(sizeof(struct rational_s) + 2 * taps * sizeof(float));
+    self->rational->table = coef_acquire(up, down, taps);
+    self->sample_delay += (uint32_t) lround((((double) taps * up - 1.0) / 2.0) / up * d);
+    return 0;
+}
+
+struct jsdrv_downsample_s * jsdrv_downsample_alloc(uint32_t sample_rate_in, uint32_t sample_rate_out, int mode) {
+    uint32_t decimate_factor = 0;
+    if (JSDRV_DOWNSAMPLE_MODE_RATIONAL != mode) {
+        decimate_factor = decimate_factor_get(sample_rate_in, sample_rate_out);
+        if (0 == decimate_factor) {
+            return NULL;
+        }
+    } else if ((0 == sample_rate_out) || (sample_rate_in < sample_rate_out)) {
+        JSDRV_LOGE("Cannot resample: %lu to %lu", sample_rate_in, sample_rate_out);
         return NULL;
+    } else if (0 == (sample_rate_in % sample_rate_out)) {
+        decimate_factor = sample_rate_in / sample_rate_out;
     }
 
     struct jsdrv_downsample_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_downsample_s));
@@ -110,52 +459,56 @@ struct jsdrv_downsample_s * jsdrv_downsample_alloc(uint32_t sample_rate_in, uint
     self->sample_rate_in = sample_rate_in;
     self->sample_rate_out = sample_rate_out;
     self->decimate_factor = decimate_factor;
+    self->align = decimate_factor;
 
     switch (mode) {
         case JSDRV_DOWNSAMPLE_MODE_AVERAGE:
             self->mode = JSDRV_DOWNSAMPLE_MODE_AVERAGE;
             self->sample_delay = self->decimate_factor / 2;
             return self;
+        case JSDRV_DOWNSAMPLE_MODE_MAJORITY:
+            self->mode = JSDRV_DOWNSAMPLE_MODE_MAJORITY;
+            self->sample_delay = self->decimate_factor / 2;
+            return self;
         case JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND:
             self->mode = JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND;
             break;
+        case JSDRV_DOWNSAMPLE_MODE_RATIONAL:
+            self->mode = JSDRV_DOWNSAMPLE_MODE_RATIONAL;
+            if (rational_configure(self)) {
+                jsdrv_downsample_free(self);
+                return NULL;
+            }
+            return self;
+        case JSDRV_DOWNSAMPLE_MODE_CIC:  // fall through
+        case JSDRV_DOWNSAMPLE_MODE_CIC_COMPENSATED:
+            if (decimate_factor > CIC_DECIMATE_MAX) {
+                JSDRV_LOGE("Cannot downsample: CIC decimate factor %lu > %lu", decimate_factor, CIC_DECIMATE_MAX);
+                jsdrv_free(self);
+                return NULL;
+            }
+            self->mode = (enum jsdrv_downsample_mode_e) mode;
+            self->cic.gain = (uint64_t) decimate_factor * decimate_factor * decimate_factor;
+            self->cic.window = CIC_STAGES * (decimate_factor - 1) + 1;
+            self->cic.compensate = (JSDRV_DOWNSAMPLE_MODE_CIC_COMPENSATED == mode);
+            self->sample_delay = (CIC_STAGES * (decimate_factor - 1)) / 2;
+            if (self->cic.compensate) {
+                self->sample_delay += decimate_factor;
+            }
+            return self;
         default:
             jsdrv_free(self);
             JSDRV_LOGE("Unsupported mode: %d", mode);
             return NULL;
     }
 
-    uint32_t idx = 0;
-    while (decimate_factor > 1) {
-        struct filter_s * f = &self->filters[idx];
-        if (0 == (decimate_factor & 1)) {
-            f->taps = coef_2;
-            f->taps_length = COEF_2_SIZE;
-            f->taps_center = COEF_2_CENTER;
-            f->downsample_factor = 2;
-            decimate_factor >>= 1;
-        } else {
-            uint32_t d = decimate_factor / 5;
-            if (decimate_factor != (d * 5)) {
-                JSDRV_LOGE("Cannot downsample: sample_rate_out * M != sample_rate_in");
-                jsdrv_downsample_free(self);
-                return NULL;
-            }
-            f->taps = coef_5;
-            f->taps_length = COEF_5_SIZE;
-            f->taps_center = COEF_5_CENTER;
-            f->downsample_factor = 5;
-            decimate_factor = d;
-        }
-        self->sample_delay += f->taps_center;
-        ++idx;
-        if (idx >= JSDRV_ARRAY_SIZE(self->filters)) {
-            JSDRV_LOGE("too much downsampling");
-            jsdrv_downsample_free(self);
-            return NULL;
-        }
+    uint32_t count_2 = 0;
+    uint32_t count_5 = 0;
+    if (stages_factor(decimate_factor, &count_2, &count_5)) {
+        jsdrv_downsample_free(self);
+        return NULL;
     }
-
+    stages_configure(self, count_2, count_5);
     return self;
 }
 
@@ -165,14 +518,28 @@ void jsdrv_downsample_clear(struct jsdrv_downsample_s * self) {
     }
     self->sample_count = 0;
     self->avg = 0;
+    jsdrv_memset(self->hist, 0, sizeof(self->hist));
+    jsdrv_memset(self->cic.integrator, 0, sizeof(self->cic.integrator));
+    jsdrv_memset(self->cic.comb, 0, sizeof(self->cic.comb));
     for (size_t i = 0; i < JSDRV_ARRAY_SIZE(self->filters); ++i) {
         self->filters[i].buffer_idx = 0;
+        self->filters[i].nan_age = 0;
         jsdrv_memset(self->filters[i].buffer, 0, sizeof(self->filters[i].buffer));
     }
+    if (NULL != self->rational) {
+        self->rational->phase = 0;
+        self->rational->wait = 0;
+        self->rational->seeded = false;
+        self->rational->hist_idx = 0;
+    }
 }
 
 void jsdrv_downsample_free(struct jsdrv_downsample_s * self) {
     if (NULL != self) {
+        if (NULL != self->rational) {
+            coef_release(self->rational->table);
+            jsdrv_free(self->rational);
+        }
         jsdrv_free(self);
     }
 }
@@ -185,9 +552,123 @@ uint32_t jsdrv_downsample_decimate_factor(struct jsdrv_downsample_s * self) {
     }
 }
 
-static bool jsdrv_downsample_add_i64q30(struct jsdrv_downsample_s * self, uint64_t sample_id, int64_t x_in, int64_t * x_out) {
+uint32_t jsdrv_downsample_sample_delay(struct jsdrv_downsample_s * self) {
+    return (NULL == self) ? 0 : self->sample_delay;
+}
+
+/**
+ * @brief Compute the symmetric FIR output for the most recent samples.
+ *
+ * @param w The oldest sample of the contiguous 2 * taps_center + 1 window.
+ * @param taps The filter taps.
+ * @param taps_center The center tap index.
+ * @return The filter output.
+ *
+ * Inlined with a constant taps_center so that the compiler can unroll
+ * and vectorize the loop.  The window must not contain NaN.
+ */
+static inline int64_t filter_compute(const int64_t * w, const int32_t * taps, uint32_t taps_center) {
+    int64_t acc = taps[taps_center] * w[taps_center];
+    for (uint32_t k = 1; k <= taps_center; ++k) {
+        acc += (w[taps_center + k] + w[taps_center - k]) * taps[taps_center + k];
+    }
+    return acc;
+}
+
+// Add modulo 2^128, which is well defined for the unbounded integrators.
+static inline void cic_add(js220_i128 * a, js220_i128 b) {
+    uint64_t lo = a->u64[0] + b.u64[0];
+    a->u64[1] = a->u64[1] + b.u64[1] + ((lo < b.u64[0]) ? 1 : 0);
+    a->u64[0] = lo;
+}
+
+// Subtract modulo 2^128.
+static inline js220_i128 cic_sub(js220_i128 a, js220_i128 b) {
+    js220_i128 r;
+    r.u64[0] = a.u64[0] - b.u64[0];
+    r.u64[1] = a.u64[1] - b.u64[1] - ((a.u64[0] < b.u64[0]) ? 1 : 0);
+    return r;
+}
+
+static inline bool cic_add_i64q30(struct jsdrv_downsample_s * self, uint64_t sample_id, int64_t x_in, int64_t * x_out) {
+    struct cic_s * c = &self->cic;
+    if (self->sample_count == 0) {
+        if (0 != (sample_id % self->decimate_factor)) {
+            // discard until aligned
+            return false;
+        }
+        // start from the steady state for this value
+        c->offset = (INT64_MIN == x_in) ? 0 : x_in;
+        c->hold = 0;
+        c->nan_age = (INT64_MIN == x_in) ? 0 : c->window;
+        c->count = self->decimate_factor;
+        c->comp_seeded = false;
+        jsdrv_memset(c->integrator, 0, sizeof(c->integrator));
+        jsdrv_memset(c->comb, 0, sizeof(c->comb));
+    }
+    if (INT64_MIN == x_in) {
+        c->nan_age = 0;  // hold the previous value to keep the integrators bounded
+    } else {
+        c->hold = x_in - c->offset;
+        if (c->nan_age < c->window) {
+            ++c->nan_age;
+        }
+    }
+    js220_i128 v = js220_i128_init_i64(c->hold);
+    for (uint32_t k = 0; k < CIC_STAGES; ++k) {
+        cic_add(&c->integrator[k], v);
+        v = c->integrator[k];
+    }
+    ++self->sample_count;
+    if (0 != --c->count) {
+        return false;
+    }
+    c->count = self->decimate_factor;
+
+    for (uint32_t k = 0; k < CIC_STAGES; ++k) {
+        js220_i128 y = cic_sub(v, c->comb[k]);
+        c->comb[k] = v;
+        v = y;
+    }
+    int64_t y;
+    if (c->nan_age < c->window) {  // NaN in the impulse response
+        y = INT64_MIN;
+    } else {
+        bool neg = js220_i128_is_neg(v);
+        if (neg) {
+            v = js220_i128_neg(v);
+        }
+        cic_add(&v, js220_i128_init_i64((int64_t) (c->gain >> 1)));  // round to nearest
+        v = js220_i128_udiv(v, c->gain, NULL);
+        y = (neg ? -v.i64[0] : v.i64[0]) + c->offset;
+    }
+    if (!c->compensate) {
+        *x_out = y;
+        return true;
+    }
+
+    if (!c->comp_seeded) {
+        c->comp[1] = y;
+        c->comp[2] = y;
+        c->comp_seeded = true;
+    }
+    c->comp[0] = c->comp[1];
+    c->comp[1] = c->comp[2];
+    c->comp[2] = y;
+    if ((INT64_MIN == c->comp[0]) || (INT64_MIN == c->comp[1]) || (INT64_MIN == y)) {
+        *x_out = INT64_MIN;
+    } else {
+        *x_out = (CIC_COMP_CENTER * c->comp[1] + CIC_COMP_SIDE * (c->comp[0] + c->comp[2])) >> CIC_COMP_SHIFT;
+    }
+    return true;
+}
+
+static inline bool jsdrv_downsample_add_i64q30(struct jsdrv_downsample_s * self, uint64_t sample_id, int64_t x_in, int64_t * x_out) {
     struct filter_s * f;
-    if (self->mode == JSDRV_DOWNSAMPLE_MODE_AVERAGE) {
+    if ((JSDRV_DOWNSAMPLE_MODE_CIC == self->mode) || (JSDRV_DOWNSAMPLE_MODE_CIC_COMPENSATED == self->mode)) {
+        return cic_add_i64q30(self, sample_id, x_in, x_out);
+    }
+    if ((self->mode != JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND) && (self->mode != JSDRV_DOWNSAMPLE_MODE_RATIONAL)) {
         if (self->sample_count == 0) {
             if (0 != (sample_id % self->decimate_factor)) {
                 // discard until aligned
@@ -213,7 +694,7 @@ static bool jsdrv_downsample_add_i64q30(struct jsdrv_downsample_s * self, uint64
     }
 
     if (self->sample_count == 0) {
-        if (0 != (sample_id % self->decimate_factor)) {
+        if (0 != (sample_id % self->align)) {
             // discard until aligned
             return false;
         }
@@ -223,18 +704,16 @@ static bool jsdrv_downsample_add_i64q30(struct jsdrv_downsample_s * self, uint64
             if (0 == f->taps_length) {
                 break;
             }
-            for (size_t k = 0; k < BUFFER_SIZE; ++k) {
+            for (size_t k = 0; k < JSDRV_ARRAY_SIZE(f->buffer); ++k) {
                 f->buffer[k] = x_in;
             }
+            f->nan_age = (INT64_MIN == x_in) ? 0 : NAN_AGE_MAX;
             f->downsample_count = f->downsample_factor;
         }
     }
     ++self->sample_count;
 
     int64_t x_feed = x_in;
-    int64_t x_sum;
-    uint32_t fwd_idx;
-    uint32_t bwd_idx;
 
     for (size_t filter_idx = 0; filter_idx < JSDRV_ARRAY_SIZE(self->filters); ++filter_idx) {
         f = &self->filters[filter_idx];
@@ -243,62 +722,160 @@ static bool jsdrv_downsample_add_i64q30(struct jsdrv_downsample_s * self, uint64
             return true;
         }
 
-        uint8_t buffer_idx = f->buffer_idx;
+        uint32_t buffer_idx = f->buffer_idx;
         f->buffer[buffer_idx] = x_feed;
-        f->buffer_idx = (f->buffer_idx + 1) & BUFFER_MASK;
+        f->buffer[buffer_idx + BUFFER_SIZE] = x_feed;
+        f->buffer_idx = (uint8_t) ((buffer_idx + 1) & BUFFER_MASK);
+        if (INT64_MIN == x_feed) {
+            f->nan_age = 0;
+        } else if (f->nan_age < NAN_AGE_MAX) {
+            ++f->nan_age;
+        }
         --f->downsample_count;
         if (0 == f->downsample_count) { // compute filter sample
-            fwd_idx = (buffer_idx - f->taps_center) & BUFFER_MASK;
-            bwd_idx = fwd_idx;
-            if (f->buffer[fwd_idx] == INT64_MIN) {  // NaN
+            if (f->nan_age < f->taps_length) {  // NaN in window
                 x_feed = INT64_MIN;
             } else {
-                x_feed = f->taps[f->taps_center] * f->buffer[fwd_idx];
-                for (uint8_t tap_idx = f->taps_center + 1; tap_idx < f->taps_length; ++tap_idx) {
-                    fwd_idx = (fwd_idx + 1) & BUFFER_MASK;
-                    bwd_idx = (bwd_idx - 1) & BUFFER_MASK;
-                    if ((f->buffer[fwd_idx] == INT64_MIN) || (f->buffer[bwd_idx] == INT64_MIN)) {  // NaN
-                        x_feed = INT64_MIN;
-                        break;
-                    }
-                    x_sum = f->buffer[fwd_idx] + f->buffer[bwd_idx];
-                    x_feed += x_sum * f->taps[tap_idx];
+                const int64_t * w = &f->buffer[buffer_idx + BUFFER_SIZE + 1 - f->taps_length];
+                if (COEF_5_CENTER == f->taps_center) {
+                    x_feed = filter_compute(w, coef_5, COEF_5_CENTER);
+                } else {
+                    x_feed = filter_compute(w, coef_2, COEF_2_CENTER);
                 }
-            }
-            if (x_feed != INT64_MIN) {
                 x_feed >>= 23;
             }
             f->downsample_count = f->downsample_factor;
         } else {
-            break;
+            return false;
         }
     }
-    return false;
+    *x_out = x_feed;  // all FILTERS_MAX stages
+    return true;
+}
+
+static inline int64_t f32_to_i64q30(float x) {
+    return isnan(x) ? INT64_MIN : (int64_t) (x * f_scale_in);
+}
+
+static inline float i64q30_to_f32(int64_t x) {
+    return (INT64_MIN == x) ? NAN : ((float) (x)) * f_scale_out;
+}
+
+// Add one sample at the polyphase stage input rate.
+static inline bool rational_add(struct rational_s * r, float x, float * y) {
+    const struct rational_coef_s * t = r->table;
+    uint32_t taps = t->taps;
+    if (!r->seeded) {
+        for (uint32_t k = 0; k < (2 * taps); ++k) {
+            r->hist[k] = x;
+        }
+        r->seeded = true;
+    }
+    uint32_t idx = r->hist_idx;
+    r->hist[idx] = x;
+    r->hist[idx + taps] = x;
+    r->hist_idx = ((idx + 1) == taps) ? 0 : (idx + 1);
+    if (r->wait) {
+        --r->wait;
+        return false;
+    }
+    const float * w = r->hist + idx + 1;  // oldest first
+    const float * c = t->coef + r->phase * taps;
+    float acc = 0.0f;
+    for (uint32_t k = 0; k < taps; ++k) {
+        acc += c[k] * w[k];
+    }
+    *y = acc;
+    uint32_t phase = r->phase + t->down;
+    r->wait = phase / t->up - 1;
+    r->phase = phase % t->up;
+    return true;
+}
+
+static inline bool add_f32(struct jsdrv_downsample_s * self, uint64_t sample_id, float x_in, float * x_out) {
+    int64_t x64 = f32_to_i64q30(x_in);
+    if (!jsdrv_downsample_add_i64q30(self, sample_id, x64, &x64)) {
+        return false;
+    }
+    if (NULL == self->rational) {
+        *x_out = i64q30_to_f32(x64);
+        return true;
+    }
+    return rational_add(self->rational, i64q30_to_f32(x64), x_out);
 }
 
 bool jsdrv_downsample_add_f32(struct jsdrv_downsample_s * self, uint64_t sample_id, float x_in, float * x_out) {
-    int64_t x64;
     if (NULL == self) {
         *x_out = x_in;
         return true;
     }
-    if (isnan(x_in)) {
-        x64 = INT64_MIN;
-    } else {
-        x64 = (int64_t) (x_in * f_scale_in);
+    return add_f32(self, sample_id, x_in, x_out);
+}
+
+void jsdrv_downsample_add_f32_block(struct jsdrv_downsample_s * self, uint64_t sample_id,
+                                    const float * x, uint32_t n, float * y, uint32_t * n_out) {
+    uint32_t count = 0;
+    uint32_t idx = 0;
+    if (NULL == self) {
+        if (y != x) {
+            jsdrv_memcpy(y, x, n * sizeof(float));
+        }
+        *n_out = n;
+        return;
     }
-    bool rv = jsdrv_downsample_add_i64q30(self, sample_id, x64, &x64);
-    if (rv) {
-        if (x64 == INT64_MIN) {
-            *x_out = NAN;
-        } else {
-            *x_out = ((float) (x64)) * f_scale_out;
+    if (0 == self->sample_count) {
+        // discard until aligned
+        uint32_t skip = (uint32_t) (sample_id % self->align);
+        if (skip) {
+            skip = self->align - skip;
         }
+        idx = (skip > n) ? n : skip;
     }
-    return rv;
+    for (; idx < n; ++idx) {
+        if (add_f32(self, sample_id + idx, x[idx], &y[count])) {
+            ++count;
+        }
+    }
+    *n_out = count;
+}
+
+static inline bool majority_add(struct jsdrv_downsample_s * self, uint64_t sample_id, uint8_t x_in, uint8_t * x_out) {
+    if (self->sample_count == 0) {
+        if (0 != (sample_id % self->decimate_factor)) {
+            // discard until aligned
+            return false;
+        }
+    }
+    ++self->hist[x_in & 0x0f];
+    ++self->sample_count;
+    if (self->sample_count < self->decimate_factor) {
+        return false;
+    }
+    uint8_t value = 0;
+    for (uint8_t k = 1; k < 16; ++k) {
+        if (self->hist[k] > self->hist[value]) {
+            value = k;
+        }
+    }
+    *x_out = value;
+    self->sample_count = 0;
+    jsdrv_memset(self->hist, 0, sizeof(self->hist));
+    return true;
 }
 
 bool jsdrv_downsample_add_u8(struct jsdrv_downsample_s * self, uint64_t sample_id, uint8_t x_in, uint8_t * x_out) {
+    if (JSDRV_DOWNSAMPLE_MODE_MAJORITY == self->mode) {
+        return majority_add(self, sample_id, x_in, x_out);
+    }
+    if (NULL != self->rational) {
+        float y = 0.0f;
+        if (!add_f32(self, sample_id, (float) x_in, &y)) {
+            return false;
+        }
+        y = roundf(y);
+        *x_out = (y <= 0.0f) ? 0 : ((y >= 255.0f) ? 255 : (uint8_t) y);
+        return true;
+    }
     int64_t x64 = ((int64_t) x_in) << 30;
     bool rv = jsdrv_downsample_add_i64q30(self, sample_id, x64, &x64);
     if (rv) {
@@ -307,3 +884,264 @@ bool jsdrv_downsample_add_u8(struct jsdrv_downsample_s * self, uint64_t sample_i
     }
     return rv;
 }
+
+void jsdrv_downsample_add_u8_block(struct jsdrv_downsample_s * self, uint64_t sample_id,
+                                   const uint8_t * x, uint32_t n, uint8_t * y, uint32_t * n_out) {
+    uint32_t count = 0;
+    if (NULL == self) {
+        if (y != x) {
+            jsdrv_memcpy(y, x, n);
+        }
+        *n_out = n;
+        return;
+    }
+    if (JSDRV_DOWNSAMPLE_MODE_MAJORITY == self->mode) {
+        for (uint32_t idx = 0; idx < n; ++idx) {
+            if (majority_add(self, sample_id + idx, x[idx], &y[count])) {
+                ++count;
+            }
+        }
+        *n_out = count;
+        return;
+    }
+    for (uint32_t idx = 0; idx < n; ++idx) {
+        if (jsdrv_downsample_add_u8(self, sample_id + idx, x[idx], &y[count])) {
+            ++count;
+        }
+    }
+    *n_out = count;
+}
+
+struct jsdrv_downsample_mc_s * jsdrv_downsample_mc_alloc(uint32_t sample_rate_in, uint32_t sample_rate_out,
+                                                         int mode, uint32_t channel_count) {
+    if ((0 == channel_count) || (channel_count > MC_LANES)) {
+        JSDRV_LOGE("Invalid channel_count: %lu", channel_count);
+        return NULL;
+    }
+    uint32_t decimate_factor = decimate_factor_get(sample_rate_in, sample_rate_out);
+    if (0 == decimate_factor) {
+        return NULL;
+    }
+    uint32_t count_2 = 0;
+    uint32_t count_5 = 0;
+    switch (mode) {
+        case JSDRV_DOWNSAMPLE_MODE_AVERAGE:  // fall through
+        case JSDRV_DOWNSAMPLE_MODE_MAJORITY:  // averages f32, like jsdrv_downsample_add_f32()
+            mode = JSDRV_DOWNSAMPLE_MODE_AVERAGE;
+            break;
+        case JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND:
+            if (stages_factor(decimate_factor, &count_2, &count_5)) {
+                return NULL;
+            }
+            break;
+        default:
+            JSDRV_LOGE("Unsupported mode: %d", mode);
+            return NULL;
+    }
+
+    uint32_t filter_count = count_2 + count_5;
+    struct jsdrv_downsample_mc_s * self = jsdrv_alloc_clr(
+            sizeof(struct jsdrv_downsample_mc_s) + filter_count * sizeof(struct filter_mc_s));
+    self->mode = (enum jsdrv_downsample_mode_e) mode;
+    self->channel_count = channel_count;
+    self->lanes = (channel_count <= 4) ? 4 : MC_LANES;
+    self->decimate_factor = decimate_factor;
+    self->filter_count = filter_count;
+    if (JSDRV_DOWNSAMPLE_MODE_AVERAGE == mode) {
+        self->sample_delay = decimate_factor / 2;
+    }
+    uint32_t rate_div = 1;
+    for (uint32_t idx = 0; idx < filter_count; ++idx) {  // same order as jsdrv_downsample_alloc()
+        struct filter_mc_s * f = &self->filters[idx];
+        if (idx < count_5) {
+            f->taps = coef_5;
+            f->taps_length = COEF_5_SIZE;
+            f->taps_center = COEF_5_CENTER;
+            f->downsample_factor = 5;
+        } else {
+            f->taps = coef_2;
+            f->taps_length = COEF_2_SIZE;
+            f->taps_center = COEF_2_CENTER;
+            f->downsample_factor = 2;
+        }
+        self->sample_delay += f->taps_center * rate_div;
+        rate_div *= f->downsample_factor;
+    }
+    return self;
+}
+
+void jsdrv_downsample_mc_free(struct jsdrv_downsample_mc_s * self) {
+    if (NULL != self) {
+        jsdrv_free(self);
+    }
+}
+
+void jsdrv_downsample_mc_clear(struct jsdrv_downsample_mc_s * self) {
+    if (NULL == self) {
+        return;
+    }
+    self->sample_count = 0;
+    jsdrv_memset(self->avg, 0, sizeof(self->avg));
+    for (uint32_t i = 0; i < self->filter_count; ++i) {
+        struct filter_mc_s * f = &self->filters[i];
+        f->buffer_idx = 0;
+        jsdrv_memset(f->nan_age, 0, sizeof(f->nan_age));
+        jsdrv_memset(f->buffer, 0, sizeof(f->buffer));
+    }
+}
+
+uint32_t jsdrv_downsample_mc_decimate_factor(struct jsdrv_downsample_mc_s * self) {
+    return (NULL == self) ? 1 : self->decimate_factor;
+}
+
+uint32_t jsdrv_downsample_mc_sample_delay(struct jsdrv_downsample_mc_s * self) {
+    return (NULL == self) ? 0 : self->sample_delay;
+}
+
+/**
+ * @brief Compute the symmetric FIR output for all lanes.
+ *
+ * @param w The oldest sample of the contiguous 2 * taps_center + 1 window.
+ * @param taps The filter taps.
+ * @param taps_center The center tap index.
+ * @param lanes The interleave stride, 4 or MC_LANES.
+ * @param[out] acc The filter output for each lane.
+ *
+ * Inlined with constant taps_center and lanes so that the inner loop
+ * over the lanes shares each tap load and vectorizes.
+ */
+static inline void filter_compute_mc(const int64_t * w, const int32_t * taps, uint32_t taps_center,
+                                     uint32_t lanes, int64_t * acc) {
+    int64_t t = taps[taps_center];
+    const int64_t * c = w + taps_center * lanes;
+    for (uint32_t lane = 0; lane < lanes; ++lane) {
+        acc[lane] = t * c[lane];
+    }
+    for (uint32_t k = 1; k <= taps_center; ++k) {
+        t = taps[taps_center + k];
+        const int64_t * a = c + k * lanes;
+        const int64_t * b = c - k * lanes;
+        for (uint32_t lane = 0; lane < lanes; ++lane) {
+            acc[lane] += (a[lane] + b[lane]) * t;
+        }
+    }
+}
+
+static inline void filter_compute_mc_dispatch(const int64_t * w, uint32_t taps_center, uint32_t lanes, int64_t * acc) {
+    if (COEF_5_CENTER == taps_center) {
+        if (4 == lanes) {
+            filter_compute_mc(w, coef_5, COEF_5_CENTER, 4, acc);
+        } else {
+            filter_compute_mc(w, coef_5, COEF_5_CENTER, MC_LANES, acc);
+        }
+    } else {
+        if (4 == lanes) {
+            filter_compute_mc(w, coef_2, COEF_2_CENTER, 4, acc);
+        } else {
+            filter_compute_mc(w, coef_2, COEF_2_CENTER, MC_LANES, acc);
+        }
+    }
+}
+
+// x holds one sample for each lane, INT64_MIN for NaN, and receives the output.
+static inline bool mc_add_i64q30(struct jsdrv_downsample_mc_s * self, uint64_t sample_id, int64_t * x) {
+    uint32_t lanes = self->lanes;
+    if (self->mode != JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND) {
+        if (self->sample_count == 0) {
+            if (0 != (sample_id % self->decimate_factor)) {
+                return false;  // discard until aligned
+            }
+            jsdrv_memset(self->avg, 0, sizeof(self->avg));
+        }
+        for (uint32_t lane = 0; lane < self->channel_count; ++lane) {
+            if (INT64_MIN != self->avg[lane]) {
+                self->avg[lane] = (INT64_MIN == x[lane]) ? INT64_MIN : (self->avg[lane] + x[lane]);
+            }
+        }
+        ++self->sample_count;
+        if (self->sample_count < self->decimate_factor) {
+            return false;
+        }
+        for (uint32_t lane = 0; lane < self->channel_count; ++lane) {
+            x[lane] = (INT64_MIN == self->avg[lane]) ? INT64_MIN : (self->avg[lane] / (int64_t) self->sample_count);
+        }
+        self->sample_count = 0;
+        return true;
+    }
+
+    if (self->sample_count == 0) {
+        if (0 != (sample_id % self->decimate_factor)) {
+            return false;  // discard until aligned
+        }
+        // seed all buffers with this value
+        for (uint32_t i = 0; i < self->filter_count; ++i) {
+            struct filter_mc_s * f = &self->filters[i];
+            for (uint32_t lane = 0; lane < lanes; ++lane) {
+                bool is_nan = (INT64_MIN == x[lane]);
+                for (uint32_t k = 0; k < (2 * BUFFER_SIZE); ++k) {
+                    f->buffer[k * lanes + lane] = is_nan ? 0 : x[lane];
+                }
+                f->nan_age[lane] = is_nan ? 0 : NAN_AGE_MAX;
+            }
+            f->downsample_count = f->downsample_factor;
+        }
+    }
+    ++self->sample_count;
+
+    for (uint32_t filter_idx = 0; filter_idx < self->filter_count; ++filter_idx) {
+        struct filter_mc_s * f = &self->filters[filter_idx];
+        uint32_t buffer_idx = f->buffer_idx;
+        int64_t * b0 = &f->buffer[buffer_idx * lanes];
+        int64_t * b1 = &f->buffer[(buffer_idx + BUFFER_SIZE) * lanes];
+        for (uint32_t lane = 0; lane < lanes; ++lane) {
+            int64_t v = x[lane];
+            if (INT64_MIN == v) {
+                v = 0;
+                f->nan_age[lane] = 0;
+            } else if (f->nan_age[lane] < NAN_AGE_MAX) {
+                ++f->nan_age[lane];
+            }
+            b0[lane] = v;
+            b1[lane] = v;
+        }
+        f->buffer_idx = (uint8_t) ((buffer_idx + 1) & BUFFER_MASK);
+        --f->downsample_count;
+        if (0 != f->downsample_count) {
+            return false;
+        }
+        f->downsample_count = f->downsample_factor;
+        const int64_t * w = &f->buffer[(buffer_idx + BUFFER_SIZE + 1 - f->taps_length) * lanes];
+        filter_compute_mc_dispatch(w, f->taps_center, lanes, x);
+        for (uint32_t lane = 0; lane < lanes; ++lane) {
+            x[lane] = (f->nan_age[lane] < f->taps_length) ? INT64_MIN : (x[lane] >> 23);
+        }
+    }
+    return true;
+}
+
+void jsdrv_downsample_mc_add_f32_block(struct jsdrv_downsample_mc_s * self, uint64_t sample_id,
+                                       const float * const * x, uint32_t n, float * const * y, uint32_t * n_out) {
+    uint32_t count = 0;
+    uint32_t idx = 0;
+    int64_t x64[MC_LANES] = {0};
+    if (0 == self->sample_count) {
+        // discard until aligned
+        uint32_t skip = (uint32_t) (sample_id % self->decimate_factor);
+        if (skip) {
+            skip = self->decimate_factor - skip;
+        }
+        idx = (skip > n) ? n : skip;
+    }
+    for (; idx < n; ++idx) {
+        for (uint32_t lane = 0; lane < self->channel_count; ++lane) {
+            x64[lane] = f32_to_i64q30(x[lane][idx]);
+        }
+        if (mc_add_i64q30(self, sample_id + idx, x64)) {
+            for (uint32_t lane = 0; lane < self->channel_count; ++lane) {
+                y[lane][count] = i64q30_to_f32(x64[lane]);
+            }
+            ++count;
+        }
+    }
+    *n_out = count;
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright 2022 Jetperch LLC
+ * Copyright 2022-2026 Jetperch LLC
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -14,127 +14,1282 @@
  * limitations under the License.
  */
 
+/*
+ * The emulation backend provides the same low-level device interface
+ * as the USB backends.  The normal JS220 and JS110 upper-level drivers
+ * connect to each emulated instrument, which answers control transfers
+ * and bulk out frames like the instrument firmware, and which streams
+ * synthetic bulk in frames at the full 2 Msps sample rate.
+ */
+
+#define JSDRV_LOG_LEVEL JSDRV_LOG_LEVEL_ALL
 #include "jsdrv.h"
-#include "jsdrv_prv/cdef.h"
-#include "jsdrv/log.h"
-#include "jsdrv_prv/log.h"
 #include "jsdrv_prv/backend.h"
-#include "jsdrv_prv/assert.h"
-#include "js220_api.h"
+#include "jsdrv_prv/buffer_codec.h"
+#include "jsdrv_prv/cdef.h"
 #include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/latency.h"
+#include "jsdrv_prv/js110_cal.h"
+#include "jsdrv_prv/js220_i128.h"
+#include "jsdrv_prv/list.h"
+#include "jsdrv_prv/log.h"
 #include "jsdrv_prv/msg_queue.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv_prv/usb_spec.h"
+#include "jsdrv_prv/usb_trace.h"
 #include "jsdrv/cstr.h"
 #include "jsdrv/error_code.h"
-#include "jsdrv_prv/windows.h"
+#include "jsdrv/time.h"
+#include "js110_api.h"
+#include "js220_api.h"
+#include "tinyprintf.h"
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
 
-struct device_s {
+
+#define BACKEND_PREFIX                  'z'
+#define DEVICES_MAX                     (64U)
+#define FRAME_SIZE                      (512U)
+#define SAMPLE_RATE                     (2000000U)
+#define LOOP_TIMEOUT_MS                 (1U)
+#define IDLE_TIMEOUT_MS                 (50U)
+#define FLUSH_TIMEOUT_MS                (10U)      // bulk in short transfer when idle
+#define FIFO_SAMPLES                    (SAMPLE_RATE / 10)  // instrument buffer before overflow
+#define CTRL_FRAMES_MAX                 (64U)
+#define RETAIN_MAX                      (64U)
+#define SINE_LENGTH                     (1000U)    // 1 kHz at 1 Msps
+#define STALL_MS_DEFAULT                (100U)
+#define JS220_PORTS                     (15U)
+#define JS220_PORT_DATA_SIZE            (JS220_PAYLOAD_SIZE_MAX - sizeof(uint32_t))
+#define JS220_PORT_STATS                (14U)
+#define JS220_STATS_SCNT_DEFAULT        (1000000U)
+#define JS220_ITEM_TIMEMAP              (JS220_PORTS)
+#define JS220_ITEM_NONE                 (JS220_PORTS + 1)
+#define JS110_FRAME_SAMPLES             (126U)
+
+enum model_e {
+    MODEL_JS220,
+    MODEL_JS110,
+};
+
+struct config_s {
+    uint32_t pattern;           // jsdrv_emulated_pattern_e
+    uint32_t speed;             // percent of real time, 0 for unpaced
+    uint32_t skip;
+    uint32_t dup;
+    uint32_t stall;
+    uint32_t stall_ms;
+    uint32_t codec;             // nonzero to compress JS220 data port frames
+    char * trace_dir;           // JSDRV_ARG_USB_TRACE or NULL
+};
+
+struct transfer_s {
     struct jsdrv_list_s item;
+    struct jsdrvp_msg_s * msg;              // the bulk in loan message, owned by this transfer
+    int64_t time_start;                     // first frame time for the short transfer flush
+    uint32_t length;                        // bytes filled
+    uint32_t buffer_size;
+    uint8_t buffer[];                       // must be last
+};
+
+struct js220_port_s {
+    uint64_t sample_id;                     // the first sample_id of the next frame
+    uint32_t decimate;                      // sample_id increment per element
 };
 
-#define DEVICES_MAX                     (256U)
+struct retain_s {
+    char topic[JS220_TOPIC_LENGTH];
+    struct jsdrv_union_s value;             // non-pointer types only
+};
+
+struct backend_s;
+
+struct dev_s {
+    struct jsdrvp_ll_device_s ll;
+    struct backend_s * backend;
+    uint8_t model;                          // model_e
+    jsdrv_thread_t thread;
+    volatile bool do_exit;
+    bool open;
+    struct jsdrv_usb_trace_s * trace;
+
+    bool bulk_in_open;
+    uint8_t bulk_in_endpoint;
+    uint32_t bulk_in_depth;
+    uint32_t bulk_in_size;
+    uint32_t bulk_in_spare;
+    struct jsdrv_list_s transfers_free;
+    struct transfer_s * transfer;           // partially filled, not yet sent
+    bool transfer_ctrl;                     // transfer contains a control response
+    uint64_t transfer_count;
+    int64_t stall_until;
+
+    uint32_t frame[FRAME_SIZE / sizeof(uint32_t)];  // frame under construction
+    uint32_t ctrl_frames[CTRL_FRAMES_MAX][FRAME_SIZE / sizeof(uint32_t)];
+    uint32_t ctrl_head;
+    uint32_t ctrl_tail;
+    uint64_t frame_count;                   // data frames, for fault injection
+
+    int64_t time_now;
+    int64_t time_start;                     // pacing reference
+    uint64_t sample_id_start;               // pacing reference
+    uint64_t sample_id;                     // the instrument sample counter
+
+    // JS220
+    bool connected;
+    uint16_t frame_id;
+    uint32_t port_enable;                   // bitmap of js220_port_s index
+    struct js220_port_s ports[JS220_PORTS];
+    uint32_t signal_n;
+    uint32_t gpi_n;
+    uint32_t gpi_mode;
+    uint32_t stats_scnt;
+    uint64_t stats_sample_id;               // next block start
+    uint64_t stats_accum_sample_id;
+    js220_i128 stats_i_int;
+    js220_i128 stats_p_int;
+    uint64_t timemap_sample_id;             // next timemap
+    struct retain_s retain[RETAIN_MAX];
+    uint32_t retain_count;
+
+    // JS110
+    bool streaming;
+    uint16_t pkt_index;
+    struct js110_host_settings_s settings;
+    struct js110_host_extio_s extio;
+    uint8_t loopback[64];
+};
 
 struct backend_s {
     struct jsdrvbk_s backend;
     struct jsdrv_context_s * context;
-    bool do_exit;
-    HANDLE thread;
-    DWORD thread_id;
+    struct config_s config;
+    float sine[SINE_LENGTH];
+    uint8_t * cal;                          // JS110 calibration record
+    uint32_t cal_size;
+    uint32_t device_count;
+    struct dev_s * devices[DEVICES_MAX];
 };
 
-static bool backend_handle_msg(struct backend_s * s, struct jsdrvp_msg_s * msg) {
-    bool rv = true;
-    if (!msg) {
+struct js220_port_def_s {
+    const char * ctrl_topic;
+    uint32_t element_bits;
+    uint32_t decimate_min;
+};
+
+// Matches the JS220 upper-level driver PORT_MAP, port_id = 16 + index.
+static const struct js220_port_def_s JS220_PORT_DEFS[JS220_PORTS] = {
+        {"s/adc/0/ctrl",   16, 1},
+        {"s/adc/1/ctrl",   16, 1},
+        {"s/adc/2/ctrl",   16, 1},
+        {"s/adc/3/ctrl",   16, 1},
+        {"s/i/range/ctrl",  4, 1},
+        {"s/i/ctrl",       32, 2},
+        {"s/v/ctrl",       32, 2},
+        {"s/p/ctrl",       32, 2},
+        {"s/gpi/0/ctrl",    1, 1},
+        {"s/gpi/1/ctrl",    1, 1},
+        {"s/gpi/2/ctrl",    1, 1},
+        {"s/gpi/3/ctrl",    1, 1},
+        {"s/gpi/7/ctrl",    1, 1},
+        {"s/uart/0/ctrl",   0, 1},  // not emulated
+        {"s/stats/ctrl",    0, 2},  // js220_statistics_raw_s
+};
+
+// JS110 full-scale current for each range, in A.
+static const double JS110_I_RANGE[] = {10.0, 2.0, 0.18, 0.018, 0.0018, 0.00018, 0.000018};
+// JS110 full-scale voltage for each range, in V.
+static const double JS110_V_RANGE[] = {15.0, 5.0};
+
+static const uint8_t JS110_CAL_MAGIC[16] = "\xd3tagfmt \r\n \n  \x1a\x1c";
+
+static void js220_pattern(struct dev_s * d, uint64_t sample_id, float * i, float * v) {
+    struct backend_s * s = d->backend;
+    uint64_t k = sample_id >> 1;  // 1 Msps
+    if (JSDRV_EMULATED_PATTERN_RAMP == s->config.pattern) {
+        *i = (float) (k & 0xffff) * (1.0f / 65536.0f);
+        *v = 1.0f + (float) ((k >> 8) & 0xff) * (1.0f / 256.0f);
+    } else {
+        uint32_t idx = (uint32_t) (k % SINE_LENGTH);
+        *i = 0.1f + 0.05f * s->sine[idx];
+        *v = 3.3f + 0.1f * s->sine[(idx + SINE_LENGTH / 4) % SINE_LENGTH];
+    }
+}
+
+static uint32_t js110_pattern(struct dev_s * d, uint64_t sample_id) {
+    struct backend_s * s = d->backend;
+    uint32_t i_range;
+    uint32_t i_code;
+    uint32_t v_code;
+    uint32_t v_range = (d->settings.options >> 1) & 1;
+    if (JSDRV_EMULATED_PATTERN_RAMP == s->config.pattern) {
+        i_range = 0;
+        i_code = (uint32_t) (sample_id & 0x3fff);
+        v_code = (uint32_t) ((sample_id >> 14) & 0x3fff);
+    } else {
+        uint32_t idx = (uint32_t) ((sample_id >> 1) % SINE_LENGTH);
+        i_range = 2;
+        i_code = (uint32_t) ((0.1 + 0.05 * s->sine[idx]) * 16384.0 / JS110_I_RANGE[i_range]);
+        v_code = (uint32_t) ((3.3 + 0.1 * s->sine[(idx + SINE_LENGTH / 4) % SINE_LENGTH])
+                             * 16384.0 / JS110_V_RANGE[v_range]);
+    }
+    return (i_range & 3) | ((i_code & 0x3fff) << 2) | (((i_range >> 2) & 1) << 16) | ((v_code & 0x3fff) << 18);
+}
+
+static void transfer_destroy(struct dev_s * d, struct transfer_s * t) {
+    if (NULL != t->msg) {
+        jsdrvp_msg_free(d->backend->context, t->msg);
+        t->msg = NULL;
+    }
+    jsdrv_free(t);
+}
+
+static void transfers_free_clear(struct dev_s * d) {
+    struct jsdrv_list_s * item;
+    while (NULL != (item = jsdrv_list_remove_head(&d->transfers_free))) {
+        transfer_destroy(d, JSDRV_CONTAINER_OF(item, struct transfer_s, item));
+    }
+}
+
+static void transfer_return(struct dev_s * d, struct jsdrvp_msg_s * msg) {
+    struct transfer_s * t = JSDRV_CONTAINER_OF(msg->value.value.bin, struct transfer_s, buffer);
+    if (t->msg != msg) {
+        JSDRV_LOGW("stream_in_data message not owned by transfer");
+        jsdrvp_msg_free(d->backend->context, msg);
+    } else if (!d->bulk_in_open || (t->buffer_size != d->bulk_in_size)) {
+        transfer_destroy(d, t);
+    } else {
+        jsdrv_list_add_tail(&d->transfers_free, &t->item);
+    }
+}
+
+static bool is_stalled(struct dev_s * d) {
+    return d->time_now < d->stall_until;
+}
+
+static void transfer_send(struct dev_s * d) {
+    struct transfer_s * t = d->transfer;
+    struct config_s * config = &d->backend->config;
+    d->transfer = NULL;
+    d->transfer_ctrl = false;
+    t->msg->value = jsdrv_union_bin(t->buffer, t->length);
+    t->msg->extra.bkusb_stream.endpoint = d->bulk_in_endpoint;
+    t->msg->extra.bkusb_stream.transfer_depth = d->bulk_in_depth;
+    JSDRV_LATENCY_STAMP(t->msg->latency.usb);
+    jsdrv_usb_trace_write(d->trace, JSDRV_USB_TRACE_BULK_IN, d->bulk_in_endpoint, 0, 0, t->buffer, t->length);
+    msg_queue_push(d->ll.rsp_q, t->msg);
+    ++d->transfer_count;
+    if (config->stall && (0 == (d->transfer_count % config->stall))) {
+        JSDRV_LOGD1("%s stall bulk in for %" PRIu32 " ms", d->ll.prefix, config->stall_ms);
+        d->stall_until = d->time_now + config->stall_ms * JSDRV_TIME_MILLISECOND;
+    }
+}
+
+static bool frame_space(struct dev_s * d) {
+    if (!d->bulk_in_open || is_stalled(d)) {
         return false;
     }
-    if (0 == strcmp(JSDRV_MSG_FINALIZE, msg->topic)) {
-        JSDRV_LOGI("winusb backend finalize");
-        s->do_exit = true;
-        rv = false;
+    return (NULL != d->transfer) || !jsdrv_list_is_empty(&d->transfers_free);
+}
+
+static void frame_copy(struct dev_s * d, const uint32_t * frame) {
+    struct transfer_s * t = d->transfer;
+    if (NULL == t) {
+        struct jsdrv_list_s * item = jsdrv_list_remove_head(&d->transfers_free);
+        if (NULL == item) {
+            return;  // only for duplicates, which are then lost
+        }
+        t = JSDRV_CONTAINER_OF(item, struct transfer_s, item);
+        t->length = 0;
+        t->time_start = d->time_now;
+        d->transfer = t;
+    }
+    memcpy(t->buffer + t->length, frame, FRAME_SIZE);
+    t->length += FRAME_SIZE;
+    if (t->length >= t->buffer_size) {
+        transfer_send(d);
+    }
+}
+
+// Send the data frame in d->frame, which requires frame_space().
+static void frame_send_data(struct dev_s * d) {
+    struct config_s * config = &d->backend->config;
+    ++d->frame_count;
+    if (config->skip && (0 == (d->frame_count % config->skip))) {
+        return;  // lost, but still consumed frame_id or pkt_index
+    }
+    frame_copy(d, d->frame);
+    if (config->dup && (0 == (d->frame_count % config->dup)) && frame_space(d)) {
+        frame_copy(d, d->frame);
+    }
+}
+
+static void ctrl_frame_push(struct dev_s * d, uint8_t port_id, const void * payload, uint16_t length) {
+    uint32_t next = (d->ctrl_head + 1) % CTRL_FRAMES_MAX;
+    if (next == d->ctrl_tail) {
+        JSDRV_LOGW("%s control frame overflow", d->ll.prefix);
+        return;
+    }
+    uint32_t * frame = d->ctrl_frames[d->ctrl_head];
+    memset(frame, 0, FRAME_SIZE);
+    frame[0] = js220_frame_hdr_pack(0, length, port_id);  // frame_id assigned on send
+    memcpy(&frame[1], payload, length);
+    d->ctrl_head = next;
+}
+
+static void ctrl_frames_process(struct dev_s * d) {
+    while ((d->ctrl_tail != d->ctrl_head) && frame_space(d)) {
+        uint32_t * frame = d->ctrl_frames[d->ctrl_tail];
+        frame[0] |= d->frame_id++;
+        d->transfer_ctrl = true;
+        frame_copy(d, frame);
+        d->ctrl_tail = (d->ctrl_tail + 1) % CTRL_FRAMES_MAX;
+    }
+}
+
+static uint64_t sample_id_due(struct dev_s * d) {
+    uint32_t speed = d->backend->config.speed;
+    if (0 == speed) {
+        return UINT64_MAX;
+    }
+    double dt = JSDRV_TIME_TO_F64(d->time_now - d->time_start);
+    return d->sample_id_start + (uint64_t) (dt * (SAMPLE_RATE / 100.0) * speed);
+}
+
+static void timing_start(struct dev_s * d) {
+    d->time_now = jsdrv_time_utc();
+    d->time_start = d->time_now;
+    d->sample_id_start = d->sample_id;
+}
+
+static uint64_t align_up(uint64_t sample_id, uint32_t decimate) {
+    return ((sample_id + decimate - 1) / decimate) * decimate;
+}
+
+static void js220_publish(struct dev_s * d, const char * topic, const struct jsdrv_union_s * value) {
+    uint32_t buf[FRAME_SIZE / sizeof(uint32_t)];
+    struct js220_publish_s * p = (struct js220_publish_s *) buf;
+    uint16_t length = sizeof(struct js220_publish_s);
+    memset(buf, 0, sizeof(buf));
+    jsdrv_cstr_copy(p->topic, topic, sizeof(p->topic));
+    p->type = value->type;
+    p->flags = value->flags;
+    p->op = value->op;
+    p->app = value->app;
+    memcpy(p->data, &value->value.u64, sizeof(uint64_t));
+    length += sizeof(uint64_t);
+    ctrl_frame_push(d, 1, buf, length);
+}
+
+static void js220_return_code(struct dev_s * d, const char * topic, int32_t rc) {
+    char t[JS220_TOPIC_LENGTH];
+    tfp_snprintf(t, sizeof(t), "%s%c", topic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
+    js220_publish(d, t, &jsdrv_union_i32(rc));
+}
+
+static void js220_retain(struct dev_s * d, const char * topic, const struct jsdrv_union_s * value) {
+    if (jsdrv_union_is_type_ptr(value)) {
+        return;
+    }
+    struct retain_s * r = NULL;
+    for (uint32_t i = 0; i < d->retain_count; ++i) {
+        if (0 == strcmp(d->retain[i].topic, topic)) {
+            r = &d->retain[i];
+            break;
+        }
+    }
+    if (NULL == r) {
+        if (d->retain_count >= RETAIN_MAX) {
+            return;
+        }
+        r = &d->retain[d->retain_count++];
+        jsdrv_cstr_copy(r->topic, topic, sizeof(r->topic));
+    }
+    r->value = *value;
+    r->value.flags = JSDRV_UNION_FLAG_RETAIN;
+}
+
+static void js220_port_decimate_update(struct dev_s * d) {
+    for (uint32_t idx = 0; idx < JS220_PORTS; ++idx) {
+        const struct js220_port_def_s * def = &JS220_PORT_DEFS[idx];
+        struct js220_port_s * p = &d->ports[idx];
+        uint32_t decimate = def->decimate_min;
+        if (32 == def->element_bits) {
+            decimate *= d->signal_n;
+        } else if ((1 == def->element_bits) && d->gpi_mode) {
+            decimate = d->gpi_n;
+        }
+        if (decimate != p->decimate) {
+            p->decimate = decimate;
+            p->sample_id = align_up(p->sample_id, decimate);
+        }
+    }
+}
+
+static uint64_t js220_now(struct dev_s * d) {
+    if (d->backend->config.speed) {
+        return sample_id_due(d);
+    }
+    return d->sample_id;
+}
+
+static void js220_port_ctrl(struct dev_s * d, uint32_t idx, const struct jsdrv_union_s * value) {
+    bool enable = false;
+    uint32_t mask = 1U << idx;
+    jsdrv_union_to_bool(value, &enable);
+    if (!enable) {
+        d->port_enable &= ~mask;
+        return;
+    } else if (d->port_enable & mask) {
+        return;
+    }
+    uint64_t now = js220_now(d);
+    d->port_enable |= mask;
+    if (JS220_PORT_STATS == idx) {
+        d->stats_sample_id = align_up(now, 2);
+        d->stats_accum_sample_id = d->stats_sample_id;
+        d->stats_i_int = js220_i128_init_i64(0);
+        d->stats_p_int = js220_i128_init_i64(0);
     } else {
-        // todo add device
-        // todo remove device
-        JSDRV_LOGE("backend_handle_msg unsupported %s", msg->topic);
+        d->ports[idx].sample_id = align_up(now, d->ports[idx].decimate);
     }
-    jsdrvp_msg_free(s->context, msg);
-    return rv;
 }
 
-static void backend_ready(struct backend_s * s) {
-    struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc_value(s->context, JSDRV_MSG_INITIALIZE, &jsdrv_union_i32(0));
-    msg->payload.str[0] = s->backend.prefix;
-    jsdrvp_backend_send(s->context, msg);
+static void js220_handle_publish(struct dev_s * d, struct js220_publish_s * p, uint16_t length) {
+    struct jsdrv_union_s value;
+    char topic[JS220_TOPIC_LENGTH];
+    memcpy(topic, p->topic, sizeof(topic));
+    topic[sizeof(topic) - 1] = 0;
+    memset(&value, 0, sizeof(value));
+    value.type = p->type;
+    value.flags = p->flags;
+    value.op = p->op;
+    value.app = p->app;
+    if (length < sizeof(struct js220_publish_s)) {
+        return;
+    } else if (!jsdrv_union_is_type_ptr(&value) && (value.type != JSDRV_UNION_NULL)) {
+        memcpy(&value.value.u64, p->data, sizeof(uint64_t));
+    }
+    JSDRV_LOGD2("%s publish %s", d->ll.prefix, topic);
+
+    if (0 == strcmp("$", topic)) {
+        return;  // no instrument metadata
+    } else if (0 == strcmp("?", topic)) {
+        for (uint32_t i = 0; i < d->retain_count; ++i) {
+            js220_publish(d, d->retain[i].topic, &d->retain[i].value);
+        }
+        return;
+    } else if (0 == strcmp(JS220_TOPIC_PING, topic)) {
+        js220_publish(d, JS220_TOPIC_PONG, &value);
+        return;
+    }
+
+    struct jsdrv_union_s v = value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+        v.value.u32 = 0;
+    }
+    if (0 == strcmp("s/dwnN/N", topic)) {
+        d->signal_n = v.value.u32 ? v.value.u32 : 1;
+        js220_port_decimate_update(d);
+    } else if (0 == strcmp("s/gpi/+/dwnN/N", topic)) {
+        d->gpi_n = v.value.u32 ? v.value.u32 : 1;
+        js220_port_decimate_update(d);
+    } else if (0 == strcmp("s/gpi/+/dwnN/mode", topic)) {
+        d->gpi_mode = v.value.u32;
+        js220_port_decimate_update(d);
+    } else if (0 == strcmp("s/stats/scnt", topic)) {
+        d->stats_scnt = v.value.u32;
+        if ((0 == d->stats_scnt) || (d->stats_scnt > 0x00ffffff)) {
+            d->stats_scnt = JS220_STATS_SCNT_DEFAULT;
+        }
+    } else {
+        for (uint32_t idx = 0; idx < JS220_PORTS; ++idx) {
+            if (0 == strcmp(JS220_PORT_DEFS[idx].ctrl_topic, topic)) {
+                js220_port_ctrl(d, idx, &value);
+                break;
+            }
+        }
+    }
+    js220_retain(d, topic, &value);
+    js220_return_code(d, topic, 0);
 }
 
-static DWORD WINAPI backend_thread(LPVOID lpParam) {
-    struct backend_s * s = (struct backend_s *) lpParam;
-    JSDRV_LOGI("emulated backend_thread started");
+static void js220_bulk_out(struct dev_s * d, const uint8_t * data, uint32_t size) {
+    uint32_t frame[FRAME_SIZE / sizeof(uint32_t)];
+    for (uint32_t offset = 0; (offset + sizeof(uint32_t)) <= size; offset += FRAME_SIZE) {
+        uint32_t sz = size - offset;
+        if (sz > FRAME_SIZE) {
+            sz = FRAME_SIZE;
+        }
+        memset(frame, 0, sizeof(frame));
+        memcpy(frame, data + offset, sz);
+        uint16_t length = js220_frame_hdr_extract_length(frame[0]);
+        uint8_t port_id = js220_frame_hdr_extract_port_id(frame[0]);
+        if (length > JS220_PAYLOAD_SIZE_MAX) {
+            JSDRV_LOGW("%s bulk out invalid length %d", d->ll.prefix, (int) length);
+            continue;
+        }
+        switch (port_id) {
+            case 0: {
+                struct js220_port0_header_s * hdr = (struct js220_port0_header_s *) &frame[1];
+                if (JS220_PORT0_OP_ECHO == hdr->op) {
+                    ctrl_frame_push(d, 0, &frame[1], length);
+                }
+                break;  // ignore timesync responses
+            }
+            case 1:
+                js220_handle_publish(d, (struct js220_publish_s *) &frame[1], length);
+                break;
+            default:
+                JSDRV_LOGD1("%s bulk out port %d ignored", d->ll.prefix, (int) port_id);
+                break;
+        }
+    }
+}
+
+static void js220_connect(struct dev_s * d) {
+    struct js220_port0_msg_s m;
+    memset(&m, 0, sizeof(m));
+    d->ctrl_head = 0;
+    d->ctrl_tail = 0;
+    d->frame_id = 0;
+    d->port_enable = 0;
+    d->signal_n = 1;
+    d->gpi_n = 1;
+    d->gpi_mode = 0;
+    d->stats_scnt = JS220_STATS_SCNT_DEFAULT;
+    js220_port_decimate_update(d);
+    timing_start(d);
+    d->timemap_sample_id = d->sample_id;
+    d->connected = true;
+
+    m.port0_hdr.op = JS220_PORT0_OP_CONNECT;
+    m.payload.connect.protocol_version = JS220_PROTOCOL_VERSION_U32;
+    m.payload.connect.fw_version = JSDRV_VERSION_ENCODE_U32(1, 3, 0);
+    m.payload.connect.hw_version = JSDRV_VERSION_ENCODE_U32(1, 0, 0);
+    m.payload.connect.fpga_version = JSDRV_VERSION_ENCODE_U32(1, 3, 0);
+    ctrl_frame_push(d, 0, &m.port0_hdr, JS220_PORT0_CONNECT_LENGTH);
+}
+
+static void js220_disconnect(struct dev_s * d) {
+    d->connected = false;
+    d->port_enable = 0;
+    d->ctrl_head = 0;
+    d->ctrl_tail = 0;
+}
+
+static uint32_t js220_port_span(struct dev_s * d, uint32_t idx) {
+    const struct js220_port_def_s * def = &JS220_PORT_DEFS[idx];
+    if (JS220_PORT_STATS == idx) {
+        return 2 * d->stats_scnt;
+    }
+    return ((JS220_PORT_DATA_SIZE * 8) / def->element_bits) * d->ports[idx].decimate;
+}
+
+static uint64_t js220_port_start(struct dev_s * d, uint32_t idx) {
+    return (JS220_PORT_STATS == idx) ? d->stats_sample_id : d->ports[idx].sample_id;
+}
+
+static void js220_port_start_set(struct dev_s * d, uint32_t idx, uint64_t sample_id) {
+    if (JS220_PORT_STATS == idx) {
+        d->stats_sample_id = sample_id;
+    } else {
+        d->ports[idx].sample_id = sample_id;
+    }
+}
 
-    HANDLE handles[1];
-    handles[0] = msg_queue_handle_get(s->backend.cmd_q);
-    backend_ready(s);
+static bool is_js220_port_emulated(uint32_t idx) {
+    return (JS220_PORT_STATS == idx) || (0 != JS220_PORT_DEFS[idx].element_bits);
+}
 
-    while (!s->do_exit) {
-        WaitForMultipleObjects(1, handles, false, 5000);
-        if (WAIT_OBJECT_0 == WaitForSingleObject(handles[0], 0)) {
-            ResetEvent(handles[0]);
-            while (1) {
-                struct jsdrvp_msg_s * msg = msg_queue_pop_immediate(s->backend.cmd_q);
-                if (!backend_handle_msg(s, msg)) {
-                    break;
+static void js220_overflow(struct dev_s * d, uint64_t due) {
+    uint64_t oldest = UINT64_MAX;
+    for (uint32_t idx = 0; idx < JS220_PORTS; ++idx) {
+        if ((d->port_enable & (1U << idx)) && is_js220_port_emulated(idx)) {
+            uint64_t start = js220_port_start(d, idx);
+            if (start < oldest) {
+                oldest = start;
+            }
+        }
+    }
+    if ((UINT64_MAX == oldest) || ((oldest + FIFO_SAMPLES) >= due)) {
+        return;
+    }
+    JSDRV_LOGI("%s FIFO overflow, skip %" PRIu64 " samples", d->ll.prefix, due - oldest);
+    for (uint32_t idx = 0; idx < JS220_PORTS; ++idx) {
+        uint32_t decimate = (JS220_PORT_STATS == idx) ? 2 : d->ports[idx].decimate;
+        js220_port_start_set(d, idx, align_up(due, decimate));
+    }
+    d->stats_accum_sample_id = d->stats_sample_id;
+    d->stats_i_int = js220_i128_init_i64(0);
+    d->stats_p_int = js220_i128_init_i64(0);
+}
+
+// Replace the raw frame payload with its encoding when smaller, like firmware with compression enabled.
+static void js220_port_encode(struct dev_s * d, uint32_t idx) {
+    uint8_t buf[JS220_PORT_DATA_SIZE - sizeof(uint32_t)];
+    const uint8_t * data = (const uint8_t *) &d->frame[2];
+    uint32_t bits = JS220_PORT_DEFS[idx].element_bits;
+    uint32_t codec = JSDRV_CODEC_RAW;
+    uint32_t sz = 0;
+    if (32 == bits) {
+        codec = JSDRV_CODEC_XOR_F32;
+        sz = jsdrv_codec_xor_f32_encode((const float *) data, JS220_PORT_DATA_SIZE / sizeof(float), buf, sizeof(buf));
+    } else if (bits < 8) {
+        codec = JSDRV_CODEC_RLE8;
+        sz = jsdrv_codec_rle8_encode(data, JS220_PORT_DATA_SIZE, buf, sizeof(buf));
+    }
+    if (0 == sz) {
+        return;  // send raw
+    }
+    d->frame[0] = js220_frame_hdr_pack(js220_frame_hdr_extract_frame_id(d->frame[0]),
+                                       (uint16_t) (2 * sizeof(uint32_t) + sz), (uint8_t) (16 + idx))
+            | (codec << 30);
+    d->frame[2] = JS220_PORT_DATA_SIZE;  // decoded length
+    memcpy(&d->frame[3], buf, sz);
+}
+
+static void js220_port_frame(struct dev_s * d, uint32_t idx) {
+    const struct js220_port_def_s * def = &JS220_PORT_DEFS[idx];
+    struct js220_port_s * p = &d->ports[idx];
+    uint32_t count = (JS220_PORT_DATA_SIZE * 8) / def->element_bits;
+    uint32_t decimate = p->decimate;
+    uint64_t sample_id = p->sample_id;
+    float i;
+    float v;
+    memset(d->frame, 0, sizeof(d->frame));
+    d->frame[0] = js220_frame_hdr_pack(d->frame_id++, JS220_PAYLOAD_SIZE_MAX, (uint8_t) (16 + idx));
+    d->frame[1] = (uint32_t) (sample_id & 0xffffffffU);
+    uint8_t * data = (uint8_t *) &d->frame[2];
+
+    if (32 == def->element_bits) {
+        float * f = (float *) data;
+        for (uint32_t k = 0; k < count; ++k) {
+            js220_pattern(d, sample_id + k * decimate, &i, &v);
+            switch (idx) {
+                case 5: f[k] = i; break;
+                case 6: f[k] = v; break;
+                default: f[k] = i * v; break;
+            }
+        }
+    } else if (16 == def->element_bits) {
+        int16_t * a = (int16_t *) data;
+        for (uint32_t k = 0; k < count; ++k) {
+            js220_pattern(d, sample_id + k * decimate, &i, &v);
+            a[k] = (int16_t) (((idx & 1) ? v : i) * 1000.0f);
+        }
+    } else if (4 == def->element_bits) {
+        uint8_t range = (JSDRV_EMULATED_PATTERN_RAMP == d->backend->config.pattern) ? 0 : 2;
+        memset(data, range | (range << 4), JS220_PORT_DATA_SIZE);
+    } else {
+        uint32_t shift = 12 + ((idx == 12) ? 7 : (idx - 8));
+        for (uint32_t k = 0; k < count; ++k) {
+            uint8_t bit = (uint8_t) (((sample_id + k * decimate) >> shift) & 1);
+            data[k >> 3] |= bit << (k & 7);
+        }
+    }
+    p->sample_id += count * decimate;
+    if (d->backend->config.codec) {
+        js220_port_encode(d, idx);
+    }
+    frame_send_data(d);
+}
+
+static void js220_stats_frame(struct dev_s * d) {
+    struct js220_statistics_raw_s r;
+    const double q31 = 2147483648.0;
+    const double q27 = 134217728.0;
+    float i;
+    float v;
+    int64_t p_x1 = 0;
+    memset(&r, 0, sizeof(r));
+    r.header = 0x92000000U | (d->stats_scnt & 0x00ffffffU);
+    r.sample_freq = SAMPLE_RATE;
+    r.block_sample_id = d->stats_sample_id;
+    r.accum_sample_id = d->stats_accum_sample_id;
+    r.i_min = INT64_MAX;
+    r.i_max = INT64_MIN;
+    r.v_min = INT64_MAX;
+    r.v_max = INT64_MIN;
+    r.p_min = INT64_MAX;
+    r.p_max = INT64_MIN;
+    r.i_x2 = js220_i128_init_i64(0);
+    r.v_x2 = js220_i128_init_i64(0);
+    r.p_x2 = js220_i128_init_i64(0);
+    for (uint32_t k = 0; k < d->stats_scnt; ++k) {
+        js220_pattern(d, d->stats_sample_id + 2 * k, &i, &v);
+        int64_t iq = (int64_t) (i * q31);
+        int64_t vq = (int64_t) (v * q31);
+        int64_t pq = (int64_t) (i * v * q27);
+        r.i_x1 += iq;
+        r.v_x1 += vq;
+        p_x1 += pq;
+        r.i_min = (iq < r.i_min) ? iq : r.i_min;
+        r.i_max = (iq > r.i_max) ? iq : r.i_max;
+        r.v_min = (vq < r.v_min) ? vq : r.v_min;
+        r.v_max = (vq > r.v_max) ? vq : r.v_max;
+        r.p_min = (pq < r.p_min) ? pq : r.p_min;
+        r.p_max = (pq > r.p_max) ? pq : r.p_max;
+        r.i_x2 = js220_i128_add(r.i_x2, js220_i128_square_i64(iq));
+        r.v_x2 = js220_i128_add(r.v_x2, js220_i128_square_i64(vq));
+        r.p_x2 = js220_i128_add(r.p_x2, js220_i128_square_i64(pq));
+    }
+    r.p_x1 = p_x1;
+    d->stats_i_int = js220_i128_add(d->stats_i_int, js220_i128_init_i64(r.i_x1));
+    d->stats_p_int = js220_i128_add(d->stats_p_int, js220_i128_lshift(js220_i128_init_i64(p_x1), 4));
+    r.i_int = d->stats_i_int;
+    r.p_int = d->stats_p_int;
+    r.v_int = js220_i128_init_i64(0);
+    d->stats_sample_id += 2 * d->stats_scnt;
+
+    memset(d->frame, 0, sizeof(d->frame));
+    d->frame[0] = js220_frame_hdr_pack(d->frame_id++, sizeof(r), (uint8_t) (16 + JS220_PORT_STATS));
+    memcpy(&d->frame[1], &r, sizeof(r));
+    frame_send_data(d);
+}
+
+static void js220_timemap_frame(struct dev_s * d) {
+    struct js220_port0_msg_s m;
+    memset(&m, 0, sizeof(m));
+    uint64_t counter = d->timemap_sample_id;
+    double dt = ((double) (counter - d->sample_id_start)) / SAMPLE_RATE;
+    m.frame_hdr.u32 = js220_frame_hdr_pack(d->frame_id++, JS220_PORT0_TIMEMAP_LENGTH, 0);
+    m.port0_hdr.op = JS220_PORT0_OP_TIMEMAP;
+    m.payload.timemap.utc = d->time_start + JSDRV_F64_TO_TIME(dt);
+    m.payload.timemap.counter = counter;
+    m.payload.timemap.counter_rate = ((uint64_t) SAMPLE_RATE) << 32;
+    memset(d->frame, 0, sizeof(d->frame));
+    memcpy(d->frame, &m, sizeof(m));
+    frame_copy(d, d->frame);
+    d->timemap_sample_id += SAMPLE_RATE;
+}
+
+static void js220_process(struct dev_s * d) {
+    bool paced = (0 != d->backend->config.speed);
+    uint64_t due = sample_id_due(d);
+    if (!d->connected) {
+        return;
+    }
+    if (paced) {
+        js220_overflow(d, due);
+    }
+    while (frame_space(d)) {
+        // emit frames in the order that the instrument completes them
+        uint32_t item = JS220_ITEM_NONE;
+        uint64_t end = UINT64_MAX;
+        for (uint32_t idx = 0; idx < JS220_PORTS; ++idx) {
+            if ((d->port_enable & (1U << idx)) && is_js220_port_emulated(idx)) {
+                uint64_t e = js220_port_start(d, idx) + js220_port_span(d, idx);
+                if (e < end) {
+                    end = e;
+                    item = idx;
                 }
             }
+        }
+        if ((d->timemap_sample_id <= end) && (paced || (JS220_ITEM_NONE != item))) {
+            item = JS220_ITEM_TIMEMAP;
+            end = d->timemap_sample_id;
+        }
+        if ((JS220_ITEM_NONE == item) || (end > due)) {
+            break;
+        }
+        if (!paced && (end > d->sample_id)) {
+            d->sample_id = end;
+        }
+        if (JS220_ITEM_TIMEMAP == item) {
+            js220_timemap_frame(d);
+        } else if (JS220_PORT_STATS == item) {
+            js220_stats_frame(d);
+        } else {
+            js220_port_frame(d, item);
+        }
+    }
+    if (paced) {
+        d->sample_id = due;
+    }
+}
 
+static void js110_process(struct dev_s * d) {
+    uint64_t due = sample_id_due(d);
+    const uint32_t span = JS110_FRAME_SAMPLES;
+    if (!d->streaming) {
+        return;
+    }
+    if (d->backend->config.speed && ((d->sample_id + FIFO_SAMPLES) < due)) {
+        uint64_t frames = (due - d->sample_id) / span;
+        JSDRV_LOGI("%s FIFO overflow, skip %" PRIu64 " samples", d->ll.prefix, frames * span);
+        d->sample_id += frames * span;
+        d->pkt_index = (uint16_t) (d->pkt_index + frames);
+    }
+    while (((d->sample_id + span) <= due) && frame_space(d)) {
+        uint8_t * p_u8 = (uint8_t *) d->frame;
+        uint16_t length = FRAME_SIZE | (((d->settings.options >> 1) & 1) << 15);
+        p_u8[0] = 1;  // buffer type
+        p_u8[1] = 0;  // status
+        p_u8[2] = (uint8_t) (length & 0xff);
+        p_u8[3] = (uint8_t) ((length >> 8) & 0xff);
+        p_u8[4] = (uint8_t) (d->pkt_index & 0xff);
+        p_u8[5] = (uint8_t) ((d->pkt_index >> 8) & 0xff);
+        p_u8[6] = 0;
+        p_u8[7] = 0;
+        for (uint32_t k = 0; k < span; ++k) {
+            d->frame[2 + k] = js110_pattern(d, d->sample_id + k);
         }
+        d->sample_id += span;
+        ++d->pkt_index;
+        frame_send_data(d);
     }
+}
+
+static uint32_t js110_packet(struct dev_s * d, uint8_t type, uint8_t * buf) {
+    struct js110_host_packet_s pkt;
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.header.version = JS110_HOST_API_VERSION;
+    pkt.header.type = type;
+    switch (type) {
+        case JS110_HOST_PACKET_TYPE_SETTINGS:
+            pkt.header.length = 16;
+            pkt.payload.settings = d->settings;
+            break;
+        case JS110_HOST_PACKET_TYPE_EXTIO:
+            pkt.header.length = 24;
+            pkt.payload.extio = d->extio;
+            break;
+        default:
+            pkt.header.length = (uint8_t) (sizeof(pkt.header) + sizeof(pkt.payload.status));
+            pkt.payload.status.settings_result = 0;
+            pkt.payload.status.sensor_select = d->settings.select;
+            pkt.payload.status.sensor_source = d->settings.source;
+            pkt.payload.status.sensor_options = d->settings.options;
+            pkt.payload.status.samples_total = (int64_t) d->sample_id;
+            pkt.payload.status.samples_this = 0;  // on-instrument statistics not emulated
+            break;
+    }
+    memcpy(buf, &pkt, pkt.header.length);
+    return pkt.header.length;
+}
 
-    JSDRV_LOGI("emulated backend_thread done");
+static int32_t js110_ctrl_in(struct dev_s * d, const usb_setup_t * setup, uint8_t * buf, uint32_t * size) {
+    struct backend_s * s = d->backend;
+    uint32_t sz = 0;
+    switch (setup->s.bRequest) {
+        case JS110_HOST_USB_REQUEST_LOOPBACK_BUFFER:
+            sz = sizeof(d->loopback);
+            memcpy(buf, d->loopback, sz);
+            break;
+        case JS110_HOST_USB_REQUEST_SETTINGS:
+            sz = js110_packet(d, JS110_HOST_PACKET_TYPE_SETTINGS, buf);
+            break;
+        case JS110_HOST_USB_REQUEST_STATUS:
+            sz = js110_packet(d, JS110_HOST_PACKET_TYPE_STATUS, buf);
+            break;
+        case JS110_HOST_USB_REQUEST_EXTIO:
+            sz = js110_packet(d, JS110_HOST_PACKET_TYPE_EXTIO, buf);
+            break;
+        case JS110_HOST_USB_REQUEST_SERIAL_NUMBER: {
+            const char * sn = strrchr(d->ll.prefix, '/') + 1;
+            sz = (uint32_t) strlen(sn);
+            memcpy(buf, sn, sz);
+            break;
+        }
+        case JS110_HOST_USB_REQUEST_CALIBRATION:
+            if (setup->s.wIndex < s->cal_size) {
+                sz = s->cal_size - setup->s.wIndex;
+                if (sz > JSDRV_PAYLOAD_LENGTH_MAX) {
+                    sz = JSDRV_PAYLOAD_LENGTH_MAX;
+                }
+                memcpy(buf, s->cal + setup->s.wIndex, sz);
+            }
+            break;
+        default:
+            return JSDRV_ERROR_NOT_SUPPORTED;
+    }
+    if (sz > setup->s.wLength) {
+        sz = setup->s.wLength;
+    }
+    *size = sz;
     return 0;
 }
 
+static int32_t js110_ctrl_out(struct dev_s * d, const usb_setup_t * setup, const uint8_t * buf, uint32_t size) {
+    struct js110_host_packet_s pkt;
+    memset(&pkt, 0, sizeof(pkt));
+    memcpy(&pkt, buf, (size < sizeof(pkt)) ? size : sizeof(pkt));
+    switch (setup->s.bRequest) {
+        case JS110_HOST_USB_REQUEST_LOOPBACK_BUFFER:
+            memcpy(d->loopback, buf, (size < sizeof(d->loopback)) ? size : sizeof(d->loopback));
+            return 0;
+        case JS110_HOST_USB_REQUEST_SETTINGS: {
+            if ((size < 16) || (pkt.header.type != JS110_HOST_PACKET_TYPE_SETTINGS)) {
+                return JSDRV_ERROR_PARAMETER_INVALID;
+            }
+            bool streaming = (0x03 == (pkt.payload.settings.streaming & 0x03));
+            d->settings = pkt.payload.settings;
+            if (streaming && !d->streaming) {
+                timing_start(d);
+            }
+            d->streaming = streaming;
+            return 0;
+        }
+        case JS110_HOST_USB_REQUEST_EXTIO:
+            if ((size < 24) || (pkt.header.type != JS110_HOST_PACKET_TYPE_EXTIO)) {
+                return JSDRV_ERROR_PARAMETER_INVALID;
+            }
+            d->extio = pkt.payload.extio;
+            return 0;
+        default:
+            return JSDRV_ERROR_NOT_SUPPORTED;
+    }
+}
+
+static void ctrl_in(struct dev_s * d, struct jsdrvp_msg_s * msg) {
+    const usb_setup_t * setup = &msg->extra.bkusb_ctrl.setup;
+    uint32_t sz = 0;
+    int32_t rc = 0;
+    if (MODEL_JS110 == d->model) {
+        rc = js110_ctrl_in(d, setup, msg->payload.bin, &sz);
+    } else if ((JS220_CTRL_OP_CONNECT == setup->s.bRequest) || (JS220_CTRL_OP_DISCONNECT == setup->s.bRequest)) {
+        if (JS220_CTRL_OP_CONNECT == setup->s.bRequest) {
+            js220_connect(d);
+        } else {
+            js220_disconnect(d);
+        }
+        msg->payload.bin[0] = 0;
+        sz = 1;
+    } else {
+        rc = JSDRV_ERROR_NOT_SUPPORTED;
+    }
+    if (0 == rc) {
+        msg->value = jsdrv_union_bin(msg->payload.bin, sz);
+    } else {
+        sz = 0;
+    }
+    msg->extra.bkusb_ctrl.status = rc;
+    jsdrv_usb_trace_write(d->trace, JSDRV_USB_TRACE_CTRL_IN, 0, setup->u64, rc, msg->payload.bin, sz);
+    msg_queue_push(d->ll.rsp_q, msg);
+}
+
+static void ctrl_out(struct dev_s * d, struct jsdrvp_msg_s * msg) {
+    int32_t rc = JSDRV_ERROR_NOT_SUPPORTED;
+    if (MODEL_JS110 == d->model) {
+        rc = js110_ctrl_out(d, &msg->extra.bkusb_ctrl.setup, msg->value.value.bin, msg->value.size);
+    }
+    msg->extra.bkusb_ctrl.status = rc;
+    jsdrv_usb_trace_write(d->trace, JSDRV_USB_TRACE_CTRL_OUT, 0, msg->extra.bkusb_ctrl.setup.u64, rc,
+                          msg->value.value.bin, msg->value.size);
+    msg_queue_push(d->ll.rsp_q, msg);
+}
+
+static void bulk_in_close(struct dev_s * d) {
+    d->bulk_in_open = false;
+    if (NULL != d->transfer) {
+        transfer_destroy(d, d->transfer);
+        d->transfer = NULL;
+    }
+    d->transfer_ctrl = false;
+    transfers_free_clear(d);
+}
+
+static void bulk_in_open(struct dev_s * d, struct jsdrvp_msg_s * msg) {
+    bulk_in_close(d);
+    d->bulk_in_endpoint = msg->extra.bkusb_stream.endpoint;
+    d->bulk_in_depth = jsdrv_usbbk_bulk_in_depth(msg->extra.bkusb_stream.transfer_depth);
+    d->bulk_in_size = jsdrv_usbbk_bulk_in_size(msg->extra.bkusb_stream.transfer_size);
+    d->bulk_in_spare = jsdrv_usbbk_bulk_in_spare(msg->extra.bkusb_stream.transfer_spare);
+    JSDRV_LOGI("bulk_in_open(%s, endpoint=0x%02x, depth=%" PRIu32 ", size=%" PRIu32 ", spare=%" PRIu32 ")",
+               d->ll.prefix, (int) d->bulk_in_endpoint, d->bulk_in_depth, d->bulk_in_size, d->bulk_in_spare);
+    for (uint32_t i = 0; i < (d->bulk_in_depth + d->bulk_in_spare); ++i) {
+        struct transfer_s * t = jsdrv_alloc_clr(sizeof(struct transfer_s) + d->bulk_in_size);
+        jsdrv_list_initialize(&t->item);
+        t->buffer_size = d->bulk_in_size;
+        t->msg = jsdrvp_msg_alloc(d->backend->context);
+        jsdrv_cstr_copy(t->msg->topic, JSDRV_USBBK_MSG_STREAM_IN_DATA, sizeof(t->msg->topic));
+        jsdrv_list_add_tail(&d->transfers_free, &t->item);
+    }
+    d->bulk_in_open = true;
+    msg->value = jsdrv_union_i32(0);
+    msg_queue_push(d->ll.rsp_q, msg);
+}
+
+static void trace_close(struct dev_s * d) {
+    if (NULL != d->trace) {
+        jsdrv_usb_trace_close(d->trace);
+        d->trace = NULL;
+    }
+}
+
+static void trace_open(struct dev_s * d) {
+    char path[1024];
+    const char * dir = d->backend->config.trace_dir;
+    trace_close(d);
+    if ((NULL != dir) && (0 == jsdrv_usb_trace_path(dir, d->ll.prefix, path, sizeof(path)))) {
+        d->trace = jsdrv_usb_trace_open(path, d->ll.prefix);
+    }
+}
+
+static void device_close(struct dev_s * d) {
+    bulk_in_close(d);
+    js220_disconnect(d);
+    d->streaming = false;
+    d->open = false;
+    trace_close(d);
+}
+
+static void device_handle_msg(struct dev_s * d, struct jsdrvp_msg_s * msg) {
+    if (0 == strcmp(JSDRV_USBBK_MSG_STREAM_IN_DATA, msg->topic)) {
+        transfer_return(d, msg);
+        return;
+    }
+    JSDRV_LOGD2("device_handle_msg(%s) %s", d->ll.prefix, msg->topic);
+    if (0 == strcmp(JSDRV_USBBK_MSG_BULK_OUT_DATA, msg->topic)) {
+        jsdrv_usb_trace_write(d->trace, JSDRV_USB_TRACE_BULK_OUT, msg->extra.bkusb_stream.endpoint, 0, 0,
+                              msg->value.value.bin, msg->value.size);
+        if (MODEL_JS220 == d->model) {
+            js220_bulk_out(d, msg->value.value.bin, msg->value.size);
+        }
+        msg->value = jsdrv_union_i32(0);
+    } else if (0 == strcmp(JSDRV_USBBK_MSG_CTRL_IN, msg->topic)) {
+        ctrl_in(d, msg);
+        return;
+    } else if (0 == strcmp(JSDRV_USBBK_MSG_CTRL_OUT, msg->topic)) {
+        ctrl_out(d, msg);
+        return;
+    } else if (0 == strcmp(JSDRV_USBBK_MSG_BULK_IN_STREAM_OPEN, msg->topic)) {
+        bulk_in_open(d, msg);
+        return;
+    } else if (0 == strcmp(JSDRV_USBBK_MSG_BULK_IN_STREAM_CLOSE, msg->topic)) {
+        bulk_in_close(d);
+        msg->value = jsdrv_union_i32(0);
+    } else if (0 == strcmp(JSDRV_MSG_OPEN, msg->topic)) {
+        JSDRV_LOGI("device_open(%s)", d->ll.prefix);
+        trace_open(d);
+        d->open = true;
+        msg->value = jsdrv_union_i32(0);
+    } else if ((0 == strcmp(JSDRV_MSG_CLOSE, msg->topic)) || (0 == strcmp(JSDRV_MSG_FINALIZE, msg->topic))) {
+        JSDRV_LOGI("device_close(%s)", d->ll.prefix);
+        device_close(d);
+        msg->value = jsdrv_union_i32(0);
+    } else {
+        JSDRV_LOGW("unsupported topic %s", msg->topic);
+        msg->value = jsdrv_union_i32(JSDRV_ERROR_PARAMETER_INVALID);
+    }
+    msg_queue_push(d->ll.rsp_q, msg);
+}
+
+static void device_process(struct dev_s * d) {
+    d->time_now = jsdrv_time_utc();
+    ctrl_frames_process(d);
+    if (MODEL_JS220 == d->model) {
+        js220_process(d);
+    } else {
+        js110_process(d);
+    }
+    struct transfer_s * t = d->transfer;
+    if ((NULL != t) && !is_stalled(d)
+            && (d->transfer_ctrl || ((d->time_now - t->time_start) >= (FLUSH_TIMEOUT_MS * JSDRV_TIME_MILLISECOND)))) {
+        transfer_send(d);
+    }
+}
+
+static bool device_is_active(struct dev_s * d) {
+    return d->bulk_in_open && (d->connected || d->streaming || (d->ctrl_tail != d->ctrl_head));
+}
+
+static THREAD_RETURN_TYPE device_thread(THREAD_ARG_TYPE lpParam) {
+    struct dev_s * d = (struct dev_s *) lpParam;
+    struct jsdrvp_msg_s * msg = NULL;
+    JSDRV_LOGI("emulated device thread started %s", d->ll.prefix);
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_USB);
+    while (!d->do_exit) {
+        uint32_t timeout_ms = device_is_active(d) ? LOOP_TIMEOUT_MS : IDLE_TIMEOUT_MS;
+        if (0 == msg_queue_pop(d->ll.cmd_q, &msg, timeout_ms)) {
+            device_handle_msg(d, msg);
+            while (NULL != (msg = msg_queue_pop_immediate(d->ll.cmd_q))) {
+                device_handle_msg(d, msg);
+            }
+        }
+        device_process(d);
+    }
+    JSDRV_LOGI("emulated device thread done %s", d->ll.prefix);
+    jsdrv_thread_unregister();
+    THREAD_RETURN();
+}
+
+static void queue_drain(struct dev_s * d, struct msg_queue_s * q) {
+    struct jsdrvp_msg_s * msg;
+    while (NULL != (msg = msg_queue_pop_immediate(q))) {
+        if (0 == strcmp(JSDRV_USBBK_MSG_STREAM_IN_DATA, msg->topic)) {
+            struct transfer_s * t = JSDRV_CONTAINER_OF(msg->value.value.bin, struct transfer_s, buffer);
+            if (t->msg == msg) {
+                transfer_destroy(d, t);
+                continue;
+            }
+        }
+        jsdrvp_msg_free(d->backend->context, msg);
+    }
+}
+
+static void device_free(struct dev_s * d) {
+    if (d->thread) {
+        d->do_exit = true;
+        jsdrv_thread_join(&d->thread, 1000);
+    }
+    bulk_in_close(d);
+    trace_close(d);
+    queue_drain(d, d->ll.cmd_q);
+    queue_drain(d, d->ll.rsp_q);
+    msg_queue_finalize(d->ll.cmd_q);
+    msg_queue_finalize(d->ll.rsp_q);
+    jsdrv_free(d);
+}
+
+static void device_add_announce(struct backend_s * s, struct dev_s * d) {
+    struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc(s->context);
+    jsdrv_cstr_copy(msg->topic, JSDRV_MSG_DEVICE_ADD, sizeof(msg->topic));
+    msg->value.type = JSDRV_UNION_BIN;
+    msg->value.app = JSDRV_PAYLOAD_TYPE_DEVICE;
+    msg->value.value.bin = (const uint8_t *) &msg->payload.device;
+    msg->payload.device = d->ll;
+    jsdrvp_backend_send(s->context, msg);
+}
+
+static int32_t device_add(struct backend_s * s, uint8_t model, uint32_t index) {
+    if (s->device_count >= DEVICES_MAX) {
+        JSDRV_LOGW("too many emulated devices");
+        return JSDRV_ERROR_TOO_BIG;
+    }
+    struct dev_s * d = jsdrv_alloc_clr(sizeof(struct dev_s));
+    d->backend = s;
+    d->model = model;
+    jsdrv_list_initialize(&d->transfers_free);
+    d->signal_n = 1;
+    d->gpi_n = 1;
+    d->stats_scnt = JS220_STATS_SCNT_DEFAULT;
+    js220_port_decimate_update(d);
+    d->settings.sensor_power = 1;
+    d->settings.select = 0x80;  // auto range
+    d->settings.source = 0xC0;
+    d->extio.io_voltage_mv = 3300;
+    tfp_snprintf(d->ll.prefix, sizeof(d->ll.prefix), "%c/%s/EMU%03u",
+                 s->backend.prefix, (MODEL_JS220 == model) ? "js220" : "js110", (unsigned) (index + 1));
+    d->ll.cmd_q = msg_queue_init_spsc(MSG_QUEUE_SPSC_CAPACITY_DEFAULT);
+    d->ll.rsp_q = msg_queue_init_spsc(MSG_QUEUE_SPSC_CAPACITY_DEFAULT);
+    msg_queue_lanes_enable(d->ll.rsp_q);
+    s->devices[s->device_count++] = d;
+    if (jsdrv_thread_create(&d->thread, device_thread, d, 1)) {
+        JSDRV_LOGE("emulated device thread create failed");
+        return JSDRV_ERROR_UNSPECIFIED;
+    }
+    device_add_announce(s, d);
+    return 0;
+}
+
+static void js110_cal_create(struct backend_s * s) {
+    char json[512];
+    int n = snprintf(json, sizeof(json), "{\"current\": {\"offset\": [0, 0, 0, 0, 0, 0, 0], \"gain\": [");
+    for (size_t i = 0; i < JSDRV_ARRAY_SIZE(JS110_I_RANGE); ++i) {
+        n += snprintf(json + n, sizeof(json) - n, "%s%.17g", i ? ", " : "", JS110_I_RANGE[i] / 16384.0);
+    }
+    n += snprintf(json + n, sizeof(json) - n, "]}, \"voltage\": {\"offset\": [0, 0], \"gain\": [%.17g, %.17g]}}",
+                  JS110_V_RANGE[0] / 16384.0, JS110_V_RANGE[1] / 16384.0);
+    uint32_t json_size = (uint32_t) n + 1;
+    uint32_t tlv_length = 8 + json_size + 4;  // tag, length, value, crc32
+    tlv_length = (tlv_length + 7) & ~7U;
+    s->cal_size = (uint32_t) sizeof(struct js110_cal_header_s) + tlv_length;
+    s->cal = jsdrv_alloc_clr(s->cal_size);
+    struct js110_cal_header_s hdr;
+    memcpy(hdr.magic, JS110_CAL_MAGIC, sizeof(hdr.magic));
+    hdr.length = s->cal_size;
+    hdr.version = 1;
+    hdr.crc32 = 0xE1A7ED00U;  // host cache key only, the emulated record never changes
+    memcpy(s->cal, &hdr, sizeof(hdr));
+    uint32_t tl[2] = {0x534A41U, json_size};  // "AJS" JSON calibration tag
+    memcpy(s->cal + sizeof(hdr), tl, sizeof(tl));
+    memcpy(s->cal + sizeof(hdr) + sizeof(tl), json, json_size);
+}
+
+static uint32_t arg_u32(struct jsdrv_context_s * context, const char * topic, uint32_t default_value) {
+    const struct jsdrv_union_s * arg = jsdrvp_arg_get(context, topic);
+    if (NULL != arg) {
+        struct jsdrv_union_s v = *arg;
+        if (0 == jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+            return v.value.u32;
+        }
+        JSDRV_LOGW("invalid argument type for %s", topic);
+    }
+    return default_value;
+}
+
+static char * arg_str_copy(struct jsdrv_context_s * context, const char * topic) {
+    const struct jsdrv_union_s * arg = jsdrvp_arg_get(context, topic);
+    if (NULL == arg) {
+        return NULL;
+    } else if ((arg->type != JSDRV_UNION_STR) || (NULL == arg->value.str) || !arg->value.str[0]) {
+        JSDRV_LOGW("invalid argument type for %s", topic);
+        return NULL;
+    }
+    size_t sz = strlen(arg->value.str) + 1;
+    char * str = jsdrv_alloc(sz);
+    memcpy(str, arg->value.str, sz);
+    return str;
+}
+
 static void backend_finalize(struct jsdrvbk_s * backend) {
     if (backend) {
         struct backend_s * s = (struct backend_s *) backend;
         JSDRV_LOGI("finalize emulated backend");
-        if (s->thread) {
-            jsdrvp_send_finalize_msg(s->context, s->backend.cmd_q, JSDRV_MSG_FINALIZE);
-            // and wait for thread to exit.
-            if (WAIT_OBJECT_0 != WaitForSingleObject(s->thread, 1000)) {
-                JSDRV_LOGE("emulated thread not closed cleanly.");
-            }
-            CloseHandle(s->thread);
-            s->thread = NULL;
+        for (uint32_t i = 0; i < s->device_count; ++i) {
+            device_free(s->devices[i]);
+            s->devices[i] = NULL;
         }
         if (s->backend.cmd_q) {
             msg_queue_finalize(s->backend.cmd_q);
             s->backend.cmd_q = NULL;
         }
+        jsdrv_free(s->cal);
+        jsdrv_free(s->config.trace_dir);
         jsdrv_free(s);
     }
 }
 
 int32_t jsdrv_emulation_backend_factory(struct jsdrv_context_s * context, struct jsdrvbk_s ** backend) {
-    struct backend_s * self = jsdrv_alloc_clr(sizeof(struct backend_s));
-    self->context = context;
-    self->backend.prefix = 'z';
-    self->backend.finalize = backend_finalize;
-    self->backend.cmd_q = msg_queue_init();
-
-    self->thread = CreateThread(
-            NULL,                   // default security attributes
-            0,                      // use default stack size
-            backend_thread,         // thread function name
-            self,                   // argument to thread function
-            0,                      // use default creation flags
-            &self->thread_id);      // returns the thread identifier
-    if (self->thread == NULL) {
-        JSDRV_LOGE("CreateThread failed");
-        backend_finalize(&self->backend);
-        return JSDRV_ERROR_UNSPECIFIED;
-    }
-    if (!SetThreadPriority(self->thread, THREAD_PRIORITY_ABOVE_NORMAL)) {
-        WINDOWS_LOGE("%s", "SetThreadPriority");
+    int32_t rc = 0;
+    struct backend_s * s = jsdrv_alloc_clr(sizeof(struct backend_s));
+    s->context = context;
+    s->backend.prefix = BACKEND_PREFIX;
+    s->backend.finalize = backend_finalize;
+    s->backend.cmd_q = msg_queue_init();
+    s->config.pattern = arg_u32(context, JSDRV_ARG_EMULATED_PATTERN, JSDRV_EMULATED_PATTERN_SINE);
+    s->config.speed = arg_u32(context, JSDRV_ARG_EMULATED_SPEED, 100);
+    s->config.skip = arg_u32(context, JSDRV_ARG_EMULATED_SKIP, 0);
+    s->config.dup = arg_u32(context, JSDRV_ARG_EMULATED_DUP, 0);
+    s->config.stall = arg_u32(context, JSDRV_ARG_EMULATED_STALL, 0);
+    s->config.stall_ms = arg_u32(context, JSDRV_ARG_EMULATED_STALL_MS, STALL_MS_DEFAULT);
+    s->config.codec = arg_u32(context, JSDRV_ARG_EMULATED_CODEC, 0);
+    s->config.trace_dir = arg_str_copy(context, JSDRV_ARG_USB_TRACE);
+    for (uint32_t i = 0; i < SINE_LENGTH; ++i) {
+        s->sine[i] = (float) sin((2.0 * 3.14159265358979323846 * i) / SINE_LENGTH);
     }
+    js110_cal_create(s);
+
+    struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc_value(context, JSDRV_MSG_INITIALIZE, &jsdrv_union_i32(0));
+    msg->payload.str[0] = s->backend.prefix;
+    jsdrvp_backend_send(context, msg);
 
-    *backend = &self->backend;
+    uint32_t js220_count = arg_u32(context, JSDRV_ARG_EMULATED_JS220, 0);
+    uint32_t js110_count = arg_u32(context, JSDRV_ARG_EMULATED_JS110, 0);
+    for (uint32_t i = 0; (0 == rc) && (i < js220_count); ++i) {
+        rc = device_add(s, MODEL_JS220, i);
+    }
+    for (uint32_t i = 0; (0 == rc) && (i < js110_count); ++i) {
+        rc = device_add(s, MODEL_JS110, i);
+    }
+    if (rc) {
+        backend_finalize(&s->backend);
+        return rc;
+    }
+    *backend = &s->backend;
     return 0;
-}
\ No newline at end of file
+}
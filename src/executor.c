@@ -0,0 +1,266 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define JSDRV_LOG_LEVEL JSDRV_LOG_LEVEL_ALL
+#include "jsdrv_prv/executor.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/event.h"
+#include "jsdrv_prv/list.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/mutex.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv/time.h"
+#if !_WIN32
+#include <poll.h>
+#endif
+
+
+#define REMOVE_POLL_MS  (1U)
+
+enum task_state_e {
+    TASK_IDLE = 0,          // waiting for a signal or timer
+    TASK_READY = 1,         // in the ready list
+    TASK_RUNNING = 2,       // running on a worker
+    TASK_RUNNING_SIGNALED = 3,  // running, run again on completion
+    TASK_REMOVING = 4,      // running, do not run again
+    TASK_REMOVED = 5,       // safe to free
+};
+
+struct jsdrv_executor_task_s {
+    struct jsdrv_list_s item;       // in ready
+    struct jsdrv_list_s task_item;  // in tasks
+    struct jsdrv_executor_s * parent;
+    jsdrv_executor_fn fn;
+    void * user_data;
+    uint8_t state;                  // task_state_e, guarded by parent->mutex
+    bool timer;                     // true when deadline_ms is valid
+    uint32_t deadline_ms;           // jsdrv_time_ms_u32()
+};
+
+struct worker_s {
+    struct jsdrv_executor_s * parent;
+    jsdrv_thread_t thread;
+};
+
+struct jsdrv_executor_s {
+    jsdrv_os_mutex_t mutex;
+    jsdrv_os_event_t event;         // signalled while ready is not empty
+    struct jsdrv_list_s ready;
+    struct jsdrv_list_s tasks;
+    volatile bool do_exit;
+    uint32_t thread_count;
+    struct worker_s workers[JSDRV_EXECUTOR_THREADS_MAX];
+};
+
+static void event_wait(jsdrv_os_event_t ev, int32_t timeout_ms) {
+#if _WIN32
+    WaitForSingleObject(ev, (timeout_ms < 0) ? INFINITE : (DWORD) timeout_ms);
+#else
+    struct pollfd fds = {
+            .fd = ev->fd_poll,
+            .events = ev->events,
+            .revents = 0,
+    };
+    poll(&fds, 1, timeout_ms);
+#endif
+}
+
+// Call with the mutex held.
+static void ready_add(struct jsdrv_executor_s * self, struct jsdrv_executor_task_s * task) {
+    task->state = TASK_READY;
+    task->timer = false;
+    jsdrv_list_add_tail(&self->ready, &task->item);
+    jsdrv_os_event_signal(self->event);
+}
+
+// Move expired timers to ready and get the milliseconds to the next timer, -1 for none.
+// Call with the mutex held.
+static int32_t timers_process(struct jsdrv_executor_s * self) {
+    int32_t timeout_ms = -1;
+    uint32_t now = jsdrv_time_ms_u32();
+    struct jsdrv_list_s * item;
+    jsdrv_list_foreach(&self->tasks, item) {
+        struct jsdrv_executor_task_s * task = JSDRV_CONTAINER_OF(item, struct jsdrv_executor_task_s, task_item);
+        if (!task->timer || (TASK_IDLE != task->state)) {
+            continue;
+        }
+        uint32_t remaining = task->deadline_ms - now;
+        if ((0 == remaining) || (remaining > (1U << 31U))) {
+            ready_add(self, task);
+        } else if ((timeout_ms < 0) || (remaining < (uint32_t) timeout_ms)) {
+            timeout_ms = (int32_t) remaining;
+        }
+    }
+    return timeout_ms;
+}
+
+static void task_run(struct jsdrv_executor_s * self, struct jsdrv_executor_task_s * task) {
+    task->state = TASK_RUNNING;
+    jsdrv_os_mutex_unlock(self->mutex);
+    int32_t timeout_ms = task->fn(task->user_data);
+    jsdrv_os_mutex_lock(self->mutex);
+    if (timeout_ms >= 0) {
+        task->timer = true;
+        task->deadline_ms = jsdrv_time_ms_u32() + (uint32_t) timeout_ms;
+    } else {
+        task->timer = false;
+    }
+    switch (task->state) {
+        case TASK_RUNNING_SIGNALED: ready_add(self, task); break;
+        case TASK_REMOVING: task->state = TASK_REMOVED; break;
+        default: task->state = TASK_IDLE; break;
+    }
+}
+
+static THREAD_RETURN_TYPE worker_thread(THREAD_ARG_TYPE lpParam) {
+    struct worker_s * w = (struct worker_s *) lpParam;
+    struct jsdrv_executor_s * self = w->parent;
+    JSDRV_LOGI("executor worker started");
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_DEVICE);
+
+    jsdrv_os_mutex_lock(self->mutex);
+    while (!self->do_exit) {
+        int32_t timeout_ms = timers_process(self);
+        struct jsdrv_list_s * item = jsdrv_list_remove_head(&self->ready);
+        if (item) {
+            task_run(self, JSDRV_CONTAINER_OF(item, struct jsdrv_executor_task_s, item));
+            continue;
+        }
+        jsdrv_os_event_reset(self->event);  // ready is empty, signalled on the next add
+        jsdrv_os_mutex_unlock(self->mutex);
+        event_wait(self->event, timeout_ms);
+        jsdrv_os_mutex_lock(self->mutex);
+    }
+    jsdrv_os_mutex_unlock(self->mutex);
+    jsdrv_os_event_signal(self->event);  // wake the next worker to exit
+
+    JSDRV_LOGI("executor worker done");
+    jsdrv_thread_unregister();
+    THREAD_RETURN();
+}
+
+struct jsdrv_executor_s * jsdrv_executor_initialize(uint32_t thread_count) {
+    if (0 == thread_count) {
+        thread_count = 1;
+    } else if (thread_count > JSDRV_EXECUTOR_THREADS_MAX) {
+        JSDRV_LOGW("executor thread_count %u clamped to %u", thread_count, JSDRV_EXECUTOR_THREADS_MAX);
+        thread_count = JSDRV_EXECUTOR_THREADS_MAX;
+    }
+    struct jsdrv_executor_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_executor_s));
+    jsdrv_list_initialize(&self->ready);
+    jsdrv_list_initialize(&self->tasks);
+    self->mutex = jsdrv_os_mutex_alloc("executor");
+    self->event = jsdrv_os_event_alloc();
+    if ((NULL == self->mutex) || (NULL == self->event)) {
+        jsdrv_executor_finalize(self);
+        return NULL;
+    }
+    for (uint32_t idx = 0; idx < thread_count; ++idx) {
+        struct worker_s * w = &self->workers[idx];
+        w->parent = self;
+        if (jsdrv_thread_create(&w->thread, worker_thread, w, 1)) {
+            JSDRV_LOGE("executor thread %u create failed", idx);
+            jsdrv_executor_finalize(self);
+            return NULL;
+        }
+        self->thread_count = idx + 1;
+    }
+    JSDRV_LOGI("executor initialized with %u threads", thread_count);
+    return self;
+}
+
+void jsdrv_executor_finalize(struct jsdrv_executor_s * self) {
+    if (NULL == self) {
+        return;
+    }
+    if (self->mutex && self->event) {
+        jsdrv_os_mutex_lock(self->mutex);
+        self->do_exit = true;
+        jsdrv_os_event_signal(self->event);
+        jsdrv_os_mutex_unlock(self->mutex);
+    }
+    for (uint32_t idx = 0; idx < self->thread_count; ++idx) {
+        jsdrv_thread_join(&self->workers[idx].thread, 1000);
+    }
+    struct jsdrv_list_s * item;
+    while (NULL != (item = jsdrv_list_remove_head(&self->tasks))) {
+        JSDRV_LOGW("executor finalize with task");
+        jsdrv_free(JSDRV_CONTAINER_OF(item, struct jsdrv_executor_task_s, task_item));
+    }
+    if (self->event) {
+        jsdrv_os_event_free(self->event);
+    }
+    if (self->mutex) {
+        jsdrv_os_mutex_free(self->mutex);
+    }
+    jsdrv_free(self);
+}
+
+uint32_t jsdrv_executor_thread_count(struct jsdrv_executor_s * self) {
+    return self->thread_count;
+}
+
+struct jsdrv_executor_task_s * jsdrv_executor_task_add(struct jsdrv_executor_s * self,
+                                                       jsdrv_executor_fn fn, void * user_data) {
+    struct jsdrv_executor_task_s * task = jsdrv_alloc_clr(sizeof(struct jsdrv_executor_task_s));
+    jsdrv_list_initialize(&task->item);
+    jsdrv_list_initialize(&task->task_item);
+    task->parent = self;
+    task->fn = fn;
+    task->user_data = user_data;
+    jsdrv_os_mutex_lock(self->mutex);
+    jsdrv_list_add_tail(&self->tasks, &task->task_item);
+    ready_add(self, task);
+    jsdrv_os_mutex_unlock(self->mutex);
+    return task;
+}
+
+void jsdrv_executor_task_signal(void * task_ptr) {
+    struct jsdrv_executor_task_s * task = (struct jsdrv_executor_task_s *) task_ptr;
+    struct jsdrv_executor_s * self = task->parent;
+    jsdrv_os_mutex_lock(self->mutex);
+    switch (task->state) {
+        case TASK_IDLE: ready_add(self, task); break;
+        case TASK_RUNNING: task->state = TASK_RUNNING_SIGNALED; break;
+        default: break;  // already scheduled or removing
+    }
+    jsdrv_os_mutex_unlock(self->mutex);
+}
+
+void jsdrv_executor_task_remove(struct jsdrv_executor_task_s * task) {
+    if (NULL == task) {
+        return;
+    }
+    struct jsdrv_executor_s * self = task->parent;
+    jsdrv_os_mutex_lock(self->mutex);
+    if (TASK_READY == task->state) {
+        jsdrv_list_remove(&task->item);
+        task->state = TASK_REMOVED;
+    } else if ((TASK_RUNNING == task->state) || (TASK_RUNNING_SIGNALED == task->state)) {
+        task->state = TASK_REMOVING;
+    } else {
+        task->state = TASK_REMOVED;
+    }
+    while (TASK_REMOVED != task->state) {
+        jsdrv_os_mutex_unlock(self->mutex);
+        jsdrv_thread_sleep_ms(REMOVE_POLL_MS);
+        jsdrv_os_mutex_lock(self->mutex);
+    }
+    jsdrv_list_remove(&task->task_item);
+    jsdrv_os_mutex_unlock(self->mutex);
+    jsdrv_free(task);
+}
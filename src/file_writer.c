@@ -0,0 +1,300 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/file_writer.h"
+#include "jsdrv_prv/event.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/mutex.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/time.h"
+#include <inttypes.h>
+#include <string.h>
+
+#if !_WIN32
+#include <poll.h>
+#endif
+
+
+#define WRITER_POLL_MS          (100U)
+#define SYNC_INTERVAL_MS        (1000U)
+
+
+struct jsdrv_file_writer_s {
+    struct jsdrv_os_file_s * file;
+    uint8_t * mem;
+    size_t mem_size;
+    uint32_t buffer_size;
+    uint32_t buffer_count;
+    uint32_t sync;
+    int64_t sync_interval;
+    int64_t sync_time;      // the last sync, writer thread only
+    uint32_t * fill;        // valid bytes in each submitted buffer
+    struct jsdrv_os_file_chunk_s * chunks;  // the batch, writer thread only
+    uint32_t batch;         // the maximum buffers for each write
+    uint32_t head;          // buffers submitted, modified by the producer under mutex
+    uint32_t tail;          // buffers written, modified by the writer under mutex
+    uint32_t offset;        // the producer offset into buffer head
+    struct jsdrv_file_writer_status_s status;  // under mutex
+    bool do_exit;
+    jsdrv_os_mutex_t mutex;
+    jsdrv_os_event_t ev;
+    jsdrv_thread_t thread;
+};
+
+static void event_wait(jsdrv_os_event_t ev, uint32_t timeout_ms) {
+#if _WIN32
+    WaitForSingleObject(ev, timeout_ms);
+#else
+    struct pollfd fds = {
+            .fd = ev->fd_poll,
+            .events = ev->events,
+            .revents = 0,
+    };
+    poll(&fds, 1, (int) timeout_ms);
+#endif
+}
+
+static inline uint8_t * buffer_ptr(struct jsdrv_file_writer_s * self, uint32_t idx) {
+    return self->mem + (size_t) (idx % self->buffer_count) * self->buffer_size;
+}
+
+static int32_t buffer_write(struct jsdrv_file_writer_s * self, uint32_t idx, uint32_t count) {
+    uint64_t sz = 0;
+    for (uint32_t k = 0; k < count; ++k) {
+        self->chunks[k].ptr = buffer_ptr(self, idx + k);
+        self->chunks[k].size_bytes = self->fill[(idx + k) % self->buffer_count];
+        sz += self->chunks[k].size_bytes;
+    }
+    int64_t t_start = jsdrv_time_utc();
+    int32_t rc = jsdrv_os_file_write_batch(self->file, self->chunks, count);
+    int64_t t_end = jsdrv_time_utc();
+    if (!rc && ((JSDRV_FILE_WRITER_SYNC_BUFFER == self->sync)
+            || ((JSDRV_FILE_WRITER_SYNC_INTERVAL == self->sync) && ((t_end - self->sync_time) >= self->sync_interval)))) {
+        rc = jsdrv_os_file_sync(self->file);
+        self->sync_time = t_end;
+        t_end = jsdrv_time_utc();
+    }
+    int64_t duration = t_end - t_start;
+
+    jsdrv_os_mutex_lock(self->mutex);
+    if (rc) {
+        if (!self->status.error) {
+            self->status.error = rc;  // discard the buffer so that the producer never stalls
+        }
+    } else {
+        self->status.bytes_written += sz;
+    }
+    self->status.write_time += duration;
+    if (duration > self->status.write_time_max) {
+        self->status.write_time_max = duration;
+    }
+    if (count > self->status.batch_max) {
+        self->status.batch_max = count;
+    }
+    self->tail += count;
+    jsdrv_os_mutex_unlock(self->mutex);
+    return rc;
+}
+
+static THREAD_RETURN_TYPE writer_thread(THREAD_ARG_TYPE arg) {
+    struct jsdrv_file_writer_s * self = (struct jsdrv_file_writer_s *) arg;
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_WRITER);
+    while (1) {
+        jsdrv_os_event_reset(self->ev);
+        jsdrv_os_mutex_lock(self->mutex);
+        uint32_t pending = self->head - self->tail;
+        bool do_exit = self->do_exit;
+        jsdrv_os_mutex_unlock(self->mutex);
+        if (pending) {
+            buffer_write(self, self->tail, (pending > self->batch) ? self->batch : pending);
+        } else if (do_exit) {
+            break;
+        } else {
+            event_wait(self->ev, WRITER_POLL_MS);
+        }
+    }
+    jsdrv_thread_unregister();
+    THREAD_RETURN();
+}
+
+static void writer_free(struct jsdrv_file_writer_s * self) {
+    if (self->ev) {
+        jsdrv_os_event_free(self->ev);
+    }
+    if (self->mutex) {
+        jsdrv_os_mutex_free(self->mutex);
+    }
+    if (self->fill) {
+        jsdrv_free(self->fill);
+    }
+    if (self->chunks) {
+        jsdrv_free(self->chunks);
+    }
+    jsdrv_os_mem_free(self->mem, self->mem_size);
+    jsdrv_free(self);
+}
+
+struct jsdrv_file_writer_s * jsdrv_file_writer_open(const char * path, const struct jsdrv_file_writer_config_s * config) {
+    struct jsdrv_file_writer_config_s cfg;
+    if ((NULL == path) || (0 == path[0])) {
+        return NULL;
+    }
+    if (config) {
+        cfg = *config;
+    } else {
+        memset(&cfg, 0, sizeof(cfg));
+    }
+    if (0 == cfg.buffer_size) {
+        cfg.buffer_size = JSDRV_FILE_WRITER_BUFFER_SIZE;
+    }
+    if (0 == cfg.buffer_count) {
+        cfg.buffer_count = JSDRV_FILE_WRITER_BUFFER_COUNT;
+    } else if (cfg.buffer_count < 2) {
+        cfg.buffer_count = 2;  // write one while filling the other
+    }
+    if (0 == cfg.sync_interval_ms) {
+        cfg.sync_interval_ms = SYNC_INTERVAL_MS;
+    }
+
+    struct jsdrv_file_writer_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_file_writer_s));
+    self->buffer_size = (cfg.buffer_size + JSDRV_FILE_WRITER_BUFFER_ALIGN - 1) & ~(JSDRV_FILE_WRITER_BUFFER_ALIGN - 1);
+    self->buffer_count = cfg.buffer_count;
+    self->sync = cfg.sync;
+    self->sync_interval = JSDRV_TIME_MILLISECOND * (int64_t) cfg.sync_interval_ms;
+    self->mem_size = (size_t) self->buffer_count * self->buffer_size;
+    self->mem = jsdrv_os_mem_alloc(self->mem_size, 0, -1);
+    if (NULL == self->mem) {
+        JSDRV_LOGE("file writer could not allocate %zu bytes", self->mem_size);
+        writer_free(self);
+        return NULL;
+    }
+    uint32_t file_flags = (cfg.flags & JSDRV_FILE_WRITER_FLAG_DIRECT) ? JSDRV_OS_FILE_FLAG_DIRECT : 0;
+    if (cfg.flags & JSDRV_FILE_WRITER_FLAG_URING) {
+        file_flags |= JSDRV_OS_FILE_FLAG_URING;
+    }
+    self->file = jsdrv_os_file_open(path, file_flags);
+    if (NULL == self->file) {
+        writer_free(self);
+        return NULL;
+    }
+    self->batch = 1;  // release each buffer to the producer as soon as possible
+    if ((cfg.flags & JSDRV_FILE_WRITER_FLAG_URING) && (0 == jsdrv_os_file_register(self->file, self->mem, self->mem_size))) {
+        self->batch = self->buffer_count;
+        self->status.uring = true;
+    }
+    if (cfg.preallocate) {
+        int32_t rc = jsdrv_os_file_preallocate(self->file, cfg.preallocate);
+        if (rc) {
+            JSDRV_LOGW("file writer preallocate %" PRIu64 " unavailable: %" PRId32, cfg.preallocate, rc);
+        }
+    }
+    self->fill = jsdrv_alloc_clr(self->buffer_count * sizeof(uint32_t));
+    self->chunks = jsdrv_alloc_clr(self->batch * sizeof(struct jsdrv_os_file_chunk_s));
+    self->mutex = jsdrv_os_mutex_alloc("file_writer");
+    self->ev = jsdrv_os_event_alloc();
+    self->sync_time = jsdrv_time_utc();
+    if (jsdrv_thread_create(&self->thread, writer_thread, self, 1)) {
+        jsdrv_os_file_close(self->file);
+        writer_free(self);
+        return NULL;
+    }
+    return self;
+}
+
+uint32_t jsdrv_file_writer_buffer_size(struct jsdrv_file_writer_s * self) {
+    return self->buffer_size;
+}
+
+void jsdrv_file_writer_flush(struct jsdrv_file_writer_s * self) {
+    if (0 == self->offset) {
+        return;
+    }
+    self->fill[self->head % self->buffer_count] = self->offset;
+    jsdrv_os_mutex_lock(self->mutex);
+    ++self->head;
+    uint32_t backlog = self->head - self->tail;
+    if (backlog > self->status.backlog_max) {
+        self->status.backlog_max = backlog;
+    }
+    jsdrv_os_mutex_unlock(self->mutex);
+    self->offset = 0;
+    jsdrv_os_event_signal(self->ev);
+}
+
+uint8_t * jsdrv_file_writer_reserve(struct jsdrv_file_writer_s * self, uint32_t size) {
+    if (size > self->buffer_size) {
+        return NULL;
+    }
+    if ((self->offset + size) > self->buffer_size) {
+        jsdrv_file_writer_flush(self);
+    }
+    jsdrv_os_mutex_lock(self->mutex);
+    bool available = (self->head - self->tail) < self->buffer_count;
+    if (available) {
+        self->status.bytes_reserved += size;
+    } else {
+        ++self->status.reserve_fail;
+    }
+    jsdrv_os_mutex_unlock(self->mutex);
+    if (!available) {
+        return NULL;
+    }
+    uint8_t * p = buffer_ptr(self, self->head) + self->offset;
+    self->offset += size;
+    return p;
+}
+
+int32_t jsdrv_file_writer_write(struct jsdrv_file_writer_s * self, const void * data, uint32_t size) {
+    if (size > self->buffer_size) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    uint8_t * p = jsdrv_file_writer_reserve(self, size);
+    if (NULL == p) {
+        return JSDRV_ERROR_FULL;
+    }
+    memcpy(p, data, size);
+    return 0;
+}
+
+void jsdrv_file_writer_status(struct jsdrv_file_writer_s * self, struct jsdrv_file_writer_status_s * status) {
+    jsdrv_os_mutex_lock(self->mutex);
+    *status = self->status;
+    status->backlog = self->head - self->tail;
+    jsdrv_os_mutex_unlock(self->mutex);
+}
+
+int32_t jsdrv_file_writer_close(struct jsdrv_file_writer_s * self) {
+    if (NULL == self) {
+        return 0;
+    }
+    jsdrv_file_writer_flush(self);
+    jsdrv_os_mutex_lock(self->mutex);
+    self->do_exit = true;
+    jsdrv_os_mutex_unlock(self->mutex);
+    jsdrv_os_event_signal(self->ev);
+    jsdrv_thread_join(&self->thread, 0);
+
+    int32_t rc = self->status.error;
+    if (!rc && (JSDRV_FILE_WRITER_SYNC_NONE != self->sync)) {
+        rc = jsdrv_os_file_sync(self->file);
+    }
+    int32_t rc_close = jsdrv_os_file_close(self->file);
+    rc = rc ? rc : rc_close;
+    writer_free(self);
+    return rc;
+}
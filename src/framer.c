@@ -0,0 +1,281 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/framer.h"
+#include "jsdrv_prv/pack.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv/error_code.h"
+#include <stdbool.h>
+#include <string.h>
+
+
+struct channel_s {
+    struct jsdrv_stream_frame_channel_s def;  // the input format
+    uint8_t sample_size;        // retained bytes per sample: 4 for float, 1 for integers
+    uint64_t sample_id;         // the sample id for buffer[0]
+    uint32_t decimate_factor;   // 0 until the first samples
+    uint32_t count;             // the retained samples
+    uint8_t * buffer;           // JSDRV_FRAMER_SAMPLES_MAX samples
+};
+
+struct jsdrv_framer_s {
+    uint8_t channel_count;
+    struct channel_s channels[JSDRV_STREAM_FRAME_CHANNELS_MAX];
+};
+
+static bool is_format_valid(const struct jsdrv_stream_frame_channel_s * c) {
+    if (JSDRV_DATA_TYPE_FLOAT == c->element_type) {
+        return 32 == c->element_size_bits;
+    }
+    return (JSDRV_DATA_TYPE_UINT == c->element_type)
+        && ((1 == c->element_size_bits) || (4 == c->element_size_bits) || (8 == c->element_size_bits));
+}
+
+static bool is_format_equal(const struct jsdrv_stream_frame_channel_s * a,
+                            const struct jsdrv_stream_frame_channel_s * b) {
+    return (a->field_id == b->field_id) && (a->index == b->index)
+        && (a->element_type == b->element_type) && (a->element_size_bits == b->element_size_bits);
+}
+
+static void channels_free(struct jsdrv_framer_s * self) {
+    for (uint32_t idx = 0; idx < self->channel_count; ++idx) {
+        jsdrv_free(self->channels[idx].buffer);
+    }
+    memset(self->channels, 0, sizeof(self->channels));
+    self->channel_count = 0;
+}
+
+struct jsdrv_framer_s * jsdrv_framer_alloc(void) {
+    return jsdrv_alloc_clr(sizeof(struct jsdrv_framer_s));
+}
+
+void jsdrv_framer_free(struct jsdrv_framer_s * self) {
+    if (NULL != self) {
+        channels_free(self);
+        jsdrv_free(self);
+    }
+}
+
+int32_t jsdrv_framer_configure(struct jsdrv_framer_s * self, const struct jsdrv_stream_frame_channel_s * channels,
+                               uint8_t channel_count) {
+    if (channel_count > JSDRV_STREAM_FRAME_CHANNELS_MAX) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    bool equal = (channel_count == self->channel_count);
+    for (uint32_t idx = 0; idx < channel_count; ++idx) {
+        if (!is_format_valid(&channels[idx])) {
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+        if (equal && !is_format_equal(&channels[idx], &self->channels[idx].def)) {
+            equal = false;
+        }
+    }
+    if (equal) {
+        return 0;  // retain samples
+    }
+    channels_free(self);
+    for (uint32_t idx = 0; idx < channel_count; ++idx) {
+        struct channel_s * c = &self->channels[idx];
+        c->def = channels[idx];
+        c->def.offset = 0;
+        c->sample_size = (JSDRV_DATA_TYPE_FLOAT == c->def.element_type) ? 4 : 1;
+        c->buffer = jsdrv_alloc(JSDRV_FRAMER_SAMPLES_MAX * c->sample_size);
+    }
+    self->channel_count = channel_count;
+    return 0;
+}
+
+void jsdrv_framer_clear(struct jsdrv_framer_s * self) {
+    for (uint32_t idx = 0; idx < self->channel_count; ++idx) {
+        struct channel_s * c = &self->channels[idx];
+        c->sample_id = 0;
+        c->decimate_factor = 0;
+        c->count = 0;
+    }
+}
+
+static void channel_drop(struct channel_s * c, uint32_t n) {
+    if (n >= c->count) {
+        c->count = 0;
+    } else {
+        memmove(c->buffer, c->buffer + n * c->sample_size, (c->count - n) * c->sample_size);
+        c->count -= n;
+    }
+    c->sample_id += (uint64_t) n * c->decimate_factor;
+}
+
+static void channel_unpack(struct channel_s * c, const uint8_t * x, uint32_t offset, uint32_t n) {
+    uint8_t * y = c->buffer + c->count * c->sample_size;
+    switch (c->def.element_size_bits) {
+        case 32: memcpy(y, x + offset * 4, n * 4); break;
+        case 8: memcpy(y, x + offset, n); break;
+        case 4:
+            if (0 == (offset & 1)) {
+                jsdrv_unpack_u4(y, x + (offset >> 1), n);
+            } else {
+                for (uint32_t k = 0; k < n; ++k) {
+                    uint32_t i = offset + k;
+                    y[k] = (x[i >> 1] >> ((i & 1) * 4)) & 0x0f;
+                }
+            }
+            break;
+        default:
+            if (0 == (offset & 7)) {
+                jsdrv_unpack_u1(y, x + (offset >> 3), n);
+            } else {
+                for (uint32_t k = 0; k < n; ++k) {
+                    uint32_t i = offset + k;
+                    y[k] = (x[i >> 3] >> (i & 7)) & 1;
+                }
+            }
+            break;
+    }
+    c->count += n;
+}
+
+int32_t jsdrv_framer_add(struct jsdrv_framer_s * self, uint8_t channel, uint64_t sample_id,
+                         uint32_t decimate_factor, const void * data, uint32_t count) {
+    if ((channel >= self->channel_count) || (0 == decimate_factor) || ((NULL == data) && count)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (0 == count) {
+        return 0;
+    }
+    struct channel_s * c = &self->channels[channel];
+    if (c->count && ((decimate_factor != c->decimate_factor)
+            || (sample_id != (c->sample_id + (uint64_t) c->count * c->decimate_factor)))) {
+        c->count = 0;  // discontinuity, restart
+    }
+    if (0 == c->count) {
+        c->sample_id = sample_id;
+        c->decimate_factor = decimate_factor;
+    }
+    uint32_t offset = 0;
+    uint64_t total = (uint64_t) c->count + count;
+    if (total > JSDRV_FRAMER_SAMPLES_MAX) {
+        uint32_t n = (uint32_t) (total - JSDRV_FRAMER_SAMPLES_MAX);
+        offset = (n > c->count) ? (n - c->count) : 0;  // also skip the oldest new samples
+        channel_drop(c, n);
+    }
+    channel_unpack(c, (const uint8_t *) data, offset, count - offset);
+    return 0;
+}
+
+uint32_t jsdrv_framer_decimate_factor(struct jsdrv_framer_s * self) {
+    return self->channel_count ? self->channels[0].decimate_factor : 0;
+}
+
+/*
+ * Discard the channel 0 samples that other channels cannot provide,
+ * and the other channel samples superseded at the first channel 0
+ * sample.  Return true when every channel has samples.
+ */
+static bool channels_align(struct jsdrv_framer_s * self) {
+    if (0 == self->channel_count) {
+        return false;
+    }
+    struct channel_s * m = &self->channels[0];
+    uint64_t start = m->sample_id;
+    for (uint32_t idx = 0; idx < self->channel_count; ++idx) {
+        struct channel_s * c = &self->channels[idx];
+        if (0 == c->count) {
+            return false;
+        }
+        if (c->sample_id > start) {
+            start = c->sample_id;
+        }
+    }
+    if (start > m->sample_id) {
+        uint64_t n = (start - m->sample_id + m->decimate_factor - 1) / m->decimate_factor;
+        channel_drop(m, (n > m->count) ? m->count : (uint32_t) n);
+        if (0 == m->count) {
+            return false;
+        }
+    }
+    for (uint32_t idx = 1; idx < self->channel_count; ++idx) {
+        struct channel_s * c = &self->channels[idx];
+        uint64_t j = (m->sample_id - c->sample_id) / c->decimate_factor;
+        channel_drop(c, (j >= c->count) ? (c->count - 1) : (uint32_t) j);
+    }
+    return true;
+}
+
+// Get the channel 0 samples that all channels cover.
+static uint32_t channels_available(struct jsdrv_framer_s * self) {
+    if (!channels_align(self)) {
+        return 0;
+    }
+    struct channel_s * m = &self->channels[0];
+    uint64_t end = UINT64_MAX;
+    for (uint32_t idx = 1; idx < self->channel_count; ++idx) {
+        struct channel_s * c = &self->channels[idx];
+        uint64_t c_end = c->sample_id + (uint64_t) c->count * c->decimate_factor;
+        if (c_end < end) {
+            end = c_end;
+        }
+    }
+    if (UINT64_MAX == end) {
+        return m->count;
+    }
+    uint64_t n = (end - m->sample_id + m->decimate_factor - 1) / m->decimate_factor;
+    return (n > m->count) ? m->count : (uint32_t) n;
+}
+
+uint32_t jsdrv_framer_pop(struct jsdrv_framer_s * self, struct jsdrv_stream_frame_s * frame, uint32_t element_count) {
+    uint32_t sample_bytes = 0;
+    for (uint32_t idx = 0; idx < self->channel_count; ++idx) {
+        sample_bytes += self->channels[idx].sample_size;
+    }
+    if (0 == sample_bytes) {
+        return 0;
+    }
+    uint32_t n_max = (JSDRV_STREAM_FRAME_DATA_SIZE - 8 * self->channel_count) / sample_bytes;
+    uint32_t n = (element_count > n_max) ? n_max : element_count;
+    if ((0 == n) || (channels_available(self) < n)) {
+        return 0;
+    }
+
+    struct channel_s * m = &self->channels[0];
+    memset(frame, 0, JSDRV_STREAM_FRAME_HEADER_SIZE);
+    frame->sample_id = m->sample_id;
+    frame->version = 1;
+    frame->channel_count = self->channel_count;
+    frame->element_count = n;
+    frame->decimate_factor = m->decimate_factor;
+    uint32_t offset = 0;
+    for (uint32_t idx = 0; idx < self->channel_count; ++idx) {
+        struct channel_s * c = &self->channels[idx];
+        struct jsdrv_stream_frame_channel_s * ch = &frame->channels[idx];
+        *ch = c->def;
+        ch->element_size_bits = c->sample_size * 8;
+        ch->offset = offset;
+        uint8_t * y = frame->data + offset;
+        uint64_t delta = m->sample_id - c->sample_id;
+        if ((c->decimate_factor == m->decimate_factor) && (0 == (delta % c->decimate_factor))) {
+            uint64_t j = delta / c->decimate_factor;
+            memcpy(y, c->buffer + j * c->sample_size, n * c->sample_size);
+        } else {
+            for (uint32_t k = 0; k < n; ++k) {
+                uint64_t j = (delta + (uint64_t) k * m->decimate_factor) / c->decimate_factor;
+                memcpy(y + k * c->sample_size, c->buffer + j * c->sample_size, c->sample_size);
+            }
+        }
+        offset += (n * c->sample_size + 7) & ~7U;
+    }
+    channel_drop(m, n);
+    channels_align(self);
+    return JSDRV_STREAM_FRAME_HEADER_SIZE + offset;
+}
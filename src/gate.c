@@ -0,0 +1,380 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/gate.h"
+#include "jsdrv_prv/js220_i128.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/statistics.h"
+#include "js220_api.h"
+#include <math.h>
+#include <string.h>
+
+
+#define WINDOW_MASK (JSDRV_GATE_WINDOW - 1U)
+#define ADD_CHUNK (65536U)  // bound the 64-bit integration partial sums
+
+struct edge_s {
+    uint64_t sample_id;     // the first sample_id with level
+    uint8_t level;
+};
+
+struct gpi_s {
+    uint64_t sample_id_first;   // the first received sample_id
+    uint64_t sample_id_next;    // the next expected sample_id, 0 before the first
+    uint8_t level;              // the level at the gate position, before the retained edges
+    uint8_t level_last;         // the most recently received level
+    uint32_t edge_tail;         // the ring index of the oldest retained edge
+    uint32_t edge_count;
+    struct edge_s edges[JSDRV_GATE_EDGES];
+};
+
+struct jsdrv_gate_s {
+    jsdrv_gate_fn fn;
+    void * user_data;
+    uint8_t mask;
+    uint8_t level;
+    uint8_t decimate_factor;
+    uint64_t overrun;
+    struct gpi_s gpi[JSDRV_GATE_GPI_COUNT];
+
+    uint64_t sample_id_next;    // the next expected i, v, p sample_id, 0 before the first
+    uint64_t pending_sample_id; // the sample_id of the oldest pending sample
+    uint32_t pending_tail;      // the ring index of the oldest pending sample
+    uint32_t pending_count;
+
+    bool active;                // the interval is open
+    uint64_t interval_sample_id;
+    uint64_t interval_count;
+    struct jsdrv_statistics_accum_s accum[3];
+    js220_i128 charge;          // Q31
+    js220_i128 energy;          // Q31
+    struct jsdrv_statistics_s statistics;
+
+    float pending[3][JSDRV_GATE_WINDOW];
+};
+
+
+static void gpi_clear(struct gpi_s * g) {
+    g->sample_id_first = 0;
+    g->sample_id_next = 0;
+    g->level = 0;
+    g->level_last = 0;
+    g->edge_tail = 0;
+    g->edge_count = 0;
+}
+
+struct jsdrv_gate_s * jsdrv_gate_alloc(uint32_t sample_freq, uint8_t decimate_factor,
+                                       jsdrv_gate_fn fn, void * user_data) {
+    struct jsdrv_gate_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_gate_s));
+    self->fn = fn;
+    self->user_data = user_data;
+    self->decimate_factor = decimate_factor ? decimate_factor : 1;
+    struct jsdrv_statistics_s * s = &self->statistics;
+    s->version = 1;
+    s->decimate_factor = self->decimate_factor;
+    s->sample_freq = sample_freq;
+    jsdrv_gate_clear(self);
+    return self;
+}
+
+void jsdrv_gate_free(struct jsdrv_gate_s * self) {
+    if (NULL != self) {
+        jsdrv_free(self);
+    }
+}
+
+void jsdrv_gate_clear(struct jsdrv_gate_s * self) {
+    for (uint32_t k = 0; k < JSDRV_GATE_GPI_COUNT; ++k) {
+        gpi_clear(&self->gpi[k]);
+    }
+    self->sample_id_next = 0;
+    self->pending_sample_id = 0;
+    self->pending_tail = 0;
+    self->pending_count = 0;
+    self->active = false;
+}
+
+void jsdrv_gate_config(struct jsdrv_gate_s * self, uint8_t mask, uint8_t level) {
+    self->mask = mask;
+    self->level = level & mask;
+    jsdrv_gate_clear(self);
+}
+
+uint8_t jsdrv_gate_mask(struct jsdrv_gate_s * self) {
+    return self->mask;
+}
+
+uint64_t jsdrv_gate_overrun(struct jsdrv_gate_s * self) {
+    return self->overrun;
+}
+
+#define FIELD_COPY(_a, _field)                                  \
+    if (0 == (_a)->k) {                                         \
+        s->_field##_avg = NAN;                                  \
+        s->_field##_std = NAN;                                  \
+        s->_field##_min = NAN;                                  \
+        s->_field##_max = NAN;                                  \
+    } else {                                                    \
+        s->_field##_avg = (_a)->mean;                           \
+        s->_field##_std = sqrt((_a)->s / (double) (_a)->k);     \
+        s->_field##_min = (_a)->min;                            \
+        s->_field##_max = (_a)->max;                            \
+    }
+
+static void interval_close(struct jsdrv_gate_s * self) {
+    if (!self->active) {
+        return;
+    }
+    self->active = false;
+    struct jsdrv_statistics_s * s = &self->statistics;
+    FIELD_COPY(&self->accum[0], i);
+    FIELD_COPY(&self->accum[1], v);
+    FIELD_COPY(&self->accum[2], p);
+    s->block_sample_id = self->interval_sample_id;
+    s->accum_sample_id = self->interval_sample_id;
+    s->block_sample_count = (self->interval_count > UINT32_MAX) ? UINT32_MAX : (uint32_t) self->interval_count;
+    uint32_t sampling_freq = s->sample_freq / s->decimate_factor;
+    js220_i128 a = js220_i128_compute_integral(self->charge, sampling_freq);
+    s->charge_i128[0] = a.u64[0];
+    s->charge_i128[1] = a.u64[1];
+    s->charge_f64 = js220_i128_to_f64(a, 31);
+    a = js220_i128_compute_integral(self->energy, sampling_freq);
+    s->energy_i128[0] = a.u64[0];
+    s->energy_i128[1] = a.u64[1];
+    s->energy_f64 = js220_i128_to_f64(a, 31);
+    self->fn(self->user_data, s);
+}
+
+static void interval_add(struct jsdrv_gate_s * self, uint64_t sample_id,
+                         const float * i, const float * v, const float * p, uint32_t count) {
+    if (!self->active) {
+        self->active = true;
+        self->interval_sample_id = sample_id;
+        self->interval_count = 0;
+        for (uint32_t idx = 0; idx < 3; ++idx) {
+            jsdrv_statistics_reset(&self->accum[idx]);
+        }
+        self->charge = js220_i128_init_i64(0);
+        self->energy = js220_i128_init_i64(0);
+    }
+    self->interval_count += count;
+    while (count) {
+        uint32_t n = (count > ADD_CHUNK) ? ADD_CHUNK : count;
+        struct jsdrv_statistics_accum_s a;
+        const float * x[3] = {i, v, p};
+        int64_t i_x1 = 0;
+        int64_t p_x1 = 0;
+        uint32_t k = 0;
+        while (k < n) {
+            uint32_t run = k;
+            while ((run < n) && !isnan(i[run]) && !isnan(v[run]) && !isnan(p[run])) {
+                i_x1 += (int64_t) (i[run] * (1LL << 31));
+                p_x1 += (int64_t) (p[run] * (1LL << 31));
+                ++run;
+            }
+            if (run > k) {
+                for (uint32_t idx = 0; idx < 3; ++idx) {
+                    jsdrv_statistics_compute_f32(&a, x[idx] + k, run - k);
+                    jsdrv_statistics_combine(&self->accum[idx], &self->accum[idx], &a);
+                }
+            }
+            k = run + 1;  // skip the invalid sample
+        }
+        self->charge = js220_i128_add(self->charge, js220_i128_init_i64(i_x1));
+        self->energy = js220_i128_add(self->energy, js220_i128_init_i64(p_x1));
+        i += n;
+        v += n;
+        p += n;
+        count -= n;
+    }
+}
+
+/*
+ * Process the leading samples whose GPI are known.
+ * Returns the number of samples consumed.
+ */
+static uint32_t process(struct jsdrv_gate_s * self, uint64_t sample_id,
+                        const float * i, const float * v, const float * p, uint32_t count) {
+    uint32_t d = self->decimate_factor;
+    uint32_t consumed = 0;
+    while (consumed < count) {
+        uint64_t s = sample_id + (uint64_t) consumed * d;
+        uint64_t end = UINT64_MAX;  // the sample_id where the gate may change
+        bool on = true;
+        for (uint32_t b = 0; b < JSDRV_GATE_GPI_COUNT; ++b) {
+            if (0 == (self->mask & (1U << b))) {
+                continue;
+            }
+            struct gpi_s * g = &self->gpi[b];
+            if ((0 == g->sample_id_next) || (s >= g->sample_id_next)) {
+                return consumed;  // wait for this GPI
+            }
+            while (g->edge_count && (g->edges[g->edge_tail].sample_id <= s)) {
+                g->level = g->edges[g->edge_tail].level;
+                g->edge_tail = (g->edge_tail + 1) % JSDRV_GATE_EDGES;
+                --g->edge_count;
+            }
+            uint64_t g_end = g->edge_count ? g->edges[g->edge_tail].sample_id : g->sample_id_next;
+            if (s < g->sample_id_first) {
+                on = false;  // unknown before the first GPI sample
+                g_end = g->sample_id_first;
+            } else if (g->level != ((self->level >> b) & 1U)) {
+                on = false;
+            }
+            if (g_end < end) {
+                end = g_end;
+            }
+        }
+        uint64_t n64 = (end - s + d - 1) / d;
+        uint32_t n = ((count - consumed) < n64) ? (count - consumed) : (uint32_t) n64;
+        if (on) {
+            interval_add(self, s, i + consumed, v + consumed, p + consumed, n);
+        } else {
+            interval_close(self);
+        }
+        consumed += n;
+    }
+    return consumed;
+}
+
+static void pending_discard(struct jsdrv_gate_s * self, uint32_t count) {
+    self->pending_tail = (self->pending_tail + count) & WINDOW_MASK;
+    self->pending_count -= count;
+    self->pending_sample_id += (uint64_t) count * self->decimate_factor;
+}
+
+static void pending_process(struct jsdrv_gate_s * self) {
+    while (self->pending_count) {
+        uint32_t k = JSDRV_GATE_WINDOW - self->pending_tail;
+        if (k > self->pending_count) {
+            k = self->pending_count;
+        }
+        uint32_t t = self->pending_tail;
+        uint32_t n = process(self, self->pending_sample_id,
+                             self->pending[0] + t, self->pending[1] + t, self->pending[2] + t, k);
+        pending_discard(self, n);
+        if (n < k) {
+            return;  // wait for the GPI
+        }
+    }
+}
+
+static void pending_write(struct jsdrv_gate_s * self, uint64_t sample_id,
+                          const float * i, const float * v, const float * p, uint32_t count) {
+    uint32_t drop = 0;
+    if (count > JSDRV_GATE_WINDOW) {
+        drop = self->pending_count + count - JSDRV_GATE_WINDOW;
+        pending_discard(self, self->pending_count);
+        uint32_t skip = count - JSDRV_GATE_WINDOW;
+        i += skip;
+        v += skip;
+        p += skip;
+        sample_id += (uint64_t) skip * self->decimate_factor;
+        count = JSDRV_GATE_WINDOW;
+    } else if ((self->pending_count + count) > JSDRV_GATE_WINDOW) {
+        drop = self->pending_count + count - JSDRV_GATE_WINDOW;
+        pending_discard(self, drop);
+    }
+    if (drop) {
+        self->overrun += drop;
+        interval_close(self);
+    }
+    if (0 == self->pending_count) {
+        self->pending_sample_id = sample_id;
+    }
+    uint32_t head = (self->pending_tail + self->pending_count) & WINDOW_MASK;
+    self->pending_count += count;
+    while (count) {
+        uint32_t k = JSDRV_GATE_WINDOW - head;
+        if (k > count) {
+            k = count;
+        }
+        memcpy(self->pending[0] + head, i, k * sizeof(float));
+        memcpy(self->pending[1] + head, v, k * sizeof(float));
+        memcpy(self->pending[2] + head, p, k * sizeof(float));
+        i += k;
+        v += k;
+        p += k;
+        head = (head + k) & WINDOW_MASK;
+        count -= k;
+    }
+}
+
+void jsdrv_gate_add(struct jsdrv_gate_s * self, uint64_t sample_id,
+                    const float * i, const float * v, const float * p, uint32_t count) {
+    if ((0 == self->mask) || (0 == count)) {
+        return;
+    }
+    if (self->sample_id_next && (sample_id != self->sample_id_next)) {
+        pending_discard(self, self->pending_count);  // discontinuity
+        interval_close(self);
+    }
+    self->sample_id_next = sample_id + (uint64_t) count * self->decimate_factor;
+    pending_process(self);
+    if (0 == self->pending_count) {
+        uint32_t n = process(self, sample_id, i, v, p, count);  // directly when the GPI lead
+        i += n;
+        v += n;
+        p += n;
+        sample_id += (uint64_t) n * self->decimate_factor;
+        count -= n;
+    }
+    if (count) {
+        pending_write(self, sample_id, i, v, p, count);
+    }
+}
+
+static void edge_push(struct jsdrv_gate_s * self, struct gpi_s * g, uint64_t sample_id, uint8_t level) {
+    if (g->edge_count >= JSDRV_GATE_EDGES) {
+        // apply the oldest edge early, which shifts it to the gate position
+        g->level = g->edges[g->edge_tail].level;
+        g->edge_tail = (g->edge_tail + 1) % JSDRV_GATE_EDGES;
+        --g->edge_count;
+        ++self->overrun;
+    }
+    struct edge_s * e = &g->edges[(g->edge_tail + g->edge_count) % JSDRV_GATE_EDGES];
+    e->sample_id = sample_id;
+    e->level = level;
+    ++g->edge_count;
+    g->level_last = level;
+}
+
+void jsdrv_gate_add_gpi(struct jsdrv_gate_s * self, uint8_t gpi, uint64_t sample_id, uint32_t decimate_factor,
+                        const uint8_t * x, uint32_t count) {
+    if ((gpi >= JSDRV_GATE_GPI_COUNT) || (0 == (self->mask & (1U << gpi))) || (0 == count)) {
+        return;
+    }
+    struct gpi_s * g = &self->gpi[gpi];
+    if (0 == g->sample_id_next) {
+        g->sample_id_first = sample_id;
+        g->level = x[0] & 1U;
+        g->level_last = g->level;
+    }
+    uint32_t k = 0;
+    while (k < count) {
+        if ((0 == (k & 7U)) && ((count - k) >= 8) && (x[k >> 3] == (g->level_last ? 0xffU : 0x00U))) {
+            k += 8;  // no change in this byte
+            continue;
+        }
+        uint8_t b = (x[k >> 3] >> (k & 7U)) & 1U;
+        if (b != g->level_last) {
+            edge_push(self, g, sample_id + (uint64_t) k * decimate_factor, b);
+        }
+        ++k;
+    }
+    g->sample_id_next = sample_id + (uint64_t) count * decimate_factor;
+    pending_process(self);
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/host_stats.h"
+#include "jsdrv_prv/js220_i128.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv/error_code.h"
+#include <math.h>
+#include <string.h>
+
+
+#define ADD_CHUNK (65536U)  // bound the 64-bit integration partial sums
+
+
+static void segment_reset(struct jsdrv_host_stats_s * self) {
+    for (uint32_t k = 0; k < 3; ++k) {
+        jsdrv_statistics_reset(&self->cur[k]);
+    }
+    self->seg_fill = 0;
+}
+
+static void window_restart(struct jsdrv_host_stats_s * self) {
+    self->seg_head = 0;
+    self->seg_valid = 0;
+    segment_reset(self);
+}
+
+void jsdrv_host_stats_initialize(struct jsdrv_host_stats_s * self, uint32_t sample_freq, uint8_t decimate_factor) {
+    jsdrv_memset(self, 0, sizeof(*self));
+    struct jsdrv_statistics_s * s = &self->statistics;
+    s->version = 1;
+    s->decimate_factor = decimate_factor ? decimate_factor : 1;
+    s->sample_freq = sample_freq;
+    jsdrv_host_stats_config(self, sample_freq / (10U * s->decimate_factor), 0);
+}
+
+int32_t jsdrv_host_stats_config(struct jsdrv_host_stats_s * self, uint32_t window, uint32_t hop) {
+    if (0 == hop) {
+        hop = window;
+    }
+    if ((0 == window) || (hop > window) || (window % hop)
+            || ((window / hop) > JSDRV_HOST_STATS_SEGMENTS_MAX)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    self->window = window;
+    self->hop = hop;
+    self->seg_count = window / hop;
+    jsdrv_host_stats_clear(self);
+    return 0;
+}
+
+static void derived_clear(struct jsdrv_host_stats_s * self) {
+    struct jsdrv_host_derived_s * d = &self->derived;
+    jsdrv_memset(d, 0, sizeof(*d));
+    d->version = 1;
+    d->bins_per_octave = JSDRV_HOST_HIST_BINS_PER_OCTAVE;
+    d->octave_min = JSDRV_HOST_HIST_OCTAVE_MIN;
+    d->octave_max = JSDRV_HOST_HIST_OCTAVE_MAX;
+    d->bin_count = JSDRV_HOST_HIST_BIN_COUNT;
+}
+
+void jsdrv_host_stats_clear(struct jsdrv_host_stats_s * self) {
+    window_restart(self);
+    self->sample_id_next = 0;
+    self->charge = js220_i128_init_i64(0);
+    self->energy = js220_i128_init_i64(0);
+    self->statistics.block_sample_id = 0;
+    self->statistics.accum_sample_id = 0;
+    derived_clear(self);
+}
+
+void jsdrv_host_stats_derived_enable(struct jsdrv_host_stats_s * self, bool enable) {
+    if (enable && !self->derived_enable) {
+        derived_clear(self);
+        self->derived.hist_sample_id = self->sample_id_next;
+    }
+    self->derived_enable = enable;
+}
+
+// The histogram bin from the float exponent and upper mantissa bits, no log required.
+static inline uint32_t hist_bin(float x) {
+    const uint32_t sub_bits = 2;  // log2(JSDRV_HOST_HIST_BINS_PER_OCTAVE)
+    if (!(x >= 0x1p-30f)) {  // JSDRV_HOST_HIST_OCTAVE_MIN, also zero and negative
+        return 0;
+    } else if (x >= 0x1p10f) {  // JSDRV_HOST_HIST_OCTAVE_MAX
+        return JSDRV_HOST_HIST_BIN_COUNT - 1;
+    }
+    uint32_t u;
+    memcpy(&u, &x, sizeof(u));
+    uint32_t octave = (u >> 23) - (127 + JSDRV_HOST_HIST_OCTAVE_MIN);
+    return 1 + (octave << sub_bits) + ((u >> (23 - sub_bits)) & ((1U << sub_bits) - 1));
+}
+
+static void hist_add(uint64_t * hist, const float * x, uint32_t count) {
+    for (uint32_t k = 0; k < count; ++k) {
+        ++hist[hist_bin(x[k])];
+    }
+}
+
+static void segment_add(struct jsdrv_host_stats_s * self,
+        const float * i, const float * v, const float * p, uint32_t count) {
+    struct jsdrv_statistics_accum_s a;
+    const float * x[3] = {i, v, p};
+    int64_t i_x1 = 0;
+    int64_t p_x1 = 0;
+    uint32_t k = 0;
+    while (k < count) {
+        uint32_t run = k;
+        while ((run < count) && !isnan(i[run]) && !isnan(v[run]) && !isnan(p[run])) {
+            i_x1 += (int64_t) (i[run] * (1LL << 31));
+            p_x1 += (int64_t) (p[run] * (1LL << 31));
+            ++run;
+        }
+        if (run > k) {
+            for (uint32_t idx = 0; idx < 3; ++idx) {
+                jsdrv_statistics_compute_f32(&a, x[idx] + k, run - k);
+                jsdrv_statistics_combine(&self->cur[idx], &self->cur[idx], &a);
+            }
+            if (self->derived_enable) {
+                hist_add(self->derived.i_hist, i + k, run - k);
+                hist_add(self->derived.v_hist, v + k, run - k);
+                hist_add(self->derived.p_hist, p + k, run - k);
+            }
+        }
+        k = run + 1;  // skip the invalid sample
+    }
+    self->charge = js220_i128_add(self->charge, js220_i128_init_i64(i_x1));
+    self->energy = js220_i128_add(self->energy, js220_i128_init_i64(p_x1));
+}
+
+#define FIELD_COPY(_a, _field)                                  \
+    if (0 == (_a)->k) {                                         \
+        s->_field##_avg = NAN;                                  \
+        s->_field##_std = NAN;                                  \
+        s->_field##_min = NAN;                                  \
+        s->_field##_max = NAN;                                  \
+    } else {                                                    \
+        s->_field##_avg = (_a)->mean;                           \
+        s->_field##_std = sqrt((_a)->s / (double) (_a)->k);     \
+        s->_field##_min = (_a)->min;                            \
+        s->_field##_max = (_a)->max;                            \
+    }
+
+static void derived_rms(const struct jsdrv_statistics_accum_s * a, double * rms, double * crest) {
+    if (0 == a->k) {
+        *rms = NAN;
+        *crest = NAN;
+        return;
+    }
+    *rms = sqrt(a->mean * a->mean + a->s / (double) a->k);
+    double peak = fmax(fabs(a->min), fabs(a->max));
+    *crest = (*rms > 0.0) ? (peak / *rms) : NAN;
+}
+
+static struct jsdrv_statistics_s * segment_close(struct jsdrv_host_stats_s * self) {
+    struct jsdrv_statistics_s * s = &self->statistics;
+    struct jsdrv_statistics_accum_s w[3];
+    for (uint32_t idx = 0; idx < 3; ++idx) {
+        self->seg[self->seg_head][idx] = self->cur[idx];
+    }
+    self->seg_head = (self->seg_head + 1) % self->seg_count;
+    if (self->seg_valid < self->seg_count) {
+        ++self->seg_valid;
+    }
+    segment_reset(self);
+    if (self->seg_valid < self->seg_count) {
+        return NULL;
+    }
+
+    for (uint32_t idx = 0; idx < 3; ++idx) {
+        jsdrv_statistics_reset(&w[idx]);
+        for (uint32_t n = 0; n < self->seg_count; ++n) {
+            jsdrv_statistics_combine(&w[idx], &w[idx], &self->seg[n][idx]);
+        }
+    }
+    FIELD_COPY(&w[0], i);
+    FIELD_COPY(&w[1], v);
+    FIELD_COPY(&w[2], p);
+    if (self->derived_enable) {
+        derived_rms(&w[0], &self->derived.i_rms, &self->derived.i_crest);
+        derived_rms(&w[1], &self->derived.v_rms, &self->derived.v_crest);
+        derived_rms(&w[2], &self->derived.p_rms, &self->derived.p_crest);
+    }
+
+    s->block_sample_count = self->window;
+    s->block_sample_id = self->sample_id_next - (uint64_t) self->window * s->decimate_factor;
+    self->derived.block_sample_id = s->block_sample_id;
+    uint32_t sampling_freq = s->sample_freq / s->decimate_factor;
+    js220_i128 a = js220_i128_compute_integral(self->charge, sampling_freq);
+    s->charge_i128[0] = a.u64[0];
+    s->charge_i128[1] = a.u64[1];
+    s->charge_f64 = js220_i128_to_f64(a, 31);
+    a = js220_i128_compute_integral(self->energy, sampling_freq);
+    s->energy_i128[0] = a.u64[0];
+    s->energy_i128[1] = a.u64[1];
+    s->energy_f64 = js220_i128_to_f64(a, 31);
+    return s;
+}
+
+uint32_t jsdrv_host_stats_add(struct jsdrv_host_stats_s * self, uint64_t sample_id,
+        const float * i, const float * v, const float * p, uint32_t count,
+        struct jsdrv_statistics_s ** stats) {
+    *stats = NULL;
+    if (0 == count) {
+        return 0;
+    }
+    if (0 == self->sample_id_next) {
+        self->statistics.accum_sample_id = sample_id;
+        self->derived.hist_sample_id = sample_id;
+    } else if (sample_id != self->sample_id_next) {
+        window_restart(self);
+    }
+    uint32_t remaining = self->hop - self->seg_fill;
+    if (count > remaining) {
+        count = remaining;
+    }
+    if (count > ADD_CHUNK) {
+        count = ADD_CHUNK;
+    }
+    segment_add(self, i, v, p, count);
+    self->seg_fill += count;
+    self->sample_id_next = sample_id + (uint64_t) count * self->statistics.decimate_factor;
+    if (self->seg_fill == self->hop) {
+        *stats = segment_close(self);
+    }
+    return count;
+}
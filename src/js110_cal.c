@@ -18,6 +18,9 @@
 #include "jsdrv_prv/json.h"
 #include "jsdrv/error_code.h"
 #include "jsdrv_prv/log.h"
+#include "jsdrv_prv/platform.h"
+#include "tinyprintf.h"
+#include <stdio.h>
 #include <string.h>
 
 
@@ -114,3 +117,84 @@ int32_t js110_cal_parse(const uint8_t * data, double cal[2][2][9]) {
     memcpy(cal, state.value, sizeof(state.value));
     return 0;
 }
+
+static void cache_filename(char * buf, size_t buf_size, const char * path,
+                           const char * serial_number, uint32_t crc32) {
+    char sn[32];
+    size_t i = 0;
+    for (; serial_number[i] && (i < (sizeof(sn) - 1)); ++i) {
+        char c = serial_number[i];
+        bool valid = ((c >= '0') && (c <= '9')) || ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'));
+        sn[i] = valid ? c : '_';
+    }
+    sn[i] = 0;
+    tfp_snprintf(buf, buf_size, "%s/js110_%s_%08lx.cal", path, sn, (unsigned long) crc32);
+}
+
+int32_t js110_cal_cache_load(const char * path, const char * serial_number,
+                             const struct js110_cal_header_s * hdr, uint8_t ** data) {
+    char filename[1024];
+    struct js110_cal_header_s file_hdr;
+    if (!path || !serial_number || !hdr || !data) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    *data = NULL;
+    if ((hdr->length < sizeof(*hdr)) || (hdr->length > JS110_CAL_LENGTH_MAX)) {
+        return JSDRV_ERROR_NOT_FOUND;
+    }
+    cache_filename(filename, sizeof(filename), path, serial_number, hdr->crc32);
+    FILE * f = fopen(filename, "rb");
+    if (NULL == f) {
+        return JSDRV_ERROR_NOT_FOUND;
+    }
+    if ((1 != fread(&file_hdr, sizeof(file_hdr), 1, f))
+            || (0 != memcmp(&file_hdr, hdr, sizeof(file_hdr)))) {
+        JSDRV_LOGI("cal cache mismatch: %s", filename);
+        fclose(f);
+        return JSDRV_ERROR_NOT_FOUND;
+    }
+    uint8_t * d = jsdrv_alloc((size_t) hdr->length);
+    memcpy(d, &file_hdr, sizeof(file_hdr));
+    size_t sz = (size_t) hdr->length - sizeof(file_hdr);
+    if (sz != fread(d + sizeof(file_hdr), 1, sz, f)) {
+        JSDRV_LOGW("cal cache truncated: %s", filename);
+        jsdrv_free(d);
+        fclose(f);
+        return JSDRV_ERROR_NOT_FOUND;
+    }
+    fclose(f);
+    JSDRV_LOGI("cal cache hit: %s", filename);
+    *data = d;
+    return 0;
+}
+
+int32_t js110_cal_cache_save(const char * path, const char * serial_number, const uint8_t * data) {
+    char filename[1024];
+    char filename_tmp[1040];
+    const struct js110_cal_header_s * hdr = (const struct js110_cal_header_s *) data;
+    if (!path || !serial_number || !data) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if ((hdr->length < sizeof(*hdr)) || (hdr->length > JS110_CAL_LENGTH_MAX)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    cache_filename(filename, sizeof(filename), path, serial_number, hdr->crc32);
+    tfp_snprintf(filename_tmp, sizeof(filename_tmp), "%s.tmp", filename);
+    FILE * f = fopen(filename_tmp, "wb");
+    if (NULL == f) {
+        JSDRV_LOGW("cal cache open failed: %s", filename_tmp);
+        return JSDRV_ERROR_IO;
+    }
+    size_t sz = (size_t) hdr->length;
+    bool ok = (sz == fwrite(data, 1, sz, f));
+    ok = (0 == fclose(f)) && ok;
+    // write then rename so that readers never see a partial record
+    remove(filename);
+    if (!ok || rename(filename_tmp, filename)) {
+        JSDRV_LOGW("cal cache write failed: %s", filename);
+        remove(filename_tmp);
+        return JSDRV_ERROR_IO;
+    }
+    JSDRV_LOGI("cal cache saved: %s", filename);
+    return 0;
+}
@@ -34,6 +34,10 @@ static inline uint8_t ptr_decr(uint8_t idx) {
     return (idx - 1) & _SUPPRESS_SAMPLES_MASK;
 }
 
+static inline uint8_t sample_i_range(uint32_t sample_u32) {
+    return (sample_u32 & 3) | (((sample_u32 >> 16) & 1) << 2);
+}
+
 static inline uint8_t ptr_sub(uint8_t a, uint8_t b) {
     return (a - b) & _SUPPRESS_SAMPLES_MASK;
 }
@@ -117,7 +121,7 @@ struct js110_sample_s js110_sp_process(struct js110_sp_s * self, uint32_t sample
     ++self->sample_count;
 
     // interpret sample_u32 and apply calibration
-    uint8_t i_range = (sample_u32 & 3) | (((sample_u32 >> 16) & 1) << 2);
+    uint8_t i_range = sample_i_range(sample_u32);
     if ((i_range > 7) || (sample_u32 == 0xffffffffLU)) {
         ++self->sample_missing_count;
         self->contiguous_count = 0;
@@ -239,6 +243,113 @@ struct js110_sample_s js110_sp_process(struct js110_sp_s * self, uint32_t sample
     return self->samples[self->head];
 }
 
+// The number of leading samples that js110_sp_process() handles without suppression.
+static uint32_t fast_run_length(struct js110_sp_s * self, const uint32_t * samples, uint32_t count) {
+    if (self->_suppress_samples_remaining
+            || ((self->_suppress_mode == JS110_SUPPRESS_MODE_NAN) && self->_suppress_samples_counter)) {
+        return 0;
+    }
+    uint32_t n = 0;
+    while ((n < count) && (samples[n] != 0xffffffffLU) && (sample_i_range(samples[n]) == self->_i_range_last)) {
+        ++n;
+    }
+    return n;
+}
+
+static void fast_run(struct js110_sp_s * self, const uint32_t * samples, uint32_t count,
+                     uint8_t v_range, struct js110_sp_block_s * dst) {
+    const uint32_t delay = JS110_SUPPRESS_SAMPLES_MAX - 1;
+    uint8_t i_range = self->_i_range_last;
+    const double i_offset = self->cal[0][0][i_range];
+    const double i_gain = self->cal[0][1][i_range];
+    const double v_offset = self->cal[1][0][v_range];
+    const double v_gain = self->cal[1][1][v_range];
+
+    // The first outputs come from the delay line.
+    uint32_t k_end = (count < delay) ? count : delay;
+    for (uint32_t k = 0; k < k_end; ++k) {
+        const struct js110_sample_s * s = &self->samples[(self->head + 1 + k) & _SUPPRESS_SAMPLES_MASK];
+        dst->i[k] = s->i;
+        dst->v[k] = s->v;
+        dst->p[k] = s->p;
+        dst->current_range[k] = s->current_range;
+        dst->gpi0[k] = s->gpi0;
+        dst->gpi1[k] = s->gpi1;
+    }
+
+    // Samples that leave the delay line within this run go directly to dst.
+    float * d_i = dst->i + delay;
+    float * d_v = dst->v + delay;
+    float * d_p = dst->p + delay;
+    uint8_t * d_r = dst->current_range + delay;
+    uint8_t * d_g0 = dst->gpi0 + delay;
+    uint8_t * d_g1 = dst->gpi1 + delay;
+    for (uint32_t k = 0; (k + delay) < count; ++k) {
+        uint32_t u = samples[k];
+        double i = (double) ((u >> 2) & 0x3fff);
+        double v = (double) ((u >> 18) & 0x3fff);
+        i = (i + i_offset) * i_gain;
+        v = (v + v_offset) * v_gain;
+        d_i[k] = (float) i;
+        d_v[k] = (float) v;
+        d_p[k] = (float) (i * v);
+        d_r[k] = i_range;
+        d_g0[k] = (u >> 2) & 1;
+        d_g1[k] = (u >> 18) & 1;
+    }
+
+    // The final samples remain in the delay line.
+    uint32_t k_start = (count > JS110_SUPPRESS_SAMPLES_MAX) ? (count - JS110_SUPPRESS_SAMPLES_MAX) : 0;
+    for (uint32_t k = k_start; k < count; ++k) {
+        uint32_t u = samples[k];
+        double i = (double) ((u >> 2) & 0x3fff);
+        double v = (double) ((u >> 18) & 0x3fff);
+        i = (i + i_offset) * i_gain;
+        v = (v + v_offset) * v_gain;
+        struct js110_sample_s * s = &self->samples[(self->head + k) & _SUPPRESS_SAMPLES_MASK];
+        s->i = (float) i;
+        s->v = (float) v;
+        s->p = (float) (i * v);
+        s->current_range = i_range;
+        s->gpi0 = (u >> 2) & 1;
+        s->gpi1 = (u >> 18) & 1;
+    }
+
+    self->head = (self->head + count) & _SUPPRESS_SAMPLES_MASK;
+    self->sample_count += count;
+    self->contiguous_count += count;
+    self->is_skipping = 0;
+}
+
+void js110_sp_process_block(struct js110_sp_s * self, const uint32_t * samples, uint32_t count,
+                            uint8_t v_range, struct js110_sp_block_s * dst) {
+    uint32_t idx = 0;
+    while (idx < count) {
+        uint32_t n = fast_run_length(self, samples + idx, count - idx);
+        if (n) {
+            struct js110_sp_block_s d = {
+                .i = dst->i + idx,
+                .v = dst->v + idx,
+                .p = dst->p + idx,
+                .current_range = dst->current_range + idx,
+                .gpi0 = dst->gpi0 + idx,
+                .gpi1 = dst->gpi1 + idx,
+            };
+            fast_run(self, samples + idx, n, v_range, &d);
+            idx += n;
+        } else {
+            struct js110_sample_s s = js110_sp_process(self, samples[idx], v_range);
+            dst->i[idx] = s.i;
+            dst->v[idx] = s.v;
+            dst->p[idx] = s.p;
+            dst->current_range[idx] = s.current_range;
+            dst->gpi0[idx] = s.gpi0;
+            dst->gpi1[idx] = s.gpi1;
+            ++idx;
+        }
+    }
+}
+
 int32_t js110_sp_suppress_win(struct js110_sp_s * self, uint8_t window) {
     switch (window) {
         case 0: self->_suppress_matrix = NULL; break;
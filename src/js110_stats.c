@@ -21,6 +21,25 @@
 #include <math.h>
 
 
+/*
+ * Block accumulation splits each Q31 value into x = a * 2^32 + b with
+ * a signed and b unsigned 32-bit, so that
+ *   x^2 = a^2 * 2^64 + a * b * 2^33 + b^2
+ * accumulates exactly in 64-bit partial sums.  The partials promote
+ * to the 128-bit sum at least every BLOCK_CHUNK samples, which bounds
+ * them well below 2^63 for |a| < BLOCK_A_MAX.
+ */
+#define BLOCK_CHUNK (4096U)
+#define BLOCK_A_MAX (1LL << 15)
+
+struct partial_s {
+    uint64_t a2;        // sum of a * a
+    int64_t ab;         // sum of a * b
+    uint64_t b2;        // sum of b * b, modulo 2^64
+    uint64_t b2_carry;  // b2 overflow count
+};
+
+
 static void clear(struct js110_stats_s * self) {
     for (int i = 0; i < 3; ++i) {
         struct js110_stats_field_s * f = &self->fields[i];
@@ -78,6 +97,41 @@ static void update(struct js110_stats_field_s * f, float x) {
     f->x2 = js220_i128_add(f->x2, r);
 }
 
+static inline void update_partial(struct js110_stats_field_s * f, struct partial_s * q, float x) {
+    f->avg += x;
+    if (x < f->min) {
+        f->min = x;
+    }
+    if (x > f->max) {
+        f->max = x;
+    }
+    int64_t x_i64 = (int64_t) (x * (1LL << 31));
+    f->x1 += x_i64;
+    int64_t a = x_i64 >> 32;
+    uint64_t b = (uint32_t) x_i64;
+    if ((a >= -BLOCK_A_MAX) && (a < BLOCK_A_MAX)) {
+        uint64_t b2 = q->b2 + b * b;
+        q->b2_carry += (b2 < q->b2) ? 1 : 0;
+        q->b2 = b2;
+        q->a2 += (uint64_t) (a * a);
+        q->ab += a * (int64_t) b;
+    } else {
+        f->x2 = js220_i128_add(f->x2, js220_i128_square_i64(x_i64));
+    }
+}
+
+static void promote(struct js110_stats_field_s * f, struct partial_s * q) {
+    js220_i128 r;
+    r.u64[0] = q->b2;
+    r.u64[1] = q->a2 + q->b2_carry;
+    r = js220_i128_add(r, js220_i128_lshift(js220_i128_init_i64(q->ab), 33));
+    f->x2 = js220_i128_add(f->x2, r);
+    q->a2 = 0;
+    q->ab = 0;
+    q->b2 = 0;
+    q->b2_carry = 0;
+}
+
 static void finalize(struct js110_stats_field_s * f, uint32_t sample_count) {
     f->avg /= sample_count;
     f->std = js220_i128_compute_std(f->x1, f->x2, sample_count, 31);
@@ -89,6 +143,41 @@ static void finalize(struct js110_stats_field_s * f, uint32_t sample_count) {
     s->_field##_min = self->fields[_idx].min; \
     s->_field##_max = self->fields[_idx].max
 
+static struct jsdrv_statistics_s * block_finalize(struct js110_stats_s * self) {
+    struct jsdrv_statistics_s * s = &self->statistics;
+    js220_i128 a;
+    js220_i128 i_128;
+    js220_i128 p_128;
+    i_128.u64[0] = self->fields[0].x1;
+    i_128.i64[1] = (self->fields[0].x1 < 0) ? -1LL : 0;
+    self->charge = js220_i128_add(self->charge, i_128);
+
+    p_128.u64[0] = self->fields[2].x1;
+    p_128.i64[1] = (self->fields[2].x1 < 0) ? -1LL : 0;
+    self->energy = js220_i128_add(self->energy, p_128);
+
+    finalize(&self->fields[0], self->valid_count);
+    finalize(&self->fields[1], self->valid_count);
+    finalize(&self->fields[2], self->valid_count);
+    self->sample_count = 0;
+    self->valid_count = 0;
+
+    uint32_t sampling_freq = s->sample_freq / s->decimate_factor;
+    a = js220_i128_compute_integral(self->charge, sampling_freq);
+    s->charge_i128[0] = a.u64[0];
+    s->charge_i128[1] = a.u64[1];
+    s->charge_f64 = js220_i128_to_f64(a, 31);
+    a = js220_i128_compute_integral(self->energy, sampling_freq);
+    s->energy_i128[0] = a.u64[0];
+    s->energy_i128[1] = a.u64[1];
+    s->energy_f64 = js220_i128_to_f64(a, 31);
+
+    FIELD_COPY(0, i);
+    FIELD_COPY(1, v);
+    FIELD_COPY(2, p);
+        return s;
+}
+
 struct jsdrv_statistics_s * js110_stats_compute(struct js110_stats_s * self, float i, float v, float p) {
     struct jsdrv_statistics_s * s = &self->statistics;
     if (0 == self->sample_count) {
@@ -103,39 +192,47 @@ struct jsdrv_statistics_s * js110_stats_compute(struct js110_stats_s * self, flo
     }
 
     if (self->sample_count == s->block_sample_count) {
-        js220_i128 a;
-        js220_i128 i_128;
-        js220_i128 p_128;
-        i_128.u64[0] = self->fields[0].x1;
-        i_128.i64[1] = (self->fields[0].x1 < 0) ? -1LL : 0;
-        self->charge = js220_i128_add(self->charge, i_128);
-
-        p_128.u64[0] = self->fields[2].x1;
-        p_128.i64[1] = (self->fields[2].x1 < 0) ? -1LL : 0;
-        self->energy = js220_i128_add(self->energy, p_128);
-
-        finalize(&self->fields[0], self->valid_count);
-        finalize(&self->fields[1], self->valid_count);
-        finalize(&self->fields[2], self->valid_count);
-        self->sample_count = 0;
-        self->valid_count = 0;
-
-        uint32_t sampling_freq = s->sample_freq / s->decimate_factor;
-        a = js220_i128_compute_integral(self->charge, sampling_freq);
-        s->charge_i128[0] = a.u64[0];
-        s->charge_i128[1] = a.u64[1];
-        s->charge_f64 = js220_i128_to_f64(a, 31);
-        a = js220_i128_compute_integral(self->energy, sampling_freq);
-        s->energy_i128[0] = a.u64[0];
-        s->energy_i128[1] = a.u64[1];
-        s->energy_f64 = js220_i128_to_f64(a, 31);
-
-        FIELD_COPY(0, i);
-        FIELD_COPY(1, v);
-        FIELD_COPY(2, p);
-
-        return s;
+        return block_finalize(self);
     } else {
         return 0;
     }
 }
+
+uint32_t js110_stats_compute_block(struct js110_stats_s * self,
+        const float * i, const float * v, const float * p, uint32_t count,
+        struct jsdrv_statistics_s ** stats) {
+    struct jsdrv_statistics_s * s = &self->statistics;
+    struct partial_s q[3] = {{0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}};
+    *stats = NULL;
+    if (0 == self->sample_count) {
+        clear(self);
+    }
+    uint32_t remaining = s->block_sample_count - self->sample_count;
+    if (0 == remaining) {
+        remaining = count;  // block_sample_count 0, never finalize
+    }
+    if (count > remaining) {
+        count = remaining;
+    }
+    for (uint32_t k = 0; k < count; k += BLOCK_CHUNK) {
+        uint32_t k_end = ((count - k) > BLOCK_CHUNK) ? (k + BLOCK_CHUNK) : count;
+        uint32_t valid = 0;
+        for (uint32_t n = k; n < k_end; ++n) {
+            if (!isnan(i[n]) && !isnan(v[n]) && !isnan(p[n])) {
+                ++valid;
+                update_partial(&self->fields[0], &q[0], i[n]);
+                update_partial(&self->fields[1], &q[1], v[n]);
+                update_partial(&self->fields[2], &q[2], p[n]);
+            }
+        }
+        for (uint32_t idx = 0; idx < 3; ++idx) {
+            promote(&self->fields[idx], &q[idx]);
+        }
+        self->valid_count += valid;
+    }
+    self->sample_count += count;
+    if (self->sample_count == s->block_sample_count) {
+        *stats = block_finalize(self);
+    }
+    return count;
+}
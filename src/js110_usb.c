@@ -17,7 +17,9 @@
 #include "jsdrv.h"
 #include "js110_api.h"
 #include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/continuity.h"
 #include "jsdrv_prv/downsample.h"
+#include "jsdrv_prv/pack.h"
 #include "jsdrv_prv/log.h"
 #include "jsdrv_prv/backend.h"
 #include "jsdrv_prv/frontend.h"
@@ -25,14 +27,20 @@
 #include "jsdrv_prv/js110_sample_processor.h"
 #include "jsdrv_prv/js110_stats.h"
 #include "jsdrv_prv/js220_i128.h"
+#include "jsdrv_prv/latency.h"
 #include "jsdrv_prv/msg_queue.h"
 #include "jsdrv_prv/usb_spec.h"
 #include "jsdrv_prv/thread.h"
+#include "jsdrv_prv/trace.h"
 #include "jsdrv_prv/time_map_filter.h"
+#include "jsdrv_prv/topic_index.h"
+#include "jsdrv_prv/trigger.h"
 #include "jsdrv_prv/pubsub.h"
+#include "jsdrv_prv/stream_event.h"
 #include "jsdrv/cstr.h"
 #include "jsdrv/error_code.h"
 #include "jsdrv/meta.h"
+#include "jsdrv/time.h"
 #include "jsdrv/topic.h"
 #include "jsdrv_prv/dbc.h"
 #include "jsdrv_prv/platform.h"
@@ -44,9 +52,14 @@
 #define INTERVAL_MS                 (100U)
 #define SENSOR_COMMAND_TIMEOUT_MS   (3000U)
 #define FRAME_SIZE_BYTES            (512U)
+#define FRAME_SAMPLES               ((FRAME_SIZE_BYTES / 4) - 2)  // excluding the header
 #define ROE JSDRV_RETURN_ON_ERROR
 #define SAMPLING_FREQUENCY          (2000000U)
 #define STREAM_PAYLOAD_FULL         (JSDRV_STREAM_DATA_SIZE - JSDRV_STREAM_HEADER_SIZE - JS220_USB_FRAME_LENGTH)
+#define STREAM_LATENCY_MS_DEFAULT   (50U)
+#define STREAM_LATENCY_MS_MAX       (100U)
+#define SETTINGS_RC_MAX             (16U)
+#define SETTINGS_COALESCE_MS        (2U)
 
 struct js110_dev_s;  // forward declaration, see below
 
@@ -57,6 +70,11 @@ enum state_e {
     ST_OPEN = 3,
 };
 
+enum settings_e {
+    SETTINGS_STREAM = (1U << 0),  // stream_settings_out()
+    SETTINGS_EXTIO = (1U << 1),   // extio_settings_out()
+};
+
 static int32_t d_close(struct js110_dev_s * d);
 
 typedef void (*param_fn)(struct js110_dev_s * d, const struct jsdrv_union_s * value);
@@ -92,6 +110,12 @@ static void on_gpi_1_ctrl(struct js110_dev_s * d, const struct jsdrv_union_s * v
 static void on_stats_scnt(struct js110_dev_s * d, const struct jsdrv_union_s * value);
 static void on_stats_ctrl(struct js110_dev_s * d, const struct jsdrv_union_s * value);
 static void on_sstats_ctrl(struct js110_dev_s * d, const struct jsdrv_union_s * value);
+static void on_bulk_in_depth(struct js110_dev_s * d, const struct jsdrv_union_s * value);
+static void on_bulk_in_size(struct js110_dev_s * d, const struct jsdrv_union_s * value);
+static void on_bulk_in_spare(struct js110_dev_s * d, const struct jsdrv_union_s * value);
+static void on_stream_latency(struct js110_dev_s * d, const struct jsdrv_union_s * value);
+static void on_stream_event(struct js110_dev_s * d, const struct jsdrv_union_s * value);
+static void on_qos(struct js110_dev_s * d, const struct jsdrv_union_s * value);
 
 enum param_e {  // CAREFUL! This must match the order in PARAMS exactly!
     PARAM_I_RANGE_SELECT,
@@ -116,6 +140,12 @@ enum param_e {  // CAREFUL! This must match the order in PARAMS exactly!
     PARAM_STATS_SCNT,
     PARAM_STATS_CTRL,
     PARAM_SSTATS_CTRL,
+    PARAM_BULK_IN_DEPTH,
+    PARAM_BULK_IN_SIZE,
+    PARAM_BULK_IN_SPARE,
+    PARAM_STREAM_LATENCY,
+    PARAM_STREAM_EVENT,
+    PARAM_QOS,
     PARAM__COUNT,  // must be last
 };
 
@@ -409,6 +439,81 @@ static const struct param_s PARAMS[] = {
         "}",
         on_sstats_ctrl,
     },
+    {
+        "h/usb/bulk_in/depth",
+        "{"
+            "\"dtype\": \"u32\","
+            "\"brief\": \"The number of outstanding USB bulk in transfers.\","
+            "\"detail\": \"Applied on the next device open.  Increase to tolerate longer host scheduling delays.\","
+            "\"default\": 4,"
+            "\"range\": [1, 64]"
+        "}",
+        on_bulk_in_depth,
+    },
+    {
+        "h/usb/bulk_in/size",
+        "{"
+            "\"dtype\": \"u32\","
+            "\"brief\": \"The size of each USB bulk in transfer in bytes.\","
+            "\"detail\": \"Applied on the next device open.\","
+            "\"default\": 32768,"
+            "\"options\": ["
+                "[32768, \"32 kB\"],"
+                "[65536, \"64 kB\"],"
+                "[131072, \"128 kB\"],"
+                "[262144, \"256 kB\"],"
+                "[524288, \"512 kB\"],"
+                "[1048576, \"1 MB\"]"
+            "]"
+        "}",
+        on_bulk_in_size,
+    },
+    {
+        "h/usb/bulk_in/spare",
+        "{"
+            "\"dtype\": \"u32\","
+            "\"brief\": \"The number of spare USB bulk in transfers.\","
+            "\"detail\": \"Applied on the next device open.  Spare transfers replace completed transfers while the driver processes their data.\","
+            "\"default\": 4,"
+            "\"range\": [1, 64]"
+        "}",
+        on_bulk_in_spare,
+    },
+    {
+        "h/stream/latency",
+        "{"
+            "\"dtype\": \"u32\","
+            "\"brief\": \"The maximum stream message latency in milliseconds.\","
+            "\"detail\": \"Each stream message holds at most this duration of samples.  Below the 50 ms default, partial messages also send once their first data is this old, and 0 sends the data of each USB bulk in transfer immediately.  Lower values reduce latency at a higher message rate.\","
+            "\"default\": 50,"
+            "\"range\": [0, 100]"
+        "}",
+        on_stream_latency,
+    },
+    {
+        "h/stream/event",
+        "{"
+            "\"dtype\": \"bool\","
+            "\"brief\": \"Send the current range and GPI streams as value changes.\","
+            "\"detail\": \"When enabled, these streams publish JSDRV_PAYLOAD_TYPE_STREAM_EVENT messages that contain only the (sample_id, value) transitions.  Each message spans up to 1 second of samples, or h/stream/latency when below the 50 ms default.  Recording, shared memory, network and alignment services only accept the packed stream format.\","
+            "\"default\": 0"
+        "}",
+        on_stream_event,
+    },
+    {
+        "h/qos",
+        "{"
+            "\"dtype\": \"u8\","
+            "\"brief\": \"The message priority for this device.\","
+            "\"detail\": \"When several devices share the driver, the frontend and memory buffer threads process the data of critical devices first and the data of background devices last.  The messages of each device remain in order.  Changes apply to the next message.\","
+            "\"default\": 1,"
+            "\"options\": ["
+                "[0, \"background\"],"
+                "[1, \"normal\"],"
+                "[2, \"critical\"]]"
+        "}",
+        on_qos,
+    },
     {NULL, NULL, NULL},  // MUST BE LAST
 };
 
@@ -449,6 +554,25 @@ const struct field_def_s FIELDS[] = {
 struct port_s {
     struct jsdrvp_msg_s * msg;
     struct jsdrv_downsample_s * downsample;
+    struct jsdrvp_topic_s topic;  // the precomputed data topic
+    uint32_t element_count_max;  // for msg
+    int64_t msg_time;     // jsdrv_time_monotonic() when msg was allocated
+};
+
+/*
+ * Coalesce the instrument settings changed by a burst of parameter
+ * updates, see settings_flush().  The return codes for those
+ * parameters wait for the instrument to apply the settings.
+ */
+struct settings_s {
+    uint8_t pending;            // settings_e changed but not yet sent
+    bool marked;                // the current parameter handler changed settings
+    uint32_t marked_ms;         // the most recent settings_mark()
+    bool wait;                  // sent, awaiting the instrument status
+    uint32_t wait_start_ms;
+    uint32_t rc_wait;           // return codes for the sent settings, rc[0:rc_wait]
+    uint32_t rc_count;
+    char rc[SETTINGS_RC_MAX][JSDRV_TOPIC_LENGTH_MAX];
 };
 
 struct js110_dev_s {
@@ -458,17 +582,27 @@ struct js110_dev_s {
     uint8_t state; // state_e
 
     struct jsdrv_union_s param_values[JSDRV_ARRAY_SIZE(PARAMS)];
+    struct jsdrv_topic_index_s param_index;
+    uint16_t param_index_storage[PARAM__COUNT];
     uint64_t packet_index;
+    int64_t in_latency_usb;  // USB completion stamp for the bulk in message being decoded
     struct js110_sp_s sample_processor;
     struct js110_stats_s stats;
     uint64_t sample_id;
     struct jsdrv_tmf_s * time_map_filter;
     struct jsdrvp_msg_s * status_msg;
+    bool status_settings;       // status_msg was requested after sending settings
+    struct settings_s settings;
 
     int64_t sstats_samples_total_prev;
     struct jsdrv_tmf_s * sstats_time_map_filter;
 
     struct port_s ports[JSDRV_ARRAY_SIZE(FIELDS)];
+    struct jsdrvp_topic_s stats_topic;   // s/stats/value
+    struct jsdrvp_topic_s continuity_topic;  // s/gaps, shared by all signals
+    struct jsdrv_continuity_tracker_s continuity;
+    struct jsdrvp_topic_s sstats_topic;  // s/sstats/value
+    struct jsdrv_trigger_s triggers[JSDRV_TRIGGER_COUNT];
 
     volatile bool do_exit;
     jsdrv_thread_t thread;
@@ -520,11 +654,16 @@ static struct jsdrvp_msg_s * ll_await_msg(struct js110_dev_s * d, struct jsdrvp_
     }
 }
 
+static void backend_send(struct js110_dev_s * d, struct jsdrvp_msg_s * m) {
+    m->qos = d->param_values[PARAM_QOS].value.u8;
+    jsdrvp_backend_send(d->context, m);
+}
+
 static void send_to_frontend(struct js110_dev_s * d, const char * subtopic, const struct jsdrv_union_s * value) {
     struct jsdrvp_msg_s * m;
     m = jsdrvp_msg_alloc_value(d->context, "", value);
     tfp_snprintf(m->topic, sizeof(m->topic), "%s/%s", d->ll.prefix, subtopic);
-    jsdrvp_backend_send(d->context, m);
+    backend_send(d, m);
 }
 
 static int32_t jsdrvb_ctrl_out(struct js110_dev_s * d, usb_setup_t setup, const void * buffer) {
@@ -587,6 +726,9 @@ static int32_t jsdrvb_bulk_in_stream_open(struct js110_dev_s * d, uint8_t endpoi
     jsdrv_cstr_copy(m->topic, JSDRV_USBBK_MSG_BULK_IN_STREAM_OPEN, sizeof(m->topic));
     m->value = jsdrv_union_i32(0);
     m->extra.bkusb_stream.endpoint = endpoint;
+    m->extra.bkusb_stream.transfer_depth = d->param_values[PARAM_BULK_IN_DEPTH].value.u32;
+    m->extra.bkusb_stream.transfer_size = d->param_values[PARAM_BULK_IN_SIZE].value.u32;
+    m->extra.bkusb_stream.transfer_spare = d->param_values[PARAM_BULK_IN_SPARE].value.u32;
     msg_queue_push(d->ll.cmd_q, m);
     m = ll_await_msg(d, m, TIMEOUT_MS);
     if (!m) {
@@ -608,7 +750,7 @@ static void statistics_fwd(struct js110_dev_s * d, struct js110_host_status_s co
 
     jsdrv_tmf_add(d->sstats_time_map_filter, s->samples_total + s->samples_this, jsdrv_time_utc());
     struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(d->context);
-    tfp_snprintf(m->topic, sizeof(m->topic), "%s/s/sstats/value", d->ll.prefix);
+    jsdrvp_msg_topic_set(m, &d->sstats_topic);
     struct jsdrv_statistics_s * dst = (struct jsdrv_statistics_s *) m->payload.bin;
     m->value = jsdrv_union_cbin_r((uint8_t *) dst, sizeof(*dst));
     m->value.app = JSDRV_PAYLOAD_TYPE_STATISTICS;
@@ -656,7 +798,7 @@ static void statistics_fwd(struct js110_dev_s * d, struct js110_host_status_s co
     dst->energy_i128[1] = energy.u64[1];
 
     jsdrv_tmf_get(d->sstats_time_map_filter, &dst->time_map);
-    jsdrvp_backend_send(d->context, m);
+    backend_send(d, m);
 }
 
 static struct jsdrvp_msg_s * d_status_req(struct js110_dev_s * d) {
@@ -670,9 +812,14 @@ static struct jsdrvp_msg_s * d_status_req(struct js110_dev_s * d) {
     return m;
 }
 
+static void settings_status(struct js110_dev_s * d, struct js110_host_status_s const * s);
+
 static int32_t d_status_rsp(struct js110_dev_s * d, struct jsdrvp_msg_s * msg) {
+    bool settings = false;
     if (msg == d->status_msg) {
         d->status_msg = NULL;
+        settings = d->status_settings;
+        d->status_settings = false;
     }
     if (msg->value.size > STATUS_SETUP.s.wLength) {
         JSDRV_LOGW("d_status_rsp: returned too much data");
@@ -684,6 +831,9 @@ static int32_t d_status_rsp(struct js110_dev_s * d, struct jsdrvp_msg_s * msg) {
         return JSDRV_ERROR_NOT_SUPPORTED;
     } else if (pkt->header.type == JS110_HOST_PACKET_TYPE_STATUS) {
         statistics_fwd(d, &pkt->payload.status);
+        if (settings) {
+            settings_status(d, &pkt->payload.status);
+        }
         return 0;
     } else {
         JSDRV_LOGW("d_status_rsp: unsupported type %d", (int) pkt->header.type);
@@ -755,8 +905,24 @@ static int32_t calibration_get(struct js110_dev_s * d) {
         JSDRV_LOGW("cal too small");
         return JSDRV_ERROR_TOO_SMALL;
     }
+    if ((hdr.length < sizeof(hdr)) || (hdr.length > JS110_CAL_LENGTH_MAX)) {
+        JSDRV_LOGW("cal invalid length");
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+
+    const char * cache_path = jsdrvp_cal_cache_path(d->context);
+    const char * serial_number = strrchr(d->ll.prefix, '/');
+    serial_number = serial_number ? (serial_number + 1) : d->ll.prefix;
+    if (cache_path && (0 == js110_cal_cache_load(cache_path, serial_number, &hdr, &cal))) {
+        rv = js110_cal_parse(cal, d->sample_processor.cal);
+        jsdrv_free(cal);
+        if (0 == rv) {
+            return 0;
+        }
+        JSDRV_LOGW("cal cache parse failed, read from device");
+    }
 
-    cal = jsdrv_alloc(hdr.length);
+    cal = jsdrv_alloc((size_t) hdr.length);
     uint32_t offset = 0;
     while (offset < hdr.length) {
         setup.s.wIndex = offset;
@@ -776,11 +942,14 @@ static int32_t calibration_get(struct js110_dev_s * d) {
     if (0 == rv) {
         rv = js110_cal_parse(cal, d->sample_processor.cal);
     }
+    if ((0 == rv) && cache_path) {
+        js110_cal_cache_save(cache_path, serial_number, cal);  // ignore errors
+    }
     jsdrv_free(cal);
     return rv;
 }
 
-static int32_t stream_settings_send(struct js110_dev_s * d) {
+static int32_t stream_settings_out(struct js110_dev_s * d) {
     struct js110_host_packet_s pkt;
     memset(&pkt, 0, sizeof(pkt));
     // initialize device - configure for normal operation
@@ -803,9 +972,14 @@ static int32_t stream_settings_send(struct js110_dev_s * d) {
             .wLength = pkt.header.length,
     }};
     if (jsdrvb_ctrl_out(d, setup, &pkt)) {
-        JSDRV_LOGW("stream_settings_send failed");
+        JSDRV_LOGW("stream_settings_out failed");
         return JSDRV_ERROR_IO;
     }
+    return 0;
+}
+
+static int32_t stream_settings_send(struct js110_dev_s * d) {
+    ROE(stream_settings_out(d));
     if (wait_for_sensor_command(d)) {
         JSDRV_LOGW("stream_settings_send did not work");
         return JSDRV_ERROR_IO;
@@ -843,7 +1017,7 @@ static int32_t stream_settings_sync(struct js110_dev_s * d) {
     return 0;
 }
 
-static int32_t extio_settings_send(struct js110_dev_s * d) {
+static int32_t extio_settings_out(struct js110_dev_s * d) {
     struct js110_host_packet_s pkt;
     memset(&pkt, 0, sizeof(pkt));
     pkt.header.version = JS110_HOST_API_VERSION;
@@ -865,16 +1039,132 @@ static int32_t extio_settings_send(struct js110_dev_s * d) {
             .wLength = pkt.header.length,
     }};
     if (jsdrvb_ctrl_out(d, setup, &pkt)) {
-        JSDRV_LOGW("extio_settings_send failed");
-        return JSDRV_ERROR_IO;
-    }
-    if (wait_for_sensor_command(d)) {
-        JSDRV_LOGW("extio_settings_send did not work");
+        JSDRV_LOGW("extio_settings_out failed");
         return JSDRV_ERROR_IO;
     }
     return 0;
 }
 
+static void settings_mark(struct js110_dev_s * d, uint8_t settings) {
+    d->settings.pending |= settings;
+    d->settings.marked = true;
+    d->settings.marked_ms = jsdrv_time_ms_u32();
+}
+
+// Send the return codes for the sent settings.
+static void settings_complete(struct js110_dev_s * d, int32_t rc) {
+    struct settings_s * s = &d->settings;
+    if (rc) {
+        JSDRV_LOGW("settings failed: %d", (int) rc);
+    }
+    for (uint32_t idx = 0; idx < s->rc_wait; ++idx) {
+        send_to_frontend(d, s->rc[idx], &jsdrv_union_i32(rc));
+    }
+    memmove(s->rc[0], s->rc[s->rc_wait], (s->rc_count - s->rc_wait) * sizeof(s->rc[0]));
+    s->rc_count -= s->rc_wait;
+    s->rc_wait = 0;
+    s->wait = false;
+}
+
+// Send the pending settings without waiting for the instrument.
+static int32_t settings_send(struct js110_dev_s * d) {
+    struct settings_s * s = &d->settings;
+    int32_t rc = 0;
+    uint8_t pending = s->pending;
+    s->pending = 0;
+    s->rc_wait = s->rc_count;
+    if (pending & SETTINGS_STREAM) {
+        rc = stream_settings_out(d);
+    }
+    if ((0 == rc) && (pending & SETTINGS_EXTIO)) {
+        rc = extio_settings_out(d);
+    }
+    return rc;
+}
+
+// Get the time for settings_flush() to send, or UINT32_MAX when idle.
+static uint32_t settings_flush_ms(struct js110_dev_s * d) {
+    struct settings_s * s = &d->settings;
+    if (s->wait || (0 == s->rc_count)) {
+        return UINT32_MAX;
+    }
+    uint32_t dt = jsdrv_time_ms_u32() - s->marked_ms;
+    return (dt >= SETTINGS_COALESCE_MS) ? 0 : (SETTINGS_COALESCE_MS - dt);
+}
+
+/*
+ * Send the settings for all parameters handled within
+ * SETTINGS_COALESCE_MS of each other with one transfer for each
+ * settings_e, then poll the instrument status asynchronously using
+ * status_msg.
+ */
+static void settings_flush(struct js110_dev_s * d) {
+    struct settings_s * s = &d->settings;
+    if (s->wait) {
+        if ((jsdrv_time_ms_u32() - s->wait_start_ms) > SENSOR_COMMAND_TIMEOUT_MS) {
+            JSDRV_LOGW("settings_flush timed out");
+            settings_complete(d, JSDRV_ERROR_TIMED_OUT);
+        } else {
+            if (NULL == d->status_msg) {
+                d->status_msg = d_status_req(d);
+                d->status_settings = true;
+            }
+            return;
+        }
+    }
+    if (0 == s->rc_count) {
+        s->pending = 0;  // handled by d_open() or settings_sync()
+        return;
+    }
+    if (settings_flush_ms(d)) {
+        return;  // await more parameters
+    }
+    int32_t rc = settings_send(d);
+    if (rc) {
+        settings_complete(d, rc);
+        return;
+    }
+    s->wait = true;
+    s->wait_start_ms = jsdrv_time_ms_u32();
+    if (NULL == d->status_msg) {
+        d->status_msg = d_status_req(d);
+        d->status_settings = true;
+    }  // else request after the outstanding status completes
+}
+
+static void settings_status(struct js110_dev_s * d, struct js110_host_status_s const * status) {
+    int32_t settings_result = status->settings_result;
+    if (!d->settings.wait || (settings_result == -1) || (settings_result == 19)) {
+        return;  // waiting, settings_flush() polls again
+    }
+    settings_complete(d, 0);
+}
+
+// Send the pending settings and wait for the instrument to apply them.
+static int32_t settings_sync(struct js110_dev_s * d) {
+    int32_t rc = 0;
+    if (d->settings.wait) {
+        settings_complete(d, wait_for_sensor_command(d));
+    }
+    if (d->settings.pending || d->settings.rc_count) {
+        rc = settings_send(d);
+        if (0 == rc) {
+            rc = wait_for_sensor_command(d);
+        }
+        settings_complete(d, rc);
+    }
+    return rc;
+}
+
+// Defer the parameter return code until the instrument applies its settings.
+static void settings_rc_defer(struct js110_dev_s * d, const char * topic) {
+    struct settings_s * s = &d->settings;
+    if (s->rc_count >= SETTINGS_RC_MAX) {
+        settings_sync(d);
+    }
+    jsdrv_cstr_copy(s->rc[s->rc_count++], topic, sizeof(s->rc[0]));
+}
+
 static int32_t extio_settings_sync(struct js110_dev_s * d) {
     struct js110_host_packet_s pkt;
     memset(&pkt, 0, sizeof(pkt));
@@ -933,37 +1223,37 @@ static int32_t extio_gpi_recv(struct js110_dev_s * d, uint8_t * gpi) {
 
 static void on_i_range_select(struct js110_dev_s * d, const struct jsdrv_union_s * value) {
     d->param_values[PARAM_I_RANGE_SELECT] = *value;
-    stream_settings_send(d);
+    settings_mark(d, SETTINGS_STREAM);
 }
 
 static void on_v_range_select(struct js110_dev_s * d, const struct jsdrv_union_s * value) {
     d->param_values[PARAM_V_RANGE_SELECT] = *value;
-    stream_settings_send(d);
+    settings_mark(d, SETTINGS_STREAM);
 }
 
 static void on_extio_voltage(struct js110_dev_s * d, const struct jsdrv_union_s * value) {
     d->param_values[PARAM_EXTIO_VOLTAGE] = *value;
-    extio_settings_send(d);
+    settings_mark(d, SETTINGS_EXTIO);
 }
 
 static void on_gpo0_value(struct js110_dev_s * d, const struct jsdrv_union_s * value) {
     d->param_values[PARAM_GPO0_VALUE] = *value;
-    extio_settings_send(d);
+    settings_mark(d, SETTINGS_EXTIO);
 }
 
 static void on_gpo1_value(struct js110_dev_s * d, const struct jsdrv_union_s * value) {
     d->param_values[PARAM_GPO1_VALUE] = *value;
-    extio_settings_send(d);
+    settings_mark(d, SETTINGS_EXTIO);
 }
 
 static void on_current_lsb_source(struct js110_dev_s * d, const struct jsdrv_union_s * value) {
     d->param_values[PARAM_I_LSB_SOURCE] = *value;
-    extio_settings_send(d);
+    settings_mark(d, SETTINGS_EXTIO);
 }
 
 static void on_voltage_lsb_source(struct js110_dev_s * d, const struct jsdrv_union_s * value) {
     d->param_values[PARAM_V_LSB_SOURCE] = *value;
-    extio_settings_send(d);
+    settings_mark(d, SETTINGS_EXTIO);
 }
 
 static void on_i_range_mode(struct js110_dev_s * d, const struct jsdrv_union_s * value) {
@@ -1020,7 +1310,9 @@ static void on_sampling_frequency(struct js110_dev_s * d, const struct jsdrv_uni
             p->downsample = NULL;
         }
         reset_port(d, idx);
-        p->downsample = jsdrv_downsample_alloc(SAMPLING_FREQUENCY, fs, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND);
+        int mode = (JSDRV_FIELD_RANGE == FIELDS[idx].field_id)
+                ? JSDRV_DOWNSAMPLE_MODE_MAJORITY : JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND;
+        p->downsample = jsdrv_downsample_alloc(SAMPLING_FREQUENCY, fs, mode);
     }
 }
 
@@ -1047,7 +1339,7 @@ static void on_update_ctrl(struct js110_dev_s * d, const struct jsdrv_union_s *
             }
             d->sample_id = 0;
         }
-        stream_settings_send(d);
+        settings_mark(d, SETTINGS_STREAM);
         JSDRV_LOGI("on_update_ctrl %d (stream change complete) %s", param, stream_str);
     } else {
         JSDRV_LOGI("on_update_ctrl %d (no stream change)", param);
@@ -1092,6 +1384,44 @@ static void on_sstats_ctrl(struct js110_dev_s * d, const struct jsdrv_union_s *
     d->param_values[PARAM_SSTATS_CTRL] = *value;
 }
 
+static void on_bulk_in_depth(struct js110_dev_s * d, const struct jsdrv_union_s * value) {
+    struct jsdrv_union_s v = *value;
+    jsdrv_union_as_type(&v, JSDRV_UNION_U32);
+    d->param_values[PARAM_BULK_IN_DEPTH] = jsdrv_union_u32(jsdrv_usbbk_bulk_in_depth(v.value.u32));
+}
+
+static void on_bulk_in_size(struct js110_dev_s * d, const struct jsdrv_union_s * value) {
+    struct jsdrv_union_s v = *value;
+    jsdrv_union_as_type(&v, JSDRV_UNION_U32);
+    d->param_values[PARAM_BULK_IN_SIZE] = jsdrv_union_u32(jsdrv_usbbk_bulk_in_size(v.value.u32));
+}
+
+static void on_bulk_in_spare(struct js110_dev_s * d, const struct jsdrv_union_s * value) {
+    struct jsdrv_union_s v = *value;
+    jsdrv_union_as_type(&v, JSDRV_UNION_U32);
+    d->param_values[PARAM_BULK_IN_SPARE] = jsdrv_union_u32(jsdrv_usbbk_bulk_in_spare(v.value.u32));
+}
+
+static void on_stream_latency(struct js110_dev_s * d, const struct jsdrv_union_s * value) {
+    struct jsdrv_union_s v = *value;
+    jsdrv_union_as_type(&v, JSDRV_UNION_U32);
+    uint32_t ms = (v.value.u32 > STREAM_LATENCY_MS_MAX) ? STREAM_LATENCY_MS_MAX : v.value.u32;
+    d->param_values[PARAM_STREAM_LATENCY] = jsdrv_union_u32(ms);
+}
+
+static void on_stream_event(struct js110_dev_s * d, const struct jsdrv_union_s * value) {
+    bool enable = false;
+    jsdrv_union_to_bool(value, &enable);
+    d->param_values[PARAM_STREAM_EVENT] = jsdrv_union_u8(enable ? 1 : 0);
+}
+
+static void on_qos(struct js110_dev_s * d, const struct jsdrv_union_s * value) {
+    struct jsdrv_union_s v = *value;
+    jsdrv_union_as_type(&v, JSDRV_UNION_U32);
+    uint8_t qos = (v.value.u32 > JSDRVP_QOS_CRITICAL) ? JSDRVP_QOS_CRITICAL : (uint8_t) v.value.u32;
+    d->param_values[PARAM_QOS] = jsdrv_union_u8(qos);
+}
+
 static int32_t d_open_ll(struct js110_dev_s * d, int32_t opt) {
     JSDRV_LOGI("open_ll");
     struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(d->context, JSDRV_MSG_OPEN, &jsdrv_union_i32(opt & 1));
@@ -1122,6 +1452,9 @@ static void d_reset(struct js110_dev_s * d) {
     for (uint32_t idx = 0; idx < JSDRV_ARRAY_SIZE(FIELDS); ++idx) {
         reset_port(d, idx);
     }
+    for (uint32_t idx = 0; idx < JSDRV_TRIGGER_COUNT; ++idx) {
+        jsdrv_trigger_clear(&d->triggers[idx]);
+    }
 }
 
 static int32_t d_open(struct js110_dev_s * d, int32_t opt) {
@@ -1159,6 +1492,7 @@ static int32_t d_open(struct js110_dev_s * d, int32_t opt) {
         jsdrv_topic_suffix_add(&topic, JSDRV_TOPIC_SUFFIX_METADATA_RSP);
         send_to_frontend(d, topic.topic, &jsdrv_union_cjson_r(p->meta));
     }
+    jsdrv_trigger_meta_publish(d->context, d->ll.prefix);
 
     ROE(calibration_get(d));
     if (opt != JSDRV_DEVICE_OPEN_MODE_DEFAULTS) {
@@ -1183,6 +1517,9 @@ static int32_t d_open(struct js110_dev_s * d, int32_t opt) {
 
 static int32_t d_close(struct js110_dev_s * d) {
     JSDRV_LOGI("close");
+    if (d->state == ST_OPEN) {
+        settings_sync(d);
+    }
     struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(d->context, JSDRV_MSG_CLOSE, &jsdrv_union_u32(0));
     msg_queue_push(d->ll.cmd_q, m);
     m = ll_await_msg(d, m, TIMEOUT_MS);
@@ -1209,18 +1546,52 @@ static void handle_cmd_publish(struct js110_dev_s * d, const struct jsdrvp_msg_s
     jsdrv_topic_suffix_add(&topic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
     JSDRV_LOGI("handle_cmd_publish %s", topic_str);
 
-    for (int i = 0; NULL != PARAMS[i].topic; ++i) {
-        const struct param_s * p = &PARAMS[i];
-        if (0 == strcmp(p->topic, topic_str)) {
-            p->fn(d, &msg->value);
+    int32_t idx = jsdrv_topic_index_find(&d->param_index, topic_str);
+    if (idx >= 0) {
+        d->settings.marked = false;
+        PARAMS[idx].fn(d, &msg->value);
+        if (d->settings.marked) {
+            settings_rc_defer(d, topic.topic);  // see settings_flush()
+        } else {
             send_to_frontend(d, topic.topic, &jsdrv_union_i32(0));
-            return;
         }
+        return;
     }
     JSDRV_LOGW("handle_cmd_publish %s not found", msg->topic);
     send_to_frontend(d, topic.topic, &jsdrv_union_i32(JSDRV_ERROR_UNAVAILABLE));
 }
 
+static void handle_cmd_trigger(struct js110_dev_s * d, const struct jsdrvp_msg_s * msg) {
+    struct jsdrv_topic_s topic;
+    const char * topic_str = prefix_match_and_strip(d->ll.prefix, msg->topic);
+    jsdrv_topic_set(&topic, topic_str);
+    jsdrv_topic_suffix_add(&topic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
+    int32_t rc = jsdrv_trigger_param(d->triggers, topic_str, &msg->value);
+    send_to_frontend(d, topic.topic, &jsdrv_union_i32(rc));
+}
+
+static void continuity_publish(struct js110_dev_s * d) {
+    if (!jsdrv_continuity_publish_ready(&d->continuity, d->sample_id, jsdrv_time_monotonic())) {
+        return;
+    }
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(d->context);
+    jsdrvp_msg_topic_set(m, &d->continuity_topic);
+    JSDRV_ASSERT(sizeof(m->payload.bin) >= sizeof(struct jsdrv_continuity_s));
+    memcpy(m->payload.bin, &d->continuity.value, sizeof(struct jsdrv_continuity_s));
+    m->value = jsdrv_union_cbin_r(m->payload.bin, sizeof(struct jsdrv_continuity_s));
+    m->value.app = JSDRV_PAYLOAD_TYPE_CONTINUITY;
+    backend_send(d, m);
+}
+
+static void handle_cmd_continuity_clear(struct js110_dev_s * d, const struct jsdrvp_msg_s * msg) {
+    struct jsdrv_topic_s topic;
+    jsdrv_topic_set(&topic, prefix_match_and_strip(d->ll.prefix, msg->topic));
+    jsdrv_topic_suffix_add(&topic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
+    jsdrv_continuity_clear(&d->continuity);
+    continuity_publish(d);
+    send_to_frontend(d, topic.topic, &jsdrv_union_i32(0));
+}
+
 static void handle_cmd_gpi_req(struct js110_dev_s * d, const struct jsdrvp_msg_s * msg) {
     uint8_t gpi = 0;
     int32_t rv;
@@ -1230,6 +1601,7 @@ static void handle_cmd_gpi_req(struct js110_dev_s * d, const struct jsdrvp_msg_s
     jsdrv_topic_suffix_add(&topic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
     JSDRV_LOGI("handle_cmd_gpi_req %s", topic_str);
 
+    settings_sync(d);  // read with the requested extio settings
     rv = extio_gpi_recv(d, &gpi);
     if (0 == rv) {
         send_to_frontend(d, "s/gpi/+/!value", &jsdrv_union_u8(gpi));
@@ -1278,6 +1650,12 @@ static bool handle_cmd(struct js110_dev_s * d, struct jsdrvp_msg_s * msg) {
         } else {
             JSDRV_LOGE("handle_cmd unsupported %s", msg->topic);
         }
+    } else if (jsdrv_cstr_starts_with(topic, "h/usb/bulk_in/") || jsdrv_cstr_starts_with(topic, "h/stream/")) {
+        handle_cmd_publish(d, msg);  // allowed while closed
+    } else if (jsdrv_cstr_starts_with(topic, "h/trig/")) {
+        handle_cmd_trigger(d, msg);  // allowed while closed
+    } else if (0 == strcmp("h/gaps/!clear", topic)) {
+        handle_cmd_continuity_clear(d, msg);  // allowed while closed
     } else if (d->state != ST_OPEN) {
         send_to_frontend(d, topic, &jsdrv_union_i32(JSDRV_ERROR_CLOSED));
     } else if (0 == strcmp("s/gpi/+/!req", topic)) {
@@ -1289,145 +1667,238 @@ static bool handle_cmd(struct js110_dev_s * d, struct jsdrvp_msg_s * msg) {
     return rv;
 }
 
-static struct jsdrvp_msg_s * field_message_get(struct js110_dev_s * d, uint8_t field_idx) {
-    struct jsdrv_stream_signal_s * s;
-    const struct field_def_s * field_def = &FIELDS[field_idx];
-    struct jsdrvp_msg_s * m;
-    struct port_s * p = &d->ports[field_idx];
-
-    if (0 == d->param_values[field_def->param].value.u8) {
-        if (p->msg) {
-            JSDRV_LOGI("channel disabled, discard partial message");
-            jsdrvp_msg_free(d->context, p->msg);
-            p->msg = NULL;
-        }
-        return NULL;
+// The elements per message, rounded up to a whole byte for sub-byte elements.
+static uint32_t field_element_count_max(const struct field_def_s * field_def, uint32_t decimate_factor,
+                                        uint32_t latency_ms) {
+    if (0 == latency_ms) {
+        latency_ms = STREAM_LATENCY_MS_DEFAULT;  // flushed each bulk in transfer
     }
-
-    if (NULL == p->msg) {
-        uint32_t decimate_factor = jsdrv_downsample_decimate_factor(p->downsample);
-        if (d->sample_id % decimate_factor) {
-            return NULL;
-        }
-        m = jsdrvp_msg_alloc_data(d->context, "");
-        tfp_snprintf(m->topic, sizeof(m->topic), "%s/%s", d->ll.prefix, field_def->data_topic);
-        s = (struct jsdrv_stream_signal_s *) m->value.value.bin;
-        s->sample_id = d->sample_id;
-        s->index = field_def->index;
-        s->field_id = field_def->field_id;
-        s->element_type = field_def->element_type;
-        s->element_size_bits = field_def->element_size_bits;
-        s->sample_rate = SAMPLING_FREQUENCY;
-        s->decimate_factor = decimate_factor;
-        s->element_count = 0;
-        m->u32_a = (uint32_t) d->sample_id;
-        m->value.app = JSDRV_PAYLOAD_TYPE_STREAM;
-        m->value.size = JSDRV_STREAM_HEADER_SIZE;
-        p->msg = m;
-    }
-
-    return p->msg;
-}
-
-static void field_message_process_end(struct js110_dev_s * d, uint8_t idx) {
-    struct port_s * p = &d->ports[idx];
-    struct jsdrvp_msg_s * m = p->msg;
-    struct jsdrv_stream_signal_s * s = (struct jsdrv_stream_signal_s *) m->value.value.bin;
-    ++s->element_count;
-    if ((s->element_size_bits < 8) && (((s->element_count * s->element_size_bits) & 0x7) != 0)) {
-        return;
+    uint32_t element_count_max = (uint32_t) (((uint64_t) SAMPLING_FREQUENCY * latency_ms) / (1000ULL * decimate_factor));
+    uint32_t full = (STREAM_PAYLOAD_FULL * 8) / field_def->element_size_bits;
+    if (element_count_max > full) {
+        element_count_max = full;
     }
-    uint32_t element_count_max = SAMPLING_FREQUENCY / (20 * jsdrv_downsample_decimate_factor(p->downsample));
     if (element_count_max < 1) {
         element_count_max = 1;
     }
-    if ((((s->element_count * s->element_size_bits) / 8) >= STREAM_PAYLOAD_FULL)
-            || (s->element_count >= element_count_max)) {
-        jsdrv_tmf_get(d->time_map_filter, &s->time_map);
-        p->msg->value.size = JSDRV_STREAM_HEADER_SIZE + s->element_count * s->element_size_bits / 8;
-        jsdrvp_backend_send(d->context, p->msg);
-        p->msg = NULL;
+    if (field_def->element_size_bits < 8) {
+        uint32_t per_byte = 8 / field_def->element_size_bits;
+        element_count_max = ((element_count_max + per_byte - 1) / per_byte) * per_byte;
     }
+    return element_count_max;
 }
 
-static void add_f32_field(struct js110_dev_s * d, uint8_t field_idx, float value) {
-    struct port_s * p = &d->ports[field_idx];
-    struct jsdrvp_msg_s * m = field_message_get(d, field_idx);
-    if (NULL == m) {
-        return;
-    }
-    if (!jsdrv_downsample_add_f32(p->downsample, d->sample_processor.sample_count - 1, value, &value)) {
-        return;
+// The elements per event-encoded message, see stream_event.h.
+static uint32_t field_event_span_max(uint32_t decimate_factor, uint32_t latency_ms) {
+    if ((0 == latency_ms) || (latency_ms >= STREAM_LATENCY_MS_DEFAULT)) {
+        latency_ms = JSDRV_STREAM_EVENT_SPAN_MS;  // 0 flushed each bulk in transfer
     }
-    struct jsdrv_stream_signal_s * s = (struct jsdrv_stream_signal_s *) m->value.value.bin;
-    float *data = (float *) s->data;
-    data[s->element_count] = value;
-    field_message_process_end(d, field_idx);
+    uint32_t span_max = (uint32_t) (((uint64_t) SAMPLING_FREQUENCY * latency_ms) / (1000ULL * decimate_factor));
+    return (span_max < 1) ? 1 : span_max;
 }
 
-static void add_u4_field(struct js110_dev_s * d, uint8_t field_idx, uint8_t value) {
+static struct jsdrvp_msg_s * field_message_alloc(struct js110_dev_s * d, uint8_t field_idx, uint64_t sample_id,
+                                                 uint8_t app) {
     struct jsdrv_stream_signal_s * s;
+    const struct field_def_s * field_def = &FIELDS[field_idx];
     struct port_s * p = &d->ports[field_idx];
-    struct jsdrvp_msg_s * m = field_message_get(d, field_idx);
-    if (NULL == m) {
-        return;
+    uint32_t decimate_factor = jsdrv_downsample_decimate_factor(p->downsample);
+    uint32_t latency_ms = d->param_values[PARAM_STREAM_LATENCY].value.u32;
+    uint32_t element_count_max;
+    uint32_t sz;
+    if (JSDRV_PAYLOAD_TYPE_STREAM_EVENT == app) {
+        element_count_max = field_event_span_max(decimate_factor, latency_ms);
+        sz = JSDRV_STREAM_EVENT_SIZE_MAX;
+    } else {
+        element_count_max = field_element_count_max(field_def, decimate_factor, latency_ms);
+        sz = JSDRV_STREAM_HEADER_SIZE + (element_count_max * field_def->element_size_bits + 7) / 8;
     }
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_data_sz(d->context, "", sz);
+    jsdrvp_msg_topic_set(m, &p->topic);
+    m->latency.usb = d->in_latency_usb;
+    s = (struct jsdrv_stream_signal_s *) m->value.value.bin;
+    s->sample_id = sample_id;
+    s->index = field_def->index;
+    s->field_id = field_def->field_id;
+    s->element_type = field_def->element_type;
+    s->element_size_bits = field_def->element_size_bits;
+    s->sample_rate = SAMPLING_FREQUENCY;
+    s->decimate_factor = decimate_factor;
+    s->element_count = 0;
+    m->u32_a = (uint32_t) sample_id;
+    m->value.app = app;
+    m->value.size = JSDRV_STREAM_HEADER_SIZE;
+    p->msg = m;
+    p->element_count_max = element_count_max;
+    p->msg_time = jsdrv_time_monotonic();
+    return m;
+}
 
-    if (!jsdrv_downsample_add_u8(p->downsample, d->sample_processor.sample_count - 1, value, &value)) {
-        return;
+static void field_message_send(struct js110_dev_s * d, struct port_s * p) {
+    struct jsdrv_stream_signal_s * s = (struct jsdrv_stream_signal_s *) p->msg->value.value.bin;
+    jsdrv_tmf_get(d->time_map_filter, &s->time_map);
+    if (JSDRV_PAYLOAD_TYPE_STREAM == p->msg->value.app) {  // events update the size as they add
+        p->msg->value.size = JSDRV_STREAM_HEADER_SIZE + (s->element_count * s->element_size_bits + 7) / 8;
     }
-    s = (struct jsdrv_stream_signal_s *) m->value.value.bin;
-    value = value & 0x0f;
-    if (0 == (s->element_count & 1)) {
-        s->data[s->element_count >> 1] = value;
-    } else {
-        s->data[s->element_count >> 1] |= (value << 4);
+    JSDRV_LATENCY_STAMP(p->msg->latency.decode);
+    backend_send(d, p->msg);
+    p->msg = NULL;
+}
+
+static void field_pack_u8(struct jsdrv_stream_signal_s * s, const uint8_t * x, uint32_t n) {
+    uint32_t k = s->element_count;
+    s->element_count += n;
+    if (4 == s->element_size_bits) {
+        if ((k & 1) && n) {
+            s->data[k >> 1] |= (uint8_t) ((x[0] & 0x0f) << 4);
+            ++x;
+            --n;
+            ++k;
+        }
+        jsdrv_pack_u4(s->data + (k >> 1), x, n);
+    } else {  // 1 bit
+        for (; (k & 7) && n; ++x, --n, ++k) {
+            s->data[k >> 3] |= (uint8_t) ((x[0] & 1) << (k & 7));
+        }
+        jsdrv_pack_u1(s->data + (k >> 3), x, n);
     }
-    field_message_process_end(d, field_idx);
 }
 
-static void add_u1_field(struct js110_dev_s * d, uint8_t field_idx, uint8_t value) {
-    struct jsdrv_stream_signal_s * s;
+/*
+ * Add downsampled samples to the event-encoded field message.  When the
+ * events are full, send the message and continue with a new one.
+ */
+static void field_add_events(struct js110_dev_s * d, uint8_t field_idx, const uint8_t * y, uint32_t n) {
     struct port_s * p = &d->ports[field_idx];
-    struct jsdrvp_msg_s * m = field_message_get(d, field_idx);
-    if (NULL == m) {
-        return;
+    uint32_t offset = 0;
+    while (offset < n) {
+        struct jsdrv_stream_signal_s * s = (struct jsdrv_stream_signal_s *) p->msg->value.value.bin;
+        offset += jsdrv_stream_event_add_u8(s, &p->msg->value.size, p->msg->capacity, y + offset, n - offset);
+        if (offset < n) {
+            uint64_t sample_id = s->sample_id + (uint64_t) s->element_count * s->decimate_factor;
+            field_message_send(d, p);
+            field_message_alloc(d, field_idx, sample_id, JSDRV_PAYLOAD_TYPE_STREAM_EVENT);
+        }
     }
+}
 
-    if (!jsdrv_downsample_add_u8(p->downsample, d->sample_processor.sample_count - 1, value, &value)) {
+/*
+ * Add a block of contiguous samples to a field.  Each message fill
+ * downsamples a run of samples with a single call, and the message
+ * full check runs once per run rather than once per sample.
+ */
+static void field_add_block(struct js110_dev_s * d, uint8_t field_idx, uint64_t sample_idx,
+                            const void * x, uint32_t n) {
+    const struct field_def_s * field_def = &FIELDS[field_idx];
+    struct port_s * p = &d->ports[field_idx];
+    uint8_t y_u8[FRAME_SAMPLES];
+
+    if (0 == d->param_values[field_def->param].value.u8) {
+        if (p->msg) {
+            JSDRV_LOGI("channel disabled, discard partial message");
+            jsdrvp_msg_free(d->context, p->msg);
+            p->msg = NULL;
+        }
         return;
     }
-    s = (struct jsdrv_stream_signal_s *) m->value.value.bin;
-    value = value & 1;
-    if (0 == (s->element_count & 7)) {
-        s->data[s->element_count >> 3] = value;
-    } else {
-        s->data[s->element_count >> 3] |= value << (s->element_count & 7);
+
+    uint8_t app = (d->param_values[PARAM_STREAM_EVENT].value.u8 && (field_def->element_size_bits < 8))
+            ? JSDRV_PAYLOAD_TYPE_STREAM_EVENT : JSDRV_PAYLOAD_TYPE_STREAM;
+    if (p->msg && (p->msg->value.app != app)) {  // h/stream/event changed
+        field_message_send(d, p);
+    }
+
+    uint32_t decimate_factor = jsdrv_downsample_decimate_factor(p->downsample);
+    uint32_t offset = 0;
+    while (offset < n) {
+        if (NULL == p->msg) {
+            // start messages on decimation boundaries
+            uint32_t skip = (uint32_t) ((d->sample_id + offset) % decimate_factor);
+            if (skip) {
+                offset += decimate_factor - skip;
+                if (offset >= n) {
+                    break;
+                }
+            }
+            field_message_alloc(d, field_idx, d->sample_id + offset, app);
+        }
+        struct jsdrv_stream_signal_s * s = (struct jsdrv_stream_signal_s *) p->msg->value.value.bin;
+        uint64_t run_max = (uint64_t) (p->element_count_max - s->element_count) * decimate_factor;
+        uint32_t run = n - offset;
+        if (run > run_max) {
+            run = (uint32_t) run_max;
+        }
+        uint32_t n_out = 0;
+        if (JSDRV_DATA_TYPE_FLOAT == field_def->element_type) {
+            float * data = (float *) s->data;
+            jsdrv_downsample_add_f32_block(p->downsample, sample_idx + offset, ((const float *) x) + offset, run,
+                                           data + s->element_count, &n_out);
+            s->element_count += n_out;
+        } else {
+            jsdrv_downsample_add_u8_block(p->downsample, sample_idx + offset, ((const uint8_t *) x) + offset, run,
+                                          y_u8, &n_out);
+            if (JSDRV_PAYLOAD_TYPE_STREAM == app) {
+                field_pack_u8(s, y_u8, n_out);
+            } else {
+                field_add_events(d, field_idx, y_u8, n_out);
+                s = (struct jsdrv_stream_signal_s *) p->msg->value.value.bin;  // may be a new message
+            }
+        }
+        offset += run;
+        if (s->element_count >= p->element_count_max) {
+            field_message_send(d, p);
+        }
     }
-    field_message_process_end(d, field_idx);
 }
 
-static void handle_sample(struct js110_dev_s * d, uint32_t sample, uint8_t v_range) {
-    struct js110_sample_s z = js110_sp_process(&d->sample_processor, sample, v_range);
-    add_f32_field(d, 0, z.i);
-    add_f32_field(d, 1, z.v);
-    add_f32_field(d, 2, z.p);
-    add_u4_field(d, 3, z.current_range);
-    add_u1_field(d, 4, z.gpi0);
-    add_u1_field(d, 5, z.gpi1);
-    ++d->sample_id;
+static void handle_stats(struct js110_dev_s * d, const float * i, const float * v, const float * p, uint32_t count) {
+    uint64_t sample_id = d->sample_id - count;
+    uint32_t offset = 0;
+    while (offset < count) {
+        struct jsdrv_statistics_s * s = NULL;
+        offset += js110_stats_compute_block(&d->stats, i + offset, v + offset, p + offset, count - offset, &s);
+        if (NULL != s) {
+            struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(d->context);
+            jsdrvp_msg_topic_set(m, &d->stats_topic);
+            struct jsdrv_statistics_s * dst = (struct jsdrv_statistics_s *) m->payload.bin;
+            *dst = *s;
+            jsdrv_tmf_get(d->time_map_filter, &dst->time_map);
+            m->value = jsdrv_union_cbin_r((uint8_t *) dst, sizeof(*dst));
+            m->value.app = JSDRV_PAYLOAD_TYPE_STATISTICS;
+            backend_send(d, m);
+            s->block_sample_id = sample_id + offset;
+        }
+    }
+}
 
-    struct jsdrv_statistics_s * s = js110_stats_compute(&d->stats, z.i, z.v, z.p);
-    if (NULL != s) {
-        struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(d->context);
-        tfp_snprintf(m->topic, sizeof(m->topic), "%s/s/stats/value", d->ll.prefix);
-        struct jsdrv_statistics_s * dst = (struct jsdrv_statistics_s *) m->payload.bin;
-        *dst = *s;
-        jsdrv_tmf_get(d->time_map_filter, &dst->time_map);
-        m->value = jsdrv_union_cbin_r((uint8_t *) dst, sizeof(*dst));
-        m->value.app = JSDRV_PAYLOAD_TYPE_STATISTICS;
-        jsdrvp_backend_send(d->context, m);
-        s->block_sample_id = d->sample_id;
+// Evaluate the triggers on the full-rate frame samples before host downsampling.
+static void trigger_process(struct js110_dev_s * d, const struct js110_sp_block_s * block, uint32_t count) {
+    struct jsdrv_trigger_event_s * event = NULL;
+    for (uint32_t idx = 0; idx < JSDRV_TRIGGER_COUNT; ++idx) {
+        struct jsdrv_trigger_s * t = &d->triggers[idx];
+        const float * x_f32 = NULL;
+        const uint8_t * x_u8 = NULL;
+        switch (t->source) {
+            case JSDRV_TRIGGER_SOURCE_CURRENT: x_f32 = block->i; break;
+            case JSDRV_TRIGGER_SOURCE_VOLTAGE: x_f32 = block->v; break;
+            case JSDRV_TRIGGER_SOURCE_POWER:   x_f32 = block->p; break;
+            case JSDRV_TRIGGER_SOURCE_GPI0:    x_u8 = block->gpi0; break;
+            case JSDRV_TRIGGER_SOURCE_GPI1:    x_u8 = block->gpi1; break;
+            default: continue;
+        }
+        for (uint32_t k = 0; k < count; ) {
+            if (x_f32) {
+                k += jsdrv_trigger_add_f32(t, d->sample_id + k, SAMPLING_FREQUENCY, 1, x_f32 + k, count - k, &event);
+            } else {
+                k += jsdrv_trigger_add_u8(t, d->sample_id + k, SAMPLING_FREQUENCY, 1, x_u8 + k, count - k, &event);
+            }
+            if (event) {
+                struct jsdrv_time_map_s time_map;
+                jsdrv_tmf_get(d->time_map_filter, &time_map);
+                event->utc = (time_map.offset_time > 0) ? jsdrv_time_from_counter(&time_map, event->sample_id) : 0;
+                jsdrv_trigger_event_publish(d->context, d->ll.prefix, t);
+            }
+        }
     }
 }
 
@@ -1435,7 +1906,7 @@ static void handle_stream_in_frame(struct js110_dev_s * d, uint32_t * p_u32) {
     uint8_t * p_u8 = (uint8_t *) p_u32;
     uint8_t buffer_type = p_u8[0];
     if (1 != buffer_type) {
-        JSDRV_LOGW("handle_stream_in_frame invalid buffer type: %d", (int) buffer_type);
+        JSDRV_LOGW_RATE("handle_stream_in_frame invalid buffer type: %d", (int) buffer_type);
         return;
     }
     uint8_t status = p_u8[1];
@@ -1443,15 +1914,24 @@ static void handle_stream_in_frame(struct js110_dev_s * d, uint32_t * p_u32) {
     uint8_t voltage_range = (p_u8[3] >> 7) & 1;
     uint64_t pkt_index = ((uint16_t) p_u8[4]) | (((uint16_t) p_u8[5]) << 8);
     if (status) {
-        JSDRV_LOGW("handle_stream_in_frame status = %d", (int) status);
+        JSDRV_LOGW_RATE("handle_stream_in_frame status = %d", (int) status);
+        jsdrv_continuity_drop(&d->continuity);
         return;
     }
     if (FRAME_SIZE_BYTES != pkt_length) {
-        JSDRV_LOGW("handle_stream_in_frame invalid length = %d", (int) pkt_length);
+        JSDRV_LOGW_RATE("handle_stream_in_frame invalid length = %d", (int) pkt_length);
+        jsdrv_continuity_drop(&d->continuity);
         return;
     }
     if ((d->packet_index & 0xffff) != pkt_index) {
-        JSDRV_LOGW("pkt_index skip: expected %d, received %d", d->packet_index, pkt_index);
+        JSDRV_LOGW_RATE("pkt_index skip: expected %d, received %d", d->packet_index, pkt_index);
+        uint64_t lost = (pkt_index - d->packet_index) & 0xffff;
+        if (lost < 0x8000) {
+            // sample_id does not advance over lost frames, so the gap has no sample_id range
+            jsdrv_continuity_skip(&d->continuity, d->sample_id, lost * FRAME_SAMPLES);
+        } else {
+            jsdrv_continuity_resync(&d->continuity);
+        }
         //while ((d->packet_index & 0xffff) != pkt_index) {
         //    for (uint32_t i = 2; i < (FRAME_SIZE_BYTES / 4); ++i) {
         //        handle_sample(d, 0xffffffffLU, voltage_range);
@@ -1462,19 +1942,70 @@ static void handle_stream_in_frame(struct js110_dev_s * d, uint32_t * p_u32) {
         d->packet_index = pkt_index;
     }
     jsdrv_tmf_add(d->time_map_filter, d->sample_id, jsdrv_time_utc());
-    for (uint32_t i = 2; i < (FRAME_SIZE_BYTES / 4); ++i) {
-        handle_sample(d, p_u32[i], voltage_range);
-    }
+    float i[FRAME_SAMPLES];
+    float v[FRAME_SAMPLES];
+    float p[FRAME_SAMPLES];
+    uint8_t current_range[FRAME_SAMPLES];
+    uint8_t gpi0[FRAME_SAMPLES];
+    uint8_t gpi1[FRAME_SAMPLES];
+    struct js110_sp_block_s block = {
+        .i = i, .v = v, .p = p,
+        .current_range = current_range, .gpi0 = gpi0, .gpi1 = gpi1,
+    };
+    uint64_t sample_idx = d->sample_processor.sample_count;
+    uint64_t missing = d->sample_processor.sample_missing_count;
+    js110_sp_process_block(&d->sample_processor, p_u32 + 2, FRAME_SAMPLES, voltage_range, &block);
+    if (missing != d->sample_processor.sample_missing_count) {
+        // instrument missing sample markers, one gap per frame
+        jsdrv_continuity_skip(&d->continuity, d->sample_id, d->sample_processor.sample_missing_count - missing);
+    }
+    trigger_process(d, &block, FRAME_SAMPLES);
+    field_add_block(d, 0, sample_idx, i, FRAME_SAMPLES);
+    field_add_block(d, 1, sample_idx, v, FRAME_SAMPLES);
+    field_add_block(d, 2, sample_idx, p, FRAME_SAMPLES);
+    field_add_block(d, 3, sample_idx, current_range, FRAME_SAMPLES);
+    field_add_block(d, 4, sample_idx, gpi0, FRAME_SAMPLES);
+    field_add_block(d, 5, sample_idx, gpi1, FRAME_SAMPLES);
+    d->sample_id += FRAME_SAMPLES;
+    handle_stats(d, i, v, p, FRAME_SAMPLES);
     d->packet_index = (d->packet_index + 1) & 0xffff;
 }
 
+/*
+ * Send partial field messages whose first data is older than
+ * h/stream/latency.  When samples arrive slower than real time,
+ * messages would otherwise wait for element_count_max samples.
+ * The default latency keeps the sample count limit only.
+ */
+static void field_flush(struct js110_dev_s * d) {
+    uint32_t latency_ms = d->param_values[PARAM_STREAM_LATENCY].value.u32;
+    if (latency_ms >= STREAM_LATENCY_MS_DEFAULT) {
+        return;
+    }
+    int64_t now = jsdrv_time_monotonic();
+    int64_t limit = JSDRV_MILLISECONDS_TO_TIME(latency_ms);
+    for (uint32_t idx = 0; idx < JSDRV_ARRAY_SIZE(d->ports); ++idx) {
+        struct port_s * p = &d->ports[idx];
+        if ((NULL == p->msg) || ((now - p->msg_time) < limit)) {
+            continue;
+        }
+        struct jsdrv_stream_signal_s * s = (struct jsdrv_stream_signal_s *) p->msg->value.value.bin;
+        if (s->element_count) {
+            field_message_send(d, p);
+        }
+    }
+}
+
 static void handle_stream_in(struct js110_dev_s * d, struct jsdrvp_msg_s * msg) {
     JSDRV_ASSERT(msg->value.type == JSDRV_UNION_BIN);
+    d->in_latency_usb = msg->latency.usb;
     uint32_t frame_count = (msg->value.size + FRAME_SIZE_BYTES - 1) / FRAME_SIZE_BYTES;
     for (uint32_t i = 0; i < frame_count; ++i) {
         uint32_t * p_u32 = (uint32_t *) &msg->value.value.bin[i * FRAME_SIZE_BYTES];
         handle_stream_in_frame(d, p_u32);
     }
+    field_flush(d);
+    continuity_publish(d);
 }
 
 static bool handle_rsp(struct js110_dev_s * d, struct jsdrvp_msg_s * msg) {
@@ -1508,6 +2039,7 @@ static THREAD_RETURN_TYPE driver_thread(THREAD_ARG_TYPE lpParam) {
     uint32_t duration_ms = 0;
     struct js110_dev_s *d = (struct js110_dev_s *) lpParam;
     JSDRV_LOGI("JS110 USB upper-level thread started %s", d->ll.prefix);
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_DEVICE);
 
 #if _WIN32
     HANDLE handles[MAXIMUM_WAIT_OBJECTS];
@@ -1533,6 +2065,10 @@ static THREAD_RETURN_TYPE driver_thread(THREAD_ARG_TYPE lpParam) {
             }
         } else {
             duration_ms = INTERVAL_MS - duration_ms;
+            uint32_t flush_ms = settings_flush_ms(d);
+            if (flush_ms < duration_ms) {
+                duration_ms = flush_ms;
+            }
 #if _WIN32
             WaitForMultipleObjects(handle_count, handles, false, duration_ms);
 #else
@@ -1540,15 +2076,22 @@ static THREAD_RETURN_TYPE driver_thread(THREAD_ARG_TYPE lpParam) {
 #endif
         }
         //JSDRV_LOGD3("ul thread");
+        JSDRV_TRACE_START(t_cmd);
         while (handle_cmd(d, msg_queue_pop_immediate(d->ul.cmd_q))) {
             ;
         }
+        JSDRV_TRACE_END("dev_cmd", t_cmd, 0);
         // note: ResetEvent handled automatically by msg_queue_pop_immediate
+        JSDRV_TRACE_START(t_rsp);
+        uint32_t rsp_count = 0;
         while (handle_rsp(d, msg_queue_pop_immediate(d->ll.rsp_q))) {
-            ;
+            ++rsp_count;
         }
+        JSDRV_TRACE_END("dev_rsp", t_rsp, rsp_count);
+        settings_flush(d);
     }
     JSDRV_LOGI("JS110 USB upper-level thread done %s", d->ll.prefix);
+    jsdrv_thread_unregister();
     THREAD_RETURN();
 }
 
@@ -1580,8 +2123,17 @@ int32_t jsdrvp_ul_js110_usb_factory(struct jsdrvp_ul_device_s ** device, struct
     d->context = context;
     d->ll = *ll;
     d->ul.cmd_q = msg_queue_init();
+    msg_queue_lanes_enable(d->ul.cmd_q);
     d->ul.join = join;
     d->state = ST_CLOSED;
+    for (uint32_t idx = 0; idx < JSDRV_ARRAY_SIZE(FIELDS); ++idx) {
+        jsdrvp_topic_init(&d->ports[idx].topic, d->ll.prefix, FIELDS[idx].data_topic);
+    }
+    jsdrvp_topic_init(&d->stats_topic, d->ll.prefix, "s/stats/value");
+    jsdrvp_topic_init(&d->continuity_topic, d->ll.prefix, "s/gaps");
+    jsdrv_continuity_clear(&d->continuity);
+    d->continuity.changed = false;  // publish on the first event
+    jsdrvp_topic_init(&d->sstats_topic, d->ll.prefix, "s/sstats/value");
     d->time_map_filter = jsdrv_tmf_new(SAMPLING_FREQUENCY, 60, JSDRV_TIME_SECOND);
     d->sstats_time_map_filter = jsdrv_tmf_new(SAMPLING_FREQUENCY, 60, JSDRV_TIME_SECOND);
     d->status_msg = NULL;
@@ -1592,6 +2144,11 @@ int32_t jsdrvp_ul_js110_usb_factory(struct jsdrvp_ul_device_s ** device, struct
     for (int i = 0; NULL != PARAMS[i].topic; ++i) {
         jsdrv_meta_default(PARAMS[i].meta, &d->param_values[i]);
     }
+    for (uint32_t idx = 0; idx < JSDRV_TRIGGER_COUNT; ++idx) {
+        jsdrv_trigger_initialize(&d->triggers[idx], (uint8_t) idx);
+    }
+    jsdrv_topic_index_init(&d->param_index, PARAMS, sizeof(PARAMS[0]), offsetof(struct param_s, topic),
+                           PARAM__COUNT, d->param_index_storage);
 
     if (jsdrv_thread_create(&d->thread, driver_thread, d, 1)) {
         return JSDRV_ERROR_UNSPECIFIED;
@@ -33,5 +33,102 @@ const struct jsdrvp_param_s js220_params[] = {
             "\"flags\": [\"ro\", \"hide\"]"
         "}",
     },
+    {
+        .topic = "h/usb/bulk_in/depth",
+        .meta = "{"
+            "\"dtype\": \"u32\","
+            "\"brief\": \"The number of outstanding USB bulk in transfers.\","
+            "\"detail\": \"Applied on the next device open.  Increase to tolerate longer host scheduling delays.\","
+            "\"default\": 4,"
+            "\"range\": [1, 64]"
+        "}",
+    },
+    {
+        .topic = "h/usb/bulk_in/max",
+        .meta = "{"
+            "\"dtype\": \"u32\","
+            "\"brief\": \"The adaptive limit for outstanding USB bulk in transfers.\","
+            "\"detail\": \"Applied on the next device open.  When greater than h/usb/bulk_in/depth, the backend doubles the outstanding transfers up to this limit when the host falls behind or the stream skips samples, then decreases them by one after each 10 seconds without pressure.  h/usb/bulk_in/actual publishes the current value.  0 keeps the depth fixed.\","
+            "\"default\": 0,"
+            "\"range\": [0, 64]"
+        "}",
+    },
+    {
+        .topic = "h/usb/bulk_in/size",
+        .meta = "{"
+            "\"dtype\": \"u32\","
+            "\"brief\": \"The size of each USB bulk in transfer in bytes.\","
+            "\"detail\": \"Applied on the next device open.\","
+            "\"default\": 32768,"
+            "\"options\": ["
+                "[32768, \"32 kB\"],"
+                "[65536, \"64 kB\"],"
+                "[131072, \"128 kB\"],"
+                "[262144, \"256 kB\"],"
+                "[524288, \"512 kB\"],"
+                "[1048576, \"1 MB\"]]"
+        "}",
+    },
+    {
+        .topic = "h/usb/bulk_in/spare",
+        .meta = "{"
+            "\"dtype\": \"u32\","
+            "\"brief\": \"The number of spare USB bulk in transfers.\","
+            "\"detail\": \"Applied on the next device open.  Spare transfers replace completed transfers while the driver processes their data.\","
+            "\"default\": 4,"
+            "\"range\": [1, 64]"
+        "}",
+    },
+    {
+        .topic = "h/stream/latency",
+        .meta = "{"
+            "\"dtype\": \"u32\","
+            "\"brief\": \"The maximum stream message latency in milliseconds.\","
+            "\"detail\": \"Each stream message holds at most this duration of samples.  Below the 50 ms default, partial messages also send once their first data is this old, and 0 sends the data of each USB bulk in transfer immediately.  Lower values reduce latency at a higher message rate.\","
+            "\"default\": 50,"
+            "\"range\": [0, 100]"
+        "}",
+    },
+    {
+        .topic = "h/stream/event",
+        .meta = "{"
+            "\"dtype\": \"bool\","
+            "\"brief\": \"Send the current range and GPI streams as value changes.\","
+            "\"detail\": \"When enabled, these streams publish JSDRV_PAYLOAD_TYPE_STREAM_EVENT messages that contain only the (sample_id, value) transitions.  Each message spans up to 1 second of samples, or h/stream/latency when below the 50 ms default.  Recording, shared memory, network and alignment services only accept the packed stream format.\","
+            "\"default\": 0"
+        "}",
+    },
+    {
+        .topic = "h/stream/frame",
+        .meta = "{"
+            "\"dtype\": \"bool\","
+            "\"brief\": \"Also publish the enabled signals together.\","
+            "\"detail\": \"When enabled, s/frame/!data publishes JSDRV_PAYLOAD_TYPE_STREAM_FRAME messages that contain the current, voltage, power, current range and GPI samples for the same sample_id range.  Each signal continues to publish its own stream.\","
+            "\"default\": 0"
+        "}",
+    },
+    {
+        .topic = "h/power/window",
+        .meta = "{"
+            "\"dtype\": \"u32\","
+            "\"brief\": \"The host power alignment window in samples.\","
+            "\"detail\": \"When the host computes power from current and voltage, it retains the samples of the leading signal until the other signal arrives.  When one signal falls more than this window behind, the host discards the oldest retained samples and increments h/power/overrun.  The value rounds up to a power of 2.  Changes apply immediately and discard the retained samples.\","
+            "\"default\": 65536,"
+            "\"range\": [1024, 4194304]"
+        "}",
+    },
+    {
+        .topic = "h/qos",
+        .meta = "{"
+            "\"dtype\": \"u8\","
+            "\"brief\": \"The message priority for this device.\","
+            "\"detail\": \"When several devices share the driver, the frontend and memory buffer threads process the data of critical devices first and the data of background devices last.  The messages of each device remain in order.  Changes apply to the next message.\","
+            "\"default\": 1,"
+            "\"options\": ["
+                "[0, \"background\"],"
+                "[1, \"normal\"],"
+                "[2, \"critical\"]]"
+        "}",
+    },
     {.topic = NULL, .meta = NULL}  // end of list
 };
@@ -18,22 +18,43 @@
 #include "jsdrv.h"
 #include "js220_api.h"
 #include "jsdrv_prv/js220_stats.h"
+#include "jsdrv_prv/atomic.h"
+#include "jsdrv_prv/buffer_codec.h"
+#include "jsdrv_prv/calibration_hash.h"
 #include "jsdrv_prv/downsample.h"
+#include "jsdrv_prv/executor.h"
 #include "jsdrv_prv/backend.h"
 #include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/continuity.h"
 #include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/host_stats.h"
+#include "jsdrv_prv/latency.h"
 #include "jsdrv_prv/log.h"
 #include "jsdrv_prv/msg_queue.h"
+#include "jsdrv_prv/pack.h"
+#include "jsdrv_prv/perf.h"
+#include "jsdrv_prv/power_align.h"
+#include "jsdrv_prv/proc.h"
+#include "jsdrv_prv/tap.h"
+#include "jsdrv_prv/pubsub.h"
+#include "jsdrv_prv/stream_event.h"
+#include "jsdrv_prv/framer.h"
+#include "jsdrv_prv/gate.h"
 #include "jsdrv_prv/thread.h"
+#include "jsdrv_prv/trace.h"
+#include "jsdrv_prv/topic_index.h"
+#include "jsdrv_prv/trigger.h"
 #include "jsdrv/cstr.h"
 #include "jsdrv/error_code.h"
 #include "jsdrv_prv/dbc.h"
-#include "jsdrv_prv/sample_buffer_f32.h"
+#include "jsdrv_prv/simd_f32.h"
+#include "jsdrv/time.h"
 #include "jsdrv/topic.h"
 #include "jsdrv_prv/platform.h"
 #include "jsdrv/version.h"
 #include "tinyprintf.h"
 #include <inttypes.h>
+#include <stdio.h>
 
 /*
  * Streaming data handling
@@ -83,10 +104,15 @@
 #define SENSOR_COMMAND_TIMEOUT_MS  (3000U)
 #define FRAME_SIZE_BYTES           (512U)
 #define FRAME_SIZE_U32             (FRAME_SIZE_BYTES / 4)
+#define BULK_OUT_PACK_FRAMES       (8U)  // port 1 frames packed into one bulk out transfer
 #define MEM_SIZE_MAX               (512U * 1024U)
 #define SAMPLING_FREQUENCY         (2000000U)
 #define FS_MIN_ON_INSTRUMENT       (1000U)
 #define STREAM_PAYLOAD_FULL        (JSDRV_STREAM_DATA_SIZE - JSDRV_STREAM_HEADER_SIZE - JS220_USB_FRAME_LENGTH)
+#define STREAM_RUN_SIZE            (4096U)  // sample bytes batched for each port, see stream_in_run_add()
+#define STREAM_LATENCY_MS_DEFAULT  (50U)
+#define STREAM_LATENCY_MS_MAX      (100U)
+#define USB_BANDWIDTH_MAX          (40000000U)  // practical USB high-speed bulk in bytes per second
 
 extern const struct jsdrvp_param_s js220_params[];
 
@@ -150,7 +176,9 @@ static const char * signal_downsample_filter = "{"
     "\"default\": 0,"
     "\"options\": ["
         "[0, \"wideband\"],"  // on host (default)
-        "[1, \"sinc1\"]"      // on instrument, added in fpga & fw version 1.3.0
+        "[1, \"sinc1\"],"     // on instrument, added in fpga & fw version 1.3.0
+        "[2, \"cic\"],"       // on host, sinc^3
+        "[3, \"cic_comp\"]"   // on host, sinc^3 with droop compensation
     "]"
 "}";
 
@@ -166,10 +194,54 @@ static const char * v_scale_factor = "{"
     "\"default\": 1.0"
 "}";
 
+static const char * host_stats_ctrl_meta = "{"
+    "\"dtype\": \"bool\","
+    "\"brief\": \"Enable host statistics from the full-rate i, v, p streams.\","
+    "\"detail\": \"Publishes s/stats/host/value.  Requires s/i/ctrl, s/v/ctrl and s/p/ctrl.\","
+    "\"default\": 0"
+"}";
+
+static const char * host_stats_derived_meta = "{"
+    "\"dtype\": \"bool\","
+    "\"brief\": \"Enable the derived host statistics.\","
+    "\"detail\": \"Publishes the window RMS, crest factor and running histograms to s/stats/host/derived with each host statistics window.  Requires h/stats/ctrl.\","
+    "\"default\": 0"
+"}";
+
+static const char * host_stats_window_meta = "{"
+    "\"dtype\": \"u32\","
+    "\"brief\": \"The host statistics window in 1 Msps samples.\","
+    "\"default\": 100000,"
+    "\"range\": [1, 4294967295]"
+"}";
+
+static const char * gate_mask_meta = "{"
+    "\"dtype\": \"u8\","
+    "\"brief\": \"The GPI bits that control the host gate.\","
+    "\"detail\": \"Bit N selects s/gpi/N.  While (gpi & mask) == h/gate/level, the host accumulates the full-rate i, v and p samples, and publishes the statistics with the charge and energy of each gate interval to s/gate/value.  Requires s/i/ctrl, s/v/ctrl, s/p/ctrl and s/gpi/N/ctrl for each selected GPI.  0 disables.\","
+    "\"default\": 0"
+"}";
+
+static const char * gate_level_meta = "{"
+    "\"dtype\": \"u8\","
+    "\"brief\": \"The GPI levels that activate the host gate.\","
+    "\"detail\": \"Bit N is the active level for s/gpi/N, for the bits in h/gate/mask.\","
+    "\"default\": 0"
+"}";
+
+static const char * host_stats_hop_meta = "{"
+    "\"dtype\": \"u32\","
+    "\"brief\": \"The host statistics samples between updates.\","
+    "\"detail\": \"Use 0 for tumbling windows.  Otherwise the window must be a multiple of hop, up to 64 hops.\","
+    "\"default\": 0"
+"}";
+
 
 enum downsample_e {
     DOWNSAMPLE_WIDEBAND = 0,
     DOWNSAMPLE_SINC1 = 1,
+    DOWNSAMPLE_CIC = 2,
+    DOWNSAMPLE_CIC_COMP = 3,
 };
 
 enum state_e {
@@ -222,8 +294,14 @@ struct field_def_s PORT_MAP[] = {
 #define PORT_ID_CURRENT (5 + 16)
 #define PORT_ID_VOLTAGE (6 + 16)
 #define PORT_ID_POWER   (7 + 16)
+#define PORT_ID_GPI0    (8 + 16)
+#define PORT_ID_GPI1    (9 + 16)
 #define COMPUTE_POWER_MASK ((1 << PORT_ID_CURRENT) | (1 << PORT_ID_VOLTAGE) | (1 << PORT_ID_POWER))
 #define PORTS_LENGTH (16)  // but last one is reserved
+#define FRAME_CHANNEL_NONE (0xffU)
+
+// The s/frame/!data channel ports, float first so that current defines the frame samples
+static const uint8_t FRAME_PORTS[] = {5, 6, 7, 4, 8, 9, 10, 11, 12};
 
 JSDRV_STATIC_ASSERT(PORTS_LENGTH == JSDRV_ARRAY_SIZE(PORT_MAP), ports_length);
 
@@ -233,14 +311,49 @@ enum break_e {
     BREAK_PUBSUB_TOPIC = 2,
 };
 
+/// The pending open operation steps, see open_advance().
+enum open_step_e {
+    OPEN_STEP_IDLE = 0,         // no open in progress
+    OPEN_STEP_LL = 1,           // await JSDRV_MSG_OPEN from the lower-level driver
+    OPEN_STEP_DISCONNECT = 2,   // await the JS220_CTRL_OP_DISCONNECT response
+    OPEN_STEP_STREAM = 3,       // await JSDRV_USBBK_MSG_BULK_IN_STREAM_OPEN
+    OPEN_STEP_CONNECT = 4,      // await the JS220_CTRL_OP_CONNECT response
+    OPEN_STEP_WAIT_CONNECT = 5, // await port 0 JS220_PORT0_OP_CONNECT
+    OPEN_STEP_PING = 6,         // await the pong after the metadata query
+};
+
+struct port_tap_s {
+    struct jsdrv_tap_s tap;
+    struct jsdrvp_msg_s * msg_in;
+    int64_t msg_in_time;           // jsdrv_time_monotonic() when msg_in was allocated
+    struct jsdrvp_topic_s topic;   // s/{signal}/tap/N/!data, empty for non-float ports
+};
+
+// contiguous frame payloads for one port within a bulk in transfer
+struct port_run_s {
+    uint32_t size;            // bytes in data including the sample_id header, 0 when empty
+    uint32_t sample_id_next;  // the u32 sample_id following the last sample
+    uint32_t data[1 + STREAM_RUN_SIZE / sizeof(uint32_t)];  // sample_id + samples
+};
+
 struct port_s {
     struct jsdrv_downsample_s * downsample;
+    struct jsdrv_downsample_s * downsample_next;  // primed while pending, NULL for no downsampling
+    bool downsample_pending;       // switch to downsample_next, see port_downsample_next()
+    uint32_t downsample_prime;     // input samples remaining before the switch
     uint32_t decimate_factor;      // on-instrument decimation performed, excluding host downsampling
     uint64_t sample_id_next;
     struct jsdrvp_msg_s * msg_in;  // one for each port
-    struct sbuf_f32_s * buf;
+    int64_t msg_in_time;           // jsdrv_time_monotonic() when msg_in was allocated
+    struct jsdrvp_topic_s topic;   // the precomputed data topic
+    struct jsdrv_continuity_tracker_s continuity;
+    struct jsdrvp_topic_s continuity_topic;  // s/{signal}/gaps, empty for non-sample ports
+    struct port_tap_s taps[JSDRV_TAP_COUNT];  // h/tap/N/fs outputs
+    struct port_run_s run;         // pending samples, see stream_in_run_add()
 };
 
+#define HOST_PARAMS_MAX (16U)
+
 struct dev_s {
     struct jsdrvp_ul_device_s ul; // MUST BE FIRST!
     struct jsdrvp_ll_device_s ll;
@@ -248,36 +361,83 @@ struct dev_s {
     uint16_t out_frame_id;
     uint16_t in_frame_id;
     uint64_t in_frame_count;
+    int64_t in_latency_usb;  // USB completion stamp for the bulk in message being decoded
     uint32_t stream_in_port_enable;
+    uint32_t stream_latency_ms;  // h/stream/latency, 0 flushes each bulk in transfer
+    uint8_t qos;                 // h/qos, jsdrvp_qos_e for all messages to the frontend
+    bool stream_event;           // h/stream/event, send sub-byte streams as value changes
+    struct jsdrv_framer_s * framer;  // h/stream/frame, NULL when off
+    uint32_t frame_port_mask;    // the stream_in_port_enable ports configured in framer
+    uint8_t frame_channel[PORTS_LENGTH];  // the framer channel for each port, FRAME_CHANNEL_NONE when excluded
+    struct jsdrvp_msg_s * frame_msg;      // the next frame message, reused until filled
+    struct jsdrvp_topic_s frame_topic;    // s/frame/!data
+    uint32_t bulk_in_depth;  // outstanding bulk in transfers, see jsdrv_usbbk_bulk_in_depth()
+    uint32_t bulk_in_depth_max;     // h/usb/bulk_in/max, adaptive depth limit, 0 for fixed
+    uint32_t bulk_in_depth_actual;  // the last published h/usb/bulk_in/actual
+    bool bulk_in_skip;       // a stream skip since the last returned bulk in message
+    uint32_t bulk_in_size;   // bytes per bulk in transfer, see jsdrv_usbbk_bulk_in_size()
+    uint32_t bulk_in_spare;  // spare bulk in transfers, see jsdrv_usbbk_bulk_in_spare()
+    uint32_t usb_budget;     // h/usb/budget bytes per second, 0 to only warn above USB_BANDWIDTH_MAX
+    uint32_t usb_bw;         // h/usb/bw, the estimated bulk in bytes per second
+    uint64_t usb_rx_bytes;   // bulk in bytes since usb_rx_time
+    int64_t usb_rx_time;     // jsdrv_time_monotonic() of the last h/usb/rx
+    struct jsdrvp_msg_s * bulk_out_pack;  // pending port 1 frames, see bulk_out_flush()
 
     struct js220_port0_connect_s port0_connect;
     uint32_t fs;  // sampling frequency
     uint32_t signal_downsample_filter;
     uint32_t gpi_downsample_filter;
+    uint32_t tap_fs[JSDRV_TAP_COUNT];  // h/tap/N/fs, 0 for off
 
     struct port_s ports[PORTS_LENGTH]; // one for each port
+    struct jsdrvp_topic_s stats_topic;       // s/stats/value
+    struct jsdrvp_topic_s host_stats_topic;  // s/stats/host/value
+    struct jsdrvp_topic_s host_derived_topic;  // s/stats/host/derived
+    struct jsdrvp_topic_s gate_topic;        // s/gate/value
     enum break_e ll_await_break_on;
     bool ll_await_break;
     char ll_await_break_topic[JSDRV_TOPIC_LENGTH_MAX];
     struct jsdrv_union_s ll_await_break_value;
+    uint8_t open_step;           // open_step_e
+    int32_t open_opt;            // the JSDRV_DEVICE_OPEN_MODE for the pending open
+    uint32_t open_deadline_ms;   // jsdrv_time_ms_u32() timeout for the current open step
+    struct jsdrv_list_s cmd_deferred;  // commands received during the pending open
     volatile bool do_exit;
     jsdrv_thread_t thread;
+    struct jsdrv_executor_task_s * task;  // JSDRV_ARG_DEVICE_THREADS task instead of thread, or NULL
+    bool task_started;
+    volatile int32_t task_done;
     uint8_t state;  // state_e
 
     struct jsdrv_time_map_s time_map;
 
     float i_scale;
     float v_scale;
-    struct sbuf_f32_s i_buf;
-    struct sbuf_f32_s v_buf;
-    struct sbuf_f32_s p_buf;
+    struct jsdrv_power_align_s * power_align;  // h/power/window
+    uint32_t power_overrun;   // the last published h/power/overrun
+    struct jsdrv_host_stats_s host_stats;
+    bool host_stats_enable;
+    uint32_t host_stats_hop;  // 0 for tumbling
+    struct jsdrv_gate_s * gate;  // h/gate/mask, h/gate/level
+    uint8_t gate_level;       // h/gate/level
+    uint32_t gate_overrun;    // the last published h/gate/overrun
+    struct jsdrv_trigger_s triggers[JSDRV_TRIGGER_COUNT];
+    struct jsdrv_proc_s procs[JSDRV_PROC_SIGNAL_COUNT];
+    struct jsdrv_topic_index_s host_param_index;
+    uint16_t host_param_index_storage[HOST_PARAMS_MAX];
+    struct jsdrv_topic_index_s port_ctrl_index;
+    uint16_t port_ctrl_index_storage[JSDRV_ARRAY_SIZE(PORT_MAP)];
+    uint32_t port_decode[1 + JS220_PORT_DECODE_SIZE_MAX / sizeof(uint32_t)];  // sample_id + decoded samples
 
     // memory operations
     struct js220_port3_header_s mem_hdr;
     uint32_t mem_offset_valid;  // offset for completed mem_data.
     uint32_t mem_offset_sent;   // offset for write sent mem_data.
     uint8_t * mem_data;         // read/write data
+    FILE * mem_file;            // write data streamed from a file, when not mem_data
     struct jsdrv_topic_s mem_topic;
+    uint32_t mem_hash[JSDRV_CALIBRATION_HASH_U32_SIZE];  // verify image hash
+    bool mem_verify;            // read back compares with the image
 };
 
 const char * MEM_C[] = {"app", "upd1", "upd2", "storage", "log", "acfg", "bcfg", "pers", NULL};
@@ -308,6 +468,7 @@ const uint8_t MEM_S_U8[] = {
 JSDRV_STATIC_ASSERT(JSDRV_ARRAY_SIZE(MEM_S) == JSDRV_ARRAY_SIZE(MEM_S_U8), mem_s_arrays);
 
 static bool handle_rsp(struct dev_s * d, struct jsdrvp_msg_s * msg);
+static void on_power(void * user_data, uint64_t sample_id, const float * i, const float * v, float * p, uint32_t count);
 
 static const char * prefix_match_and_strip(const char * prefix, const char * topic) {
     while (*prefix) {
@@ -323,23 +484,30 @@ static const char * prefix_match_and_strip(const char * prefix, const char * top
 
 typedef bool (*msg_filter_fn)(void * user_data, struct dev_s * d, struct jsdrvp_msg_s * msg);
 
-static bool msg_filter_none(void * user_data, struct dev_s * d, struct jsdrvp_msg_s * msg) {
-    (void) user_data;
-    (void) d;
-    (void) msg;
-    return false;
-}
-
 static bool msg_filter_by_topic(void * user_data, struct dev_s * d, struct jsdrvp_msg_s * msg) {
     (void) d;
     const char * topic = (const char *) user_data;
     return (0 == strcmp(msg->topic, topic));
 }
 
+static void bulk_out_flush(struct dev_s * d) {
+    if (d->bulk_out_pack) {
+        JSDRV_LOGD2("bulk_out_flush %d bytes", (int) d->bulk_out_pack->value.size);
+        msg_queue_push(d->ll.cmd_q, d->bulk_out_pack);
+        d->bulk_out_pack = NULL;
+    }
+}
+
+static void ll_send(struct dev_s * d, struct jsdrvp_msg_s * m) {
+    bulk_out_flush(d);  // preserve command order
+    msg_queue_push(d->ll.cmd_q, m);
+}
+
 static struct jsdrvp_msg_s * ll_await(struct dev_s * d, msg_filter_fn filter_fn, void * filter_user_data, uint32_t timeout_ms) {
     uint32_t t_now = jsdrv_time_ms_u32();
     uint32_t t_end = t_now + timeout_ms;
     d->ll_await_break = false;
+    bulk_out_flush(d);
 
     while (!d->ll_await_break && !d->do_exit) {
 #if _WIN32
@@ -351,7 +519,7 @@ static struct jsdrvp_msg_s * ll_await(struct dev_s * d, msg_filter_fn filter_fn,
             .events = POLLIN,
             .revents = 0,
         };
-        poll(&fds, 1, 2);
+        poll(&fds, 1, (int) timeout_ms);
 #endif
         struct jsdrvp_msg_s * m = msg_queue_pop_immediate(d->ll.rsp_q);
         if (m) {
@@ -392,7 +560,7 @@ static int32_t jsdrvb_ctrl_out(struct dev_s * d, usb_setup_t setup, const void *
     memcpy(m->payload.bin, buffer, setup.s.wLength);
     m->value.size = setup.s.wLength;
 
-    msg_queue_push(d->ll.cmd_q, m);
+    ll_send(d, m);
     m = ll_await_topic(d, JSDRV_USBBK_MSG_CTRL_OUT, TIMEOUT_MS);
     if (!m) {
         JSDRV_LOGW("ctrl_out timed out");
@@ -403,22 +571,24 @@ static int32_t jsdrvb_ctrl_out(struct dev_s * d, usb_setup_t setup, const void *
 }
 #endif
 
-static int32_t jsdrvb_ctrl_in(struct dev_s * d, usb_setup_t setup, void * buffer, uint32_t * size) {
-    int32_t rv = 0;
+static void jsdrvb_ctrl_in_send(struct dev_s * d, usb_setup_t setup) {
     struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(d->context);
     jsdrv_cstr_copy(m->topic, JSDRV_USBBK_MSG_CTRL_IN, sizeof(m->topic));
     m->value.type = JSDRV_UNION_BIN;
     m->value.value.bin = m->payload.bin;
     m->value.app = JSDRV_PAYLOAD_TYPE_USB_CTRL;
     m->extra.bkusb_ctrl.setup = setup;
+    ll_send(d, m);
+}
 
-    msg_queue_push(d->ll.cmd_q, m);
-    m = ll_await_topic(d, JSDRV_USBBK_MSG_CTRL_IN, TIMEOUT_MS);
+// Complete a control in transaction, NULL m for timeout.  Frees m.
+static int32_t jsdrvb_ctrl_in_rsp(struct dev_s * d, struct jsdrvp_msg_s * m, uint16_t length, void * buffer, uint32_t * size) {
+    int32_t rv = 0;
     if (!m) {
         JSDRV_LOGW("ctrl_in timed out");
         return JSDRV_ERROR_TIMED_OUT;
     }
-    if (m->value.size > setup.s.wLength) {
+    if (m->value.size > length) {
         JSDRV_LOGW("ctrl_in returned too much data");
         rv = JSDRV_ERROR_TOO_BIG;
     } else {
@@ -431,13 +601,22 @@ static int32_t jsdrvb_ctrl_in(struct dev_s * d, usb_setup_t setup, void * buffer
     return rv;
 }
 
-static int32_t jsdrvb_bulk_in_stream_open(struct dev_s * d) {
-    int32_t rv = 0;
+static void jsdrvb_bulk_in_stream_open_send(struct dev_s * d) {
     struct jsdrvp_msg_s * m;
     m = jsdrvp_msg_alloc_value(d->context, JSDRV_USBBK_MSG_BULK_IN_STREAM_OPEN, &jsdrv_union_i32(0));
     m->extra.bkusb_stream.endpoint = JS220_USB_EP_BULK_IN;
-    msg_queue_push(d->ll.cmd_q, m);
-    m = ll_await_topic(d, JSDRV_USBBK_MSG_BULK_IN_STREAM_OPEN, TIMEOUT_MS);
+    m->extra.bkusb_stream.transfer_depth = d->bulk_in_depth;
+    m->extra.bkusb_stream.transfer_depth_max = d->bulk_in_depth_max;
+    d->bulk_in_depth_actual = 0;  // publish on the first data
+    d->bulk_in_skip = false;
+    m->extra.bkusb_stream.transfer_size = d->bulk_in_size;
+    m->extra.bkusb_stream.transfer_spare = d->bulk_in_spare;
+    ll_send(d, m);
+}
+
+// Complete the bulk in stream open, NULL m for timeout.  Frees m.
+static int32_t jsdrvb_bulk_in_stream_open_rsp(struct dev_s * d, struct jsdrvp_msg_s * m) {
+    int32_t rv = 0;
     if (!m) {
         JSDRV_LOGW("jsdrvb_bulk_in_stream_open timed out");
         return JSDRV_ERROR_TIMED_OUT;
@@ -460,13 +639,39 @@ static struct jsdrvp_msg_s * bulk_out_factory(struct dev_s * d, uint8_t port_id,
     return m;
 }
 
+static uint8_t * bulk_out_pack_frame(struct dev_s * d) {
+    struct jsdrvp_msg_s * m = d->bulk_out_pack;
+    if (m && (m->value.size > ((BULK_OUT_PACK_FRAMES - 1) * FRAME_SIZE_BYTES))) {
+        bulk_out_flush(d);
+        m = NULL;
+    }
+    if (NULL == m) {
+        m = jsdrvp_msg_alloc_data_sz(d->context, JSDRV_USBBK_MSG_BULK_OUT_DATA, BULK_OUT_PACK_FRAMES * FRAME_SIZE_BYTES);
+        m->extra.bkusb_stream.endpoint = JS220_USB_EP_BULK_OUT;
+        d->bulk_out_pack = m;
+    } else {
+        // Pad to the frame boundary so that each frame is its own USB packet.
+        uint32_t sz = ((m->value.size + FRAME_SIZE_BYTES - 1) / FRAME_SIZE_BYTES) * FRAME_SIZE_BYTES;
+        memset(m->payload.bin + m->value.size, 0, sz - m->value.size);
+        m->value.size = sz;
+    }
+    uint8_t * frame = m->payload.bin + m->value.size;
+    uint32_t * p_u32 = (uint32_t *) frame;
+    *p_u32 = js220_frame_hdr_pack(d->out_frame_id++, 0, 1);
+    m->value.size += sizeof(uint32_t);
+    return frame;
+}
+
 static int32_t bulk_out_publish(struct dev_s * d, const char * topic, const struct jsdrv_union_s * value) {
     uint16_t length = sizeof(struct js220_publish_s);
-    struct jsdrvp_msg_s * m = bulk_out_factory(d, 1, 0);
-    struct js220_publish_s * p = (struct js220_publish_s *) &m->payload.bin[4];
-    char buf[32];
-    jsdrv_union_value_to_str(value, buf, (uint32_t) sizeof(buf), 1);
-    JSDRV_LOGD1("publish to dev %s %s", topic, buf);
+    uint8_t * frame = bulk_out_pack_frame(d);
+    struct jsdrvp_msg_s * m = d->bulk_out_pack;
+    struct js220_publish_s * p = (struct js220_publish_s *) &frame[4];
+    if (JSDRV_LOG_ENABLED(JSDRV_LOG_LEVEL_DEBUG1)) {
+        char buf[32];
+        jsdrv_union_value_to_str(value, buf, (uint32_t) sizeof(buf), 1);
+        JSDRV_LOGD1("publish to dev %s %s", topic, buf);
+    }
     memset(p, 0, sizeof(*p) + sizeof(union jsdrv_union_inner_u));
     jsdrv_cstr_copy(p->topic, topic, sizeof(p->topic));
     p->type = value->type;
@@ -491,24 +696,29 @@ static int32_t bulk_out_publish(struct dev_s * d, const char * topic, const stru
         length += (uint16_t) sizeof(uint64_t);
     }
     m->value.size += length;
-    struct js220_frame_hdr_s * hdr = (struct js220_frame_hdr_s *) &m->payload.bin[0];
+    struct js220_frame_hdr_s * hdr = (struct js220_frame_hdr_s *) frame;
     hdr->length += length;
-    msg_queue_push(d->ll.cmd_q, m);
     return 0;
 }
 
+static void backend_send(struct dev_s * d, struct jsdrvp_msg_s * m) {
+    m->qos = d->qos;
+    jsdrvp_backend_send(d->context, m);
+}
+
 static void send_to_frontend(struct dev_s * d, const char * subtopic, const struct jsdrv_union_s * value) {
     struct jsdrvp_msg_s * m;
     m = jsdrvp_msg_alloc_value(d->context, "", value);
     tfp_snprintf(m->topic, sizeof(m->topic), "%s/%s", d->ll.prefix, subtopic);
-    jsdrvp_backend_send(d->context, m);
+    backend_send(d, m);
 }
 
 static int32_t send_return_code_to_frontend(struct dev_s * d, const char * subtopic, int32_t rc) {
     struct jsdrvp_msg_s * m;
-    m = jsdrvp_msg_alloc_value(d->context, "", &jsdrv_union_i32(rc));
+    m = jsdrvp_msg_alloc_small(d->context);
+    m->value = jsdrv_union_i32(rc);
     tfp_snprintf(m->topic, sizeof(m->topic), "%s/%s%c", d->ll.prefix, subtopic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
-    jsdrvp_backend_send(d->context, m);
+    backend_send(d, m);
     return rc;
 }
 
@@ -517,17 +727,22 @@ static void update_state(struct dev_s * d, enum state_e state) {
     send_to_frontend(d, "h/state", &jsdrv_union_u32_r(d->state));
 }
 
-static int32_t d_ctrl_req(struct dev_s * d, uint8_t op) {
-    uint8_t buf_in[1];
+static void d_ctrl_req_send(struct dev_s * d, uint8_t op) {
     usb_setup_t setup = { .s = {
             .bmRequestType = USB_REQUEST_TYPE(IN, VENDOR, DEVICE),
             .bRequest = op,
             .wValue = 0,
             .wIndex = 0,
-            .wLength = sizeof(buf_in),
+            .wLength = 1,
     }};
+    jsdrvb_ctrl_in_send(d, setup);
+}
+
+// Complete a control request, NULL m for timeout.  Frees m.
+static int32_t d_ctrl_rsp(struct dev_s * d, uint8_t op, struct jsdrvp_msg_s * m) {
+    uint8_t buf_in[1];
     uint32_t sz = 0;
-    int32_t rv = jsdrvb_ctrl_in(d, setup, buf_in, &sz);
+    int32_t rv = jsdrvb_ctrl_in_rsp(d, m, sizeof(buf_in), buf_in, &sz);
     if (rv) {
         goto exit;
     }
@@ -543,72 +758,64 @@ exit:
     return rv;
 }
 
-static int32_t ll_await_pubsub_topic(struct dev_s * d, const char * topic, uint32_t timeout_ms) {
-    jsdrv_cstr_copy(d->ll_await_break_topic, topic, sizeof(d->ll_await_break_topic));
-    d->ll_await_break_on = BREAK_PUBSUB_TOPIC;
-    ll_await(d, msg_filter_none, NULL, timeout_ms);
-    if (!d->ll_await_break) {
-        JSDRV_LOGE("ll_await_pubsub_topic(%s) timed out", topic);
-        return JSDRV_ERROR_TIMED_OUT;
-    }
-    return 0;
+static int32_t d_ctrl_req(struct dev_s * d, uint8_t op) {
+    d_ctrl_req_send(d, op);
+    return d_ctrl_rsp(d, op, ll_await_topic(d, JSDRV_USBBK_MSG_CTRL_IN, TIMEOUT_MS));
 }
 
-static int32_t ping_wait(struct dev_s * d, uint32_t value) {
-    JSDRV_LOGD1("ping_wait(%" PRIu32 ")", value);
-    bulk_out_publish(d, JS220_TOPIC_PING, &jsdrv_union_u32(value));
-
-    if (!ll_await_pubsub_topic(d, JS220_TOPIC_PONG, 1000)) {
-        if ((d->ll_await_break_value.type != JSDRV_UNION_U32) || (d->ll_await_break_value.value.u32 != value)) {
-            JSDRV_LOGW("ping_wait value mismatch: send=%" PRIu32 ", recv=%" PRIu32,
-                     value, d->ll_await_break_value.value.u32);
-        } else {
-            JSDRV_LOGD1("ping_wait(%" PRIu32 ") done", value);
+static void port_taps_free(struct dev_s * d, struct port_s * p) {
+    for (uint32_t idx = 0; idx < JSDRV_TAP_COUNT; ++idx) {
+        struct port_tap_s * t = &p->taps[idx];
+        if (NULL != t->msg_in) {
+            jsdrvp_msg_free(d->context, t->msg_in);
+            t->msg_in = NULL;
         }
-        return 0;
-    } else {
-        JSDRV_LOGW("ping_wait(%" PRIu32 ") timed out", value);
-        return JSDRV_ERROR_TIMED_OUT;
+        jsdrv_tap_finalize(&t->tap);
     }
 }
 
-static int32_t wait_for_connect(struct dev_s * d) {
-    // only allowed response at this time is BULK IN, port 0, JS220_PORT0_OP_CONNECT
-    // however, process all to be robust
-    d->ll_await_break_on = BREAK_CONNECT;
-    ll_await(d, msg_filter_none, NULL, 1000);
-    if (!d->ll_await_break) {
-        JSDRV_LOGE("OP_CONNECT timed out");
-        return JSDRV_ERROR_TIMED_OUT;
+static void frame_free(struct dev_s * d) {
+    if (NULL != d->frame_msg) {
+        jsdrvp_msg_free(d->context, d->frame_msg);
+        d->frame_msg = NULL;
     }
-    return 0;
+    jsdrv_framer_free(d->framer);
+    d->framer = NULL;
+    d->frame_port_mask = 0;
 }
 
-static int32_t d_open_ll(struct dev_s * d, int32_t opt) {
-    JSDRV_LOGI("open_ll(opt=%d)", opt);
-    int32_t rc;
-    d->ll_await_break_on = BREAK_NONE;
+static void port_downsample_switch(struct port_s * p) {
+    jsdrv_downsample_free(p->downsample);
+    p->downsample = p->downsample_next;
+    p->downsample_next = NULL;
+    p->downsample_pending = false;
+    p->downsample_prime = 0;
+}
 
-    if (d->state == ST_OPEN) {
-        JSDRV_LOGE("open_ll but already open");
-        return JSDRV_ERROR_IN_USE;
-    }
-    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(d->context, JSDRV_MSG_OPEN, &jsdrv_union_i32(opt & 1));
-    msg_queue_push(d->ll.cmd_q, m);
-    m = ll_await_topic(d, JSDRV_MSG_OPEN, TIMEOUT_MS);
-    if (!m) {
-        JSDRV_LOGE("open_ll timed out");
-        return JSDRV_ERROR_TIMED_OUT;
-    }
-    update_state(d, ST_OPENING);
-    rc = m->value.value.i32;
-    jsdrvp_msg_free(d->context, m);
-    if (rc) {
-        JSDRV_LOGE("open_ll failed");
-        update_state(d, ST_CLOSED);
-        return rc;
+static void port_downsample_cancel(struct port_s * p) {
+    jsdrv_downsample_free(p->downsample_next);
+    p->downsample_next = NULL;
+    p->downsample_pending = false;
+    p->downsample_prime = 0;
+}
+
+/*
+ * Change the host downsampling for a port without interrupting its
+ * stream.  The new chain primes on the same input as the current
+ * chain until its filter history contains only real samples, then
+ * stream_in_port() switches at the next frame boundary.  Idle ports
+ * switch immediately.
+ */
+static void port_downsample_next(struct dev_s * d, uint32_t idx, struct jsdrv_downsample_s * downsample) {
+    struct port_s * p = &d->ports[idx];
+    port_downsample_cancel(p);
+    p->downsample_next = downsample;
+    p->downsample_pending = true;
+    if (0 == (d->stream_in_port_enable & (0x00010000U << idx))) {
+        port_downsample_switch(p);
+    } else {
+        p->downsample_prime = 2 * jsdrv_downsample_sample_delay(downsample);
     }
-    return 0;
 }
 
 static void d_reset(struct dev_s * d) {
@@ -616,18 +823,27 @@ static void d_reset(struct dev_s * d) {
     d->in_frame_id = 0;
     d->in_frame_count = 0;
     d->stream_in_port_enable = 0;
+    if (NULL != d->framer) {
+        jsdrv_framer_clear(d->framer);
+    }
 
     d->ll_await_break_on = BREAK_NONE;
     d->ll_await_break = false;
-    sbuf_f32_clear(&d->i_buf);
-    sbuf_f32_clear(&d->v_buf);
-    sbuf_f32_clear(&d->p_buf);
-    d->ports[0x0f & PORT_ID_CURRENT].buf = &d->i_buf;
-    d->ports[0x0f & PORT_ID_VOLTAGE].buf = &d->v_buf;
-    d->ports[0x0f & PORT_ID_POWER].buf = &d->p_buf;
+    jsdrv_power_align_clear(d->power_align);
+    jsdrv_host_stats_initialize(&d->host_stats, SAMPLING_FREQUENCY, 2);
+    d->host_stats_enable = false;
+    d->host_stats_hop = 0;
+    jsdrv_gate_clear(d->gate);
+    for (uint32_t idx = 0; idx < JSDRV_TRIGGER_COUNT; ++idx) {
+        jsdrv_trigger_clear(&d->triggers[idx]);
+    }
+    for (uint32_t idx = 0; idx < JSDRV_PROC_SIGNAL_COUNT; ++idx) {
+        jsdrv_proc_clear(&d->procs[idx]);
+    }
 
     for (uint32_t idx = 0; idx < (PORTS_LENGTH - 2); ++idx) {
         struct port_s *p = &d->ports[idx];
+        port_downsample_cancel(p);
         if (p->downsample) {
             jsdrv_downsample_free(p->downsample);
             p->downsample = NULL;
@@ -637,6 +853,7 @@ static void d_reset(struct dev_s * d) {
             jsdrvp_msg_free(d->context, p->msg_in);
             p->msg_in = NULL;
         }
+        port_taps_free(d, p);
         p->decimate_factor = PORT_MAP[idx].decimate_min;
     }
 
@@ -645,61 +862,6 @@ static void d_reset(struct dev_s * d) {
 }
 
 
-static int32_t d_open(struct dev_s * d, int32_t opt) {
-    JSDRV_LOGI("open(opt=%d)", opt);
-    int32_t rc;
-    rc = d_ctrl_req(d, JS220_CTRL_OP_DISCONNECT);
-    if (rc) {
-        JSDRV_LOGI("jsdrvb_bulk_in_stream_open disconnect: %d", rc);
-        // ok, just continue on.
-    }
-
-    d_reset(d);
-    d->stream_in_port_enable = 0x000f;  // always enable ports 0, 1, 2, 3
-    rc = jsdrvb_bulk_in_stream_open(d);
-    if (rc) {
-        d->stream_in_port_enable = 0;
-        JSDRV_LOGE("jsdrvb_bulk_in_stream_open failed: %d", rc);
-        return rc;
-    }
-
-    JSDRV_RETURN_ON_ERROR(d_ctrl_req(d, JS220_CTRL_OP_CONNECT));
-
-    if (JSDRV_DEVICE_OPEN_MODE_RAW != opt) {  // normal operation
-        JSDRV_RETURN_ON_ERROR(wait_for_connect(d));
-        JSDRV_LOGD1("query metadata");
-        JSDRV_RETURN_ON_ERROR(bulk_out_publish(d, "$", &jsdrv_union_null()));
-        JSDRV_RETURN_ON_ERROR(ping_wait(d, 1));
-        if (JSDRV_DEVICE_OPEN_MODE_RESUME == opt) {
-            struct jsdrv_topic_s topic;
-            jsdrv_topic_set(&topic, d->ll.prefix);
-            jsdrv_topic_append(&topic, "h");
-
-            JSDRV_LOGD1("query values from instrument");
-            JSDRV_RETURN_ON_ERROR(bulk_out_publish(d, "?", &jsdrv_union_null()));
-            JSDRV_RETURN_ON_ERROR(ping_wait(d, 2));
-
-            JSDRV_LOGD1("query host-side values from pubsub");
-            jsdrvp_device_subscribe(d->context, d->ll.prefix, topic.topic, JSDRV_SFLAG_RETAIN | JSDRV_SFLAG_PUB);
-            jsdrvp_device_unsubscribe(d->context, d->ll.prefix, topic.topic, JSDRV_SFLAG_RETAIN | JSDRV_SFLAG_PUB);
-        } else if (JSDRV_DEVICE_OPEN_MODE_DEFAULTS == opt) {
-            // todo publish metadata defaults to device
-            // subscribe retained for self
-            // publish ping to PubSub
-            // publish retained to device
-            // on pong, unsubscribe
-        } else {
-            JSDRV_LOGW("invalid open mode: %d", opt);
-        }
-    } else {
-        send_to_frontend(d, "h/!reset$", &jsdrv_union_cjson_r(reset_meta));
-    }
-
-    JSDRV_LOGI("open complete");
-    update_state(d, ST_OPEN);
-    return 0;
-}
-
 static int32_t d_close(struct dev_s * d) {
     int32_t rv = 0;
     JSDRV_LOGI("close");
@@ -707,7 +869,7 @@ static int32_t d_close(struct dev_s * d) {
         d->stream_in_port_enable = 0;  // disable all ports
         d_ctrl_req(d, JS220_CTRL_OP_DISCONNECT);  // ignore errors
         struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(d->context, JSDRV_MSG_CLOSE, &jsdrv_union_i32(0));
-        msg_queue_push(d->ll.cmd_q, m);
+        ll_send(d, m);
         m = ll_await_topic(d, JSDRV_MSG_CLOSE, 1000);
         if (!m) {
             rv = JSDRV_ERROR_TIMED_OUT;
@@ -724,6 +886,7 @@ static int32_t d_close(struct dev_s * d) {
                 jsdrvp_msg_free(d->context, p->msg_in);
                 p->msg_in = NULL;
             }
+            port_taps_free(d, p);
         }
         update_state(d, ST_CLOSED);
         d_reset(d);
@@ -731,6 +894,206 @@ static int32_t d_close(struct dev_s * d) {
     return rv;
 }
 
+static void open_step(struct dev_s * d, uint8_t step, uint32_t timeout_ms) {
+    JSDRV_LOGD1("open step %d", (int) step);
+    d->open_step = step;
+    d->open_deadline_ms = jsdrv_time_ms_u32() + timeout_ms;
+    bulk_out_flush(d);
+}
+
+static void open_complete(struct dev_s * d, int32_t rc) {
+    d->open_step = OPEN_STEP_IDLE;
+    d->ll_await_break_on = BREAK_NONE;
+    if (rc) {
+        JSDRV_LOGE("open failed: %d", rc);
+        d_close(d);
+    } else {
+        JSDRV_LOGI("open complete");
+        update_state(d, ST_OPEN);
+    }
+    send_to_frontend(d, JSDRV_MSG_OPEN "#", &jsdrv_union_i32(rc));
+}
+
+static void open_await_pubsub_topic(struct dev_s * d, const char * topic) {
+    jsdrv_cstr_copy(d->ll_await_break_topic, topic, sizeof(d->ll_await_break_topic));
+    d->ll_await_break = false;
+    d->ll_await_break_on = BREAK_PUBSUB_TOPIC;
+}
+
+// Finish the open after the instrument answers the metadata query.
+static void open_finish(struct dev_s * d) {
+    int32_t opt = d->open_opt;
+    if ((d->ll_await_break_value.type != JSDRV_UNION_U32) || (d->ll_await_break_value.value.u32 != 1)) {
+        JSDRV_LOGW("ping value mismatch: send=1, recv=%" PRIu32, d->ll_await_break_value.value.u32);
+    }
+    if (JSDRV_DEVICE_OPEN_MODE_RESUME == opt) {
+        struct jsdrv_topic_s topic;
+        jsdrv_topic_set(&topic, d->ll.prefix);
+        jsdrv_topic_append(&topic, "h");
+
+        JSDRV_LOGD1("query host-side values from pubsub");
+        jsdrvp_device_subscribe(d->context, d->ll.prefix, topic.topic, JSDRV_SFLAG_RETAIN | JSDRV_SFLAG_PUB);
+        jsdrvp_device_unsubscribe(d->context, d->ll.prefix, topic.topic, JSDRV_SFLAG_RETAIN | JSDRV_SFLAG_PUB);
+    } else if (JSDRV_DEVICE_OPEN_MODE_DEFAULTS == opt) {
+        // todo publish metadata defaults to device
+        // subscribe retained for self
+        // publish ping to PubSub
+        // publish retained to device
+        // on pong, unsubscribe
+    } else {
+        JSDRV_LOGW("invalid open mode: %d", opt);
+    }
+    open_complete(d, 0);
+}
+
+/**
+ * @brief Advance the pending open operation.
+ *
+ * @param d The device.
+ * @param m The lower-level response for the current step, or NULL
+ *      to check the port 0 and pubsub completion flags.
+ * @return True if m was consumed, false to process m normally.
+ *
+ * The open proceeds as a sequence of non-blocking steps so that the
+ * device thread continues to process stream data and the commands
+ * that are allowed while closed.  Each step has a deadline, see
+ * open_timeout_ms() and open_expire().
+ */
+static bool open_advance(struct dev_s * d, struct jsdrvp_msg_s * m) {
+    int32_t rc;
+    int32_t opt = d->open_opt;
+    switch (d->open_step) {
+        case OPEN_STEP_LL:
+            if (!m || (0 != strcmp(JSDRV_MSG_OPEN, m->topic))) {
+                return false;
+            }
+            update_state(d, ST_OPENING);
+            rc = m->value.value.i32;
+            jsdrvp_msg_free(d->context, m);
+            if (rc) {
+                JSDRV_LOGE("open_ll failed");
+                d->open_step = OPEN_STEP_IDLE;
+                update_state(d, ST_CLOSED);
+                send_to_frontend(d, JSDRV_MSG_OPEN "#", &jsdrv_union_i32(rc));
+                return true;
+            }
+            d_ctrl_req_send(d, JS220_CTRL_OP_DISCONNECT);
+            open_step(d, OPEN_STEP_DISCONNECT, TIMEOUT_MS);
+            return true;
+
+        case OPEN_STEP_DISCONNECT:
+            if (!m || (0 != strcmp(JSDRV_USBBK_MSG_CTRL_IN, m->topic))) {
+                return false;
+            }
+            rc = d_ctrl_rsp(d, JS220_CTRL_OP_DISCONNECT, m);
+            if (rc) {
+                JSDRV_LOGI("jsdrvb_bulk_in_stream_open disconnect: %d", rc);
+                // ok, just continue on.
+            }
+            d_reset(d);
+            d->stream_in_port_enable = 0x000f;  // always enable ports 0, 1, 2, 3
+            jsdrvb_bulk_in_stream_open_send(d);
+            open_step(d, OPEN_STEP_STREAM, TIMEOUT_MS);
+            return true;
+
+        case OPEN_STEP_STREAM:
+            if (!m || (0 != strcmp(JSDRV_USBBK_MSG_BULK_IN_STREAM_OPEN, m->topic))) {
+                return false;
+            }
+            rc = jsdrvb_bulk_in_stream_open_rsp(d, m);
+            if (rc) {
+                d->stream_in_port_enable = 0;
+                JSDRV_LOGE("jsdrvb_bulk_in_stream_open failed: %d", rc);
+                open_complete(d, rc);
+                return true;
+            }
+            if (JSDRV_DEVICE_OPEN_MODE_RAW != opt) {
+                d->ll_await_break = false;
+                d->ll_await_break_on = BREAK_CONNECT;  // set before the response can arrive
+            }
+            d_ctrl_req_send(d, JS220_CTRL_OP_CONNECT);
+            open_step(d, OPEN_STEP_CONNECT, TIMEOUT_MS);
+            return true;
+
+        case OPEN_STEP_CONNECT:
+            if (!m || (0 != strcmp(JSDRV_USBBK_MSG_CTRL_IN, m->topic))) {
+                return false;
+            }
+            rc = d_ctrl_rsp(d, JS220_CTRL_OP_CONNECT, m);
+            if (rc) {
+                open_complete(d, rc);
+            } else if (JSDRV_DEVICE_OPEN_MODE_RAW == opt) {
+                send_to_frontend(d, "h/!reset$", &jsdrv_union_cjson_r(reset_meta));
+                open_complete(d, 0);
+            } else {
+                open_step(d, OPEN_STEP_WAIT_CONNECT, TIMEOUT_MS);
+                open_advance(d, NULL);  // port 0 connect may already be processed
+            }
+            return true;
+
+        case OPEN_STEP_WAIT_CONNECT:
+            if (m || !d->ll_await_break) {
+                return false;
+            }
+            JSDRV_LOGD1("query metadata");
+            bulk_out_publish(d, "$", &jsdrv_union_null());
+            if (JSDRV_DEVICE_OPEN_MODE_RESUME == opt) {
+                // pipeline the value query, the instrument responds in order
+                JSDRV_LOGD1("query values from instrument");
+                bulk_out_publish(d, "?", &jsdrv_union_null());
+            }
+            open_await_pubsub_topic(d, JS220_TOPIC_PONG);
+            bulk_out_publish(d, JS220_TOPIC_PING, &jsdrv_union_u32(1));
+            open_step(d, OPEN_STEP_PING, TIMEOUT_MS);
+            return true;
+
+        case OPEN_STEP_PING:
+            if (m || !d->ll_await_break) {
+                return false;
+            }
+            open_finish(d);
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+static void open_start(struct dev_s * d, int32_t opt) {
+    JSDRV_LOGI("open(opt=%d)", opt);
+    d->ll_await_break_on = BREAK_NONE;
+    if (d->state == ST_OPEN) {
+        JSDRV_LOGE("open_ll but already open");
+        send_to_frontend(d, JSDRV_MSG_OPEN "#", &jsdrv_union_i32(JSDRV_ERROR_IN_USE));
+        return;
+    }
+    d->open_opt = opt;
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(d->context, JSDRV_MSG_OPEN, &jsdrv_union_i32(opt & 1));
+    ll_send(d, m);
+    open_step(d, OPEN_STEP_LL, TIMEOUT_MS);
+}
+
+// The milliseconds until the current open step times out, -1 for none.
+static int32_t open_timeout_ms(struct dev_s * d) {
+    if (OPEN_STEP_IDLE == d->open_step) {
+        return -1;
+    }
+    uint32_t remaining = d->open_deadline_ms - jsdrv_time_ms_u32();
+    return (remaining > (1U << 31U)) ? 0 : (int32_t) remaining;
+}
+
+static void open_expire(struct dev_s * d) {
+    if ((OPEN_STEP_IDLE != d->open_step) && (0 == open_timeout_ms(d))) {
+        JSDRV_LOGW("open step %d timed out", (int) d->open_step);
+        if (OPEN_STEP_LL == d->open_step) {
+            d->open_step = OPEN_STEP_IDLE;
+            send_to_frontend(d, JSDRV_MSG_OPEN "#", &jsdrv_union_i32(JSDRV_ERROR_TIMED_OUT));
+        } else {
+            open_complete(d, JSDRV_ERROR_TIMED_OUT);
+        }
+    }
+}
+
 static bool has_on_instrument_downsample(struct dev_s * d) {
     return (
             (d->port0_connect.fw_version >= (JSDRV_VERSION_ENCODE_U32(1, 3, 0)))
@@ -748,15 +1111,118 @@ static bool is_ivp_enabled(struct dev_s * d) {
     return (COMPUTE_POWER_MASK == (COMPUTE_POWER_MASK & d->stream_in_port_enable));
 }
 
+static struct jsdrv_proc_s * port_proc(struct dev_s * d, uint8_t port_id) {
+    switch (port_id) {
+        case PORT_ID_CURRENT: return &d->procs[JSDRV_PROC_SIGNAL_CURRENT];
+        case PORT_ID_VOLTAGE: return &d->procs[JSDRV_PROC_SIGNAL_VOLTAGE];
+        case PORT_ID_POWER:   return &d->procs[JSDRV_PROC_SIGNAL_POWER];
+        default:              return NULL;
+    }
+}
+
 static void stream_reset_host_side(struct dev_s * d, size_t port_id) {
     struct port_s * p = &d->ports[port_id & 0x0f];
     if (NULL != p->msg_in) {
         jsdrvp_msg_free(d->context, p->msg_in);
         p->msg_in = NULL;
     }
-    sbuf_f32_clear(p->buf);
+    if (p->downsample_pending) {
+        port_downsample_switch(p);
+    }
     jsdrv_downsample_clear(p->downsample);
+    for (uint32_t idx = 0; idx < JSDRV_TAP_COUNT; ++idx) {
+        struct port_tap_s * t = &p->taps[idx];
+        if (NULL != t->msg_in) {
+            jsdrvp_msg_free(d->context, t->msg_in);
+            t->msg_in = NULL;
+        }
+        jsdrv_tap_clear(&t->tap);
+    }
+    struct jsdrv_proc_s * proc = port_proc(d, (uint8_t) port_id);
+    if (NULL != proc) {
+        jsdrv_proc_clear(proc);
+    }
     p->sample_id_next = 0;
+    if ((PORT_ID_CURRENT == port_id) || (PORT_ID_VOLTAGE == port_id) || (PORT_ID_POWER == port_id)) {
+        jsdrv_power_align_clear(d->power_align);
+        jsdrv_host_stats_clear(&d->host_stats);
+        jsdrv_gate_clear(d->gate);
+    } else if (JSDRV_FIELD_GPI == PORT_MAP[port_id & 0x0f].field_id) {
+        jsdrv_gate_clear(d->gate);
+    }
+    if (NULL != d->framer) {
+        jsdrv_framer_clear(d->framer);
+    }
+}
+
+/*
+ * Estimate the bulk in bytes per second for the ports in mask, a
+ * stream_in_port_enable value.  The estimate includes the frame and
+ * sample_id headers, and excludes power when the host computes it.
+ */
+static uint32_t stream_bandwidth(struct dev_s * d, uint32_t mask) {
+    const uint64_t frame_data = FRAME_SIZE_BYTES - 2 * sizeof(uint32_t);
+    uint64_t total = 0;
+    if ((COMPUTE_POWER_MASK == (COMPUTE_POWER_MASK & mask)) && !is_on_instrument_downsample_active(d)) {
+        mask &= ~(1U << PORT_ID_POWER);
+    }
+    for (uint32_t idx = 0; idx < PORTS_LENGTH; ++idx) {
+        uint32_t decimate = d->ports[idx].decimate_factor;
+        if ((0 == (mask & (0x00010000U << idx))) || (0 == decimate)) {
+            continue;
+        }
+        uint64_t data = ((uint64_t) SAMPLING_FREQUENCY * PORT_MAP[idx].element_size_bits) / (8U * decimate);
+        total += (data * FRAME_SIZE_BYTES + frame_data - 1) / frame_data;
+    }
+    return (total > UINT32_MAX) ? UINT32_MAX : (uint32_t) total;
+}
+
+static int32_t stream_bandwidth_check(struct dev_s * d, uint32_t mask) {
+    uint32_t bw = stream_bandwidth(d, mask);
+    if (d->usb_budget && (bw > d->usb_budget)) {
+        JSDRV_LOGW("%s stream %" PRIu32 " B/s exceeds h/usb/budget %" PRIu32 " B/s, reject",
+                   d->ll.prefix, bw, d->usb_budget);
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    if (bw > USB_BANDWIDTH_MAX) {
+        JSDRV_LOGW("%s stream %" PRIu32 " B/s exceeds USB capacity, expect skips", d->ll.prefix, bw);
+    }
+    return 0;
+}
+
+static void stream_bandwidth_publish(struct dev_s * d) {
+    uint32_t bw = stream_bandwidth(d, d->stream_in_port_enable);
+    if (bw != d->usb_bw) {
+        d->usb_bw = bw;
+        send_to_frontend(d, "h/usb/bw", &jsdrv_union_u32_r(bw));
+    }
+}
+
+// Publish the measured bulk in bytes per second about once per second while streaming.
+static void stream_rx_update(struct dev_s * d, uint32_t size) {
+    int64_t now = jsdrv_time_monotonic();
+    d->usb_rx_bytes += size;
+    if ((0 == d->usb_rx_time) || ((now - d->usb_rx_time) >= (2 * JSDRV_TIME_SECOND))) {
+        d->usb_rx_bytes = size;  // first data or resumed after idle
+        d->usb_rx_time = now;
+    } else if ((now - d->usb_rx_time) >= JSDRV_TIME_SECOND) {
+        uint64_t rate = (d->usb_rx_bytes * JSDRV_TIME_SECOND) / (uint64_t) (now - d->usb_rx_time);
+        send_to_frontend(d, "h/usb/rx", &jsdrv_union_u32_r((rate > UINT32_MAX) ? UINT32_MAX : (uint32_t) rate));
+        d->usb_rx_bytes = 0;
+        d->usb_rx_time = now;
+        uint64_t overrun = jsdrv_power_align_overrun(d->power_align);
+        uint32_t overrun_u32 = (overrun > UINT32_MAX) ? UINT32_MAX : (uint32_t) overrun;
+        if (overrun_u32 != d->power_overrun) {
+            d->power_overrun = overrun_u32;
+            send_to_frontend(d, "h/power/overrun", &jsdrv_union_u32_r(overrun_u32));
+        }
+        overrun = jsdrv_gate_overrun(d->gate);
+        overrun_u32 = (overrun > UINT32_MAX) ? UINT32_MAX : (uint32_t) overrun;
+        if (overrun_u32 != d->gate_overrun) {
+            d->gate_overrun = overrun_u32;
+            send_to_frontend(d, "h/gate/overrun", &jsdrv_union_u32_r(overrun_u32));
+        }
+    }
 }
 
 static void stream_suspend(struct dev_s * d) {
@@ -788,37 +1254,38 @@ static void stream_resume(struct dev_s * d) {
 
 static bool stream_in_port_enable(struct dev_s * d, const char * topic, bool enable) {
     bool was_enabled;
-    for (size_t i = 0; i < JSDRV_ARRAY_SIZE(PORT_MAP); ++i) {
-        if (PORT_MAP[i].ctrl_topic && (0 == strcmp(PORT_MAP[i].ctrl_topic, topic))) {
-            uint32_t mask = (0x00010000 << i);
-            was_enabled = (0 != (d->stream_in_port_enable & mask));
-            if (enable == was_enabled) {
-                JSDRV_LOGD1("stream_in_port_enable duplicate port %s %s",
-                            topic, (enable ? "on" : "off"));
-                return true;
-            }
-            stream_reset_host_side(d, i + 16);
-            if (enable) {
-                d->stream_in_port_enable |= mask;
-            } else {
-                d->stream_in_port_enable &= ~mask;
-            }
-            JSDRV_LOGD1("stream_in_port_enable port %s %s => 0x%08lx",
-                        topic, (enable ? "on" : "off"), d->stream_in_port_enable);
-
-            if ((PORT_MAP[i].field_id == JSDRV_FIELD_CURRENT)
-                    || (PORT_MAP[i].field_id == JSDRV_FIELD_VOLTAGE)
-                    || (PORT_MAP[i].field_id == JSDRV_FIELD_POWER)) {
-                if (is_ivp_enabled(d) && !is_on_instrument_downsample_active(d)) {
-                    // computer power on host
-                    bulk_out_publish(d, "s/p/ctrl", &jsdrv_union_u32_r(0));
-                    bulk_out_publish(d, "s/i/ctrl", &jsdrv_union_u32_r(1));
-                    bulk_out_publish(d, "s/v/ctrl", &jsdrv_union_u32_r(1));
-                    return false;
-                }
-            }
+    int32_t idx = jsdrv_topic_index_find(&d->port_ctrl_index, topic);
+    if (idx >= 0) {
+        uint32_t i = (uint32_t) idx;
+        uint32_t mask = (0x00010000 << i);
+        was_enabled = (0 != (d->stream_in_port_enable & mask));
+        if (enable == was_enabled) {
+            JSDRV_LOGD1("stream_in_port_enable duplicate port %s %s",
+                        topic, (enable ? "on" : "off"));
             return true;
         }
+        stream_reset_host_side(d, i + 16);
+        if (enable) {
+            d->stream_in_port_enable |= mask;
+        } else {
+            d->stream_in_port_enable &= ~mask;
+        }
+        JSDRV_LOGD1("stream_in_port_enable port %s %s => 0x%08lx",
+                    topic, (enable ? "on" : "off"), d->stream_in_port_enable);
+        stream_bandwidth_publish(d);
+
+        if ((PORT_MAP[i].field_id == JSDRV_FIELD_CURRENT)
+                || (PORT_MAP[i].field_id == JSDRV_FIELD_VOLTAGE)
+                || (PORT_MAP[i].field_id == JSDRV_FIELD_POWER)) {
+            if (is_ivp_enabled(d) && !is_on_instrument_downsample_active(d)) {
+                // computer power on host
+                bulk_out_publish(d, "s/p/ctrl", &jsdrv_union_u32_r(0));
+                bulk_out_publish(d, "s/i/ctrl", &jsdrv_union_u32_r(1));
+                bulk_out_publish(d, "s/v/ctrl", &jsdrv_union_u32_r(1));
+                return false;
+            }
+        }
+        return true;
     }
     JSDRV_LOGW("stream_in_port_enable port not found %s", topic);
     return false;
@@ -828,7 +1295,14 @@ static bool handle_cmd_ctrl(struct dev_s * d, const char * topic, const struct j
     bool v = false;
     if (jsdrv_cstr_ends_with(topic, "/ctrl")) {
         jsdrv_union_to_bool(value, &v);
-        if (stream_in_port_enable(d, topic, v)) {
+        int32_t idx = jsdrv_topic_index_find(&d->port_ctrl_index, topic);
+        int32_t rc = 0;
+        if (v && (idx >= 0)) {
+            rc = stream_bandwidth_check(d, d->stream_in_port_enable | (0x00010000U << idx));
+        }
+        if (rc) {
+            send_return_code_to_frontend(d, topic, rc);
+        } else if (stream_in_port_enable(d, topic, v)) {
             bulk_out_publish(d, topic, value);
         } else {
             struct jsdrv_topic_s t;
@@ -853,39 +1327,115 @@ static void handle_rsp_ctrl(struct dev_s * d, const char * topic, const struct j
     }
 }
 
+static void mem_release(struct dev_s * d) {
+    if (NULL != d->mem_data) {
+        jsdrv_free(d->mem_data);
+        d->mem_data = NULL;
+    }
+    if (NULL != d->mem_file) {
+        fclose(d->mem_file);
+        d->mem_file = NULL;
+    }
+}
+
 static int32_t mem_complete(struct dev_s * d, int32_t status) {
     JSDRV_LOGI("mem_complete(%d)", status);
     if (JS220_PORT3_OP_NONE == d->mem_hdr.op) {
         return status;
     }
 
-    if ((0 == status) && (JS220_PORT3_OP_READ_REQ == d->mem_hdr.op)) {
+    if ((0 == status) && (JS220_PORT3_OP_READ_REQ == d->mem_hdr.op) && !d->mem_verify) {
         struct jsdrv_topic_s topic;
         jsdrv_topic_set(&topic, d->mem_topic.topic);
         jsdrv_topic_remove(&topic);
         jsdrv_topic_append(&topic, "!rdata");
         JSDRV_LOGD1("%s with %d bytes", topic.topic, d->mem_hdr.length);
         struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(d->context, topic.topic, &jsdrv_union_bin(d->mem_data, d->mem_hdr.length));
-        jsdrvp_backend_send(d->context, m);
+        backend_send(d, m);
     }
 
     jsdrv_topic_suffix_add(&d->mem_topic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
     struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(d->context);
     m->value = jsdrv_union_i32(status);
     memcpy(m->topic, d->mem_topic.topic, d->mem_topic.length + 1);
-    jsdrvp_backend_send(d->context, m);
+    backend_send(d, m);
 
     jsdrv_topic_clear(&d->mem_topic);
-    memset(&d->mem_hdr, 0, sizeof(d->mem_topic));
+    memset(&d->mem_hdr, 0, sizeof(d->mem_hdr));
     d->mem_offset_valid = 0;
     d->mem_offset_sent = 0;
-    if (NULL != d->mem_data) {
-        jsdrv_free(d->mem_data);
-        d->mem_data = NULL;
-    }
+    d->mem_verify = false;
+    mem_release(d);
     return status;
 }
 
+static int32_t mem_file_open(struct dev_s * d, const char * path, uint32_t * size) {
+    FILE * fh = fopen(path, "rb");
+    if (NULL == fh) {
+        JSDRV_LOGW("write file open failed: %s", path);
+        return JSDRV_ERROR_NOT_FOUND;
+    }
+    long sz = -1;
+    if (0 == fseek(fh, 0, SEEK_END)) {
+        sz = ftell(fh);
+    }
+    if ((sz < 0) || fseek(fh, 0, SEEK_SET)) {
+        JSDRV_LOGW("write file size failed: %s", path);
+        fclose(fh);
+        return JSDRV_ERROR_IO;
+    }
+    if ((unsigned long) sz > MEM_SIZE_MAX) {
+        JSDRV_LOGW("write file too big: %ld > %d", sz, (int) MEM_SIZE_MAX);
+        fclose(fh);
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    d->mem_file = fh;
+    *size = (uint32_t) sz;
+    return 0;
+}
+
+// Get image bytes from mem_data, or read them from mem_file into buf.
+// File reads must be sequential.
+static const uint8_t * mem_image_get(struct dev_s * d, uint32_t offset, uint8_t * buf, uint32_t length) {
+    if (NULL == d->mem_file) {
+        return d->mem_data + offset;
+    }
+    if (fread(buf, 1, length, d->mem_file) != length) {
+        JSDRV_LOGW("image file read failed at offset %d", (int) offset);
+        return NULL;
+    }
+    return buf;
+}
+
+// Hash the image, padded with 0xff to the hash block size.
+static int32_t mem_image_hash(struct dev_s * d, uint32_t length) {
+    uint32_t buf[128];
+    jsdrv_calibration_hash_init(d->mem_hash);
+    for (uint32_t offset = 0; offset < length; offset += sizeof(buf)) {
+        uint32_t sz = length - offset;
+        if (sz > sizeof(buf)) {
+            sz = sizeof(buf);
+        }
+        const uint8_t * p = mem_image_get(d, offset, (uint8_t *) buf, sz);
+        if (NULL == p) {
+            return JSDRV_ERROR_IO;
+        }
+        uint32_t sz_pad = (sz + JSDRV_CALIBRATION_HASH_BLOCK_SIZE - 1) & ~(JSDRV_CALIBRATION_HASH_BLOCK_SIZE - 1);
+        if (sz_pad != sz) {
+            if (p != (uint8_t *) buf) {
+                memcpy(buf, p, sz);
+            }
+            memset(((uint8_t *) buf) + sz, 0xff, sz_pad - sz);
+            p = (uint8_t *) buf;
+        }
+        jsdrv_calibration_hash_update(d->mem_hash, offset, (const uint32_t *) p, sz_pad);
+    }
+    if ((NULL != d->mem_file) && fseek(d->mem_file, 0, SEEK_SET)) {
+        return JSDRV_ERROR_IO;
+    }
+    return 0;
+}
+
 static int32_t handle_cmd_mem(struct dev_s * d, struct jsdrvp_msg_s * msg) {
     struct jsdrv_topic_s topic_holder;
     const char * topic = prefix_match_and_strip(d->ll.prefix, msg->topic);
@@ -936,17 +1486,32 @@ static int32_t handle_cmd_mem(struct dev_s * d, struct jsdrvp_msg_s * msg) {
     m->hdr.region = table_u8[idx];
     if (0 == strcmp("!erase", mem_cmd_str)) {
         m->hdr.op = JS220_PORT3_OP_ERASE;
-    } else if (0 == strcmp("!write", mem_cmd_str)) {
-        if (msg->value.size > MEM_SIZE_MAX) {
-            JSDRV_LOGW("write size too big: %d > %d", (int) msg->value.size, (int) MEM_SIZE_MAX);
+    } else if ((0 == strcmp("!write", mem_cmd_str)) || (0 == strcmp("!verify", mem_cmd_str))) {
+        bool verify = ('v' == mem_cmd_str[1]);
+        uint32_t sz = msg->value.size;
+        int32_t rc = 0;
+        if (JSDRV_UNION_STR == msg->value.type) {
+            rc = mem_file_open(d, msg->value.value.str, &sz);
+        } else if (sz > MEM_SIZE_MAX) {
+            JSDRV_LOGW("write size too big: %d > %d", (int) sz, (int) MEM_SIZE_MAX);
+            rc = JSDRV_ERROR_PARAMETER_INVALID;
+        }
+        if ((0 == rc) && (NULL == d->mem_file)) {
+            d->mem_data = jsdrv_alloc(sz);
+            memcpy(d->mem_data, msg->value.value.bin, sz);
+        }
+        if ((0 == rc) && verify) {
+            rc = mem_image_hash(d, sz);
+        }
+        if (rc) {
             --d->out_frame_id;
             jsdrvp_msg_free(d->context, msg_bk);
-            return mem_complete(d, JSDRV_ERROR_PARAMETER_INVALID);
+            jsdrv_topic_clear(&d->mem_topic);
+            mem_release(d);
+            return send_return_code_to_frontend(d, topic, rc);
         }
-        m->hdr.op = JS220_PORT3_OP_WRITE_START;
-        m->hdr.length = msg->value.size;
-        d->mem_data = jsdrv_alloc(msg->value.size);
-        memcpy(d->mem_data, msg->value.value.bin, msg->value.size);
+        m->hdr.op = verify ? JS220_PORT3_OP_HASH_REQ : JS220_PORT3_OP_WRITE_START;
+        m->hdr.length = sz;
     } else if (0 == strcmp("!read", mem_cmd_str)) {
         int32_t sz = MEM_SIZE_MAX;
         jsdrv_union_as_type(&msg->value, JSDRV_UNION_U32);
@@ -965,7 +1530,7 @@ static int32_t handle_cmd_mem(struct dev_s * d, struct jsdrvp_msg_s * msg) {
     }
     d->mem_hdr = m->hdr;
     JSDRV_LOGD1("mem cmd: region=%s, op=%s, length=%d", region_str, mem_cmd_str, (int) d->mem_hdr.length);
-    msg_queue_push(d->ll.cmd_q, msg_bk);
+    ll_send(d, msg_bk);
 
     return 0;
 }
@@ -982,65 +1547,109 @@ static int32_t handle_reset(struct dev_s * d, int32_t target) {
     memset(&m->hdr, 0, sizeof(m->hdr));
     m->hdr.op = JS220_PORT3_OP_BOOT;
     m->hdr.arg = target;
-    msg_queue_push(d->ll.cmd_q, msg_bk);
+    ll_send(d, msg_bk);
     return 0;
 }
 
-static int32_t on_sampling_frequency(struct dev_s * d,  const struct jsdrv_union_s * value) {
-    struct jsdrv_union_s v = *value;
-    uint32_t fs_in;
-    if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
-        JSDRV_LOGW("Could not process sampling frequency");
-        return JSDRV_ERROR_PARAMETER_INVALID;
+static uint32_t gpi_decimate_factor(uint32_t fs) {
+    if (fs < FS_MIN_ON_INSTRUMENT) {
+        return SAMPLING_FREQUENCY / FS_MIN_ON_INSTRUMENT;
     }
+    return SAMPLING_FREQUENCY / fs;
+}
 
-    stream_suspend(d);
-    d->fs = v.value.u32;
-    JSDRV_LOGI("on_sampling_frequency(%lu)", d->fs);
-    uint32_t gpi_n = SAMPLING_FREQUENCY / d->fs;
-    if (d->fs < FS_MIN_ON_INSTRUMENT) {
-        gpi_n = SAMPLING_FREQUENCY / FS_MIN_ON_INSTRUMENT;
+// The jsdrv_downsample_mode_e for host downsampling with the h/filter setting.
+static int host_downsample_mode(struct dev_s * d) {
+    switch (d->signal_downsample_filter) {
+        case DOWNSAMPLE_SINC1: return JSDRV_DOWNSAMPLE_MODE_AVERAGE;
+        case DOWNSAMPLE_CIC: return JSDRV_DOWNSAMPLE_MODE_CIC;
+        case DOWNSAMPLE_CIC_COMP: return JSDRV_DOWNSAMPLE_MODE_CIC_COMPENSATED;
+        default: return JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND;
     }
-    uint32_t signal_n = (DOWNSAMPLE_WIDEBAND == d->signal_downsample_filter) ? 1 : (gpi_n / 2);
+}
 
-    for (uint32_t idx = 0; idx < (PORTS_LENGTH - 2); ++idx) {
-        struct port_s *p = &d->ports[idx];
-        if (p->downsample) {
-            jsdrv_downsample_free(p->downsample);
-            p->downsample = NULL;
+/*
+ * Compute the on-instrument decimate factor for port idx at the host
+ * sample rate d->fs, and allocate its host downsampler, if any.
+ */
+static struct jsdrv_downsample_s * port_rate(struct dev_s * d, uint32_t idx, uint32_t * decimate_factor) {
+    struct jsdrv_downsample_s * downsample = NULL;
+    uint32_t gpi_n = gpi_decimate_factor(d->fs);
+    *decimate_factor = PORT_MAP[idx].decimate_min;
+    uint32_t fs_in = SAMPLING_FREQUENCY / *decimate_factor;
+    if (
+            (PORT_MAP[idx].element_type == JSDRV_DATA_TYPE_UINT)
+            && (PORT_MAP[idx].element_size_bits == 1)
+            && (d->gpi_downsample_filter)) {
+        *decimate_factor = gpi_n;
+        return NULL;
+    }
+    if (PORT_MAP[idx].element_type != JSDRV_DATA_TYPE_FLOAT) {
+        return NULL;
+    }
+    if (d->fs >= fs_in) {
+        return NULL;
+    }
+
+    if (DOWNSAMPLE_SINC1 != d->signal_downsample_filter) {
+        downsample = jsdrv_downsample_alloc(fs_in, d->fs, host_downsample_mode(d));
+        if (NULL == downsample) {
+            JSDRV_LOGW("jsdrv_downsample_alloc failed");
         }
-        p->decimate_factor = PORT_MAP[idx].decimate_min;
-        fs_in = SAMPLING_FREQUENCY / p->decimate_factor;
-        if (
-                (PORT_MAP[idx].element_type == JSDRV_DATA_TYPE_UINT)
-                && (PORT_MAP[idx].element_size_bits == 1)
-                && (d->gpi_downsample_filter)) {
-            p->decimate_factor = gpi_n;
-            continue;
+    } else {
+        *decimate_factor = gpi_n;  // GPI is from full rate
+        if (d->fs < FS_MIN_ON_INSTRUMENT) {
+            downsample = jsdrv_downsample_alloc(FS_MIN_ON_INSTRUMENT, d->fs, JSDRV_DOWNSAMPLE_MODE_AVERAGE);
+            if (NULL == downsample) {
+                JSDRV_LOGW("jsdrv_downsample_alloc failed");
+            }
         }
-        if (PORT_MAP[idx].element_type != JSDRV_DATA_TYPE_FLOAT) {
-            continue;
+    }
+    JSDRV_LOGI("jsdrv_downsample_alloc idx=%lu, decimate_factor=%lu", idx, *decimate_factor);
+    return downsample;
+}
+
+/*
+ * Apply the host sample rate.  When seamless and only the host
+ * downsampling changes, the streams continue through the switch, see
+ * port_downsample_next().  Otherwise, changing the on-instrument
+ * decimation suspends and resumes the streams.
+ */
+static int32_t sampling_frequency_apply(struct dev_s * d, uint32_t fs, bool seamless) {
+    struct jsdrv_downsample_s * downsample[PORTS_LENGTH - 2];
+    uint32_t decimate_factor[PORTS_LENGTH - 2];
+    uint32_t fs_prev = d->fs;
+    bool active_prev = is_on_instrument_downsample_active(d);
+
+    d->fs = fs;
+    JSDRV_LOGI("on_sampling_frequency(%lu)", d->fs);
+    uint32_t gpi_n = gpi_decimate_factor(d->fs);
+    uint32_t signal_n = (DOWNSAMPLE_SINC1 == d->signal_downsample_filter) ? (gpi_n / 2) : 1;
+    seamless = seamless && fs_prev && (active_prev == is_on_instrument_downsample_active(d));
+    for (uint32_t idx = 0; idx < (PORTS_LENGTH - 2); ++idx) {
+        downsample[idx] = port_rate(d, idx, &decimate_factor[idx]);
+        seamless = seamless && (decimate_factor[idx] == d->ports[idx].decimate_factor);
+    }
+
+    if (seamless) {
+        for (uint32_t idx = 0; idx < (PORTS_LENGTH - 2); ++idx) {
+            port_downsample_next(d, idx, downsample[idx]);
         }
-        if (d->fs >= fs_in) {
-            continue;
+        if (has_on_instrument_downsample(d) && (NULL != d->ll.cmd_q) && (gpi_n != gpi_decimate_factor(fs_prev))) {
+            // unused while s/gpi/+/dwnN/mode is off, which keeps the GPI decimate factor unchanged
+            bulk_out_publish(d, "s/gpi/+/dwnN/N", &jsdrv_union_u32_r(gpi_n));
         }
+        return 0;
+    }
 
-        if (DOWNSAMPLE_WIDEBAND == d->signal_downsample_filter) {
-            p->downsample = jsdrv_downsample_alloc(fs_in, d->fs, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND);
-            if (NULL == p->downsample) {
-                JSDRV_LOGW("jsdrv_downsample_alloc failed");
-            }
-        } else {
-            p->decimate_factor = gpi_n;  // GPI is from full rate
-            if (d->fs < FS_MIN_ON_INSTRUMENT) {
-                p->downsample = jsdrv_downsample_alloc(FS_MIN_ON_INSTRUMENT, d->fs, JSDRV_DOWNSAMPLE_MODE_AVERAGE);
-                if (NULL == p->downsample) {
-                    JSDRV_LOGW("jsdrv_downsample_alloc failed");
-                }
-            }
+    stream_suspend(d);
+    for (uint32_t idx = 0; idx < (PORTS_LENGTH - 2); ++idx) {
+        struct port_s *p = &d->ports[idx];
+        if (p->downsample) {
+            jsdrv_downsample_free(p->downsample);
         }
-        JSDRV_LOGI("jsdrv_downsample_alloc idx=%lu, decimate_factor=%lu",
-                   idx, p->decimate_factor);
+        p->downsample = downsample[idx];
+        p->decimate_factor = decimate_factor[idx];
     }
 
     if (has_on_instrument_downsample(d) && (NULL != d->ll.cmd_q)) {
@@ -1049,18 +1658,33 @@ static int32_t on_sampling_frequency(struct dev_s * d,  const struct jsdrv_union
         bulk_out_publish(d, "s/gpi/+/dwnN/N", &jsdrv_union_u32_r(gpi_n));
     }
     stream_resume(d);
+    stream_bandwidth_check(d, d->stream_in_port_enable);  // already applied, warn only
+    stream_bandwidth_publish(d);
 
     return 0;
 }
 
+static int32_t on_sampling_frequency(struct dev_s * d,  const struct jsdrv_union_s * value) {
+    struct jsdrv_union_s v = *value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+        JSDRV_LOGW("Could not process sampling frequency");
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    return sampling_frequency_apply(d, v.value.u32, true);
+}
+
 static int32_t on_filter(struct dev_s * d,  const struct jsdrv_union_s * value) {
     struct jsdrv_union_s v = *value;
     if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
         JSDRV_LOGW("Could not process signal downsampling filter setting");
         return JSDRV_ERROR_PARAMETER_INVALID;
     }
+    if (v.value.u32 > DOWNSAMPLE_CIC_COMP) {
+        JSDRV_LOGW("Invalid signal downsampling filter %lu", v.value.u32);
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
     d->signal_downsample_filter = v.value.u32;
-    return on_sampling_frequency(d, &jsdrv_union_u32_r(d->fs));
+    return sampling_frequency_apply(d, d->fs, false);
 }
 
 static int32_t on_gpi_downsample_filter(struct dev_s * d,  const struct jsdrv_union_s * value) {
@@ -1069,10 +1693,228 @@ static int32_t on_gpi_downsample_filter(struct dev_s * d,  const struct jsdrv_un
         JSDRV_LOGW("Could not process GPI downsampling filter setting");
         return JSDRV_ERROR_PARAMETER_INVALID;
     }
-    d->gpi_downsample_filter = v.value.u32;
-    return on_sampling_frequency(d, &jsdrv_union_u32_r(d->fs));
+    d->gpi_downsample_filter = v.value.u32;
+    return sampling_frequency_apply(d, d->fs, false);
+}
+
+static int32_t on_bulk_in_param(struct dev_s * d, const char * topic, const struct jsdrv_union_s * value) {
+    struct jsdrv_union_s v = *value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+        JSDRV_LOGW("Could not process %s", topic);
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (0 == strcmp("h/usb/bulk_in/depth", topic)) {
+        d->bulk_in_depth = jsdrv_usbbk_bulk_in_depth(v.value.u32);
+    } else if (0 == strcmp("h/usb/bulk_in/max", topic)) {
+        d->bulk_in_depth_max = v.value.u32 ? jsdrv_usbbk_bulk_in_depth(v.value.u32) : 0;
+    } else if (0 == strcmp("h/usb/bulk_in/size", topic)) {
+        d->bulk_in_size = jsdrv_usbbk_bulk_in_size(v.value.u32);
+    } else if (0 == strcmp("h/usb/bulk_in/spare", topic)) {
+        d->bulk_in_spare = jsdrv_usbbk_bulk_in_spare(v.value.u32);
+    } else if (0 == strcmp("h/usb/budget", topic)) {
+        d->usb_budget = v.value.u32;
+    } else {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    return 0;
+}
+
+static int32_t on_stream_latency(struct dev_s * d, const struct jsdrv_union_s * value) {
+    struct jsdrv_union_s v = *value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    d->stream_latency_ms = (v.value.u32 > STREAM_LATENCY_MS_MAX) ? STREAM_LATENCY_MS_MAX : v.value.u32;
+    return 0;
+}
+
+static int32_t on_qos(struct dev_s * d, const struct jsdrv_union_s * value) {
+    struct jsdrv_union_s v = *value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U32) || (v.value.u32 > JSDRVP_QOS_CRITICAL)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    d->qos = (uint8_t) v.value.u32;
+    return 0;
+}
+
+static int32_t on_power_window(struct dev_s * d, const struct jsdrv_union_s * value) {
+    struct jsdrv_union_s v = *value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (v.value.u32 != jsdrv_power_align_window(d->power_align)) {
+        // discards the retained samples, like a stream restart
+        jsdrv_power_align_free(d->power_align);
+        d->power_align = jsdrv_power_align_alloc(v.value.u32, on_power, d);
+    }
+    return 0;
+}
+
+static int32_t on_stream_event(struct dev_s * d, const struct jsdrv_union_s * value) {
+    if (jsdrv_union_to_bool(value, &d->stream_event)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    return 0;
+}
+
+static int32_t on_stream_frame(struct dev_s * d, const struct jsdrv_union_s * value) {
+    bool enable = false;
+    if (jsdrv_union_to_bool(value, &enable)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (!enable) {
+        frame_free(d);
+    } else if (NULL == d->framer) {
+        d->framer = jsdrv_framer_alloc();
+        d->frame_port_mask = 0;  // configure on the next bulk in transfer
+        memset(d->frame_channel, FRAME_CHANNEL_NONE, sizeof(d->frame_channel));
+    }
+    return 0;
+}
+
+static int32_t on_host_stats(struct dev_s * d, const char * topic, const struct jsdrv_union_s * value) {
+    struct jsdrv_union_s v = *value;
+    int32_t rc;
+    if (0 == strcmp("h/stats/ctrl", topic)) {
+        bool enable = false;
+        if (jsdrv_union_to_bool(&v, &enable)) {
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+        if (enable != d->host_stats_enable) {
+            jsdrv_host_stats_clear(&d->host_stats);
+            d->host_stats_enable = enable;
+        }
+        return 0;
+    } else if (0 == strcmp("h/stats/derived", topic)) {
+        bool enable = false;
+        if (jsdrv_union_to_bool(&v, &enable)) {
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+        jsdrv_host_stats_derived_enable(&d->host_stats, enable);
+        return 0;
+    }
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (0 == strcmp("h/stats/window", topic)) {
+        rc = jsdrv_host_stats_config(&d->host_stats, v.value.u32, d->host_stats_hop);
+    } else if (0 == strcmp("h/stats/hop", topic)) {
+        rc = jsdrv_host_stats_config(&d->host_stats, d->host_stats.window, v.value.u32);
+        if (0 == rc) {
+            d->host_stats_hop = v.value.u32;
+        }
+    } else {
+        rc = JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    return rc;
+}
+
+static int32_t on_host_gate(struct dev_s * d, const char * topic, const struct jsdrv_union_s * value) {
+    struct jsdrv_union_s v = *value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U32) || (v.value.u32 > 0xff)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    uint8_t mask = jsdrv_gate_mask(d->gate);
+    uint8_t level = d->gate_level;
+    if (0 == strcmp("h/gate/mask", topic)) {
+        mask = (uint8_t) v.value.u32;
+    } else {
+        level = (uint8_t) v.value.u32;
+    }
+    d->gate_level = level;
+    jsdrv_gate_config(d->gate, mask, level);
+    return 0;
+}
+
+static int32_t on_host_reset(struct dev_s * d, const char * topic, const struct jsdrv_union_s * value) {
+    (void) topic;
+    return handle_reset(d, value->value.i32);  // value=target
+}
+
+static void continuity_publish(struct dev_s * d) {
+    int64_t now = jsdrv_time_monotonic();
+    for (uint32_t idx = 0; idx < PORTS_LENGTH; ++idx) {
+        struct port_s * port = &d->ports[idx];
+        if ((0 == port->continuity_topic.length)
+                || !jsdrv_continuity_publish_ready(&port->continuity, port->sample_id_next, now)) {
+            continue;
+        }
+        struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(d->context);
+        jsdrvp_msg_topic_set(m, &port->continuity_topic);
+        JSDRV_ASSERT(sizeof(m->payload.bin) >= sizeof(struct jsdrv_continuity_s));
+        memcpy(m->payload.bin, &port->continuity.value, sizeof(struct jsdrv_continuity_s));
+        m->value = jsdrv_union_cbin_r(m->payload.bin, sizeof(struct jsdrv_continuity_s));
+        m->value.app = JSDRV_PAYLOAD_TYPE_CONTINUITY;
+        backend_send(d, m);
+    }
+}
+
+static int32_t on_continuity_clear(struct dev_s * d, const char * topic, const struct jsdrv_union_s * value) {
+    (void) topic;
+    (void) value;
+    for (uint32_t idx = 0; idx < PORTS_LENGTH; ++idx) {
+        jsdrv_continuity_clear(&d->ports[idx].continuity);
+    }
+    continuity_publish(d);
+    return 0;
+}
+
+static int32_t on_host_timeout(struct dev_s * d, const char * topic, const struct jsdrv_union_s * value) {
+    (void) d;
+    (void) topic;
+    jsdrv_thread_sleep_ms(value->value.u32);
+    JSDRV_LOGI("JS220 timeout done: %" PRIu32, value->value.u32);
+    return 0;
+}
+
+static int32_t on_host_fs(struct dev_s * d, const char * topic, const struct jsdrv_union_s * value) {
+    (void) topic;
+    return on_sampling_frequency(d, value);
+}
+
+static int32_t on_host_filter(struct dev_s * d, const char * topic, const struct jsdrv_union_s * value) {
+    (void) topic;
+    return on_filter(d, value);
+}
+
+static int32_t on_host_scale(struct dev_s * d, const char * topic, const struct jsdrv_union_s * value) {
+    struct jsdrv_union_s v = *value;
+    int32_t rc = jsdrv_union_as_type(&v, JSDRV_UNION_F64);
+    if (!rc) {
+        if (topic[2] == 'i') {
+            d->i_scale = (float) v.value.f64;
+        } else {
+            d->v_scale = (float) v.value.f64;
+        }
+    }
+    return rc;
 }
 
+typedef int32_t (*host_param_fn)(struct dev_s * d, const char * topic, const struct jsdrv_union_s * value);
+
+struct host_param_s {
+    const char * topic;
+    host_param_fn fn;
+};
+
+static const struct host_param_s HOST_PARAMS[] = {
+    {"h/!reset",        on_host_reset},
+    {"h/timeout",       on_host_timeout},
+    {"h/fs",            on_host_fs},
+    {"h/filter",        on_host_filter},
+    {"h/i_scale",       on_host_scale},
+    {"h/v_scale",       on_host_scale},
+    {"h/stats/ctrl",    on_host_stats},
+    {"h/stats/window",  on_host_stats},
+    {"h/stats/hop",     on_host_stats},
+    {"h/stats/derived", on_host_stats},
+    {"h/gate/mask",     on_host_gate},
+    {"h/gate/level",    on_host_gate},
+    {"h/gaps/!clear",   on_continuity_clear},
+    {"h/state",         NULL},
+};
+JSDRV_STATIC_ASSERT(JSDRV_ARRAY_SIZE(HOST_PARAMS) <= HOST_PARAMS_MAX, host_params_max);
+
 static bool handle_cmd(struct dev_s * d, struct jsdrvp_msg_s * msg) {
     int32_t rc = 0;
     bool rv = true;
@@ -1090,20 +1932,16 @@ static bool handle_cmd(struct dev_s * d, struct jsdrvp_msg_s * msg) {
         }
     } else if (!topic) {
         JSDRV_LOGE("handle_cmd mismatch %s, %s", msg->topic, d->ll.prefix);
+    } else if ((OPEN_STEP_IDLE != d->open_step) && (topic[0] == JSDRV_MSG_COMMAND_PREFIX_CHAR)
+            && (0 != strcmp(JSDRV_MSG_FINALIZE, topic))) {
+        jsdrv_list_add_tail(&d->cmd_deferred, &msg->item);  // process in order after the open
     } else if (topic[0] == JSDRV_MSG_COMMAND_PREFIX_CHAR) {
         if (0 == strcmp(JSDRV_MSG_OPEN, topic)) {
             int32_t opt = 0;
             if ((msg->value.type == JSDRV_UNION_U32) || (msg->value.type == JSDRV_UNION_I32)) {
                 opt = msg->value.value.i32;
             }
-            rc = d_open_ll(d, opt);
-            if (0 == rc) {
-                rc = d_open(d, opt);
-                if (rc) {
-                    d_close(d);
-                }
-            }
-            send_to_frontend(d, JSDRV_MSG_OPEN "#", &jsdrv_union_i32(rc));
+            open_start(d, opt);  // responds when the open completes
         } else if (0 == strcmp(JSDRV_MSG_CLOSE, topic)) {
             rc = d_close(d);
             send_to_frontend(d, JSDRV_MSG_CLOSE "#", &jsdrv_union_i32(rc));
@@ -1114,6 +1952,44 @@ static bool handle_cmd(struct dev_s * d, struct jsdrvp_msg_s * msg) {
         } else {
             JSDRV_LOGE("handle_cmd unsupported %s", msg->topic);
         }
+    } else if (jsdrv_cstr_starts_with(topic, "h/usb/bulk_in/") || (0 == strcmp("h/usb/budget", topic))) {
+        // allowed while closed, applied on next open
+        rc = on_bulk_in_param(d, topic, &msg->value);
+        send_return_code_to_frontend(d, topic, rc);
+    } else if (0 == strcmp("h/stream/latency", topic)) {
+        // allowed while closed, applies to the next stream message
+        rc = on_stream_latency(d, &msg->value);
+        send_return_code_to_frontend(d, topic, rc);
+    } else if (0 == strcmp("h/qos", topic)) {
+        // allowed while closed, applies to the next message, including this return code
+        rc = on_qos(d, &msg->value);
+        send_return_code_to_frontend(d, topic, rc);
+    } else if (0 == strcmp("h/power/window", topic)) {
+        // allowed while closed, applies immediately
+        rc = on_power_window(d, &msg->value);
+        send_return_code_to_frontend(d, topic, rc);
+    } else if (0 == strcmp("h/stream/event", topic)) {
+        // allowed while closed, applies to the next stream message
+        rc = on_stream_event(d, &msg->value);
+        send_return_code_to_frontend(d, topic, rc);
+    } else if (0 == strcmp("h/stream/frame", topic)) {
+        // allowed while closed, applies to the next bulk in transfer
+        rc = on_stream_frame(d, &msg->value);
+        send_return_code_to_frontend(d, topic, rc);
+    } else if (jsdrv_cstr_starts_with(topic, "h/trig/")) {
+        // allowed while closed
+        rc = jsdrv_trigger_param(d->triggers, topic, &msg->value);
+        send_return_code_to_frontend(d, topic, rc);
+    } else if (jsdrv_cstr_starts_with(topic, "h/proc/")) {
+        // allowed while closed, applies to the next stream message
+        rc = jsdrv_proc_param(d->procs, topic, &msg->value);
+        send_return_code_to_frontend(d, topic, rc);
+    } else if (jsdrv_cstr_starts_with(topic, "h/tap/")) {
+        // allowed while closed, applies to the next stream message
+        rc = jsdrv_tap_param(d->tap_fs, topic, &msg->value);
+        send_return_code_to_frontend(d, topic, rc);
+    } else if (OPEN_STEP_IDLE != d->open_step) {
+        jsdrv_list_add_tail(&d->cmd_deferred, &msg->item);  // process in order after the open
     } else if (d->state != ST_OPEN) {
         send_return_code_to_frontend(d, topic, JSDRV_ERROR_CLOSED);
     } else if ((topic[0] == 'h') && (topic[1] == '/')) {
@@ -1121,38 +1997,15 @@ static bool handle_cmd(struct dev_s * d, struct jsdrvp_msg_s * msg) {
         // handle any host-side parameters here.
         if (jsdrv_cstr_starts_with(topic, "h/mem/")) {
             handle_cmd_mem(d, msg);
-        } else if (0 == strcmp("h/!reset", topic)) {   // value=target
-            rc = handle_reset(d, msg->value.value.i32);
-            send_return_code_to_frontend(d, topic, rc);
-        } else if (0 == strcmp("h/timeout", topic)) {
-            jsdrv_thread_sleep_ms(msg->value.value.u32);
-            JSDRV_LOGI("JS220 timeout done: %" PRIu32, msg->value.value.u32);
-            send_return_code_to_frontend(d, topic, 0);
-        } else if (0 == strcmp("h/fs", topic)) {
-            rc = on_sampling_frequency(d, &msg->value);
-            send_return_code_to_frontend(d, topic, rc);
-        } else if (0 == strcmp("h/filter", topic)) {
-            rc = on_filter(d, &msg->value);
-            send_return_code_to_frontend(d, topic, rc);
-        } else if (0 == strcmp("h/i_scale", topic)) {
-            struct jsdrv_union_s value = msg->value;
-            rc = jsdrv_union_as_type(&value, JSDRV_UNION_F64);
-            if (!rc) {
-                d->i_scale = (float) msg->value.value.f64;
-            }
-            send_return_code_to_frontend(d, topic, rc);
-        } else if (0 == strcmp("h/v_scale", topic)) {
-            struct jsdrv_union_s value = msg->value;
-            rc = jsdrv_union_as_type(&value, JSDRV_UNION_F64);
-            if (!rc) {
-                d->v_scale = (float) msg->value.value.f64;
-            }
-            send_return_code_to_frontend(d, topic, rc);
-        } else if (0 == strcmp("h/state", topic)) {
-            // ignore
         } else {
-            JSDRV_LOGE("topic invalid: %s", msg->topic);
-            send_return_code_to_frontend(d, topic, JSDRV_ERROR_PARAMETER_INVALID);
+            int32_t idx = jsdrv_topic_index_find(&d->host_param_index, topic);
+            if (idx < 0) {
+                JSDRV_LOGE("topic invalid: %s", msg->topic);
+                send_return_code_to_frontend(d, topic, JSDRV_ERROR_PARAMETER_INVALID);
+            } else if (NULL != HOST_PARAMS[idx].fn) {  // NULL fn ignores
+                rc = HOST_PARAMS[idx].fn(d, topic, &msg->value);
+                send_return_code_to_frontend(d, topic, rc);
+            }
         }
     } else {
         JSDRV_LOGD1("handle_cmd to device %s", topic);
@@ -1176,6 +2029,211 @@ static void time_map_update(struct dev_s * d, uint64_t sample_id, double counter
     }
 }
 
+static void stream_msg_send(struct dev_s * d, struct jsdrvp_msg_s * m) {
+    JSDRV_LATENCY_STAMP(m->latency.decode);
+    backend_send(d, m);
+}
+
+static uint8_t port_trigger_source(uint8_t port_id) {
+    switch (port_id) {
+        case PORT_ID_CURRENT: return JSDRV_TRIGGER_SOURCE_CURRENT;
+        case PORT_ID_VOLTAGE: return JSDRV_TRIGGER_SOURCE_VOLTAGE;
+        case PORT_ID_POWER:   return JSDRV_TRIGGER_SOURCE_POWER;
+        case PORT_ID_GPI0:    return JSDRV_TRIGGER_SOURCE_GPI0;
+        case PORT_ID_GPI1:    return JSDRV_TRIGGER_SOURCE_GPI1;
+        default:              return JSDRV_TRIGGER_SOURCE_OFF;
+    }
+}
+
+static void trigger_event_send(struct dev_s * d, struct jsdrv_trigger_s * t, struct jsdrv_trigger_event_s * event) {
+    event->utc = (d->time_map.offset_time > 0) ? jsdrv_time_from_counter(&d->time_map, event->sample_id) : 0;
+    jsdrv_trigger_event_publish(d->context, d->ll.prefix, t);
+}
+
+// Evaluate the triggers on the scaled port samples before host downsampling.
+static void trigger_process(struct dev_s * d, uint8_t port_id, const uint32_t * p_u32, uint32_t sample_count) {
+    uint8_t source = port_trigger_source(port_id);
+    if (JSDRV_TRIGGER_SOURCE_OFF == source) {
+        return;
+    }
+    struct port_s * port = &d->ports[port_id & 0x0f];
+    bool is_float = (PORT_MAP[port_id & 0x0f].element_type == JSDRV_DATA_TYPE_FLOAT);
+    struct jsdrv_trigger_event_s * event = NULL;
+    uint8_t x_u8[256];  // unpacked u1 samples, multiple of 8
+    for (uint32_t idx = 0; idx < JSDRV_TRIGGER_COUNT; ++idx) {
+        struct jsdrv_trigger_s * t = &d->triggers[idx];
+        if (t->source != source) {
+            continue;
+        }
+        uint32_t offset = 0;
+        while (offset < sample_count) {
+            uint32_t n = sample_count - offset;
+            const void * x = ((const float *) p_u32) + offset;
+            if (!is_float) {
+                n = (n > sizeof(x_u8)) ? (uint32_t) sizeof(x_u8) : n;
+                jsdrv_unpack_u1(x_u8, ((const uint8_t *) p_u32) + (offset >> 3), n);
+                x = x_u8;
+            }
+            for (uint32_t k = 0; k < n; ) {
+                uint64_t sample_id = port->sample_id_next + (uint64_t) (offset + k) * port->decimate_factor;
+                if (is_float) {
+                    k += jsdrv_trigger_add_f32(t, sample_id, SAMPLING_FREQUENCY, port->decimate_factor,
+                                               ((const float *) x) + k, n - k, &event);
+                } else {
+                    k += jsdrv_trigger_add_u8(t, sample_id, SAMPLING_FREQUENCY, port->decimate_factor,
+                                              ((const uint8_t *) x) + k, n - k, &event);
+                }
+                if (event) {
+                    trigger_event_send(d, t, event);
+                }
+            }
+            offset += n;
+        }
+    }
+}
+
+static struct jsdrvp_msg_s * stream_msg_init(struct dev_s * d, uint8_t port_id, const struct jsdrvp_topic_s * topic,
+                                             uint64_t sample_id, uint32_t downsample_factor, uint32_t sz, uint8_t app) {
+    struct field_def_s * field_def = &PORT_MAP[port_id & 0x0f];
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_data_sz(d->context, "", sz);
+    jsdrvp_msg_topic_set(m, topic);
+    m->latency.usb = d->in_latency_usb;
+    struct jsdrv_stream_signal_s * s = (struct jsdrv_stream_signal_s *) m->value.value.bin;
+    s->sample_id = sample_id;
+    s->sample_rate = SAMPLING_FREQUENCY;
+    s->decimate_factor = downsample_factor;
+    s->index = field_def->index;
+    s->field_id = field_def->field_id;
+    s->element_type = field_def->element_type;
+    s->element_size_bits = field_def->element_size_bits;
+    s->element_count = 0;
+    time_map_update(d, sample_id, (double) s->sample_rate, false);
+    s->time_map = d->time_map;
+    m->value.app = app;
+    m->value.size = JSDRV_STREAM_HEADER_SIZE;
+    return m;
+}
+
+static struct jsdrvp_msg_s * stream_msg_alloc(struct dev_s * d, uint8_t port_id, uint64_t sample_id,
+                                              uint32_t downsample_factor, uint32_t sz, uint8_t app) {
+    struct port_s * port = &d->ports[port_id & 0x0f];
+    struct jsdrvp_msg_s * m = stream_msg_init(d, port_id, &port->topic, sample_id, downsample_factor, sz, app);
+    port->msg_in = m;
+    port->msg_in_time = jsdrv_time_monotonic();
+    return m;
+}
+
+static uint32_t stream_element_count_max(struct dev_s * d, uint32_t downsample_factor) {
+    uint32_t latency_ms = d->stream_latency_ms ? d->stream_latency_ms : STREAM_LATENCY_MS_DEFAULT;
+    uint32_t count = (uint32_t) (((uint64_t) SAMPLING_FREQUENCY * latency_ms) / (1000ULL * downsample_factor));
+    return (count < 1) ? 1 : count;
+}
+
+/*
+ * Downsample the newly published float samples for each "h/tap/N/fs"
+ * output.  The taps start from the published stream, rather than the
+ * port samples, so the early downsampling stages run once for all
+ * outputs.
+ */
+static void stream_in_port_taps(struct dev_s * d, uint8_t port_id, uint64_t sample_id,
+                                uint32_t decimate_factor, const float * x, uint32_t n) {
+    struct port_s * port = &d->ports[port_id & 0x0f];
+    int mode = host_downsample_mode(d);
+    for (uint32_t idx = 0; idx < JSDRV_TAP_COUNT; ++idx) {
+        struct port_tap_s * t = &port->taps[idx];
+        uint32_t fs = d->tap_fs[idx];
+        if ((0 == fs) && (0 == t->tap.fs)) {
+            continue;  // off
+        }
+        uint32_t factor = jsdrv_tap_configure(&t->tap, SAMPLING_FREQUENCY, fs, mode, decimate_factor);
+        struct jsdrvp_msg_s * m = t->msg_in;
+        uint32_t sz = n * sizeof(float);
+        if (m && ((((struct jsdrv_stream_signal_s *) m->value.value.bin)->decimate_factor != factor)
+                || ((m->value.size + sz) > m->capacity))) {
+            t->msg_in = NULL;
+            stream_msg_send(d, m);
+            m = NULL;
+        }
+        if (0 == factor) {
+            continue;  // tap off or invalid
+        }
+        uint32_t element_count_max = stream_element_count_max(d, factor);
+        if (NULL == m) {
+            m = stream_msg_init(d, port_id, &t->topic, sample_id, factor,
+                                JSDRV_STREAM_HEADER_SIZE + element_count_max * sizeof(float) + sz,
+                                JSDRV_PAYLOAD_TYPE_STREAM);
+            t->msg_in = m;
+            t->msg_in_time = jsdrv_time_monotonic();
+        }
+        struct jsdrv_stream_signal_s * s = (struct jsdrv_stream_signal_s *) m->value.value.bin;
+        uint64_t y_sample_id = 0;
+        uint32_t n_out = jsdrv_tap_process(&t->tap, sample_id, x, n,
+                                           (float *) &m->value.value.bin[m->value.size], &y_sample_id);
+        if (0 == n_out) {
+            continue;
+        }
+        if (0 == s->element_count) {
+            s->sample_id = y_sample_id;
+        }
+        s->element_count += n_out;
+        m->value.size += n_out * sizeof(float);
+        if ((((s->element_count * s->element_size_bits) / 8) >= STREAM_PAYLOAD_FULL)
+                || (s->element_count >= element_count_max)) {
+            t->msg_in = NULL;
+            stream_msg_send(d, m);
+        }
+    }
+}
+
+/*
+ * Add sub-byte samples to event-encoded messages.  Each message spans
+ * up to JSDRV_STREAM_EVENT_SPAN_MS, or a nonzero h/stream/latency below
+ * the default, and sends early when its events are full.
+ */
+static void stream_in_port_events(struct dev_s * d, uint8_t port_id, const uint8_t * x, uint32_t sample_count) {
+    struct port_s * port = &d->ports[port_id & 0x0f];
+    uint32_t span_ms = d->stream_latency_ms;
+    if ((0 == span_ms) || (span_ms >= STREAM_LATENCY_MS_DEFAULT)) {
+        span_ms = JSDRV_STREAM_EVENT_SPAN_MS;  // 0 flushes each bulk in transfer
+    }
+    uint32_t span_max = (uint32_t) (((uint64_t) SAMPLING_FREQUENCY * span_ms) / (1000ULL * port->decimate_factor));
+    if (span_max < 1) {
+        span_max = 1;
+    }
+    uint32_t offset = 0;
+    while (offset < sample_count) {
+        struct jsdrvp_msg_s * m = port->msg_in;
+        if (NULL == m) {
+            uint64_t sample_id = port->sample_id_next + (uint64_t) offset * port->decimate_factor;
+            m = stream_msg_alloc(d, port_id, sample_id, port->decimate_factor,
+                                 JSDRV_STREAM_EVENT_SIZE_MAX, JSDRV_PAYLOAD_TYPE_STREAM_EVENT);
+        }
+        struct jsdrv_stream_signal_s * s = (struct jsdrv_stream_signal_s *) m->value.value.bin;
+        uint32_t n = sample_count - offset;
+        if (n > (span_max - s->element_count)) {
+            n = span_max - s->element_count;
+        }
+        uint32_t k = jsdrv_stream_event_add_packed(s, &m->value.size, m->capacity, x, offset, n);
+        offset += k;
+        if ((k < n) || (s->element_count >= span_max)) {
+            port->msg_in = NULL;
+            stream_msg_send(d, m);
+        }
+    }
+}
+
+// Add the published samples to the s/frame/!data channel for this port.
+static void stream_in_port_frame(struct dev_s * d, uint8_t port_id, uint64_t sample_id, uint32_t decimate_factor,
+                                 const void * x, uint32_t n) {
+    if (NULL == d->framer) {
+        return;
+    }
+    uint8_t channel = d->frame_channel[port_id & 0x0f];
+    if (FRAME_CHANNEL_NONE != channel) {
+        jsdrv_framer_add(d->framer, channel, sample_id, decimate_factor, x, n);
+    }
+}
+
 static void handle_stream_in_port(struct dev_s * d, uint8_t port_id, uint32_t * p_u32, uint16_t size) {
     struct field_def_s * field_def = &PORT_MAP[port_id & 0x0f];
     struct port_s * port = &d->ports[port_id & 0x0f];
@@ -1186,11 +2244,11 @@ static void handle_stream_in_port(struct dev_s * d, uint8_t port_id, uint32_t *
     }
 
     if (0 == field_def->element_size_bits) {
-        JSDRV_LOGW("stream_in_port %d element_size_bits is 0", port_id);
+        JSDRV_LOGW_RATE("stream_in_port %d element_size_bits is 0", port_id);
         return;
     }
     if (0 == port->decimate_factor) {
-        JSDRV_LOGW("stream_in_port %d port->decimate_factor is 0", port_id);
+        JSDRV_LOGW_RATE("stream_in_port %d port->decimate_factor is 0", port_id);
         return;
     }
 
@@ -1198,14 +2256,25 @@ static void handle_stream_in_port(struct dev_s * d, uint8_t port_id, uint32_t *
     size -= sizeof(uint32_t);
     uint32_t sample_count = (size << 3) / field_def->element_size_bits;
     if (sample_count == 0) {
-        JSDRV_LOGI("stream_in_port %d empty message", port_id);
+        JSDRV_LOGI_RATE("stream_in_port %d empty message", port_id);
         return;
     }
 
     // downsample_factor is the total rate reduction which combines:
     // - instrument decimation (port->decimate_factor)
-    // - host-side downsampling including anti-alias filtering.
-    uint32_t downsample_factor = port->decimate_factor * jsdrv_downsample_decimate_factor(port->downsample);
+    // - host-side downsampling including anti-alias filtering, or
+    //   the processing chain when it reduces the rate.
+    struct jsdrv_proc_s * proc = port_proc(d, port_id);
+    if ((NULL != proc) && !proc->active) {
+        proc = NULL;
+    }
+    uint32_t proc_factor = proc ? proc->decimate_factor : 1;
+    if (port->downsample_pending && ((0 == port->downsample_prime) || (proc_factor > 1))) {
+        port_downsample_switch(port);  // frame boundary, the message below restarts at the new rate
+    }
+    uint32_t downsample_factor = port->decimate_factor
+            * ((proc_factor > 1) ? proc_factor : jsdrv_downsample_decimate_factor(port->downsample));
+    uint32_t element_count_max = stream_element_count_max(d, downsample_factor);
 
     // header is u32 sample_id, consume and skip to payload
     // sample_id is always for 2 Msps, regardless of this port's sample rate
@@ -1222,7 +2291,8 @@ static void handle_stream_in_port(struct dev_s * d, uint8_t port_id, uint32_t *
                     port_id, sample_id_u32, d->time_map.offset_counter);
         resync = true;
     } else if ((skip >= quarter_range_u32) && (dup >= quarter_range_u32)) {
-        JSDRV_LOGW("stream_in_port %d lost sync", port_id);
+        JSDRV_LOGW_RATE("stream_in_port %d lost sync", port_id);
+        jsdrv_continuity_resync(&port->continuity);
         resync = true;
     } else if (skip >= quarter_range_u32) {
         skip = 0;  // is duplicate
@@ -1244,7 +2314,8 @@ static void handle_stream_in_port(struct dev_s * d, uint8_t port_id, uint32_t *
         } else if (bwd < quarter_range_u32) {
             port->sample_id_next = d->time_map.offset_counter - bwd;
         } else {
-            JSDRV_LOGW("stream_in_port %d sync failed, drop", port_id);
+            JSDRV_LOGW_RATE("stream_in_port %d sync failed, drop", port_id);
+            jsdrv_continuity_drop(&port->continuity);
             return;
         }
         skip = 0;
@@ -1254,12 +2325,14 @@ static void handle_stream_in_port(struct dev_s * d, uint8_t port_id, uint32_t *
     if ((dup == 0) && (skip == 0)) {
         // normal operation, ready to process sample_id_next.
     } else if ((sample_count * port->decimate_factor) < dup) {
-        JSDRV_LOGI("stream_in_port %d dup %" PRIu32 " : received=0x%" PRIx32 " expected=0x%" PRIx32,
-                   port_id, dup, sample_id_u32, sample_id_expect_u32);
+        JSDRV_LOGI_RATE("stream_in_port %d dup %" PRIu32 " : received=0x%" PRIx32 " expected=0x%" PRIx32,
+                        port_id, dup, sample_id_u32, sample_id_expect_u32);
+        jsdrv_continuity_dup(&port->continuity, (uint64_t) sample_count * port->decimate_factor);
         return;  // no new data present, still awaiting sample_id_next.
     } else if (dup) {
-        JSDRV_LOGI("stream_in_port %d overlap %" PRIu32 " : received=0x%" PRIx32 " expected=0x%" PRIx32,
-                   port_id, dup, sample_id_u32, sample_id_expect_u32);
+        JSDRV_LOGI_RATE("stream_in_port %d overlap %" PRIu32 " : received=0x%" PRIx32 " expected=0x%" PRIx32,
+                        port_id, dup, sample_id_u32, sample_id_expect_u32);
+        jsdrv_continuity_dup(&port->continuity, dup);
         uint32_t overlap = dup / port->decimate_factor;
         uint16_t overlap_size = (uint16_t) ((overlap * field_def->element_size_bits) / 8);
         if (overlap_size < port->decimate_factor) {
@@ -1270,17 +2343,22 @@ static void handle_stream_in_port(struct dev_s * d, uint8_t port_id, uint32_t *
         p_u32 += overlap_size / sizeof(uint32_t);
         // ready to process starting from sample_id_next.
     } else if (skip) {
-        JSDRV_LOGI("stream_in_port %d skip %" PRIu32 " : received=0x%" PRIx32 " expected=0x%" PRIx32,
-                   port_id, skip, sample_id_u32, sample_id_expect_u32);
+        JSDRV_LOGI_RATE("stream_in_port %d skip %" PRIu32 " : received=0x%" PRIx32 " expected=0x%" PRIx32,
+                        port_id, skip, sample_id_u32, sample_id_expect_u32);
         if (m) {
             JSDRV_LOGD1("stream_in_port: port_id=%d send partial message", (int) port_id);
             port->msg_in = NULL;
-            jsdrvp_backend_send(d->context, m);
+            stream_msg_send(d, m);
             m = NULL;
             s = NULL;
         }
         // sample_id_next not available, update based upon skip
+        jsdrv_continuity_skip(&port->continuity, port->sample_id_next, skip);
         port->sample_id_next += skip;
+        d->bulk_in_skip = true;
+        if (proc) {
+            jsdrv_proc_clear(proc);
+        }
     }
 
     float scale = 1.0;
@@ -1292,19 +2370,55 @@ static void handle_stream_in_port(struct dev_s * d, uint8_t port_id, uint32_t *
 
     // apply scale
     if ((scale != 1.0) && (scale != 0.0)) {
-        float * samples_f32 = (float *) p_u32;
-        for (size_t i = 0; i < sample_count; ++i) {
-            *samples_f32++ *= scale;
-        }
+        jsdrv_f32_scale((float *) p_u32, scale, sample_count);
+    }
+
+    if (((PORT_ID_CURRENT == port_id) || (PORT_ID_VOLTAGE == port_id))
+            && is_ivp_enabled(d) && !is_on_instrument_downsample_active(d)) {
+        // computes power for the samples that the other channel already has, see on_power()
+        jsdrv_power_align_add(d->power_align,
+                              (PORT_ID_CURRENT == port_id) ? JSDRV_POWER_ALIGN_CURRENT : JSDRV_POWER_ALIGN_VOLTAGE,
+                              port->sample_id_next, port->decimate_factor, (const float *) p_u32, sample_count);
+    }
+    trigger_process(d, port_id, p_u32, sample_count);
+    if (JSDRV_FIELD_GPI == field_def->field_id) {
+        jsdrv_gate_add_gpi(d->gate, field_def->index, port->sample_id_next, port->decimate_factor,
+                           (const uint8_t *) p_u32, sample_count);
+    }
+
+    // the processing chain reduces the samples in place, sample_count remains the input count
+    uint32_t out_count = sample_count;
+    uint64_t out_sample_id = port->sample_id_next;
+    if (proc) {
+        out_sample_id -= (uint64_t) proc->phase * port->decimate_factor;  // first sample in the window
+        out_count = jsdrv_proc_process(proc, (float) SAMPLING_FREQUENCY / port->decimate_factor,
+                                       (float *) p_u32, sample_count);
+        size = (uint16_t) (out_count * sizeof(float));
     }
 
-    sbuf_f32_add(port->buf, port->sample_id_next, (float *) p_u32, sample_count);
+    uint8_t app = (d->stream_event && (field_def->element_size_bits < 8))
+            ? JSDRV_PAYLOAD_TYPE_STREAM_EVENT : JSDRV_PAYLOAD_TYPE_STREAM;
+    if (m && ((m->value.app != app)  // h/stream/event changed
+            || (((struct jsdrv_stream_signal_s *) m->value.value.bin)->decimate_factor != downsample_factor))) {
+        port->msg_in = NULL;
+        stream_msg_send(d, m);
+        m = NULL;
+        s = NULL;
+    }
+    if (field_def->element_type != JSDRV_DATA_TYPE_FLOAT) {
+        stream_in_port_frame(d, port_id, port->sample_id_next, port->decimate_factor, p_u32, sample_count);
+    }
+    if (JSDRV_PAYLOAD_TYPE_STREAM_EVENT == app) {
+        stream_in_port_events(d, port_id, (const uint8_t *) p_u32, sample_count);
+        port->sample_id_next += sample_count * port->decimate_factor;
+        return;
+    }
 
-    if (m && ((m->value.size + size) >= sizeof(struct jsdrv_stream_signal_s))) {
-        // should never happen (see jsdrvp_backend_send towards end), but just in case
+    if (m && ((m->value.size + size) >= m->capacity)) {
+        // rare, message sized for element_count_max (see jsdrvp_backend_send towards end)
         JSDRV_LOGD1("stream_in_port: port_id=%d send complete message", (int) port_id);
         port->msg_in = NULL;
-        jsdrvp_backend_send(d->context, m);
+        stream_msg_send(d, m);
         m = NULL;
         s = NULL;
     }
@@ -1312,76 +2426,135 @@ static void handle_stream_in_port(struct dev_s * d, uint8_t port_id, uint32_t *
     if (m) {
         s = (struct jsdrv_stream_signal_s *) m->value.value.bin;
     } else {
-        m = jsdrvp_msg_alloc_data(d->context, "");
-        tfp_snprintf(m->topic, sizeof(m->topic), "%s/%s", d->ll.prefix, field_def->data_topic);
+        // size for element_count_max plus this frame, which may overshoot
+        uint32_t sz = JSDRV_STREAM_HEADER_SIZE + (element_count_max * field_def->element_size_bits + 7) / 8 + size;
+        m = stream_msg_alloc(d, port_id, out_sample_id, downsample_factor, sz, JSDRV_PAYLOAD_TYPE_STREAM);
         s = (struct jsdrv_stream_signal_s *) m->value.value.bin;
-        s->sample_id = port->sample_id_next;
-        s->sample_rate = SAMPLING_FREQUENCY;
-        s->decimate_factor = downsample_factor;
-        s->index = field_def->index;
-        s->field_id = field_def->field_id;
-        s->element_type = field_def->element_type;
-        s->element_size_bits = field_def->element_size_bits;
-        s->element_count = 0;
-        time_map_update(d, port->sample_id_next, (double) s->sample_rate, false);
-        s->time_map = d->time_map;
-        m->value.app = JSDRV_PAYLOAD_TYPE_STREAM;
-        m->value.size = JSDRV_STREAM_HEADER_SIZE;
-        port->msg_in = m;
-    }
-
-    // Add decompression here as needed - compression not yet implemented on sensor
+    }
 
     uint8_t * p = (uint8_t *) &m->value.value.bin[m->value.size];
-    JSDRV_ASSERT((m->value.size + size) <= sizeof(struct jsdrv_stream_signal_s));
+    uint32_t element_count_prev = s->element_count;
+    JSDRV_ASSERT((m->value.size + size) <= m->capacity);
 
-    if ((port->downsample != NULL) && (s->element_type == JSDRV_DATA_TYPE_FLOAT)) {
+    if ((port->downsample != NULL) && (proc_factor == 1) && (s->element_type == JSDRV_DATA_TYPE_FLOAT)) {
+        JSDRV_PERF_TIME_START(t_start);
         float * x = (float *) p_u32;
         float * y = (float *) p;
         uint64_t sample_id_u64 = port->sample_id_next;
-        for (uint32_t idx = 0; idx < sample_count; ++idx) {
+        uint32_t idx = 0;
+        uint32_t n_out = 0;
+        // per sample until the first output to capture its sample_id
+        for (; (s->element_count == 0) && (idx < sample_count); ++idx) {
             if (jsdrv_downsample_add_f32(port->downsample, sample_id_u64 / port->decimate_factor, x[idx], y)) {
                 ++y;
-                if (s->element_count == 0) {
-                    s->sample_id = sample_id_u64;
-                }
+                s->sample_id = sample_id_u64;
                 ++s->element_count;
                 m->value.size += sizeof(float);
             }
             sample_id_u64 += port->decimate_factor;
         }
+        if (idx < sample_count) {
+            jsdrv_downsample_add_f32_block(port->downsample, sample_id_u64 / port->decimate_factor,
+                                           x + idx, sample_count - idx, y, &n_out);
+            s->element_count += n_out;
+            m->value.size += n_out * sizeof(float);
+        }
+        JSDRV_PERF_TIME_END(JSDRV_PERF_DS_TIME, t_start);
     } else {
         m->value.size += size;
         memcpy(p, p_u32, size);
-        s->element_count += sample_count;
+        s->element_count += out_count;
+    }
+    if (port->downsample_pending && (s->element_type == JSDRV_DATA_TYPE_FLOAT)) {
+        // prime in place, the current chain already consumed x
+        uint32_t n_out = 0;
+        float * x = (float *) p_u32;
+        jsdrv_downsample_add_f32_block(port->downsample_next, port->sample_id_next / port->decimate_factor,
+                                       x, sample_count, x, &n_out);
+        port->downsample_prime = (sample_count >= port->downsample_prime) ? 0 : (port->downsample_prime - sample_count);
     }
     port->sample_id_next += sample_count * port->decimate_factor;
+    if ((s->element_type == JSDRV_DATA_TYPE_FLOAT) && (s->element_count > element_count_prev)) {
+        uint64_t sample_id = s->sample_id + (uint64_t) element_count_prev * downsample_factor;
+        uint32_t n = s->element_count - element_count_prev;
+        stream_in_port_taps(d, port_id, sample_id, downsample_factor, (const float *) p, n);
+        stream_in_port_frame(d, port_id, sample_id, downsample_factor, p, n);
+    }
 
     // determine if need to send
     uint64_t sample_id_delta = port->sample_id_next - s->sample_id;
-    uint32_t element_count_max = SAMPLING_FREQUENCY / (20 * downsample_factor);
-    if (element_count_max < 1) {
-        element_count_max = 1;
-    }
     if ((((s->element_count * s->element_size_bits) / 8) >= STREAM_PAYLOAD_FULL)
             || (s->element_count >= element_count_max)) {
         JSDRV_LOGD3("stream_in_port: port_id=%d, sampled_id=%" PRIu32 ", sample_id_delta=%" PRIu32 ", size=%" PRIu32,
                     (int) port_id, s->sample_id, sample_id_delta, m->value.size);
         port->msg_in = NULL;
-        jsdrvp_backend_send(d->context, m);
+        stream_msg_send(d, m);
     }
 }
 
-static void compute_power(struct dev_s * d) {
-    // for full-rate data, must compute power on the host
-    // insufficient sensor-controller and USB bandwidth to stream everything.
-    sbuf_f32_mult(&d->p_buf, &d->i_buf, &d->v_buf);
-    uint32_t sz = sbuf_f32_length(&d->p_buf);
-    if (sz) {
-        handle_stream_in_port(d, PORT_ID_POWER, &d->p_buf.msg_sample_id, (1 + sz) * 4);
+static void compute_host_stats(struct dev_s * d, uint64_t sample_id,
+                               const float * i, const float * v, const float * p, uint32_t n) {
+    uint32_t offset = 0;
+    while (offset < n) {
+        struct jsdrv_statistics_s * s = NULL;
+        uint32_t k = jsdrv_host_stats_add(&d->host_stats, sample_id,
+                                          i + offset, v + offset, p + offset, n - offset, &s);
+        if (NULL != s) {
+            struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(d->context);
+            jsdrvp_msg_topic_set(m, &d->host_stats_topic);
+            JSDRV_ASSERT(sizeof(m->payload.bin) >= sizeof(struct jsdrv_statistics_s));
+            struct jsdrv_statistics_s * dst = (struct jsdrv_statistics_s *) m->payload.bin;
+            *dst = *s;
+            dst->time_map = d->time_map;
+            m->value = jsdrv_union_cbin_r((uint8_t *) dst, sizeof(*dst));
+            m->value.app = JSDRV_PAYLOAD_TYPE_STATISTICS;
+            backend_send(d, m);
+            if (d->host_stats.derived_enable) {
+                uint32_t sz = sizeof(struct jsdrv_host_derived_s);
+                m = jsdrvp_msg_alloc_data_sz(d->context, "", sz);
+                jsdrvp_msg_topic_set(m, &d->host_derived_topic);
+                memcpy(m->payload.bin, &d->host_stats.derived, sz);
+                m->value.size = sz;
+                m->value.app = JSDRV_PAYLOAD_TYPE_HOST_DERIVED;
+                backend_send(d, m);
+            }
+        }
+        offset += k;
+        sample_id += (uint64_t) k * 2;
     }
 }
 
+// Publish the statistics for each h/gate interval, see jsdrv_gate_fn.
+static void on_gate(void * user_data, struct jsdrv_statistics_s * stats) {
+    struct dev_s * d = (struct dev_s *) user_data;
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(d->context);
+    jsdrvp_msg_topic_set(m, &d->gate_topic);
+    JSDRV_ASSERT(sizeof(m->payload.bin) >= sizeof(struct jsdrv_statistics_s));
+    struct jsdrv_statistics_s * dst = (struct jsdrv_statistics_s *) m->payload.bin;
+    *dst = *stats;
+    dst->time_map = d->time_map;
+    m->value = jsdrv_union_cbin_r((uint8_t *) dst, sizeof(*dst));
+    m->value.app = JSDRV_PAYLOAD_TYPE_STATISTICS;
+    backend_send(d, m);
+}
+
+/*
+ * For full-rate data, must compute power on the host since the
+ * sensor-controller and USB have insufficient bandwidth to stream
+ * everything.  The power alignment calls this function with each span
+ * of aligned current, voltage and power samples.
+ */
+static void on_power(void * user_data, uint64_t sample_id, const float * i, const float * v, float * p, uint32_t count) {
+    struct dev_s * d = (struct dev_s *) user_data;
+    if (d->host_stats_enable) {
+        compute_host_stats(d, sample_id, i, v, p, count);
+    }
+    jsdrv_gate_add(d->gate, sample_id, i, v, p, count);
+    uint32_t * p_u32 = ((uint32_t *) p) - 1;  // the scratch word
+    p_u32[0] = (uint32_t) sample_id;
+    handle_stream_in_port(d, PORT_ID_POWER, p_u32, (uint16_t) ((1 + count) * sizeof(uint32_t)));
+}
+
 static void handle_uart_in(struct dev_s * d, uint32_t * p_u32, uint16_t size) {
     (void) d;
     (void) p_u32;
@@ -1396,7 +2569,7 @@ static void handle_statistics_in(struct dev_s * d, uint32_t * p_u32, uint16_t si
         return;
     }
     struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(d->context);
-    tfp_snprintf(m->topic, sizeof(m->topic), "%s/s/stats/value", d->ll.prefix);
+    jsdrvp_msg_topic_set(m, &d->stats_topic);
     JSDRV_ASSERT(sizeof(m->payload.bin) >= sizeof(struct jsdrv_statistics_s));
     struct jsdrv_statistics_s * dst = (struct jsdrv_statistics_s *) m->payload.bin;
     m->value = jsdrv_union_cbin_r((uint8_t *) dst, sizeof(*dst));
@@ -1424,7 +2597,7 @@ static void handle_statistics_in(struct dev_s * d, uint32_t * p_u32, uint16_t si
                         (double) dst->sample_freq,
                         false);
         dst->time_map = d->time_map;
-        jsdrvp_backend_send(d->context, m);
+        backend_send(d, m);
     } else {
         jsdrvp_msg_free(d->context, m);
     }
@@ -1473,7 +2646,16 @@ static void handle_stream_in_port0(struct dev_s * d, uint32_t * p_u32, uint16_t
             }
             send_to_frontend(d, "h/i_scale", &jsdrv_union_cjson_r(i_scale_factor));
             send_to_frontend(d, "h/v_scale", &jsdrv_union_cjson_r(v_scale_factor));
+            send_to_frontend(d, "h/stats/ctrl$", &jsdrv_union_cjson_r(host_stats_ctrl_meta));
+            send_to_frontend(d, "h/stats/window$", &jsdrv_union_cjson_r(host_stats_window_meta));
+            send_to_frontend(d, "h/stats/hop$", &jsdrv_union_cjson_r(host_stats_hop_meta));
+            send_to_frontend(d, "h/stats/derived$", &jsdrv_union_cjson_r(host_stats_derived_meta));
+            send_to_frontend(d, "h/gate/mask$", &jsdrv_union_cjson_r(gate_mask_meta));
+            send_to_frontend(d, "h/gate/level$", &jsdrv_union_cjson_r(gate_level_meta));
             send_to_frontend(d, "h/!reset$", &jsdrv_union_cjson_r(reset_meta));
+            jsdrv_trigger_meta_publish(d->context, d->ll.prefix);
+            jsdrv_proc_meta_publish(d->context, d->ll.prefix);
+            jsdrv_tap_meta_publish(d->context, d->ll.prefix);
             send_to_frontend(d, "c/fw/version", &jsdrv_union_u32_r(c->fw_version));
             send_to_frontend(d, "c/hw/version", &jsdrv_union_u32_r(c->hw_version));
             send_to_frontend(d, "s/fpga/version", &jsdrv_union_u32_r(c->fpga_version));
@@ -1503,7 +2685,7 @@ static void handle_stream_in_port0(struct dev_s * d, uint32_t * p_u32, uint16_t
             p0->payload.timesync.utc_recv = t_utc;
             p0->payload.timesync.utc_send = jsdrv_time_utc();
             p0->payload.timesync.end_count = 0;
-            msg_queue_push(d->ll.cmd_q, m);
+            ll_send(d, m);
             JSDRV_LOGD2("port 0 timesync utc==%" PRIi64 " counter=%" PRIi64,
                         t_utc, p->timesync.start_count);
             break;
@@ -1560,9 +2742,11 @@ static void handle_stream_in_pubsub(struct dev_s * d, uint32_t * p_u32, uint16_t
     } else {
         jsdrv_memcpy(&m->value.value, p->data, sizeof(m->value.value));
     }
-    char buf[32];
-    jsdrv_union_value_to_str(&m->value, buf, (uint32_t) sizeof(buf), 1);
-    JSDRV_LOGD1("publish from dev: %s %s", p->topic, buf);
+    if (JSDRV_LOG_ENABLED(JSDRV_LOG_LEVEL_DEBUG1)) {
+        char buf[32];
+        jsdrv_union_value_to_str(&m->value, buf, (uint32_t) sizeof(buf), 1);
+        JSDRV_LOGD1("publish from dev: %s %s", p->topic, buf);
+    }
 
     if ((d->ll_await_break_on == BREAK_PUBSUB_TOPIC) && (0 == strcmp(d->ll_await_break_topic, p->topic))) {
         d->ll_await_break_on = BREAK_NONE;
@@ -1571,7 +2755,7 @@ static void handle_stream_in_pubsub(struct dev_s * d, uint32_t * p_u32, uint16_t
     }
 
     handle_rsp_ctrl(d, p->topic, &m->value);  // reconnect in streaming, may not be desirable
-    jsdrvp_backend_send(d->context, m);
+    backend_send(d, m);
 }
 
 static void handle_stream_in_logging(struct dev_s * d, uint32_t * p_u32, uint16_t size) {
@@ -1586,7 +2770,7 @@ static void mem_write_end(struct dev_s * d) {
     memset(&m->hdr, 0, sizeof(m->hdr));
     m->hdr = d->mem_hdr;
     m->hdr.op = JS220_PORT3_OP_NONE;
-    msg_queue_push(d->ll.cmd_q, msg_bk);
+    ll_send(d, msg_bk);
 }
 
 static void mem_write_next(struct dev_s * d) {
@@ -1608,10 +2792,21 @@ static void mem_write_next(struct dev_s * d) {
         m->hdr.op = JS220_PORT3_OP_WRITE_DATA;
         m->hdr.offset = d->mem_offset_sent;
         m->hdr.length = (remaining > JS220_PORT3_DATA_SIZE_MAX) ? JS220_PORT3_DATA_SIZE_MAX : remaining;
-        memcpy(m->data, d->mem_data + m->hdr.offset, m->hdr.length);
+        if (NULL != d->mem_file) {
+            // mem_offset_sent only advances, so the file reads are sequential
+            if (fread(m->data, 1, m->hdr.length, d->mem_file) != m->hdr.length) {
+                JSDRV_LOGW("write file read failed at offset %d", (int) m->hdr.offset);
+                --d->out_frame_id;
+                jsdrvp_msg_free(d->context, msg_bk);
+                mem_complete(d, JSDRV_ERROR_IO);
+                break;
+            }
+        } else {
+            memcpy(m->data, d->mem_data + m->hdr.offset, m->hdr.length);
+        }
         JSDRV_LOGD1("mem_write_data offset=%d, length=%d", (int) d->mem_offset_sent, (int) m->hdr.length);
         d->mem_offset_sent += m->hdr.length;
-        msg_queue_push(d->ll.cmd_q, msg_bk);
+        ll_send(d, msg_bk);
     }
 }
 
@@ -1621,7 +2816,7 @@ static void mem_write_finalize(struct dev_s * d) {
     struct js220_port3_msg_s * m = (struct js220_port3_msg_s *) msg_bk->value.value.bin;
     d->mem_hdr.op = JS220_PORT3_OP_WRITE_FINALIZE;
     m->hdr = d->mem_hdr;
-    msg_queue_push(d->ll.cmd_q, msg_bk);
+    ll_send(d, msg_bk);
 }
 
 static void mem_status(struct dev_s * d, uint8_t status) {
@@ -1644,7 +2839,18 @@ static void mem_handle_read_data(struct dev_s * d, struct js220_port3_msg_s * ms
         if (sz > sz_remaining) {
             sz = sz_remaining;
         }
-        if (sz) {
+        if (sz && d->mem_verify) {
+            uint8_t buf[JS220_PORT3_DATA_SIZE_MAX];
+            const uint8_t * p = mem_image_get(d, d->mem_offset_valid, buf, sz);
+            if (NULL == p) {
+                mem_status(d, JSDRV_ERROR_IO);
+            } else if (memcmp(p, msg->data, sz)) {
+                JSDRV_LOGW("mem verify mismatch in offset %d to %d",
+                           (int) d->mem_offset_valid, (int) (d->mem_offset_valid + sz));
+                mem_status(d, JSDRV_ERROR_MESSAGE_INTEGRITY);
+            }
+            d->mem_offset_valid += sz;
+        } else if (sz) {
             memcpy(d->mem_data + d->mem_offset_valid, msg->data, sz);
             d->mem_offset_valid += sz;
         } else {
@@ -1653,6 +2859,19 @@ static void mem_handle_read_data(struct dev_s * d, struct js220_port3_msg_s * ms
     }
 }
 
+// Verify by reading back the region when the instrument cannot hash it.
+static void mem_verify_read(struct dev_s * d) {
+    struct jsdrvp_msg_s * msg_bk = bulk_out_factory(d, 3, sizeof(struct js220_port3_header_s));
+    struct js220_port3_msg_s * m = (struct js220_port3_msg_s *) msg_bk->value.value.bin;
+    memset(&m->hdr, 0, sizeof(m->hdr));
+    m->hdr.op = JS220_PORT3_OP_READ_REQ;
+    m->hdr.region = d->mem_hdr.region;
+    m->hdr.length = d->mem_hdr.length;
+    d->mem_hdr = m->hdr;
+    d->mem_verify = true;
+    ll_send(d, msg_bk);
+}
+
 static void handle_stream_in_mem(struct dev_s * d, uint32_t * p_u32, uint16_t size) {
     size += sizeof(union js220_frame_hdr_u);  // excluded over USB
     size_t hdr_size = sizeof(union js220_frame_hdr_u) + sizeof(struct js220_port3_header_s);
@@ -1701,9 +2920,24 @@ static void handle_stream_in_mem(struct dev_s * d, uint32_t * p_u32, uint16_t si
                 break;
             case JS220_PORT3_OP_WRITE_FINALIZE: mem_complete(d, status); break;
             case JS220_PORT3_OP_READ_REQ:
+                if (d->mem_verify && (0 == status) && (d->mem_offset_valid != d->mem_hdr.length)) {
+                    JSDRV_LOGW("mem verify read %d of %d bytes", (int) d->mem_offset_valid, (int) d->mem_hdr.length);
+                    status = JSDRV_ERROR_MESSAGE_INTEGRITY;
+                }
                 d->mem_hdr.length = d->mem_offset_valid;  // truncate as needed
                 mem_complete(d, status);
                 break;
+            case JS220_PORT3_OP_HASH_REQ:
+                if (status || (size < (hdr_size + sizeof(d->mem_hash)))) {
+                    JSDRV_LOGI("mem hash unavailable, status=%d, verify by read back", (int) status);
+                    mem_verify_read(d);
+                } else if (memcmp(msg->data, d->mem_hash, sizeof(d->mem_hash))) {
+                    JSDRV_LOGW("mem verify hash mismatch");
+                    mem_complete(d, JSDRV_ERROR_MESSAGE_INTEGRITY);
+                } else {
+                    mem_complete(d, 0);
+                }
+                break;
             default:
                 JSDRV_LOGW("unsupported ack: %d", (int) msg->hdr.arg);
                 break;
@@ -1717,12 +2951,97 @@ static void handle_stream_in_mem(struct dev_s * d, uint32_t * p_u32, uint16_t si
 
 }
 
+static int32_t port_decode_xor_f32(const uint8_t * src, uint32_t src_size, uint8_t * dst, uint32_t dst_size) {
+    if (dst_size & 3) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    return jsdrv_codec_xor_f32_decode(src, src_size, (float *) dst, dst_size / sizeof(float));
+}
+
+typedef int32_t (*port_decode_fn)(const uint8_t * src, uint32_t src_size, uint8_t * dst, uint32_t dst_size);
+
+// Indexed by the frame header codec, NULL for unsupported
+static const port_decode_fn PORT_DECODE[4] = {
+    [JSDRV_CODEC_RAW] = NULL,
+    [JSDRV_CODEC_RLE8] = jsdrv_codec_rle8_decode,
+    [JSDRV_CODEC_XOR_F32] = port_decode_xor_f32,
+};
+
+/*
+ * Decode a compressed data port frame into d->port_decode.  The result
+ * has the same layout as an uncompressed frame payload, so
+ * handle_stream_in_port() processes it unchanged.  The samples must
+ * decode to whole bytes, and f32 samples to whole samples.
+ */
+static uint32_t * port_decode(struct dev_s * d, uint8_t port_id, uint8_t codec, const uint32_t * p_u32, uint16_t * size) {
+    port_decode_fn fn = PORT_DECODE[codec & 3];
+    if ((NULL == fn) || (*size < (2 * sizeof(uint32_t)))) {
+        JSDRV_LOGW_RATE("stream_in_port %d unsupported codec %d", (int) port_id, (int) codec);
+        return NULL;
+    }
+    uint32_t decoded = p_u32[1] & 0xffff;
+    if ((decoded > JS220_PORT_DECODE_SIZE_MAX)
+            || fn((const uint8_t *) &p_u32[2], *size - 2 * sizeof(uint32_t),
+                  (uint8_t *) &d->port_decode[1], decoded)) {
+        JSDRV_LOGW_RATE("stream_in_port %d codec %d decode failed", (int) port_id, (int) codec);
+        return NULL;
+    }
+    d->port_decode[0] = p_u32[0];
+    *size = (uint16_t) (sizeof(uint32_t) + decoded);
+    return d->port_decode;
+}
+
+// Process the pending runs for all ports.
+static void stream_in_runs_flush(struct dev_s * d) {
+    for (uint32_t idx = 0; idx < JSDRV_ARRAY_SIZE(d->ports); ++idx) {
+        struct port_run_s * run = &d->ports[idx].run;
+        if (run->size) {
+            uint16_t size = (uint16_t) run->size;
+            run->size = 0;
+            handle_stream_in_port(d, (uint8_t) (16U + idx), run->data, size);
+        }
+    }
+}
+
+/*
+ * Add a data port frame payload to the port's run.  A bulk in transfer
+ * interleaves frames from each port, so handling each frame separately
+ * repeats the per-message work for every 126 samples.  Instead, append
+ * frames that continue the run and process each run with a single
+ * handle_stream_in_port() call.  A frame that does not continue its
+ * run or does not fit flushes all runs, which bounds the latency of
+ * the current and voltage samples awaiting their power computation.
+ */
+static void stream_in_run_add(struct dev_s * d, uint8_t port_id, uint32_t * payload, uint16_t length) {
+    struct port_s * port = &d->ports[port_id & 0x0f];
+    struct port_run_s * run = &port->run;
+    uint32_t element_size_bits = PORT_MAP[port_id & 0x0f].element_size_bits;
+    if ((length <= sizeof(uint32_t)) || (0 == element_size_bits) || (0 == port->decimate_factor)
+            || (length > sizeof(run->data))) {
+        stream_in_runs_flush(d);
+        handle_stream_in_port(d, port_id, payload, length);  // logs or processes unbatched
+        stream_in_runs_flush(d);
+        return;
+    }
+    uint32_t sz = length - sizeof(uint32_t);
+    if (run->size && ((payload[0] != run->sample_id_next) || ((run->size + sz) > sizeof(run->data)))) {
+        stream_in_runs_flush(d);
+    }
+    if (0 == run->size) {
+        run->data[0] = payload[0];
+        run->size = sizeof(uint32_t);
+    }
+    memcpy(((uint8_t *) run->data) + run->size, payload + 1, sz);
+    run->size += sz;
+    run->sample_id_next = payload[0] + ((sz * 8) / element_size_bits) * port->decimate_factor;
+}
+
 static void handle_stream_in_frame(struct dev_s * d, uint32_t * p_u32) {
     union js220_frame_hdr_u hdr;
     hdr.u32 = p_u32[0];
     if (d->in_frame_id != (uint16_t) hdr.h.frame_id) {
         if (0 != d->in_frame_count) {
-            JSDRV_LOGW("in frame_id mismatch %d != %d", (int) d->in_frame_id, (int) hdr.h.frame_id);
+            JSDRV_LOGW_RATE("in frame_id mismatch %d != %d", (int) d->in_frame_id, (int) hdr.h.frame_id);
             // todo keep statistics
         }
         d->in_frame_id = hdr.h.frame_id;
@@ -1738,11 +3057,15 @@ static void handle_stream_in_frame(struct dev_s * d, uint32_t * p_u32) {
         } else if (hdr.h.port_id == (16U + 14U)) {
             handle_statistics_in(d, p_u32 + 1, hdr.h.length);
         } else {
-            handle_stream_in_port(d, hdr.h.port_id, p_u32 + 1, hdr.h.length);
-            if ((hdr.h.port_id == PORT_ID_VOLTAGE)
-                    && is_ivp_enabled(d)
-                    && !is_on_instrument_downsample_active(d)) {
-                compute_power(d);
+            uint32_t * payload = p_u32 + 1;
+            uint16_t length = (uint16_t) hdr.h.length;
+            if (hdr.h.codec) {
+                payload = port_decode(d, (uint8_t) hdr.h.port_id, (uint8_t) hdr.h.codec, payload, &length);
+            }
+            if (NULL != payload) {
+                stream_in_run_add(d, (uint8_t) hdr.h.port_id, payload, length);
+            } else {
+                jsdrv_continuity_drop(&d->ports[hdr.h.port_id & 0x0f].continuity);
             }
         }
     } else {
@@ -1759,13 +3082,161 @@ static void handle_stream_in_frame(struct dev_s * d, uint32_t * p_u32) {
     ++d->in_frame_count;
 }
 
+/*
+ * Send partial stream messages whose first data is older than
+ * h/stream/latency.  When samples arrive slower than real time, such
+ * as while the instrument changes rate, messages would otherwise
+ * wait for element_count_max samples.  The default latency keeps
+ * the sample count limit only.
+ */
+static void stream_in_flush_msg(struct dev_s * d, struct jsdrvp_msg_s ** msg_in, int64_t msg_in_time, int64_t now) {
+    struct jsdrvp_msg_s * m = *msg_in;
+    if ((NULL == m) || ((now - msg_in_time) < JSDRV_MILLISECONDS_TO_TIME(d->stream_latency_ms))) {
+        return;
+    }
+    struct jsdrv_stream_signal_s * s = (struct jsdrv_stream_signal_s *) m->value.value.bin;
+    if (s->element_count) {
+        *msg_in = NULL;
+        stream_msg_send(d, m);
+    }
+}
+
+static void stream_in_flush(struct dev_s * d) {
+    if (d->stream_latency_ms >= STREAM_LATENCY_MS_DEFAULT) {
+        return;
+    }
+    int64_t now = jsdrv_time_monotonic();
+    for (uint32_t idx = 0; idx < JSDRV_ARRAY_SIZE(d->ports); ++idx) {
+        struct port_s * port = &d->ports[idx];
+        stream_in_flush_msg(d, &port->msg_in, port->msg_in_time, now);
+        for (uint32_t k = 0; k < JSDRV_TAP_COUNT; ++k) {
+            stream_in_flush_msg(d, &port->taps[k].msg_in, port->taps[k].msg_in_time, now);
+        }
+    }
+}
+
+static void stream_in_oldest(struct jsdrvp_msg_s * m, int64_t msg_in_time, int64_t * oldest) {
+    if ((NULL == m) || (0 == ((struct jsdrv_stream_signal_s *) m->value.value.bin)->element_count)) {
+        return;  // stream_in_flush skips empty messages
+    }
+    if (msg_in_time < *oldest) {
+        *oldest = msg_in_time;
+    }
+}
+
+/*
+ * Get the time until stream_in_flush has work, or -1 when only new
+ * messages can create work.  The device thread waits using this value
+ * instead of waking periodically.
+ */
+static int32_t stream_in_flush_timeout_ms(struct dev_s * d) {
+    if (d->stream_latency_ms >= STREAM_LATENCY_MS_DEFAULT) {
+        return -1;
+    }
+    int64_t oldest = INT64_MAX;
+    for (uint32_t idx = 0; idx < JSDRV_ARRAY_SIZE(d->ports); ++idx) {
+        struct port_s * port = &d->ports[idx];
+        stream_in_oldest(port->msg_in, port->msg_in_time, &oldest);
+        for (uint32_t k = 0; k < JSDRV_TAP_COUNT; ++k) {
+            stream_in_oldest(port->taps[k].msg_in, port->taps[k].msg_in_time, &oldest);
+        }
+    }
+    if (INT64_MAX == oldest) {
+        return -1;
+    }
+    int64_t remaining = oldest + JSDRV_MILLISECONDS_TO_TIME(d->stream_latency_ms) - jsdrv_time_monotonic();
+    if (remaining <= 0) {
+        return 0;
+    }
+    return (int32_t) JSDRV_TIME_TO_MILLISECONDS(remaining) + 1;  // round up
+}
+
+/*
+ * Configure the framer channels for the enabled ports.  Channels
+ * follow FRAME_PORTS order, and power is a channel even when the
+ * host computes it.
+ */
+static void stream_frame_configure(struct dev_s * d) {
+    uint32_t mask = 0;
+    for (uint32_t idx = 0; idx < JSDRV_ARRAY_SIZE(FRAME_PORTS); ++idx) {
+        mask |= (0x00010000U << FRAME_PORTS[idx]);
+    }
+    mask &= d->stream_in_port_enable;
+    if (mask == d->frame_port_mask) {
+        return;
+    }
+    struct jsdrv_stream_frame_channel_s channels[JSDRV_STREAM_FRAME_CHANNELS_MAX];
+    uint8_t count = 0;
+    memset(d->frame_channel, FRAME_CHANNEL_NONE, sizeof(d->frame_channel));
+    for (uint32_t idx = 0; idx < JSDRV_ARRAY_SIZE(FRAME_PORTS); ++idx) {
+        uint8_t port_idx = FRAME_PORTS[idx];
+        if (0 == (mask & (0x00010000U << port_idx))) {
+            continue;
+        }
+        struct field_def_s * field_def = &PORT_MAP[port_idx];
+        channels[count].field_id = field_def->field_id;
+        channels[count].index = field_def->index;
+        channels[count].element_type = field_def->element_type;
+        channels[count].element_size_bits = field_def->element_size_bits;
+        channels[count].offset = 0;
+        d->frame_channel[port_idx] = count++;
+    }
+    jsdrv_framer_configure(d->framer, channels, count);
+    d->frame_port_mask = mask;
+}
+
+// Publish the completed s/frame/!data messages.
+static void stream_frame_publish(struct dev_s * d) {
+    uint32_t decimate_factor = jsdrv_framer_decimate_factor(d->framer);
+    if (0 == decimate_factor) {
+        return;
+    }
+    uint32_t element_count = stream_element_count_max(d, decimate_factor);
+    while (1) {
+        struct jsdrvp_msg_s * m = d->frame_msg;
+        if (NULL == m) {
+            m = jsdrvp_msg_alloc_data_sz(d->context, "", sizeof(struct jsdrv_stream_frame_s));
+            jsdrvp_msg_topic_set(m, &d->frame_topic);
+            m->value.app = JSDRV_PAYLOAD_TYPE_STREAM_FRAME;
+            d->frame_msg = m;
+        }
+        struct jsdrv_stream_frame_s * frame = (struct jsdrv_stream_frame_s *) m->value.value.bin;
+        uint32_t sz = jsdrv_framer_pop(d->framer, frame, element_count);
+        if (0 == sz) {
+            return;
+        }
+        frame->sample_rate = SAMPLING_FREQUENCY;
+        frame->time_map = d->time_map;
+        m->value.size = sz;
+        m->latency.usb = d->in_latency_usb;
+        d->frame_msg = NULL;
+        stream_msg_send(d, m);
+    }
+}
+
 static void handle_stream_in(struct dev_s * d, struct jsdrvp_msg_s * msg) {
     JSDRV_ASSERT(msg->value.type == JSDRV_UNION_BIN);
+    d->in_latency_usb = msg->latency.usb;
+    stream_rx_update(d, msg->value.size);
+    uint32_t depth = msg->extra.bkusb_stream.transfer_depth;
+    if (depth && (depth != d->bulk_in_depth_actual)) {
+        d->bulk_in_depth_actual = depth;
+        send_to_frontend(d, "h/usb/bulk_in/actual", &jsdrv_union_u32_r(depth));
+    }
+    if (NULL != d->framer) {
+        stream_frame_configure(d);
+    }
     uint32_t frame_count = (msg->value.size + FRAME_SIZE_BYTES - 1) / FRAME_SIZE_BYTES;
     for (uint32_t i = 0; i < frame_count; ++i) {
         uint32_t * p_u32 = (uint32_t *) &msg->value.value.bin[i * FRAME_SIZE_BYTES];
         handle_stream_in_frame(d, p_u32);
     }
+    stream_in_runs_flush(d);
+    if (NULL != d->framer) {
+        stream_frame_publish(d);
+    }
+    stream_in_flush(d);
+    continuity_publish(d);
 }
 
 static bool handle_rsp(struct dev_s * d, struct jsdrvp_msg_s * msg) {
@@ -1773,9 +3244,14 @@ static bool handle_rsp(struct dev_s * d, struct jsdrvp_msg_s * msg) {
     if (!msg) {
         return false;
     }
+    if ((OPEN_STEP_IDLE != d->open_step) && open_advance(d, msg)) {
+        return true;
+    }
     if (0 == strcmp(JSDRV_USBBK_MSG_STREAM_IN_DATA, msg->topic)) {
         JSDRV_LOGD3("stream_in_data sz=%d", (int) msg->value.size);
         handle_stream_in(d, msg);
+        msg->extra.bkusb_stream.transfer_skip = d->bulk_in_skip ? 1 : 0;  // adaptive depth pressure
+        d->bulk_in_skip = false;
         msg_queue_push(d->ll.cmd_q, msg);  // return
         return true;
     } else if (0 == strcmp(JSDRV_USBBK_MSG_BULK_OUT_DATA, msg->topic)) {
@@ -1795,10 +3271,69 @@ static bool handle_rsp(struct dev_s * d, struct jsdrvp_msg_s * msg) {
     return rv;
 }
 
+static void cmd_deferred_process(struct dev_s * d) {
+    struct jsdrv_list_s * item;
+    while ((OPEN_STEP_IDLE == d->open_step) && !d->do_exit
+            && (NULL != (item = jsdrv_list_remove_head(&d->cmd_deferred)))) {
+        handle_cmd(d, JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item));
+    }
+}
+
+static void driver_start(struct dev_s * d) {
+    // publish metadata for our host-side parameters
+    for (const struct jsdrvp_param_s * p = js220_params; p->topic; ++p) {
+        struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc_value(d->context, "", &jsdrv_union_json(p->meta));
+        tfp_snprintf(msg->topic, sizeof(msg->topic), "%s/%s$", d->ll.prefix, p->topic);
+        backend_send(d, msg);
+    }
+    update_state(d, ST_CLOSED);
+}
+
+// Process all pending messages and get the milliseconds to the next deadline, -1 for none.
+static int32_t driver_step(struct dev_s * d) {
+    JSDRV_TRACE_START(t_cmd);
+    while (handle_cmd(d, msg_queue_pop_immediate(d->ul.cmd_q))) {
+        ;
+    }
+    bulk_out_flush(d);
+    JSDRV_TRACE_END("dev_cmd", t_cmd, 0);
+    // note: ResetEvent handled automatically by msg_queue_pop_immediate
+    JSDRV_TRACE_START(t_rsp);
+    uint32_t rsp_count = 0;
+    while (handle_rsp(d, msg_queue_pop_immediate(d->ll.rsp_q))) {
+        ++rsp_count;
+    }
+    JSDRV_TRACE_END("dev_rsp", t_rsp, rsp_count);
+    open_advance(d, NULL);
+    open_expire(d);
+    cmd_deferred_process(d);
+    JSDRV_TRACE_START(t_flush);
+    stream_in_flush(d);
+    JSDRV_TRACE_END("dev_flush", t_flush, 0);
+
+    int32_t timeout_ms = stream_in_flush_timeout_ms(d);
+    int32_t open_ms = open_timeout_ms(d);
+    if ((open_ms >= 0) && ((timeout_ms < 0) || (open_ms < timeout_ms))) {
+        timeout_ms = open_ms;
+    }
+    return timeout_ms;
+}
+
+static void driver_stop(struct dev_s * d) {
+    struct jsdrv_list_s * item;
+    while (NULL != (item = jsdrv_list_remove_head(&d->cmd_deferred))) {
+        jsdrvp_msg_free(d->context, JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item));
+    }
+    if (d->bulk_out_pack) {
+        jsdrvp_msg_free(d->context, d->bulk_out_pack);
+        d->bulk_out_pack = NULL;
+    }
+}
+
 static THREAD_RETURN_TYPE driver_thread(THREAD_ARG_TYPE lpParam) {
-    struct jsdrvp_msg_s * msg;
     struct dev_s *d = (struct dev_s *) lpParam;
     JSDRV_LOGI("JS220 USB upper-level thread started for %s", d->ll.prefix);
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_DEVICE);
 
 #if _WIN32
     HANDLE handles[MAXIMUM_WAIT_OBJECTS];
@@ -1814,41 +3349,66 @@ static THREAD_RETURN_TYPE driver_thread(THREAD_ARG_TYPE lpParam) {
     fds[1].events = POLLIN;
 #endif
 
-    // publish metadata for our host-side parameters
-    for (const struct jsdrvp_param_s * p = js220_params; p->topic; ++p) {
-        msg = jsdrvp_msg_alloc_value(d->context, "", &jsdrv_union_json(p->meta));
-        tfp_snprintf(msg->topic, sizeof(msg->topic), "%s/%s$", d->ll.prefix, p->topic);
-        jsdrvp_backend_send(d->context, msg);
-        msg = NULL;
-    }
-
-    update_state(d, ST_CLOSED);
-
+    driver_start(d);
+    int32_t timeout_ms = -1;
     while (!d->do_exit) {
+        // block until the next message or timer deadline, no periodic wakeup
 #if _WIN32
-        WaitForMultipleObjects(handle_count, handles, false, 5000);
+        WaitForMultipleObjects(handle_count, handles, false, (timeout_ms < 0) ? INFINITE : (DWORD) timeout_ms);
 #else
-        poll(fds, 2, 2);
+        poll(fds, 2, timeout_ms);
 #endif
         JSDRV_LOGD2("ul thread tick");
-        while (handle_cmd(d, msg_queue_pop_immediate(d->ul.cmd_q))) {
-            ;
-        }
-        // note: ResetEvent handled automatically by msg_queue_pop_immediate
-        while (handle_rsp(d, msg_queue_pop_immediate(d->ll.rsp_q))) {
-            ;
-        }
+        timeout_ms = driver_step(d);
     }
+    driver_stop(d);
 
     JSDRV_LOGI("JS220 USB upper-level thread done %s", d->ll.prefix);
+    jsdrv_thread_unregister();
     THREAD_RETURN();
 }
 
+// The jsdrv_executor_fn for JSDRV_ARG_DEVICE_THREADS.
+static int32_t driver_task(void * user_data) {
+    struct dev_s * d = (struct dev_s *) user_data;
+    if (d->task_done) {
+        return -1;
+    }
+    if (!d->task_started) {
+        JSDRV_LOGI("JS220 USB upper-level task started for %s", d->ll.prefix);
+        d->task_started = true;
+        driver_start(d);
+    }
+    int32_t timeout_ms = driver_step(d);
+    if (d->do_exit) {
+        driver_stop(d);
+        JSDRV_LOGI("JS220 USB upper-level task done %s", d->ll.prefix);
+        jsdrv_atomic_store(&d->task_done, 1);
+        return -1;
+    }
+    return timeout_ms;
+}
+
 static void join(struct jsdrvp_ul_device_s * device) {
     struct dev_s * d = (struct dev_s *) device;
     jsdrvp_send_finalize_msg(d->context, d->ul.cmd_q, "");
-    // and wait for thread to exit.
-    jsdrv_thread_join(&d->thread, 1000);
+    if (d->task) {
+        // and wait for the task to exit.
+        for (uint32_t t_start = jsdrv_time_ms_u32(); !jsdrv_atomic_load(&d->task_done); ) {
+            if ((jsdrv_time_ms_u32() - t_start) >= 1000) {
+                JSDRV_LOGW("JS220 USB upper-level task join timed out %s", d->ll.prefix);
+                break;
+            }
+            jsdrv_thread_sleep_ms(1);
+        }
+        msg_queue_notify_set(d->ul.cmd_q, NULL, NULL);
+        msg_queue_notify_set(d->ll.rsp_q, NULL, NULL);
+        jsdrv_executor_task_remove(d->task);
+        d->task = NULL;
+    } else {
+        // and wait for thread to exit.
+        jsdrv_thread_join(&d->thread, 1000);
+    }
 
     for (uint32_t idx = 0; idx < JSDRV_ARRAY_SIZE(d->ports); ++idx) {
         struct port_s *p = &d->ports[idx];
@@ -1860,7 +3420,12 @@ static void join(struct jsdrvp_ul_device_s * device) {
             jsdrv_downsample_free(p->downsample);
             p->downsample = NULL;
         }
+        port_downsample_cancel(p);
+        port_taps_free(d, p);
     }
+    frame_free(d);
+    jsdrv_power_align_free(d->power_align);
+    jsdrv_gate_free(d->gate);
     jsdrv_free(d);
 }
 
@@ -1873,12 +3438,69 @@ int32_t jsdrvp_ul_js220_usb_factory(struct jsdrvp_ul_device_s ** device, struct
     JSDRV_LOGD3("jsdrvp_ul_js220_usb_factory %p", d);
     d->i_scale = 1.0f;
     d->v_scale = 1.0f;
+    d->bulk_in_depth = JSDRV_USBBK_BULK_IN_DEPTH_DEFAULT;
+    d->bulk_in_size = JSDRV_USBBK_BULK_IN_SIZE_DEFAULT;
+    d->bulk_in_spare = JSDRV_USBBK_BULK_IN_SPARE_DEFAULT;
+    d->stream_latency_ms = STREAM_LATENCY_MS_DEFAULT;
+    d->qos = JSDRVP_QOS_NORMAL;
+    d->power_align = jsdrv_power_align_alloc(JSDRV_POWER_ALIGN_WINDOW_DEFAULT, on_power, d);
+    d->gate = jsdrv_gate_alloc(SAMPLING_FREQUENCY, 2, on_gate, d);
+    for (uint32_t idx = 0; idx < JSDRV_TRIGGER_COUNT; ++idx) {
+        jsdrv_trigger_initialize(&d->triggers[idx], (uint8_t) idx);
+    }
+    for (uint32_t idx = 0; idx < JSDRV_PROC_SIGNAL_COUNT; ++idx) {
+        jsdrv_proc_initialize(&d->procs[idx]);
+    }
     on_sampling_frequency(d, &jsdrv_union_u32_r(SAMPLING_FREQUENCY));
     d->context = context;
     d->ll = *ll;
     d->ul.cmd_q = msg_queue_init();
+    msg_queue_lanes_enable(d->ul.cmd_q);
     d->ul.join = join;
-    if (jsdrv_thread_create(&d->thread, driver_thread, d, 1)) {
+    jsdrv_list_initialize(&d->cmd_deferred);
+    for (uint32_t idx = 0; idx < PORTS_LENGTH; ++idx) {
+        if (NULL != PORT_MAP[idx].data_topic) {
+            jsdrvp_topic_init(&d->ports[idx].topic, d->ll.prefix, PORT_MAP[idx].data_topic);
+        }
+        if ((NULL != PORT_MAP[idx].data_topic) && jsdrv_cstr_ends_with(PORT_MAP[idx].data_topic, "/!data")) {
+            char subtopic[JSDRV_TOPIC_LENGTH_MAX];
+            jsdrv_cstr_copy(subtopic, PORT_MAP[idx].data_topic, sizeof(subtopic));
+            subtopic[strlen(subtopic) - 5] = 0;  // remove "!data"
+            jsdrv_cstr_join(subtopic, subtopic, "gaps", sizeof(subtopic));
+            jsdrvp_topic_init(&d->ports[idx].continuity_topic, d->ll.prefix, subtopic);
+            jsdrv_continuity_clear(&d->ports[idx].continuity);
+            d->ports[idx].continuity.changed = false;  // publish on the first event
+        }
+        if ((NULL != PORT_MAP[idx].data_topic) && (JSDRV_DATA_TYPE_FLOAT == PORT_MAP[idx].element_type)) {
+            for (uint32_t k = 0; k < JSDRV_TAP_COUNT; ++k) {
+                struct jsdrv_topic_s t;
+                jsdrv_topic_set(&t, PORT_MAP[idx].data_topic);
+                jsdrv_topic_remove(&t);  // remove "!data"
+                jsdrv_topic_append(&t, "tap");
+                char index[2] = {(char) ('0' + k), 0};
+                jsdrv_topic_append(&t, index);
+                jsdrv_topic_append(&t, "!data");
+                jsdrvp_topic_init(&d->ports[idx].taps[k].topic, d->ll.prefix, t.topic);
+            }
+        }
+    }
+    jsdrvp_topic_init(&d->stats_topic, d->ll.prefix, "s/stats/value");
+    jsdrvp_topic_init(&d->host_stats_topic, d->ll.prefix, "s/stats/host/value");
+    jsdrvp_topic_init(&d->host_derived_topic, d->ll.prefix, "s/stats/host/derived");
+    jsdrvp_topic_init(&d->gate_topic, d->ll.prefix, "s/gate/value");
+    jsdrvp_topic_init(&d->frame_topic, d->ll.prefix, "s/frame/!data");
+    jsdrv_topic_index_init(&d->host_param_index, HOST_PARAMS, sizeof(HOST_PARAMS[0]),
+                           offsetof(struct host_param_s, topic), JSDRV_ARRAY_SIZE(HOST_PARAMS),
+                           d->host_param_index_storage);
+    jsdrv_topic_index_init(&d->port_ctrl_index, PORT_MAP, sizeof(PORT_MAP[0]),
+                           offsetof(struct field_def_s, ctrl_topic), JSDRV_ARRAY_SIZE(PORT_MAP),
+                           d->port_ctrl_index_storage);
+    struct jsdrv_executor_s * executor = jsdrvp_executor(context);
+    if (executor) {
+        d->task = jsdrv_executor_task_add(executor, driver_task, d);
+        msg_queue_notify_set(d->ul.cmd_q, jsdrv_executor_task_signal, d->task);
+        msg_queue_notify_set(d->ll.rsp_q, jsdrv_executor_task_signal, d->task);
+    } else if (jsdrv_thread_create(&d->thread, driver_thread, d, 1)) {
         return JSDRV_ERROR_UNSPECIFIED;
     }
     *device = &d->ul;
@@ -24,26 +24,57 @@
 #include "jsdrv.h"
 #include "jsdrv/version.h"
 #include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/alloc.h"
 #include "jsdrv_prv/assert.h"
+#include "jsdrv_prv/atomic.h"
 #include "jsdrv_prv/log.h"
+#include "jsdrv_prv/mutex.h"
 #include "jsdrv_prv/backend.h"
+#include "jsdrv_prv/align.h"
+#include "jsdrv_prv/api_timeout.h"
 #include "jsdrv_prv/buffer.h"
 #include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/cpu.h"
+#include "jsdrv_prv/dispatch.h"
+#include "jsdrv_prv/executor.h"
 #include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/latency.h"
 #include "jsdrv_prv/pubsub.h"
+#include "jsdrv_prv/record.h"
+#include "jsdrv_prv/shm.h"
+#include "jsdrv_prv/simd_f32.h"
+#include "jsdrv_prv/stats_all.h"
+#include "jsdrv_prv/stats_history.h"
 #include "jsdrv_prv/thread.h"
+#include "jsdrv_prv/trace.h"
 #include "jsdrv_prv/msg_queue.h"
+#include "jsdrv_prv/perf.h"
 #include "jsdrv/cstr.h"
 #include "jsdrv/time.h"
 #include "jsdrv/error_code.h"
 #include "jsdrv/topic.h"
+#include "tinyprintf.h"
 
 
 #define DEVICE_COUNT_MAX    (256U)  // 255 Joulescopes attached to 1 host should be enough
 #define BACKEND_COUNT_MAX   (127U)  // Allow prefixes 0-9, a-z, A-Z
 #define DEVICE_LOOKUP_MAX   (BACKEND_COUNT_MAX * DEVICE_COUNT_MAX)
 #define API_TIMEOUT_MS      (3000)
+#define API_EVENT_POOL_MAX  (16U)   // cached completion events for blocking API calls
 #define FRONTEND_THREAD_POLL_MS  (1000)
+#define POOL_PUBLISH_INTERVAL       (JSDRV_TIME_SECOND)
+#define POOL_MSG_PREALLOC_DEFAULT   (64U)
+#define POOL_MSG_MAX_DEFAULT        (4096U)
+#define POOL_SMALL_PREALLOC_DEFAULT (64U)
+#define POOL_SMALL_MAX_DEFAULT      (4096U)
+#ifndef JSDRV_POOL_DATA_PREALLOC
+#define JSDRV_POOL_DATA_PREALLOC    (16U)
+#endif
+#ifndef JSDRV_POOL_DATA_MAX
+#define JSDRV_POOL_DATA_MAX         (256U)
+#endif
+#define POOL_DATA_PREALLOC_DEFAULT  (JSDRV_POOL_DATA_PREALLOC)
+#define POOL_DATA_MAX_DEFAULT       (JSDRV_POOL_DATA_MAX)   // per size class
 
 #ifndef UNITTEST
 #define UNITTEST 0
@@ -53,16 +84,66 @@
 JSDRV_STATIC_ASSERT(DEVICE_LOOKUP_MAX < UINT16_MAX, too_many_devices);
 JSDRV_STATIC_ASSERT(JSDRV_STREAM_HEADER_SIZE == offsetof(struct jsdrv_stream_signal_s, data), jsdrv_stream_signal_s_header_size);
 JSDRV_STATIC_ASSERT(JSDRV_STREAM_DATA_SIZE == (sizeof(struct jsdrv_stream_signal_s) - JSDRV_STREAM_HEADER_SIZE), sizeof_jsdrv_stream_signal_s);
-static const size_t STREAM_MSG_SZ = sizeof(struct jsdrvp_msg_s) - sizeof(union jsdrvp_payload_u) + sizeof(struct jsdrv_stream_signal_s);
+JSDRV_STATIC_ASSERT((JSDRV_STREAM_DATA_SIZE >= 16384) && (0 == (JSDRV_STREAM_DATA_SIZE % 4096)), stream_data_size);  // above the 8k pool
+JSDRV_STATIC_ASSERT(JSDRV_STREAM_FRAME_HEADER_SIZE == offsetof(struct jsdrv_stream_frame_s, data), jsdrv_stream_frame_s_header_size);
+JSDRV_STATIC_ASSERT(sizeof(struct jsdrv_stream_signal_s) == sizeof(struct jsdrv_stream_frame_s), sizeof_jsdrv_stream_frame_s);
+
+// data message payload size classes, in increasing order
+static const uint32_t DATA_POOL_CAPACITY[] = {
+    JSDRV_STREAM_HEADER_SIZE + 1024,
+    JSDRV_STREAM_HEADER_SIZE + 8 * 1024,
+    sizeof(struct jsdrv_stream_signal_s),
+};
+static const char * DATA_POOL_TOPIC[] = {
+    JSDRV_MSG_POOL_DATA "/1k",
+    JSDRV_MSG_POOL_DATA "/8k",
+    JSDRV_MSG_POOL_DATA "/64k",
+};
+#define DATA_POOL_COUNT (JSDRV_ARRAY_SIZE(DATA_POOL_CAPACITY))
 
 struct frontend_dev_s {
     char prefix[JSDRV_TOPIC_LENGTH_MAX];
     struct jsdrv_context_s * context;
     struct jsdrvp_ul_device_s * device;
+    int32_t open_mode;          // the JSDRV_MSG_OPEN value
+    bool is_open;               // JSDRV_MSG_OPEN without a later JSDRV_MSG_CLOSE
+    char restore_topic[JSDRV_TOPIC_LENGTH_MAX];  // the writable topic of the last restore metadata
+    bool route_pending;         // enable routed after pubsub processes the add subscriptions
+    bool routed;                // guarded by route_mutex, accepts direct commands
+    struct jsdrv_list_s item;
+};
+
+/// A removed open device that JSDRV_MSG_REOPEN reopens when it returns.
+struct reconnect_s {
+    char prefix[JSDRV_TOPIC_LENGTH_MAX];
+    int32_t open_mode;
+    int64_t deadline;           // jsdrv_time_utc()
     struct jsdrv_list_s item;
 };
 
 
+/**
+ * @brief A message pool.
+ *
+ * Allocation first takes a message from the free list, then falls
+ * back to the heap.  Free returns the message to the free list unless
+ * the pool already holds max messages, in which case the message
+ * returns to the heap.  Allocation never fails, so bursts still
+ * succeed, but the retained memory is bounded.
+ */
+struct msg_pool_s {
+    const char * topic;                 // telemetry topic prefix
+    struct msg_queue_s * free_q;
+    size_t msg_size;
+    uint32_t capacity;                  // payload capacity in bytes
+    int32_t max;                        // maximum retained messages, 0 for unlimited
+    volatile int32_t allocated;         // messages allocated, free + in use
+    volatile int32_t in_use;
+    volatile int32_t high_water;        // maximum in_use
+    volatile int32_t heap_fallbacks;    // allocations with empty free list
+    int32_t published[4];               // last published counter values
+};
+
 enum state_e {
     ST_INIT_AWAITING_FRONTEND,
     ST_INIT_AWAITING_BACKEND,
@@ -71,70 +152,239 @@ enum state_e {
 };
 
 struct jsdrv_context_s {
-    struct msg_queue_s * msg_free;
-    struct msg_queue_s * msg_free_data;
+    struct msg_pool_s pool_msg;
+    struct msg_pool_s pool_small;
+    struct msg_pool_s pool_data[DATA_POOL_COUNT];
     struct msg_queue_s * msg_cmd;       // from API (any thread) to jsdrv thread
     struct msg_queue_s * msg_backend;   // backend thread(s) to jsdrv thread
 
     const struct jsdrv_arg_s * args;
     enum state_e state;
+    bool device_list_pending;  // JSDRV_MSG_DEVICE_LIST changed during initialization
     int32_t init_status;  // 0 or first reported backend error code.
     struct jsdrvbk_s * backends[BACKEND_COUNT_MAX];
     struct jsdrv_pubsub_s * pubsub;
-    struct jsdrv_list_s devices;          // frontend_dev_s
-    struct jsdrv_list_s cmd_timeouts;
+    struct jsdrv_dispatch_s * dispatch;   // optional data plane threads
+    struct jsdrv_executor_s * executor;   // optional shared device driver threads
+    struct jsdrv_buffer_mgr_s * buffer_mgr;
+    struct jsdrv_align_svc_s * align;
+    struct jsdrv_record_svc_s * record;
+    struct jsdrv_shm_svc_s * shm;
+    struct jsdrv_thread_svc_s * thread_svc;
+    struct jsdrv_stats_all_svc_s * stats_all;
+    struct jsdrv_stats_history_svc_s * stats_history;
+    char * cal_cache_path;                // JSDRV_ARG_JS110_CAL_CACHE or NULL
+    struct jsdrv_list_s devices;          // frontend_dev_s, modify only with route_mutex
+    jsdrv_os_mutex_t route_mutex;         // guards devices changes and routed
+    bool route_pending;                   // a device has route_pending set
+    int32_t direct_count;                 // direct command values applied this frontend wake
+    struct jsdrv_list_s reconnects;       // reconnect_s
+    uint32_t reconnect_ms;                // JSDRV_MSG_REOPEN, 0 to disable
+    struct jsdrv_api_timeouts_s cmd_timeouts;  // only accessed from the jsdrv thread
+    jsdrv_os_mutex_t ev_pool_mutex;
+    jsdrv_os_event_t ev_pool[API_EVENT_POOL_MAX];
+    uint32_t ev_pool_count;
+    volatile int32_t cmd_pending;       // msg_cmd messages not yet fully processed
+    int64_t pool_publish_time;
+    uint64_t perf_published[JSDRV_PERF_COUNT];
+    uint64_t alloc_published[JSDRV_ALLOC_CAT_COUNT][3];
+    uint64_t latency_published[JSDRV_LATENCY_STAGE_COUNT][JSDRV_LATENCY_BINS];
     jsdrv_thread_t thread;
 
     volatile bool do_exit;
 };
 
-struct jsdrvp_msg_s * jsdrvp_msg_alloc(struct jsdrv_context_s * context) {
-    struct jsdrvp_msg_s * m = msg_queue_pop_immediate(context->msg_free);
+const struct jsdrv_union_s * jsdrvp_arg_get(struct jsdrv_context_s * context, const char * topic) {
+    const struct jsdrv_arg_s * arg = context->args;
+    if ((NULL == arg) || (NULL == topic)) {
+        return NULL;
+    }
+    for (; (NULL != arg->topic) && arg->topic[0]; ++arg) {
+        if (0 == strcmp(arg->topic, topic)) {
+            return &arg->value;
+        }
+    }
+    return NULL;
+}
+
+const char * jsdrvp_cal_cache_path(struct jsdrv_context_s * context) {
+    return context->cal_cache_path;
+}
+
+struct jsdrv_executor_s * jsdrvp_executor(struct jsdrv_context_s * context) {
+    return context->executor;
+}
+
+static char * arg_str_copy(struct jsdrv_context_s * context, const char * topic) {
+    const struct jsdrv_union_s * arg = jsdrvp_arg_get(context, topic);
+    if (NULL == arg) {
+        return NULL;
+    } else if ((arg->type != JSDRV_UNION_STR) || (NULL == arg->value.str) || !arg->value.str[0]) {
+        JSDRV_LOGW("invalid argument type for %s", topic);
+        return NULL;
+    }
+    size_t sz = strlen(arg->value.str) + 1;
+    char * s = jsdrv_alloc(sz);
+    memcpy(s, arg->value.str, sz);
+    return s;
+}
+
+static uint32_t arg_u32(struct jsdrv_context_s * context, const char * topic, uint32_t default_value) {
+    const struct jsdrv_union_s * arg = jsdrvp_arg_get(context, topic);
+    if (NULL != arg) {
+        struct jsdrv_union_s v = *arg;
+        if (0 == jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+            return v.value.u32;
+        }
+        JSDRV_LOGW("invalid argument type for %s", topic);
+    }
+    return default_value;
+}
+
+static struct jsdrvp_msg_s * pool_alloc(struct msg_pool_s * pool) {
+    struct jsdrvp_msg_s * m = msg_queue_pop_immediate(pool->free_q);
     if (!m) {
-        m = jsdrv_alloc_clr(sizeof(struct jsdrvp_msg_s));
-        JSDRV_LOGD3("jsdrvp_msg_alloc %p", m);
+        m = jsdrv_alloc_clr_cat(pool->msg_size, JSDRV_ALLOC_CAT_MSG);
+        JSDRV_LOGD3("pool_alloc %s %p sz=%zu", pool->topic, m, pool->msg_size);
         jsdrv_list_initialize(&m->item);
+        jsdrv_atomic_add(&pool->allocated, 1);
+        jsdrv_atomic_add(&pool->heap_fallbacks, 1);
+    }
+    m->capacity = pool->capacity;
+    int32_t in_use = jsdrv_atomic_add(&pool->in_use, 1);
+    if (in_use > jsdrv_atomic_load(&pool->high_water)) {
+        jsdrv_atomic_store(&pool->high_water, in_use);  // approximate under contention
+    }
+    return m;
+}
+
+static void pool_free(struct msg_pool_s * pool, struct jsdrvp_msg_s * msg, bool do_exit) {
+    jsdrv_atomic_add(&pool->in_use, -1);
+    if (do_exit || ((pool->max > 0) && (jsdrv_atomic_load(&pool->allocated) > pool->max))) {
+        jsdrv_atomic_add(&pool->allocated, -1);
+        jsdrv_free(msg);
+    } else {
+        msg_queue_push(pool->free_q, msg);
+    }
+}
+
+static int32_t pool_initialize(struct msg_pool_s * pool, const char * topic, uint32_t capacity,
+        uint32_t prealloc, uint32_t max) {
+    size_t msg_size = offsetof(struct jsdrvp_msg_s, payload) + capacity;
+    if ((capacity > JSDRVP_MSG_SMALL_PAYLOAD_SIZE) && (msg_size < sizeof(struct jsdrvp_msg_s))) {
+        msg_size = sizeof(struct jsdrvp_msg_s);
+    }
+    pool->topic = topic;
+    pool->msg_size = msg_size;
+    pool->capacity = capacity;
+    pool->max = (int32_t) max;
+    pool->free_q = msg_queue_init();
+    if (NULL == pool->free_q) {
+        return JSDRV_ERROR_NOT_ENOUGH_MEMORY;
     }
+    if (max && (prealloc > max)) {
+        prealloc = max;
+    }
+    for (uint32_t i = 0; i < prealloc; ++i) {
+        struct jsdrvp_msg_s * m = jsdrv_alloc_clr_cat(msg_size, JSDRV_ALLOC_CAT_MSG);
+        jsdrv_list_initialize(&m->item);
+        msg_queue_push(pool->free_q, m);
+    }
+    pool->allocated = (int32_t) prealloc;
+    for (uint32_t i = 0; i < JSDRV_ARRAY_SIZE(pool->published); ++i) {
+        pool->published[i] = -1;  // force first publish
+    }
+    return 0;
+}
+
+static void pool_finalize(struct msg_pool_s * pool) {
+    if (pool->free_q) {
+        msg_queue_finalize(pool->free_q);
+        pool->free_q = NULL;
+    }
+}
+
+void jsdrvp_topic_init(struct jsdrvp_topic_s * topic, const char * prefix, const char * subtopic) {
+    tfp_snprintf(topic->topic, sizeof(topic->topic), "%s/%s", prefix, subtopic);
+    topic->length = (uint32_t) strlen(topic->topic);
+    topic->hash = jsdrv_pubsub_topic_hash(topic->topic);
+}
+
+void jsdrvp_msg_topic_set(struct jsdrvp_msg_s * msg, const struct jsdrvp_topic_s * topic) {
+    memcpy(msg->topic, topic->topic, topic->length + 1);
+    msg->topic_hash = topic->hash;
+}
+
+static struct jsdrvp_msg_s * msg_init(struct jsdrvp_msg_s * m) {
     m->inner_msg_type = JSDRV_MSG_TYPE_NORMAL;
     m->source = 0;
     m->u32_a = 0;
     m->u32_b = 0;
+    m->topic_hash = 0;
     m->topic[0] = 0;
     memset(&m->value, 0, sizeof(m->value));
     m->payload.str[0] = 0;
     memset(&m->extra, 0, sizeof(m->extra));
+    memset(&m->latency, 0, sizeof(m->latency));
+    m->qos = JSDRVP_QOS_NORMAL;
     m->timeout = NULL;
+    m->refcnt = 1;
     return m;
 }
 
+struct jsdrvp_msg_s * jsdrvp_msg_alloc(struct jsdrv_context_s * context) {
+    return msg_init(pool_alloc(&context->pool_msg));
+}
+
+struct jsdrvp_msg_s * jsdrvp_msg_alloc_small(struct jsdrv_context_s * context) {
+    return msg_init(pool_alloc(&context->pool_small));
+}
+
 struct jsdrvp_msg_s * jsdrvp_msg_alloc_data(struct jsdrv_context_s * context, const char * topic) {
-    struct jsdrvp_msg_s * m = msg_queue_pop_immediate(context->msg_free_data);
-    if (!m) {
-        m = jsdrv_alloc_clr(STREAM_MSG_SZ);
-        JSDRV_LOGD3("jsdrvp_msg_alloc_data %p sz=%zu", m, STREAM_MSG_SZ);
-        jsdrv_list_initialize(&m->item);
+    return jsdrvp_msg_alloc_data_sz(context, topic, sizeof(struct jsdrv_stream_signal_s));
+}
+
+struct jsdrvp_msg_s * jsdrvp_msg_alloc_data_sz(struct jsdrv_context_s * context, const char * topic, uint32_t size) {
+    uint32_t idx = 0;
+    while ((idx < (DATA_POOL_COUNT - 1)) && (size > DATA_POOL_CAPACITY[idx])) {
+        ++idx;
     }
+    struct jsdrvp_msg_s * m = pool_alloc(&context->pool_data[idx]);
     m->inner_msg_type = JSDRV_MSG_TYPE_DATA;
     m->source = 0;
     m->u32_a = 0;
     m->u32_b = 0;
+    m->topic_hash = 0;
     jsdrv_cstr_copy(m->topic, topic, sizeof(m->topic));
     m->value = jsdrv_union_bin(&m->payload.bin[0], 0);
     memset(&m->extra, 0, sizeof(m->extra));
+    memset(&m->latency, 0, sizeof(m->latency));
+    m->qos = JSDRVP_QOS_NORMAL;
     m->timeout = NULL;
+    m->refcnt = 1;
     return m;
 }
 
 struct jsdrvp_msg_s * jsdrvp_msg_clone(struct jsdrv_context_s * context, const struct jsdrvp_msg_s * msg_src) {
     struct jsdrvp_msg_s * m;
     if (msg_src->inner_msg_type == JSDRV_MSG_TYPE_DATA) {
-        m = jsdrvp_msg_alloc_data(context, msg_src->topic);
+        m = jsdrvp_msg_alloc_data_sz(context, msg_src->topic, msg_src->value.size);
+        m->topic_hash = msg_src->topic_hash;
+        m->latency = msg_src->latency;
+        m->qos = msg_src->qos;
         m->value = msg_src->value;
         m->value.value.bin = &m->payload.bin[0];
         memcpy(m->payload.bin, msg_src->payload.bin, msg_src->value.size);
     } else {
         m = jsdrvp_msg_alloc(context);
-        *m = *msg_src;
+        uint32_t capacity = m->capacity;
+        uint32_t sz = capacity;
+        if (msg_src->capacity && (msg_src->capacity < capacity)) {
+            sz = msg_src->capacity;  // small message
+        }
+        memcpy(m, msg_src, offsetof(struct jsdrvp_msg_s, payload) + sz);
+        m->capacity = capacity;
+        m->refcnt = 1;
         switch (m->value.type) {
             case JSDRV_UNION_JSON:  // intentional fall-through
             case JSDRV_UNION_STR:
@@ -142,7 +392,7 @@ struct jsdrvp_msg_s * jsdrvp_msg_clone(struct jsdrv_context_s * context, const s
                 break;
             case JSDRV_UNION_BIN:
                 if (m->value.flags & JSDRV_UNION_FLAG_HEAP_MEMORY) {
-                    uint8_t *ptr = jsdrv_alloc(m->value.size);
+                    uint8_t *ptr = jsdrv_alloc_cat(m->value.size, JSDRV_ALLOC_CAT_MSG);
                     memcpy(ptr, m->value.value.bin, m->value.size);
                     m->value.value.bin = ptr;
                 } else {
@@ -157,6 +407,36 @@ struct jsdrvp_msg_s * jsdrvp_msg_clone(struct jsdrv_context_s * context, const s
     return m;
 }
 
+struct jsdrvp_msg_s * jsdrvp_msg_compact(struct jsdrv_context_s * context, struct jsdrvp_msg_s * msg) {
+    if ((JSDRV_MSG_TYPE_NORMAL != msg->inner_msg_type) || (msg->capacity <= JSDRVP_MSG_SMALL_PAYLOAD_SIZE)
+            || (1 != jsdrv_atomic_load(&msg->refcnt))) {
+        return msg;
+    }
+    uint32_t sz = 0;
+    if (jsdrv_union_is_type_ptr(&msg->value)) {
+        if ((msg->value.flags & JSDRV_UNION_FLAG_HEAP_MEMORY) || (msg->value.value.bin != msg->payload.bin)) {
+            return msg;
+        }
+        sz = msg->value.size;
+        if ((0 == sz) && (JSDRV_UNION_BIN != msg->value.type)) {
+            sz = (uint32_t) strlen(msg->payload.str) + 1;
+        }
+        if (sz > JSDRVP_MSG_SMALL_PAYLOAD_SIZE) {
+            return msg;
+        }
+    }
+    struct jsdrvp_msg_s * m = pool_alloc(&context->pool_small);
+    uint32_t capacity = m->capacity;
+    memcpy(m, msg, offsetof(struct jsdrvp_msg_s, payload) + sz);
+    jsdrv_list_initialize(&m->item);
+    m->capacity = capacity;
+    if (sz) {
+        m->value.value.bin = m->payload.bin;
+    }
+    jsdrvp_msg_free(context, msg);
+    return m;
+}
+
 struct jsdrvp_msg_s * jsdrvp_msg_alloc_value(struct jsdrv_context_s * context, const char * topic, const struct jsdrv_union_s * value) {
     struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
     jsdrv_cstr_copy(m->topic, topic, sizeof(m->topic));
@@ -171,10 +451,10 @@ struct jsdrvp_msg_s * jsdrvp_msg_alloc_value(struct jsdrv_context_s * context, c
             }
             /* intentional fall-through */
         case JSDRV_UNION_BIN:
-            if (value->size > sizeof(m->payload.bin)) {
-                JSDRV_LOGD2("publish %s size %d using heap", topic, (int) value->size);
-                uint8_t * ptr = jsdrv_alloc(value->size);
-                memcpy(ptr, value->value.bin, value->size);
+            if (m->value.size > sizeof(m->payload.bin)) {
+                JSDRV_LOGD2("publish %s size %d using heap", topic, (int) m->value.size);
+                uint8_t * ptr = jsdrv_alloc_cat(m->value.size, JSDRV_ALLOC_CAT_MSG);
+                memcpy(ptr, value->value.bin, m->value.size);
                 m->value.value.bin = ptr;
                 m->value.flags |= JSDRV_UNION_FLAG_HEAP_MEMORY;
             } else {
@@ -197,7 +477,7 @@ struct jsdrvp_msg_s * jsdrvp_msg_alloc_str(struct jsdrv_context_s * context, con
 }
 
 struct jsdrvp_msg_s * jsdrvp_msg_alloc_i32(struct jsdrv_context_s * context, const char * topic, int32_t value) {
-    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_small(context);
     jsdrv_cstr_copy(m->topic, topic, sizeof(m->topic));
     m->value = jsdrv_union_i32_r(value);
     return m;
@@ -210,15 +490,110 @@ struct jsdrvp_msg_s * jsdrvp_msg_alloc_u32(struct jsdrv_context_s * context, con
     return m;
 }
 
+static void pool_publish(struct jsdrv_context_s * c, struct msg_pool_s * pool) {
+    static const char * names[] = {"alloc", "in_use", "peak", "heap"};  // <= 7 chars per level
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    int32_t values[] = {
+        jsdrv_atomic_load(&pool->allocated),
+        jsdrv_atomic_load(&pool->in_use),
+        jsdrv_atomic_load(&pool->high_water),
+        jsdrv_atomic_load(&pool->heap_fallbacks),
+    };
+    for (uint32_t i = 0; i < JSDRV_ARRAY_SIZE(values); ++i) {
+        if (values[i] != pool->published[i]) {
+            pool->published[i] = values[i];
+            tfp_snprintf(topic, sizeof(topic), "%s/%s", pool->topic, names[i]);
+            struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_u32(c, topic, (uint32_t) values[i]);
+            jsdrv_pubsub_publish(c->pubsub, m);
+        }
+    }
+}
+
+static void u64_publish(struct jsdrv_context_s * c, const char * topic, uint64_t value) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(c);
+    jsdrv_cstr_copy(m->topic, topic, sizeof(m->topic));
+    m->value = jsdrv_union_u64_r(value);
+    jsdrv_pubsub_publish(c->pubsub, m);
+}
+
+static void perf_publish(struct jsdrv_context_s * c) {
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    for (uint32_t i = 0; i < JSDRV_PERF_COUNT; ++i) {
+        uint64_t value = jsdrv_perf_get(i);
+        if (value != c->perf_published[i]) {
+            c->perf_published[i] = value;
+            tfp_snprintf(topic, sizeof(topic), "%s/%s", JSDRV_MSG_PERF, jsdrv_perf_name(i));
+            u64_publish(c, topic, value);
+        }
+    }
+}
+
+static void alloc_publish(struct jsdrv_context_s * c) {
+    static const char * names[] = {"bytes", "count", "peak"};
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    struct jsdrv_alloc_cat_stats_s stats;
+    for (uint32_t cat = 0; cat < JSDRV_ALLOC_CAT_COUNT; ++cat) {
+        jsdrv_alloc_cat_stats_get(cat, &stats);
+        uint64_t values[] = {stats.bytes, stats.count, stats.peak};
+        for (uint32_t i = 0; i < JSDRV_ARRAY_SIZE(values); ++i) {
+            if (values[i] != c->alloc_published[cat][i]) {
+                c->alloc_published[cat][i] = values[i];
+                tfp_snprintf(topic, sizeof(topic), "%s/%s/%s", JSDRV_MSG_ALLOC, jsdrv_alloc_cat_name(cat), names[i]);
+                u64_publish(c, topic, values[i]);
+            }
+        }
+    }
+}
+
+static void latency_publish(struct jsdrv_context_s * c) {
+    static const uint32_t PERCENTILES[] = {500, 990, 999};
+    static const char * PERCENTILE_NAMES[] = {"p50", "p99", "p999"};
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    uint64_t bins[JSDRV_LATENCY_BINS];
+    for (uint32_t stage = 0; stage < JSDRV_LATENCY_STAGE_COUNT; ++stage) {
+        uint64_t * published = c->latency_published[stage];
+        uint64_t count = 0;
+        jsdrv_latency_get(stage, bins);
+        for (uint32_t i = 0; i < JSDRV_LATENCY_BINS; ++i) {
+            uint64_t v = bins[i];
+            bins[i] = v - published[i];  // since the previous update
+            published[i] = v;
+            count += bins[i];
+        }
+        if (0 == count) {
+            continue;
+        }
+        const char * name = jsdrv_latency_stage_name(stage);
+        tfp_snprintf(topic, sizeof(topic), "%s/%s/count", JSDRV_MSG_LATENCY, name);
+        u64_publish(c, topic, count);
+        for (uint32_t i = 0; i < JSDRV_ARRAY_SIZE(PERCENTILES); ++i) {
+            tfp_snprintf(topic, sizeof(topic), "%s/%s/%s", JSDRV_MSG_LATENCY, name, PERCENTILE_NAMES[i]);
+            u64_publish(c, topic, jsdrv_latency_percentile(bins, PERCENTILES[i]));
+        }
+    }
+}
+
+static void pools_publish(struct jsdrv_context_s * c) {
+    int64_t t = jsdrv_time_utc();
+    if ((t - c->pool_publish_time) >= POOL_PUBLISH_INTERVAL) {
+        c->pool_publish_time = t;
+        pool_publish(c, &c->pool_msg);
+        pool_publish(c, &c->pool_small);
+        for (uint32_t i = 0; i < DATA_POOL_COUNT; ++i) {
+            pool_publish(c, &c->pool_data[i]);
+        }
+        perf_publish(c);
+        alloc_publish(c);
+        latency_publish(c);
+    }
+}
+
 static int32_t timeout_next_ms(struct jsdrv_context_s * c) {
-    struct jsdrv_list_s * item;
-    struct jsdrvp_api_timeout_s * timeout;
     int64_t t = jsdrv_time_utc();
-    item = jsdrv_list_peek_head(&c->cmd_timeouts);
-    if (!item) {
+    struct jsdrvp_api_timeout_s * timeout = jsdrv_api_timeouts_peek(&c->cmd_timeouts);
+    if (!timeout) {
         return FRONTEND_THREAD_POLL_MS;  // maximum polling delay
     }
-    timeout = JSDRV_CONTAINER_OF(item, struct jsdrvp_api_timeout_s, item);
     int64_t t_delta = timeout->timeout - t;
     if (t_delta <= 0) {
         return 0;
@@ -230,48 +605,53 @@ static int32_t timeout_next_ms(struct jsdrv_context_s * c) {
 }
 
 static void timeout_add(struct jsdrv_context_s * c, struct jsdrvp_api_timeout_s * timeout) {
-    struct jsdrv_list_s * item;
-    struct jsdrvp_api_timeout_s * t;
-    jsdrv_list_add_tail(&c->cmd_timeouts, &timeout->item);
-    jsdrv_list_foreach(&c->cmd_timeouts, item) {
-        t = JSDRV_CONTAINER_OF(item, struct jsdrvp_api_timeout_s, item);
-        if (timeout->timeout < t->timeout) {
-            jsdrv_list_remove(&timeout->item);
-            jsdrv_list_insert_before(item, &timeout->item);
-            break;
+    jsdrv_api_timeouts_add(&c->cmd_timeouts, timeout);
+}
+
+struct jsdrvp_api_async_s {
+    struct jsdrvp_api_timeout_s timeout;
+    char topic[JSDRV_TOPIC_LENGTH_MAX];         // the caller's topic
+    jsdrv_async_fn cbk_fn;
+    void * cbk_user_data;
+    struct jsdrv_union_s * value;               // jsdrv_query_async() only
+};
+
+static void timeout_signal(struct jsdrvp_api_timeout_s * t, int32_t rc) {
+    t->return_code = rc;
+    if (t->async) {
+        struct jsdrvp_api_async_s * a = t->async;
+        a->cbk_fn(a->cbk_user_data, a->topic, rc, a->value);
+        jsdrv_free(a);
+        return;
+    }
+    if (t->batch) {
+        t = t->batch;
+        if (rc && !t->return_code) {
+            t->return_code = rc;  // report the first error
+        }
+        if (--t->batch_pending) {
+            return;
         }
     }
+    jsdrv_os_event_signal(t->ev);
 }
 
 static void timeout_process(struct jsdrv_context_s * c) {
-    struct jsdrv_list_s * item;
     struct jsdrvp_api_timeout_s * t;
     int64_t t_now = jsdrv_time_utc();
-    jsdrv_list_foreach(&c->cmd_timeouts, item) {
-        t = JSDRV_CONTAINER_OF(item, struct jsdrvp_api_timeout_s, item);
-        if (t->timeout <= t_now) {
-            jsdrv_list_remove(item);
-            t->return_code = JSDRV_ERROR_TIMED_OUT;
-            jsdrv_os_event_signal(t->ev);
-        } else {
-            break;
-        }
+    while ((NULL != (t = jsdrv_api_timeouts_peek(&c->cmd_timeouts))) && (t->timeout <= t_now)) {
+        jsdrv_api_timeouts_remove(&c->cmd_timeouts, t);
+        timeout_signal(t, JSDRV_ERROR_TIMED_OUT);
     }
 }
 
 static int32_t timeout_complete(struct jsdrv_context_s * c, const char * topic, int32_t rc) {
-    struct jsdrv_list_s * item;
-    struct jsdrvp_api_timeout_s * t;
     JSDRV_LOGD2("timeout_complete %s %d", topic, rc);
-
-    jsdrv_list_foreach(&c->cmd_timeouts, item) {
-        t = JSDRV_CONTAINER_OF(item, struct jsdrvp_api_timeout_s, item);
-        if (0 == strcmp(t->topic, topic)) {
-            jsdrv_list_remove(item);
-            t->return_code = rc;
-            jsdrv_os_event_signal(t->ev);
-            return 0;
-        }
+    struct jsdrvp_api_timeout_s * t = jsdrv_api_timeouts_find(&c->cmd_timeouts, topic);
+    if (t) {
+        jsdrv_api_timeouts_remove(&c->cmd_timeouts, t);
+        timeout_signal(t, rc);
+        return 0;
     }
     JSDRV_LOGD1("timeout_complete not found: %s", topic);
     return JSDRV_ERROR_NOT_FOUND;
@@ -279,9 +659,11 @@ static int32_t timeout_complete(struct jsdrv_context_s * c, const char * topic,
 
 static uint8_t on_return_code(void * user_data, struct jsdrvp_msg_s * msg) {
     struct jsdrv_context_s * c = (struct jsdrv_context_s *) user_data;
-    char value_str[128];
-    jsdrv_union_value_to_str(&msg->value, value_str, sizeof(value_str), 1);
-    JSDRV_LOGD1("on_return_code(%s) %s", msg->topic, value_str);
+    if (JSDRV_LOG_ENABLED(JSDRV_LOG_LEVEL_DEBUG1)) {
+        char value_str[128];
+        jsdrv_union_value_to_str(&msg->value, value_str, sizeof(value_str), 1);
+        JSDRV_LOGD1("on_return_code(%s) %s", msg->topic, value_str);
+    }
     if (msg->value.type != JSDRV_UNION_I32) {
         JSDRV_LOGW("on_return_code %s unsupported type %d", msg->topic, msg->value.type);
         return 0;
@@ -314,16 +696,57 @@ static bool is_backend_initialization_complete(struct jsdrv_context_s * c) {
     return true;
 }
 
+static void device_list_publish(struct jsdrv_context_s * c);
+
 static void init_complete(struct jsdrv_context_s * c) {
     JSDRV_ASSERT(c->state == ST_INIT_AWAITING_BACKEND);
     if (is_backend_initialization_complete(c)) {
         c->args = NULL;  // only valid for the duration of INITIALIZE
         c->state = ST_ACTIVE;
         JSDRV_LOGI("init_complete");
+        if (c->device_list_pending) {
+            device_list_publish(c);  // all devices from the initial scans at once
+        }
         timeout_complete(c, JSDRV_MSG_INITIALIZE "#", c->init_status);
     }
 }
 
+static int32_t trace_cmd(struct jsdrvp_msg_s * msg) {
+    const char * subtopic = msg->topic + sizeof(JSDRV_MSG_TRACE);
+    struct jsdrv_union_s v = msg->value;
+    if (0 == strcmp("!start", subtopic)) {
+        if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+        return jsdrv_trace_start(v.value.u32);
+    } else if (0 == strcmp("!stop", subtopic)) {
+        jsdrv_trace_stop();
+        if ((JSDRV_UNION_STR == v.type) && v.value.str && v.value.str[0]) {
+            return jsdrv_trace_write(v.value.str);  // blocks the frontend, but only after recording stops
+        }
+        return 0;
+    }
+    return JSDRV_ERROR_NOT_FOUND;
+}
+
+static int32_t alloc_cmd(struct jsdrvp_msg_s * msg) {
+    const char * subtopic = msg->topic + sizeof(JSDRV_MSG_ALLOC);
+    struct jsdrv_union_s v = msg->value;
+    if (0 == strcmp("!trace", subtopic)) {
+        if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+        jsdrv_alloc_trace_enable(0 != v.value.u32);
+        return 0;
+    } else if (0 == strcmp("!dump", subtopic)) {
+        if ((JSDRV_UNION_STR != v.type) || !v.value.str || !v.value.str[0]) {
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+        return jsdrv_alloc_trace_write(v.value.str);  // blocks the frontend
+    }
+    return JSDRV_ERROR_NOT_FOUND;
+}
+
 static bool handle_cmd_msg(struct jsdrv_context_s * c, struct jsdrvp_msg_s * msg) {
     if (!msg) {
         return false;
@@ -353,6 +776,52 @@ static bool handle_cmd_msg(struct jsdrv_context_s * c, struct jsdrvp_msg_s * msg
             jsdrvp_msg_free(c, msg);
             JSDRV_LOGI("%s request", JSDRV_MSG_TIMEOUT);
             return true;
+        } else if (0 == strcmp(JSDRV_MSG_LATENCY "/trailer", msg->topic)) {
+            struct jsdrv_union_s v = msg->value;
+            int32_t rc = JSDRV_ERROR_PARAMETER_INVALID;
+            if (0 == jsdrv_union_as_type(&v, JSDRV_UNION_U8)) {
+                jsdrv_latency_trailer_set(0 != v.value.u8);
+                rc = 0;
+            }
+            struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_i32(c, "", rc);
+            jsdrv_cstr_join(m->topic, msg->topic, "#", sizeof(m->topic));
+            if (rc) {
+                jsdrvp_msg_free(c, msg);
+            } else {
+                jsdrv_pubsub_publish(c->pubsub, msg);  // retain the value
+            }
+            jsdrv_pubsub_publish(c->pubsub, m);
+            return true;
+        } else if (0 == strcmp(JSDRV_MSG_REOPEN, msg->topic)) {
+            struct jsdrv_union_s v = msg->value;
+            int32_t rc = JSDRV_ERROR_PARAMETER_INVALID;
+            if (0 == jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+                c->reconnect_ms = v.value.u32;
+                rc = 0;
+            }
+            struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_i32(c, "", rc);
+            jsdrv_cstr_join(m->topic, msg->topic, "#", sizeof(m->topic));
+            if (rc) {
+                jsdrvp_msg_free(c, msg);
+            } else {
+                jsdrv_pubsub_publish(c->pubsub, msg);  // retain the value
+            }
+            jsdrv_pubsub_publish(c->pubsub, m);
+            return true;
+        } else if (0 == strncmp(JSDRV_MSG_TRACE "/", msg->topic, sizeof(JSDRV_MSG_TRACE))) {
+            int32_t rc = trace_cmd(msg);
+            struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_i32(c, "", rc);
+            jsdrv_cstr_join(m->topic, msg->topic, "#", sizeof(m->topic));
+            jsdrvp_msg_free(c, msg);
+            jsdrv_pubsub_publish(c->pubsub, m);
+            return true;
+        } else if (0 == strncmp(JSDRV_MSG_ALLOC "/!", msg->topic, sizeof(JSDRV_MSG_ALLOC) + 1)) {
+            int32_t rc = alloc_cmd(msg);
+            struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_i32(c, "", rc);
+            jsdrv_cstr_join(m->topic, msg->topic, "#", sizeof(m->topic));
+            jsdrvp_msg_free(c, msg);
+            jsdrv_pubsub_publish(c->pubsub, m);
+            return true;
         }
     }
     jsdrv_pubsub_publish(c->pubsub, msg);  // msg ownership relinquished
@@ -387,11 +856,46 @@ static struct frontend_dev_s * device_lookup(struct jsdrv_context_s * c, const c
     return NULL;
 }
 
+static void reconnect_free(struct reconnect_s * r) {
+    jsdrv_list_remove(&r->item);
+    jsdrv_free(r);
+}
+
+// Find the pending reconnect for a device topic and discard the expired ones.
+static struct reconnect_s * reconnect_find(struct jsdrv_context_s * c, const char * topic) {
+    struct jsdrv_list_s * item;
+    struct reconnect_s * r;
+    struct reconnect_s * rv = NULL;
+    int64_t now = jsdrv_time_utc();
+    jsdrv_list_foreach(&c->reconnects, item) {
+        r = JSDRV_CONTAINER_OF(item, struct reconnect_s, item);
+        size_t sz = strlen(r->prefix);
+        if (now >= r->deadline) {
+            JSDRV_LOGI("reconnect %s expired", r->prefix);
+            reconnect_free(r);
+        } else if ((0 == strncmp(r->prefix, topic, sz)) && ((topic[sz] == 0) || (topic[sz] == '/'))) {
+            rv = r;
+        }
+    }
+    return rv;
+}
+
+static void reconnect_free_all(struct jsdrv_context_s * c) {
+    struct jsdrv_list_s * item;
+    while (NULL != (item = jsdrv_list_remove_head(&c->reconnects))) {
+        jsdrv_free(JSDRV_CONTAINER_OF(item, struct reconnect_s, item));
+    }
+}
+
 static uint8_t device_removed_responder_fn(void * user_data, struct jsdrvp_msg_s * msg) {
     int32_t rc;
     struct jsdrv_context_s * c = (struct jsdrv_context_s *) user_data;
     if (jsdrv_cstr_ends_with(msg->topic, JSDRV_MSG_CLOSE)) {
     	JSDRV_LOGI("%s but device already removed", msg->topic);
+        struct reconnect_s * r = reconnect_find(c, msg->topic);
+        if (r) {
+            reconnect_free(r);       // the application no longer wants the device open
+        }
         rc = 0;                      // closing an already removed device is ok.
     } else {
     	JSDRV_LOGW("%s but device already removed", msg->topic);
@@ -422,11 +926,45 @@ static void device_removed_responder(struct jsdrv_context_s * c, const char * pr
 static uint8_t device_subscriber(void * user_data, struct jsdrvp_msg_s * msg) {
     JSDRV_LOGD2("device_subscriber %s", msg->topic);
     struct frontend_dev_s * d = (struct frontend_dev_s *) user_data;
+    const char * subtopic = msg->topic + strlen(d->prefix);
+    if (0 == strcmp("/" JSDRV_MSG_OPEN, subtopic)) {
+        d->is_open = true;
+        d->open_mode = 0;
+        if ((msg->value.type == JSDRV_UNION_U32) || (msg->value.type == JSDRV_UNION_I32)) {
+            d->open_mode = msg->value.value.i32;
+        }
+    } else if (0 == strcmp("/" JSDRV_MSG_CLOSE, subtopic)) {
+        d->is_open = false;
+    }
     struct jsdrvp_msg_s * m = jsdrvp_msg_clone(d->context, msg);
     msg_queue_push(d->device->cmd_q, m);
     return 0;
 }
 
+/*
+ * Replay the retained parameters of a reconnected device.  The subscriber
+ * receives each topic's metadata immediately before its value, and only
+ * forwards the values of writable parameters.  Commands, "!" topics and
+ * read-only values, such as h/state, are device outputs.
+ */
+static uint8_t device_restore_subscriber(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct frontend_dev_s * d = (struct frontend_dev_s *) user_data;
+    const char * subtopic = msg->topic + strlen(d->prefix);
+    if (jsdrv_cstr_ends_with(msg->topic, "$")) {
+        d->restore_topic[0] = 0;
+        if ((0 != strncmp("/@/", subtopic, 3)) && !strchr(subtopic, '!')
+                && (msg->value.type == JSDRV_UNION_JSON) && !strstr(msg->value.value.str, "\"ro\"")) {
+            jsdrv_cstr_copy(d->restore_topic, msg->topic, sizeof(d->restore_topic));
+            d->restore_topic[strlen(d->restore_topic) - 1] = 0;
+        }
+    } else if (d->restore_topic[0] && (0 == strcmp(d->restore_topic, msg->topic))) {
+        JSDRV_LOGD1("restore %s", msg->topic);
+        device_subscriber(d, msg);
+        d->restore_topic[0] = 0;
+    }
+    return 0;
+}
+
 void jsdrvp_device_subscribe(struct jsdrv_context_s * context, const char * dev_topic,
                              const char * topic, uint8_t flags) {
     struct frontend_dev_s * dev = device_lookup(context, dev_topic);
@@ -467,7 +1005,7 @@ void jsdrvp_device_unsubscribe(struct jsdrv_context_s * context, const char * de
     jsdrvp_backend_send(context, m);
 }
 
-static void device_sub(struct frontend_dev_s * d, const char * op) {
+static void device_sub(struct frontend_dev_s * d, const char * op, jsdrv_pubsub_subscribe_fn fn, uint8_t flags) {
     struct jsdrvp_msg_s * sub_msg = jsdrvp_msg_alloc(d->context);
     jsdrv_cstr_copy(sub_msg->topic, op, sizeof(sub_msg->topic));
     sub_msg->value.type = JSDRV_UNION_BIN;
@@ -475,9 +1013,9 @@ static void device_sub(struct frontend_dev_s * d, const char * op) {
     sub_msg->value.value.bin = (uint8_t *) &sub_msg->payload.sub;
     jsdrv_cstr_copy(sub_msg->payload.sub.topic, d->prefix, sizeof(sub_msg->payload.sub.topic));
     sub_msg->payload.sub.subscriber.is_internal = 1;
-    sub_msg->payload.sub.subscriber.internal_fn = device_subscriber;
+    sub_msg->payload.sub.subscriber.internal_fn = fn;
     sub_msg->payload.sub.subscriber.user_data = d;
-    sub_msg->payload.sub.subscriber.flags = JSDRV_SFLAG_PUB;
+    sub_msg->payload.sub.subscriber.flags = flags;
     jsdrv_pubsub_publish(d->context->pubsub, sub_msg);
 }
 
@@ -503,7 +1041,9 @@ static void device_add_msg(struct jsdrv_context_s * c, struct jsdrvp_msg_s * msg
     d->context = c;
     jsdrv_list_initialize(&d->item);
     jsdrv_cstr_copy(d->prefix, msg->payload.device.prefix, sizeof(d->prefix));
+    jsdrv_os_mutex_lock(c->route_mutex);
     jsdrv_list_add_tail(&c->devices, &d->item);
+    jsdrv_os_mutex_unlock(c->route_mutex);
 
     int rv = 1;
     if (0 == strcmp("js220", model)) {
@@ -512,14 +1052,13 @@ static void device_add_msg(struct jsdrv_context_s * c, struct jsdrvp_msg_s * msg
         rv = jsdrvp_ul_js110_usb_factory(&d->device, c, &msg->payload.device);
     } else if (0 == strcmp("&js220", model))  {
         rv = jsdrvp_ul_js220_usb_factory(&d->device, c, &msg->payload.device);
-#if UNITTEST == 0
-    //} else if (0 == strcmp("emu", model)) {
-    //    rv = jsdrvp_ul_emu_factory(&d->device, c, &msg->payload.device);
-#endif
     }
     if (rv) {
         JSDRV_LOGE("device_add(%s) failed with %d", model, rv);
         jsdrvp_msg_free(c, msg);
+        jsdrv_os_mutex_lock(c->route_mutex);
+        jsdrv_list_remove(&d->item);
+        jsdrv_os_mutex_unlock(c->route_mutex);
         jsdrv_free(d);
         // todo indicate device failure?
         return;
@@ -528,7 +1067,22 @@ static void device_add_msg(struct jsdrv_context_s * c, struct jsdrvp_msg_s * msg
     msg->value.flags = 0;
     jsdrv_pubsub_publish(c->pubsub, msg);  // transfers msg ownership
     device_removed_responder(c, d->prefix, JSDRV_PUBSUB_UNSUBSCRIBE);
-    device_sub(d, JSDRV_PUBSUB_SUBSCRIBE);
+    device_sub(d, JSDRV_PUBSUB_SUBSCRIBE, device_subscriber, JSDRV_SFLAG_PUB);
+
+    struct reconnect_s * r = reconnect_find(c, d->prefix);
+    if (r) {
+        JSDRV_LOGI("reconnect %s mode=%d", d->prefix, (int) r->open_mode);
+        struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(c, "", &jsdrv_union_i32(r->open_mode));
+        tfp_snprintf(m->topic, sizeof(m->topic), "%s/%s", d->prefix, JSDRV_MSG_OPEN);
+        reconnect_free(r);
+        jsdrv_pubsub_publish(c->pubsub, m);
+        // the device defers the restored parameters until the open completes
+        uint8_t flags = JSDRV_SFLAG_RETAIN | JSDRV_SFLAG_PUB | JSDRV_SFLAG_METADATA_RSP;
+        device_sub(d, JSDRV_PUBSUB_SUBSCRIBE, device_restore_subscriber, flags);
+        device_sub(d, JSDRV_PUBSUB_UNSUBSCRIBE, device_restore_subscriber, flags);
+    }
+    d->route_pending = true;  // direct commands must not overtake the restore
+    c->route_pending = true;
 }
 
 static void device_remove(struct jsdrv_context_s * c, struct frontend_dev_s * d) {
@@ -536,22 +1090,42 @@ static void device_remove(struct jsdrv_context_s * c, struct frontend_dev_s * d)
     if (!d) {
         return;
     }
+    jsdrv_os_mutex_lock(c->route_mutex);
+    d->routed = false;  // no direct commands after join
+    jsdrv_os_mutex_unlock(c->route_mutex);
     d->device->join(d->device);
     device_removed_responder(c, d->prefix, JSDRV_PUBSUB_SUBSCRIBE);
-    device_sub(d, JSDRV_PUBSUB_UNSUBSCRIBE);
+    device_sub(d, JSDRV_PUBSUB_UNSUBSCRIBE, device_subscriber, JSDRV_SFLAG_PUB);
     // todo update state
+    jsdrv_os_mutex_lock(c->route_mutex);
     jsdrv_list_remove(&d->item);
+    jsdrv_os_mutex_unlock(c->route_mutex);
     jsdrv_free(d);
 }
 
 static void device_remove_all(struct jsdrv_context_s * c) {
     while (!jsdrv_list_is_empty(&c->devices)) {
-        struct jsdrv_list_s * item = jsdrv_list_remove_head(&c->devices);
+        struct jsdrv_list_s * item = jsdrv_list_peek_head(&c->devices);
         struct frontend_dev_s * d = JSDRV_CONTAINER_OF(item, struct frontend_dev_s, item);
         device_remove(c, d);
     }
 }
 
+// Enable direct commands once pubsub processed the device add subscriptions.
+static void device_routes_enable(struct jsdrv_context_s * c) {
+    struct jsdrv_list_s * item;
+    c->route_pending = false;
+    jsdrv_os_mutex_lock(c->route_mutex);
+    jsdrv_list_foreach(&c->devices, item) {
+        struct frontend_dev_s * d = JSDRV_CONTAINER_OF(item, struct frontend_dev_s, item);
+        if (d->route_pending) {
+            d->route_pending = false;
+            d->routed = true;
+        }
+    }
+    jsdrv_os_mutex_unlock(c->route_mutex);
+}
+
 static void device_remove_msg(struct jsdrv_context_s * c, struct jsdrvp_msg_s * msg) {
     JSDRV_ASSERT(c && msg);
     JSDRV_ASSERT(msg->value.type == JSDRV_UNION_STR);
@@ -563,6 +1137,19 @@ static void device_remove_msg(struct jsdrv_context_s * c, struct jsdrvp_msg_s *
         jsdrvp_msg_free(c, msg);
         return;
     }
+    struct reconnect_s * r = reconnect_find(c, d->prefix);
+    if (r) {
+        reconnect_free(r);
+    }
+    if (c->reconnect_ms && d->is_open && (JSDRV_DEVICE_OPEN_MODE_RAW != d->open_mode)) {
+        JSDRV_LOGI("device %s removed while open, reconnect for %u ms", d->prefix, (unsigned) c->reconnect_ms);
+        r = jsdrv_alloc_clr(sizeof(struct reconnect_s));
+        jsdrv_list_initialize(&r->item);
+        jsdrv_cstr_copy(r->prefix, d->prefix, sizeof(r->prefix));
+        r->open_mode = d->open_mode;
+        r->deadline = jsdrv_time_utc() + c->reconnect_ms * JSDRV_TIME_MILLISECOND;
+        jsdrv_list_add_tail(&c->reconnects, &r->item);
+    }
     device_remove(c, d);
     jsdrv_pubsub_publish(c->pubsub, msg);  // transfers msg ownership
 }
@@ -591,6 +1178,11 @@ static void handle_backend_init_msg(struct jsdrv_context_s * c, struct jsdrvp_ms
 }
 
 static void device_list_publish(struct jsdrv_context_s * c) {
+    if (c->state != ST_ACTIVE) {
+        c->device_list_pending = true;  // coalesce the initial scan, see init_complete()
+        return;
+    }
+    c->device_list_pending = false;
     struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(c, JSDRV_MSG_DEVICE_LIST, &jsdrv_union_cstr_r(""));
     char * p = m->payload.str;
     char * p_end = m->payload.str + sizeof(m->payload.str) - JSDRV_TOPIC_LENGTH_MAX - 2;
@@ -631,6 +1223,14 @@ static bool handle_backend_msg(struct jsdrv_context_s * c, struct jsdrvp_msg_s *
             device_list_publish(c);
         } else if (0 == strcmp(JSDRV_MSG_INITIALIZE, msg->topic)) {
             handle_backend_init_msg(c, msg);
+        } else if (0 == strncmp(JSDRV_MSG_THREADS "/", msg->topic, sizeof(JSDRV_MSG_THREADS))) {
+            jsdrv_pubsub_publish(c->pubsub, msg);
+        } else if (0 == strncmp(JSDRV_MSG_STATISTICS_ALL, msg->topic, sizeof(JSDRV_MSG_STATISTICS_ALL))
+                   || (0 == strncmp(JSDRV_MSG_STATISTICS_PERIOD, msg->topic, sizeof(JSDRV_MSG_STATISTICS_PERIOD) - 1))) {
+            jsdrv_pubsub_publish(c->pubsub, msg);  // includes the period metadata
+        } else if ((0 == strncmp(JSDRV_MSG_STATISTICS_HISTORY, msg->topic, sizeof(JSDRV_MSG_STATISTICS_HISTORY) - 1))
+                   || (0 == strncmp(JSDRV_MSG_STATISTICS_HISTORY_REQ, msg->topic, sizeof(JSDRV_MSG_STATISTICS_HISTORY_REQ) - 1))) {
+            jsdrv_pubsub_publish(c->pubsub, msg);  // stats_history metadata and return codes
         } else {
             JSDRV_LOGW("unhandled %s", msg->topic);
         }
@@ -638,6 +1238,12 @@ static bool handle_backend_msg(struct jsdrv_context_s * c, struct jsdrvp_msg_s *
         jsdrv_pubsub_publish(c->pubsub, msg);
     } else if (msg->topic[0] == 'm') {  // buffer
         jsdrv_pubsub_publish(c->pubsub, msg);
+    } else if ((msg->topic[0] == 't') && (msg->topic[1] == '/') && !device_lookup(c, msg->topic)) {  // time alignment
+        jsdrv_pubsub_publish(c->pubsub, msg);
+    } else if ((msg->topic[0] == 'r') && (msg->topic[1] == '/') && !device_lookup(c, msg->topic)) {  // recorder
+        jsdrv_pubsub_publish(c->pubsub, msg);
+    } else if ((msg->topic[0] == 'x') && (msg->topic[1] == '/') && !device_lookup(c, msg->topic)) {  // shared memory export
+        jsdrv_pubsub_publish(c->pubsub, msg);
     } else {
         switch (msg->inner_msg_type) {
             case JSDRV_MSG_TYPE_NORMAL: break;
@@ -647,6 +1253,13 @@ static bool handle_backend_msg(struct jsdrv_context_s * c, struct jsdrvp_msg_s *
                 jsdrvp_msg_free(c, msg);
                 return true;
         }
+        if (JSDRVP_MSG_SOURCE_DIRECT == msg->source) {  // from publish_direct()
+            ++c->direct_count;
+            if (msg->timeout) {
+                timeout_add(c, msg->timeout);  // before the device return code
+                msg->timeout = NULL;
+            }
+        }
         struct frontend_dev_s * d = device_lookup(c, msg->topic);
         if (d) {
             msg->extra.frontend.subscriber.internal_fn = device_subscriber;
@@ -670,17 +1283,12 @@ static void backends_finalize(struct jsdrv_context_s * c) {
 }
 
 static void timeouts_finalize(struct jsdrv_context_s * c) {
-    struct jsdrv_list_s * item;
     struct jsdrvp_api_timeout_s * timeout;
-    while (1) {
-        item = jsdrv_list_remove_head(&c->cmd_timeouts);
-        if (!item) {
-            break;
-        }
-        timeout = JSDRV_CONTAINER_OF(item, struct jsdrvp_api_timeout_s, item);
-        timeout->return_code = JSDRV_ERROR_ABORTED;
-        jsdrv_os_event_signal(timeout->ev);
+    while (NULL != (timeout = jsdrv_api_timeouts_peek(&c->cmd_timeouts))) {
+        jsdrv_api_timeouts_remove(&c->cmd_timeouts, timeout);
+        timeout_signal(timeout, JSDRV_ERROR_ABORTED);
     }
+    jsdrv_api_timeouts_finalize(&c->cmd_timeouts);
 }
 
 static int32_t backend_init(struct jsdrv_context_s * c, jsdrv_backend_factory factory) {
@@ -713,6 +1321,7 @@ static THREAD_RETURN_TYPE frontend_thread(THREAD_ARG_TYPE lpParam) {
     struct jsdrv_context_s * c = (struct jsdrv_context_s *) lpParam;
     int32_t timeout_ms;
     JSDRV_LOGI("USB frontend thread started");
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_FRONTEND);
     subscribe_return_code(c);
 
 #if _WIN32
@@ -732,8 +1341,13 @@ static THREAD_RETURN_TYPE frontend_thread(THREAD_ARG_TYPE lpParam) {
     BACKEND_INIT(c, jsdrv_unittest_backend_factory);
 #else
     BACKEND_INIT(c, jsdrv_usb_backend_factory);
-    // todo BACKEND_INIT(c, jsdrv_emulation_backend_factory);
 #endif
+    if (arg_u32(c, JSDRV_ARG_EMULATED_JS220, 0) + arg_u32(c, JSDRV_ARG_EMULATED_JS110, 0)) {
+        BACKEND_INIT(c, jsdrv_emulation_backend_factory);
+    }
+    if (jsdrvp_arg_get(c, JSDRV_ARG_USB_REPLAY)) {
+        BACKEND_INIT(c, jsdrv_usb_replay_backend_factory);
+    }
 
     while (!c->do_exit) {
         timeout_ms = timeout_next_ms(c);
@@ -744,27 +1358,69 @@ static THREAD_RETURN_TYPE frontend_thread(THREAD_ARG_TYPE lpParam) {
 #endif
         //JSDRV_LOGD3("frontend_thread");
         // note: ResetEvent handled automatically by msg_queue_pop_immediate
+#if JSDRV_PERF_ENABLE
+        JSDRV_TRACE_START(t_backend);
+        uint64_t backend_count = 0;
+        JSDRV_PERF_MAX(JSDRV_PERF_BACKEND_CONTROL_MAX, msg_queue_depth(c->msg_backend, MSG_QUEUE_LANE_CONTROL));
+        JSDRV_PERF_MAX(JSDRV_PERF_BACKEND_DATA_MAX, msg_queue_depth(c->msg_backend, MSG_QUEUE_LANE_DATA));
+        while (handle_backend_msg(c, msg_queue_pop_immediate(c->msg_backend))) {
+            ++backend_count;
+        }
+        JSDRV_PERF_MAX(JSDRV_PERF_BACKEND_MAX, backend_count);
+        JSDRV_TRACE_END("backend", t_backend, backend_count);
+#else
         while (handle_backend_msg(c, msg_queue_pop_immediate(c->msg_backend))) {
             ; //
         }
+#endif
         // note: ResetEvent handled automatically by msg_queue_pop_immediate
+        JSDRV_TRACE_START(t_cmd);
+        int32_t cmd_count = 0;
         while (handle_cmd_msg(c, msg_queue_pop_immediate(c->msg_cmd))) {
-            ; //
+            ++cmd_count;
         }
+        JSDRV_TRACE_END("cmd", t_cmd, cmd_count);
+        pools_publish(c);
+        JSDRV_TRACE_START(t_pubsub);
         jsdrv_pubsub_process(c->pubsub);
+        JSDRV_TRACE_END("pubsub", t_pubsub, 0);
+        if (c->route_pending) {
+            device_routes_enable(c);
+        }
+        cmd_count += c->direct_count;
+        c->direct_count = 0;
+        if (cmd_count) {
+            jsdrv_atomic_add(&c->cmd_pending, -cmd_count);  // after pubsub applied them
+        }
         timeout_process(c);
     }
 
     device_remove_all(c);
+    reconnect_free_all(c);
     backends_finalize(c);
     timeouts_finalize(c);
+    jsdrv_thread_unregister();
     THREAD_RETURN();
 }
 
+struct jsdrvp_msg_s * jsdrvp_msg_retain(struct jsdrvp_msg_s * msg) {
+    if (NULL != msg) {
+        jsdrv_atomic_add(&msg->refcnt, 1);
+    }
+    return msg;
+}
+
 void jsdrvp_msg_free(struct jsdrv_context_s * context, struct jsdrvp_msg_s * msg) {
     if (!msg) {
         return;  // NULL pointer, do nothing.
     }
+    int32_t refcnt = jsdrv_atomic_add(&msg->refcnt, -1);
+    if (refcnt > 0) {
+        return;  // still in use by another holder
+    } else if (refcnt < 0) {
+        JSDRV_LOGW("jsdrvp_msg_free but already freed");
+        return;
+    }
     if (!jsdrv_list_is_empty(&msg->item)) {
         JSDRV_LOGW("jsdrvp_msg_free but still in list");
     }
@@ -784,82 +1440,287 @@ void jsdrvp_msg_free(struct jsdrv_context_s * context, struct jsdrvp_msg_s * msg
                 break;
         }
     }
-    if (context->do_exit) {
-        jsdrv_free(msg);
-    } else if (msg->inner_msg_type == JSDRV_MSG_TYPE_DATA) {
-        msg_queue_push(context->msg_free_data, msg);
+    if (msg->inner_msg_type == JSDRV_MSG_TYPE_DATA) {
+        uint32_t idx = 0;
+        while ((idx < (DATA_POOL_COUNT - 1)) && (msg->capacity != DATA_POOL_CAPACITY[idx])) {
+            ++idx;
+        }
+        pool_free(&context->pool_data[idx], msg, context->do_exit);
     } else if (msg->inner_msg_type == JSDRV_MSG_TYPE_NORMAL) {
-        msg_queue_push(context->msg_free, msg);
+        struct msg_pool_s * pool = (msg->capacity == JSDRVP_MSG_SMALL_PAYLOAD_SIZE) ? &context->pool_small : &context->pool_msg;
+        pool_free(pool, msg, context->do_exit);
     } else {
         JSDRV_LOGE("corrupted message with invalid inner_msg_type");
         jsdrv_free(msg);
     }
 }
 
+static bool api_timeout_allowed(struct jsdrv_context_s * context, const char * topic) {
+    if (jsdrv_thread_is_current(&context->thread)) {
+        JSDRV_LOGW("API command %s invoked on jsdrv thread with timeout.  Forcing timeout=0.", topic);
+        return false;
+    } else if (jsdrv_dispatch_is_current(context->dispatch)) {
+        JSDRV_LOGW("API command %s invoked on dispatch thread with timeout.  Forcing timeout=0.", topic);
+        return false;
+    }
+    return true;
+}
+
+static void api_timeout_init(struct jsdrvp_api_timeout_s * timeout, const char * topic, uint32_t timeout_ms) {
+    jsdrv_list_initialize(&timeout->item);
+    jsdrv_cstr_join(timeout->topic, topic, "#", sizeof(timeout->topic));
+    timeout->timeout = jsdrv_time_utc() + timeout_ms * JSDRV_TIME_MILLISECOND;
+    timeout->ev = NULL;
+    timeout->return_code = 0;
+    timeout->batch = NULL;
+    timeout->batch_pending = 0;
+    timeout->async = NULL;
+}
+
+static jsdrv_os_event_t api_event_acquire(struct jsdrv_context_s * context) {
+    jsdrv_os_event_t ev = NULL;
+    jsdrv_os_mutex_lock(context->ev_pool_mutex);
+    if (context->ev_pool_count) {
+        ev = context->ev_pool[--context->ev_pool_count];
+    }
+    jsdrv_os_mutex_unlock(context->ev_pool_mutex);
+    return ev ? ev : jsdrv_os_event_alloc();
+}
+
+/**
+ * @brief Return a completion event to the pool.
+ *
+ * @param context The driver context.
+ * @param ev The event from api_event_acquire().
+ * @param signaled True when api_wait() returned on the event signal.
+ *      Otherwise the jsdrv thread may still signal the event, so free
+ *      rather than reuse.
+ */
+static void api_event_release(struct jsdrv_context_s * context, jsdrv_os_event_t ev, bool signaled) {
+    if (signaled) {
+        jsdrv_os_event_reset(ev);
+        jsdrv_os_mutex_lock(context->ev_pool_mutex);
+        if (context->ev_pool_count < API_EVENT_POOL_MAX) {
+            context->ev_pool[context->ev_pool_count++] = ev;
+            ev = NULL;
+        }
+        jsdrv_os_mutex_unlock(context->ev_pool_mutex);
+    }
+    if (ev) {
+        jsdrv_os_event_free(ev);
+    }
+}
+
+static int32_t api_wait(struct jsdrvp_api_timeout_s * timeout, bool * signaled) {
+    int32_t rc;
+    *signaled = false;
+#if _WIN32
+    switch (WaitForSingleObject(timeout->ev, INFINITE)) {  // timeout performed in main jsdrv thread
+        case WAIT_ABANDONED: rc = JSDRV_ERROR_ABORTED; break;
+        case WAIT_OBJECT_0: rc = timeout->return_code; *signaled = true; break;
+        case WAIT_TIMEOUT: rc = JSDRV_ERROR_TIMED_OUT; break;
+        case WAIT_FAILED: rc = JSDRV_ERROR_UNSPECIFIED; break;
+        default: rc = JSDRV_ERROR_UNSPECIFIED; break;
+    }
+#else
+    struct pollfd fds = {
+            .fd = timeout->ev->fd_poll,
+            .events = timeout->ev->events,
+            .revents = 0,
+    };
+    int prv = poll(&fds, 1, 1000000);  // timeout > main jsdrv thread timeout
+    if (prv < 0) {
+        rc = JSDRV_ERROR_UNSPECIFIED;
+    } else if (prv == 0) {
+        rc = JSDRV_ERROR_TIMED_OUT;
+    } else {
+        rc = timeout->return_code;
+        *signaled = true;
+    }
+#endif
+    return rc;
+}
+
 static int32_t api_cmd(struct jsdrv_context_s * context, struct jsdrvp_msg_s * m, uint32_t timeout_ms) {
     struct jsdrvp_api_timeout_s timeout;
     volatile int32_t rc = 0;
+    bool signaled;
+    if (timeout_ms && !api_timeout_allowed(context, m->topic)) {
+        timeout_ms = 0;
+    }
     if (timeout_ms) {
-        if (jsdrv_thread_is_current(&context->thread)) {
-            JSDRV_LOGW("API command %s invoked on jsdrv thread with timeout.  Forcing timeout=0.", m->topic);
-            timeout_ms = 0;
-        } else {
-            jsdrv_list_initialize(&timeout.item);
-            jsdrv_cstr_join(timeout.topic, m->topic, "#", sizeof(timeout.topic));
-            timeout.timeout = jsdrv_time_utc() + timeout_ms * JSDRV_TIME_MILLISECOND;
-            timeout.ev = jsdrv_os_event_alloc();
-            timeout.return_code = 0;
-            // use a stack variable, but block on timeout to ensure stays in scopre
-            m->timeout = &timeout;  // cppcheck-suppress autoVariables
-            m->source = 1;
-        }
+        api_timeout_init(&timeout, m->topic, timeout_ms);
+        timeout.ev = api_event_acquire(context);
+        // use a stack variable, but block on timeout to ensure stays in scopre
+        m->timeout = &timeout;  // cppcheck-suppress autoVariables
+        m->source = 1;
     }
     JSDRV_LOGD1("api_cmd(%s) start", m->topic);
+    jsdrv_atomic_add(&context->cmd_pending, 1);
     msg_queue_push(context->msg_cmd, m);
     m = NULL;  // we relinquished ownership of m, ensure we don't use it.
     if (timeout_ms) {
-#if _WIN32
-        switch (WaitForSingleObject(timeout.ev, INFINITE)) {  // timeout performed in main jsdrv thread
-            case WAIT_ABANDONED: rc = JSDRV_ERROR_ABORTED; break;
-            case WAIT_OBJECT_0: rc = timeout.return_code; break;
-            case WAIT_TIMEOUT: rc = JSDRV_ERROR_TIMED_OUT; break;
-            case WAIT_FAILED: rc = JSDRV_ERROR_UNSPECIFIED; break;
-            default: rc = JSDRV_ERROR_UNSPECIFIED; break;
-        }
-#else
-        struct pollfd fds = {
-                .fd = timeout.ev->fd_poll,
-                .events = timeout.ev->events,
-                .revents = 0,
-        };
-        int prv = poll(&fds, 1, 1000000);  // timeout > main jsdrv thread timeout
-        if (prv < 0) {
-            rc = JSDRV_ERROR_UNSPECIFIED;
-        } else if (prv == 0) {
-            rc = JSDRV_ERROR_TIMED_OUT;
-        } else {
-            rc = timeout.return_code;
-        }
-#endif
-        jsdrv_os_event_free(timeout.ev);
+        rc = api_wait(&timeout, &signaled);
+        api_event_release(context, timeout.ev, signaled);
     }
     JSDRV_LOGD1("api_cmd done %lu", rc);
     return rc;
 }
 
+/*
+ * Find the routed device for a topic.  Call with route_mutex held.
+ * Device topics have the form {backend}/{model}/{serial_number}/{subtopic}.
+ */
+static struct frontend_dev_s * device_route_find(struct jsdrv_context_s * c, const char * topic) {
+    struct jsdrv_list_s * item;
+    jsdrv_list_foreach(&c->devices, item) {
+        struct frontend_dev_s * d = JSDRV_CONTAINER_OF(item, struct frontend_dev_s, item);
+        size_t sz = strlen(d->prefix);
+        if (d->routed && (0 == strncmp(d->prefix, topic, sz)) && (topic[sz] == '/')) {
+            return d;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Send a device parameter directly from the API thread to the device
+ * command queue, which skips the frontend and pubsub hops.  The value
+ * also goes to the backend queue ahead of the device response, so the
+ * frontend applies it to pubsub as a device message, which the device
+ * does not receive again, and registers the timeout before the return
+ * code arrives.  Only values that pubsub would pass to the device
+ * unmodified qualify: scalar values for topics with direct metadata that
+ * differ from the retained value.  With no other commands in flight, the
+ * direct command also cannot overtake an earlier command from this thread.
+ *
+ * Returns JSDRV_ERROR_UNAVAILABLE when the command requires the frontend.
+ */
+static int32_t publish_direct(struct jsdrv_context_s * c, const char * topic,
+                              const struct jsdrv_union_s * value, uint32_t timeout_ms) {
+    struct jsdrvp_api_timeout_s timeout;
+    struct jsdrv_union_s retained;
+    int32_t rc = 0;
+    bool signaled;
+    size_t sz = strlen(topic);
+    if (c->do_exit || (c->state != ST_ACTIVE) || (sz < 2) || (sz >= JSDRV_TOPIC_LENGTH_MAX)
+            || strchr("$?%&#/", topic[sz - 1]) || strstr(topic, "/@/")
+            || (JSDRV_UNION_NULL == value->type) || jsdrv_union_is_type_ptr(value)
+            || (0 != jsdrv_atomic_load(&c->cmd_pending))
+            || jsdrv_pubsub_query_direct(c->pubsub, topic, &retained)
+            || ((JSDRV_UNION_NULL != retained.type) && jsdrv_union_eq(&retained, value))) {
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    if (timeout_ms && !api_timeout_allowed(c, topic)) {
+        timeout_ms = 0;
+    }
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(c, topic, value);
+    struct jsdrvp_msg_s * cmd = jsdrvp_msg_alloc_value(c, topic, value);
+
+    jsdrv_os_mutex_lock(c->route_mutex);
+    struct frontend_dev_s * d = device_route_find(c, topic);
+    if (NULL == d) {
+        jsdrv_os_mutex_unlock(c->route_mutex);
+        jsdrvp_msg_free(c, m);
+        jsdrvp_msg_free(c, cmd);
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    if (timeout_ms) {
+        api_timeout_init(&timeout, topic, timeout_ms);
+        timeout.ev = api_event_acquire(c);
+        m->timeout = &timeout;  // cppcheck-suppress autoVariables
+    }
+    m->source = JSDRVP_MSG_SOURCE_DIRECT;
+    JSDRV_LOGD1("publish_direct(%s)", topic);
+    jsdrv_atomic_add(&c->cmd_pending, 1);  // jsdrv_query() waits for the retained value
+    msg_queue_push(c->msg_backend, m);     // before the device can respond
+    msg_queue_push(d->device->cmd_q, cmd);
+    jsdrv_os_mutex_unlock(c->route_mutex);
+    JSDRV_PERF_ADD(JSDRV_PERF_PUBLISH_DIRECT, 1);
+    if (timeout_ms) {
+        rc = api_wait(&timeout, &signaled);
+        api_event_release(c, timeout.ev, signaled);
+    }
+    return rc;
+}
+
 int32_t jsdrv_publish(struct jsdrv_context_s * context,
         const char * name, const struct jsdrv_union_s * value,
         uint32_t timeout_ms) {
+    if (name && value) {
+        int32_t rc = publish_direct(context, name, value, timeout_ms);
+        if (JSDRV_ERROR_UNAVAILABLE != rc) {
+            return rc;
+        }
+    }
     struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(context, name, value);
     return api_cmd(context, m, timeout_ms);
 }
 
+int32_t jsdrv_publish_batch(struct jsdrv_context_s * context,
+        const char * const * topics, const struct jsdrv_union_s * values,
+        uint32_t count, uint32_t timeout_ms) {
+    struct jsdrvp_api_timeout_s batch;
+    struct jsdrvp_api_timeout_s * timeouts = NULL;
+    struct jsdrv_list_s msgs;
+    int32_t rc = 0;
+    bool signaled;
+    if (!count) {
+        return 0;
+    } else if (!topics || !values) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!topics[i] || !topics[i][0]) {
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+    }
+    if (timeout_ms && !api_timeout_allowed(context, topics[0])) {
+        timeout_ms = 0;
+    }
+    if (timeout_ms) {
+        api_timeout_init(&batch, "", timeout_ms);
+        batch.ev = api_event_acquire(context);
+        batch.batch_pending = count;
+        timeouts = jsdrv_alloc(count * sizeof(struct jsdrvp_api_timeout_s));
+    }
+    jsdrv_list_initialize(&msgs);
+    for (uint32_t i = 0; i < count; ++i) {
+        struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(context, topics[i], &values[i]);
+        if (timeouts) {
+            api_timeout_init(&timeouts[i], topics[i], timeout_ms);
+            timeouts[i].ev = batch.ev;
+            timeouts[i].batch = &batch;  // cppcheck-suppress autoVariables
+            m->timeout = &timeouts[i];
+            m->source = 1;
+        }
+        jsdrv_list_add_tail(&msgs, &m->item);
+    }
+    JSDRV_LOGD1("jsdrv_publish_batch(%s, %lu) start", topics[0], (unsigned long) count);
+    jsdrv_atomic_add(&context->cmd_pending, (int32_t) count);
+    msg_queue_push_list(context->msg_cmd, &msgs);
+    if (timeouts) {
+        rc = api_wait(&batch, &signaled);
+        api_event_release(context, batch.ev, signaled);
+        jsdrv_free(timeouts);
+    }
+    JSDRV_LOGD1("jsdrv_publish_batch done %ld", (long) rc);
+    return rc;
+}
+
 int32_t jsdrv_query(struct jsdrv_context_s * context,
                     const char * topic, struct jsdrv_union_s * value,
                     uint32_t timeout_ms) {
     if (!topic || !topic[0] || !value) {
         return JSDRV_ERROR_PARAMETER_INVALID;
     }
+    // With no commands in flight, the retained scalar snapshot matches the
+    // result of the round trip, including any earlier publish from this thread.
+    if ((0 == jsdrv_atomic_load(&context->cmd_pending))
+            && (0 == jsdrv_pubsub_query_cached(context->pubsub, topic, value))) {
+        JSDRV_PERF_ADD(JSDRV_PERF_QUERY_CACHED, 1);
+        return 0;
+    }
     if (!timeout_ms) {
         timeout_ms = JSDRV_TIMEOUT_MS_DEFAULT;
     }
@@ -870,40 +1731,145 @@ int32_t jsdrv_query(struct jsdrv_context_s * context,
     return api_cmd(context, m, timeout_ms);
 }
 
-static int32_t subscribe_common(struct jsdrv_context_s * p,
-        const char * topic, uint8_t flags,
-        const char * op, jsdrv_subscribe_fn cbk_fn, void * cbk_user_data,
-                                uint32_t timeout_ms) {
+static int32_t api_async(struct jsdrv_context_s * context, struct jsdrvp_msg_s * m,
+                         const char * topic, struct jsdrv_union_s * value,
+                         jsdrv_async_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) {
+    struct jsdrvp_api_async_s * a = jsdrv_alloc_clr(sizeof(struct jsdrvp_api_async_s));
+    api_timeout_init(&a->timeout, m->topic, timeout_ms ? timeout_ms : JSDRV_TIMEOUT_MS_DEFAULT);
+    a->timeout.async = a;
+    jsdrv_cstr_copy(a->topic, topic, sizeof(a->topic));
+    a->cbk_fn = cbk_fn;
+    a->cbk_user_data = cbk_user_data;
+    a->value = value;
+    m->timeout = &a->timeout;  // owned by the jsdrv thread, freed after cbk_fn
+    m->source = 1;
+    JSDRV_LOGD1("api_async(%s) start", m->topic);
+    jsdrv_atomic_add(&context->cmd_pending, 1);
+    msg_queue_push(context->msg_cmd, m);
+    return 0;
+}
+
+int32_t jsdrv_publish_async(struct jsdrv_context_s * context,
+        const char * topic, const struct jsdrv_union_s * value,
+        jsdrv_async_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) {
+    if (!topic || !topic[0] || !value || !cbk_fn) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(context, topic, value);
+    return api_async(context, m, topic, NULL, cbk_fn, cbk_user_data, timeout_ms);
+}
+
+int32_t jsdrv_query_async(struct jsdrv_context_s * context,
+        const char * topic, struct jsdrv_union_s * value,
+        jsdrv_async_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) {
+    if (!topic || !value || !cbk_fn) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
+    jsdrv_cstr_copy(m->topic, JSDRV_PUBSUB_QUERY, sizeof(m->topic));
+    jsdrv_cstr_copy(m->payload.query.topic, topic, sizeof(m->payload.query.topic));
+    m->payload.query.value = value;
+    return api_async(context, m, topic, value, cbk_fn, cbk_user_data, timeout_ms);
+}
+
+int32_t jsdrv_query_snapshot(struct jsdrv_context_s * context,
+                             const char * topic, uint8_t flags,
+                             struct jsdrv_union_s * value,
+                             uint32_t timeout_ms) {
+    if (!topic || !value) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (!timeout_ms) {
+        timeout_ms = JSDRV_TIMEOUT_MS_DEFAULT;
+    }
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
+    jsdrv_cstr_copy(m->topic, JSDRV_PUBSUB_SNAPSHOT, sizeof(m->topic));
+    jsdrv_cstr_copy(m->payload.query.topic, topic, sizeof(m->payload.query.topic));
+    m->payload.query.value = value;
+    m->payload.query.flags = flags;
+    return api_cmd(context, m, timeout_ms);
+}
+
+static struct jsdrvp_msg_s * subscribe_msg_alloc(struct jsdrv_context_s * p,
+        const char * topic, uint8_t flags, const char * op, void * cbk_user_data) {
     struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(p);
     jsdrv_cstr_copy(m->topic, op, sizeof(m->topic));
     m->value.type = JSDRV_UNION_BIN;
     m->value.value.bin = m->payload.bin;
     m->value.app = JSDRV_PAYLOAD_TYPE_SUB;
     jsdrv_cstr_copy(m->payload.sub.topic, topic, sizeof(m->payload.sub.topic));
-    m->payload.sub.subscriber.external_fn = cbk_fn;
     m->payload.sub.subscriber.user_data = cbk_user_data;
     m->payload.sub.subscriber.is_internal = 0;
+    m->payload.sub.subscriber.is_batch = 0;
     m->payload.sub.subscriber.flags = flags;
+    m->payload.sub.subscriber.queue_policy = 0;
+    m->payload.sub.subscriber.queue_depth = 0;
+    m->payload.sub.subscriber.queue = NULL;
     JSDRV_LOGD1("subscribe_common(%s, %s)", topic, op);
+    return m;
+}
+
+static int32_t subscribe_common(struct jsdrv_context_s * p,
+        const char * topic, uint8_t flags, uint8_t policy, uint32_t depth,
+        const char * op, jsdrv_subscribe_fn cbk_fn, void * cbk_user_data,
+                                uint32_t timeout_ms) {
+    struct jsdrvp_msg_s * m = subscribe_msg_alloc(p, topic, flags, op, cbk_user_data);
+    m->payload.sub.subscriber.external_fn = cbk_fn;
+    m->payload.sub.subscriber.queue_policy = policy;
+    m->payload.sub.subscriber.queue_depth = depth;
     return api_cmd(p, m, timeout_ms);
 }
 
 int32_t jsdrv_subscribe(struct jsdrv_context_s * context, const char * name, uint8_t flags,
                         jsdrv_subscribe_fn cbk_fn, void * cbk_user_data,
                         uint32_t timeout_ms) {
-    return subscribe_common(context, name, flags, JSDRV_PUBSUB_SUBSCRIBE, cbk_fn, cbk_user_data, timeout_ms);
+    return subscribe_common(context, name, flags, JSDRV_SUBSCRIBE_QUEUE_BLOCK, 0,
+                            JSDRV_PUBSUB_SUBSCRIBE, cbk_fn, cbk_user_data, timeout_ms);
+}
+
+int32_t jsdrv_subscribe_queued(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
+                               uint8_t policy, uint32_t depth,
+                               jsdrv_subscribe_fn cbk_fn, void * cbk_user_data,
+                               uint32_t timeout_ms) {
+    if (policy > JSDRV_SUBSCRIBE_QUEUE_COALESCE) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    return subscribe_common(context, topic, flags | JSDRV_SFLAG_QUEUED, policy, depth,
+                            JSDRV_PUBSUB_SUBSCRIBE, cbk_fn, cbk_user_data, timeout_ms);
+}
+
+int32_t jsdrv_subscribe_batch(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
+                              jsdrv_subscribe_batch_fn cbk_fn, void * cbk_user_data,
+                              uint32_t timeout_ms) {
+    if (flags & JSDRV_SFLAG_QUEUED) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct jsdrvp_msg_s * m = subscribe_msg_alloc(context, topic, flags, JSDRV_PUBSUB_SUBSCRIBE, cbk_user_data);
+    m->payload.sub.subscriber.batch_fn = cbk_fn;
+    m->payload.sub.subscriber.is_batch = 1;
+    return api_cmd(context, m, timeout_ms);
+}
+
+int32_t jsdrv_unsubscribe_batch(struct jsdrv_context_s * context, const char * topic,
+                                jsdrv_subscribe_batch_fn cbk_fn, void * cbk_user_data,
+                                uint32_t timeout_ms) {
+    const char * op = topic ? JSDRV_PUBSUB_UNSUBSCRIBE : JSDRV_PUBSUB_UNSUBSCRIBE_ALL;
+    struct jsdrvp_msg_s * m = subscribe_msg_alloc(context, topic ? topic : "", 0, op, cbk_user_data);
+    m->payload.sub.subscriber.batch_fn = cbk_fn;
+    m->payload.sub.subscriber.is_batch = 1;
+    return api_cmd(context, m, timeout_ms);
 }
 
 int32_t jsdrv_unsubscribe(struct jsdrv_context_s * context, const char * name,
                           jsdrv_subscribe_fn cbk_fn, void * cbk_user_data,
                           uint32_t timeout_ms) {
-    return subscribe_common(context, name, 0, JSDRV_PUBSUB_UNSUBSCRIBE, cbk_fn, cbk_user_data, timeout_ms);
+    return subscribe_common(context, name, 0, 0, 0, JSDRV_PUBSUB_UNSUBSCRIBE, cbk_fn, cbk_user_data, timeout_ms);
 }
 
 int32_t jsdrv_unsubscribe_all(struct jsdrv_context_s * context,
                               jsdrv_subscribe_fn cbk_fn, void * cbk_user_data,
                               uint32_t timeout_ms) {
-    return subscribe_common(context, "", 0, JSDRV_PUBSUB_UNSUBSCRIBE_ALL, cbk_fn, cbk_user_data, timeout_ms);
+    return subscribe_common(context, "", 0, 0, 0, JSDRV_PUBSUB_UNSUBSCRIBE_ALL, cbk_fn, cbk_user_data, timeout_ms);
 }
 
 #define MSG_QUEUE_ALLOC(context_, ptr_)         \
@@ -922,34 +1888,87 @@ int32_t jsdrv_unsubscribe_all(struct jsdrv_context_s * context,
 int32_t jsdrv_initialize(struct jsdrv_context_s ** context, const struct jsdrv_arg_s * args, uint32_t timeout_ms) {
     JSDRV_LOGI("jsdrv_initialize: start");
     JSDRV_RETURN_ON_ERROR(jsdrv_platform_initialize());
+    char cpu_str[64];
+    uint32_t cpu_features = jsdrv_cpu_features();
+    jsdrv_f32_select(cpu_features);
+    jsdrv_cpu_features_to_str(cpu_features, cpu_str, sizeof(cpu_str));
+    JSDRV_LOGI("jsdrv_initialize: cpu %s, kernels %s", cpu_str, jsdrv_f32_impl());
     struct jsdrv_context_s * c = jsdrv_alloc_clr(sizeof(struct jsdrv_context_s));
     c->args = args;
+    c->cal_cache_path = arg_str_copy(c, JSDRV_ARG_JS110_CAL_CACHE);
     c->state = ST_INIT_AWAITING_FRONTEND;
     c->init_status = 0;
     jsdrv_list_initialize(&c->devices);
-    jsdrv_list_initialize(&c->cmd_timeouts);
-
-    MSG_QUEUE_ALLOC(c, c->msg_free);
-    MSG_QUEUE_ALLOC(c, c->msg_free_data);
+    jsdrv_list_initialize(&c->reconnects);
+    c->route_mutex = jsdrv_os_mutex_alloc("jsdrv_route");
+    jsdrv_api_timeouts_initialize(&c->cmd_timeouts);
+    c->ev_pool_mutex = jsdrv_os_mutex_alloc("jsdrv_ev_pool");
+    for (uint32_t stage = 0; stage < JSDRV_LATENCY_STAGE_COUNT; ++stage) {
+        jsdrv_latency_get(stage, c->latency_published[stage]);  // process-wide, publish from here
+    }
+    jsdrv_latency_trailer_set(false);
+
+    int32_t rc = pool_initialize(&c->pool_msg, JSDRV_MSG_POOL_MSG, sizeof(union jsdrvp_payload_u),
+            arg_u32(c, JSDRV_ARG_POOL_MSG_PREALLOC, POOL_MSG_PREALLOC_DEFAULT),
+            arg_u32(c, JSDRV_ARG_POOL_MSG_MAX, POOL_MSG_MAX_DEFAULT));
+    if (0 == rc) {
+        rc = pool_initialize(&c->pool_small, JSDRV_MSG_POOL_SMALL, JSDRVP_MSG_SMALL_PAYLOAD_SIZE,
+            arg_u32(c, JSDRV_ARG_POOL_SMALL_PREALLOC, POOL_SMALL_PREALLOC_DEFAULT),
+            arg_u32(c, JSDRV_ARG_POOL_SMALL_MAX, POOL_SMALL_MAX_DEFAULT));
+    }
+    for (uint32_t i = 0; (0 == rc) && (i < DATA_POOL_COUNT); ++i) {
+        rc = pool_initialize(&c->pool_data[i], DATA_POOL_TOPIC[i], DATA_POOL_CAPACITY[i],
+            arg_u32(c, JSDRV_ARG_POOL_DATA_PREALLOC, POOL_DATA_PREALLOC_DEFAULT),
+            arg_u32(c, JSDRV_ARG_POOL_DATA_MAX, POOL_DATA_MAX_DEFAULT));
+    }
+    if (rc) {
+        jsdrv_finalize(c, 0);
+        return rc;
+    }
     MSG_QUEUE_ALLOC(c, c->msg_cmd);
     MSG_QUEUE_ALLOC(c, c->msg_backend);
+    msg_queue_lanes_enable(c->msg_backend);
+    msg_queue_qos_enable(c->msg_backend);
     c->pubsub = jsdrv_pubsub_initialize(c);
+    c->dispatch = jsdrv_dispatch_initialize(c, arg_u32(c, JSDRV_ARG_FRONTEND_DATA_THREADS, 0));
+    if (NULL == c->dispatch) {
+        jsdrv_finalize(c, 0);
+        return JSDRV_ERROR_UNSPECIFIED;
+    }
+    jsdrv_pubsub_dispatch_register(c->pubsub, jsdrv_dispatch_pubsub(c->dispatch));
+    uint32_t device_threads = arg_u32(c, JSDRV_ARG_DEVICE_THREADS, 0);
+    if (device_threads) {
+        c->executor = jsdrv_executor_initialize(device_threads);
+        if (NULL == c->executor) {
+            jsdrv_finalize(c, 0);
+            return JSDRV_ERROR_UNSPECIFIED;
+        }
+    }
     struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc_u32(c, JSDRV_MSG_VERSION, JSDRV_VERSION_U32);
     jsdrv_pubsub_publish(c->pubsub, msg);
     msg = jsdrvp_msg_alloc_str(c, JSDRV_MSG_DEVICE_LIST, "");  // start with empty device list
     jsdrv_pubsub_publish(c->pubsub, msg);
     jsdrv_pubsub_process(c->pubsub);
-    JSDRV_RETURN_ON_ERROR(jsdrv_buffer_initialize(c));
-
+#if JSDRV_BUFFER_ENABLE
+    JSDRV_RETURN_ON_ERROR(jsdrv_buffer_initialize(c, &c->buffer_mgr));
+#endif
+    JSDRV_RETURN_ON_ERROR(jsdrv_align_initialize(c, &c->align));
+    JSDRV_RETURN_ON_ERROR(jsdrv_record_initialize(c, &c->record));
+    JSDRV_RETURN_ON_ERROR(jsdrv_shm_initialize(c, &c->shm));
+    JSDRV_RETURN_ON_ERROR(jsdrv_thread_policy_initialize(c, &c->thread_svc));
+    JSDRV_RETURN_ON_ERROR(jsdrv_stats_all_initialize(c, &c->stats_all));
+    JSDRV_RETURN_ON_ERROR(jsdrv_stats_history_initialize(c, &c->stats_history));
+
+    *context = c;  // before thread start, backends may use it
     int32_t rv = jsdrv_thread_create(&c->thread, frontend_thread, c, 1);
     if (rv) {
+        *context = NULL;
         jsdrv_finalize(c, 0);
         return rv;
     }
 
     msg = jsdrvp_msg_alloc_u32(c, JSDRV_MSG_INITIALIZE, 0);
     timeout_ms = timeout_ms ? timeout_ms : JSDRV_TIMEOUT_MS_INIT;
-    *context = c;
     rv = api_cmd(c, msg, timeout_ms);
     JSDRV_LOGI("jsdrv_initialize: return %ld", rv);
     return rv;
@@ -966,25 +1985,68 @@ void jsdrv_finalize(struct jsdrv_context_s * context, uint32_t timeout_ms) {
         jsdrv_cstr_copy(msg->topic, JSDRV_MSG_FINALIZE, sizeof(msg->topic));
         msg_queue_push(context->msg_cmd, msg);
         jsdrv_thread_join(&context->thread, timeout_ms);
-        jsdrv_buffer_finalize();
+        if (c->dispatch) {
+            jsdrv_pubsub_dispatch_register(c->pubsub, NULL);
+            jsdrv_dispatch_finalize(c->dispatch);
+            c->dispatch = NULL;
+        }
+        jsdrv_executor_finalize(c->executor);  // after the device threads join
+        c->executor = NULL;
+        jsdrv_stats_history_finalize(c->stats_history);
+        c->stats_history = NULL;
+        jsdrv_stats_all_finalize(c->stats_all);
+        c->stats_all = NULL;
+        jsdrv_thread_policy_finalize(c->thread_svc);
+        c->thread_svc = NULL;
+        jsdrv_shm_finalize(c->shm);
+        c->shm = NULL;
+        jsdrv_record_finalize(c->record);
+        c->record = NULL;
+        jsdrv_align_finalize(c->align);
+        c->align = NULL;
+#if JSDRV_BUFFER_ENABLE
+        jsdrv_buffer_finalize(c->buffer_mgr);
+#endif
+        c->buffer_mgr = NULL;
         jsdrv_pubsub_finalize(c->pubsub);
         c->pubsub = NULL;
 
         MSG_QUEUE_FREE(c->msg_cmd);
         MSG_QUEUE_FREE(c->msg_backend);
-        MSG_QUEUE_FREE(c->msg_free);
-        MSG_QUEUE_FREE(c->msg_free_data);
+        pool_finalize(&c->pool_msg);
+        pool_finalize(&c->pool_small);
+        for (uint32_t i = 0; i < DATA_POOL_COUNT; ++i) {
+            pool_finalize(&c->pool_data[i]);
+        }
+        if (c->cal_cache_path) {
+            jsdrv_free(c->cal_cache_path);
+            c->cal_cache_path = NULL;
+        }
+        while (c->ev_pool_count) {
+            jsdrv_os_event_free(c->ev_pool[--c->ev_pool_count]);
+        }
+        if (c->ev_pool_mutex) {
+            jsdrv_os_mutex_free(c->ev_pool_mutex);
+            c->ev_pool_mutex = NULL;
+        }
+        if (c->route_mutex) {
+            jsdrv_os_mutex_free(c->route_mutex);
+            c->route_mutex = NULL;
+        }
 
+        jsdrv_trace_release();
         jsdrv_free(c);
         jsdrv_platform_finalize();
     }
 }
 
 void jsdrvp_backend_send(struct jsdrv_context_s * context, struct jsdrvp_msg_s * msg) {
-    char buf[32];
-    jsdrv_union_value_to_str(&msg->value, buf, (uint32_t) sizeof(buf), 1);
     if (context->msg_backend) {
-        JSDRV_LOGD2("jsdrvp_backend_send %s %s", msg->topic, buf);
+        if (JSDRV_LOG_ENABLED(JSDRV_LOG_LEVEL_DEBUG2)) {
+            char buf[32];
+            jsdrv_union_value_to_str(&msg->value, buf, (uint32_t) sizeof(buf), 1);
+            JSDRV_LOGD2("jsdrvp_backend_send %s %s", msg->topic, buf);
+        }
         msg_queue_push(context->msg_backend, msg);
     } else {  // should never happen
         JSDRV_LOGW("jsdrvp_backend_send but no backend queue!");
@@ -1008,9 +2070,203 @@ int32_t jsdrv_open(struct jsdrv_context_s * context, const char * device_prefix,
     return jsdrv_publish(context, t.topic, &jsdrv_union_i32(mode), JSDRV_TIMEOUT_MS_DEFAULT);
 }
 
+int32_t jsdrv_open_many(struct jsdrv_context_s * context,
+        const char * const * device_prefixes, uint32_t count,
+        int32_t mode, uint32_t timeout_ms) {
+    int32_t rc;
+    if (!count) {
+        return 0;
+    } else if (!device_prefixes) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct jsdrv_topic_s * t = jsdrv_alloc(count * sizeof(struct jsdrv_topic_s));
+    const char ** topics = jsdrv_alloc(count * sizeof(const char *));
+    struct jsdrv_union_s * values = jsdrv_alloc(count * sizeof(struct jsdrv_union_s));
+    for (uint32_t i = 0; i < count; ++i) {
+        jsdrv_topic_set(&t[i], device_prefixes[i] ? device_prefixes[i] : "");
+        if (t[i].length) {
+            jsdrv_topic_append(&t[i], JSDRV_MSG_OPEN);
+        }
+        topics[i] = t[i].topic;
+        values[i] = jsdrv_union_i32(mode);
+    }
+    rc = jsdrv_publish_batch(context, topics, values, count, timeout_ms);
+    jsdrv_free(values);
+    jsdrv_free(topics);
+    jsdrv_free(t);
+    return rc;
+}
+
 int32_t jsdrv_close(struct jsdrv_context_s * context, const char * device_prefix) {
     struct jsdrv_topic_s t;
     jsdrv_topic_set(&t, device_prefix);
     jsdrv_topic_append(&t, JSDRV_MSG_CLOSE);
     return jsdrv_publish(context, t.topic, &jsdrv_union_i32(0), JSDRV_TIMEOUT_MS_DEFAULT);
 }
+
+int32_t jsdrv_buffer_read(struct jsdrv_context_s * context, uint8_t buffer_id, uint8_t signal_id,
+        struct jsdrv_buffer_request_s * req, struct jsdrv_buffer_response_s * rsp, uint64_t rsp_size) {
+    if ((NULL == context) || (NULL == req) || (NULL == rsp)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (rsp_size < (sizeof(struct jsdrv_buffer_response_s) + JSDRV_BUFFER_READ_SLACK)) {
+        return JSDRV_ERROR_TOO_SMALL;
+    }
+#if JSDRV_BUFFER_ENABLE
+    uint64_t data_size = rsp_size - sizeof(struct jsdrv_buffer_response_s) - JSDRV_BUFFER_READ_SLACK;
+    return jsdrv_buffer_mgr_read(context->buffer_mgr, buffer_id, signal_id, req, rsp, data_size);
+#else
+    (void) buffer_id;
+    (void) signal_id;
+    return JSDRV_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+int32_t jsdrv_buffer_read_samples(struct jsdrv_context_s * context, uint8_t buffer_id, uint8_t signal_id,
+        uint64_t start, uint64_t length, struct jsdrv_buffer_response_s * rsp, uint64_t rsp_size) {
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = start;
+    req.time.samples.length = length;
+    return jsdrv_buffer_read(context, buffer_id, signal_id, &req, rsp, rsp_size);
+}
+
+int32_t jsdrv_buffer_read_summary(struct jsdrv_context_s * context, uint8_t buffer_id, uint8_t signal_id,
+        uint64_t start, uint64_t end, uint64_t length,
+        struct jsdrv_buffer_response_s * rsp, uint64_t rsp_size) {
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = start;
+    req.time.samples.end = end;
+    req.time.samples.length = length;
+    return jsdrv_buffer_read(context, buffer_id, signal_id, &req, rsp, rsp_size);
+}
+
+struct measure_s {
+    jsdrv_os_event_t ev;
+    uint32_t sample_count;
+    volatile uint32_t done;
+    struct jsdrv_statistics_s statistics;
+};
+
+static void on_measure(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    struct measure_s * self = (struct measure_s *) user_data;
+    (void) topic;
+    if (self->done || (JSDRV_UNION_BIN != value->type) || (JSDRV_PAYLOAD_TYPE_STATISTICS != value->app)
+            || (value->size < sizeof(self->statistics))) {
+        return;
+    }
+    const struct jsdrv_statistics_s * s = (const struct jsdrv_statistics_s *) value->value.bin;
+    if (s->block_sample_count != self->sample_count) {
+        return;  // from an earlier window configuration
+    }
+    self->statistics = *s;
+    self->done = 1;
+    jsdrv_os_event_signal(self->ev);
+}
+
+static bool measure_wait(jsdrv_os_event_t ev, uint32_t timeout_ms) {
+#if _WIN32
+    return WAIT_OBJECT_0 == WaitForSingleObject(ev, timeout_ms);
+#else
+    struct pollfd fds = {
+            .fd = ev->fd_poll,
+            .events = ev->events,
+            .revents = 0,
+    };
+    return poll(&fds, 1, (int) timeout_ms) > 0;
+#endif
+}
+
+static int32_t measure_publish(struct jsdrv_context_s * context, const char * device, const char * subtopic,
+        const struct jsdrv_union_s * value) {
+    struct jsdrv_topic_s t;
+    jsdrv_topic_set(&t, device);
+    jsdrv_topic_append(&t, subtopic);
+    return jsdrv_publish(context, t.topic, value, JSDRV_TIMEOUT_MS_DEFAULT);
+}
+
+int32_t jsdrv_measure(struct jsdrv_context_s * context, const char * device, uint32_t sample_count,
+        struct jsdrv_statistics_s * statistics, uint32_t timeout_ms) {
+    // The settings to change, in restore order, with the fallback when not retained.
+    static const struct {
+        const char * subtopic;
+        uint32_t fallback;
+    } settings[] = {
+        {"h/stats/ctrl", 0},
+        {"h/stats/window", 100000},
+        {"h/stats/hop", 0},
+        {"s/i/ctrl", 0},
+        {"s/v/ctrl", 0},
+        {"s/p/ctrl", 0},
+    };
+    struct jsdrv_union_s restore[JSDRV_ARRAY_SIZE(settings)];
+    struct jsdrv_topic_s t;
+    struct measure_s m;
+    int32_t rc;
+
+    if ((NULL == context) || (NULL == device) || !device[0] || !sample_count || (NULL == statistics)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (!api_timeout_allowed(context, device)) {
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    for (size_t k = 0; k < JSDRV_ARRAY_SIZE(settings); ++k) {
+        jsdrv_topic_set(&t, device);
+        jsdrv_topic_append(&t, settings[k].subtopic);
+        restore[k] = jsdrv_union_u32_r(settings[k].fallback);  // scalar, so no query buffer
+        if (jsdrv_query(context, t.topic, &restore[k], JSDRV_TIMEOUT_MS_DEFAULT)
+                || (restore[k].type < JSDRV_UNION_F32)) {
+            restore[k] = jsdrv_union_u32_r(settings[k].fallback);
+        }
+    }
+
+    memset(&m, 0, sizeof(m));
+    m.sample_count = sample_count;
+    m.ev = api_event_acquire(context);
+    jsdrv_topic_set(&t, device);
+    jsdrv_topic_append(&t, "s/stats/host/value");
+
+    rc = measure_publish(context, device, "h/stats/ctrl", &jsdrv_union_u32_r(0));
+    if (0 == rc) {
+        rc = measure_publish(context, device, "h/stats/window", &jsdrv_union_u32_r(sample_count));
+    }
+    if (0 == rc) {
+        rc = measure_publish(context, device, "h/stats/hop", &jsdrv_union_u32_r(0));
+    }
+    if (0 == rc) {
+        rc = jsdrv_subscribe(context, t.topic, JSDRV_SFLAG_PUB, on_measure, &m, JSDRV_TIMEOUT_MS_DEFAULT);
+    }
+    if (0 == rc) {
+        rc = measure_publish(context, device, "h/stats/ctrl", &jsdrv_union_u32_r(1));
+        for (size_t k = 3; (0 == rc) && (k < JSDRV_ARRAY_SIZE(settings)); ++k) {
+            rc = measure_publish(context, device, settings[k].subtopic, &jsdrv_union_u32_r(1));
+        }
+        if (0 == rc) {
+            // sample_count at 1 Msps is the duration in microseconds
+            uint32_t duration_ms = (uint32_t) ((sample_count + 999U) / 1000U);
+            uint64_t wait_ms = (uint64_t) duration_ms + (timeout_ms ? timeout_ms : JSDRV_TIMEOUT_MS_DEFAULT);
+            if (wait_ms > INT32_MAX) {
+                wait_ms = INT32_MAX;
+            }
+            rc = measure_wait(m.ev, (uint32_t) wait_ms) ? 0 : JSDRV_ERROR_TIMED_OUT;
+        }
+        jsdrv_unsubscribe(context, t.topic, on_measure, &m, JSDRV_TIMEOUT_MS_DEFAULT);
+    }
+
+    for (size_t k = JSDRV_ARRAY_SIZE(settings); k > 0; --k) {
+        measure_publish(context, device, settings[k - 1].subtopic, &restore[k - 1]);
+    }
+    api_event_release(context, m.ev, true);  // unsubscribed, so no further signal
+    if ((0 == rc) && !m.done) {
+        rc = JSDRV_ERROR_TIMED_OUT;
+    }
+    if (0 == rc) {
+        *statistics = m.statistics;
+    }
+    return rc;
+}
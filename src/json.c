@@ -20,8 +20,28 @@
 #include <math.h>
 
 #define delim(op__) ((struct jsdrv_union_s){.type=JSDRV_UNION_NULL, .op=op__, .flags=0, .app=0, .value={.u64=0}, .size=0})
-const char * WHITESPACE = " \n\t\r";
-const char * ESCAPE = "\"\\/bfnrtu";
+
+// Character classes, one table lookup replaces the list scans.
+#define CC_WS       (0x01)  // whitespace: " \n\t\r"
+#define CC_ESCAPE   (0x02)  // valid after backslash: "\"\\/bfnrtu"
+#define CC_HEX      (0x04)  // hexadecimal digit
+#define CC_STR_END  (0x08)  // stops the string scan: '"', '\\' and the terminator
+#define CC_FLOAT    (0x10)  // starts a fractional or exponent part: ".eE"
+
+static const uint8_t CHAR_CLASS[256] = {
+    [0] = CC_STR_END,
+    [' '] = CC_WS, ['\n'] = CC_WS, ['\t'] = CC_WS, ['\r'] = CC_WS,
+    ['"'] = CC_ESCAPE | CC_STR_END, ['\\'] = CC_ESCAPE | CC_STR_END, ['/'] = CC_ESCAPE,
+    ['b'] = CC_ESCAPE | CC_HEX, ['f'] = CC_ESCAPE | CC_HEX,
+    ['n'] = CC_ESCAPE, ['r'] = CC_ESCAPE, ['t'] = CC_ESCAPE, ['u'] = CC_ESCAPE,
+    ['0'] = CC_HEX, ['1'] = CC_HEX, ['2'] = CC_HEX, ['3'] = CC_HEX, ['4'] = CC_HEX,
+    ['5'] = CC_HEX, ['6'] = CC_HEX, ['7'] = CC_HEX, ['8'] = CC_HEX, ['9'] = CC_HEX,
+    ['a'] = CC_HEX, ['c'] = CC_HEX, ['d'] = CC_HEX, ['e'] = CC_HEX | CC_FLOAT,
+    ['A'] = CC_HEX, ['B'] = CC_HEX, ['C'] = CC_HEX, ['D'] = CC_HEX, ['E'] = CC_HEX | CC_FLOAT, ['F'] = CC_HEX,
+    ['.'] = CC_FLOAT,
+};
+
+#define CHAR_IS(ch__, cc__) (CHAR_CLASS[(uint8_t) (ch__)] & (cc__))
 
 #define NEXT(s__)       (s__)->json[(s__)->offset]
 #define ADVANCE(s__)    (s__)->offset++
@@ -43,32 +63,8 @@ static int32_t on_token_ignore(void * user_data, const struct jsdrv_union_s * to
     return 0;
 }
 
-static int32_t is_in(char ch, const char * list) {
-    for (const char * w = list; *w; ++w) {
-        if (ch == *w) {
-            return 1;
-        }
-    }
-    return 0;
-}
-
-static int32_t is_whitespace(char ch) { return is_in(ch, WHITESPACE); }
-static int32_t is_escape(char ch) { return is_in(ch, ESCAPE); }
-
-static int32_t to_hex(char v) {
-    if ((v >= '0') && (v <= '9')) {
-        return v - '0';
-    } else if ((v >= 'a') && (v <= 'f')) {
-        return v - 'a' + 10;
-    } else if ((v >= 'A') && (v <= 'F')) {
-        return v - 'A' + 10;
-    } else {
-        return -1;
-    }
-}
-
 static void skip_whitespace(struct parse_s * s) {
-    while (is_whitespace(NEXT(s))) {
+    while (CHAR_IS(NEXT(s), CC_WS)) {
         ADVANCE(s);
     }
 }
@@ -89,6 +85,9 @@ static int32_t parse_string(struct parse_s * s, uint8_t op) {
     uint32_t offset_start = s->offset;
     char ch;
     while (1) {
+        while (!CHAR_IS(NEXT(s), CC_STR_END)) {
+            ADVANCE(s);  // ordinary string characters
+        }
         ch = NEXT(s);
         if (!ch) {
             JSDRV_LOGW("unterminated string starting at %u", offset_start - 1);
@@ -99,7 +98,7 @@ static int32_t parse_string(struct parse_s * s, uint8_t op) {
         } else if (ch == '\\') {
             ADVANCE(s);
             ch = NEXT(s);
-            if (!is_escape(ch)) {
+            if (!CHAR_IS(ch, CC_ESCAPE)) {
                 JSDRV_LOGW("invalid string escape %c at %u", ch, s->offset);
                 return JSDRV_ERROR_SYNTAX_ERROR;
             }
@@ -107,7 +106,7 @@ static int32_t parse_string(struct parse_s * s, uint8_t op) {
                 for (int i = 0; i < 4; i++) {
                     ADVANCE(s);
                     ch = NEXT(s);
-                    if (to_hex(ch) < 0) {
+                    if (!CHAR_IS(ch, CC_HEX)) {
                         JSDRV_LOGW("invalid string escape hex %c at %u", ch, s->offset);
                         return JSDRV_ERROR_SYNTAX_ERROR;
                     }
@@ -226,7 +225,7 @@ static int32_t parse_number(struct parse_s * s) {
         return JSDRV_ERROR_SYNTAX_ERROR;
     }
 
-    if (!is_in(NEXT(s), ".eE")) {  // i32
+    if (!CHAR_IS(NEXT(s), CC_FLOAT)) {  // i32
         if (is_neg) {
             whole = -whole;
         }
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/latency.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv.h"
+#include <string.h>
+
+#if _WIN32
+#include <windows.h>
+#endif
+
+#define LINEAR_BINS (16U)     // one bin per us below 16 us
+#define OCTAVE_SHIFT (3U)     // 8 bins per octave
+#define OCTAVE_FIRST (4U)     // log2(LINEAR_BINS)
+
+
+volatile uint64_t jsdrv_latency_bins[JSDRV_LATENCY_STAGE_COUNT][JSDRV_LATENCY_BINS];
+static volatile int32_t trailer_enable_ = 0;
+
+static const char * STAGE_NAMES[JSDRV_LATENCY_STAGE_COUNT] = {
+    [JSDRV_LATENCY_DECODE] = "decode",
+    [JSDRV_LATENCY_QUEUE] = "queue",
+    [JSDRV_LATENCY_DELIVER] = "deliver",
+    [JSDRV_LATENCY_TOTAL] = "total",
+};
+
+static inline uint64_t bin_load(volatile uint64_t * p) {
+#if _WIN32
+    return (uint64_t) InterlockedCompareExchange64((volatile LONG64 *) p, 0, 0);
+#else
+    return __atomic_load_n(p, __ATOMIC_RELAXED);
+#endif
+}
+
+const char * jsdrv_latency_stage_name(uint32_t stage) {
+    if (stage >= JSDRV_LATENCY_STAGE_COUNT) {
+        return NULL;
+    }
+    return STAGE_NAMES[stage];
+}
+
+uint32_t jsdrv_latency_bin(uint64_t us) {
+    if (us < LINEAR_BINS) {
+        return (uint32_t) us;
+    }
+    uint32_t octave = 63;
+    while (0 == (us & (1ULL << octave))) {
+        --octave;
+    }
+    uint32_t sub = (uint32_t) (us >> (octave - OCTAVE_SHIFT)) & ((1U << OCTAVE_SHIFT) - 1);
+    uint32_t bin = LINEAR_BINS + ((octave - OCTAVE_FIRST) << OCTAVE_SHIFT) + sub;
+    return (bin < JSDRV_LATENCY_BINS) ? bin : (JSDRV_LATENCY_BINS - 1);
+}
+
+uint64_t jsdrv_latency_bin_value(uint32_t bin) {
+    if (bin < LINEAR_BINS) {
+        return bin;
+    }
+    if (bin >= JSDRV_LATENCY_BINS) {
+        bin = JSDRV_LATENCY_BINS - 1;
+    }
+    uint32_t octave = OCTAVE_FIRST + ((bin - LINEAR_BINS) >> OCTAVE_SHIFT);
+    uint64_t sub = (bin - LINEAR_BINS) & ((1U << OCTAVE_SHIFT) - 1);
+    return (((1ULL << OCTAVE_SHIFT) + sub + 1) << (octave - OCTAVE_SHIFT)) - 1;
+}
+
+void jsdrv_latency_add(uint32_t stage, int64_t duration) {
+    if (stage >= JSDRV_LATENCY_STAGE_COUNT) {
+        return;
+    }
+    uint64_t us = (duration > 0) ? (uint64_t) JSDRV_TIME_TO_MICROSECONDS(duration) : 0;
+    volatile uint64_t * p = &jsdrv_latency_bins[stage][jsdrv_latency_bin(us)];
+#if _WIN32
+    InterlockedIncrement64((volatile LONG64 *) p);
+#else
+    __atomic_fetch_add(p, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+uint64_t jsdrv_latency_get(uint32_t stage, uint64_t * bins) {
+    uint64_t total = 0;
+    if (stage >= JSDRV_LATENCY_STAGE_COUNT) {
+        memset(bins, 0, JSDRV_LATENCY_BINS * sizeof(uint64_t));
+        return 0;
+    }
+    for (uint32_t i = 0; i < JSDRV_LATENCY_BINS; ++i) {
+        bins[i] = bin_load(&jsdrv_latency_bins[stage][i]);
+        total += bins[i];
+    }
+    return total;
+}
+
+uint64_t jsdrv_latency_percentile(const uint64_t * bins, uint32_t ppt) {
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < JSDRV_LATENCY_BINS; ++i) {
+        total += bins[i];
+    }
+    if (0 == total) {
+        return 0;
+    }
+    uint64_t rank = (total * ppt + 999) / 1000;  // ceil, 1-based
+    if (rank < 1) {
+        rank = 1;
+    }
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < JSDRV_LATENCY_BINS; ++i) {
+        count += bins[i];
+        if (count >= rank) {
+            return jsdrv_latency_bin_value(i);
+        }
+    }
+    return jsdrv_latency_bin_value(JSDRV_LATENCY_BINS - 1);
+}
+
+void jsdrv_latency_reset(void) {
+    for (uint32_t stage = 0; stage < JSDRV_LATENCY_STAGE_COUNT; ++stage) {
+        for (uint32_t i = 0; i < JSDRV_LATENCY_BINS; ++i) {
+#if _WIN32
+            InterlockedExchange64((volatile LONG64 *) &jsdrv_latency_bins[stage][i], 0);
+#else
+            __atomic_store_n(&jsdrv_latency_bins[stage][i], 0, __ATOMIC_RELAXED);
+#endif
+        }
+    }
+    jsdrv_latency_trailer_set(false);
+}
+
+void jsdrv_latency_trailer_set(bool enable) {
+#if _WIN32
+    InterlockedExchange((volatile LONG *) &trailer_enable_, enable ? 1 : 0);
+#else
+    __atomic_store_n(&trailer_enable_, enable ? 1 : 0, __ATOMIC_RELAXED);
+#endif
+}
+
+static bool trailer_enabled(void) {
+#if _WIN32
+    return 0 != InterlockedCompareExchange((volatile LONG *) &trailer_enable_, 0, 0);
+#else
+    return 0 != __atomic_load_n(&trailer_enable_, __ATOMIC_RELAXED);
+#endif
+}
+
+static void trailer_append(struct jsdrvp_msg_s * msg) {
+    const struct jsdrv_stream_signal_s * s = (const struct jsdrv_stream_signal_s *) msg->value.value.bin;
+    uint32_t offset = JSDRV_STREAM_HEADER_SIZE + (uint32_t) (((uint64_t) s->element_count * s->element_size_bits + 7) / 8);
+    offset = (offset + 7) & ~7U;
+    if ((offset + sizeof(struct jsdrv_stream_latency_s)) > msg->capacity) {
+        return;  // no room, deliver without the trailer
+    }
+    memcpy(&msg->payload.bin[offset], &msg->latency, sizeof(msg->latency));
+    msg->value.size = offset + (uint32_t) sizeof(struct jsdrv_stream_latency_s);
+}
+
+void jsdrv_latency_dispatch(struct jsdrvp_msg_s * msg) {
+    if ((0 == msg->latency.usb) || (msg->value.app != JSDRV_PAYLOAD_TYPE_STREAM)) {
+        return;
+    }
+    JSDRV_LATENCY_STAMP(msg->latency.dispatch);
+    if (msg->latency.decode) {
+        jsdrv_latency_add(JSDRV_LATENCY_DECODE, msg->latency.decode - msg->latency.usb);
+        jsdrv_latency_add(JSDRV_LATENCY_QUEUE, msg->latency.dispatch - msg->latency.decode);
+    }
+    if (trailer_enabled() && (msg->value.value.bin == msg->payload.bin)) {
+        trailer_append(msg);
+    }
+}
+
+void jsdrv_latency_deliver(const struct jsdrvp_msg_s * msg) {
+    if ((0 == msg->latency.usb) || (msg->value.app != JSDRV_PAYLOAD_TYPE_STREAM)) {
+        return;
+    }
+    int64_t t = jsdrv_time_monotonic();
+    jsdrv_latency_add(JSDRV_LATENCY_DELIVER, t - msg->latency.dispatch);
+    jsdrv_latency_add(JSDRV_LATENCY_TOTAL, t - msg->latency.usb);
+}
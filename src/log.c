@@ -21,14 +21,19 @@
  */
 
 #include "jsdrv_prv/log.h"
+#include "jsdrv_prv/alloc.h"
 #include "jsdrv_prv/platform.h"
 #include "jsdrv/error_code.h"
 #include "jsdrv_prv/cdef.h"
 #include "jsdrv/cstr.h"
 #include "jsdrv_prv/list.h"
 #include "jsdrv_prv/mutex.h"
+#include "jsdrv_prv/atomic.h"
+#include "jsdrv_prv/thread.h"
 #include "tinyprintf.h"
 #include <stdio.h>
+#include <stddef.h>
+#include <string.h>
 
 #if _WIN32
 #include <windows.h>
@@ -42,11 +47,22 @@
 #define LOG_DPRINTF       (0)
 #define MSG_COUNT_INIT    (1024U)
 #define MSG_PEND_COUNT_MAX (1024U)
+#define RING_COUNT        (64U)              // threads with deferred rings
+#define RING_SIZE         (64U * 1024U)      // bytes per thread
+#define RECORD_SIZE_MAX   (2048U)            // bytes per deferred record
+#define RECORD_STR_MAX    (JSDRV_LOG_MESSAGE_SIZE_MAX)
+#define RATE_SITE_COUNT   (256U)             // JSDRV_LOG_RATE() call sites with summaries
 #define LOCK_MSG()        jsdrv_os_mutex_lock(log_instance_.msg_mutex)
 #define UNLOCK_MSG()      jsdrv_os_mutex_unlock(log_instance_.msg_mutex)
 #define LOCK_DISPATCH()   jsdrv_os_mutex_lock(log_instance_.dispatch_mutex)
 #define UNLOCK_DISPATCH() jsdrv_os_mutex_unlock(log_instance_.dispatch_mutex)
 
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
 #ifdef _MSC_VER
 #define dprintf(fmt, ...) do { if (LOG_DPRINTF) {printf(fmt "\n", __VA_ARGS__); }} while (0)
 #else
@@ -99,11 +115,75 @@ struct dispatch_s {
     void * user_data;
 };
 
+/*
+ * Deferred records hold the format pointer and the captured arguments.
+ * Each argument, including '*' width and precision, occupies one arg_u.
+ * Strings store their length in one arg_u followed by the nul-terminated
+ * characters padded to a multiple of 8 bytes.
+ */
+union arg_u {
+    int64_t i;
+    uint64_t u;
+    double f;
+    const void * p;
+};
+
+struct record_s {
+    uint32_t size;          // total bytes, multiple of 8, 0 to wrap to the ring start
+    uint32_t line;
+    uint8_t level;
+    uint8_t rsv8[7];
+    int64_t timestamp;
+    const char * filename;
+    const char * format;
+};
+
+#define RECORD_HEADER_SIZE (((sizeof(struct record_s) + 7U) / 8U) * 8U)
+
+/*
+ * A single-producer, single-consumer ring owned by one thread.
+ * The owning thread writes records and advances head.
+ * The log thread formats records and advances tail.
+ * Head always leaves room for the 8-byte wrap record.
+ */
+struct ring_s {
+    volatile int32_t head;
+    volatile int32_t tail;
+    volatile int32_t dropped;
+    uint8_t * buffer;
+};
+
+enum length_e {
+    LENGTH_NONE,
+    LENGTH_HH,
+    LENGTH_H,
+    LENGTH_L,
+    LENGTH_LL,
+    LENGTH_Z,
+    LENGTH_J,
+    LENGTH_T,
+    LENGTH_LD,
+};
+
+// A parsed printf conversion specification.
+struct spec_s {
+    const char * flags;
+    uint8_t flags_size;
+    uint8_t width_star;
+    uint8_t precision_star;
+    uint8_t has_precision;
+    const char * width;
+    uint8_t width_size;
+    const char * precision;
+    uint8_t precision_size;
+    uint8_t length;         // length_e
+    char conversion;
+};
+
 struct log_s {
     volatile uint32_t initialized;
     volatile uint32_t active_count;
     volatile int8_t quit;
-    volatile int8_t level;
     volatile uint8_t dropping;
     volatile uint32_t msg_pend_count;
 
@@ -113,6 +193,14 @@ struct log_s {
     jsdrv_os_mutex_t dispatch_mutex;
     jsdrv_os_mutex_t msg_mutex;
 
+    volatile int32_t deferred;
+    volatile int32_t notify_pending;
+    volatile int32_t ring_count;
+    struct ring_s rings[RING_COUNT];
+    char message[JSDRV_LOG_MESSAGE_SIZE_MAX];  // deferred format buffer, log thread only
+    volatile int32_t rate_count;
+    struct jsdrv_log_rate_s * volatile rate_sites[RATE_SITE_COUNT];
+
 #if _WIN32
     // Windows
     HANDLE event;
@@ -125,11 +213,12 @@ struct log_s {
 #endif
 };
 
+volatile int8_t jsdrv_log_level_ = JSDRV_LOG_LEVEL_OFF;
+
 static struct log_s log_instance_ = {
         .initialized=0,
         .active_count=0,
         .quit=0,
-        .level=JSDRV_LOG_LEVEL_OFF,
         .dropping=0,
         .msg_pend_count=0,
         .dispatch_list={NULL, NULL},
@@ -137,6 +226,9 @@ static struct log_s log_instance_ = {
         .msg_pend={NULL, NULL},
         .dispatch_mutex=NULL,
         .msg_mutex=NULL,
+        .deferred=0,
+        .notify_pending=0,
+        .ring_count=0,
 #if _WIN32
         .event=NULL,
         .thread=NULL,
@@ -159,7 +251,7 @@ static struct msg_s * msg_alloc() {
     }
     item = jsdrv_list_remove_head(&log_instance_.msg_free);
     if (NULL == item) {
-        msg = jsdrv_alloc(sizeof(struct msg_s));
+        msg = jsdrv_alloc_cat(sizeof(struct msg_s), JSDRV_ALLOC_CAT_LOG);
         jsdrv_list_initialize(&msg->item);
     } else {
         msg = JSDRV_CONTAINER_OF(item, struct msg_s, item);
@@ -167,25 +259,26 @@ static struct msg_s * msg_alloc() {
     return msg;
 }
 
-void jsdrv_log_publish(uint8_t level, const char * filename, uint32_t line, const char * format, ...) {
-    va_list args;
+static bool publish_check(uint8_t level) {
     if (0 == log_instance_.active_count) {
         dprintf("jsdrv_log_publish but not active");
-        return;
+        return false;
     } else if (log_instance_.quit) {
         dprintf("jsdrv_log_publish but quit");
-        return;
-    } else if (level > log_instance_.level) {
+        return false;
+    } else if (level > jsdrv_log_level_) {
         // dprintf("jsdrv_log_publish but ignore");
-        return;
+        return false;
     } else if (log_instance_.dropping != 0) {
         // dprintf("jsdrv_log_publish dropping");
-        return;
+        return false;
     } else {
         // dprintf("jsdrv_log_publish");
+        return true;
     }
+}
 
-    va_start(args, format);
+static void publish_locked(uint8_t level, const char * filename, uint32_t line, const char * format, va_list args) {
     LOCK_MSG();
     if (0 == log_instance_.dropping) {
         struct msg_s *msg = msg_alloc();
@@ -219,11 +312,308 @@ void jsdrv_log_publish(uint8_t level, const char * filename, uint32_t line, cons
         }
     }
     UNLOCK_MSG();
+}
+
+void jsdrv_log_publish(uint8_t level, const char * filename, uint32_t line, const char * format, ...) {
+    va_list args;
+    if (!publish_check(level)) {
+        return;
+    }
+    va_start(args, format);
+    publish_locked(level, filename, line, format, args);
+    va_end(args);
+}
+
+static const char * digits_parse(const char * p, const char ** start, uint8_t * size) {
+    *start = p;
+    while ((*p >= '0') && (*p <= '9')) {
+        ++p;
+    }
+    *size = (uint8_t) (p - *start);
+    return p;
+}
+
+/**
+ * @brief Parse a printf conversion specification.
+ *
+ * @param p The character following '%'.
+ * @param[out] spec The parsed specification.
+ * @return The character following the conversion, or NULL if not supported.
+ */
+static const char * spec_parse(const char * p, struct spec_s * spec) {
+    memset(spec, 0, sizeof(*spec));
+    spec->flags = p;
+    while ((*p == '-') || (*p == '+') || (*p == ' ') || (*p == '#') || (*p == '0')) {
+        ++p;
+    }
+    spec->flags_size = (uint8_t) (p - spec->flags);
+    if (*p == '*') {
+        spec->width_star = 1;
+        ++p;
+    } else {
+        p = digits_parse(p, &spec->width, &spec->width_size);
+    }
+    if (*p == '.') {
+        spec->has_precision = 1;
+        ++p;
+        if (*p == '*') {
+            spec->precision_star = 1;
+            ++p;
+        } else {
+            p = digits_parse(p, &spec->precision, &spec->precision_size);
+        }
+    }
+    switch (*p) {
+        case 'h':
+            ++p;
+            if (*p == 'h') {
+                ++p;
+                spec->length = LENGTH_HH;
+            } else {
+                spec->length = LENGTH_H;
+            }
+            break;
+        case 'l':
+            ++p;
+            if (*p == 'l') {
+                ++p;
+                spec->length = LENGTH_LL;
+            } else {
+                spec->length = LENGTH_L;
+            }
+            break;
+        case 'z': ++p; spec->length = LENGTH_Z; break;
+        case 'j': ++p; spec->length = LENGTH_J; break;
+        case 't': ++p; spec->length = LENGTH_T; break;
+        case 'L': ++p; spec->length = LENGTH_LD; break;
+        default: break;
+    }
+    spec->conversion = *p;
+    if ((spec->flags_size + spec->width_size + spec->precision_size) > 32) {
+        return NULL;  // too long for record_format()
+    }
+    switch (spec->conversion) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        case 'p':
+            return p + 1;
+        case 'c': case 's':  // wide characters are not supported
+            return (spec->length == LENGTH_NONE) ? (p + 1) : NULL;
+        default:  // includes %n and invalid specifications
+            return NULL;
+    }
+}
+
+static int64_t arg_signed(uint8_t length, va_list * args) {
+    switch (length) {
+        case LENGTH_HH: return (signed char) va_arg(*args, int);
+        case LENGTH_H: return (short) va_arg(*args, int);
+        case LENGTH_L: return va_arg(*args, long);
+        case LENGTH_LL: return va_arg(*args, long long);
+        case LENGTH_Z: return (int64_t) va_arg(*args, size_t);
+        case LENGTH_J: return va_arg(*args, intmax_t);
+        case LENGTH_T: return va_arg(*args, ptrdiff_t);
+        default: return va_arg(*args, int);
+    }
+}
+
+static uint64_t arg_unsigned(uint8_t length, va_list * args) {
+    switch (length) {
+        case LENGTH_HH: return (unsigned char) va_arg(*args, unsigned int);
+        case LENGTH_H: return (unsigned short) va_arg(*args, unsigned int);
+        case LENGTH_L: return va_arg(*args, unsigned long);
+        case LENGTH_LL: return va_arg(*args, unsigned long long);
+        case LENGTH_Z: return va_arg(*args, size_t);
+        case LENGTH_J: return va_arg(*args, uintmax_t);
+        case LENGTH_T: return (uint64_t) va_arg(*args, ptrdiff_t);
+        default: return va_arg(*args, unsigned int);
+    }
+}
+
+/**
+ * @brief Capture the arguments for format.
+ *
+ * @param format The printf-compatible format.
+ * @param args The arguments.
+ * @param[out] buf The destination for the arguments.
+ * @param buf_size The size of buf in bytes, a multiple of 8.
+ * @return The captured size in bytes, or -1 if not supported.
+ */
+static int32_t args_capture(const char * format, va_list * args, uint8_t * buf, uint32_t buf_size) {
+    struct spec_s spec;
+    union arg_u * a = (union arg_u *) buf;
+    union arg_u * a_end = (union arg_u *) (buf + buf_size);
+    const char * p = format;
+    while (*p) {
+        if (*p++ != '%') {
+            continue;
+        }
+        if (*p == '%') {
+            ++p;
+            continue;
+        }
+        p = spec_parse(p, &spec);
+        if (NULL == p) {
+            return -1;
+        }
+        int precision = -1;
+        if (spec.width_star) {
+            if (a >= a_end) {
+                return -1;
+            }
+            (a++)->i = va_arg(*args, int);
+        }
+        if (spec.precision_star) {
+            if (a >= a_end) {
+                return -1;
+            }
+            precision = va_arg(*args, int);
+            (a++)->i = precision;
+        } else if (spec.has_precision) {
+            precision = 0;
+            for (uint8_t i = 0; i < spec.precision_size; ++i) {
+                precision = precision * 10 + (spec.precision[i] - '0');
+            }
+        }
+        if (a >= a_end) {
+            return -1;
+        }
+        switch (spec.conversion) {
+            case 'd': case 'i': case 'c':
+                a->i = arg_signed(spec.length, args);
+                break;
+            case 'u': case 'o': case 'x': case 'X':
+                a->u = arg_unsigned(spec.length, args);
+                break;
+            case 'p':
+                a->p = va_arg(*args, void *);
+                break;
+            case 's': {
+                const char * str = va_arg(*args, const char *);
+                if (NULL == str) {
+                    str = "(null)";
+                }
+                if ((a + 1) >= a_end) {
+                    return -1;
+                }
+                // bound by precision since the string may not be terminated
+                size_t sz_max = ((uint8_t *) a_end - (uint8_t *) (a + 1)) - 1;
+                if (sz_max > RECORD_STR_MAX) {
+                    sz_max = RECORD_STR_MAX;
+                }
+                if ((precision >= 0) && ((size_t) precision < sz_max)) {
+                    sz_max = (size_t) precision;
+                }
+                size_t sz = 0;
+                while ((sz < sz_max) && str[sz]) {
+                    ++sz;
+                }
+                a->u = sz;
+                char * dst = (char *) (a + 1);
+                memcpy(dst, str, sz);
+                dst[sz] = 0;
+                a += 1 + (sz + 8) / 8;
+                continue;
+            }
+            default:
+                if (spec.length == LENGTH_LD) {
+                    a->f = (double) va_arg(*args, long double);
+                } else {
+                    a->f = va_arg(*args, double);
+                }
+                break;
+        }
+        ++a;
+    }
+    return (int32_t) ((uint8_t *) a - buf);
+}
+
+static struct ring_s * ring_claim() {
+    static THREAD_LOCAL struct ring_s * ring_ = NULL;
+    static THREAD_LOCAL uint8_t ring_none_ = 0;
+    if ((NULL == ring_) && !ring_none_) {
+        int32_t idx = jsdrv_atomic_add(&log_instance_.ring_count, 1) - 1;
+        if (idx >= (int32_t) RING_COUNT) {
+            ring_none_ = 1;  // use the locked path
+        } else {
+            struct ring_s * ring = &log_instance_.rings[idx];
+            ring->buffer = jsdrv_alloc_cat(RING_SIZE, JSDRV_ALLOC_CAT_LOG);
+            ring_ = ring;
+        }
+    }
+    return ring_;
+}
+
+static bool ring_write(struct ring_s * ring, const uint8_t * record, uint32_t size) {
+    uint32_t head = (uint32_t) jsdrv_atomic_load(&ring->head);
+    uint32_t tail = (uint32_t) jsdrv_atomic_load(&ring->tail);
+    uint32_t next;
+    if (head >= tail) {
+        if ((head + size) <= (RING_SIZE - 8U)) {
+            next = head;
+        } else if (size < tail) {
+            ((struct record_s *) (ring->buffer + head))->size = 0;  // wrap
+            next = 0;
+        } else {
+            return false;
+        }
+    } else if ((head + size) < tail) {
+        next = head;
+    } else {
+        return false;
+    }
+    memcpy(ring->buffer + next, record, size);
+    jsdrv_atomic_store(&ring->head, (int32_t) (next + size));
+    return true;
+}
+
+static bool publish_deferred(uint8_t level, const char * filename, uint32_t line, const char * format, va_list args) {
+    uint64_t buf[RECORD_SIZE_MAX / sizeof(uint64_t)];
+    uint8_t * record = (uint8_t *) buf;
+    va_list args_copy;
+    struct ring_s * ring = ring_claim();
+    if (NULL == ring) {
+        return false;
+    }
+    va_copy(args_copy, args);
+    int32_t sz = args_capture(format, &args_copy, record + RECORD_HEADER_SIZE,
+                              (uint32_t) (sizeof(buf) - RECORD_HEADER_SIZE));
+    va_end(args_copy);
+    if (sz < 0) {
+        return false;
+    }
+    struct record_s * r = (struct record_s *) record;
+    r->size = (uint32_t) (RECORD_HEADER_SIZE + sz);
+    r->line = line;
+    r->level = level;
+    memset(r->rsv8, 0, sizeof(r->rsv8));
+    r->timestamp = jsdrv_time_utc();
+    r->filename = filename;
+    r->format = format;
+    if (!ring_write(ring, record, r->size)) {
+        jsdrv_atomic_add(&ring->dropped, 1);
+    }
+    // batch notifications: only the first record since the last process()
+    if (1 == jsdrv_atomic_add(&log_instance_.notify_pending, 1)) {
+        thread_notify();
+    }
+    return true;
+}
+
+void jsdrv_log_publish_static(uint8_t level, const char * filename, uint32_t line, const char * format, ...) {
+    va_list args;
+    if (!publish_check(level)) {
+        return;
+    }
+    va_start(args, format);
+    if (!log_instance_.deferred || !publish_deferred(level, filename, line, format, args)) {
+        publish_locked(level, filename, line, format, args);
+    }
     va_end(args);
 }
 
 int32_t jsdrv_log_register(jsdrv_log_recv fn, void * user_data) {
-    struct dispatch_s * dispatch = jsdrv_alloc(sizeof(struct dispatch_s));
+    struct dispatch_s * dispatch = jsdrv_alloc_cat(sizeof(struct dispatch_s), JSDRV_ALLOC_CAT_LOG);
     jsdrv_list_initialize(&dispatch->item);
     dispatch->fn = fn;
     dispatch->user_data = user_data;
@@ -254,11 +644,195 @@ int32_t jsdrv_log_unregister(jsdrv_log_recv fn, void * user_data) {
     return 0;
 }
 
+static void dispatch(struct log_s * self, struct jsdrv_log_header_s const * header,
+                     const char * filename, const char * message) {
+    struct jsdrv_list_s * item = NULL;
+    struct dispatch_s * d = NULL;
+    LOCK_DISPATCH();
+    jsdrv_list_foreach(&self->dispatch_list, item) {
+        d = JSDRV_CONTAINER_OF(item, struct dispatch_s, item);
+        d->fn(d->user_data, header, filename, message);
+    }
+    UNLOCK_DISPATCH();
+}
+
+static void record_format(const struct record_s * r, char * buf, size_t buf_size) {
+    struct spec_s spec;
+    char fmt[64];
+    size_t pos = 0;
+    const union arg_u * a = (const union arg_u *) (((const uint8_t *) r) + RECORD_HEADER_SIZE);
+    const char * p = r->format;
+    while (*p && (pos + 1 < buf_size)) {
+        if (*p != '%') {
+            buf[pos++] = *p++;
+            continue;
+        }
+        ++p;
+        if (*p == '%') {
+            buf[pos++] = *p++;
+            continue;
+        }
+        p = spec_parse(p, &spec);  // same result as args_capture()
+        size_t k = 0;
+        fmt[k++] = '%';
+        memcpy(fmt + k, spec.flags, spec.flags_size);
+        k += spec.flags_size;
+        if (spec.width_star) {
+            k += snprintf(fmt + k, sizeof(fmt) - k, "%d", (int) (a++)->i);
+        } else {
+            memcpy(fmt + k, spec.width, spec.width_size);
+            k += spec.width_size;
+        }
+        if (spec.precision_star) {
+            int precision = (int) (a++)->i;
+            if (precision >= 0) {  // negative is the same as omitted
+                k += snprintf(fmt + k, sizeof(fmt) - k, ".%d", precision);
+            }
+        } else if (spec.has_precision) {
+            fmt[k++] = '.';
+            memcpy(fmt + k, spec.precision, spec.precision_size);
+            k += spec.precision_size;
+        }
+        int rv;
+        size_t remaining = buf_size - pos;
+        switch (spec.conversion) {
+            case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+                fmt[k++] = 'l';
+                fmt[k++] = 'l';
+                fmt[k++] = spec.conversion;
+                fmt[k] = 0;
+                if ((spec.conversion == 'd') || (spec.conversion == 'i')) {
+                    rv = snprintf(buf + pos, remaining, fmt, (long long) a->i);
+                } else {
+                    rv = snprintf(buf + pos, remaining, fmt, (unsigned long long) a->u);
+                }
+                ++a;
+                break;
+            case 'c':
+                fmt[k++] = 'c';
+                fmt[k] = 0;
+                rv = snprintf(buf + pos, remaining, fmt, (int) (a++)->i);
+                break;
+            case 'p':
+                fmt[k++] = 'p';
+                fmt[k] = 0;
+                rv = snprintf(buf + pos, remaining, fmt, (a++)->p);
+                break;
+            case 's':
+                fmt[k++] = 's';
+                fmt[k] = 0;
+                rv = snprintf(buf + pos, remaining, fmt, (const char *) (a + 1));
+                a += 1 + (a->u + 8) / 8;
+                break;
+            default:
+                fmt[k++] = spec.conversion;
+                fmt[k] = 0;
+                rv = snprintf(buf + pos, remaining, fmt, (a++)->f);
+                break;
+        }
+        if (rv > 0) {
+            pos += ((size_t) rv < remaining) ? (size_t) rv : (remaining - 1);
+        }
+    }
+    buf[pos] = 0;
+}
+
+static void ring_process(struct log_s * self, struct ring_s * ring) {
+    struct jsdrv_log_header_s header;
+    header.version = JSDRV_LOG_VERSION;
+    header.rsvu8_1 = 0;
+    header.rsvu8_2 = 0;
+
+    int32_t dropped = jsdrv_atomic_load(&ring->dropped);
+    if (dropped) {
+        jsdrv_atomic_add(&ring->dropped, -dropped);
+        header.level = JSDRV_LOG_LEVEL_ERROR;
+        header.line = __LINE__;
+        header.timestamp = jsdrv_time_utc();
+        snprintf(self->message, sizeof(self->message), "log drop due to overflow: %d deferred messages", (int) dropped);
+        dispatch(self, &header, __FILENAME__, self->message);
+    }
+
+    uint32_t tail = (uint32_t) jsdrv_atomic_load(&ring->tail);
+    while (tail != (uint32_t) jsdrv_atomic_load(&ring->head)) {
+        const struct record_s * r = (const struct record_s *) (ring->buffer + tail);
+        if (0 == r->size) {
+            tail = 0;
+        } else {
+            if (r->level <= jsdrv_log_level_) {
+                header.level = r->level;
+                header.line = r->line;
+                header.timestamp = r->timestamp;
+                record_format(r, self->message, sizeof(self->message));
+                dispatch(self, &header, r->filename, self->message);
+            }
+            tail += r->size;
+        }
+        jsdrv_atomic_store(&ring->tail, (int32_t) tail);
+    }
+}
+
+bool jsdrv_log_rate_allow(struct jsdrv_log_rate_s * self) {
+    uint32_t now = jsdrv_time_ms_u32();
+    int32_t dt = (int32_t) (now - (uint32_t) jsdrv_atomic_load(&self->start_ms));
+    if ((dt < 0) || (dt >= JSDRV_LOG_RATE_INTERVAL_MS)) {
+        // racing threads may both restart the interval, which only allows extra messages
+        jsdrv_atomic_store(&self->start_ms, (int32_t) now);
+        jsdrv_atomic_store(&self->count, 0);
+    }
+    if (jsdrv_atomic_add(&self->count, 1) <= JSDRV_LOG_RATE_BURST) {
+        return true;
+    }
+    if ((0 == jsdrv_atomic_load(&self->registered)) && (1 == jsdrv_atomic_add(&self->registered, 1))) {
+        int32_t idx = jsdrv_atomic_add(&log_instance_.rate_count, 1) - 1;
+        if (idx < (int32_t) RATE_SITE_COUNT) {
+            self->summary_ms = now;
+            jsdrv_atomic_fence();
+            log_instance_.rate_sites[idx] = self;
+        }
+    }
+    jsdrv_atomic_add(&self->suppressed, 1);
+    return false;
+}
+
+static void rate_process(struct log_s * self, bool flush) {
+    struct jsdrv_log_header_s header;
+    header.version = JSDRV_LOG_VERSION;
+    header.rsvu8_1 = 0;
+    header.rsvu8_2 = 0;
+    uint32_t now = jsdrv_time_ms_u32();
+    int32_t count = jsdrv_atomic_load(&self->rate_count);
+    if (count > (int32_t) RATE_SITE_COUNT) {
+        count = RATE_SITE_COUNT;
+    }
+    for (int32_t i = 0; i < count; ++i) {
+        struct jsdrv_log_rate_s * site = self->rate_sites[i];
+        if (NULL == site) {
+            continue;  // registration in progress
+        }
+        jsdrv_atomic_fence();
+        int32_t suppressed = jsdrv_atomic_load(&site->suppressed);
+        if ((suppressed <= 0) || (!flush && ((now - site->summary_ms) < JSDRV_LOG_RATE_INTERVAL_MS))) {
+            continue;
+        }
+        jsdrv_atomic_add(&site->suppressed, -suppressed);
+        site->summary_ms = now;
+        if (site->level <= jsdrv_log_level_) {
+            header.level = site->level;
+            header.line = site->line;
+            header.timestamp = jsdrv_time_utc();
+            snprintf(self->message, sizeof(self->message), "suppressed %d similar messages: %s",
+                     (int) suppressed, site->format);
+            dispatch(self, &header, site->filename, self->message);
+        }
+    }
+}
+
 static void process(struct log_s * self) {
     struct jsdrv_list_s * item = NULL;
     struct msg_s * msg = NULL;
-    struct dispatch_s * dispatch = NULL;
 
+    jsdrv_atomic_store(&self->notify_pending, 0);
     while (1) {
         LOCK_MSG();
         if (NULL != msg) {
@@ -276,16 +850,20 @@ static void process(struct log_s * self) {
             log_instance_.dropping = 0;
         }
         msg = JSDRV_CONTAINER_OF(item, struct msg_s, item);
-        if (msg->header.level > self->level) {
+        if (msg->header.level > jsdrv_log_level_) {
             continue;
         }
-        LOCK_DISPATCH();
-        jsdrv_list_foreach(&self->dispatch_list, item) {
-            dispatch = JSDRV_CONTAINER_OF(item, struct dispatch_s, item);
-            dispatch->fn(dispatch->user_data, &msg->header, msg->filename, msg->message);
-        }
-        UNLOCK_DISPATCH();
+        dispatch(self, &msg->header, msg->filename, msg->message);
+    }
+
+    int32_t ring_count = jsdrv_atomic_load(&self->ring_count);
+    if (ring_count > (int32_t) RING_COUNT) {
+        ring_count = RING_COUNT;
+    }
+    for (int32_t i = 0; i < ring_count; ++i) {
+        ring_process(self, &self->rings[i]);
     }
+    rate_process(self, 0 != self->quit);
 }
 
 static void list_free(struct jsdrv_list_s * list) {
@@ -302,12 +880,14 @@ static void list_free(struct jsdrv_list_s * list) {
 #if _WIN32
 static DWORD WINAPI log_thread(LPVOID lpParam) {
     (void) lpParam;
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_LOG);
     while (!log_instance_.quit) {
         WaitForSingleObject(log_instance_.event, 100);
         ResetEvent(log_instance_.event);
         process(&log_instance_);
     }
     process(&log_instance_);
+    jsdrv_thread_unregister();
     dprintf("log_thread exit");
     return 0;
 }
@@ -364,6 +944,7 @@ static void * log_thread(void * arg) {
     struct pollfd fds;
     fds.fd = log_instance_.fd_read;
     fds.events = POLLIN;
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_LOG);
     while (!log_instance_.quit) {
         fds.revents = 0;
         poll(&fds, 1, 100);
@@ -375,6 +956,7 @@ static void * log_thread(void * arg) {
         process(&log_instance_);
     }
     process(&log_instance_);
+    jsdrv_thread_unregister();
     return 0;
 }
 
@@ -453,7 +1035,7 @@ void jsdrv_log_initialize() {
         }
 
         for (size_t i = 0; i < MSG_COUNT_INIT; ++i) {
-            struct msg_s *msg = jsdrv_alloc(sizeof(struct msg_s));
+            struct msg_s *msg = jsdrv_alloc_cat(sizeof(struct msg_s), JSDRV_ALLOC_CAT_LOG);
             jsdrv_list_initialize(&msg->item);
             jsdrv_list_add_tail(&log_instance_.msg_free, &msg->item);
         }
@@ -495,18 +1077,26 @@ void jsdrv_log_finalize() {
         list_free(&log_instance_.msg_free);
         UNLOCK_MSG();
         UNLOCK_DISPATCH();
-        // do not free the mutexes, for thread safety on exit
+        // do not free the mutexes or deferred rings, for thread safety on exit
         // jsdrv_os_mutex_free(log_instance_.msg_mutex);
         // jsdrv_os_mutex_free(log_instance_.dispatch_mutex);
     }
 }
 
 void jsdrv_log_level_set(int8_t level) {
-    log_instance_.level = level;
+    jsdrv_log_level_ = level;
 }
 
 int8_t jsdrv_log_level_get() {
-    return log_instance_.level;
+    return jsdrv_log_level_;
+}
+
+void jsdrv_log_deferred_set(bool enable) {
+    jsdrv_atomic_store(&log_instance_.deferred, enable ? 1 : 0);
+}
+
+bool jsdrv_log_deferred_get() {
+    return 0 != jsdrv_atomic_load(&log_instance_.deferred);
 }
 
 JSDRV_API const char * jsdrv_log_level_to_str(int8_t level) {
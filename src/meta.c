@@ -17,6 +17,7 @@
 #include "jsdrv/meta.h"
 #include "jsdrv/cstr.h"
 #include "jsdrv/error_code.h"
+#include "jsdrv_prv/cdef.h"
 #include "jsdrv_prv/json.h"
 #include "jsdrv_prv/log.h"
 #include "jsdrv_prv/platform.h"
@@ -38,6 +39,7 @@ const struct dtype_map_s dtype_map[] = {
         {"i32", JSDRV_UNION_I32},
         {"i64", JSDRV_UNION_I64},
         {"bool", JSDRV_UNION_U8},
+        {"str", JSDRV_UNION_STR},
         {NULL, 0},
 };
 
@@ -186,40 +188,38 @@ enum value_state_e {
     VALUE_ST_RANGE_VAL,
     VALUE_ST_OPTIONS,
     VALUE_ST_OPTIONS_VAL,
-    VALUE_ST_OPTIONS_MATCH,
+    VALUE_ST_DONE,
 };
 
-struct value_s {
+struct compile_s {
     uint8_t state;  // value_state_e
-    uint8_t type;
     uint8_t depth;
     uint8_t array_idx;
-    struct jsdrv_union_s * value;
     union jsdrv_union_inner_u option;
-    union jsdrv_union_inner_u range[3];
+    struct jsdrv_meta_schema_s * schema;
 };
 
-static void maybe_convert_str_to_type(struct value_s * s) {
+static void maybe_convert_str_to_type(uint8_t type, struct jsdrv_union_s * value) {
     int32_t i32 = 0;
     uint32_t u32 = 0;
-    if (s->value->type != JSDRV_UNION_STR) {
+    if (value->type != JSDRV_UNION_STR) {
         return;
     }
-    switch (s->type) {
+    switch (type) {
         case JSDRV_UNION_U8:   // intentional fall-through
         case JSDRV_UNION_U16:  // intentional fall-through
         case JSDRV_UNION_U32:  // intentional fall-through
-            if (!jsdrv_cstr_to_u32(s->value->value.str, &u32)) {
-                s->value->type = s->type;
-                s->value->value.u32 = u32;
+            if (!jsdrv_cstr_to_u32(value->value.str, &u32)) {
+                value->type = type;
+                value->value.u32 = u32;
             }
             break;
         case JSDRV_UNION_I8:   // intentional fall-through
         case JSDRV_UNION_I16:  // intentional fall-through
         case JSDRV_UNION_I32:  // intentional fall-through
-            if (!jsdrv_cstr_to_i32(s->value->value.str, &i32)) {
-                s->value->type = s->type;
-                s->value->value.i32 = i32;
+            if (!jsdrv_cstr_to_i32(value->value.str, &i32)) {
+                value->type = type;
+                value->value.i32 = i32;
             }
             break;
         default:
@@ -227,41 +227,57 @@ static void maybe_convert_str_to_type(struct value_s * s) {
     }
 }
 
-static int32_t on_value(void * user_data, const struct jsdrv_union_s * token) {
+static int32_t option_append(struct jsdrv_meta_schema_s * schema, const struct jsdrv_union_s * token,
+                             union jsdrv_union_inner_u value) {
+    if (schema->option_count >= schema->option_size) {
+        uint32_t sz = schema->option_size ? (schema->option_size * 2) : 16;
+        struct jsdrv_meta_option_s * options = jsdrv_alloc(sz * sizeof(struct jsdrv_meta_option_s));
+        if (schema->options) {
+            jsdrv_memcpy(options, schema->options, schema->option_count * sizeof(struct jsdrv_meta_option_s));
+            jsdrv_free(schema->options);
+        }
+        schema->options = options;
+        schema->option_size = sz;
+    }
+    struct jsdrv_meta_option_s * option = &schema->options[schema->option_count++];
+    option->token = *token;
+    option->value = value;
+    return 0;
+}
+
+static int32_t on_compile(void * user_data, const struct jsdrv_union_s * token) {
     int32_t rc = 0;
-    struct value_s * s = (struct value_s *) user_data;
+    struct compile_s * s = (struct compile_s *) user_data;
+    struct jsdrv_meta_schema_s * schema = s->schema;
     struct jsdrv_union_s t;
     switch (token->op) {
         case JSDRV_JSON_VALUE:
             if (s->state == VALUE_ST_DTYPE_KEY) {
                 if (jsdrv_cstr_starts_with(token->value.str, "bool")) {
-                    bool val_bool = false;
-                    rc = jsdrv_union_to_bool(s->value, &val_bool);
-                    if (!rc) {
-                        s->value->type = JSDRV_UNION_U8;
-                        s->value->value.u8 = val_bool ? 1 : 0;
-                        rc = JSDRV_ERROR_ABORTED;
-                    }
+                    schema->dtype = JSDRV_UNION_U8;
+                    schema->flags |= JSDRV_META_SCHEMA_FLAG_BOOL;
+                    s->state = VALUE_ST_DONE;
+                    rc = JSDRV_ERROR_ABORTED;
                 } else {
-                    rc = dtype_lookup(token, &s->type);
-                    maybe_convert_str_to_type(s);
+                    rc = dtype_lookup(token, &schema->dtype);
                     s->state = VALUE_ST_SEARCH;
                 }
             } else if (s->state == VALUE_ST_RANGE_VAL) {
-                s->range[s->array_idx++].u64 = token->value.u64;
+                if (s->array_idx < JSDRV_ARRAY_SIZE(schema->range)) {
+                    schema->range[s->array_idx++].u64 = token->value.u64;
+                    schema->range_count = s->array_idx;
+                }
             } else if (s->state == VALUE_ST_OPTIONS_VAL) {
                 if (0 == s->array_idx++) {
                     t = *token;
-                    if (jsdrv_union_as_type(&t, s->type)) {
-                        return JSDRV_ERROR_PARAMETER_INVALID;
+                    if (jsdrv_union_as_type(&t, schema->dtype)) {
+                        // jsdrv_meta_value() fails on reaching this option, same as no match
+                        s->state = VALUE_ST_DONE;
+                        return JSDRV_ERROR_ABORTED;
                     }
                     s->option.u64 = t.value.u64;
                 }
-                if (jsdrv_union_equiv(s->value, token)) {
-                    s->value->value.u64 = s->option.u64;
-                    s->value->type = s->type;
-                    s->state = VALUE_ST_OPTIONS_MATCH;
-                }
+                rc = option_append(schema, token, s->option);
             }
             break;
         case JSDRV_JSON_KEY:
@@ -271,6 +287,7 @@ static int32_t on_value(void * user_data, const struct jsdrv_union_s * token) {
                 s->state = VALUE_ST_RANGE_KEY;
             } else if ((s->state == VALUE_ST_SEARCH) && (s->depth == 1) && (0 == jsdrv_json_strcmp("options", token))) {
                 s->state = VALUE_ST_OPTIONS;
+                schema->flags |= JSDRV_META_SCHEMA_FLAG_OPTIONS;
             }
             break;
         case JSDRV_JSON_OBJ_START: s->depth++; break;
@@ -284,14 +301,13 @@ static int32_t on_value(void * user_data, const struct jsdrv_union_s * token) {
             if (s->state == VALUE_ST_RANGE_KEY) {
                 s->array_idx = 0;
                 s->state = VALUE_ST_RANGE_VAL;
+                schema->flags |= JSDRV_META_SCHEMA_FLAG_RANGE;
             }
             break;
         case JSDRV_JSON_ARRAY_END:
             if ((s->state == VALUE_ST_OPTIONS_VAL) && (s->depth == 3)) {
                 s->state = VALUE_ST_OPTIONS;
             } else if ((s->state == VALUE_ST_OPTIONS) && (s->depth == 2)) {
-                rc = JSDRV_ERROR_PARAMETER_INVALID;  // no match
-            } else if ((s->state == VALUE_ST_OPTIONS_MATCH) && (s->depth == 2)) {
                 s->state = VALUE_ST_SEARCH;
             } else if ((s->state == VALUE_ST_RANGE_VAL) && (s->depth == 2)) {
                 s->state = VALUE_ST_SEARCH;
@@ -303,17 +319,78 @@ static int32_t on_value(void * user_data, const struct jsdrv_union_s * token) {
     return rc;
 }
 
-int32_t jsdrv_meta_value(const char * meta, struct jsdrv_union_s * value) {
-    if (!meta || !value) {
+int32_t jsdrv_meta_compile(const char * meta, struct jsdrv_meta_schema_s * schema) {
+    if (!schema) {
         return JSDRV_ERROR_PARAMETER_INVALID;
     }
-    struct value_s self = {
+    jsdrv_memset(schema, 0, sizeof(*schema));
+    if (!meta) {
+        schema->status = JSDRV_ERROR_PARAMETER_INVALID;
+        return schema->status;
+    }
+    struct compile_s self = {
             .state = VALUE_ST_DTYPE_SEARCH,
-            .type = JSDRV_UNION_NULL,
             .depth = 0,
-            .value=value,
-            .option={.u64=0},
-            .range={{.u64=0}, {.u64=0}, {.u64=0}}
+            .array_idx = 0,
+            .option = {.u64=0},
+            .schema = schema,
     };
-    return jsdrv_json_parse(meta, on_value, &self);
+    schema->status = jsdrv_json_parse(meta, on_compile, &self);
+    return schema->status;
+}
+
+int32_t jsdrv_meta_schema_value(const struct jsdrv_meta_schema_s * schema, struct jsdrv_union_s * value) {
+    if (!schema || !value) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (schema->status) {
+        return schema->status;
+    }
+    if (schema->flags & JSDRV_META_SCHEMA_FLAG_BOOL) {
+        bool val_bool = false;
+        int32_t rc = jsdrv_union_to_bool(value, &val_bool);
+        if (!rc) {
+            value->type = JSDRV_UNION_U8;
+            value->value.u8 = val_bool ? 1 : 0;
+        }
+        return rc;
+    }
+    if (JSDRV_UNION_NULL == schema->dtype) {
+        return 0;
+    }
+    maybe_convert_str_to_type(schema->dtype, value);
+    if (schema->flags & JSDRV_META_SCHEMA_FLAG_OPTIONS) {
+        for (uint32_t i = 0; i < schema->option_count; ++i) {
+            const struct jsdrv_meta_option_s * option = &schema->options[i];
+            if (jsdrv_union_equiv(value, &option->token)) {
+                value->value.u64 = option->value.u64;
+                value->type = schema->dtype;
+                return 0;
+            }
+        }
+        return JSDRV_ERROR_PARAMETER_INVALID;  // no match
+    }
+    return 0;
+}
+
+void jsdrv_meta_schema_free(struct jsdrv_meta_schema_s * schema) {
+    if (schema && schema->options) {
+        jsdrv_free(schema->options);
+        schema->options = NULL;
+        schema->option_count = 0;
+        schema->option_size = 0;
+    }
+}
+
+int32_t jsdrv_meta_value(const char * meta, struct jsdrv_union_s * value) {
+    if (!meta || !value) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct jsdrv_meta_schema_s schema;
+    int32_t rc = jsdrv_meta_compile(meta, &schema);
+    if (!rc) {
+        rc = jsdrv_meta_schema_value(&schema, value);
+    }
+    jsdrv_meta_schema_free(&schema);
+    return rc;
 }
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/meta_store.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/platform.h"
+#include <string.h>
+
+
+struct jsdrv_meta_store_s {
+    struct jsdrv_list_s buckets[JSDRV_META_STORE_BUCKETS];
+    uint32_t count;
+};
+
+static uint32_t content_hash(const char * json, uint32_t * size) {
+    uint32_t hash = 2166136261U;  // FNV-1a
+    const char * p = json;
+    while (*p) {
+        hash ^= (uint8_t) *p++;
+        hash *= 16777619U;
+    }
+    *size = (uint32_t) (p - json) + 1;
+    return hash;
+}
+
+static void entry_free(struct jsdrv_meta_entry_s * entry) {
+    jsdrv_meta_schema_free(&entry->schema);
+    jsdrv_free(entry);
+}
+
+struct jsdrv_meta_store_s * jsdrv_meta_store_alloc(void) {
+    struct jsdrv_meta_store_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_meta_store_s));
+    for (uint32_t idx = 0; idx < JSDRV_META_STORE_BUCKETS; ++idx) {
+        jsdrv_list_initialize(&self->buckets[idx]);
+    }
+    return self;
+}
+
+void jsdrv_meta_store_free(struct jsdrv_meta_store_s * self) {
+    if (NULL == self) {
+        return;
+    }
+    for (uint32_t idx = 0; idx < JSDRV_META_STORE_BUCKETS; ++idx) {
+        while (!jsdrv_list_is_empty(&self->buckets[idx])) {
+            struct jsdrv_list_s * item = jsdrv_list_remove_head(&self->buckets[idx]);
+            entry_free(JSDRV_CONTAINER_OF(item, struct jsdrv_meta_entry_s, item));
+        }
+    }
+    jsdrv_free(self);
+}
+
+const struct jsdrv_meta_entry_s * jsdrv_meta_store_intern(struct jsdrv_meta_store_s * self, const char * json) {
+    uint32_t size = 0;
+    uint32_t hash = content_hash(json, &size);
+    struct jsdrv_list_s * bucket = &self->buckets[hash & (JSDRV_META_STORE_BUCKETS - 1)];
+    struct jsdrv_list_s * item;
+    struct jsdrv_meta_entry_s * entry;
+    jsdrv_list_foreach(bucket, item) {
+        entry = JSDRV_CONTAINER_OF(item, struct jsdrv_meta_entry_s, item);
+        if ((entry->hash == hash) && (entry->size == size) && (0 == memcmp(entry->json, json, size))) {
+            ++entry->refcnt;
+            return entry;
+        }
+    }
+    entry = jsdrv_alloc_clr(sizeof(struct jsdrv_meta_entry_s) + size);
+    jsdrv_list_initialize(&entry->item);
+    entry->hash = hash;
+    entry->refcnt = 1;
+    entry->size = size;
+    memcpy(entry->json, json, size);
+    (void) jsdrv_meta_compile(entry->json, &entry->schema);  // validation returns any error
+    jsdrv_list_add_tail(bucket, &entry->item);
+    ++self->count;
+    return entry;
+}
+
+void jsdrv_meta_store_release(struct jsdrv_meta_store_s * self, const struct jsdrv_meta_entry_s * entry) {
+    if (NULL == entry) {
+        return;
+    }
+    struct jsdrv_meta_entry_s * e = (struct jsdrv_meta_entry_s *) entry;
+    if (--e->refcnt) {
+        return;
+    }
+    jsdrv_list_remove(&e->item);
+    --self->count;
+    entry_free(e);
+}
+
+uint32_t jsdrv_meta_store_count(struct jsdrv_meta_store_s * self) {
+    return self->count;
+}
@@ -0,0 +1,996 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv/net.h"
+#include "jsdrv.h"
+#include "jsdrv_prv/buffer_codec.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/event.h"
+#include "jsdrv_prv/list.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/mutex.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/topic.h"
+#include "jsdrv/error_code.h"
+#include <inttypes.h>
+#include <string.h>
+
+#if !_WIN32
+#include <poll.h>
+#endif
+
+
+#define ALIGN8(x)               (((x) + 7U) & ~7U)
+#define HEADER_SIZE             (sizeof(struct jsdrv_net_header_s))
+#define POLL_MS                 (100U)
+#define QUERY_BUFFER_SIZE       (JSDRV_NET_FRAME_SIZE_MAX / 2)
+JSDRV_STATIC_ASSERT(16 == sizeof(struct jsdrv_net_header_s), header_size);
+JSDRV_STATIC_ASSERT((HEADER_SIZE + ALIGN8(JSDRV_TOPIC_LENGTH_MAX) + sizeof(struct jsdrv_stream_signal_s))
+                    <= JSDRV_NET_FRAME_SIZE_MAX, frame_size);
+
+
+struct frame_s {
+    struct jsdrv_list_s item;
+    uint32_t length;
+    uint8_t data[];
+};
+
+struct client_s {
+    struct jsdrv_net_server_s * server;
+    struct jsdrv_os_socket_s * sock;
+    uint8_t codec;              // the most recent subscribe codec
+    jsdrv_os_mutex_t mutex;
+    jsdrv_os_event_t ev;
+    struct jsdrv_list_s tx;     // frame_s, under mutex
+    uint32_t tx_bytes;          // under mutex
+    uint64_t dropped;           // under mutex
+    volatile bool do_exit;
+    volatile bool closed;       // connection ended, ready for client_free()
+    bool rx_started;
+    bool tx_started;
+    jsdrv_thread_t rx_thread;
+    jsdrv_thread_t tx_thread;
+    uint8_t * rx_buf;
+    uint8_t * query_buf;
+};
+
+struct jsdrv_net_server_s {
+    struct jsdrv_context_s * context;
+    struct jsdrv_os_socket_s * sock;
+    uint16_t port;
+    uint32_t queue_size;
+    bool read_only;
+    volatile bool do_exit;
+    jsdrv_thread_t thread;
+    struct client_s * clients[JSDRV_NET_CLIENTS_MAX];  // listener thread only
+};
+
+static void event_wait(jsdrv_os_event_t ev, uint32_t timeout_ms) {
+#if _WIN32
+    WaitForSingleObject(ev, timeout_ms);
+#else
+    struct pollfd fds = {
+            .fd = ev->fd_poll,
+            .events = ev->events,
+            .revents = 0,
+    };
+    poll(&fds, 1, (int) timeout_ms);
+#endif
+}
+
+static uint32_t stream_data_size(const struct jsdrv_stream_signal_s * s) {
+    return (uint32_t) (((uint64_t) s->element_count * s->element_size_bits + 7) / 8);
+}
+
+static uint8_t stream_codec(const struct jsdrv_stream_signal_s * s, uint8_t codec) {
+    bool is_f32 = (JSDRV_DATA_TYPE_FLOAT == s->element_type) && (32 == s->element_size_bits);
+    bool is_u8 = (s->element_size_bits <= 8);
+    switch (codec) {
+        case JSDRV_NET_CODEC_COMPRESS: return is_f32 ? JSDRV_NET_CODEC_XOR_F32 : (is_u8 ? JSDRV_NET_CODEC_RLE8 : JSDRV_NET_CODEC_RAW);
+        case JSDRV_NET_CODEC_RLE8: return is_u8 ? codec : JSDRV_NET_CODEC_RAW;
+        case JSDRV_NET_CODEC_XOR_F32: return is_f32 ? codec : JSDRV_NET_CODEC_RAW;
+        default: return JSDRV_NET_CODEC_RAW;
+    }
+}
+
+// Encode the stream data into dst, returns the encoded size or 0 to send raw.
+static uint32_t stream_encode(const struct jsdrv_union_s * value, uint8_t codec, uint8_t * dst, uint32_t dst_size) {
+    const struct jsdrv_stream_signal_s * s = (const struct jsdrv_stream_signal_s *) value->value.bin;
+    uint32_t sz = stream_data_size(s);
+    if ((JSDRV_NET_CODEC_RAW == codec) || ((JSDRV_STREAM_HEADER_SIZE + sz) > value->size)) {
+        return 0;
+    }
+    if (dst_size > (JSDRV_STREAM_HEADER_SIZE + sz)) {
+        dst_size = JSDRV_STREAM_HEADER_SIZE + sz;  // only send compressed data when smaller
+    }
+    if (dst_size <= JSDRV_STREAM_HEADER_SIZE) {
+        return 0;
+    }
+    uint32_t n;
+    if (JSDRV_NET_CODEC_XOR_F32 == codec) {
+        n = jsdrv_codec_xor_f32_encode((const float *) s->data, s->element_count,
+                                       dst + JSDRV_STREAM_HEADER_SIZE, dst_size - JSDRV_STREAM_HEADER_SIZE);
+    } else {
+        n = jsdrv_codec_rle8_encode(s->data, sz, dst + JSDRV_STREAM_HEADER_SIZE, dst_size - JSDRV_STREAM_HEADER_SIZE);
+    }
+    if (0 == n) {
+        return 0;
+    }
+    memcpy(dst, s, JSDRV_STREAM_HEADER_SIZE);
+    return JSDRV_STREAM_HEADER_SIZE + n;
+}
+
+uint32_t jsdrv_net_encode(uint8_t frame_type, const char * topic,
+                          const struct jsdrv_union_s * value, uint8_t codec,
+                          uint8_t * buf, uint32_t buf_size) {
+    struct jsdrv_union_s v = value ? *value : jsdrv_union_null();
+    size_t topic_len = topic ? strlen(topic) : 0;
+    uint32_t topic_size = ALIGN8((uint32_t) topic_len + 1);
+    uint32_t value_offset = HEADER_SIZE + topic_size;
+    uint32_t value_size;
+    if ((0 == topic_len) || (topic_len >= JSDRV_TOPIC_LENGTH_MAX) || (value_offset > buf_size)) {
+        return 0;
+    }
+    struct jsdrv_net_header_s * hdr = (struct jsdrv_net_header_s *) buf;
+    hdr->frame_type = frame_type;
+    hdr->codec = (JSDRV_NET_FRAME_SUBSCRIBE == frame_type) ? codec : JSDRV_NET_CODEC_RAW;
+    hdr->topic_size = (uint16_t) topic_size;
+    hdr->type = v.type;
+    hdr->flags = v.flags;
+    if (JSDRV_NET_FRAME_SUBSCRIBE != frame_type) {
+        hdr->flags &= JSDRV_UNION_FLAG_RETAIN;  // pointers do not survive the connection
+    }
+    hdr->op = v.op;
+    hdr->app = v.app;
+    hdr->size = 0;
+    memset(buf + HEADER_SIZE, 0, topic_size);
+    memcpy(buf + HEADER_SIZE, topic, topic_len);
+    uint8_t * p = buf + value_offset;
+    uint32_t p_size = buf_size - value_offset;
+
+    if (JSDRV_UNION_NULL == v.type) {
+        value_size = 0;
+    } else if (jsdrv_union_is_type_ptr(&v)) {
+        if ((0 == v.size) && ((JSDRV_UNION_STR == v.type) || (JSDRV_UNION_JSON == v.type))) {
+            v.size = (uint32_t) strlen(v.value.str) + 1;
+        }
+        hdr->size = v.size;
+        value_size = 0;
+        if ((JSDRV_UNION_BIN == v.type) && (JSDRV_PAYLOAD_TYPE_STREAM == v.app) && (v.size >= JSDRV_STREAM_HEADER_SIZE)) {
+            uint8_t c = stream_codec((const struct jsdrv_stream_signal_s *) v.value.bin, codec);
+            value_size = stream_encode(&v, c, p, p_size);
+            if (value_size) {
+                hdr->codec = c;
+            }
+        }
+        if (0 == value_size) {
+            if (v.size > p_size) {
+                return 0;
+            }
+            if (v.size) {
+                memcpy(p, v.value.bin, v.size);
+            }
+            value_size = v.size;
+        }
+    } else if ((v.type >= JSDRV_UNION_F32) && (v.type <= JSDRV_UNION_I64)) {
+        if (p_size < 8) {
+            return 0;
+        }
+        memcpy(p, &v.value.u64, 8);
+        value_size = 8;
+    } else {
+        return 0;
+    }
+    hdr->length = value_offset + value_size;
+    return hdr->length;
+}
+
+int32_t jsdrv_net_decode(const uint8_t * buf, uint32_t size, struct jsdrv_net_frame_s * frame,
+                         uint8_t * scratch, uint32_t scratch_size) {
+    const struct jsdrv_net_header_s * hdr = (const struct jsdrv_net_header_s *) buf;
+    if (size < HEADER_SIZE) {
+        return JSDRV_ERROR_TOO_SMALL;
+    }
+    if ((hdr->length < HEADER_SIZE) || (hdr->topic_size < 8) || (hdr->topic_size & 7)
+            || ((HEADER_SIZE + hdr->topic_size) > hdr->length)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (hdr->length > size) {
+        return JSDRV_ERROR_TOO_SMALL;
+    }
+    const char * topic = (const char *) (buf + HEADER_SIZE);
+    if ((0 == topic[0]) || (0 != topic[hdr->topic_size - 1])) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    const uint8_t * p = buf + HEADER_SIZE + hdr->topic_size;
+    uint32_t p_size = hdr->length - HEADER_SIZE - hdr->topic_size;
+
+    memset(frame, 0, sizeof(*frame));
+    frame->frame_type = hdr->frame_type;
+    frame->topic = topic;
+    struct jsdrv_union_s * v = &frame->value;
+    v->type = hdr->type;
+    v->flags = hdr->flags;
+    v->op = hdr->op;
+    v->app = hdr->app;
+    if (JSDRV_NET_FRAME_SUBSCRIBE == hdr->frame_type) {
+        frame->codec = hdr->codec;
+    } else {
+        v->flags &= JSDRV_UNION_FLAG_RETAIN;
+    }
+
+    if (JSDRV_UNION_NULL == v->type) {
+        return p_size ? JSDRV_ERROR_PARAMETER_INVALID : 0;
+    } else if (jsdrv_union_is_type_ptr(v)) {
+        v->size = hdr->size;
+        v->value.bin = p;
+        if ((JSDRV_NET_FRAME_SUBSCRIBE == hdr->frame_type) || (JSDRV_NET_CODEC_RAW == hdr->codec)) {
+            if (p_size != hdr->size) {
+                return JSDRV_ERROR_PARAMETER_INVALID;
+            }
+        } else {
+            const struct jsdrv_stream_signal_s * s = (const struct jsdrv_stream_signal_s *) p;
+            if ((JSDRV_UNION_BIN != v->type) || (JSDRV_PAYLOAD_TYPE_STREAM != v->app)
+                    || (p_size < JSDRV_STREAM_HEADER_SIZE) || (NULL == scratch)) {
+                return JSDRV_ERROR_PARAMETER_INVALID;
+            }
+            uint32_t sz = stream_data_size(s);
+            if (((JSDRV_STREAM_HEADER_SIZE + sz) != hdr->size) || (hdr->size > scratch_size)) {
+                return JSDRV_ERROR_PARAMETER_INVALID;
+            }
+            memcpy(scratch, p, JSDRV_STREAM_HEADER_SIZE);
+            const uint8_t * src = p + JSDRV_STREAM_HEADER_SIZE;
+            uint32_t src_size = p_size - JSDRV_STREAM_HEADER_SIZE;
+            struct jsdrv_stream_signal_s * d = (struct jsdrv_stream_signal_s *) scratch;
+            int32_t rc;
+            if ((JSDRV_NET_CODEC_XOR_F32 == hdr->codec) && (JSDRV_DATA_TYPE_FLOAT == s->element_type)
+                    && (32 == s->element_size_bits)) {
+                rc = jsdrv_codec_xor_f32_decode(src, src_size, (float *) d->data, s->element_count);
+            } else if (JSDRV_NET_CODEC_RLE8 == hdr->codec) {
+                rc = jsdrv_codec_rle8_decode(src, src_size, d->data, sz);
+            } else {
+                rc = JSDRV_ERROR_PARAMETER_INVALID;
+            }
+            if (rc) {
+                return JSDRV_ERROR_PARAMETER_INVALID;
+            }
+            v->value.bin = scratch;
+        }
+        if (((JSDRV_UNION_STR == v->type) || (JSDRV_UNION_JSON == v->type))
+                && ((0 == v->size) || (0 != v->value.str[v->size - 1]))) {
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+        return 0;
+    } else if ((v->type >= JSDRV_UNION_F32) && (v->type <= JSDRV_UNION_I64) && (8 == p_size)) {
+        memcpy(&v->value.u64, p, 8);
+        return 0;
+    }
+    return JSDRV_ERROR_PARAMETER_INVALID;
+}
+
+static void client_enqueue(struct client_s * self, uint8_t frame_type, const char * topic,
+                           const struct jsdrv_union_s * value, bool droppable) {
+    uint32_t sz = HEADER_SIZE + ALIGN8(JSDRV_TOPIC_LENGTH_MAX) + 8;
+    if (jsdrv_union_is_type_ptr(value)) {
+        sz += (value->size || (JSDRV_UNION_BIN == value->type)) ? value->size : ((uint32_t) strlen(value->value.str) + 1);
+    }
+    struct frame_s * f = jsdrv_alloc(sizeof(struct frame_s) + sz);
+    jsdrv_list_initialize(&f->item);
+    f->length = jsdrv_net_encode(frame_type, topic, value, self->codec, f->data, sz);
+    if (0 == f->length) {
+        JSDRV_LOGW("net encode failed: %s", topic);
+        jsdrv_free(f);
+        return;
+    }
+
+    jsdrv_os_mutex_lock(self->mutex);
+    if (droppable && ((self->tx_bytes + f->length) > self->server->queue_size)) {
+        ++self->dropped;
+        jsdrv_os_mutex_unlock(self->mutex);
+        jsdrv_free(f);
+        return;
+    }
+    self->tx_bytes += f->length;
+    jsdrv_list_add_tail(&self->tx, &f->item);
+    jsdrv_os_mutex_unlock(self->mutex);
+    jsdrv_os_event_signal(self->ev);
+}
+
+static void client_return_code(struct client_s * self, uint8_t frame_type, const char * topic, int32_t rc) {
+    struct jsdrv_union_s v = jsdrv_union_i32(rc);
+    v.op = frame_type;
+    client_enqueue(self, JSDRV_NET_FRAME_RETURN_CODE, topic, &v, false);
+}
+
+static void on_update(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    struct client_s * self = (struct client_s *) user_data;
+    if (!self->closed) {
+        client_enqueue(self, JSDRV_NET_FRAME_PUBLISH, topic, value, JSDRV_UNION_BIN == value->type);
+    }
+}
+
+static void client_handle_frame(struct client_s * self, const struct jsdrv_net_frame_s * frame) {
+    struct jsdrv_context_s * context = self->server->context;
+    struct jsdrv_union_s v;
+    int32_t rc;
+    switch (frame->frame_type) {
+        case JSDRV_NET_FRAME_PUBLISH:
+            if (self->server->read_only) {
+                rc = JSDRV_ERROR_PERMISSIONS;
+            } else {
+                rc = jsdrv_publish(context, frame->topic, &frame->value, 0);  // do not stall later frames
+            }
+            break;
+        case JSDRV_NET_FRAME_QUERY:
+            v = jsdrv_union_bin(self->query_buf, QUERY_BUFFER_SIZE);
+            rc = jsdrv_query(context, frame->topic, &v, JSDRV_TIMEOUT_MS_DEFAULT);
+            if (0 == rc) {
+                client_enqueue(self, JSDRV_NET_FRAME_QUERY, frame->topic, &v, false);
+                return;
+            }
+            break;
+        case JSDRV_NET_FRAME_SUBSCRIBE:
+            self->codec = frame->codec;
+            rc = jsdrv_subscribe(context, frame->topic, frame->value.flags, on_update, self, JSDRV_TIMEOUT_MS_DEFAULT);
+            break;
+        case JSDRV_NET_FRAME_UNSUBSCRIBE:
+            rc = jsdrv_unsubscribe(context, frame->topic, on_update, self, JSDRV_TIMEOUT_MS_DEFAULT);
+            break;
+        default:
+            rc = JSDRV_ERROR_NOT_SUPPORTED;
+            break;
+    }
+    client_return_code(self, frame->frame_type, frame->topic, rc);
+}
+
+// Process all complete frames in rx_buf, returns the remaining byte count.
+static int32_t client_rx_process(struct client_s * self, uint32_t * offset) {
+    struct jsdrv_net_frame_s frame;
+    uint32_t pos = 0;
+    while ((*offset - pos) >= HEADER_SIZE) {
+        int32_t rc = jsdrv_net_decode(self->rx_buf + pos, *offset - pos, &frame, NULL, 0);
+        if (JSDRV_ERROR_TOO_SMALL == rc) {
+            const struct jsdrv_net_header_s * hdr = (const struct jsdrv_net_header_s *) (self->rx_buf + pos);
+            if (hdr->length > JSDRV_NET_FRAME_SIZE_MAX) {
+                return JSDRV_ERROR_TOO_BIG;
+            }
+            break;
+        } else if (rc) {
+            return rc;
+        }
+        client_handle_frame(self, &frame);
+        pos += ((const struct jsdrv_net_header_s *) (self->rx_buf + pos))->length;
+    }
+    if (pos) {
+        memmove(self->rx_buf, self->rx_buf + pos, *offset - pos);
+        *offset -= pos;
+    }
+    return 0;
+}
+
+static THREAD_RETURN_TYPE client_rx_thread(THREAD_ARG_TYPE arg) {
+    struct client_s * self = (struct client_s *) arg;
+    uint32_t offset = 0;
+    size_t sz;
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_NET);
+    while (!self->do_exit) {
+        int32_t rc = jsdrv_os_socket_recv(self->sock, self->rx_buf + offset,
+                                          JSDRV_NET_FRAME_SIZE_MAX - offset, POLL_MS, &sz);
+        if (JSDRV_ERROR_TIMED_OUT == rc) {
+            continue;
+        } else if (rc) {
+            if (JSDRV_ERROR_CLOSED != rc) {
+                JSDRV_LOGW("net client receive failed: %" PRId32, rc);
+            }
+            break;
+        }
+        offset += (uint32_t) sz;
+        rc = client_rx_process(self, &offset);
+        if (rc) {
+            JSDRV_LOGW("net client protocol error %" PRId32 ", disconnect", rc);
+            break;
+        }
+    }
+    jsdrv_thread_unregister();
+    self->closed = true;
+    jsdrv_os_event_signal(self->ev);
+    THREAD_RETURN();
+}
+
+static THREAD_RETURN_TYPE client_tx_thread(THREAD_ARG_TYPE arg) {
+    struct client_s * self = (struct client_s *) arg;
+    bool error = false;
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_NET);
+    while (1) {
+        jsdrv_os_event_reset(self->ev);
+        jsdrv_os_mutex_lock(self->mutex);
+        struct jsdrv_list_s * item = jsdrv_list_remove_head(&self->tx);
+        struct frame_s * f = item ? JSDRV_CONTAINER_OF(item, struct frame_s, item) : NULL;
+        if (f) {
+            self->tx_bytes -= f->length;
+        }
+        jsdrv_os_mutex_unlock(self->mutex);
+        if (f) {
+            if (!error && jsdrv_os_socket_send(self->sock, f->data, f->length)) {
+                error = true;  // keep draining, rx thread detects the disconnect
+            }
+            jsdrv_free(f);
+        } else if (self->do_exit) {
+            break;
+        } else {
+            event_wait(self->ev, POLL_MS);
+        }
+    }
+    jsdrv_thread_unregister();
+    THREAD_RETURN();
+}
+
+static void client_free(struct client_s * self) {
+    struct jsdrv_context_s * context = self->server->context;
+    self->closed = true;
+    jsdrv_unsubscribe_all(context, on_update, self, JSDRV_TIMEOUT_MS_DEFAULT);
+    self->do_exit = true;
+    jsdrv_os_event_signal(self->ev);
+    if (self->rx_started) {
+        jsdrv_thread_join(&self->rx_thread, 1000);
+    }
+    if (self->tx_started) {
+        jsdrv_thread_join(&self->tx_thread, 1000);
+    }
+    while (!jsdrv_list_is_empty(&self->tx)) {
+        struct jsdrv_list_s * item = jsdrv_list_remove_head(&self->tx);
+        jsdrv_free(JSDRV_CONTAINER_OF(item, struct frame_s, item));
+    }
+    if (self->dropped) {
+        JSDRV_LOGI("net client dropped %" PRIu64 " frames", self->dropped);
+    }
+    jsdrv_os_socket_close(self->sock);
+    jsdrv_os_event_free(self->ev);
+    jsdrv_os_mutex_free(self->mutex);
+    jsdrv_free(self->rx_buf);
+    jsdrv_free(self->query_buf);
+    jsdrv_free(self);
+}
+
+static struct client_s * client_alloc(struct jsdrv_net_server_s * server, struct jsdrv_os_socket_s * sock) {
+    struct client_s * self = jsdrv_alloc_clr(sizeof(struct client_s));
+    self->server = server;
+    self->sock = sock;
+    self->mutex = jsdrv_os_mutex_alloc("net_client");
+    self->ev = jsdrv_os_event_alloc();
+    jsdrv_list_initialize(&self->tx);
+    self->rx_buf = jsdrv_alloc(JSDRV_NET_FRAME_SIZE_MAX);
+    self->query_buf = jsdrv_alloc(QUERY_BUFFER_SIZE);
+    self->tx_started = (0 == jsdrv_thread_create(&self->tx_thread, client_tx_thread, self, 0));
+    if (self->tx_started) {
+        self->rx_started = (0 == jsdrv_thread_create(&self->rx_thread, client_rx_thread, self, 0));
+    }
+    if (!self->rx_started) {
+        JSDRV_LOGW("net client thread create failed");
+        self->closed = true;
+    }
+    return self;
+}
+
+static THREAD_RETURN_TYPE server_thread(THREAD_ARG_TYPE arg) {
+    struct jsdrv_net_server_s * self = (struct jsdrv_net_server_s *) arg;
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_NET);
+    while (!self->do_exit) {
+        for (uint32_t i = 0; i < JSDRV_NET_CLIENTS_MAX; ++i) {
+            if (self->clients[i] && self->clients[i]->closed) {
+                JSDRV_LOGI("net client %" PRIu32 " disconnected", i);
+                client_free(self->clients[i]);
+                self->clients[i] = NULL;
+            }
+        }
+        struct jsdrv_os_socket_s * sock = jsdrv_os_socket_accept(self->sock, POLL_MS);
+        if (NULL == sock) {
+            continue;
+        }
+        uint32_t idx = JSDRV_NET_CLIENTS_MAX;
+        for (uint32_t i = 0; i < JSDRV_NET_CLIENTS_MAX; ++i) {
+            if (NULL == self->clients[i]) {
+                idx = i;
+                break;
+            }
+        }
+        if (idx >= JSDRV_NET_CLIENTS_MAX) {
+            JSDRV_LOGW("net client rejected: too many clients");
+            jsdrv_os_socket_close(sock);
+            continue;
+        }
+        JSDRV_LOGI("net client %" PRIu32 " connected", idx);
+        self->clients[idx] = client_alloc(self, sock);
+    }
+    for (uint32_t i = 0; i < JSDRV_NET_CLIENTS_MAX; ++i) {
+        if (self->clients[i]) {
+            client_free(self->clients[i]);
+            self->clients[i] = NULL;
+        }
+    }
+    jsdrv_thread_unregister();
+    THREAD_RETURN();
+}
+
+int32_t jsdrv_net_server_open(struct jsdrv_context_s * context,
+                              const struct jsdrv_net_server_config_s * config,
+                              struct jsdrv_net_server_s ** server) {
+    if ((NULL == context) || (NULL == config) || (NULL == server)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    *server = NULL;
+    struct jsdrv_net_server_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_net_server_s));
+    self->context = context;
+    self->port = config->port;
+    self->queue_size = config->queue_size ? config->queue_size : JSDRV_NET_QUEUE_SIZE_DEFAULT;
+    self->read_only = (0 != config->read_only);
+    self->sock = jsdrv_os_socket_listen(config->host ? config->host : "127.0.0.1", &self->port);
+    if (NULL == self->sock) {
+        jsdrv_free(self);
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    if (jsdrv_thread_create(&self->thread, server_thread, self, 0)) {
+        jsdrv_os_socket_close(self->sock);
+        jsdrv_free(self);
+        return JSDRV_ERROR_UNSPECIFIED;
+    }
+    JSDRV_LOGI("net server listening on %s port %u%s", config->host ? config->host : "127.0.0.1",
+               (unsigned int) self->port, self->read_only ? " read-only" : "");
+    *server = self;
+    return 0;
+}
+
+uint16_t jsdrv_net_server_port(struct jsdrv_net_server_s * server) {
+    return server ? server->port : 0;
+}
+
+void jsdrv_net_server_close(struct jsdrv_net_server_s * server) {
+    if (NULL == server) {
+        return;
+    }
+    server->do_exit = true;
+    jsdrv_thread_join(&server->thread, 5000);
+    jsdrv_os_socket_close(server->sock);
+    jsdrv_free(server);
+}
+
+struct client_sub_s {
+    struct jsdrv_list_s item;
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    bool is_wildcard;
+    uint8_t flags;
+    jsdrv_subscribe_fn fn;
+    void * user_data;
+};
+
+struct jsdrv_net_client_s {
+    struct jsdrv_os_socket_s * sock;
+    uint8_t codec;
+    jsdrv_os_mutex_t req_mutex;         // one request at a time
+    jsdrv_os_mutex_t mutex;             // subs and responses
+    jsdrv_os_event_t ev;                // response received
+    struct jsdrv_list_s subs;           // client_sub_s, under mutex
+    struct jsdrv_list_s remote;         // client_sub_s server subscriptions, under req_mutex
+    uint32_t tx_count;                  // requests sent, under mutex
+    uint32_t rx_count;                  // responses received, under mutex
+    int32_t rsp_rc;                     // under mutex
+    struct jsdrv_union_s * rsp_value;   // query destination, under mutex
+    volatile bool do_exit;
+    volatile bool closed;
+    bool thread_started;
+    jsdrv_thread_t thread;
+    uint8_t * tx_buf;                   // under req_mutex
+    uint8_t * rx_buf;
+    uint8_t * scratch;
+};
+
+static uint8_t topic_suffix_flag(char ch) {
+    switch (ch) {
+        case JSDRV_TOPIC_SUFFIX_METADATA_REQ: return JSDRV_SFLAG_METADATA_REQ;
+        case JSDRV_TOPIC_SUFFIX_METADATA_RSP: return JSDRV_SFLAG_METADATA_RSP;
+        case JSDRV_TOPIC_SUFFIX_QUERY_REQ: return JSDRV_SFLAG_QUERY_REQ;
+        case JSDRV_TOPIC_SUFFIX_QUERY_RSP: return JSDRV_SFLAG_QUERY_RSP;
+        case JSDRV_TOPIC_SUFFIX_RETURN_CODE: return JSDRV_SFLAG_RETURN_CODE;
+        default: return JSDRV_SFLAG_PUB;
+    }
+}
+
+static bool client_sub_match(const struct client_sub_s * s, const char * topic) {
+    if (s->is_wildcard) {
+        return jsdrv_topic_match(s->topic, topic);
+    }
+    size_t n = strlen(s->topic);
+    return (0 == strncmp(s->topic, topic, n)) && ((0 == n) || (0 == topic[n]) || ('/' == topic[n]));
+}
+
+static void client_dispatch(struct jsdrv_net_client_s * self, const struct jsdrv_net_frame_s * frame) {
+    struct jsdrv_topic_s topic;
+    jsdrv_topic_set(&topic, frame->topic);
+    uint8_t flag = topic_suffix_flag(jsdrv_topic_suffix_remove(&topic));
+    struct jsdrv_list_s * item;
+    jsdrv_os_mutex_lock(self->mutex);
+    jsdrv_list_foreach(&self->subs, item) {
+        struct client_sub_s * s = JSDRV_CONTAINER_OF(item, struct client_sub_s, item);
+        if ((s->flags & flag) && client_sub_match(s, topic.topic)) {
+            s->fn(s->user_data, frame->topic, &frame->value);
+        }
+    }
+    jsdrv_os_mutex_unlock(self->mutex);
+}
+
+static void client_response(struct jsdrv_net_client_s * self, const struct jsdrv_net_frame_s * frame) {
+    jsdrv_os_mutex_lock(self->mutex);
+    ++self->rx_count;
+    if (self->rx_count == self->tx_count) {  // otherwise a late response to a timed out request
+        if (JSDRV_NET_FRAME_RETURN_CODE == frame->frame_type) {
+            self->rsp_rc = frame->value.value.i32;
+        } else if (NULL == self->rsp_value) {
+            self->rsp_rc = JSDRV_ERROR_PARAMETER_INVALID;
+        } else if (jsdrv_union_is_type_ptr(&frame->value)) {
+            struct jsdrv_union_s * dst = self->rsp_value;
+            if (!jsdrv_union_is_type_ptr(dst)) {
+                self->rsp_rc = JSDRV_ERROR_SYNTAX_ERROR;
+            } else if (frame->value.size > dst->size) {
+                self->rsp_rc = JSDRV_ERROR_TOO_SMALL;
+            } else {
+                memcpy((void *) dst->value.bin, frame->value.value.bin, frame->value.size);
+                dst->type = frame->value.type;
+                dst->size = frame->value.size;
+                self->rsp_rc = 0;
+            }
+        } else {
+            *self->rsp_value = frame->value;
+            self->rsp_rc = 0;
+        }
+    }
+    jsdrv_os_mutex_unlock(self->mutex);
+    jsdrv_os_event_signal(self->ev);
+}
+
+static THREAD_RETURN_TYPE net_client_thread(THREAD_ARG_TYPE arg) {
+    struct jsdrv_net_client_s * self = (struct jsdrv_net_client_s *) arg;
+    struct jsdrv_net_frame_s frame;
+    uint32_t offset = 0;
+    size_t sz;
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_NET);
+    while (!self->do_exit) {
+        int32_t rc = jsdrv_os_socket_recv(self->sock, self->rx_buf + offset,
+                                          JSDRV_NET_FRAME_SIZE_MAX - offset, POLL_MS, &sz);
+        if (JSDRV_ERROR_TIMED_OUT == rc) {
+            continue;
+        } else if (rc) {
+            if (JSDRV_ERROR_CLOSED != rc) {
+                JSDRV_LOGW("net server receive failed: %" PRId32, rc);
+            }
+            break;
+        }
+        offset += (uint32_t) sz;
+        uint32_t pos = 0;
+        while ((offset - pos) >= HEADER_SIZE) {
+            const struct jsdrv_net_header_s * hdr = (const struct jsdrv_net_header_s *) (self->rx_buf + pos);
+            rc = jsdrv_net_decode(self->rx_buf + pos, offset - pos, &frame,
+                                  self->scratch, sizeof(struct jsdrv_stream_signal_s));
+            if (JSDRV_ERROR_TOO_SMALL == rc) {
+                rc = (hdr->length > JSDRV_NET_FRAME_SIZE_MAX) ? JSDRV_ERROR_TOO_BIG : 0;
+                break;
+            } else if (rc) {
+                break;
+            }
+            if (JSDRV_NET_FRAME_PUBLISH == frame.frame_type) {
+                client_dispatch(self, &frame);
+            } else {
+                client_response(self, &frame);
+            }
+            pos += hdr->length;
+        }
+        if (rc) {
+            JSDRV_LOGW("net server protocol error %" PRId32 ", disconnect", rc);
+            break;
+        }
+        if (pos) {
+            memmove(self->rx_buf, self->rx_buf + pos, offset - pos);
+            offset -= pos;
+        }
+    }
+    jsdrv_thread_unregister();
+    self->closed = true;
+    jsdrv_os_event_signal(self->ev);
+    THREAD_RETURN();
+}
+
+static void client_subs_free(struct jsdrv_list_s * list) {
+    while (!jsdrv_list_is_empty(list)) {
+        struct jsdrv_list_s * item = jsdrv_list_remove_head(list);
+        jsdrv_free(JSDRV_CONTAINER_OF(item, struct client_sub_s, item));
+    }
+}
+
+// Send a request and wait for its response, call under req_mutex.
+static int32_t client_request(struct jsdrv_net_client_s * self, uint8_t frame_type, const char * topic,
+                              const struct jsdrv_union_s * value, struct jsdrv_union_s * query_value,
+                              uint32_t timeout_ms) {
+    if (self->closed) {
+        return JSDRV_ERROR_CLOSED;
+    }
+    uint32_t sz = jsdrv_net_encode(frame_type, topic, value, self->codec, self->tx_buf, JSDRV_NET_FRAME_SIZE_MAX);
+    if (0 == sz) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    jsdrv_os_mutex_lock(self->mutex);
+    uint32_t id = ++self->tx_count;
+    self->rsp_rc = JSDRV_ERROR_TIMED_OUT;
+    self->rsp_value = query_value;
+    jsdrv_os_mutex_unlock(self->mutex);
+
+    int32_t rc = jsdrv_os_socket_send(self->sock, self->tx_buf, sz);
+    uint32_t t_start = jsdrv_time_ms_u32();
+    while ((0 == rc) && timeout_ms) {
+        jsdrv_os_mutex_lock(self->mutex);
+        jsdrv_os_event_reset(self->ev);
+        bool done = (self->rx_count == id);
+        if (done) {
+            rc = self->rsp_rc;
+        }
+        jsdrv_os_mutex_unlock(self->mutex);
+        uint32_t elapsed = jsdrv_time_ms_u32() - t_start;
+        if (done) {
+            break;
+        } else if (self->closed) {
+            rc = JSDRV_ERROR_CLOSED;
+        } else if (elapsed >= timeout_ms) {
+            rc = JSDRV_ERROR_TIMED_OUT;
+        } else {
+            event_wait(self->ev, timeout_ms - elapsed);
+        }
+    }
+    jsdrv_os_mutex_lock(self->mutex);
+    self->rsp_value = NULL;
+    jsdrv_os_mutex_unlock(self->mutex);
+    return rc;
+}
+
+int32_t jsdrv_net_client_open(const struct jsdrv_net_client_config_s * config,
+                              struct jsdrv_net_client_s ** client) {
+    if ((NULL == config) || (NULL == client)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    *client = NULL;
+    const char * host = config->host ? config->host : "127.0.0.1";
+    uint16_t port = config->port ? config->port : JSDRV_NET_PORT_DEFAULT;
+    struct jsdrv_os_socket_s * sock = jsdrv_os_socket_connect(host, port);
+    if (NULL == sock) {
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    struct jsdrv_net_client_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_net_client_s));
+    self->sock = sock;
+    self->codec = config->codec;
+    self->req_mutex = jsdrv_os_mutex_alloc("net_client_req");
+    self->mutex = jsdrv_os_mutex_alloc("net_client");
+    self->ev = jsdrv_os_event_alloc();
+    jsdrv_list_initialize(&self->subs);
+    jsdrv_list_initialize(&self->remote);
+    self->tx_buf = jsdrv_alloc(JSDRV_NET_FRAME_SIZE_MAX);
+    self->rx_buf = jsdrv_alloc(JSDRV_NET_FRAME_SIZE_MAX);
+    self->scratch = jsdrv_alloc(sizeof(struct jsdrv_stream_signal_s));
+    self->thread_started = (0 == jsdrv_thread_create(&self->thread, net_client_thread, self, 0));
+    if (!self->thread_started) {
+        jsdrv_net_client_close(self);
+        return JSDRV_ERROR_UNSPECIFIED;
+    }
+    *client = self;
+    return 0;
+}
+
+void jsdrv_net_client_close(struct jsdrv_net_client_s * client) {
+    if (NULL == client) {
+        return;
+    }
+    client->do_exit = true;
+    if (client->thread_started) {
+        jsdrv_thread_join(&client->thread, 1000);
+    }
+    client_subs_free(&client->subs);
+    client_subs_free(&client->remote);
+    jsdrv_os_socket_close(client->sock);
+    jsdrv_os_event_free(client->ev);
+    jsdrv_os_mutex_free(client->mutex);
+    jsdrv_os_mutex_free(client->req_mutex);
+    jsdrv_free(client->tx_buf);
+    jsdrv_free(client->rx_buf);
+    jsdrv_free(client->scratch);
+    jsdrv_free(client);
+}
+
+int32_t jsdrv_net_client_publish(struct jsdrv_net_client_s * client, const char * topic,
+                                 const struct jsdrv_union_s * value, uint32_t timeout_ms) {
+    if ((NULL == client) || (NULL == topic) || (NULL == value)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    jsdrv_os_mutex_lock(client->req_mutex);
+    int32_t rc = client_request(client, JSDRV_NET_FRAME_PUBLISH, topic, value, NULL, timeout_ms);
+    jsdrv_os_mutex_unlock(client->req_mutex);
+    return rc;
+}
+
+int32_t jsdrv_net_client_query(struct jsdrv_net_client_s * client, const char * topic,
+                               struct jsdrv_union_s * value, uint32_t timeout_ms) {
+    if ((NULL == client) || (NULL == topic) || (NULL == value) || (0 == timeout_ms)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    jsdrv_os_mutex_lock(client->req_mutex);
+    int32_t rc = client_request(client, JSDRV_NET_FRAME_QUERY, topic, NULL, value, timeout_ms);
+    jsdrv_os_mutex_unlock(client->req_mutex);
+    return rc;
+}
+
+// Check if the subscription to topic a includes the updates for topic b.
+static bool topic_covers(const char * a, const char * b) {
+    size_t n = strlen(a);
+    return (0 == n) || ((0 == strncmp(a, b, n)) && ((0 == b[n]) || ('/' == b[n])));
+}
+
+// Find the shortest subscription topic that includes topic, call under mutex.
+static const char * client_sub_root(struct jsdrv_net_client_s * self, const char * topic) {
+    const char * root = topic;
+    struct jsdrv_list_s * item;
+    jsdrv_list_foreach(&self->subs, item) {
+        struct client_sub_s * s = JSDRV_CONTAINER_OF(item, struct client_sub_s, item);
+        if (!s->is_wildcard && (strlen(s->topic) < strlen(root)) && topic_covers(s->topic, topic)) {
+            root = s->topic;
+        }
+    }
+    return root;
+}
+
+static struct client_sub_s * client_remote_find(struct jsdrv_list_s * list, const char * topic) {
+    struct jsdrv_list_s * item;
+    jsdrv_list_foreach(list, item) {
+        struct client_sub_s * r = JSDRV_CONTAINER_OF(item, struct client_sub_s, item);
+        if (0 == strcmp(r->topic, topic)) {
+            return r;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Update the server subscriptions to match the local subscriptions,
+ * call under req_mutex.
+ *
+ * The server delivers each update once for each matching subscription.
+ * Only subscribe to the topics not included by another non-wildcard
+ * topic, with the combined flags of all the topics they include, so that
+ * the client receives each update once.  A subscription with
+ * JSDRV_SFLAG_RETAIN in retain_topic resubscribes its server topic to
+ * replay the retained values.
+ */
+static int32_t client_sync(struct jsdrv_net_client_s * self, const char * retain_topic, uint32_t timeout_ms) {
+    struct jsdrv_list_s desired;
+    struct jsdrv_list_s * item;
+    char retain_root[JSDRV_TOPIC_LENGTH_MAX];
+    int32_t rc = 0;
+    int32_t rv;
+    jsdrv_list_initialize(&desired);
+    jsdrv_os_mutex_lock(self->mutex);
+    jsdrv_list_foreach(&self->subs, item) {
+        struct client_sub_s * s = JSDRV_CONTAINER_OF(item, struct client_sub_s, item);
+        const char * root = client_sub_root(self, s->topic);
+        struct client_sub_s * d = client_remote_find(&desired, root);
+        if (NULL == d) {
+            d = jsdrv_alloc_clr(sizeof(struct client_sub_s));
+            jsdrv_list_initialize(&d->item);
+            jsdrv_cstr_copy(d->topic, root, sizeof(d->topic));
+            jsdrv_list_add_tail(&desired, &d->item);
+        }
+        d->flags |= s->flags & ~(JSDRV_SFLAG_RETAIN | JSDRV_SFLAG_QUEUED);
+    }
+    retain_root[0] = 0;
+    if (retain_topic) {
+        jsdrv_cstr_copy(retain_root, client_sub_root(self, retain_topic), sizeof(retain_root));
+    }
+    jsdrv_os_mutex_unlock(self->mutex);
+
+    jsdrv_list_foreach(&self->remote, item) {
+        struct client_sub_s * r = JSDRV_CONTAINER_OF(item, struct client_sub_s, item);
+        struct client_sub_s * d = client_remote_find(&desired, r->topic);
+        if ((NULL == d) || (d->flags != r->flags) || (retain_topic && (0 == strcmp(r->topic, retain_root)))) {
+            rv = client_request(self, JSDRV_NET_FRAME_UNSUBSCRIBE, r->topic, NULL, NULL, timeout_ms);
+            rc = rc ? rc : rv;
+            jsdrv_list_remove(&r->item);
+            jsdrv_free(r);
+        }
+    }
+    jsdrv_list_foreach(&desired, item) {
+        struct client_sub_s * d = JSDRV_CONTAINER_OF(item, struct client_sub_s, item);
+        if (client_remote_find(&self->remote, d->topic)) {
+            continue;
+        }
+        struct jsdrv_union_s v = jsdrv_union_null();
+        v.flags = d->flags;
+        if (retain_topic && (0 == strcmp(d->topic, retain_root))) {
+            v.flags |= JSDRV_SFLAG_RETAIN;
+        }
+        rv = client_request(self, JSDRV_NET_FRAME_SUBSCRIBE, d->topic, &v, NULL, timeout_ms);
+        if (rv) {
+            rc = rc ? rc : rv;
+        } else {
+            jsdrv_list_remove(&d->item);
+            jsdrv_list_add_tail(&self->remote, &d->item);
+        }
+    }
+    client_subs_free(&desired);
+    return rc;
+}
+
+int32_t jsdrv_net_client_subscribe(struct jsdrv_net_client_s * client, const char * topic, uint8_t flags,
+                                   jsdrv_subscribe_fn cbk_fn, void * cbk_user_data,
+                                   uint32_t timeout_ms) {
+    if ((NULL == client) || (NULL == topic) || (NULL == cbk_fn) || (strlen(topic) >= JSDRV_TOPIC_LENGTH_MAX)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct client_sub_s * s = jsdrv_alloc_clr(sizeof(struct client_sub_s));
+    jsdrv_list_initialize(&s->item);
+    jsdrv_cstr_copy(s->topic, topic, sizeof(s->topic));
+    s->is_wildcard = jsdrv_topic_is_wildcard(topic);
+    s->flags = flags;
+    s->fn = cbk_fn;
+    s->user_data = cbk_user_data;
+
+    jsdrv_os_mutex_lock(client->req_mutex);
+    jsdrv_os_mutex_lock(client->mutex);
+    jsdrv_list_add_tail(&client->subs, &s->item);
+    jsdrv_os_mutex_unlock(client->mutex);
+    int32_t rc = client_sync(client, (flags & JSDRV_SFLAG_RETAIN) ? topic : NULL, timeout_ms);
+    if (rc) {
+        jsdrv_os_mutex_lock(client->mutex);
+        jsdrv_list_remove(&s->item);
+        jsdrv_os_mutex_unlock(client->mutex);
+        jsdrv_free(s);
+        client_sync(client, NULL, timeout_ms);
+    }
+    jsdrv_os_mutex_unlock(client->req_mutex);
+    return rc;
+}
+
+int32_t jsdrv_net_client_unsubscribe(struct jsdrv_net_client_s * client, const char * topic,
+                                     jsdrv_subscribe_fn cbk_fn, void * cbk_user_data,
+                                     uint32_t timeout_ms) {
+    if ((NULL == client) || (NULL == topic)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct jsdrv_list_s removed;
+    struct jsdrv_list_s * item;
+    jsdrv_list_initialize(&removed);
+    jsdrv_os_mutex_lock(client->req_mutex);
+    jsdrv_os_mutex_lock(client->mutex);
+    jsdrv_list_foreach(&client->subs, item) {
+        struct client_sub_s * s = JSDRV_CONTAINER_OF(item, struct client_sub_s, item);
+        if ((0 == strcmp(s->topic, topic)) && (s->fn == cbk_fn) && (s->user_data == cbk_user_data)) {
+            jsdrv_list_remove(&s->item);
+            jsdrv_list_add_tail(&removed, &s->item);
+        }
+    }
+    jsdrv_os_mutex_unlock(client->mutex);
+    int32_t rc = JSDRV_ERROR_NOT_FOUND;
+    if (!jsdrv_list_is_empty(&removed)) {
+        client_subs_free(&removed);
+        rc = client_sync(client, NULL, timeout_ms);
+    }
+    jsdrv_os_mutex_unlock(client->req_mutex);
+    return rc;
+}
@@ -0,0 +1,348 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/pack.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define PACK_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define PACK_NEON 1
+#include <arm_neon.h>
+#endif
+
+
+static inline uint64_t load_u64(const uint8_t * x) {
+    return ((uint64_t) x[0]) | (((uint64_t) x[1]) << 8) | (((uint64_t) x[2]) << 16) | (((uint64_t) x[3]) << 24)
+        | (((uint64_t) x[4]) << 32) | (((uint64_t) x[5]) << 40) | (((uint64_t) x[6]) << 48) | (((uint64_t) x[7]) << 56);
+}
+
+// 8 samples to 4 bytes
+static inline uint32_t pack_u4_x8(uint64_t w) {
+    w &= 0x0f0f0f0f0f0f0f0fULL;
+    w = (w | (w >> 4)) & 0x00ff00ff00ff00ffULL;
+    w = (w | (w >> 8)) & 0x0000ffff0000ffffULL;
+    return (uint32_t) (w | (w >> 16));
+}
+
+// 8 samples to 1 byte: the multiply gathers bit 0 of each byte into the top byte.
+static inline uint8_t pack_u1_x8(uint64_t w) {
+    return (uint8_t) (((w & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56);
+}
+
+static void pack_u4_tail(uint8_t * y, const uint8_t * x, uint32_t n) {
+    for (uint32_t i = 0; (i + 1) < n; i += 2) {
+        *y++ = (uint8_t) ((x[i] & 0x0f) | ((x[i + 1] & 0x0f) << 4));
+    }
+    if (n & 1) {
+        *y = x[n - 1] & 0x0f;
+    }
+}
+
+static void pack_u1_tail(uint8_t * y, const uint8_t * x, uint32_t n) {
+    uint8_t b = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        b |= (uint8_t) ((x[i] & 1) << i);
+    }
+    *y = b;
+}
+
+void jsdrv_pack_u4(uint8_t * y, const uint8_t * x, uint32_t n) {
+    uint32_t i = 0;
+#if PACK_SSE2
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    const __m128i lo = _mm_set1_epi16(0x00ff);
+    for (; (i + 32) <= n; i += 32) {
+        __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i *) (x + i)), mask);
+        __m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i *) (x + i + 16)), mask);
+        // each 16-bit lane holds 2 samples: combine into the lower byte
+        a = _mm_and_si128(_mm_or_si128(a, _mm_srli_epi16(a, 4)), lo);
+        b = _mm_and_si128(_mm_or_si128(b, _mm_srli_epi16(b, 4)), lo);
+        _mm_storeu_si128((__m128i *) (y + i / 2), _mm_packus_epi16(a, b));
+    }
+#elif PACK_NEON
+    const uint8x16_t mask = vdupq_n_u8(0x0f);
+    for (; (i + 16) <= n; i += 16) {
+        uint16x8_t w = vreinterpretq_u16_u8(vandq_u8(vld1q_u8(x + i), mask));
+        vst1_u8(y + i / 2, vmovn_u16(vorrq_u16(w, vshrq_n_u16(w, 4))));
+    }
+#endif
+    for (; (i + 8) <= n; i += 8) {
+        uint32_t v = pack_u4_x8(load_u64(x + i));
+        uint8_t * p = y + i / 2;
+        p[0] = (uint8_t) v;
+        p[1] = (uint8_t) (v >> 8);
+        p[2] = (uint8_t) (v >> 16);
+        p[3] = (uint8_t) (v >> 24);
+    }
+    if (i < n) {
+        pack_u4_tail(y + i / 2, x + i, n - i);
+    }
+}
+
+void jsdrv_pack_u1(uint8_t * y, const uint8_t * x, uint32_t n) {
+    uint32_t i = 0;
+#if PACK_SSE2
+    for (; (i + 16) <= n; i += 16) {
+        // move bit 0 to bit 7 of each byte for movemask
+        __m128i a = _mm_slli_epi16(_mm_loadu_si128((const __m128i *) (x + i)), 7);
+        uint32_t m = (uint32_t) _mm_movemask_epi8(a);
+        y[i / 8] = (uint8_t) m;
+        y[i / 8 + 1] = (uint8_t) (m >> 8);
+    }
+#elif PACK_NEON
+    static const int8_t shifts[16] = {0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7};
+    const int8x16_t shift = vld1q_s8(shifts);
+    const uint8x16_t one = vdupq_n_u8(1);
+    for (; (i + 16) <= n; i += 16) {
+        uint8x16_t a = vshlq_u8(vandq_u8(vld1q_u8(x + i), one), shift);
+        // the bits are disjoint, so pairwise addition combines them
+        uint8x8_t s = vpadd_u8(vget_low_u8(a), vget_high_u8(a));
+        s = vpadd_u8(s, s);
+        s = vpadd_u8(s, s);
+        y[i / 8] = vget_lane_u8(s, 0);
+        y[i / 8 + 1] = vget_lane_u8(s, 1);
+    }
+#endif
+    for (; (i + 8) <= n; i += 8) {
+        y[i / 8] = pack_u1_x8(load_u64(x + i));
+    }
+    if (i < n) {
+        pack_u1_tail(y + i / 8, x + i, n - i);
+    }
+}
+
+static inline void store_u64(uint8_t * y, uint64_t w) {
+    for (uint32_t k = 0; k < 8; ++k) {
+        y[k] = (uint8_t) (w >> (8 * k));
+    }
+}
+
+// 1 byte to 8 samples: isolate bit k in byte k, then map nonzero bytes to 1.
+static inline uint64_t unpack_u1_x8(uint8_t b) {
+    uint64_t w = (b * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+    return ((w + 0x7f7f7f7f7f7f7f7fULL) >> 7) & 0x0101010101010101ULL;
+}
+
+void jsdrv_unpack_u4(uint8_t * y, const uint8_t * x, uint32_t n) {
+    uint32_t i = 0;
+#if PACK_SSE2
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    for (; (i + 32) <= n; i += 32) {
+        __m128i b = _mm_loadu_si128((const __m128i *) (x + i / 2));
+        __m128i lo = _mm_and_si128(b, mask);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(b, 4), mask);
+        _mm_storeu_si128((__m128i *) (y + i), _mm_unpacklo_epi8(lo, hi));
+        _mm_storeu_si128((__m128i *) (y + i + 16), _mm_unpackhi_epi8(lo, hi));
+    }
+#elif PACK_NEON
+    const uint8x16_t mask = vdupq_n_u8(0x0f);
+    for (; (i + 32) <= n; i += 32) {
+        uint8x16_t b = vld1q_u8(x + i / 2);
+        uint8x16x2_t z;
+        z.val[0] = vandq_u8(b, mask);
+        z.val[1] = vshrq_n_u8(b, 4);
+        vst2q_u8(y + i, z);  // interleave
+    }
+#endif
+    for (; (i + 2) <= n; i += 2) {
+        uint8_t b = x[i / 2];
+        y[i] = b & 0x0f;
+        y[i + 1] = b >> 4;
+    }
+    if (i < n) {
+        y[i] = x[i / 2] & 0x0f;
+    }
+}
+
+void jsdrv_unpack_u1(uint8_t * y, const uint8_t * x, uint32_t n) {
+    uint32_t i = 0;
+#if PACK_SSE2
+    const __m128i bits = _mm_set_epi8((char) 0x80, 0x40, 0x20, 0x10, 8, 4, 2, 1,
+                                      (char) 0x80, 0x40, 0x20, 0x10, 8, 4, 2, 1);
+    const __m128i one = _mm_set1_epi8(1);
+    for (; (i + 16) <= n; i += 16) {
+        // broadcast byte 0 to lanes 0-7 and byte 1 to lanes 8-15
+        __m128i b = _mm_cvtsi32_si128(x[i / 8] | (x[i / 8 + 1] << 8));
+        b = _mm_unpacklo_epi8(b, b);
+        b = _mm_unpacklo_epi16(b, b);
+        b = _mm_unpacklo_epi32(b, b);
+        b = _mm_cmpeq_epi8(_mm_and_si128(b, bits), bits);
+        _mm_storeu_si128((__m128i *) (y + i), _mm_and_si128(b, one));
+    }
+#elif PACK_NEON
+    static const uint8_t bits_u8[16] = {1, 2, 4, 8, 0x10, 0x20, 0x40, 0x80, 1, 2, 4, 8, 0x10, 0x20, 0x40, 0x80};
+    const uint8x16_t bits = vld1q_u8(bits_u8);
+    const uint8x16_t one = vdupq_n_u8(1);
+    for (; (i + 16) <= n; i += 16) {
+        uint8x16_t b = vcombine_u8(vdup_n_u8(x[i / 8]), vdup_n_u8(x[i / 8 + 1]));
+        vst1q_u8(y + i, vandq_u8(vtstq_u8(b, bits), one));
+    }
+#endif
+    for (; (i + 8) <= n; i += 8) {
+        store_u64(y + i, unpack_u1_x8(x[i / 8]));
+    }
+    for (; i < n; ++i) {
+        y[i] = (x[i / 8] >> (i & 7)) & 1;
+    }
+}
+
+void jsdrv_u_sum_reset(struct jsdrv_u_sum_s * s) {
+    s->x1 = 0;
+    s->x2 = 0;
+    s->min = 0xff;
+    s->max = 0;
+}
+
+static inline void sum_u8(struct jsdrv_u_sum_s * s, uint8_t v) {
+    s->x1 += v;
+    s->x2 += (uint64_t) v * v;
+    if (v < s->min) {
+        s->min = v;
+    }
+    if (v > s->max) {
+        s->max = v;
+    }
+}
+
+void jsdrv_sum_u4(struct jsdrv_u_sum_s * s, const uint8_t * x, uint64_t offset, uint64_t n) {
+    if (0 == n) {
+        return;
+    }
+    x += offset / 2;
+    if (offset & 1) {
+        sum_u8(s, *x++ >> 4);
+        --n;
+    }
+    uint64_t bytes = n / 2;
+    uint64_t i = 0;
+#if PACK_SSE2
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    const __m128i lo16 = _mm_set1_epi16(0x00ff);
+    const __m128i one16 = _mm_set1_epi16(1);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i x1 = zero;
+    __m128i x2 = zero;
+    __m128i v_min = _mm_set1_epi8((char) 0xff);
+    __m128i v_max = zero;
+    while ((i + 16) <= bytes) {
+        __m128i x2_u32 = zero;  // at most 1800 per lane per iteration
+        for (uint32_t k = 0; (k < 0x10000) && ((i + 16) <= bytes); ++k, i += 16) {
+            __m128i b = _mm_loadu_si128((const __m128i *) (x + i));
+            __m128i lo = _mm_and_si128(b, mask);
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(b, 4), mask);
+            x1 = _mm_add_epi64(x1, _mm_add_epi64(_mm_sad_epu8(lo, zero), _mm_sad_epu8(hi, zero)));
+            __m128i a0 = _mm_and_si128(lo, lo16);
+            __m128i a1 = _mm_srli_epi16(lo, 8);
+            __m128i a2 = _mm_and_si128(hi, lo16);
+            __m128i a3 = _mm_srli_epi16(hi, 8);
+            __m128i sq = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(a0, a0), _mm_mullo_epi16(a1, a1)),
+                                       _mm_add_epi16(_mm_mullo_epi16(a2, a2), _mm_mullo_epi16(a3, a3)));
+            x2_u32 = _mm_add_epi32(x2_u32, _mm_madd_epi16(sq, one16));
+            v_min = _mm_min_epu8(v_min, _mm_min_epu8(lo, hi));
+            v_max = _mm_max_epu8(v_max, _mm_max_epu8(lo, hi));
+        }
+        x2 = _mm_add_epi64(x2, _mm_add_epi64(_mm_unpacklo_epi32(x2_u32, zero), _mm_unpackhi_epi32(x2_u32, zero)));
+    }
+    uint64_t x1_u64[2];
+    uint64_t x2_u64[2];
+    uint8_t min_u8[16];
+    uint8_t max_u8[16];
+    _mm_storeu_si128((__m128i *) x1_u64, x1);
+    _mm_storeu_si128((__m128i *) x2_u64, x2);
+    _mm_storeu_si128((__m128i *) min_u8, v_min);
+    _mm_storeu_si128((__m128i *) max_u8, v_max);
+    if (i) {
+        s->x1 += x1_u64[0] + x1_u64[1];
+        s->x2 += x2_u64[0] + x2_u64[1];
+        for (uint32_t k = 0; k < 16; ++k) {
+            if (min_u8[k] < s->min) {
+                s->min = min_u8[k];
+            }
+            if (max_u8[k] > s->max) {
+                s->max = max_u8[k];
+            }
+        }
+    }
+#endif
+    for (; i < bytes; ++i) {
+        sum_u8(s, x[i] & 0x0f);
+        sum_u8(s, x[i] >> 4);
+    }
+    if (n & 1) {
+        sum_u8(s, x[bytes] & 0x0f);
+    }
+}
+
+static inline uint32_t popcount64(uint64_t w) {
+#if defined(__clang__) || defined(__GNUC__)
+    return (uint32_t) __builtin_popcountll(w);
+#else
+    w = w - ((w >> 1) & 0x5555555555555555ULL);
+    w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+    w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (uint32_t) ((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+void jsdrv_sum_u1(struct jsdrv_u_sum_s * s, const uint8_t * x, uint64_t offset, uint64_t n) {
+    if (0 == n) {
+        return;
+    }
+    uint64_t length = n;
+    uint64_t ones = 0;
+    x += offset / 8;
+    uint32_t shift = (uint32_t) (offset & 7);
+    uint64_t i = 0;
+    if (shift) {
+        uint64_t k = 8 - shift;
+        if (k > n) {
+            k = n;
+        }
+        ones += popcount64((x[0] >> shift) & ((1U << k) - 1));
+        ++x;
+        n -= k;
+    }
+    uint64_t bytes = n / 8;
+    for (; (i + 8) <= bytes; i += 8) {
+        ones += popcount64(load_u64(x + i));
+    }
+    for (; i < bytes; ++i) {
+        ones += popcount64(x[i]);
+    }
+    if (n & 7) {
+        ones += popcount64(x[bytes] & ((1U << (n & 7)) - 1));
+    }
+    s->x1 += ones;
+    s->x2 += ones;
+    uint8_t v_min = (ones == length) ? 1 : 0;
+    if (v_min < s->min) {
+        s->min = v_min;
+    }
+    if (ones) {
+        s->max = 1;
+    }
+}
+
+const char * jsdrv_pack_impl(void) {
+#if PACK_SSE2
+    return "sse2";
+#elif PACK_NEON
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
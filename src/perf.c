@@ -0,0 +1,83 @@
+/*
+* Copyright 2026 Jetperch LLC
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "jsdrv_prv/perf.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv/time.h"
+#include <stdbool.h>
+
+
+volatile uint64_t jsdrv_perf_counters[JSDRV_PERF_COUNT];
+
+struct perf_info_s {
+    const char * name;  // <= 7 chars per level
+    bool is_time;       // stored in jsdrv_time_utc() units, reported in us
+};
+
+static const struct perf_info_s PERF_INFO[JSDRV_PERF_COUNT] = {
+    [JSDRV_PERF_USB_XFER] = {"xfer", false},
+    [JSDRV_PERF_USB_RX] = {"rx", false},
+    [JSDRV_PERF_LOAN_0] = {"loan/0", false},
+    [JSDRV_PERF_LOAN_1] = {"loan/1", false},
+    [JSDRV_PERF_LOAN_2] = {"loan/2", false},
+    [JSDRV_PERF_LOAN_3] = {"loan/3", false},
+    [JSDRV_PERF_LOAN_4] = {"loan/4", false},
+    [JSDRV_PERF_LOAN_5] = {"loan/5", false},
+    [JSDRV_PERF_LOAN_6] = {"loan/6", false},
+    [JSDRV_PERF_LOAN_7] = {"loan/7", false},
+    [JSDRV_PERF_BACKEND_MAX] = {"be_max", false},
+    [JSDRV_PERF_BACKEND_CONTROL_MAX] = {"be_ctl", false},
+    [JSDRV_PERF_BACKEND_DATA_MAX] = {"be_data", false},
+    [JSDRV_PERF_PUBSUB_MSG] = {"ps_msg", false},
+    [JSDRV_PERF_PUBSUB_TIME] = {"ps_us", true},
+    [JSDRV_PERF_DATA_MSG] = {"data", false},
+    [JSDRV_PERF_BUF_TIME] = {"buf_us", true},
+    [JSDRV_PERF_DS_TIME] = {"ds_us", true},
+    [JSDRV_PERF_QUERY_CACHED] = {"q_cache", false},
+    [JSDRV_PERF_PUBLISH_DIRECT] = {"pub_dir", false},
+};
+
+const char * jsdrv_perf_name(uint32_t id) {
+    if (id >= JSDRV_PERF_COUNT) {
+        return NULL;
+    }
+    return PERF_INFO[id].name;
+}
+
+uint64_t jsdrv_perf_get(uint32_t id) {
+    if (id >= JSDRV_PERF_COUNT) {
+        return 0;
+    }
+#if _WIN32
+    uint64_t v = (uint64_t) InterlockedCompareExchange64((volatile LONG64 *) &jsdrv_perf_counters[id], 0, 0);
+#else
+    uint64_t v = __atomic_load_n(&jsdrv_perf_counters[id], __ATOMIC_RELAXED);
+#endif
+    if (PERF_INFO[id].is_time) {
+        v = (uint64_t) JSDRV_TIME_TO_COUNTER((int64_t) v, 1000000LL);
+    }
+    return v;
+}
+
+void jsdrv_perf_reset(void) {
+    for (uint32_t id = 0; id < JSDRV_PERF_COUNT; ++id) {
+#if _WIN32
+        InterlockedExchange64((volatile LONG64 *) &jsdrv_perf_counters[id], 0);
+#else
+        __atomic_store_n(&jsdrv_perf_counters[id], 0, __ATOMIC_RELAXED);
+#endif
+    }
+}
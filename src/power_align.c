@@ -0,0 +1,208 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/power_align.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/simd_f32.h"
+#include <math.h>
+#include <string.h>
+
+
+struct jsdrv_power_align_s {
+    uint32_t window;            // power of 2
+    uint32_t mask;
+    uint8_t channel;            // the channel of the retained samples
+    uint32_t decimate_factor;   // 0 until the first samples
+    uint64_t sample_id;         // the sample_id of the oldest retained sample
+    uint32_t tail;              // the ring index of the oldest retained sample
+    uint32_t count;             // the retained samples
+    uint64_t overrun;
+    jsdrv_power_align_fn fn;
+    void * user_data;
+    float * ring;               // window samples
+    float * out;                // 1 + window samples, out[0] is the callee scratch word
+};
+
+static void discard(struct jsdrv_power_align_s * self, uint32_t count) {
+    self->tail = (self->tail + count) & self->mask;
+    self->count -= count;
+    self->sample_id += (uint64_t) count * self->decimate_factor;
+}
+
+// Append samples to the ring, NaN when x is NULL
+static void ring_write(struct jsdrv_power_align_s * self, const float * x, uint32_t count) {
+    if (count > self->window) {
+        self->overrun += self->count + count - self->window;
+        self->sample_id += (uint64_t) (self->count + count - self->window) * self->decimate_factor;
+        self->count = 0;
+        if (x) {
+            x += count - self->window;
+        }
+        count = self->window;
+    } else if ((self->count + count) > self->window) {
+        uint32_t n = self->count + count - self->window;
+        self->overrun += n;
+        discard(self, n);
+    }
+    uint32_t head = (self->tail + self->count) & self->mask;
+    self->count += count;
+    while (count) {
+        uint32_t k = self->window - head;
+        if (k > count) {
+            k = count;
+        }
+        if (x) {
+            memcpy(self->ring + head, x, k * sizeof(float));
+            x += k;
+        } else {
+            for (uint32_t idx = 0; idx < k; ++idx) {
+                self->ring[head + idx] = NAN;
+            }
+        }
+        head = (head + k) & self->mask;
+        count -= k;
+    }
+}
+
+static void retain(struct jsdrv_power_align_s * self, uint8_t channel,
+                   uint64_t sample_id, const float * x, uint32_t count) {
+    uint32_t d = self->decimate_factor;
+    if (0 == self->count) {
+        self->channel = channel;
+        self->sample_id = sample_id;
+    } else {
+        uint64_t sample_id_end = self->sample_id + (uint64_t) self->count * d;
+        if (sample_id < sample_id_end) {
+            uint64_t dup = (sample_id_end - sample_id) / d;
+            if (dup >= count) {
+                return;
+            }
+            x += dup;
+            count -= (uint32_t) dup;
+        } else if (sample_id > sample_id_end) {
+            uint64_t skip = (sample_id - sample_id_end) / d;
+            if (skip >= self->window) {
+                self->overrun += self->count;  // never matched
+                self->count = 0;
+                self->sample_id = sample_id;
+            } else {
+                ring_write(self, NULL, (uint32_t) skip);
+            }
+        }
+    }
+    ring_write(self, x, count);
+}
+
+static void emit(struct jsdrv_power_align_s * self, const float * x, uint32_t count) {
+    float * p = self->out + 1;
+    while (count) {
+        uint32_t k = self->window - self->tail;
+        if (k > count) {
+            k = count;
+        }
+        const float * y = self->ring + self->tail;
+        jsdrv_f32_mult(p, x, y, 1.0f, k);
+        if (JSDRV_POWER_ALIGN_CURRENT == self->channel) {
+            self->fn(self->user_data, self->sample_id, y, x, p, k);
+        } else {
+            self->fn(self->user_data, self->sample_id, x, y, p, k);
+        }
+        discard(self, k);
+        x += k;
+        count -= k;
+    }
+}
+
+void jsdrv_power_align_add(struct jsdrv_power_align_s * self, uint8_t channel,
+                           uint64_t sample_id, uint32_t decimate_factor,
+                           const float * x, uint32_t count) {
+    if ((0 == count) || (0 == decimate_factor)) {
+        return;
+    }
+    if (decimate_factor != self->decimate_factor) {
+        jsdrv_power_align_clear(self);
+        self->decimate_factor = decimate_factor;
+    }
+    uint32_t d = decimate_factor;
+    if ((0 == self->count) || (channel == self->channel)) {
+        retain(self, channel, sample_id, x, count);
+        return;
+    }
+
+    // the other channel leads: multiply the overlap directly from x
+    uint64_t sample_id_end = self->sample_id + (uint64_t) self->count * d;
+    if (sample_id >= sample_id_end) {
+        discard(self, self->count);  // skipped by this channel
+        retain(self, channel, sample_id, x, count);
+        return;
+    }
+    if (sample_id < self->sample_id) {
+        uint64_t skip = (self->sample_id - sample_id) / d;
+        if (skip >= count) {
+            return;  // partner samples already discarded
+        }
+        x += skip;
+        count -= (uint32_t) skip;
+        sample_id += skip * d;
+    } else if (sample_id > self->sample_id) {
+        discard(self, (uint32_t) ((sample_id - self->sample_id) / d));
+    }
+    uint32_t n = (count < self->count) ? count : self->count;
+    emit(self, x, n);
+    if (count > n) {
+        retain(self, channel, sample_id + (uint64_t) n * d, x + n, count - n);
+    }
+}
+
+struct jsdrv_power_align_s * jsdrv_power_align_alloc(uint32_t window, jsdrv_power_align_fn fn, void * user_data) {
+    struct jsdrv_power_align_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_power_align_s));
+    if (window > JSDRV_POWER_ALIGN_WINDOW_MAX) {
+        window = JSDRV_POWER_ALIGN_WINDOW_MAX;
+    }
+    self->window = JSDRV_POWER_ALIGN_WINDOW_MIN;
+    while (self->window < window) {
+        self->window <<= 1;
+    }
+    self->mask = self->window - 1;
+    self->fn = fn;
+    self->user_data = user_data;
+    self->ring = jsdrv_alloc(self->window * sizeof(float));
+    self->out = jsdrv_alloc((1 + self->window) * sizeof(float));
+    return self;
+}
+
+void jsdrv_power_align_free(struct jsdrv_power_align_s * self) {
+    if (NULL != self) {
+        jsdrv_free(self->ring);
+        jsdrv_free(self->out);
+        jsdrv_free(self);
+    }
+}
+
+void jsdrv_power_align_clear(struct jsdrv_power_align_s * self) {
+    self->decimate_factor = 0;
+    self->sample_id = 0;
+    self->tail = 0;
+    self->count = 0;
+}
+
+uint32_t jsdrv_power_align_window(struct jsdrv_power_align_s * self) {
+    return self->window;
+}
+
+uint64_t jsdrv_power_align_overrun(struct jsdrv_power_align_s * self) {
+    return self->overrun;
+}
@@ -0,0 +1,281 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/proc.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "tinyprintf.h"
+#include <math.h>
+#include <string.h>
+
+
+#define TOPIC_PREFIX "h/proc/"
+#define PI (3.14159265358979323846)
+
+static const char SIGNAL_NAMES[JSDRV_PROC_SIGNAL_COUNT] = {'i', 'v', 'p'};
+
+static const char * FIELD_NAMES[JSDRV_PROC_FIELD_COUNT] = {
+    [JSDRV_PROC_FIELD_TYPE] = "type",
+    [JSDRV_PROC_FIELD_A] = "a",
+    [JSDRV_PROC_FIELD_B] = "b",
+    [JSDRV_PROC_FIELD_N] = "n",
+};
+
+static const char * FIELD_META[JSDRV_PROC_FIELD_COUNT] = {
+    [JSDRV_PROC_FIELD_TYPE] = "{"
+        "\"dtype\": \"u8\","
+        "\"brief\": \"The processing stage type.\","
+        "\"detail\": \"The stages run in order on the published stream.  decimate and rms reduce the sample rate by n.\","
+        "\"default\": 0,"
+        "\"options\": ["
+            "[0, \"off\"],"
+            "[1, \"scale\", \"a * x + b\"],"
+            "[2, \"lowpass\", \"single-pole IIR with cutoff a Hz\"],"
+            "[3, \"decimate\", \"mean of each n samples\"],"
+            "[4, \"rms\", \"RMS of each n samples\"],"
+            "[5, \"threshold\", \"1 at or above a, 0 below a - b\"]"
+        "]"
+    "}",
+    [JSDRV_PROC_FIELD_A] = "{"
+        "\"dtype\": \"f32\","
+        "\"brief\": \"The scale gain, lowpass cutoff in Hz, or threshold level.\","
+        "\"default\": 1.0"
+    "}",
+    [JSDRV_PROC_FIELD_B] = "{"
+        "\"dtype\": \"f32\","
+        "\"brief\": \"The scale offset or threshold hysteresis.\","
+        "\"default\": 0.0"
+    "}",
+    [JSDRV_PROC_FIELD_N] = "{"
+        "\"dtype\": \"u32\","
+        "\"brief\": \"The decimate or rms window length in samples.\","
+        "\"default\": 1,"
+        "\"range\": [1, 1000000]"
+    "}",
+};
+
+static inline bool is_decimating(uint8_t type) {
+    return (JSDRV_PROC_TYPE_DECIMATE == type) || (JSDRV_PROC_TYPE_RMS == type);
+}
+
+static void stage_clear(struct jsdrv_proc_stage_s * st) {
+    st->acc = 0.0;
+    st->count = 0;
+    st->y = 0.0f;
+    st->valid = false;
+}
+
+void jsdrv_proc_initialize(struct jsdrv_proc_s * self) {
+    memset(self, 0, sizeof(*self));
+    for (uint32_t idx = 0; idx < JSDRV_PROC_STAGE_COUNT; ++idx) {
+        self->stages[idx].a = 1.0f;
+        self->stages[idx].n = 1;
+    }
+    self->decimate_factor = 1;
+}
+
+void jsdrv_proc_clear(struct jsdrv_proc_s * self) {
+    for (uint32_t idx = 0; idx < JSDRV_PROC_STAGE_COUNT; ++idx) {
+        stage_clear(&self->stages[idx]);
+    }
+    self->phase = 0;
+}
+
+const char * jsdrv_proc_field_name(uint8_t field) {
+    return (field < JSDRV_PROC_FIELD_COUNT) ? FIELD_NAMES[field] : NULL;
+}
+
+static int32_t value_u8(const struct jsdrv_union_s * value, uint8_t max, uint8_t * rv) {
+    struct jsdrv_union_s v = *value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U8) || (v.value.u8 > max)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    *rv = v.value.u8;
+    return 0;
+}
+
+static int32_t value_u32(const struct jsdrv_union_s * value, uint32_t * rv) {
+    struct jsdrv_union_s v = *value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U32) || (0 == v.value.u32) || (v.value.u32 > JSDRV_PROC_DECIMATE_MAX)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    *rv = v.value.u32;
+    return 0;
+}
+
+static int32_t value_f32(const struct jsdrv_union_s * value, float * rv) {
+    struct jsdrv_union_s v = *value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_F64) || !isfinite(v.value.f64)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    *rv = (float) v.value.f64;
+    return 0;
+}
+
+// Update the chain summary, false when the combined rate reduction is too large.
+static bool chain_update(struct jsdrv_proc_s * self) {
+    uint64_t factor = 1;
+    bool active = false;
+    for (uint32_t idx = 0; idx < JSDRV_PROC_STAGE_COUNT; ++idx) {
+        struct jsdrv_proc_stage_s * st = &self->stages[idx];
+        if (JSDRV_PROC_TYPE_OFF != st->type) {
+            active = true;
+        }
+        if (is_decimating(st->type)) {
+            factor *= st->n;
+            if (factor > JSDRV_PROC_DECIMATE_MAX) {
+                return false;
+            }
+        }
+    }
+    self->decimate_factor = (uint32_t) factor;
+    self->active = active;
+    return true;
+}
+
+int32_t jsdrv_proc_param(struct jsdrv_proc_s * procs, const char * topic, const struct jsdrv_union_s * value) {
+    const char * s = jsdrv_cstr_starts_with(topic, TOPIC_PREFIX);
+    if ((NULL == s) || (s[0] == 0) || (s[1] != '/')) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    const char * p = memchr(SIGNAL_NAMES, s[0], sizeof(SIGNAL_NAMES));
+    if (NULL == p) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct jsdrv_proc_s * self = &procs[p - SIGNAL_NAMES];
+    s += 2;
+    if ((s[0] < '0') || ((uint32_t) (s[0] - '0') >= JSDRV_PROC_STAGE_COUNT) || (s[1] != '/')) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct jsdrv_proc_stage_s * st = &self->stages[s[0] - '0'];
+    struct jsdrv_proc_stage_s st_prev = *st;
+    s += 2;
+    int32_t rc;
+    if (0 == strcmp(s, FIELD_NAMES[JSDRV_PROC_FIELD_TYPE])) {
+        rc = value_u8(value, JSDRV_PROC_TYPE_COUNT - 1, &st->type);
+    } else if (0 == strcmp(s, FIELD_NAMES[JSDRV_PROC_FIELD_A])) {
+        rc = value_f32(value, &st->a);
+    } else if (0 == strcmp(s, FIELD_NAMES[JSDRV_PROC_FIELD_B])) {
+        rc = value_f32(value, &st->b);
+    } else if (0 == strcmp(s, FIELD_NAMES[JSDRV_PROC_FIELD_N])) {
+        rc = value_u32(value, &st->n);
+    } else {
+        rc = JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if ((0 == rc) && !chain_update(self)) {
+        *st = st_prev;
+        rc = JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (0 == rc) {
+        jsdrv_proc_clear(self);
+    }
+    return rc;
+}
+
+static void lowpass(struct jsdrv_proc_stage_s * st, float sample_rate, float * x, uint32_t count) {
+    if (st->a <= 0.0f) {
+        return;
+    }
+    float alpha = (float) (1.0 - exp(-2.0 * PI * st->a / sample_rate));
+    for (uint32_t idx = 0; idx < count; ++idx) {
+        if (!isfinite(x[idx])) {
+            st->valid = false;  // pass the gap and restart
+        } else if (!st->valid) {
+            st->y = x[idx];
+            st->valid = true;
+        } else {
+            st->y += alpha * (x[idx] - st->y);
+            x[idx] = st->y;
+        }
+    }
+}
+
+static uint32_t window(struct jsdrv_proc_stage_s * st, float * x, uint32_t count) {
+    bool rms = (JSDRV_PROC_TYPE_RMS == st->type);
+    uint32_t k = 0;
+    for (uint32_t idx = 0; idx < count; ++idx) {
+        double v = x[idx];
+        st->acc += rms ? (v * v) : v;
+        if (++st->count >= st->n) {
+            double y = st->acc / st->n;
+            x[k++] = (float) (rms ? sqrt(y) : y);
+            st->acc = 0.0;
+            st->count = 0;
+        }
+    }
+    return k;
+}
+
+static void threshold(struct jsdrv_proc_stage_s * st, float * x, uint32_t count) {
+    float lo = st->a - st->b;
+    for (uint32_t idx = 0; idx < count; ++idx) {
+        float v = x[idx];
+        if (isnan(v)) {
+            continue;  // pass NaN
+        } else if (v >= st->a) {
+            st->y = 1.0f;
+        } else if ((v < lo) || !st->valid) {
+            st->y = 0.0f;
+        }  // else within the hysteresis band, keep the state
+        st->valid = true;
+        x[idx] = st->y;
+    }
+}
+
+uint32_t jsdrv_proc_process(struct jsdrv_proc_s * self, float sample_rate, float * x, uint32_t count) {
+    if (!self->active) {
+        return count;
+    }
+    self->phase = (uint32_t) ((self->phase + (uint64_t) count) % self->decimate_factor);
+    for (uint32_t idx = 0; (idx < JSDRV_PROC_STAGE_COUNT) && count; ++idx) {
+        struct jsdrv_proc_stage_s * st = &self->stages[idx];
+        switch (st->type) {
+            case JSDRV_PROC_TYPE_SCALE:
+                for (uint32_t k = 0; k < count; ++k) {
+                    x[k] = st->a * x[k] + st->b;
+                }
+                break;
+            case JSDRV_PROC_TYPE_LOWPASS:
+                lowpass(st, sample_rate, x, count);
+                break;
+            case JSDRV_PROC_TYPE_DECIMATE:  // intentional fall-through
+            case JSDRV_PROC_TYPE_RMS:
+                count = window(st, x, count);
+                sample_rate /= (float) st->n;
+                break;
+            case JSDRV_PROC_TYPE_THRESHOLD:
+                threshold(st, x, count);
+                break;
+            default:
+                break;
+        }
+    }
+    return count;
+}
+
+void jsdrv_proc_meta_publish(struct jsdrv_context_s * context, const char * prefix) {
+    for (uint32_t sig = 0; sig < JSDRV_PROC_SIGNAL_COUNT; ++sig) {
+        for (uint32_t idx = 0; idx < JSDRV_PROC_STAGE_COUNT; ++idx) {
+            for (uint8_t field = 0; field < JSDRV_PROC_FIELD_COUNT; ++field) {
+                struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_cjson_r(FIELD_META[field]));
+                tfp_snprintf(m->topic, sizeof(m->topic), "%s/" TOPIC_PREFIX "%c/%u/%s$",
+                             prefix, SIGNAL_NAMES[sig], (unsigned int) idx, FIELD_NAMES[field]);
+                jsdrvp_backend_send(context, m);
+            }
+        }
+    }
+}
@@ -17,39 +17,124 @@
 #define JSDRV_LOG_LEVEL JSDRV_LOG_LEVEL_ALL
 
 #include "jsdrv_prv/pubsub.h"
+#include "jsdrv_prv/alloc.h"
 #include "jsdrv_prv/platform.h"
 #include "jsdrv_prv/assert.h"
 #include "jsdrv_prv/cdef.h"
 #include "jsdrv_prv/backend.h"
 #include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/latency.h"
 #include "jsdrv_prv/log.h"
+#include "jsdrv_prv/meta_store.h"
+#include "jsdrv_prv/perf.h"
+#include "jsdrv_prv/trace.h"
+#include "jsdrv_prv/value_cache.h"
 #include "jsdrv/meta.h"
 #include "jsdrv/cstr.h"
 #include "jsdrv/error_code.h"
+#include "jsdrv/topic.h"
+#include <math.h>
+#include <stdio.h>
+
+struct owner_s;
 
 struct subscriber_s {
     struct jsdrv_pubsub_subscriber_s sub;
     struct jsdrv_list_s item;
+    struct owner_s * owner;          // the owner for unsubscribe_from_all() or NULL
+    struct jsdrv_list_s owner_item;  // in owner->subscribers
+    char pattern[JSDRV_TOPIC_LENGTH_MAX];  // the wildcard subscription topic or empty
+};
+
+#define OWNER_MAP_SIZE_INIT (64U)  // must be power of 2
+
+// Accumulated messages for one batch subscriber, see jsdrv_subscribe_batch().
+struct batch_s {
+    struct jsdrv_list_s item;         // in jsdrv_pubsub_s.batch_pending when count > 0
+    jsdrv_subscribe_batch_fn fn;
+    void * user_data;
+    uint32_t count;
+    struct jsdrvp_msg_s * refs[JSDRV_SUBSCRIBE_BATCH_SIZE_MAX];  // retained
+    struct jsdrv_union_s values[JSDRV_SUBSCRIBE_BATCH_SIZE_MAX];
+    struct jsdrv_subscribe_msg_s msgs[JSDRV_SUBSCRIBE_BATCH_SIZE_MAX];
+};
+
+// All subscriptions for one subscriber identity, see is_same_subscriber().
+struct owner_s {
+    struct owner_s * next;            // the owner_map_s bucket chain
+    void * void_fn;
+    void * user_data;
+    uint8_t is_internal;
+    struct jsdrv_list_s subscribers;  // of subscriber_s.owner_item, never empty
+    struct batch_s * batch;           // for batch subscribers, allocated on first message
+};
+
+// Chained hash map from subscriber identity to its owner_s.
+struct owner_map_s {
+    struct owner_s ** buckets;
+    uint32_t mask;   // size - 1
+    uint32_t count;
 };
 
+#define TOPIC_MAP_SIZE_INIT (256U)  // must be power of 2
+#define TOPIC_VALUE_INLINE_SIZE (24U)  // retained str, json and bin values up to this size
+
 struct topic_s {
     char name[JSDRV_TOPIC_LENGTH_PER_LEVEL];
-    struct jsdrvp_msg_s * value;
-    struct jsdrvp_msg_s * meta;
+    char topic[JSDRV_TOPIC_LENGTH_MAX];  // the full topic name
+    uint32_t hash;                       // jsdrv_pubsub_topic_hash(topic)
+    struct jsdrv_union_s value;          // retained when JSDRV_UNION_FLAG_RETAIN, see topic_value_set()
+    struct jsdrvp_msg_s * value_msg;     // retained message for data and payload types, or NULL
+    uint8_t value_inline[TOPIC_VALUE_INLINE_SIZE];
+    const struct jsdrv_meta_entry_s * meta;  // interned in jsdrv_pubsub_s.meta_store
     struct topic_s * parent;
     struct jsdrv_list_s item;  // used by parent->children list
     struct jsdrv_list_s children;
     struct jsdrv_list_s subscribers;
+
+    // Data-plane subscriber vector for this topic and its ancestors,
+    // valid when data_subs_gen == jsdrv_pubsub_s.subscriber_gen.
+    struct jsdrv_pubsub_subscriber_s * data_subs;
+    uint32_t data_subs_count;
+    uint32_t data_subs_size;
+    uint32_t data_subs_gen;
+    uint32_t shard;            // jsdrv_pubsub_shard_hash(topic) or 0 (not computed)
+};
+
+// Flat, open-addressed hash map from full topic name to topic_s.
+struct topic_map_s {
+    struct topic_s ** entries;
+    uint32_t mask;   // size - 1
+    uint32_t count;
 };
 
 struct jsdrv_pubsub_s {
     struct jsdrv_context_s * context;
     struct topic_s * root_topic;
+    struct topic_map_s topic_map;
+    struct owner_map_s owner_map;
+    uint32_t subscriber_gen;                  // incremented on each subscriber change
+    const struct jsdrv_pubsub_dispatch_s * dispatch;  // optional data plane dispatcher
+    struct jsdrv_pubsub_queue_s ** queue_closing;     // removed subscriber queues to close
+    uint32_t queue_closing_count;
+    uint32_t queue_closing_size;
     struct jsdrv_list_s subscriber_free;      // of subscriber_s
+    struct jsdrv_list_s wildcards;            // of subscriber_s with a pattern
     struct jsdrv_list_s msg_pend;             // of jsdrvp_msg_s
+    struct jsdrv_list_s batch_pending;        // of batch_s with messages
+    struct jsdrv_value_cache_s * value_cache; // retained scalar values for any thread
+    struct jsdrv_meta_store_s * meta_store;   // interned metadata shared between topics
 };
 
-static uint8_t publish(struct topic_s * topic, struct jsdrvp_msg_s * msg, uint8_t flags);
+static inline bool topic_has_value(const struct topic_s * topic) {
+    return 0 != (topic->value.flags & JSDRV_UNION_FLAG_RETAIN);
+}
+
+static inline const struct jsdrv_union_s * topic_value(const struct topic_s * topic) {
+    return topic_has_value(topic) ? &topic->value : NULL;
+}
+
+static uint8_t publish(struct jsdrv_pubsub_s * self, struct topic_s * topic, struct jsdrvp_msg_s * msg, uint8_t flags);
 
 static void topic_str_append(char * topic_str, const char * topic_sub_str) {
     // WARNING: topic_str must be >= TOPIC_LENGTH_MAX
@@ -101,6 +186,149 @@ static void topic_str_pop(char * topic_str) {
 }
 #endif
 
+static inline uint32_t owner_hash(const struct jsdrv_pubsub_subscriber_s * s) {
+    uint64_t h = ((uint64_t) (uintptr_t) s->void_fn) * 0x9E3779B97F4A7C15ULL;
+    h ^= ((uint64_t) (uintptr_t) s->user_data + s->is_internal) * 0xC2B2AE3D27D4EB4FULL;
+    return (uint32_t) (h ^ (h >> 32));
+}
+
+static struct owner_s ** owner_slot(struct jsdrv_pubsub_s * self, const struct jsdrv_pubsub_subscriber_s * s) {
+    struct owner_s ** slot = &self->owner_map.buckets[owner_hash(s) & self->owner_map.mask];
+    while (*slot) {
+        struct owner_s * o = *slot;
+        if ((o->void_fn == s->void_fn) && (o->user_data == s->user_data) && (o->is_internal == s->is_internal)) {
+            break;
+        }
+        slot = &o->next;
+    }
+    return slot;
+}
+
+static void owner_map_grow(struct jsdrv_pubsub_s * self) {
+    struct owner_map_s * map = &self->owner_map;
+    uint32_t size = 2 * (map->mask + 1);
+    struct owner_s ** buckets = jsdrv_alloc_clr_cat(size * sizeof(struct owner_s *), JSDRV_ALLOC_CAT_PUBSUB);
+    for (uint32_t i = 0; i <= map->mask; ++i) {
+        struct owner_s * o = map->buckets[i];
+        while (o) {
+            struct owner_s * next = o->next;
+            struct jsdrv_pubsub_subscriber_s key = {.void_fn = o->void_fn, .user_data = o->user_data,
+                                                    .is_internal = o->is_internal};
+            uint32_t idx = owner_hash(&key) & (size - 1);
+            o->next = buckets[idx];
+            buckets[idx] = o;
+            o = next;
+        }
+    }
+    jsdrv_free(map->buckets);
+    map->buckets = buckets;
+    map->mask = size - 1;
+}
+
+// Add the subscriber to the owner of its identity for unsubscribe_from_all().
+static void owner_add(struct jsdrv_pubsub_s * self, struct subscriber_s * sub) {
+    if (!sub->sub.void_fn) {
+        return;  // never matches is_same_subscriber()
+    }
+    struct owner_s ** slot = owner_slot(self, &sub->sub);
+    struct owner_s * o = *slot;
+    if (!o) {
+        if (self->owner_map.count >= (self->owner_map.mask + 1)) {
+            owner_map_grow(self);  // keep the load factor <= 1
+            slot = owner_slot(self, &sub->sub);
+        }
+        o = jsdrv_alloc_clr_cat(sizeof(struct owner_s), JSDRV_ALLOC_CAT_PUBSUB);
+        o->void_fn = sub->sub.void_fn;
+        o->user_data = sub->sub.user_data;
+        o->is_internal = sub->sub.is_internal;
+        jsdrv_list_initialize(&o->subscribers);
+        *slot = o;
+        ++self->owner_map.count;
+    }
+    sub->owner = o;
+    jsdrv_list_add_tail(&o->subscribers, &sub->owner_item);
+}
+
+static void batch_flush(struct jsdrv_pubsub_s * self, struct batch_s * b) {
+    uint32_t count = b->count;
+    if (!count) {
+        return;
+    }
+    b->count = 0;
+    jsdrv_list_remove(&b->item);
+    for (uint32_t i = 0; i < count; ++i) {
+        jsdrv_latency_deliver(b->refs[i]);
+        b->msgs[i].topic = b->refs[i]->topic;
+        b->msgs[i].value = &b->values[i];
+    }
+    b->fn(b->user_data, b->msgs, count);
+    for (uint32_t i = 0; i < count; ++i) {
+        jsdrvp_msg_free(self->context, b->refs[i]);
+        b->refs[i] = NULL;
+    }
+}
+
+static void batch_flush_all(struct jsdrv_pubsub_s * self) {
+    while (!jsdrv_list_is_empty(&self->batch_pending)) {
+        struct jsdrv_list_s * item = jsdrv_list_peek_head(&self->batch_pending);
+        batch_flush(self, JSDRV_CONTAINER_OF(item, struct batch_s, item));
+    }
+}
+
+static void batch_add(struct jsdrv_pubsub_s * self, const struct jsdrv_pubsub_subscriber_s * s, struct jsdrvp_msg_s * msg) {
+    struct jsdrv_union_s value;
+    if (msg->value.app < JSDRV_PAYLOAD_TYPE_SUB) {  // public jsdrv_payload_type_e
+        value = msg->value;
+    } else if ((msg->value.type == JSDRV_UNION_BIN) && (msg->value.app == JSDRV_PAYLOAD_TYPE_DEVICE)) {
+        value = jsdrv_union_str(msg->payload.device.prefix);
+    } else {
+        JSDRV_LOGW("unsupported value.app type: %d", (int) msg->value.app);
+        return;
+    }
+    struct owner_s * o = *owner_slot(self, s);
+    if (!o) {
+        JSDRV_LOGW("batch subscriber not found");
+        return;
+    }
+    struct batch_s * b = o->batch;
+    if (!b) {
+        b = jsdrv_alloc_clr_cat(sizeof(struct batch_s), JSDRV_ALLOC_CAT_PUBSUB);
+        jsdrv_list_initialize(&b->item);
+        b->fn = s->batch_fn;
+        b->user_data = s->user_data;
+        o->batch = b;
+    }
+    if (0 == b->count) {
+        jsdrv_list_add_tail(&self->batch_pending, &b->item);
+    }
+    b->refs[b->count] = jsdrvp_msg_retain(msg);
+    b->values[b->count] = value;
+    if (++b->count >= JSDRV_SUBSCRIBE_BATCH_SIZE_MAX) {
+        batch_flush(self, b);
+    }
+}
+
+// Remove the subscriber from its owner, and free the owner after its last subscriber.
+static void owner_remove(struct jsdrv_pubsub_s * self, struct subscriber_s * sub) {
+    struct owner_s * o = sub->owner;
+    if (!o) {
+        return;
+    }
+    sub->owner = NULL;
+    jsdrv_list_remove(&sub->owner_item);
+    if (jsdrv_list_is_empty(&o->subscribers)) {
+        struct owner_s ** slot = owner_slot(self, &sub->sub);
+        JSDRV_ASSERT(*slot == o);
+        *slot = o->next;
+        --self->owner_map.count;
+        if (o->batch) {
+            batch_flush(self, o->batch);  // deliver before unsubscribe completes
+            jsdrv_free(o->batch);
+        }
+        jsdrv_free(o);
+    }
+}
+
 static struct subscriber_s * subscriber_alloc(struct jsdrv_pubsub_s * self) {
     struct subscriber_s * sub;
     if (!jsdrv_list_is_empty(&self->subscriber_free)) {
@@ -108,22 +336,43 @@ static struct subscriber_s * subscriber_alloc(struct jsdrv_pubsub_s * self) {
         item = jsdrv_list_remove_head(&self->subscriber_free);
         sub = JSDRV_CONTAINER_OF(item, struct subscriber_s, item);
     } else {
-        sub = jsdrv_alloc_clr(sizeof(struct subscriber_s));
+        sub = jsdrv_alloc_clr_cat(sizeof(struct subscriber_s), JSDRV_ALLOC_CAT_PUBSUB);
         //JSDRV_LOGD3("subscriber alloc: %p", (void *) sub);
     }
     jsdrv_memset(sub, 0, sizeof(*sub));
     jsdrv_list_initialize(&sub->item);
+    jsdrv_list_initialize(&sub->owner_item);
     return sub;
 }
 
 static void subscriber_free(struct jsdrv_pubsub_s * self, struct subscriber_s * sub) {
+    owner_remove(self, sub);
     jsdrv_list_add_tail(&self->subscriber_free, &sub->item);
 }
 
+static void subscriber_remove(struct jsdrv_pubsub_s * self, struct subscriber_s * sub) {
+    jsdrv_list_remove(&sub->item);
+    if (sub->sub.queue) {
+        if (self->queue_closing_count >= self->queue_closing_size) {
+            uint32_t sz = self->queue_closing_size ? (2 * self->queue_closing_size) : 4;
+            struct jsdrv_pubsub_queue_s ** q = jsdrv_alloc_cat(sz * sizeof(*q), JSDRV_ALLOC_CAT_PUBSUB);
+            if (self->queue_closing) {
+                memcpy(q, self->queue_closing, self->queue_closing_count * sizeof(*q));
+                jsdrv_free(self->queue_closing);
+            }
+            self->queue_closing = q;
+            self->queue_closing_size = sz;
+        }
+        self->queue_closing[self->queue_closing_count++] = sub->sub.queue;
+        sub->sub.queue = NULL;
+    }
+    subscriber_free(self, sub);
+}
+
 static struct topic_s * topic_alloc(struct jsdrv_pubsub_s * self, const char * name) {
     (void) self;
-    struct topic_s * topic = jsdrv_alloc_clr(sizeof(struct topic_s));
-    topic->value = NULL;
+    struct topic_s * topic = jsdrv_alloc_clr_cat(sizeof(struct topic_s), JSDRV_ALLOC_CAT_PUBSUB);
+    topic->value = jsdrv_union_null();
     jsdrv_list_initialize(&topic->item);
     jsdrv_list_initialize(&topic->children);
     jsdrv_list_initialize(&topic->subscribers);
@@ -132,20 +381,62 @@ static struct topic_s * topic_alloc(struct jsdrv_pubsub_s * self, const char * n
     return topic;
 }
 
+static void topic_value_clear(struct jsdrv_pubsub_s * self, struct topic_s * topic) {
+    if (topic->value_msg) {
+        jsdrvp_msg_free(self->context, topic->value_msg);
+        topic->value_msg = NULL;
+    } else if (jsdrv_union_is_type_ptr(&topic->value) && topic->value.value.bin
+            && (topic->value.value.bin != topic->value_inline)) {
+        jsdrv_free((void *) topic->value.value.bin);
+    }
+    topic->value = jsdrv_union_null();
+}
+
+/*
+ * Retain the value from msg.  Standard union values are copied into the
+ * topic, inline when small, so that the topic does not hold a full
+ * message for each retained value.  Messages with other payload types
+ * are retained as is.
+ *
+ * Return true when the topic took ownership of msg.
+ */
+static bool topic_value_set(struct jsdrv_pubsub_s * self, struct topic_s * topic, struct jsdrvp_msg_s * msg) {
+    topic_value_clear(self, topic);
+    const struct jsdrv_union_s * v = &msg->value;
+    bool is_ptr = jsdrv_union_is_type_ptr(v);
+    if ((v->app != JSDRV_PAYLOAD_TYPE_UNION) || (is_ptr && !v->value.bin)
+            || ((v->type == JSDRV_UNION_BIN) && !v->size)) {
+        topic->value_msg = msg;
+        topic->value = msg->value;
+        return true;
+    }
+    topic->value = *v;
+    topic->value.flags &= ~JSDRV_UNION_FLAG_HEAP_MEMORY;
+    if (is_ptr) {
+        // retain the original size, which may be 0 for str and json, for de-duplication
+        size_t sz = v->size ? v->size : (strlen(v->value.str) + 1);
+        uint8_t * buf = (sz <= sizeof(topic->value_inline)) ? topic->value_inline : jsdrv_alloc_cat(sz, JSDRV_ALLOC_CAT_PUBSUB);
+        memcpy(buf, v->value.bin, sz);
+        topic->value.value.bin = buf;
+    }
+    return false;
+}
+
 static void topic_free(struct jsdrv_pubsub_s * self, struct topic_s * topic) {
     struct jsdrv_list_s * item;
     struct subscriber_s * subscriber;
     if (!topic) {
         return;
     }
-    if (topic->value) {
-        jsdrvp_msg_free(self->context, topic->value);
-        topic->value = NULL;
+    if (topic_has_value(topic)) {
+        jsdrv_value_cache_set(self->value_cache, topic->topic, topic->hash, NULL);
     }
+    topic_value_clear(self, topic);
     if (topic->meta) {
-        jsdrvp_msg_free(self->context, topic->meta);
-        topic->meta = NULL;
+        jsdrv_value_cache_direct_set(self->value_cache, topic->topic, topic->hash, false);
     }
+    jsdrv_meta_store_release(self->meta_store, topic->meta);
+    topic->meta = NULL;
     jsdrv_list_foreach(&topic->subscribers, item) {
         subscriber = JSDRV_CONTAINER_OF(item, struct subscriber_s, item);
         jsdrv_list_remove(item);
@@ -158,9 +449,70 @@ static void topic_free(struct jsdrv_pubsub_s * self, struct topic_s * topic) {
         topic_free(self, subtopic);
     }
     //JSDRV_LOGD3("topic free: %p", (void *)topic);
+    if (topic->data_subs) {
+        jsdrv_free(topic->data_subs);
+    }
     jsdrv_free(topic);
 }
 
+uint32_t jsdrv_pubsub_topic_hash(const char * topic) {
+    uint32_t hash = 2166136261U;  // FNV-1a
+    while (*topic) {
+        hash ^= (uint8_t) *topic++;
+        hash *= 16777619U;
+    }
+    return hash ? hash : 1U;  // reserve 0 for "not computed"
+}
+
+uint32_t jsdrv_pubsub_shard_hash(const char * topic) {
+    uint32_t hash = 2166136261U;  // FNV-1a, matches jsdrv_pubsub_topic_hash()
+    uint32_t levels = 0;
+    for (; *topic; ++topic) {
+        if ((*topic == '/') && (++levels >= JSDRV_PUBSUB_SHARD_LEVELS)) {
+            break;
+        }
+        hash ^= (uint8_t) *topic;
+        hash *= 16777619U;
+    }
+    return hash ? hash : 1U;
+}
+
+static void topic_map_insert(struct topic_map_s * map, struct topic_s * topic) {
+    if (((map->count + 1) * 2) > (map->mask + 1)) {
+        // grow to keep the load factor <= 0.5
+        struct topic_map_s m = {
+            .entries = jsdrv_alloc_clr_cat(2 * (map->mask + 1) * sizeof(struct topic_s *), JSDRV_ALLOC_CAT_PUBSUB),
+            .mask = 2 * (map->mask + 1) - 1,
+            .count = 0,
+        };
+        for (uint32_t i = 0; i <= map->mask; ++i) {
+            if (map->entries[i]) {
+                topic_map_insert(&m, map->entries[i]);
+            }
+        }
+        jsdrv_free(map->entries);
+        *map = m;
+    }
+    uint32_t idx = topic->hash & map->mask;
+    while (map->entries[idx]) {
+        idx = (idx + 1) & map->mask;
+    }
+    map->entries[idx] = topic;
+    ++map->count;
+}
+
+static struct topic_s * topic_map_find(struct topic_map_s * map, const char * topic, uint32_t hash) {
+    uint32_t idx = hash & map->mask;
+    struct topic_s * t;
+    while (NULL != (t = map->entries[idx])) {
+        if ((t->hash == hash) && (0 == strcmp(t->topic, topic))) {
+            return t;
+        }
+        idx = (idx + 1) & map->mask;
+    }
+    return NULL;
+}
+
 /**
  * @brief Parse the next subtopic.
  * @param topic[inout] The topic, which is advanced to the next subtopic.
@@ -200,11 +552,62 @@ static struct topic_s * subtopic_find(struct topic_s * parent, const char * subt
     return NULL;
 }
 
-static struct topic_s * topic_find(struct jsdrv_pubsub_s * self, const char * topic, bool create) {
+static void topic_add(struct jsdrv_pubsub_s * self, struct topic_s * parent, struct topic_s * topic) {
+    topic->parent = parent;
+    jsdrv_list_add_tail(&parent->children, &topic->item);
+    char * t = topic->topic;
+    char * t_end = topic->topic + sizeof(topic->topic) - 1;
+    if (parent != self->root_topic) {
+        for (const char * c = parent->topic; *c && (t < t_end); ++c) {
+            *t++ = *c;
+        }
+        if (t < t_end) {
+            *t++ = '/';
+        }
+    }
+    for (const char * c = topic->name; *c && (t < t_end); ++c) {
+        *t++ = *c;
+    }
+    *t = 0;
+    topic->hash = jsdrv_pubsub_topic_hash(topic->topic);
+    if (topic->topic[0]) {  // the root topic "" is never in the map
+        topic_map_insert(&self->topic_map, topic);
+    }
+}
+
+/**
+ * @brief Find a topic.
+ *
+ * @param self The pubsub instance.
+ * @param topic The full topic name.
+ * @param hash The jsdrv_pubsub_topic_hash() for topic, or 0 to compute.
+ *      This value is only a hint and is verified against topic.
+ * @param create When true, create the topic if it does not exist.
+ * @return The topic or NULL.
+ */
+static struct topic_s * topic_find_hash(struct jsdrv_pubsub_s * self, const char * topic, uint32_t hash, bool create) {
     char subtopic_str[JSDRV_TOPIC_LENGTH_PER_LEVEL];
     const char * c = topic;
 
-    struct topic_s * t = self->root_topic;
+    if (0 == *topic) {
+        return self->root_topic;
+    }
+    struct topic_s * t = NULL;
+    if (hash) {
+        t = topic_map_find(&self->topic_map, topic, hash);
+    }
+    if (!t) {
+        uint32_t hash_computed = jsdrv_pubsub_topic_hash(topic);
+        if (hash_computed != hash) {
+            t = topic_map_find(&self->topic_map, topic, hash_computed);
+        }
+    }
+    if (t) {
+        return t;
+    }
+
+    // slow path: not in map, walk the tree, which handles unusual topics
+    t = self->root_topic;
     struct topic_s * subtopic;
     while (*c != 0) {
         if (!subtopic_get_str(&c, subtopic_str)) {
@@ -216,20 +619,32 @@ static struct topic_s * topic_find(struct jsdrv_pubsub_s * self, const char * to
                 return NULL;
             }
             subtopic = topic_alloc(self, subtopic_str);
-            subtopic->parent = t;
-            jsdrv_list_add_tail(&t->children, &subtopic->item);
+            topic_add(self, t, subtopic);
         }
         t = subtopic;
     }
     return t;
 }
 
+static inline struct topic_s * topic_find(struct jsdrv_pubsub_s * self, const char * topic, bool create) {
+    return topic_find_hash(self, topic, 0, create);
+}
+
 struct jsdrv_pubsub_s * jsdrv_pubsub_initialize(struct jsdrv_context_s * context) {
-    struct jsdrv_pubsub_s * s = jsdrv_alloc_clr(sizeof(struct jsdrv_pubsub_s));
+    struct jsdrv_pubsub_s * s = jsdrv_alloc_clr_cat(sizeof(struct jsdrv_pubsub_s), JSDRV_ALLOC_CAT_PUBSUB);
     s->context = context;
     jsdrv_list_initialize(&s->subscriber_free);
+    jsdrv_list_initialize(&s->wildcards);
     jsdrv_list_initialize(&s->msg_pend);
+    jsdrv_list_initialize(&s->batch_pending);
     s->root_topic = topic_alloc(s, "");
+    s->topic_map.entries = jsdrv_alloc_clr_cat(TOPIC_MAP_SIZE_INIT * sizeof(struct topic_s *), JSDRV_ALLOC_CAT_PUBSUB);
+    s->topic_map.mask = TOPIC_MAP_SIZE_INIT - 1;
+    s->owner_map.buckets = jsdrv_alloc_clr_cat(OWNER_MAP_SIZE_INIT * sizeof(struct owner_s *), JSDRV_ALLOC_CAT_PUBSUB);
+    s->owner_map.mask = OWNER_MAP_SIZE_INIT - 1;
+    s->subscriber_gen = 1;
+    s->value_cache = jsdrv_value_cache_alloc();
+    s->meta_store = jsdrv_meta_store_alloc();
     return s;
 }
 
@@ -241,40 +656,62 @@ void jsdrv_pubsub_finalize(struct jsdrv_pubsub_s * self) {
             jsdrvp_msg_free(self->context, m);
         }
         topic_free(self, self->root_topic);
+        jsdrv_free(self->topic_map.entries);
+        jsdrv_value_cache_free(self->value_cache);
+        self->value_cache = NULL;
+        jsdrv_meta_store_free(self->meta_store);
+        self->meta_store = NULL;
+        while (!jsdrv_list_is_empty(&self->wildcards)) {
+            struct jsdrv_list_s * item = jsdrv_list_remove_head(&self->wildcards);
+            subscriber_free(self, JSDRV_CONTAINER_OF(item, struct subscriber_s, item));
+        }
+        JSDRV_ASSERT(0 == self->owner_map.count);
+        jsdrv_free(self->owner_map.buckets);
         while (!jsdrv_list_is_empty(&self->subscriber_free)) {
             struct jsdrv_list_s * item = jsdrv_list_remove_head(&self->subscriber_free);
             struct subscriber_s * sub = JSDRV_CONTAINER_OF(item, struct subscriber_s, item);
             //JSDRV_LOGD3("subscriber free: %p", (void *) sub);
             jsdrv_free(sub);
         }
+        if (self->queue_closing) {
+            jsdrv_free(self->queue_closing);
+        }
         jsdrv_free(self);
     }
 }
 
+void jsdrv_pubsub_dispatch_register(struct jsdrv_pubsub_s * self, const struct jsdrv_pubsub_dispatch_s * dispatch) {
+    self->dispatch = dispatch;
+}
+
 int32_t jsdrv_pubsub_publish(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg) {
     jsdrv_list_add_tail(&self->msg_pend, &msg->item);
     return 0;
 }
 
-static int8_t subscriber_call(struct jsdrv_pubsub_subscriber_s * s, struct jsdrvp_msg_s * msg) {
+void jsdrv_pubsub_external_call(const struct jsdrv_pubsub_subscriber_s * s, struct jsdrvp_msg_s * msg) {
+    if (msg->value.app < JSDRV_PAYLOAD_TYPE_SUB) {  // public jsdrv_payload_type_e
+        jsdrv_latency_deliver(msg);
+        s->external_fn(s->user_data, msg->topic, &msg->value);
+    } else if ((msg->value.type == JSDRV_UNION_BIN) && (msg->value.app == JSDRV_PAYLOAD_TYPE_DEVICE)) {
+        s->external_fn(s->user_data, msg->topic, &jsdrv_union_str(msg->payload.device.prefix));
+    } else {
+        JSDRV_LOGW("unsupported value.app type: %d", (int) msg->value.app);
+    }
+}
+
+static int8_t subscriber_call(struct jsdrv_pubsub_s * self, struct jsdrv_pubsub_subscriber_s * s, struct jsdrvp_msg_s * msg) {
     uint8_t rc = 0;
     if (!s->void_fn) {
         JSDRV_LOGW("skip null subscriber");
     } else if (s->is_internal) {
         rc = s->internal_fn(s->user_data, msg);
+    } else if (s->is_batch) {
+        batch_add(self, s, msg);
+    } else if (s->queue) {
+        s->queue->push(s->queue, msg);
     } else {
-        if ((msg->value.app == JSDRV_PAYLOAD_TYPE_UNION)
-                || (msg->value.app == JSDRV_PAYLOAD_TYPE_STREAM)
-                || (msg->value.app == JSDRV_PAYLOAD_TYPE_STATISTICS)
-                || (msg->value.app == JSDRV_PAYLOAD_TYPE_BUFFER_INFO)
-                || (msg->value.app == JSDRV_PAYLOAD_TYPE_BUFFER_REQ)
-                || (msg->value.app == JSDRV_PAYLOAD_TYPE_BUFFER_RSP)) {
-            s->external_fn(s->user_data, msg->topic, &msg->value);
-        } else if ((msg->value.type == JSDRV_UNION_BIN) && (msg->value.app == JSDRV_PAYLOAD_TYPE_DEVICE)) {
-            s->external_fn(s->user_data, msg->topic, &jsdrv_union_str(msg->payload.device.prefix));
-        } else {
-            JSDRV_LOGW("unsupported value.app type: %d", (int) msg->value.app);
-        }
+        jsdrv_pubsub_external_call(s, msg);
     }
 
     if (rc) {
@@ -284,40 +721,97 @@ static int8_t subscriber_call(struct jsdrv_pubsub_subscriber_s * s, struct jsdrv
     return rc;
 }
 
-static void subscribe_traverse(struct topic_s * topic, char * topic_str, struct subscriber_s * sub) {
+/*
+ * Topics do not retain their metadata message, only the interned entry.
+ * Build a temporary message for late subscribers.  Dispatch queues
+ * retain the message as needed.
+ */
+static void subscriber_call_meta(struct jsdrv_pubsub_s * self, struct topic_s * topic, struct subscriber_s * sub) {
+    char topic_str[JSDRV_TOPIC_LENGTH_MAX];
+    struct jsdrv_union_s value = jsdrv_union_json(topic->meta->json);
+    value.size = topic->meta->size;
+    jsdrv_cstr_join(topic_str, topic->topic, "$", sizeof(topic_str));
+    struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc_value(self->context, topic_str, &value);
+    subscriber_call(self, &sub->sub, msg);
+    jsdrvp_msg_free(self->context, msg);
+}
+
+/*
+ * Topics retain values, not messages.  Build a temporary message to
+ * replay the retained value.  Dispatch queues retain the message as needed.
+ */
+static void subscriber_call_value(struct jsdrv_pubsub_s * self, struct topic_s * topic, struct subscriber_s * sub) {
+    if (topic->value_msg) {
+        subscriber_call(self, &sub->sub, topic->value_msg);
+        return;
+    }
+    struct jsdrvp_msg_s * msg;
+    if (jsdrv_union_is_type_ptr(&topic->value)) {
+        msg = jsdrvp_msg_alloc_value(self->context, topic->topic, &topic->value);
+    } else {
+        msg = jsdrvp_msg_alloc_small(self->context);
+        jsdrv_cstr_copy(msg->topic, topic->topic, sizeof(msg->topic));
+        msg->value = topic->value;
+    }
+    subscriber_call(self, &sub->sub, msg);
+    jsdrvp_msg_free(self->context, msg);
+}
+
+static void subscribe_traverse(struct jsdrv_pubsub_s * self, struct topic_s * topic, char * topic_str,
+                               struct subscriber_s * sub) {
     size_t topic_str_len = strlen(topic_str);
     char * topic_str_last = topic_str + topic_str_len;
     if ((sub->sub.flags & JSDRV_SFLAG_METADATA_RSP) && topic->meta) {
-        subscriber_call(&sub->sub, topic->meta);
+        subscriber_call_meta(self, topic, sub);
     }
-    if ((sub->sub.flags & JSDRV_SFLAG_PUB) && topic->value && (topic->value->value.flags & JSDRV_UNION_FLAG_RETAIN)) {
-        subscriber_call(&sub->sub, topic->value);
+    if ((sub->sub.flags & JSDRV_SFLAG_PUB) && topic_has_value(topic)) {
+        subscriber_call_value(self, topic, sub);
     }
     struct jsdrv_list_s * item;
     struct topic_s * subtopic;
     jsdrv_list_foreach(&topic->children, item) {
         subtopic = JSDRV_CONTAINER_OF(item, struct topic_s, item);
         topic_str_append(topic_str, subtopic->name);
-        subscribe_traverse(subtopic, topic_str, sub);
+        subscribe_traverse(self, subtopic, topic_str, sub);
         *topic_str_last = 0;  // reset string to original
     }
 }
 
-static void devices_on_sub(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg) {
+static void wildcard_traverse(struct jsdrv_pubsub_s * self, struct topic_s * topic, struct subscriber_s * sub) {
+    if (jsdrv_topic_match(sub->pattern, topic->topic)) {
+        if ((sub->sub.flags & JSDRV_SFLAG_METADATA_RSP) && topic->meta) {
+            subscriber_call_meta(self, topic, sub);
+        }
+        if ((sub->sub.flags & JSDRV_SFLAG_PUB) && topic_has_value(topic)) {
+            subscriber_call_value(self, topic, sub);
+        }
+    }
+    struct jsdrv_list_s * item;
+    jsdrv_list_foreach(&topic->children, item) {
+        wildcard_traverse(self, JSDRV_CONTAINER_OF(item, struct topic_s, item), sub);
+    }
+}
+
+static void devices_on_sub(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg, struct subscriber_s * sub) {
     // publish device add for all existing devices (as needed)
     char dev_str[JSDRV_TOPIC_LENGTH_MAX];
     const char * t = msg->payload.sub.topic;
     if ((0 == strcmp(t, "")) || (0 == strcmp(t, "@")) || (0 == strcmp(t, "@/")) || (0 == strcmp(t, JSDRV_MSG_DEVICE_ADD))) {
         struct topic_s * t_dev_list = topic_find(self, JSDRV_MSG_DEVICE_LIST, false);
-        if (!t_dev_list || !t_dev_list->value || (t_dev_list->value->value.type != JSDRV_UNION_STR)) {
+        if (!t_dev_list || !topic_has_value(t_dev_list) || (t_dev_list->value.type != JSDRV_UNION_STR)) {
             return;
         }
-        const char * src = t_dev_list->value->value.value.str;
+        const char * src = t_dev_list->value.value.str;
         char * dst = dev_str;
         while (1) {
             if (*src == 0 || *src == ',') {
                 *dst = 0;
-                if (dev_str[0]) {
+                if (dev_str[0] && (sub->sub.queue || sub->sub.is_batch)) {
+                    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, JSDRV_MSG_DEVICE_ADD,
+                                                                     &jsdrv_union_str(dev_str));
+                    subscriber_call(self, &sub->sub, m);
+                    jsdrvp_msg_free(self->context, m);
+                } else if (dev_str[0]) {
                     msg->payload.sub.subscriber.external_fn(msg->payload.sub.subscriber.user_data,
                                                             JSDRV_MSG_DEVICE_ADD,
                                                             &jsdrv_union_str(dev_str));
@@ -334,30 +828,30 @@ static void devices_on_sub(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * m
     }
 }
 
-static void query_value_copy(const struct jsdrvp_msg_s * src, struct jsdrvp_msg_s * dst) {
+static void query_value_copy(const struct jsdrv_union_s * src, struct jsdrvp_msg_s * dst) {
     if (!src) {
         *dst->payload.query.value = jsdrv_union_null();
         return;
     }
-    size_t sz = src->value.size;
-    if (jsdrv_union_is_type_ptr(&src->value)) {
+    size_t sz = src->size;
+    if (jsdrv_union_is_type_ptr(src)) {
         if (!jsdrv_union_is_type_ptr(dst->payload.query.value)) {
             dst->value = jsdrv_union_i32(JSDRV_ERROR_SYNTAX_ERROR);
             return;
         }
         if (!sz) {
-            sz = strlen(src->value.value.str) + 1;
+            sz = strlen(src->value.str) + 1;
         }
         if (sz > dst->payload.query.value->size) {
             dst->value = jsdrv_union_i32(JSDRV_ERROR_TOO_SMALL);
         } else {
-            memcpy((void *) dst->payload.query.value->value.bin, src->value.value.bin, sz);
-            dst->payload.query.value->type = src->value.type;
+            memcpy((void *) dst->payload.query.value->value.bin, src->value.bin, sz);
+            dst->payload.query.value->type = src->type;
             dst->payload.query.value->size = (uint32_t) sz;
             dst->value = jsdrv_union_i32(0);
         }
     } else {
-        *dst->payload.query.value = src->value;
+        *dst->payload.query.value = *src;
         dst->value = jsdrv_union_i32(0);
     }
 }
@@ -380,7 +874,7 @@ static void publish_return_code(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_
     if (t) {
         msg->topic[sz] = JSDRV_TOPIC_SUFFIX_RETURN_CODE;
         msg->topic[sz + 1] = 0;
-        publish(t, msg, JSDRV_SFLAG_RETURN_CODE);
+        publish(self, t, msg, JSDRV_SFLAG_RETURN_CODE);
     }
     jsdrvp_msg_free(self->context, msg);
 }
@@ -408,21 +902,161 @@ static int32_t query(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg) {
         if (!t->meta) {
             msg->payload.query.value->type = JSDRV_UNION_NULL;
         } else {
-            query_value_copy(t->meta, msg);
+            struct jsdrv_union_s value = jsdrv_union_json(t->meta->json);
+            value.size = t->meta->size;
+            query_value_copy(&value, msg);
         }
     } else {
-        query_value_copy(t->value, msg);
-        char buf[32];
-        jsdrv_union_value_to_str(msg->payload.query.value, buf, sizeof(buf), 1);
-        JSDRV_LOGD1("query %s => %s", topic, buf);
+        query_value_copy(topic_value(t), msg);
+        if (JSDRV_LOG_ENABLED(JSDRV_LOG_LEVEL_DEBUG1)) {
+            char buf[32];
+            jsdrv_union_value_to_str(msg->payload.query.value, buf, sizeof(buf), 1);
+            JSDRV_LOGD1("query %s => %s", topic, buf);
+        }
     }
     return msg->value.value.i32;
 }
 
+struct snapshot_s {
+    char * buf;
+    uint32_t capacity;  // excluding the terminator
+    uint32_t length;    // the full document length, may exceed capacity
+    uint8_t flags;
+    bool first;
+};
+
+static void snapshot_write(struct snapshot_s * s, const char * str, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        if (s->length < s->capacity) {
+            s->buf[s->length] = str[i];
+        }
+        ++s->length;
+    }
+}
+
+static void snapshot_write_cstr(struct snapshot_s * s, const char * str) {
+    snapshot_write(s, str, (uint32_t) strlen(str));
+}
+
+static void snapshot_write_str(struct snapshot_s * s, const char * str) {
+    char esc[8];
+    snapshot_write(s, "\"", 1);
+    for (; *str; ++str) {
+        uint8_t ch = (uint8_t) *str;
+        switch (ch) {
+            case '"': snapshot_write(s, "\\\"", 2); break;
+            case '\\': snapshot_write(s, "\\\\", 2); break;
+            case '\n': snapshot_write(s, "\\n", 2); break;
+            case '\r': snapshot_write(s, "\\r", 2); break;
+            case '\t': snapshot_write(s, "\\t", 2); break;
+            default:
+                if (ch < 0x20) {
+                    snprintf(esc, sizeof(esc), "\\u%04x", (unsigned int) ch);
+                    snapshot_write_cstr(s, esc);
+                } else {
+                    snapshot_write(s, str, 1);
+                }
+                break;
+        }
+    }
+    snapshot_write(s, "\"", 1);
+}
+
+static bool snapshot_value_to_json(const struct jsdrv_union_s * value, char * buf, size_t buf_size) {
+    double f64;
+    switch (value->type) {
+        case JSDRV_UNION_NULL: snprintf(buf, buf_size, "null"); return true;
+        case JSDRV_UNION_F32:  f64 = (double) value->value.f32; break;
+        case JSDRV_UNION_F64:  f64 = value->value.f64; break;
+        case JSDRV_UNION_U8:   snprintf(buf, buf_size, "%u", (unsigned int) value->value.u8); return true;
+        case JSDRV_UNION_U16:  snprintf(buf, buf_size, "%u", (unsigned int) value->value.u16); return true;
+        case JSDRV_UNION_U32:  snprintf(buf, buf_size, "%lu", (unsigned long) value->value.u32); return true;
+        case JSDRV_UNION_U64:  snprintf(buf, buf_size, "%llu", (unsigned long long) value->value.u64); return true;
+        case JSDRV_UNION_I8:   snprintf(buf, buf_size, "%d", (int) value->value.i8); return true;
+        case JSDRV_UNION_I16:  snprintf(buf, buf_size, "%d", (int) value->value.i16); return true;
+        case JSDRV_UNION_I32:  snprintf(buf, buf_size, "%ld", (long) value->value.i32); return true;
+        case JSDRV_UNION_I64:  snprintf(buf, buf_size, "%lld", (long long) value->value.i64); return true;
+        default: return false;  // BIN and reserved types have no JSON representation
+    }
+    if (isfinite(f64)) {
+        snprintf(buf, buf_size, "%.17g", f64);
+    } else {
+        snprintf(buf, buf_size, "null");
+    }
+    return true;
+}
+
+static void snapshot_entry(struct snapshot_s * s, const char * topic, const char * suffix,
+                           const struct jsdrv_union_s * value) {
+    char num[32];
+    bool is_str = (value->type == JSDRV_UNION_STR);
+    bool is_json = (value->type == JSDRV_UNION_JSON);
+    if (!is_str && !is_json && !snapshot_value_to_json(value, num, sizeof(num))) {
+        return;  // omit
+    }
+    snapshot_write_cstr(s, s->first ? "\"" : ",\"");
+    s->first = false;
+    snapshot_write_cstr(s, topic);
+    snapshot_write_cstr(s, suffix);
+    snapshot_write(s, "\":", 2);
+    if (is_str) {
+        snapshot_write_str(s, value->value.str);
+    } else if (is_json) {
+        snapshot_write_cstr(s, value->value.str);
+    } else {
+        snapshot_write_cstr(s, num);
+    }
+}
+
+static void snapshot_traverse(struct snapshot_s * s, struct topic_s * topic) {
+    if ((s->flags & JSDRV_SFLAG_METADATA_RSP) && topic->meta) {
+        snapshot_entry(s, topic->topic, "$", &jsdrv_union_json(topic->meta->json));
+    }
+    if ((s->flags & JSDRV_SFLAG_PUB) && topic_has_value(topic)) {
+        snapshot_entry(s, topic->topic, "", &topic->value);
+    }
+    struct jsdrv_list_s * item;
+    jsdrv_list_foreach(&topic->children, item) {
+        snapshot_traverse(s, JSDRV_CONTAINER_OF(item, struct topic_s, item));
+    }
+}
+
+static int32_t snapshot(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg) {
+    struct jsdrv_union_s * value = msg->payload.query.value;
+    if (!value || !jsdrv_union_is_type_ptr(value) || !value->value.str || !value->size) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct topic_s * t = topic_find(self, msg->payload.query.topic, false);
+    if (!t) {
+        return JSDRV_ERROR_NOT_FOUND;
+    }
+    struct snapshot_s s = {
+        .buf = (char *) value->value.str,
+        .capacity = value->size - 1,
+        .length = 0,
+        .flags = msg->payload.query.flags,
+        .first = true,
+    };
+    snapshot_write(&s, "{", 1);
+    snapshot_traverse(&s, t);
+    snapshot_write(&s, "}", 1);
+    uint32_t sz = s.length + 1;
+    if (s.length > s.capacity) {
+        value->size = sz;  // the required size
+        return JSDRV_ERROR_TOO_SMALL;
+    }
+    s.buf[s.length] = 0;
+    value->type = JSDRV_UNION_JSON;
+    value->size = sz;
+    JSDRV_LOGD1("snapshot %s => %lu bytes", msg->payload.query.topic, (unsigned long) sz);
+    return 0;
+}
+
 static int32_t subscribe(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg) {
     JSDRV_ASSERT(msg->value.type == JSDRV_UNION_BIN);
     JSDRV_ASSERT(msg->value.value.bin == msg->payload.bin);
-    struct topic_s * t = topic_find(self, msg->payload.sub.topic, true);
+    bool is_wildcard = jsdrv_topic_is_wildcard(msg->payload.sub.topic);
+    struct topic_s * t = is_wildcard ? self->root_topic : topic_find(self, msg->payload.sub.topic, true);
     if (!t) {
         JSDRV_LOGE("could not find/create subscribe topic %s", msg->payload.sub.topic);
         return JSDRV_ERROR_NOT_FOUND;
@@ -432,11 +1066,31 @@ static int32_t subscribe(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg
 
     struct subscriber_s * sub = subscriber_alloc(self);
     sub->sub = msg->payload.sub.subscriber;
-    jsdrv_list_add_tail(&t->subscribers, &sub->item);
+    sub->sub.queue = NULL;
+    if ((sub->sub.flags & JSDRV_SFLAG_QUEUED) && !sub->sub.is_internal) {
+        if (self->dispatch && self->dispatch->queue_open) {
+            sub->sub.queue = self->dispatch->queue_open(self->dispatch->user_data, msg->payload.sub.topic, &sub->sub);
+        }
+        if (!sub->sub.queue) {
+            JSDRV_LOGW("subscribe %s: queue not available, deliver directly", msg->payload.sub.topic);
+        }
+    }
+    if (is_wildcard) {
+        jsdrv_cstr_copy(sub->pattern, msg->payload.sub.topic, sizeof(sub->pattern));
+        jsdrv_list_add_tail(&self->wildcards, &sub->item);
+    } else {
+        jsdrv_list_add_tail(&t->subscribers, &sub->item);
+    }
+    owner_add(self, sub);
+    ++self->subscriber_gen;
 
     if (sub->sub.flags & JSDRV_SFLAG_RETAIN) {
-        devices_on_sub(self, msg);
-        subscribe_traverse(t, msg->payload.sub.topic, sub);
+        if (is_wildcard) {
+            wildcard_traverse(self, t, sub);
+        } else {
+            devices_on_sub(self, msg, sub);
+            subscribe_traverse(self, t, msg->payload.sub.topic, sub);
+        }
     }
     return 0;
 }
@@ -448,9 +1102,29 @@ static bool is_same_subscriber(const struct jsdrv_pubsub_subscriber_s * a, const
             (a->user_data == b->user_data));
 }
 
+static int32_t unsubscribe_wildcard(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg) {
+    struct jsdrv_list_s * item;
+    struct subscriber_s * s;
+    int count = 0;
+    JSDRV_LOGD2("unsubscribe %s", msg->payload.sub.topic);
+    jsdrv_list_foreach(&self->wildcards, item) {
+        s = JSDRV_CONTAINER_OF(item, struct subscriber_s, item);
+        if ((0 == strcmp(s->pattern, msg->payload.sub.topic))
+                && is_same_subscriber(&s->sub, &msg->payload.sub.subscriber)) {
+            subscriber_remove(self, s);
+            ++count;
+        }
+    }
+    ++self->subscriber_gen;
+    return count ? 0 : JSDRV_ERROR_NOT_FOUND;
+}
+
 static int32_t unsubscribe(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg) {
     struct jsdrv_list_s * item;
     struct subscriber_s * s;
+    if (jsdrv_topic_is_wildcard(msg->payload.sub.topic)) {
+        return unsubscribe_wildcard(self, msg);
+    }
     struct topic_s * t = topic_find(self, msg->payload.sub.topic, true);
     int count = 0;
     if (!t) {
@@ -462,98 +1136,108 @@ static int32_t unsubscribe(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * m
     jsdrv_list_foreach(&t->subscribers, item) {
         s = JSDRV_CONTAINER_OF(item, struct subscriber_s, item);
         if (is_same_subscriber(&s->sub, &msg->payload.sub.subscriber)) {
-            jsdrv_list_remove(item);
-            subscriber_free(self, s);
+            subscriber_remove(self, s);
             ++count;
         }
     }
+    ++self->subscriber_gen;
     return count ? 0 : JSDRV_ERROR_NOT_FOUND;
 }
 
-static void unsubscribe_traverse(struct jsdrv_pubsub_s * self, struct topic_s * topic, struct jsdrvp_msg_s * msg) {
-    struct jsdrv_list_s * item;
-    struct topic_s * subtopic;
-    struct subscriber_s * s;
-    jsdrv_list_foreach(&topic->subscribers, item) {
-        s = JSDRV_CONTAINER_OF(item, struct subscriber_s, item);
-        if (is_same_subscriber(&s->sub, &msg->payload.sub.subscriber)) {
-            jsdrv_list_remove(item);
-            subscriber_free(self, s);
+/*
+ * Remove all subscriptions, including wildcards, for the subscriber.
+ * The owner lists its subscriptions, so the cost scales with the
+ * subscriber's subscriptions rather than the topic tree.
+ */
+static void unsubscribe_from_all(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg) {
+    const struct jsdrv_pubsub_subscriber_s * key = &msg->payload.sub.subscriber;
+    struct owner_s * o = key->void_fn ? *owner_slot(self, key) : NULL;
+    while (o) {
+        struct jsdrv_list_s * item = jsdrv_list_peek_head(&o->subscribers);
+        if (item->next == &o->subscribers) {
+            o = NULL;  // last subscriber, subscriber_remove() frees the owner
         }
+        subscriber_remove(self, JSDRV_CONTAINER_OF(item, struct subscriber_s, owner_item));
     }
-
-    jsdrv_list_foreach(&topic->children, item) {
-        subtopic = JSDRV_CONTAINER_OF(item, struct topic_s, item);
-        unsubscribe_traverse(self, subtopic, msg);
-    }
+    ++self->subscriber_gen;
 }
 
-static void unsubscribe_from_all(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg) {
-    unsubscribe_traverse(self, self->root_topic, msg);
+static inline bool subscriber_wants(const struct subscriber_s * s, uint8_t flags) {
+    switch (flags) {
+        case JSDRV_SFLAG_RETURN_CODE: return 0 != (s->sub.flags & JSDRV_SFLAG_RETURN_CODE);
+        case JSDRV_SFLAG_METADATA_RSP: return 0 != (s->sub.flags & JSDRV_SFLAG_METADATA_RSP);
+        default: return 0 != (s->sub.flags & JSDRV_SFLAG_PUB);
+    }
 }
 
-static uint8_t publish(struct topic_s * topic, struct jsdrvp_msg_s * msg, uint8_t flags) {
+static uint8_t publish(struct jsdrv_pubsub_s * self, struct topic_s * topic, struct jsdrvp_msg_s * msg, uint8_t flags) {
     uint8_t status = 0;
+    uint8_t rv;
     struct jsdrv_list_s * item;
     struct subscriber_s * s;
+    const char * topic_str = topic->topic;
     while (topic) {
         jsdrv_list_foreach(&topic->subscribers, item) {
             s = JSDRV_CONTAINER_OF(item, struct subscriber_s, item);
-            if (is_same_subscriber(&s->sub, &msg->extra.frontend.subscriber)) {
+            if (is_same_subscriber(&s->sub, &msg->extra.frontend.subscriber) || !subscriber_wants(s, flags)) {
                 continue;
             }
-            switch (flags) {
-                case JSDRV_SFLAG_RETURN_CODE:
-                    if (!(s->sub.flags & JSDRV_SFLAG_RETURN_CODE)) {
-                        continue;
-                    }
-                    break;
-                case JSDRV_SFLAG_METADATA_RSP:
-                    if (!(s->sub.flags & JSDRV_SFLAG_METADATA_RSP)) {
-                        continue;
-                    }
-                    break;
-                default:
-                    if (!(s->sub.flags & JSDRV_SFLAG_PUB)) {
-                        continue;
-                    }
-                    break;
-            }
-            uint8_t rv = subscriber_call(&s->sub, msg);
+            rv = subscriber_call(self, &s->sub, msg);
             if (!status && rv) {
                 status = rv;
             }
         }
         topic = topic->parent;
     }
+    jsdrv_list_foreach(&self->wildcards, item) {
+        s = JSDRV_CONTAINER_OF(item, struct subscriber_s, item);
+        if (is_same_subscriber(&s->sub, &msg->extra.frontend.subscriber) || !subscriber_wants(s, flags)
+                || !jsdrv_topic_match(s->pattern, topic_str)) {
+            continue;
+        }
+        rv = subscriber_call(self, &s->sub, msg);
+        if (!status && rv) {
+            status = rv;
+        }
+    }
     return status;
 }
 
+// True when jsdrv_meta_schema_value() passes scalar, non-string values unmodified.
+static bool is_schema_direct(const struct jsdrv_meta_schema_s * schema) {
+    return (0 == schema->status)
+        && (0 == (schema->flags & (JSDRV_META_SCHEMA_FLAG_BOOL | JSDRV_META_SCHEMA_FLAG_OPTIONS)));
+}
+
 static void publish_meta(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg) {
+    if (!JSDRV_META_ENABLE) {
+        jsdrvp_msg_free(self->context, msg);  // neither intern nor create the topic
+        return;
+    }
     char topic[JSDRV_TOPIC_LENGTH_MAX];
     jsdrv_cstr_copy(topic, msg->topic, sizeof(topic));
     topic[strlen(topic) - 1] = 0;
     struct topic_s * t = topic_find(self, topic, true);
     if (t) {
-        if (t->meta) {
-            jsdrvp_msg_free(self->context, t->meta);
-        }
+        const struct jsdrv_meta_entry_s * meta = jsdrv_meta_store_intern(self->meta_store, msg->value.value.str);
+        jsdrv_meta_store_release(self->meta_store, t->meta);  // after intern, keeps unchanged metadata compiled
+        t->meta = meta;
+        jsdrv_value_cache_direct_set(self->value_cache, t->topic, t->hash, is_schema_direct(&meta->schema));
         if (!msg->value.size) {
-            msg->value.size = (uint32_t) (strlen(msg->value.value.str) + 1);
+            msg->value.size = meta->size;
         }
-        t->meta = msg;
-        publish(t, msg, JSDRV_SFLAG_METADATA_RSP);
-    } else {
-        jsdrvp_msg_free(self->context, msg);
+        publish(self, t, msg, JSDRV_SFLAG_METADATA_RSP);
     }
+    jsdrvp_msg_free(self->context, msg);
 }
 
 static void local_return_code(struct jsdrv_pubsub_s * self, const char * topic, int32_t return_code) {
     struct topic_s * t = topic_find(self, topic, false);
     if (t) {
-        struct jsdrvp_msg_s * rsp = jsdrvp_msg_alloc_value(self->context, "", &jsdrv_union_i32(return_code));
+        struct jsdrvp_msg_s * rsp = jsdrvp_msg_alloc_small(self->context);
+        rsp->value = jsdrv_union_i32(return_code);
         jsdrv_cstr_join(rsp->topic, topic, "#", sizeof(rsp->topic));
-        publish(t, rsp, JSDRV_SFLAG_RETURN_CODE);
+        publish(self, t, rsp, JSDRV_SFLAG_RETURN_CODE);
         jsdrvp_msg_free(self->context, rsp);
     } else {
         JSDRV_LOGW("local_return_code failed on %s", topic);
@@ -562,10 +1246,10 @@ static void local_return_code(struct jsdrv_pubsub_s * self, const char * topic,
 
 static void publish_normal(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg) {
     uint8_t status = 0;
-    struct topic_s * t = topic_find(self, msg->topic, true);
+    struct topic_s * t = topic_find_hash(self, msg->topic, msg->topic_hash, true);
     if (t) {
         if (t->meta) {
-            status = jsdrv_meta_value(t->meta->value.value.str, &msg->value);
+            status = jsdrv_meta_schema_value(&t->meta->schema, &msg->value);
             if (status) {
                 char buf[32];
                 jsdrv_union_value_to_str(&msg->value, buf, (uint32_t) sizeof(buf), 1);
@@ -575,26 +1259,24 @@ static void publish_normal(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * m
                 return;
             }
         }
-        if (t->value && jsdrv_union_eq(&t->value->value, &msg->value)) {
+        if (topic_has_value(t) && jsdrv_union_eq_bounded(&t->value, &msg->value, JSDRV_PAYLOAD_LENGTH_MAX)) {
             JSDRV_LOGD1("pubsub dedup %s", msg->topic);
             local_return_code(self, msg->topic, 0);
             jsdrvp_msg_free(self->context, msg);
             return;
         }
-        if (t->value) {
-            jsdrvp_msg_free(self->context, t->value);  // free old value
-            t->value = NULL;
-        }
+        bool owned = false;
         if ((msg->value.flags & JSDRV_UNION_FLAG_RETAIN) && (t->name[0] != '!')) {
-            t->value = msg;
+            owned = topic_value_set(self, t, msg);
         } else {
-            t->value = NULL;
+            topic_value_clear(self, t);
         }
-        status = publish(t, msg, 0);
+        jsdrv_value_cache_set(self->value_cache, t->topic, t->hash, topic_value(t));
+        status = publish(self, t, msg, 0);
         if (status) {
             local_return_code(self, msg->topic, status);
         }
-        if (!t->value) {
+        if (!owned) {
             jsdrvp_msg_free(self->context, msg);
         }
     } else {
@@ -602,11 +1284,135 @@ static void publish_normal(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * m
     }
 }
 
+static void data_subs_update(struct jsdrv_pubsub_s * self, struct topic_s * topic) {
+    struct jsdrv_list_s * item;
+    struct subscriber_s * s;
+    uint32_t count = 0;
+    for (struct topic_s * t = topic; t; t = t->parent) {
+        jsdrv_list_foreach(&t->subscribers, item) {
+            s = JSDRV_CONTAINER_OF(item, struct subscriber_s, item);
+            if (s->sub.flags & JSDRV_SFLAG_PUB) {
+                ++count;
+            }
+        }
+    }
+    jsdrv_list_foreach(&self->wildcards, item) {
+        s = JSDRV_CONTAINER_OF(item, struct subscriber_s, item);
+        if ((s->sub.flags & JSDRV_SFLAG_PUB) && jsdrv_topic_match(s->pattern, topic->topic)) {
+            ++count;
+        }
+    }
+    if (count > topic->data_subs_size) {
+        if (topic->data_subs) {
+            jsdrv_free(topic->data_subs);
+        }
+        topic->data_subs = jsdrv_alloc_cat(count * sizeof(struct jsdrv_pubsub_subscriber_s), JSDRV_ALLOC_CAT_PUBSUB);
+        topic->data_subs_size = count;
+    }
+    // same order as publish(): this topic first, then ancestors, then wildcards
+    count = 0;
+    for (struct topic_s * t = topic; t; t = t->parent) {
+        jsdrv_list_foreach(&t->subscribers, item) {
+            s = JSDRV_CONTAINER_OF(item, struct subscriber_s, item);
+            if (s->sub.flags & JSDRV_SFLAG_PUB) {
+                topic->data_subs[count++] = s->sub;
+            }
+        }
+    }
+    jsdrv_list_foreach(&self->wildcards, item) {
+        s = JSDRV_CONTAINER_OF(item, struct subscriber_s, item);
+        if ((s->sub.flags & JSDRV_SFLAG_PUB) && jsdrv_topic_match(s->pattern, topic->topic)) {
+            topic->data_subs[count++] = s->sub;
+        }
+    }
+    topic->data_subs_count = count;
+    topic->data_subs_gen = self->subscriber_gen;
+    if (!topic->shard) {
+        topic->shard = jsdrv_pubsub_shard_hash(topic->topic);
+    }
+}
+
+static inline bool is_data_msg(const struct jsdrvp_msg_s * msg) {
+    return (msg->value.type == JSDRV_UNION_BIN)
+        && ((msg->value.app == JSDRV_PAYLOAD_TYPE_STREAM) || (msg->value.app == JSDRV_PAYLOAD_TYPE_STREAM_EVENT)
+            || (msg->value.app == JSDRV_PAYLOAD_TYPE_STATISTICS));
+}
+
+/**
+ * @brief Publish stream and statistics data.
+ *
+ * @param self The pubsub instance.
+ * @param msg The data message.
+ *
+ * The data plane skips metadata validation and value de-duplication,
+ * which is a full compare for large binary payloads.  Retained values,
+ * such as statistics, are still replaced by pointer.
+ */
+static void publish_data(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg) {
+    uint8_t status = 0;
+    JSDRV_PERF_ADD(JSDRV_PERF_DATA_MSG, 1);
+    struct topic_s * t = topic_find_hash(self, msg->topic, msg->topic_hash, true);
+    if (!t) {
+        jsdrvp_msg_free(self->context, msg);
+        return;
+    }
+    if (t->data_subs_gen != self->subscriber_gen) {
+        data_subs_update(self, t);
+    }
+    jsdrv_latency_dispatch(msg);
+    topic_value_clear(self, t);
+    if ((msg->value.flags & JSDRV_UNION_FLAG_RETAIN) && (t->name[0] != '!')) {
+        t->value_msg = msg;  // zero copy, see topic_value_set()
+        t->value = msg->value;
+    }
+    const struct jsdrv_pubsub_dispatch_s * dispatch = self->dispatch;
+    struct jsdrv_pubsub_subscriber_s external[JSDRV_PUBSUB_DISPATCH_SUBSCRIBERS_MAX];
+    uint32_t external_count = 0;
+    for (uint32_t idx = 0; idx < t->data_subs_count; ++idx) {
+        struct jsdrv_pubsub_subscriber_s * s = &t->data_subs[idx];
+        if (is_same_subscriber(s, &msg->extra.frontend.subscriber)) {
+            continue;
+        }
+        if (dispatch && dispatch->data && !s->is_internal && !s->is_batch && !s->queue) {
+            external[external_count++] = *s;
+            if (external_count >= JSDRV_PUBSUB_DISPATCH_SUBSCRIBERS_MAX) {
+                dispatch->data(dispatch->user_data, msg, t->shard, external, external_count);
+                external_count = 0;
+            }
+            continue;
+        }
+        uint8_t rv = subscriber_call(self, s, msg);
+        if (!status && rv) {
+            status = rv;
+        }
+    }
+    if (external_count) {  // implies dispatch->data
+        dispatch->data(dispatch->user_data, msg, t->shard, external, external_count);
+    }
+    if (status) {
+        local_return_code(self, msg->topic, status);
+    }
+    if (!t->value_msg) {
+        jsdrvp_msg_free(self->context, msg);
+    }
+}
+
+static bool is_unsubscribe_external(struct jsdrvp_msg_s * msg) {
+    return ((0 == strcmp(JSDRV_PUBSUB_UNSUBSCRIBE, msg->topic))
+            || (0 == strcmp(JSDRV_PUBSUB_UNSUBSCRIBE_ALL, msg->topic)))
+        && !msg->payload.sub.subscriber.is_internal;
+}
+
 static void process_msg(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg) {
     int32_t rc = 0;
     if (msg->topic[0] == JSDRV_PUBSUB_COMMAND_PREFIX) {
-        if (0 == strcmp(JSDRV_PUBSUB_QUERY, msg->topic)) {
+        if (jsdrv_cstr_ends_with(msg->topic, "#")) {
+            publish_return_code(self, msg);  // completed dispatch barrier
+            return;
+        } else if (0 == strcmp(JSDRV_PUBSUB_QUERY, msg->topic)) {
             rc = query(self, msg);
+        } else if (0 == strcmp(JSDRV_PUBSUB_SNAPSHOT, msg->topic)) {
+            rc = snapshot(self, msg);
         } else if (0 == strcmp(JSDRV_PUBSUB_SUBSCRIBE, msg->topic)) {
             rc = subscribe(self, msg);
         } else if (0 == strcmp(JSDRV_PUBSUB_UNSUBSCRIBE, msg->topic)) {
@@ -617,11 +1423,23 @@ static void process_msg(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg)
             JSDRV_LOGW("unsupported command %s", msg->topic);
             rc = JSDRV_ERROR_NOT_SUPPORTED;
         }
-        if (msg->source) {
+        batch_flush_all(self);  // deliver retained values and prior messages before the return code
+        if (self->dispatch && is_unsubscribe_external(msg)
+                && (self->dispatch->data || self->queue_closing_count)) {
+            struct jsdrvp_msg_s * rsp = NULL;
+            if (msg->source) {
+                rsp = jsdrvp_msg_alloc_value(self->context, "", &jsdrv_union_i32(rc));
+                jsdrv_cstr_join(rsp->topic, msg->topic, "#", sizeof(rsp->topic));
+            }
+            self->dispatch->barrier(self->dispatch->user_data, rsp, self->queue_closing, self->queue_closing_count);
+            self->queue_closing_count = 0;
+        } else if (msg->source) {
             JSDRV_LOGD1("publish_return_code_i32(\"%s\", %ld)", msg->topic, rc);
             publish_return_code_i32(self, msg->topic, rc);
         }
         jsdrvp_msg_free(self->context, msg);
+    } else if (is_data_msg(msg) && msg->topic[0]) {
+        publish_data(self, msg);  // data topics never end with '$' or '#'
     } else {  // publish to topic
         size_t topic_sz = strlen(msg->topic);  // excluding terminator
         if (0 == topic_sz) {
@@ -640,17 +1458,33 @@ static void process_msg(struct jsdrv_pubsub_s * self, struct jsdrvp_msg_s * msg)
     }
 }
 
+int32_t jsdrv_pubsub_query_cached(struct jsdrv_pubsub_s * self, const char * topic, struct jsdrv_union_s * value) {
+    return jsdrv_value_cache_get(self->value_cache, topic, value);
+}
+
+int32_t jsdrv_pubsub_query_direct(struct jsdrv_pubsub_s * self, const char * topic, struct jsdrv_union_s * value) {
+    return jsdrv_value_cache_direct_get(self->value_cache, topic, value);
+}
+
 void jsdrv_pubsub_process(struct jsdrv_pubsub_s * self) {
     while (!jsdrv_list_is_empty(&self->msg_pend)) {
         struct jsdrv_list_s * item = jsdrv_list_remove_head(&self->msg_pend);
         struct jsdrvp_msg_s * msg = JSDRV_CONTAINER_OF(item, struct jsdrvp_msg_s, item);
-        if (jsdrv_cstr_ends_with(msg->topic, "!data")) {
+        if (!JSDRV_LOG_ENABLED(JSDRV_LOG_LEVEL_DEBUG1)) {
+            // skip formatting
+        } else if (jsdrv_cstr_ends_with(msg->topic, "!data")) {
             JSDRV_LOGD3("jsdrv_pubsub_process %s", msg->topic);
         } else {
             char buf[32];
             jsdrv_union_value_to_str(&msg->value, buf, sizeof(buf), 1);
             JSDRV_LOGD1("jsdrv_pubsub_process %s => %s", msg->topic, buf);
         }
+        JSDRV_PERF_TIME_START(t_start);
+        JSDRV_TRACE_START(t_trace);
         process_msg(self, msg);
+        JSDRV_TRACE_END("publish", t_trace, 0);
+        JSDRV_PERF_TIME_END(JSDRV_PERF_PUBSUB_TIME, t_start);
+        JSDRV_PERF_ADD(JSDRV_PERF_PUBSUB_MSG, 1);
     }
+    batch_flush_all(self);
 }
\ No newline at end of file
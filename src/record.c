@@ -0,0 +1,432 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/record.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/dbc.h"
+#include "jsdrv_prv/file_writer.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/time.h"
+#include "jsdrv/topic.h"
+#include "tinyprintf.h"
+#include <inttypes.h>
+#include <string.h>
+
+
+#define ALIGN8(x)               (((x) + 7U) & ~7U)
+#define CHUNK_SIZE(payload)     (sizeof(struct jsdrv_record_chunk_s) + ALIGN8(payload))
+JSDRV_STATIC_ASSERT(0 == (sizeof(struct jsdrv_record_header_s) & 7), header_size);
+JSDRV_STATIC_ASSERT(8 == sizeof(struct jsdrv_record_chunk_s), chunk_size);
+JSDRV_STATIC_ASSERT(CHUNK_SIZE(sizeof(struct jsdrv_stream_signal_s)) <= JSDRV_RECORD_BUFFER_SIZE, buffer_size);
+JSDRV_STATIC_ASSERT(JSDRV_RECORD_SIGNALS_MAX <= 32, signal_mask);
+
+
+struct jsdrv_record_s {
+    struct jsdrv_file_writer_s * writer;
+    uint32_t signal_mask;
+    uint64_t size;          // the bytes appended
+    uint64_t msg_count;
+    uint64_t drop_count;
+};
+
+static int32_t chunk_write(struct jsdrv_record_s * self, uint8_t type, uint8_t signal_idx,
+                           const void * payload, uint32_t payload_size) {
+    uint32_t sz = CHUNK_SIZE(payload_size);
+    uint8_t * p = jsdrv_file_writer_reserve(self->writer, sz);
+    if (NULL == p) {
+        return JSDRV_ERROR_FULL;
+    }
+    self->size += sz;
+    struct jsdrv_record_chunk_s * chunk = (struct jsdrv_record_chunk_s *) p;
+    chunk->type = type;
+    chunk->signal_idx = signal_idx;
+    chunk->rsv = 0;
+    chunk->payload_size = payload_size;
+    p += sizeof(*chunk);
+    memcpy(p, payload, payload_size);
+    memset(p + payload_size, 0, ALIGN8(payload_size) - payload_size);
+    return 0;
+}
+
+struct jsdrv_record_s * jsdrv_record_open(const char * path, uint32_t flags) {
+    struct jsdrv_file_writer_config_s config = {
+        .buffer_size = JSDRV_RECORD_BUFFER_SIZE,
+        .buffer_count = JSDRV_RECORD_BUFFER_COUNT,
+        .flags = ((flags & JSDRV_RECORD_FLAG_DIRECT) ? JSDRV_FILE_WRITER_FLAG_DIRECT : 0)
+                | ((flags & JSDRV_RECORD_FLAG_URING) ? JSDRV_FILE_WRITER_FLAG_URING : 0),
+        .sync = JSDRV_FILE_WRITER_SYNC_NONE,
+        .sync_interval_ms = 0,
+        .preallocate = 0,
+    };
+    struct jsdrv_file_writer_s * writer = jsdrv_file_writer_open(path, &config);
+    if (NULL == writer) {
+        return NULL;
+    }
+    struct jsdrv_record_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_record_s));
+    self->writer = writer;
+    struct jsdrv_record_header_s * hdr = (struct jsdrv_record_header_s *) jsdrv_file_writer_reserve(writer, sizeof(*hdr));
+    memcpy(hdr->magic, JSDRV_RECORD_MAGIC, sizeof(hdr->magic));
+    hdr->version = JSDRV_RECORD_VERSION;
+    hdr->header_size = sizeof(*hdr);
+    hdr->utc = jsdrv_time_utc();
+    self->size = sizeof(*hdr);
+    JSDRV_LOGI("record open %s", path);
+    return self;
+}
+
+int32_t jsdrv_record_signal(struct jsdrv_record_s * self, uint8_t signal_idx, const char * topic) {
+    if ((signal_idx >= JSDRV_RECORD_SIGNALS_MAX) || (NULL == topic)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    uint32_t sz = (uint32_t) strlen(topic) + 1;
+    if (sz > JSDRV_TOPIC_LENGTH_MAX) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    JSDRV_RETURN_ON_ERROR(chunk_write(self, JSDRV_RECORD_CHUNK_SIGNAL, signal_idx, topic, sz));
+    self->signal_mask |= (1U << signal_idx);
+    return 0;
+}
+
+int32_t jsdrv_record_append(struct jsdrv_record_s * self, uint8_t signal_idx,
+                            const struct jsdrv_stream_signal_s * signal, uint32_t size) {
+    struct jsdrv_file_writer_status_s status;
+    if ((signal_idx >= JSDRV_RECORD_SIGNALS_MAX) || (0 == (self->signal_mask & (1U << signal_idx)))
+            || (size < JSDRV_STREAM_HEADER_SIZE) || (size > sizeof(*signal))) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (chunk_write(self, JSDRV_RECORD_CHUNK_DATA, signal_idx, signal, size)) {
+        jsdrv_file_writer_status(self->writer, &status);
+        return status.error ? status.error : JSDRV_ERROR_FULL;
+    }
+    ++self->msg_count;
+    return 0;
+}
+
+int32_t jsdrv_record_write(struct jsdrv_record_s * self, uint8_t signal_idx,
+                           const struct jsdrv_stream_signal_s * signal, uint32_t size) {
+    int32_t rc = jsdrv_record_append(self, signal_idx, signal, size);
+    if ((JSDRV_ERROR_PARAMETER_INVALID != rc) && rc) {
+        ++self->drop_count;
+    }
+    return rc;
+}
+
+void jsdrv_record_status(struct jsdrv_record_s * self, struct jsdrv_record_status_s * status) {
+    struct jsdrv_file_writer_status_s w;
+    jsdrv_file_writer_status(self->writer, &w);
+    status->msg_count = self->msg_count;
+    status->drop_count = self->drop_count;
+    status->bytes_written = w.bytes_written;
+}
+
+int32_t jsdrv_record_close(struct jsdrv_record_s * self) {
+    if (NULL == self) {
+        return 0;
+    }
+    struct jsdrv_record_status_s end;
+    end.msg_count = self->msg_count;
+    end.drop_count = self->drop_count;
+    end.bytes_written = self->size;
+    while (chunk_write(self, JSDRV_RECORD_CHUNK_END, 0, &end, sizeof(end))) {
+        jsdrv_thread_sleep_ms(1);  // closing may block for the writer
+    }
+    int32_t rc = jsdrv_file_writer_close(self->writer);
+    JSDRV_LOGI("record close: %" PRIu64 " messages, %" PRIu64 " dropped, %" PRIu64 " bytes, rc=%" PRId32,
+               self->msg_count, self->drop_count, self->size, rc);
+    jsdrv_free(self);
+    return rc;
+}
+
+
+// -- Driver service --
+
+static const char * signals_meta = "{"
+    "\"dtype\": \"str\","
+    "\"brief\": \"The comma-separated stream data topics to record.\","
+    "\"detail\": \"Set before r/NNN/!open.  The signal index is the position in this list.\""
+"}";
+
+static const char * direct_meta = "{"
+    "\"dtype\": \"bool\","
+    "\"brief\": \"Request unbuffered writes that bypass the OS cache.\","
+    "\"default\": 0"
+"}";
+
+static const char * uring_meta = "{"
+    "\"dtype\": \"bool\","
+    "\"brief\": \"Request batched io_uring writes on Linux.\","
+    "\"detail\": \"Uses normal writes when io_uring is unavailable.\","
+    "\"default\": 0"
+"}";
+
+static const char * action_open_meta = "{"
+    "\"dtype\": \"str\","
+    "\"brief\": \"Start recording the signals to this file path.\""
+"}";
+
+static const char * action_close_meta = "{"
+    "\"dtype\": \"u32\","
+    "\"brief\": \"Stop recording and close the file.\""
+"}";
+
+struct record_inst_s;
+struct jsdrv_record_svc_s;
+
+struct record_signal_s {
+    struct record_inst_s * inst;
+    uint8_t idx;
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+};
+
+struct record_inst_s {
+    struct jsdrv_record_svc_s * parent;
+    char prefix[8];  // "r/NNN/"
+    bool direct;
+    bool uring;
+    uint8_t signal_count;
+    struct record_signal_s signals[JSDRV_RECORD_SIGNALS_MAX];
+    struct jsdrv_record_s * record;
+};
+
+struct jsdrv_record_svc_s {
+    struct jsdrv_context_s * context;
+    struct record_inst_s inst[JSDRV_RECORD_INSTANCES_MAX];
+};
+
+static void inst_topic(struct record_inst_s * inst, const char * name, char * topic) {
+    jsdrv_cstr_copy(topic, inst->prefix, JSDRV_TOPIC_LENGTH_MAX);
+    jsdrv_cstr_join(topic, topic, name, JSDRV_TOPIC_LENGTH_MAX);
+}
+
+static void send_to_frontend(struct jsdrv_record_svc_s * self, const char * topic, const struct jsdrv_union_s * value) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, topic, value);
+    jsdrvp_backend_send(self->context, m);
+}
+
+static int32_t subscribe(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
+                         jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
+    jsdrv_cstr_copy(m->topic, JSDRV_PUBSUB_SUBSCRIBE, sizeof(m->topic));
+    m->value.type = JSDRV_UNION_BIN;
+    m->value.value.bin = m->payload.bin;
+    m->value.app = JSDRV_PAYLOAD_TYPE_SUB;
+    jsdrv_cstr_copy(m->payload.sub.topic, topic, sizeof(m->payload.sub.topic));
+    m->payload.sub.subscriber.internal_fn = cbk_fn;
+    m->payload.sub.subscriber.user_data = cbk_user_data;
+    m->payload.sub.subscriber.is_internal = 1;
+    m->payload.sub.subscriber.flags = flags;
+    jsdrvp_backend_send(context, m);
+    return 0;
+}
+
+static int32_t unsubscribe(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
+                           jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
+    jsdrv_cstr_copy(m->topic, JSDRV_PUBSUB_UNSUBSCRIBE, sizeof(m->topic));
+    m->value.type = JSDRV_UNION_BIN;
+    m->value.value.bin = m->payload.bin;
+    m->value.app = JSDRV_PAYLOAD_TYPE_SUB;
+    jsdrv_cstr_copy(m->payload.sub.topic, topic, sizeof(m->payload.sub.topic));
+    m->payload.sub.subscriber.internal_fn = cbk_fn;
+    m->payload.sub.subscriber.user_data = cbk_user_data;
+    m->payload.sub.subscriber.is_internal = 1;
+    m->payload.sub.subscriber.flags = flags;
+    jsdrvp_backend_send(context, m);
+    return 0;
+}
+
+static int32_t send_return_code_to_frontend(struct jsdrv_context_s * context, const char * topic, int32_t rc,
+        jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
+    struct jsdrvp_msg_s * m;
+    m = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_i32(rc));
+    tfp_snprintf(m->topic, sizeof(m->topic), "%s%c", topic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
+    m->extra.frontend.subscriber.internal_fn = cbk_fn;
+    m->extra.frontend.subscriber.user_data = cbk_user_data;
+    m->extra.frontend.subscriber.is_internal = 1;
+    jsdrvp_backend_send(context, m);
+    return rc;
+}
+
+static uint8_t _record_recv_data(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct record_signal_s * s = (struct record_signal_s *) user_data;
+    struct jsdrv_record_s * record = s->inst->record;
+    if ((NULL == record) || (JSDRV_UNION_BIN != msg->value.type) || (JSDRV_PAYLOAD_TYPE_STREAM != msg->value.app)) {
+        return 0;  // includes data in flight after close
+    }
+    const struct jsdrv_stream_signal_s * signal = (const struct jsdrv_stream_signal_s *) msg->value.value.bin;
+    jsdrv_record_write(record, s->idx, signal, msg->value.size);  // status counts drops
+    return 0;
+}
+
+static uint8_t _record_signals(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct record_inst_s * inst = (struct record_inst_s *) user_data;
+    if (JSDRV_UNION_STR != msg->value.type) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    } else if (NULL != inst->record) {
+        return JSDRV_ERROR_BUSY;
+    }
+    uint8_t count = 0;
+    const char * p = msg->value.value.str;
+    while (p && *p) {
+        const char * end = strchr(p, ',');
+        size_t sz = end ? (size_t) (end - p) : strlen(p);
+        if ((sz >= JSDRV_TOPIC_LENGTH_MAX) || (count >= JSDRV_RECORD_SIGNALS_MAX)) {
+            inst->signal_count = 0;
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+        if (sz) {
+            memcpy(inst->signals[count].topic, p, sz);
+            inst->signals[count].topic[sz] = 0;
+            ++count;
+        }
+        p = end ? (end + 1) : NULL;
+    }
+    inst->signal_count = count;
+    return 0;
+}
+
+static uint8_t _record_direct(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct record_inst_s * inst = (struct record_inst_s *) user_data;
+    bool direct = false;
+    if (jsdrv_union_to_bool(&msg->value, &direct)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    inst->direct = direct;
+    return 0;
+}
+
+static uint8_t _record_uring(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct record_inst_s * inst = (struct record_inst_s *) user_data;
+    bool uring = false;
+    if (jsdrv_union_to_bool(&msg->value, &uring)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    inst->uring = uring;
+    return 0;
+}
+
+static uint8_t _record_open(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct record_inst_s * inst = (struct record_inst_s *) user_data;
+    struct jsdrv_record_svc_s * self = inst->parent;
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    inst_topic(inst, "!open", topic);
+    const char * path = msg->value.value.str;
+    if ((JSDRV_UNION_STR != msg->value.type) || (NULL == path) || (0 == path[0]) || (0 == inst->signal_count)) {
+        return (uint8_t) send_return_code_to_frontend(self->context, topic, JSDRV_ERROR_PARAMETER_INVALID, _record_open, inst);
+    } else if (NULL != inst->record) {
+        return (uint8_t) send_return_code_to_frontend(self->context, topic, JSDRV_ERROR_BUSY, _record_open, inst);
+    }
+    uint32_t flags = (inst->direct ? JSDRV_RECORD_FLAG_DIRECT : 0) | (inst->uring ? JSDRV_RECORD_FLAG_URING : 0);
+    struct jsdrv_record_s * record = jsdrv_record_open(path, flags);
+    if (NULL == record) {
+        return (uint8_t) send_return_code_to_frontend(self->context, topic, JSDRV_ERROR_IO, _record_open, inst);
+    }
+    for (uint8_t k = 0; k < inst->signal_count; ++k) {
+        jsdrv_record_signal(record, k, inst->signals[k].topic);
+        subscribe(self->context, inst->signals[k].topic, JSDRV_SFLAG_PUB, _record_recv_data, &inst->signals[k]);
+    }
+    inst->record = record;
+    return (uint8_t) send_return_code_to_frontend(self->context, topic, 0, _record_open, inst);
+}
+
+static int32_t inst_close(struct jsdrv_record_svc_s * self, struct record_inst_s * inst) {
+    if (NULL == inst->record) {
+        return JSDRV_ERROR_CLOSED;
+    }
+    for (uint8_t k = 0; k < inst->signal_count; ++k) {
+        unsubscribe(self->context, inst->signals[k].topic, JSDRV_SFLAG_PUB, _record_recv_data, &inst->signals[k]);
+    }
+    struct jsdrv_record_s * record = inst->record;
+    inst->record = NULL;
+    return jsdrv_record_close(record);
+}
+
+static uint8_t _record_close(void * user_data, struct jsdrvp_msg_s * msg) {
+    (void) msg;
+    struct record_inst_s * inst = (struct record_inst_s *) user_data;
+    struct jsdrv_record_svc_s * self = inst->parent;
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    inst_topic(inst, "!close", topic);
+    return (uint8_t) send_return_code_to_frontend(self->context, topic, inst_close(self, inst), _record_close, inst);
+}
+
+struct record_topic_s {
+    const char * name;
+    jsdrv_pubsub_subscribe_fn fn;
+};
+
+static const struct record_topic_s topics_[] = {
+    {"signals", _record_signals},
+    {"direct", _record_direct},
+    {"uring", _record_uring},
+    {"!open", _record_open},
+    {"!close", _record_close},
+};
+
+int32_t jsdrv_record_initialize(struct jsdrv_context_s * context, struct jsdrv_record_svc_s ** instance) {
+    JSDRV_DBC_NOT_NULL(context);
+    JSDRV_DBC_NOT_NULL(instance);
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    const char * meta[] = {signals_meta, direct_meta, uring_meta, action_open_meta, action_close_meta};  // topics_ order
+    struct jsdrv_record_svc_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_record_svc_s));
+    self->context = context;
+    for (uint32_t i = 0; i < JSDRV_RECORD_INSTANCES_MAX; ++i) {
+        struct record_inst_s * inst = &self->inst[i];
+        inst->parent = self;
+        tfp_snprintf(inst->prefix, sizeof(inst->prefix), "r/%03u/", (unsigned int) (i + 1));
+        for (uint8_t k = 0; k < JSDRV_RECORD_SIGNALS_MAX; ++k) {
+            inst->signals[k].inst = inst;
+            inst->signals[k].idx = k;
+        }
+        for (uint32_t k = 0; k < JSDRV_ARRAY_SIZE(topics_); ++k) {
+            inst_topic(inst, topics_[k].name, topic);
+            jsdrv_cstr_join(topic, topic, "$", sizeof(topic));
+            send_to_frontend(self, topic, &jsdrv_union_cjson_r(meta[k]));
+        }
+        inst_topic(inst, "signals", topic);
+        send_to_frontend(self, topic, &jsdrv_union_cstr_r(""));
+        inst_topic(inst, "direct", topic);
+        send_to_frontend(self, topic, &jsdrv_union_u8_r(0));
+        inst_topic(inst, "uring", topic);
+        send_to_frontend(self, topic, &jsdrv_union_u8_r(0));
+        for (uint32_t k = 0; k < JSDRV_ARRAY_SIZE(topics_); ++k) {
+            inst_topic(inst, topics_[k].name, topic);
+            subscribe(self->context, topic, JSDRV_SFLAG_PUB, topics_[k].fn, inst);
+        }
+    }
+    *instance = self;
+    return 0;
+}
+
+void jsdrv_record_finalize(struct jsdrv_record_svc_s * self) {
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    if (self) {
+        for (uint32_t i = 0; i < JSDRV_RECORD_INSTANCES_MAX; ++i) {
+            struct record_inst_s * inst = &self->inst[i];
+            for (uint32_t k = 0; k < JSDRV_ARRAY_SIZE(topics_); ++k) {
+                inst_topic(inst, topics_[k].name, topic);
+                unsubscribe(self->context, topic, JSDRV_SFLAG_PUB, topics_[k].fn, inst);
+            }
+            inst_close(self, inst);
+        }
+        jsdrv_free(self);
+    }
+}
@@ -16,6 +16,7 @@
 
 #include "jsdrv_prv/sample_buffer_f32.h"
 #include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/simd_f32.h"
 #include "jsdrv_prv/cdef.h"
 #include <math.h>
 
@@ -123,10 +124,27 @@ void sbuf_f32_mult(struct sbuf_f32_s * r, struct sbuf_f32_s * s1, struct sbuf_f3
 
     r->msg_sample_id = (uint32_t) (r_sample_id & 0xffffffff);
     r->head_sample_id = r_sample_id;
-    while ((s1->tail != s1->head) && (s2->tail != s2->head)) {
-        r->buffer[r->head++] = s1->buffer[s1->tail] * s2->buffer[s2->tail];
-        s1->tail = (s1->tail + 1) & SAMPLE_BUFFER_MASK;
-        s2->tail = (s2->tail + 1) & SAMPLE_BUFFER_MASK;
-        r->head_sample_id += r->sample_id_decimate;
+    uint32_t n = sbuf_f32_length(s1);
+    uint32_t n2 = sbuf_f32_length(s2);
+    if (n2 < n) {
+        n = n2;
     }
+
+    // r is empty with head = 0, so only s1 and s2 can wrap.
+    // Process contiguous spans: at most 3, usually 1 or 2.
+    while (n) {
+        uint32_t k = n;
+        if (k > (SAMPLE_BUFFER_LENGTH - s1->tail)) {
+            k = SAMPLE_BUFFER_LENGTH - s1->tail;
+        }
+        if (k > (SAMPLE_BUFFER_LENGTH - s2->tail)) {
+            k = SAMPLE_BUFFER_LENGTH - s2->tail;
+        }
+        jsdrv_f32_mult(r->buffer + r->head, s1->buffer + s1->tail, s2->buffer + s2->tail, 1.0f, k);
+        s1->tail = (s1->tail + k) & SAMPLE_BUFFER_MASK;
+        s2->tail = (s2->tail + k) & SAMPLE_BUFFER_MASK;
+        r->head += k;
+        n -= k;
+    }
+    r->head_sample_id += (uint64_t) r->head * r->sample_id_decimate;
 }
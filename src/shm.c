@@ -0,0 +1,537 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/shm.h"
+#include "jsdrv_prv/atomic.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/dbc.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/pack.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/topic.h"
+#include "tinyprintf.h"
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+
+
+#define SHM_NAME_LENGTH_MAX     (64U)
+#define SEQ_RETRIES             (100000U)
+JSDRV_STATIC_ASSERT(sizeof(struct jsdrv_shm_header_s) <= JSDRV_SHM_HEADER_SIZE, header_size);
+
+
+struct jsdrv_shm_writer_s {
+    char name[SHM_NAME_LENGTH_MAX];
+    char topic[JSDRV_SHM_TOPIC_LENGTH_MAX];
+    uint64_t capacity;
+    struct jsdrv_os_shm_s * shm;
+    struct jsdrv_shm_header_s * hdr;
+    uint8_t * data;
+    uint32_t element_bytes;
+    uint8_t * unpack;       // u1 and u4 unpack scratch, JSDRV_STREAM_DATA_SIZE * 8 bytes
+    int32_t error;          // sticky region creation error
+};
+
+struct jsdrv_shm_reader_s {
+    struct jsdrv_os_shm_s * shm;
+    const struct jsdrv_shm_header_s * hdr;
+    const uint8_t * data;
+    uint32_t element_bytes;
+};
+
+static inline void seq_update(volatile int32_t * seq) {
+    jsdrv_atomic_add(seq, 1);  // sequentially consistent, orders the surrounding writes
+}
+
+static uint8_t ring_bits(const struct jsdrv_stream_signal_s * s) {
+    if ((JSDRV_DATA_TYPE_UINT == s->element_type) && ((1 == s->element_size_bits) || (4 == s->element_size_bits))) {
+        return 8;  // unpacked
+    }
+    switch (s->element_size_bits) {
+        case 8: return 8;
+        case 16: return 16;
+        case 32: return 32;
+        case 64: return 64;
+        default: return 0;
+    }
+}
+
+struct jsdrv_shm_writer_s * jsdrv_shm_writer_open(const char * name, const char * topic, uint64_t capacity) {
+    if ((NULL == name) || (0 == name[0]) || (strlen(name) >= SHM_NAME_LENGTH_MAX)
+            || (NULL == topic) || (0 == topic[0]) || (strlen(topic) >= JSDRV_SHM_TOPIC_LENGTH_MAX)
+            || (0 == capacity)) {
+        return NULL;
+    }
+    struct jsdrv_shm_writer_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_shm_writer_s));
+    jsdrv_cstr_copy(self->name, name, sizeof(self->name));
+    jsdrv_cstr_copy(self->topic, topic, sizeof(self->topic));
+    self->capacity = capacity;
+    return self;
+}
+
+static int32_t writer_create(struct jsdrv_shm_writer_s * self, const struct jsdrv_stream_signal_s * s) {
+    uint8_t bits = ring_bits(s);
+    if (0 == bits) {
+        return JSDRV_ERROR_NOT_SUPPORTED;
+    }
+    self->element_bytes = bits / 8;
+    size_t size = JSDRV_SHM_HEADER_SIZE + (size_t) (self->capacity * self->element_bytes);
+    self->shm = jsdrv_os_shm_create(self->name, size);
+    if (NULL == self->shm) {
+        return JSDRV_ERROR_IO;
+    }
+    uint8_t * p = jsdrv_os_shm_ptr(self->shm, NULL);
+    self->hdr = (struct jsdrv_shm_header_s *) p;
+    self->data = p + JSDRV_SHM_HEADER_SIZE;
+    if (8 == bits) {
+        self->unpack = jsdrv_alloc(JSDRV_STREAM_DATA_SIZE * 8);
+    }
+
+    struct jsdrv_shm_header_s * hdr = self->hdr;
+    seq_update(&hdr->seq);
+    hdr->version = JSDRV_SHM_VERSION;
+    hdr->header_size = JSDRV_SHM_HEADER_SIZE;
+    hdr->capacity = self->capacity;
+    hdr->write_count = 0;
+    hdr->sample_id = s->sample_id;
+    hdr->field_id = s->field_id;
+    hdr->index = s->index;
+    hdr->element_type = s->element_type;
+    hdr->element_size_bits = bits;
+    jsdrv_cstr_copy(hdr->topic, self->topic, sizeof(hdr->topic));
+    memcpy(hdr->magic, JSDRV_SHM_MAGIC, sizeof(hdr->magic));  // last, readers check first
+    seq_update(&hdr->seq);
+    JSDRV_LOGI("shm export %s to %s: %" PRIu64 " x %u bits", self->topic, self->name, self->capacity, bits);
+    return 0;
+}
+
+// Copy n elements from src to ring element k, which wraps.
+static void ring_copy(struct jsdrv_shm_writer_s * self, uint64_t k, const uint8_t * src, uint64_t n) {
+    uint64_t idx = k % self->capacity;
+    uint64_t n1 = self->capacity - idx;
+    if (n1 > n) {
+        n1 = n;
+    }
+    memcpy(self->data + idx * self->element_bytes, src, (size_t) (n1 * self->element_bytes));
+    if (n > n1) {
+        memcpy(self->data, src + n1 * self->element_bytes, (size_t) ((n - n1) * self->element_bytes));
+    }
+}
+
+// Fill n elements from ring element k, which wraps, with NaN for floats and 0 otherwise.
+static void ring_fill(struct jsdrv_shm_writer_s * self, uint64_t k, uint64_t n) {
+    uint8_t element_type = self->hdr->element_type;
+    for (uint64_t i = 0; i < n; ++i) {
+        uint8_t * p = self->data + ((k + i) % self->capacity) * self->element_bytes;
+        if ((JSDRV_DATA_TYPE_FLOAT == element_type) && (4 == self->element_bytes)) {
+            *((float *) p) = NAN;
+        } else if ((JSDRV_DATA_TYPE_FLOAT == element_type) && (8 == self->element_bytes)) {
+            *((double *) p) = NAN;
+        } else {
+            memset(p, 0, self->element_bytes);
+        }
+    }
+}
+
+int32_t jsdrv_shm_writer_write(struct jsdrv_shm_writer_s * self, const struct jsdrv_stream_signal_s * signal) {
+    if (self->error) {
+        return self->error;
+    } else if (NULL == self->shm) {
+        int32_t rc = writer_create(self, signal);
+        if (rc) {
+            JSDRV_LOGW("shm export %s to %s failed: %" PRId32, self->topic, self->name, rc);
+            self->error = rc;
+            return rc;
+        }
+    }
+    struct jsdrv_shm_header_s * hdr = self->hdr;
+    if ((signal->element_type != hdr->element_type) || (ring_bits(signal) != hdr->element_size_bits)) {
+        return JSDRV_ERROR_NOT_SUPPORTED;
+    }
+    uint64_t decimate_factor = signal->decimate_factor ? signal->decimate_factor : 1;
+    const uint8_t * src = signal->data;
+    uint64_t n = signal->element_count;
+    if ((1 == signal->element_size_bits) || (4 == signal->element_size_bits)) {
+        if (n > (JSDRV_STREAM_DATA_SIZE * 8)) {
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        } else if (1 == signal->element_size_bits) {
+            jsdrv_unpack_u1(self->unpack, signal->data, (uint32_t) n);
+        } else {
+            jsdrv_unpack_u4(self->unpack, signal->data, (uint32_t) n);
+        }
+        src = self->unpack;
+    }
+
+    seq_update(&hdr->seq);
+    uint64_t write_count = hdr->write_count;
+    if (signal->sample_id > hdr->sample_id) {
+        uint64_t gap = (signal->sample_id - hdr->sample_id) / decimate_factor;
+        ring_fill(self, write_count, (gap < self->capacity) ? gap : self->capacity);
+        write_count += gap;
+    } else if (signal->sample_id < hdr->sample_id) {
+        write_count += self->capacity;  // the stream restarted, invalidate all elements
+    }
+    if (n > self->capacity) {
+        write_count += n - self->capacity;  // keep only the newest elements
+        src += (n - self->capacity) * self->element_bytes;
+        n = self->capacity;
+    }
+    ring_copy(self, write_count, src, n);
+    hdr->write_count = write_count + n;
+    hdr->sample_id = signal->sample_id + signal->element_count * decimate_factor;
+    hdr->time_map = signal->time_map;
+    hdr->sample_rate = signal->sample_rate;
+    hdr->decimate_factor = (uint32_t) decimate_factor;
+    seq_update(&hdr->seq);
+    return 0;
+}
+
+void jsdrv_shm_writer_close(struct jsdrv_shm_writer_s * self) {
+    if (NULL == self) {
+        return;
+    }
+    if (self->shm) {
+        JSDRV_LOGI("shm export %s close: %" PRIu64 " elements", self->name, self->hdr->write_count);
+        jsdrv_os_shm_close(self->shm);
+    }
+    if (self->unpack) {
+        jsdrv_free(self->unpack);
+    }
+    jsdrv_free(self);
+}
+
+
+// -- Reader --
+
+int32_t jsdrv_shm_reader_open(const char * name, struct jsdrv_shm_reader_s ** reader) {
+    struct jsdrv_shm_header_s hdr;
+    size_t size = 0;
+    if (NULL == reader) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    *reader = NULL;
+    struct jsdrv_os_shm_s * shm = jsdrv_os_shm_open(name);
+    if (NULL == shm) {
+        return JSDRV_ERROR_NOT_FOUND;
+    }
+    struct jsdrv_shm_reader_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_shm_reader_s));
+    self->shm = shm;
+    const uint8_t * p = jsdrv_os_shm_ptr(shm, &size);
+    self->hdr = (const struct jsdrv_shm_header_s *) p;
+    self->data = p + JSDRV_SHM_HEADER_SIZE;
+    if ((size < JSDRV_SHM_HEADER_SIZE) || jsdrv_shm_reader_header(self, &hdr)
+            || memcmp(hdr.magic, JSDRV_SHM_MAGIC, sizeof(hdr.magic))
+            || (JSDRV_SHM_VERSION != hdr.version) || (JSDRV_SHM_HEADER_SIZE != hdr.header_size)
+            || (0 == hdr.element_size_bits) || (hdr.element_size_bits & 7)
+            || ((JSDRV_SHM_HEADER_SIZE + hdr.capacity * (hdr.element_size_bits / 8)) > size)) {
+        jsdrv_shm_reader_close(self);
+        return JSDRV_ERROR_NOT_SUPPORTED;
+    }
+    self->element_bytes = hdr.element_size_bits / 8;
+    *reader = self;
+    return 0;
+}
+
+void jsdrv_shm_reader_close(struct jsdrv_shm_reader_s * reader) {
+    if (NULL == reader) {
+        return;
+    }
+    jsdrv_os_shm_close(reader->shm);
+    jsdrv_free(reader);
+}
+
+int32_t jsdrv_shm_reader_header(struct jsdrv_shm_reader_s * reader, struct jsdrv_shm_header_s * header) {
+    volatile int32_t * seq = (volatile int32_t *) &reader->hdr->seq;
+    for (uint32_t retry = 0; retry < SEQ_RETRIES; ++retry) {
+        int32_t seq1 = jsdrv_atomic_load(seq);
+        if (seq1 & 1) {
+            continue;  // update in progress
+        }
+        memcpy(header, (const void *) reader->hdr, sizeof(*header));
+        if (seq1 == jsdrv_atomic_load(seq)) {
+            header->seq = seq1;
+            return 0;
+        }
+    }
+    return JSDRV_ERROR_BUSY;
+}
+
+const void * jsdrv_shm_reader_data(struct jsdrv_shm_reader_s * reader) {
+    return reader->data;
+}
+
+int32_t jsdrv_shm_reader_read(struct jsdrv_shm_reader_s * reader, uint64_t sample_id, uint64_t count, void * data) {
+    struct jsdrv_shm_header_s hdr;
+    JSDRV_RETURN_ON_ERROR(jsdrv_shm_reader_header(reader, &hdr));
+    uint64_t decimate_factor = hdr.decimate_factor ? hdr.decimate_factor : 1;
+    if (sample_id > hdr.sample_id) {
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    uint64_t delta = hdr.sample_id - sample_id;
+    if (delta % decimate_factor) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    uint64_t back = delta / decimate_factor;  // elements from sample_id to write_count
+    if ((back > hdr.write_count) || (back > hdr.capacity) || (count > back)) {
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    uint64_t k = hdr.write_count - back;
+    uint64_t idx = k % hdr.capacity;
+    uint64_t n1 = hdr.capacity - idx;
+    if (n1 > count) {
+        n1 = count;
+    }
+    uint8_t * dst = (uint8_t *) data;
+    memcpy(dst, reader->data + idx * reader->element_bytes, (size_t) (n1 * reader->element_bytes));
+    if (count > n1) {
+        memcpy(dst + n1 * reader->element_bytes, reader->data, (size_t) ((count - n1) * reader->element_bytes));
+    }
+
+    // confirm that the writer did not overwrite the elements during the copy
+    JSDRV_RETURN_ON_ERROR(jsdrv_shm_reader_header(reader, &hdr));
+    if ((hdr.write_count - k) > hdr.capacity) {
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    return 0;
+}
+
+
+// -- Driver service --
+
+static const char * signal_meta = "{"
+    "\"dtype\": \"str\","
+    "\"brief\": \"The stream data topic to export.\","
+    "\"detail\": \"Set before x/NNN/!open.\""
+"}";
+
+static const char * size_meta = "{"
+    "\"dtype\": \"u32\","
+    "\"brief\": \"The ring capacity in elements.\","
+    "\"default\": 4194304"
+"}";
+
+static const char * action_open_meta = "{"
+    "\"dtype\": \"str\","
+    "\"brief\": \"Start exporting to the shared memory region with this name.\","
+    "\"detail\": \"The name may contain letters, digits, '_', '-' and '.'.\""
+"}";
+
+static const char * action_close_meta = "{"
+    "\"dtype\": \"u32\","
+    "\"brief\": \"Stop exporting and remove the shared memory region.\""
+"}";
+
+struct jsdrv_shm_svc_s;
+
+struct shm_inst_s {
+    struct jsdrv_shm_svc_s * parent;
+    char prefix[8];  // "x/NNN/"
+    char topic[JSDRV_SHM_TOPIC_LENGTH_MAX];
+    uint32_t capacity;
+    struct jsdrv_shm_writer_s * writer;
+};
+
+struct jsdrv_shm_svc_s {
+    struct jsdrv_context_s * context;
+    struct shm_inst_s inst[JSDRV_SHM_INSTANCES_MAX];
+};
+
+static void inst_topic(struct shm_inst_s * inst, const char * name, char * topic) {
+    jsdrv_cstr_copy(topic, inst->prefix, JSDRV_TOPIC_LENGTH_MAX);
+    jsdrv_cstr_join(topic, topic, name, JSDRV_TOPIC_LENGTH_MAX);
+}
+
+static void send_to_frontend(struct jsdrv_shm_svc_s * self, const char * topic, const struct jsdrv_union_s * value) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, topic, value);
+    jsdrvp_backend_send(self->context, m);
+}
+
+static int32_t subscribe(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
+                         jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
+    jsdrv_cstr_copy(m->topic, JSDRV_PUBSUB_SUBSCRIBE, sizeof(m->topic));
+    m->value.type = JSDRV_UNION_BIN;
+    m->value.value.bin = m->payload.bin;
+    m->value.app = JSDRV_PAYLOAD_TYPE_SUB;
+    jsdrv_cstr_copy(m->payload.sub.topic, topic, sizeof(m->payload.sub.topic));
+    m->payload.sub.subscriber.internal_fn = cbk_fn;
+    m->payload.sub.subscriber.user_data = cbk_user_data;
+    m->payload.sub.subscriber.is_internal = 1;
+    m->payload.sub.subscriber.flags = flags;
+    jsdrvp_backend_send(context, m);
+    return 0;
+}
+
+static int32_t unsubscribe(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
+                           jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
+    jsdrv_cstr_copy(m->topic, JSDRV_PUBSUB_UNSUBSCRIBE, sizeof(m->topic));
+    m->value.type = JSDRV_UNION_BIN;
+    m->value.value.bin = m->payload.bin;
+    m->value.app = JSDRV_PAYLOAD_TYPE_SUB;
+    jsdrv_cstr_copy(m->payload.sub.topic, topic, sizeof(m->payload.sub.topic));
+    m->payload.sub.subscriber.internal_fn = cbk_fn;
+    m->payload.sub.subscriber.user_data = cbk_user_data;
+    m->payload.sub.subscriber.is_internal = 1;
+    m->payload.sub.subscriber.flags = flags;
+    jsdrvp_backend_send(context, m);
+    return 0;
+}
+
+static int32_t send_return_code_to_frontend(struct jsdrv_context_s * context, const char * topic, int32_t rc,
+        jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
+    struct jsdrvp_msg_s * m;
+    m = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_i32(rc));
+    tfp_snprintf(m->topic, sizeof(m->topic), "%s%c", topic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
+    m->extra.frontend.subscriber.internal_fn = cbk_fn;
+    m->extra.frontend.subscriber.user_data = cbk_user_data;
+    m->extra.frontend.subscriber.is_internal = 1;
+    jsdrvp_backend_send(context, m);
+    return rc;
+}
+
+static uint8_t _shm_recv_data(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct shm_inst_s * inst = (struct shm_inst_s *) user_data;
+    if ((NULL == inst->writer) || (JSDRV_UNION_BIN != msg->value.type) || (JSDRV_PAYLOAD_TYPE_STREAM != msg->value.app)
+            || (msg->value.size < JSDRV_STREAM_HEADER_SIZE)) {
+        return 0;  // includes data in flight after close
+    }
+    jsdrv_shm_writer_write(inst->writer, (const struct jsdrv_stream_signal_s *) msg->value.value.bin);
+    return 0;
+}
+
+static uint8_t _shm_signal(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct shm_inst_s * inst = (struct shm_inst_s *) user_data;
+    if ((JSDRV_UNION_STR != msg->value.type) || (NULL == msg->value.value.str)
+            || (strlen(msg->value.value.str) >= sizeof(inst->topic))) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    } else if (NULL != inst->writer) {
+        return JSDRV_ERROR_BUSY;
+    }
+    jsdrv_cstr_copy(inst->topic, msg->value.value.str, sizeof(inst->topic));
+    return 0;
+}
+
+static uint8_t _shm_size(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct shm_inst_s * inst = (struct shm_inst_s *) user_data;
+    struct jsdrv_union_s v = msg->value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U32) || (0 == v.value.u32)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    } else if (NULL != inst->writer) {
+        return JSDRV_ERROR_BUSY;
+    }
+    inst->capacity = v.value.u32;
+    return 0;
+}
+
+static uint8_t _shm_open(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct shm_inst_s * inst = (struct shm_inst_s *) user_data;
+    struct jsdrv_shm_svc_s * self = inst->parent;
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    inst_topic(inst, "!open", topic);
+    if (NULL != inst->writer) {
+        return (uint8_t) send_return_code_to_frontend(self->context, topic, JSDRV_ERROR_BUSY, _shm_open, inst);
+    }
+    struct jsdrv_shm_writer_s * writer = NULL;
+    if (JSDRV_UNION_STR == msg->value.type) {
+        writer = jsdrv_shm_writer_open(msg->value.value.str, inst->topic, inst->capacity);
+    }
+    if (NULL == writer) {
+        return (uint8_t) send_return_code_to_frontend(self->context, topic, JSDRV_ERROR_PARAMETER_INVALID, _shm_open, inst);
+    }
+    inst->writer = writer;
+    subscribe(self->context, inst->topic, JSDRV_SFLAG_PUB, _shm_recv_data, inst);
+    return (uint8_t) send_return_code_to_frontend(self->context, topic, 0, _shm_open, inst);
+}
+
+static int32_t inst_close(struct jsdrv_shm_svc_s * self, struct shm_inst_s * inst) {
+    if (NULL == inst->writer) {
+        return JSDRV_ERROR_CLOSED;
+    }
+    unsubscribe(self->context, inst->topic, JSDRV_SFLAG_PUB, _shm_recv_data, inst);
+    jsdrv_shm_writer_close(inst->writer);
+    inst->writer = NULL;
+    return 0;
+}
+
+static uint8_t _shm_close(void * user_data, struct jsdrvp_msg_s * msg) {
+    (void) msg;
+    struct shm_inst_s * inst = (struct shm_inst_s *) user_data;
+    struct jsdrv_shm_svc_s * self = inst->parent;
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    inst_topic(inst, "!close", topic);
+    return (uint8_t) send_return_code_to_frontend(self->context, topic, inst_close(self, inst), _shm_close, inst);
+}
+
+struct shm_topic_s {
+    const char * name;
+    jsdrv_pubsub_subscribe_fn fn;
+};
+
+static const struct shm_topic_s topics_[] = {
+    {"signal", _shm_signal},
+    {"size", _shm_size},
+    {"!open", _shm_open},
+    {"!close", _shm_close},
+};
+
+int32_t jsdrv_shm_initialize(struct jsdrv_context_s * context, struct jsdrv_shm_svc_s ** instance) {
+    JSDRV_DBC_NOT_NULL(context);
+    JSDRV_DBC_NOT_NULL(instance);
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    const char * meta[] = {signal_meta, size_meta, action_open_meta, action_close_meta};  // topics_ order
+    struct jsdrv_shm_svc_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_shm_svc_s));
+    self->context = context;
+    for (uint32_t i = 0; i < JSDRV_SHM_INSTANCES_MAX; ++i) {
+        struct shm_inst_s * inst = &self->inst[i];
+        inst->parent = self;
+        tfp_snprintf(inst->prefix, sizeof(inst->prefix), "x/%03u/", (unsigned int) (i + 1));
+        inst->capacity = JSDRV_SHM_CAPACITY_DEFAULT;
+        for (uint32_t k = 0; k < JSDRV_ARRAY_SIZE(topics_); ++k) {
+            inst_topic(inst, topics_[k].name, topic);
+            jsdrv_cstr_join(topic, topic, "$", sizeof(topic));
+            send_to_frontend(self, topic, &jsdrv_union_cjson_r(meta[k]));
+        }
+        inst_topic(inst, "signal", topic);
+        send_to_frontend(self, topic, &jsdrv_union_cstr_r(""));
+        inst_topic(inst, "size", topic);
+        send_to_frontend(self, topic, &jsdrv_union_u32_r(JSDRV_SHM_CAPACITY_DEFAULT));
+        for (uint32_t k = 0; k < JSDRV_ARRAY_SIZE(topics_); ++k) {
+            inst_topic(inst, topics_[k].name, topic);
+            subscribe(self->context, topic, JSDRV_SFLAG_PUB, topics_[k].fn, inst);
+        }
+    }
+    *instance = self;
+    return 0;
+}
+
+void jsdrv_shm_finalize(struct jsdrv_shm_svc_s * self) {
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    if (self) {
+        for (uint32_t i = 0; i < JSDRV_SHM_INSTANCES_MAX; ++i) {
+            struct shm_inst_s * inst = &self->inst[i];
+            for (uint32_t k = 0; k < JSDRV_ARRAY_SIZE(topics_); ++k) {
+                inst_topic(inst, topics_[k].name, topic);
+                unsubscribe(self->context, topic, JSDRV_SFLAG_PUB, topics_[k].fn, inst);
+            }
+            inst_close(self, inst);
+        }
+        jsdrv_free(self);
+    }
+}
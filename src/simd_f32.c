@@ -0,0 +1,647 @@
+/*
+ * Copyright 2023 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/simd_f32.h"
+#include "jsdrv_prv/cpu.h"
+#include "jsdrv.h"
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define SIMD_SSE2 1
+#if _WIN32
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#if defined(__clang__) || defined(__GNUC__)
+#define SIMD_AVX2 1
+#define SIMD_AVX2_FN __attribute__((target("avx2")))
+#define SIMD_AVX512 1
+#define SIMD_AVX512_FN __attribute__((target("avx512f")))
+#elif defined(_MSC_VER)
+#define SIMD_AVX2 1
+#define SIMD_AVX2_FN
+#define SIMD_AVX512 1
+#define SIMD_AVX512_FN
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_NEON_F64 1  // float64x2_t requires AArch64
+#endif
+#endif
+
+
+typedef void (*mult_fn)(float * y, const float * a, const float * b, float scale, uint32_t n);
+typedef void (*scale_fn)(float * x, float scale, uint32_t n);
+typedef void (*sum_fn)(struct jsdrv_f32_sum_s * s, const float * x, uint32_t n);
+typedef double (*sum_sq_diff_fn)(const float * x, uint32_t n, double mean);
+typedef int32_t (*combine_fn)(struct jsdrv_summary_entry_s * y, const struct jsdrv_summary_entry_s * x, uint32_t n);
+
+struct impl_s {
+    const char * name;
+    mult_fn mult;
+    scale_fn scale;
+    sum_fn sum;
+    sum_sq_diff_fn sum_sq_diff;
+    combine_fn combine;
+};
+
+static inline uint32_t popcount8(uint32_t m) {
+    m = m - ((m >> 1) & 0x55);
+    m = (m & 0x33) + ((m >> 2) & 0x33);
+    return (m + (m >> 4)) & 0x0f;
+}
+
+static void combine_store(struct jsdrv_summary_entry_s * y, double mean, double s, uint32_t n,
+                          float y_min, float y_max) {
+    y->avg = (float) mean;
+    y->std = (n > 1) ? (float) sqrt(s / (double) (n - 1)) : 0.0f;
+    y->min = y_min;
+    y->max = y_max;
+}
+
+static void mult_scalar(float * y, const float * a, const float * b, float scale, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        y[i] = (a[i] * b[i]) * scale;
+    }
+}
+
+static void scale_scalar(float * x, float scale, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        x[i] *= scale;
+    }
+}
+
+static void sum_scalar(struct jsdrv_f32_sum_s * s, const float * x, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        float f = x[i];
+        if (isnan(f)) {
+            continue;
+        }
+        s->sum += f;
+        ++s->count;
+        if (f < s->min) {
+            s->min = f;
+        }
+        if (f > s->max) {
+            s->max = f;
+        }
+    }
+}
+
+static double sum_sq_diff_scalar(const float * x, uint32_t n, double mean) {
+    double d2 = 0.0;
+    for (uint32_t i = 0; i < n; ++i) {
+        if (!isnan(x[i])) {
+            double d = x[i] - mean;
+            d2 += d * d;
+        }
+    }
+    return d2;
+}
+
+static int32_t combine_scalar(struct jsdrv_summary_entry_s * y, const struct jsdrv_summary_entry_s * x, uint32_t n) {
+    double sum = 0.0;
+    double sq = 0.0;
+    float y_min = FLT_MAX;
+    float y_max = -FLT_MAX;
+    if (0 == n) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        const struct jsdrv_summary_entry_s * e = &x[i];
+        if (isnan(e->avg) || isnan(e->std) || isnan(e->min) || isnan(e->max)) {
+            return 1;
+        }
+        sum += e->avg;
+        sq += (double) e->std * e->std;
+        if (e->min < y_min) {
+            y_min = e->min;
+        }
+        if (e->max > y_max) {
+            y_max = e->max;
+        }
+    }
+    double mean = sum / n;
+    double d2 = 0.0;
+    for (uint32_t i = 0; i < n; ++i) {
+        double d = x[i].avg - mean;
+        d2 += d * d;
+    }
+    combine_store(y, mean, sq + d2, n, y_min, y_max);
+    return 0;
+}
+
+static const struct impl_s IMPL_SCALAR = {"scalar", mult_scalar, scale_scalar,
+                                          sum_scalar, sum_sq_diff_scalar, combine_scalar};
+
+#if SIMD_SSE2
+static void mult_sse2(float * y, const float * a, const float * b, float scale, uint32_t n) {
+    uint32_t i = 0;
+    __m128 s = _mm_set1_ps(scale);
+    for (; (i + 4) <= n; i += 4) {
+        __m128 p = _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        _mm_storeu_ps(y + i, _mm_mul_ps(p, s));
+    }
+    mult_scalar(y + i, a + i, b + i, scale, n - i);
+}
+
+static void scale_sse2(float * x, float scale, uint32_t n) {
+    uint32_t i = 0;
+    __m128 s = _mm_set1_ps(scale);
+    for (; (i + 4) <= n; i += 4) {
+        _mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), s));
+    }
+    scale_scalar(x + i, scale, n - i);
+}
+
+static void sum_sse2(struct jsdrv_f32_sum_s * s, const float * x, uint32_t n) {
+    uint32_t i = 0;
+    uint64_t count = 0;
+    __m128d s0 = _mm_setzero_pd();
+    __m128d s1 = _mm_setzero_pd();
+    __m128 f_max = _mm_set1_ps(FLT_MAX);
+    __m128 f_min = _mm_set1_ps(-FLT_MAX);
+    __m128 y_min = f_max;
+    __m128 y_max = f_min;
+    for (; (i + 4) <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(x + i);
+        __m128 ord = _mm_cmpord_ps(v, v);
+        __m128 vz = _mm_and_ps(v, ord);
+        s0 = _mm_add_pd(s0, _mm_cvtps_pd(vz));
+        s1 = _mm_add_pd(s1, _mm_cvtps_pd(_mm_movehl_ps(vz, vz)));
+        y_min = _mm_min_ps(y_min, _mm_or_ps(vz, _mm_andnot_ps(ord, f_max)));
+        y_max = _mm_max_ps(y_max, _mm_or_ps(vz, _mm_andnot_ps(ord, f_min)));
+        count += popcount8((uint32_t) _mm_movemask_ps(ord));
+    }
+    double d[2];
+    float f_lo[4];
+    float f_hi[4];
+    _mm_storeu_pd(d, _mm_add_pd(s0, s1));
+    _mm_storeu_ps(f_lo, y_min);
+    _mm_storeu_ps(f_hi, y_max);
+    s->sum += d[0] + d[1];
+    s->count += count;
+    for (uint32_t k = 0; k < 4; ++k) {
+        s->min = (f_lo[k] < s->min) ? f_lo[k] : s->min;
+        s->max = (f_hi[k] > s->max) ? f_hi[k] : s->max;
+    }
+    sum_scalar(s, x + i, n - i);
+}
+
+static double sum_sq_diff_sse2(const float * x, uint32_t n, double mean) {
+    uint32_t i = 0;
+    __m128d m = _mm_set1_pd(mean);
+    __m128d acc = _mm_setzero_pd();
+    for (; (i + 4) <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(x + i);
+        __m128d lo = _mm_cvtps_pd(v);
+        __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+        __m128d d_lo = _mm_sub_pd(lo, m);
+        __m128d d_hi = _mm_sub_pd(hi, m);
+        acc = _mm_add_pd(acc, _mm_and_pd(_mm_mul_pd(d_lo, d_lo), _mm_cmpord_pd(lo, lo)));
+        acc = _mm_add_pd(acc, _mm_and_pd(_mm_mul_pd(d_hi, d_hi), _mm_cmpord_pd(hi, hi)));
+    }
+    double d[2];
+    _mm_storeu_pd(d, acc);
+    return d[0] + d[1] + sum_sq_diff_scalar(x + i, n - i, mean);
+}
+
+static int32_t combine_sse2(struct jsdrv_summary_entry_s * y, const struct jsdrv_summary_entry_s * x, uint32_t n) {
+    const float * f = (const float *) x;  // avg, std, min, max
+    __m128d sum = _mm_setzero_pd();  // lane 0: avg
+    __m128d sq = _mm_setzero_pd();   // lane 1: std^2
+    __m128 y_min = _mm_set1_ps(FLT_MAX);
+    __m128 y_max = _mm_set1_ps(-FLT_MAX);
+    __m128 nan = _mm_setzero_ps();
+    if (0 == n) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        __m128 v = _mm_loadu_ps(f + 4 * i);
+        __m128d lo = _mm_cvtps_pd(v);
+        nan = _mm_or_ps(nan, _mm_cmpunord_ps(v, v));
+        sum = _mm_add_pd(sum, lo);
+        sq = _mm_add_pd(sq, _mm_mul_pd(lo, lo));
+        y_min = _mm_min_ps(y_min, v);
+        y_max = _mm_max_ps(y_max, v);
+    }
+    if (_mm_movemask_ps(nan)) {
+        return 1;
+    }
+    double d_sum[2];
+    double d_sq[2];
+    float f_min[4];
+    float f_max[4];
+    _mm_storeu_pd(d_sum, sum);
+    _mm_storeu_pd(d_sq, sq);
+    _mm_storeu_ps(f_min, y_min);
+    _mm_storeu_ps(f_max, y_max);
+    double mean = d_sum[0] / n;
+    __m128d m = _mm_set1_pd(mean);
+    __m128d d2 = _mm_setzero_pd();
+    for (uint32_t i = 0; i < n; ++i) {
+        __m128d d = _mm_sub_pd(_mm_cvtps_pd(_mm_loadu_ps(f + 4 * i)), m);
+        d2 = _mm_add_pd(d2, _mm_mul_pd(d, d));
+    }
+    double d_d2[2];
+    _mm_storeu_pd(d_d2, d2);
+    combine_store(y, mean, d_sq[1] + d_d2[0], n, f_min[2], f_max[3]);
+    return 0;
+}
+
+static const struct impl_s IMPL_SSE2 = {"sse2", mult_sse2, scale_sse2,
+                                        sum_sse2, sum_sq_diff_sse2, combine_sse2};
+#endif
+
+#if SIMD_AVX2
+SIMD_AVX2_FN static void mult_avx2(float * y, const float * a, const float * b, float scale, uint32_t n) {
+    uint32_t i = 0;
+    __m256 s = _mm256_set1_ps(scale);
+    for (; (i + 8) <= n; i += 8) {
+        __m256 p = _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        _mm256_storeu_ps(y + i, _mm256_mul_ps(p, s));
+    }
+    mult_scalar(y + i, a + i, b + i, scale, n - i);
+}
+
+SIMD_AVX2_FN static void scale_avx2(float * x, float scale, uint32_t n) {
+    uint32_t i = 0;
+    __m256 s = _mm256_set1_ps(scale);
+    for (; (i + 8) <= n; i += 8) {
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), s));
+    }
+    scale_scalar(x + i, scale, n - i);
+}
+
+SIMD_AVX2_FN static void sum_avx2(struct jsdrv_f32_sum_s * s, const float * x, uint32_t n) {
+    uint32_t i = 0;
+    uint64_t count = 0;
+    __m256d s0 = _mm256_setzero_pd();
+    __m256d s1 = _mm256_setzero_pd();
+    __m256 f_max = _mm256_set1_ps(FLT_MAX);
+    __m256 f_min = _mm256_set1_ps(-FLT_MAX);
+    __m256 y_min = f_max;
+    __m256 y_max = f_min;
+    for (; (i + 8) <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(x + i);
+        __m256 ord = _mm256_cmp_ps(v, v, _CMP_ORD_Q);
+        __m256 vz = _mm256_and_ps(v, ord);
+        s0 = _mm256_add_pd(s0, _mm256_cvtps_pd(_mm256_castps256_ps128(vz)));
+        s1 = _mm256_add_pd(s1, _mm256_cvtps_pd(_mm256_extractf128_ps(vz, 1)));
+        y_min = _mm256_min_ps(y_min, _mm256_blendv_ps(f_max, v, ord));
+        y_max = _mm256_max_ps(y_max, _mm256_blendv_ps(f_min, v, ord));
+        count += popcount8((uint32_t) _mm256_movemask_ps(ord));
+    }
+    double d[4];
+    float f_lo[8];
+    float f_hi[8];
+    _mm256_storeu_pd(d, _mm256_add_pd(s0, s1));
+    _mm256_storeu_ps(f_lo, y_min);
+    _mm256_storeu_ps(f_hi, y_max);
+    s->sum += (d[0] + d[1]) + (d[2] + d[3]);
+    s->count += count;
+    for (uint32_t k = 0; k < 8; ++k) {
+        s->min = (f_lo[k] < s->min) ? f_lo[k] : s->min;
+        s->max = (f_hi[k] > s->max) ? f_hi[k] : s->max;
+    }
+    sum_scalar(s, x + i, n - i);
+}
+
+SIMD_AVX2_FN static double sum_sq_diff_avx2(const float * x, uint32_t n, double mean) {
+    uint32_t i = 0;
+    __m256d m = _mm256_set1_pd(mean);
+    __m256d acc = _mm256_setzero_pd();
+    for (; (i + 8) <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(x + i);
+        __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+        __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+        __m256d d_lo = _mm256_sub_pd(lo, m);
+        __m256d d_hi = _mm256_sub_pd(hi, m);
+        acc = _mm256_add_pd(acc, _mm256_and_pd(_mm256_mul_pd(d_lo, d_lo), _mm256_cmp_pd(lo, lo, _CMP_ORD_Q)));
+        acc = _mm256_add_pd(acc, _mm256_and_pd(_mm256_mul_pd(d_hi, d_hi), _mm256_cmp_pd(hi, hi, _CMP_ORD_Q)));
+    }
+    double d[4];
+    _mm256_storeu_pd(d, acc);
+    return (d[0] + d[1]) + (d[2] + d[3]) + sum_sq_diff_scalar(x + i, n - i, mean);
+}
+
+SIMD_AVX2_FN static int32_t combine_avx2(struct jsdrv_summary_entry_s * y, const struct jsdrv_summary_entry_s * x, uint32_t n) {
+    const float * f = (const float *) x;  // avg, std, min, max
+    __m256d sum = _mm256_setzero_pd();  // lane 0: avg
+    __m256d sq = _mm256_setzero_pd();   // lane 1: std^2
+    __m256d y_min = _mm256_set1_pd(FLT_MAX);
+    __m256d y_max = _mm256_set1_pd(-FLT_MAX);
+    __m256d nan = _mm256_setzero_pd();
+    if (0 == n) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        __m256d v = _mm256_cvtps_pd(_mm_loadu_ps(f + 4 * i));
+        nan = _mm256_or_pd(nan, _mm256_cmp_pd(v, v, _CMP_UNORD_Q));
+        sum = _mm256_add_pd(sum, v);
+        sq = _mm256_add_pd(sq, _mm256_mul_pd(v, v));
+        y_min = _mm256_min_pd(y_min, v);
+        y_max = _mm256_max_pd(y_max, v);
+    }
+    if (_mm256_movemask_pd(nan)) {
+        return 1;
+    }
+    double d_sum[4];
+    double d_sq[4];
+    double d_min[4];
+    double d_max[4];
+    _mm256_storeu_pd(d_sum, sum);
+    _mm256_storeu_pd(d_sq, sq);
+    _mm256_storeu_pd(d_min, y_min);
+    _mm256_storeu_pd(d_max, y_max);
+    double mean = d_sum[0] / n;
+    __m256d m = _mm256_set1_pd(mean);
+    __m256d d2 = _mm256_setzero_pd();
+    for (uint32_t i = 0; i < n; ++i) {
+        __m256d d = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(f + 4 * i)), m);
+        d2 = _mm256_add_pd(d2, _mm256_mul_pd(d, d));
+    }
+    double d_d2[4];
+    _mm256_storeu_pd(d_d2, d2);
+    combine_store(y, mean, d_sq[1] + d_d2[0], n, (float) d_min[2], (float) d_max[3]);
+    return 0;
+}
+
+static const struct impl_s IMPL_AVX2 = {"avx2", mult_avx2, scale_avx2,
+                                        sum_avx2, sum_sq_diff_avx2, combine_avx2};
+
+#endif
+
+#if SIMD_AVX512
+SIMD_AVX512_FN static void mult_avx512(float * y, const float * a, const float * b, float scale, uint32_t n) {
+    uint32_t i = 0;
+    __m512 s = _mm512_set1_ps(scale);
+    for (; (i + 16) <= n; i += 16) {
+        __m512 p = _mm512_mul_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        _mm512_storeu_ps(y + i, _mm512_mul_ps(p, s));
+    }
+    mult_scalar(y + i, a + i, b + i, scale, n - i);
+}
+
+SIMD_AVX512_FN static void scale_avx512(float * x, float scale, uint32_t n) {
+    uint32_t i = 0;
+    __m512 s = _mm512_set1_ps(scale);
+    for (; (i + 16) <= n; i += 16) {
+        _mm512_storeu_ps(x + i, _mm512_mul_ps(_mm512_loadu_ps(x + i), s));
+    }
+    scale_scalar(x + i, scale, n - i);
+}
+
+SIMD_AVX512_FN static inline __m256 avx512_hi_ps(__m512 v) {
+    return _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));  // AVX-512F only
+}
+
+SIMD_AVX512_FN static void sum_avx512(struct jsdrv_f32_sum_s * s, const float * x, uint32_t n) {
+    uint32_t i = 0;
+    uint64_t count = 0;
+    __m512d s0 = _mm512_setzero_pd();
+    __m512d s1 = _mm512_setzero_pd();
+    __m512 y_min = _mm512_set1_ps(FLT_MAX);
+    __m512 y_max = _mm512_set1_ps(-FLT_MAX);
+    for (; (i + 16) <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(x + i);
+        __mmask16 ord = _mm512_cmp_ps_mask(v, v, _CMP_ORD_Q);
+        __m512 vz = _mm512_maskz_mov_ps(ord, v);
+        s0 = _mm512_add_pd(s0, _mm512_cvtps_pd(_mm512_castps512_ps256(vz)));
+        s1 = _mm512_add_pd(s1, _mm512_cvtps_pd(avx512_hi_ps(vz)));
+        y_min = _mm512_mask_min_ps(y_min, ord, y_min, v);
+        y_max = _mm512_mask_max_ps(y_max, ord, y_max, v);
+        count += popcount8(ord & 0xff) + popcount8((uint32_t) ord >> 8);
+    }
+    double d[8];
+    float f_lo[16];
+    float f_hi[16];
+    _mm512_storeu_pd(d, _mm512_add_pd(s0, s1));
+    _mm512_storeu_ps(f_lo, y_min);
+    _mm512_storeu_ps(f_hi, y_max);
+    s->sum += ((d[0] + d[1]) + (d[2] + d[3])) + ((d[4] + d[5]) + (d[6] + d[7]));
+    s->count += count;
+    for (uint32_t k = 0; k < 16; ++k) {
+        s->min = (f_lo[k] < s->min) ? f_lo[k] : s->min;
+        s->max = (f_hi[k] > s->max) ? f_hi[k] : s->max;
+    }
+    sum_scalar(s, x + i, n - i);
+}
+
+SIMD_AVX512_FN static double sum_sq_diff_avx512(const float * x, uint32_t n, double mean) {
+    uint32_t i = 0;
+    __m512d m = _mm512_set1_pd(mean);
+    __m512d acc = _mm512_setzero_pd();
+    for (; (i + 16) <= n; i += 16) {
+        __m512 v = _mm512_loadu_ps(x + i);
+        __m512d lo = _mm512_cvtps_pd(_mm512_castps512_ps256(v));
+        __m512d hi = _mm512_cvtps_pd(avx512_hi_ps(v));
+        __m512d d_lo = _mm512_sub_pd(lo, m);
+        __m512d d_hi = _mm512_sub_pd(hi, m);
+        acc = _mm512_mask_add_pd(acc, _mm512_cmp_pd_mask(lo, lo, _CMP_ORD_Q), acc, _mm512_mul_pd(d_lo, d_lo));
+        acc = _mm512_mask_add_pd(acc, _mm512_cmp_pd_mask(hi, hi, _CMP_ORD_Q), acc, _mm512_mul_pd(d_hi, d_hi));
+    }
+    double d[8];
+    _mm512_storeu_pd(d, acc);
+    return ((d[0] + d[1]) + (d[2] + d[3])) + ((d[4] + d[5]) + (d[6] + d[7]))
+           + sum_sq_diff_scalar(x + i, n - i, mean);
+}
+
+// combine processes one 4-float entry per step, which AVX2 already covers
+static const struct impl_s IMPL_AVX512 = {"avx512", mult_avx512, scale_avx512,
+                                          sum_avx512, sum_sq_diff_avx512, combine_avx2};
+#endif
+
+#if SIMD_NEON
+static void mult_neon(float * y, const float * a, const float * b, float scale, uint32_t n) {
+    uint32_t i = 0;
+    float32x4_t s = vdupq_n_f32(scale);
+    for (; (i + 4) <= n; i += 4) {
+        float32x4_t p = vmulq_f32(vld1q_f32(a + i), vld1q_f32(b + i));
+        vst1q_f32(y + i, vmulq_f32(p, s));
+    }
+    mult_scalar(y + i, a + i, b + i, scale, n - i);
+}
+
+static void scale_neon(float * x, float scale, uint32_t n) {
+    uint32_t i = 0;
+    float32x4_t s = vdupq_n_f32(scale);
+    for (; (i + 4) <= n; i += 4) {
+        vst1q_f32(x + i, vmulq_f32(vld1q_f32(x + i), s));
+    }
+    scale_scalar(x + i, scale, n - i);
+}
+
+#if SIMD_NEON_F64
+static void sum_neon(struct jsdrv_f32_sum_s * s, const float * x, uint32_t n) {
+    uint32_t i = 0;
+    uint64_t count = 0;
+    float64x2_t s0 = vdupq_n_f64(0.0);
+    float64x2_t s1 = vdupq_n_f64(0.0);
+    float32x4_t f_max = vdupq_n_f32(FLT_MAX);
+    float32x4_t f_min = vdupq_n_f32(-FLT_MAX);
+    float32x4_t y_min = f_max;
+    float32x4_t y_max = f_min;
+    for (; (i + 4) <= n; i += 4) {
+        float32x4_t v = vld1q_f32(x + i);
+        uint32x4_t ord = vceqq_f32(v, v);
+        float32x4_t vz = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(v), ord));
+        s0 = vaddq_f64(s0, vcvt_f64_f32(vget_low_f32(vz)));
+        s1 = vaddq_f64(s1, vcvt_high_f64_f32(vz));
+        y_min = vminq_f32(y_min, vbslq_f32(ord, v, f_max));
+        y_max = vmaxq_f32(y_max, vbslq_f32(ord, v, f_min));
+        count += vaddvq_u32(vshrq_n_u32(ord, 31));
+    }
+    float v_min = vminvq_f32(y_min);
+    float v_max = vmaxvq_f32(y_max);
+    s->sum += vaddvq_f64(vaddq_f64(s0, s1));
+    s->count += count;
+    s->min = (v_min < s->min) ? v_min : s->min;
+    s->max = (v_max > s->max) ? v_max : s->max;
+    sum_scalar(s, x + i, n - i);
+}
+
+static double sum_sq_diff_neon(const float * x, uint32_t n, double mean) {
+    uint32_t i = 0;
+    float64x2_t m = vdupq_n_f64(mean);
+    float64x2_t acc = vdupq_n_f64(0.0);
+    for (; (i + 4) <= n; i += 4) {
+        float32x4_t v = vld1q_f32(x + i);
+        float64x2_t lo = vcvt_f64_f32(vget_low_f32(v));
+        float64x2_t hi = vcvt_high_f64_f32(v);
+        float64x2_t d_lo = vsubq_f64(lo, m);
+        float64x2_t d_hi = vsubq_f64(hi, m);
+        uint64x2_t sq_lo = vandq_u64(vreinterpretq_u64_f64(vmulq_f64(d_lo, d_lo)), vceqq_f64(lo, lo));
+        uint64x2_t sq_hi = vandq_u64(vreinterpretq_u64_f64(vmulq_f64(d_hi, d_hi)), vceqq_f64(hi, hi));
+        acc = vaddq_f64(acc, vreinterpretq_f64_u64(sq_lo));
+        acc = vaddq_f64(acc, vreinterpretq_f64_u64(sq_hi));
+    }
+    return vaddvq_f64(acc) + sum_sq_diff_scalar(x + i, n - i, mean);
+}
+
+static int32_t combine_neon(struct jsdrv_summary_entry_s * y, const struct jsdrv_summary_entry_s * x, uint32_t n) {
+    const float * f = (const float *) x;  // avg, std, min, max
+    float64x2_t sum = vdupq_n_f64(0.0);  // lane 0: avg
+    float64x2_t sq = vdupq_n_f64(0.0);   // lane 1: std^2
+    float32x4_t y_min = vdupq_n_f32(FLT_MAX);
+    float32x4_t y_max = vdupq_n_f32(-FLT_MAX);
+    uint32x4_t ord = vdupq_n_u32(0xffffffffU);
+    if (0 == n) {
+        return 1;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        float32x4_t v = vld1q_f32(f + 4 * i);
+        float64x2_t lo = vcvt_f64_f32(vget_low_f32(v));
+        ord = vandq_u32(ord, vceqq_f32(v, v));
+        sum = vaddq_f64(sum, lo);
+        sq = vaddq_f64(sq, vmulq_f64(lo, lo));
+        y_min = vminq_f32(y_min, v);
+        y_max = vmaxq_f32(y_max, v);
+    }
+    if (0 == vminvq_u32(ord)) {
+        return 1;
+    }
+    double mean = vgetq_lane_f64(sum, 0) / n;
+    float64x2_t m = vdupq_n_f64(mean);
+    float64x2_t d2 = vdupq_n_f64(0.0);
+    for (uint32_t i = 0; i < n; ++i) {
+        float64x2_t d = vsubq_f64(vcvt_f64_f32(vld1_f32(f + 4 * i)), m);
+        d2 = vaddq_f64(d2, vmulq_f64(d, d));
+    }
+    combine_store(y, mean, vgetq_lane_f64(sq, 1) + vgetq_lane_f64(d2, 0), n,
+                  vgetq_lane_f32(y_min, 2), vgetq_lane_f32(y_max, 3));
+    return 0;
+}
+
+static const struct impl_s IMPL_NEON = {"neon", mult_neon, scale_neon,
+                                        sum_neon, sum_sq_diff_neon, combine_neon};
+#else
+static const struct impl_s IMPL_NEON = {"neon", mult_neon, scale_neon,
+                                        sum_scalar, sum_sq_diff_scalar, combine_scalar};
+#endif
+#endif
+
+// Selection is idempotent, so concurrent first calls are benign.
+static const struct impl_s * volatile impl_ = NULL;
+
+void jsdrv_f32_select(uint32_t features) {
+    const struct impl_s * impl = &IMPL_SCALAR;
+#if SIMD_SSE2
+    if (features & JSDRV_CPU_SSE2) {
+        impl = &IMPL_SSE2;
+    }
+#endif
+#if SIMD_AVX2
+    if (features & JSDRV_CPU_AVX2) {
+        impl = &IMPL_AVX2;
+    }
+#endif
+#if SIMD_AVX512
+    if (features & JSDRV_CPU_AVX512) {
+        impl = &IMPL_AVX512;
+    }
+#endif
+#if SIMD_NEON
+    if (features & JSDRV_CPU_NEON) {
+        impl = &IMPL_NEON;
+    }
+#endif
+    impl_ = impl;
+}
+
+static inline const struct impl_s * impl_select(void) {
+    const struct impl_s * impl = impl_;
+    if (NULL == impl) {  // direct use without jsdrv_initialize()
+        jsdrv_f32_select(jsdrv_cpu_features());
+        impl = impl_;
+    }
+    return impl;
+}
+
+void jsdrv_f32_mult(float * y, const float * a, const float * b, float scale, uint32_t n) {
+    impl_select()->mult(y, a, b, scale, n);
+}
+
+void jsdrv_f32_scale(float * x, float scale, uint32_t n) {
+    impl_select()->scale(x, scale, n);
+}
+
+void jsdrv_f32_sum_reset(struct jsdrv_f32_sum_s * s) {
+    s->count = 0;
+    s->sum = 0.0;
+    s->min = FLT_MAX;
+    s->max = -FLT_MAX;
+}
+
+void jsdrv_f32_sum(struct jsdrv_f32_sum_s * s, const float * x, uint32_t n) {
+    impl_select()->sum(s, x, n);
+}
+
+double jsdrv_f32_sum_sq_diff(const float * x, uint32_t n, double mean) {
+    return impl_select()->sum_sq_diff(x, n, mean);
+}
+
+int32_t jsdrv_f32_summary_combine(struct jsdrv_summary_entry_s * y, const struct jsdrv_summary_entry_s * x, uint32_t n) {
+    return impl_select()->combine(y, x, n);
+}
+
+const char * jsdrv_f32_impl(void) {
+    return impl_select()->name;
+}
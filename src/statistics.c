@@ -15,9 +15,13 @@
  */
 
 #include "jsdrv_prv/statistics.h"
+#include "jsdrv_prv/cpu.h"
+#include "jsdrv_prv/simd_f32.h"
+#include "jsdrv_prv/thread.h"
 #include "jsdrv.h"  // for struct jsdrv_summary_entry_s, otherwise independent
 #include <float.h>
 #include <math.h>
+#include <stdbool.h>
 
 void jsdrv_statistics_reset(struct jsdrv_statistics_accum_s *s) {
     s->k = 0;
@@ -42,17 +46,32 @@ void jsdrv_statistics_invalid(struct jsdrv_statistics_accum_s *s) {
     s->max = NAN;
 }
 
-void jsdrv_statistics_compute_f32(struct jsdrv_statistics_accum_s * s, const float * x, uint64_t length) {
-    if (length <= 0) {
-        jsdrv_statistics_reset(s);
-        return;
+// Each block is small enough to stay in the L1 cache, so the
+// two passes over a block read the array from memory only once.
+static void block_f32(struct jsdrv_statistics_accum_s * b, const float * x, uint32_t n, bool * nan) {
+    struct jsdrv_f32_sum_s sum;
+    jsdrv_f32_sum_reset(&sum);
+    jsdrv_f32_sum(&sum, x, n);
+    b->k = n;
+    b->min = sum.count ? sum.min : DBL_MAX;
+    b->max = sum.count ? sum.max : -DBL_MAX;
+    if (sum.count != n) {
+        *nan = true;  // the result mean and variance are NaN
+        b->mean = 0.0;
+        b->s = 0.0;
+    } else {
+        b->mean = sum.sum / n;
+        b->s = jsdrv_f32_sum_sq_diff(x, n, b->mean);
     }
-    float v;
+}
+
+static void block_f64(struct jsdrv_statistics_accum_s * b, const double * x, uint32_t n, bool * nan) {
+    double v;
     double v_mean = 0.0;
-    float v_min = FLT_MAX;
-    float v_max = -FLT_MAX;
+    double v_min = DBL_MAX;
+    double v_max = -DBL_MAX;
     double v_var = 0.0;
-    for (uint64_t i = 0; i < length; ++i) {
+    for (uint32_t i = 0; i < n; ++i) {
         v = x[i];
         v_mean += v;
         if (v < v_min) {
@@ -62,50 +81,153 @@ void jsdrv_statistics_compute_f32(struct jsdrv_statistics_accum_s * s, const flo
             v_max = v;
         }
     }
-    v_mean /= length;
-    double m;
-    for (uint64_t i = 0; i < length; ++i) {
-        m = x[i] - v_mean;
-        v_var += (m * m);
+    v_mean /= n;
+    if (isnan(v_mean)) {
+        *nan = true;
+        v_mean = 0.0;
+    } else {
+        double m;
+        for (uint32_t i = 0; i < n; ++i) {
+            m = x[i] - v_mean;
+            v_var += (m * m);
+        }
+    }
+    b->k = n;
+    b->mean = v_mean;
+    b->s = v_var;
+    b->min = v_min;
+    b->max = v_max;
+}
+
+static void compute_f32(struct jsdrv_statistics_accum_s * s, const float * x, uint64_t length) {
+    struct jsdrv_statistics_accum_s b;
+    bool nan = false;
+    jsdrv_statistics_reset(s);
+    for (uint64_t i = 0; i < length; i += JSDRV_STATISTICS_BLOCK_SIZE) {
+        uint64_t n = length - i;
+        block_f32(&b, x + i, (uint32_t) ((n > JSDRV_STATISTICS_BLOCK_SIZE) ? JSDRV_STATISTICS_BLOCK_SIZE : n), &nan);
+        jsdrv_statistics_combine(s, s, &b);
+    }
+    if (nan) {
+        s->mean = NAN;
+        s->s = NAN;
+    }
+}
+
+static void compute_f64(struct jsdrv_statistics_accum_s * s, const double * x, uint64_t length) {
+    struct jsdrv_statistics_accum_s b;
+    bool nan = false;
+    jsdrv_statistics_reset(s);
+    for (uint64_t i = 0; i < length; i += JSDRV_STATISTICS_BLOCK_SIZE) {
+        uint64_t n = length - i;
+        block_f64(&b, x + i, (uint32_t) ((n > JSDRV_STATISTICS_BLOCK_SIZE) ? JSDRV_STATISTICS_BLOCK_SIZE : n), &nan);
+        jsdrv_statistics_combine(s, s, &b);
+    }
+    if (nan) {
+        s->mean = NAN;
+        s->s = NAN;
     }
-    s->k = length;
-    s->mean = v_mean;
-    s->s = v_var;
-    s->min = v_min;
-    s->max = v_max;
+}
+
+void jsdrv_statistics_compute_f32(struct jsdrv_statistics_accum_s * s, const float * x, uint64_t length) {
+    compute_f32(s, x, length);
 }
 
 void jsdrv_statistics_compute_f64(struct jsdrv_statistics_accum_s * s, const double * x, uint64_t length)  {
-    if (length <= 0) {
-        jsdrv_statistics_reset(s);
-        return;
+    compute_f64(s, x, length);
+}
+
+struct part_s {
+    jsdrv_thread_t thread;
+    const void * x;
+    uint64_t length;
+    bool is_f64;
+    bool started;  // thread created, join required
+    struct jsdrv_statistics_accum_s s;
+};
+
+static THREAD_RETURN_TYPE part_thread(THREAD_ARG_TYPE arg) {
+    struct part_s * p = (struct part_s *) arg;
+    if (p->is_f64) {
+        compute_f64(&p->s, (const double *) p->x, p->length);
+    } else {
+        compute_f32(&p->s, (const float *) p->x, p->length);
     }
-    double v;
-    double v_mean = 0.0;
-    double v_min = DBL_MAX;
-    double v_max = -DBL_MAX;
-    double v_var = 0.0;
-    for (uint64_t i = 0; i < length; ++i) {
-        v = x[i];
-        v_mean += v;
-        if (v < v_min) {
-            v_min = v;
+    THREAD_RETURN();
+}
+
+static void compute_parallel(struct jsdrv_statistics_accum_s * s, const void * x, uint64_t length,
+                             bool is_f64, uint32_t threads) {
+    struct part_s parts[JSDRV_STATISTICS_THREADS_MAX];
+    uint32_t element_size = is_f64 ? sizeof(double) : sizeof(float);
+    if (0 == threads) {
+        threads = jsdrv_cpu_count();
+    }
+    uint64_t threads_max = length / JSDRV_STATISTICS_PARALLEL_MIN;
+    if (threads > threads_max) {
+        threads = (uint32_t) threads_max;
+    }
+    if (threads > JSDRV_STATISTICS_THREADS_MAX) {
+        threads = JSDRV_STATISTICS_THREADS_MAX;
+    }
+    if (threads <= 1) {
+        threads = 1;
+    }
+
+    // split on block boundaries so the result matches the serial computation order within each part
+    uint64_t blocks = (length + JSDRV_STATISTICS_BLOCK_SIZE - 1) / JSDRV_STATISTICS_BLOCK_SIZE;
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < threads; ++i) {
+        struct part_s * p = &parts[i];
+        uint64_t end = ((blocks * (i + 1)) / threads) * JSDRV_STATISTICS_BLOCK_SIZE;
+        if (end > length) {
+            end = length;
         }
-        if (v > v_max) {
-            v_max = v;
+        p->x = ((const uint8_t *) x) + offset * element_size;
+        p->length = end - offset;
+        p->is_f64 = is_f64;
+        p->started = false;
+        offset = end;
+        if ((i + 1) < threads) {  // the calling thread computes the last part
+            if (jsdrv_thread_create(&p->thread, part_thread, p, 0)) {
+                part_thread(p);  // compute inline on failure
+            } else {
+                p->started = true;
+            }
+        }
+    }
+    part_thread(&parts[threads - 1]);
+    for (uint32_t i = 0; i < threads; ++i) {
+        if (parts[i].started) {
+            jsdrv_thread_join(&parts[i].thread, UINT32_MAX);
         }
     }
-    v_mean /= length;
-    double m;
-    for (uint64_t i = 0; i < length; ++i) {
-        m = x[i] - v_mean;
-        v_var += (m * m);
+
+    bool nan = false;
+    jsdrv_statistics_reset(s);
+    for (uint32_t i = 0; i < threads; ++i) {
+        struct jsdrv_statistics_accum_s * b = &parts[i].s;
+        if (isnan(b->mean)) {
+            nan = true;
+            b->mean = 0.0;
+            b->s = 0.0;
+        }
+        jsdrv_statistics_combine(s, s, b);
     }
-    s->k = length;
-    s->mean = v_mean;
-    s->s = v_var;
-    s->min = v_min;
-    s->max = v_max;
+    if (nan) {
+        s->mean = NAN;
+        s->s = NAN;
+    }
+}
+
+void jsdrv_statistics_compute_f32_parallel(struct jsdrv_statistics_accum_s * s, const float * x,
+                                           uint64_t length, uint32_t threads) {
+    compute_parallel(s, x, length, false, threads);
+}
+
+void jsdrv_statistics_compute_f64_parallel(struct jsdrv_statistics_accum_s * s, const double * x,
+                                           uint64_t length, uint32_t threads) {
+    compute_parallel(s, x, length, true, threads);
 }
 
 void jsdrv_statistics_add(struct jsdrv_statistics_accum_s *s, double x) {
@@ -168,6 +290,26 @@ void jsdrv_statistics_combine(struct jsdrv_statistics_accum_s *tgt,
     }
 }
 
+void jsdrv_statistics_combine_envelope(struct jsdrv_statistics_accum_s *tgt,
+                                      const struct jsdrv_statistics_accum_s *a,
+                                      const struct jsdrv_statistics_accum_s *b) {
+    uint64_t kt = a->k + b->k;
+    if (kt == 0) {
+        jsdrv_statistics_reset(tgt);
+    } else if (a->k == 0) {
+        jsdrv_statistics_copy(tgt, b);
+    } else if (b->k == 0) {
+        jsdrv_statistics_copy(tgt, a);
+    } else {
+        double f1 = a->k / (double) kt;
+        tgt->mean = f1 * a->mean + (1.0 - f1) * b->mean;
+        tgt->min = (a->min < b->min) ? a->min : b->min;
+        tgt->max = (a->max > b->max) ? a->max : b->max;
+        tgt->k = kt;
+    }
+    tgt->s = NAN;
+}
+
 void jsdrv_statistics_from_entry(struct jsdrv_statistics_accum_s * s, struct jsdrv_summary_entry_s const * e, uint64_t k) {
     s->k = k;
     s->mean = e->avg;
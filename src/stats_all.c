@@ -0,0 +1,225 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/stats_all.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/dbc.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/time.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+
+#define STATS_TOPIC_SUFFIX "/s/stats/value"
+#define STATS_TOPIC_WILDCARD "u/+/+" STATS_TOPIC_SUFFIX
+
+static const char * period_meta = "{"
+    "\"dtype\": \"u32\","
+    "\"brief\": \"The combined statistics period in milliseconds.\","
+    "\"detail\": \"Combine the latest statistics from all devices into @/stats/!all.  0 disables.\","
+    "\"default\": 0"
+"}";
+
+struct jsdrv_stats_all_svc_s {
+    struct jsdrv_context_s * context;
+    uint32_t period_ms;
+    uint32_t publish_ms;
+    bool subscribed;
+    struct jsdrv_statistics_all_s all;
+};
+
+void jsdrv_stats_all_clear(struct jsdrv_statistics_all_s * self) {
+    memset(self, 0, offsetof(struct jsdrv_statistics_all_s, entries));
+    self->version = 1;
+}
+
+static int32_t entry_find(const struct jsdrv_statistics_all_s * self, const char * device) {
+    for (int32_t idx = 0; idx < (int32_t) self->count; ++idx) {
+        if (0 == strcmp(self->entries[idx].device, device)) {
+            return idx;
+        }
+    }
+    return -1;
+}
+
+static void entry_delete(struct jsdrv_statistics_all_s * self, uint32_t idx) {
+    --self->count;
+    memmove(&self->entries[idx], &self->entries[idx + 1],
+            (self->count - idx) * sizeof(struct jsdrv_statistics_all_entry_s));
+}
+
+static int64_t block_end_utc(const struct jsdrv_statistics_s * s) {
+    if (s->time_map.counter_rate <= 0.0) {
+        return 0;
+    }
+    uint64_t counter = s->block_sample_id + (uint64_t) s->block_sample_count * s->decimate_factor;
+    return jsdrv_time_from_counter(&s->time_map, counter);
+}
+
+int32_t jsdrv_stats_all_update(struct jsdrv_statistics_all_s * self, const char * device,
+                               const struct jsdrv_statistics_s * statistics) {
+    if (!self || !device || !statistics || !device[0] || (strlen(device) >= JSDRV_TOPIC_LENGTH_MAX)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    int32_t idx = entry_find(self, device);
+    if (idx >= 0) {
+        entry_delete(self, (uint32_t) idx);
+    } else if (self->count >= JSDRV_STATISTICS_ALL_DEVICES_MAX) {
+        return JSDRV_ERROR_FULL;
+    }
+    int64_t utc = block_end_utc(statistics);
+    uint32_t k = self->count;
+    while (k && (self->entries[k - 1].utc > utc)) {  // usually the newest
+        --k;
+    }
+    memmove(&self->entries[k + 1], &self->entries[k],
+            (self->count - k) * sizeof(struct jsdrv_statistics_all_entry_s));
+    struct jsdrv_statistics_all_entry_s * e = &self->entries[k];
+    jsdrv_cstr_copy(e->device, device, sizeof(e->device));
+    e->utc = utc;
+    e->statistics = *statistics;
+    ++self->count;
+    return 0;
+}
+
+int32_t jsdrv_stats_all_remove(struct jsdrv_statistics_all_s * self, const char * device) {
+    int32_t idx = entry_find(self, device);
+    if (idx < 0) {
+        return JSDRV_ERROR_NOT_FOUND;
+    }
+    entry_delete(self, (uint32_t) idx);
+    return 0;
+}
+
+uint32_t jsdrv_stats_all_size(const struct jsdrv_statistics_all_s * self) {
+    return (uint32_t) (offsetof(struct jsdrv_statistics_all_s, entries)
+        + self->count * sizeof(struct jsdrv_statistics_all_entry_s));
+}
+
+static void send_to_frontend(struct jsdrv_stats_all_svc_s * self, const char * topic, const struct jsdrv_union_s * value) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, topic, value);
+    jsdrvp_backend_send(self->context, m);
+}
+
+static void subscription(struct jsdrv_context_s * context, const char * op, const char * topic,
+                         jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
+    jsdrv_cstr_copy(m->topic, op, sizeof(m->topic));
+    m->value.type = JSDRV_UNION_BIN;
+    m->value.value.bin = m->payload.bin;
+    m->value.app = JSDRV_PAYLOAD_TYPE_SUB;
+    jsdrv_cstr_copy(m->payload.sub.topic, topic, sizeof(m->payload.sub.topic));
+    m->payload.sub.subscriber.internal_fn = cbk_fn;
+    m->payload.sub.subscriber.user_data = cbk_user_data;
+    m->payload.sub.subscriber.is_internal = 1;
+    m->payload.sub.subscriber.flags = JSDRV_SFLAG_PUB;
+    jsdrvp_backend_send(context, m);
+}
+
+static void all_publish(struct jsdrv_stats_all_svc_s * self) {
+    uint32_t size = jsdrv_stats_all_size(&self->all);
+    self->all.utc = jsdrv_time_utc();
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_data_sz(self->context, JSDRV_MSG_STATISTICS_ALL, size);
+    memcpy(m->payload.bin, &self->all, size);
+    m->value.size = size;
+    m->value.app = JSDRV_PAYLOAD_TYPE_STATISTICS_ALL;
+    jsdrvp_backend_send(self->context, m);
+}
+
+static uint8_t on_stats(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct jsdrv_stats_all_svc_s * self = (struct jsdrv_stats_all_svc_s *) user_data;
+    char device[JSDRV_TOPIC_LENGTH_MAX];
+    if ((msg->value.type != JSDRV_UNION_BIN) || (msg->value.app != JSDRV_PAYLOAD_TYPE_STATISTICS)
+            || (msg->value.size < sizeof(struct jsdrv_statistics_s)) || !self->period_ms) {
+        return 0;
+    }
+    size_t sz = strlen(msg->topic);
+    if (sz <= (sizeof(STATS_TOPIC_SUFFIX) - 1)) {
+        return 0;
+    }
+    sz -= sizeof(STATS_TOPIC_SUFFIX) - 1;
+    memcpy(device, msg->topic, sz);
+    device[sz] = 0;
+    if (jsdrv_stats_all_update(&self->all, device, (const struct jsdrv_statistics_s *) msg->value.value.bin)) {
+        return 0;  // more than JSDRV_STATISTICS_ALL_DEVICES_MAX devices
+    }
+    uint32_t now = jsdrv_time_ms_u32();
+    if ((now - self->publish_ms) >= self->period_ms) {
+        self->publish_ms = now;
+        all_publish(self);
+    }
+    return 0;
+}
+
+static uint8_t on_period(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct jsdrv_stats_all_svc_s * self = (struct jsdrv_stats_all_svc_s *) user_data;
+    struct jsdrv_union_s v = msg->value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    self->period_ms = v.value.u32;
+    if (self->period_ms && !self->subscribed) {
+        JSDRV_LOGI("combined statistics period %u ms", (unsigned int) self->period_ms);
+        self->publish_ms = jsdrv_time_ms_u32() - self->period_ms;
+        subscription(self->context, JSDRV_PUBSUB_SUBSCRIBE, STATS_TOPIC_WILDCARD, on_stats, self);
+        self->subscribed = true;
+    } else if (!self->period_ms && self->subscribed) {
+        JSDRV_LOGI("combined statistics disabled");
+        subscription(self->context, JSDRV_PUBSUB_UNSUBSCRIBE, STATS_TOPIC_WILDCARD, on_stats, self);
+        self->subscribed = false;
+        jsdrv_stats_all_clear(&self->all);
+    }
+    return 0;
+}
+
+static uint8_t on_device_remove(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct jsdrv_stats_all_svc_s * self = (struct jsdrv_stats_all_svc_s *) user_data;
+    if (msg->value.type == JSDRV_UNION_STR) {
+        jsdrv_stats_all_remove(&self->all, msg->value.value.str);
+    }
+    return 0;
+}
+
+int32_t jsdrv_stats_all_initialize(struct jsdrv_context_s * context, struct jsdrv_stats_all_svc_s ** instance) {
+    JSDRV_DBC_NOT_NULL(context);
+    JSDRV_DBC_NOT_NULL(instance);
+    struct jsdrv_stats_all_svc_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_stats_all_svc_s));
+    self->context = context;
+    jsdrv_stats_all_clear(&self->all);
+    send_to_frontend(self, JSDRV_MSG_STATISTICS_PERIOD "$", &jsdrv_union_cjson_r(period_meta));
+    send_to_frontend(self, JSDRV_MSG_STATISTICS_PERIOD, &jsdrv_union_u32_r(0));
+    subscription(context, JSDRV_PUBSUB_SUBSCRIBE, JSDRV_MSG_STATISTICS_PERIOD, on_period, self);
+    subscription(context, JSDRV_PUBSUB_SUBSCRIBE, JSDRV_MSG_DEVICE_REMOVE, on_device_remove, self);
+    *instance = self;
+    return 0;
+}
+
+void jsdrv_stats_all_finalize(struct jsdrv_stats_all_svc_s * self) {
+    if (self) {
+        subscription(self->context, JSDRV_PUBSUB_UNSUBSCRIBE, JSDRV_MSG_STATISTICS_PERIOD, on_period, self);
+        subscription(self->context, JSDRV_PUBSUB_UNSUBSCRIBE, JSDRV_MSG_DEVICE_REMOVE, on_device_remove, self);
+        if (self->subscribed) {
+            subscription(self->context, JSDRV_PUBSUB_UNSUBSCRIBE, STATS_TOPIC_WILDCARD, on_stats, self);
+            self->subscribed = false;
+        }
+        jsdrv_free(self);
+    }
+}
@@ -0,0 +1,349 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/stats_history.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/dbc.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/time.h"
+#include "tinyprintf.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+
+#define STATS_TOPIC_SUFFIX "/s/stats/value"
+#define STATS_TOPIC_WILDCARD "u/+/+" STATS_TOPIC_SUFFIX
+
+JSDRV_STATIC_ASSERT(sizeof(struct jsdrv_statistics_history_response_s) <= sizeof(struct jsdrv_stream_signal_s),
+                    history_response_size);
+
+static const char * history_meta = "{"
+    "\"dtype\": \"u32\","
+    "\"brief\": \"The statistics history records for each device.\","
+    "\"detail\": \"Retain the most recent statistics updates from each device for @/stats/!hist requests.  Changes discard the retained records.  0 disables.\","
+    "\"default\": 0,"
+    "\"range\": [0, 65536]"
+"}";
+
+struct jsdrv_stats_history_s {
+    uint32_t capacity;
+    uint32_t head;   // the next record index to write
+    uint32_t size;
+    struct jsdrv_statistics_s records[];
+};
+
+struct device_s {
+    char prefix[JSDRV_TOPIC_LENGTH_MAX];
+    struct jsdrv_stats_history_s * history;  // NULL when unused
+};
+
+struct jsdrv_stats_history_svc_s {
+    struct jsdrv_context_s * context;
+    uint32_t capacity;
+    bool subscribed;
+    struct device_s devices[JSDRV_STATS_HISTORY_DEVICES_MAX];
+    struct jsdrv_statistics_history_response_s rsp;  // the response workspace
+};
+
+struct jsdrv_stats_history_s * jsdrv_stats_history_alloc(uint32_t capacity) {
+    if ((0 == capacity) || (capacity > JSDRV_STATISTICS_HISTORY_MAX)) {
+        return NULL;
+    }
+    struct jsdrv_stats_history_s * self = jsdrv_alloc(sizeof(struct jsdrv_stats_history_s)
+        + capacity * sizeof(struct jsdrv_statistics_s));
+    self->capacity = capacity;
+    self->head = 0;
+    self->size = 0;
+    return self;
+}
+
+void jsdrv_stats_history_free(struct jsdrv_stats_history_s * self) {
+    if (self) {
+        jsdrv_free(self);
+    }
+}
+
+void jsdrv_stats_history_add(struct jsdrv_stats_history_s * self, const struct jsdrv_statistics_s * statistics) {
+    self->records[self->head] = *statistics;
+    self->head = (self->head + 1 == self->capacity) ? 0 : (self->head + 1);
+    if (self->size < self->capacity) {
+        ++self->size;
+    }
+}
+
+uint32_t jsdrv_stats_history_size(struct jsdrv_stats_history_s * self) {
+    return self ? self->size : 0;
+}
+
+static const struct jsdrv_statistics_s * record_get(struct jsdrv_stats_history_s * self, uint32_t idx) {
+    uint32_t k = self->head + self->capacity - self->size + idx;  // oldest first
+    return &self->records[k % self->capacity];
+}
+
+static bool record_match(const struct jsdrv_statistics_history_request_s * req, const struct jsdrv_statistics_s * s) {
+    if (JSDRV_TIME_SAMPLES == req->time_type) {
+        uint64_t t = s->block_sample_id;
+        return (t >= req->time.samples.start) && (!req->time.samples.end || (t <= req->time.samples.end));
+    }
+    int64_t t = 0;
+    if (s->time_map.counter_rate > 0.0) {
+        t = jsdrv_time_from_counter(&s->time_map, s->block_sample_id);
+    }
+    return (t >= req->time.utc.start) && (!req->time.utc.end || (t <= req->time.utc.end));
+}
+
+int32_t jsdrv_stats_history_query(struct jsdrv_stats_history_s * self,
+                                  const struct jsdrv_statistics_history_request_s * req,
+                                  struct jsdrv_statistics_history_response_s * rsp,
+                                  jsdrv_stats_history_rsp_fn fn, void * user_data) {
+    if (!req || !rsp || !fn || (1 != req->version)
+            || ((JSDRV_TIME_SAMPLES != req->time_type) && (JSDRV_TIME_UTC != req->time_type))) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    uint32_t size = jsdrv_stats_history_size(self);
+    uint64_t length = (JSDRV_TIME_SAMPLES == req->time_type) ? req->time.samples.length : req->time.utc.length;
+    uint64_t total = 0;
+    for (uint32_t idx = 0; idx < size; ++idx) {
+        total += record_match(req, record_get(self, idx)) ? 1 : 0;
+    }
+    uint64_t skip = (length && (total > length)) ? (total - length) : 0;
+
+    memset(rsp, 0, offsetof(struct jsdrv_statistics_history_response_s, data));
+    rsp->version = 1;
+    rsp->rsp_id = req->rsp_id;
+    rsp->total = total - skip;
+    uint64_t remaining = rsp->total;
+    for (uint32_t idx = 0; remaining && (idx < size); ++idx) {
+        const struct jsdrv_statistics_s * s = record_get(self, idx);
+        if (!record_match(req, s)) {
+            continue;
+        } else if (skip) {
+            --skip;  // keep only the most recent length records
+            continue;
+        }
+        rsp->data[rsp->count++] = *s;
+        --remaining;
+        if ((JSDRV_STATISTICS_HISTORY_RESPONSE_COUNT == rsp->count) || !remaining) {
+            rsp->flags = remaining ? 0 : JSDRV_BUFFER_RESPONSE_FLAG_FINAL;
+            fn(user_data, rsp);
+            ++rsp->seq;
+            rsp->count = 0;
+        }
+    }
+    if (0 == rsp->total) {
+        rsp->flags = JSDRV_BUFFER_RESPONSE_FLAG_FINAL;
+        fn(user_data, rsp);
+    }
+    return 0;
+}
+
+static void send_to_frontend(struct jsdrv_stats_history_svc_s * self, const char * topic, const struct jsdrv_union_s * value) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, topic, value);
+    jsdrvp_backend_send(self->context, m);
+}
+
+static void subscription(struct jsdrv_context_s * context, const char * op, const char * topic,
+                         jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
+    jsdrv_cstr_copy(m->topic, op, sizeof(m->topic));
+    m->value.type = JSDRV_UNION_BIN;
+    m->value.value.bin = m->payload.bin;
+    m->value.app = JSDRV_PAYLOAD_TYPE_SUB;
+    jsdrv_cstr_copy(m->payload.sub.topic, topic, sizeof(m->payload.sub.topic));
+    m->payload.sub.subscriber.internal_fn = cbk_fn;
+    m->payload.sub.subscriber.user_data = cbk_user_data;
+    m->payload.sub.subscriber.is_internal = 1;
+    m->payload.sub.subscriber.flags = JSDRV_SFLAG_PUB;
+    jsdrvp_backend_send(context, m);
+}
+
+static uint8_t send_return_code_to_frontend(struct jsdrv_context_s * context, const char * topic, int32_t rc,
+        jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
+    struct jsdrvp_msg_s * m;
+    m = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_i32(rc));
+    tfp_snprintf(m->topic, sizeof(m->topic), "%s%c", topic, JSDRV_TOPIC_SUFFIX_RETURN_CODE);
+    m->extra.frontend.subscriber.internal_fn = cbk_fn;
+    m->extra.frontend.subscriber.user_data = cbk_user_data;
+    m->extra.frontend.subscriber.is_internal = 1;
+    jsdrvp_backend_send(context, m);
+    return (uint8_t) rc;
+}
+
+static struct device_s * device_find(struct jsdrv_stats_history_svc_s * self, const char * prefix) {
+    for (uint32_t idx = 0; idx < JSDRV_STATS_HISTORY_DEVICES_MAX; ++idx) {
+        struct device_s * d = &self->devices[idx];
+        if (d->history && (0 == strcmp(d->prefix, prefix))) {
+            return d;
+        }
+    }
+    return NULL;
+}
+
+static struct device_s * device_add(struct jsdrv_stats_history_svc_s * self, const char * prefix) {
+    for (uint32_t idx = 0; idx < JSDRV_STATS_HISTORY_DEVICES_MAX; ++idx) {
+        struct device_s * d = &self->devices[idx];
+        if (!d->history) {
+            d->history = jsdrv_stats_history_alloc(self->capacity);
+            jsdrv_cstr_copy(d->prefix, prefix, sizeof(d->prefix));
+            return d;
+        }
+    }
+    return NULL;
+}
+
+static void device_free(struct device_s * d) {
+    jsdrv_stats_history_free(d->history);
+    d->history = NULL;
+    d->prefix[0] = 0;
+}
+
+static void devices_free(struct jsdrv_stats_history_svc_s * self) {
+    for (uint32_t idx = 0; idx < JSDRV_STATS_HISTORY_DEVICES_MAX; ++idx) {
+        device_free(&self->devices[idx]);
+    }
+}
+
+static uint8_t on_stats(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct jsdrv_stats_history_svc_s * self = (struct jsdrv_stats_history_svc_s *) user_data;
+    char prefix[JSDRV_TOPIC_LENGTH_MAX];
+    if ((msg->value.type != JSDRV_UNION_BIN) || (msg->value.app != JSDRV_PAYLOAD_TYPE_STATISTICS)
+            || (msg->value.size < sizeof(struct jsdrv_statistics_s)) || !self->capacity) {
+        return 0;
+    }
+    size_t sz = strlen(msg->topic);
+    if (sz <= (sizeof(STATS_TOPIC_SUFFIX) - 1)) {
+        return 0;
+    }
+    sz -= sizeof(STATS_TOPIC_SUFFIX) - 1;
+    memcpy(prefix, msg->topic, sz);
+    prefix[sz] = 0;
+    struct device_s * d = device_find(self, prefix);
+    if (!d) {
+        d = device_add(self, prefix);
+        if (!d) {
+            return 0;  // more than JSDRV_STATS_HISTORY_DEVICES_MAX devices
+        }
+    }
+    jsdrv_stats_history_add(d->history, (const struct jsdrv_statistics_s *) msg->value.value.bin);
+    return 0;
+}
+
+static uint8_t on_history(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct jsdrv_stats_history_svc_s * self = (struct jsdrv_stats_history_svc_s *) user_data;
+    struct jsdrv_union_s v = msg->value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+        return send_return_code_to_frontend(self->context, JSDRV_MSG_STATISTICS_HISTORY, JSDRV_ERROR_PARAMETER_INVALID,
+                                            on_history, self);
+    }
+    uint32_t capacity = (v.value.u32 > JSDRV_STATISTICS_HISTORY_MAX) ? JSDRV_STATISTICS_HISTORY_MAX : v.value.u32;
+    if (capacity == self->capacity) {
+        return send_return_code_to_frontend(self->context, JSDRV_MSG_STATISTICS_HISTORY, 0, on_history, self);
+    }
+    devices_free(self);
+    self->capacity = capacity;
+    if (self->capacity && !self->subscribed) {
+        JSDRV_LOGI("statistics history %u records", (unsigned int) self->capacity);
+        subscription(self->context, JSDRV_PUBSUB_SUBSCRIBE, STATS_TOPIC_WILDCARD, on_stats, self);
+        self->subscribed = true;
+    } else if (!self->capacity && self->subscribed) {
+        JSDRV_LOGI("statistics history disabled");
+        subscription(self->context, JSDRV_PUBSUB_UNSUBSCRIBE, STATS_TOPIC_WILDCARD, on_stats, self);
+        self->subscribed = false;
+    }
+    return send_return_code_to_frontend(self->context, JSDRV_MSG_STATISTICS_HISTORY, 0, on_history, self);
+}
+
+struct rsp_ctx_s {
+    struct jsdrv_stats_history_svc_s * self;
+    const char * topic;
+};
+
+static void on_rsp(void * user_data, struct jsdrv_statistics_history_response_s * rsp) {
+    struct rsp_ctx_s * ctx = (struct rsp_ctx_s *) user_data;
+    struct jsdrv_stats_history_svc_s * self = ctx->self;
+    uint32_t size = (uint32_t) (offsetof(struct jsdrv_statistics_history_response_s, data)
+        + rsp->count * sizeof(struct jsdrv_statistics_s));
+    struct jsdrvp_msg_s * r = jsdrvp_msg_alloc_data_sz(self->context, ctx->topic, size);
+    memcpy(r->payload.bin, rsp, size);
+    r->value.size = size;
+    r->value.app = JSDRV_PAYLOAD_TYPE_STATISTICS_HISTORY_RSP;
+    jsdrvp_backend_send(self->context, r);
+}
+
+static uint8_t on_request(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct jsdrv_stats_history_svc_s * self = (struct jsdrv_stats_history_svc_s *) user_data;
+    struct jsdrv_statistics_history_request_s req;
+    if ((msg->value.type != JSDRV_UNION_BIN) || (msg->value.size < sizeof(req))) {
+        JSDRV_LOGW("invalid statistics history request");
+        return send_return_code_to_frontend(self->context, JSDRV_MSG_STATISTICS_HISTORY_REQ,
+                                            JSDRV_ERROR_PARAMETER_INVALID, on_request, self);
+    }
+    memcpy(&req, msg->value.value.bin, sizeof(req));
+    req.device[sizeof(req.device) - 1] = 0;
+    req.rsp_topic[sizeof(req.rsp_topic) - 1] = 0;
+    if (!req.rsp_topic[0]) {
+        return send_return_code_to_frontend(self->context, JSDRV_MSG_STATISTICS_HISTORY_REQ,
+                                            JSDRV_ERROR_PARAMETER_INVALID, on_request, self);
+    }
+    struct device_s * d = device_find(self, req.device);
+    struct rsp_ctx_s ctx = {.self = self, .topic = req.rsp_topic};
+    int32_t rc = jsdrv_stats_history_query(d ? d->history : NULL, &req, &self->rsp, on_rsp, &ctx);
+    return send_return_code_to_frontend(self->context, JSDRV_MSG_STATISTICS_HISTORY_REQ, rc, on_request, self);
+}
+
+static uint8_t on_device_remove(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct jsdrv_stats_history_svc_s * self = (struct jsdrv_stats_history_svc_s *) user_data;
+    if (msg->value.type == JSDRV_UNION_STR) {
+        struct device_s * d = device_find(self, msg->value.value.str);
+        if (d) {
+            device_free(d);
+        }
+    }
+    return 0;
+}
+
+int32_t jsdrv_stats_history_initialize(struct jsdrv_context_s * context, struct jsdrv_stats_history_svc_s ** instance) {
+    JSDRV_DBC_NOT_NULL(context);
+    JSDRV_DBC_NOT_NULL(instance);
+    struct jsdrv_stats_history_svc_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_stats_history_svc_s));
+    self->context = context;
+    send_to_frontend(self, JSDRV_MSG_STATISTICS_HISTORY "$", &jsdrv_union_cjson_r(history_meta));
+    send_to_frontend(self, JSDRV_MSG_STATISTICS_HISTORY, &jsdrv_union_u32_r(0));
+    subscription(context, JSDRV_PUBSUB_SUBSCRIBE, JSDRV_MSG_STATISTICS_HISTORY, on_history, self);
+    subscription(context, JSDRV_PUBSUB_SUBSCRIBE, JSDRV_MSG_STATISTICS_HISTORY_REQ, on_request, self);
+    subscription(context, JSDRV_PUBSUB_SUBSCRIBE, JSDRV_MSG_DEVICE_REMOVE, on_device_remove, self);
+    *instance = self;
+    return 0;
+}
+
+void jsdrv_stats_history_finalize(struct jsdrv_stats_history_svc_s * self) {
+    if (self) {
+        subscription(self->context, JSDRV_PUBSUB_UNSUBSCRIBE, JSDRV_MSG_STATISTICS_HISTORY, on_history, self);
+        subscription(self->context, JSDRV_PUBSUB_UNSUBSCRIBE, JSDRV_MSG_STATISTICS_HISTORY_REQ, on_request, self);
+        subscription(self->context, JSDRV_PUBSUB_UNSUBSCRIBE, JSDRV_MSG_DEVICE_REMOVE, on_device_remove, self);
+        if (self->subscribed) {
+            subscription(self->context, JSDRV_PUBSUB_UNSUBSCRIBE, STATS_TOPIC_WILDCARD, on_stats, self);
+            self->subscribed = false;
+        }
+        devices_free(self);
+        jsdrv_free(self);
+    }
+}
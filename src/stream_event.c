@@ -0,0 +1,93 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/stream_event.h"
+#include <stdbool.h>
+
+
+static inline bool event_append(struct jsdrv_stream_signal_s * s, uint32_t * size, uint32_t capacity,
+                                uint32_t offset, uint32_t value) {
+    if ((*size + sizeof(struct jsdrv_stream_event_s)) > capacity) {
+        return false;
+    }
+    struct jsdrv_stream_event_s * e = (struct jsdrv_stream_event_s *) &s->data[*size - JSDRV_STREAM_HEADER_SIZE];
+    e->offset = offset;
+    e->value = value;
+    *size += sizeof(struct jsdrv_stream_event_s);
+    return true;
+}
+
+static inline bool event_last(const struct jsdrv_stream_signal_s * s, uint32_t size, uint32_t * value) {
+    uint32_t count = jsdrv_stream_event_count(size);
+    if (0 == count) {
+        return false;
+    }
+    const struct jsdrv_stream_event_s * e = (const struct jsdrv_stream_event_s *) s->data;
+    *value = e[count - 1].value;
+    return true;
+}
+
+uint32_t jsdrv_stream_event_add_packed(struct jsdrv_stream_signal_s * s, uint32_t * size, uint32_t capacity,
+                                       const uint8_t * x, uint32_t offset, uint32_t n) {
+    uint32_t bits = s->element_size_bits;
+    uint32_t per_byte = 8 / bits;
+    uint32_t mask = (1U << bits) - 1;
+    uint32_t value = 0;
+    bool valid = event_last(s, *size, &value);
+    uint8_t fill = (uint8_t) (value * (0xffU / mask));  // value in every element of a byte
+    uint32_t k = 0;
+    while (k < n) {
+        uint32_t idx = offset + k;
+        if (valid && (0 == (idx % per_byte)) && ((n - k) >= per_byte) && (x[idx / per_byte] == fill)) {
+            k += per_byte;  // unchanged byte
+            continue;
+        }
+        uint32_t bit = idx * bits;
+        uint32_t v = (x[bit >> 3] >> (bit & 7)) & mask;
+        if (!valid || (v != value)) {
+            if (!event_append(s, size, capacity, s->element_count + k, v)) {
+                break;
+            }
+            valid = true;
+            value = v;
+            fill = (uint8_t) (value * (0xffU / mask));
+        }
+        ++k;
+    }
+    s->element_count += k;
+    return k;
+}
+
+uint32_t jsdrv_stream_event_add_u8(struct jsdrv_stream_signal_s * s, uint32_t * size, uint32_t capacity,
+                                   const uint8_t * x, uint32_t n) {
+    uint32_t mask = (1U << s->element_size_bits) - 1;
+    uint32_t value = 0;
+    bool valid = event_last(s, *size, &value);
+    uint32_t k = 0;
+    for (; k < n; ++k) {
+        uint32_t v = x[k] & mask;
+        if (valid && (v == value)) {
+            continue;
+        }
+        if (!event_append(s, size, capacity, s->element_count + k, v)) {
+            break;
+        }
+        valid = true;
+        value = v;
+    }
+    s->element_count += k;
+    return k;
+}
@@ -0,0 +1,416 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv/stream_reader.h"
+#include "jsdrv_prv/atomic.h"
+#include "jsdrv_prv/event.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/stream_event.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/time.h"
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+
+#if !_WIN32
+#include <poll.h>
+#endif
+
+
+struct channel_s {
+    struct jsdrv_stream_reader_s * parent;
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    uint8_t element_type;       // JSDRV_DATA_TYPE_FLOAT or JSDRV_DATA_TYPE_UINT
+    uint8_t element_size;       // output bytes per sample
+    uint8_t * data;             // capacity * element_size
+
+    // written by the producer before started
+    uint64_t sample_id0;        // the sample id for ring counter 0
+    uint32_t decimate_factor;
+    uint32_t sample_rate;
+    volatile int32_t started;
+
+    uint64_t head64;            // producer only
+    uint64_t tail64;            // consumer only, may exceed head64 while aligning
+    volatile int32_t head;      // samples written, lower bits of head64
+    volatile int32_t tail;      // samples released, at most head
+    volatile int32_t gap_count;
+    volatile int32_t overrun_count;
+};
+
+struct jsdrv_stream_reader_s {
+    struct jsdrv_context_s * context;
+    uint32_t channel_count;
+    uint32_t capacity;          // power of 2
+    uint32_t mask;
+    bool aligned;               // consumer only
+    volatile int32_t waiting;
+    jsdrv_os_event_t ev;
+    struct channel_s channels[JSDRV_STREAM_READER_CHANNELS_MAX];
+};
+
+static void event_wait(jsdrv_os_event_t ev, uint32_t timeout_ms) {
+#if _WIN32
+    WaitForSingleObject(ev, timeout_ms);
+#else
+    struct pollfd fds = {
+            .fd = ev->fd_poll,
+            .events = ev->events,
+            .revents = 0,
+    };
+    poll(&fds, 1, (int) timeout_ms);
+#endif
+}
+
+static inline uint8_t sample_u8(const struct jsdrv_stream_signal_s * s, uint32_t idx) {
+    switch (s->element_size_bits) {
+        case 1: return (s->data[idx >> 3] >> (idx & 7)) & 1;
+        case 4: return (s->data[idx >> 1] >> ((idx & 1) << 2)) & 0x0f;
+        default: return s->data[idx];
+    }
+}
+
+static void fill(struct channel_s * ch, uint32_t count) {
+    uint8_t * p;
+    for (uint32_t k = 0; k < count; ++k) {
+        p = ch->data + (((uint32_t) ch->head64 + k) & ch->parent->mask) * ch->element_size;
+        if (JSDRV_DATA_TYPE_FLOAT == ch->element_type) {
+            *((float *) p) = NAN;
+        } else {
+            *p = 0;
+        }
+    }
+    ch->head64 += count;
+}
+
+static void write_f32(struct channel_s * ch, const float * x, uint32_t count) {
+    uint32_t mask = ch->parent->mask;
+    float * dst = (float *) ch->data;
+    uint32_t idx = ((uint32_t) ch->head64) & mask;
+    uint32_t n = ch->parent->capacity - idx;
+    if (n > count) {
+        n = count;
+    }
+    memcpy(dst + idx, x, n * sizeof(float));
+    memcpy(dst, x + n, (count - n) * sizeof(float));
+    ch->head64 += count;
+}
+
+static void write_u8(struct channel_s * ch, const struct jsdrv_stream_signal_s * s, uint32_t size,
+                     bool is_event, uint32_t offset, uint32_t count) {
+    uint32_t mask = ch->parent->mask;
+    uint32_t idx = (uint32_t) ch->head64;
+    if (is_event) {
+        const struct jsdrv_stream_event_s * e = (const struct jsdrv_stream_event_s *) s->data;
+        uint32_t e_count = jsdrv_stream_event_count(size);
+        uint32_t e_idx = 0;
+        uint8_t value = 0;
+        for (uint32_t k = offset; k < offset + count; ++k) {
+            while ((e_idx < e_count) && (e[e_idx].offset <= k)) {
+                value = (uint8_t) e[e_idx++].value;
+            }
+            ch->data[(idx++) & mask] = value;
+        }
+    } else if (8 == s->element_size_bits) {
+        uint32_t n = ch->parent->capacity - (idx & mask);
+        if (n > count) {
+            n = count;
+        }
+        memcpy(ch->data + (idx & mask), s->data + offset, n);
+        memcpy(ch->data, s->data + offset + n, count - n);
+    } else {
+        for (uint32_t k = offset; k < offset + count; ++k) {
+            ch->data[(idx++) & mask] = sample_u8(s, k);
+        }
+    }
+    ch->head64 += count;
+}
+
+static bool is_supported(const struct channel_s * ch, const struct jsdrv_stream_signal_s * s) {
+    if (ch->element_type != s->element_type) {
+        return false;
+    } else if (JSDRV_DATA_TYPE_FLOAT == s->element_type) {
+        return 32 == s->element_size_bits;
+    } else {
+        return (1 == s->element_size_bits) || (4 == s->element_size_bits) || (8 == s->element_size_bits);
+    }
+}
+
+// called from the jsdrv frontend thread, the single producer for each channel
+static void on_data(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    (void) topic;
+    struct channel_s * ch = (struct channel_s *) user_data;
+    struct jsdrv_stream_reader_s * self = ch->parent;
+    if ((value->type != JSDRV_UNION_BIN) || (value->size < JSDRV_STREAM_HEADER_SIZE)) {
+        return;
+    }
+    bool is_event = (JSDRV_PAYLOAD_TYPE_STREAM_EVENT == value->app);
+    if (!is_event && (JSDRV_PAYLOAD_TYPE_STREAM != value->app)) {
+        return;
+    }
+    const struct jsdrv_stream_signal_s * s = (const struct jsdrv_stream_signal_s *) value->value.bin;
+    uint32_t count = s->element_count;
+    if (!count || !s->decimate_factor) {
+        return;
+    }
+    if ((is_event && (JSDRV_DATA_TYPE_UINT != ch->element_type)) || (!is_event && !is_supported(ch, s))) {
+        jsdrv_atomic_add(&ch->overrun_count, (int32_t) count);
+        return;
+    }
+    if (!jsdrv_atomic_load(&ch->started)) {
+        ch->sample_id0 = s->sample_id;
+        ch->decimate_factor = s->decimate_factor;
+        ch->sample_rate = s->sample_rate;
+        jsdrv_atomic_store(&ch->started, 1);
+    } else if (s->decimate_factor != ch->decimate_factor) {
+        jsdrv_atomic_add(&ch->overrun_count, (int32_t) count);
+        return;
+    }
+
+    uint32_t used = (uint32_t) jsdrv_atomic_load(&ch->head) - (uint32_t) jsdrv_atomic_load(&ch->tail);
+    uint32_t avail = self->capacity - used;
+    uint64_t expect = ch->sample_id0 + ch->head64 * ch->decimate_factor;
+    uint32_t offset = 0;
+    if (s->sample_id > expect) {
+        uint64_t gap = (s->sample_id - expect) / ch->decimate_factor;
+        uint32_t n = (gap > avail) ? avail : (uint32_t) gap;
+        fill(ch, n);
+        avail -= n;
+        jsdrv_atomic_add(&ch->gap_count, (int32_t) n);
+        if (n < gap) {  // fill the remaining gap as space becomes available
+            avail = 0;
+        }
+    } else if (s->sample_id < expect) {
+        uint64_t skip = (expect - s->sample_id) / ch->decimate_factor;
+        if (skip >= count) {
+            return;  // duplicate
+        }
+        offset = (uint32_t) skip;
+        count -= offset;
+    }
+
+    uint32_t n = (count > avail) ? avail : count;
+    if (n) {
+        if (JSDRV_DATA_TYPE_FLOAT == ch->element_type) {
+            write_f32(ch, ((const float *) s->data) + offset, n);
+        } else {
+            write_u8(ch, s, value->size, is_event, offset, n);
+        }
+    }
+    if (n < count) {
+        jsdrv_atomic_add(&ch->overrun_count, (int32_t) (count - n));
+    }
+    jsdrv_atomic_store(&ch->head, (int32_t) (uint32_t) ch->head64);
+    if (jsdrv_atomic_load(&self->waiting)) {
+        jsdrv_os_event_signal(self->ev);
+    }
+}
+
+static uint32_t channel_available(struct channel_s * ch) {
+    uint32_t head = (uint32_t) jsdrv_atomic_load(&ch->head);
+    int32_t n = (int32_t) (head - (uint32_t) ch->tail64);
+    if (n <= 0) {  // still aligning: release all written samples
+        jsdrv_atomic_store(&ch->tail, (int32_t) head);
+        return 0;
+    }
+    jsdrv_atomic_store(&ch->tail, (int32_t) (uint32_t) ch->tail64);
+    return (uint32_t) n;
+}
+
+static int32_t align(struct jsdrv_stream_reader_s * self) {
+    uint64_t sample_id = 0;
+    uint32_t decimate_factor = 0;
+    for (uint32_t idx = 0; idx < self->channel_count; ++idx) {
+        struct channel_s * ch = &self->channels[idx];
+        if (!jsdrv_atomic_load(&ch->started)) {
+            return JSDRV_ERROR_UNAVAILABLE;
+        }
+        if (!decimate_factor) {
+            decimate_factor = ch->decimate_factor;
+        } else if (decimate_factor != ch->decimate_factor) {
+            JSDRV_LOGW("stream_reader decimate_factor mismatch: %s", ch->topic);
+            return JSDRV_ERROR_NOT_SUPPORTED;
+        }
+        if (ch->sample_id0 > sample_id) {
+            sample_id = ch->sample_id0;
+        }
+    }
+    for (uint32_t idx = 0; idx < self->channel_count; ++idx) {
+        struct channel_s * ch = &self->channels[idx];
+        ch->tail64 = (sample_id - ch->sample_id0 + decimate_factor - 1) / decimate_factor;
+    }
+    self->aligned = true;
+    return 0;
+}
+
+static uint32_t available(struct jsdrv_stream_reader_s * self) {
+    uint32_t rv = UINT32_MAX;
+    for (uint32_t idx = 0; idx < self->channel_count; ++idx) {
+        uint32_t n = channel_available(&self->channels[idx]);
+        if (n < rv) {
+            rv = n;
+        }
+    }
+    return rv;
+}
+
+static void copy_out(struct jsdrv_stream_reader_s * self, void * const * out, uint32_t count) {
+    for (uint32_t idx = 0; idx < self->channel_count; ++idx) {
+        struct channel_s * ch = &self->channels[idx];
+        uint32_t k = ((uint32_t) ch->tail64) & self->mask;
+        uint32_t n = self->capacity - k;
+        if (n > count) {
+            n = count;
+        }
+        uint8_t * dst = (uint8_t *) out[idx];
+        memcpy(dst, ch->data + (size_t) k * ch->element_size, (size_t) n * ch->element_size);
+        memcpy(dst + (size_t) n * ch->element_size, ch->data, (size_t) (count - n) * ch->element_size);
+        ch->tail64 += count;
+        jsdrv_atomic_store(&ch->tail, (int32_t) (uint32_t) ch->tail64);
+    }
+}
+
+static uint64_t counter_take(volatile int32_t * counter) {
+    int32_t v = jsdrv_atomic_load(counter);
+    jsdrv_atomic_add(counter, -v);
+    return (uint64_t) (uint32_t) v;
+}
+
+int32_t jsdrv_stream_reader_read(struct jsdrv_stream_reader_s * self,
+                                 void * const * out, uint32_t sample_count, uint32_t timeout_ms,
+                                 struct jsdrv_stream_reader_info_s * info) {
+    if (!self || !out || (sample_count > self->capacity)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;  // the ring never holds more than capacity
+    }
+    int32_t rc = 0;
+    uint32_t n = 0;
+    int64_t t_end = jsdrv_time_monotonic() + JSDRV_MILLISECONDS_TO_TIME(timeout_ms);
+    while (1) {
+        jsdrv_os_event_reset(self->ev);
+        jsdrv_atomic_store(&self->waiting, 1);
+        if (!self->aligned) {
+            rc = align(self);
+            if (JSDRV_ERROR_NOT_SUPPORTED == rc) {
+                break;
+            }
+        }
+        n = self->aligned ? available(self) : 0;
+        if (n >= sample_count) {
+            n = sample_count;
+            rc = 0;
+            break;
+        }
+        int64_t t_remain = t_end - jsdrv_time_monotonic();
+        if (t_remain <= 0) {
+            rc = JSDRV_ERROR_TIMED_OUT;
+            break;
+        }
+        event_wait(self->ev, (uint32_t) JSDRV_TIME_TO_MILLISECONDS(t_remain + JSDRV_TIME_MILLISECOND - 1));
+    }
+    jsdrv_atomic_store(&self->waiting, 0);
+
+    if (info) {
+        memset(info, 0, sizeof(*info));
+        info->sample_count = n;
+    }
+    if (!self->aligned) {
+        return rc;
+    }
+    struct channel_s * ch = &self->channels[0];
+    if (info) {
+        info->sample_id = ch->sample_id0 + ch->tail64 * ch->decimate_factor;
+        info->decimate_factor = ch->decimate_factor;
+        info->sample_rate = ch->sample_rate;
+        for (uint32_t idx = 0; idx < self->channel_count; ++idx) {
+            info->gap_count += counter_take(&self->channels[idx].gap_count);
+            info->overrun_count += counter_take(&self->channels[idx].overrun_count);
+        }
+    }
+    if (n) {
+        copy_out(self, out, n);
+    }
+    return rc;
+}
+
+static void reader_free(struct jsdrv_stream_reader_s * self) {
+    for (uint32_t idx = 0; idx < JSDRV_STREAM_READER_CHANNELS_MAX; ++idx) {
+        struct channel_s * ch = &self->channels[idx];
+        if (ch->topic[0]) {
+            jsdrv_unsubscribe(self->context, ch->topic, on_data, ch, JSDRV_TIMEOUT_MS_DEFAULT);
+        }
+        if (ch->data) {
+            jsdrv_free(ch->data);
+        }
+    }
+    if (self->ev) {
+        jsdrv_os_event_free(self->ev);
+    }
+    jsdrv_free(self);
+}
+
+int32_t jsdrv_stream_reader_open(struct jsdrv_context_s * context,
+                                 const char * const * topics, const uint8_t * element_types,
+                                 uint32_t channel_count, uint32_t capacity,
+                                 struct jsdrv_stream_reader_s ** reader) {
+    if (!context || !topics || !reader || !channel_count || (channel_count > JSDRV_STREAM_READER_CHANNELS_MAX)
+            || !capacity || (capacity > JSDRV_STREAM_READER_CAPACITY_MAX)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    *reader = NULL;
+    for (uint32_t idx = 0; idx < channel_count; ++idx) {
+        uint8_t element_type = element_types ? element_types[idx] : JSDRV_DATA_TYPE_FLOAT;
+        if (!topics[idx] || ((JSDRV_DATA_TYPE_FLOAT != element_type) && (JSDRV_DATA_TYPE_UINT != element_type))) {
+            return JSDRV_ERROR_PARAMETER_INVALID;
+        }
+    }
+    struct jsdrv_stream_reader_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_stream_reader_s));
+    self->context = context;
+    self->capacity = 1;
+    while (self->capacity < capacity) {
+        self->capacity <<= 1;
+    }
+    self->mask = self->capacity - 1;
+    self->ev = jsdrv_os_event_alloc();
+
+    for (uint32_t idx = 0; idx < channel_count; ++idx) {
+        struct channel_s * ch = &self->channels[idx];
+        ch->parent = self;
+        ch->element_type = element_types ? element_types[idx] : JSDRV_DATA_TYPE_FLOAT;
+        ch->element_size = (JSDRV_DATA_TYPE_FLOAT == ch->element_type) ? sizeof(float) : 1;
+        ch->data = jsdrv_alloc((size_t) self->capacity * ch->element_size);
+    }
+    for (uint32_t idx = 0; idx < channel_count; ++idx) {
+        struct channel_s * ch = &self->channels[idx];
+        int32_t rc = jsdrv_subscribe(context, topics[idx], JSDRV_SFLAG_PUB, on_data, ch, JSDRV_TIMEOUT_MS_DEFAULT);
+        if (rc) {
+            JSDRV_LOGW("stream_reader subscribe %s failed: %" PRIi32, topics[idx], rc);
+            reader_free(self);
+            return rc;
+        }
+        jsdrv_cstr_copy(ch->topic, topics[idx], sizeof(ch->topic));
+    }
+    self->channel_count = channel_count;
+    *reader = self;
+    return 0;
+}
+
+void jsdrv_stream_reader_close(struct jsdrv_stream_reader_s * self) {
+    if (self) {
+        reader_free(self);
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/tap.h"
+#include "jsdrv_prv/downsample.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "tinyprintf.h"
+#include <inttypes.h>
+#include <string.h>
+
+
+#define TOPIC_PREFIX "h/tap/"
+
+static const char * FS_META = "{"
+    "\"dtype\": \"u32\","
+    "\"brief\": \"The additional output sample rate.\","
+    "\"detail\": \"Also publish each float signal at this rate to s/{i, v, p}/tap/N/!data.  The rate must evenly divide h/fs.\","
+    "\"default\": 0,"
+    "\"options\": ["
+        "[0, \"off\"],"
+        "[1000000, \"1 MHz\"],"
+        "[500000, \"500 kHz\"],"
+        "[200000, \"200 kHz\"],"
+        "[100000, \"100 kHz\"],"
+        "[50000, \"50 kHz\"],"
+        "[20000, \"20 kHz\"],"
+        "[10000, \"10 kHz\"],"
+        "[5000, \"5 kHz\"],"
+        "[2000, \"2 kHz\"],"
+        "[1000, \"1 kHz\"],"
+        "[500, \"500 Hz\"],"
+        "[200, \"200 Hz\"],"
+        "[100, \"100 Hz\"],"
+        "[50, \"50 Hz\"],"
+        "[20, \"20 Hz\"],"
+        "[10, \"10 Hz\"],"
+        "[5, \"5 Hz\"],"
+        "[2, \"2 Hz\"],"
+        "[1, \"1 Hz\"]"
+    "]"
+"}";
+
+void jsdrv_tap_initialize(struct jsdrv_tap_s * self) {
+    memset(self, 0, sizeof(*self));
+}
+
+void jsdrv_tap_finalize(struct jsdrv_tap_s * self) {
+    jsdrv_downsample_free(self->downsample);
+    jsdrv_tap_initialize(self);
+}
+
+void jsdrv_tap_clear(struct jsdrv_tap_s * self) {
+    jsdrv_downsample_clear(self->downsample);
+    self->sample_id_next = 0;
+}
+
+int32_t jsdrv_tap_param(uint32_t * fs, const char * topic, const struct jsdrv_union_s * value) {
+    const char * s = jsdrv_cstr_starts_with(topic, TOPIC_PREFIX);
+    if ((NULL == s) || (s[0] < '0') || ((uint32_t) (s[0] - '0') >= JSDRV_TAP_COUNT) || (0 != strcmp(s + 1, "/fs"))) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct jsdrv_union_s v = *value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    fs[s[0] - '0'] = v.value.u32;
+    return 0;
+}
+
+uint32_t jsdrv_tap_configure(struct jsdrv_tap_s * self, uint32_t sample_rate, uint32_t fs, int mode,
+                             uint32_t input_factor) {
+    if ((fs != self->fs) || (mode != self->mode) || (input_factor != self->input_factor)) {
+        jsdrv_downsample_free(self->downsample);
+        self->downsample = NULL;
+        self->fs = fs;
+        self->mode = mode;
+        self->input_factor = input_factor;
+        self->sample_id_next = 0;
+        if (0 == fs) {
+            // off
+        } else if ((0 == input_factor) || (0 != (sample_rate % input_factor))) {
+            JSDRV_LOGW("tap input decimate factor %" PRIu32 " invalid", input_factor);
+        } else {
+            self->downsample = jsdrv_downsample_alloc(sample_rate / input_factor, fs, mode);
+            if (NULL == self->downsample) {
+                JSDRV_LOGW("tap %" PRIu32 " Hz unavailable from %" PRIu32 " Hz", fs, sample_rate / input_factor);
+            }
+        }
+    }
+    if (NULL == self->downsample) {
+        return 0;
+    }
+    return self->input_factor * jsdrv_downsample_decimate_factor(self->downsample);
+}
+
+uint32_t jsdrv_tap_process(struct jsdrv_tap_s * self, uint64_t sample_id, const float * x, uint32_t n,
+                           float * y, uint64_t * y_sample_id) {
+    if ((NULL == self->downsample) || (0 == n)) {
+        return 0;
+    }
+    uint64_t idx = sample_id / self->input_factor;
+    if (idx != self->sample_id_next) {
+        jsdrv_downsample_clear(self->downsample);  // discontinuity, restart aligned
+    }
+    self->sample_id_next = idx + n;
+    uint32_t n_out = 0;
+    jsdrv_downsample_add_f32_block(self->downsample, idx, x, n, y, &n_out);
+    if (n_out) {
+        // each output completes a window that starts on a multiple of factor
+        uint64_t factor = jsdrv_downsample_decimate_factor(self->downsample);
+        uint64_t last = idx + n - 1;
+        last -= (last + 1) % factor;
+        *y_sample_id = (last - (n_out - 1) * factor) * self->input_factor + (sample_id % self->input_factor);
+    }
+    return n_out;
+}
+
+void jsdrv_tap_meta_publish(struct jsdrv_context_s * context, const char * prefix) {
+    for (uint32_t idx = 0; idx < JSDRV_TAP_COUNT; ++idx) {
+        struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_cjson_r(FS_META));
+        tfp_snprintf(m->topic, sizeof(m->topic), "%s/" TOPIC_PREFIX "%u/fs$", prefix, (unsigned int) idx);
+        jsdrvp_backend_send(context, m);
+    }
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/thread.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/dbc.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "tinyprintf.h"
+#include <string.h>
+
+
+static const char * ROLE_NAMES[JSDRV_THREAD_ROLE_COUNT] = {
+    "front", "usb", "device", "buffer", "disp", "writer", "net", "log",
+};
+
+static const char * policy_meta = "{"
+    "\"dtype\": \"u8\","
+    "\"brief\": \"The scheduling policy for this thread role.\","
+    "\"detail\": \"Real-time policies usually need elevated privileges.  Windows maps the policy and priority to the nearest thread priority level.\","
+    "\"default\": 0,"
+    "\"options\": ["
+        "[0, \"default\"],"
+        "[1, \"other\"],"
+        "[2, \"fifo\"],"
+        "[3, \"rr\"]"
+    "]"
+"}";
+
+static const char * priority_meta = "{"
+    "\"dtype\": \"i32\","
+    "\"brief\": \"The priority for this thread role.\","
+    "\"detail\": \"The nice value from -20 (highest) to 19 for other, or 1 to 99 (highest) for fifo and rr.  Set before policy.\","
+    "\"default\": 0,"
+    "\"range\": [-20, 99]"
+"}";
+
+static const char * affinity_meta = "{"
+    "\"dtype\": \"u64\","
+    "\"brief\": \"The CPU bit mask for this thread role.\","
+    "\"detail\": \"Bit k allows CPU k.  0 leaves the affinity unchanged.  Not supported on macOS.\","
+    "\"default\": 0"
+"}";
+
+enum field_e {
+    FIELD_POLICY,
+    FIELD_PRIORITY,
+    FIELD_AFFINITY,
+    FIELD_COUNT,
+};
+
+static const char * FIELD_NAMES[FIELD_COUNT] = {"policy", "prio", "cpus"};
+
+struct thread_topic_s {
+    uint8_t role;
+    uint8_t field;
+};
+
+struct jsdrv_thread_svc_s {
+    struct jsdrv_context_s * context;
+    struct thread_topic_s topics[JSDRV_THREAD_ROLE_COUNT][FIELD_COUNT];
+};
+
+const char * jsdrv_thread_role_name(uint8_t role) {
+    return (role < JSDRV_THREAD_ROLE_COUNT) ? ROLE_NAMES[role] : NULL;
+}
+
+static void role_topic(uint8_t role, uint8_t field, char * topic) {
+    tfp_snprintf(topic, JSDRV_TOPIC_LENGTH_MAX, JSDRV_MSG_THREADS "/%s/%s", ROLE_NAMES[role], FIELD_NAMES[field]);
+}
+
+static void send_to_frontend(struct jsdrv_thread_svc_s * self, const char * topic, const struct jsdrv_union_s * value) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(self->context, topic, value);
+    jsdrvp_backend_send(self->context, m);
+}
+
+static void subscription(struct jsdrv_context_s * context, const char * op, const char * topic,
+                         jsdrv_pubsub_subscribe_fn cbk_fn, void * cbk_user_data) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
+    jsdrv_cstr_copy(m->topic, op, sizeof(m->topic));
+    m->value.type = JSDRV_UNION_BIN;
+    m->value.value.bin = m->payload.bin;
+    m->value.app = JSDRV_PAYLOAD_TYPE_SUB;
+    jsdrv_cstr_copy(m->payload.sub.topic, topic, sizeof(m->payload.sub.topic));
+    m->payload.sub.subscriber.internal_fn = cbk_fn;
+    m->payload.sub.subscriber.user_data = cbk_user_data;
+    m->payload.sub.subscriber.is_internal = 1;
+    m->payload.sub.subscriber.flags = JSDRV_SFLAG_PUB;
+    jsdrvp_backend_send(context, m);
+}
+
+static uint8_t on_field(void * user_data, struct jsdrvp_msg_s * msg) {
+    struct thread_topic_s * t = (struct thread_topic_s *) user_data;
+    struct jsdrv_thread_policy_s policy;
+    struct jsdrv_union_s v = msg->value;
+    jsdrv_thread_policy_get(t->role, &policy);
+    switch (t->field) {
+        case FIELD_POLICY:
+            if (jsdrv_union_as_type(&v, JSDRV_UNION_U8)) {
+                return JSDRV_ERROR_PARAMETER_INVALID;
+            }
+            policy.sched = v.value.u8;
+            break;
+        case FIELD_PRIORITY:
+            if (jsdrv_union_as_type(&v, JSDRV_UNION_I32)) {
+                return JSDRV_ERROR_PARAMETER_INVALID;
+            }
+            policy.priority = v.value.i32;
+            break;
+        case FIELD_AFFINITY:
+            if (jsdrv_union_as_type(&v, JSDRV_UNION_U64)) {
+                return JSDRV_ERROR_PARAMETER_INVALID;
+            }
+            policy.affinity = v.value.u64;
+            break;
+        default:
+            return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    return (uint8_t) jsdrv_thread_policy_set(t->role, &policy);
+}
+
+int32_t jsdrv_thread_policy_initialize(struct jsdrv_context_s * context, struct jsdrv_thread_svc_s ** instance) {
+    JSDRV_DBC_NOT_NULL(context);
+    JSDRV_DBC_NOT_NULL(instance);
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    const char * meta[FIELD_COUNT] = {policy_meta, priority_meta, affinity_meta};  // field_e order
+    struct jsdrv_thread_policy_s policy;
+    struct jsdrv_thread_svc_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_thread_svc_s));
+    self->context = context;
+    for (uint8_t role = 0; role < JSDRV_THREAD_ROLE_COUNT; ++role) {
+        jsdrv_thread_policy_get(role, &policy);
+        for (uint8_t field = 0; field < FIELD_COUNT; ++field) {
+            self->topics[role][field].role = role;
+            self->topics[role][field].field = field;
+            role_topic(role, field, topic);
+            jsdrv_cstr_join(topic, topic, "$", sizeof(topic));
+            send_to_frontend(self, topic, &jsdrv_union_cjson_r(meta[field]));
+        }
+        role_topic(role, FIELD_POLICY, topic);
+        send_to_frontend(self, topic, &jsdrv_union_u8_r(policy.sched));
+        role_topic(role, FIELD_PRIORITY, topic);
+        send_to_frontend(self, topic, &jsdrv_union_i32_r(policy.priority));
+        role_topic(role, FIELD_AFFINITY, topic);
+        send_to_frontend(self, topic, &jsdrv_union_u64_r(policy.affinity));
+        for (uint8_t field = 0; field < FIELD_COUNT; ++field) {
+            role_topic(role, field, topic);
+            subscription(context, JSDRV_PUBSUB_SUBSCRIBE, topic, on_field, &self->topics[role][field]);
+        }
+    }
+    *instance = self;
+    return 0;
+}
+
+void jsdrv_thread_policy_finalize(struct jsdrv_thread_svc_s * self) {
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    if (self) {
+        for (uint8_t role = 0; role < JSDRV_THREAD_ROLE_COUNT; ++role) {
+            for (uint8_t field = 0; field < FIELD_COUNT; ++field) {
+                role_topic(role, field, topic);
+                subscription(self->context, JSDRV_PUBSUB_UNSUBSCRIBE, topic, on_field, &self->topics[role][field]);
+            }
+        }
+        jsdrv_free(self);
+    }
+}
@@ -15,9 +15,31 @@
  */
 
 #include "jsdrv/time.h"
+#include "jsdrv_prv/cpu.h"
 #include "tinyprintf.h"
 #include <inttypes.h>
 #include <math.h>
+#include <stdbool.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#if _WIN32
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#define SIMD_AVX2 1
+#if defined(__clang__) || defined(__GNUC__)
+#define SIMD_AVX2_FN __attribute__((target("avx2")))
+#else
+#define SIMD_AVX2_FN
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_NEON_F64 1
+#include <arm_neon.h>
+#endif
+
+#define RANGE_CHUNK (256U)
+#define EXACT_F64_MAX (4503599627370496.0)      // 2^52, integers below convert exactly
+#define MAGIC_I64_MAX (2251799813685248.0)      // 2^51, the magic number conversion limit
 
 int32_t jsdrv_time_to_str(int64_t t, char * str, size_t size) {
     if (!size) {
@@ -69,3 +91,101 @@ uint64_t jsdrv_time_to_counter(const struct jsdrv_time_map_s * self, int64_t tim
     counter += self->offset_counter;
     return counter;
 }
+
+// Per element, identical to jsdrv_time_from_counter().
+static void range_scalar(double scale, int64_t delta, int64_t incr, int64_t offset_time,
+                         int64_t * time64, size_t count) {
+    for (size_t k = 0; k < count; ++k) {
+        time64[k] = (int64_t) round(scale * (double) delta) + offset_time;
+        delta += incr;
+    }
+}
+
+#if SIMD_AVX2
+// round() ties away from zero, which the SIMD rounding modes do not provide.
+SIMD_AVX2_FN static void range_avx2(double scale, int64_t delta, int64_t incr, int64_t offset_time,
+                                    int64_t * time64, size_t count) {
+    const __m256d magic = _mm256_set1_pd(6755399441055744.0);  // 2^52 + 2^51
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d neg_half = _mm256_set1_pd(-0.5);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d s = _mm256_set1_pd(scale);
+    const __m256d step = _mm256_set1_pd(4.0 * (double) incr);
+    const __m256i offset = _mm256_sub_epi64(_mm256_set1_epi64x(offset_time), _mm256_castpd_si256(magic));
+    double i = (double) incr;
+    __m256d d = _mm256_add_pd(_mm256_set1_pd((double) delta), _mm256_set_pd(3.0 * i, 2.0 * i, i, 0.0));
+    size_t k = 0;
+    for (; (k + 4) <= count; k += 4) {
+        __m256d x = _mm256_mul_pd(s, d);
+        __m256d t = _mm256_round_pd(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        __m256d f = _mm256_sub_pd(x, t);
+        t = _mm256_add_pd(t, _mm256_and_pd(_mm256_cmp_pd(f, half, _CMP_GE_OQ), one));
+        t = _mm256_sub_pd(t, _mm256_and_pd(_mm256_cmp_pd(f, neg_half, _CMP_LE_OQ), one));
+        __m256i v = _mm256_add_epi64(_mm256_castpd_si256(_mm256_add_pd(t, magic)), offset);
+        _mm256_storeu_si256((__m256i *) (time64 + k), v);
+        d = _mm256_add_pd(d, step);
+    }
+    range_scalar(scale, delta + (int64_t) k * incr, incr, offset_time, time64 + k, count - k);
+}
+#endif
+
+#if SIMD_NEON_F64
+static void range_neon(double scale, int64_t delta, int64_t incr, int64_t offset_time,
+                       int64_t * time64, size_t count) {
+    const float64x2_t s = vdupq_n_f64(scale);
+    const float64x2_t step = vdupq_n_f64(2.0 * (double) incr);
+    const int64x2_t offset = vdupq_n_s64(offset_time);
+    double d_init[2] = {(double) delta, (double) delta + (double) incr};
+    float64x2_t d = vld1q_f64(d_init);
+    size_t k = 0;
+    for (; (k + 2) <= count; k += 2) {
+        float64x2_t t = vrndaq_f64(vmulq_f64(s, d));  // ties away from zero, same as round()
+        vst1q_s64(time64 + k, vaddq_s64(vcvtq_s64_f64(t), offset));
+        d = vaddq_f64(d, step);
+    }
+    range_scalar(scale, delta + (int64_t) k * incr, incr, offset_time, time64 + k, count - k);
+}
+#endif
+
+void jsdrv_time_from_counter_range(const struct jsdrv_time_map_s * self, uint64_t counter, uint32_t incr,
+                                   int64_t * time64, size_t count) {
+    if (0 == count) {
+        return;
+    }
+    int64_t delta = (int64_t) (counter - self->offset_counter);
+    int64_t delta_end = delta + (int64_t) ((count - 1) * (uint64_t) incr);
+    double scale = (double) JSDRV_TIME_SECOND / self->counter_rate;
+    int64_t offset_time = self->offset_time;
+    // The SIMD code computes each delta in double precision, which is exact below 2^52.
+    bool exact = (fabs((double) delta) < EXACT_F64_MAX) && (fabs((double) delta_end) < EXACT_F64_MAX);
+#if SIMD_AVX2
+    if (exact && (jsdrv_cpu_features() & JSDRV_CPU_AVX2)
+            && (fabs(scale * (double) delta) < MAGIC_I64_MAX)
+            && (fabs(scale * (double) delta_end) < MAGIC_I64_MAX)) {
+        range_avx2(scale, delta, incr, offset_time, time64, count);
+        return;
+    }
+#elif SIMD_NEON_F64
+    if (exact && (jsdrv_cpu_features() & JSDRV_CPU_NEON)) {
+        range_neon(scale, delta, incr, offset_time, time64, count);
+        return;
+    }
+#endif
+    (void) exact;
+    range_scalar(scale, delta, incr, offset_time, time64, count);
+}
+
+void jsdrv_time_from_counter_range_f64(const struct jsdrv_time_map_s * self, uint64_t counter, uint32_t incr,
+                                       double * t, size_t count) {
+    int64_t time64[RANGE_CHUNK];
+    while (count) {
+        size_t n = (count > RANGE_CHUNK) ? RANGE_CHUNK : count;
+        jsdrv_time_from_counter_range(self, counter, incr, time64, n);
+        for (size_t k = 0; k < n; ++k) {
+            t[k] = JSDRV_TIME_TO_F64(time64[k]);
+        }
+        counter += n * (uint64_t) incr;
+        t += n;
+        count -= n;
+    }
+}
@@ -17,37 +17,157 @@
 #include "jsdrv_prv/time_map_filter.h"
 #include "jsdrv_prv/platform.h"
 #include <inttypes.h>
+#include <stdbool.h>
+
+
+#define DRIFT_PPM_MAX (1000.0)     // reject rate estimates further from nominal
 
 
 struct tmf_point_s {
     uint64_t counter;
     int64_t utc;
+    int64_t key;        // utc - time(counter - counter_ref), the offset estimate at counter_ref
 };
 
 
+/*
+ * The offset estimate is the minimum of key over the window, which
+ * assumes that the minimum latency point is the most accurate.  A
+ * monotonic deque of point indices with increasing keys tracks the
+ * sliding window minimum in amortized O(1).  The keys depend upon
+ * counter_ref and the counter rate, so the filter rebases once every
+ * points_max additions to bound the deltas and apply any new drift
+ * estimate.  The rebase is O(points_max), which is amortized O(1).
+ */
 struct jsdrv_tmf_s {
     struct jsdrv_time_map_s time_map;
+    double counter_rate_nominal;
     int64_t interval;
     uint32_t points_max;
     uint32_t points_valid;
     uint32_t head;
     int64_t utc_prev;
+    uint64_t counter_ref;
+    int64_t utc_ref;
+    uint32_t adds;          // since the last rebase
+    bool drift;
+
+    // least-squares sums of x = counter - counter_ref, y = utc - utc_ref
+    double sx;
+    double sy;
+    double sxx;
+    double sxy;
+
+    uint32_t * dq;          // deque of point indices, capacity points_max
+    uint32_t dq_head;       // oldest entry
+    uint32_t dq_count;
     struct tmf_point_s points[];
 };
 
 
+static inline uint32_t ring_inc(struct jsdrv_tmf_s * self, uint32_t idx) {
+    ++idx;
+    return (idx >= self->points_max) ? 0 : idx;
+}
+
+static inline uint32_t ring_tail(struct jsdrv_tmf_s * self) {
+    uint32_t tail = self->points_max + self->head - self->points_valid;
+    return (tail >= self->points_max) ? (tail - self->points_max) : tail;
+}
+
+static int64_t counter_to_time(struct jsdrv_tmf_s * self, uint64_t counter_delta) {
+    if (self->time_map.counter_rate == self->counter_rate_nominal) {
+        // exact integer conversion
+        return JSDRV_COUNTER_TO_TIME(counter_delta, (uint64_t) self->time_map.counter_rate);
+    }
+    return (int64_t) (((double) counter_delta / self->time_map.counter_rate) * (double) JSDRV_TIME_SECOND);
+}
+
+static void sums_update(struct jsdrv_tmf_s * self, const struct tmf_point_s * p, double sign) {
+    double x = (double) (p->counter - self->counter_ref);
+    double y = (double) (p->utc - self->utc_ref);
+    self->sx += sign * x;
+    self->sy += sign * y;
+    self->sxx += sign * x * x;
+    self->sxy += sign * x * y;
+}
+
+static void dq_push(struct jsdrv_tmf_s * self, uint32_t idx) {
+    int64_t key = self->points[idx].key;
+    while (self->dq_count) {
+        uint32_t back = self->dq_head + self->dq_count - 1;
+        if (back >= self->points_max) {
+            back -= self->points_max;
+        }
+        if (self->points[self->dq[back]].key < key) {
+            break;
+        }
+        --self->dq_count;
+    }
+    uint32_t pos = self->dq_head + self->dq_count;
+    if (pos >= self->points_max) {
+        pos -= self->points_max;
+    }
+    self->dq[pos] = idx;
+    ++self->dq_count;
+}
+
+static void drift_update(struct jsdrv_tmf_s * self) {
+    double n = (double) self->points_valid;
+    double den = n * self->sxx - self->sx * self->sx;
+    if ((self->points_valid < 3) || (den <= 0.0)) {
+        return;
+    }
+    double slope = (n * self->sxy - self->sx * self->sy) / den;  // time per counter tick
+    if (slope <= 0.0) {
+        return;
+    }
+    double rate = (double) JSDRV_TIME_SECOND / slope;
+    double ppm = (rate / self->counter_rate_nominal - 1.0) * 1e6;
+    if ((ppm > DRIFT_PPM_MAX) || (ppm < -DRIFT_PPM_MAX)) {
+        return;
+    }
+    self->time_map.counter_rate = rate;
+}
+
+static void rebase(struct jsdrv_tmf_s * self) {
+    uint32_t tail = ring_tail(self);
+    self->counter_ref = self->points[tail].counter;
+    self->utc_ref = self->points[tail].utc;
+    self->adds = 0;
+    self->sx = 0.0;
+    self->sy = 0.0;
+    self->sxx = 0.0;
+    self->sxy = 0.0;
+    for (uint32_t n = 0, idx = tail; n < self->points_valid; ++n, idx = ring_inc(self, idx)) {
+        sums_update(self, &self->points[idx], 1.0);
+    }
+    if (self->drift) {
+        drift_update(self);
+    }
+    self->dq_head = 0;
+    self->dq_count = 0;
+    for (uint32_t n = 0, idx = tail; n < self->points_valid; ++n, idx = ring_inc(self, idx)) {
+        struct tmf_point_s * p = &self->points[idx];
+        p->key = p->utc - counter_to_time(self, p->counter - self->counter_ref);
+        dq_push(self, idx);
+    }
+}
+
 struct jsdrv_tmf_s * jsdrv_tmf_new(uint32_t counter_rate, uint32_t points, int64_t interval) {
     if ((counter_rate == 0) || (points == 0) || (interval < JSDRV_TIME_MICROSECOND)) {
         return NULL;
     }
 
     size_t sz = sizeof(struct jsdrv_tmf_s) + sizeof(struct tmf_point_s) * points;
-    struct jsdrv_tmf_s * self = jsdrv_alloc(sz);
+    struct jsdrv_tmf_s * self = jsdrv_alloc(sz + sizeof(uint32_t) * points);
     if (NULL == self) {
         return NULL;
     }
-    memset(self, 0, sz);
+    memset(self, 0, sz + sizeof(uint32_t) * points);
+    self->dq = (uint32_t *) (((uint8_t *) self) + sz);
     self->time_map.counter_rate = counter_rate;
+    self->counter_rate_nominal = counter_rate;
     self->interval = interval;
     self->points_max = points;
     return self;
@@ -65,7 +185,23 @@ void jsdrv_tmf_clear(struct jsdrv_tmf_s * self) {
         self->points_valid = 0;
         self->time_map.offset_time = 0;
         self->time_map.offset_counter = 0;
+        self->time_map.counter_rate = self->counter_rate_nominal;
         self->utc_prev = 0;
+        self->adds = 0;
+        self->dq_head = 0;
+        self->dq_count = 0;
+    }
+}
+
+void jsdrv_tmf_drift_set(struct jsdrv_tmf_s * self, bool enable) {
+    if (NULL != self) {
+        self->drift = enable;
+        if (!enable) {
+            self->time_map.counter_rate = self->counter_rate_nominal;
+        }
+        if (self->points_valid) {
+            rebase(self);
+        }
     }
 }
 
@@ -76,40 +212,45 @@ void jsdrv_tmf_add(struct jsdrv_tmf_s * self, uint64_t counter, int64_t utc) {
     if ((utc - self->utc_prev) < self->interval) {
         return;
     }
-
-    // add new point
-    self->points[self->head].counter = counter;
-    self->points[self->head].utc = utc;
     self->utc_prev = utc;
-    ++self->head;
-    if (self->head >= self->points_max) {
-        self->head = 0;
+
+    if (0 == self->points_valid) {
+        self->counter_ref = counter;
+        self->utc_ref = utc;
+        self->sx = 0.0;
+        self->sy = 0.0;
+        self->sxx = 0.0;
+        self->sxy = 0.0;
+    } else if (self->points_valid == self->points_max) {
+        // evict the oldest point, which the new point overwrites
+        sums_update(self, &self->points[self->head], -1.0);
+        if (self->dq_count && (self->dq[self->dq_head] == self->head)) {
+            self->dq_head = ring_inc(self, self->dq_head);
+            --self->dq_count;
+        }
     }
+
+    // add new point
+    uint32_t idx = self->head;
+    struct tmf_point_s * p = &self->points[idx];
+    p->counter = counter;
+    p->utc = utc;
+    p->key = utc - counter_to_time(self, counter - self->counter_ref);
+    self->head = ring_inc(self, self->head);
     if (self->points_valid < self->points_max) {
         ++self->points_valid;
     }
+    sums_update(self, p, 1.0);
+    dq_push(self, idx);
+    if (++self->adds >= self->points_max) {
+        rebase(self);
+    }
 
     // update time map
-    uint32_t tail = self->points_max + self->head - self->points_valid;
-    if (tail >= self->points_max) {
-        tail -= self->points_max;
-    }
-    uint64_t counter_offset = self->points[tail].counter;
-    int64_t utc_est = self->points[tail].utc;
-    while (tail != self->head) {
-        uint64_t counter_delta = self->points[tail].counter - counter_offset;
-        int64_t utc_delta = JSDRV_COUNTER_TO_TIME(counter_delta, (uint64_t) self->time_map.counter_rate);
-        int64_t utc_est1 = self->points[tail].utc - utc_delta;
-        if (utc_est1 < utc_est) {
-            utc_est = utc_est1;
-        }
-        ++tail;
-        if (tail >= self->points_max) {
-            tail = 0;
-        }
-    }
+    uint64_t counter_offset = self->points[ring_tail(self)].counter;
+    int64_t key_min = self->points[self->dq[self->dq_head]].key;
     self->time_map.offset_counter = counter_offset;
-    self->time_map.offset_time = utc_est;
+    self->time_map.offset_time = key_min + counter_to_time(self, counter_offset - self->counter_ref);
 }
 
 void jsdrv_tmf_get(struct jsdrv_tmf_s * self, struct jsdrv_time_map_s * time_map) {
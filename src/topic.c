@@ -116,3 +116,62 @@ char jsdrv_topic_suffix_remove(struct jsdrv_topic_s * topic) {
     }
     return ch;
 }
+
+static inline bool is_level_wildcard(const char * p, char ch) {
+    return (p[0] == ch) && ((p[1] == 0) || (p[1] == '/'));
+}
+
+bool jsdrv_topic_is_wildcard(const char * pattern) {
+    const char * p = pattern;
+    while (*p) {
+        if (is_level_wildcard(p, '+') || ((p[0] == '#') && (p[1] == 0))) {
+            return true;
+        }
+        while (*p && (*p != '/')) {
+            ++p;
+        }
+        if (*p) {
+            ++p;  // skip separator
+        }
+    }
+    return false;
+}
+
+bool jsdrv_topic_match(const char * pattern, const char * topic) {
+    const char * p = pattern;
+    const char * t = topic;
+    while (1) {
+        if ((p[0] == '#') && (p[1] == 0)) {
+            return true;  // matches the remaining levels, if any
+        }
+        if (is_level_wildcard(p, '+')) {
+            if (!*t) {
+                return false;
+            }
+            ++p;
+            while (*t && (*t != '/')) {
+                ++t;
+            }
+        } else {
+            while (*p && (*p != '/') && (*p == *t)) {
+                ++p;
+                ++t;
+            }
+            if (((*p != 0) && (*p != '/')) || ((*t != 0) && (*t != '/'))) {
+                return false;  // level mismatch
+            }
+        }
+        if (!*p) {
+            return !*t;
+        }
+        // *p == '/'
+        ++p;
+        if (*t == '/') {
+            ++t;
+        } else if ((p[0] == '#') && (p[1] == 0)) {
+            return true;  // "a/#" matches "a"
+        } else {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/topic_index.h"
+#include <string.h>
+
+
+static inline const char * entry_topic(const struct jsdrv_topic_index_s * self, uint16_t i) {
+    const char * topic;
+    memcpy(&topic, self->table + (i * self->stride) + self->offset, sizeof(topic));
+    return topic;
+}
+
+void jsdrv_topic_index_init(struct jsdrv_topic_index_s * self, const void * table,
+        size_t stride, size_t offset, uint16_t count, uint16_t * idx) {
+    self->table = (const uint8_t *) table;
+    self->stride = stride;
+    self->offset = offset;
+    self->idx = idx;
+    self->count = 0;
+    // insertion sort, the tables are small and only sorted once
+    for (uint16_t i = 0; i < count; ++i) {
+        const char * topic = entry_topic(self, i);
+        if (NULL == topic) {
+            continue;
+        }
+        uint16_t k = self->count++;
+        while ((k > 0) && (strcmp(entry_topic(self, idx[k - 1]), topic) > 0)) {
+            idx[k] = idx[k - 1];
+            --k;
+        }
+        idx[k] = i;
+    }
+}
+
+int32_t jsdrv_topic_index_find(const struct jsdrv_topic_index_s * self, const char * topic) {
+    uint32_t lo = 0;
+    uint32_t hi = self->count;
+    if (NULL == topic) {
+        return -1;
+    }
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        uint16_t i = self->idx[mid];
+        int rc = strcmp(entry_topic(self, i), topic);
+        if (0 == rc) {
+            return i;
+        } else if (rc < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,280 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/trace.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv/error_code.h"
+#include <inttypes.h>
+#include <stdio.h>
+#if _WIN32
+#include <windows.h>
+#define THREAD_LOCAL __declspec(thread)
+#define LOCK() AcquireSRWLockExclusive(&lock_)
+#define UNLOCK() ReleaseSRWLockExclusive(&lock_)
+#else
+#include <pthread.h>
+#define THREAD_LOCAL _Thread_local
+#define LOCK() pthread_mutex_lock(&lock_)
+#define UNLOCK() pthread_mutex_unlock(&lock_)
+#endif
+
+
+#define ROLE_NONE (0xffU)
+
+// Matches jsdrv_thread_role_name(), which is not part of the support library.
+static const char * ROLE_NAMES[JSDRV_THREAD_ROLE_COUNT] = {
+    "front", "usb", "device", "buffer", "disp", "writer", "net", "log",
+};
+
+enum slot_state_e {
+    SLOT_FREE = 0,
+    SLOT_OWNED = 1,     // attached to a running thread, which writes without lock
+    SLOT_RETIRED = 2,   // the thread exited, read only
+};
+
+struct slot_s {
+    volatile int32_t state;
+    volatile int32_t gen;               // the trace generation for events, written by the owner
+    uint8_t role;
+    uint32_t capacity;                  // power of 2
+    volatile uint64_t count;            // total events written, written by the owner
+    struct jsdrv_trace_event_s * events;
+};
+
+volatile int32_t jsdrv_trace_active = 0;
+
+// The lock only guards slot ownership, never the recording path.
+#if _WIN32
+static SRWLOCK lock_ = SRWLOCK_INIT;
+#else
+static pthread_mutex_t lock_ = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static struct slot_s slots_[JSDRV_TRACE_THREAD_MAX];
+static volatile int32_t gen_ = 0;
+static volatile int32_t capacity_ = JSDRV_TRACE_EVENTS_DEFAULT;
+static int64_t time_start_ = 0;
+static THREAD_LOCAL struct slot_s * slot_ = NULL;
+static THREAD_LOCAL uint8_t role_ = ROLE_NONE;
+
+static inline uint64_t count_load(volatile uint64_t * p) {
+#if _WIN32
+    return (uint64_t) InterlockedCompareExchange64((volatile LONG64 *) p, 0, 0);
+#else
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline void count_store(volatile uint64_t * p, uint64_t value) {
+#if _WIN32
+    InterlockedExchange64((volatile LONG64 *) p, (LONG64) value);
+#else
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+#endif
+}
+
+static struct slot_s * slot_acquire(void) {
+    struct slot_s * s = NULL;
+    LOCK();
+    for (uint32_t idx = 0; idx < JSDRV_TRACE_THREAD_MAX; ++idx) {
+        if (SLOT_FREE == slots_[idx].state) {
+            s = &slots_[idx];
+            s->role = role_;
+            s->gen = -1;  // reset on first use
+            jsdrv_atomic_store(&s->state, SLOT_OWNED);
+            break;
+        }
+    }
+    UNLOCK();
+    return s;
+}
+
+static void slot_reset(struct slot_s * s, int32_t gen) {
+    uint32_t capacity = (uint32_t) jsdrv_atomic_load(&capacity_);
+    if (s->capacity != capacity) {
+        jsdrv_free(s->events);
+        s->events = jsdrv_alloc(capacity * sizeof(struct jsdrv_trace_event_s));
+        s->capacity = capacity;
+    }
+    count_store(&s->count, 0);
+    jsdrv_atomic_store(&s->gen, gen);
+}
+
+static void slot_free(struct slot_s * s) {
+    jsdrv_free(s->events);
+    s->events = NULL;
+    s->capacity = 0;
+    count_store(&s->count, 0);
+    s->gen = -1;
+    jsdrv_atomic_store(&s->state, SLOT_FREE);
+}
+
+// Get the valid event range for a slot in the current generation.
+static bool slot_range(struct slot_s * s, uint64_t * first, uint64_t * last) {
+    int32_t state = jsdrv_atomic_load(&s->state);
+    if ((SLOT_FREE == state) || (jsdrv_atomic_load(&s->gen) != jsdrv_atomic_load(&gen_))) {
+        return false;
+    }
+    uint64_t count = count_load(&s->count);
+    *last = count;
+    // when wrapped, skip the oldest event which a late writer may overwrite
+    *first = (count >= s->capacity) ? (count - s->capacity + 1) : 0;
+    return *first < *last;
+}
+
+void jsdrv_trace_span(const char * name, int64_t start, uint64_t arg) {
+    int64_t now = jsdrv_time_monotonic();
+    if (!jsdrv_trace_is_active()) {
+        return;
+    }
+    struct slot_s * s = slot_;
+    if (NULL == s) {
+        s = slot_acquire();
+        if (NULL == s) {
+            return;  // all slots in use
+        }
+        slot_ = s;
+    }
+    int32_t gen = jsdrv_atomic_load(&gen_);
+    if (s->gen != gen) {
+        slot_reset(s, gen);
+    }
+    uint64_t count = s->count;  // owner only
+    struct jsdrv_trace_event_s * e = &s->events[count & (s->capacity - 1)];
+    e->start = start;
+    e->duration = now - start;
+    e->name = name;
+    e->arg = arg;
+    count_store(&s->count, count + 1);
+}
+
+void jsdrv_trace_thread_start(uint8_t role) {
+    role_ = role;
+}
+
+void jsdrv_trace_thread_stop(void) {
+    struct slot_s * s = slot_;
+    if (NULL != s) {
+        slot_ = NULL;
+        LOCK();
+        jsdrv_atomic_store(&s->state, SLOT_RETIRED);
+        UNLOCK();
+    }
+    role_ = ROLE_NONE;
+}
+
+int32_t jsdrv_trace_start(uint32_t events_per_thread) {
+    if (0 == events_per_thread) {
+        events_per_thread = JSDRV_TRACE_EVENTS_DEFAULT;
+    } else if (events_per_thread > JSDRV_TRACE_EVENTS_MAX) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    uint32_t capacity = 1;
+    while (capacity < events_per_thread) {
+        capacity <<= 1;
+    }
+    jsdrv_atomic_store(&jsdrv_trace_active, 0);
+    LOCK();
+    for (uint32_t idx = 0; idx < JSDRV_TRACE_THREAD_MAX; ++idx) {
+        if (SLOT_RETIRED == slots_[idx].state) {
+            slot_free(&slots_[idx]);
+        }
+    }
+    jsdrv_atomic_store(&capacity_, (int32_t) capacity);
+    time_start_ = jsdrv_time_monotonic();
+    jsdrv_atomic_add(&gen_, 1);  // owned slots reset on their next span
+    UNLOCK();
+    jsdrv_atomic_store(&jsdrv_trace_active, 1);
+    JSDRV_LOGI("trace start: %" PRIu32 " events per thread", capacity);
+    return 0;
+}
+
+void jsdrv_trace_stop(void) {
+    if (jsdrv_trace_is_active()) {
+        jsdrv_atomic_store(&jsdrv_trace_active, 0);
+        JSDRV_LOGI("trace stop: %" PRIu64 " events", jsdrv_trace_event_count());
+    }
+}
+
+uint64_t jsdrv_trace_event_count(void) {
+    uint64_t total = 0;
+    uint64_t first;
+    uint64_t last;
+    LOCK();
+    for (uint32_t idx = 0; idx < JSDRV_TRACE_THREAD_MAX; ++idx) {
+        if (slot_range(&slots_[idx], &first, &last)) {
+            total += last - first;
+        }
+    }
+    UNLOCK();
+    return total;
+}
+
+static double time_to_us(int64_t t) {
+    return ((double) t) * (1000000.0 / (double) (1LL << 30));
+}
+
+int32_t jsdrv_trace_write(const char * path) {
+    uint64_t first;
+    uint64_t last;
+    if (jsdrv_trace_is_active()) {
+        return JSDRV_ERROR_BUSY;
+    }
+    FILE * f = fopen(path, "wb");
+    if (NULL == f) {
+        JSDRV_LOGW("trace write could not open %s", path);
+        return JSDRV_ERROR_IO;
+    }
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"jsdrv\"}}");
+    LOCK();  // slots remain while writing
+    for (uint32_t idx = 0; idx < JSDRV_TRACE_THREAD_MAX; ++idx) {
+        struct slot_s * s = &slots_[idx];
+        if (!slot_range(s, &first, &last)) {
+            continue;
+        }
+        const char * role = (s->role < JSDRV_THREAD_ROLE_COUNT) ? ROLE_NAMES[s->role] : "thread";
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu32
+                   ",\"args\":{\"name\":\"%s.%" PRIu32 "\"}}",
+                idx + 1, role, idx + 1);
+        for (uint64_t k = first; k < last; ++k) {
+            struct jsdrv_trace_event_s * e = &s->events[k & (s->capacity - 1)];
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%" PRIu32
+                       ",\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"n\":%" PRIu64 "}}",
+                    e->name, idx + 1, time_to_us(e->start - time_start_), time_to_us(e->duration), e->arg);
+        }
+    }
+    UNLOCK();
+    fprintf(f, "\n]}\n");
+    int32_t rc = (0 == ferror(f)) ? 0 : JSDRV_ERROR_IO;
+    if (fclose(f)) {
+        rc = JSDRV_ERROR_IO;
+    }
+    JSDRV_LOGI("trace write %s: rc=%" PRId32, path, rc);
+    return rc;
+}
+
+void jsdrv_trace_release(void) {
+    LOCK();
+    for (uint32_t idx = 0; idx < JSDRV_TRACE_THREAD_MAX; ++idx) {
+        if (SLOT_RETIRED == slots_[idx].state) {
+            slot_free(&slots_[idx]);
+        }
+    }
+    UNLOCK();
+}
@@ -0,0 +1,300 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/trigger.h"
+#include "jsdrv_prv/assert.h"
+#include "jsdrv_prv/buffer.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "tinyprintf.h"
+#include <math.h>
+#include <string.h>
+
+
+#define TOPIC_PREFIX "h/trig/"
+
+static const char * FIELD_NAMES[JSDRV_TRIGGER_FIELD_COUNT] = {
+    [JSDRV_TRIGGER_FIELD_SOURCE] = "source",
+    [JSDRV_TRIGGER_FIELD_LEVEL] = "level",
+    [JSDRV_TRIGGER_FIELD_EDGE] = "edge",
+    [JSDRV_TRIGGER_FIELD_HYST] = "hyst",
+    [JSDRV_TRIGGER_FIELD_DUR] = "dur",
+    [JSDRV_TRIGGER_FIELD_SNAP] = "snap",
+};
+
+static const char * FIELD_META[JSDRV_TRIGGER_FIELD_COUNT] = {
+    [JSDRV_TRIGGER_FIELD_SOURCE] = "{"
+        "\"dtype\": \"u8\","
+        "\"brief\": \"The trigger source signal.\","
+        "\"detail\": \"The trigger evaluates the full-rate samples before host downsampling.\","
+        "\"default\": 0,"
+        "\"options\": ["
+            "[0, \"off\"],"
+            "[1, \"current\"],"
+            "[2, \"voltage\"],"
+            "[3, \"power\"],"
+            "[4, \"gpi0\"],"
+            "[5, \"gpi1\"]"
+        "]"
+    "}",
+    [JSDRV_TRIGGER_FIELD_LEVEL] = "{"
+        "\"dtype\": \"f32\","
+        "\"brief\": \"The trigger level in signal units.\","
+        "\"default\": 0.0"
+    "}",
+    [JSDRV_TRIGGER_FIELD_EDGE] = "{"
+        "\"dtype\": \"u8\","
+        "\"brief\": \"The trigger edge.\","
+        "\"default\": 0,"
+        "\"options\": ["
+            "[0, \"rising\"],"
+            "[1, \"falling\"],"
+            "[2, \"both\"]"
+        "]"
+    "}",
+    [JSDRV_TRIGGER_FIELD_HYST] = "{"
+        "\"dtype\": \"f32\","
+        "\"brief\": \"The trigger hysteresis in signal units.\","
+        "\"detail\": \"The signal must return past the level by this amount before the next crossing.\","
+        "\"default\": 0.0"
+    "}",
+    [JSDRV_TRIGGER_FIELD_DUR] = "{"
+        "\"dtype\": \"f32\","
+        "\"brief\": \"The trigger duration in seconds.\","
+        "\"detail\": \"The signal must stay past the level for this duration to match.  The event reports the crossing sample.\","
+        "\"default\": 0.0"
+    "}",
+    [JSDRV_TRIGGER_FIELD_SNAP] = "{"
+        "\"dtype\": \"u8\","
+        "\"brief\": \"The memory buffer to snapshot on match.\","
+        "\"detail\": \"Publishes to m/BBB/g/!snap for this buffer id.  0 disables.\","
+        "\"default\": 0,"
+        "\"range\": [0, 16]"
+    "}",
+};
+
+void jsdrv_trigger_initialize(struct jsdrv_trigger_s * self, uint8_t index) {
+    memset(self, 0, sizeof(*self));
+    self->index = index;
+    jsdrv_trigger_clear(self);
+}
+
+void jsdrv_trigger_clear(struct jsdrv_trigger_s * self) {
+    self->state = -1;
+    self->pending = 0;
+    self->pending_count = 0;
+    self->sample_id_next = 0;
+}
+
+const char * jsdrv_trigger_field_name(uint8_t field) {
+    return (field < JSDRV_TRIGGER_FIELD_COUNT) ? FIELD_NAMES[field] : NULL;
+}
+
+const char * jsdrv_trigger_field_meta(uint8_t field) {
+    return (field < JSDRV_TRIGGER_FIELD_COUNT) ? FIELD_META[field] : NULL;
+}
+
+static int32_t value_u8(const struct jsdrv_union_s * value, uint8_t max, uint8_t * rv) {
+    struct jsdrv_union_s v = *value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_U8) || (v.value.u8 > max)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    *rv = v.value.u8;
+    return 0;
+}
+
+static int32_t value_f32(const struct jsdrv_union_s * value, bool positive, float * rv) {
+    struct jsdrv_union_s v = *value;
+    if (jsdrv_union_as_type(&v, JSDRV_UNION_F64) || !isfinite(v.value.f64) || (positive && (v.value.f64 < 0.0))) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    *rv = (float) v.value.f64;
+    return 0;
+}
+
+int32_t jsdrv_trigger_param(struct jsdrv_trigger_s * triggers, const char * topic, const struct jsdrv_union_s * value) {
+    const char * s = jsdrv_cstr_starts_with(topic, TOPIC_PREFIX);
+    if ((NULL == s) || (s[0] < '0') || ((uint32_t) (s[0] - '0') >= JSDRV_TRIGGER_COUNT) || (s[1] != '/')) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct jsdrv_trigger_s * t = &triggers[s[0] - '0'];
+    s += 2;
+    int32_t rc;
+    if (0 == strcmp(s, FIELD_NAMES[JSDRV_TRIGGER_FIELD_SOURCE])) {
+        rc = value_u8(value, JSDRV_TRIGGER_SOURCE_COUNT - 1, &t->source);
+    } else if (0 == strcmp(s, FIELD_NAMES[JSDRV_TRIGGER_FIELD_LEVEL])) {
+        rc = value_f32(value, false, &t->level);
+    } else if (0 == strcmp(s, FIELD_NAMES[JSDRV_TRIGGER_FIELD_EDGE])) {
+        rc = value_u8(value, JSDRV_TRIGGER_EDGE_BOTH, &t->edge);
+    } else if (0 == strcmp(s, FIELD_NAMES[JSDRV_TRIGGER_FIELD_HYST])) {
+        rc = value_f32(value, true, &t->hyst);
+    } else if (0 == strcmp(s, FIELD_NAMES[JSDRV_TRIGGER_FIELD_DUR])) {
+        rc = value_f32(value, true, &t->duration);
+    } else if (0 == strcmp(s, FIELD_NAMES[JSDRV_TRIGGER_FIELD_SNAP])) {
+        rc = value_u8(value, JSDRV_BUFFER_COUNT_MAX, &t->snap);
+    } else {
+        rc = JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (0 == rc) {
+        jsdrv_trigger_clear(t);
+    }
+    return rc;
+}
+
+static inline bool match_on(const struct jsdrv_trigger_s * self, uint8_t edge) {
+    return (self->edge == JSDRV_TRIGGER_EDGE_BOTH) || (self->edge == edge);
+}
+
+/*
+ * Process a single sample.  Returns true when the sample completes a
+ * match with self->event populated.
+ */
+static bool sample_add(struct jsdrv_trigger_s * self, float x, uint64_t sample_id, uint64_t duration) {
+    float hi = self->level;
+    float lo = self->level;
+    switch (self->edge) {
+        case JSDRV_TRIGGER_EDGE_RISING:  lo -= self->hyst; break;
+        case JSDRV_TRIGGER_EDGE_FALLING: hi += self->hyst; break;
+        default:
+            hi += self->hyst * 0.5f;
+            lo -= self->hyst * 0.5f;
+            break;
+    }
+
+    int8_t state = self->state;
+    if (x >= hi) {
+        state = 1;
+    } else if (x < lo) {
+        state = 0;
+    }  // else NaN or within the hysteresis band, keep the state
+
+    if (state != self->state) {
+        bool crossing = self->state >= 0;
+        self->state = state;
+        self->pending = 0;
+        uint8_t edge = state ? JSDRV_TRIGGER_EDGE_RISING : JSDRV_TRIGGER_EDGE_FALLING;
+        if (crossing && match_on(self, edge)) {
+            self->pending = 1;
+            self->pending_count = 0;
+            self->event.edge = edge;
+            self->event.value = x;
+            self->event.sample_id = sample_id;
+        }
+    }
+    if (self->pending) {
+        if (++self->pending_count >= duration) {
+            self->pending = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint64_t duration_samples(const struct jsdrv_trigger_s * self, uint32_t sample_rate, uint32_t decimate_factor) {
+    // tolerate f32 rounding so that whole sample durations do not round up
+    double n = ceil((double) self->duration * sample_rate / decimate_factor - 1e-3);
+    return (n < 1.0) ? 1 : (uint64_t) n;
+}
+
+static bool block_start(struct jsdrv_trigger_s * self, uint64_t sample_id,
+                        uint32_t sample_rate, uint32_t decimate_factor) {
+    if (0 == decimate_factor) {
+        return false;
+    }
+    if (self->sample_id_next != sample_id) {
+        jsdrv_trigger_clear(self);
+    }
+    self->event.version = 1;
+    self->event.trigger = self->index;
+    self->event.source = self->source;
+    self->event.sample_rate = sample_rate;
+    self->event.decimate_factor = decimate_factor;
+    return true;
+}
+
+uint32_t jsdrv_trigger_add_f32(struct jsdrv_trigger_s * self, uint64_t sample_id,
+        uint32_t sample_rate, uint32_t decimate_factor,
+        const float * x, uint32_t count, struct jsdrv_trigger_event_s ** event) {
+    *event = NULL;
+    if (!block_start(self, sample_id, sample_rate, decimate_factor)) {
+        return count;
+    }
+    uint64_t duration = duration_samples(self, sample_rate, decimate_factor);
+    uint32_t idx = 0;
+    while (idx < count) {
+        bool match = sample_add(self, x[idx], sample_id, duration);
+        ++idx;
+        sample_id += decimate_factor;
+        if (match) {
+            *event = &self->event;
+            break;
+        }
+    }
+    self->sample_id_next = sample_id;
+    return idx;
+}
+
+uint32_t jsdrv_trigger_add_u8(struct jsdrv_trigger_s * self, uint64_t sample_id,
+        uint32_t sample_rate, uint32_t decimate_factor,
+        const uint8_t * x, uint32_t count, struct jsdrv_trigger_event_s ** event) {
+    *event = NULL;
+    if (!block_start(self, sample_id, sample_rate, decimate_factor)) {
+        return count;
+    }
+    uint64_t duration = duration_samples(self, sample_rate, decimate_factor);
+    uint32_t idx = 0;
+    while (idx < count) {
+        bool match = sample_add(self, (float) x[idx], sample_id, duration);
+        ++idx;
+        sample_id += decimate_factor;
+        if (match) {
+            *event = &self->event;
+            break;
+        }
+    }
+    self->sample_id_next = sample_id;
+    return idx;
+}
+
+void jsdrv_trigger_meta_publish(struct jsdrv_context_s * context, const char * prefix) {
+    for (uint32_t idx = 0; idx < JSDRV_TRIGGER_COUNT; ++idx) {
+        for (uint8_t field = 0; field < JSDRV_TRIGGER_FIELD_COUNT; ++field) {
+            struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_cjson_r(FIELD_META[field]));
+            tfp_snprintf(m->topic, sizeof(m->topic), "%s/" TOPIC_PREFIX "%u/%s$", prefix, (unsigned int) idx, FIELD_NAMES[field]);
+            jsdrvp_backend_send(context, m);
+        }
+    }
+}
+
+void jsdrv_trigger_event_publish(struct jsdrv_context_s * context, const char * prefix,
+                                 const struct jsdrv_trigger_s * self) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
+    tfp_snprintf(m->topic, sizeof(m->topic), "%s/" TOPIC_PREFIX "%u/!event", prefix, (unsigned int) self->index);
+    JSDRV_ASSERT(sizeof(m->payload.bin) >= sizeof(struct jsdrv_trigger_event_s));
+    struct jsdrv_trigger_event_s * dst = (struct jsdrv_trigger_event_s *) m->payload.bin;
+    *dst = self->event;
+    m->value = jsdrv_union_cbin_r((uint8_t *) dst, sizeof(*dst));
+    m->value.app = JSDRV_PAYLOAD_TYPE_TRIGGER;
+    jsdrvp_backend_send(context, m);
+
+    if (self->snap) {
+        m = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(1));
+        tfp_snprintf(m->topic, sizeof(m->topic), "m/%03u/%s", (unsigned int) self->snap, JSDRV_BUFFER_MSG_SNAP);
+        jsdrvp_backend_send(context, m);
+    }
+}
@@ -115,6 +115,9 @@ bool jsdrv_union_equiv(const struct jsdrv_union_s * v1, const struct jsdrv_union
 
 int32_t jsdrv_union_as_type(struct jsdrv_union_s * x, uint8_t type) {
     int32_t rv = 0;
+    if (x->type == type) {
+        return rv;  // already the requested type, the common case
+    }
     jsdrv_union_widen(x);
     if (x->type == type) {
         return rv;
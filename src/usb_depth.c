@@ -0,0 +1,49 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/usb_depth.h"
+#include <string.h>
+
+
+void jsdrv_usb_depth_init(struct jsdrv_usb_depth_s * self, uint32_t depth_min, uint32_t depth_max, int64_t now) {
+    memset(self, 0, sizeof(*self));
+    self->depth = depth_min;
+    self->depth_min = depth_min;
+    self->depth_max = (depth_max > depth_min) ? depth_max : depth_min;
+    self->hold_end = now;
+    self->quiet_start = now;
+}
+
+uint32_t jsdrv_usb_depth_pressure(struct jsdrv_usb_depth_s * self, int64_t now) {
+    if (!jsdrv_usb_depth_is_adaptive(self)) {
+        return self->depth;
+    }
+    self->quiet_start = now;
+    if ((now >= self->hold_end) && (self->depth < self->depth_max)) {
+        uint32_t depth = self->depth * 2;
+        self->depth = (depth > self->depth_max) ? self->depth_max : depth;
+        self->hold_end = now + JSDRV_USB_DEPTH_HOLD;
+    }
+    return self->depth;
+}
+
+uint32_t jsdrv_usb_depth_update(struct jsdrv_usb_depth_s * self, int64_t now) {
+    if ((self->depth > self->depth_min) && ((now - self->quiet_start) >= JSDRV_USB_DEPTH_QUIET)) {
+        --self->depth;
+        self->quiet_start = now;
+    }
+    return self->depth;
+}
@@ -0,0 +1,485 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * The replay backend provides the same low-level device interface
+ * as the USB backends for a single device recorded with
+ * JSDRV_ARG_USB_TRACE.  Control in transfers return the next traced
+ * transfer with the same setup packet.  Out transfers always succeed.
+ * The traced bulk in transfers replay in order once the upper-level
+ * driver opens the bulk in stream, either at the traced timing or as
+ * fast as the upper-level driver returns the transfers.
+ *
+ * Device responses must not arrive before the matching host requests.
+ * Each bulk in transfer waits until the upper-level driver has issued
+ * at least as many control and bulk out transfers as preceded it in
+ * the trace.  When the upper-level driver issues fewer requests than
+ * the traced session, the wait ends after GATE_TIMEOUT_MS.
+ *
+ * Note that the JS110 upper-level driver discards the sample data
+ * for fields that it has not enabled, so replay a JS110 trace with
+ * the same fields enabled as during the capture.
+ */
+
+#define JSDRV_LOG_LEVEL JSDRV_LOG_LEVEL_ALL
+#include "jsdrv.h"
+#include "jsdrv_prv/backend.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/latency.h"
+#include "jsdrv_prv/list.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/msg_queue.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv_prv/usb_spec.h"
+#include "jsdrv_prv/usb_trace.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/time.h"
+#include <inttypes.h>
+
+
+#define BACKEND_PREFIX                  'y'
+#define LOOP_TIMEOUT_MS                 (1U)
+#define IDLE_TIMEOUT_MS                 (50U)
+#define GATE_TIMEOUT_MS                 (1000U)
+
+struct transfer_s {
+    struct jsdrv_list_s item;
+    struct jsdrvp_msg_s * msg;              // the bulk in loan message, owned by this transfer
+    uint32_t buffer_size;
+    uint8_t buffer[];                       // must be last
+};
+
+struct backend_s;
+
+struct dev_s {
+    struct jsdrvp_ll_device_s ll;
+    struct backend_s * backend;
+    jsdrv_thread_t thread;
+    volatile bool do_exit;
+    bool open;
+
+    struct jsdrv_usb_trace_reader_s * bulk;  // bulk in cursor
+    struct jsdrv_usb_trace_reader_s * ctrl;  // control in cursor
+
+    bool bulk_in_open;
+    uint32_t bulk_in_depth;
+    uint32_t bulk_in_size;
+    uint32_t bulk_in_spare;
+    struct jsdrv_list_s transfers_free;
+
+    bool started;
+    bool done;
+    struct jsdrv_usb_trace_record_s record; // the pending bulk in record
+    const uint8_t * payload;                // the pending bulk in record payload
+    uint32_t offset;                        // the bytes of payload already sent
+    int64_t time_first;                     // the first traced bulk in time
+    int64_t time_start;                     // the replay start time
+    uint64_t host_count;                    // control and bulk out transfers from the upper layer
+    uint64_t trace_host_count;              // control and bulk out transfers traced before the record
+    int64_t gate_time;                      // the wait start for host_count, 0 when not waiting
+    uint64_t transfer_count;
+    uint64_t byte_count;
+};
+
+struct backend_s {
+    struct jsdrvbk_s backend;
+    struct jsdrv_context_s * context;
+    uint32_t speed;                         // percent of real time, 0 for unpaced
+    struct dev_s * device;
+};
+
+static void transfer_destroy(struct dev_s * d, struct transfer_s * t) {
+    if (NULL != t->msg) {
+        jsdrvp_msg_free(d->backend->context, t->msg);
+        t->msg = NULL;
+    }
+    jsdrv_free(t);
+}
+
+static void transfers_free_clear(struct dev_s * d) {
+    struct jsdrv_list_s * item;
+    while (NULL != (item = jsdrv_list_remove_head(&d->transfers_free))) {
+        transfer_destroy(d, JSDRV_CONTAINER_OF(item, struct transfer_s, item));
+    }
+}
+
+static void transfer_return(struct dev_s * d, struct jsdrvp_msg_s * msg) {
+    struct transfer_s * t = JSDRV_CONTAINER_OF(msg->value.value.bin, struct transfer_s, buffer);
+    if (t->msg != msg) {
+        JSDRV_LOGW("stream_in_data message not owned by transfer");
+        jsdrvp_msg_free(d->backend->context, msg);
+    } else if (!d->bulk_in_open || (t->buffer_size != d->bulk_in_size)) {
+        transfer_destroy(d, t);
+    } else {
+        jsdrv_list_add_tail(&d->transfers_free, &t->item);
+    }
+}
+
+static void replay_reset(struct dev_s * d) {
+    jsdrv_usb_trace_reader_rewind(d->bulk);
+    jsdrv_usb_trace_reader_rewind(d->ctrl);
+    d->started = false;
+    d->done = false;
+    d->payload = NULL;
+    d->offset = 0;
+    d->host_count = 0;
+    d->trace_host_count = 0;
+    d->gate_time = 0;
+    d->transfer_count = 0;
+    d->byte_count = 0;
+}
+
+static void replay_done(struct dev_s * d) {
+    d->done = true;
+    double dt = JSDRV_TIME_TO_F64(jsdrv_time_utc() - d->time_start);
+    double rate = (dt > 0.0) ? (d->byte_count / (dt * 1e6)) : 0.0;
+    JSDRV_LOGI("%s replay done: %" PRIu64 " transfers, %" PRIu64 " bytes in %.3f s (%.1f MB/s)",
+               d->ll.prefix, d->transfer_count, d->byte_count, dt, rate);
+}
+
+// Get the pending bulk in record, or false at the end of the trace.
+static bool record_next(struct dev_s * d) {
+    while (NULL == d->payload) {
+        int32_t rc = jsdrv_usb_trace_reader_next(d->bulk, &d->record, &d->payload);
+        if (rc) {
+            d->payload = NULL;
+            if (JSDRV_ERROR_IO == rc) {
+                JSDRV_LOGW("%s replay trace truncated", d->ll.prefix);
+            }
+            return false;
+        }
+        if (JSDRV_USB_TRACE_BULK_IN != d->record.type) {
+            if (JSDRV_USB_TRACE_END != d->record.type) {
+                ++d->trace_host_count;
+            }
+            d->payload = NULL;
+            continue;
+        } else if (d->record.status || !d->record.payload_size) {
+            d->payload = NULL;
+            continue;
+        }
+        d->offset = 0;
+        if (!d->started) {
+            d->started = true;
+            d->time_first = d->record.time;
+            d->time_start = jsdrv_time_utc();
+        }
+    }
+    return true;
+}
+
+static bool is_gated(struct dev_s * d) {
+    if (d->host_count >= d->trace_host_count) {
+        return false;
+    }
+    int64_t now = jsdrv_time_utc();
+    if (0 == d->gate_time) {
+        d->gate_time = now;
+    } else if ((now - d->gate_time) >= (GATE_TIMEOUT_MS * JSDRV_TIME_MILLISECOND)) {
+        JSDRV_LOGW("%s replay host request timeout: %" PRIu64 " of %" PRIu64,
+                   d->ll.prefix, d->host_count, d->trace_host_count);
+        d->host_count = d->trace_host_count;
+        return false;
+    }
+    return true;
+}
+
+static bool is_due(struct dev_s * d) {
+    uint32_t speed = d->backend->speed;
+    if (0 == speed) {
+        return true;
+    }
+    int64_t dt = ((d->record.time - d->time_first) * 100) / speed;
+    return (jsdrv_time_utc() - d->time_start) >= dt;
+}
+
+static void bulk_in_process(struct dev_s * d) {
+    while (d->bulk_in_open && !d->done && !jsdrv_list_is_empty(&d->transfers_free)) {
+        if (!record_next(d)) {
+            replay_done(d);
+            return;
+        }
+        if (is_gated(d)) {
+            return;
+        }
+        if (d->gate_time) {
+            // restart the pacing after waiting on the upper layer
+            d->gate_time = 0;
+            d->time_first = d->record.time;
+            d->time_start = jsdrv_time_utc();
+        }
+        if (!is_due(d)) {
+            return;
+        }
+        struct jsdrv_list_s * item = jsdrv_list_remove_head(&d->transfers_free);
+        struct transfer_s * t = JSDRV_CONTAINER_OF(item, struct transfer_s, item);
+        uint32_t sz = d->record.payload_size - d->offset;
+        if (sz > t->buffer_size) {
+            sz = t->buffer_size;
+        }
+        memcpy(t->buffer, d->payload + d->offset, sz);
+        d->offset += sz;
+        if (d->offset >= d->record.payload_size) {
+            d->payload = NULL;
+        }
+        t->msg->value = jsdrv_union_bin(t->buffer, sz);
+        t->msg->extra.bkusb_stream.endpoint = d->record.endpoint;
+        JSDRV_LATENCY_STAMP(t->msg->latency.usb);
+        msg_queue_push(d->ll.rsp_q, t->msg);
+        ++d->transfer_count;
+        d->byte_count += sz;
+    }
+}
+
+static void ctrl_in(struct dev_s * d, struct jsdrvp_msg_s * msg) {
+    const usb_setup_t * setup = &msg->extra.bkusb_ctrl.setup;
+    struct jsdrv_usb_trace_record_s record;
+    const uint8_t * payload = NULL;
+    bool wrapped = false;
+    while (1) {
+        if (jsdrv_usb_trace_reader_next(d->ctrl, &record, &payload)) {
+            if (wrapped) {
+                JSDRV_LOGW("%s replay ctrl_in not traced: 0x%016" PRIx64, d->ll.prefix, setup->u64);
+                msg->extra.bkusb_ctrl.status = JSDRV_ERROR_NOT_SUPPORTED;
+                break;
+            }
+            jsdrv_usb_trace_reader_rewind(d->ctrl);
+            wrapped = true;
+        } else if ((JSDRV_USB_TRACE_CTRL_IN == record.type) && (record.setup == setup->u64)) {
+            uint32_t sz = record.payload_size;
+            if (sz > setup->s.wLength) {
+                sz = setup->s.wLength;
+            }
+            if (sz > JSDRV_PAYLOAD_LENGTH_MAX) {
+                sz = JSDRV_PAYLOAD_LENGTH_MAX;
+            }
+            if (0 == record.status) {
+                memcpy(msg->payload.bin, payload, sz);
+                msg->value = jsdrv_union_bin(msg->payload.bin, sz);
+            }
+            msg->extra.bkusb_ctrl.status = record.status;
+            break;
+        }
+    }
+    msg_queue_push(d->ll.rsp_q, msg);
+}
+
+static void bulk_in_close(struct dev_s * d) {
+    d->bulk_in_open = false;
+    transfers_free_clear(d);
+}
+
+static void bulk_in_open(struct dev_s * d, struct jsdrvp_msg_s * msg) {
+    bulk_in_close(d);
+    d->bulk_in_depth = jsdrv_usbbk_bulk_in_depth(msg->extra.bkusb_stream.transfer_depth);
+    d->bulk_in_size = jsdrv_usbbk_bulk_in_size(msg->extra.bkusb_stream.transfer_size);
+    d->bulk_in_spare = jsdrv_usbbk_bulk_in_spare(msg->extra.bkusb_stream.transfer_spare);
+    JSDRV_LOGI("bulk_in_open(%s, endpoint=0x%02x, depth=%" PRIu32 ", size=%" PRIu32 ", spare=%" PRIu32 ")",
+               d->ll.prefix, (int) msg->extra.bkusb_stream.endpoint,
+               d->bulk_in_depth, d->bulk_in_size, d->bulk_in_spare);
+    for (uint32_t i = 0; i < (d->bulk_in_depth + d->bulk_in_spare); ++i) {
+        struct transfer_s * t = jsdrv_alloc_clr(sizeof(struct transfer_s) + d->bulk_in_size);
+        jsdrv_list_initialize(&t->item);
+        t->buffer_size = d->bulk_in_size;
+        t->msg = jsdrvp_msg_alloc(d->backend->context);
+        jsdrv_cstr_copy(t->msg->topic, JSDRV_USBBK_MSG_STREAM_IN_DATA, sizeof(t->msg->topic));
+        jsdrv_list_add_tail(&d->transfers_free, &t->item);
+    }
+    d->bulk_in_open = true;
+    msg->value = jsdrv_union_i32(0);
+    msg_queue_push(d->ll.rsp_q, msg);
+}
+
+static void device_handle_msg(struct dev_s * d, struct jsdrvp_msg_s * msg) {
+    if (0 == strcmp(JSDRV_USBBK_MSG_STREAM_IN_DATA, msg->topic)) {
+        transfer_return(d, msg);
+        return;
+    }
+    JSDRV_LOGD2("device_handle_msg(%s) %s", d->ll.prefix, msg->topic);
+    if (0 == strcmp(JSDRV_USBBK_MSG_BULK_OUT_DATA, msg->topic)) {
+        ++d->host_count;
+        msg->value = jsdrv_union_i32(0);
+    } else if (0 == strcmp(JSDRV_USBBK_MSG_CTRL_IN, msg->topic)) {
+        ++d->host_count;
+        ctrl_in(d, msg);
+        return;
+    } else if (0 == strcmp(JSDRV_USBBK_MSG_CTRL_OUT, msg->topic)) {
+        ++d->host_count;
+        msg->extra.bkusb_ctrl.status = 0;
+    } else if (0 == strcmp(JSDRV_USBBK_MSG_BULK_IN_STREAM_OPEN, msg->topic)) {
+        bulk_in_open(d, msg);
+        return;
+    } else if (0 == strcmp(JSDRV_USBBK_MSG_BULK_IN_STREAM_CLOSE, msg->topic)) {
+        bulk_in_close(d);
+        msg->value = jsdrv_union_i32(0);
+    } else if (0 == strcmp(JSDRV_MSG_OPEN, msg->topic)) {
+        JSDRV_LOGI("device_open(%s)", d->ll.prefix);
+        replay_reset(d);
+        d->open = true;
+        msg->value = jsdrv_union_i32(0);
+    } else if ((0 == strcmp(JSDRV_MSG_CLOSE, msg->topic)) || (0 == strcmp(JSDRV_MSG_FINALIZE, msg->topic))) {
+        JSDRV_LOGI("device_close(%s)", d->ll.prefix);
+        bulk_in_close(d);
+        d->open = false;
+        msg->value = jsdrv_union_i32(0);
+    } else {
+        JSDRV_LOGW("unsupported topic %s", msg->topic);
+        msg->value = jsdrv_union_i32(JSDRV_ERROR_PARAMETER_INVALID);
+    }
+    msg_queue_push(d->ll.rsp_q, msg);
+}
+
+static THREAD_RETURN_TYPE device_thread(THREAD_ARG_TYPE lpParam) {
+    struct dev_s * d = (struct dev_s *) lpParam;
+    struct jsdrvp_msg_s * msg = NULL;
+    JSDRV_LOGI("replay device thread started %s", d->ll.prefix);
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_USB);
+    while (!d->do_exit) {
+        bool active = d->bulk_in_open && !d->done;
+        uint32_t timeout_ms = active ? LOOP_TIMEOUT_MS : IDLE_TIMEOUT_MS;
+        if (0 == msg_queue_pop(d->ll.cmd_q, &msg, timeout_ms)) {
+            device_handle_msg(d, msg);
+            while (NULL != (msg = msg_queue_pop_immediate(d->ll.cmd_q))) {
+                device_handle_msg(d, msg);
+            }
+        }
+        bulk_in_process(d);
+    }
+    JSDRV_LOGI("replay device thread done %s", d->ll.prefix);
+    jsdrv_thread_unregister();
+    THREAD_RETURN();
+}
+
+static void queue_drain(struct dev_s * d, struct msg_queue_s * q) {
+    struct jsdrvp_msg_s * msg;
+    while (NULL != (msg = msg_queue_pop_immediate(q))) {
+        if (0 == strcmp(JSDRV_USBBK_MSG_STREAM_IN_DATA, msg->topic)) {
+            struct transfer_s * t = JSDRV_CONTAINER_OF(msg->value.value.bin, struct transfer_s, buffer);
+            if (t->msg == msg) {
+                transfer_destroy(d, t);
+                continue;
+            }
+        }
+        jsdrvp_msg_free(d->backend->context, msg);
+    }
+}
+
+static void device_free(struct dev_s * d) {
+    if (d->thread) {
+        d->do_exit = true;
+        jsdrv_thread_join(&d->thread, 1000);
+    }
+    bulk_in_close(d);
+    if (d->ll.cmd_q) {
+        queue_drain(d, d->ll.cmd_q);
+        queue_drain(d, d->ll.rsp_q);
+        msg_queue_finalize(d->ll.cmd_q);
+        msg_queue_finalize(d->ll.rsp_q);
+    }
+    jsdrv_usb_trace_reader_close(d->bulk);
+    jsdrv_usb_trace_reader_close(d->ctrl);
+    jsdrv_free(d);
+}
+
+static void device_add_announce(struct backend_s * s, struct dev_s * d) {
+    struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc(s->context);
+    jsdrv_cstr_copy(msg->topic, JSDRV_MSG_DEVICE_ADD, sizeof(msg->topic));
+    msg->value.type = JSDRV_UNION_BIN;
+    msg->value.app = JSDRV_PAYLOAD_TYPE_DEVICE;
+    msg->value.value.bin = (const uint8_t *) &msg->payload.device;
+    msg->payload.device = d->ll;
+    jsdrvp_backend_send(s->context, msg);
+}
+
+static int32_t device_add(struct backend_s * s, const char * path) {
+    struct jsdrv_usb_trace_header_s header;
+    struct dev_s * d = jsdrv_alloc_clr(sizeof(struct dev_s));
+    d->backend = s;
+    s->device = d;
+    jsdrv_list_initialize(&d->transfers_free);
+    d->bulk = jsdrv_usb_trace_reader_open(path, &header);
+    d->ctrl = jsdrv_usb_trace_reader_open(path, &header);
+    if ((NULL == d->bulk) || (NULL == d->ctrl) || (header.prefix[0] == 0) || (header.prefix[1] != '/')) {
+        JSDRV_LOGE("replay trace invalid: %s", path);
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    jsdrv_cstr_copy(d->ll.prefix, header.prefix, sizeof(d->ll.prefix));
+    d->ll.prefix[0] = s->backend.prefix;
+    JSDRV_LOGI("replay %s as %s", path, d->ll.prefix);
+    d->ll.cmd_q = msg_queue_init_spsc(MSG_QUEUE_SPSC_CAPACITY_DEFAULT);
+    d->ll.rsp_q = msg_queue_init_spsc(MSG_QUEUE_SPSC_CAPACITY_DEFAULT);
+    msg_queue_lanes_enable(d->ll.rsp_q);
+    if (jsdrv_thread_create(&d->thread, device_thread, d, 1)) {
+        JSDRV_LOGE("replay device thread create failed");
+        return JSDRV_ERROR_UNSPECIFIED;
+    }
+    device_add_announce(s, d);
+    return 0;
+}
+
+static void backend_finalize(struct jsdrvbk_s * backend) {
+    if (backend) {
+        struct backend_s * s = (struct backend_s *) backend;
+        JSDRV_LOGI("finalize replay backend");
+        if (s->device) {
+            device_free(s->device);
+            s->device = NULL;
+        }
+        if (s->backend.cmd_q) {
+            msg_queue_finalize(s->backend.cmd_q);
+            s->backend.cmd_q = NULL;
+        }
+        jsdrv_free(s);
+    }
+}
+
+int32_t jsdrv_usb_replay_backend_factory(struct jsdrv_context_s * context, struct jsdrvbk_s ** backend) {
+    const struct jsdrv_union_s * path = jsdrvp_arg_get(context, JSDRV_ARG_USB_REPLAY);
+    if ((NULL == path) || (path->type != JSDRV_UNION_STR) || (NULL == path->value.str)) {
+        JSDRV_LOGE("invalid argument type for %s", JSDRV_ARG_USB_REPLAY);
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    struct backend_s * s = jsdrv_alloc_clr(sizeof(struct backend_s));
+    s->context = context;
+    s->backend.prefix = BACKEND_PREFIX;
+    s->backend.finalize = backend_finalize;
+    s->backend.cmd_q = msg_queue_init();
+    s->speed = 100;
+    const struct jsdrv_union_s * arg = jsdrvp_arg_get(context, JSDRV_ARG_USB_REPLAY_SPEED);
+    if (NULL != arg) {
+        struct jsdrv_union_s v = *arg;
+        if (0 == jsdrv_union_as_type(&v, JSDRV_UNION_U32)) {
+            s->speed = v.value.u32;
+        } else {
+            JSDRV_LOGW("invalid argument type for %s", JSDRV_ARG_USB_REPLAY_SPEED);
+        }
+    }
+
+    struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc_value(context, JSDRV_MSG_INITIALIZE, &jsdrv_union_i32(0));
+    msg->payload.str[0] = s->backend.prefix;
+    jsdrvp_backend_send(context, msg);
+
+    int32_t rc = device_add(s, path->value.str);
+    if (rc) {
+        backend_finalize(&s->backend);
+        return rc;
+    }
+    *backend = &s->backend;
+    return 0;
+}
@@ -0,0 +1,252 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/usb_trace.h"
+#include "jsdrv_prv/backend.h"
+#include "jsdrv_prv/cdef.h"
+#include "jsdrv_prv/file_writer.h"
+#include "jsdrv_prv/log.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/time.h"
+#include "tinyprintf.h"
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+
+#define ALIGN8(x)               (((x) + 7U) & ~7U)
+#define RECORD_SIZE(payload)    (sizeof(struct jsdrv_usb_trace_record_s) + ALIGN8(payload))
+#define READ_BUFFER_SIZE        (1024U * 1024U)
+JSDRV_STATIC_ASSERT(0 == (sizeof(struct jsdrv_usb_trace_header_s) & 7), header_size);
+JSDRV_STATIC_ASSERT(32 == sizeof(struct jsdrv_usb_trace_record_s), record_size);
+JSDRV_STATIC_ASSERT(JSDRV_USBBK_BULK_IN_SIZE_MAX <= JSDRV_USB_TRACE_PAYLOAD_MAX, payload_max);
+JSDRV_STATIC_ASSERT(RECORD_SIZE(JSDRV_USB_TRACE_PAYLOAD_MAX) <= JSDRV_FILE_WRITER_BUFFER_SIZE, buffer_size);
+
+
+struct jsdrv_usb_trace_s {
+    struct jsdrv_file_writer_s * writer;
+    uint64_t size;          // the bytes appended
+    uint64_t record_count;
+    uint64_t drop_count;
+};
+
+struct jsdrv_usb_trace_reader_s {
+    FILE * f;
+    uint32_t header_size;
+    uint32_t buffer_size;
+    uint8_t * buffer;
+    bool end;
+};
+
+static int32_t record_write(struct jsdrv_usb_trace_s * self, uint8_t type, uint8_t endpoint,
+                            uint64_t setup, int32_t status, const void * data, uint32_t size) {
+    uint32_t sz = RECORD_SIZE(size);
+    uint8_t * p = jsdrv_file_writer_reserve(self->writer, sz);
+    if (NULL == p) {
+        return JSDRV_ERROR_FULL;
+    }
+    self->size += sz;
+    struct jsdrv_usb_trace_record_s * r = (struct jsdrv_usb_trace_record_s *) p;
+    r->type = type;
+    r->endpoint = endpoint;
+    r->rsv = 0;
+    r->payload_size = size;
+    r->time = jsdrv_time_utc();
+    r->setup = setup;
+    r->status = status;
+    r->rsv2 = 0;
+    p += sizeof(*r);
+    if (size) {
+        memcpy(p, data, size);
+    }
+    memset(p + size, 0, ALIGN8(size) - size);
+    return 0;
+}
+
+int32_t jsdrv_usb_trace_path(const char * dir, const char * prefix, char * path, size_t path_size) {
+    char name[JSDRV_TOPIC_LENGTH_MAX];
+    // skip the backend prefix character, "u/js220/000415" -> "js220_000415"
+    const char * src = (prefix[0] && (prefix[1] == '/')) ? (prefix + 2) : prefix;
+    size_t k = 0;
+    for (; src[k] && (k < (sizeof(name) - 1)); ++k) {
+        name[k] = (src[k] == '/') ? '_' : src[k];
+    }
+    name[k] = 0;
+    int n = tfp_snprintf(path, path_size, "%s/%s%s", dir, name, JSDRV_USB_TRACE_EXTENSION);
+    if ((n < 0) || ((size_t) n >= path_size)) {
+        return JSDRV_ERROR_TOO_SMALL;
+    }
+    return 0;
+}
+
+struct jsdrv_usb_trace_s * jsdrv_usb_trace_open(const char * path, const char * prefix) {
+    if ((NULL == path) || (NULL == prefix)) {
+        return NULL;
+    }
+    struct jsdrv_file_writer_config_s config = {
+        .buffer_size = JSDRV_FILE_WRITER_BUFFER_SIZE,
+        .buffer_count = JSDRV_FILE_WRITER_BUFFER_COUNT,
+        .flags = 0,
+        .sync = JSDRV_FILE_WRITER_SYNC_CLOSE,
+        .sync_interval_ms = 0,
+        .preallocate = 0,
+    };
+    struct jsdrv_file_writer_s * writer = jsdrv_file_writer_open(path, &config);
+    if (NULL == writer) {
+        JSDRV_LOGW("usb trace open failed: %s", path);
+        return NULL;
+    }
+    struct jsdrv_usb_trace_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_usb_trace_s));
+    self->writer = writer;
+    struct jsdrv_usb_trace_header_s * hdr = (struct jsdrv_usb_trace_header_s *) jsdrv_file_writer_reserve(writer, sizeof(*hdr));
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->magic, JSDRV_USB_TRACE_MAGIC, sizeof(hdr->magic));
+    hdr->version = JSDRV_USB_TRACE_VERSION;
+    hdr->header_size = sizeof(*hdr);
+    hdr->utc = jsdrv_time_utc();
+    jsdrv_cstr_copy(hdr->prefix, prefix, sizeof(hdr->prefix));
+    self->size = sizeof(*hdr);
+    JSDRV_LOGI("usb trace open %s", path);
+    return self;
+}
+
+int32_t jsdrv_usb_trace_write(struct jsdrv_usb_trace_s * self, uint8_t type, uint8_t endpoint,
+                              uint64_t setup, int32_t status, const void * data, uint32_t size) {
+    struct jsdrv_file_writer_status_s w;
+    if (NULL == self) {
+        return 0;
+    }
+    if ((type < JSDRV_USB_TRACE_CTRL_IN) || (type >= JSDRV_USB_TRACE_END)
+            || (size > JSDRV_USB_TRACE_PAYLOAD_MAX) || ((NULL == data) && size)) {
+        return JSDRV_ERROR_PARAMETER_INVALID;
+    }
+    if (record_write(self, type, endpoint, setup, status, data, size)) {
+        ++self->drop_count;
+        jsdrv_file_writer_status(self->writer, &w);
+        return w.error ? w.error : JSDRV_ERROR_FULL;
+    }
+    ++self->record_count;
+    return 0;
+}
+
+void jsdrv_usb_trace_status(struct jsdrv_usb_trace_s * self, struct jsdrv_usb_trace_status_s * status) {
+    struct jsdrv_file_writer_status_s w;
+    jsdrv_file_writer_status(self->writer, &w);
+    status->record_count = self->record_count;
+    status->drop_count = self->drop_count;
+    status->bytes_written = w.bytes_written;
+}
+
+int32_t jsdrv_usb_trace_close(struct jsdrv_usb_trace_s * self) {
+    if (NULL == self) {
+        return 0;
+    }
+    struct jsdrv_usb_trace_status_s end;
+    end.record_count = self->record_count;
+    end.drop_count = self->drop_count;
+    end.bytes_written = self->size;
+    while (record_write(self, JSDRV_USB_TRACE_END, 0, 0, 0, &end, sizeof(end))) {
+        jsdrv_thread_sleep_ms(1);  // closing may block for the writer
+    }
+    int32_t rc = jsdrv_file_writer_close(self->writer);
+    JSDRV_LOGI("usb trace close: %" PRIu64 " records, %" PRIu64 " dropped, %" PRIu64 " bytes, rc=%" PRId32,
+               self->record_count, self->drop_count, self->size, rc);
+    jsdrv_free(self);
+    return rc;
+}
+
+struct jsdrv_usb_trace_reader_s * jsdrv_usb_trace_reader_open(const char * path,
+                                                              struct jsdrv_usb_trace_header_s * header) {
+    FILE * f = fopen(path, "rb");
+    if (NULL == f) {
+        JSDRV_LOGW("usb trace not found: %s", path);
+        return NULL;
+    }
+    if ((1 != fread(header, sizeof(*header), 1, f))
+            || (0 != memcmp(header->magic, JSDRV_USB_TRACE_MAGIC, sizeof(header->magic)))
+            || (header->version != JSDRV_USB_TRACE_VERSION)
+            || (header->header_size < sizeof(*header))
+            || (0 != fseek(f, (long) header->header_size, SEEK_SET))) {
+        JSDRV_LOGW("usb trace invalid header: %s", path);
+        fclose(f);
+        return NULL;
+    }
+    header->prefix[sizeof(header->prefix) - 1] = 0;
+    struct jsdrv_usb_trace_reader_s * self = jsdrv_alloc_clr(sizeof(struct jsdrv_usb_trace_reader_s));
+    self->f = f;
+    self->header_size = header->header_size;
+    self->buffer_size = READ_BUFFER_SIZE;
+    self->buffer = jsdrv_alloc(self->buffer_size);
+    return self;
+}
+
+int32_t jsdrv_usb_trace_reader_next(struct jsdrv_usb_trace_reader_s * self,
+                                    struct jsdrv_usb_trace_record_s * record, const uint8_t ** payload) {
+    if (self->end) {
+        return JSDRV_ERROR_UNAVAILABLE;
+    }
+    size_t n = fread(record, 1, sizeof(*record), self->f);
+    if (0 == n) {
+        self->end = true;  // no END record, such as a crash during capture
+        return JSDRV_ERROR_UNAVAILABLE;
+    } else if ((n != sizeof(*record)) || (record->payload_size > JSDRV_USB_TRACE_PAYLOAD_MAX)) {
+        self->end = true;
+        return JSDRV_ERROR_IO;
+    }
+    uint32_t sz = ALIGN8(record->payload_size);
+    if (NULL == payload) {
+        if (sz && fseek(self->f, (long) sz, SEEK_CUR)) {
+            self->end = true;
+            return JSDRV_ERROR_IO;
+        }
+    } else {
+        if (sz > self->buffer_size) {
+            jsdrv_free(self->buffer);
+            self->buffer_size = sz;
+            self->buffer = jsdrv_alloc(self->buffer_size);
+        }
+        if (sz && (1 != fread(self->buffer, sz, 1, self->f))) {
+            self->end = true;
+            return JSDRV_ERROR_IO;
+        }
+        *payload = self->buffer;
+    }
+    if (JSDRV_USB_TRACE_END == record->type) {
+        self->end = true;
+    }
+    return 0;
+}
+
+int32_t jsdrv_usb_trace_reader_rewind(struct jsdrv_usb_trace_reader_s * self) {
+    self->end = false;
+    if (fseek(self->f, (long) self->header_size, SEEK_SET)) {
+        self->end = true;
+        return JSDRV_ERROR_IO;
+    }
+    return 0;
+}
+
+void jsdrv_usb_trace_reader_close(struct jsdrv_usb_trace_reader_s * self) {
+    if (NULL != self) {
+        fclose(self->f);
+        jsdrv_free(self->buffer);
+        jsdrv_free(self);
+    }
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jsdrv_prv/value_cache.h"
+#include "jsdrv_prv/atomic.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/pubsub.h"
+#include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv.h"
+#include <string.h>
+
+
+#define READ_RETRY_MAX (16U)
+#define COUNT_MAX ((JSDRV_VALUE_CACHE_SIZE * 3U) / 4U)  // limit the probe length
+
+struct entry_s {
+    volatile int32_t seq;       // odd during an update
+    volatile int32_t hash;      // 0 until assigned, then constant
+    int32_t valid;              // guarded by seq
+    int32_t direct;             // guarded by seq, see jsdrv_value_cache_direct_set()
+    struct jsdrv_union_s value; // guarded by seq
+    char topic[JSDRV_TOPIC_LENGTH_MAX];  // constant once hash is assigned
+};
+
+struct jsdrv_value_cache_s {
+    uint32_t count;             // writer only
+    struct entry_s entries[JSDRV_VALUE_CACHE_SIZE];
+};
+
+struct jsdrv_value_cache_s * jsdrv_value_cache_alloc(void) {
+    return jsdrv_alloc_clr(sizeof(struct jsdrv_value_cache_s));
+}
+
+void jsdrv_value_cache_free(struct jsdrv_value_cache_s * self) {
+    if (self) {
+        jsdrv_free(self);
+    }
+}
+
+// Find the writer's entry for topic, or assign a new entry when create.
+static struct entry_s * entry_find(struct jsdrv_value_cache_s * self, const char * topic, uint32_t hash, bool create) {
+    uint32_t idx = hash & (JSDRV_VALUE_CACHE_SIZE - 1);
+    while (1) {
+        struct entry_s * e = &self->entries[idx];
+        if (0 == e->hash) {
+            if (!create || (self->count >= COUNT_MAX)) {
+                return NULL;  // nothing to invalidate or full
+            }
+            jsdrv_cstr_copy(e->topic, topic, sizeof(e->topic));
+            ++self->count;
+            jsdrv_atomic_store(&e->hash, (int32_t) hash);  // publish the entry, valid=0 and direct=0
+            return e;
+        } else if (((uint32_t) e->hash == hash) && (0 == strcmp(e->topic, topic))) {
+            return e;
+        }
+        idx = (idx + 1) & (JSDRV_VALUE_CACHE_SIZE - 1);
+    }
+}
+
+void jsdrv_value_cache_set(struct jsdrv_value_cache_s * self, const char * topic, uint32_t hash,
+                           const struct jsdrv_union_s * value) {
+    bool valid = (NULL != value) && !jsdrv_union_is_type_ptr(value);
+    struct entry_s * e = entry_find(self, topic, hash, valid);
+    if (NULL == e) {
+        return;
+    }
+    jsdrv_atomic_add(&e->seq, 1);
+    if (valid) {
+        e->value = *value;
+    }
+    e->valid = valid ? 1 : 0;
+    jsdrv_atomic_add(&e->seq, 1);
+}
+
+void jsdrv_value_cache_direct_set(struct jsdrv_value_cache_s * self, const char * topic, uint32_t hash,
+                                  bool direct) {
+    struct entry_s * e = entry_find(self, topic, hash, direct);
+    if (NULL == e) {
+        return;
+    }
+    jsdrv_atomic_add(&e->seq, 1);
+    e->direct = direct ? 1 : 0;
+    jsdrv_atomic_add(&e->seq, 1);
+}
+
+// Copy a consistent snapshot, false when the writer kept updating.
+static bool entry_read(struct entry_s * e, int32_t * valid, int32_t * direct, struct jsdrv_union_s * value) {
+    for (uint32_t retry = 0; retry < READ_RETRY_MAX; ++retry) {
+        int32_t seq = jsdrv_atomic_load(&e->seq);
+        if (seq & 1) {
+            continue;  // update in progress
+        }
+        int32_t v_valid = e->valid;
+        int32_t v_direct = e->direct;
+        struct jsdrv_union_s v = e->value;
+        jsdrv_atomic_fence();
+        if (seq == jsdrv_atomic_load(&e->seq)) {
+            *valid = v_valid;
+            *direct = v_direct;
+            if (v_valid) {
+                *value = v;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+static struct entry_s * entry_lookup(struct jsdrv_value_cache_s * self, const char * topic) {
+    if (!self || !topic) {
+        return NULL;
+    }
+    uint32_t hash = jsdrv_pubsub_topic_hash(topic);
+    uint32_t idx = hash & (JSDRV_VALUE_CACHE_SIZE - 1);
+    for (uint32_t probe = 0; probe < JSDRV_VALUE_CACHE_SIZE; ++probe) {
+        struct entry_s * e = &self->entries[idx];
+        uint32_t h = (uint32_t) jsdrv_atomic_load(&e->hash);
+        if (0 == h) {
+            break;
+        } else if ((h == hash) && (0 == strcmp(e->topic, topic))) {
+            return e;
+        }
+        idx = (idx + 1) & (JSDRV_VALUE_CACHE_SIZE - 1);
+    }
+    return NULL;
+}
+
+int32_t jsdrv_value_cache_get(struct jsdrv_value_cache_s * self, const char * topic,
+                              struct jsdrv_union_s * value) {
+    int32_t valid = 0;
+    int32_t direct = 0;
+    struct entry_s * e = entry_lookup(self, topic);
+    if (e && entry_read(e, &valid, &direct, value) && valid) {
+        return 0;
+    }
+    return JSDRV_ERROR_UNAVAILABLE;
+}
+
+int32_t jsdrv_value_cache_direct_get(struct jsdrv_value_cache_s * self, const char * topic,
+                                     struct jsdrv_union_s * value) {
+    int32_t valid = 0;
+    int32_t direct = 0;
+    struct entry_s * e = entry_lookup(self, topic);
+    if (e && entry_read(e, &valid, &direct, value) && direct) {
+        if (!valid) {
+            *value = jsdrv_union_null();
+        }
+        return 0;
+    }
+    return JSDRV_ERROR_UNAVAILABLE;
+}
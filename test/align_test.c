@@ -0,0 +1,189 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <math.h>
+#include <string.h>
+#include "jsdrv_prv/align.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/time.h"
+
+
+#define OUT_MAX (250000U)
+#define T0 (JSDRV_TIME_SECOND * 1000)
+
+struct out_s {
+    uint32_t count;
+    uint32_t frames;
+    uint64_t sample_id_next;
+    float y[2][OUT_MAX];
+};
+
+static struct out_s out_;
+static struct jsdrv_stream_signal_s signal_;
+
+static void on_frame(void * user_data, const struct jsdrv_align_frame_s * frame, uint32_t size) {
+    struct out_s * out = (struct out_s *) user_data;
+    uint32_t n = frame->element_count;
+    assert_int_equal(2, frame->source_count);
+    assert_int_equal(JSDRV_STREAM_HEADER_SIZE + 2 * n * sizeof(float), size);
+    if (out->frames) {
+        assert_int_equal(out->sample_id_next, frame->sample_id);
+    }
+    out->sample_id_next = frame->sample_id + n * frame->decimate_factor;
+    assert_true((out->count + n) <= OUT_MAX);
+    memcpy(&out->y[0][out->count], frame->data, n * sizeof(float));
+    memcpy(&out->y[1][out->count], frame->data + n, n * sizeof(float));
+    out->count += n;
+    ++out->frames;
+}
+
+static struct jsdrv_align_s * setup(void) {
+    memset(&out_, 0, sizeof(out_));
+    struct jsdrv_align_s * a = jsdrv_align_alloc(on_frame, &out_);
+    assert_non_null(a);
+    assert_int_equal(0, jsdrv_align_source_count_set(a, 2));
+    return a;
+}
+
+/*
+ * Send count samples starting at sample index idx.  The time map places
+ * index 0 at T0 + time_offset, and each value is the master sample
+ * position at that time so that the aligned values match the master.
+ */
+static int32_t send(struct jsdrv_align_s * a, uint8_t source_idx, uint32_t sample_rate, int64_t time_offset,
+                    uint64_t idx, uint32_t count) {
+    struct jsdrv_stream_signal_s * s = &signal_;
+    s->sample_id = idx;
+    s->field_id = JSDRV_FIELD_CURRENT;
+    s->index = 0;
+    s->element_type = JSDRV_DATA_TYPE_FLOAT;
+    s->element_size_bits = 32;
+    s->element_count = count;
+    s->sample_rate = sample_rate;
+    s->decimate_factor = 1;
+    s->time_map.offset_time = T0 + time_offset;
+    s->time_map.offset_counter = 0;
+    s->time_map.counter_rate = (double) sample_rate;
+    double scale = 1000000.0 / sample_rate;
+    double offset = ((double) time_offset / JSDRV_TIME_SECOND) * 1000000.0;
+    float * data = (float *) s->data;
+    for (uint32_t i = 0; i < count; ++i) {
+        data[i] = (float) ((idx + i) * scale + offset);
+    }
+    return jsdrv_align_recv(a, source_idx, s);
+}
+
+static void check_aligned(uint32_t nan_max) {
+    uint32_t nan_count = 0;
+    for (uint32_t j = 0; j < out_.count; ++j) {
+        assert_float_equal((float) j, out_.y[0][j], 0.0f);
+        if (isnan(out_.y[1][j])) {
+            ++nan_count;
+        } else {
+            assert_float_equal(out_.y[0][j], out_.y[1][j], 0.01f);
+        }
+    }
+    assert_true(nan_count <= nan_max);
+}
+
+static void test_map(void **state) {
+    (void) state;
+    struct jsdrv_align_map_s map;
+    struct jsdrv_align_s * a = setup();
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_align_map(a, &map));
+    assert_int_equal(0, send(a, 0, 1000000, 0, 0, 1000));
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_align_map(a, &map));
+    assert_int_equal(0, send(a, 1, 500000, 1024, 0, 500));
+    assert_int_equal(0, jsdrv_align_map(a, &map));
+    assert_int_equal(1, map.version);
+    assert_int_equal(2, map.source_count);
+    assert_int_equal(1000000, map.sample_rate[0]);
+    assert_int_equal(500000, map.sample_rate[1]);
+    assert_int_equal(1, map.decimate_factor[1]);
+    assert_int_equal(T0 + 1024, map.time_map[1].offset_time);
+    assert_int_equal(0, out_.count);  // frames disabled
+    jsdrv_align_free(a);
+}
+
+static void test_identity(void **state) {
+    (void) state;
+    struct jsdrv_align_s * a = setup();
+    jsdrv_align_frames_enable(a, true);
+    for (uint32_t k = 0; k < 20; ++k) {
+        assert_int_equal(0, send(a, 0, 1000000, 0, k * 1000, 1000));
+        assert_int_equal(0, send(a, 1, 1000000, 0, k * 1000, 1000));
+    }
+    assert_true(out_.count >= 19990);
+    check_aligned(0);
+    jsdrv_align_free(a);
+}
+
+static void test_offset_and_rate(void **state) {
+    (void) state;
+    struct jsdrv_align_s * a = setup();
+    jsdrv_align_frames_enable(a, true);
+    for (uint32_t k = 0; k < 20; ++k) {
+        assert_int_equal(0, send(a, 0, 1000000, 0, k * 1000, 1000));
+        assert_int_equal(0, send(a, 1, 500000, 1024, k * 500, 500));  // 2**-20 s later
+    }
+    assert_true(out_.count >= 19990);
+    check_aligned(1);  // master sample 0 precedes source 1
+    jsdrv_align_free(a);
+}
+
+static void test_source_stall(void **state) {
+    (void) state;
+    struct jsdrv_align_s * a = setup();
+    jsdrv_align_frames_enable(a, true);
+    assert_int_equal(0, send(a, 1, 1000000, 0, 0, 1000));
+    for (uint32_t k = 0; k < 200; ++k) {
+        assert_int_equal(0, send(a, 0, 1000000, 0, k * 1000, 1000));
+    }
+    assert_true(out_.count > (200000 - JSDRV_ALIGN_RING_SIZE / 2 - 1000));
+    assert_false(isnan(out_.y[1][998]));
+    assert_true(isnan(out_.y[1][out_.count - 1]));
+    check_aligned(out_.count);
+    jsdrv_align_free(a);
+}
+
+static void test_invalid(void **state) {
+    (void) state;
+    struct jsdrv_align_s * a = setup();
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, send(a, 2, 1000000, 0, 0, 1000));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_align_source_count_set(a, JSDRV_ALIGN_SOURCES_MAX + 1));
+    signal_.element_type = JSDRV_DATA_TYPE_UINT;
+    signal_.element_size_bits = 4;
+    assert_int_equal(0, jsdrv_align_recv(a, 0, &signal_));
+    jsdrv_align_frames_enable(a, true);
+    assert_int_equal(JSDRV_ERROR_NOT_SUPPORTED, jsdrv_align_recv(a, 0, &signal_));
+    jsdrv_align_free(a);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_map),
+            cmocka_unit_test(test_identity),
+            cmocka_unit_test(test_offset_and_rate),
+            cmocka_unit_test(test_source_stall),
+            cmocka_unit_test(test_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
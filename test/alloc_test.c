@@ -0,0 +1,218 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv.h"
+#include "jsdrv_prv/alloc.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv/error_code.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+struct counter_s {
+    int32_t alloc_count;
+    int32_t free_count;
+    size_t last_size;
+};
+
+static struct counter_s counter_;
+
+static void * counting_alloc(void * user_data, size_t size_bytes) {
+    struct counter_s * c = (struct counter_s *) user_data;
+    ++c->alloc_count;
+    c->last_size = size_bytes;
+    return malloc(size_bytes);
+}
+
+static void counting_free(void * user_data, void * ptr) {
+    struct counter_s * c = (struct counter_s *) user_data;
+    ++c->free_count;
+    free(ptr);
+}
+
+static const struct jsdrv_allocator_s allocator_ = {
+    .alloc = counting_alloc,
+    .free = counting_free,
+    .user_data = &counter_,
+};
+
+static int setup(void ** state) {
+    (void) state;
+    memset(&counter_, 0, sizeof(counter_));
+    return jsdrv_allocator_set(&allocator_) ? -1 : 0;
+}
+
+static int teardown(void ** state) {
+    (void) state;
+    return jsdrv_allocator_set(NULL) ? -1 : 0;
+}
+
+static void test_small_reuse(void ** state) {
+    (void) state;
+    uint8_t * p1 = jsdrv_alloc(100);
+    assert_int_equal(1, counter_.alloc_count);
+    assert_int_equal(128, counter_.last_size);
+    assert_int_equal(0, ((uintptr_t) p1) & 15);
+    p1[99] = 1;
+    jsdrv_free(p1);
+    assert_int_equal(0, counter_.free_count);  // held in the free list
+
+    uint8_t * p2 = jsdrv_alloc(112);  // same size class
+    assert_ptr_equal(p1, p2);
+    assert_int_equal(1, counter_.alloc_count);
+    uint8_t * p3 = jsdrv_alloc(113);  // next size class
+    assert_int_equal(2, counter_.alloc_count);
+    assert_int_equal(256, counter_.last_size);
+    jsdrv_free(p2);
+    jsdrv_free(p3);
+
+    struct jsdrv_alloc_stats_s stats;
+    jsdrv_alloc_stats_get(&stats);
+    assert_int_equal(2, stats.outstanding);
+    assert_int_equal(2, stats.free_count);
+}
+
+static void test_large(void ** state) {
+    (void) state;
+    void * p = jsdrv_alloc(JSDRV_ALLOC_SMALL_MAX + 1);
+    assert_int_equal(1, counter_.alloc_count);
+    assert_int_equal(JSDRV_ALLOC_SMALL_MAX + 17, counter_.last_size);
+    jsdrv_free(p);
+    assert_int_equal(1, counter_.free_count);
+}
+
+static void test_busy(void ** state) {
+    (void) state;
+    void * p = jsdrv_alloc(8);
+    assert_int_equal(JSDRV_ERROR_BUSY, jsdrv_allocator_set(NULL));
+    struct jsdrv_allocator_s invalid = {.alloc = counting_alloc, .free = NULL, .user_data = NULL};
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_allocator_set(&invalid));
+    jsdrv_free(p);
+    assert_int_equal(0, jsdrv_allocator_set(&allocator_));  // trims the free lists
+    assert_int_equal(1, counter_.free_count);
+}
+
+static void test_thread_cache(void ** state) {
+    (void) state;
+    void * p[JSDRV_ALLOC_CACHE_MAX * 2];
+    jsdrv_alloc_thread_cache_start();
+    int32_t base = counter_.alloc_count;  // the cache itself
+    for (uint32_t i = 0; i < JSDRV_ALLOC_CACHE_MAX * 2; ++i) {
+        p[i] = jsdrv_alloc(32);
+    }
+    for (uint32_t i = 0; i < JSDRV_ALLOC_CACHE_MAX * 2; ++i) {
+        jsdrv_free(p[i]);
+    }
+    struct jsdrv_alloc_stats_s stats;
+    jsdrv_alloc_stats_get(&stats);
+    assert_true(stats.free_count > 0);  // overflow returned in batches
+    assert_true(stats.free_count < JSDRV_ALLOC_CACHE_MAX * 2);
+    for (uint32_t i = 0; i < JSDRV_ALLOC_CACHE_MAX * 2; ++i) {
+        p[i] = jsdrv_alloc(32);
+    }
+    assert_int_equal(base + JSDRV_ALLOC_CACHE_MAX * 2, counter_.alloc_count);  // all reused
+    for (uint32_t i = 0; i < JSDRV_ALLOC_CACHE_MAX * 2; ++i) {
+        jsdrv_free(p[i]);
+    }
+    jsdrv_alloc_thread_cache_stop();
+    jsdrv_alloc_stats_get(&stats);
+    assert_int_equal(JSDRV_ALLOC_CACHE_MAX * 2, stats.free_count);
+    assert_int_equal(JSDRV_ALLOC_CACHE_MAX * 2, stats.outstanding);
+}
+
+static void test_category(void ** state) {
+    (void) state;
+    struct jsdrv_alloc_cat_stats_s s0;
+    struct jsdrv_alloc_cat_stats_s s1;
+    jsdrv_alloc_cat_stats_get(JSDRV_ALLOC_CAT_BUFFER, &s0);
+    void * p1 = jsdrv_alloc_cat(100, JSDRV_ALLOC_CAT_BUFFER);
+    void * p2 = jsdrv_alloc_clr_cat(JSDRV_ALLOC_SMALL_MAX + 1, JSDRV_ALLOC_CAT_BUFFER);
+    jsdrv_alloc_cat_stats_get(JSDRV_ALLOC_CAT_BUFFER, &s1);
+    assert_int_equal(s0.count + 2, s1.count);
+    assert_int_equal(s0.bytes + 128 + JSDRV_ALLOC_SMALL_MAX + 17, s1.bytes);
+    assert_true(s1.peak >= s1.bytes);
+    jsdrv_free(p1);
+    jsdrv_free(p2);
+    jsdrv_alloc_cat_stats_get(JSDRV_ALLOC_CAT_BUFFER, &s1);
+    assert_int_equal(s0.count, s1.count);
+    assert_int_equal(s0.bytes, s1.bytes);
+
+    jsdrv_alloc_cat_stats_get(JSDRV_ALLOC_CAT_OTHER, &s0);
+    p1 = jsdrv_alloc(8);
+    jsdrv_alloc_cat_stats_get(JSDRV_ALLOC_CAT_OTHER, &s1);
+    assert_int_equal(s0.count + 1, s1.count);
+    jsdrv_free(p1);
+    assert_string_equal("pubsub", jsdrv_alloc_cat_name(JSDRV_ALLOC_CAT_PUBSUB));
+    assert_null(jsdrv_alloc_cat_name(JSDRV_ALLOC_CAT_COUNT));
+    jsdrv_alloc_cat_stats_get(JSDRV_ALLOC_CAT_COUNT, &s1);
+    assert_int_equal(0, s1.count);
+}
+
+static void test_trace(void ** state) {
+    (void) state;
+    char path[] = "alloc_test_trace.json";
+    char buf[4096];
+    assert_false(jsdrv_alloc_trace_is_enabled());
+    jsdrv_alloc_trace_enable(true);
+    uint8_t * p1 = jsdrv_alloc_cat(100, JSDRV_ALLOC_CAT_LOG);
+    uint8_t * p2 = jsdrv_alloc_cat(200, JSDRV_ALLOC_CAT_XFER);
+    jsdrv_alloc_trace_enable(false);
+    assert_int_equal(0, ((uintptr_t) p1) & 15);
+    memset(p1, 0x55, 100);
+    uint8_t * p3 = jsdrv_alloc(100);  // not traced
+    assert_int_equal(3, counter_.alloc_count);
+    assert_int_equal(0, jsdrv_alloc_trace_write(path));
+    FILE * f = fopen(path, "rb");
+    assert_non_null(f);
+    size_t sz = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    remove(path);
+    buf[sz] = 0;
+    assert_non_null(strstr(buf, "\"count\":2"));
+    assert_non_null(strstr(buf, "\"category\":\"xfer\",\"size\":200"));
+    assert_true(strstr(buf, "xfer") < strstr(buf, "\"log\""));  // newest first
+
+    jsdrv_free(p2);
+    jsdrv_free(p1);
+    assert_int_equal(2, counter_.free_count);  // traced blocks are not reused
+    jsdrv_free(p3);
+    assert_int_equal(0, jsdrv_alloc_trace_write(path));
+    f = fopen(path, "rb");
+    assert_non_null(f);
+    sz = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    remove(path);
+    buf[sz] = 0;
+    assert_non_null(strstr(buf, "\"count\":0"));
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test_setup_teardown(test_small_reuse, setup, teardown),
+            cmocka_unit_test_setup_teardown(test_large, setup, teardown),
+            cmocka_unit_test_setup_teardown(test_busy, setup, teardown),
+            cmocka_unit_test_setup_teardown(test_thread_cache, setup, teardown),
+            cmocka_unit_test_setup_teardown(test_category, setup, teardown),
+            cmocka_unit_test_setup_teardown(test_trace, setup, teardown),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/api_timeout.h"
+#include "jsdrv/cstr.h"
+#include "tinyprintf.h"
+#include <string.h>
+
+
+#define COUNT (1000U)
+
+static struct jsdrvp_api_timeout_s timeouts_[COUNT];
+
+static struct jsdrvp_api_timeout_s * timeout_init(uint32_t idx, const char * topic, int64_t timeout) {
+    struct jsdrvp_api_timeout_s * t = &timeouts_[idx];
+    memset(t, 0, sizeof(*t));
+    jsdrv_cstr_copy(t->topic, topic, sizeof(t->topic));
+    t->timeout = timeout;
+    return t;
+}
+
+static void test_empty(void ** state) {
+    (void) state;
+    struct jsdrv_api_timeouts_s s;
+    jsdrv_api_timeouts_initialize(&s);
+    assert_null(jsdrv_api_timeouts_peek(&s));
+    assert_null(jsdrv_api_timeouts_find(&s, "a/b#"));
+    jsdrv_api_timeouts_finalize(&s);
+}
+
+static void test_deadline_order(void ** state) {
+    (void) state;
+    struct jsdrv_api_timeouts_s s;
+    jsdrv_api_timeouts_initialize(&s);
+    char topic[32];
+    for (uint32_t idx = 0; idx < COUNT; ++idx) {
+        tfp_snprintf(topic, sizeof(topic), "t/%u#", (unsigned int) idx);
+        jsdrv_api_timeouts_add(&s, timeout_init(idx, topic, (idx * 7919) % COUNT));
+    }
+    // remove every third by topic, from the middle of the heap
+    for (uint32_t idx = 0; idx < COUNT; idx += 3) {
+        tfp_snprintf(topic, sizeof(topic), "t/%u#", (unsigned int) idx);
+        struct jsdrvp_api_timeout_s * t = jsdrv_api_timeouts_find(&s, topic);
+        assert_ptr_equal(&timeouts_[idx], t);
+        jsdrv_api_timeouts_remove(&s, t);
+        assert_null(jsdrv_api_timeouts_find(&s, topic));
+    }
+    int64_t prev = -1;
+    uint32_t count = 0;
+    struct jsdrvp_api_timeout_s * t;
+    while (NULL != (t = jsdrv_api_timeouts_peek(&s))) {
+        assert_true(t->timeout >= prev);
+        prev = t->timeout;
+        jsdrv_api_timeouts_remove(&s, t);
+        ++count;
+    }
+    assert_int_equal(COUNT - (COUNT + 2) / 3, count);
+    jsdrv_api_timeouts_finalize(&s);
+}
+
+static void test_same_topic_fifo(void ** state) {
+    (void) state;
+    struct jsdrv_api_timeouts_s s;
+    jsdrv_api_timeouts_initialize(&s);
+    jsdrv_api_timeouts_add(&s, timeout_init(0, "u/js220/1/s/i/ctrl#", 30));
+    jsdrv_api_timeouts_add(&s, timeout_init(1, "u/js220/1/s/i/ctrl#", 10));
+    jsdrv_api_timeouts_add(&s, timeout_init(2, "u/js220/1/s/v/ctrl#", 20));
+    assert_ptr_equal(&timeouts_[1], jsdrv_api_timeouts_peek(&s));
+    struct jsdrvp_api_timeout_s * t = jsdrv_api_timeouts_find(&s, "u/js220/1/s/i/ctrl#");
+    assert_ptr_equal(&timeouts_[0], t);  // first added, not earliest deadline
+    jsdrv_api_timeouts_remove(&s, t);
+    t = jsdrv_api_timeouts_find(&s, "u/js220/1/s/i/ctrl#");
+    assert_ptr_equal(&timeouts_[1], t);
+    jsdrv_api_timeouts_remove(&s, t);
+    assert_ptr_equal(&timeouts_[2], jsdrv_api_timeouts_peek(&s));
+    jsdrv_api_timeouts_remove(&s, &timeouts_[2]);
+    assert_null(jsdrv_api_timeouts_peek(&s));
+    jsdrv_api_timeouts_finalize(&s);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_empty),
+            cmocka_unit_test(test_deadline_order),
+            cmocka_unit_test(test_same_topic_fifo),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
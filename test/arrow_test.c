@@ -0,0 +1,208 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv/arrow.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/time.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+static struct jsdrv_stream_signal_s stream_;
+static uint8_t rsp_buf_[sizeof(struct jsdrv_buffer_response_s) + 4096];
+
+static const struct jsdrv_stream_signal_s * stream_f32(uint64_t sample_id, uint32_t count) {
+    memset(&stream_, 0, JSDRV_STREAM_HEADER_SIZE);
+    stream_.sample_id = sample_id;
+    stream_.field_id = JSDRV_FIELD_CURRENT;
+    stream_.element_type = JSDRV_DATA_TYPE_FLOAT;
+    stream_.element_size_bits = 32;
+    stream_.element_count = count;
+    stream_.sample_rate = 1000000;
+    stream_.decimate_factor = 2;
+    stream_.time_map.offset_time = JSDRV_TIME_SECOND;
+    stream_.time_map.offset_counter = 0;
+    stream_.time_map.counter_rate = 1000000.0;
+    float * x = (float *) stream_.data;
+    for (uint32_t k = 0; k < count; ++k) {
+        x[k] = (float) ((sample_id / 2) + k);
+    }
+    return &stream_;
+}
+
+static const uint64_t * col_u64(const struct ArrowArray * a, uint32_t idx) {
+    return (const uint64_t *) a->children[idx]->buffers[1];
+}
+
+static const float * col_f32(const struct ArrowArray * a, uint32_t idx) {
+    return (const float *) a->children[idx]->buffers[1];
+}
+
+static void release(struct ArrowSchema * schema, struct ArrowArray * array) {
+    schema->release(schema);
+    assert_null(schema->release);
+    array->release(array);
+    assert_null(array->release);
+}
+
+static void test_alloc(void **state) {
+    (void) state;
+    assert_null(jsdrv_arrow_batcher_alloc(0));
+    assert_null(jsdrv_arrow_batcher_alloc(JSDRV_ARROW_ROWS_MAX + 1));
+    struct jsdrv_arrow_batcher_s * a = jsdrv_arrow_batcher_alloc(10);
+    struct ArrowSchema schema;
+    struct ArrowArray array;
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_arrow_batcher_pop(a, &schema, &array, true));
+    stream_f32(0, 4);
+    stream_.element_size_bits = 12;
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_arrow_batcher_add_stream(a, &stream_));
+    jsdrv_arrow_batcher_add_stream(a, stream_f32(0, 4));  // pending batch freed
+    jsdrv_arrow_batcher_free(a);
+    jsdrv_arrow_batcher_free(NULL);
+}
+
+static void test_stream_f32(void **state) {
+    (void) state;
+    struct ArrowSchema schema;
+    struct ArrowArray array;
+    struct jsdrv_arrow_batcher_s * a = jsdrv_arrow_batcher_alloc(100);
+    assert_int_equal(0, jsdrv_arrow_batcher_add_stream(a, stream_f32(1000, 60)));
+    assert_int_equal(0, jsdrv_arrow_batcher_ready(a));
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_arrow_batcher_pop(a, &schema, &array, false));
+    assert_int_equal(0, jsdrv_arrow_batcher_add_stream(a, stream_f32(1120, 60)));  // spans two batches
+    assert_int_equal(1, jsdrv_arrow_batcher_ready(a));
+
+    assert_int_equal(0, jsdrv_arrow_batcher_pop(a, &schema, &array, false));
+    assert_string_equal("+s", schema.format);
+    assert_int_equal(3, schema.n_children);
+    assert_string_equal("sample_id", schema.children[0]->name);
+    assert_string_equal("L", schema.children[0]->format);
+    assert_string_equal("tsn:UTC", schema.children[1]->format);
+    assert_string_equal("value", schema.children[2]->name);
+    assert_string_equal("f", schema.children[2]->format);
+    assert_int_equal(100, array.length);
+    assert_int_equal(1, array.n_buffers);
+    assert_int_equal(3, array.n_children);
+    assert_int_equal(100, array.children[2]->length);
+    assert_int_equal(2, array.children[2]->n_buffers);
+    assert_null(array.children[2]->buffers[0]);
+    for (uint32_t k = 0; k < 100; ++k) {
+        assert_int_equal(1000 + 2 * k, col_u64(&array, 0)[k]);
+        assert_true(((float) (500 + k)) == col_f32(&array, 2)[k]);
+    }
+    const int64_t * utc = (const int64_t *) array.children[1]->buffers[1];
+    int64_t t0 = (1 + JSDRV_TIME_EPOCH_UNIX_OFFSET_SECONDS) * 1000000000LL;
+    assert_true(llabs(utc[0] - (t0 + 1000000)) < 2);  // 1000 counts at 1 MHz
+    assert_true(llabs(utc[99] - (t0 + 1000000 + 99 * 2000)) < 2);
+
+    // move a child, release the parent, then the child
+    struct ArrowArray value = *array.children[2];
+    array.children[2]->release = NULL;
+    release(&schema, &array);
+    assert_true(500.0f == ((const float *) value.buffers[1])[0]);
+    value.release(&value);
+
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_arrow_batcher_pop(a, &schema, &array, false));
+    assert_int_equal(0, jsdrv_arrow_batcher_pop(a, &schema, &array, true));
+    assert_int_equal(20, array.length);
+    assert_int_equal(1200, col_u64(&array, 0)[0]);
+    release(&schema, &array);
+    jsdrv_arrow_batcher_free(a);
+}
+
+static void test_stream_u4_format_change(void **state) {
+    (void) state;
+    struct ArrowSchema schema;
+    struct ArrowArray array;
+    struct jsdrv_arrow_batcher_s * a = jsdrv_arrow_batcher_alloc(7);
+    assert_int_equal(0, jsdrv_arrow_batcher_add_stream(a, stream_f32(0, 3)));
+    stream_f32(6, 16);
+    stream_.element_type = JSDRV_DATA_TYPE_UINT;
+    stream_.element_size_bits = 4;
+    for (uint32_t k = 0; k < 8; ++k) {
+        stream_.data[k] = (uint8_t) (((2 * k + 1) << 4) | (2 * k));
+    }
+    assert_int_equal(0, jsdrv_arrow_batcher_add_stream(a, &stream_));
+    assert_int_equal(3, jsdrv_arrow_batcher_ready(a));  // f32, then 7 + 7 u4
+
+    assert_int_equal(0, jsdrv_arrow_batcher_pop(a, &schema, &array, false));
+    assert_int_equal(3, array.length);
+    release(&schema, &array);
+    for (uint32_t batch = 0; batch < 3; ++batch) {
+        assert_int_equal(0, jsdrv_arrow_batcher_pop(a, &schema, &array, true));
+        assert_string_equal("C", schema.children[2]->format);
+        const uint8_t * v = (const uint8_t *) array.children[2]->buffers[1];
+        for (int64_t k = 0; k < array.length; ++k) {
+            assert_int_equal((batch * 7 + k) & 0x0f, v[k]);  // odd offsets in the second batch
+        }
+        assert_int_equal((batch < 2) ? 7 : 2, array.length);
+        release(&schema, &array);
+    }
+    jsdrv_arrow_batcher_free(a);
+}
+
+static void test_buffer_summary(void **state) {
+    (void) state;
+    struct ArrowSchema schema;
+    struct ArrowArray array;
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_buf_;
+    memset(rsp_buf_, 0, sizeof(rsp_buf_));
+    rsp->version = 1;
+    rsp->response_type = JSDRV_BUFFER_RESPONSE_SUMMARY;
+    rsp->info.element_type = JSDRV_DATA_TYPE_FLOAT;
+    rsp->info.element_size_bits = 32;
+    rsp->info.time_range_samples.start = 100;
+    rsp->info.time_range_samples.end = 199;
+    rsp->info.time_range_samples.length = 10;
+    rsp->info.time_map.counter_rate = 1000.0;
+    struct jsdrv_summary_entry_s * e = (struct jsdrv_summary_entry_s *) rsp->data;
+    for (uint32_t k = 0; k < 10; ++k) {
+        e[k].avg = (float) k;
+        e[k].std = 1.0f;
+        e[k].min = (float) k - 2.0f;
+        e[k].max = (float) k + 2.0f;
+    }
+    struct jsdrv_arrow_batcher_s * a = jsdrv_arrow_batcher_alloc(1000);
+    assert_int_equal(0, jsdrv_arrow_batcher_add_buffer_rsp(a, rsp));
+    assert_int_equal(0, jsdrv_arrow_batcher_pop(a, &schema, &array, true));
+    assert_int_equal(6, schema.n_children);
+    assert_string_equal("max", schema.children[5]->name);
+    assert_int_equal(10, array.length);
+    assert_int_equal(190, col_u64(&array, 0)[9]);
+    assert_true(9.0f == col_f32(&array, 2)[9]);
+    assert_true(7.0f == col_f32(&array, 4)[9]);
+    assert_true(11.0f == col_f32(&array, 5)[9]);
+    release(&schema, &array);
+
+    rsp->response_type = JSDRV_BUFFER_RESPONSE_INTEGRAL;
+    assert_int_equal(JSDRV_ERROR_NOT_SUPPORTED, jsdrv_arrow_batcher_add_buffer_rsp(a, rsp));
+    jsdrv_arrow_batcher_free(a);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_alloc),
+            cmocka_unit_test(test_stream_f32),
+            cmocka_unit_test(test_stream_u4_format_change),
+            cmocka_unit_test(test_buffer_summary),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
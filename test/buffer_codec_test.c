@@ -0,0 +1,144 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <math.h>
+#include "jsdrv/error_code.h"
+#include "jsdrv_prv/buffer_codec.h"
+
+
+#define LENGTH (4096)
+
+
+static uint32_t lcg_next(uint32_t * state) {
+    *state = (*state * 1664525U) + 1013904223U;
+    return *state;
+}
+
+static void test_rle8_constant(void **state) {
+    (void) state;
+    uint8_t src[LENGTH];
+    uint8_t enc[LENGTH];
+    uint8_t dec[LENGTH];
+    memset(src, 0x33, sizeof(src));
+    uint32_t sz = jsdrv_codec_rle8_encode(src, sizeof(src), enc, sizeof(enc));
+    assert_int_equal(2 * (LENGTH / 256), sz);
+    assert_int_equal(0, jsdrv_codec_rle8_decode(enc, sz, dec, sizeof(dec)));
+    assert_memory_equal(src, dec, sizeof(src));
+}
+
+static void test_rle8_runs(void **state) {
+    (void) state;
+    uint8_t src[LENGTH];
+    uint8_t enc[LENGTH];
+    uint8_t dec[LENGTH];
+    for (uint32_t i = 0; i < LENGTH; ++i) {
+        src[i] = (uint8_t) (i / 300);
+    }
+    uint32_t sz = jsdrv_codec_rle8_encode(src, sizeof(src), enc, sizeof(enc));
+    assert_true(sz > 0);
+    assert_true(sz < 100);
+    assert_int_equal(0, jsdrv_codec_rle8_decode(enc, sz, dec, sizeof(dec)));
+    assert_memory_equal(src, dec, sizeof(src));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_codec_rle8_decode(enc, sz, dec, sizeof(dec) - 1));
+}
+
+static void test_rle8_incompressible(void **state) {
+    (void) state;
+    uint8_t src[LENGTH];
+    uint8_t enc[LENGTH];
+    for (uint32_t i = 0; i < LENGTH; ++i) {
+        src[i] = (uint8_t) i;
+    }
+    assert_int_equal(0, jsdrv_codec_rle8_encode(src, sizeof(src), enc, sizeof(enc)));
+}
+
+static void check_xor_f32(const float * src, uint32_t count, uint32_t size_max) {
+    uint8_t enc[LENGTH * sizeof(float)];
+    float dec[LENGTH];
+    uint32_t sz = jsdrv_codec_xor_f32_encode(src, count, enc, sizeof(enc));
+    assert_true(sz > 0);
+    assert_true(sz <= size_max);
+    assert_int_equal(0, jsdrv_codec_xor_f32_decode(enc, sz, dec, count));
+    assert_memory_equal(src, dec, count * sizeof(float));  // bit exact, including NaN
+}
+
+static void test_xor_f32_constant(void **state) {
+    (void) state;
+    float src[LENGTH];
+    for (uint32_t i = 0; i < LENGTH; ++i) {
+        src[i] = 0.001f;
+    }
+    check_xor_f32(src, LENGTH, 4 + LENGTH / 8 + 1);
+}
+
+static void test_xor_f32_quantized(void **state) {
+    (void) state;
+    float src[LENGTH];
+    uint32_t lcg = 1;
+    for (uint32_t i = 0; i < LENGTH; ++i) {
+        src[i] = 0.5f + (float) (lcg_next(&lcg) >> 28) / 1024.0f;  // few mantissa bits
+    }
+    src[100] = NAN;
+    src[101] = INFINITY;
+    src[102] = -0.0f;
+    check_xor_f32(src, LENGTH, LENGTH * 2);
+}
+
+static void test_xor_f32_noise(void **state) {
+    (void) state;
+    float src[LENGTH];
+    uint8_t enc[LENGTH * sizeof(float)];
+    uint32_t lcg = 7;
+    for (uint32_t i = 0; i < LENGTH; ++i) {
+        uint32_t u = lcg_next(&lcg);
+        memcpy(&src[i], &u, sizeof(u));
+    }
+    // more than raw size, caller stores raw
+    assert_int_equal(0, jsdrv_codec_xor_f32_encode(src, LENGTH, enc, sizeof(enc)));
+    check_xor_f32(src, 1, 4);
+}
+
+static void test_xor_f32_corrupt(void **state) {
+    (void) state;
+    float src[64];
+    float dec[64];
+    uint8_t enc[sizeof(src)];
+    for (uint32_t i = 0; i < 64; ++i) {
+        src[i] = (float) i;
+    }
+    uint32_t sz = jsdrv_codec_xor_f32_encode(src, 64, enc, sizeof(enc));
+    assert_true(sz > 0);
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_codec_xor_f32_decode(enc, sz / 2, dec, 64));
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_rle8_constant),
+            cmocka_unit_test(test_rle8_runs),
+            cmocka_unit_test(test_rle8_incompressible),
+            cmocka_unit_test(test_xor_f32_constant),
+            cmocka_unit_test(test_xor_f32_quantized),
+            cmocka_unit_test(test_xor_f32_noise),
+            cmocka_unit_test(test_xor_f32_corrupt),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -23,13 +23,16 @@
 #include <stdlib.h>
 #include <math.h>
 #include "jsdrv_prv/buffer_signal.h"
+#include "jsdrv_prv/pack.h"
+#include "jsdrv_prv/platform.h"
 #include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
 #include "tinyprintf.h"
 
 const char SRC_TOPIC[] = "src/topic/!data";
 
 
-#define initialize()                                        \
+#define initialize_hdr()                                    \
     (void) state;                                           \
     struct bufsig_s b;                                      \
     memset(&b, 0, sizeof(b));                               \
@@ -44,6 +47,10 @@ const char SRC_TOPIC[] = "src/topic/!data";
     b.hdr.sample_rate = 1000000;                            \
     b.time_map.counter_rate = (double) b.hdr.sample_rate;   \
     b.active = true;                                        \
+    b.numa_node = -1
+
+#define initialize()                                        \
+    initialize_hdr();                                       \
     jsdrv_bufsig_alloc(&b, 1000000, 10, 10)
 
 
@@ -76,17 +83,21 @@ static void insert_samples(struct bufsig_s * b, uint64_t sample_id_start, uint32
     s.index = 7;
     s.element_type = JSDRV_DATA_TYPE_FLOAT;
     s.element_size_bits = 32;
-    s.element_count = length;
     s.sample_rate = 1000000;
     s.decimate_factor = 1;
     s.time_map.offset_time = JSDRV_TIME_HOUR;
     s.time_map.counter_rate = s.sample_rate;
     s.time_map.offset_counter = 0;
     float * f32 = (float *) s.data;
-    for (uint32_t i = 0; i < s.element_count; ++i) {
-        f32[i] = (s.sample_id + i) / 1000000.0f;
+    while (length) {  // split into messages that fit JSDRV_STREAM_DATA_SIZE
+        s.element_count = (length > (sizeof(s.data) / sizeof(float))) ? (sizeof(s.data) / sizeof(float)) : length;
+        for (uint32_t i = 0; i < s.element_count; ++i) {
+            f32[i] = (s.sample_id + i) / 1000000.0f;
+        }
+        jsdrv_bufsig_recv_data(b, &s);
+        s.sample_id += s.element_count;
+        length -= s.element_count;
     }
-    jsdrv_bufsig_recv_data(b, &s);
 }
 
 static void check_samples(struct jsdrv_buffer_response_s * rsp, uint64_t sample_id_start, uint64_t length) {
@@ -214,6 +225,177 @@ static void test_samples_wrap(void **state) {
     jsdrv_bufsig_free(&b);
 }
 
+static void test_samples_file_backed(void **state) {
+    initialize_hdr();
+    b.storage_dir = ".";
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    assert_int_equal(BUFSIG_STORAGE_FILE, b.level0_storage);
+    assert_int_equal(1000000 * sizeof(float), b.level0_mapped_size);
+    uint32_t length = 873;
+    for (uint64_t sample_id = 0; sample_id < 1100000; sample_id += length) {
+        insert_samples(&b, sample_id, 873);
+    }
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = 999990;
+    req.time.samples.length = 1000;
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    jsdrv_bufsig_process_request(&b, &req, rsp);
+    check_samples(rsp, 999990, 1000);
+
+    jsdrv_bufsig_free(&b);
+    assert_int_equal(0, b.level0_mapped_size);
+    assert_null(b.level0_data);
+}
+
+static void test_samples_os_mem(void **state) {
+    initialize_hdr();
+    b.mem_flags = JSDRV_OS_MEM_FLAG_HUGE | JSDRV_OS_MEM_FLAG_PREFAULT;
+    b.numa_node = 0;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    assert_int_equal(BUFSIG_STORAGE_MEM, b.level0_storage);
+    uint32_t length = 873;
+    for (uint64_t sample_id = 0; sample_id < 1100000; sample_id += length) {
+        insert_samples(&b, sample_id, 873);
+    }
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = 999990;
+    req.time.samples.length = 1000;
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    jsdrv_bufsig_process_request(&b, &req, rsp);
+    check_samples(rsp, 999990, 1000);
+
+    jsdrv_bufsig_free(&b);
+    assert_int_equal(BUFSIG_STORAGE_HEAP, b.level0_storage);
+    assert_null(b.level0_data);
+}
+
+#define CODEC_N (64 * JSDRV_BUFSIG_BLOCK_SAMPLES)
+
+static void check_values(struct jsdrv_buffer_response_s * rsp, uint64_t sample_id_start, uint64_t length) {
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_SAMPLES, rsp->response_type);
+    assert_int_equal(sample_id_start, rsp->info.time_range_samples.start);
+    assert_int_equal(length, rsp->info.time_range_samples.length);
+    float * data = (float *) rsp->data;
+    for (uint32_t i = 0; i < length; ++i) {
+        assert_float_equal((sample_id_start + i) / 1000000.0f, data[i], 1e-12);
+    }
+}
+
+static void samples_req(struct bufsig_s * b, uint64_t start, uint64_t length, struct jsdrv_buffer_response_s * rsp) {
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = start;
+    req.time.samples.length = length;
+    assert_int_equal(0, jsdrv_bufsig_process_request(b, &req, rsp));
+}
+
+static void test_codec_samples(void **state) {
+    initialize_hdr();
+    b.codec = 1;
+    jsdrv_bufsig_alloc(&b, CODEC_N, 128, 32);
+    assert_non_null(b.blocks);
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    uint64_t sample_id_end = 300000;
+    for (uint64_t sample_id = 0; sample_id < sample_id_end; sample_id += 873) {
+        insert_samples(&b, sample_id, 873);
+    }
+    sample_id_end = b.sample_id_head;
+    struct jsdrv_buffer_info_s info;
+    jsdrv_bufsig_info(&b, &info);
+    assert_int_equal(CODEC_N, info.size_in_samples);
+    assert_int_equal(sample_id_end - 1, info.time_range_samples.end);
+    assert_true(info.time_range_samples.length > (CODEC_N - JSDRV_BUFSIG_BLOCK_SAMPLES));
+    assert_true(b.blocks_size < (CODEC_N * sizeof(float)));
+
+    samples_req(&b, sample_id_end - 1000, 1000, rsp);                // open block
+    check_values(rsp, sample_id_end - 1000, 1000);
+    samples_req(&b, 200000 - 500, 1000, rsp);                        // spans blocks
+    check_values(rsp, 200000 - 500, 1000);
+    samples_req(&b, info.time_range_samples.start, 1000, rsp);       // oldest block
+    check_values(rsp, info.time_range_samples.start, 1000);
+
+    jsdrv_bufsig_free(&b);
+    assert_null(b.blocks);
+    assert_null(b.level0_data);
+}
+
+static void test_codec_budget(void **state) {
+    initialize_hdr();
+    b.codec = 1;
+    b.level0_budget = 8 * JSDRV_BUFSIG_BLOCK_SAMPLES * sizeof(float);
+    jsdrv_bufsig_alloc(&b, CODEC_N, 128, 32);
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    for (uint64_t sample_id = 0; sample_id < 300000; sample_id += 873) {
+        insert_samples(&b, sample_id, 873);
+    }
+    struct jsdrv_buffer_info_s info;
+    jsdrv_bufsig_info(&b, &info);
+    assert_true(b.blocks_size <= b.level0_budget);
+    assert_true(info.time_range_samples.length >= (8 * JSDRV_BUFSIG_BLOCK_SAMPLES));
+    assert_true(info.time_range_samples.length < CODEC_N);
+    samples_req(&b, info.time_range_samples.start, 1000, rsp);
+    check_values(rsp, info.time_range_samples.start, 1000);
+
+    // constant data compresses to the full N
+    jsdrv_bufsig_clear(&b);
+    for (uint64_t sample_id = 0; sample_id < 300000; sample_id += 873) {
+        insert_const_samples(&b, sample_id, 873, 0.25f);
+    }
+    jsdrv_bufsig_info(&b, &info);
+    assert_true(info.time_range_samples.length > (CODEC_N - JSDRV_BUFSIG_BLOCK_SAMPLES));
+
+    jsdrv_bufsig_free(&b);
+}
+
+static void test_codec_summary(void **state) {
+    initialize_hdr();
+    struct bufsig_s z = b;
+    z.codec = 1;
+    jsdrv_bufsig_alloc(&b, CODEC_N, 128, 32);
+    jsdrv_bufsig_alloc(&z, CODEC_N, 128, 32);
+    for (uint64_t sample_id = 0; sample_id < 300000; sample_id += 873) {
+        insert_samples(&b, sample_id, 873);
+        insert_samples(&z, sample_id, 873);
+    }
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = 100000;
+    req.time.samples.end = 100000 + 100 * 50 - 1;  // within level 0
+    req.time.samples.length = 100;
+    uint64_t rsp1_u64[1 << 12];
+    uint64_t rsp2_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp1 = (struct jsdrv_buffer_response_s *) rsp1_u64;
+    struct jsdrv_buffer_response_s * rsp2 = (struct jsdrv_buffer_response_s *) rsp2_u64;
+    struct jsdrv_buffer_request_s req2 = req;
+    jsdrv_bufsig_process_request(&b, &req, rsp1);
+    jsdrv_bufsig_process_request(&z, &req2, rsp2);
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_SUMMARY, rsp2->response_type);
+    assert_int_equal(rsp1->info.time_range_samples.length, rsp2->info.time_range_samples.length);
+    struct jsdrv_summary_entry_s * e1 = (struct jsdrv_summary_entry_s *) rsp1->data;
+    struct jsdrv_summary_entry_s * e2 = (struct jsdrv_summary_entry_s *) rsp2->data;
+    for (uint32_t i = 0; i < rsp1->info.time_range_samples.length; ++i) {
+        assert_float_equal(e1[i].avg, e2[i].avg, 1e-9);
+        assert_float_equal(e1[i].min, e2[i].min, 0);
+        assert_float_equal(e1[i].max, e2[i].max, 0);
+    }
+    jsdrv_bufsig_free(&b);
+    jsdrv_bufsig_free(&z);
+}
+
 static void test_summary_simple(void **state) {
     initialize();
     insert_samples(&b, 1000, 1000);
@@ -315,6 +497,1296 @@ static void test_summary_wrap(void **state) {
     jsdrv_bufsig_free(&b);
 }
 
+static void test_summary_carry(void **state) {
+    initialize();
+    for (uint64_t sample_id = 0; sample_id < 12000; sample_id += 1000) {
+        insert_samples(&b, sample_id, 1000);
+    }
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    struct jsdrv_summary_entry_s * entries = (struct jsdrv_summary_entry_s *) rsp->data;
+
+    // entries start on the level entry carried from the previous entry
+    req.time.samples.start = 1000;
+    req.time.samples.end = 1000 + 10 * 1000 - 1;
+    req.time.samples.length = 10;
+    jsdrv_bufsig_process_request(&b, &req, rsp);
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_SUMMARY, rsp->response_type);
+    for (uint32_t i = 0; i < 10; ++i) {
+        assert_float_equal((1499.5 + 1000 * i) / 1000000.0, entries[i].avg, 1e-8);
+    }
+
+    // entries start within the carried level entry, which is shared approximately
+    req.time.samples.start = 37;
+    req.time.samples.end = 37 + 10 * 370 - 1;
+    req.time.samples.length = 10;
+    jsdrv_bufsig_process_request(&b, &req, rsp);
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_SUMMARY, rsp->response_type);
+    for (uint32_t i = 0; i < 10; ++i) {
+        assert_float_equal((221.5 + 370 * i) / 1000000.0, entries[i].avg, 1e-5);
+    }
+    jsdrv_bufsig_free(&b);
+}
+
+
+static void test_snapshot_overwritten(void **state) {
+    initialize();
+    uint32_t length = 1000;
+    for (uint64_t sample_id = 0; sample_id < 500000; sample_id += length) {
+        insert_samples(&b, sample_id, length);
+    }
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = 10000;
+    req.time.samples.length = 1000;
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    struct bufsig_s snapshot = b;
+    jsdrv_bufsig_process_request(&snapshot, &req, rsp);
+    check_samples(rsp, 10000, 1000);
+    assert_false(jsdrv_bufsig_snapshot_overwritten(&snapshot, &b, rsp));
+
+    // fill and wrap up to the requested range
+    for (uint64_t sample_id = 500000; sample_id < 1010000; sample_id += length) {
+        insert_samples(&b, sample_id, length);
+    }
+    assert_false(jsdrv_bufsig_snapshot_overwritten(&snapshot, &b, rsp));
+    insert_samples(&b, 1010000, length);
+    assert_true(jsdrv_bufsig_snapshot_overwritten(&snapshot, &b, rsp));
+
+    snapshot = b;
+    jsdrv_bufsig_process_request(&snapshot, &req, rsp);
+    assert_false(jsdrv_bufsig_snapshot_overwritten(&snapshot, &b, rsp));
+    jsdrv_bufsig_clear(&b);
+    assert_true(jsdrv_bufsig_snapshot_overwritten(&snapshot, &b, rsp));
+
+    jsdrv_bufsig_free(&b);
+}
+
+static void test_freeze(void **state) {
+    initialize();
+    struct bufsig_s f;
+    struct jsdrv_buffer_info_s info;
+    memset(&f, 0, sizeof(f));
+    insert_samples(&b, 1000, 1000);
+    void * level0 = b.level0_data;
+    jsdrv_bufsig_freeze(&b, &f);
+    assert_ptr_equal(level0, f.level0_data);
+    assert_non_null(b.level0_data);
+    assert_ptr_not_equal(level0, b.level0_data);
+
+    insert_samples(&b, 2000, 500);  // live continues at the next sample
+    jsdrv_bufsig_info(&b, &info);
+    assert_int_equal(2000, info.time_range_samples.start);
+    assert_int_equal(500, info.time_range_samples.length);
+
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = 1000;
+    req.time.samples.length = 1000;
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    assert_int_equal(0, jsdrv_bufsig_process_request(&f, &req, rsp));
+    check_samples(rsp, 1000, 1000);
+
+    // ping-pong reuses the frozen storage
+    void * spare = b.level0_data;
+    jsdrv_bufsig_freeze(&b, &f);
+    assert_ptr_equal(level0, b.level0_data);
+    assert_ptr_equal(spare, f.level0_data);
+    jsdrv_bufsig_info(&f, &info);
+    assert_int_equal(2000, info.time_range_samples.start);
+    assert_int_equal(500, info.time_range_samples.length);
+    jsdrv_bufsig_info(&b, &info);
+    assert_int_equal(0, info.time_range_samples.length);
+
+    jsdrv_bufsig_free(&f);
+    jsdrv_bufsig_free(&b);
+}
+
+static void u4_signal_init(struct jsdrv_stream_signal_s * s, uint64_t sample_id, uint32_t length) {
+    memset(s, 0, sizeof(*s));
+    s->sample_id = sample_id;
+    s->field_id = JSDRV_FIELD_RANGE;
+    s->element_type = JSDRV_DATA_TYPE_UINT;
+    s->element_size_bits = 4;
+    s->element_count = length;
+    s->sample_rate = 1000000;
+    s->decimate_factor = 1;
+    s->time_map.offset_time = JSDRV_TIME_HOUR;
+    s->time_map.counter_rate = s->sample_rate;
+}
+
+static void test_recv_events(void **state) {
+    initialize_hdr();
+    b.hdr.field_id = JSDRV_FIELD_RANGE;
+    b.hdr.element_type = JSDRV_DATA_TYPE_UINT;
+    b.hdr.element_size_bits = 4;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    static struct jsdrv_stream_signal_s s;
+    uint8_t expect[1101];
+
+    u4_signal_init(&s, 1000, 101);  // odd, so the events start mid-byte
+    memset(expect, 1, 101);
+    jsdrv_pack_u4(s.data, expect, 101);
+    jsdrv_bufsig_recv_data(&b, &s);
+
+    u4_signal_init(&s, 1101, 1000);
+    struct jsdrv_stream_event_s * e = (struct jsdrv_stream_event_s *) s.data;
+    e[0].offset = 0;   e[0].value = 2;
+    e[1].offset = 333; e[1].value = 5;
+    e[2].offset = 334; e[2].value = 0;
+    e[3].offset = 901; e[3].value = 7;
+    jsdrv_bufsig_recv_events(&b, &s, 4);
+    memset(expect + 101, 2, 333);
+    expect[101 + 333] = 5;
+    memset(expect + 101 + 334, 0, 901 - 334);
+    memset(expect + 101 + 901, 7, 1000 - 901);
+
+    struct jsdrv_buffer_info_s info;
+    jsdrv_bufsig_info(&b, &info);
+    assert_int_equal(1000, info.time_range_samples.start);
+    assert_int_equal(1101, info.time_range_samples.length);
+
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = 1000;
+    req.time.samples.length = 1101;
+    uint64_t rsp_u64[1 << 12];
+    uint8_t actual[1101];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    assert_int_equal(0, jsdrv_bufsig_process_request(&b, &req, rsp));
+    assert_int_equal(1101, rsp->info.time_range_samples.length);
+    jsdrv_unpack_u4(actual, (const uint8_t *) rsp->data, 1101);
+    assert_memory_equal(expect, actual, sizeof(expect));
+    jsdrv_bufsig_free(&b);
+}
+
+static void test_stream_samples(void **state) {
+    initialize();
+    uint32_t length = 1000;
+    for (uint64_t sample_id = 0; sample_id < 500000; sample_id += length) {
+        insert_samples(&b, sample_id, length);
+    }
+    struct jsdrv_buffer_request_s req;
+    struct jsdrv_buffer_request_s chunk;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.flags = JSDRV_BUFFER_REQUEST_FLAG_STREAM;
+    req.time.samples.start = 1000;
+    req.time.samples.length = 100000;
+    uint64_t count = jsdrv_bufsig_stream_plan(&b, &req);
+    assert_true(count > 1);
+    assert_int_equal(1000 + 100000 - 1, req.time.samples.end);
+
+    uint64_t rsp_u64[1 << 14];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    uint64_t sample_id = 1000;
+    for (uint64_t seq = 0; seq < count; ++seq) {
+        jsdrv_bufsig_stream_chunk(&b, &req, seq, &chunk);
+        assert_int_equal(0, jsdrv_bufsig_process_request(&b, &chunk, rsp));
+        assert_int_equal(sample_id, rsp->info.time_range_samples.start);
+        check_samples(rsp, sample_id, rsp->info.time_range_samples.length);
+        sample_id += rsp->info.time_range_samples.length;
+    }
+    assert_int_equal(1000 + 100000, sample_id);
+
+    jsdrv_bufsig_free(&b);
+}
+
+static void test_stream_summary(void **state) {
+    initialize();
+    uint32_t length = 1000;
+    for (uint64_t sample_id = 0; sample_id < 500000; sample_id += length) {
+        insert_samples(&b, sample_id, length);
+    }
+    struct jsdrv_buffer_request_s req;
+    struct jsdrv_buffer_request_s chunk;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.flags = JSDRV_BUFFER_REQUEST_FLAG_STREAM;
+    req.time.samples.start = 0;
+    req.time.samples.end = 499999;
+    req.time.samples.length = 10000;
+    uint64_t count = jsdrv_bufsig_stream_plan(&b, &req);
+    assert_true(count > 1);
+
+    uint64_t rsp_u64[1 << 14];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    uint64_t entries = 0;
+    for (uint64_t seq = 0; seq < count; ++seq) {
+        jsdrv_bufsig_stream_chunk(&b, &req, seq, &chunk);
+        assert_int_equal(0, jsdrv_bufsig_process_request(&b, &chunk, rsp));
+        assert_int_equal(JSDRV_BUFFER_RESPONSE_SUMMARY, rsp->response_type);
+        assert_int_equal(entries * 50, rsp->info.time_range_samples.start);
+        struct jsdrv_summary_entry_s * e = (struct jsdrv_summary_entry_s *) rsp->data;
+        for (uint64_t k = 0; k < rsp->info.time_range_samples.length; ++k) {
+            float avg = ((entries + k) * 50 + 24.5f) / 1000000.0f;
+            assert_float_equal(avg, e[k].avg, 50 / 1000000.0f);  // within one entry
+        }
+        entries += rsp->info.time_range_samples.length;
+    }
+    assert_int_equal(10000, entries);
+
+    req.time.samples.end = 10;
+    req.time.samples.start = 20;
+    assert_int_equal(0, jsdrv_bufsig_stream_plan(&b, &req));
+    jsdrv_bufsig_free(&b);
+}
+
+static void test_standing_summary(void **state) {
+    initialize();
+    insert_samples(&b, 0, 10000);
+    struct jsdrv_buffer_request_s req;
+    struct jsdrv_buffer_request_s chunk;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.flags = JSDRV_BUFFER_REQUEST_FLAG_STANDING;
+    req.time.samples.start = 0;
+    req.time.samples.end = 9999;
+    req.time.samples.length = 100;
+    assert_int_equal(100, jsdrv_bufsig_standing_plan(&b, &req));
+
+    uint64_t rsp_u64[1 << 14];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    uint64_t next = UINT64_MAX;
+    assert_true(jsdrv_bufsig_standing_chunk(&b, &req, &next, &chunk));  // the initial viewport
+    assert_int_equal(0, chunk.flags & JSDRV_BUFFER_REQUEST_FLAG_STANDING);
+    assert_int_equal(0, chunk.time.samples.start);
+    assert_int_equal(100, chunk.time.samples.length);
+    assert_int_equal(100, next);
+    assert_false(jsdrv_bufsig_standing_chunk(&b, &req, &next, &chunk));
+
+    insert_samples(&b, 10000, 250);  // completes 2 entries past the viewport end
+    assert_true(jsdrv_bufsig_standing_chunk(&b, &req, &next, &chunk));
+    assert_int_equal(10000, chunk.time.samples.start);
+    assert_int_equal(10199, chunk.time.samples.end);
+    assert_int_equal(2, chunk.time.samples.length);
+    assert_int_equal(0, jsdrv_bufsig_process_request(&b, &chunk, rsp));
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_SUMMARY, rsp->response_type);
+    assert_int_equal(2, rsp->info.time_range_samples.length);
+    struct jsdrv_summary_entry_s * e = (struct jsdrv_summary_entry_s *) rsp->data;
+    assert_float_equal((10100 + 49.5f) / 1000000.0f, e[1].avg, 1e-6f);
+    assert_false(jsdrv_bufsig_standing_chunk(&b, &req, &next, &chunk));
+
+    insert_samples(&b, 10250, 10000);  // more than a viewport behind
+    insert_samples(&b, 20250, 10000);
+    assert_true(jsdrv_bufsig_standing_chunk(&b, &req, &next, &chunk));
+    assert_int_equal(20200, chunk.time.samples.start);
+    assert_int_equal(100, chunk.time.samples.length);
+    assert_int_equal(302, next);
+
+    req.flags |= JSDRV_BUFFER_REQUEST_FLAG_INTEGRAL;
+    assert_int_equal(0, jsdrv_bufsig_standing_plan(&b, &req));
+    req.flags = JSDRV_BUFFER_REQUEST_FLAG_STANDING;
+    req.time.samples.length = 6000;  // samples, not a summary
+    assert_int_equal(0, jsdrv_bufsig_standing_plan(&b, &req));
+    jsdrv_bufsig_free(&b);
+}
+
+static void test_display_summary(void **state) {
+    initialize();
+    insert_samples(&b, 0, 10050);
+    struct jsdrv_buffer_request_s req;
+    struct jsdrv_buffer_request_s chunk;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.flags = JSDRV_BUFFER_REQUEST_FLAG_DISPLAY;
+    req.time.samples.start = 0;
+    req.time.samples.end = 999;   // the span
+    req.time.samples.length = 10;  // the pixels
+    assert_int_equal(100, jsdrv_bufsig_standing_plan(&b, &req));
+
+    uint64_t next = UINT64_MAX;
+    assert_true(jsdrv_bufsig_display_chunk(&b, &req, &next, &chunk));
+    assert_int_equal(0, chunk.flags & JSDRV_BUFFER_REQUEST_FLAG_DISPLAY);
+    assert_int_equal(9000, chunk.time.samples.start);
+    assert_int_equal(9999, chunk.time.samples.end);
+    assert_int_equal(10, chunk.time.samples.length);
+    assert_false(jsdrv_bufsig_display_chunk(&b, &req, &next, &chunk));  // no new entries
+
+    insert_samples(&b, 10050, 100);  // completes one entry
+    assert_true(jsdrv_bufsig_display_chunk(&b, &req, &next, &chunk));
+    assert_int_equal(9100, chunk.time.samples.start);  // the full viewport, aligned to start
+    assert_int_equal(10, chunk.time.samples.length);
+
+    uint64_t rsp_u64[1 << 14];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    assert_int_equal(0, jsdrv_bufsig_process_request(&b, &chunk, rsp));
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_SUMMARY, rsp->response_type);
+    assert_int_equal(10, rsp->info.time_range_samples.length);
+    struct jsdrv_summary_entry_s * e = (struct jsdrv_summary_entry_s *) rsp->data;
+    for (uint32_t k = 0; k < 10; ++k) {  // each entry is one aligned summary level entry
+        assert_float_equal((9100 + 100 * k + 49.5f) / 1000000.0f, e[k].avg, 1e-6f);
+    }
+
+    req.time.samples.end = 999999;
+    req.time.samples.length = 100000;  // more than one response
+    assert_int_equal(0, jsdrv_bufsig_standing_plan(&b, &req));
+    jsdrv_bufsig_free(&b);
+}
+
+static void integral_req(struct bufsig_s * b, uint64_t start, uint64_t end, struct jsdrv_buffer_response_s * rsp) {
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.flags = JSDRV_BUFFER_REQUEST_FLAG_INTEGRAL;
+    req.time.samples.start = start;
+    req.time.samples.end = end;
+    assert_int_equal(0, jsdrv_bufsig_process_request(b, &req, rsp));
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_INTEGRAL, rsp->response_type);
+}
+
+static void test_integral(void **state) {
+    initialize_hdr();
+    b.integral = 1;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    assert_non_null(b.integral_index);
+    uint32_t length = 873;
+    for (uint64_t sample_id = 0; sample_id < 1100000; sample_id += length) {
+        insert_samples(&b, sample_id, length);
+    }
+    insert_samples(&b, b.sample_id_head + 100, length);  // 100 NaN samples
+    uint64_t rsp_u64[64];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    struct jsdrv_buffer_integral_s * y = (struct jsdrv_buffer_integral_s *) rsp->data;
+    uint64_t ranges[][2] = {
+        {200000, 200005}, {200003, 200027}, {200000, 999999}, {999990, 1100500}, {150000, 0xffffffffLLU},
+    };
+    for (uint32_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); ++i) {
+        integral_req(&b, ranges[i][0], ranges[i][1], rsp);
+        struct jsdrv_buffer_integral_s indexed = *y;
+        struct bufsig_integral_s * index = b.integral_index;
+        b.integral_index = NULL;  // sum every sample from level 0
+        integral_req(&b, ranges[i][0], ranges[i][1], rsp);
+        b.integral_index = index;
+        assert_memory_equal(indexed.sum_i128, y->sum_i128, sizeof(y->sum_i128));
+        assert_int_equal(indexed.sample_count, y->sample_count);
+        assert_int_equal(1, rsp->info.time_range_samples.length);
+    }
+
+    integral_req(&b, 200000, 999999, rsp);
+    assert_int_equal(800000, y->sample_count);
+    double expect = (200000.0 + 999999.0) / 2.0 * 800000 / 1e6 / 1e6;  // mean * samples / fs
+    assert_float_equal(expect, y->integral, 1e-9);
+
+    integral_req(&b, 0, 2000000, rsp);  // clipped to the buffer
+    assert_int_equal(b.sample_id_head - 1000000, rsp->info.time_range_samples.start);
+    assert_int_equal(b.sample_id_head - 1, rsp->info.time_range_samples.end);
+    assert_int_equal(1000000 - 100, y->sample_count);
+    jsdrv_bufsig_free(&b);
+}
+
+static void test_multi_clip(void **state) {
+    initialize_hdr();
+    struct bufsig_s z = b;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    jsdrv_bufsig_alloc(&z, 1000000, 10, 10);
+    insert_samples(&b, 0, 1000);
+    insert_samples(&z, 0, 800);  // lags by 200 samples
+    struct bufsig_s * signals[] = {&b, NULL, &z};
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = 100;
+    req.time.samples.end = 999;
+    jsdrv_bufsig_multi_clip(signals, 3, &req);
+    assert_int_equal(100, req.time.samples.start);
+    assert_int_equal(799, req.time.samples.end);
+
+    req.time.samples.end = 999;
+    req.time.samples.length = 90;  // summary, increment 10
+    jsdrv_bufsig_multi_clip(signals, 3, &req);
+    assert_int_equal(70, req.time.samples.length);
+    assert_int_equal(799, req.time.samples.end);
+
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    struct jsdrv_buffer_request_s req2 = req;
+    assert_int_equal(0, jsdrv_bufsig_process_request_sz(&b, &req2, rsp, sizeof(rsp_u64) / 2));
+    assert_int_equal(70, rsp->info.time_range_samples.length);
+    assert_int_equal(sizeof(*rsp) + 70 * sizeof(struct jsdrv_summary_entry_s), jsdrv_bufsig_response_size(rsp));
+
+    req.time.samples.length = 0;
+    req.time.samples.end = 99;  // within every signal
+    jsdrv_bufsig_multi_clip(signals, 3, &req);
+    assert_int_equal(99, req.time.samples.end);
+    jsdrv_bufsig_free(&b);
+    jsdrv_bufsig_free(&z);
+}
+
+static void summary_req(struct bufsig_s * b, uint64_t start, uint64_t incr, uint64_t length,
+                        struct jsdrv_buffer_response_s * rsp) {
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = start;
+    req.time.samples.end = start + incr * length - 1;
+    req.time.samples.length = length;
+    assert_int_equal(0, jsdrv_bufsig_process_request(b, &req, rsp));
+    assert_int_equal(length, rsp->info.time_range_samples.length);
+}
+
+static void test_tile_cache(void **state) {
+    initialize_hdr();
+    struct bufsig_s z = b;
+    z.tile_count = 4;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    jsdrv_bufsig_alloc(&z, 1000000, 10, 10);
+    assert_non_null(z.tiles);
+    for (uint64_t sample_id = 0; sample_id < 300000; sample_id += 873) {
+        insert_samples(&b, sample_id, 873);
+        insert_samples(&z, sample_id, 873);
+    }
+    uint64_t rsp1_u64[1 << 12];
+    uint64_t rsp2_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp1 = (struct jsdrv_buffer_response_s *) rsp1_u64;
+    struct jsdrv_buffer_response_s * rsp2 = (struct jsdrv_buffer_response_s *) rsp2_u64;
+    struct jsdrv_summary_entry_s * e1 = (struct jsdrv_summary_entry_s *) rsp1->data;
+    struct jsdrv_summary_entry_s * e2 = (struct jsdrv_summary_entry_s *) rsp2->data;
+
+    // one aligned tile matches the uncached request exactly
+    summary_req(&b, 64005, 1000, JSDRV_BUFSIG_TILE_ENTRIES, rsp1);
+    for (uint32_t i = 0; i < JSDRV_BUFSIG_TILE_ENTRIES; ++i) {  // unaligned start
+        assert_float_equal((64005 + i * 1000 + 499.5) / 1e6, e1[i].avg, 1e-5);
+    }
+    summary_req(&z, 64005, 1000, JSDRV_BUFSIG_TILE_ENTRIES, rsp2);
+    assert_memory_equal(e1, e2, JSDRV_BUFSIG_TILE_ENTRIES * sizeof(*e1));
+    assert_int_equal(1, z.tile_clock);
+    summary_req(&z, 64005, 1000, JSDRV_BUFSIG_TILE_ENTRIES, rsp2);
+    assert_int_equal(2, z.tile_clock);  // hit
+    assert_memory_equal(e1, e2, JSDRV_BUFSIG_TILE_ENTRIES * sizeof(*e1));
+
+    // pan by 10 entries spans 3 tiles, with the finished tile from the cache
+    summary_req(&b, 74005, 1000, 100, rsp1);
+    summary_req(&z, 74005, 1000, 100, rsp2);
+    assert_int_equal(4, z.tile_clock);
+    for (uint32_t i = 0; i < 100; ++i) {
+        assert_float_equal(e1[i].avg, e2[i].avg, 1e-5);
+    }
+
+    // a tile beyond the newest sample is not cached
+    summary_req(&z, 256005, 1000, 50, rsp2);
+    assert_int_equal(4, z.tile_clock);
+
+    // overwrite the cached range
+    for (uint64_t sample_id = 300000 - (300000 % 873) + 873; sample_id < 1100000; sample_id += 873) {
+        insert_samples(&z, sample_id, 873);
+    }
+    summary_req(&z, 64005, 1000, JSDRV_BUFSIG_TILE_ENTRIES, rsp2);
+    assert_int_equal(4, z.tile_clock);
+    assert_true(isnan(e2[0].avg));
+    jsdrv_bufsig_free(&b);
+    jsdrv_bufsig_free(&z);
+}
+
+static uint32_t tiles_valid(struct bufsig_s * z) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < z->tile_count; ++i) {
+        count += z->tiles[i].generation ? 1 : 0;
+    }
+    return count;
+}
+
+static void test_tile_prefetch(void **state) {
+    initialize_hdr();
+    struct bufsig_s z = b;
+    z.tile_count = 4;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    jsdrv_bufsig_alloc(&z, 1000000, 10, 10);
+    assert_false(jsdrv_bufsig_tile_prefetch(&b, 64005, 1000, 128, false));  // no tiles
+    for (uint64_t sample_id = 0; sample_id < 300000; sample_id += 873) {
+        insert_samples(&b, sample_id, 873);
+        insert_samples(&z, sample_id, 873);
+    }
+    uint64_t rsp1_u64[1 << 12];
+    uint64_t rsp2_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp1 = (struct jsdrv_buffer_response_s *) rsp1_u64;
+    struct jsdrv_buffer_response_s * rsp2 = (struct jsdrv_buffer_response_s *) rsp2_u64;
+    struct jsdrv_summary_entry_s * e1 = (struct jsdrv_summary_entry_s *) rsp1->data;
+    struct jsdrv_summary_entry_s * e2 = (struct jsdrv_summary_entry_s *) rsp2->data;
+
+    // one tile per call, then nothing left
+    assert_true(jsdrv_bufsig_tile_prefetch(&z, 64005, 1000, 128, false));
+    assert_int_equal(1, tiles_valid(&z));
+    assert_true(jsdrv_bufsig_tile_prefetch(&z, 64005, 1000, 128, false));
+    assert_false(jsdrv_bufsig_tile_prefetch(&z, 64005, 1000, 128, false));
+    assert_int_equal(2, tiles_valid(&z));
+
+    // the request hits the prefetched tiles
+    summary_req(&b, 64005, 1000, 128, rsp1);
+    summary_req(&z, 64005, 1000, 128, rsp2);
+    assert_int_equal(2, tiles_valid(&z));
+    for (uint32_t i = 0; i < 128; ++i) {
+        assert_float_equal(e1[i].avg, e2[i].avg, 1e-5);
+    }
+
+    // partial tiles beyond the newest sample are skipped
+    assert_false(jsdrv_bufsig_tile_prefetch(&z, 256005, 1000, 50, false));
+    assert_false(jsdrv_bufsig_tile_prefetch(&z, 64005, 0, 128, false));
+    assert_true(jsdrv_bufsig_tile_prefetch(&z, 64005, 1000, 64, true));  // envelope tiles are separate
+    assert_int_equal(3, tiles_valid(&z));
+    jsdrv_bufsig_free(&b);
+    jsdrv_bufsig_free(&z);
+}
+
+static void test_summary_envelope(void **state) {
+    initialize_hdr();
+    struct bufsig_s z = b;
+    z.tile_count = 4;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    jsdrv_bufsig_alloc(&z, 1000000, 10, 10);
+    for (uint64_t sample_id = 0; sample_id < 300000; sample_id += 873) {
+        insert_samples(&b, sample_id, 873);
+        insert_samples(&z, sample_id, 873);
+    }
+    uint64_t rsp1_u64[1 << 12];
+    uint64_t rsp2_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp1 = (struct jsdrv_buffer_response_s *) rsp1_u64;
+    struct jsdrv_buffer_response_s * rsp2 = (struct jsdrv_buffer_response_s *) rsp2_u64;
+    struct jsdrv_summary_entry_s * e1 = (struct jsdrv_summary_entry_s *) rsp1->data;
+    struct jsdrv_summary_entry_s * e2 = (struct jsdrv_summary_entry_s *) rsp2->data;
+    uint64_t incrs[] = {7, 1000, 1234};
+    struct bufsig_s * signals[] = {&b, &z};
+    for (uint32_t k = 0; k < 2; ++k) {
+        for (uint32_t n = 0; n < 3; ++n) {
+            struct jsdrv_buffer_request_s req;
+            memset(&req, 0, sizeof(req));
+            req.version = 1;
+            req.time_type = JSDRV_TIME_SAMPLES;
+            req.time.samples.start = 100003;
+            req.time.samples.end = 100003 + incrs[n] * 100 - 1;
+            req.time.samples.length = 100;
+            struct jsdrv_buffer_request_s req2 = req;
+            req2.flags = JSDRV_BUFFER_REQUEST_FLAG_ENVELOPE;
+            assert_int_equal(0, jsdrv_bufsig_process_request(signals[k], &req, rsp1));
+            assert_int_equal(0, jsdrv_bufsig_process_request(signals[k], &req2, rsp2));
+            assert_int_equal(JSDRV_BUFFER_RESPONSE_SUMMARY, rsp2->response_type);
+            assert_int_equal(100, rsp2->info.time_range_samples.length);
+            for (uint32_t i = 0; i < 100; ++i) {
+                assert_float_equal(e1[i].avg, e2[i].avg, 0.0);
+                assert_float_equal(e1[i].min, e2[i].min, 0.0);
+                assert_float_equal(e1[i].max, e2[i].max, 0.0);
+                assert_false(isnan(e1[i].std));
+                assert_true(isnan(e2[i].std));
+            }
+        }
+    }
+    jsdrv_bufsig_free(&b);
+    jsdrv_bufsig_free(&z);
+}
+
+static void strided_req(struct bufsig_s * b, uint64_t start, uint64_t end, uint64_t length,
+                        struct jsdrv_buffer_response_s * rsp) {
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.flags = JSDRV_BUFFER_REQUEST_FLAG_STRIDE;
+    req.time.samples.start = start;
+    req.time.samples.end = end;
+    req.time.samples.length = length;
+    assert_int_equal(0, jsdrv_bufsig_process_request(b, &req, rsp));
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_STRIDED, rsp->response_type);
+}
+
+static void test_strided(void **state) {
+    initialize();
+    for (uint64_t sample_id = 0; sample_id < 1500000; sample_id += 1000) {
+        insert_samples(&b, sample_id, 1000);  // wraps the ring
+    }
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    float * f32 = (float *) rsp->data;
+    strided_req(&b, 400000, 1499999, 1000, rsp);
+    assert_int_equal(1000, rsp->info.time_range_samples.length);
+    assert_int_equal(1499999, rsp->info.time_range_samples.end);
+    assert_int_equal(sizeof(*rsp) + 1000 * sizeof(float), jsdrv_bufsig_response_size(rsp));
+    for (uint32_t i = 0; i < 1000; ++i) {
+        assert_float_equal((400000 + i * 1100) / 1000000.0f, f32[i], 1e-12);
+    }
+    strided_req(&b, 499000, 509999, 10, rsp);  // starts before the tail
+    assert_true(isnan(f32[0]));
+    assert_float_equal(500100 / 1000000.0f, f32[1], 1e-12);
+    jsdrv_bufsig_free(&b);
+}
+
+static void test_strided_u4(void **state) {
+    initialize_hdr();
+    b.hdr.field_id = JSDRV_FIELD_RANGE;
+    b.hdr.element_type = JSDRV_DATA_TYPE_UINT;
+    b.hdr.element_size_bits = 4;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    static struct jsdrv_stream_signal_s s;
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    uint8_t x[1001];
+    for (uint32_t i = 0; i < sizeof(x); ++i) {
+        x[i] = (uint8_t) (i % 13);
+    }
+    u4_signal_init(&s, 1000, sizeof(x));
+    jsdrv_pack_u4(s.data, x, sizeof(x));
+    jsdrv_bufsig_recv_data(&b, &s);
+    strided_req(&b, 1001, 1300, 100, rsp);
+    uint8_t actual[100];
+    jsdrv_unpack_u4(actual, (const uint8_t *) rsp->data, 100);
+    for (uint32_t i = 0; i < 100; ++i) {
+        assert_int_equal(x[1 + i * 3], actual[i]);
+    }
+    jsdrv_bufsig_free(&b);
+}
+
+static void test_copy_replace(void **state) {
+    initialize();
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    struct jsdrv_buffer_info_s info;
+    for (uint64_t k = 1000; k < 1501000; k += 1000) {
+        insert_samples(&b, k, 1000);
+    }
+    struct bufsig_s d;
+    memset(&d, 0, sizeof(d));
+    d.hdr = b.hdr;
+    d.time_map = b.time_map;
+    d.numa_node = -1;
+    jsdrv_bufsig_alloc(&d, 100000, 10, 10);
+    assert_true(jsdrv_bufsig_copy(&d, &b, b.sample_id_head));
+    jsdrv_bufsig_info(&d, &info);
+    assert_int_equal(1401000, info.time_range_samples.start);
+    assert_int_equal(100000, info.time_range_samples.length);
+
+    insert_samples(&b, 1501000, 1000);  // catch up with new samples
+    assert_true(jsdrv_bufsig_copy(&d, &b, b.sample_id_head));
+    uint64_t generation = b.generation;
+    jsdrv_bufsig_replace(&b, &d);
+    assert_int_equal(generation + 1, b.generation);
+    assert_true(b.active);
+    jsdrv_bufsig_info(&b, &info);
+    assert_string_equal(SRC_TOPIC, info.topic);
+    assert_int_equal(100000, info.size_in_samples);
+    assert_int_equal(1402000, info.time_range_samples.start);
+    assert_int_equal(100000, info.time_range_samples.length);
+    samples_req(&b, 1501500, 500, rsp);
+    check_values(rsp, 1501500, 500);
+
+    insert_samples(&b, 1502000, 1000);  // live continues into the new storage
+    samples_req(&b, 1502500, 500, rsp);
+    check_values(rsp, 1502500, 500);
+    jsdrv_bufsig_free(&d);
+    jsdrv_bufsig_free(&b);
+}
+
+static void gaps_req(struct bufsig_s * b, uint64_t start, uint64_t end, struct jsdrv_buffer_response_s * rsp) {
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.flags = JSDRV_BUFFER_REQUEST_FLAG_GAPS;
+    req.time.samples.start = start;
+    req.time.samples.end = end;
+    assert_int_equal(0, jsdrv_bufsig_process_request(b, &req, rsp));
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_GAPS, rsp->response_type);
+}
+
+static void test_gap(void **state) {
+    initialize_hdr();
+    b.integral = 1;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    struct jsdrv_time_range_samples_s * ranges = (struct jsdrv_time_range_samples_s *) rsp->data;
+    insert_samples(&b, 1000, 1003);
+    insert_samples(&b, 5003, 1000);  // 3000 missing samples
+    assert_int_equal(1, b.gap_count);
+
+    samples_req(&b, 1990, 3100, rsp);
+    assert_true(rsp->flags & JSDRV_BUFFER_RESPONSE_FLAG_GAP);
+    float * f32 = (float *) rsp->data;
+    for (uint32_t i = 0; i < 3100; ++i) {
+        uint64_t sample_id = 1990 + i;
+        if ((sample_id >= 2003) && (sample_id < 5003)) {
+            assert_true(isnan(f32[i]));
+        } else {
+            assert_float_equal(sample_id / 1000000.0f, f32[i], 1e-12);
+        }
+    }
+    samples_req(&b, 1000, 1000, rsp);
+    assert_false(rsp->flags & JSDRV_BUFFER_RESPONSE_FLAG_GAP);
+
+    summary_req(&b, 1000, 1000, 5, rsp);
+    struct jsdrv_summary_entry_s * e = (struct jsdrv_summary_entry_s *) rsp->data;
+    assert_true(rsp->flags & JSDRV_BUFFER_RESPONSE_FLAG_GAP);
+    assert_false(isnan(e[0].avg));  // assert_float_equal accepts NaN
+    assert_float_equal(1499.5f / 1000000.0f, e[0].avg, 1e-9);
+    assert_true(isnan(e[1].avg));  // 2000 to 2002, then level entries entirely within the gap
+    assert_true(isnan(e[2].avg));
+    assert_true(isnan(e[3].avg));
+    assert_false(isnan(e[4].avg));
+    // 5003 to 5999, the level 1 entry 5000 to 5009 weighs as 10 samples with mean 5006
+    assert_float_equal(5499.515f / 1000000.0f, e[4].avg, 1e-9);
+    summary_req(&b, 2010, 10, 10, rsp);  // level 1 entries within the gap
+    for (uint32_t i = 0; i < 10; ++i) {
+        assert_true(isnan(e[i].avg));
+    }
+
+    integral_req(&b, 1000, 6002, rsp);
+    struct jsdrv_buffer_integral_s * y = (struct jsdrv_buffer_integral_s *) rsp->data;
+    assert_int_equal(2003, y->sample_count);
+
+    gaps_req(&b, 0, 10000, rsp);
+    assert_int_equal(1000, rsp->info.time_range_samples.start);
+    assert_int_equal(6002, rsp->info.time_range_samples.end);
+    assert_int_equal(1, rsp->info.time_range_samples.length);
+    assert_int_equal(2003, ranges[0].start);
+    assert_int_equal(5002, ranges[0].end);
+    assert_int_equal(3000, ranges[0].length);
+    gaps_req(&b, 3000, 3009, rsp);
+    assert_int_equal(1, rsp->info.time_range_samples.length);
+    assert_int_equal(3000, ranges[0].start);
+    assert_int_equal(3009, ranges[0].end);
+    gaps_req(&b, 5003, 6002, rsp);
+    assert_int_equal(0, rsp->info.time_range_samples.length);
+
+    for (uint64_t k = 6003; k < 1010000; k += 1000) {  // overwrite the gap
+        insert_samples(&b, k, 1000);
+    }
+    assert_int_equal(0, b.gap_count);
+    samples_req(&b, 1006003, 1000, rsp);
+    check_values(rsp, 1006003, 1000);
+    jsdrv_bufsig_free(&b);
+}
+
+static void test_gap_u4(void **state) {
+    initialize_hdr();
+    b.hdr.field_id = JSDRV_FIELD_RANGE;
+    b.hdr.element_type = JSDRV_DATA_TYPE_UINT;
+    b.hdr.element_size_bits = 4;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    static struct jsdrv_stream_signal_s s;
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    uint8_t x[300];
+    for (uint32_t i = 0; i < sizeof(x); ++i) {
+        x[i] = (uint8_t) (1 + (i % 13));
+    }
+    u4_signal_init(&s, 1000, sizeof(x));
+    jsdrv_pack_u4(s.data, x, sizeof(x));
+    jsdrv_bufsig_recv_data(&b, &s);
+    u4_signal_init(&s, 1000 + sizeof(x) + 78, sizeof(x));
+    jsdrv_pack_u4(s.data, x, sizeof(x));
+    jsdrv_bufsig_recv_data(&b, &s);
+
+    samples_req(&b, 1001, 2 * sizeof(x) + 70, rsp);
+    assert_true(rsp->flags & JSDRV_BUFFER_RESPONSE_FLAG_GAP);
+    uint8_t actual[2 * sizeof(x) + 70];
+    jsdrv_unpack_u4(actual, (const uint8_t *) rsp->data, sizeof(actual));
+    for (uint32_t i = 0; i < sizeof(actual); ++i) {
+        uint32_t offset = i + 1;
+        if (offset < sizeof(x)) {
+            assert_int_equal(x[offset], actual[i]);
+        } else if (offset < (sizeof(x) + 78)) {
+            assert_int_equal(0, actual[i]);
+        } else {
+            assert_int_equal(x[offset - sizeof(x) - 78], actual[i]);
+        }
+    }
+    jsdrv_bufsig_free(&b);
+}
+
+static void insert_f32(struct bufsig_s * b, uint64_t sample_id_start, const float * x, uint32_t length) {
+    static struct jsdrv_stream_signal_s s;
+    while (length) {
+        uint32_t n = (length > 2000) ? 2000 : length;
+        memset(&s, 0, sizeof(s));
+        s.sample_id = sample_id_start;
+        s.field_id = JSDRV_FIELD_CURRENT;
+        s.index = 7;
+        s.element_type = JSDRV_DATA_TYPE_FLOAT;
+        s.element_size_bits = 32;
+        s.element_count = n;
+        s.sample_rate = 1000000;
+        s.decimate_factor = 1;
+        s.time_map.offset_time = JSDRV_TIME_HOUR;
+        s.time_map.counter_rate = s.sample_rate;
+        memcpy(s.data, x, n * sizeof(float));
+        jsdrv_bufsig_recv_data(b, &s);
+        sample_id_start += n;
+        x += n;
+        length -= n;
+    }
+}
+
+static uint64_t search_req(struct bufsig_s * b, uint64_t start, uint64_t end, uint8_t options,
+                           struct jsdrv_buffer_response_s * rsp, uint32_t data_size) {
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.op = JSDRV_BUFFER_REQUEST_OP_SEARCH | options;
+    req.threshold = 0.5f;
+    req.time.samples.start = start;
+    req.time.samples.end = end;
+    assert_int_equal(0, jsdrv_bufsig_process_request_sz(b, &req, rsp, data_size));
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_CROSSINGS, rsp->response_type);
+    return rsp->info.time_range_samples.length;
+}
+
+static void test_search(void **state) {
+    initialize();
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    uint64_t * y = (uint64_t *) rsp->data;
+    uint32_t sz = sizeof(rsp_u64) - sizeof(*rsp) - JSDRV_BUFSIG_RSP_SLACK;
+    float * x = malloc(300000 * sizeof(float));
+    for (uint32_t i = 0; i < 300000; ++i) {
+        x[i] = (((i >= 100000) && (i < 105000)) || (i == 150003)) ? 1.0f : 0.0f;
+    }
+    insert_f32(&b, 0, x, 300000);
+
+    assert_int_equal(1, search_req(&b, 0, 299999, 0, rsp, sz));
+    assert_int_equal(100000, y[0]);
+    assert_int_equal(0, rsp->info.time_range_samples.start);
+    assert_int_equal(299999, rsp->info.time_range_samples.end);
+    assert_int_equal(1, search_req(&b, 0, 299999, JSDRV_BUFFER_SEARCH_FALLING, rsp, sz));
+    assert_int_equal(105000, y[0]);
+    assert_int_equal(1, search_req(&b, 0, 299999, JSDRV_BUFFER_SEARCH_LAST, rsp, sz));
+    assert_int_equal(150004, y[0]);
+    assert_int_equal(1, search_req(&b, 0, 299999, JSDRV_BUFFER_SEARCH_LAST | JSDRV_BUFFER_SEARCH_RISING, rsp, sz));
+    assert_int_equal(150003, y[0]);
+    assert_int_equal(4, search_req(&b, 0, 299999, JSDRV_BUFFER_SEARCH_ALL, rsp, sz));
+    assert_int_equal(100000, y[0]);
+    assert_int_equal(105000, y[1]);
+    assert_int_equal(150003, y[2]);
+    assert_int_equal(150004, y[3]);
+    assert_int_equal(2, search_req(&b, 0, 299999, JSDRV_BUFFER_SEARCH_ALL, rsp, 2 * sizeof(uint64_t)));
+    assert_int_equal(105000, rsp->info.time_range_samples.end);  // continue from end + 1
+
+    // the preceding sample detects a crossing at start
+    assert_int_equal(1, search_req(&b, 100000, 299999, JSDRV_BUFFER_SEARCH_RISING, rsp, sz));
+    assert_int_equal(100000, y[0]);
+    assert_int_equal(1, search_req(&b, 100001, 299999, JSDRV_BUFFER_SEARCH_RISING, rsp, sz));
+    assert_int_equal(150003, y[0]);
+    assert_int_equal(1, search_req(&b, 0, 150003, JSDRV_BUFFER_SEARCH_LAST, rsp, sz));
+    assert_int_equal(150003, y[0]);
+    assert_int_equal(0, search_req(&b, 105001, 150002, 0, rsp, sz));
+    assert_int_equal(0, search_req(&b, 105001, 150002, JSDRV_BUFFER_SEARCH_LAST, rsp, sz));
+    assert_int_equal(0, search_req(&b, 400000, 500000, 0, rsp, sz));  // past the newest sample
+
+    // match a linear scan for many crossings at every level
+    uint32_t v = 1;
+    float level = 0.0f;
+    for (uint32_t i = 0; i < 300000; ++i) {
+        v = v * 1664525U + 1013904223U;
+        if (0 == (v >> 22)) {
+            level = (level > 0.5f) ? 0.0f : 1.0f;
+        }
+        x[i] = ((v >> 16) & 0x3f) ? level : NAN;
+    }
+    insert_f32(&b, 300000, x, 300000);
+    const uint64_t ranges[][2] = {{300000, 599999}, {301234, 587654}, {450001, 450999}, {299990, 300020}};
+    for (uint32_t r = 0; r < 4; ++r) {
+        uint64_t expect[512];
+        uint32_t expect_count = 0;
+        int above = -1;
+        uint64_t first = (ranges[r][0] > 300000) ? (ranges[r][0] - 1) : 300000;
+        for (uint64_t k = first; k <= ranges[r][1]; ++k) {
+            float f = x[k - 300000];
+            if (isnan(f)) {
+                continue;
+            }
+            int a = f > 0.5f;
+            if ((above >= 0) && (a != above)) {
+                assert_true(expect_count < 512);
+                expect[expect_count++] = k;
+            }
+            above = a;
+        }
+        assert_int_equal(expect_count, search_req(&b, ranges[r][0], ranges[r][1], JSDRV_BUFFER_SEARCH_ALL, rsp, sz));
+        assert_memory_equal(expect, y, expect_count * sizeof(uint64_t));
+        if (expect_count) {
+            assert_int_equal(1, search_req(&b, ranges[r][0], ranges[r][1], 0, rsp, sz));
+            assert_int_equal(expect[0], y[0]);
+            assert_int_equal(1, search_req(&b, ranges[r][0], ranges[r][1], JSDRV_BUFFER_SEARCH_LAST, rsp, sz));
+            assert_int_equal(expect[expect_count - 1], y[0]);
+        }
+    }
+    free(x);
+    jsdrv_bufsig_free(&b);
+}
+
+static void insert_blocks(struct bufsig_s * b, uint64_t sample_id, uint32_t count, float value) {
+    float * x = malloc(100000 * sizeof(float));
+    for (uint32_t i = 0; i < count; ++i) {
+        for (uint32_t k = 0; k < 100000; ++k) {
+            x[k] = value + (float) i;
+        }
+        insert_f32(b, sample_id + i * 100000ULL, x, 100000);
+    }
+    free(x);
+}
+
+static void test_trend(void **state) {
+    initialize_hdr();
+    b.trend_level = 2;
+    b.trend_k = 100000;
+    struct bufsig_s b2 = b;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    assert_non_null(b.trend);
+    assert_int_equal(100, b.trend_spe);
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    struct jsdrv_summary_entry_s * y = (struct jsdrv_summary_entry_s *) rsp->data;
+
+    insert_blocks(&b, 0, 30, 1.0f);
+    assert_int_equal(2000000, b.sample_id_head - b.level0_size);
+    summary_req(&b, 0, 100000, 21, rsp);
+    assert_true(0 != (rsp->flags & JSDRV_BUFFER_RESPONSE_FLAG_TREND));
+    for (uint32_t i = 0; i < 21; ++i) {  // level 0 starts at entry 20
+        assert_float_equal(1.0f + i, y[i].avg, 1e-6);
+        assert_float_equal(1.0f + i, y[i].min, 1e-6);
+        assert_float_equal(1.0f + i, y[i].max, 1e-6);
+    }
+    summary_req(&b, 2000000, 100000, 10, rsp);
+    assert_int_equal(0, rsp->flags & JSDRV_BUFFER_RESPONSE_FLAG_TREND);
+
+    // a gap, then a skip that restarts level 0 but not the trend
+    insert_blocks(&b, 3200000, 2, 100.0f);
+    insert_blocks(&b, 6000000, 1, 200.0f);
+    assert_int_equal(6000000, b.sample_id_head - b.level0_size);
+    summary_req(&b, 0, 100000, 61, rsp);
+    assert_true(0 != (rsp->flags & JSDRV_BUFFER_RESPONSE_FLAG_TREND));
+    for (uint32_t i = 0; i < 61; ++i) {
+        if (i < 30) {
+            assert_float_equal(1.0f + i, y[i].avg, 1e-6);
+        } else if ((32 == i) || (33 == i)) {
+            assert_float_equal(68.0f + i, y[i].avg, 1e-6);
+        } else if (60 == i) {
+            assert_float_equal(200.0f, y[i].avg, 1e-6);
+        } else {
+            assert_true(isnan(y[i].avg));
+        }
+    }
+
+    // a copy retains the older trend entries
+    jsdrv_bufsig_alloc(&b2, 1000000, 10, 10);
+    assert_true(jsdrv_bufsig_copy(&b2, &b, b.sample_id_head));
+    uint64_t rsp2_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp2 = (struct jsdrv_buffer_response_s *) rsp2_u64;
+    summary_req(&b2, 0, 100000, 61, rsp2);
+    assert_memory_equal(y, rsp2->data, 61 * sizeof(struct jsdrv_summary_entry_s));
+
+    jsdrv_bufsig_clear(&b);
+    assert_int_equal(0, b.trend_size);
+    jsdrv_bufsig_free(&b);
+    jsdrv_bufsig_free(&b2);
+    assert_null(b.trend);
+}
+
+static void test_save_load(void **state) {
+    initialize_hdr();
+    b.integral = 1;
+    b.histogram = 1;
+    b.trend_level = 2;
+    b.trend_k = 100000;
+    struct bufsig_s b2;
+    memset(&b2, 0, sizeof(b2));
+    b2.active = true;
+    b2.numa_node = -1;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    insert_blocks(&b, 0, 15, 1.0f);
+    insert_blocks(&b, 1600000, 2, 50.0f);  // gap
+    assert_int_equal(1, b.gap_count);
+
+    FILE * f = tmpfile();
+    assert_non_null(f);
+    assert_int_equal(0, jsdrv_bufsig_save(&b, f));
+    rewind(f);
+    uint32_t idx = 0;
+    assert_int_equal(0, jsdrv_bufsig_load(&b2, f, &idx));
+    assert_int_equal(b.idx, idx);
+    assert_string_equal(SRC_TOPIC, b2.topic);
+    assert_int_equal(b.sample_id_head, b2.sample_id_head);
+    assert_int_equal(b.level0_size, b2.level0_size);
+    assert_int_equal(1, b2.gap_count);
+    assert_memory_equal(b.level0_data, b2.level0_data, b.N * sizeof(float));
+    for (int i = 0; NULL != b.levels[i].data; ++i) {
+        assert_int_equal(b.levels[i].k, b2.levels[i].k);
+        assert_memory_equal(b.levels[i].data, b2.levels[i].data, b.levels[i].k * sizeof(struct jsdrv_summary_entry_s));
+    }
+    assert_memory_equal(b.hist_level1, b2.hist_level1, b.levels[0].k * JSDRV_BUFSIG_HIST_BINS * sizeof(uint16_t));
+    assert_memory_equal(b.trend, b2.trend, b.trend_k * sizeof(struct jsdrv_summary_entry_s));
+
+    uint64_t rsp_u64[1 << 12];
+    uint64_t rsp2_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    struct jsdrv_buffer_response_s * rsp2 = (struct jsdrv_buffer_response_s *) rsp2_u64;
+    summary_req(&b, 0, 100000, 18, rsp);
+    summary_req(&b2, 0, 100000, 18, rsp2);
+    assert_int_equal(rsp->flags, rsp2->flags);
+    assert_memory_equal(rsp->data, rsp2->data, 18 * sizeof(struct jsdrv_summary_entry_s));
+    integral_req(&b, 900000, 1700000, rsp);
+    integral_req(&b2, 900000, 1700000, rsp2);
+    assert_memory_equal(rsp->data, rsp2->data, sizeof(struct jsdrv_buffer_integral_s));
+
+    // the loaded signal continues to receive samples
+    insert_blocks(&b2, 1800000, 1, 60.0f);
+    assert_int_equal(1900000, b2.sample_id_head);
+
+    // reject other records
+    rewind(f);
+    assert_int_equal(0, fputc('X', f) == EOF);
+    rewind(f);
+    jsdrv_bufsig_free(&b2);
+    memset(&b2, 0, sizeof(b2));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_bufsig_load(&b2, f, &idx));
+    fclose(f);
+
+    struct bufsig_stream_header_s hdr = b.hdr;
+    jsdrv_bufsig_free(&b);
+    b.hdr = hdr;
+    b.integral = 0;
+    b.histogram = 0;
+    b.trend_level = 0;
+    b.codec = 1;
+    jsdrv_bufsig_alloc(&b, CODEC_N, 128, 32);
+    assert_non_null(b.blocks);
+    assert_int_equal(JSDRV_ERROR_NOT_SUPPORTED, jsdrv_bufsig_save(&b, NULL));
+    jsdrv_bufsig_free(&b);
+    jsdrv_bufsig_free(&b2);
+}
+
+static void test_ingest(void **state) {
+    initialize_hdr();
+    b.integral = 1;
+    b.histogram = 1;
+    b.trend_level = 1;
+    b.trend_k = 200000;
+    struct bufsig_s b2 = b;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    jsdrv_bufsig_alloc(&b2, 1000000, 10, 10);
+    uint32_t length = 1650000;
+    float * x = malloc(length * sizeof(float));
+    for (uint32_t k = 0; k < length; ++k) {
+        x[k] = (float) (k % 1237) * 0.01f;
+    }
+    x[123456] = NAN;
+
+    insert_f32(&b, 0, x, 700000);
+    insert_f32(&b, 750000, x + 750000, 900000);  // gap and wrap
+    struct bufsig_s b3;
+    memset(&b3, 0, sizeof(b3));
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_bufsig_ingest(&b3, 0, x, 10, 4));
+    assert_int_equal(0, jsdrv_bufsig_ingest(&b2, 0, x, 700000, 4));
+    assert_int_equal(0, jsdrv_bufsig_ingest(&b2, 750000, x + 750000, 900000, 4));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_bufsig_ingest(&b2, 1000, x, 10, 4));
+
+    jsdrv_bufsig_summary_update(&b, JSDRV_BUFSIG_LEVELS_MAX);
+    jsdrv_bufsig_summary_update(&b2, JSDRV_BUFSIG_LEVELS_MAX);
+    assert_int_equal(b.sample_id_head, b2.sample_id_head);
+    assert_int_equal(b.level0_size, b2.level0_size);
+    assert_int_equal(b.gap_count, b2.gap_count);
+    assert_memory_equal(b.level0_data, b2.level0_data, b.N * sizeof(float));
+    for (int i = 0; NULL != b.levels[i].data; ++i) {
+        assert_memory_equal(b.levels[i].data, b2.levels[i].data, b.levels[i].k * sizeof(struct jsdrv_summary_entry_s));
+        if (i) {
+            assert_memory_equal(b.hist_levels[i], b2.hist_levels[i], b.levels[i].k * JSDRV_BUFSIG_HIST_BINS * sizeof(uint32_t));
+        }
+    }
+    assert_memory_equal(b.integral_index, b2.integral_index, b.levels[0].k * sizeof(struct bufsig_integral_s));
+    assert_memory_equal(b.hist_level1, b2.hist_level1, b.levels[0].k * JSDRV_BUFSIG_HIST_BINS * sizeof(uint16_t));
+    assert_int_equal(b.trend_size, b2.trend_size);
+    assert_memory_equal(b.trend, b2.trend, b.trend_k * sizeof(struct jsdrv_summary_entry_s));
+
+    // only the newest N samples remain
+    assert_int_equal(0, jsdrv_bufsig_ingest(&b2, 2000000, x, length, 4));
+    assert_int_equal(3650000, b2.sample_id_head);
+    assert_int_equal(1000000, b2.level0_size);
+    assert_memory_equal(x + 650000, b2.level0_data, 1000000 * sizeof(float));
+    free(x);
+    jsdrv_bufsig_free(&b);
+    jsdrv_bufsig_free(&b2);
+}
+
+static void test_summary_lazy(void **state) {
+    initialize_hdr();
+    b.histogram = 1;
+    struct bufsig_s b2 = b;
+    struct bufsig_stream_header_s hdr = b.hdr;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    jsdrv_bufsig_alloc(&b2, 1000000, 10, 10);
+    uint32_t length = 1650000;
+    float * x = malloc(length * sizeof(float));
+    for (uint32_t k = 0; k < length; ++k) {
+        x[k] = (float) (k % 1237) * 0.01f;
+    }
+
+    insert_f32(&b, 0, x, length);
+    assert_true(jsdrv_bufsig_summary_pending(&b));
+    assert_true(b.summary_dirty[0] < JSDRV_BUFSIG_SUMMARY_BATCH);
+    assert_true(b.summary_dirty[1] <= (b.N / 4));
+    for (uint32_t k = 0; k < length; k += 2000) {  // eager reference
+        insert_f32(&b2, k, x + k, 2000);
+        jsdrv_bufsig_summary_update(&b2, JSDRV_BUFSIG_LEVELS_MAX);
+    }
+    assert_false(jsdrv_bufsig_summary_pending(&b2));
+
+    uint64_t rsp_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    uint64_t rsp2_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp2 = (struct jsdrv_buffer_response_s *) rsp2_u64;
+    summary_req(&b, 650000, 100, 100, rsp);  // completes level 2 only
+    summary_req(&b2, 650000, 100, 100, rsp2);
+    assert_memory_equal(rsp->data, rsp2->data, 100 * sizeof(struct jsdrv_summary_entry_s));
+    assert_int_equal(0, b.summary_dirty[1]);
+    assert_true(0 != b.summary_dirty[2]);
+    summary_req(&b, 650000, 100000, 10, rsp);
+    summary_req(&b2, 650000, 100000, 10, rsp2);
+    assert_memory_equal(rsp->data, rsp2->data, 10 * sizeof(struct jsdrv_summary_entry_s));
+
+    jsdrv_bufsig_summary_update(&b, JSDRV_BUFSIG_LEVELS_MAX);
+    assert_false(jsdrv_bufsig_summary_pending(&b));
+    for (int i = 1; NULL != b.levels[i].data; ++i) {
+        assert_memory_equal(b.levels[i].data, b2.levels[i].data, b.levels[i].k * sizeof(struct jsdrv_summary_entry_s));
+        assert_memory_equal(b.hist_levels[i], b2.hist_levels[i], b.levels[i].k * JSDRV_BUFSIG_HIST_BINS * sizeof(uint32_t));
+    }
+    jsdrv_bufsig_free(&b);
+    jsdrv_bufsig_free(&b2);
+
+    // batches that cross the end of a ring that is not a multiple of the entry sizes
+    b.hdr = hdr;
+    b2.hdr = hdr;
+    jsdrv_bufsig_alloc(&b, 123457, 10, 10);
+    jsdrv_bufsig_alloc(&b2, 123457, 10, 10);
+    insert_f32(&b, 0, x, 400000);
+    for (uint32_t k = 0; k < 400000; k += 2000) {
+        insert_f32(&b2, k, x + k, 2000);
+        jsdrv_bufsig_summary_update(&b2, JSDRV_BUFSIG_LEVELS_MAX);
+    }
+    jsdrv_bufsig_summary_update(&b, JSDRV_BUFSIG_LEVELS_MAX);
+    for (int i = 0; NULL != b.levels[i].data; ++i) {
+        assert_memory_equal(b.levels[i].data, b2.levels[i].data, b.levels[i].k * sizeof(struct jsdrv_summary_entry_s));
+    }
+    free(x);
+    jsdrv_bufsig_free(&b);
+    jsdrv_bufsig_free(&b2);
+}
+
+static int float_cmp(const void * a, const void * b) {
+    float fa = *((const float *) a);
+    float fb = *((const float *) b);
+    return (fa < fb) ? -1 : ((fa > fb) ? 1 : 0);
+}
+
+static int32_t quantile_req(struct bufsig_s * b, uint64_t start, uint64_t end, uint64_t length,
+                            struct jsdrv_buffer_response_s * rsp, uint32_t data_size) {
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.op = JSDRV_BUFFER_REQUEST_OP_QUANTILE;
+    req.time.samples.start = start;
+    req.time.samples.end = end;
+    req.time.samples.length = length;
+    return jsdrv_bufsig_process_request_sz(b, &req, rsp, data_size);
+}
+
+static void test_quantile(void **state) {
+    initialize_hdr();
+    struct bufsig_s b_scan = b;
+    b.histogram = 1;
+    jsdrv_bufsig_alloc(&b, 1000000, 10, 10);
+    jsdrv_bufsig_alloc(&b_scan, 1000000, 10, 10);
+    assert_non_null(b.hist_level1);
+    assert_non_null(b.hist_levels[1]);
+    assert_null(b_scan.hist_level1);
+    uint64_t rsp_u64[1 << 12];
+    uint64_t rsp_scan_u64[1 << 12];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    struct jsdrv_buffer_response_s * rsp_scan = (struct jsdrv_buffer_response_s *) rsp_scan_u64;
+    float * y = (float *) rsp->data;
+    uint32_t sz = sizeof(rsp_u64) - sizeof(*rsp) - JSDRV_BUFSIG_RSP_SLACK;
+
+    assert_int_equal(0, quantile_req(&b, 0, 1000, 11, rsp, sz));
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_QUANTILES, rsp->response_type);
+    assert_int_equal(0, rsp->info.time_range_samples.length);  // empty buffer
+
+    // wrap the ring with log-uniform values from 1 uA to 1 A, zeros and NaNs
+    uint32_t total = 1200000;
+    float * x = malloc(total * sizeof(float));
+    uint32_t v = 1;
+    for (uint32_t i = 0; i < total; ++i) {
+        v = v * 1664525U + 1013904223U;
+        if (0 == ((v >> 8) & 0xff)) {
+            x[i] = NAN;
+        } else if (1 == ((v >> 8) & 0xff)) {
+            x[i] = 0.0f;
+        } else {
+            x[i] = powf(10.0f, -6.0f * (float) (v >> 16) / 65536.0f);
+        }
+    }
+    insert_f32(&b, 0, x, total);
+    insert_f32(&b_scan, 0, x, total);
+
+    float * sorted = malloc(total * sizeof(float));
+    const uint64_t ranges[][2] = {{200000, 1199999}, {200001, 1187654}, {450001, 450999}, {123, 300020}};
+    for (uint32_t r = 0; r < 4; ++r) {
+        assert_int_equal(0, quantile_req(&b, ranges[r][0], ranges[r][1], 1001, rsp, sz));
+        assert_int_equal(0, quantile_req(&b_scan, ranges[r][0], ranges[r][1], 1001, rsp_scan, sz));
+        assert_int_equal(1001, rsp->info.time_range_samples.length);
+        assert_memory_equal(y, rsp_scan->data, 1001 * sizeof(float));  // index matches the scan
+        uint64_t start = (ranges[r][0] < 200000) ? 200000 : ranges[r][0];
+        assert_int_equal(start, rsp->info.time_range_samples.start);
+        assert_int_equal(ranges[r][1], rsp->info.time_range_samples.end);
+        uint32_t n = 0;
+        for (uint64_t k = start; k <= ranges[r][1]; ++k) {
+            if (!isnan(x[k])) {
+                sorted[n++] = x[k];
+            }
+        }
+        qsort(sorted, n, sizeof(float), float_cmp);
+        assert_true(sorted[0] == y[0]);
+        assert_true(sorted[n - 1] == y[1000]);
+        for (uint32_t i = 1; i < 1000; ++i) {
+            float expect = sorted[(uint32_t) (((uint64_t) i * (n - 1)) / 1000)];
+            assert_true(y[i] >= y[i - 1]);
+            if (expect > 0.0f) {  // within one log-spaced bin
+                assert_true((y[i] >= (expect / 1.5f)) && (y[i] <= (expect * 1.5f)));
+            } else {
+                assert_true(y[i] < 1e-7f);
+            }
+        }
+    }
+
+    assert_int_equal(0, quantile_req(&b, 777, 199999, 11, rsp, sz));
+    assert_int_equal(0, rsp->info.time_range_samples.length);  // before the oldest sample
+    assert_int_equal(0, quantile_req(&b, 200000, 299999, 0, rsp, sz));
+    assert_int_equal(101, rsp->info.time_range_samples.length);
+    assert_int_equal(0, quantile_req(&b, 200000, 299999, 1, rsp, sz));  // median
+    assert_true((y[0] > 0.5e-3f) && (y[0] < 2e-3f));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, quantile_req(&b, 200000, 299999, 101, rsp, 100 * sizeof(float)));
+
+    free(sorted);
+    free(x);
+    jsdrv_bufsig_free(&b);
+    jsdrv_bufsig_free(&b_scan);
+}
 
 int main(void) {
     const struct CMUnitTest tests[] = {
@@ -323,10 +1795,39 @@ int main(void) {
             cmocka_unit_test(test_samples_start_end),
             cmocka_unit_test(test_samples_all),
             cmocka_unit_test(test_samples_wrap),
+            cmocka_unit_test(test_samples_file_backed),
+            cmocka_unit_test(test_samples_os_mem),
+            cmocka_unit_test(test_codec_samples),
+            cmocka_unit_test(test_codec_budget),
+            cmocka_unit_test(test_codec_summary),
             cmocka_unit_test(test_summary_simple),
             cmocka_unit_test(test_summary_level1),
             cmocka_unit_test(test_summary_nan_on_out_of_range),
             cmocka_unit_test(test_summary_wrap),
+            cmocka_unit_test(test_summary_carry),
+            cmocka_unit_test(test_snapshot_overwritten),
+            cmocka_unit_test(test_freeze),
+            cmocka_unit_test(test_recv_events),
+            cmocka_unit_test(test_stream_samples),
+            cmocka_unit_test(test_stream_summary),
+            cmocka_unit_test(test_standing_summary),
+            cmocka_unit_test(test_display_summary),
+            cmocka_unit_test(test_integral),
+            cmocka_unit_test(test_multi_clip),
+            cmocka_unit_test(test_tile_cache),
+            cmocka_unit_test(test_tile_prefetch),
+            cmocka_unit_test(test_summary_envelope),
+            cmocka_unit_test(test_strided),
+            cmocka_unit_test(test_strided_u4),
+            cmocka_unit_test(test_copy_replace),
+            cmocka_unit_test(test_gap),
+            cmocka_unit_test(test_gap_u4),
+            cmocka_unit_test(test_search),
+            cmocka_unit_test(test_quantile),
+            cmocka_unit_test(test_trend),
+            cmocka_unit_test(test_save_load),
+            cmocka_unit_test(test_ingest),
+            cmocka_unit_test(test_summary_lazy),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
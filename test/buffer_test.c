@@ -21,13 +21,16 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 #include "jsdrv.h"
 #include "jsdrv_prv/buffer.h"
 #include "jsdrv_prv/cdef.h"
 #include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
 #include "jsdrv_prv/frontend.h"
 #include "jsdrv_prv/list.h"
 #include "jsdrv_prv/msg_queue.h"
+#include "jsdrv_prv/record.h"
 #include "tinyprintf.h"
 //#include "test.inc"
 
@@ -49,11 +52,15 @@ struct jsdrv_context_s {
     struct jsdrv_list_s subscribers;
 };
 
+static struct jsdrv_buffer_mgr_s * buffer_mgr_ = NULL;
+static volatile int32_t data_alloc_count_ = 0;
+
 struct jsdrvp_msg_s * jsdrvp_msg_alloc(struct jsdrv_context_s * context) {
     (void) context;
     struct jsdrvp_msg_s * m = calloc(1, sizeof(struct jsdrvp_msg_s));
     jsdrv_list_initialize(&m->item);
     m->inner_msg_type = JSDRV_MSG_TYPE_NORMAL;
+    m->refcnt = 1;
     return m;
 }
 
@@ -62,11 +69,17 @@ struct jsdrvp_msg_s * jsdrvp_msg_alloc_data(struct jsdrv_context_s * context, co
     struct jsdrvp_msg_s * m = calloc(1, STREAM_MSG_SZ);
     jsdrv_list_initialize(&m->item);
     m->inner_msg_type = JSDRV_MSG_TYPE_DATA;
+    m->refcnt = 1;
+    __atomic_add_fetch(&data_alloc_count_, 1, __ATOMIC_SEQ_CST);
     jsdrv_cstr_copy(m->topic, topic, sizeof(m->topic));
     m->value = jsdrv_union_bin(&m->payload.bin[0], 0);
     return m;
 }
 
+struct jsdrvp_msg_s * jsdrvp_msg_alloc_small(struct jsdrv_context_s * context) {
+    return jsdrvp_msg_alloc(context);
+}
+
 struct jsdrvp_msg_s * jsdrvp_msg_alloc_value(struct jsdrv_context_s * context, const char * topic, const struct jsdrv_union_s * value) {
     struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(context);
     jsdrv_cstr_copy(m->topic, topic, sizeof(m->topic));
@@ -126,11 +139,23 @@ struct jsdrvp_msg_s * jsdrvp_msg_clone(struct jsdrv_context_s * context, const s
         }
     }
     jsdrv_list_initialize(&m->item);
+    m->refcnt = 1;
     return m;
 }
 
+struct jsdrvp_msg_s * jsdrvp_msg_retain(struct jsdrvp_msg_s * msg) {
+    __atomic_add_fetch(&msg->refcnt, 1, __ATOMIC_SEQ_CST);
+    return msg;
+}
+
 void jsdrvp_msg_free(struct jsdrv_context_s * context, struct jsdrvp_msg_s * msg) {
     (void) context;
+    if (NULL == msg) {
+        return;
+    }
+    if (__atomic_sub_fetch(&msg->refcnt, 1, __ATOMIC_SEQ_CST) > 0) {
+        return;
+    }
     if (msg->value.flags & JSDRV_UNION_FLAG_HEAP_MEMORY) {
         free((void *) msg->value.value.bin);
     }
@@ -165,6 +190,9 @@ void jsdrvp_backend_send(struct jsdrv_context_s * context, struct jsdrvp_msg_s *
     msg_queue_push(context->msg_sent, msg);
 }
 
+static float export_progress_ = 0.0f;
+#define EXPORT_PATH "buffer_test_export.rec"
+
 static void msg_send_process_next(struct jsdrv_context_s * context, uint32_t timeout_ms) {
     struct jsdrvp_msg_s * msg = NULL;
     char topic[JSDRV_TOPIC_LENGTH_MAX];
@@ -217,6 +245,9 @@ static void msg_send_process_next(struct jsdrv_context_s * context, uint32_t tim
             ch += 4;
             if (0 == strcmp("info", ch)) {
                 check_expected_ptr(topic);
+            } else if (0 == strcmp("export", ch)) {
+                check_expected_ptr(topic);
+                export_progress_ = msg->value.value.f32;
             } else {
                 // unknown topic, not supported
                 assert_true(0);
@@ -274,7 +305,7 @@ struct jsdrv_context_s * initialize() {
     context->msg_sent = msg_queue_init();
     assert_non_null(context->msg_sent);
     jsdrv_list_initialize(&context->subscribers);
-    assert_int_equal(0, jsdrv_buffer_initialize(context));
+    assert_int_equal(0, jsdrv_buffer_initialize(context, &buffer_mgr_));
 
     expect_meta(JSDRV_BUFFER_MGR_MSG_ACTION_ADD "$");
     msg_send_process_next(context, TIMEOUT_MS);
@@ -294,7 +325,8 @@ struct jsdrv_context_s * initialize() {
 
 void finalize(struct jsdrv_context_s * context) {
     struct jsdrv_list_s * item;
-    jsdrv_buffer_finalize();
+    jsdrv_buffer_finalize(buffer_mgr_);
+    buffer_mgr_ = NULL;
     expect_unsubscribe(JSDRV_BUFFER_MGR_MSG_ACTION_ADD);
     msg_send_process_next(context, TIMEOUT_MS);
     expect_unsubscribe(JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE);
@@ -380,6 +412,46 @@ static struct jsdrvp_msg_s * generate_msg_data_i(struct jsdrv_context_s * contex
     return msg;
 }
 
+static void check_export_file(uint64_t sample_id_end) {
+    uint64_t sample_id = 0;
+    uint8_t * buf = malloc(1 << 20);
+    FILE * f = fopen(EXPORT_PATH, "rb");
+    assert_non_null(f);
+    size_t sz = fread(buf, 1, 1 << 20, f);
+    fclose(f);
+    remove(EXPORT_PATH);
+
+    const struct jsdrv_record_header_s * hdr = (const struct jsdrv_record_header_s *) buf;
+    assert_true(sz > sizeof(*hdr));
+    assert_memory_equal(JSDRV_RECORD_MAGIC, hdr->magic, sizeof(hdr->magic));
+    size_t offset = hdr->header_size;
+    uint32_t chunks[3] = {0, 0, 0};
+    uint32_t samples = 0;
+    while (offset < sz) {
+        const struct jsdrv_record_chunk_s * c = (const struct jsdrv_record_chunk_s *) (buf + offset);
+        assert_true((c->type >= JSDRV_RECORD_CHUNK_SIGNAL) && (c->type <= JSDRV_RECORD_CHUNK_END));
+        ++chunks[c->type - 1];
+        if (JSDRV_RECORD_CHUNK_DATA == c->type) {
+            const struct jsdrv_stream_signal_s * s = (const struct jsdrv_stream_signal_s *) (c + 1);
+            if (0 == samples) {
+                sample_id = s->sample_id / 2;  // the first retained sample
+            }
+            assert_int_equal((sample_id + samples) * 2, s->sample_id);
+            assert_int_equal(2, s->decimate_factor);
+            const float * y = (const float *) s->data;
+            assert_true(((float) (sample_id + samples)) * 0.001f == y[0]);
+            samples += s->element_count;
+        }
+        offset += sizeof(*c) + ((c->payload_size + 7) & ~7U);
+    }
+    assert_int_equal(1, chunks[0]);
+    assert_true(chunks[1] > 0);
+    assert_int_equal(1, chunks[2]);
+    assert_true(samples > 0);
+    assert_int_equal(sample_id_end, sample_id + samples);
+    free(buf);
+}
+
 static void test_one_signal(void **state) {
     (void) state;
     struct jsdrvp_msg_s * msg;
@@ -417,16 +489,22 @@ static void test_one_signal(void **state) {
     publish(context, msg);
 
     // send first data frame
+    int32_t data_alloc_count = data_alloc_count_;
     msg = generate_msg_data_i(context, 10000LLU, 100);
     publish(context, msg);
     expect_info_any("m/003/s/005/info");
     msg_send_process_next(context, TIMEOUT_MS);
+    assert_int_equal(1, msg->refcnt);  // buffer released its shared reference
+    jsdrvp_msg_free(context, msg);
 
     // Send second data frame
     msg = generate_msg_data_i(context, 10100LLU, 100);
     publish(context, msg);
     expect_info_any("m/003/s/005/info");  // todo check range?
     msg_send_process_next(context, TIMEOUT_MS);
+    assert_int_equal(1, msg->refcnt);
+    jsdrvp_msg_free(context, msg);
+    assert_int_equal(data_alloc_count + 2, data_alloc_count_);  // no data copies
 
     // request sample data, expect response
     struct jsdrv_buffer_request_s req;
@@ -456,6 +534,61 @@ static void test_one_signal(void **state) {
     expect_rsp_any("t/!rsp");
     msg_send_process_next(context, TIMEOUT_MS);
 
+    // read directly into caller memory, no response message
+    uint64_t rsp_u64[(sizeof(struct jsdrv_buffer_response_s) + 100 * sizeof(float) + JSDRV_BUFFER_READ_SLACK) / 8];
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) rsp_u64;
+    uint64_t data_size = 100 * sizeof(float);
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = 10100LLU;  // the first frame allocates
+    req.time.samples.length = 100;
+    req.rsp_id = 44;
+    data_alloc_count = data_alloc_count_;
+    assert_int_equal(0, jsdrv_buffer_mgr_read(buffer_mgr_, buffer_id, signal_id, &req, rsp, data_size));
+    assert_int_equal(data_alloc_count, data_alloc_count_);
+    assert_int_equal(44, rsp->rsp_id);
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_SAMPLES, rsp->response_type);
+    assert_int_equal(10100LLU, rsp->info.time_range_samples.start);
+    assert_int_equal(100, rsp->info.time_range_samples.length);
+    assert_true(10.199f == ((float *) rsp->data)[99]);
+    req.time.samples.length = 100;
+    assert_int_equal(0, jsdrv_buffer_mgr_read(buffer_mgr_, buffer_id, signal_id, &req, rsp, 50 * sizeof(float)));
+    assert_int_equal(50, rsp->info.time_range_samples.length);  // clipped to fit
+
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = 10100LLU;
+    req.time.samples.end = 10199LLU;
+    req.time.samples.length = 10;
+    assert_int_equal(0, jsdrv_buffer_mgr_read(buffer_mgr_, buffer_id, signal_id, &req, rsp, data_size));
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_SUMMARY, rsp->response_type);
+    assert_int_equal(10, rsp->info.time_range_samples.length);
+    struct jsdrv_summary_entry_s * e = (struct jsdrv_summary_entry_s *) rsp->data;
+    assert_true(10.100f == e[0].min);
+    assert_true(10.109f == e[0].max);
+
+    assert_int_equal(JSDRV_ERROR_NOT_FOUND, jsdrv_buffer_mgr_read(buffer_mgr_, buffer_id, 6, &req, rsp, data_size));
+    assert_int_equal(JSDRV_ERROR_NOT_FOUND, jsdrv_buffer_mgr_read(buffer_mgr_, 4, signal_id, &req, rsp, data_size));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_buffer_mgr_read(buffer_mgr_, buffer_id, 0, &req, rsp, data_size));
+
+    // export all samples to a file, expect progress
+    struct jsdrv_buffer_export_s x;
+    memset(&x, 0, sizeof(x));
+    x.version = 1;
+    x.time_type = JSDRV_TIME_SAMPLES;
+    jsdrv_cstr_copy(x.path, EXPORT_PATH, sizeof(x.path));
+    msg = jsdrvp_msg_alloc_value(context, "m/003/s/005/!export", &jsdrv_union_bin((uint8_t *) &x, sizeof(x)));
+    publish(context, msg);
+    expect_info_any("m/003/s/005/export");
+    msg_send_process_next(context, TIMEOUT_MS);
+    assert_true(0.0f == export_progress_);
+    expect_info_any("m/003/s/005/export");
+    msg_send_process_next(context, TIMEOUT_MS);
+    assert_true(1.0f == export_progress_);
+    check_export_file(10200LLU);  // through the newest sample
+
     // tear down
     msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(signal_id));
     tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_REMOVE);
@@ -476,12 +609,751 @@ static void test_one_signal(void **state) {
     finalize(context);
 }
 
+static void test_info_rate(void **state) {
+    (void) state;
+    struct jsdrvp_msg_s * msg;
+    const uint8_t buffer_id = 3;
+    const uint8_t signal_id = 5;
+    uint8_t ex_list_buffer0[] = {0};
+    uint8_t ex_list_buffer1[] = {buffer_id, 0};
+    uint8_t ex_list_sig0[] = {0};
+    uint8_t ex_list_sig1[] = {signal_id, 0};
+
+    struct jsdrv_context_s * context = initialize();
+    publish(context, jsdrvp_msg_alloc_value(context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, &jsdrv_union_u8(buffer_id)));
+    expect_subscribe("m/003");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_buf_list(ex_list_buffer1, sizeof(ex_list_buffer1));
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(signal_id));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_ADD);
+    publish(context, msg);
+    expect_sig_list(ex_list_sig1, sizeof(ex_list_sig1));
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_str("u/js220/0123456/s/i/!data"));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/s/%03u/topic", buffer_id, signal_id);
+    publish(context, msg);
+    expect_subscribe("u/js220/0123456/s/i/!data");
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u32(1));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_INFO_RATE);
+    publish(context, msg);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u64(1000000LLU));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_SIZE);
+    publish(context, msg);
+
+    // first frame allocates and publishes, the rest coalesce into one update
+    for (uint64_t i = 0; i < 5; ++i) {
+        msg = generate_msg_data_i(context, 10000LLU + i * 100, 100);
+        publish(context, msg);
+        jsdrvp_msg_free(context, msg);
+    }
+    expect_info_any("m/003/s/005/info");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_info_any("m/003/s/005/info");
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    // no further info, so the next message is the request response
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = 10000LLU;
+    req.time.samples.length = 500;
+    jsdrv_cstr_copy(req.rsp_topic, "t/!rsp", sizeof(req.rsp_topic));
+    req.rsp_id = 42;
+    msg = jsdrvp_msg_alloc_value(context, "m/003/s/005/!req", &jsdrv_union_bin((uint8_t *) &req, sizeof(req)));
+    publish(context, msg);
+    expect_rsp_any("t/!rsp");
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(signal_id));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_REMOVE);
+    publish(context, msg);
+    expect_unsubscribe("u/js220/0123456/s/i/!data");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_rsp_any("m/003/s/005/info");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_sig_list(ex_list_sig0, sizeof(ex_list_sig0));
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    publish(context, jsdrvp_msg_alloc_value(context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, &jsdrv_union_u8(buffer_id)));
+    expect_unsubscribe("m/003");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_buf_list(ex_list_buffer0, sizeof(ex_list_buffer0));
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    finalize(context);
+}
+
+static void test_workers(void **state) {
+    (void) state;
+    struct jsdrvp_msg_s * msg;
+    const uint8_t buffer_id = 3;
+    uint8_t ex_list_buffer0[] = {0};
+    uint8_t ex_list_buffer1[] = {buffer_id, 0};
+    uint8_t ex_list_sig0[] = {0};
+    uint8_t ex_list_sig5[] = {5, 0};
+    uint8_t ex_list_sig6[] = {5, 6, 0};
+    uint8_t ex_list_sig6_only[] = {6, 0};
+
+    struct jsdrv_context_s * context = initialize();
+    publish(context, jsdrvp_msg_alloc_value(context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, &jsdrv_union_u8(buffer_id)));
+    expect_subscribe("m/003");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_buf_list(ex_list_buffer1, sizeof(ex_list_buffer1));
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u32(2));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_WORKERS);
+    publish(context, msg);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u32(0));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_INFO_RATE);
+    publish(context, msg);
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(5));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_ADD);
+    publish(context, msg);
+    expect_sig_list(ex_list_sig5, sizeof(ex_list_sig5));
+    msg_send_process_next(context, TIMEOUT_MS);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(6));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_ADD);
+    publish(context, msg);
+    expect_sig_list(ex_list_sig6, sizeof(ex_list_sig6));
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    for (uint32_t signal_id = 5; signal_id <= 6; ++signal_id) {
+        msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_str("u/js220/0123456/s/i/!data"));
+        tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/s/%03u/topic", buffer_id, signal_id);
+        publish(context, msg);
+        expect_subscribe("u/js220/0123456/s/i/!data");
+        msg_send_process_next(context, TIMEOUT_MS);
+    }
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u64(1000000LLU));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_SIZE);
+    publish(context, msg);
+
+    // Both signals share the source topic, so each frame feeds both.
+    // The first frame allocates, the rest ingest on separate workers.
+    msg = generate_msg_data_i(context, 10000LLU, 100);
+    publish(context, msg);
+    jsdrvp_msg_free(context, msg);
+    expect_info_any("m/003/s/005/info");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_info_any("m/003/s/006/info");
+    msg_send_process_next(context, TIMEOUT_MS);
+    for (uint64_t i = 1; i < 4; ++i) {
+        msg = generate_msg_data_i(context, 10000LLU + i * 100, 100);
+        publish(context, msg);
+        expect_any(msg_send_process_next, topic);  // worker order not guaranteed
+        msg_send_process_next(context, TIMEOUT_MS);
+        expect_any(msg_send_process_next, topic);
+        msg_send_process_next(context, TIMEOUT_MS);
+        assert_int_equal(1, msg->refcnt);  // workers released their shared references
+        jsdrvp_msg_free(context, msg);
+    }
+
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = 10000LLU;
+    req.time.samples.length = 400;
+    jsdrv_cstr_copy(req.rsp_topic, "t/!rsp", sizeof(req.rsp_topic));
+    req.rsp_id = 42;
+    msg = jsdrvp_msg_alloc_value(context, "m/003/s/006/!req", &jsdrv_union_bin((uint8_t *) &req, sizeof(req)));
+    publish(context, msg);
+    expect_rsp_any("t/!rsp");
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(5));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_REMOVE);
+    publish(context, msg);
+    expect_unsubscribe("u/js220/0123456/s/i/!data");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_info_any("m/003/s/005/info");  // signal 6 keeps its data
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_sig_list(ex_list_sig6_only, sizeof(ex_list_sig6_only));
+    msg_send_process_next(context, TIMEOUT_MS);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(6));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_REMOVE);
+    publish(context, msg);
+    expect_unsubscribe("u/js220/0123456/s/i/!data");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_info_any("m/003/s/006/info");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_sig_list(ex_list_sig0, sizeof(ex_list_sig0));
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    publish(context, jsdrvp_msg_alloc_value(context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, &jsdrv_union_u8(buffer_id)));
+    expect_unsubscribe("m/003");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_buf_list(ex_list_buffer0, sizeof(ex_list_buffer0));
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    finalize(context);
+}
+
+static struct jsdrvp_msg_s * rsp_pop(struct jsdrv_context_s * context) {
+    struct jsdrvp_msg_s * msg = NULL;
+    char return_code_suffix[2] = {JSDRV_TOPIC_SUFFIX_RETURN_CODE, 0};
+    while (1) {
+        assert_int_equal(0, msg_queue_pop(context->msg_sent, &msg, TIMEOUT_MS));
+        if (jsdrv_cstr_ends_with(msg->topic, "!rsp")) {
+            return msg;
+        }
+        assert_true(jsdrv_cstr_ends_with(msg->topic, return_code_suffix) || jsdrv_cstr_ends_with(msg->topic, "/info")
+                    || jsdrv_cstr_ends_with(msg->topic, "/snap"));
+        jsdrvp_msg_free(context, msg);
+    }
+}
+
+static void req_publish(struct jsdrv_context_s * context, const char * rsp_topic, int64_t rsp_id) {
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = 10000LLU;
+    req.time.samples.end = 10199LLU;
+    req.time.samples.length = 20;
+    jsdrv_cstr_copy(req.rsp_topic, rsp_topic, sizeof(req.rsp_topic));
+    req.rsp_id = rsp_id;
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/s/005/!req", &jsdrv_union_bin((uint8_t *) &req, sizeof(req))));
+}
+
+static int64_t rsp_collect(struct jsdrv_context_s * context, const char * barrier_topic, uint32_t * count) {
+    int64_t rsp_id = -1;
+    *count = 0;
+    while (1) {
+        struct jsdrvp_msg_s * msg = rsp_pop(context);
+        struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) msg->value.value.bin;
+        bool done = (0 == strcmp(barrier_topic, msg->topic));
+        assert_int_equal(JSDRV_BUFFER_RESPONSE_FLAG_FINAL, rsp->flags);
+        assert_int_equal(0, rsp->seq);
+        if (!done) {
+            rsp_id = rsp->rsp_id;
+            ++*count;
+        }
+        jsdrvp_msg_free(context, msg);
+        if (done) {
+            return rsp_id;
+        }
+    }
+}
+
+static void test_req_latest_and_cancel(void **state) {
+    (void) state;
+    struct jsdrvp_msg_s * msg;
+    uint32_t count = 0;
+    const uint8_t buffer_id = 3;
+    const uint8_t signal_id = 5;
+    uint8_t ex_list_buffer0[] = {0};
+    uint8_t ex_list_buffer1[] = {buffer_id, 0};
+    uint8_t ex_list_sig1[] = {signal_id, 0};
+
+    struct jsdrv_context_s * context = initialize();
+    publish(context, jsdrvp_msg_alloc_value(context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, &jsdrv_union_u8(buffer_id)));
+    expect_subscribe("m/003");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_buf_list(ex_list_buffer1, sizeof(ex_list_buffer1));
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(signal_id));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_ADD);
+    publish(context, msg);
+    expect_sig_list(ex_list_sig1, sizeof(ex_list_sig1));
+    msg_send_process_next(context, TIMEOUT_MS);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_str("u/js220/0123456/s/i/!data"));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/s/%03u/topic", buffer_id, signal_id);
+    publish(context, msg);
+    expect_subscribe("u/js220/0123456/s/i/!data");
+    msg_send_process_next(context, TIMEOUT_MS);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(1));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_REQ_LATEST);
+    publish(context, msg);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u64(1000000LLU));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_SIZE);
+    publish(context, msg);
+    for (uint64_t i = 0; i < 2; ++i) {
+        msg = generate_msg_data_i(context, 10000LLU + i * 100, 100);
+        publish(context, msg);
+        jsdrvp_msg_free(context, msg);
+    }
+
+    // Newer requests replace pending ones for the same rsp_topic.
+    for (int64_t rsp_id = 1; rsp_id <= 5; ++rsp_id) {
+        req_publish(context, "t/!rsp", rsp_id);
+    }
+    req_publish(context, "b/!rsp", 100);
+    assert_int_equal(5, rsp_collect(context, "b/!rsp", &count));
+    assert_in_range(count, 1, 5);
+
+    // Cancel removes a pending request
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(0));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_REQ_LATEST);
+    publish(context, msg);
+    req_publish(context, "t/!rsp", 6);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_i64(6));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/s/%03u/!cancel", buffer_id, signal_id);
+    publish(context, msg);
+    req_publish(context, "t/!rsp", 7);
+    req_publish(context, "b/!rsp", 101);
+    assert_int_equal(7, rsp_collect(context, "b/!rsp", &count));
+    assert_in_range(count, 1, 2);  // 6 only if processed before the cancel arrived
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(signal_id));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_REMOVE);
+    publish(context, msg);
+    publish(context, jsdrvp_msg_alloc_value(context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, &jsdrv_union_u8(buffer_id)));
+    while (1) {  // discard the teardown messages through the buffer list
+        assert_int_equal(0, msg_queue_pop(context->msg_sent, &msg, TIMEOUT_MS));
+        bool done = (0 == strcmp(JSDRV_BUFFER_MGR_MSG_ACTION_LIST, msg->topic));
+        if (0 == strcmp(JSDRV_PUBSUB_UNSUBSCRIBE, msg->topic)) {
+            unsubscribe(context, msg);
+        }
+        if (done) {
+            assert_memory_equal(ex_list_buffer0, msg->value.value.bin, sizeof(ex_list_buffer0));
+        }
+        jsdrvp_msg_free(context, msg);
+        if (done) {
+            break;
+        }
+    }
+
+    finalize(context);
+}
+
+static void summary_check(struct jsdrv_context_s * context, uint64_t start, uint64_t incr, uint64_t length) {
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.time.samples.start = start;
+    req.time.samples.end = start + incr * length - 1;
+    req.time.samples.length = length;
+    jsdrv_cstr_copy(req.rsp_topic, "t/!rsp", sizeof(req.rsp_topic));
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/s/005/!req", &jsdrv_union_bin((uint8_t *) &req, sizeof(req))));
+    struct jsdrvp_msg_s * msg = rsp_pop(context);
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) msg->value.value.bin;
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_SUMMARY, rsp->response_type);
+    assert_int_equal(length, rsp->info.time_range_samples.length);
+    struct jsdrv_summary_entry_s * e = (struct jsdrv_summary_entry_s *) rsp->data;
+    for (uint64_t i = 0; i < length; ++i) {
+        assert_float_equal((start + i * incr + (incr - 1) * 0.5) * 0.001, e[i].avg, 1e-3);
+    }
+    jsdrvp_msg_free(context, msg);
+}
+
+static void test_prefetch(void **state) {
+    (void) state;
+    struct jsdrvp_msg_s * msg;
+    const uint8_t buffer_id = 3;
+    const uint8_t signal_id = 5;
+    uint8_t ex_list_buffer0[] = {0};
+    uint8_t ex_list_buffer1[] = {buffer_id, 0};
+    uint8_t ex_list_sig1[] = {signal_id, 0};
+
+    struct jsdrv_context_s * context = initialize();
+    publish(context, jsdrvp_msg_alloc_value(context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, &jsdrv_union_u8(buffer_id)));
+    expect_subscribe("m/003");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_buf_list(ex_list_buffer1, sizeof(ex_list_buffer1));
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(signal_id));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_ADD);
+    publish(context, msg);
+    expect_sig_list(ex_list_sig1, sizeof(ex_list_sig1));
+    msg_send_process_next(context, TIMEOUT_MS);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_str("u/js220/0123456/s/i/!data"));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/s/%03u/topic", buffer_id, signal_id);
+    publish(context, msg);
+    expect_subscribe("u/js220/0123456/s/i/!data");
+    msg_send_process_next(context, TIMEOUT_MS);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u32(64));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_TILE_CACHE);
+    publish(context, msg);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(1));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_PREFETCH);
+    publish(context, msg);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u64(1000000LLU));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_SIZE);
+    publish(context, msg);
+    for (uint64_t i = 0; i < 100; ++i) {
+        msg = generate_msg_data_i(context, i * 1000, 1000);
+        publish(context, msg);
+        jsdrvp_msg_free(context, msg);
+    }
+
+    // Pan, then zoom, while the reader prefetches the adjacent windows.
+    for (uint64_t k = 0; k < 8; ++k) {
+        summary_check(context, 10000 + k * 2000, 20, 100);
+    }
+    summary_check(context, 36000, 40, 100);
+    summary_check(context, 46000, 20, 100);
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(signal_id));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_REMOVE);
+    publish(context, msg);
+    publish(context, jsdrvp_msg_alloc_value(context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, &jsdrv_union_u8(buffer_id)));
+    while (1) {  // discard the teardown messages through the buffer list
+        assert_int_equal(0, msg_queue_pop(context->msg_sent, &msg, TIMEOUT_MS));
+        bool done = (0 == strcmp(JSDRV_BUFFER_MGR_MSG_ACTION_LIST, msg->topic));
+        if (0 == strcmp(JSDRV_PUBSUB_UNSUBSCRIBE, msg->topic)) {
+            unsubscribe(context, msg);
+        }
+        if (done) {
+            assert_memory_equal(ex_list_buffer0, msg->value.value.bin, sizeof(ex_list_buffer0));
+        }
+        jsdrvp_msg_free(context, msg);
+        if (done) {
+            break;
+        }
+    }
+
+    finalize(context);
+}
+
+static void display_publish(struct jsdrv_context_s * context, int64_t rsp_id, float rate) {
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.flags = JSDRV_BUFFER_REQUEST_FLAG_DISPLAY;
+    req.threshold = rate;
+    req.time.samples.start = 0;
+    req.time.samples.end = 9999;
+    req.time.samples.length = 100;
+    jsdrv_cstr_copy(req.rsp_topic, "d/!rsp", sizeof(req.rsp_topic));
+    req.rsp_id = rsp_id;
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/s/005/!req", &jsdrv_union_bin((uint8_t *) &req, sizeof(req))));
+}
+
+static void test_display_rate(void **state) {
+    (void) state;
+    struct jsdrvp_msg_s * msg;
+    uint32_t count = 0;
+    const uint8_t buffer_id = 3;
+    const uint8_t signal_id = 5;
+    uint8_t ex_list_buffer0[] = {0};
+    uint8_t ex_list_buffer1[] = {buffer_id, 0};
+    uint8_t ex_list_sig1[] = {signal_id, 0};
+
+    struct jsdrv_context_s * context = initialize();
+    publish(context, jsdrvp_msg_alloc_value(context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, &jsdrv_union_u8(buffer_id)));
+    expect_subscribe("m/003");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_buf_list(ex_list_buffer1, sizeof(ex_list_buffer1));
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(signal_id));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_ADD);
+    publish(context, msg);
+    expect_sig_list(ex_list_sig1, sizeof(ex_list_sig1));
+    msg_send_process_next(context, TIMEOUT_MS);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_str("u/js220/0123456/s/i/!data"));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/s/%03u/topic", buffer_id, signal_id);
+    publish(context, msg);
+    expect_subscribe("u/js220/0123456/s/i/!data");
+    msg_send_process_next(context, TIMEOUT_MS);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u64(1000000LLU));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_SIZE);
+    publish(context, msg);
+    for (uint64_t i = 0; i < 20; ++i) {
+        msg = generate_msg_data_i(context, i * 1000, 1000);
+        publish(context, msg);
+        jsdrvp_msg_free(context, msg);
+    }
+
+    // Invalid frame rates are ignored, larger rates are limited.
+    display_publish(context, 1, -1.0f);
+    display_publish(context, 2, NAN);
+    display_publish(context, 3, 1e-30f);
+    display_publish(context, 4, 0.5f);
+    display_publish(context, 5, INFINITY);
+    req_publish(context, "b/!rsp", 100);
+    while (1) {
+        msg = rsp_pop(context);
+        struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) msg->value.value.bin;
+        bool done = (0 == strcmp("b/!rsp", msg->topic));
+        if (!done) {
+            assert_string_equal("d/!rsp", msg->topic);
+            assert_int_equal(5, rsp->rsp_id);
+            ++count;
+        }
+        jsdrvp_msg_free(context, msg);
+        if (done) {
+            break;
+        }
+    }
+    assert_int_equal(1, count);  // the initial frame
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(signal_id));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_REMOVE);
+    publish(context, msg);
+    publish(context, jsdrvp_msg_alloc_value(context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, &jsdrv_union_u8(buffer_id)));
+    while (1) {  // discard the teardown messages through the buffer list
+        assert_int_equal(0, msg_queue_pop(context->msg_sent, &msg, TIMEOUT_MS));
+        bool done = (0 == strcmp(JSDRV_BUFFER_MGR_MSG_ACTION_LIST, msg->topic));
+        if (0 == strcmp(JSDRV_PUBSUB_UNSUBSCRIBE, msg->topic)) {
+            unsubscribe(context, msg);
+        }
+        if (done) {
+            assert_memory_equal(ex_list_buffer0, msg->value.value.bin, sizeof(ex_list_buffer0));
+        }
+        jsdrvp_msg_free(context, msg);
+        if (done) {
+            break;
+        }
+    }
+
+    finalize(context);
+}
+
+// Discard messages through the snapshot state.
+static void snap_state_wait(struct jsdrv_context_s * context, uint8_t snap_state) {
+    struct jsdrvp_msg_s * msg = NULL;
+    while (1) {
+        assert_int_equal(0, msg_queue_pop(context->msg_sent, &msg, TIMEOUT_MS));
+        bool done = (0 == strcmp("m/003/" JSDRV_BUFFER_MSG_SNAP_STATE, msg->topic))
+                && (msg->value.value.u8 == snap_state);
+        jsdrvp_msg_free(context, msg);
+        if (done) {
+            return;
+        }
+    }
+}
+
+static uint64_t req_check(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
+                          uint64_t start, uint64_t length) {
+    struct jsdrv_buffer_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.flags = flags;
+    req.time.samples.start = start;
+    req.time.samples.length = length;
+    jsdrv_cstr_copy(req.rsp_topic, "t/!rsp", sizeof(req.rsp_topic));
+    publish(context, jsdrvp_msg_alloc_value(context, topic, &jsdrv_union_bin((uint8_t *) &req, sizeof(req))));
+    struct jsdrvp_msg_s * msg = rsp_pop(context);
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) msg->value.value.bin;
+    assert_int_equal(start, rsp->info.time_range_samples.start);
+    assert_int_equal(length, rsp->info.time_range_samples.length);
+    float * data = (float *) rsp->data;
+    for (uint64_t i = 0; i < length; ++i) {
+        assert_float_equal((start + i) * 0.001f, data[i], 1e-6);
+    }
+    uint64_t size_in_samples = rsp->info.size_in_samples;
+    jsdrvp_msg_free(context, msg);
+    return size_in_samples;
+}
+
+static void snap_req_check(struct jsdrv_context_s * context, uint8_t flags, uint64_t start, uint64_t length) {
+    req_check(context, "m/003/s/005/!req", flags, start, length);
+}
+
+static void test_snapshot(void **state) {
+    (void) state;
+    struct jsdrvp_msg_s * msg;
+    const uint8_t buffer_id = 3;
+    const uint8_t signal_id = 5;
+    uint8_t ex_list_buffer0[] = {0};
+    uint8_t ex_list_buffer1[] = {buffer_id, 0};
+    uint8_t ex_list_sig1[] = {signal_id, 0};
+
+    struct jsdrv_context_s * context = initialize();
+    publish(context, jsdrvp_msg_alloc_value(context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, &jsdrv_union_u8(buffer_id)));
+    expect_subscribe("m/003");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_buf_list(ex_list_buffer1, sizeof(ex_list_buffer1));
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(signal_id));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_ADD);
+    publish(context, msg);
+    expect_sig_list(ex_list_sig1, sizeof(ex_list_sig1));
+    msg_send_process_next(context, TIMEOUT_MS);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_str("u/js220/0123456/s/i/!data"));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/s/%03u/topic", buffer_id, signal_id);
+    publish(context, msg);
+    expect_subscribe("u/js220/0123456/s/i/!data");
+    msg_send_process_next(context, TIMEOUT_MS);
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u64(1000000LLU));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_SIZE);
+    publish(context, msg);
+    for (uint64_t i = 0; i < 3; ++i) {  // the first frame only allocates
+        msg = generate_msg_data_i(context, 10000LLU + i * 100, 100);
+        publish(context, msg);
+        jsdrvp_msg_free(context, msg);
+    }
+
+    // Immediate snapshot, then the live buffer continues.
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/" JSDRV_BUFFER_MSG_SNAP, &jsdrv_union_u8(1)));
+    snap_state_wait(context, 2);
+    msg = generate_msg_data_i(context, 10300LLU, 100);
+    publish(context, msg);
+    jsdrvp_msg_free(context, msg);
+    snap_req_check(context, JSDRV_BUFFER_REQUEST_FLAG_SNAPSHOT, 10100LLU, 200);
+    snap_req_check(context, 0, 10300LLU, 100);
+
+    // Capture 1 ms = 1000 samples after the trigger.
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/" JSDRV_BUFFER_MSG_SNAP_POST, &jsdrv_union_u32(1)));
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/" JSDRV_BUFFER_MSG_SNAP, &jsdrv_union_u8(1)));
+    snap_state_wait(context, 1);
+    for (uint64_t i = 0; i < 10; ++i) {
+        msg = generate_msg_data_i(context, 10400LLU + i * 100, 100);
+        publish(context, msg);
+        jsdrvp_msg_free(context, msg);
+    }
+    snap_state_wait(context, 2);
+    snap_req_check(context, JSDRV_BUFFER_REQUEST_FLAG_SNAPSHOT, 10300LLU, 1100);
+
+    // Reconfiguration discards the snapshot.
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/" JSDRV_BUFFER_MSG_ACTION_CLEAR, &jsdrv_union_u8(1)));
+    snap_state_wait(context, 0);
+
+    msg = jsdrvp_msg_alloc_value(context, "", &jsdrv_union_u8(signal_id));
+    tfp_snprintf(msg->topic, sizeof(msg->topic), "m/%03u/%s", buffer_id, JSDRV_BUFFER_MSG_ACTION_SIGNAL_REMOVE);
+    publish(context, msg);
+    publish(context, jsdrvp_msg_alloc_value(context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, &jsdrv_union_u8(buffer_id)));
+    while (1) {  // discard the teardown messages through the buffer list
+        assert_int_equal(0, msg_queue_pop(context->msg_sent, &msg, TIMEOUT_MS));
+        bool done = (0 == strcmp(JSDRV_BUFFER_MGR_MSG_ACTION_LIST, msg->topic));
+        if (0 == strcmp(JSDRV_PUBSUB_UNSUBSCRIBE, msg->topic)) {
+            unsubscribe(context, msg);
+        }
+        if (done) {
+            assert_memory_equal(ex_list_buffer0, msg->value.value.bin, sizeof(ex_list_buffer0));
+        }
+        jsdrvp_msg_free(context, msg);
+        if (done) {
+            break;
+        }
+    }
+
+    finalize(context);
+}
+
+// Wait for the signal info after its storage is allocated.
+static uint64_t info_alloc_wait(struct jsdrv_context_s * context, const char * topic) {
+    struct jsdrvp_msg_s * msg = NULL;
+    while (1) {
+        assert_int_equal(0, msg_queue_pop(context->msg_sent, &msg, TIMEOUT_MS));
+        uint64_t size_in_samples = 0;
+        if (0 == strcmp(topic, msg->topic)) {
+            size_in_samples = ((struct jsdrv_buffer_info_s *) msg->value.value.bin)->size_in_samples;
+        }
+        jsdrvp_msg_free(context, msg);
+        if (size_in_samples) {
+            return size_in_samples;
+        }
+    }
+}
+
+static void test_add_signal_rebalance(void **state) {
+    (void) state;
+    struct jsdrvp_msg_s * msg;
+    const uint8_t buffer_id = 3;
+    const uint32_t frame = 4000;  // fits the smallest JSDRV_STREAM_DATA_SIZE
+    uint8_t ex_list_buffer0[] = {0};
+    uint8_t ex_list_buffer1[] = {buffer_id, 0};
+    uint8_t ex_list_sig5[] = {5, 0};
+    uint8_t ex_list_sig6[] = {5, 6, 0};
+
+    struct jsdrv_context_s * context = initialize();
+    publish(context, jsdrvp_msg_alloc_value(context, JSDRV_BUFFER_MGR_MSG_ACTION_ADD, &jsdrv_union_u8(buffer_id)));
+    expect_subscribe("m/003");
+    msg_send_process_next(context, TIMEOUT_MS);
+    expect_buf_list(ex_list_buffer1, sizeof(ex_list_buffer1));
+    msg_send_process_next(context, TIMEOUT_MS);
+
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/" JSDRV_BUFFER_MSG_REBALANCE, &jsdrv_union_u8(1)));
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/" JSDRV_BUFFER_MSG_ACTION_SIGNAL_ADD, &jsdrv_union_u8(5)));
+    expect_sig_list(ex_list_sig5, sizeof(ex_list_sig5));
+    msg_send_process_next(context, TIMEOUT_MS);
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/s/005/topic", &jsdrv_union_str("u/js220/0123456/s/i/!data")));
+    expect_subscribe("u/js220/0123456/s/i/!data");
+    msg_send_process_next(context, TIMEOUT_MS);
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/" JSDRV_BUFFER_MSG_SIZE, &jsdrv_union_u64(1000000LLU)));
+
+    // Fill signal 5 past the size that remains after the rebalance.
+    uint64_t sample_id = 10000LLU;
+    for (uint32_t i = 0; i < 52; ++i, sample_id += frame) {
+        msg = generate_msg_data_i(context, sample_id, frame);
+        publish(context, msg);
+        jsdrvp_msg_free(context, msg);
+    }
+    uint64_t n1 = req_check(context, "m/003/s/005/!req", 0, sample_id - 1000, 1000);
+
+    // Add signal 6 with the same source, which allocates on its first data.
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/" JSDRV_BUFFER_MSG_ACTION_SIGNAL_ADD, &jsdrv_union_u8(6)));
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/s/006/topic", &jsdrv_union_str("u/js220/0123456/s/i/!data")));
+    while (1) {
+        assert_int_equal(0, msg_queue_pop(context->msg_sent, &msg, TIMEOUT_MS));
+        bool done = (0 == strcmp(JSDRV_PUBSUB_SUBSCRIBE, msg->topic));
+        if (done) {
+            subscribe(context, msg);
+        } else if (0 == strcmp("m/003/" JSDRV_BUFFER_MSG_LIST, msg->topic)) {
+            assert_memory_equal(ex_list_sig6, msg->value.value.bin, sizeof(ex_list_sig6));
+        }
+        jsdrvp_msg_free(context, msg);
+        if (done) {
+            break;
+        }
+    }
+    msg = generate_msg_data_i(context, sample_id, frame);
+    publish(context, msg);
+    jsdrvp_msg_free(context, msg);
+    sample_id += frame;
+    uint64_t n6 = info_alloc_wait(context, "m/003/s/006/info");
+
+    // Signal 5 shrinks in place and keeps its newest samples.
+    uint64_t n5 = req_check(context, "m/003/s/005/!req", 0, sample_id - 1000, 1000);
+    assert_true(n5 < n1);
+    assert_int_equal(n5, n6);
+    msg = generate_msg_data_i(context, sample_id, frame);
+    publish(context, msg);
+    jsdrvp_msg_free(context, msg);
+    sample_id += frame;
+    req_check(context, "m/003/s/005/!req", 0, sample_id - n5, 1000);
+    req_check(context, "m/003/s/006/!req", 0, sample_id - 1000, 1000);
+
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/" JSDRV_BUFFER_MSG_ACTION_SIGNAL_REMOVE, &jsdrv_union_u8(5)));
+    publish(context, jsdrvp_msg_alloc_value(context, "m/003/" JSDRV_BUFFER_MSG_ACTION_SIGNAL_REMOVE, &jsdrv_union_u8(6)));
+    publish(context, jsdrvp_msg_alloc_value(context, JSDRV_BUFFER_MGR_MSG_ACTION_REMOVE, &jsdrv_union_u8(buffer_id)));
+    while (1) {  // discard the teardown messages through the buffer list
+        assert_int_equal(0, msg_queue_pop(context->msg_sent, &msg, TIMEOUT_MS));
+        bool done = (0 == strcmp(JSDRV_BUFFER_MGR_MSG_ACTION_LIST, msg->topic));
+        if (0 == strcmp(JSDRV_PUBSUB_UNSUBSCRIBE, msg->topic)) {
+            unsubscribe(context, msg);
+        }
+        if (done) {
+            assert_memory_equal(ex_list_buffer0, msg->value.value.bin, sizeof(ex_list_buffer0));
+        }
+        jsdrvp_msg_free(context, msg);
+        if (done) {
+            break;
+        }
+    }
+
+    finalize(context);
+}
 
 int main(void) {
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_initialize_finalize),
             cmocka_unit_test(test_add_remove),
             cmocka_unit_test(test_one_signal),
+            cmocka_unit_test(test_info_rate),
+            cmocka_unit_test(test_workers),
+            cmocka_unit_test(test_req_latest_and_cancel),
+            cmocka_unit_test(test_prefetch),
+            cmocka_unit_test(test_display_rate),
+            cmocka_unit_test(test_snapshot),
+            cmocka_unit_test(test_add_signal_rebalance),
             // test hold
             // test buffer wrap
             // test mode: fill
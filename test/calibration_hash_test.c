@@ -0,0 +1,73 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv.h"
+#include "jsdrv_prv/calibration_hash.h"
+
+
+static const uint32_t HASH_128[16] = {
+        0x7a1634d7U, 0xfd6f60e4U, 0xcec565bbU, 0xbb2f3cceU, 0x9a86996fU, 0xdfd530ddU, 0x2a4342d1U, 0x50c77635U,
+        0x5b190348U, 0xaed9f905U, 0x24cb664eU, 0x31a84671U, 0x796f97dfU, 0x02e43b86U, 0x49cd8abbU, 0x862569f4U,
+};
+
+static void msg_init(uint32_t * msg, uint32_t length_u32) {
+    for (uint32_t i = 0; i < length_u32; ++i) {
+        msg[i] = i * 0x01010101U;
+    }
+}
+
+static void test_hash(void ** state) {
+    (void) state;
+    uint32_t msg[32];
+    uint32_t hash[16];
+    msg_init(msg, 32);
+    jsdrv_calibration_hash(msg, sizeof(msg), hash);
+    assert_memory_equal(HASH_128, hash, sizeof(hash));
+
+    msg[31] ^= 1;
+    jsdrv_calibration_hash(msg, sizeof(msg), hash);
+    assert_memory_not_equal(HASH_128, hash, sizeof(hash));
+}
+
+static void test_incremental(void ** state) {
+    (void) state;
+    uint32_t msg[32];
+    uint32_t hash[16];
+    msg_init(msg, 32);
+    jsdrv_calibration_hash_init(hash);
+    jsdrv_calibration_hash_update(hash, 0, msg, 32);
+    jsdrv_calibration_hash_update(hash, 32, msg + 8, 64);
+    jsdrv_calibration_hash_update(hash, 96, msg + 24, 0);
+    jsdrv_calibration_hash_update(hash, 96, msg + 24, 32);
+    assert_memory_equal(HASH_128, hash, sizeof(hash));
+
+    jsdrv_calibration_hash_init(hash);  // offset matters
+    jsdrv_calibration_hash_update(hash, 32, msg, 128);
+    assert_memory_not_equal(HASH_128, hash, sizeof(hash));
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_hash),
+            cmocka_unit_test(test_incremental),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
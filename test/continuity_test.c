@@ -0,0 +1,79 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include "jsdrv_prv/continuity.h"
+
+
+static void test_counters(void ** state) {
+    (void) state;
+    struct jsdrv_continuity_tracker_s c;
+    memset(&c, 0, sizeof(c));
+    jsdrv_continuity_clear(&c);
+    assert_true(jsdrv_continuity_publish_ready(&c, 100, 1));
+    assert_false(jsdrv_continuity_publish_ready(&c, 100, 2));  // unchanged
+
+    jsdrv_continuity_skip(&c, 1000, 20);
+    jsdrv_continuity_dup(&c, 4);
+    jsdrv_continuity_resync(&c);
+    jsdrv_continuity_drop(&c);
+    assert_false(jsdrv_continuity_publish_ready(&c, 2000, 2));  // rate limited
+    assert_true(jsdrv_continuity_publish_ready(&c, 2000, 1 + JSDRV_CONTINUITY_PUBLISH_INTERVAL));
+    assert_int_equal(1, c.value.version);
+    assert_int_equal(2000, c.value.sample_id);
+    assert_int_equal(1, c.value.skip_count);
+    assert_int_equal(20, c.value.skip_length);
+    assert_int_equal(1, c.value.dup_count);
+    assert_int_equal(4, c.value.dup_length);
+    assert_int_equal(1, c.value.resync_count);
+    assert_int_equal(1, c.value.drop_count);
+    assert_int_equal(1, c.value.gap_count);
+    assert_int_equal(1000, c.value.gaps[0].sample_id);
+    assert_int_equal(20, c.value.gaps[0].length);
+
+    jsdrv_continuity_clear(&c);
+    assert_int_equal(0, c.value.skip_count);
+    assert_int_equal(0, c.value.gap_count);
+    assert_int_equal(2000, c.value.sample_id);
+    assert_true(jsdrv_continuity_publish_ready(&c, 2000, 3));  // clear publishes immediately
+}
+
+static void test_gaps_recent(void ** state) {
+    (void) state;
+    struct jsdrv_continuity_tracker_s c;
+    memset(&c, 0, sizeof(c));
+    jsdrv_continuity_clear(&c);
+    for (uint64_t k = 0; k < (JSDRV_CONTINUITY_GAP_COUNT + 3); ++k) {
+        jsdrv_continuity_skip(&c, k * 100, k + 1);
+    }
+    assert_int_equal(JSDRV_CONTINUITY_GAP_COUNT + 3, c.value.skip_count);
+    assert_int_equal(JSDRV_CONTINUITY_GAP_COUNT, c.value.gap_count);
+    assert_int_equal(300, c.value.gaps[0].sample_id);  // oldest retained
+    assert_int_equal((JSDRV_CONTINUITY_GAP_COUNT + 2) * 100, c.value.gaps[JSDRV_CONTINUITY_GAP_COUNT - 1].sample_id);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_counters),
+            cmocka_unit_test(test_gaps_recent),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
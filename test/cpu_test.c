@@ -0,0 +1,84 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdlib.h>
+#include <string.h>
+#include "jsdrv_prv/cpu.h"
+#include "jsdrv_prv/simd_f32.h"
+#include "jsdrv/error_code.h"
+
+
+static void test_mask(void ** state) {
+    (void) state;
+    uint32_t mask = 0;
+    assert_int_equal(0, jsdrv_cpu_mask(NULL, &mask));
+    assert_int_equal(~0U, mask);
+    assert_int_equal(0, jsdrv_cpu_mask("scalar", &mask));
+    assert_int_equal(0, mask);
+    assert_int_equal(0, jsdrv_cpu_mask("AVX2", &mask));
+    assert_int_equal(JSDRV_CPU_SSE2 | JSDRV_CPU_SSE42 | JSDRV_CPU_AVX2, mask);
+    assert_int_equal(0, jsdrv_cpu_mask("neon", &mask));
+    assert_int_equal(JSDRV_CPU_NEON, mask);
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_cpu_mask("mmx", &mask));
+}
+
+static void test_detect(void ** state) {
+    (void) state;
+    uint32_t f = jsdrv_cpu_detect();
+#if defined(__x86_64__) || defined(_M_X64)
+    assert_true(f & JSDRV_CPU_SSE2);  // required by x86-64
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    assert_true(f & JSDRV_CPU_NEON);
+#endif
+    if (f & JSDRV_CPU_AVX512) {
+        assert_true(f & JSDRV_CPU_AVX2);
+    }
+}
+
+static void test_to_str(void ** state) {
+    (void) state;
+    char str[64];
+    jsdrv_cpu_features_to_str(0, str, sizeof(str));
+    assert_string_equal("scalar", str);
+    jsdrv_cpu_features_to_str(JSDRV_CPU_SSE2 | JSDRV_CPU_AVX2, str, sizeof(str));
+    assert_string_equal("sse2 avx2", str);
+}
+
+static void test_env(void ** state) {
+    (void) state;
+#if _WIN32
+    _putenv_s(JSDRV_CPU_ENV, "scalar");
+#else
+    setenv(JSDRV_CPU_ENV, "scalar", 1);
+#endif
+    assert_int_equal(0, jsdrv_cpu_features());  // first call reads the environment
+    assert_string_equal("scalar", jsdrv_f32_impl());
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_mask),
+            cmocka_unit_test(test_detect),
+            cmocka_unit_test(test_to_str),
+            cmocka_unit_test(test_env),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -35,6 +35,8 @@ static void test_passthrough_f32(void **state) {
     d = jsdrv_downsample_alloc(1000000, 1000000, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND);
     assert_non_null(d);
     assert_int_equal(1, jsdrv_downsample_decimate_factor(d));
+    assert_int_equal(0, jsdrv_downsample_sample_delay(d));
+    assert_int_equal(0, jsdrv_downsample_sample_delay(NULL));
     assert_true(jsdrv_downsample_add_f32(d, 1000, 1.0f, &y));
     assert_float_equal(y, 1.0f, 1e-5);
     assert_true(jsdrv_downsample_add_f32(d, 1001, 2.0f, &y));
@@ -49,6 +51,7 @@ static void test_basic_x2_f32(void **state) {
     d = jsdrv_downsample_alloc(1000000, 500000, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND);
     assert_non_null(d);
     assert_int_equal(2, jsdrv_downsample_decimate_factor(d));
+    assert_true(jsdrv_downsample_sample_delay(d) > 0);
     assert_false(jsdrv_downsample_add_f32(d, 1000, 1.0f, &y));
     assert_true(jsdrv_downsample_add_f32(d, 1001, 1.0f, &y));
     assert_float_equal(y, 1.0, 1e-5);
@@ -151,6 +154,413 @@ static void test_filt1_u8(void **state) {
     jsdrv_downsample_free(d);
 }
 
+static void check_block_matches(uint32_t sample_rate_in, uint32_t sample_rate_out, int mode) {
+    float x[4000];
+    float y1[4000];
+    float y2[4000];
+    uint32_t n1 = 0;
+    uint32_t n2 = 0;
+    uint32_t n_out = 0;
+    uint64_t sample_id = 7;  // unaligned
+    struct jsdrv_downsample_s * d1 = jsdrv_downsample_alloc(sample_rate_in, sample_rate_out, mode);
+    struct jsdrv_downsample_s * d2 = jsdrv_downsample_alloc(sample_rate_in, sample_rate_out, mode);
+    assert_non_null(d1);
+    assert_non_null(d2);
+    for (uint32_t i = 0; i < 4000; ++i) {
+        x[i] = (float) ((i * 37) % 101) * 0.01f;
+    }
+    x[1500] = NAN;
+
+    for (uint32_t i = 0; i < 4000; ++i) {
+        if (jsdrv_downsample_add_f32(d1, sample_id + i, x[i], &y1[n1])) {
+            ++n1;
+        }
+    }
+    for (uint32_t i = 0; i < 4000; i += 333) {  // uneven blocks
+        uint32_t k = ((i + 333) > 4000) ? (4000 - i) : 333;
+        jsdrv_downsample_add_f32_block(d2, sample_id + i, x + i, k, y2 + n2, &n_out);
+        n2 += n_out;
+    }
+    assert_int_equal(n1, n2);
+    assert_true(n1 > 0);
+    for (uint32_t i = 0; i < n1; ++i) {
+        if (isnan(y1[i])) {
+            assert_true(isnan(y2[i]));
+        } else {
+            assert_float_equal(y1[i], y2[i], 0.0);
+        }
+    }
+    jsdrv_downsample_free(d1);
+    jsdrv_downsample_free(d2);
+}
+
+static void test_block_f32(void **state) {
+    (void) state;
+    check_block_matches(1000000, 500000, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND);
+    check_block_matches(1000000, 20000, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND);
+    check_block_matches(2000000, 10000, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND);
+    check_block_matches(1000000, 10000, JSDRV_DOWNSAMPLE_MODE_AVERAGE);
+}
+
+static void test_block_passthrough_f32(void **state) {
+    (void) state;
+    float x[] = {1.0f, 2.0f, 3.0f};
+    float y[3] = {0.0f, 0.0f, 0.0f};
+    uint32_t n_out = 0;
+    jsdrv_downsample_add_f32_block(NULL, 0, x, 3, y, &n_out);
+    assert_int_equal(3, n_out);
+    assert_float_equal(3.0f, y[2], 0.0);
+}
+
+static void test_block_u8(void **state) {
+    (void) state;
+    uint8_t x[4000];
+    uint8_t y1[4000];
+    uint8_t y2[4000];
+    uint32_t n1 = 0;
+    uint32_t n2 = 0;
+    uint32_t n_out = 0;
+    struct jsdrv_downsample_s * d1 = jsdrv_downsample_alloc(2000000, 20000, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND);
+    struct jsdrv_downsample_s * d2 = jsdrv_downsample_alloc(2000000, 20000, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND);
+    assert_non_null(d1);
+    assert_non_null(d2);
+    for (uint32_t i = 0; i < 4000; ++i) {
+        x[i] = (uint8_t) ((i / 250) & 0x0f);
+    }
+    for (uint32_t i = 0; i < 4000; ++i) {
+        if (jsdrv_downsample_add_u8(d1, i, x[i], &y1[n1])) {
+            ++n1;
+        }
+    }
+    for (uint32_t i = 0; i < 4000; i += 126) {  // JS110 frame size
+        uint32_t k = ((i + 126) > 4000) ? (4000 - i) : 126;
+        jsdrv_downsample_add_u8_block(d2, i, x + i, k, y2 + n2, &n_out);
+        n2 += n_out;
+    }
+    assert_int_equal(40, n1);
+    assert_int_equal(n1, n2);
+    assert_memory_equal(y1, y2, n1);
+    jsdrv_downsample_free(d1);
+    jsdrv_downsample_free(d2);
+
+    jsdrv_downsample_add_u8_block(NULL, 0, x, 300, y2, &n_out);
+    assert_int_equal(300, n_out);
+    assert_memory_equal(x, y2, 300);
+}
+
+static void test_majority_u8(void **state) {
+    (void) state;
+    uint8_t x[1000];
+    uint8_t y[1000];
+    uint8_t z = 0;
+    uint32_t n_out = 0;
+    struct jsdrv_downsample_s * d = jsdrv_downsample_alloc(1000000, 10000, JSDRV_DOWNSAMPLE_MODE_MAJORITY);
+    assert_non_null(d);
+    assert_int_equal(100, jsdrv_downsample_decimate_factor(d));
+    for (uint32_t i = 0; i < 1000; ++i) {
+        uint32_t k = i % 100;
+        x[i] = (k < 30) ? 3 : ((k < 70) ? 5 : 7);
+    }
+    x[150] = 0x13;  // upper nibble ignored
+    jsdrv_downsample_add_u8_block(d, 50, x + 50, 950, y, &n_out);  // starts unaligned
+    assert_int_equal(9, n_out);
+    for (uint32_t i = 0; i < n_out; ++i) {
+        assert_int_equal(5, y[i]);
+    }
+
+    jsdrv_downsample_clear(d);
+    for (uint32_t i = 0; i < 100; ++i) {  // tie resolves to smallest
+        assert_int_equal((i == 99), jsdrv_downsample_add_u8(d, i, (i & 1) ? 6 : 2, &z));
+    }
+    assert_int_equal(2, z);
+    jsdrv_downsample_free(d);
+}
+
+static void check_mc_matches(uint32_t sample_rate_in, uint32_t sample_rate_out, int mode) {
+    enum {N = 20000, C = 3};
+    static float x[C][N];
+    static float y1[C][N];
+    static float y2[C][N];
+    uint32_t n1 = 0;
+    uint32_t n2 = 0;
+    uint32_t n_out = 0;
+    struct jsdrv_downsample_mc_s * mc = jsdrv_downsample_mc_alloc(sample_rate_in, sample_rate_out, mode, C);
+    assert_non_null(mc);
+    for (uint32_t c = 0; c < C; ++c) {
+        for (uint32_t i = 0; i < N; ++i) {
+            x[c][i] = (float) (sin(0.001 * (c + 1) * i) + 0.25 * c);
+        }
+    }
+    x[1][7000] = NAN;
+    for (uint32_t c = 0; c < C; ++c) {
+        struct jsdrv_downsample_s * d = jsdrv_downsample_alloc(sample_rate_in, sample_rate_out, mode);
+        assert_int_equal(jsdrv_downsample_decimate_factor(d), jsdrv_downsample_mc_decimate_factor(mc));
+        assert_int_equal(jsdrv_downsample_sample_delay(d), jsdrv_downsample_mc_sample_delay(mc));
+        jsdrv_downsample_add_f32_block(d, 3, x[c] + 3, N - 3, y1[c], &n1);  // starts unaligned
+        jsdrv_downsample_free(d);
+    }
+    const float * xp[C];
+    float * yp[C];
+    for (uint32_t i = 3; i < N; i += 126) {
+        uint32_t k = ((i + 126) > N) ? (N - i) : 126;
+        for (uint32_t c = 0; c < C; ++c) {
+            xp[c] = x[c] + i;
+            yp[c] = y2[c] + n2;
+        }
+        jsdrv_downsample_mc_add_f32_block(mc, i, xp, k, yp, &n_out);
+        n2 += n_out;
+    }
+    assert_true(n1 > 0);
+    assert_int_equal(n1, n2);
+    for (uint32_t c = 0; c < C; ++c) {
+        for (uint32_t i = 0; i < n1; ++i) {
+            if (isnan(y1[c][i])) {
+                assert_true(isnan(y2[c][i]));
+            } else {
+                assert_float_equal(y1[c][i], y2[c][i], 0.0);
+            }
+        }
+    }
+    jsdrv_downsample_mc_free(mc);
+}
+
+static void test_mc_f32(void **state) {
+    (void) state;
+    check_mc_matches(1000000, 1000000, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND);
+    check_mc_matches(1000000, 500000, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND);
+    check_mc_matches(2000000, 10000, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND);
+    check_mc_matches(1000000, 10000, JSDRV_DOWNSAMPLE_MODE_AVERAGE);
+
+    float x[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+    float * y[] = {x};
+    const float * xp[] = {x};
+    uint32_t n_out = 0;
+    struct jsdrv_downsample_mc_s * mc = jsdrv_downsample_mc_alloc(1000000, 500000, JSDRV_DOWNSAMPLE_MODE_AVERAGE, 1);
+    jsdrv_downsample_mc_add_f32_block(mc, 0, xp, 4, y, &n_out);  // in place
+    assert_int_equal(2, n_out);
+    assert_float_equal(1.5f, x[0], 1e-6);
+    assert_float_equal(3.5f, x[1], 1e-6);
+    jsdrv_downsample_mc_clear(mc);
+    jsdrv_downsample_mc_free(mc);
+
+    assert_null(jsdrv_downsample_mc_alloc(1000000, 1000, JSDRV_DOWNSAMPLE_MODE_AVERAGE, 0));
+    assert_null(jsdrv_downsample_mc_alloc(1000000, 1000, JSDRV_DOWNSAMPLE_MODE_AVERAGE,
+                                          JSDRV_DOWNSAMPLE_MC_CHANNELS_MAX + 1));
+    assert_null(jsdrv_downsample_mc_alloc(12000, 1000, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND, 1));
+}
+
+// The RMS amplitude of a full scale tone after settling, as a fraction of full scale.
+static double tone_amplitude(int mode, uint32_t sample_rate_out, double freq) {
+    const uint32_t sample_rate_in = 1000000;
+    float y = 0.0f;
+    double sum = 0.0;
+    uint32_t count = 0;
+    struct jsdrv_downsample_s * d = jsdrv_downsample_alloc(sample_rate_in, sample_rate_out, mode);
+    assert_non_null(d);
+    for (uint32_t i = 0; i < sample_rate_in; ++i) {
+        float x = (float) sin(2.0 * M_PI * freq * i / sample_rate_in);
+        if (jsdrv_downsample_add_f32(d, i, x, &y) && (i >= (sample_rate_in / 2))) {  // skip settling
+            sum += (double) y * y;
+            ++count;
+        }
+    }
+    jsdrv_downsample_free(d);
+    return sqrt(2.0 * sum / count);
+}
+
+static void test_stage_order_response(void **state) {
+    (void) state;
+    // 1000 = 5^3 * 2^3 and 10000 = 5^2 * 2^2
+    assert_float_equal(1.0, tone_amplitude(JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND, 1000, 100.0), 0.02);
+    assert_true(tone_amplitude(JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND, 1000, 900.0) < 0.001);  // aliases to 100 Hz
+    assert_float_equal(1.0, tone_amplitude(JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND, 10000, 1000.0), 0.02);
+    assert_true(tone_amplitude(JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND, 10000, 9000.0) < 0.001);  // aliases to 1 kHz
+}
+
+static void test_cic_response(void **state) {
+    (void) state;
+    const int cic = JSDRV_DOWNSAMPLE_MODE_CIC;
+    const int comp = JSDRV_DOWNSAMPLE_MODE_CIC_COMPENSATED;
+    assert_float_equal(1.0, tone_amplitude(cic, 1000, 10.0), 0.002);
+    assert_float_equal(0.819, tone_amplitude(cic, 1000, 200.0), 0.005);  // sinc^3 droop
+    assert_true(tone_amplitude(cic, 1000, 1010.0) < 0.001);  // aliases to 10 Hz
+    assert_float_equal(1.0, tone_amplitude(comp, 1000, 10.0), 0.002);
+    assert_float_equal(1.0, tone_amplitude(comp, 1000, 200.0), 0.01);
+    assert_true(tone_amplitude(comp, 1000, 1010.0) < 0.001);
+}
+
+static void test_cic(void **state) {
+    (void) state;
+    float x[20000];
+    float y1[200];
+    float y2[200];
+    uint32_t n1 = 0;
+    uint32_t n2 = 0;
+    uint32_t n_out = 0;
+    struct jsdrv_downsample_s * d1 = jsdrv_downsample_alloc(1000000, 10000, JSDRV_DOWNSAMPLE_MODE_CIC);
+    struct jsdrv_downsample_s * d2 = jsdrv_downsample_alloc(1000000, 10000, JSDRV_DOWNSAMPLE_MODE_CIC_COMPENSATED);
+    assert_non_null(d1);
+    assert_non_null(d2);
+    assert_int_equal(100, jsdrv_downsample_decimate_factor(d1));
+    assert_int_equal(148, jsdrv_downsample_sample_delay(d1));
+    assert_int_equal(248, jsdrv_downsample_sample_delay(d2));
+    for (uint32_t i = 0; i < 20000; ++i) {
+        x[i] = 0.75f;
+    }
+    x[10095] = NAN;  // sample_id 10105
+    for (uint32_t i = 0; i < 20000; ++i) {
+        if (jsdrv_downsample_add_f32(d1, 10 + i, x[i], &y1[n1])) {
+            ++n1;
+        }
+    }
+    for (uint32_t i = 0; i < 20000; i += 126) {  // frame size
+        uint32_t k = ((i + 126) > 20000) ? (20000 - i) : 126;
+        jsdrv_downsample_add_f32_block(d2, 10 + i, x + i, k, y2 + n2, &n_out);
+        n2 += n_out;
+    }
+    assert_int_equal(199, n1);  // aligned to sample_id 100
+    assert_int_equal(n1, n2);
+    for (uint32_t i = 0; i < n1; ++i) {
+        if ((i >= 100) && (i <= 102)) {  // the NaN at output 100 and the 3 stage impulse response
+            assert_true(isnan(y1[i]));
+        } else {
+            assert_float_equal(0.75f, y1[i], 0.0);
+        }
+        if ((i >= 100) && (i <= 104)) {  // and the compensation FIR
+            assert_true(isnan(y2[i]));
+        } else {
+            assert_float_equal(0.75f, y2[i], 0.0);
+        }
+    }
+
+    jsdrv_downsample_clear(d1);
+    uint8_t z = 0;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        if (jsdrv_downsample_add_u8(d1, i, 3, &z)) {
+            assert_int_equal(3, z);
+            ++count;
+        }
+    }
+    assert_int_equal(10, count);
+    jsdrv_downsample_free(d1);
+    jsdrv_downsample_free(d2);
+
+    // 1 Msps to 1 sps, which settles after 3 outputs
+    d1 = jsdrv_downsample_alloc(1000000, 1, JSDRV_DOWNSAMPLE_MODE_CIC);
+    assert_non_null(d1);
+    for (uint32_t k = 0; k < 20000; ++k) {
+        x[k] = (k & 1) ? 7.5f : -0.5f;
+    }
+    x[0] = -8.0f;  // offset from the mean
+    n1 = 0;
+    for (uint32_t i = 0; i < 200; ++i) {
+        jsdrv_downsample_add_f32_block(d1, i * 20000, x, 20000, y1 + n1, &n_out);
+        n1 += n_out;
+        x[0] = -0.5f;
+    }
+    assert_int_equal(4, n1);
+    assert_float_equal(3.5f, y1[3], 1e-6);
+    jsdrv_downsample_free(d1);
+
+    assert_null(jsdrv_downsample_alloc(3000000, 1, JSDRV_DOWNSAMPLE_MODE_CIC));  // decimate factor > 2^21
+    assert_null(jsdrv_downsample_mc_alloc(1000000, 1000, JSDRV_DOWNSAMPLE_MODE_CIC, 1));
+}
+
+// The RMS amplitude of a full scale tone after settling, as a fraction of full scale.
+static double rational_tone_amplitude(uint32_t sample_rate_in, uint32_t sample_rate_out, double freq) {
+    static float x[2000000];
+    static float y[2000000];
+    uint32_t n_out = 0;
+    double sum = 0.0;
+    struct jsdrv_downsample_s * d = jsdrv_downsample_alloc(sample_rate_in, sample_rate_out,
+                                                           JSDRV_DOWNSAMPLE_MODE_RATIONAL);
+    assert_non_null(d);
+    for (uint32_t i = 0; i < sample_rate_in; ++i) {
+        x[i] = (float) sin(2.0 * M_PI * freq * i / sample_rate_in);
+    }
+    jsdrv_downsample_add_f32_block(d, 0, x, sample_rate_in, y, &n_out);
+    assert_int_equal(sample_rate_out, n_out);
+    for (uint32_t i = n_out / 2; i < n_out; ++i) {  // skip settling
+        sum += (double) y[i] * y[i];
+    }
+    jsdrv_downsample_free(d);
+    return sqrt(2.0 * sum / (n_out - n_out / 2));
+}
+
+static void test_rational_response(void **state) {
+    (void) state;
+    assert_float_equal(1.0, rational_tone_amplitude(2000000, 48000, 1000.0), 0.01);
+    assert_float_equal(1.0, rational_tone_amplitude(2000000, 48000, 18000.0), 0.01);
+    assert_true(rational_tone_amplitude(2000000, 48000, 30000.0) < 0.001);  // aliases to 18 kHz
+    assert_float_equal(1.0, rational_tone_amplitude(2000000, 44100, 1000.0), 0.01);
+    assert_true(rational_tone_amplitude(2000000, 44100, 60000.0) < 0.001);
+    assert_float_equal(1.0, rational_tone_amplitude(1000000, 300000, 10000.0), 0.01);
+}
+
+static void test_rational(void **state) {
+    (void) state;
+    float x[10000];
+    float y1[10000];
+    float y2[10000];
+    uint32_t n1 = 0;
+    uint32_t n2 = 0;
+    uint32_t n_out = 0;
+    struct jsdrv_downsample_s * d1 = jsdrv_downsample_alloc(2000000, 48000, JSDRV_DOWNSAMPLE_MODE_RATIONAL);
+    struct jsdrv_downsample_s * d2 = jsdrv_downsample_alloc(2000000, 48000, JSDRV_DOWNSAMPLE_MODE_RATIONAL);
+    assert_non_null(d1);
+    assert_non_null(d2);
+    assert_int_equal(0, jsdrv_downsample_decimate_factor(d1));
+    assert_true(jsdrv_downsample_sample_delay(d1) > 0);
+    for (uint32_t i = 0; i < 10000; ++i) {
+        x[i] = 0.75f;
+    }
+    x[9000] = NAN;
+    for (uint32_t i = 0; i < 10000; ++i) {
+        if (jsdrv_downsample_add_f32(d1, 10 + i, x[i], &y1[n1])) {
+            ++n1;
+        }
+    }
+    for (uint32_t i = 0; i < 10000; i += 126) {  // frame size
+        uint32_t k = ((i + 126) > 10000) ? (10000 - i) : 126;
+        jsdrv_downsample_add_f32_block(d2, 10 + i, x + i, k, y2 + n2, &n_out);
+        n2 += n_out;
+    }
+    assert_int_equal(n1, n2);
+    assert_int_equal(235, n1);  // 9760 inputs from the aligned sample_id 250, 24 outputs per 1000
+    bool has_nan = false;
+    for (uint32_t i = 0; i < n1; ++i) {
+        if (isnan(y1[i])) {
+            has_nan = true;
+            assert_true(isnan(y2[i]));
+        } else {
+            assert_float_equal(0.75f, y1[i], 1e-5);
+            assert_float_equal(y1[i], y2[i], 0.0);
+        }
+    }
+    assert_true(has_nan);
+
+    jsdrv_downsample_clear(d1);
+    uint8_t z = 0;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        if (jsdrv_downsample_add_u8(d1, i, 3, &z)) {
+            assert_int_equal(3, z);
+            ++count;
+        }
+    }
+    assert_int_equal(24, count);
+    jsdrv_downsample_free(d1);
+    jsdrv_downsample_free(d2);
+
+    d1 = jsdrv_downsample_alloc(2000000, 1000, JSDRV_DOWNSAMPLE_MODE_RATIONAL);  // integer ratio
+    assert_int_equal(2000, jsdrv_downsample_decimate_factor(d1));
+    jsdrv_downsample_free(d1);
+    assert_null(jsdrv_downsample_alloc(2000000, 1999999, JSDRV_DOWNSAMPLE_MODE_RATIONAL));
+    assert_null(jsdrv_downsample_alloc(1000, 2000, JSDRV_DOWNSAMPLE_MODE_RATIONAL));
+    assert_null(jsdrv_downsample_alloc(1000, 0, JSDRV_DOWNSAMPLE_MODE_RATIONAL));
+}
+
 static void test_invalid_args(void **state) {
     (void) state;
     assert_null(jsdrv_downsample_alloc(1000000, 2000000, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND));
@@ -168,6 +578,16 @@ int main(void) {
             cmocka_unit_test(test_filt1_f32),
             cmocka_unit_test(test_filt1_f32_nan),
             cmocka_unit_test(test_filt1_u8),
+            cmocka_unit_test(test_block_f32),
+            cmocka_unit_test(test_block_passthrough_f32),
+            cmocka_unit_test(test_block_u8),
+            cmocka_unit_test(test_majority_u8),
+            cmocka_unit_test(test_mc_f32),
+            cmocka_unit_test(test_stage_order_response),
+            cmocka_unit_test(test_cic_response),
+            cmocka_unit_test(test_cic),
+            cmocka_unit_test(test_rational_response),
+            cmocka_unit_test(test_rational),
             cmocka_unit_test(test_invalid_args),
     };
 
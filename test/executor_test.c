@@ -0,0 +1,178 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv.h"
+#include "jsdrv_prv/atomic.h"
+#include "jsdrv_prv/executor.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/list.h"
+#include "jsdrv_prv/msg_queue.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv/time.h"
+#include <string.h>
+
+
+#define WAIT_MS (2000U)
+#define MSG_COUNT (1000U)
+
+struct task_s {
+    struct jsdrv_executor_task_s * task;
+    volatile int32_t count;
+    volatile int32_t running;
+    volatile int32_t overlap;
+    int32_t timer_runs;             // return a timer for the first runs
+    uint32_t sleep_ms;              // delay in each run
+    struct msg_queue_s * q;         // drain when not NULL
+    volatile int32_t msgs;
+};
+
+static int32_t task_fn(void * user_data) {
+    struct task_s * t = (struct task_s *) user_data;
+    if (1 != jsdrv_atomic_add(&t->running, 1)) {
+        jsdrv_atomic_add(&t->overlap, 1);
+    }
+    if (t->sleep_ms) {
+        jsdrv_thread_sleep_ms(t->sleep_ms);
+    }
+    if (t->q) {
+        struct jsdrvp_msg_s * msg;
+        while (NULL != (msg = msg_queue_pop_immediate(t->q))) {
+            jsdrv_free(msg);
+            jsdrv_atomic_add(&t->msgs, 1);
+        }
+    }
+    int32_t count = jsdrv_atomic_add(&t->count, 1);
+    jsdrv_atomic_add(&t->running, -1);
+    return (count <= t->timer_runs) ? 5 : -1;
+}
+
+static bool wait_for(volatile int32_t * value, int32_t expect) {
+    uint32_t t_start = jsdrv_time_ms_u32();
+    while (jsdrv_atomic_load(value) < expect) {
+        if ((jsdrv_time_ms_u32() - t_start) > WAIT_MS) {
+            return false;
+        }
+        jsdrv_thread_sleep_ms(1);
+    }
+    return true;
+}
+
+static void test_signal(void ** state) {
+    (void) state;
+    struct jsdrv_executor_s * ex = jsdrv_executor_initialize(2);
+    assert_non_null(ex);
+    assert_int_equal(2, jsdrv_executor_thread_count(ex));
+    struct task_s t = {0};
+    t.task = jsdrv_executor_task_add(ex, task_fn, &t);
+    assert_true(wait_for(&t.count, 1));  // runs once on add
+    jsdrv_thread_sleep_ms(20);
+    assert_int_equal(1, t.count);
+    jsdrv_executor_task_signal(t.task);
+    assert_true(wait_for(&t.count, 2));
+    jsdrv_executor_task_remove(t.task);
+    jsdrv_executor_finalize(ex);
+}
+
+static void test_timer(void ** state) {
+    (void) state;
+    struct jsdrv_executor_s * ex = jsdrv_executor_initialize(1);
+    struct task_s t = {.timer_runs = 3};
+    t.task = jsdrv_executor_task_add(ex, task_fn, &t);
+    assert_true(wait_for(&t.count, 4));
+    jsdrv_thread_sleep_ms(30);
+    assert_int_equal(4, t.count);  // no timer after the last run
+    jsdrv_executor_task_remove(t.task);
+    jsdrv_executor_finalize(ex);
+}
+
+static void test_signal_while_running(void ** state) {
+    (void) state;
+    struct jsdrv_executor_s * ex = jsdrv_executor_initialize(4);
+    struct task_s t = {.sleep_ms = 20};
+    t.task = jsdrv_executor_task_add(ex, task_fn, &t);
+    jsdrv_thread_sleep_ms(5);
+    for (int i = 0; i < 10; ++i) {
+        jsdrv_executor_task_signal(t.task);
+    }
+    assert_true(wait_for(&t.count, 2));
+    jsdrv_executor_task_remove(t.task);  // waits for any run in progress
+    assert_int_equal(0, t.running);
+    assert_int_equal(0, t.overlap);
+    jsdrv_executor_finalize(ex);
+}
+
+static void test_many_tasks(void ** state) {
+    (void) state;
+    struct jsdrv_executor_s * ex = jsdrv_executor_initialize(4);
+    struct task_s t[16];
+    memset(t, 0, sizeof(t));
+    for (uint32_t idx = 0; idx < 16; ++idx) {
+        t[idx].task = jsdrv_executor_task_add(ex, task_fn, &t[idx]);
+    }
+    for (uint32_t k = 0; k < 100; ++k) {
+        for (uint32_t idx = 0; idx < 16; ++idx) {
+            jsdrv_executor_task_signal(t[idx].task);
+        }
+    }
+    for (uint32_t idx = 0; idx < 16; ++idx) {
+        assert_true(wait_for(&t[idx].count, 1));  // signals coalesce while ready
+        jsdrv_executor_task_signal(t[idx].task);
+    }
+    for (uint32_t idx = 0; idx < 16; ++idx) {
+        assert_true(wait_for(&t[idx].count, 2));
+        jsdrv_executor_task_remove(t[idx].task);
+        assert_int_equal(0, t[idx].overlap);
+    }
+    jsdrv_executor_finalize(ex);
+}
+
+static void test_msg_queue_notify(void ** state) {
+    (void) state;
+    struct jsdrv_executor_s * ex = jsdrv_executor_initialize(2);
+    struct msg_queue_s * queues[] = {msg_queue_init(), msg_queue_init_spsc(MSG_QUEUE_SPSC_CAPACITY_DEFAULT)};
+    for (uint32_t q_idx = 0; q_idx < 2; ++q_idx) {
+        struct task_s t = {.q = queues[q_idx]};
+        t.task = jsdrv_executor_task_add(ex, task_fn, &t);
+        msg_queue_notify_set(t.q, jsdrv_executor_task_signal, t.task);
+        for (uint32_t idx = 0; idx < MSG_COUNT; ++idx) {
+            struct jsdrvp_msg_s * msg = jsdrv_alloc_clr(sizeof(struct jsdrvp_msg_s));
+            jsdrv_list_initialize(&msg->item);
+            msg_queue_push(t.q, msg);
+        }
+        assert_true(wait_for(&t.msgs, MSG_COUNT));
+        msg_queue_notify_set(t.q, NULL, NULL);
+        jsdrv_executor_task_remove(t.task);
+        msg_queue_finalize(t.q);
+    }
+    jsdrv_executor_finalize(ex);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_signal),
+            cmocka_unit_test(test_timer),
+            cmocka_unit_test(test_signal_while_running),
+            cmocka_unit_test(test_many_tasks),
+            cmocka_unit_test(test_msg_queue_notify),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
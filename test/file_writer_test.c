@@ -0,0 +1,173 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "jsdrv_prv/file_writer.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv/error_code.h"
+
+
+#define PATH "file_writer_test.bin"
+#define TOTAL_SIZE (1000000U)
+
+static uint8_t data_[TOTAL_SIZE];
+
+static void data_fill(void) {
+    uint32_t lfsr = 0x1234U;
+    for (uint32_t i = 0; i < TOTAL_SIZE; ++i) {
+        lfsr = (lfsr * 1103515245U) + 12345U;
+        data_[i] = (uint8_t) (lfsr >> 16);
+    }
+}
+
+static void file_check(uint32_t size) {
+    FILE * f = fopen(PATH, "rb");
+    assert_non_null(f);
+    fseek(f, 0, SEEK_END);
+    assert_int_equal(size, ftell(f));
+    fseek(f, 0, SEEK_SET);
+    uint8_t * buf = malloc(size + 1);
+    assert_int_equal(size, fread(buf, 1, size + 1, f));
+    fclose(f);
+    assert_memory_equal(data_, buf, size);
+    free(buf);
+    remove(PATH);
+}
+
+// Write data_ in varying sizes, retrying when the writer falls behind.
+static void write_all(struct jsdrv_file_writer_s * w) {
+    uint32_t offset = 0;
+    uint32_t k = 0;
+    while (offset < TOTAL_SIZE) {
+        uint32_t sz = 1 + (k++ * 7919) % 20000;
+        if ((offset + sz) > TOTAL_SIZE) {
+            sz = TOTAL_SIZE - offset;
+        }
+        int32_t rc = jsdrv_file_writer_write(w, data_ + offset, sz);
+        if (JSDRV_ERROR_FULL == rc) {
+            jsdrv_thread_sleep_ms(1);
+            continue;
+        }
+        assert_int_equal(0, rc);
+        offset += sz;
+    }
+}
+
+static void test_write(void **state) {
+    (void) state;
+    struct jsdrv_file_writer_status_s status;
+    struct jsdrv_file_writer_config_s config = {
+        .buffer_size = 1000,    // rounds up
+        .buffer_count = 1,      // at least double buffered
+    };
+    data_fill();
+    struct jsdrv_file_writer_s * w = jsdrv_file_writer_open(PATH, &config);
+    assert_non_null(w);
+    assert_int_equal(JSDRV_FILE_WRITER_BUFFER_ALIGN, jsdrv_file_writer_buffer_size(w));
+    assert_null(jsdrv_file_writer_reserve(w, JSDRV_FILE_WRITER_BUFFER_ALIGN + 1));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_file_writer_write(w, data_, JSDRV_FILE_WRITER_BUFFER_ALIGN + 1));
+    write_all(w);
+    jsdrv_file_writer_flush(w);
+    for (int i = 0; i < 1000; ++i) {
+        jsdrv_file_writer_status(w, &status);
+        if (status.bytes_written == TOTAL_SIZE) {
+            break;
+        }
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(TOTAL_SIZE, status.bytes_reserved);
+    assert_int_equal(TOTAL_SIZE, status.bytes_written);
+    assert_int_equal(0, status.backlog);
+    assert_true(status.backlog_max >= 1);
+    assert_true(status.backlog_max <= 2);
+    assert_int_equal(0, status.error);
+    assert_int_equal(0, jsdrv_file_writer_close(w));
+    file_check(TOTAL_SIZE);
+}
+
+static void test_options(void **state) {
+    (void) state;
+    const uint32_t sync[] = {JSDRV_FILE_WRITER_SYNC_CLOSE, JSDRV_FILE_WRITER_SYNC_INTERVAL, JSDRV_FILE_WRITER_SYNC_BUFFER};
+    data_fill();
+    for (uint32_t i = 0; i < 3; ++i) {
+        struct jsdrv_file_writer_config_s config = {
+            .buffer_size = 256 * 1024,
+            .buffer_count = 4,
+            .flags = JSDRV_FILE_WRITER_FLAG_DIRECT,
+            .sync = sync[i],
+            .sync_interval_ms = 1,
+            .preallocate = 4 * TOTAL_SIZE,  // released on close
+        };
+        struct jsdrv_file_writer_s * w = jsdrv_file_writer_open(PATH, &config);
+        assert_non_null(w);
+        write_all(w);
+        assert_int_equal(0, jsdrv_file_writer_close(w));
+        file_check(TOTAL_SIZE);
+    }
+}
+
+static void test_uring(void **state) {
+    (void) state;
+    struct jsdrv_file_writer_status_s status;
+    data_fill();
+    for (uint32_t i = 0; i < 2; ++i) {
+        struct jsdrv_file_writer_config_s config = {
+            .buffer_size = 64 * 1024,
+            .buffer_count = 8,
+            .flags = JSDRV_FILE_WRITER_FLAG_URING | (i ? JSDRV_FILE_WRITER_FLAG_DIRECT : 0),
+            .preallocate = 2 * TOTAL_SIZE,  // released on close
+        };
+        struct jsdrv_file_writer_s * w = jsdrv_file_writer_open(PATH, &config);
+        assert_non_null(w);
+        write_all(w);
+        jsdrv_file_writer_status(w, &status);
+        assert_int_equal(0, status.error);
+        if (!status.uring) {  // unavailable kernel or sandbox, the writer falls back
+            assert_true(status.batch_max <= 1);
+        }
+        assert_int_equal(0, jsdrv_file_writer_close(w));
+        file_check(TOTAL_SIZE);
+    }
+}
+
+static void test_invalid(void **state) {
+    (void) state;
+    assert_null(jsdrv_file_writer_open("", NULL));
+    assert_null(jsdrv_file_writer_open("no_such_dir/file_writer_test.bin", NULL));
+    assert_int_equal(0, jsdrv_file_writer_close(NULL));
+    struct jsdrv_file_writer_s * w = jsdrv_file_writer_open(PATH, NULL);
+    assert_non_null(w);
+    assert_int_equal(JSDRV_FILE_WRITER_BUFFER_SIZE, jsdrv_file_writer_buffer_size(w));
+    assert_int_equal(0, jsdrv_file_writer_close(w));
+    file_check(0);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_write),
+            cmocka_unit_test(test_options),
+            cmocka_unit_test(test_uring),
+            cmocka_unit_test(test_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
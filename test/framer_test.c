@@ -0,0 +1,179 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/framer.h"
+#include "jsdrv/error_code.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+static const struct jsdrv_stream_frame_channel_s CHANNELS[] = {
+    {JSDRV_FIELD_CURRENT, 0, JSDRV_DATA_TYPE_FLOAT, 32, 0},
+    {JSDRV_FIELD_VOLTAGE, 0, JSDRV_DATA_TYPE_FLOAT, 32, 0},
+    {JSDRV_FIELD_RANGE, 0, JSDRV_DATA_TYPE_UINT, 4, 0},
+    {JSDRV_FIELD_GPI, 0, JSDRV_DATA_TYPE_UINT, 1, 0},
+};
+
+static struct jsdrv_stream_frame_s frame_;
+
+static void add_f32(struct jsdrv_framer_s * f, uint8_t channel, uint64_t sample_id, uint32_t decimate_factor,
+                    float value_start, uint32_t count) {
+    float x[1024];
+    assert_true(count <= 1024);
+    for (uint32_t k = 0; k < count; ++k) {
+        x[k] = value_start + (float) k;
+    }
+    assert_int_equal(0, jsdrv_framer_add(f, channel, sample_id, decimate_factor, x, count));
+}
+
+static const float * frame_f32(uint8_t channel) {
+    return (const float *) (frame_.data + frame_.channels[channel].offset);
+}
+
+static const uint8_t * frame_u8(uint8_t channel) {
+    return frame_.data + frame_.channels[channel].offset;
+}
+
+static void test_configure(void **state) {
+    (void) state;
+    struct jsdrv_framer_s * f = jsdrv_framer_alloc();
+    struct jsdrv_stream_frame_channel_s c = {JSDRV_FIELD_RANGE, 0, JSDRV_DATA_TYPE_UINT, 2, 0};
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_framer_configure(f, &c, 1));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_framer_configure(f, CHANNELS, JSDRV_STREAM_FRAME_CHANNELS_MAX + 1));
+    assert_int_equal(0, jsdrv_framer_configure(f, CHANNELS, 2));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_framer_add(f, 2, 0, 2, NULL, 0));
+    assert_int_equal(0, jsdrv_framer_decimate_factor(f));
+    add_f32(f, 0, 1000, 2, 0.0f, 10);
+    assert_int_equal(2, jsdrv_framer_decimate_factor(f));
+    assert_int_equal(0, jsdrv_framer_configure(f, CHANNELS, 2));  // same, retains samples
+    assert_int_equal(2, jsdrv_framer_decimate_factor(f));
+    assert_int_equal(0, jsdrv_framer_configure(f, CHANNELS, 3));
+    assert_int_equal(0, jsdrv_framer_decimate_factor(f));
+    jsdrv_framer_free(f);
+}
+
+static void test_align_f32(void **state) {
+    (void) state;
+    struct jsdrv_framer_s * f = jsdrv_framer_alloc();
+    assert_int_equal(0, jsdrv_framer_configure(f, CHANNELS, 2));
+    add_f32(f, 0, 1000, 2, 0.0f, 100);      // 1000 to 1198
+    assert_int_equal(0, jsdrv_framer_pop(f, &frame_, 10));  // awaiting voltage
+    add_f32(f, 1, 1020, 2, 500.0f, 50);     // 1020 to 1118
+    assert_int_equal(0, jsdrv_framer_pop(f, &frame_, 51));
+    uint32_t sz = jsdrv_framer_pop(f, &frame_, 40);
+    assert_int_equal(JSDRV_STREAM_FRAME_HEADER_SIZE + 2 * 40 * sizeof(float), sz);
+    assert_int_equal(1, frame_.version);
+    assert_int_equal(2, frame_.channel_count);
+    assert_int_equal(1020, frame_.sample_id);
+    assert_int_equal(2, frame_.decimate_factor);
+    assert_int_equal(40, frame_.element_count);
+    assert_int_equal(JSDRV_FIELD_VOLTAGE, frame_.channels[1].field_id);
+    assert_int_equal(0, frame_.channels[1].offset % 8);
+    for (uint32_t k = 0; k < 40; ++k) {
+        assert_true((10.0f + k) == frame_f32(0)[k]);
+        assert_true((500.0f + k) == frame_f32(1)[k]);
+    }
+    assert_int_equal(0, jsdrv_framer_pop(f, &frame_, 20));  // only 10 remain
+    add_f32(f, 1, 1120, 2, 550.0f, 50);
+    assert_int_not_equal(0, jsdrv_framer_pop(f, &frame_, 20));
+    assert_int_equal(1100, frame_.sample_id);
+    assert_true(50.0f == frame_f32(0)[0]);
+    assert_true(540.0f == frame_f32(1)[0]);
+    jsdrv_framer_free(f);
+}
+
+static void test_hold_integers(void **state) {
+    (void) state;
+    struct jsdrv_framer_s * f = jsdrv_framer_alloc();
+    assert_int_equal(0, jsdrv_framer_configure(f, CHANNELS, 4));
+    uint8_t range[32];  // 64 u4 samples at every sample_id
+    for (uint32_t k = 0; k < 64; ++k) {
+        uint8_t v = (uint8_t) (k & 0x0f);
+        range[k >> 1] = (k & 1) ? (uint8_t) (range[k >> 1] | (v << 4)) : v;
+    }
+    uint8_t gpi[8] = {0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55};  // 64 u1 samples, alternating
+    add_f32(f, 0, 2001, 2, 0.0f, 30);   // odd sample ids
+    add_f32(f, 1, 2001, 2, 100.0f, 30);
+    assert_int_equal(0, jsdrv_framer_add(f, 2, 2000, 1, range, 64));
+    assert_int_equal(0, jsdrv_framer_add(f, 3, 2000, 1, gpi, 64));
+    assert_int_not_equal(0, jsdrv_framer_pop(f, &frame_, 30));
+    assert_int_equal(2001, frame_.sample_id);
+    assert_int_equal(8, frame_.channels[2].element_size_bits);
+    assert_int_equal(JSDRV_DATA_TYPE_UINT, frame_.channels[3].element_type);
+    for (uint32_t k = 0; k < 30; ++k) {
+        uint32_t j = 1 + 2 * k;  // the range and gpi index for sample_id 2001 + 2 * k
+        assert_int_equal(j & 0x0f, frame_u8(2)[k]);
+        assert_int_equal(0, frame_u8(3)[k]);  // odd samples are 0
+        assert_true((100.0f + k) == frame_f32(1)[k]);
+    }
+    jsdrv_framer_free(f);
+}
+
+static void test_discontinuity(void **state) {
+    (void) state;
+    struct jsdrv_framer_s * f = jsdrv_framer_alloc();
+    assert_int_equal(0, jsdrv_framer_configure(f, CHANNELS, 2));
+    add_f32(f, 0, 0, 2, 0.0f, 200);
+    add_f32(f, 1, 0, 2, 0.0f, 50);
+    add_f32(f, 1, 200, 2, 100.0f, 100);  // skip 50 samples, restarts voltage
+    assert_int_not_equal(0, jsdrv_framer_pop(f, &frame_, 50));
+    assert_int_equal(200, frame_.sample_id);
+    assert_true(100.0f == frame_f32(0)[0]);
+    assert_true(100.0f == frame_f32(1)[0]);
+    jsdrv_framer_clear(f);
+    assert_int_equal(0, jsdrv_framer_decimate_factor(f));
+    assert_int_equal(0, jsdrv_framer_pop(f, &frame_, 1));
+    jsdrv_framer_free(f);
+}
+
+static void test_overflow_and_limit(void **state) {
+    (void) state;
+    struct jsdrv_framer_s * f = jsdrv_framer_alloc();
+    assert_int_equal(0, jsdrv_framer_configure(f, CHANNELS, 2));
+    uint64_t sample_id = 0;
+    for (uint32_t k = 0; k < (JSDRV_FRAMER_SAMPLES_MAX / 1024) + 4; ++k) {
+        add_f32(f, 0, sample_id, 2, (float) (k * 1024), 1024);
+        sample_id += 2 * 1024;
+    }
+    // voltage arrives late, current retains only the newest samples
+    uint64_t v_start = sample_id - 2ULL * JSDRV_FRAMER_SAMPLES_MAX;
+    for (uint32_t k = 0; k < (JSDRV_FRAMER_SAMPLES_MAX / 1024); ++k) {
+        add_f32(f, 1, v_start + k * 2048ULL, 2, 0.0f, 1024);
+    }
+    uint32_t n_max = JSDRV_STREAM_FRAME_DATA_SIZE / 8 - 2;
+    uint32_t sz = jsdrv_framer_pop(f, &frame_, UINT32_MAX);
+    assert_int_equal(n_max, frame_.element_count);
+    assert_true(sz <= sizeof(frame_));
+    assert_int_equal(v_start, frame_.sample_id);
+    assert_true(((float) (v_start / 2)) == frame_f32(0)[0]);
+    jsdrv_framer_free(f);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_configure),
+            cmocka_unit_test(test_align_f32),
+            cmocka_unit_test(test_hold_integers),
+            cmocka_unit_test(test_discontinuity),
+            cmocka_unit_test(test_overflow_and_limit),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -24,13 +24,21 @@
 #include "jsdrv/log.h"
 #include "jsdrv_prv/backend.h"
 #include "jsdrv_prv/assert.h"
+#include "jsdrv_prv/atomic.h"
+#include "jsdrv_prv/buffer.h"
+#include "jsdrv_prv/buffer_signal.h"
 #include "js220_api.h"
 #include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/latency.h"
 #include "jsdrv_prv/msg_queue.h"
+#include "jsdrv_prv/perf.h"
+#include "jsdrv_prv/platform.h"
 #include "jsdrv_prv/thread.h"
 #include "jsdrv/cstr.h"
 #include "jsdrv/error_code.h"
+#include "jsdrv/net.h"
 #include <stdio.h>
+#include <math.h>
 
 #define DEVICE_PREFIX "t/js220/123456"
 #define SUB_TIMEOUT_MS   (2000)
@@ -46,8 +54,11 @@ struct test_s {
 };
 
 struct test_s self_;
+static struct jsdrvbk_s backend_other_;
 
-#define SETUP() \
+#define SETUP() SETUP_ARGS(NULL)
+
+#define SETUP_ARGS(args_) \
     memset(&self_, 0, sizeof(self_));                                                       \
     struct test_s * self = &self_;                                                          \
     *state = self;                                                                          \
@@ -55,7 +66,7 @@ struct test_s self_;
     jsdrv_cstr_copy(self->ll_dev1.prefix, DEVICE_PREFIX, sizeof(self->ll_dev1.prefix));     \
     self->ll_dev1.cmd_q = msg_queue_init();                                                 \
     self->ll_dev1.rsp_q = msg_queue_init();                                                 \
-    assert_int_equal(0, jsdrv_initialize(&self->context, NULL, 1000));                      \
+    assert_int_equal(0, jsdrv_initialize(&self->context, (args_), 1000));                    \
     assert_int_equal(0, jsdrv_subscribe(self->context, "@", JSDRV_SFLAG_PUB, subscribe_cmd_fn, self, 1000))
 
 
@@ -78,6 +89,11 @@ static void subscribe_cmd_fn(void * user_data, const char * topic, const struct
     if (jsdrv_cstr_ends_with(topic, "/!data")) {
         return;  // handled separately
     }
+    if (jsdrv_cstr_starts_with(topic, "@/pool/") || jsdrv_cstr_starts_with(topic, JSDRV_MSG_PERF "/")
+            || jsdrv_cstr_starts_with(topic, JSDRV_MSG_LATENCY "/")
+            || jsdrv_cstr_starts_with(topic, JSDRV_MSG_ALLOC "/")) {
+        return;  // periodic telemetry
+    }
     struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(t->context);
     jsdrv_cstr_copy(m->topic, topic, sizeof(m->topic));
     m->value = *value;
@@ -236,14 +252,17 @@ static void dev_expect_bulk_out(struct jsdrvp_ll_device_s * d, uint16_t frame_id
 
 int32_t jsdrv_unittest_backend_factory(struct jsdrv_context_s * context, struct jsdrvbk_s ** backend) {
     struct test_s * self = &self_;
-    assert_ptr_equal(self->context, context);
-    self->backend.prefix = 't';
-    self->backend.finalize = bk_finalize;
-    self->backend.cmd_q = msg_queue_init();
-    *backend = &self->backend;
+    struct jsdrvbk_s * b = &self->backend;
+    if (self->context != context) {
+        b = &backend_other_;  // additional, independent context
+    }
+    b->prefix = 't';
+    b->finalize = bk_finalize;
+    b->cmd_q = msg_queue_init();
+    *backend = b;
 
     struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc_value(context, JSDRV_MSG_INITIALIZE, &jsdrv_union_i32(0));
-    msg->payload.str[0] = self->backend.prefix;
+    msg->payload.str[0] = b->prefix;
     jsdrvp_backend_send(context, msg);
     return 0;
 }
@@ -288,21 +307,33 @@ static void publish_from_dev(struct test_s * self, const char * subtopic, const
 }
 #endif
 
-static void device1_add(struct test_s * self) {
-    assert_int_equal(0, jsdrv_subscribe(self->context, DEVICE_PREFIX,
-                                        JSDRV_SFLAG_PUB | JSDRV_SFLAG_RETAIN | JSDRV_SFLAG_RETURN_CODE | JSDRV_SFLAG_METADATA_RSP,
-                                        subscribe_cmd_fn, self, 1000));
-
+static void device1_add_send(struct test_s * self) {
     struct jsdrvp_msg_s *msg = jsdrvp_msg_alloc(self->context);
     jsdrv_cstr_copy(msg->topic, JSDRV_MSG_DEVICE_ADD, sizeof(msg->topic));
     msg->value = jsdrv_union_bin((const uint8_t *) &msg->payload.device, sizeof(msg->payload.device));
     msg->value.app = JSDRV_PAYLOAD_TYPE_DEVICE;
     msg->payload.device = self->ll_dev1;
     jsdrvp_backend_send(self->context, msg);
+}
+
+static void device1_add(struct test_s * self) {
+    assert_int_equal(0, jsdrv_subscribe(self->context, DEVICE_PREFIX,
+                                        JSDRV_SFLAG_PUB | JSDRV_SFLAG_RETAIN | JSDRV_SFLAG_RETURN_CODE | JSDRV_SFLAG_METADATA_RSP,
+                                        subscribe_cmd_fn, self, 1000));
+    device1_add_send(self);
     expect_subscribe_cmd_str(self, JSDRV_MSG_DEVICE_ADD, DEVICE_PREFIX);
     expect_subscribe_cmd_str(self, JSDRV_MSG_DEVICE_LIST, DEVICE_PREFIX);
 
     expect_subscribe_cmd_json(self, DEVICE_PREFIX "/h/state$", NULL);
+    expect_subscribe_cmd_json(self, DEVICE_PREFIX "/h/usb/bulk_in/depth$", NULL);
+    expect_subscribe_cmd_json(self, DEVICE_PREFIX "/h/usb/bulk_in/max$", NULL);
+    expect_subscribe_cmd_json(self, DEVICE_PREFIX "/h/usb/bulk_in/size$", NULL);
+    expect_subscribe_cmd_json(self, DEVICE_PREFIX "/h/usb/bulk_in/spare$", NULL);
+    expect_subscribe_cmd_json(self, DEVICE_PREFIX "/h/stream/latency$", NULL);
+    expect_subscribe_cmd_json(self, DEVICE_PREFIX "/h/stream/event$", NULL);
+    expect_subscribe_cmd_json(self, DEVICE_PREFIX "/h/stream/frame$", NULL);
+    expect_subscribe_cmd_json(self, DEVICE_PREFIX "/h/power/window$", NULL);
+    expect_subscribe_cmd_json(self, DEVICE_PREFIX "/h/qos$", NULL);
     expect_subscribe_cmd(self, DEVICE_PREFIX "/h/state", &jsdrv_union_u32_r(1));  // closed
 }
 
@@ -406,6 +437,565 @@ static void test_discovery(void ** state) {
     }
 }
 
+static void test_discovery_executor(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_DEVICE_THREADS, .value=jsdrv_union_u32(2)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    for (int i = 0; i < 3; ++i) {
+        SETUP_ARGS(args);
+        device1_add(self);
+        device1_remove(self);
+        ASSERT_QUEUES_EMPTY(self);
+        TEARDOWN();
+    }
+}
+
+// Skip unrelated messages, such as the device metadata and state.
+static void expect_subscribe_cmd_skip(struct test_s * t, const char * parameter_, const struct jsdrv_union_s * value) {
+    struct jsdrvp_msg_s * msg;
+    while (1) {
+        assert_int_equal(0, msg_queue_pop(t->sub_msgs, &msg, SUB_TIMEOUT_MS));
+        if (0 == strcmp(parameter_, msg->topic)) {
+            break;
+        }
+        jsdrvp_msg_free(t->context, msg);
+    }
+    assert_true(jsdrv_union_eq(value, &msg->value));
+    jsdrvp_msg_free(t->context, msg);
+}
+
+static void ll_dev1_expect_open(struct test_s * self, int32_t mode) {
+    struct jsdrvp_msg_s * msg;
+    assert_int_equal(0, msg_queue_pop(self->ll_dev1.cmd_q, &msg, DEV_TIMEOUT_MS));
+    assert_string_equal(JSDRV_MSG_OPEN, msg->topic);
+    assert_int_equal(mode, msg->value.value.i32);
+    jsdrvp_msg_free(self->context, msg);
+}
+
+static void ll_dev1_drain(struct test_s * self) {
+    struct jsdrvp_msg_s * msg;
+    while (NULL != (msg = msg_queue_pop_immediate(self->ll_dev1.cmd_q))) {
+        jsdrvp_msg_free(self->context, msg);
+    }
+}
+
+static void device1_readd(struct test_s * self) {
+    assert_int_equal(0, jsdrv_subscribe(self->context, DEVICE_PREFIX, JSDRV_SFLAG_PUB | JSDRV_SFLAG_RETURN_CODE,
+                                        subscribe_cmd_fn, self, 1000));
+    device1_add_send(self);
+    expect_subscribe_cmd_str(self, JSDRV_MSG_DEVICE_ADD, DEVICE_PREFIX);
+}
+
+// Wait for the device to process all prior messages, then discard the responses.
+static void device1_sync(struct test_s * self) {
+    struct jsdrvp_msg_s * msg;
+    const char * topic = DEVICE_PREFIX "/h/stream/latency";
+    // a batch always takes the frontend path, after the pending device messages
+    assert_int_equal(0, jsdrv_publish_batch(self->context, &topic, &jsdrv_union_u32(6), 1, 1000));
+    while (NULL != (msg = msg_queue_pop_immediate(self->sub_msgs))) {
+        assert_string_not_equal(DEVICE_PREFIX "/" JSDRV_MSG_OPEN, msg->topic);
+        jsdrvp_msg_free(self->context, msg);
+    }
+}
+
+// Wait for the device return code to its h/state on add, which may arrive after device1_sync().
+static void device1_expect_state_rc(struct test_s * self) {
+    struct jsdrvp_msg_s * msg;
+    bool done = false;
+    while (!done) {
+        assert_int_equal(0, msg_queue_pop(self->sub_msgs, &msg, SUB_TIMEOUT_MS));
+        assert_string_not_equal(DEVICE_PREFIX "/" JSDRV_MSG_OPEN, msg->topic);
+        done = (0 == strcmp(DEVICE_PREFIX "/h/state#", msg->topic));
+        jsdrvp_msg_free(self->context, msg);
+    }
+}
+
+static void test_reconnect(void ** state) {
+    SETUP();
+    assert_int_equal(0, jsdrv_publish(self->context, JSDRV_MSG_REOPEN, &jsdrv_union_u32(1000), 1000));
+    expect_subscribe_cmd(self, JSDRV_MSG_REOPEN, &jsdrv_union_u32(1000));
+    device1_add(self);
+    assert_int_equal(0, jsdrv_publish(self->context, DEVICE_PREFIX "/h/stream/latency", &jsdrv_union_u32_r(5), 1000));
+    expect_subscribe_cmd(self, DEVICE_PREFIX "/h/stream/latency", &jsdrv_union_u32_r(5));
+    expect_subscribe_cmd(self, DEVICE_PREFIX "/h/stream/latency#", &jsdrv_union_i32(0));
+    assert_int_equal(0, jsdrv_publish(self->context, DEVICE_PREFIX "/" JSDRV_MSG_OPEN, &jsdrv_union_i32(1), 0));
+    expect_subscribe_cmd(self, DEVICE_PREFIX "/" JSDRV_MSG_OPEN, &jsdrv_union_i32(1));
+    ll_dev1_expect_open(self, 1);
+
+    // unplug while open, then return: reopen with the same mode and restore
+    device1_remove(self);
+    ll_dev1_drain(self);
+    device1_readd(self);
+    expect_subscribe_cmd_skip(self, DEVICE_PREFIX "/" JSDRV_MSG_OPEN, &jsdrv_union_i32(1));
+    ll_dev1_expect_open(self, 1);
+    expect_subscribe_cmd_skip(self, DEVICE_PREFIX "/h/stream/latency#", &jsdrv_union_i32(0));
+    device1_sync(self);
+
+    // close while removed cancels the reconnect
+    device1_remove(self);
+    ll_dev1_drain(self);
+    assert_int_equal(0, jsdrv_publish(self->context, DEVICE_PREFIX "/" JSDRV_MSG_CLOSE, &jsdrv_union_i32(0), 1000));
+    device1_readd(self);
+    device1_expect_state_rc(self);
+    device1_sync(self);
+    assert_true(msg_queue_is_empty(self->ll_dev1.cmd_q));
+    device1_remove(self);
+    TEARDOWN();
+}
+
+static void test_publish_direct(void ** state) {
+    SETUP();
+    struct jsdrv_union_s v;
+    device1_add(self);
+    uint64_t direct = jsdrv_perf_get(JSDRV_PERF_PUBLISH_DIRECT);
+    for (uint32_t i = 1; i <= 3; ++i) {
+        assert_int_equal(0, jsdrv_publish(self->context, DEVICE_PREFIX "/h/stream/latency", &jsdrv_union_u32_r(i), 1000));
+        expect_subscribe_cmd(self, DEVICE_PREFIX "/h/stream/latency", &jsdrv_union_u32_r(i));  // value before return code
+        expect_subscribe_cmd(self, DEVICE_PREFIX "/h/stream/latency#", &jsdrv_union_i32(0));
+        assert_int_equal(0, jsdrv_query(self->context, DEVICE_PREFIX "/h/stream/latency", &v, 0));
+        assert_int_equal(i, v.value.u32);
+    }
+#if JSDRV_PERF_ENABLE
+    assert_true(jsdrv_perf_get(JSDRV_PERF_PUBLISH_DIRECT) > direct);
+#else
+    (void) direct;
+#endif
+
+    // the retained value takes the pubsub path, which deduplicates
+    assert_int_equal(0, jsdrv_publish(self->context, DEVICE_PREFIX "/h/stream/latency", &jsdrv_union_u32_r(3), 1000));
+    expect_subscribe_cmd(self, DEVICE_PREFIX "/h/stream/latency#", &jsdrv_union_i32(0));
+    device1_remove(self);
+    ASSERT_QUEUES_EMPTY(self);
+    TEARDOWN();
+}
+
+static void test_msg_retain(void ** state) {
+    SETUP();
+    struct jsdrvp_msg_s * msg = jsdrvp_msg_alloc_data(self->context, DEVICE_PREFIX "/s/i/!data");
+    assert_int_equal(1, msg->refcnt);
+    assert_ptr_equal(msg, jsdrvp_msg_retain(msg));
+    assert_int_equal(2, msg->refcnt);
+    jsdrvp_msg_free(self->context, msg);
+    assert_int_equal(1, msg->refcnt);  // still owned, not on the free list
+    struct jsdrvp_msg_s * other = jsdrvp_msg_alloc_data(self->context, DEVICE_PREFIX "/s/v/!data");
+    assert_ptr_not_equal(msg, other);
+    jsdrvp_msg_free(self->context, other);
+    jsdrvp_msg_free(self->context, msg);
+    TEARDOWN();
+}
+
+static void test_msg_alloc_data_sz(void ** state) {
+    SETUP();
+    struct jsdrvp_msg_s * small = jsdrvp_msg_alloc_data_sz(self->context, DEVICE_PREFIX "/s/i/!data", 100);
+    assert_true(small->capacity >= 100);
+    assert_true(small->capacity < sizeof(struct jsdrv_stream_signal_s));
+    struct jsdrvp_msg_s * large = jsdrvp_msg_alloc_data_sz(self->context, DEVICE_PREFIX "/s/v/!data", 100000);
+    assert_int_equal(sizeof(struct jsdrv_stream_signal_s), large->capacity);
+    struct jsdrvp_msg_s * full = jsdrvp_msg_alloc_data(self->context, DEVICE_PREFIX "/s/p/!data");
+    assert_int_equal(sizeof(struct jsdrv_stream_signal_s), full->capacity);
+
+    small->value.size = 64;
+    memset(small->payload.bin, 0x5a, small->value.size);
+    struct jsdrvp_msg_s * clone = jsdrvp_msg_clone(self->context, small);
+    assert_int_equal(small->capacity, clone->capacity);
+    assert_memory_equal(small->payload.bin, clone->payload.bin, small->value.size);
+
+    jsdrvp_msg_free(self->context, clone);
+    jsdrvp_msg_free(self->context, small);
+    jsdrvp_msg_free(self->context, large);
+    jsdrvp_msg_free(self->context, full);
+    TEARDOWN();
+}
+
+static void test_msg_small(void ** state) {
+    SETUP();
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_small(self->context);
+    assert_int_equal(JSDRVP_MSG_SMALL_PAYLOAD_SIZE, m->capacity);
+    jsdrv_cstr_copy(m->topic, "x/small#", sizeof(m->topic));
+    m->value = jsdrv_union_i32(-3);
+    struct jsdrvp_msg_s * clone = jsdrvp_msg_clone(self->context, m);
+    assert_true(clone->capacity > JSDRVP_MSG_SMALL_PAYLOAD_SIZE);
+    assert_string_equal("x/small#", clone->topic);
+    assert_int_equal(-3, clone->value.value.i32);
+    jsdrvp_msg_free(self->context, clone);
+    jsdrvp_msg_free(self->context, m);
+
+    m = jsdrvp_msg_alloc_value(self->context, "x/small", &jsdrv_union_cstr("hello"));
+    m = jsdrvp_msg_compact(self->context, m);
+    assert_int_equal(JSDRVP_MSG_SMALL_PAYLOAD_SIZE, m->capacity);
+    assert_ptr_equal(m->payload.str, m->value.value.str);
+    assert_string_equal("hello", m->value.value.str);
+    jsdrvp_msg_free(self->context, m);
+
+    char str[2 * JSDRVP_MSG_SMALL_PAYLOAD_SIZE];
+    memset(str, 'a', sizeof(str) - 1);
+    str[sizeof(str) - 1] = 0;
+    m = jsdrvp_msg_alloc_value(self->context, "x/small", &jsdrv_union_cstr(str));
+    struct jsdrvp_msg_s * m2 = jsdrvp_msg_compact(self->context, m);
+    assert_ptr_equal(m, m2);  // too large
+    jsdrvp_msg_retain(m);
+    m = jsdrvp_msg_alloc_value(self->context, "x/small", &jsdrv_union_u32(7));
+    jsdrvp_msg_retain(m);
+    assert_ptr_equal(m, jsdrvp_msg_compact(self->context, m));  // shared
+    jsdrvp_msg_free(self->context, m);
+    jsdrvp_msg_free(self->context, m);
+    jsdrvp_msg_free(self->context, m2);
+    jsdrvp_msg_free(self->context, m2);
+
+    // retained scalar values are compact and still query
+    struct jsdrv_union_s value;
+    assert_int_equal(0, jsdrv_publish(self->context, "x/small/v", &jsdrv_union_u32_r(42), 0));
+    assert_int_equal(0, jsdrv_query(self->context, "x/small/v", &value, 1000));
+    assert_int_equal(42, value.value.u32);
+    TEARDOWN();
+}
+
+static void test_publish_batch(void ** state) {
+    const char * topics[] = {"x/batch/0", "x/batch/1", "x/batch/2"};
+    struct jsdrv_union_s values[] = {jsdrv_union_u32_r(10), jsdrv_union_u32_r(11), jsdrv_union_u32_r(12)};
+    const char * topics_invalid[] = {"x/batch/0", ""};
+    struct jsdrv_union_s value;
+    SETUP();
+    assert_int_equal(0, jsdrv_publish_batch(self->context, topics, values, 0, 1000));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_publish_batch(self->context, NULL, values, 3, 1000));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_publish_batch(self->context, topics_invalid, values, 2, 1000));
+    assert_int_equal(0, jsdrv_publish_batch(self->context, topics, values, 3, 0));
+    for (uint32_t i = 0; i < 3; ++i) {
+        memset(&value, 0, sizeof(value));
+        assert_int_equal(0, jsdrv_query(self->context, topics[i], &value, 1000));
+        assert_int_equal(10 + i, value.value.u32);
+    }
+
+    // non-device topics do not send return codes, so the batch times out
+    values[0].value.u32 = 20;
+    assert_int_equal(JSDRV_ERROR_TIMED_OUT, jsdrv_publish_batch(self->context, topics, values, 3, 50));
+    memset(&value, 0, sizeof(value));
+    assert_int_equal(0, jsdrv_query(self->context, topics[0], &value, 1000));
+    assert_int_equal(20, value.value.u32);
+    TEARDOWN();
+}
+
+struct async_state_s {
+    volatile int32_t count;
+    int32_t rc[8];
+    char topic[8][JSDRV_TOPIC_LENGTH_MAX];
+    struct jsdrv_union_s * value[8];
+};
+
+static void on_async(void * user_data, const char * topic, int32_t return_code, struct jsdrv_union_s * value) {
+    struct async_state_s * a = (struct async_state_s *) user_data;
+    int32_t idx = a->count;
+    a->rc[idx] = return_code;
+    jsdrv_cstr_copy(a->topic[idx], topic, sizeof(a->topic[idx]));
+    a->value[idx] = value;
+    jsdrv_atomic_add(&a->count, 1);
+}
+
+static void async_wait(struct async_state_s * a, int32_t count) {
+    for (uint32_t i = 0; (i < 1000) && (jsdrv_atomic_load(&a->count) < count); ++i) {
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(count, jsdrv_atomic_load(&a->count));
+}
+
+static void test_async(void ** state) {
+    const char * topics[] = {"x/async/0", "x/async/1", "x/async/2"};
+    struct jsdrv_union_s values[3];
+    struct async_state_s a;
+    memset(&a, 0, sizeof(a));
+    SETUP();
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_publish_async(self->context, "", &values[0], on_async, &a, 0));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_query_async(self->context, topics[0], NULL, on_async, &a, 0));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_query_async(self->context, topics[0], &values[0], NULL, &a, 0));
+
+    for (uint32_t i = 0; i < 3; ++i) {
+        assert_int_equal(0, jsdrv_publish(self->context, topics[i], &jsdrv_union_u32_r(30 + i), 0));
+    }
+    memset(values, 0, sizeof(values));
+    for (uint32_t i = 0; i < 3; ++i) {
+        assert_int_equal(0, jsdrv_query_async(self->context, topics[i], &values[i], on_async, &a, 1000));
+    }
+    async_wait(&a, 3);
+    for (uint32_t i = 0; i < 3; ++i) {  // complete in order
+        assert_int_equal(0, a.rc[i]);
+        assert_string_equal(topics[i], a.topic[i]);
+        assert_ptr_equal(&values[i], a.value[i]);
+        assert_int_equal(30 + i, values[i].value.u32);
+    }
+
+    // non-device topics do not send return codes, so the publish times out
+    assert_int_equal(0, jsdrv_publish_async(self->context, topics[0], &jsdrv_union_u32_r(40), on_async, &a, 20));
+    async_wait(&a, 4);
+    assert_int_equal(JSDRV_ERROR_TIMED_OUT, a.rc[3]);
+    assert_string_equal(topics[0], a.topic[3]);
+    assert_null(a.value[3]);
+    TEARDOWN();
+}
+
+static void test_open_many(void ** state) {
+    const char * prefixes[] = {"t/js220/000001", "t/js220/000002"};
+    const char * prefixes_invalid[] = {"t/js220/000001", NULL};
+    SETUP();
+    assert_int_equal(0, jsdrv_open_many(self->context, prefixes, 0, 0, 1000));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_open_many(self->context, NULL, 2, 0, 1000));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_open_many(self->context, prefixes_invalid, 2, 0, 1000));
+    // devices not present, so no return codes
+    assert_int_equal(JSDRV_ERROR_TIMED_OUT, jsdrv_open_many(self->context, prefixes, 2, 0, 50));
+    TEARDOWN();
+}
+
+struct dispatch_state_s {
+    volatile int32_t count;
+    volatile uint32_t last;
+    volatile int32_t blocked;
+    volatile int32_t release;
+    volatile int32_t out_of_order;
+};
+
+static void on_dispatch_data(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    struct dispatch_state_s * d = (struct dispatch_state_s *) user_data;
+    (void) topic;
+    uint32_t v = *((const uint32_t *) value->value.bin);
+    if (d->count && (v != (d->last + 1))) {
+        d->out_of_order = 1;
+    }
+    d->last = v;
+    ++d->count;
+    if (v == 0) {  // block the data plane
+        d->blocked = 1;
+        for (int i = 0; (i < 2000) && !d->release; ++i) {
+            jsdrv_thread_sleep_ms(1);
+        }
+    }
+}
+
+static void dispatch_publish(struct test_s * self, uint32_t v) {
+    struct jsdrv_union_s value = jsdrv_union_bin((uint8_t *) &v, sizeof(v));
+    value.app = JSDRV_PAYLOAD_TYPE_STREAM;
+    assert_int_equal(0, jsdrv_publish(self->context, DEVICE_PREFIX "/s/i/!data", &value, 0));
+}
+
+static void test_data_dispatch(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_FRONTEND_DATA_THREADS, .value=jsdrv_union_u32(2)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct dispatch_state_s d;
+    memset(&d, 0, sizeof(d));
+    struct jsdrv_union_s version;
+    SETUP_ARGS(args);
+    assert_int_equal(0, jsdrv_subscribe(self->context, DEVICE_PREFIX "/s/i/!data", JSDRV_SFLAG_PUB,
+                                        on_dispatch_data, &d, 1000));
+    for (uint32_t v = 0; v < 100; ++v) {
+        dispatch_publish(self, v);
+    }
+    for (int i = 0; (i < 2000) && !d.blocked; ++i) {
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(1, d.blocked);
+
+    // control plane still responds while a data subscriber blocks
+    memset(&version, 0, sizeof(version));
+    assert_int_equal(0, jsdrv_query(self->context, JSDRV_MSG_VERSION, &version, 100));
+    assert_int_equal(JSDRV_VERSION_U32, version.value.u32);
+    assert_int_equal(1, d.count);
+    d.release = 1;
+
+    // unsubscribe completes after all prior data is delivered
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, DEVICE_PREFIX "/s/i/!data", on_dispatch_data, &d, 3000));
+    assert_int_equal(100, d.count);
+    assert_int_equal(0, d.out_of_order);
+    dispatch_publish(self, 100);
+    assert_int_equal(0, jsdrv_query(self->context, JSDRV_MSG_VERSION, &version, 1000));
+    assert_int_equal(100, d.count);
+    TEARDOWN();
+}
+
+static void test_thread_policy(void ** state) {
+    struct jsdrv_union_s value;
+    struct jsdrv_thread_policy_s policy;
+    SETUP();
+    memset(&value, 0, sizeof(value));
+    assert_int_equal(0, jsdrv_query(self->context, "@/threads/usb/policy", &value, 1000));
+    assert_int_equal(JSDRV_THREAD_SCHED_DEFAULT, value.value.u8);
+
+    assert_int_equal(0, jsdrv_publish(self->context, "@/threads/net/prio", &jsdrv_union_i32(3), 0));
+    assert_int_equal(0, jsdrv_query(self->context, "@/threads/net/prio", &value, 1000));  // processed in order
+    assert_int_equal(0, jsdrv_thread_policy_get(JSDRV_THREAD_ROLE_NET, &policy));
+    assert_int_equal(JSDRV_THREAD_SCHED_DEFAULT, policy.sched);
+    assert_int_equal(3, policy.priority);
+    memset(&policy, 0, sizeof(policy));
+    assert_int_equal(0, jsdrv_thread_policy_set(JSDRV_THREAD_ROLE_NET, &policy));
+    TEARDOWN();
+}
+
+static void test_multiple_contexts(void ** state) {
+    struct jsdrv_context_s * c2 = NULL;
+    SETUP();
+    assert_int_equal(0, jsdrv_initialize(&c2, NULL, 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "m/@/!add", &jsdrv_union_u8(1), 1000));
+    assert_int_equal(0, jsdrv_publish(c2, "m/@/!add", &jsdrv_union_u8(1), 1000));  // independent managers
+    assert_int_equal(JSDRV_ERROR_ALREADY_EXISTS, jsdrv_publish(self->context, "m/@/!add", &jsdrv_union_u8(1), 1000));
+    assert_int_equal(0, jsdrv_publish(c2, "m/@/!remove", &jsdrv_union_u8(1), 1000));
+    assert_int_equal(0, jsdrv_publish(c2, "m/@/!add", &jsdrv_union_u8(1), 1000));
+    jsdrv_finalize(c2, 1000);
+    assert_int_equal(0, jsdrv_publish(self->context, "m/@/!remove", &jsdrv_union_u8(1), 1000));
+    TEARDOWN();
+}
+
+// Publish the buffer settings through the topic tree, which limits each level length.
+static void test_buffer_settings(void ** state) {
+    SETUP();
+    assert_int_equal(0, jsdrv_publish(self->context, "m/@/!add", &jsdrv_union_u8(1), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "m/001/" JSDRV_BUFFER_MSG_INTEGRAL, &jsdrv_union_u8(1), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "m/001/" JSDRV_BUFFER_MSG_HISTOGRAM, &jsdrv_union_u8(1), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "m/001/" JSDRV_BUFFER_MSG_TILE_CACHE, &jsdrv_union_u32(16), 1000));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_publish(self->context, "m/001/" JSDRV_BUFFER_MSG_TILE_CACHE,
+                                                                  &jsdrv_union_u32(JSDRV_BUFFER_TILE_CACHE_MAX + 1), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "m/001/" JSDRV_BUFFER_MSG_PREFETCH, &jsdrv_union_u8(1), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "m/001/" JSDRV_BUFFER_MSG_REBALANCE, &jsdrv_union_u8(1), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "m/001/" JSDRV_BUFFER_MSG_TREND_LEVEL, &jsdrv_union_u32(3), 1000));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_publish(self->context, "m/001/" JSDRV_BUFFER_MSG_TREND_LEVEL,
+                                                                  &jsdrv_union_u32(JSDRV_BUFSIG_LEVELS_MAX + 1), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "m/@/!remove", &jsdrv_union_u8(1), 1000));
+    TEARDOWN();
+}
+
+struct stats_history_rsp_s {
+    volatile uint32_t count;
+    volatile uint32_t final;
+    uint32_t errors;
+};
+
+static void on_stats_history_rsp(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    struct stats_history_rsp_s * t = (struct stats_history_rsp_s *) user_data;
+    (void) topic;
+    const struct jsdrv_statistics_history_response_s * rsp = (const struct jsdrv_statistics_history_response_s *) value->value.bin;
+    if ((value->app != JSDRV_PAYLOAD_TYPE_STATISTICS_HISTORY_RSP) || (rsp->rsp_id != 42) || rsp->count) {
+        ++t->errors;
+    }
+    ++t->count;
+    if (rsp->flags & JSDRV_BUFFER_RESPONSE_FLAG_FINAL) {
+        t->final = 1;
+    }
+}
+
+static void test_stats_history_request(void ** state) {
+    SETUP();
+    struct stats_history_rsp_s t;
+    memset(&t, 0, sizeof(t));
+    struct jsdrv_statistics_history_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.rsp_id = 42;
+    jsdrv_cstr_copy(req.device, DEVICE_PREFIX, sizeof(req.device));
+    jsdrv_cstr_copy(req.rsp_topic, "a/hist/!rsp", sizeof(req.rsp_topic));
+    assert_int_equal(0, jsdrv_publish(self->context, JSDRV_MSG_STATISTICS_HISTORY, &jsdrv_union_u32(16), 1000));
+    assert_int_equal(0, jsdrv_subscribe(self->context, req.rsp_topic, JSDRV_SFLAG_PUB, on_stats_history_rsp, &t, 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, JSDRV_MSG_STATISTICS_HISTORY_REQ,
+                                      &jsdrv_union_cbin((uint8_t *) &req, sizeof(req)), 1000));
+    for (int i = 0; (i < 1000) && !t.final; ++i) {
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, req.rsp_topic, on_stats_history_rsp, &t, 1000));
+    assert_int_equal(1, t.count);  // no records, single empty response
+    assert_int_equal(1, t.final);
+    assert_int_equal(0, t.errors);
+    assert_int_equal(0, jsdrv_publish(self->context, JSDRV_MSG_STATISTICS_HISTORY, &jsdrv_union_u32(0), 1000));
+    TEARDOWN();
+}
+
+static void test_queued_coalesce(void ** state) {
+    struct dispatch_state_s d;
+    memset(&d, 0, sizeof(d));
+    struct jsdrv_union_s value;
+    char str[JSDRV_TOPIC_LENGTH_MAX];
+    SETUP();
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_subscribe_queued(
+            self->context, DEVICE_PREFIX "/s/i/!data", JSDRV_SFLAG_PUB, 255, 4, on_dispatch_data, &d, 1000));
+    assert_int_equal(0, jsdrv_subscribe_queued(self->context, DEVICE_PREFIX "/s/i/!data", JSDRV_SFLAG_PUB,
+                                               JSDRV_SUBSCRIBE_QUEUE_COALESCE, 4, on_dispatch_data, &d, 1000));
+    dispatch_publish(self, 0);
+    for (int i = 0; (i < 2000) && !d.blocked; ++i) {
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(1, d.blocked);
+    for (uint32_t v = 1; v < 100; ++v) {
+        dispatch_publish(self, v);
+    }
+    memset(&value, 0, sizeof(value));
+    value.type = JSDRV_UNION_STR;
+    value.value.str = str;
+    value.size = sizeof(str);
+    assert_int_equal(0, jsdrv_query(self->context, "@/subq/0/topic", &value, 1000));
+    assert_string_equal(DEVICE_PREFIX "/s/i/!data", str);
+    d.release = 1;
+
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, DEVICE_PREFIX "/s/i/!data", on_dispatch_data, &d, 3000));
+    assert_int_equal(2, d.count);
+    assert_int_equal(99, d.last);
+    TEARDOWN();
+}
+
+static void test_queued_block(void ** state) {
+    struct dispatch_state_s d;
+    memset(&d, 0, sizeof(d));
+    SETUP();
+    assert_int_equal(0, jsdrv_subscribe_queued(self->context, DEVICE_PREFIX "/s/i/!data", JSDRV_SFLAG_PUB,
+                                               JSDRV_SUBSCRIBE_QUEUE_BLOCK, 2, on_dispatch_data, &d, 1000));
+    for (uint32_t v = 0; v < 20; ++v) {
+        dispatch_publish(self, v);
+    }
+    for (int i = 0; (i < 2000) && !d.blocked; ++i) {
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(1, d.blocked);
+    d.release = 1;
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, DEVICE_PREFIX "/s/i/!data", on_dispatch_data, &d, 3000));
+    assert_int_equal(20, d.count);
+    assert_int_equal(0, d.out_of_order);
+    TEARDOWN();
+}
+
+static void on_batch_data(void * user_data, const struct jsdrv_subscribe_msg_s * msgs, uint32_t count) {
+    struct dispatch_state_s * d = (struct dispatch_state_s *) user_data;
+    assert_true(count <= JSDRV_SUBSCRIBE_BATCH_SIZE_MAX);
+    for (uint32_t i = 0; i < count; ++i) {
+        on_dispatch_data(user_data, msgs[i].topic, msgs[i].value);
+    }
+    ++d->blocked;  // batch count
+}
+
+static void test_batch(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_FRONTEND_DATA_THREADS, .value=jsdrv_union_u32(2)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct dispatch_state_s d;
+    memset(&d, 0, sizeof(d));
+    struct jsdrv_union_s version;
+    d.release = 1;
+    SETUP_ARGS(args);
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_subscribe_batch(self->context, DEVICE_PREFIX "/s/i/!data",
+            JSDRV_SFLAG_PUB | JSDRV_SFLAG_QUEUED, on_batch_data, &d, 1000));
+    assert_int_equal(0, jsdrv_subscribe_batch(self->context, DEVICE_PREFIX "/s/i/!data", JSDRV_SFLAG_PUB,
+                                              on_batch_data, &d, 1000));
+    for (uint32_t v = 0; v < 200; ++v) {
+        dispatch_publish(self, v);
+    }
+    assert_int_equal(0, jsdrv_unsubscribe_batch(self->context, NULL, on_batch_data, &d, 1000));
+    assert_int_equal(200, d.count);
+    assert_int_equal(0, d.out_of_order);
+    assert_true((d.blocked >= 4) && (d.blocked <= 200));
+    dispatch_publish(self, 200);
+    memset(&version, 0, sizeof(version));
+    assert_int_equal(0, jsdrv_query(self->context, JSDRV_MSG_VERSION, &version, 1000));  // processed in order
+    assert_int_equal(200, d.count);
+    TEARDOWN();
+}
+
 #if 0
 static void test_device_open(void ** state) {
     SETUP();
@@ -553,6 +1143,1012 @@ void log_recv(void * user_data, struct jsdrv_log_header_s const * header,
            filename, header->line, message);
 }
 
+struct net_rx_s {
+    struct jsdrv_os_socket_s * sock;
+    uint8_t buf[JSDRV_NET_FRAME_SIZE_MAX];
+    uint8_t scratch[sizeof(struct jsdrv_stream_signal_s)];
+    uint32_t offset;
+    uint32_t consumed;
+};
+
+static struct net_rx_s net_rx_;
+
+static void net_send(struct net_rx_s * rx, uint8_t frame_type, const char * topic,
+                     const struct jsdrv_union_s * value, uint8_t codec) {
+    uint8_t buf[256];
+    uint32_t sz = jsdrv_net_encode(frame_type, topic, value, codec, buf, sizeof(buf));
+    assert_true(sz > 0);
+    assert_int_equal(0, jsdrv_os_socket_send(rx->sock, buf, sz));
+}
+
+static void net_recv(struct net_rx_s * rx, struct jsdrv_net_frame_s * frame) {
+    size_t sz;
+    if (rx->consumed) {
+        memmove(rx->buf, rx->buf + rx->consumed, rx->offset - rx->consumed);
+        rx->offset -= rx->consumed;
+        rx->consumed = 0;
+    }
+    for (int i = 0; i < 100; ++i) {
+        int32_t rc = jsdrv_net_decode(rx->buf, rx->offset, frame, rx->scratch, sizeof(rx->scratch));
+        if (0 == rc) {
+            rx->consumed = ((struct jsdrv_net_header_s *) rx->buf)->length;
+            return;
+        }
+        assert_int_equal(JSDRV_ERROR_TOO_SMALL, rc);
+        rc = jsdrv_os_socket_recv(rx->sock, rx->buf + rx->offset, sizeof(rx->buf) - rx->offset, 20, &sz);
+        if (0 == rc) {
+            rx->offset += (uint32_t) sz;
+        } else {
+            assert_int_equal(JSDRV_ERROR_TIMED_OUT, rc);
+        }
+    }
+    fail_msg("net frame timed out");
+}
+
+static void net_expect_rc(struct net_rx_s * rx, uint8_t frame_type, const char * topic, int32_t rc) {
+    struct jsdrv_net_frame_s frame;
+    net_recv(rx, &frame);
+    assert_int_equal(JSDRV_NET_FRAME_RETURN_CODE, frame.frame_type);
+    assert_string_equal(topic, frame.topic);
+    assert_int_equal(frame_type, frame.value.op);
+    assert_int_equal(rc, frame.value.value.i32);
+}
+
+static void test_net_server(void ** state) {
+    struct jsdrv_net_server_config_s config = {.host="127.0.0.1", .port=0, .queue_size=0};
+    struct jsdrv_net_server_s * server = NULL;
+    struct jsdrv_net_frame_s frame;
+    struct net_rx_s * rx = &net_rx_;
+    struct jsdrv_union_s v = jsdrv_union_null();
+    SETUP();
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_net_server_open(self->context, NULL, &server));
+    assert_int_equal(0, jsdrv_net_server_open(self->context, &config, &server));
+    assert_true(jsdrv_net_server_port(server) > 0);
+    memset(rx, 0, sizeof(*rx));
+    rx->sock = jsdrv_os_socket_connect("127.0.0.1", jsdrv_net_server_port(server));
+    assert_non_null(rx->sock);
+
+    v.flags = JSDRV_SFLAG_PUB;
+    net_send(rx, JSDRV_NET_FRAME_SUBSCRIBE, "n/net", &v, JSDRV_NET_CODEC_COMPRESS);
+    net_expect_rc(rx, JSDRV_NET_FRAME_SUBSCRIBE, "n/net", 0);
+
+    // local publish to the remote client
+    assert_int_equal(0, jsdrv_publish(self->context, "n/net/a", &jsdrv_union_u32_r(42), 0));
+    net_recv(rx, &frame);
+    assert_int_equal(JSDRV_NET_FRAME_PUBLISH, frame.frame_type);
+    assert_string_equal("n/net/a", frame.topic);
+    assert_true(jsdrv_union_eq(&jsdrv_union_u32_r(42), &frame.value));
+
+    // remote publish and query
+    net_send(rx, JSDRV_NET_FRAME_PUBLISH, "n/net/b", &jsdrv_union_cstr_r("hello"), 0);
+    for (int i = 0; i < 2; ++i) {  // update and return code in either order
+        net_recv(rx, &frame);
+        assert_string_equal("n/net/b", frame.topic);
+        if (JSDRV_NET_FRAME_PUBLISH == frame.frame_type) {
+            assert_string_equal("hello", frame.value.value.str);
+        } else {
+            assert_int_equal(JSDRV_NET_FRAME_RETURN_CODE, frame.frame_type);
+            assert_int_equal(0, frame.value.value.i32);
+        }
+    }
+    net_send(rx, JSDRV_NET_FRAME_QUERY, "n/net/b", NULL, 0);
+    net_recv(rx, &frame);
+    assert_int_equal(JSDRV_NET_FRAME_QUERY, frame.frame_type);
+    assert_string_equal("hello", frame.value.value.str);
+    net_send(rx, JSDRV_NET_FRAME_QUERY, "n/none", NULL, 0);
+    net_recv(rx, &frame);
+    assert_int_equal(JSDRV_NET_FRAME_RETURN_CODE, frame.frame_type);
+    assert_int_not_equal(0, frame.value.value.i32);
+
+    // compressed stream data
+    struct jsdrv_stream_signal_s * s = jsdrv_alloc_clr(sizeof(struct jsdrv_stream_signal_s));
+    s->sample_id = 1000;
+    s->element_type = JSDRV_DATA_TYPE_FLOAT;
+    s->element_size_bits = 32;
+    s->element_count = 1000;
+    for (uint32_t i = 0; i < s->element_count; ++i) {
+        ((float *) s->data)[i] = 1.0f;
+    }
+    v = jsdrv_union_bin((const uint8_t *) s, JSDRV_STREAM_HEADER_SIZE + s->element_count * sizeof(float));
+    v.app = JSDRV_PAYLOAD_TYPE_STREAM;
+    assert_int_equal(0, jsdrv_publish(self->context, "n/net/!data", &v, 0));
+    net_recv(rx, &frame);
+    assert_int_equal(JSDRV_NET_CODEC_XOR_F32, ((struct jsdrv_net_header_s *) rx->buf)->codec);
+    assert_true(rx->consumed < 1000);
+    assert_int_equal(v.size, frame.value.size);
+    assert_memory_equal(s, frame.value.value.bin, v.size);
+    jsdrv_free(s);
+
+    net_send(rx, JSDRV_NET_FRAME_UNSUBSCRIBE, "n/net", NULL, 0);
+    net_expect_rc(rx, JSDRV_NET_FRAME_UNSUBSCRIBE, "n/net", 0);
+    jsdrv_os_socket_close(rx->sock);
+    jsdrv_net_server_close(server);
+    TEARDOWN();
+}
+
+static void test_net_server_read_only(void ** state) {
+    struct jsdrv_net_server_config_s config = {.host=NULL, .port=0, .queue_size=0, .read_only=1};
+    struct jsdrv_net_server_s * server = NULL;
+    struct jsdrv_net_frame_s frame;
+    struct net_rx_s * rx = &net_rx_;
+    SETUP();
+    assert_int_equal(0, jsdrv_publish(self->context, "n/net/a", &jsdrv_union_u32_r(42), 0));
+    assert_int_equal(0, jsdrv_net_server_open(self->context, &config, &server));  // 127.0.0.1
+    memset(rx, 0, sizeof(*rx));
+    rx->sock = jsdrv_os_socket_connect("127.0.0.1", jsdrv_net_server_port(server));
+    assert_non_null(rx->sock);
+
+    net_send(rx, JSDRV_NET_FRAME_PUBLISH, "n/net/a", &jsdrv_union_u32_r(7), 0);
+    net_expect_rc(rx, JSDRV_NET_FRAME_PUBLISH, "n/net/a", JSDRV_ERROR_PERMISSIONS);
+    net_send(rx, JSDRV_NET_FRAME_QUERY, "n/net/a", NULL, 0);
+    net_recv(rx, &frame);
+    assert_int_equal(JSDRV_NET_FRAME_QUERY, frame.frame_type);
+    assert_true(jsdrv_union_eq(&jsdrv_union_u32_r(42), &frame.value));
+
+    jsdrv_os_socket_close(rx->sock);
+    jsdrv_net_server_close(server);
+    TEARDOWN();
+}
+
+struct net_client_sub_s {
+    volatile uint32_t count;
+    struct jsdrv_union_s value;
+    char str[32];
+};
+
+static void on_net_client(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    struct net_client_sub_s * sub = (struct net_client_sub_s *) user_data;
+    (void) topic;
+    sub->value = *value;
+    if (JSDRV_UNION_STR == value->type) {
+        jsdrv_cstr_copy(sub->str, value->value.str, sizeof(sub->str));
+    }
+    ++sub->count;
+}
+
+static bool net_client_wait(struct net_client_sub_s * sub, uint32_t count) {
+    for (int i = 0; (i < 200) && (sub->count < count); ++i) {
+        jsdrv_thread_sleep_ms(5);
+    }
+    return sub->count == count;
+}
+
+static void test_net_client(void ** state) {
+    struct jsdrv_net_server_config_s server_config = {.host="127.0.0.1", .port=0, .queue_size=0};
+    struct jsdrv_net_server_s * server = NULL;
+    struct jsdrv_net_client_s * client = NULL;
+    struct net_client_sub_s a;
+    struct net_client_sub_s b;
+    char str[32];
+    SETUP();
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    assert_int_equal(0, jsdrv_net_server_open(self->context, &server_config, &server));
+    struct jsdrv_net_client_config_s config = {.host=NULL, .port=jsdrv_net_server_port(server), .codec=0};
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_net_client_open(NULL, &client));
+    assert_int_equal(0, jsdrv_net_client_open(&config, &client));
+
+    // two local subscribers share one server subscription
+    assert_int_equal(0, jsdrv_publish(self->context, "n/netc/a", &jsdrv_union_u32_r(1), 0));
+    assert_int_equal(0, jsdrv_net_client_subscribe(client, "n/netc", JSDRV_SFLAG_PUB | JSDRV_SFLAG_RETAIN,
+                                                   on_net_client, &a, 1000));
+    assert_true(net_client_wait(&a, 1));
+    assert_int_equal(0, jsdrv_net_client_subscribe(client, "n/netc/a", JSDRV_SFLAG_PUB, on_net_client, &b, 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "n/netc/a", &jsdrv_union_u32_r(42), 0));
+    assert_true(net_client_wait(&a, 2));
+    assert_true(net_client_wait(&b, 1));
+    assert_true(jsdrv_union_eq(&jsdrv_union_u32_r(42), &b.value));
+
+    // client publish and query
+    assert_int_equal(0, jsdrv_net_client_publish(client, "n/netc/b", &jsdrv_union_cstr_r("hello"), 1000));
+    assert_true(net_client_wait(&a, 3));
+    assert_string_equal("hello", a.str);
+    struct jsdrv_union_s v = jsdrv_union_bin((uint8_t *) str, sizeof(str));
+    assert_int_equal(0, jsdrv_net_client_query(client, "n/netc/b", &v, 1000));
+    assert_int_equal(JSDRV_UNION_STR, v.type);
+    assert_string_equal("hello", str);
+    v = jsdrv_union_bin((uint8_t *) str, 2);
+    assert_int_equal(JSDRV_ERROR_TOO_SMALL, jsdrv_net_client_query(client, "n/netc/b", &v, 1000));
+    v = jsdrv_union_u32(0);
+    assert_int_equal(0, jsdrv_net_client_query(client, "n/netc/a", &v, 1000));
+    assert_int_equal(42, v.value.u32);
+    assert_int_not_equal(0, jsdrv_net_client_query(client, "n/none", &v, 1000));
+
+    // unsubscribe
+    assert_int_equal(JSDRV_ERROR_NOT_FOUND, jsdrv_net_client_unsubscribe(client, "n/netc", on_net_client, &b, 1000));
+    assert_int_equal(0, jsdrv_net_client_unsubscribe(client, "n/netc", on_net_client, &a, 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "n/netc/a", &jsdrv_union_u32_r(43), 0));
+    assert_true(net_client_wait(&b, 2));
+    assert_int_equal(3, a.count);
+    assert_int_equal(0, jsdrv_net_client_unsubscribe(client, "n/netc/a", on_net_client, &b, 1000));
+
+    jsdrv_net_client_close(client);
+    jsdrv_net_server_close(server);
+    TEARDOWN();
+}
+
+struct emulated_data_s {
+    volatile uint32_t count;        // received samples
+    volatile uint32_t gaps;
+    volatile uint32_t errors;
+    volatile uint32_t trailers;     // valid struct jsdrv_stream_latency_s
+    volatile uint32_t element_count_max;
+    uint64_t sample_id_next;
+};
+
+static float emulated_ramp_i(uint64_t sample_id) {
+    return (float) ((sample_id >> 1) & 0xffff) * (1.0f / 65536.0f);
+}
+
+static void on_emulated_data(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    struct emulated_data_s * e = (struct emulated_data_s *) user_data;
+    const struct jsdrv_stream_signal_s * s = (const struct jsdrv_stream_signal_s *) value->value.bin;
+    (void) topic;
+    if (e->count && (s->sample_id != e->sample_id_next)) {
+        ++e->gaps;
+    }
+    if (NULL != strstr(topic, "/js220/")) {
+        const float * f = (const float *) s->data;
+        for (uint32_t k = 0; k < s->element_count; ++k) {
+            if (f[k] != emulated_ramp_i(s->sample_id + (uint64_t) k * s->decimate_factor)) {
+                ++e->errors;
+            }
+        }
+    }
+    uint32_t offset = JSDRV_STREAM_HEADER_SIZE + (uint32_t) (((uint64_t) s->element_count * s->element_size_bits + 7) / 8);
+    offset = (offset + 7) & ~7U;
+    if (value->size == (offset + sizeof(struct jsdrv_stream_latency_s))) {
+        struct jsdrv_stream_latency_s t;
+        memcpy(&t, value->value.bin + offset, sizeof(t));
+        if (t.usb && (t.usb <= t.decode) && (t.decode <= t.dispatch) && (t.dispatch <= jsdrv_time_monotonic())) {
+            ++e->trailers;
+        } else {
+            ++e->errors;
+        }
+    }
+    if (s->element_count > e->element_count_max) {
+        e->element_count_max = s->element_count;
+    }
+    e->sample_id_next = s->sample_id + (uint64_t) s->element_count * s->decimate_factor;
+    e->count += s->element_count;
+}
+
+static void emulated_stream(struct test_s * self, const char * prefix, struct emulated_data_s * e, uint32_t samples) {
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    memset(e, 0, sizeof(*e));
+    snprintf(topic, sizeof(topic), "%s/s/i/!data", prefix);
+    assert_int_equal(0, jsdrv_open(self->context, prefix, JSDRV_DEVICE_OPEN_MODE_DEFAULTS));
+    assert_int_equal(0, jsdrv_subscribe(self->context, topic, JSDRV_SFLAG_PUB, on_emulated_data, e, 1000));
+    snprintf(topic, sizeof(topic), "%s/s/i/ctrl", prefix);
+    assert_int_equal(0, jsdrv_publish(self->context, topic, &jsdrv_union_u32(1), 1000));
+    for (int i = 0; (i < 5000) && (e->count < samples); ++i) {
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(0, jsdrv_publish(self->context, topic, &jsdrv_union_u32(0), 1000));
+    snprintf(topic, sizeof(topic), "%s/s/i/!data", prefix);
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, topic, on_emulated_data, e, 1000));
+    assert_int_equal(0, jsdrv_close(self->context, prefix));
+    assert_true(e->count >= samples);
+}
+
+static void test_emulated_js220(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_PATTERN, .value=jsdrv_union_u32(JSDRV_EMULATED_PATTERN_RAMP)},
+            {.topic=JSDRV_ARG_EMULATED_SPEED, .value=jsdrv_union_u32(0)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct emulated_data_s e;
+    SETUP_ARGS(args);
+    emulated_stream(self, "z/js220/EMU001", &e, 200000);
+    assert_int_equal(0, e.gaps);
+    assert_int_equal(0, e.errors);
+    TEARDOWN();
+}
+
+static void test_emulated_js220_executor(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_PATTERN, .value=jsdrv_union_u32(JSDRV_EMULATED_PATTERN_RAMP)},
+            {.topic=JSDRV_ARG_EMULATED_SPEED, .value=jsdrv_union_u32(0)},
+            {.topic=JSDRV_ARG_DEVICE_THREADS, .value=jsdrv_union_u32(2)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct emulated_data_s e;
+    SETUP_ARGS(args);
+    emulated_stream(self, "z/js220/EMU001", &e, 200000);
+    assert_int_equal(0, e.gaps);
+    assert_int_equal(0, e.errors);
+    TEARDOWN();
+}
+
+static void test_emulated_js220_codec(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_PATTERN, .value=jsdrv_union_u32(JSDRV_EMULATED_PATTERN_RAMP)},
+            {.topic=JSDRV_ARG_EMULATED_SPEED, .value=jsdrv_union_u32(0)},
+            {.topic=JSDRV_ARG_EMULATED_CODEC, .value=jsdrv_union_u32(1)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct emulated_data_s e;
+    SETUP_ARGS(args);
+    emulated_stream(self, "z/js220/EMU001", &e, 200000);
+    assert_int_equal(0, e.gaps);  // undecoded frames would skip
+    assert_int_equal(0, e.errors);
+    TEARDOWN();
+}
+
+static void test_emulated_measure(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_PATTERN, .value=jsdrv_union_u32(JSDRV_EMULATED_PATTERN_RAMP)},
+            {.topic=JSDRV_ARG_EMULATED_SPEED, .value=jsdrv_union_u32(0)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct jsdrv_statistics_s stats;
+    struct jsdrv_union_s value;
+    const uint32_t sample_count = 4 * 65536;  // whole ramp periods
+    SETUP_ARGS(args);
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_measure(self->context, "z/js220/EMU001", 0, &stats, 1000));
+    assert_int_equal(0, jsdrv_open(self->context, "z/js220/EMU001", JSDRV_DEVICE_OPEN_MODE_DEFAULTS));
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/stats/window", &jsdrv_union_u32_r(1000), 1000));
+    memset(&stats, 0, sizeof(stats));
+    assert_int_equal(0, jsdrv_measure(self->context, "z/js220/EMU001", sample_count, &stats, 5000));
+    assert_int_equal(sample_count, stats.block_sample_count);
+    assert_float_equal(0.5 - 0.5 / 65536, stats.i_avg, 1e-6);
+    assert_float_equal(0.0, stats.i_min, 1e-9);
+    assert_float_equal(1.0 - 1.0 / 65536, stats.i_max, 1e-6);
+    assert_float_equal(stats.i_avg * sample_count * 1e-6, stats.charge_f64, 1e-6);
+
+    // restored
+    value = jsdrv_union_u32(0);
+    assert_int_equal(0, jsdrv_query(self->context, "z/js220/EMU001/h/stats/window", &value, 1000));
+    assert_int_equal(1000, value.value.u32);
+    value = jsdrv_union_u32(1);
+    assert_int_equal(0, jsdrv_query(self->context, "z/js220/EMU001/s/i/ctrl", &value, 1000));
+    assert_int_equal(0, value.value.u32);
+    assert_int_equal(0, jsdrv_close(self->context, "z/js220/EMU001"));
+    TEARDOWN();
+}
+
+static void test_usb_budget(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_SPEED, .value=jsdrv_union_u32(0)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct jsdrv_union_s value;
+    SETUP_ARGS(args);
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/usb/budget", &jsdrv_union_u32(1000000), 1000));
+    assert_int_equal(0, jsdrv_open(self->context, "z/js220/EMU001", JSDRV_DEVICE_OPEN_MODE_DEFAULTS));
+    // 1 Msps f32 current is 4 MB/s plus frame headers
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE,
+                     jsdrv_publish(self->context, "z/js220/EMU001/s/i/ctrl", &jsdrv_union_u32(1), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/usb/budget", &jsdrv_union_u32(0), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/s/i/ctrl", &jsdrv_union_u32(1), 1000));
+    value = jsdrv_union_u32(0);
+    assert_int_equal(0, jsdrv_query(self->context, "z/js220/EMU001/h/usb/bw", &value, 1000));
+    assert_int_equal(4063493, value.value.u32);
+    value = jsdrv_union_u32(0);
+    for (int i = 0; (i < 1000) && (0 == value.value.u32); ++i) {
+        jsdrv_thread_sleep_ms(1);
+        jsdrv_query(self->context, "z/js220/EMU001/h/usb/bulk_in/actual", &value, 1000);
+    }
+    assert_int_equal(JSDRV_USBBK_BULK_IN_DEPTH_DEFAULT, value.value.u32);
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/s/i/ctrl", &jsdrv_union_u32(0), 1000));
+    assert_int_equal(0, jsdrv_close(self->context, "z/js220/EMU001"));
+    TEARDOWN();
+}
+
+static void on_continuity(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    (void) topic;
+    assert_int_equal(JSDRV_PAYLOAD_TYPE_CONTINUITY, value->app);
+    assert_int_equal(sizeof(struct jsdrv_continuity_s), value->size);
+    memcpy(user_data, value->value.bin, sizeof(struct jsdrv_continuity_s));
+}
+
+static void test_emulated_js220_skip(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_PATTERN, .value=jsdrv_union_u32(JSDRV_EMULATED_PATTERN_RAMP)},
+            {.topic=JSDRV_ARG_EMULATED_SPEED, .value=jsdrv_union_u32(0)},
+            {.topic=JSDRV_ARG_EMULATED_SKIP, .value=jsdrv_union_u32(100)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct emulated_data_s e;
+    struct jsdrv_continuity_s c;
+    memset(&c, 0, sizeof(c));
+    memset(&e, 0, sizeof(e));
+    SETUP_ARGS(args);
+    assert_int_equal(0, jsdrv_open(self->context, "z/js220/EMU001", JSDRV_DEVICE_OPEN_MODE_DEFAULTS));
+    assert_int_equal(0, jsdrv_subscribe(self->context, "z/js220/EMU001/s/i/!data", JSDRV_SFLAG_PUB,
+                                        on_emulated_data, &e, 1000));
+    assert_int_equal(0, jsdrv_subscribe(self->context, "z/js220/EMU001/s/i/gaps", JSDRV_SFLAG_PUB,
+                                        on_continuity, &c, 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/s/i/ctrl", &jsdrv_union_u32(1), 1000));
+    for (int i = 0; (i < 5000) && ((e.count < 200000) || (0 == c.version)); ++i) {
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/s/i/ctrl", &jsdrv_union_u32(0), 1000));
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, "z/js220/EMU001/s/i/!data", on_emulated_data, &e, 1000));
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, "z/js220/EMU001/s/i/gaps", on_continuity, &c, 1000));
+    assert_int_equal(0, jsdrv_close(self->context, "z/js220/EMU001"));
+    assert_true(e.gaps > 0);
+    assert_int_equal(0, e.errors);
+    assert_int_equal(1, c.version);
+    assert_true(c.skip_count > 0);
+    assert_true(c.gap_count > 0);
+    assert_true(c.gaps[0].length > 0);
+    assert_true(c.skip_length >= c.gaps[0].length);
+    TEARDOWN();
+}
+
+static void on_tap_data(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    struct emulated_data_s * e = (struct emulated_data_s *) user_data;
+    const struct jsdrv_stream_signal_s * s = (const struct jsdrv_stream_signal_s *) value->value.bin;
+    (void) topic;
+    if ((e->count && (s->sample_id != e->sample_id_next)) || (2000 != s->decimate_factor)) {
+        ++e->gaps;
+    }
+    const float * f = (const float *) s->data;
+    for (uint32_t k = 0; k < s->element_count; ++k) {
+        if (!isfinite(f[k]) || (f[k] < -0.25f) || (f[k] > 1.25f)) {  // the ramp is in [0, 1), filter rings at wrap
+            ++e->errors;
+        }
+    }
+    e->sample_id_next = s->sample_id + (uint64_t) s->element_count * s->decimate_factor;
+    e->count += s->element_count;
+}
+
+static void test_tap(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_PATTERN, .value=jsdrv_union_u32(JSDRV_EMULATED_PATTERN_RAMP)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct emulated_data_s e;
+    struct emulated_data_s tap;
+    memset(&e, 0, sizeof(e));
+    memset(&tap, 0, sizeof(tap));
+    SETUP_ARGS(args);
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID,
+                     jsdrv_publish(self->context, "z/js220/EMU001/h/tap/9/fs", &jsdrv_union_u32(1000), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/tap/0/fs", &jsdrv_union_u32(1000), 1000));
+    assert_int_equal(0, jsdrv_open(self->context, "z/js220/EMU001", JSDRV_DEVICE_OPEN_MODE_DEFAULTS));
+    assert_int_equal(0, jsdrv_subscribe(self->context, "z/js220/EMU001/s/i/!data", JSDRV_SFLAG_PUB,
+                                        on_emulated_data, &e, 1000));
+    assert_int_equal(0, jsdrv_subscribe(self->context, "z/js220/EMU001/s/i/tap/0/!data", JSDRV_SFLAG_PUB,
+                                        on_tap_data, &tap, 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/s/i/ctrl", &jsdrv_union_u32(1), 1000));
+    for (int i = 0; (i < 5000) && (tap.count < 200); ++i) {
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/s/i/ctrl", &jsdrv_union_u32(0), 1000));
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, "z/js220/EMU001/s/i/tap/0/!data", on_tap_data, &tap, 1000));
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, "z/js220/EMU001/s/i/!data", on_emulated_data, &e, 1000));
+    assert_int_equal(0, jsdrv_close(self->context, "z/js220/EMU001"));
+    assert_true(tap.count >= 200);
+    assert_true(e.count >= 100000);  // the full rate stream continues
+    assert_int_equal(0, e.gaps);
+    assert_int_equal(0, e.errors);
+    assert_int_equal(0, tap.gaps);
+    assert_int_equal(0, tap.errors);
+    TEARDOWN();
+}
+
+static void on_frame_data(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    struct emulated_data_s * e = (struct emulated_data_s *) user_data;
+    const struct jsdrv_stream_frame_s * f = (const struct jsdrv_stream_frame_s *) value->value.bin;
+    (void) topic;
+    if ((JSDRV_PAYLOAD_TYPE_STREAM_FRAME != value->app) || (4 != f->channel_count) || (2 != f->decimate_factor)
+            || (JSDRV_FIELD_CURRENT != f->channels[0].field_id) || (JSDRV_FIELD_VOLTAGE != f->channels[1].field_id)
+            || (JSDRV_FIELD_RANGE != f->channels[2].field_id) || (JSDRV_FIELD_GPI != f->channels[3].field_id)
+            || (value->size > sizeof(*f))) {
+        ++e->errors;
+        return;
+    }
+    if (e->count && (f->sample_id != e->sample_id_next)) {
+        ++e->gaps;
+    }
+    const float * i = (const float *) (f->data + f->channels[0].offset);
+    const float * v = (const float *) (f->data + f->channels[1].offset);
+    const uint8_t * range = f->data + f->channels[2].offset;
+    const uint8_t * gpi = f->data + f->channels[3].offset;
+    for (uint32_t k = 0; k < f->element_count; ++k) {
+        uint64_t sample_id = f->sample_id + (uint64_t) k * f->decimate_factor;
+        float v_expect = 1.0f + (float) (((sample_id >> 1) >> 8) & 0xff) * (1.0f / 256.0f);
+        if ((i[k] != emulated_ramp_i(sample_id)) || (v[k] != v_expect) || (0 != range[k])
+                || (gpi[k] != ((sample_id >> 12) & 1))) {
+            ++e->errors;
+        }
+    }
+    e->sample_id_next = f->sample_id + (uint64_t) f->element_count * f->decimate_factor;
+    e->count += f->element_count;
+}
+
+static void test_stream_frame(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_PATTERN, .value=jsdrv_union_u32(JSDRV_EMULATED_PATTERN_RAMP)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    static const char * CTRL[] = {
+            "z/js220/EMU001/s/i/ctrl", "z/js220/EMU001/s/v/ctrl",
+            "z/js220/EMU001/s/i/range/ctrl", "z/js220/EMU001/s/gpi/0/ctrl", NULL};
+    struct emulated_data_s e;
+    memset(&e, 0, sizeof(e));
+    SETUP_ARGS(args);
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/stream/frame", &jsdrv_union_u32(1), 1000));
+    assert_int_equal(0, jsdrv_open(self->context, "z/js220/EMU001", JSDRV_DEVICE_OPEN_MODE_DEFAULTS));
+    assert_int_equal(0, jsdrv_subscribe(self->context, "z/js220/EMU001/s/frame/!data", JSDRV_SFLAG_PUB,
+                                        on_frame_data, &e, 1000));
+    for (const char ** ctrl = CTRL; *ctrl; ++ctrl) {
+        assert_int_equal(0, jsdrv_publish(self->context, *ctrl, &jsdrv_union_u32(1), 1000));
+    }
+    for (int i = 0; (i < 5000) && (e.count < 200000); ++i) {
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, "z/js220/EMU001/s/frame/!data", on_frame_data, &e, 1000));
+    assert_int_equal(0, jsdrv_close(self->context, "z/js220/EMU001"));
+    assert_true(e.count >= 200000);
+    assert_int_equal(0, e.gaps);
+    assert_int_equal(0, e.errors);
+    TEARDOWN();
+}
+
+struct rate_data_s {
+    volatile uint32_t count;        // received samples at decimate_factor
+    volatile uint32_t changes;
+    volatile uint32_t gaps;
+    volatile uint32_t decimate_factor;
+    uint64_t sample_id_next;
+};
+
+static void on_rate_data(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    struct rate_data_s * e = (struct rate_data_s *) user_data;
+    const struct jsdrv_stream_signal_s * s = (const struct jsdrv_stream_signal_s *) value->value.bin;
+    (void) topic;
+    if (0 == e->decimate_factor) {
+        // first message
+    } else if (s->decimate_factor == e->decimate_factor) {
+        if (s->sample_id != e->sample_id_next) {
+            ++e->gaps;
+        }
+    } else {
+        // the new chain starts within one output of the old chain
+        uint32_t k = (s->decimate_factor > e->decimate_factor) ? s->decimate_factor : e->decimate_factor;
+        if (((s->sample_id + e->decimate_factor) < e->sample_id_next) || (s->sample_id > (e->sample_id_next + 2 * k))) {
+            ++e->gaps;
+        }
+        ++e->changes;
+        e->count = 0;
+    }
+    e->decimate_factor = s->decimate_factor;
+    e->sample_id_next = s->sample_id + (uint64_t) s->element_count * s->decimate_factor;
+    e->count += s->element_count;
+}
+
+static void rate_await(struct rate_data_s * e, uint32_t decimate_factor, uint32_t samples) {
+    for (int i = 0; (i < 5000) && ((e->decimate_factor != decimate_factor) || (e->count < samples)); ++i) {
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(decimate_factor, e->decimate_factor);
+    assert_true(e->count >= samples);
+}
+
+static void test_sampling_frequency_seamless(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_PATTERN, .value=jsdrv_union_u32(JSDRV_EMULATED_PATTERN_RAMP)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct rate_data_s e;
+    memset(&e, 0, sizeof(e));
+    SETUP_ARGS(args);
+    assert_int_equal(0, jsdrv_open(self->context, "z/js220/EMU001", JSDRV_DEVICE_OPEN_MODE_DEFAULTS));
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/fs", &jsdrv_union_u32(100000), 1000));
+    assert_int_equal(0, jsdrv_subscribe(self->context, "z/js220/EMU001/s/i/!data", JSDRV_SFLAG_PUB,
+                                        on_rate_data, &e, 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/s/i/ctrl", &jsdrv_union_u32(1), 1000));
+    rate_await(&e, 20, 10000);
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/fs", &jsdrv_union_u32(50000), 1000));
+    rate_await(&e, 40, 5000);
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/fs", &jsdrv_union_u32(200000), 1000));
+    rate_await(&e, 10, 20000);
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, "z/js220/EMU001/s/i/!data", on_rate_data, &e, 1000));
+    assert_int_equal(0, jsdrv_close(self->context, "z/js220/EMU001"));
+    assert_int_equal(2, e.changes);
+    assert_int_equal(0, e.gaps);
+    TEARDOWN();
+}
+
+static void test_trace(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_PATTERN, .value=jsdrv_union_u32(JSDRV_EMULATED_PATTERN_RAMP)},
+            {.topic=JSDRV_ARG_EMULATED_SPEED, .value=jsdrv_union_u32(0)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct emulated_data_s e;
+    const char * path = "frontend_test_trace.json";
+    SETUP_ARGS(args);
+    assert_int_equal(0, jsdrv_publish(self->context, JSDRV_MSG_TRACE "/!start", &jsdrv_union_u32(4096), 1000));
+    emulated_stream(self, "z/js220/EMU001", &e, 100000);
+    assert_int_equal(0, jsdrv_publish(self->context, JSDRV_MSG_TRACE "/!stop", &jsdrv_union_cstr(path), 1000));
+    assert_int_equal(JSDRV_ERROR_NOT_FOUND,
+                     jsdrv_publish(self->context, JSDRV_MSG_TRACE "/!other", &jsdrv_union_u32(0), 1000));
+    TEARDOWN();
+
+    FILE * f = fopen(path, "rb");
+    assert_non_null(f);
+    char buf[4096];
+    bool front = false;
+    bool device = false;
+    bool dev_rsp = false;
+    bool publish = false;
+    while (fgets(buf, sizeof(buf), f)) {
+        front |= (NULL != strstr(buf, "\"args\":{\"name\":\"front."));
+        device |= (NULL != strstr(buf, "\"args\":{\"name\":\"device."));
+        dev_rsp |= (NULL != strstr(buf, "\"name\":\"dev_rsp\""));
+        publish |= (NULL != strstr(buf, "\"name\":\"publish\""));
+    }
+    fclose(f);
+    remove(path);
+    assert_true(front);
+    assert_true(device);
+    assert_true(dev_rsp);
+    assert_true(publish);
+}
+
+static void test_latency_trailer(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_PATTERN, .value=jsdrv_union_u32(JSDRV_EMULATED_PATTERN_RAMP)},
+            {.topic=JSDRV_ARG_EMULATED_SPEED, .value=jsdrv_union_u32(0)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct emulated_data_s e;
+    uint64_t bins[JSDRV_LATENCY_BINS];
+    SETUP_ARGS(args);
+    uint64_t total = jsdrv_latency_get(JSDRV_LATENCY_TOTAL, bins);
+    emulated_stream(self, "z/js220/EMU001", &e, 100000);
+    assert_int_equal(0, e.trailers);  // disabled by default
+    assert_true(jsdrv_latency_get(JSDRV_LATENCY_TOTAL, bins) > total);
+    assert_true(jsdrv_latency_get(JSDRV_LATENCY_DECODE, bins) > 0);
+
+    assert_int_equal(0, jsdrv_publish(self->context, JSDRV_MSG_LATENCY "/trailer", &jsdrv_union_u8(1), 1000));
+    emulated_stream(self, "z/js220/EMU001", &e, 100000);
+    assert_true(e.trailers > 0);
+    assert_int_equal(0, e.errors);
+    assert_int_equal(0, e.gaps);
+    TEARDOWN();
+}
+
+static void stream_latency_check(struct test_s * self, const char * prefix) {
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    struct emulated_data_s e;
+    emulated_stream(self, prefix, &e, 200000);
+    uint32_t default_max = e.element_count_max;
+    snprintf(topic, sizeof(topic), "%s/h/stream/latency", prefix);
+    assert_int_equal(0, jsdrv_publish(self->context, topic, &jsdrv_union_u32_r(1), 1000));
+    emulated_stream(self, prefix, &e, 200000);
+    assert_int_equal(0, e.gaps);
+    assert_true(e.element_count_max < default_max);
+    assert_int_equal(0, jsdrv_publish(self->context, topic, &jsdrv_union_u32(0), 1000));
+    emulated_stream(self, prefix, &e, 200000);
+    assert_int_equal(0, e.gaps);
+#if JSDRV_STREAM_DATA_SIZE > 16384
+    assert_true(e.element_count_max < default_max);
+#else  // one bulk in transfer already fills the smaller messages
+    assert_true(e.element_count_max <= default_max);
+#endif
+}
+
+static void test_stream_latency(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_JS110, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_PATTERN, .value=jsdrv_union_u32(JSDRV_EMULATED_PATTERN_RAMP)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    SETUP_ARGS(args);
+    stream_latency_check(self, "z/js220/EMU001");
+    stream_latency_check(self, "z/js110/EMU001");
+    TEARDOWN();
+}
+
+struct trigger_data_s {
+    uint32_t count;
+    uint32_t errors;
+    volatile uint32_t rsp_count;
+};
+
+static void on_trigger_event(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    struct trigger_data_s * t = (struct trigger_data_s *) user_data;
+    (void) topic;
+    const struct jsdrv_trigger_event_s * ev = (const struct jsdrv_trigger_event_s *) value->value.bin;
+    if ((value->app != JSDRV_PAYLOAD_TYPE_TRIGGER) || (value->size != sizeof(*ev))) {
+        ++t->errors;
+        return;
+    }
+    // ramp current crosses 0.5 rising at the middle of each 65536 sample period
+    if ((1 != ev->version) || (0 != ev->edge) || (ev->value < 0.5f) || (0 == ev->utc)
+            || (ev->value != emulated_ramp_i(ev->sample_id))
+            || (emulated_ramp_i(ev->sample_id - ev->decimate_factor) >= 0.5f)) {
+        ++t->errors;
+    }
+    ++t->count;
+}
+
+static void on_snapshot_rsp(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    struct trigger_data_s * t = (struct trigger_data_s *) user_data;
+    (void) topic;
+    const struct jsdrv_buffer_response_s * rsp = (const struct jsdrv_buffer_response_s *) value->value.bin;
+    if ((value->app != JSDRV_PAYLOAD_TYPE_BUFFER_RSP) || (1000 != rsp->info.time_range_samples.length)) {
+        ++t->errors;
+    }
+    ++t->rsp_count;
+}
+
+static void test_trigger(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_PATTERN, .value=jsdrv_union_u32(JSDRV_EMULATED_PATTERN_RAMP)},
+            {.topic=JSDRV_ARG_EMULATED_SPEED, .value=jsdrv_union_u32(0)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    const char * prefix = "z/js220/EMU001";
+    struct emulated_data_s e;
+    struct trigger_data_s t;
+    struct jsdrv_union_s value;
+    struct jsdrv_buffer_request_s req;
+    memset(&t, 0, sizeof(t));
+    SETUP_ARGS(args);
+    assert_int_equal(0, jsdrv_publish(self->context, "m/@/!add", &jsdrv_union_u8(3), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "m/003/a/!add", &jsdrv_union_u8(1), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "m/003/s/001/topic",
+                                      &jsdrv_union_cstr("z/js220/EMU001/s/i/!data"), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "m/003/g/size", &jsdrv_union_u64(10000000LLU), 1000));
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_publish(self->context, "m/003/g/!snap", &jsdrv_union_u8(1), 1000));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID,
+                     jsdrv_publish(self->context, "z/js220/EMU001/h/trig/4/source", &jsdrv_union_u8(1), 1000));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID,
+                     jsdrv_publish(self->context, "z/js220/EMU001/h/trig/0/edge", &jsdrv_union_u8(3), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/trig/0/source", &jsdrv_union_u8(1), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/trig/0/level", &jsdrv_union_f32(0.5f), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/trig/0/hyst", &jsdrv_union_f32(0.1f), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/trig/0/dur", &jsdrv_union_f32(0.001f), 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/trig/0/snap", &jsdrv_union_u8(3), 1000));
+    assert_int_equal(0, jsdrv_subscribe(self->context, "z/js220/EMU001/h/trig/0/!event", JSDRV_SFLAG_PUB,
+                                        on_trigger_event, &t, 1000));
+    emulated_stream(self, prefix, &e, 400000);
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, "z/js220/EMU001/h/trig/0/!event",
+                                          on_trigger_event, &t, 1000));
+    assert_int_equal(0, e.errors);
+    assert_true(t.count >= 2);
+    assert_int_equal(0, t.errors);
+    for (int i = 0; i < 1000; ++i) {
+        assert_int_equal(0, jsdrv_query(self->context, "m/003/g/snap", &value, 1000));
+        if (2 == value.value.u8) {
+            break;
+        }
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(2, value.value.u8);
+
+    // read the start of the snapshot, once queued trigger snapshots complete
+    struct jsdrv_buffer_info_s info;
+    struct jsdrv_buffer_info_s info_prev;
+    memset(&info_prev, 0, sizeof(info_prev));
+    for (int i = 0; i < 100; ++i) {
+        value = jsdrv_union_bin((uint8_t *) &info, sizeof(info));
+        assert_int_equal(0, jsdrv_query(self->context, "m/003/s/001/snap", &value, 1000));
+        if ((info.time_range_samples.start == info_prev.time_range_samples.start)
+                && (info.time_range_samples.length == info_prev.time_range_samples.length)) {
+            break;
+        }
+        info_prev = info;
+        jsdrv_thread_sleep_ms(20);
+    }
+    assert_true(info.time_range_samples.length > 1000);
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = JSDRV_TIME_SAMPLES;
+    req.flags = JSDRV_BUFFER_REQUEST_FLAG_SNAPSHOT;
+    req.time.samples.start = info.time_range_samples.start;
+    req.time.samples.length = 1000;
+    jsdrv_cstr_copy(req.rsp_topic, "m/003/s/001/!rsp", sizeof(req.rsp_topic));
+    assert_int_equal(0, jsdrv_subscribe(self->context, req.rsp_topic, JSDRV_SFLAG_PUB, on_snapshot_rsp, &t, 1000));
+    assert_int_equal(0, jsdrv_publish(self->context, "m/003/s/001/!req",
+                                      &jsdrv_union_cbin((uint8_t *) &req, sizeof(req)), 1000));
+    for (int i = 0; (i < 1000) && (0 == t.rsp_count); ++i) {
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, req.rsp_topic, on_snapshot_rsp, &t, 1000));
+    assert_int_equal(1, t.rsp_count);
+    assert_int_equal(0, t.errors);
+    assert_int_equal(0, jsdrv_publish(self->context, "m/@/!remove", &jsdrv_union_u8(3), 1000));
+    TEARDOWN();
+}
+
+struct event_data_s {
+    volatile uint32_t count;        // spanned samples
+    volatile uint32_t messages;     // JSDRV_PAYLOAD_TYPE_STREAM_EVENT
+    volatile uint32_t packed;       // JSDRV_PAYLOAD_TYPE_STREAM
+    volatile uint32_t events;
+    volatile uint32_t gaps;
+    volatile uint32_t errors;
+    uint64_t sample_id_next;
+};
+
+// The emulated JS220 GPI 0 toggles every 4096 samples.
+static void on_event_data(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    struct event_data_s * e = (struct event_data_s *) user_data;
+    const struct jsdrv_stream_signal_s * s = (const struct jsdrv_stream_signal_s *) value->value.bin;
+    (void) topic;
+    if (JSDRV_PAYLOAD_TYPE_STREAM == value->app) {
+        ++e->packed;
+        return;
+    } else if (JSDRV_PAYLOAD_TYPE_STREAM_EVENT != value->app) {
+        ++e->errors;
+        return;
+    }
+    if (e->messages && (s->sample_id != e->sample_id_next)) {
+        ++e->gaps;
+    }
+    uint32_t n = (value->size - JSDRV_STREAM_HEADER_SIZE) / sizeof(struct jsdrv_stream_event_s);
+    const struct jsdrv_stream_event_s * ev = (const struct jsdrv_stream_event_s *) s->data;
+    if ((0 == n) || (0 != ev[0].offset)) {
+        ++e->errors;
+    }
+    for (uint32_t k = 0; k < n; ++k) {
+        uint64_t sample_id = s->sample_id + (uint64_t) ev[k].offset * s->decimate_factor;
+        if ((ev[k].value != ((sample_id >> 12) & 1)) || (k && (sample_id & 0xfff))
+                || (ev[k].offset >= s->element_count)) {
+            ++e->errors;
+        }
+    }
+    e->events += n;
+    e->sample_id_next = s->sample_id + (uint64_t) s->element_count * s->decimate_factor;
+    e->count += s->element_count;
+    ++e->messages;
+}
+
+static void event_stream(struct test_s * self, const char * prefix, struct event_data_s * e, uint32_t samples) {
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    memset(e, 0, sizeof(*e));
+    snprintf(topic, sizeof(topic), "%s/s/gpi/0/!data", prefix);
+    assert_int_equal(0, jsdrv_open(self->context, prefix, JSDRV_DEVICE_OPEN_MODE_DEFAULTS));
+    assert_int_equal(0, jsdrv_subscribe(self->context, topic, JSDRV_SFLAG_PUB, on_event_data, e, 1000));
+    snprintf(topic, sizeof(topic), "%s/s/gpi/0/ctrl", prefix);
+    assert_int_equal(0, jsdrv_publish(self->context, topic, &jsdrv_union_u32(1), 1000));
+    for (int i = 0; (i < 5000) && (e->count < samples) && (0 == e->packed); ++i) {
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(0, jsdrv_publish(self->context, topic, &jsdrv_union_u32(0), 1000));
+    snprintf(topic, sizeof(topic), "%s/s/gpi/0/!data", prefix);
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, topic, on_event_data, e, 1000));
+    assert_int_equal(0, jsdrv_close(self->context, prefix));
+}
+
+static void test_stream_event(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_PATTERN, .value=jsdrv_union_u32(JSDRV_EMULATED_PATTERN_RAMP)},
+            {.topic=JSDRV_ARG_EMULATED_SPEED, .value=jsdrv_union_u32(0)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    const char * prefix = "z/js220/EMU001";
+    struct event_data_s e;
+    SETUP_ARGS(args);
+    event_stream(self, prefix, &e, 1000);
+    assert_true(e.packed > 0);  // disabled by default
+    assert_int_equal(0, e.messages);
+
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/stream/event", &jsdrv_union_u8(1), 1000));
+    event_stream(self, prefix, &e, 2000000);
+    assert_true(e.count >= 2000000);
+    assert_int_equal(0, e.packed);
+    assert_int_equal(0, e.gaps);
+    assert_int_equal(0, e.errors);
+    assert_true((e.events * sizeof(struct jsdrv_stream_event_s) * 32) < (e.count / 8));  // vs packed u1
+    assert_true(e.messages < 16);
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js220/EMU001/h/stream/event", &jsdrv_union_u8(0), 1000));
+    TEARDOWN();
+}
+
+static void test_emulated_js110(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS110, .value=jsdrv_union_u32(1)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct emulated_data_s e;
+    SETUP_ARGS(args);
+    emulated_stream(self, "z/js110/EMU001", &e, 200000);
+    assert_int_equal(0, e.gaps);
+    TEARDOWN();
+}
+
+struct rc_count_s {
+    volatile uint32_t ok;
+    volatile uint32_t errors;
+};
+
+static void on_rc_count(void * user_data, const char * topic, const struct jsdrv_union_s * value) {
+    struct rc_count_s * c = (struct rc_count_s *) user_data;
+    if ('#' != topic[strlen(topic) - 1]) {
+        return;
+    }
+    if (0 == value->value.i32) {
+        ++c->ok;
+    } else {
+        ++c->errors;
+    }
+}
+
+static void test_js110_settings_burst(void ** state) {
+    struct jsdrv_arg_s args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS110, .value=jsdrv_union_u32(1)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    static const char * TOPICS[] = {
+            "z/js110/EMU001/s/i/range/select", "z/js110/EMU001/s/v/range/select",
+            "z/js110/EMU001/s/gpo/0/value",
+            "z/js110/EMU001/s/gpo/1/value", NULL};
+    struct rc_count_s c;
+    struct emulated_data_s e;
+    memset(&c, 0, sizeof(c));
+    SETUP_ARGS(args);
+    assert_int_equal(0, jsdrv_open(self->context, "z/js110/EMU001", JSDRV_DEVICE_OPEN_MODE_DEFAULTS));
+    assert_int_equal(0, jsdrv_subscribe(self->context, "z/js110/EMU001/s", JSDRV_SFLAG_RETURN_CODE,
+                                        on_rc_count, &c, 1000));
+    for (const char ** t = TOPICS; *t; ++t) {
+        assert_int_equal(0, jsdrv_publish(self->context, *t, &jsdrv_union_u8(1), 0));
+    }
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js110/EMU001/s/extio/voltage", &jsdrv_union_u32(1800), 0));
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js110/EMU001/s/i/lsb_src", &jsdrv_union_u8(2), 1000));
+    for (int i = 0; (i < 1000) && (c.ok < 6); ++i) {
+        jsdrv_thread_sleep_ms(1);
+    }
+    assert_int_equal(6, c.ok);
+    assert_int_equal(0, c.errors);
+    assert_int_equal(0, jsdrv_publish(self->context, "z/js110/EMU001/s/gpi/+/!req", &jsdrv_union_u8(0), 1000));
+    assert_int_equal(0, jsdrv_unsubscribe(self->context, "z/js110/EMU001/s", on_rc_count, &c, 1000));
+    assert_int_equal(0, jsdrv_close(self->context, "z/js110/EMU001"));
+    emulated_stream(self, "z/js110/EMU001", &e, 100000);
+    assert_int_equal(0, e.gaps);
+    TEARDOWN();
+}
+
+static void test_usb_replay_js220(void ** state) {
+    struct jsdrv_arg_s record_args[] = {
+            {.topic=JSDRV_ARG_EMULATED_JS220, .value=jsdrv_union_u32(1)},
+            {.topic=JSDRV_ARG_EMULATED_PATTERN, .value=jsdrv_union_u32(JSDRV_EMULATED_PATTERN_RAMP)},
+            {.topic=JSDRV_ARG_EMULATED_SPEED, .value=jsdrv_union_u32(0)},
+            {.topic=JSDRV_ARG_USB_TRACE, .value=jsdrv_union_str(".")},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct jsdrv_arg_s replay_args[] = {
+            {.topic=JSDRV_ARG_USB_REPLAY, .value=jsdrv_union_str("./js220_EMU001.usbtrace")},
+            {.topic=JSDRV_ARG_USB_REPLAY_SPEED, .value=jsdrv_union_u32(0)},
+            {.topic=NULL, .value=jsdrv_union_u32(0)},
+    };
+    struct emulated_data_s e;
+    {
+        SETUP_ARGS(record_args);
+        emulated_stream(self, "z/js220/EMU001", &e, 400000);
+        TEARDOWN();
+    }
+    {
+        SETUP_ARGS(replay_args);
+        emulated_stream(self, "y/js220/EMU001", &e, 200000);
+        assert_int_equal(0, e.gaps);
+        assert_int_equal(0, e.errors);
+        TEARDOWN();
+    }
+    remove("js220_EMU001.usbtrace");
+}
+
 int main(void) {
     int rv;
     jsdrv_log_initialize();
@@ -562,6 +2158,43 @@ int main(void) {
     //setvbuf(stdout, NULL, _IONBF, 0);
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_discovery),
+            cmocka_unit_test(test_discovery_executor),
+            cmocka_unit_test(test_reconnect),
+            cmocka_unit_test(test_publish_direct),
+            cmocka_unit_test(test_msg_retain),
+            cmocka_unit_test(test_msg_alloc_data_sz),
+            cmocka_unit_test(test_msg_small),
+            cmocka_unit_test(test_publish_batch),
+            cmocka_unit_test(test_async),
+            cmocka_unit_test(test_open_many),
+            cmocka_unit_test(test_data_dispatch),
+            cmocka_unit_test(test_thread_policy),
+            cmocka_unit_test(test_multiple_contexts),
+            cmocka_unit_test(test_buffer_settings),
+            cmocka_unit_test(test_stats_history_request),
+            cmocka_unit_test(test_queued_coalesce),
+            cmocka_unit_test(test_queued_block),
+            cmocka_unit_test(test_batch),
+            cmocka_unit_test(test_net_server),
+            cmocka_unit_test(test_net_server_read_only),
+            cmocka_unit_test(test_net_client),
+            cmocka_unit_test(test_emulated_js220),
+            cmocka_unit_test(test_emulated_js220_executor),
+            cmocka_unit_test(test_emulated_js220_codec),
+            cmocka_unit_test(test_emulated_js220_skip),
+            cmocka_unit_test(test_emulated_measure),
+            cmocka_unit_test(test_usb_budget),
+            cmocka_unit_test(test_tap),
+            cmocka_unit_test(test_stream_frame),
+            cmocka_unit_test(test_sampling_frequency_seamless),
+            cmocka_unit_test(test_trace),
+            cmocka_unit_test(test_latency_trailer),
+            cmocka_unit_test(test_stream_latency),
+            cmocka_unit_test(test_trigger),
+            cmocka_unit_test(test_stream_event),
+            cmocka_unit_test(test_emulated_js110),
+            cmocka_unit_test(test_js110_settings_burst),
+            cmocka_unit_test(test_usb_replay_js220),
             //cmocka_unit_test(test_device_open),
             //cmocka_unit_test(test_stream_raw_0),
             //cmocka_unit_test(test_timeout),
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <math.h>
+#include "jsdrv_prv/gate.h"
+
+
+#define LENGTH (1024U)
+#define SAMPLE_FREQ (2000000U)
+#define DECIMATE (2U)
+#define SAMPLE_ID (0x1000U)
+#define INTERVALS_MAX (16U)
+
+static float i_[LENGTH];
+static float v_[LENGTH];
+static float p_[LENGTH];
+static uint8_t gpi_[2][LENGTH / 8];  // full rate, DECIMATE times the samples of i_
+
+static struct jsdrv_statistics_s intervals_[INTERVALS_MAX];
+static uint32_t interval_count_;
+
+static void on_gate(void * user_data, struct jsdrv_statistics_s * stats) {
+    assert_ptr_equal(&interval_count_, user_data);
+    assert_true(interval_count_ < INTERVALS_MAX);
+    intervals_[interval_count_++] = *stats;
+}
+
+static int setup(void ** state) {
+    (void) state;
+    for (uint32_t k = 0; k < LENGTH; ++k) {
+        i_[k] = 1.0f;
+        v_[k] = 2.0f;
+        p_[k] = 2.0f;
+    }
+    memset(gpi_, 0, sizeof(gpi_));
+    memset(intervals_, 0, sizeof(intervals_));
+    interval_count_ = 0;
+    return 0;
+}
+
+static struct jsdrv_gate_s * gate(uint8_t mask, uint8_t level) {
+    struct jsdrv_gate_s * g = jsdrv_gate_alloc(SAMPLE_FREQ, DECIMATE, on_gate, &interval_count_);
+    assert_int_equal(0, jsdrv_gate_mask(g));
+    jsdrv_gate_config(g, mask, level);
+    assert_int_equal(mask, jsdrv_gate_mask(g));
+    return g;
+}
+
+// Set gpi_ high over [start, end) in i_ sample indices.
+static void gpi_set(uint8_t gpi, uint32_t start, uint32_t end) {
+    for (uint32_t k = start; k < end; ++k) {
+        gpi_[gpi][k >> 3] |= (uint8_t) (1U << (k & 7));
+    }
+}
+
+static void add_gpi(struct jsdrv_gate_s * g, uint8_t gpi, uint32_t start, uint32_t end) {
+    // GPI uses the i_ sample indices with decimate_factor DECIMATE, start must be a multiple of 8
+    jsdrv_gate_add_gpi(g, gpi, SAMPLE_ID + start * DECIMATE, DECIMATE, gpi_[gpi] + (start >> 3), end - start);
+}
+
+static void add(struct jsdrv_gate_s * g, uint32_t start, uint32_t end) {
+    jsdrv_gate_add(g, SAMPLE_ID + start * DECIMATE, i_ + start, v_ + start, p_ + start, end - start);
+}
+
+static void check_interval(uint32_t idx, uint32_t start, uint32_t length) {
+    struct jsdrv_statistics_s * s = &intervals_[idx];
+    assert_int_equal(SAMPLE_FREQ, s->sample_freq);
+    assert_int_equal(DECIMATE, s->decimate_factor);
+    assert_int_equal(SAMPLE_ID + start * DECIMATE, s->block_sample_id);
+    assert_int_equal(SAMPLE_ID + start * DECIMATE, s->accum_sample_id);
+    assert_int_equal(length, s->block_sample_count);
+}
+
+static void test_gpi_leading(void ** state) {
+    (void) state;
+    struct jsdrv_gate_s * g = gate(0x01, 0x01);
+    gpi_set(0, 100, 300);
+    gpi_set(0, 500, 520);
+    add_gpi(g, 0, 0, LENGTH);
+    add(g, 0, 250);
+    assert_int_equal(0, interval_count_);
+    add(g, 250, LENGTH);
+    assert_int_equal(2, interval_count_);
+    check_interval(0, 100, 200);
+    check_interval(1, 500, 20);
+    struct jsdrv_statistics_s * s = &intervals_[0];
+    assert_float_equal(1.0, s->i_avg, 0.0);
+    assert_float_equal(0.0, s->i_std, 0.0);
+    assert_float_equal(2.0, s->v_max, 0.0);
+    assert_float_equal(2.0, s->p_min, 0.0);
+    // 200 samples at 1 Msps, the integrals truncate to Q31
+    assert_float_equal(200e-6, s->charge_f64, 1e-9);
+    assert_float_equal(400e-6, s->energy_f64, 1e-9);
+    assert_int_equal(0, jsdrv_gate_overrun(g));
+    jsdrv_gate_free(g);
+}
+
+static void test_gpi_lagging(void ** state) {
+    (void) state;
+    struct jsdrv_gate_s * g = gate(0x01, 0x00);  // active low
+    gpi_set(0, 0, 64);
+    gpi_set(0, 400, LENGTH);
+    for (uint32_t k = 0; k < LENGTH; k += 100) {
+        add(g, k, (k + 100 > LENGTH) ? LENGTH : (k + 100));
+    }
+    assert_int_equal(0, interval_count_);
+    add_gpi(g, 0, 0, 128);
+    assert_int_equal(0, interval_count_);
+    add_gpi(g, 0, 128, LENGTH);
+    assert_int_equal(1, interval_count_);
+    check_interval(0, 64, 336);
+    jsdrv_gate_free(g);
+}
+
+static void test_mask_level(void ** state) {
+    (void) state;
+    struct jsdrv_gate_s * g = gate(0x05, 0x04);  // gpi2 high, gpi0 low, ignore gpi1
+    gpi_set(1, 0, LENGTH);  // stored as gpi1, added as gpi2
+    gpi_set(0, 200, 300);
+    jsdrv_gate_add_gpi(g, 2, SAMPLE_ID, DECIMATE, gpi_[1], 512);
+    add_gpi(g, 0, 0, LENGTH);
+    add_gpi(g, 1, 0, LENGTH);  // ignored, not in mask
+    add(g, 0, LENGTH);
+    assert_int_equal(1, interval_count_);  // [0, 200), then [300, 512) remains open
+    check_interval(0, 0, 200);
+    jsdrv_gate_add_gpi(g, 2, SAMPLE_ID + 512 * DECIMATE, DECIMATE, gpi_[0] + (512 >> 3), 512);  // low
+    assert_int_equal(2, interval_count_);
+    check_interval(1, 300, 212);
+    jsdrv_gate_free(g);
+}
+
+static void test_nan(void ** state) {
+    (void) state;
+    struct jsdrv_gate_s * g = gate(0x01, 0x01);
+    gpi_set(0, 0, 100);
+    i_[10] = NAN;
+    i_[20] = 11.0f;
+    add_gpi(g, 0, 0, LENGTH);
+    add(g, 0, LENGTH);
+    assert_int_equal(1, interval_count_);
+    check_interval(0, 0, 100);
+    struct jsdrv_statistics_s * s = &intervals_[0];
+    assert_float_equal(11.0, s->i_max, 0.0);
+    assert_float_equal(109.0 / 99.0, s->i_avg, 1e-12);
+    assert_float_equal(109e-6, s->charge_f64, 1e-9);  // 99 valid samples
+    assert_float_equal(198e-6, s->energy_f64, 1e-9);
+    jsdrv_gate_free(g);
+}
+
+static void test_discontinuity(void ** state) {
+    (void) state;
+    struct jsdrv_gate_s * g = gate(0x01, 0x01);
+    gpi_set(0, 0, LENGTH);
+    add_gpi(g, 0, 0, LENGTH);
+    add(g, 0, 100);
+    assert_int_equal(0, interval_count_);
+    add(g, 200, 300);  // skipped samples end the interval
+    assert_int_equal(1, interval_count_);
+    check_interval(0, 0, 100);
+    jsdrv_gate_clear(g);
+    assert_int_equal(1, interval_count_);  // clear discards
+    add_gpi(g, 0, 0, LENGTH);
+    add(g, 0, 100);
+    jsdrv_gate_config(g, 0, 0);
+    assert_int_equal(1, interval_count_);
+    jsdrv_gate_free(g);
+}
+
+static void test_overrun(void ** state) {
+    (void) state;
+    struct jsdrv_gate_s * g = gate(0x01, 0x01);
+    uint32_t total = 0;
+    while (total <= JSDRV_GATE_WINDOW) {
+        jsdrv_gate_add(g, SAMPLE_ID + total * DECIMATE, i_, v_, p_, LENGTH);
+        total += LENGTH;
+    }
+    assert_int_equal(total - JSDRV_GATE_WINDOW, jsdrv_gate_overrun(g));
+    assert_int_equal(0, interval_count_);
+    jsdrv_gate_free(g);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test_setup(test_gpi_leading, setup),
+            cmocka_unit_test_setup(test_gpi_lagging, setup),
+            cmocka_unit_test_setup(test_mask_level, setup),
+            cmocka_unit_test_setup(test_nan, setup),
+            cmocka_unit_test_setup(test_discontinuity, setup),
+            cmocka_unit_test_setup(test_overrun, setup),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <math.h>
+#include "jsdrv/error_code.h"
+#include "jsdrv_prv/host_stats.h"
+
+
+#define LENGTH (1000U)
+#define SAMPLE_FREQ (2000000U)
+#define DECIMATE (2U)
+
+static float i_[LENGTH];
+static float v_[LENGTH];
+static float p_[LENGTH];
+
+static void generate(void) {
+    for (uint32_t k = 0; k < LENGTH; ++k) {
+        i_[k] = 0.001f * (float) (k % 17);
+        v_[k] = 3.0f + 0.01f * (float) (k % 5);
+        p_[k] = i_[k] * v_[k];
+    }
+}
+
+static void check_window(struct jsdrv_statistics_s * s, uint32_t start, uint32_t length) {
+    struct jsdrv_statistics_accum_s a;
+    jsdrv_statistics_compute_f32(&a, i_ + start, length);
+    assert_float_equal(a.mean, s->i_avg, 1e-12);
+    assert_float_equal(sqrt(a.s / length), s->i_std, 1e-9);
+    assert_float_equal(a.min, s->i_min, 0.0);
+    assert_float_equal(a.max, s->i_max, 0.0);
+    jsdrv_statistics_compute_f32(&a, v_ + start, length);
+    assert_float_equal(a.mean, s->v_avg, 1e-9);
+    jsdrv_statistics_compute_f32(&a, p_ + start, length);
+    assert_float_equal(a.mean, s->p_avg, 1e-9);
+    assert_int_equal(length, s->block_sample_count);
+    assert_int_equal(0x1000 + start * DECIMATE, s->block_sample_id);
+}
+
+static uint32_t run(struct jsdrv_host_stats_s * h, uint32_t chunk, uint32_t window, uint32_t hop) {
+    uint32_t outputs = 0;
+    uint32_t k = 0;
+    while (k < LENGTH) {
+        uint32_t sz = ((LENGTH - k) < chunk) ? (LENGTH - k) : chunk;
+        struct jsdrv_statistics_s * s = NULL;
+        uint32_t n = jsdrv_host_stats_add(h, 0x1000 + k * DECIMATE, i_ + k, v_ + k, p_ + k, sz, &s);
+        assert_true(n > 0);
+        k += n;
+        if (NULL != s) {
+            check_window(s, k - window, window);
+            assert_int_equal(0, (k - window) % hop);
+            ++outputs;
+        }
+    }
+    return outputs;
+}
+
+static void test_config(void ** state) {
+    (void) state;
+    struct jsdrv_host_stats_s h;
+    jsdrv_host_stats_initialize(&h, SAMPLE_FREQ, DECIMATE);
+    assert_int_equal(100000, h.window);
+    assert_int_equal(100000, h.hop);
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_host_stats_config(&h, 0, 0));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_host_stats_config(&h, 100, 30));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_host_stats_config(&h, 100, 200));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_host_stats_config(&h, 1000, 1));
+    assert_int_equal(0, jsdrv_host_stats_config(&h, 1000, 100));
+    assert_int_equal(10, h.seg_count);
+}
+
+static void test_tumbling(void ** state) {
+    (void) state;
+    struct jsdrv_host_stats_s h;
+    generate();
+    jsdrv_host_stats_initialize(&h, SAMPLE_FREQ, DECIMATE);
+    assert_int_equal(0, jsdrv_host_stats_config(&h, 100, 0));
+    assert_int_equal(10, run(&h, 37, 100, 100));
+}
+
+static void test_sliding(void ** state) {
+    (void) state;
+    struct jsdrv_host_stats_s h;
+    generate();
+    jsdrv_host_stats_initialize(&h, SAMPLE_FREQ, DECIMATE);
+    assert_int_equal(0, jsdrv_host_stats_config(&h, 200, 50));
+    assert_int_equal(17, run(&h, 128, 200, 50));  // first at 200, then every 50
+}
+
+static void test_nan_and_integral(void ** state) {
+    (void) state;
+    struct jsdrv_host_stats_s h;
+    struct jsdrv_statistics_s * s = NULL;
+    for (uint32_t k = 0; k < LENGTH; ++k) {
+        i_[k] = 1.0f;
+        v_[k] = 2.0f;
+        p_[k] = 2.0f;
+    }
+    v_[10] = NAN;
+    jsdrv_host_stats_initialize(&h, SAMPLE_FREQ, DECIMATE);
+    assert_int_equal(0, jsdrv_host_stats_config(&h, LENGTH, 0));
+    assert_int_equal(LENGTH, jsdrv_host_stats_add(&h, 0x1000, i_, v_, p_, LENGTH, &s));
+    assert_non_null(s);
+    assert_float_equal(1.0, s->i_avg, 0.0);
+    assert_float_equal(0.0, s->i_std, 0.0);
+    assert_float_equal(2.0, s->v_max, 0.0);
+    assert_int_equal(0x1000, s->accum_sample_id);
+    // 999 valid samples at 1 Msps
+    assert_float_equal(999e-6, s->charge_f64, 1e-12);
+    assert_float_equal(2 * 999e-6, s->energy_f64, 1e-12);
+}
+
+static void test_discontinuity(void ** state) {
+    (void) state;
+    struct jsdrv_host_stats_s h;
+    struct jsdrv_statistics_s * s = NULL;
+    generate();
+    jsdrv_host_stats_initialize(&h, SAMPLE_FREQ, DECIMATE);
+    assert_int_equal(0, jsdrv_host_stats_config(&h, 100, 0));
+    assert_int_equal(60, jsdrv_host_stats_add(&h, 0x1000, i_, v_, p_, 60, &s));
+    assert_null(s);
+    // 0x1000 != expected sample_id, window restarts at the new sample_id
+    assert_int_equal(100, jsdrv_host_stats_add(&h, 0x1000, i_, v_, p_, 100, &s));
+    assert_non_null(s);
+    check_window(s, 0, 100);
+}
+
+static void test_derived(void ** state) {
+    (void) state;
+    struct jsdrv_host_stats_s h;
+    struct jsdrv_statistics_s * s = NULL;
+    generate();
+    jsdrv_host_stats_initialize(&h, SAMPLE_FREQ, DECIMATE);
+    assert_int_equal(0, jsdrv_host_stats_config(&h, 500, 0));
+    jsdrv_host_stats_derived_enable(&h, true);
+    i_[3] = 1.0f;
+    i_[4] = -1.0f;
+    p_[5] = 2000.0f;
+    i_[700] = NAN;
+    for (uint32_t k = 0; k < LENGTH; k += 500) {
+        assert_int_equal(500, jsdrv_host_stats_add(&h, 0x1000 + k * DECIMATE, i_ + k, v_ + k, p_ + k, 500, &s));
+        assert_non_null(s);
+        if (0 == k) {
+            double sum = 0.0;
+            double peak = 0.0;
+            for (uint32_t n = 0; n < 500; ++n) {
+                sum += (double) i_[n] * i_[n];
+                peak = fmax(peak, fabs(i_[n]));
+            }
+            double rms = sqrt(sum / 500);
+            assert_float_equal(rms, h.derived.i_rms, 1e-9);
+            assert_float_equal(peak / rms, h.derived.i_crest, 1e-6);
+            assert_int_equal(s->block_sample_id, h.derived.block_sample_id);
+        }
+    }
+    const struct jsdrv_host_derived_s * d = &h.derived;
+    assert_int_equal(1, d->version);
+    assert_int_equal(JSDRV_HOST_HIST_BIN_COUNT, d->bin_count);
+    assert_int_equal(0x1000, d->hist_sample_id);
+    uint64_t total = 0;
+    for (uint32_t n = 0; n < JSDRV_HOST_HIST_BIN_COUNT; ++n) {
+        total += d->i_hist[n];
+    }
+    assert_int_equal(LENGTH - 1, total);  // NaN sample skipped
+    assert_int_equal(59 + 1, d->i_hist[0]);  // zero samples and the negative sample
+    assert_int_equal(1, d->i_hist[1 + 30 * JSDRV_HOST_HIST_BINS_PER_OCTAVE]);  // 1.0
+    assert_int_equal(LENGTH - 1, d->v_hist[1 + 31 * JSDRV_HOST_HIST_BINS_PER_OCTAVE + 2]);  // 3.00 to 3.04
+    assert_int_equal(1, d->p_hist[JSDRV_HOST_HIST_BIN_COUNT - 1]);  // overflow
+
+    jsdrv_host_stats_clear(&h);
+    assert_int_equal(0, h.derived.v_hist[1 + 31 * JSDRV_HOST_HIST_BINS_PER_OCTAVE + 2]);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_config),
+            cmocka_unit_test(test_tumbling),
+            cmocka_unit_test(test_sliding),
+            cmocka_unit_test(test_nan_and_integral),
+            cmocka_unit_test(test_discontinuity),
+            cmocka_unit_test(test_derived),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
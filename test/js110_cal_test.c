@@ -21,6 +21,9 @@
 #include <string.h>
 #include <math.h>
 #include "jsdrv_prv/js110_cal.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv/error_code.h"
+#include <stdio.h>
 
 
 static const uint8_t JS110_CAL_01[] = {
@@ -127,9 +130,32 @@ static void test_parse(void ** state) {
     }
 }
 
+static void test_cache(void ** state) {
+    (void) state;
+    uint8_t * data = NULL;
+    struct js110_cal_header_s hdr;
+    memcpy(&hdr, JS110_CAL_01, sizeof(hdr));
+    remove("./js110_TEST_01_" "ab2e35ce.cal");  // from any previous run
+    assert_int_equal(JSDRV_ERROR_NOT_FOUND, js110_cal_cache_load(".", "TEST/01", &hdr, &data));
+    assert_int_equal(0, js110_cal_cache_save(".", "TEST/01", JS110_CAL_01));
+    assert_int_equal(JSDRV_ERROR_NOT_FOUND, js110_cal_cache_load(".", "TEST/02", &hdr, &data));
+
+    assert_int_equal(0, js110_cal_cache_load(".", "TEST/01", &hdr, &data));
+    assert_non_null(data);
+    assert_memory_equal(JS110_CAL_01, data, sizeof(JS110_CAL_01));
+    jsdrv_free(data);
+    data = NULL;
+
+    hdr.version += 1;
+    assert_int_equal(JSDRV_ERROR_NOT_FOUND, js110_cal_cache_load(".", "TEST/01", &hdr, &data));
+    assert_null(data);
+    assert_int_equal(0, remove("./js110_TEST_01_" "ab2e35ce.cal"));
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_parse),
+            cmocka_unit_test(test_cache),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -201,6 +201,85 @@ static void test_interp_1_3_1(void ** state) {
     generate(&s, 0, 3, expect_interp, &m);
 }
 
+#define BLOCK_LENGTH (4096)
+
+static void block_compare(uint8_t mode) {
+    struct js110_sp_s s1;
+    struct js110_sp_s s2;
+    static uint32_t raw[BLOCK_LENGTH];
+    static float i[BLOCK_LENGTH];
+    static float v[BLOCK_LENGTH];
+    static float p[BLOCK_LENGTH];
+    static uint8_t r[BLOCK_LENGTH];
+    static uint8_t g0[BLOCK_LENGTH];
+    static uint8_t g1[BLOCK_LENGTH];
+    struct js110_sp_block_s dst = {.i = i, .v = v, .p = p, .current_range = r, .gpi0 = g0, .gpi1 = g1};
+
+    js110_sp_initialize(&s1);
+    for (int k = 0; k < 9; ++k) {
+        s1.cal[0][0][k] = (k + 1) * 100.0;
+        s1.cal[0][1][k] = pow(10, -3 - k);
+    }
+    for (int k = 0; k < 2; ++k) {
+        s1.cal[1][0][k] = (k + 1) * -100.0;
+        s1.cal[1][1][k] = pow(10, -4 - k);
+    }
+    s1._suppress_mode = mode;
+    s2 = s1;
+
+    uint32_t lcg = 1;
+    uint8_t i_range = 0;
+    for (uint32_t k = 0; k < BLOCK_LENGTH; ++k) {
+        lcg = (lcg * 1664525U) + 1013904223U;
+        if ((lcg >> 24) < 4) {                  // occasional range change
+            i_range = (uint8_t) ((lcg >> 8) % 8);
+        }
+        uint32_t current = 2000 + ((lcg >> 4) & 0x3ff);
+        uint32_t voltage = 3000 + ((lcg >> 14) & 0x1ff);
+        raw[k] = ((current & 0x3fff) << 2)
+                | ((voltage & 0x3fff) << 18)
+                | (i_range & 3)
+                | ((i_range & 4) << (16 - 2))
+                | ((k & 1) ? 0x20000 : 0);
+        if ((lcg >> 24) == 255) {
+            raw[k] = 0xffffffffLU;              // occasional missing sample
+        }
+    }
+
+    // odd block lengths exercise runs shorter and longer than the delay line
+    const uint32_t lengths[] = {1, 7, 63, 64, 65, 200, 1000};
+    uint32_t idx = 0;
+    for (uint32_t n = 0; idx < BLOCK_LENGTH; ++n) {
+        uint32_t length = lengths[n % JSDRV_ARRAY_SIZE(lengths)];
+        if ((idx + length) > BLOCK_LENGTH) {
+            length = BLOCK_LENGTH - idx;
+        }
+        js110_sp_process_block(&s2, raw + idx, length, 0, &dst);
+        for (uint32_t k = 0; k < length; ++k) {
+            struct js110_sample_s z = js110_sp_process(&s1, raw[idx + k], 0);
+            assert_memory_equal(&z.i, &i[k], sizeof(float));  // bit exact, including NaN
+            assert_memory_equal(&z.v, &v[k], sizeof(float));
+            assert_memory_equal(&z.p, &p[k], sizeof(float));
+            assert_int_equal(z.current_range, r[k]);
+            assert_int_equal(z.gpi0, g0[k]);
+            assert_int_equal(z.gpi1, g1[k]);
+        }
+        idx += length;
+    }
+    assert_int_equal(s1.sample_count, s2.sample_count);
+    assert_int_equal(s1.sample_missing_count, s2.sample_missing_count);
+    assert_int_equal(s1.contiguous_count, s2.contiguous_count);
+    assert_int_equal(s1.head, s2.head);
+}
+
+static void test_block(void ** state) {
+    (void) state;
+    block_compare(JS110_SUPPRESS_MODE_OFF);
+    block_compare(JS110_SUPPRESS_MODE_MEAN);
+    block_compare(JS110_SUPPRESS_MODE_INTERP);
+    block_compare(JS110_SUPPRESS_MODE_NAN);
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_off),
@@ -211,6 +290,7 @@ int main(void) {
             cmocka_unit_test(test_mean_2_3_1),
             cmocka_unit_test(test_mean_1_3_2),
             cmocka_unit_test(test_interp_1_3_1),
+            cmocka_unit_test(test_block),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
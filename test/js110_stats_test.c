@@ -0,0 +1,105 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <math.h>
+#include "jsdrv_prv/js110_stats.h"
+
+
+#define LENGTH (50000U)
+#define STATS_BLOCK (10000U)
+
+static float i_[LENGTH];
+static float v_[LENGTH];
+static float p_[LENGTH];
+
+static uint32_t lcg_next(uint32_t * state) {
+    *state = (*state * 1664525U) + 1013904223U;
+    return *state;
+}
+
+static float lcg_f32(uint32_t * state, float scale) {
+    return scale * ((float) (lcg_next(state) >> 8) / (float) (1U << 23) - 1.0f);
+}
+
+static void generate(void) {
+    uint32_t lcg = 3;
+    for (uint32_t k = 0; k < LENGTH; ++k) {
+        i_[k] = lcg_f32(&lcg, 0.01f);
+        v_[k] = 3.3f + lcg_f32(&lcg, 0.1f);
+        p_[k] = i_[k] * v_[k];
+    }
+    i_[17] = NAN;
+    v_[12345] = NAN;
+    p_[20000] = 100000.0f;      // exceeds the 64-bit partial range
+    v_[30000] = -70000.0f;
+}
+
+static void test_block_matches_scalar(void ** state) {
+    (void) state;
+    struct js110_stats_s scalar;
+    struct js110_stats_s block;
+    struct jsdrv_statistics_s expect[LENGTH / STATS_BLOCK];
+    uint32_t expect_count = 0;
+    uint32_t actual_count = 0;
+    generate();
+    js110_stats_initialize(&scalar);
+    js110_stats_sample_count_set(&scalar, STATS_BLOCK);
+    js110_stats_initialize(&block);
+    js110_stats_sample_count_set(&block, STATS_BLOCK);
+
+    for (uint32_t k = 0; k < LENGTH; ++k) {
+        struct jsdrv_statistics_s * s = js110_stats_compute(&scalar, i_[k], v_[k], p_[k]);
+        if (NULL != s) {
+            expect[expect_count++] = *s;
+        }
+    }
+    assert_int_equal(LENGTH / STATS_BLOCK, expect_count);
+
+    uint32_t lcg = 11;
+    uint32_t k = 0;
+    while (k < LENGTH) {
+        uint32_t sz = 1 + (lcg_next(&lcg) >> 19);   // up to 8192
+        if (sz > (LENGTH - k)) {
+            sz = LENGTH - k;
+        }
+        struct jsdrv_statistics_s * s = NULL;
+        uint32_t consumed = js110_stats_compute_block(&block, i_ + k, v_ + k, p_ + k, sz, &s);
+        assert_true(consumed > 0);
+        assert_true(consumed <= sz);
+        k += consumed;
+        if (NULL != s) {
+            assert_int_equal(0, k % STATS_BLOCK);
+            assert_memory_equal(&expect[actual_count], s, sizeof(*s));
+            ++actual_count;
+        } else {
+            assert_int_equal(sz, consumed);
+        }
+    }
+    assert_int_equal(expect_count, actual_count);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_block_matches_scalar),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
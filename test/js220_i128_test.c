@@ -66,6 +66,8 @@ static void test_neg(void ** state) {
     assert_i128_equal(((js220_i128) {.i64 = {0, 0}}), js220_i128_neg((js220_i128) {.i64 = {0, 0}}));
     assert_i128_equal(((js220_i128) {.i64 = {1, 0}}), js220_i128_neg((js220_i128) {.i64 = {-1, -1}}));
     assert_i128_equal(((js220_i128) {.i64 = {-1, -1}}), js220_i128_neg((js220_i128) {.i64 = {1, 0}}));
+    assert_i128_equal(((js220_i128) {.u64 = {1LLU << 63, -1}}), js220_i128_neg((js220_i128) {.u64 = {1LLU << 63, 0}}));
+    assert_i128_equal(((js220_i128) {.u64 = {0, -1}}), js220_i128_neg((js220_i128) {.u64 = {0, 1}}));
 }
 
 static void test_udiv(void ** state) {
@@ -85,6 +87,13 @@ static void test_udiv(void ** state) {
     assert_i128_equal(((js220_i128) {.i64 = {1LL << 48, 0}}),
                       js220_i128_udiv((js220_i128) {.i64 = {3, 1}}, 1 << 16, &r));
     assert_int_equal(3, r);
+
+    assert_i128_equal(((js220_i128) {.u64 = {0x7fffffffffffffffLLU, 1}}),
+                      js220_i128_udiv((js220_i128) {.u64 = {-1, 2}}, 2, &r));
+    assert_int_equal(1, r);
+    assert_i128_equal(((js220_i128) {.u64 = {0xf, 0}}),
+                      js220_i128_udiv((js220_i128) {.u64 = {0xfffffffffffffff7LLU, 0xe}}, 0xf000000000000000LLU, &r));
+    assert_int_equal(0xeffffffffffffff7LLU, r);
 }
 
 
@@ -0,0 +1,289 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+extern "C" {
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+}
+#include "jsdrv.hpp"
+#include <exception>
+#include <string.h>
+
+
+#define CONTEXT ((struct jsdrv_context_s *) 1)
+#define QUEUE_MAX (8U)
+
+static char async_topic_[JSDRV_TOPIC_LENGTH_MAX];
+static int32_t async_rc_;
+static jsdrv_async_fn async_fn_;
+static void * async_user_data_;
+static struct jsdrv_union_s * async_value_;
+static char req_topic_[JSDRV_TOPIC_LENGTH_MAX];
+static struct jsdrv_buffer_request_s req_;
+static jsdrv_subscribe_fn cbk_fn_;
+static void * cbk_user_data_;
+static std::coroutine_handle<> queue_[QUEUE_MAX];
+static uint32_t queue_count_;
+
+extern "C" {
+
+int32_t jsdrv_initialize(struct jsdrv_context_s ** context, const struct jsdrv_arg_s * args, uint32_t timeout_ms) {
+    (void) args;
+    (void) timeout_ms;
+    *context = CONTEXT;
+    return 0;
+}
+
+void jsdrv_finalize(struct jsdrv_context_s * context, uint32_t timeout_ms) {
+    (void) context;
+    (void) timeout_ms;
+}
+
+int32_t jsdrv_publish(struct jsdrv_context_s * context, const char * topic,
+        const struct jsdrv_union_s * value, uint32_t timeout_ms) {
+    assert_ptr_equal(CONTEXT, context);
+    if (JSDRV_UNION_BIN != value->type) {
+        return 0;  // device open and close
+    }
+    assert_int_equal(0, timeout_ms);
+    assert_int_equal(sizeof(req_), value->size);
+    strcpy(req_topic_, topic);
+    memcpy(&req_, value->value.bin, sizeof(req_));
+    return 0;
+}
+
+int32_t jsdrv_publish_async(struct jsdrv_context_s * context,
+        const char * topic, const struct jsdrv_union_s * value,
+        jsdrv_async_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) {
+    (void) timeout_ms;
+    assert_ptr_equal(CONTEXT, context);
+    assert_int_equal(JSDRV_UNION_U32, value->type);
+    strcpy(async_topic_, topic);
+    async_fn_ = cbk_fn;
+    async_user_data_ = cbk_user_data;
+    async_value_ = NULL;
+    return async_rc_;
+}
+
+int32_t jsdrv_query_async(struct jsdrv_context_s * context,
+        const char * topic, struct jsdrv_union_s * value,
+        jsdrv_async_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) {
+    (void) timeout_ms;
+    assert_ptr_equal(CONTEXT, context);
+    strcpy(async_topic_, topic);
+    async_fn_ = cbk_fn;
+    async_user_data_ = cbk_user_data;
+    async_value_ = value;
+    return async_rc_;
+}
+
+int32_t jsdrv_subscribe(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
+        jsdrv_subscribe_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) {
+    (void) timeout_ms;
+    assert_ptr_equal(CONTEXT, context);
+    assert_string_equal("a/cpp/!rsp", topic);
+    assert_int_equal(JSDRV_SFLAG_PUB, flags);
+    cbk_fn_ = cbk_fn;
+    cbk_user_data_ = cbk_user_data;
+    return 0;
+}
+
+int32_t jsdrv_unsubscribe(struct jsdrv_context_s * context, const char * topic,
+        jsdrv_subscribe_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) {
+    (void) topic;
+    (void) timeout_ms;
+    assert_ptr_equal(CONTEXT, context);
+    assert_ptr_equal(cbk_fn_, cbk_fn);
+    assert_ptr_equal(cbk_user_data_, cbk_user_data);
+    cbk_fn_ = NULL;
+    return 0;
+}
+
+}
+
+// A minimal eagerly started coroutine.
+struct Task {
+    struct promise_type {
+        Task get_return_object() { return Task(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+static void post(void * user_data, std::coroutine_handle<> handle) {
+    assert_ptr_equal(&queue_count_, user_data);
+    assert_true(queue_count_ < QUEUE_MAX);
+    queue_[queue_count_++] = handle;
+}
+
+static uint32_t run(void) {
+    uint32_t count = queue_count_;
+    for (uint32_t k = 0; k < count; ++k) {
+        queue_[k].resume();
+    }
+    queue_count_ = 0;
+    return count;
+}
+
+static jsdrv::Executor executor(void) {
+    jsdrv::Executor ex;
+    ex.post = post;
+    ex.user_data = &queue_count_;
+    return ex;
+}
+
+static int setup(void ** state) {
+    (void) state;
+    async_topic_[0] = 0;
+    async_rc_ = 0;
+    async_fn_ = NULL;
+    req_topic_[0] = 0;
+    memset(&req_, 0, sizeof(req_));
+    cbk_fn_ = NULL;
+    queue_count_ = 0;
+    return 0;
+}
+
+static Task publish_task(jsdrv::Async a, int32_t * rc) {
+    *rc = co_await a.publish("s/i/ctrl", uint32_t(1));
+}
+
+static Task query_task(jsdrv::Async a, jsdrv::QueryResult * r) {
+    *r = co_await a.query("s/i/range");
+}
+
+static void test_publish(void ** state) {
+    (void) state;
+    jsdrv::Context c;
+    assert_int_equal(0, c.initialize());
+    int32_t rc = -1;
+    publish_task(c.async(executor()), &rc);
+    assert_string_equal("s/i/ctrl", async_topic_);
+    assert_int_equal(-1, rc);
+    async_fn_(async_user_data_, async_topic_, JSDRV_ERROR_TIMED_OUT, NULL);
+    assert_int_equal(-1, rc);   // resumes on the executor
+    assert_int_equal(1, run());
+    assert_int_equal(JSDRV_ERROR_TIMED_OUT, rc);
+
+    async_rc_ = JSDRV_ERROR_PARAMETER_INVALID;
+    publish_task(c.async(executor()), &rc);
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, rc);
+    assert_int_equal(0, run());
+}
+
+static void test_query(void ** state) {
+    (void) state;
+    jsdrv::Context c;
+    assert_int_equal(0, c.initialize());
+    jsdrv::Device d;
+    assert_int_equal(0, d.open(c, "u/js220/000415"));
+    jsdrv::QueryResult r;
+    r.rc = -1;
+    query_task(d.async(executor()), &r);
+    assert_string_equal("u/js220/000415/s/i/range", async_topic_);
+    *async_value_ = jsdrv::value(uint8_t(5));
+    async_fn_(async_user_data_, async_topic_, 0, async_value_);
+    assert_int_equal(1, run());
+    assert_int_equal(0, r.rc);
+    assert_int_equal(JSDRV_UNION_U8, r.value.type);
+    assert_int_equal(5, r.value.value.u8);
+}
+
+static Task summary_task(jsdrv::Buffer & b, uint8_t signal_id, jsdrv::BufferResult * r) {
+    *r = co_await b.summary(signal_id, 1000, 2000, 4);
+}
+
+static void respond(int64_t rsp_id, uint32_t length) {
+    uint64_t data[64];
+    memset(data, 0, sizeof(data));
+    struct jsdrv_buffer_response_s * rsp = (struct jsdrv_buffer_response_s *) data;
+    rsp->version = 1;
+    rsp->response_type = JSDRV_BUFFER_RESPONSE_SUMMARY;
+    rsp->flags = JSDRV_BUFFER_RESPONSE_FLAG_FINAL;
+    rsp->rsp_id = rsp_id;
+    rsp->info.time_range_samples.length = length;
+    struct jsdrv_summary_entry_s * e = (struct jsdrv_summary_entry_s *) rsp->data;
+    for (uint32_t k = 0; k < length; ++k) {
+        e[k].avg = (float) k;
+    }
+    struct jsdrv_union_s v;
+    memset(&v, 0, sizeof(v));
+    v.type = JSDRV_UNION_BIN;
+    v.app = JSDRV_PAYLOAD_TYPE_BUFFER_RSP;
+    v.value.bin = (const uint8_t *) data;
+    v.size = (uint32_t) (sizeof(*rsp) + length * sizeof(*e));
+    cbk_fn_(cbk_user_data_, "a/cpp/!rsp", &v);
+}
+
+static void test_buffer(void ** state) {
+    (void) state;
+    jsdrv::Context c;
+    assert_int_equal(0, c.initialize());
+    jsdrv::BufferResult r1;
+    jsdrv::BufferResult r2;
+    jsdrv::BufferResult r3;
+    {
+        jsdrv::Buffer b;
+        assert_int_equal(0, b.open(c, "m/001", "a/cpp/!rsp", executor()));
+        summary_task(b, 1, &r1);
+        assert_string_equal("m/001/s/001/!req", req_topic_);
+        assert_string_equal("a/cpp/!rsp", req_.rsp_topic);
+        assert_int_equal(JSDRV_TIME_UTC, req_.time_type);
+        assert_int_equal(1000, req_.time.utc.start);
+        assert_int_equal(2000, req_.time.utc.end);
+        assert_int_equal(4, req_.time.utc.length);
+        int64_t rsp_id1 = req_.rsp_id;
+        summary_task(b, 2, &r2);
+        assert_string_equal("m/001/s/002/!req", req_topic_);
+        int64_t rsp_id2 = req_.rsp_id;
+        assert_true(rsp_id1 != rsp_id2);
+        summary_task(b, 3, &r3);
+
+        respond(rsp_id2, 4);        // out of order
+        respond(rsp_id2, 4);        // duplicate ignored
+        assert_int_equal(1, run());
+        assert_int_equal(0, r2.rc);
+        assert_int_equal(4, r2.size());
+        assert_int_equal(JSDRV_BUFFER_RESPONSE_SUMMARY, r2.response()->response_type);
+        assert_true(3.0f == r2.summary()[3].avg);
+        assert_null(r1.response());
+
+        respond(rsp_id1, 2);
+        assert_int_equal(1, run());
+        assert_int_equal(2, r1.size());
+    }
+    assert_null(cbk_fn_);           // closed
+    assert_int_equal(1, run());
+    assert_int_equal(JSDRV_ERROR_ABORTED, r3.rc);
+
+    jsdrv::Buffer b;
+    summary_task(b, 1, &r1);        // not open
+    assert_int_equal(JSDRV_ERROR_CLOSED, r1.rc);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test_setup(test_publish, setup),
+            cmocka_unit_test_setup(test_query, setup),
+            cmocka_unit_test_setup(test_buffer, setup),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,272 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+extern "C" {
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+}
+#include "jsdrv.hpp"
+#include <string.h>
+
+
+#define CONTEXT ((struct jsdrv_context_s *) 1)
+
+static uint32_t finalize_count_;
+static char publish_topic_[JSDRV_TOPIC_LENGTH_MAX];
+static struct jsdrv_union_s publish_value_;
+static struct jsdrv_union_s query_value_;
+static char subscribe_topic_[JSDRV_TOPIC_LENGTH_MAX];
+static uint8_t subscribe_flags_;
+static jsdrv_subscribe_fn cbk_fn_;
+static void * cbk_user_data_;
+static uint32_t unsubscribe_count_;
+static int32_t unsubscribe_rc_;
+static uint8_t msg_[sizeof(struct jsdrv_stream_signal_s)];
+
+extern "C" {
+
+int32_t jsdrv_initialize(struct jsdrv_context_s ** context, const struct jsdrv_arg_s * args, uint32_t timeout_ms) {
+    (void) args;
+    (void) timeout_ms;
+    *context = CONTEXT;
+    return 0;
+}
+
+void jsdrv_finalize(struct jsdrv_context_s * context, uint32_t timeout_ms) {
+    (void) timeout_ms;
+    assert_ptr_equal(CONTEXT, context);
+    ++finalize_count_;
+}
+
+int32_t jsdrv_publish(struct jsdrv_context_s * context, const char * topic,
+        const struct jsdrv_union_s * value, uint32_t timeout_ms) {
+    (void) timeout_ms;
+    assert_ptr_equal(CONTEXT, context);
+    strcpy(publish_topic_, topic);
+    publish_value_ = *value;
+    return 0;
+}
+
+int32_t jsdrv_query(struct jsdrv_context_s * context, const char * topic,
+        struct jsdrv_union_s * value, uint32_t timeout_ms) {
+    (void) timeout_ms;
+    assert_ptr_equal(CONTEXT, context);
+    strcpy(publish_topic_, topic);
+    *value = query_value_;
+    return 0;
+}
+
+int32_t jsdrv_subscribe(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
+        jsdrv_subscribe_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) {
+    (void) timeout_ms;
+    assert_ptr_equal(CONTEXT, context);
+    strcpy(subscribe_topic_, topic);
+    subscribe_flags_ = flags;
+    cbk_fn_ = cbk_fn;
+    cbk_user_data_ = cbk_user_data;
+    return 0;
+}
+
+int32_t jsdrv_unsubscribe(struct jsdrv_context_s * context, const char * topic,
+        jsdrv_subscribe_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) {
+    (void) timeout_ms;
+    assert_ptr_equal(CONTEXT, context);
+    assert_string_equal(subscribe_topic_, topic);
+    assert_ptr_equal(cbk_fn_, cbk_fn);
+    assert_ptr_equal(cbk_user_data_, cbk_user_data);
+    cbk_fn_ = NULL;
+    ++unsubscribe_count_;
+    return unsubscribe_rc_;
+}
+
+}
+
+static int setup(void ** state) {
+    (void) state;
+    finalize_count_ = 0;
+    publish_topic_[0] = 0;
+    memset(&publish_value_, 0, sizeof(publish_value_));
+    query_value_ = jsdrv::value(uint8_t(7));
+    subscribe_topic_[0] = 0;
+    cbk_fn_ = NULL;
+    unsubscribe_count_ = 0;
+    unsubscribe_rc_ = 0;
+    return 0;
+}
+
+static void publish(uint32_t size) {
+    struct jsdrv_union_s v;
+    memset(&v, 0, sizeof(v));
+    v.type = JSDRV_UNION_BIN;
+    v.app = JSDRV_PAYLOAD_TYPE_STREAM;
+    v.value.bin = msg_;
+    v.size = size;
+    cbk_fn_(cbk_user_data_, subscribe_topic_, &v);
+}
+
+static struct jsdrv_stream_signal_s * msg_init(uint8_t element_type, uint8_t bits, uint32_t count) {
+    struct jsdrv_stream_signal_s * s = (struct jsdrv_stream_signal_s *) msg_;
+    memset(s, 0, JSDRV_STREAM_HEADER_SIZE);
+    s->sample_id = 1000;
+    s->element_type = element_type;
+    s->element_size_bits = bits;
+    s->element_count = count;
+    s->sample_rate = 1000000;
+    s->decimate_factor = 2;
+    return s;
+}
+
+static void test_context(void ** state) {
+    (void) state;
+    {
+        jsdrv::Context c;
+        assert_false(static_cast<bool>(c));
+        assert_int_equal(0, c.initialize());
+        assert_true(static_cast<bool>(c));
+        jsdrv::Context c2(std::move(c));
+        assert_false(static_cast<bool>(c));
+        assert_ptr_equal(CONTEXT, c2.get());
+        assert_int_equal(0, c2.publish("s/i/ctrl", uint32_t(1)));
+        assert_string_equal("s/i/ctrl", publish_topic_);
+        assert_int_equal(JSDRV_UNION_U32, publish_value_.type);
+        assert_int_equal(1, publish_value_.value.u32);
+        float f = 0.0f;
+        assert_int_equal(0, c2.query("s/i/range", f));
+        assert_true(7.0f == f);
+    }
+    assert_int_equal(1, finalize_count_);
+}
+
+static void test_device(void ** state) {
+    (void) state;
+    jsdrv::Context c;
+    assert_int_equal(0, c.initialize());
+    {
+        jsdrv::Device d;
+        assert_int_equal(0, d.open(c, "u/js220/000415"));
+        assert_string_equal("u/js220/000415/@/!open", publish_topic_);
+        assert_int_equal(JSDRV_UNION_I32, publish_value_.type);
+        assert_int_equal(0, d.publish("s/i/ctrl", "on"));
+        assert_string_equal("u/js220/000415/s/i/ctrl", publish_topic_);
+        assert_int_equal(JSDRV_UNION_STR, publish_value_.type);
+        assert_int_equal(3, publish_value_.size);
+        jsdrv::Device d2;
+        d2 = std::move(d);
+        assert_false(static_cast<bool>(d));
+        assert_string_equal("u/js220/000415", d2.prefix());
+        publish_topic_[0] = 0;
+    }
+    assert_string_equal("u/js220/000415/@/!close", publish_topic_);
+}
+
+static void test_subscribe(void ** state) {
+    (void) state;
+    jsdrv::Context c;
+    assert_int_equal(0, c.initialize());
+    uint32_t count = 0;
+    {
+        jsdrv::Subscription sub;
+        assert_int_equal(0, c.subscribe("u/js220", JSDRV_SFLAG_PUB,
+                [&count](const char * topic, const jsdrv_union_s & value) {
+                    assert_string_equal("u/js220", topic);
+                    assert_int_equal(JSDRV_UNION_U8, value.type);
+                    ++count;
+                }, sub));
+        assert_true(static_cast<bool>(sub));
+        assert_int_equal(JSDRV_SFLAG_PUB, subscribe_flags_);
+        jsdrv_union_s v = jsdrv::value(uint8_t(3));
+        cbk_fn_(cbk_user_data_, "u/js220", &v);
+        assert_int_equal(1, count);
+        jsdrv::Subscription sub2(std::move(sub));
+        assert_false(static_cast<bool>(sub));
+        assert_int_equal(0, unsubscribe_count_);
+    }
+    assert_int_equal(1, unsubscribe_count_);
+}
+
+static void test_stream_view(void ** state) {
+    (void) state;
+    jsdrv::Context c;
+    assert_int_equal(0, c.initialize());
+    jsdrv::Device d;
+    assert_int_equal(0, d.open(c, "u/js220/000415"));
+    uint32_t count = 0;
+    jsdrv::Subscription sub;
+    assert_int_equal(0, d.subscribe_stream<jsdrv::StreamView<float>>("s/i/!data",
+            [&count](jsdrv::StreamView<float> view) {
+                assert_int_equal(1000, view.sample_id());
+                assert_int_equal(2, view.decimate_factor());
+                assert_int_equal(4, view.size());
+                float expect = 0.0f;
+                for (float x: view) {
+                    assert_true(expect == x);
+                    expect += 1.0f;
+                }
+                assert_ptr_equal(msg_ + JSDRV_STREAM_HEADER_SIZE, view.data());
+                ++count;
+            }, sub));
+    assert_string_equal("u/js220/000415/s/i/!data", subscribe_topic_);
+    struct jsdrv_stream_signal_s * s = msg_init(JSDRV_DATA_TYPE_FLOAT, 32, 4);
+    float * x = (float *) s->data;
+    for (uint32_t k = 0; k < 4; ++k) {
+        x[k] = (float) k;
+    }
+    publish(JSDRV_STREAM_HEADER_SIZE + 16);
+    assert_int_equal(1, count);
+    publish(JSDRV_STREAM_HEADER_SIZE + 12);     // truncated
+    msg_init(JSDRV_DATA_TYPE_UINT, 32, 4);      // wrong type
+    publish(JSDRV_STREAM_HEADER_SIZE + 16);
+    assert_int_equal(1, count);
+}
+
+static void test_packed_view(void ** state) {
+    (void) state;
+    jsdrv::Context c;
+    assert_int_equal(0, c.initialize());
+    uint32_t count = 0;
+    jsdrv::Subscription sub;
+    assert_int_equal(0, c.subscribe_stream<jsdrv::PackedView<jsdrv::u4>>("u/js220/0/s/i/range/!data",
+            [&count](jsdrv::PackedView<jsdrv::u4> view) {
+                assert_int_equal(16, view.size());
+                for (uint32_t k = 0; k < view.size(); ++k) {
+                    assert_int_equal(k, view[k]);
+                }
+                ++count;
+            }, sub));
+    struct jsdrv_stream_signal_s * s = msg_init(JSDRV_DATA_TYPE_UINT, 4, 16);
+    for (uint32_t k = 0; k < 8; ++k) {
+        s->data[k] = (uint8_t) (((2 * k + 1) << 4) | (2 * k));
+    }
+    publish(JSDRV_STREAM_HEADER_SIZE + 8);
+    assert_int_equal(1, count);
+    msg_init(JSDRV_DATA_TYPE_UINT, 1, 16);      // wrong size
+    publish(JSDRV_STREAM_HEADER_SIZE + 8);
+    assert_int_equal(1, count);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test_setup(test_context, setup),
+            cmocka_unit_test_setup(test_device, setup),
+            cmocka_unit_test_setup(test_subscribe, setup),
+            cmocka_unit_test_setup(test_stream_view, setup),
+            cmocka_unit_test_setup(test_packed_view, setup),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
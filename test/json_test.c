@@ -96,6 +96,14 @@ static void test_value_string(void **state) {
     assert_int_equal(0, jsdrv_json_parse("   \"hello\\n\"   ", on_token, *state));
 }
 
+static void test_value_string_escape(void **state) {
+    expect_tk(&jsdrv_union_cstr("a\\\"b\\u00e9\xc2\xb5"));
+    assert_int_equal(0, jsdrv_json_parse("\"a\\\"b\\u00e9\xc2\xb5\"", on_token, *state));
+    assert_int_equal(JSDRV_ERROR_SYNTAX_ERROR, jsdrv_json_parse("\"a\\x\"", on_token, *state));
+    assert_int_equal(JSDRV_ERROR_SYNTAX_ERROR, jsdrv_json_parse("\"\\u00g0\"", on_token, *state));
+    assert_int_equal(JSDRV_ERROR_SYNTAX_ERROR, jsdrv_json_parse("\"unterminated", on_token, *state));
+}
+
 static void test_value_i32(void **state) {
     expect_tk(&jsdrv_union_i32(0));
     assert_int_equal(0, jsdrv_json_parse("   0   ", on_token, *state));
@@ -219,6 +227,7 @@ int main(void) {
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_empty),
             cmocka_unit_test(test_value_string),
+            cmocka_unit_test(test_value_string_escape),
             cmocka_unit_test(test_value_i32),
             cmocka_unit_test(test_value_literals),
             cmocka_unit_test(test_obj_empty),
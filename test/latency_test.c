@@ -0,0 +1,156 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/latency.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv/time.h"
+#include <string.h>
+
+
+static int setup(void ** state) {
+    (void) state;
+    jsdrv_latency_reset();
+    return 0;
+}
+
+static void test_names(void **state) {
+    (void) state;
+    assert_string_equal("total", jsdrv_latency_stage_name(JSDRV_LATENCY_TOTAL));
+    assert_null(jsdrv_latency_stage_name(JSDRV_LATENCY_STAGE_COUNT));
+    for (uint32_t i = 0; i < JSDRV_LATENCY_STAGE_COUNT; ++i) {
+        assert_true(strlen(jsdrv_latency_stage_name(i)) <= 7);
+    }
+}
+
+static void test_bins(void **state) {
+    (void) state;
+    for (uint64_t us = 0; us < 16; ++us) {
+        assert_int_equal(us, jsdrv_latency_bin(us));
+        assert_int_equal(us, jsdrv_latency_bin_value((uint32_t) us));
+    }
+    assert_int_equal(16, jsdrv_latency_bin(16));
+    assert_int_equal(16, jsdrv_latency_bin(17));
+    assert_int_equal(17, jsdrv_latency_bin(18));
+    assert_int_equal(17, jsdrv_latency_bin_value(16));
+    assert_int_equal(31, jsdrv_latency_bin_value(jsdrv_latency_bin(31)));
+    assert_int_equal(JSDRV_LATENCY_BINS - 1, jsdrv_latency_bin(1ULL << 40));
+    uint32_t bin_prev = 0;
+    for (uint64_t us = 16; us < (1ULL << 32); us = us * 17 / 16 + 1) {
+        uint32_t bin = jsdrv_latency_bin(us);
+        uint64_t value = jsdrv_latency_bin_value(bin);
+        assert_true(bin >= bin_prev);
+        assert_true(value >= us);
+        assert_true(value <= us + us / 8);
+        bin_prev = bin;
+    }
+}
+
+static void test_percentile(void **state) {
+    (void) state;
+    uint64_t bins[JSDRV_LATENCY_BINS];
+    assert_int_equal(0, jsdrv_latency_get(JSDRV_LATENCY_DECODE, bins));
+    assert_int_equal(0, jsdrv_latency_percentile(bins, 500));
+    for (int i = 0; i < 990; ++i) {
+        jsdrv_latency_add(JSDRV_LATENCY_DECODE, JSDRV_TIME_MICROSECOND * 100);
+    }
+    for (int i = 0; i < 9; ++i) {
+        jsdrv_latency_add(JSDRV_LATENCY_DECODE, JSDRV_TIME_MILLISECOND * 10);
+    }
+    jsdrv_latency_add(JSDRV_LATENCY_DECODE, JSDRV_TIME_SECOND);
+    jsdrv_latency_add(JSDRV_LATENCY_QUEUE, -JSDRV_TIME_MILLISECOND);
+    assert_int_equal(1000, jsdrv_latency_get(JSDRV_LATENCY_DECODE, bins));
+    assert_int_equal(jsdrv_latency_bin_value(jsdrv_latency_bin(100)), jsdrv_latency_percentile(bins, 500));
+    assert_int_equal(jsdrv_latency_bin_value(jsdrv_latency_bin(100)), jsdrv_latency_percentile(bins, 990));
+    assert_int_equal(jsdrv_latency_bin_value(jsdrv_latency_bin(10000)), jsdrv_latency_percentile(bins, 999));
+    assert_int_equal(jsdrv_latency_bin_value(jsdrv_latency_bin(1000000)), jsdrv_latency_percentile(bins, 1000));
+    assert_int_equal(1, jsdrv_latency_get(JSDRV_LATENCY_QUEUE, bins));
+    assert_int_equal(1, bins[0]);
+    jsdrv_latency_reset();
+    assert_int_equal(0, jsdrv_latency_get(JSDRV_LATENCY_DECODE, bins));
+}
+
+static void msg_init(struct jsdrvp_msg_s * m, uint32_t element_count) {
+    memset(m, 0, sizeof(*m));
+    m->capacity = sizeof(m->payload);
+    m->value = jsdrv_union_bin(m->payload.bin, 0);
+    m->value.app = JSDRV_PAYLOAD_TYPE_STREAM;
+    struct jsdrv_stream_signal_s * s = (struct jsdrv_stream_signal_s *) m->payload.bin;
+    s->element_type = JSDRV_DATA_TYPE_UINT;
+    s->element_size_bits = 4;
+    s->element_count = element_count;
+    m->value.size = JSDRV_STREAM_HEADER_SIZE + (element_count + 1) / 2;
+}
+
+static void test_dispatch_deliver(void **state) {
+    (void) state;
+    static struct jsdrvp_msg_s m;
+    uint64_t bins[JSDRV_LATENCY_BINS];
+
+    msg_init(&m, 3);
+    jsdrv_latency_dispatch(&m);  // no USB stamp
+    jsdrv_latency_deliver(&m);
+    assert_int_equal(0, m.latency.dispatch);
+    assert_int_equal(0, jsdrv_latency_get(JSDRV_LATENCY_TOTAL, bins));
+
+    int64_t t = jsdrv_time_monotonic();
+    m.latency.usb = t - JSDRV_TIME_MILLISECOND * 2;
+    m.latency.decode = t - JSDRV_TIME_MILLISECOND;
+    jsdrv_latency_dispatch(&m);
+    assert_true(m.latency.dispatch >= t);
+    assert_int_equal(JSDRV_STREAM_HEADER_SIZE + 2, m.value.size);  // trailer disabled
+    jsdrv_latency_deliver(&m);
+    assert_int_equal(1, jsdrv_latency_get(JSDRV_LATENCY_DECODE, bins));
+    assert_true(jsdrv_latency_percentile(bins, 500) >= 1000);
+    assert_int_equal(1, jsdrv_latency_get(JSDRV_LATENCY_QUEUE, bins));
+    assert_int_equal(1, jsdrv_latency_get(JSDRV_LATENCY_DELIVER, bins));
+    assert_int_equal(1, jsdrv_latency_get(JSDRV_LATENCY_TOTAL, bins));
+    assert_true(jsdrv_latency_percentile(bins, 500) >= 2000);
+
+    jsdrv_latency_trailer_set(true);
+    msg_init(&m, 3);
+    m.latency.usb = t;
+    m.latency.decode = t;
+    jsdrv_latency_dispatch(&m);
+    uint32_t offset = JSDRV_STREAM_HEADER_SIZE + 8;
+    assert_int_equal(offset + sizeof(struct jsdrv_stream_latency_s), m.value.size);
+    struct jsdrv_stream_latency_s trailer;
+    memcpy(&trailer, m.payload.bin + offset, sizeof(trailer));
+    assert_int_equal(t, trailer.usb);
+    assert_int_equal(t, trailer.decode);
+    assert_int_equal(m.latency.dispatch, trailer.dispatch);
+
+    msg_init(&m, 3);
+    m.latency.usb = t;
+    m.capacity = JSDRV_STREAM_HEADER_SIZE + 16;  // no room
+    jsdrv_latency_dispatch(&m);
+    assert_int_equal(JSDRV_STREAM_HEADER_SIZE + 2, m.value.size);
+    jsdrv_latency_reset();
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test_setup(test_names, setup),
+            cmocka_unit_test_setup(test_bins, setup),
+            cmocka_unit_test_setup(test_percentile, setup),
+            cmocka_unit_test_setup(test_dispatch_deliver, setup),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
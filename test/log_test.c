@@ -22,9 +22,12 @@
 #include <stdio.h>
 #include "jsdrv/log.h"
 #include "jsdrv_prv/log.h"
+#include "jsdrv_prv/thread.h"
 
 
 #define ENTRY_MAX  (1024)
+#define THREAD_COUNT (4)
+#define THREAD_MSG_COUNT (200)
 
 
 struct state_s {
@@ -32,6 +35,8 @@ struct state_s {
     uint32_t entries_tail;
     uint8_t level[ENTRY_MAX];
     uint32_t line[ENTRY_MAX];
+    char message[JSDRV_LOG_MESSAGE_SIZE_MAX];
+    int thread_next[THREAD_COUNT];
 };
 
 
@@ -47,7 +52,13 @@ static void log_cbk(void * user_data, struct jsdrv_log_header_s const * header,
     state->line[state->entries_head] = header->line;
     ++state->entries_head;
     (void) filename;
-    (void) message;
+    snprintf(state->message, sizeof(state->message), "%s", message);
+    int thread_id = 0;
+    int value = 0;
+    if (2 == sscanf(message, "thread %d %d", &thread_id, &value)) {
+        assert_int_equal(state->thread_next[thread_id], value);  // in order for each thread
+        ++state->thread_next[thread_id];
+    }
 }
 
 #define CHECK(state, level_, line_) \
@@ -92,10 +103,144 @@ static void test_basic(void **state) {
     CHECK(&s, JSDRV_LOG_LEVEL_WARNING, 42);
 }
 
+static int arg_eval_count_ = 0;
+
+static const char * arg_eval(void) {
+    ++arg_eval_count_;
+    return "arg";
+}
+
+static void test_level_skips_arguments(void **state) {
+    (void) state;
+    struct state_s s = {
+            .entries_head=0,
+            .entries_tail=0,
+            .level={0},
+            .line={0},
+    };
+    arg_eval_count_ = 0;
+    jsdrv_log_initialize();
+    jsdrv_log_register(log_cbk, &s);
+    jsdrv_log_level_set(JSDRV_LOG_LEVEL_WARNING);
+    assert_true(JSDRV_LOG_ENABLED(JSDRV_LOG_LEVEL_WARNING));
+    assert_false(JSDRV_LOG_ENABLED(JSDRV_LOG_LEVEL_INFO));
+    JSDRV_LOG(JSDRV_LOG_LEVEL_INFO, "%s", arg_eval());
+    assert_int_equal(0, arg_eval_count_);
+    JSDRV_LOG(JSDRV_LOG_LEVEL_WARNING, "%s", arg_eval());
+    assert_int_equal(1, arg_eval_count_);
+    jsdrv_log_level_set(JSDRV_LOG_LEVEL_OFF);
+    assert_false(JSDRV_LOG_ENABLED(JSDRV_LOG_LEVEL_EMERGENCY));
+    JSDRV_LOG(JSDRV_LOG_LEVEL_EMERGENCY, "%s", arg_eval());
+    assert_int_equal(1, arg_eval_count_);
+    jsdrv_log_finalize();
+}
+
+static void test_deferred_format(void **state) {
+    (void) state;
+    struct state_s s;
+    char expect[JSDRV_LOG_MESSAGE_SIZE_MAX];
+    char unterminated[] = {'a', 'b', 'c', 'd'};
+    memset(&s, 0, sizeof(s));
+    jsdrv_log_initialize();
+    jsdrv_log_register(log_cbk, &s);
+    jsdrv_log_level_set(JSDRV_LOG_LEVEL_INFO);
+    jsdrv_log_deferred_set(true);
+    assert_true(jsdrv_log_deferred_get());
+
+#define FMT "%d|%5u|%-4x|%08llX|%hhd|%zu|%c|%s|%.*s|%*d|%6.2f|%g|%%|%p"
+#define ARGS -3, 42U, 0xabU, 0x123456789ULL, 257, (size_t) 7, 'z', "str", 3, unterminated, -5, 9, 3.14159, 1e-9, (void *) &s
+    snprintf(expect, sizeof(expect), FMT, ARGS);
+    JSDRV_LOG(JSDRV_LOG_LEVEL_WARNING, FMT, ARGS);
+    jsdrv_log_finalize();
+    CHECK(&s, JSDRV_LOG_LEVEL_WARNING, __LINE__ - 2);
+    assert_string_equal(expect, s.message);
+#undef FMT
+#undef ARGS
+    jsdrv_log_deferred_set(false);
+}
+
+static void test_deferred_fallback(void **state) {
+    (void) state;
+    struct state_s s;
+    memset(&s, 0, sizeof(s));
+    jsdrv_log_initialize();
+    jsdrv_log_register(log_cbk, &s);
+    jsdrv_log_level_set(JSDRV_LOG_LEVEL_INFO);
+    jsdrv_log_deferred_set(true);
+    JSDRV_LOGW("%ls", L"wide");  // not supported by deferred, formats immediately
+    jsdrv_log_finalize();
+    CHECK(&s, JSDRV_LOG_LEVEL_WARNING, __LINE__ - 2);
+    assert_string_equal("wide", s.message);
+    jsdrv_log_deferred_set(false);
+}
+
+static THREAD_RETURN_TYPE log_thread(THREAD_ARG_TYPE arg) {
+    int thread_id = (int) (intptr_t) arg;
+    for (int i = 0; i < THREAD_MSG_COUNT; ++i) {
+        JSDRV_LOGI("thread %d %d", thread_id, i);
+        if (0 == (i % 50)) {
+            jsdrv_thread_sleep_ms(1);
+        }
+    }
+    THREAD_RETURN();
+}
+
+static void test_deferred_threads(void **state) {
+    (void) state;
+    struct state_s s;
+    jsdrv_thread_t threads[THREAD_COUNT];
+    memset(&s, 0, sizeof(s));
+    jsdrv_log_initialize();
+    jsdrv_log_register(log_cbk, &s);
+    jsdrv_log_level_set(JSDRV_LOG_LEVEL_INFO);
+    jsdrv_log_deferred_set(true);
+    for (int i = 0; i < THREAD_COUNT; ++i) {
+        assert_int_equal(0, jsdrv_thread_create(&threads[i], log_thread, (THREAD_ARG_TYPE) (intptr_t) i, 0));
+    }
+    for (int i = 0; i < THREAD_COUNT; ++i) {
+        assert_int_equal(0, jsdrv_thread_join(&threads[i], 1000));
+    }
+    jsdrv_log_finalize();
+    assert_int_equal(THREAD_COUNT * THREAD_MSG_COUNT, s.entries_head);
+    for (int i = 0; i < THREAD_COUNT; ++i) {
+        assert_int_equal(THREAD_MSG_COUNT, s.thread_next[i]);
+    }
+    jsdrv_log_deferred_set(false);
+}
+
+static void test_rate(void **state) {
+    (void) state;
+    struct state_s s;
+    memset(&s, 0, sizeof(s));
+    jsdrv_log_initialize();
+    jsdrv_log_register(log_cbk, &s);
+    jsdrv_log_level_set(JSDRV_LOG_LEVEL_INFO);
+    for (int i = 0; i < 100; ++i) {
+        JSDRV_LOGW_RATE("rate %d", i);
+    }
+    int line = __LINE__ - 2;
+    jsdrv_thread_sleep_ms(10);
+    assert_int_equal(JSDRV_LOG_RATE_BURST, s.entries_head);  // summary waits for the interval
+    JSDRV_LOGI_RATE("rate once");
+    jsdrv_log_finalize();
+    assert_int_equal(JSDRV_LOG_RATE_BURST + 2, s.entries_head);
+    for (int i = 0; i < JSDRV_LOG_RATE_BURST; ++i) {
+        CHECK(&s, JSDRV_LOG_LEVEL_WARNING, line);
+    }
+    CHECK(&s, JSDRV_LOG_LEVEL_INFO, line + 5);
+    CHECK(&s, JSDRV_LOG_LEVEL_WARNING, line);  // summary on finalize
+    assert_string_equal("suppressed 95 similar messages: rate %d", s.message);
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_register_before_init),
             cmocka_unit_test(test_basic),
+            cmocka_unit_test(test_level_skips_arguments),
+            cmocka_unit_test(test_deferred_format),
+            cmocka_unit_test(test_deferred_fallback),
+            cmocka_unit_test(test_deferred_threads),
+            cmocka_unit_test(test_rate),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/meta_store.h"
+#include "jsdrv/error_code.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char * META_U8 = "{\"dtype\": \"u8\", \"brief\": \"Value.\", \"default\": 2, \"range\": [0, 10]}";
+static const char * META_U32 = "{\"dtype\": \"u32\", \"brief\": \"Value.\", \"default\": 2}";
+
+
+static void test_intern_shares_entry(void **state) {
+    (void) state;
+    char copy[128];
+    struct jsdrv_meta_store_s * s = jsdrv_meta_store_alloc();
+    const struct jsdrv_meta_entry_s * e1 = jsdrv_meta_store_intern(s, META_U8);
+    assert_non_null(e1);
+    assert_int_equal(1, jsdrv_meta_store_count(s));
+    assert_string_equal(META_U8, e1->json);
+    assert_int_equal(strlen(META_U8) + 1, e1->size);
+    assert_int_equal(0, e1->schema.status);
+    assert_int_equal(JSDRV_UNION_U8, e1->schema.dtype);
+
+    strcpy(copy, META_U8);  // same content at a different address
+    const struct jsdrv_meta_entry_s * e2 = jsdrv_meta_store_intern(s, copy);
+    assert_ptr_equal(e1, e2);
+    assert_int_equal(1, jsdrv_meta_store_count(s));
+
+    const struct jsdrv_meta_entry_s * e3 = jsdrv_meta_store_intern(s, META_U32);
+    assert_ptr_not_equal(e1, e3);
+    assert_int_equal(2, jsdrv_meta_store_count(s));
+    assert_int_equal(JSDRV_UNION_U32, e3->schema.dtype);
+
+    jsdrv_meta_store_release(s, e1);
+    assert_int_equal(2, jsdrv_meta_store_count(s));
+    assert_int_equal(0, jsdrv_meta_schema_value(&e2->schema, &jsdrv_union_u8(5)));
+    jsdrv_meta_store_release(s, e2);
+    assert_int_equal(1, jsdrv_meta_store_count(s));
+    jsdrv_meta_store_release(s, NULL);
+    jsdrv_meta_store_free(s);  // frees e3
+}
+
+static void test_invalid(void **state) {
+    (void) state;
+    struct jsdrv_meta_store_s * s = jsdrv_meta_store_alloc();
+    const struct jsdrv_meta_entry_s * e = jsdrv_meta_store_intern(s, "{\"dtype\": ");
+    assert_int_not_equal(0, e->schema.status);
+    assert_int_equal(e->schema.status, jsdrv_meta_schema_value(&e->schema, &jsdrv_union_u8(1)));
+    jsdrv_meta_store_release(s, e);
+    assert_int_equal(0, jsdrv_meta_store_count(s));
+    jsdrv_meta_store_free(s);
+}
+
+static void test_many(void **state) {
+    (void) state;
+    char json[64];
+    const struct jsdrv_meta_entry_s * e[1000];
+    struct jsdrv_meta_store_s * s = jsdrv_meta_store_alloc();
+    for (uint32_t k = 0; k < 1000; ++k) {
+        snprintf(json, sizeof(json), "{\"dtype\": \"u32\", \"default\": %u}", (unsigned int) k);
+        e[k] = jsdrv_meta_store_intern(s, json);
+    }
+    assert_int_equal(1000, jsdrv_meta_store_count(s));
+    for (uint32_t k = 0; k < 1000; ++k) {
+        snprintf(json, sizeof(json), "{\"dtype\": \"u32\", \"default\": %u}", (unsigned int) k);
+        assert_ptr_equal(e[k], jsdrv_meta_store_intern(s, json));
+        jsdrv_meta_store_release(s, e[k]);
+        jsdrv_meta_store_release(s, e[k]);
+    }
+    assert_int_equal(0, jsdrv_meta_store_count(s));
+    jsdrv_meta_store_free(s);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_intern_shares_entry),
+            cmocka_unit_test(test_invalid),
+            cmocka_unit_test(test_many),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
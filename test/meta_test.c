@@ -94,11 +94,81 @@ static void test_no_default(void **state) {
     assert_false(value.flags & JSDRV_UNION_FLAG_RETAIN);
 }
 
+const char * META_BOOL = "{"
+    "\"dtype\": \"bool\","
+    "\"brief\": \"Enable.\","
+    "\"default\": 0"
+"}";
+
+const char * META_RANGE = "{"
+    "\"dtype\": \"u32\","
+    "\"brief\": \"Count.\","
+    "\"range\": [1, 100, 1]"
+"}";
+
+static void test_schema(void **state) {
+    (void) state;
+    struct jsdrv_meta_schema_s schema;
+    struct jsdrv_union_s value;
+    assert_int_equal(0, jsdrv_meta_compile(META1, &schema));
+    assert_int_equal(JSDRV_UNION_U8, schema.dtype);
+    assert_int_equal(JSDRV_META_SCHEMA_FLAG_OPTIONS, schema.flags);
+    assert_int_equal(23, schema.option_count);  // each value and alias
+    for (int i = 0; i < 2; ++i) {  // schema is reusable
+        value = cstr("_3_");
+        assert_int_equal(0, jsdrv_meta_schema_value(&schema, &value));
+        assert_true(jsdrv_union_eq(&jsdrv_union_u8(3), &value));
+        value = jsdrv_union_u32(10);
+        assert_int_equal(0, jsdrv_meta_schema_value(&schema, &value));
+        assert_true(jsdrv_union_eq(&jsdrv_union_u8(10), &value));
+        value = jsdrv_union_u8(11);
+        assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_meta_schema_value(&schema, &value));
+    }
+    jsdrv_meta_schema_free(&schema);
+    assert_null(schema.options);
+}
+
+static void test_schema_bool_range(void **state) {
+    (void) state;
+    struct jsdrv_meta_schema_s schema;
+    struct jsdrv_union_s value;
+    assert_int_equal(0, jsdrv_meta_compile(META_BOOL, &schema));
+    assert_int_equal(JSDRV_META_SCHEMA_FLAG_BOOL, schema.flags);
+    value = cstr("on");
+    assert_int_equal(0, jsdrv_meta_schema_value(&schema, &value));
+    assert_true(jsdrv_union_eq(&jsdrv_union_u8(1), &value));
+    jsdrv_meta_schema_free(&schema);
+
+    assert_int_equal(0, jsdrv_meta_compile(META_RANGE, &schema));
+    assert_int_equal(JSDRV_UNION_U32, schema.dtype);
+    assert_int_equal(JSDRV_META_SCHEMA_FLAG_RANGE, schema.flags);
+    assert_int_equal(3, schema.range_count);
+    assert_int_equal(100, schema.range[1].u64);
+    value = cstr("42");
+    assert_int_equal(0, jsdrv_meta_schema_value(&schema, &value));
+    assert_true(jsdrv_union_eq(&jsdrv_union_u32(42), &value));
+    jsdrv_meta_schema_free(&schema);
+
+    assert_int_equal(0, jsdrv_meta_compile("{\"dtype\": \"str\"}", &schema));
+    assert_int_equal(JSDRV_UNION_STR, schema.dtype);
+    value = cstr("a/b");
+    assert_int_equal(0, jsdrv_meta_schema_value(&schema, &value));
+    assert_int_equal(JSDRV_UNION_STR, value.type);
+    jsdrv_meta_schema_free(&schema);
+
+    assert_int_not_equal(0, jsdrv_meta_compile("{\"dtype\": \"invalid\"}", &schema));
+    value = jsdrv_union_u8(1);
+    assert_int_not_equal(0, jsdrv_meta_schema_value(&schema, &value));
+    jsdrv_meta_schema_free(&schema);
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_basic),
             cmocka_unit_test(test_value),
             cmocka_unit_test(test_no_default),
+            cmocka_unit_test(test_schema),
+            cmocka_unit_test(test_schema_bool_range),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
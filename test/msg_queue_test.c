@@ -0,0 +1,423 @@
+/*
+ * Copyright 2023 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv.h"
+#include "jsdrv_prv/frontend.h"
+#include "jsdrv_prv/backend.h"
+#include "jsdrv_prv/list.h"
+#include "jsdrv_prv/msg_queue.h"
+#include "jsdrv_prv/platform.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv/error_code.h"
+#include <string.h>
+#if !_WIN32
+#include <poll.h>
+#endif
+
+
+#define STRESS_COUNT (100000U)
+
+
+static struct jsdrvp_msg_s * msg_alloc(uint32_t id) {
+    struct jsdrvp_msg_s * msg = jsdrv_alloc_clr(sizeof(struct jsdrvp_msg_s));
+    jsdrv_list_initialize(&msg->item);
+    msg->u32_a = id;
+    msg->qos = JSDRVP_QOS_NORMAL;
+    return msg;
+}
+
+static struct jsdrvp_msg_s * msg_alloc_data(uint32_t id) {
+    struct jsdrvp_msg_s * msg = msg_alloc(id);
+    msg->inner_msg_type = JSDRV_MSG_TYPE_DATA;
+    return msg;
+}
+
+static struct jsdrvp_msg_s * msg_alloc_qos(uint32_t id, uint32_t qos) {
+    struct jsdrvp_msg_s * msg = msg_alloc_data(id);
+    msg->qos = qos;
+    return msg;
+}
+
+static struct jsdrvp_msg_s * msg_alloc_topic(uint32_t id, const char * topic) {
+    struct jsdrvp_msg_s * msg = msg_alloc(id);
+    strcpy(msg->topic, topic);
+    return msg;
+}
+
+static struct jsdrvp_msg_s * msg_alloc_control(uint32_t id) {
+    return msg_alloc_topic(id, "u/js220/0001/h/fs#");
+}
+
+static void check_pop(struct msg_queue_s * q, uint32_t id) {
+    struct jsdrvp_msg_s * msg = msg_queue_pop_immediate(q);
+    assert_non_null(msg);
+    assert_int_equal(id, msg->u32_a);
+    jsdrv_free(msg);
+}
+
+static void test_locked(void ** state) {
+    (void) state;
+    struct msg_queue_s * q = msg_queue_init();
+    assert_true(msg_queue_is_empty(q));
+    assert_null(msg_queue_pop_immediate(q));
+    msg_queue_push(q, msg_alloc(1));
+    msg_queue_push(q, msg_alloc(2));
+    assert_false(msg_queue_is_empty(q));
+    check_pop(q, 1);
+    check_pop(q, 2);
+    assert_null(msg_queue_pop_immediate(q));
+    msg_queue_finalize(q);
+}
+
+static void test_push_list(void ** state) {
+    (void) state;
+    struct jsdrv_list_s list;
+    struct msg_queue_s * queues[] = {msg_queue_init(), msg_queue_init_spsc(4)};
+    for (uint32_t k = 0; k < 2; ++k) {
+        struct msg_queue_s * q = queues[k];
+        jsdrv_list_initialize(&list);
+        msg_queue_push_list(q, &list);
+        assert_true(msg_queue_is_empty(q));
+        msg_queue_push(q, msg_alloc(0));
+        for (uint32_t i = 1; i < 8; ++i) {
+            struct jsdrvp_msg_s * msg = msg_alloc(i);
+            jsdrv_list_add_tail(&list, &msg->item);
+        }
+        msg_queue_push_list(q, &list);
+        assert_true(jsdrv_list_is_empty(&list));
+        for (uint32_t i = 0; i < 8; ++i) {
+            check_pop(q, i);
+        }
+        assert_null(msg_queue_pop_immediate(q));
+        msg_queue_finalize(q);
+    }
+}
+
+static void test_spsc_order(void ** state) {
+    (void) state;
+    struct msg_queue_s * q = msg_queue_init_spsc(4);
+    assert_true(msg_queue_is_empty(q));
+    assert_null(msg_queue_pop_immediate(q));
+    for (uint32_t i = 0; i < 3; ++i) {
+        msg_queue_push(q, msg_alloc(i));
+    }
+    assert_false(msg_queue_is_empty(q));
+    for (uint32_t i = 0; i < 3; ++i) {
+        check_pop(q, i);
+    }
+    assert_true(msg_queue_is_empty(q));
+    assert_null(msg_queue_pop_immediate(q));
+    msg_queue_finalize(q);
+}
+
+static void test_spsc_overflow(void ** state) {
+    (void) state;
+    struct msg_queue_s * q = msg_queue_init_spsc(4);
+    for (uint32_t i = 0; i < 10; ++i) {  // exceeds ring capacity
+        msg_queue_push(q, msg_alloc(i));
+    }
+    check_pop(q, 0);
+    check_pop(q, 1);
+    msg_queue_push(q, msg_alloc(10));  // must follow overflow items
+    for (uint32_t i = 2; i <= 10; ++i) {
+        check_pop(q, i);
+    }
+    assert_null(msg_queue_pop_immediate(q));
+    msg_queue_push(q, msg_alloc(11));  // back to the ring
+    check_pop(q, 11);
+    msg_queue_finalize(q);
+}
+
+static void test_spsc_pop_timeout(void ** state) {
+    (void) state;
+    struct jsdrvp_msg_s * msg = NULL;
+    struct msg_queue_s * q = msg_queue_init_spsc(4);
+    assert_int_equal(JSDRV_ERROR_TIMED_OUT, msg_queue_pop(q, &msg, 0));
+    assert_int_equal(JSDRV_ERROR_TIMED_OUT, msg_queue_pop(q, &msg, 1));
+    msg_queue_push(q, msg_alloc(1));
+    assert_int_equal(0, msg_queue_pop(q, &msg, 10));
+    assert_non_null(msg);
+    jsdrv_free(msg);
+    msg_queue_finalize(q);
+}
+
+static void test_spsc_finalize_nonempty(void ** state) {
+    (void) state;
+    struct msg_queue_s * q = msg_queue_init_spsc(2);
+    for (uint32_t i = 0; i < 5; ++i) {
+        msg_queue_push(q, msg_alloc(i));
+    }
+    msg_queue_finalize(q);  // frees ring and overflow messages
+}
+
+static void test_lanes(void ** state) {
+    (void) state;
+    struct msg_queue_s * queues[] = {msg_queue_init(), msg_queue_init_spsc(4)};
+    for (uint32_t k = 0; k < 2; ++k) {
+        struct msg_queue_s * q = queues[k];
+        msg_queue_lanes_enable(q);
+        for (uint32_t i = 0; i < 6; ++i) {  // overflows the ring
+            msg_queue_push(q, msg_alloc_data(i));
+        }
+        msg_queue_push(q, msg_alloc_topic(6, JSDRV_USBBK_MSG_STREAM_IN_DATA));
+        msg_queue_push(q, msg_alloc_topic(7, "u/js220/0001/h/trig/0/!event"));
+        msg_queue_push(q, msg_alloc_topic(8, JSDRV_MSG_FINALIZE));
+        msg_queue_push(q, msg_alloc_topic(9, "u/js220/0001/h/fs#"));
+        msg_queue_push(q, msg_alloc_topic(10, JSDRV_MSG_OPEN));
+        msg_queue_push(q, msg_alloc_topic(11, "u/js220/0001/h/fs$"));
+        msg_queue_push(q, msg_alloc_topic(12, JSDRV_USBBK_MSG_CTRL_IN));
+        assert_int_equal(4, msg_queue_depth(q, MSG_QUEUE_LANE_CONTROL));
+        assert_int_equal(9, msg_queue_depth(q, MSG_QUEUE_LANE_DATA));
+        assert_int_equal(0, msg_queue_depth(q, MSG_QUEUE_LANE_COUNT));
+        for (uint32_t i = 9; i < 13; ++i) {
+            check_pop(q, i);
+        }
+        check_pop(q, 0);
+        msg_queue_push(q, msg_alloc_control(13));  // overtakes data
+        check_pop(q, 13);
+        assert_int_equal(0, msg_queue_depth(q, MSG_QUEUE_LANE_CONTROL));
+        for (uint32_t i = 1; i < 9; ++i) {
+            check_pop(q, i);
+        }
+        assert_true(msg_queue_is_empty(q));
+        assert_int_equal(0, msg_queue_depth(q, MSG_QUEUE_LANE_DATA));
+        assert_null(msg_queue_pop_immediate(q));
+        msg_queue_push(q, msg_alloc_control(14));
+        assert_false(msg_queue_is_empty(q));
+        msg_queue_finalize(q);  // frees the control lane message
+    }
+}
+
+static void test_lanes_push_list(void ** state) {
+    (void) state;
+    struct jsdrv_list_s list;
+    struct msg_queue_s * queues[] = {msg_queue_init(), msg_queue_init_spsc(4)};
+    for (uint32_t k = 0; k < 2; ++k) {
+        struct msg_queue_s * q = queues[k];
+        msg_queue_lanes_enable(q);
+        jsdrv_list_initialize(&list);
+        for (uint32_t i = 0; i < 8; ++i) {
+            struct jsdrvp_msg_s * msg = (i & 1) ? msg_alloc_control(i) : msg_alloc_data(i);
+            jsdrv_list_add_tail(&list, &msg->item);
+        }
+        msg_queue_push_list(q, &list);
+        assert_true(jsdrv_list_is_empty(&list));
+        assert_int_equal(4, msg_queue_depth(q, MSG_QUEUE_LANE_CONTROL));
+        assert_int_equal(4, msg_queue_depth(q, MSG_QUEUE_LANE_DATA));
+        for (uint32_t i = 1; i < 8; i += 2) {
+            check_pop(q, i);
+        }
+        for (uint32_t i = 0; i < 8; i += 2) {
+            check_pop(q, i);
+        }
+        assert_null(msg_queue_pop_immediate(q));
+        msg_queue_finalize(q);
+    }
+}
+
+static void test_no_lanes_depth(void ** state) {
+    (void) state;
+    struct msg_queue_s * q = msg_queue_init_spsc(4);
+    msg_queue_push(q, msg_alloc_data(0));
+    msg_queue_push(q, msg_alloc_control(1));
+    assert_int_equal(0, msg_queue_depth(q, MSG_QUEUE_LANE_CONTROL));
+    assert_int_equal(0, msg_queue_depth(q, MSG_QUEUE_LANE_DATA));
+    check_pop(q, 0);  // FIFO
+    check_pop(q, 1);
+    msg_queue_finalize(q);
+}
+
+static void test_qos(void ** state) {
+    (void) state;
+    struct msg_queue_s * queues[] = {msg_queue_init(), msg_queue_init_spsc(4)};
+    for (uint32_t k = 0; k < 2; ++k) {
+        struct msg_queue_s * q = queues[k];
+        msg_queue_lanes_enable(q);
+        msg_queue_qos_enable(q);
+        msg_queue_push(q, msg_alloc_qos(0, JSDRVP_QOS_NORMAL));
+        msg_queue_push(q, msg_alloc_qos(1, JSDRVP_QOS_BACKGROUND));
+        msg_queue_push(q, msg_alloc_qos(2, JSDRVP_QOS_CRITICAL));
+        msg_queue_push(q, msg_alloc_qos(3, JSDRVP_QOS_NORMAL));
+        struct jsdrvp_msg_s * msg = msg_alloc_control(4);
+        msg->qos = JSDRVP_QOS_BACKGROUND;  // control lane ignores qos
+        msg_queue_push(q, msg);
+        msg_queue_push(q, msg_alloc_qos(5, JSDRVP_QOS_CRITICAL));
+        msg_queue_push(q, msg_alloc_qos(6, JSDRVP_QOS_BACKGROUND));
+        assert_int_equal(1, msg_queue_depth(q, MSG_QUEUE_LANE_CONTROL));
+        assert_int_equal(2, msg_queue_depth(q, MSG_QUEUE_LANE_CRITICAL));
+        assert_int_equal(2, msg_queue_depth(q, MSG_QUEUE_LANE_DATA));
+        assert_int_equal(2, msg_queue_depth(q, MSG_QUEUE_LANE_BACKGROUND));
+        check_pop(q, 4);
+        check_pop(q, 2);
+        check_pop(q, 5);
+        check_pop(q, 0);
+        msg_queue_push(q, msg_alloc_qos(7, JSDRVP_QOS_CRITICAL));  // overtakes normal
+        check_pop(q, 7);
+        check_pop(q, 3);
+        check_pop(q, 1);
+        check_pop(q, 6);
+        assert_true(msg_queue_is_empty(q));
+        assert_null(msg_queue_pop_immediate(q));
+        msg_queue_push(q, msg_alloc_qos(8, JSDRVP_QOS_BACKGROUND));
+        assert_false(msg_queue_is_empty(q));
+        msg_queue_finalize(q);  // frees the background lane message
+    }
+}
+
+static void test_qos_without_lanes(void ** state) {
+    (void) state;
+    struct msg_queue_s * q = msg_queue_init_spsc(4);
+    msg_queue_qos_enable(q);
+    struct jsdrvp_msg_s * msg = msg_alloc_control(0);
+    msg->qos = JSDRVP_QOS_BACKGROUND;
+    msg_queue_push(q, msg);
+    msg_queue_push(q, msg_alloc_qos(1, JSDRVP_QOS_NORMAL));
+    assert_int_equal(0, msg_queue_depth(q, MSG_QUEUE_LANE_CONTROL));
+    assert_int_equal(1, msg_queue_depth(q, MSG_QUEUE_LANE_BACKGROUND));
+    check_pop(q, 1);
+    check_pop(q, 0);
+    msg_queue_finalize(q);
+}
+
+static THREAD_RETURN_TYPE producer_thread(THREAD_ARG_TYPE lpParam) {
+    struct msg_queue_s * q = (struct msg_queue_s *) lpParam;
+    for (uint32_t i = 0; i < STRESS_COUNT; ++i) {
+        msg_queue_push(q, msg_alloc(i));
+    }
+    THREAD_RETURN();
+}
+
+static THREAD_RETURN_TYPE lanes_producer_thread(THREAD_ARG_TYPE lpParam) {
+    struct msg_queue_s * q = (struct msg_queue_s *) lpParam;
+    for (uint32_t i = 0; i < STRESS_COUNT; ++i) {
+        msg_queue_push(q, (i % 3) ? msg_alloc_data(i) : msg_alloc_control(i));
+    }
+    THREAD_RETURN();
+}
+
+static void test_lanes_spsc_threads(void ** state) {
+    (void) state;
+    jsdrv_thread_t thread;
+    struct jsdrvp_msg_s * msg = NULL;
+    struct msg_queue_s * q = msg_queue_init_spsc(64);
+    msg_queue_lanes_enable(q);
+    uint32_t next[MSG_QUEUE_LANE_COUNT] = {0, 1};
+    assert_int_equal(0, jsdrv_thread_create(&thread, lanes_producer_thread, q, 0));
+    for (uint32_t i = 0; i < STRESS_COUNT; ++i) {
+        assert_int_equal(0, msg_queue_pop(q, &msg, 1000));
+        uint8_t lane = (JSDRV_MSG_TYPE_DATA == msg->inner_msg_type) ? MSG_QUEUE_LANE_DATA : MSG_QUEUE_LANE_CONTROL;
+        assert_int_equal(next[lane], msg->u32_a);  // each lane remains FIFO
+        next[lane] += (MSG_QUEUE_LANE_CONTROL == lane) ? 3 : ((next[lane] % 3) == 1 ? 1 : 2);
+        jsdrv_free(msg);
+    }
+    assert_int_equal(0, jsdrv_thread_join(&thread, 1000));
+    assert_null(msg_queue_pop_immediate(q));
+    assert_int_equal(0, msg_queue_depth(q, MSG_QUEUE_LANE_CONTROL));
+    assert_int_equal(0, msg_queue_depth(q, MSG_QUEUE_LANE_DATA));
+    msg_queue_finalize(q);
+}
+
+static void test_locked_threads(void ** state) {
+    (void) state;
+    jsdrv_thread_t thread;
+    struct jsdrvp_msg_s * msg = NULL;
+    struct msg_queue_s * q = msg_queue_init();
+    assert_int_equal(0, jsdrv_thread_create(&thread, producer_thread, q, 0));
+    for (uint32_t i = 0; i < STRESS_COUNT; ++i) {
+        assert_int_equal(0, msg_queue_pop(q, &msg, 1000));
+        assert_int_equal(i, msg->u32_a);
+        jsdrv_free(msg);
+    }
+    assert_int_equal(0, jsdrv_thread_join(&thread, 1000));
+    assert_null(msg_queue_pop_immediate(q));
+    msg_queue_finalize(q);
+}
+
+#if !_WIN32
+static bool is_readable(struct msg_queue_s * q) {
+    struct pollfd fds = {.fd = msg_queue_handle_get(q), .events = POLLIN, .revents = 0};
+    return poll(&fds, 1, 0) > 0;
+}
+
+static void test_handle_level(void ** state) {
+    (void) state;
+    struct msg_queue_s * queues[] = {msg_queue_init(), msg_queue_init_spsc(4)};
+    for (uint32_t k = 0; k < 2; ++k) {
+        struct msg_queue_s * q = queues[k];
+        assert_false(is_readable(q));
+        for (uint32_t i = 0; i < 3; ++i) {
+            msg_queue_push(q, msg_alloc(i));
+        }
+        assert_true(is_readable(q));
+        check_pop(q, 0);
+        assert_true(is_readable(q));  // remains signaled until drained
+        check_pop(q, 1);
+        check_pop(q, 2);
+        assert_null(msg_queue_pop_immediate(q));
+        assert_false(is_readable(q));
+        msg_queue_push(q, msg_alloc(3));
+        assert_true(is_readable(q));
+        check_pop(q, 3);
+        assert_null(msg_queue_pop_immediate(q));
+        assert_false(is_readable(q));
+        msg_queue_finalize(q);
+    }
+}
+#endif
+
+static void test_spsc_threads(void ** state) {
+    (void) state;
+    jsdrv_thread_t thread;
+    struct jsdrvp_msg_s * msg = NULL;
+    struct msg_queue_s * q = msg_queue_init_spsc(64);
+    assert_int_equal(0, jsdrv_thread_create(&thread, producer_thread, q, 0));
+    for (uint32_t i = 0; i < STRESS_COUNT; ++i) {
+        assert_int_equal(0, msg_queue_pop(q, &msg, 1000));
+        assert_int_equal(i, msg->u32_a);
+        jsdrv_free(msg);
+    }
+    assert_int_equal(0, jsdrv_thread_join(&thread, 1000));
+    assert_null(msg_queue_pop_immediate(q));
+    msg_queue_finalize(q);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_locked),
+            cmocka_unit_test(test_locked_threads),
+#if !_WIN32
+            cmocka_unit_test(test_handle_level),
+#endif
+            cmocka_unit_test(test_push_list),
+            cmocka_unit_test(test_spsc_order),
+            cmocka_unit_test(test_spsc_overflow),
+            cmocka_unit_test(test_spsc_pop_timeout),
+            cmocka_unit_test(test_spsc_finalize_nonempty),
+            cmocka_unit_test(test_spsc_threads),
+            cmocka_unit_test(test_lanes),
+            cmocka_unit_test(test_lanes_push_list),
+            cmocka_unit_test(test_no_lanes_depth),
+            cmocka_unit_test(test_qos),
+            cmocka_unit_test(test_qos_without_lanes),
+            cmocka_unit_test(test_lanes_spsc_threads),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
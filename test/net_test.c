@@ -0,0 +1,170 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include "jsdrv.h"
+#include "jsdrv/net.h"
+#include "jsdrv/error_code.h"
+
+
+#define TOPIC "u/js220/000415/s/i/!data"
+
+static uint8_t buf_[JSDRV_NET_FRAME_SIZE_MAX];
+static uint8_t scratch_[sizeof(struct jsdrv_stream_signal_s)];
+static struct jsdrv_stream_signal_s signal_;
+
+static uint32_t signal_f32(uint32_t n) {
+    memset(&signal_, 0, sizeof(signal_));
+    signal_.sample_id = 1000;
+    signal_.field_id = JSDRV_FIELD_CURRENT;
+    signal_.element_type = JSDRV_DATA_TYPE_FLOAT;
+    signal_.element_size_bits = 32;
+    signal_.element_count = n;
+    signal_.sample_rate = 1000000;
+    signal_.decimate_factor = 1;
+    float * data = (float *) signal_.data;
+    for (uint32_t i = 0; i < n; ++i) {
+        data[i] = 0.001f * (float) (i & 0xff);
+    }
+    return JSDRV_STREAM_HEADER_SIZE + n * sizeof(float);
+}
+
+static void roundtrip(uint8_t frame_type, const char * topic, const struct jsdrv_union_s * value,
+                      struct jsdrv_net_frame_s * frame) {
+    uint32_t sz = jsdrv_net_encode(frame_type, topic, value, JSDRV_NET_CODEC_RAW, buf_, sizeof(buf_));
+    assert_true(sz > 0);
+    assert_int_equal(JSDRV_ERROR_TOO_SMALL, jsdrv_net_decode(buf_, sz - 1, frame, NULL, 0));
+    assert_int_equal(0, jsdrv_net_decode(buf_, sz + 8, frame, NULL, 0));
+    assert_int_equal(frame_type, frame->frame_type);
+    assert_string_equal(topic, frame->topic);
+}
+
+static void test_values(void **state) {
+    (void) state;
+    struct jsdrv_net_frame_s frame;
+    struct jsdrv_union_s v = jsdrv_union_u32_r(42);
+    roundtrip(JSDRV_NET_FRAME_PUBLISH, "a/b", &v, &frame);
+    assert_true(jsdrv_union_eq_exact(&v, &frame.value));
+
+    v = jsdrv_union_f64(-1.5);
+    v.op = 3;
+    v.app = 4;
+    roundtrip(JSDRV_NET_FRAME_PUBLISH, "a/b/c/d/e/f", &v, &frame);
+    assert_true(jsdrv_union_eq_exact(&v, &frame.value));
+
+    v = jsdrv_union_cstr("hello");
+    roundtrip(JSDRV_NET_FRAME_QUERY, "a/str", &v, &frame);
+    assert_int_equal(JSDRV_UNION_STR, frame.value.type);
+    assert_string_equal("hello", frame.value.value.str);
+
+    roundtrip(JSDRV_NET_FRAME_QUERY, "a/null", NULL, &frame);
+    assert_int_equal(JSDRV_UNION_NULL, frame.value.type);
+
+    v = jsdrv_union_null();
+    v.flags = JSDRV_SFLAG_PUB | JSDRV_SFLAG_RETAIN;
+    assert_true(jsdrv_net_encode(JSDRV_NET_FRAME_SUBSCRIBE, "a", &v, JSDRV_NET_CODEC_COMPRESS, buf_, sizeof(buf_)) > 0);
+    assert_int_equal(0, jsdrv_net_decode(buf_, sizeof(buf_), &frame, NULL, 0));
+    assert_int_equal(JSDRV_SFLAG_PUB | JSDRV_SFLAG_RETAIN, frame.value.flags);
+    assert_int_equal(JSDRV_NET_CODEC_COMPRESS, frame.codec);
+}
+
+static void test_stream(void **state) {
+    (void) state;
+    struct jsdrv_net_frame_s frame;
+    uint32_t size = signal_f32(10000);
+    struct jsdrv_union_s v = jsdrv_union_bin((const uint8_t *) &signal_, size);
+    v.app = JSDRV_PAYLOAD_TYPE_STREAM;
+
+    uint32_t raw = jsdrv_net_encode(JSDRV_NET_FRAME_PUBLISH, TOPIC, &v, JSDRV_NET_CODEC_RAW, buf_, sizeof(buf_));
+    assert_true(raw > size);
+    uint32_t sz = jsdrv_net_encode(JSDRV_NET_FRAME_PUBLISH, TOPIC, &v, JSDRV_NET_CODEC_COMPRESS, buf_, sizeof(buf_));
+    assert_true(sz < raw);
+    assert_int_equal(JSDRV_NET_CODEC_XOR_F32, ((struct jsdrv_net_header_s *) buf_)->codec);
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_net_decode(buf_, sz, &frame, NULL, 0));
+    assert_int_equal(0, jsdrv_net_decode(buf_, sz, &frame, scratch_, sizeof(scratch_)));
+    assert_int_equal(size, frame.value.size);
+    assert_int_equal(JSDRV_PAYLOAD_TYPE_STREAM, frame.value.app);
+    assert_memory_equal(&signal_, frame.value.value.bin, size);
+
+    // u4 with run-length encoding
+    memset(&signal_, 0, sizeof(signal_));
+    signal_.element_type = JSDRV_DATA_TYPE_UINT;
+    signal_.element_size_bits = 4;
+    signal_.element_count = 20000;
+    memset(signal_.data, 0x11, 10000);
+    v.size = JSDRV_STREAM_HEADER_SIZE + 10000;
+    sz = jsdrv_net_encode(JSDRV_NET_FRAME_PUBLISH, TOPIC, &v, JSDRV_NET_CODEC_COMPRESS, buf_, sizeof(buf_));
+    assert_true(sz < 1000);
+    assert_int_equal(JSDRV_NET_CODEC_RLE8, ((struct jsdrv_net_header_s *) buf_)->codec);
+    assert_int_equal(0, jsdrv_net_decode(buf_, sz, &frame, scratch_, sizeof(scratch_)));
+    assert_memory_equal(&signal_, frame.value.value.bin, v.size);
+
+    // incompressible data falls back to raw
+    for (uint32_t i = 0; i < 10000; ++i) {
+        signal_.data[i] = (uint8_t) (i * 7919U);
+    }
+    sz = jsdrv_net_encode(JSDRV_NET_FRAME_PUBLISH, TOPIC, &v, JSDRV_NET_CODEC_COMPRESS, buf_, sizeof(buf_));
+    assert_int_equal(JSDRV_NET_CODEC_RAW, ((struct jsdrv_net_header_s *) buf_)->codec);
+    assert_int_equal(0, jsdrv_net_decode(buf_, sz, &frame, NULL, 0));
+    assert_ptr_equal(buf_ + sz - v.size, frame.value.value.bin);
+}
+
+static void test_invalid(void **state) {
+    (void) state;
+    struct jsdrv_net_frame_s frame;
+    char topic[JSDRV_TOPIC_LENGTH_MAX + 1];
+    struct jsdrv_union_s v = jsdrv_union_u32(1);
+    assert_int_equal(0, jsdrv_net_encode(JSDRV_NET_FRAME_PUBLISH, "", &v, 0, buf_, sizeof(buf_)));
+    assert_int_equal(0, jsdrv_net_encode(JSDRV_NET_FRAME_PUBLISH, NULL, &v, 0, buf_, sizeof(buf_)));
+    memset(topic, 'a', sizeof(topic) - 1);
+    topic[sizeof(topic) - 1] = 0;
+    assert_int_equal(0, jsdrv_net_encode(JSDRV_NET_FRAME_PUBLISH, topic, &v, 0, buf_, sizeof(buf_)));
+    assert_int_equal(0, jsdrv_net_encode(JSDRV_NET_FRAME_PUBLISH, "a/b", &v, 0, buf_, 20));
+    v.type = JSDRV_UNION_RSV0;
+    assert_int_equal(0, jsdrv_net_encode(JSDRV_NET_FRAME_PUBLISH, "a/b", &v, 0, buf_, sizeof(buf_)));
+
+    v = jsdrv_union_cstr("hello");
+    uint32_t sz = jsdrv_net_encode(JSDRV_NET_FRAME_PUBLISH, "a/b", &v, 0, buf_, sizeof(buf_));
+    struct jsdrv_net_header_s * hdr = (struct jsdrv_net_header_s *) buf_;
+    assert_int_equal(JSDRV_ERROR_TOO_SMALL, jsdrv_net_decode(buf_, 8, &frame, NULL, 0));
+    buf_[sz - 1] = 'x';  // missing string terminator
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_net_decode(buf_, sz, &frame, NULL, 0));
+    buf_[sz - 1] = 0;
+    hdr->size += 1;
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_net_decode(buf_, sz, &frame, NULL, 0));
+    hdr->size -= 1;
+    hdr->topic_size = 6;
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_net_decode(buf_, sz, &frame, NULL, 0));
+    hdr->topic_size = 8;
+    buf_[sizeof(struct jsdrv_net_header_s) + 7] = 'x';  // missing topic terminator
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_net_decode(buf_, sz, &frame, NULL, 0));
+    hdr->length = 4;
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_net_decode(buf_, sz, &frame, NULL, 0));
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_values),
+            cmocka_unit_test(test_stream),
+            cmocka_unit_test(test_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
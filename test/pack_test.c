@@ -0,0 +1,171 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include "jsdrv_prv/pack.h"
+
+
+#define N_MAX (200U)
+
+static uint8_t x_[N_MAX];
+
+static void x_fill(void) {
+    uint32_t lfsr = 0x1234U;
+    for (uint32_t i = 0; i < N_MAX; ++i) {
+        lfsr = (lfsr * 1103515245U) + 12345U;
+        x_[i] = (uint8_t) (lfsr >> 16);  // upper bits must be ignored
+    }
+}
+
+static void test_u4(void **state) {
+    (void) state;
+    uint8_t expect[N_MAX / 2 + 1];
+    uint8_t y[N_MAX / 2 + 2];
+    x_fill();
+    for (uint32_t n = 0; n <= N_MAX; ++n) {
+        memset(expect, 0, sizeof(expect));
+        for (uint32_t i = 0; i < n; ++i) {
+            expect[i >> 1] |= (uint8_t) ((x_[i] & 0x0f) << ((i & 1) * 4));
+        }
+        memset(y, 0xaa, sizeof(y));
+        jsdrv_pack_u4(y, x_, n);
+        assert_memory_equal(expect, y, (n + 1) / 2);
+        assert_int_equal(0xaa, y[(n + 1) / 2]);
+    }
+}
+
+static void test_u1(void **state) {
+    (void) state;
+    uint8_t expect[N_MAX / 8 + 1];
+    uint8_t y[N_MAX / 8 + 2];
+    x_fill();
+    for (uint32_t n = 0; n <= N_MAX; ++n) {
+        memset(expect, 0, sizeof(expect));
+        for (uint32_t i = 0; i < n; ++i) {
+            expect[i >> 3] |= (uint8_t) ((x_[i] & 1) << (i & 7));
+        }
+        memset(y, 0xaa, sizeof(y));
+        jsdrv_pack_u1(y, x_, n);
+        assert_memory_equal(expect, y, (n + 7) / 8);
+        assert_int_equal(0xaa, y[(n + 7) / 8]);
+    }
+}
+
+static void test_unpack_u4(void **state) {
+    (void) state;
+    uint8_t packed[N_MAX / 2 + 1];
+    uint8_t y[N_MAX + 1];
+    x_fill();
+    for (uint32_t n = 0; n <= N_MAX; ++n) {
+        memset(y, 0xaa, sizeof(y));
+        jsdrv_pack_u4(packed, x_, n);
+        jsdrv_unpack_u4(y, packed, n);
+        for (uint32_t i = 0; i < n; ++i) {
+            assert_int_equal(x_[i] & 0x0f, y[i]);
+        }
+        assert_int_equal(0xaa, y[n]);
+    }
+}
+
+static void test_unpack_u1(void **state) {
+    (void) state;
+    uint8_t packed[N_MAX / 8 + 1];
+    uint8_t y[N_MAX + 1];
+    x_fill();
+    for (uint32_t n = 0; n <= N_MAX; ++n) {
+        memset(y, 0xaa, sizeof(y));
+        jsdrv_pack_u1(packed, x_, n);
+        jsdrv_unpack_u1(y, packed, n);
+        for (uint32_t i = 0; i < n; ++i) {
+            assert_int_equal(x_[i] & 1, y[i]);
+        }
+        assert_int_equal(0xaa, y[n]);
+    }
+}
+
+static void sum_check(uint32_t bits, uint64_t offset, uint64_t n) {
+    struct jsdrv_u_sum_s expect;
+    struct jsdrv_u_sum_s actual;
+    jsdrv_u_sum_reset(&expect);
+    for (uint64_t i = offset; i < (offset + n); ++i) {
+        uint8_t v = (4 == bits) ? ((x_[i / 2] >> ((i & 1) * 4)) & 0x0f) : ((x_[i / 8] >> (i & 7)) & 1);
+        expect.x1 += v;
+        expect.x2 += v * v;
+        expect.min = (v < expect.min) ? v : expect.min;
+        expect.max = (v > expect.max) ? v : expect.max;
+    }
+    jsdrv_u_sum_reset(&actual);
+    if (4 == bits) {
+        jsdrv_sum_u4(&actual, x_, offset, n);
+    } else {
+        jsdrv_sum_u1(&actual, x_, offset, n);
+    }
+    assert_int_equal(expect.x1, actual.x1);
+    assert_int_equal(expect.x2, actual.x2);
+    assert_int_equal(expect.min, actual.min);
+    assert_int_equal(expect.max, actual.max);
+}
+
+static void test_sum_u4(void **state) {
+    (void) state;
+    x_fill();
+    for (uint64_t offset = 0; offset < 4; ++offset) {
+        for (uint64_t n = 0; (offset + n) <= (N_MAX * 2); ++n) {
+            sum_check(4, offset, n);
+        }
+    }
+    memset(x_, 0x33, sizeof(x_));
+    sum_check(4, 1, N_MAX * 2 - 1);
+}
+
+static void test_sum_u1(void **state) {
+    (void) state;
+    x_fill();
+    for (uint64_t offset = 0; offset < 9; ++offset) {
+        for (uint64_t n = 0; (offset + n) <= (N_MAX * 8); n += 3) {
+            sum_check(1, offset, n);
+        }
+    }
+    memset(x_, 0xff, sizeof(x_));
+    sum_check(1, 3, N_MAX * 8 - 5);
+    memset(x_, 0, sizeof(x_));
+    sum_check(1, 3, N_MAX * 8 - 5);
+}
+
+static void test_impl(void **state) {
+    (void) state;
+    const char * impl = jsdrv_pack_impl();
+    assert_non_null(impl);
+    assert_true(strlen(impl) > 0);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_u4),
+            cmocka_unit_test(test_u1),
+            cmocka_unit_test(test_unpack_u4),
+            cmocka_unit_test(test_unpack_u1),
+            cmocka_unit_test(test_sum_u4),
+            cmocka_unit_test(test_sum_u1),
+            cmocka_unit_test(test_impl),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
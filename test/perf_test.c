@@ -0,0 +1,90 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/perf.h"
+#include "jsdrv/time.h"
+#include <string.h>
+
+
+static int setup(void ** state) {
+    (void) state;
+    jsdrv_perf_reset();
+    return 0;
+}
+
+static void test_names(void **state) {
+    (void) state;
+    assert_string_equal("xfer", jsdrv_perf_name(JSDRV_PERF_USB_XFER));
+    assert_string_equal("loan/7", jsdrv_perf_name(JSDRV_PERF_LOAN_7));
+    assert_null(jsdrv_perf_name(JSDRV_PERF_COUNT));
+    for (uint32_t i = 0; i < JSDRV_PERF_COUNT; ++i) {
+        const char * name = jsdrv_perf_name(i);
+        assert_non_null(name);
+        const char * slash = strchr(name, '/');
+        assert_true(((slash) ? (size_t) (slash - name) : strlen(name)) <= 7);
+    }
+}
+
+static void test_add_max(void **state) {
+    (void) state;
+    jsdrv_perf_add(JSDRV_PERF_USB_RX, 512);
+    jsdrv_perf_add(JSDRV_PERF_USB_RX, 512);
+    assert_int_equal(1024, jsdrv_perf_get(JSDRV_PERF_USB_RX));
+    jsdrv_perf_max(JSDRV_PERF_BACKEND_MAX, 5);
+    jsdrv_perf_max(JSDRV_PERF_BACKEND_MAX, 3);
+    assert_int_equal(5, jsdrv_perf_get(JSDRV_PERF_BACKEND_MAX));
+    jsdrv_perf_max(JSDRV_PERF_BACKEND_MAX, 9);
+    assert_int_equal(9, jsdrv_perf_get(JSDRV_PERF_BACKEND_MAX));
+    assert_int_equal(0, jsdrv_perf_get(JSDRV_PERF_COUNT));
+    jsdrv_perf_reset();
+    assert_int_equal(0, jsdrv_perf_get(JSDRV_PERF_USB_RX));
+}
+
+static void test_time_in_us(void **state) {
+    (void) state;
+    jsdrv_perf_add(JSDRV_PERF_PUBSUB_TIME, JSDRV_TIME_MILLISECOND * 3);
+    assert_int_equal(3000, jsdrv_perf_get(JSDRV_PERF_PUBSUB_TIME));
+}
+
+static void test_loan_histogram(void **state) {
+    (void) state;
+    jsdrv_perf_loan(0);
+    jsdrv_perf_loan(JSDRV_TIME_MICROSECOND * 15);
+    jsdrv_perf_loan(JSDRV_TIME_MICROSECOND * 17);
+    jsdrv_perf_loan(JSDRV_TIME_MILLISECOND * 2);
+    jsdrv_perf_loan(JSDRV_TIME_SECOND);
+    assert_int_equal(2, jsdrv_perf_get(JSDRV_PERF_LOAN_0));
+    assert_int_equal(1, jsdrv_perf_get(JSDRV_PERF_LOAN_1));
+    assert_int_equal(0, jsdrv_perf_get(JSDRV_PERF_LOAN_2));
+    assert_int_equal(0, jsdrv_perf_get(JSDRV_PERF_LOAN_3));
+    assert_int_equal(1, jsdrv_perf_get(JSDRV_PERF_LOAN_4));
+    assert_int_equal(1, jsdrv_perf_get(JSDRV_PERF_LOAN_7));
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test_setup(test_names, setup),
+            cmocka_unit_test_setup(test_add_max, setup),
+            cmocka_unit_test_setup(test_time_in_us, setup),
+            cmocka_unit_test_setup(test_loan_histogram, setup),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/power_align.h"
+#include <math.h>
+#include <string.h>
+
+
+#define OUT_MAX (8192U)
+#define I JSDRV_POWER_ALIGN_CURRENT
+#define V JSDRV_POWER_ALIGN_VOLTAGE
+
+static uint64_t sample_id_next_;
+static uint64_t sample_id_first_;
+static uint32_t count_;
+static uint32_t calls_;
+static float i_[OUT_MAX];
+static float v_[OUT_MAX];
+static float p_[OUT_MAX];
+
+static void on_power(void * user_data, uint64_t sample_id, const float * i, const float * v, float * p, uint32_t count) {
+    (void) user_data;
+    ((uint32_t *) p)[-1] = 0xdeadbeef;  // scratch
+    if (0 == count_) {
+        sample_id_first_ = sample_id;
+    } else {
+        assert_int_equal(sample_id_next_, sample_id);
+    }
+    assert_true((count_ + count) <= OUT_MAX);
+    memcpy(i_ + count_, i, count * sizeof(float));
+    memcpy(v_ + count_, v, count * sizeof(float));
+    memcpy(p_ + count_, p, count * sizeof(float));
+    count_ += count;
+    sample_id_next_ = sample_id + 2ULL * count;
+    ++calls_;
+}
+
+static int setup(void ** state) {
+    (void) state;
+    count_ = 0;
+    calls_ = 0;
+    return 0;
+}
+
+static void add(struct jsdrv_power_align_s * a, uint8_t channel, uint64_t sample_id, float value_start, uint32_t count) {
+    float x[4096];
+    assert_true(count <= 4096);
+    for (uint32_t k = 0; k < count; ++k) {
+        x[k] = value_start + (float) k;
+    }
+    jsdrv_power_align_add(a, channel, sample_id, 2, x, count);
+}
+
+static void test_alloc(void ** state) {
+    (void) state;
+    struct jsdrv_power_align_s * a = jsdrv_power_align_alloc(0, on_power, NULL);
+    assert_int_equal(JSDRV_POWER_ALIGN_WINDOW_MIN, jsdrv_power_align_window(a));
+    jsdrv_power_align_free(a);
+    a = jsdrv_power_align_alloc(5000, on_power, NULL);
+    assert_int_equal(8192, jsdrv_power_align_window(a));
+    jsdrv_power_align_free(a);
+    a = jsdrv_power_align_alloc(UINT32_MAX, on_power, NULL);
+    assert_int_equal(JSDRV_POWER_ALIGN_WINDOW_MAX, jsdrv_power_align_window(a));
+    jsdrv_power_align_free(a);
+    jsdrv_power_align_free(NULL);
+}
+
+static void test_current_then_voltage(void ** state) {
+    (void) state;
+    struct jsdrv_power_align_s * a = jsdrv_power_align_alloc(1024, on_power, NULL);
+    add(a, I, 1000, 0.0f, 100);
+    assert_int_equal(0, count_);
+    add(a, V, 1000, 10.0f, 60);
+    assert_int_equal(60, count_);
+    assert_int_equal(1000, sample_id_first_);
+    add(a, V, 1120, 70.0f, 100);          // voltage now leads
+    assert_int_equal(100, count_);
+    add(a, I, 1200, 100.0f, 50);
+    assert_int_equal(150, count_);
+    for (uint32_t k = 0; k < count_; ++k) {
+        assert_true(((float) k) == i_[k]);
+        assert_true((10.0f + k) == v_[k]);
+        assert_true((((float) k) * (10.0f + k)) == p_[k]);
+    }
+    assert_int_equal(0, jsdrv_power_align_overrun(a));
+    jsdrv_power_align_free(a);
+}
+
+static void test_wrap(void ** state) {
+    (void) state;
+    struct jsdrv_power_align_s * a = jsdrv_power_align_alloc(1024, on_power, NULL);
+    uint64_t sample_id = 0;
+    for (uint32_t k = 0; k < 8; ++k) {
+        add(a, V, sample_id, 0.0f, 700);
+        add(a, I, sample_id, 1.0f, 700);
+        sample_id += 1400;
+    }
+    assert_int_equal(5600, count_);
+    assert_true(calls_ > 8);              // ring wrapped
+    assert_true(700.0f == i_[699]);
+    assert_true(699.0f == v_[699]);
+    assert_true((700.0f * 699.0f) == p_[699]);
+    assert_true(1.0f == i_[700]);
+    assert_int_equal(0, jsdrv_power_align_overrun(a));
+    jsdrv_power_align_free(a);
+}
+
+static void test_overrun(void ** state) {
+    (void) state;
+    struct jsdrv_power_align_s * a = jsdrv_power_align_alloc(1024, on_power, NULL);
+    add(a, I, 0, 0.0f, 1000);
+    add(a, I, 2000, 1000.0f, 1000);       // discards the oldest 976
+    assert_int_equal(976, jsdrv_power_align_overrun(a));
+    add(a, V, 0, 0.0f, 2000);
+    assert_int_equal(1024, count_);
+    assert_int_equal(976 * 2, sample_id_first_);
+    assert_true(976.0f == i_[0]);
+    assert_true(976.0f == v_[0]);
+
+    add(a, I, 4000, 0.0f, 4000);          // larger than the window
+    assert_int_equal(976 + 4000 - 1024, jsdrv_power_align_overrun(a));
+    jsdrv_power_align_free(a);
+}
+
+static void test_skips(void ** state) {
+    (void) state;
+    struct jsdrv_power_align_s * a = jsdrv_power_align_alloc(1024, on_power, NULL);
+    add(a, I, 0, 0.0f, 100);
+    add(a, I, 400, 200.0f, 100);          // current skips 100, fill NaN
+    add(a, V, 0, 0.0f, 300);
+    assert_int_equal(300, count_);
+    assert_true(99.0f == i_[99]);
+    assert_true(isnan(i_[100]));
+    assert_true(isnan(p_[199]));
+    assert_true(200.0f == i_[200]);
+
+    setup(NULL);
+    add(a, I, 600, 300.0f, 100);          // voltage skips 50, discard current
+    add(a, V, 700, 350.0f, 50);
+    assert_int_equal(50, count_);
+    assert_int_equal(700, sample_id_first_);
+    assert_true(350.0f == i_[0]);
+
+    setup(NULL);
+    add(a, I, 2000, 0.0f, 10);            // voltage skips all retained current
+    add(a, V, 3000, 0.0f, 10);
+    assert_int_equal(0, count_);
+    add(a, I, 2990, 0.0f, 20);            // older current without voltage
+    assert_int_equal(10, count_);
+    assert_int_equal(3000, sample_id_first_);
+
+    setup(NULL);
+    add(a, V, 3100, 0.0f, 10);
+    jsdrv_power_align_add(a, I, 3100, 4, i_, 10);  // decimate change clears
+    assert_int_equal(0, count_);
+    jsdrv_power_align_free(a);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test_setup(test_alloc, setup),
+            cmocka_unit_test_setup(test_current_then_voltage, setup),
+            cmocka_unit_test_setup(test_wrap, setup),
+            cmocka_unit_test_setup(test_overrun, setup),
+            cmocka_unit_test_setup(test_skips, setup),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/proc.h"
+#include "jsdrv/error_code.h"
+#include <math.h>
+#include <string.h>
+
+#define FS (1000000.0f)
+
+
+static struct jsdrv_proc_s procs_[JSDRV_PROC_SIGNAL_COUNT];
+
+static struct jsdrv_proc_s * procs_init(void) {
+    for (uint32_t i = 0; i < JSDRV_PROC_SIGNAL_COUNT; ++i) {
+        jsdrv_proc_initialize(&procs_[i]);
+    }
+    return procs_;
+}
+
+static void test_param(void **state) {
+    (void) state;
+    struct jsdrv_proc_s * p = procs_init();
+    assert_false(p[0].active);
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/v/2/type", &jsdrv_union_u8(JSDRV_PROC_TYPE_DECIMATE)));
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/v/2/n", &jsdrv_union_u32(10)));
+    assert_true(p[JSDRV_PROC_SIGNAL_VOLTAGE].active);
+    assert_int_equal(10, p[JSDRV_PROC_SIGNAL_VOLTAGE].decimate_factor);
+    assert_false(p[JSDRV_PROC_SIGNAL_CURRENT].active);
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/p/0/a", &jsdrv_union_f32(2.5f)));
+    assert_true(2.5f == p[JSDRV_PROC_SIGNAL_POWER].stages[0].a);
+
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_proc_param(p, "h/proc/x/0/type", &jsdrv_union_u8(1)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_proc_param(p, "h/proc/i/4/type", &jsdrv_union_u8(1)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_proc_param(p, "h/proc/i/0/type", &jsdrv_union_u8(6)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_proc_param(p, "h/proc/i/0/n", &jsdrv_union_u32(0)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_proc_param(p, "h/proc/i/0/a", &jsdrv_union_f32(NAN)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_proc_param(p, "h/proc/i/0/other", &jsdrv_union_u8(0)));
+
+    // combined reduction limit reverts the change
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/v/2/n", &jsdrv_union_u32(1000)));
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/v/3/n", &jsdrv_union_u32(10000)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_proc_param(p, "h/proc/v/3/type", &jsdrv_union_u8(JSDRV_PROC_TYPE_RMS)));
+    assert_int_equal(JSDRV_PROC_TYPE_OFF, p[JSDRV_PROC_SIGNAL_VOLTAGE].stages[3].type);
+    assert_int_equal(1000, p[JSDRV_PROC_SIGNAL_VOLTAGE].decimate_factor);
+    assert_non_null(jsdrv_proc_field_name(JSDRV_PROC_FIELD_N));
+    assert_null(jsdrv_proc_field_name(JSDRV_PROC_FIELD_COUNT));
+}
+
+static void test_scale_decimate(void **state) {
+    (void) state;
+    struct jsdrv_proc_s * p = procs_init();
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/i/0/type", &jsdrv_union_u8(JSDRV_PROC_TYPE_SCALE)));
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/i/0/a", &jsdrv_union_f32(2.0f)));
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/i/0/b", &jsdrv_union_f32(1.0f)));
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/i/1/type", &jsdrv_union_u8(JSDRV_PROC_TYPE_DECIMATE)));
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/i/1/n", &jsdrv_union_u32(4)));
+    float x[10];
+    for (uint32_t i = 0; i < 10; ++i) {
+        x[i] = (float) i;
+    }
+    assert_int_equal(2, jsdrv_proc_process(p, FS, x, 10));
+    assert_float_equal(4.0f, x[0], 1e-6f);   // mean(2 * [0, 1, 2, 3] + 1)
+    assert_float_equal(12.0f, x[1], 1e-6f);
+    assert_int_equal(2, p->phase);
+
+    // window spans the calls
+    x[0] = 8.0f;
+    x[1] = 9.0f;
+    assert_int_equal(1, jsdrv_proc_process(p, FS, x, 2));
+    assert_float_equal(18.0f, x[0], 1e-6f);
+    assert_int_equal(0, p->phase);
+}
+
+static void test_rms(void **state) {
+    (void) state;
+    struct jsdrv_proc_s * p = procs_init();
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/i/0/type", &jsdrv_union_u8(JSDRV_PROC_TYPE_RMS)));
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/i/0/n", &jsdrv_union_u32(4)));
+    float x[] = {1.0f, -1.0f, 1.0f, -1.0f, 3.0f, 0.0f, 0.0f, -4.0f};
+    assert_int_equal(2, jsdrv_proc_process(p, FS, x, 8));
+    assert_float_equal(1.0f, x[0], 1e-6f);
+    assert_float_equal(2.5f, x[1], 1e-6f);
+}
+
+static void test_lowpass(void **state) {
+    (void) state;
+    struct jsdrv_proc_s * p = procs_init();
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/i/0/type", &jsdrv_union_u8(JSDRV_PROC_TYPE_LOWPASS)));
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/i/0/a", &jsdrv_union_f32(1000.0f)));
+    float x[4000];
+    x[0] = 0.0f;
+    for (uint32_t i = 1; i < 4000; ++i) {
+        x[i] = 1.0f;
+    }
+    assert_int_equal(4000, jsdrv_proc_process(p, FS, x, 4000));
+    assert_true(x[0] == 0.0f);
+    float tau = FS / (2.0f * 3.14159265f * 1000.0f);  // 159 samples
+    assert_float_equal(1.0f - expf(-1.0f), x[(uint32_t) tau], 0.01f);  // one time constant
+    assert_float_equal(1.0f, x[3999], 1e-4f);
+
+    x[0] = NAN;
+    x[1] = 5.0f;
+    x[2] = 5.0f;
+    jsdrv_proc_process(p, FS, x, 3);
+    assert_true(isnan(x[0]));
+    assert_true(5.0f == x[1]);  // restart after the gap
+    assert_true(5.0f == x[2]);
+}
+
+static void test_threshold(void **state) {
+    (void) state;
+    struct jsdrv_proc_s * p = procs_init();
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/i/0/type", &jsdrv_union_u8(JSDRV_PROC_TYPE_THRESHOLD)));
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/i/0/a", &jsdrv_union_f32(0.5f)));
+    assert_int_equal(0, jsdrv_proc_param(p, "h/proc/i/0/b", &jsdrv_union_f32(0.1f)));
+    float x[] = {0.45f, 0.6f, 0.45f, 0.3f, NAN, 0.45f};
+    float expect[] = {0.0f, 1.0f, 1.0f, 0.0f, NAN, 0.0f};
+    assert_int_equal(6, jsdrv_proc_process(p, FS, x, 6));
+    for (uint32_t i = 0; i < 6; ++i) {
+        if (isnan(expect[i])) {
+            assert_true(isnan(x[i]));
+        } else {
+            assert_true(expect[i] == x[i]);
+        }
+    }
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_param),
+            cmocka_unit_test(test_scale_decimate),
+            cmocka_unit_test(test_rms),
+            cmocka_unit_test(test_lowpass),
+            cmocka_unit_test(test_threshold),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
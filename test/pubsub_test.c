@@ -25,6 +25,7 @@
 #include "jsdrv_prv/frontend.h"
 #include "jsdrv_prv/backend.h"
 #include "jsdrv/cstr.h"
+#include "jsdrv/error_code.h"
 #include <stdarg.h>
 #include <stdio.h>
 
@@ -70,6 +71,7 @@ static uint8_t on_subscribe_internal(void * user_data, struct jsdrvp_msg_s * msg
         case JSDRV_UNION_JSON: check_expected_ptr_value(msg->value.value.str); break;
         case JSDRV_UNION_U32: check_expected_value(msg->value.value.u32); break;
         case JSDRV_UNION_I32: check_expected_value(msg->value.value.i32); break;
+        case JSDRV_UNION_BIN: check_expected_value(msg->value.size); break;
         default:
             assert_true(false);
     }
@@ -85,6 +87,7 @@ static uint8_t on_subscribe_internal(void * user_data, struct jsdrvp_msg_s * msg
         case JSDRV_UNION_JSON: expect_string(on_subscribe_internal, value, value_->value.str); break; \
         case JSDRV_UNION_U32:  expect_value(on_subscribe_internal, value, value_->value.u32); break;  \
         case JSDRV_UNION_I32:  expect_value(on_subscribe_internal, value, value_->value.i32); break;  \
+        case JSDRV_UNION_BIN:  expect_value(on_subscribe_internal, value, value_->size); break;      \
         default: assert_true(false); break;                                                         \
     }                                                                                               \
 }
@@ -121,9 +124,14 @@ struct jsdrvp_msg_s * jsdrvp_msg_alloc(struct jsdrv_context_s * context) {
     (void) context;
     struct jsdrvp_msg_s * m = jsdrv_alloc_clr(sizeof(struct jsdrvp_msg_s));
     jsdrv_list_initialize(&m->item);
+    m->refcnt = 1;
     return m;
 }
 
+struct jsdrvp_msg_s * jsdrvp_msg_alloc_small(struct jsdrv_context_s * context) {
+    return jsdrvp_msg_alloc(context);
+}
+
 struct jsdrvp_msg_s * jsdrvp_msg_alloc_value(struct jsdrv_context_s * context, const char * topic, const struct jsdrv_union_s * value) {
     struct jsdrvp_msg_s *m = jsdrvp_msg_alloc(context);
     jsdrv_cstr_copy(m->topic, topic, sizeof(m->topic));
@@ -131,9 +139,14 @@ struct jsdrvp_msg_s * jsdrvp_msg_alloc_value(struct jsdrv_context_s * context, c
     return m;
 }
 
+struct jsdrvp_msg_s * jsdrvp_msg_retain(struct jsdrvp_msg_s * msg) {
+    ++msg->refcnt;
+    return msg;
+}
+
 void jsdrvp_msg_free(struct jsdrv_context_s * context, struct jsdrvp_msg_s * msg) {
     (void) context;
-    if (msg) {
+    if (msg && (0 == --msg->refcnt)) {
         jsdrv_free(msg);
     }
 }
@@ -241,6 +254,31 @@ static void test_publish_subscribe_retain(void ** state) {
     TEARDOWN();
 }
 
+static void test_publish_subscribe_retain_copy(void ** state) {
+    SETUP();
+    char short_str[16] = "short";
+    char long_str[128];
+    char long_expect[128];
+    memset(long_str, 'x', sizeof(long_str) - 1);
+    long_str[sizeof(long_str) - 1] = 0;
+    memcpy(long_expect, long_str, sizeof(long_str));
+    publish(p, "u/js110/123456/a", &jsdrv_union_cstr_r(short_str));
+    publish(p, "u/js110/123456/b", &jsdrv_union_cstr_r(long_str));
+    jsdrv_pubsub_process(p);
+    short_str[0] = 'S';  // topics retain a copy
+    long_str[0] = 'X';
+
+    struct jsdrvp_msg_s * m = subscribe_msg(p, "u/js110", JSDRV_SFLAG_PUB | JSDRV_SFLAG_RETAIN, JSDRV_PUBSUB_SUBSCRIBE);
+    jsdrv_pubsub_publish(p, m);
+    expect_publish_internal("u/js110/123456/a", &jsdrv_union_str("short"));
+    expect_publish_internal("u/js110/123456/b", &jsdrv_union_str(long_expect));
+    jsdrv_pubsub_process(p);
+
+    publish(p, "u/js110/123456/b", &jsdrv_union_cstr_r(long_expect));  // de-duplicated
+    jsdrv_pubsub_process(p);
+    TEARDOWN();
+}
+
 static void test_subscribe_publish_nopub(void ** state) {
     SETUP();
     struct jsdrvp_msg_s * m = subscribe_msg(p, "", 0, JSDRV_PUBSUB_SUBSCRIBE);
@@ -270,6 +308,117 @@ static void test_unsubscribe_all(void ** state) {
     TEARDOWN();
 }
 
+static uint8_t on_count(void * user_data, struct jsdrvp_msg_s * msg) {
+    (void) msg;
+    ++*((uint32_t *) user_data);
+    return 0;
+}
+
+static void subscribe_count(struct jsdrv_pubsub_s * p, const char * topic, uint32_t * count, const char * op) {
+    struct jsdrvp_msg_s * m = subscribe_msg(p, topic, JSDRV_SFLAG_PUB, op);
+    m->payload.sub.subscriber.internal_fn = on_count;
+    m->payload.sub.subscriber.user_data = count;
+    jsdrv_pubsub_publish(p, m);
+}
+
+static void test_unsubscribe_all_many(void ** state) {
+    SETUP();
+    static const char * topics[] = {"u/js220/1/a", "u/js220/1/b", "u/js220/2/c", "u/+/+/d"};
+    uint32_t counts[200];
+    memset(counts, 0, sizeof(counts));
+    for (uint32_t k = 0; k < 200; ++k) {  // grow the subscriber index
+        for (uint32_t j = 0; j < 4; ++j) {
+            subscribe_count(p, topics[j], &counts[k], JSDRV_PUBSUB_SUBSCRIBE);
+        }
+    }
+    for (uint32_t k = 0; k < 200; k += 2) {
+        subscribe_count(p, "", &counts[k], JSDRV_PUBSUB_UNSUBSCRIBE_ALL);
+    }
+    jsdrv_pubsub_process(p);
+    publish_str(p, "u/js220/1/a", "1");
+    publish_str(p, "u/js220/1/b", "2");
+    publish_str(p, "u/js220/2/c", "3");
+    publish_str(p, "u/js220/2/d", "4");
+    jsdrv_pubsub_process(p);
+    for (uint32_t k = 0; k < 200; ++k) {
+        assert_int_equal((k & 1) ? 4 : 0, counts[k]);
+    }
+
+    subscribe_count(p, topics[0], &counts[0], JSDRV_PUBSUB_SUBSCRIBE);
+    subscribe_count(p, "", &counts[1], JSDRV_PUBSUB_UNSUBSCRIBE_ALL);
+    jsdrv_pubsub_process(p);
+    publish_str(p, "u/js220/1/a", "5");
+    jsdrv_pubsub_process(p);
+    assert_int_equal(1, counts[0]);
+    assert_int_equal(4, counts[1]);
+    assert_int_equal(5, counts[3]);
+    TEARDOWN();
+}
+
+static uint32_t batch_calls_;
+static uint32_t batch_count_;
+static char batch_last_[JSDRV_TOPIC_LENGTH_MAX];
+
+static void on_batch(void * user_data, const struct jsdrv_subscribe_msg_s * msgs, uint32_t count) {
+    (void) user_data;
+    assert_true((count > 0) && (count <= JSDRV_SUBSCRIBE_BATCH_SIZE_MAX));
+    for (uint32_t i = 0; i < count; ++i) {
+        assert_int_equal(JSDRV_UNION_STR, msgs[i].value->type);
+    }
+    jsdrv_cstr_join(batch_last_, msgs[count - 1].topic, msgs[count - 1].value->value.str, sizeof(batch_last_));
+    ++batch_calls_;
+    batch_count_ += count;
+}
+
+static void subscribe_batch(struct jsdrv_pubsub_s * p, const char * topic, uint8_t flags, const char * op) {
+    struct jsdrvp_msg_s * m = subscribe_msg(p, topic, flags, op);
+    m->payload.sub.subscriber.is_internal = 0;
+    m->payload.sub.subscriber.is_batch = 1;
+    m->payload.sub.subscriber.batch_fn = on_batch;
+    m->source = 1;
+    jsdrv_pubsub_publish(p, m);
+}
+
+static void test_batch(void ** state) {
+    SETUP();
+    char value[8];
+    batch_calls_ = 0;
+    batch_count_ = 0;
+    subscribe_batch(p, "u/js220/1", JSDRV_SFLAG_PUB, JSDRV_PUBSUB_SUBSCRIBE);
+    jsdrv_pubsub_process(p);
+    publish_str(p, "u/js220/1/a", "1");
+    publish_str(p, "u/js220/1/b", "2");
+    publish_str(p, "u/js220/2/a", "x");
+    publish_str(p, "u/js220/1/c", "3");
+    jsdrv_pubsub_process(p);
+    assert_int_equal(1, batch_calls_);
+    assert_int_equal(3, batch_count_);
+    assert_string_equal("u/js220/1/c3", batch_last_);
+
+    for (uint32_t k = 0; k < 70; ++k) {  // exceeds JSDRV_SUBSCRIBE_BATCH_SIZE_MAX
+        snprintf(value, sizeof(value), "%u", k);
+        publish_str(p, "u/js220/1/a", value);
+    }
+    jsdrv_pubsub_process(p);
+    assert_int_equal(3, batch_calls_);
+    assert_int_equal(73, batch_count_);
+    assert_string_equal("u/js220/1/a69", batch_last_);
+
+    publish(p, "u/js220/3/r", &jsdrv_union_cstr_r("r"));  // retained
+    subscribe_batch(p, "u/js220/3", JSDRV_SFLAG_PUB | JSDRV_SFLAG_RETAIN, JSDRV_PUBSUB_SUBSCRIBE);
+    jsdrv_pubsub_process(p);
+    assert_int_equal(4, batch_calls_);
+    assert_string_equal("u/js220/3/rr", batch_last_);
+
+    publish_str(p, "u/js220/1/a", "4");
+    subscribe_batch(p, "", 0, JSDRV_PUBSUB_UNSUBSCRIBE_ALL);  // delivers pending first
+    publish_str(p, "u/js220/1/a", "5");
+    jsdrv_pubsub_process(p);
+    assert_int_equal(5, batch_calls_);
+    assert_string_equal("u/js220/1/a4", batch_last_);
+    TEARDOWN();
+}
+
 static void test_external_subscribe_publish_unsubscribe(void ** state) {
     SETUP();
     subscribe_external(p, "u/js110/123456/hello", JSDRV_SFLAG_PUB);
@@ -307,6 +456,141 @@ static void test_external_retain(void ** state) {
     TEARDOWN();
 }
 
+static void test_many_topics(void ** state) {
+    SETUP();
+    char topic[JSDRV_TOPIC_LENGTH_MAX];
+    for (uint32_t i = 0; i < 1000; ++i) {  // forces topic map growth
+        snprintf(topic, sizeof(topic), "u/js220/%06u/s/i/!data", (unsigned int) i);
+        subscribe_internal(p, topic, JSDRV_SFLAG_PUB);
+    }
+    jsdrv_pubsub_process(p);
+    for (uint32_t i = 0; i < 1000; i += 111) {
+        snprintf(topic, sizeof(topic), "u/js220/%06u/s/i/!data", (unsigned int) i);
+        publish(p, topic, &jsdrv_union_u32(i));
+        expect_publish_internal(topic, &jsdrv_union_u32(i));
+        jsdrv_pubsub_process(p);
+    }
+    TEARDOWN();
+}
+
+static void test_topic_hash(void ** state) {
+    SETUP();
+    const char * topic = "u/js220/123456/s/i/!data";
+    assert_int_equal(jsdrv_pubsub_topic_hash(topic), jsdrv_pubsub_topic_hash(topic));
+    assert_int_not_equal(0, jsdrv_pubsub_topic_hash(""));
+    assert_int_not_equal(jsdrv_pubsub_topic_hash(topic), jsdrv_pubsub_topic_hash("u/js220/123456/s/v/!data"));
+    subscribe_internal(p, topic, JSDRV_SFLAG_PUB);
+    jsdrv_pubsub_process(p);
+
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(NULL, topic, &jsdrv_union_u32(1));
+    m->topic_hash = jsdrv_pubsub_topic_hash(topic);
+    jsdrv_pubsub_publish(p, m);
+    expect_publish_internal(topic, &jsdrv_union_u32(1));
+    jsdrv_pubsub_process(p);
+
+    m = jsdrvp_msg_alloc_value(NULL, topic, &jsdrv_union_u32(2));
+    m->topic_hash = 12345;  // stale hint must still resolve
+    jsdrv_pubsub_publish(p, m);
+    expect_publish_internal(topic, &jsdrv_union_u32(2));
+    jsdrv_pubsub_process(p);
+    TEARDOWN();
+}
+
+static void test_wildcard(void ** state) {
+    SETUP();
+    const char * wildcard = "u/+/+/s/+/ctrl";
+    jsdrv_pubsub_publish(p, jsdrvp_msg_alloc_value(NULL, "u/js220/1/s/i/ctrl", &jsdrv_union_u32_r(1)));
+    jsdrv_pubsub_process(p);
+    subscribe_internal(p, wildcard, JSDRV_SFLAG_PUB | JSDRV_SFLAG_RETAIN);
+    expect_publish_internal("u/js220/1/s/i/ctrl", &jsdrv_union_u32_r(1));
+    jsdrv_pubsub_process(p);
+
+    jsdrv_pubsub_publish(p, jsdrvp_msg_alloc_value(NULL, "u/js110/2/s/v/ctrl", &jsdrv_union_u32(2)));
+    expect_publish_internal("u/js110/2/s/v/ctrl", &jsdrv_union_u32(2));
+    jsdrv_pubsub_process(p);
+    jsdrv_pubsub_publish(p, jsdrvp_msg_alloc_value(NULL, "u/js220/1/s/i/range/ctrl", &jsdrv_union_u32(3)));
+    jsdrv_pubsub_publish(p, jsdrvp_msg_alloc_value(NULL, "u/js220/1/h/fs", &jsdrv_union_u32(4)));
+    jsdrv_pubsub_process(p);  // no match
+
+    subscribe_internal(p, "u/+/1/s/i/!data", JSDRV_SFLAG_PUB);
+    jsdrv_pubsub_process(p);
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc_value(NULL, "u/js220/1/s/i/!data", &jsdrv_union_bin(NULL, 16));
+    m->value.value.bin = m->payload.bin;
+    m->value.app = JSDRV_PAYLOAD_TYPE_STREAM;
+    jsdrv_pubsub_publish(p, m);
+    expect_publish_internal("u/js220/1/s/i/!data", &jsdrv_union_bin(NULL, 16));
+    jsdrv_pubsub_process(p);
+
+    unsubscribe_internal(p, wildcard);
+    jsdrv_pubsub_publish(p, jsdrvp_msg_alloc_value(NULL, "u/js110/2/s/v/ctrl", &jsdrv_union_u32(5)));
+    jsdrv_pubsub_process(p);
+    unsubscribe_all_internal(p, "");
+    m = jsdrvp_msg_alloc_value(NULL, "u/js220/1/s/i/!data", &jsdrv_union_bin(NULL, 16));
+    m->value.value.bin = m->payload.bin;
+    m->value.app = JSDRV_PAYLOAD_TYPE_STREAM;
+    jsdrv_pubsub_publish(p, m);
+    jsdrv_pubsub_process(p);
+    TEARDOWN();
+}
+
+static void test_shard_hash(void ** state) {
+    (void) state;
+    uint32_t shard = jsdrv_pubsub_shard_hash("u/js220/123456");
+    assert_int_equal(shard, jsdrv_pubsub_shard_hash("u/js220/123456/s/i/!data"));
+    assert_int_equal(shard, jsdrv_pubsub_shard_hash("u/js220/123456/s/stats/value"));
+    assert_int_not_equal(shard, jsdrv_pubsub_shard_hash("u/js220/123457/s/i/!data"));
+    assert_int_equal(jsdrv_pubsub_topic_hash("u/js220"), jsdrv_pubsub_shard_hash("u/js220"));
+    assert_int_not_equal(0, jsdrv_pubsub_shard_hash(""));
+}
+
+static void publish_data(struct jsdrv_pubsub_s * p, const char * topic, uint8_t app, uint32_t size, bool retain) {
+    struct jsdrvp_msg_s * m = jsdrvp_msg_alloc(NULL);
+    jsdrv_cstr_copy(m->topic, topic, sizeof(m->topic));
+    m->value = retain ? jsdrv_union_cbin_r(m->payload.bin, size) : jsdrv_union_bin(m->payload.bin, size);
+    m->value.app = app;
+    jsdrv_pubsub_publish(p, m);
+}
+
+static void test_data_publish(void ** state) {
+    SETUP();
+    const char * topic = "u/js220/123456/s/i/!data";
+    struct jsdrv_union_s v = jsdrv_union_bin(NULL, 100);
+    subscribe_internal(p, topic, JSDRV_SFLAG_PUB);
+    subscribe_internal(p, "u/js220/123456", JSDRV_SFLAG_PUB);
+    subscribe_internal(p, "u/js220", JSDRV_SFLAG_RETURN_CODE);  // not a data subscriber
+    jsdrv_pubsub_process(p);
+    publish_data(p, topic, JSDRV_PAYLOAD_TYPE_STREAM, 100, false);
+    expect_publish_internal(topic, &v);
+    expect_publish_internal(topic, &v);
+    jsdrv_pubsub_process(p);
+
+    unsubscribe_internal(p, topic);  // invalidates subscriber vector
+    publish_data(p, topic, JSDRV_PAYLOAD_TYPE_STREAM, 100, false);
+    expect_publish_internal(topic, &v);
+    jsdrv_pubsub_process(p);
+    TEARDOWN();
+}
+
+static void test_data_statistics_retain(void ** state) {
+    SETUP();
+    const char * topic = "u/js220/123456/s/stats/value";
+    struct jsdrv_union_s v = jsdrv_union_bin(NULL, 64);
+    subscribe_internal(p, topic, JSDRV_SFLAG_PUB);
+    jsdrv_pubsub_process(p);
+    // identical values are not de-duplicated
+    publish_data(p, topic, JSDRV_PAYLOAD_TYPE_STATISTICS, 64, true);
+    publish_data(p, topic, JSDRV_PAYLOAD_TYPE_STATISTICS, 64, true);
+    expect_publish_internal(topic, &v);
+    expect_publish_internal(topic, &v);
+    jsdrv_pubsub_process(p);
+
+    // but the latest value is still retained
+    subscribe_internal(p, "u/js220/123456/s", JSDRV_SFLAG_PUB | JSDRV_SFLAG_RETAIN);
+    expect_publish_internal(topic, &v);
+    jsdrv_pubsub_process(p);
+    TEARDOWN();
+}
+
 static void test_return_code(void ** state) {
     SETUP();
     subscribe_internal(p, "u/js110/123456/hello", JSDRV_SFLAG_RETURN_CODE);
@@ -334,6 +618,49 @@ static void test_meta(void ** state) {
     TEARDOWN();
 }
 
+static void test_meta_direct(void ** state) {
+    SETUP();
+    struct jsdrv_union_s v;
+    publish(p, "u/hello$", &jsdrv_union_json(META1));  // bool converts values
+    publish(p, "u/world$", &jsdrv_union_json(META2));
+    publish(p, "u/world", &jsdrv_union_u32_r(3));
+    jsdrv_pubsub_process(p);
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_pubsub_query_direct(p, "u/hello", &v));
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_pubsub_query_direct(p, "u/other", &v));
+    assert_int_equal(0, jsdrv_pubsub_query_direct(p, "u/world", &v));
+    assert_int_equal(3, v.value.u32);
+    publish(p, "u/world$", &jsdrv_union_json(META1));
+    jsdrv_pubsub_process(p);
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_pubsub_query_direct(p, "u/world", &v));
+    TEARDOWN();
+}
+
+static void test_meta_shared(void ** state) {
+    SETUP();
+    struct jsdrvp_msg_s * m;
+    struct jsdrv_union_s v;
+    char buf[512];
+    publish(p, "u/js220/1/s/i/ctrl$", &jsdrv_union_json(META1));
+    publish(p, "u/js220/2/s/i/ctrl$", &jsdrv_union_json(META1));
+    publish(p, "u/js220/2/s/i/ctrl$", &jsdrv_union_json(META1));  // republish retains the shared entry
+    jsdrv_pubsub_process(p);
+    subscribe_external(p, "u/js220", JSDRV_SFLAG_METADATA_RSP | JSDRV_SFLAG_RETAIN);
+    expect_publish_external("u/js220/1/s/i/ctrl$", &jsdrv_union_json(META1));
+    expect_publish_external("u/js220/2/s/i/ctrl$", &jsdrv_union_json(META1));
+    jsdrv_pubsub_process(p);
+
+    m = jsdrvp_msg_alloc_value(NULL, JSDRV_PUBSUB_QUERY, &jsdrv_union_i32(0));
+    jsdrv_cstr_copy(m->payload.query.topic, "u/js220/2/s/i/ctrl%", sizeof(m->payload.query.topic));
+    v = jsdrv_union_str(buf);
+    v.size = sizeof(buf);
+    m->payload.query.value = &v;
+    jsdrv_pubsub_publish(p, m);
+    jsdrv_pubsub_process(p);
+    assert_int_equal(JSDRV_UNION_JSON, v.type);
+    assert_string_equal(META1, buf);
+    TEARDOWN();
+}
+
 #define query(topic__, buf__)                                                           \
     m = jsdrvp_msg_alloc_value(NULL, JSDRV_PUBSUB_QUERY, &jsdrv_union_i32(0));            \
     jsdrv_cstr_copy(m->payload.query.topic, topic__, sizeof(m->payload.query.topic));     \
@@ -365,21 +692,76 @@ static void test_query(void ** state) {
     TEARDOWN();
 }
 
+#define snapshot(topic__, flags__, buf__, buf_size__)                                   \
+    m = jsdrvp_msg_alloc_value(NULL, JSDRV_PUBSUB_SNAPSHOT, &jsdrv_union_i32(0));         \
+    jsdrv_cstr_copy(m->payload.query.topic, topic__, sizeof(m->payload.query.topic));     \
+    v = jsdrv_union_str(buf__);                                                           \
+    v.size = (buf_size__);                                                              \
+    m->payload.query.value = &v;                                                        \
+    m->payload.query.flags = (flags__);                                                 \
+    jsdrv_pubsub_publish(p, m);
+
+static void test_snapshot(void ** state) {
+    SETUP();
+    struct jsdrvp_msg_s * m;
+    struct jsdrv_union_s v;
+    char buf[512];
+
+    publish(p, "u/js220/1/h/name", &jsdrv_union_cstr_r("a \"b\""));
+    publish(p, "u/js220/1/s/i/ctrl$", &jsdrv_union_json(META1));
+    publish(p, "u/js220/1/s/i/ctrl", &jsdrv_union_u8_r(1));
+    publish(p, "u/js220/1/s/v/range", &jsdrv_union_i32_r(-5));
+    publish(p, "u/js220/1/h/fs", &jsdrv_union_f64_r(0.5));
+    publish(p, "u/js220/1/s/i/!data", &jsdrv_union_u32(7));  // not retained
+    publish(p, "u/js220/2/h/name", &jsdrv_union_cstr_r("other"));
+    jsdrv_pubsub_process(p);
+
+    snapshot("u/js220/1", JSDRV_SFLAG_PUB, buf, sizeof(buf));
+    jsdrv_pubsub_process(p);
+    assert_int_equal(JSDRV_UNION_JSON, v.type);
+    assert_string_equal("{\"u/js220/1/h/name\":\"a \\\"b\\\"\",\"u/js220/1/h/fs\":0.5,"
+                        "\"u/js220/1/s/i/ctrl\":1,\"u/js220/1/s/v/range\":-5}", buf);
+    assert_int_equal(strlen(buf) + 1, v.size);
+    uint32_t size = v.size;
+
+    snapshot("u/js220/1/s/i", JSDRV_SFLAG_PUB | JSDRV_SFLAG_METADATA_RSP, buf, sizeof(buf));
+    jsdrv_pubsub_process(p);
+    assert_true(jsdrv_cstr_starts_with(buf, "{\"u/js220/1/s/i/ctrl$\":{\"dtype\": \"bool\","));
+    assert_true(jsdrv_cstr_ends_with(buf, "},\"u/js220/1/s/i/ctrl\":1}"));
+
+    snapshot("u/js220/1", JSDRV_SFLAG_PUB, buf, 16);  // too small
+    jsdrv_pubsub_process(p);
+    assert_int_equal(size, v.size);  // required size
+    TEARDOWN();
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_subscribe_then_publish),
             cmocka_unit_test(test_subscribe_parent_then_publish),
             cmocka_unit_test(test_publish_subscribe_no_retain),
             cmocka_unit_test(test_publish_subscribe_retain),
+            cmocka_unit_test(test_publish_subscribe_retain_copy),
             cmocka_unit_test(test_subscribe_publish_nopub),
             cmocka_unit_test(test_unsubscribe),
             cmocka_unit_test(test_unsubscribe_all),
+            cmocka_unit_test(test_unsubscribe_all_many),
             cmocka_unit_test(test_external_subscribe_publish_unsubscribe),
             cmocka_unit_test(test_external_subscribe_publish_unsubscribe_all),
             cmocka_unit_test(test_external_retain),
+            cmocka_unit_test(test_batch),
+            cmocka_unit_test(test_many_topics),
+            cmocka_unit_test(test_topic_hash),
+            cmocka_unit_test(test_shard_hash),
+            cmocka_unit_test(test_wildcard),
+            cmocka_unit_test(test_data_publish),
+            cmocka_unit_test(test_data_statistics_retain),
             cmocka_unit_test(test_return_code),
             cmocka_unit_test(test_meta),
+            cmocka_unit_test(test_meta_direct),
+            cmocka_unit_test(test_meta_shared),
             cmocka_unit_test(test_query),
+            cmocka_unit_test(test_snapshot),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "jsdrv_prv/record.h"
+#include "jsdrv/error_code.h"
+
+
+#define PATH "record_test.rec"
+#define MSG_COUNT (1000U)
+#define TOPIC0 "u/js220/000415/s/i/!data"
+#define TOPIC1 "u/js220/000415/s/v/!data"
+
+static struct jsdrv_stream_signal_s signal_;
+
+static uint32_t signal_fill(uint32_t k) {
+    uint32_t n = 1000 + (k * 37) % 3000;
+    signal_.sample_id = (uint64_t) k * 4000;
+    signal_.field_id = JSDRV_FIELD_CURRENT;
+    signal_.index = (uint8_t) (k & 1);
+    signal_.element_type = JSDRV_DATA_TYPE_FLOAT;
+    signal_.element_size_bits = 32;
+    signal_.element_count = n;
+    signal_.sample_rate = 1000000;
+    signal_.decimate_factor = 1;
+    float * data = (float *) signal_.data;
+    for (uint32_t i = 0; i < n; ++i) {
+        data[i] = (float) (k + i);
+    }
+    return JSDRV_STREAM_HEADER_SIZE + n * sizeof(float);
+}
+
+static uint8_t * file_read(size_t * size) {
+    FILE * f = fopen(PATH, "rb");
+    assert_non_null(f);
+    fseek(f, 0, SEEK_END);
+    *size = (size_t) ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t * buf = malloc(*size);
+    assert_int_equal(*size, fread(buf, 1, *size, f));
+    fclose(f);
+    return buf;
+}
+
+static struct jsdrv_record_chunk_s * chunk_next(uint8_t ** p) {
+    struct jsdrv_record_chunk_s * chunk = (struct jsdrv_record_chunk_s *) *p;
+    *p += sizeof(*chunk) + ((chunk->payload_size + 7U) & ~7U);
+    return chunk;
+}
+
+static void record_and_check(uint32_t flags) {
+    struct jsdrv_record_s * r = jsdrv_record_open(PATH, flags);
+    assert_non_null(r);
+    assert_int_equal(0, jsdrv_record_signal(r, 0, TOPIC0));
+    assert_int_equal(0, jsdrv_record_signal(r, 1, TOPIC1));
+    uint32_t dropped = 0;
+    for (uint32_t k = 0; k < MSG_COUNT; ++k) {
+        int32_t rc = jsdrv_record_write(r, (uint8_t) (k & 1), &signal_, signal_fill(k));
+        if (JSDRV_ERROR_FULL == rc) {
+            ++dropped;
+        } else {
+            assert_int_equal(0, rc);
+        }
+    }
+    struct jsdrv_record_status_s status;
+    jsdrv_record_status(r, &status);
+    assert_int_equal(MSG_COUNT - dropped, status.msg_count);
+    assert_int_equal(dropped, status.drop_count);
+    assert_int_equal(0, jsdrv_record_close(r));
+
+    size_t size = 0;
+    uint8_t * buf = file_read(&size);
+    assert_true(size > JSDRV_RECORD_BUFFER_SIZE);  // multiple buffers
+    struct jsdrv_record_header_s * hdr = (struct jsdrv_record_header_s *) buf;
+    assert_memory_equal(JSDRV_RECORD_MAGIC, hdr->magic, sizeof(hdr->magic));
+    assert_int_equal(JSDRV_RECORD_VERSION, hdr->version);
+    assert_int_equal(sizeof(*hdr), hdr->header_size);
+
+    uint8_t * p = buf + hdr->header_size;
+    struct jsdrv_record_chunk_s * chunk = chunk_next(&p);
+    assert_int_equal(JSDRV_RECORD_CHUNK_SIGNAL, chunk->type);
+    assert_int_equal(0, chunk->signal_idx);
+    assert_string_equal(TOPIC0, (char *) (chunk + 1));
+    chunk = chunk_next(&p);
+    assert_int_equal(JSDRV_RECORD_CHUNK_SIGNAL, chunk->type);
+    assert_int_equal(1, chunk->signal_idx);
+    assert_string_equal(TOPIC1, (char *) (chunk + 1));
+
+    uint32_t count = 0;
+    uint64_t sample_id_prev = 0;
+    while (1) {
+        uint8_t * chunk_start = p;
+        chunk = chunk_next(&p);
+        assert_true(p <= (buf + size));
+        if (JSDRV_RECORD_CHUNK_END == chunk->type) {
+            struct jsdrv_record_status_s * end = (struct jsdrv_record_status_s *) (chunk + 1);
+            assert_int_equal(status.msg_count, end->msg_count);
+            assert_int_equal(status.drop_count, end->drop_count);
+            assert_int_equal(chunk_start - buf, end->bytes_written);
+            break;
+        }
+        assert_int_equal(JSDRV_RECORD_CHUNK_DATA, chunk->type);
+        struct jsdrv_stream_signal_s * s = (struct jsdrv_stream_signal_s *) (chunk + 1);
+        uint32_t k = (uint32_t) (s->sample_id / 4000);
+        if (count) {
+            assert_true(s->sample_id > sample_id_prev);
+        }
+        sample_id_prev = s->sample_id;
+        assert_int_equal(k & 1, chunk->signal_idx);
+        assert_int_equal(signal_fill(k), chunk->payload_size);
+        assert_memory_equal(&signal_, s, chunk->payload_size);
+        ++count;
+    }
+    assert_int_equal(status.msg_count, count);
+    assert_ptr_equal(buf + size, p);
+    free(buf);
+    remove(PATH);
+}
+
+static void test_roundtrip(void **state) {
+    (void) state;
+    record_and_check(0);
+}
+
+static void test_direct(void **state) {
+    (void) state;
+    record_and_check(JSDRV_RECORD_FLAG_DIRECT);
+}
+
+static void test_uring(void **state) {
+    (void) state;
+    record_and_check(JSDRV_RECORD_FLAG_DIRECT | JSDRV_RECORD_FLAG_URING);
+}
+
+static void test_invalid(void **state) {
+    (void) state;
+    assert_null(jsdrv_record_open("", 0));
+    struct jsdrv_record_s * r = jsdrv_record_open(PATH, 0);
+    assert_non_null(r);
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_record_signal(r, JSDRV_RECORD_SIGNALS_MAX, TOPIC0));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_record_write(r, 0, &signal_, signal_fill(0)));
+    assert_int_equal(0, jsdrv_record_signal(r, 0, TOPIC0));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_record_write(r, 0, &signal_, JSDRV_STREAM_HEADER_SIZE - 1));
+    assert_int_equal(0, jsdrv_record_write(r, 0, &signal_, signal_fill(0)));
+    assert_int_equal(0, jsdrv_record_close(r));
+    assert_int_equal(0, jsdrv_record_close(NULL));
+    remove(PATH);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_roundtrip),
+            cmocka_unit_test(test_direct),
+            cmocka_unit_test(test_uring),
+            cmocka_unit_test(test_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -145,11 +145,40 @@ static void test_mult_some_overlap(void **state) {
     assert_int_equal(SAMPLE_BUFFER_LENGTH - 1, sbuf_f32_length(&s2));
     sbuf_f32_mult(&r, &s1, &s2);
     assert_int_equal(SAMPLE_BUFFER_LENGTH - 5, sbuf_f32_length(&r));
-    assert_int_equal(7974, r.msg_sample_id);
+    assert_int_equal(10020 - 2 * (SAMPLE_BUFFER_LENGTH - 1), r.msg_sample_id);
     assert_float_equal(40.0f, r.buffer[SAMPLE_BUFFER_LENGTH - 7], 1e-7);
     assert_float_equal(55.0f, r.buffer[SAMPLE_BUFFER_LENGTH - 6], 1e-7);
 }
 
+static void test_mult_wrap(void **state) {
+    (void) state;
+    struct sbuf_f32_s r;
+    struct sbuf_f32_s s1;
+    struct sbuf_f32_s s2;
+    float f1[SAMPLE_BUFFER_LENGTH / 2];
+    float f2[SAMPLE_BUFFER_LENGTH / 2];
+    sbuf_f32_clear(&s1);
+    sbuf_f32_clear(&s2);
+    sbuf_f32_clear(&r);
+    // place s1 and s2 tails at different offsets so that both wrap
+    s1.head = s1.tail = SAMPLE_BUFFER_LENGTH - 100;
+    s2.head = s2.tail = SAMPLE_BUFFER_LENGTH - 300;
+    for (size_t i = 0; i < JSDRV_ARRAY_SIZE(f1); ++i) {
+        f1[i] = (float) i;
+        f2[i] = (float) (i + 1);
+    }
+    sbuf_f32_add(&s1, 0, f1, JSDRV_ARRAY_SIZE(f1));
+    sbuf_f32_add(&s2, 0, f2, JSDRV_ARRAY_SIZE(f2));
+    sbuf_f32_mult(&r, &s1, &s2);
+    assert_int_equal(JSDRV_ARRAY_SIZE(f1), sbuf_f32_length(&r));
+    assert_int_equal(0, sbuf_f32_length(&s1));
+    assert_int_equal(0, sbuf_f32_length(&s2));
+    assert_int_equal(JSDRV_ARRAY_SIZE(f1) * r.sample_id_decimate, sbuf_head_sample_id(&r));
+    for (size_t i = 0; i < JSDRV_ARRAY_SIZE(f1); i++) {
+        assert_float_equal(i * (i + 1), r.buffer[i], 1e-7);
+    }
+}
+
 static void test_advance_one(void **state) {
     (void) state;
     struct sbuf_f32_s b;
@@ -183,6 +212,7 @@ int main(void) {
             cmocka_unit_test(test_mult),
             cmocka_unit_test(test_mult_no_overlap),
             cmocka_unit_test(test_mult_some_overlap),
+            cmocka_unit_test(test_mult_wrap),
             cmocka_unit_test(test_advance_one),
     };
 
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <math.h>
+#include <string.h>
+#include "jsdrv_prv/shm.h"
+#include "jsdrv/error_code.h"
+
+
+#define NAME "jsdrv_shm_test"
+#define TOPIC "u/js220/000415/s/i/!data"
+#define CAPACITY (1000U)
+
+static struct jsdrv_stream_signal_s signal_;
+
+static void signal_f32(uint64_t sample_id, uint32_t n) {
+    signal_.sample_id = sample_id;
+    signal_.field_id = JSDRV_FIELD_CURRENT;
+    signal_.index = 0;
+    signal_.element_type = JSDRV_DATA_TYPE_FLOAT;
+    signal_.element_size_bits = 32;
+    signal_.element_count = n;
+    signal_.sample_rate = 1000000;
+    signal_.decimate_factor = 2;
+    float * data = (float *) signal_.data;
+    for (uint32_t i = 0; i < n; ++i) {
+        data[i] = (float) (sample_id / 2 + i);
+    }
+}
+
+static void test_write_read(void **state) {
+    (void) state;
+    struct jsdrv_shm_reader_s * r = NULL;
+    struct jsdrv_shm_header_s hdr;
+    float y[CAPACITY];
+    assert_int_equal(JSDRV_ERROR_NOT_FOUND, jsdrv_shm_reader_open(NAME, &r));
+    struct jsdrv_shm_writer_s * w = jsdrv_shm_writer_open(NAME, TOPIC, CAPACITY);
+    assert_non_null(w);
+    signal_f32(1000, 300);
+    assert_int_equal(0, jsdrv_shm_writer_write(w, &signal_));
+
+    assert_int_equal(0, jsdrv_shm_reader_open(NAME, &r));
+    assert_int_equal(0, jsdrv_shm_reader_header(r, &hdr));
+    assert_memory_equal(JSDRV_SHM_MAGIC, hdr.magic, sizeof(hdr.magic));
+    assert_int_equal(0, hdr.seq & 1);
+    assert_int_equal(CAPACITY, hdr.capacity);
+    assert_int_equal(300, hdr.write_count);
+    assert_int_equal(1600, hdr.sample_id);
+    assert_int_equal(2, hdr.decimate_factor);
+    assert_int_equal(32, hdr.element_size_bits);
+    assert_string_equal(TOPIC, hdr.topic);
+
+    assert_int_equal(0, jsdrv_shm_reader_read(r, 1000, 300, y));
+    for (uint32_t i = 0; i < 300; ++i) {
+        assert_float_equal(500 + i, y[i], 0.0f);
+    }
+    assert_float_equal(500.0f, ((const float *) jsdrv_shm_reader_data(r))[0], 0.0f);
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_shm_reader_read(r, 1001, 1, y));
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_shm_reader_read(r, 998, 1, y));
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_shm_reader_read(r, 1598, 2, y));
+
+    // gap of 50 elements, then wrap the ring
+    signal_f32(1700, 900);
+    assert_int_equal(0, jsdrv_shm_writer_write(w, &signal_));
+    assert_int_equal(0, jsdrv_shm_reader_header(r, &hdr));
+    assert_int_equal(1250, hdr.write_count);
+    assert_int_equal(3500, hdr.sample_id);
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_shm_reader_read(r, 1000, 1, y));  // overwritten
+    assert_int_equal(0, jsdrv_shm_reader_read(r, 1500, 1000, y));
+    for (uint32_t i = 0; i < 50; ++i) {
+        assert_float_equal(750 + i, y[i], 0.0f);
+        assert_true(isnan(y[50 + i]));
+    }
+    for (uint32_t i = 0; i < 900; ++i) {
+        assert_float_equal(850 + i, y[100 + i], 0.0f);
+    }
+
+    jsdrv_shm_reader_close(r);
+    jsdrv_shm_writer_close(w);
+    assert_int_equal(JSDRV_ERROR_NOT_FOUND, jsdrv_shm_reader_open(NAME, &r));
+}
+
+static void test_u4(void **state) {
+    (void) state;
+    struct jsdrv_shm_reader_s * r = NULL;
+    struct jsdrv_shm_header_s hdr;
+    uint8_t y[16];
+    struct jsdrv_shm_writer_s * w = jsdrv_shm_writer_open(NAME, TOPIC, 16);
+    memset(&signal_, 0, sizeof(signal_));
+    signal_.element_type = JSDRV_DATA_TYPE_UINT;
+    signal_.element_size_bits = 4;
+    signal_.element_count = 6;
+    signal_.decimate_factor = 1;
+    signal_.data[0] = 0x21;
+    signal_.data[1] = 0x43;
+    signal_.data[2] = 0x65;
+    assert_int_equal(0, jsdrv_shm_writer_write(w, &signal_));
+    assert_int_equal(0, jsdrv_shm_reader_open(NAME, &r));
+    assert_int_equal(0, jsdrv_shm_reader_header(r, &hdr));
+    assert_int_equal(8, hdr.element_size_bits);
+    assert_int_equal(0, jsdrv_shm_reader_read(r, 0, 6, y));
+    for (uint32_t i = 0; i < 6; ++i) {
+        assert_int_equal(i + 1, y[i]);
+    }
+    signal_.element_size_bits = 32;
+    signal_.element_type = JSDRV_DATA_TYPE_FLOAT;
+    assert_int_equal(JSDRV_ERROR_NOT_SUPPORTED, jsdrv_shm_writer_write(w, &signal_));
+    jsdrv_shm_reader_close(r);
+    jsdrv_shm_writer_close(w);
+}
+
+static void test_invalid(void **state) {
+    (void) state;
+    struct jsdrv_shm_reader_s * r = NULL;
+    assert_null(jsdrv_shm_writer_open("", TOPIC, CAPACITY));
+    assert_null(jsdrv_shm_writer_open(NAME, TOPIC, 0));
+    struct jsdrv_shm_writer_s * w = jsdrv_shm_writer_open("bad/name", TOPIC, CAPACITY);
+    assert_non_null(w);  // created on the first write
+    signal_f32(0, 10);
+    assert_int_equal(JSDRV_ERROR_IO, jsdrv_shm_writer_write(w, &signal_));
+    assert_int_equal(JSDRV_ERROR_IO, jsdrv_shm_writer_write(w, &signal_));
+    jsdrv_shm_writer_close(w);
+    assert_int_equal(JSDRV_ERROR_NOT_FOUND, jsdrv_shm_reader_open("bad/name", &r));
+    jsdrv_shm_writer_close(NULL);
+    jsdrv_shm_reader_close(NULL);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_write_read),
+            cmocka_unit_test(test_u4),
+            cmocka_unit_test(test_invalid),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
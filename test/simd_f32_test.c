@@ -0,0 +1,203 @@
+/*
+ * Copyright 2023 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include "jsdrv.h"
+#include "jsdrv_prv/cpu.h"
+#include "jsdrv_prv/simd_f32.h"
+#include "jsdrv_prv/statistics.h"
+
+
+#define LENGTH (67)  // not a multiple of any vector width
+
+
+static void test_impl(void **state) {
+    (void) state;
+    const char * name = jsdrv_f32_impl();
+    assert_non_null(name);
+    assert_true((0 == strcmp("avx512", name)) || (0 == strcmp("avx2", name)) || (0 == strcmp("sse2", name))
+        || (0 == strcmp("neon", name)) || (0 == strcmp("scalar", name)));
+}
+
+static void test_mult(void **state) {
+    (void) state;
+    float a[LENGTH + 1];
+    float b[LENGTH + 1];
+    float y[LENGTH + 1];
+    for (uint32_t n = 0; n <= LENGTH; ++n) {
+        for (uint32_t i = 0; i <= LENGTH; ++i) {
+            a[i] = (float) i;
+            b[i] = 0.5f * (float) i + 1.0f;
+            y[i] = -1.0f;
+        }
+        jsdrv_f32_mult(y, a, b, 2.0f, n);
+        for (uint32_t i = 0; i < n; ++i) {
+            assert_float_equal((a[i] * b[i]) * 2.0f, y[i], 0.0);
+        }
+        assert_float_equal(-1.0f, y[n], 0.0);  // no overrun
+    }
+}
+
+static void test_mult_unaligned_inplace(void **state) {
+    (void) state;
+    float a[LENGTH + 1];
+    float b[LENGTH + 1];
+    for (uint32_t i = 0; i <= LENGTH; ++i) {
+        a[i] = (float) i;
+        b[i] = 3.0f;
+    }
+    jsdrv_f32_mult(a + 1, a + 1, b + 1, 1.0f, LENGTH);
+    assert_float_equal(0.0f, a[0], 0.0);
+    for (uint32_t i = 1; i <= LENGTH; ++i) {
+        assert_float_equal(3.0f * (float) i, a[i], 0.0);
+    }
+}
+
+static void test_scale(void **state) {
+    (void) state;
+    float x[LENGTH + 1];
+    for (uint32_t n = 0; n <= LENGTH; ++n) {
+        for (uint32_t i = 0; i <= LENGTH; ++i) {
+            x[i] = (float) i;
+        }
+        jsdrv_f32_scale(x, 0.25f, n);
+        for (uint32_t i = 0; i < n; ++i) {
+            assert_float_equal(0.25f * (float) i, x[i], 0.0);
+        }
+        assert_float_equal((float) n, x[n], 0.0);  // no overrun
+    }
+}
+
+static void test_sum(void **state) {
+    (void) state;
+    float x[LENGTH];
+    struct jsdrv_f32_sum_s s;
+    for (uint32_t i = 0; i < LENGTH; ++i) {
+        x[i] = (i % 5 == 3) ? NAN : ((float) i - 20.0f);
+    }
+    for (uint32_t n = 0; n <= LENGTH; ++n) {
+        uint64_t count = 0;
+        double sum = 0.0;
+        float x_min = FLT_MAX;
+        float x_max = -FLT_MAX;
+        for (uint32_t i = 0; i < n; ++i) {
+            if (!isnan(x[i])) {
+                ++count;
+                sum += x[i];
+                x_min = (x[i] < x_min) ? x[i] : x_min;
+                x_max = (x[i] > x_max) ? x[i] : x_max;
+            }
+        }
+        jsdrv_f32_sum_reset(&s);
+        jsdrv_f32_sum(&s, x, n);
+        assert_int_equal(count, s.count);
+        assert_float_equal(sum, s.sum, 0.0);
+        assert_float_equal(x_min, s.min, 0.0);
+        assert_float_equal(x_max, s.max, 0.0);
+    }
+
+    // accumulate segments
+    jsdrv_f32_sum_reset(&s);
+    jsdrv_f32_sum(&s, x, 10);
+    jsdrv_f32_sum(&s, x + 10, LENGTH - 10);
+    struct jsdrv_f32_sum_s s_all;
+    jsdrv_f32_sum_reset(&s_all);
+    jsdrv_f32_sum(&s_all, x, LENGTH);
+    assert_int_equal(s_all.count, s.count);
+    assert_float_equal(s_all.sum, s.sum, 0.0);
+}
+
+static void test_sum_sq_diff(void **state) {
+    (void) state;
+    float x[LENGTH];
+    for (uint32_t i = 0; i < LENGTH; ++i) {
+        x[i] = (i == 17) ? NAN : (1000.0f + 0.25f * (float) i);
+    }
+    double expect = 0.0;
+    for (uint32_t i = 0; i < LENGTH; ++i) {
+        if (!isnan(x[i])) {
+            double d = x[i] - 1008.0;
+            expect += d * d;
+        }
+    }
+    assert_float_equal(expect, jsdrv_f32_sum_sq_diff(x, LENGTH, 1008.0), 1e-9);
+    assert_float_equal(0.0, jsdrv_f32_sum_sq_diff(x, 0, 1008.0), 0.0);
+}
+
+static void test_summary_combine(void **state) {
+    (void) state;
+    struct jsdrv_summary_entry_s x[32];
+    struct jsdrv_summary_entry_s y;
+    struct jsdrv_summary_entry_s y_expect;
+    struct jsdrv_statistics_accum_s s_accum;
+    struct jsdrv_statistics_accum_s s_tmp;
+    for (uint32_t i = 0; i < 32; ++i) {
+        x[i].avg = 1.0f + 0.01f * (float) (i % 7);
+        x[i].std = 0.1f + 0.001f * (float) i;
+        x[i].min = x[i].avg - 0.5f - 0.01f * (float) i;
+        x[i].max = x[i].avg + 0.5f + 0.02f * (float) (i % 11);
+    }
+    for (uint32_t n = 1; n <= 32; ++n) {
+        jsdrv_statistics_reset(&s_accum);
+        for (uint32_t i = 0; i < n; ++i) {
+            jsdrv_statistics_from_entry(&s_tmp, &x[i], 1);
+            jsdrv_statistics_combine(&s_accum, &s_accum, &s_tmp);
+        }
+        jsdrv_statistics_to_entry(&s_accum, &y_expect);
+        assert_int_equal(0, jsdrv_f32_summary_combine(&y, x, n));
+        assert_float_equal(y_expect.avg, y.avg, 1e-6);
+        assert_float_equal(y_expect.std, y.std, 1e-6);
+        assert_float_equal(y_expect.min, y.min, 0.0);
+        assert_float_equal(y_expect.max, y.max, 0.0);
+    }
+
+    assert_int_equal(1, jsdrv_f32_summary_combine(&y, x, 0));
+    x[5].avg = NAN;
+    y.avg = 42.0f;
+    assert_int_equal(1, jsdrv_f32_summary_combine(&y, x, 32));
+    assert_float_equal(42.0f, y.avg, 0.0);  // unmodified
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_impl),
+            cmocka_unit_test(test_mult),
+            cmocka_unit_test(test_mult_unaligned_inplace),
+            cmocka_unit_test(test_scale),
+            cmocka_unit_test(test_sum),
+            cmocka_unit_test(test_sum_sq_diff),
+            cmocka_unit_test(test_summary_combine),
+    };
+
+    // run each kernel implementation that the host supports
+    static const char * LIMITS[] = {"", "avx2", "sse2", "scalar"};
+    uint32_t features = jsdrv_cpu_detect();
+    int rc = 0;
+    for (uint32_t i = 0; i < sizeof(LIMITS) / sizeof(LIMITS[0]); ++i) {
+        uint32_t mask = 0;
+        jsdrv_cpu_mask(LIMITS[i], &mask);
+        jsdrv_f32_select(features & mask);
+        print_message("kernels %s\n", jsdrv_f32_impl());
+        rc |= cmocka_run_group_tests(tests, NULL, NULL);
+    }
+    return rc;
+}
@@ -19,6 +19,8 @@
 #include <setjmp.h>
 #include <cmocka.h>
 #include "jsdrv_prv/statistics.h"
+#include <math.h>
+#include <stdlib.h>
 
 
 const float F32_0[] = {0.0f, 1.0f, 2.0f, 7.7f, -2.0f, 3.1f, -3.1f, 4.2f, -4.2f, -1.0f, 5.4f, -5.4f, 6.3f, -6.3f, -7.7f};
@@ -175,6 +177,29 @@ static void test_combine_f32_in_two_parts(void **state) {
     }
 }
 
+static void test_combine_envelope(void **state) {
+    (void) state;
+    struct jsdrv_statistics_accum_s s1;
+    struct jsdrv_statistics_accum_s s2;
+    struct jsdrv_statistics_accum_s ref;
+    struct jsdrv_statistics_accum_s t;
+    size_t data_len = sizeof(F32_0) / sizeof(F32_0[0]);
+    for (size_t i = 0; i < data_len; ++i) {
+        jsdrv_statistics_reset(&s1);
+        jsdrv_statistics_reset(&s2);
+        for (size_t k = 0; k < data_len; ++k) {
+            jsdrv_statistics_add((k < i) ? &s1 : &s2, F32_0[k]);
+        }
+        jsdrv_statistics_combine(&ref, &s1, &s2);
+        jsdrv_statistics_combine_envelope(&t, &s1, &s2);
+        assert_int_equal(ref.k, t.k);
+        assert_float_equal(ref.mean, t.mean, 0.0);
+        assert_float_equal(ref.min, t.min, 0.0);
+        assert_float_equal(ref.max, t.max, 0.0);
+        assert_true(isnan(t.s));
+    }
+}
+
 static void test_combine_f64_in_two_parts(void **state) {
     (void) state;
     struct jsdrv_statistics_accum_s s1;
@@ -217,6 +242,90 @@ static void test_combine_in_place(void **state) {
     assert_stats_equal(ref, t2);
 }
 
+static void test_compute_f32_blocks(void **state) {
+    (void) state;
+    struct jsdrv_statistics_accum_s t;
+    struct jsdrv_statistics_accum_s ref;
+    uint32_t length = 3 * JSDRV_STATISTICS_BLOCK_SIZE + 17;
+    float * x = malloc(length * sizeof(float));
+    jsdrv_statistics_reset(&ref);
+    for (uint32_t i = 0; i < length; ++i) {
+        x[i] = 100.0f + (float) ((i * 7919U) % 1001U) * 0.01f;
+        jsdrv_statistics_add(&ref, x[i]);
+    }
+    jsdrv_statistics_compute_f32(&t, x, length);
+    assert_int_equal(length, t.k);
+    assert_float_equal(ref.mean, t.mean, 1e-9);
+    assert_float_equal(ref.min, t.min, 0.0);
+    assert_float_equal(ref.max, t.max, 0.0);
+    assert_float_equal(ref.s, t.s, ref.s * 1e-9);
+    free(x);
+}
+
+static void test_compute_nan(void **state) {
+    (void) state;
+    struct jsdrv_statistics_accum_s t;
+    float x32[] = {1.0f, NAN, 3.0f};
+    double x64[] = {1.0, NAN, 3.0};
+    jsdrv_statistics_compute_f32(&t, x32, 3);
+    assert_int_equal(3, t.k);
+    assert_true(isnan(t.mean));
+    assert_true(isnan(t.s));
+    assert_float_equal(1.0, t.min, 0.0);
+    assert_float_equal(3.0, t.max, 0.0);
+    jsdrv_statistics_compute_f64(&t, x64, 3);
+    assert_int_equal(3, t.k);
+    assert_true(isnan(t.mean));
+    assert_true(isnan(t.s));
+    assert_float_equal(1.0, t.min, 0.0);
+    assert_float_equal(3.0, t.max, 0.0);
+}
+
+static void test_compute_parallel(void **state) {
+    (void) state;
+    struct jsdrv_statistics_accum_s t;
+    struct jsdrv_statistics_accum_s ref;
+    uint32_t length = 4 * JSDRV_STATISTICS_PARALLEL_MIN + 1234;
+    float * x32 = malloc(length * sizeof(float));
+    double * x64 = malloc(length * sizeof(double));
+    for (uint32_t i = 0; i < length; ++i) {
+        x64[i] = -2.0 + (double) ((i * 104729U) % 4099U) * 0.001;
+        x32[i] = (float) x64[i];
+    }
+
+    jsdrv_statistics_compute_f32(&ref, x32, length);
+    uint32_t threads[] = {0, 1, 3, 4, 100};
+    for (uint32_t i = 0; i < sizeof(threads) / sizeof(threads[0]); ++i) {
+        jsdrv_statistics_compute_f32_parallel(&t, x32, length, threads[i]);
+        assert_int_equal(length, t.k);
+        assert_float_equal(ref.mean, t.mean, 1e-12);
+        assert_float_equal(ref.min, t.min, 0.0);
+        assert_float_equal(ref.max, t.max, 0.0);
+        assert_float_equal(ref.s, t.s, ref.s * 1e-12);
+    }
+
+    jsdrv_statistics_compute_f64(&ref, x64, length);
+    jsdrv_statistics_compute_f64_parallel(&t, x64, length, 4);
+    assert_int_equal(length, t.k);
+    assert_float_equal(ref.mean, t.mean, 1e-12);
+    assert_float_equal(ref.min, t.min, 0.0);
+    assert_float_equal(ref.max, t.max, 0.0);
+    assert_float_equal(ref.s, t.s, ref.s * 1e-12);
+
+    x64[length - 1] = NAN;
+    jsdrv_statistics_compute_f64_parallel(&t, x64, length, 4);
+    assert_int_equal(length, t.k);
+    assert_true(isnan(t.mean));
+    assert_true(isnan(t.s));
+    assert_float_equal(ref.min, t.min, 0.0);
+
+    jsdrv_statistics_compute_f32_parallel(&t, x32, 10, 4);  // too small, runs on this thread
+    jsdrv_statistics_compute_f32(&ref, x32, 10);
+    assert_stats_equal(ref, t);
+    free(x32);
+    free(x64);
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_initialize),
@@ -228,8 +337,12 @@ int main(void) {
             cmocka_unit_test(test_combine_b_empty),
             cmocka_unit_test(test_combine_f32_run),
             cmocka_unit_test(test_combine_f32_in_two_parts),
+            cmocka_unit_test(test_combine_envelope),
             cmocka_unit_test(test_combine_f64_in_two_parts),
             cmocka_unit_test(test_combine_in_place),
+            cmocka_unit_test(test_compute_f32_blocks),
+            cmocka_unit_test(test_compute_nan),
+            cmocka_unit_test(test_compute_parallel),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/stats_all.h"
+#include "jsdrv/error_code.h"
+#include "tinyprintf.h"
+#include <string.h>
+
+#define FS (1000000U)
+
+
+static struct jsdrv_statistics_all_s all_;
+
+static struct jsdrv_statistics_s * stats(uint64_t sample_id, double i_avg) {
+    static struct jsdrv_statistics_s s;
+    memset(&s, 0, sizeof(s));
+    s.version = 1;
+    s.decimate_factor = 2;
+    s.block_sample_count = FS / 2;
+    s.sample_freq = FS;
+    s.block_sample_id = sample_id;
+    s.i_avg = i_avg;
+    s.time_map.offset_time = JSDRV_TIME_SECOND;
+    s.time_map.counter_rate = FS;
+    return &s;
+}
+
+static void test_update(void **state) {
+    (void) state;
+    jsdrv_stats_all_clear(&all_);
+    assert_int_equal(1, all_.version);
+    assert_int_equal(offsetof(struct jsdrv_statistics_all_s, entries), jsdrv_stats_all_size(&all_));
+    assert_int_equal(0, jsdrv_stats_all_update(&all_, "u/js220/000001", stats(0, 1.0)));
+    assert_int_equal(0, jsdrv_stats_all_update(&all_, "u/js220/000002", stats(2 * FS, 2.0)));
+    assert_int_equal(0, jsdrv_stats_all_update(&all_, "u/js110/000003", stats(FS, 3.0)));
+    assert_int_equal(3, all_.count);
+    assert_string_equal("u/js220/000001", all_.entries[0].device);
+    assert_string_equal("u/js110/000003", all_.entries[1].device);
+    assert_string_equal("u/js220/000002", all_.entries[2].device);
+    assert_int_equal(4 * JSDRV_TIME_SECOND, all_.entries[2].utc);  // block end + offset_time
+
+    assert_int_equal(0, jsdrv_stats_all_update(&all_, "u/js220/000001", stats(3 * FS, 4.0)));
+    assert_int_equal(3, all_.count);
+    assert_string_equal("u/js220/000001", all_.entries[2].device);
+    assert_true(4.0 == all_.entries[2].statistics.i_avg);
+    assert_int_equal(offsetof(struct jsdrv_statistics_all_s, entries) + 3 * sizeof(all_.entries[0]),
+                     jsdrv_stats_all_size(&all_));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_stats_all_update(&all_, "", stats(0, 0.0)));
+}
+
+static void test_remove(void **state) {
+    (void) state;
+    jsdrv_stats_all_clear(&all_);
+    assert_int_equal(0, jsdrv_stats_all_update(&all_, "u/js220/000001", stats(0, 1.0)));
+    assert_int_equal(0, jsdrv_stats_all_update(&all_, "u/js220/000002", stats(FS, 2.0)));
+    assert_int_equal(JSDRV_ERROR_NOT_FOUND, jsdrv_stats_all_remove(&all_, "u/js220/000003"));
+    assert_int_equal(0, jsdrv_stats_all_remove(&all_, "u/js220/000001"));
+    assert_int_equal(1, all_.count);
+    assert_string_equal("u/js220/000002", all_.entries[0].device);
+}
+
+static void test_full(void **state) {
+    (void) state;
+    char device[JSDRV_TOPIC_LENGTH_MAX];
+    jsdrv_stats_all_clear(&all_);
+    for (uint32_t i = 0; i < JSDRV_STATISTICS_ALL_DEVICES_MAX; ++i) {
+        tfp_snprintf(device, sizeof(device), "u/js220/%06u", (unsigned int) i);
+        assert_int_equal(0, jsdrv_stats_all_update(&all_, device, stats(i * FS, 0.0)));
+    }
+    assert_int_equal(JSDRV_ERROR_FULL, jsdrv_stats_all_update(&all_, "u/js220/999999", stats(0, 0.0)));
+    assert_int_equal(0, jsdrv_stats_all_update(&all_, "u/js220/000000", stats(100 * FS, 0.0)));
+    assert_string_equal("u/js220/000000", all_.entries[JSDRV_STATISTICS_ALL_DEVICES_MAX - 1].device);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_update),
+            cmocka_unit_test(test_remove),
+            cmocka_unit_test(test_full),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
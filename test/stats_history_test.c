@@ -0,0 +1,196 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/stats_history.h"
+#include "jsdrv/error_code.h"
+#include "jsdrv/time.h"
+#include <string.h>
+
+#define FS (1000000U)
+#define RSP_MAX (8U)
+
+
+static struct jsdrv_statistics_history_response_s rsp_;
+static uint32_t rsp_count_;
+static uint32_t rsp_flags_[RSP_MAX];
+static uint32_t rsp_records_[RSP_MAX];
+static uint64_t sample_ids_[RSP_MAX * JSDRV_STATISTICS_HISTORY_RESPONSE_COUNT];
+static uint32_t sample_ids_length_;
+
+static struct jsdrv_statistics_s * stats(uint64_t sample_id) {
+    static struct jsdrv_statistics_s s;
+    memset(&s, 0, sizeof(s));
+    s.version = 1;
+    s.decimate_factor = 2;
+    s.block_sample_count = FS / 4;
+    s.sample_freq = FS;
+    s.block_sample_id = sample_id;
+    s.time_map.offset_time = JSDRV_TIME_SECOND;
+    s.time_map.counter_rate = FS;
+    return &s;
+}
+
+static void on_rsp(void * user_data, struct jsdrv_statistics_history_response_s * rsp) {
+    assert_ptr_equal(&rsp_count_, user_data);
+    assert_true(rsp_count_ < RSP_MAX);
+    assert_int_equal(1, rsp->version);
+    assert_int_equal(42, rsp->rsp_id);
+    assert_int_equal(rsp_count_, rsp->seq);
+    assert_true(rsp->count <= JSDRV_STATISTICS_HISTORY_RESPONSE_COUNT);
+    rsp_flags_[rsp_count_] = rsp->flags;
+    rsp_records_[rsp_count_] = rsp->count;
+    for (uint32_t k = 0; k < rsp->count; ++k) {
+        sample_ids_[sample_ids_length_++] = rsp->data[k].block_sample_id;
+    }
+    ++rsp_count_;
+}
+
+static int setup(void ** state) {
+    (void) state;
+    rsp_count_ = 0;
+    sample_ids_length_ = 0;
+    return 0;
+}
+
+static struct jsdrv_statistics_history_request_s request(int8_t time_type, uint64_t start, uint64_t end, uint64_t length) {
+    struct jsdrv_statistics_history_request_s req;
+    memset(&req, 0, sizeof(req));
+    req.version = 1;
+    req.time_type = time_type;
+    req.time.samples.start = start;
+    req.time.samples.end = end;
+    req.time.samples.length = length;
+    req.rsp_id = 42;
+    return req;
+}
+
+static int32_t query(struct jsdrv_stats_history_s * h, const struct jsdrv_statistics_history_request_s * req) {
+    return jsdrv_stats_history_query(h, req, &rsp_, on_rsp, &rsp_count_);
+}
+
+static void test_ring(void ** state) {
+    (void) state;
+    assert_null(jsdrv_stats_history_alloc(0));
+    assert_null(jsdrv_stats_history_alloc(JSDRV_STATISTICS_HISTORY_MAX + 1));
+    struct jsdrv_stats_history_s * h = jsdrv_stats_history_alloc(4);
+    assert_int_equal(0, jsdrv_stats_history_size(h));
+    for (uint32_t k = 0; k < 6; ++k) {
+        jsdrv_stats_history_add(h, stats(k * FS));
+    }
+    assert_int_equal(4, jsdrv_stats_history_size(h));
+    struct jsdrv_statistics_history_request_s req = request(JSDRV_TIME_SAMPLES, 0, 0, 0);
+    assert_int_equal(0, query(h, &req));
+    assert_int_equal(1, rsp_count_);
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_FLAG_FINAL, rsp_flags_[0]);
+    assert_int_equal(4, rsp_.total);
+    assert_int_equal(4, sample_ids_length_);
+    for (uint32_t k = 0; k < 4; ++k) {
+        assert_int_equal((k + 2) * FS, sample_ids_[k]);  // oldest first
+    }
+    jsdrv_stats_history_free(h);
+}
+
+static void test_range(void ** state) {
+    (void) state;
+    struct jsdrv_stats_history_s * h = jsdrv_stats_history_alloc(16);
+    for (uint32_t k = 0; k < 10; ++k) {
+        jsdrv_stats_history_add(h, stats(k * FS));
+    }
+    struct jsdrv_statistics_history_request_s req = request(JSDRV_TIME_SAMPLES, 3 * FS, 6 * FS, 0);
+    assert_int_equal(0, query(h, &req));
+    assert_int_equal(4, sample_ids_length_);
+    assert_int_equal(3 * FS, sample_ids_[0]);
+    assert_int_equal(6 * FS, sample_ids_[3]);
+
+    setup(NULL);
+    req = request(JSDRV_TIME_SAMPLES, 3 * FS, 0, 2);  // most recent 2
+    assert_int_equal(0, query(h, &req));
+    assert_int_equal(2, rsp_.total);
+    assert_int_equal(2, sample_ids_length_);
+    assert_int_equal(8 * FS, sample_ids_[0]);
+    assert_int_equal(9 * FS, sample_ids_[1]);
+
+    // sample_id k * FS at counter_rate FS is k seconds after offset_time
+    setup(NULL);
+    req = request(JSDRV_TIME_UTC, 0, 0, 0);
+    req.time.utc.start = 5 * JSDRV_TIME_SECOND;
+    req.time.utc.end = 7 * JSDRV_TIME_SECOND;
+    assert_int_equal(0, query(h, &req));
+    assert_int_equal(3, sample_ids_length_);
+    assert_int_equal(4 * FS, sample_ids_[0]);
+    assert_int_equal(6 * FS, sample_ids_[2]);
+    jsdrv_stats_history_free(h);
+}
+
+static void test_empty(void ** state) {
+    (void) state;
+    struct jsdrv_statistics_history_request_s req = request(JSDRV_TIME_SAMPLES, 0, 0, 0);
+    assert_int_equal(0, query(NULL, &req));  // unknown device
+    assert_int_equal(1, rsp_count_);
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_FLAG_FINAL, rsp_flags_[0]);
+    assert_int_equal(0, rsp_records_[0]);
+    assert_int_equal(0, rsp_.total);
+
+    req.version = 2;
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, query(NULL, &req));
+    req = request(5, 0, 0, 0);
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, query(NULL, &req));
+    assert_int_equal(1, rsp_count_);
+}
+
+static void test_chunks(void ** state) {
+    (void) state;
+    const uint32_t count = 2 * JSDRV_STATISTICS_HISTORY_RESPONSE_COUNT + 10;
+    struct jsdrv_stats_history_s * h = jsdrv_stats_history_alloc(count);
+    for (uint32_t k = 0; k < count; ++k) {
+        jsdrv_stats_history_add(h, stats(k));
+    }
+    struct jsdrv_statistics_history_request_s req = request(JSDRV_TIME_SAMPLES, 0, 0, 0);
+    assert_int_equal(0, query(h, &req));
+    assert_int_equal(3, rsp_count_);
+    assert_int_equal(count, rsp_.total);
+    assert_int_equal(JSDRV_STATISTICS_HISTORY_RESPONSE_COUNT, rsp_records_[0]);
+    assert_int_equal(JSDRV_STATISTICS_HISTORY_RESPONSE_COUNT, rsp_records_[1]);
+    assert_int_equal(10, rsp_records_[2]);
+    assert_int_equal(0, rsp_flags_[0]);
+    assert_int_equal(0, rsp_flags_[1]);
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_FLAG_FINAL, rsp_flags_[2]);
+    for (uint32_t k = 0; k < count; ++k) {
+        assert_int_equal(k, sample_ids_[k]);
+    }
+
+    setup(NULL);
+    req = request(JSDRV_TIME_SAMPLES, 0, JSDRV_STATISTICS_HISTORY_RESPONSE_COUNT - 1, 0);  // exactly one
+    assert_int_equal(0, query(h, &req));
+    assert_int_equal(1, rsp_count_);
+    assert_int_equal(JSDRV_BUFFER_RESPONSE_FLAG_FINAL, rsp_flags_[0]);
+    jsdrv_stats_history_free(h);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test_setup(test_ring, setup),
+            cmocka_unit_test_setup(test_range, setup),
+            cmocka_unit_test_setup(test_empty, setup),
+            cmocka_unit_test_setup(test_chunks, setup),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/stream_event.h"
+#include "jsdrv_prv/pack.h"
+#include <string.h>
+
+
+static struct jsdrv_stream_signal_s s_;
+
+static struct jsdrv_stream_signal_s * signal_init(uint8_t element_size_bits) {
+    memset(&s_, 0, sizeof(s_));
+    s_.element_type = JSDRV_DATA_TYPE_UINT;
+    s_.element_size_bits = element_size_bits;
+    return &s_;
+}
+
+static const struct jsdrv_stream_event_s * events(const struct jsdrv_stream_signal_s * s) {
+    return (const struct jsdrv_stream_event_s *) s->data;
+}
+
+static void test_u1_packed(void **state) {
+    (void) state;
+    struct jsdrv_stream_signal_s * s = signal_init(1);
+    uint8_t x[64];
+    uint8_t p[8];
+    memset(x, 0, sizeof(x));
+    memset(x + 3, 1, 2);     // 3, 4
+    memset(x + 20, 1, 30);   // 20 to 49
+    jsdrv_pack_u1(p, x, 64);
+    uint32_t size = JSDRV_STREAM_HEADER_SIZE;
+    assert_int_equal(40, jsdrv_stream_event_add_packed(s, &size, JSDRV_STREAM_EVENT_SIZE_MAX, p, 0, 40));
+    assert_int_equal(24, jsdrv_stream_event_add_packed(s, &size, JSDRV_STREAM_EVENT_SIZE_MAX, p, 40, 24));
+    assert_int_equal(64, s->element_count);
+    assert_int_equal(5, jsdrv_stream_event_count(size));
+    const struct jsdrv_stream_event_s * e = events(s);
+    uint32_t expect[][2] = {{0, 0}, {3, 1}, {5, 0}, {20, 1}, {50, 0}};
+    for (uint32_t i = 0; i < 5; ++i) {
+        assert_int_equal(expect[i][0], e[i].offset);
+        assert_int_equal(expect[i][1], e[i].value);
+    }
+}
+
+static void test_u4_constant(void **state) {
+    (void) state;
+    struct jsdrv_stream_signal_s * s = signal_init(4);
+    uint8_t p[512];
+    memset(p, 0x22, sizeof(p));
+    uint32_t size = JSDRV_STREAM_HEADER_SIZE;
+    for (int i = 0; i < 10; ++i) {
+        assert_int_equal(1024, jsdrv_stream_event_add_packed(s, &size, JSDRV_STREAM_EVENT_SIZE_MAX, p, 0, 1024));
+    }
+    assert_int_equal(10240, s->element_count);
+    assert_int_equal(1, jsdrv_stream_event_count(size));
+    assert_int_equal(0, events(s)[0].offset);
+    assert_int_equal(2, events(s)[0].value);
+
+    p[100] = 0x32;  // sample 201 = 3
+    assert_int_equal(1024, jsdrv_stream_event_add_packed(s, &size, JSDRV_STREAM_EVENT_SIZE_MAX, p, 0, 1024));
+    assert_int_equal(3, jsdrv_stream_event_count(size));
+    assert_int_equal(10240 + 201, events(s)[1].offset);
+    assert_int_equal(3, events(s)[1].value);
+    assert_int_equal(10240 + 202, events(s)[2].offset);
+    assert_int_equal(2, events(s)[2].value);
+}
+
+static void test_u8_full(void **state) {
+    (void) state;
+    struct jsdrv_stream_signal_s * s = signal_init(1);
+    uint8_t x[16];
+    for (uint32_t i = 0; i < sizeof(x); ++i) {
+        x[i] = (uint8_t) (0xfe | (i & 1));  // only the lower bit applies
+    }
+    uint32_t capacity = JSDRV_STREAM_HEADER_SIZE + 4 * sizeof(struct jsdrv_stream_event_s);
+    uint32_t size = JSDRV_STREAM_HEADER_SIZE;
+    assert_int_equal(4, jsdrv_stream_event_add_u8(s, &size, capacity, x, 16));
+    assert_int_equal(4, s->element_count);
+    assert_int_equal(4, jsdrv_stream_event_count(size));
+    assert_int_equal(3, events(s)[3].offset);
+    assert_int_equal(1, events(s)[3].value);
+
+    signal_init(1);
+    size = JSDRV_STREAM_HEADER_SIZE;
+    memset(x, 1, sizeof(x));
+    assert_int_equal(16, jsdrv_stream_event_add_u8(s, &size, capacity, x, 16));
+    assert_int_equal(1, jsdrv_stream_event_count(size));
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_u1_packed),
+            cmocka_unit_test(test_u4_constant),
+            cmocka_unit_test(test_u8_full),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
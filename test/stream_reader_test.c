@@ -0,0 +1,261 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv/stream_reader.h"
+#include "jsdrv/error_code.h"
+#include <math.h>
+#include <string.h>
+
+
+#define CONTEXT ((struct jsdrv_context_s *) 1)
+
+static const char * TOPICS[] = {"u/js220/0/s/i/!data", "u/js220/0/s/v/!data", "u/js220/0/s/i/range/!data"};
+static const uint8_t TYPES[] = {JSDRV_DATA_TYPE_FLOAT, JSDRV_DATA_TYPE_FLOAT, JSDRV_DATA_TYPE_UINT};
+
+static jsdrv_subscribe_fn cbk_fn_;
+static void * cbk_user_data_[JSDRV_STREAM_READER_CHANNELS_MAX];
+static uint32_t subscribe_count_;
+static uint32_t unsubscribe_count_;
+static int32_t subscribe_rc_;
+static uint8_t msg_[sizeof(struct jsdrv_stream_signal_s)];
+
+int32_t jsdrv_subscribe(struct jsdrv_context_s * context, const char * topic, uint8_t flags,
+        jsdrv_subscribe_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) {
+    (void) timeout_ms;
+    assert_ptr_equal(CONTEXT, context);
+    assert_string_equal(TOPICS[subscribe_count_], topic);
+    assert_int_equal(JSDRV_SFLAG_PUB, flags);
+    if (subscribe_rc_) {
+        return subscribe_rc_;
+    }
+    cbk_fn_ = cbk_fn;
+    cbk_user_data_[subscribe_count_++] = cbk_user_data;
+    return 0;
+}
+
+int32_t jsdrv_unsubscribe(struct jsdrv_context_s * context, const char * topic,
+        jsdrv_subscribe_fn cbk_fn, void * cbk_user_data, uint32_t timeout_ms) {
+    (void) topic;
+    (void) timeout_ms;
+    assert_ptr_equal(CONTEXT, context);
+    assert_ptr_equal(cbk_fn_, cbk_fn);
+    assert_ptr_equal(cbk_user_data_[unsubscribe_count_++], cbk_user_data);
+    return 0;
+}
+
+static int setup(void ** state) {
+    (void) state;
+    cbk_fn_ = NULL;
+    subscribe_count_ = 0;
+    unsubscribe_count_ = 0;
+    subscribe_rc_ = 0;
+    return 0;
+}
+
+static void publish(uint32_t channel, uint8_t app, uint32_t size) {
+    struct jsdrv_union_s v = jsdrv_union_bin(msg_, size);
+    v.app = app;
+    cbk_fn_(cbk_user_data_[channel], TOPICS[channel], &v);
+}
+
+static struct jsdrv_stream_signal_s * msg_init(uint64_t sample_id, uint8_t element_type, uint8_t bits, uint32_t count) {
+    struct jsdrv_stream_signal_s * s = (struct jsdrv_stream_signal_s *) msg_;
+    memset(s, 0, JSDRV_STREAM_HEADER_SIZE);
+    s->sample_id = sample_id;
+    s->element_type = element_type;
+    s->element_size_bits = bits;
+    s->element_count = count;
+    s->sample_rate = 1000000;
+    s->decimate_factor = 2;
+    return s;
+}
+
+static void publish_f32(uint32_t channel, uint64_t sample_id, float value_start, uint32_t count) {
+    struct jsdrv_stream_signal_s * s = msg_init(sample_id, JSDRV_DATA_TYPE_FLOAT, 32, count);
+    float * x = (float *) s->data;
+    for (uint32_t k = 0; k < count; ++k) {
+        x[k] = value_start + (float) k;
+    }
+    publish(channel, JSDRV_PAYLOAD_TYPE_STREAM, JSDRV_STREAM_HEADER_SIZE + count * sizeof(float));
+}
+
+static void test_open(void ** state) {
+    (void) state;
+    struct jsdrv_stream_reader_s * r = NULL;
+    uint8_t types[] = {JSDRV_DATA_TYPE_INT};
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_stream_reader_open(CONTEXT, TOPICS, NULL, 0, 16, &r));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_stream_reader_open(CONTEXT, TOPICS, NULL, 1, 0, &r));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_stream_reader_open(CONTEXT, TOPICS, types, 1, 16, &r));
+    subscribe_rc_ = JSDRV_ERROR_NOT_FOUND;
+    assert_int_equal(JSDRV_ERROR_NOT_FOUND, jsdrv_stream_reader_open(CONTEXT, TOPICS, NULL, 2, 16, &r));
+    assert_null(r);
+    assert_int_equal(0, unsubscribe_count_);
+
+    subscribe_rc_ = 0;
+    assert_int_equal(0, jsdrv_stream_reader_open(CONTEXT, TOPICS, NULL, 2, 16, &r));
+    assert_int_equal(2, subscribe_count_);
+    float i[4];
+    float v[4];
+    void * out[] = {i, v};
+    struct jsdrv_stream_reader_info_s info;
+    assert_int_equal(JSDRV_ERROR_TIMED_OUT, jsdrv_stream_reader_read(r, out, 4, 0, &info));
+    assert_int_equal(0, info.sample_count);
+    assert_int_equal(JSDRV_ERROR_TIMED_OUT, jsdrv_stream_reader_read(r, out, 4, 10, &info));
+    jsdrv_stream_reader_close(r);
+    assert_int_equal(2, unsubscribe_count_);
+    jsdrv_stream_reader_close(NULL);
+}
+
+static void test_align_f32(void ** state) {
+    (void) state;
+    struct jsdrv_stream_reader_s * r = NULL;
+    assert_int_equal(0, jsdrv_stream_reader_open(CONTEXT, TOPICS, NULL, 2, 100, &r));  // 128 samples
+    float i[100];
+    float v[100];
+    void * out[] = {i, v};
+    struct jsdrv_stream_reader_info_s info;
+    publish_f32(0, 1000, 0.0f, 50);      // 1000 to 1098
+    publish_f32(1, 1020, 500.0f, 30);    // 1020 to 1078
+    assert_int_equal(0, jsdrv_stream_reader_read(r, out, 20, 0, &info));
+    assert_int_equal(1020, info.sample_id);
+    assert_int_equal(2, info.decimate_factor);
+    assert_int_equal(1000000, info.sample_rate);
+    assert_int_equal(20, info.sample_count);
+    for (uint32_t k = 0; k < 20; ++k) {
+        assert_true((10.0f + k) == i[k]);
+        assert_true((500.0f + k) == v[k]);
+    }
+    assert_int_equal(JSDRV_ERROR_TIMED_OUT, jsdrv_stream_reader_read(r, out, 20, 0, &info));
+    assert_int_equal(10, info.sample_count);
+    assert_int_equal(1060, info.sample_id);
+    assert_true(30.0f == i[0]);
+
+    // wrap the ring
+    for (uint32_t k = 0; k < 4; ++k) {
+        publish_f32(0, 1100 + 100 * k, 50.0f + 50 * k, 50);
+        publish_f32(1, 1080 + 100 * k, 530.0f + 50 * k, 50);
+        assert_int_equal(0, jsdrv_stream_reader_read(r, out, 50, 0, &info));
+        assert_int_equal(1080 + 100 * k, info.sample_id);
+        for (uint32_t j = 0; j < 50; ++j) {
+            assert_true((40.0f + 50 * k + j) == i[j]);
+            assert_true((530.0f + 50 * k + j) == v[j]);
+        }
+    }
+    assert_int_equal(0, info.gap_count);
+    assert_int_equal(0, info.overrun_count);
+    jsdrv_stream_reader_close(r);
+}
+
+static void test_gap_and_overrun(void ** state) {
+    (void) state;
+    struct jsdrv_stream_reader_s * r = NULL;
+    assert_int_equal(0, jsdrv_stream_reader_open(CONTEXT, TOPICS, NULL, 1, 64, &r));
+    float i[64];
+    void * out[] = {i};
+    struct jsdrv_stream_reader_info_s info;
+    publish_f32(0, 0, 0.0f, 10);
+    publish_f32(0, 40, 20.0f, 10);          // 10 sample gap
+    publish_f32(0, 50, 25.0f, 10);          // 5 duplicates
+    assert_int_equal(0, jsdrv_stream_reader_read(r, out, 30, 0, &info));
+    assert_int_equal(10, info.gap_count);
+    assert_true(9.0f == i[9]);
+    assert_true(isnan(i[10]));
+    assert_true(isnan(i[19]));
+    assert_true(20.0f == i[20]);
+    assert_true(29.0f == i[29]);
+
+    publish_f32(0, 70, 35.0f, 50);
+    publish_f32(0, 170, 85.0f, 50);         // 9 fit
+    assert_int_equal(0, jsdrv_stream_reader_read(r, out, 64, 0, &info));
+    assert_int_equal(41, info.overrun_count);
+    assert_int_equal(0, info.gap_count);
+    assert_true(30.0f == i[0]);
+    assert_true(93.0f == i[63]);
+    publish_f32(0, 270, 135.0f, 20);        // first refill the 41 dropped samples
+    assert_int_equal(0, jsdrv_stream_reader_read(r, out, 56, 0, &info));
+    assert_int_equal(41, info.gap_count);
+    assert_int_equal(188, info.sample_id);
+    assert_true(isnan(i[40]));
+    assert_true(135.0f == i[41]);
+    jsdrv_stream_reader_close(r);
+}
+
+static void test_read_exceeds_capacity(void ** state) {
+    (void) state;
+    struct jsdrv_stream_reader_s * r = NULL;
+    assert_int_equal(0, jsdrv_stream_reader_open(CONTEXT, TOPICS, NULL, 1, 100, &r));  // 128 samples
+    float i[129];
+    void * out[] = {i};
+    struct jsdrv_stream_reader_info_s info;
+    publish_f32(0, 0, 0.0f, 100);
+    publish_f32(0, 200, 100.0f, 28);
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_stream_reader_read(r, out, 129, 1000, &info));
+    assert_int_equal(0, jsdrv_stream_reader_read(r, out, 128, 0, &info));
+    assert_int_equal(128, info.sample_count);
+    assert_true(127.0f == i[127]);
+    jsdrv_stream_reader_close(r);
+}
+
+static void test_uint(void ** state) {
+    (void) state;
+    struct jsdrv_stream_reader_s * r = NULL;
+    assert_int_equal(0, jsdrv_stream_reader_open(CONTEXT, TOPICS, TYPES, 3, 64, &r));
+    float i[32];
+    float v[32];
+    uint8_t range[32];
+    void * out[] = {i, v, range};
+    struct jsdrv_stream_reader_info_s info;
+    publish_f32(0, 0, 0.0f, 32);
+    publish_f32(1, 0, 0.0f, 32);
+    struct jsdrv_stream_signal_s * s = msg_init(0, JSDRV_DATA_TYPE_UINT, 4, 16);
+    for (uint32_t k = 0; k < 8; ++k) {
+        s->data[k] = (uint8_t) (((2 * k + 1) << 4) | (2 * k));
+    }
+    publish(2, JSDRV_PAYLOAD_TYPE_STREAM, JSDRV_STREAM_HEADER_SIZE + 8);
+    s = msg_init(32, JSDRV_DATA_TYPE_UINT, 4, 16);  // events
+    struct jsdrv_stream_event_s * e = (struct jsdrv_stream_event_s *) s->data;
+    e[0].offset = 0;
+    e[0].value = 3;
+    e[1].offset = 10;
+    e[1].value = 5;
+    publish(2, JSDRV_PAYLOAD_TYPE_STREAM_EVENT, JSDRV_STREAM_HEADER_SIZE + 2 * sizeof(*e));
+    s = msg_init(64, JSDRV_DATA_TYPE_FLOAT, 32, 4);  // wrong type
+    publish(2, JSDRV_PAYLOAD_TYPE_STREAM, JSDRV_STREAM_HEADER_SIZE + 16);
+
+    assert_int_equal(0, jsdrv_stream_reader_read(r, out, 32, 0, &info));
+    assert_int_equal(4, info.overrun_count);
+    for (uint32_t k = 0; k < 16; ++k) {
+        assert_int_equal(k, range[k]);
+        assert_int_equal((k < 10) ? 3 : 5, range[16 + k]);
+    }
+    jsdrv_stream_reader_close(r);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test_setup(test_open, setup),
+            cmocka_unit_test_setup(test_align_f32, setup),
+            cmocka_unit_test_setup(test_gap_and_overrun, setup),
+            cmocka_unit_test_setup(test_read_exceeds_capacity, setup),
+            cmocka_unit_test_setup(test_uint, setup),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
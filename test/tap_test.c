@@ -0,0 +1,115 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/tap.h"
+#include "jsdrv_prv/downsample.h"
+#include "jsdrv/error_code.h"
+#include <string.h>
+
+#define FS (2000000U)
+
+
+static void test_param(void **state) {
+    (void) state;
+    uint32_t fs[JSDRV_TAP_COUNT] = {0, 0};
+    assert_int_equal(0, jsdrv_tap_param(fs, "h/tap/0/fs", &jsdrv_union_u32(1000)));
+    assert_int_equal(1000, fs[0]);
+    assert_int_equal(0, jsdrv_tap_param(fs, "h/tap/1/fs", &jsdrv_union_u32(10)));
+    assert_int_equal(10, fs[1]);
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_tap_param(fs, "h/tap/2/fs", &jsdrv_union_u32(1)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_tap_param(fs, "h/tap/0/rate", &jsdrv_union_u32(1)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_tap_param(fs, "h/tap/0/fs", &jsdrv_union_cstr("x")));
+}
+
+static void test_configure(void **state) {
+    (void) state;
+    struct jsdrv_tap_s tap;
+    jsdrv_tap_initialize(&tap);
+    assert_int_equal(0, jsdrv_tap_configure(&tap, FS, 0, JSDRV_DOWNSAMPLE_MODE_AVERAGE, 2));
+    assert_int_equal(2000, jsdrv_tap_configure(&tap, FS, 1000, JSDRV_DOWNSAMPLE_MODE_AVERAGE, 2));
+    assert_int_equal(2000, jsdrv_tap_configure(&tap, FS, 1000, JSDRV_DOWNSAMPLE_MODE_FLAT_PASSBAND, 20));
+    assert_int_equal(0, jsdrv_tap_configure(&tap, FS, 3000, JSDRV_DOWNSAMPLE_MODE_AVERAGE, 2));  // not a divisor
+    assert_int_equal(0, jsdrv_tap_configure(&tap, FS, 500000, JSDRV_DOWNSAMPLE_MODE_AVERAGE, 20));  // above input
+    jsdrv_tap_finalize(&tap);
+    assert_int_equal(0, tap.fs);
+}
+
+static void test_process_matches_downsample(void **state) {
+    (void) state;
+    float x[1000];
+    float y[1000];
+    float y_ref[1000];
+    struct jsdrv_tap_s tap;
+    jsdrv_tap_initialize(&tap);
+    struct jsdrv_downsample_s * ds = jsdrv_downsample_alloc(100000, 1000, JSDRV_DOWNSAMPLE_MODE_AVERAGE);
+    assert_int_equal(2000, jsdrv_tap_configure(&tap, FS, 1000, JSDRV_DOWNSAMPLE_MODE_AVERAGE, 20));
+
+    uint64_t idx = 1234;  // unaligned start at 100 kHz
+    uint32_t n_ref_total = 0;
+    uint32_t n_total = 0;
+    uint64_t sample_id_next = 0;
+    for (uint32_t block = 0; block < 10; ++block) {
+        for (uint32_t k = 0; k < 1000; ++k) {
+            x[k] = (float) ((idx + k) % 300);
+        }
+        uint32_t n_ref = 0;
+        jsdrv_downsample_add_f32_block(ds, idx, x, 1000, y_ref, &n_ref);
+        uint64_t y_sample_id = 0;
+        uint32_t n = jsdrv_tap_process(&tap, idx * 20 + 7, x, 1000, y, &y_sample_id);
+        assert_int_equal(n_ref, n);
+        assert_memory_equal(y_ref, y, n * sizeof(float));
+        if (n) {
+            assert_int_equal(7, y_sample_id % 20);
+            assert_int_equal(99, (y_sample_id / 20) % 100);  // completes each 100 sample window
+            if (n_total) {
+                assert_int_equal(sample_id_next, y_sample_id);
+            }
+            sample_id_next = y_sample_id + (uint64_t) n * 2000;
+        }
+        n_ref_total += n_ref;
+        n_total += n;
+        idx += 1000;
+    }
+    assert_int_equal(n_ref_total, n_total);
+    assert_true(n_total > 90);
+
+    // a discontinuity restarts aligned
+    uint64_t y_sample_id = 0;
+    for (uint32_t k = 0; k < 1000; ++k) {
+        x[k] = 1.0f;
+    }
+    assert_int_equal(11234, idx);
+    assert_int_equal(9, jsdrv_tap_process(&tap, 11284 * 20, x, 1000, y, &y_sample_id));
+    assert_int_equal((11300 + 99) * 20, y_sample_id);
+    assert_true(1.0f == y[0]);
+
+    jsdrv_downsample_free(ds);
+    jsdrv_tap_finalize(&tap);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_param),
+            cmocka_unit_test(test_configure),
+            cmocka_unit_test(test_process_matches_downsample),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // pthread_getaffinity_np
+#endif
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include "jsdrv_prv/thread.h"
+#include "jsdrv_prv/atomic.h"
+#include "jsdrv/error_code.h"
+#if defined(__linux__)
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+#define ROLE JSDRV_THREAD_ROLE_WRITER
+
+struct worker_s {
+    jsdrv_thread_t thread;
+    volatile int32_t registered;
+    volatile int32_t do_exit;
+    int32_t tid;
+};
+
+static THREAD_RETURN_TYPE worker_thread(THREAD_ARG_TYPE arg) {
+    struct worker_s * w = (struct worker_s *) arg;
+    jsdrv_thread_register(ROLE);
+#if defined(__linux__)
+    w->tid = (int32_t) syscall(SYS_gettid);
+#endif
+    jsdrv_atomic_store(&w->registered, 1);
+    while (!jsdrv_atomic_load(&w->do_exit)) {
+        jsdrv_thread_sleep_ms(1);
+    }
+    jsdrv_thread_unregister();
+    THREAD_RETURN();
+}
+
+static void worker_start(struct worker_s * w) {
+    memset(w, 0, sizeof(*w));
+    assert_int_equal(0, jsdrv_thread_create(&w->thread, worker_thread, w, 0));
+    while (!jsdrv_atomic_load(&w->registered)) {
+        jsdrv_thread_sleep_ms(1);
+    }
+}
+
+static void worker_stop(struct worker_s * w) {
+    jsdrv_atomic_store(&w->do_exit, 1);
+    assert_int_equal(0, jsdrv_thread_join(&w->thread, 1000));
+}
+
+static void assert_policy(struct worker_s * w, int nice, int cpu) {
+#if defined(__linux__)
+    cpu_set_t cpuset;
+    errno = 0;
+    assert_int_equal(nice, getpriority(PRIO_PROCESS, (id_t) w->tid));
+    assert_int_equal(0, pthread_getaffinity_np(w->thread, sizeof(cpuset), &cpuset));
+    assert_int_equal(1, CPU_COUNT(&cpuset));
+    assert_true(CPU_ISSET(cpu, &cpuset));
+#else
+    (void) w;
+    (void) nice;
+    (void) cpu;
+#endif
+}
+
+static int cpu_first(void) {
+#if defined(__linux__)
+    cpu_set_t cpuset;
+    assert_int_equal(0, sched_getaffinity(0, sizeof(cpuset), &cpuset));
+    for (int cpu = 0; cpu < 64; ++cpu) {
+        if (CPU_ISSET(cpu, &cpuset)) {
+            return cpu;
+        }
+    }
+#endif
+    return 0;
+}
+
+static void test_invalid(void ** state) {
+    (void) state;
+    struct jsdrv_thread_policy_s p = {.sched = JSDRV_THREAD_SCHED_DEFAULT, .priority = 0, .affinity = 0};
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_thread_policy_set(JSDRV_THREAD_ROLE_COUNT, &p));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_thread_policy_get(JSDRV_THREAD_ROLE_COUNT, &p));
+    p.sched = JSDRV_THREAD_SCHED_RR + 1;
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_thread_policy_set(ROLE, &p));
+    p.sched = JSDRV_THREAD_SCHED_OTHER;
+    p.priority = 20;
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_thread_policy_set(ROLE, &p));
+    p.sched = JSDRV_THREAD_SCHED_FIFO;
+    p.priority = 0;
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_thread_policy_set(ROLE, &p));
+    assert_int_equal(0, jsdrv_thread_policy_get(ROLE, &p));
+    assert_int_equal(JSDRV_THREAD_SCHED_DEFAULT, p.sched);
+    assert_non_null(jsdrv_thread_role_name(JSDRV_THREAD_ROLE_USB));
+    assert_null(jsdrv_thread_role_name(JSDRV_THREAD_ROLE_COUNT));
+}
+
+static void test_register(void ** state) {
+    (void) state;
+    struct worker_s w1;
+    struct worker_s w2;
+    int cpu = cpu_first();
+    struct jsdrv_thread_policy_s p = {.sched = JSDRV_THREAD_SCHED_OTHER, .priority = 5, .affinity = 1ULL << cpu};
+    assert_int_equal(0, jsdrv_thread_role_count(ROLE));
+    worker_start(&w1);
+    assert_int_equal(1, jsdrv_thread_role_count(ROLE));
+
+    // applies to registered threads, raising nice needs no privileges
+    assert_int_equal(0, jsdrv_thread_policy_set(ROLE, &p));
+    assert_policy(&w1, 5, cpu);
+
+    // and to threads registered later
+    worker_start(&w2);
+    assert_int_equal(2, jsdrv_thread_role_count(ROLE));
+    assert_policy(&w2, 5, cpu);
+
+    worker_stop(&w1);
+    worker_stop(&w2);
+    assert_int_equal(0, jsdrv_thread_role_count(ROLE));
+    memset(&p, 0, sizeof(p));
+    assert_int_equal(0, jsdrv_thread_policy_set(ROLE, &p));
+}
+
+static void test_cpu(void ** state) {
+    (void) state;
+    struct worker_s w;
+    struct jsdrv_thread_cpu_s cpu[8];
+    uint32_t count = jsdrv_thread_cpu_get(cpu, 8);
+    for (uint32_t i = 0; i < count; ++i) {
+        assert_int_not_equal(ROLE, cpu[i].role);
+    }
+    worker_start(&w);
+    count = jsdrv_thread_cpu_get(cpu, 8);
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (ROLE == cpu[i].role) {
+            ++found;
+#if defined(__linux__)
+            assert_int_equal(w.tid, cpu[i].id);
+            assert_true(cpu[i].cpu_time >= 0);
+#endif
+        }
+    }
+    assert_int_equal(1, found);
+    assert_int_equal(0, jsdrv_thread_cpu_get(cpu, 0));
+    worker_stop(&w);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_invalid),
+            cmocka_unit_test(test_register),
+            cmocka_unit_test(test_cpu),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
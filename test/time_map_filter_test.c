@@ -64,12 +64,74 @@ static void test_add_multiple(void **state) {
     jsdrv_tmf_free(t);
 }
 
+static uint32_t lcg_next(uint32_t * state) {
+    *state = (*state * 1664525U) + 1013904223U;
+    return *state;
+}
+
+static void test_sliding_minimum(void **state) {
+    (void) state;
+    const uint32_t points = 16;
+    struct jsdrv_time_map_s tm;
+    uint64_t counters[200];
+    int64_t utcs[200];
+    uint32_t lcg = 5;
+    struct jsdrv_tmf_s * t = jsdrv_tmf_new(FREQ, points, JSDRV_TIME_SECOND);
+    assert_non_null(t);
+    for (uint32_t k = 0; k < 200; ++k) {
+        counters[k] = (60 + 2 * k) * FREQ + (lcg_next(&lcg) >> 20);
+        utcs[k] = (60 + 2 * k) * JSDRV_TIME_SECOND + (int64_t) (lcg_next(&lcg) >> 12);  // latency jitter
+        jsdrv_tmf_add(t, counters[k], utcs[k]);
+        jsdrv_tmf_get(t, &tm);
+
+        // brute force reference over the window
+        uint32_t first = (k >= points) ? (k - points + 1) : 0;
+        int64_t expect = utcs[first];
+        for (uint32_t n = first; n <= k; ++n) {
+            int64_t est = utcs[n] - JSDRV_COUNTER_TO_TIME(counters[n] - counters[first], FREQ);
+            if (est < expect) {
+                expect = est;
+            }
+        }
+        assert_int_equal(counters[first], tm.offset_counter);
+        int64_t err = tm.offset_time - expect;
+        assert_true((err >= -2) && (err <= 2));  // rounding only
+        assert_int_equal(FREQ, tm.counter_rate);
+    }
+    jsdrv_tmf_free(t);
+}
+
+static void test_drift(void **state) {
+    (void) state;
+    struct jsdrv_time_map_s tm;
+    const double rate = FREQ * (1.0 + 50e-6);  // 50 ppm fast
+    struct jsdrv_tmf_s * t = jsdrv_tmf_new(FREQ, 60, JSDRV_TIME_SECOND);
+    assert_non_null(t);
+    jsdrv_tmf_drift_set(t, true);
+    for (uint32_t k = 0; k < 300; ++k) {
+        jsdrv_tmf_add(t, (uint64_t) (k * rate), (60 + k) * JSDRV_TIME_SECOND);
+    }
+    jsdrv_tmf_get(t, &tm);
+    assert_float_equal(rate, tm.counter_rate, 0.01);
+    // map the newest point back to UTC
+    int64_t utc = tm.offset_time + (int64_t) ((299 * rate - (double) tm.offset_counter)
+            / tm.counter_rate * JSDRV_TIME_SECOND);
+    int64_t err = utc - (60 + 299) * JSDRV_TIME_SECOND;
+    assert_true((err > -JSDRV_TIME_MICROSECOND) && (err < JSDRV_TIME_MICROSECOND));
+
+    jsdrv_tmf_drift_set(t, false);
+    jsdrv_tmf_get(t, &tm);
+    assert_int_equal(FREQ, tm.counter_rate);
+    jsdrv_tmf_free(t);
+}
 
 int main(void) {
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_new_free),
             cmocka_unit_test(test_add_one),
             cmocka_unit_test(test_add_multiple),
+            cmocka_unit_test(test_sliding_minimum),
+            cmocka_unit_test(test_drift),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -183,6 +183,39 @@ static void test_counter(void **state) {
     assert_int_equal(OFFSET1 - FS1, jsdrv_time_to_counter(&tmap, JSDRV_TIME_HOUR - JSDRV_TIME_SECOND));
 }
 
+static void range_check(const struct jsdrv_time_map_s * tmap, uint64_t counter, uint32_t incr) {
+    int64_t t[67];
+    double f[67];
+    jsdrv_time_from_counter_range(tmap, counter, incr, t, 67);
+    jsdrv_time_from_counter_range_f64(tmap, counter, incr, f, 67);
+    for (uint32_t k = 0; k < 67; ++k) {
+        int64_t expect = jsdrv_time_from_counter(tmap, counter + k * (uint64_t) incr);
+        assert_int_equal(expect, t[k]);
+        assert_true(JSDRV_TIME_TO_F64(expect) == f[k]);
+    }
+}
+
+static void test_counter_range(void **state) {
+    (void) state;
+    struct jsdrv_time_map_s tmap = {
+        .offset_time = JSDRV_TIME_HOUR,
+        .offset_counter = 1000000000ULL,
+        .counter_rate = 1000000.0,
+    };
+    range_check(&tmap, tmap.offset_counter, 1);
+    range_check(&tmap, tmap.offset_counter - 30, 2);    // negative to positive delta
+    range_check(&tmap, 123456789012ULL, 7);
+    tmap.counter_rate = 999999.7;                       // inexact scale
+    range_check(&tmap, 123456789012ULL, 1);
+    tmap.counter_rate = 2.0 * JSDRV_TIME_SECOND;        // x.5 ties round away from zero
+    range_check(&tmap, tmap.offset_counter - 33, 1);
+    tmap.counter_rate = 1.0;                            // beyond the SIMD range
+    range_check(&tmap, tmap.offset_counter + (1ULL << 30), 3);
+    int64_t t = 5;
+    jsdrv_time_from_counter_range(&tmap, 0, 1, &t, 0);
+    assert_int_equal(5, t);
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_constants),
@@ -199,6 +232,7 @@ int main(void) {
             cmocka_unit_test(test_str),
             cmocka_unit_test(test_counter_trivial),
             cmocka_unit_test(test_counter),
+            cmocka_unit_test(test_counter_range),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/topic_index.h"
+
+
+struct entry_s {
+    uint32_t value;
+    const char * topic;
+};
+
+static const struct entry_s TABLE[] = {
+    {0, "s/i/range/select"},
+    {1, "s/v/range/select"},
+    {2, NULL},
+    {3, "s/extio/voltage"},
+    {4, "s/gpo/0/value"},
+    {5, "s/i/range/mode"},
+    {6, "a"},
+    {7, "s/i/range"},
+};
+
+#define COUNT ((uint16_t) (sizeof(TABLE) / sizeof(TABLE[0])))
+
+static void test_find(void **state) {
+    (void) state;
+    struct jsdrv_topic_index_s index;
+    uint16_t idx[COUNT];
+    jsdrv_topic_index_init(&index, TABLE, sizeof(TABLE[0]), offsetof(struct entry_s, topic), COUNT, idx);
+    assert_int_equal(COUNT - 1, index.count);
+    for (uint16_t i = 0; i < COUNT; ++i) {
+        if (TABLE[i].topic) {
+            assert_int_equal(i, jsdrv_topic_index_find(&index, TABLE[i].topic));
+        }
+    }
+    assert_int_equal(-1, jsdrv_topic_index_find(&index, "s/i/range/"));
+    assert_int_equal(-1, jsdrv_topic_index_find(&index, "s/i/rang"));
+    assert_int_equal(-1, jsdrv_topic_index_find(&index, ""));
+    assert_int_equal(-1, jsdrv_topic_index_find(&index, "z"));
+    assert_int_equal(-1, jsdrv_topic_index_find(&index, NULL));
+}
+
+static void test_empty(void **state) {
+    (void) state;
+    struct jsdrv_topic_index_s index;
+    uint16_t idx[1];
+    jsdrv_topic_index_init(&index, TABLE, sizeof(TABLE[0]), offsetof(struct entry_s, topic), 0, idx);
+    assert_int_equal(-1, jsdrv_topic_index_find(&index, "a"));
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_find),
+            cmocka_unit_test(test_empty),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -135,6 +135,29 @@ static void test_remove(void **state) {
 
 JSDRV_API int32_t jsdrv_topic_remove(struct jsdrv_topic_s * topic);
 
+static void test_match(void **state) {
+    (void) state;
+    assert_false(jsdrv_topic_is_wildcard("u/js220/000415/s/i/!data"));
+    assert_false(jsdrv_topic_is_wildcard("u/js+220/a#"));
+    assert_true(jsdrv_topic_is_wildcard("u/+/+/s/+/!data"));
+    assert_true(jsdrv_topic_is_wildcard("+"));
+    assert_true(jsdrv_topic_is_wildcard("u/#"));
+
+    assert_true(jsdrv_topic_match("u/+/+/s/+/!data", "u/js220/000415/s/i/!data"));
+    assert_false(jsdrv_topic_match("u/+/+/s/+/!data", "u/js220/000415/s/i/range/!data"));
+    assert_false(jsdrv_topic_match("u/+/+/s/+/!data", "u/js220/000415/s/i"));
+    assert_false(jsdrv_topic_match("u/+/+/s/+/!data", "u/js220/000415/h/i/!data"));
+    assert_true(jsdrv_topic_match("u/+/+/s/i/!data", "u/js110/1/s/i/!data"));
+    assert_false(jsdrv_topic_match("u/+", "u"));
+    assert_true(jsdrv_topic_match("u/#", "u"));
+    assert_true(jsdrv_topic_match("u/#", "u/js220/000415/s/i/!data"));
+    assert_false(jsdrv_topic_match("u/#", "up/js220"));
+    assert_true(jsdrv_topic_match("#", "u/js220"));
+    assert_true(jsdrv_topic_match("+/js220/#", "u/js220/000415"));
+    assert_false(jsdrv_topic_match("u/js22", "u/js220"));
+    assert_false(jsdrv_topic_match("u/js220", "u/js22"));
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
             cmocka_unit_test(test_append),
@@ -144,6 +167,7 @@ int main(void) {
             cmocka_unit_test(test_suffix_add),
             cmocka_unit_test(test_suffix_remove),
             cmocka_unit_test(test_remove),
+            cmocka_unit_test(test_match),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
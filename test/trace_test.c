@@ -0,0 +1,137 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "jsdrv_prv/trace.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv/error_code.h"
+
+
+#define PATH "trace_test.json"
+
+static char * file_read(const char * path) {
+    FILE * f = fopen(path, "rb");
+    assert_non_null(f);
+    fseek(f, 0, SEEK_END);
+    long sz = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char * s = malloc(sz + 1);
+    assert_int_equal(sz, fread(s, 1, sz, f));
+    s[sz] = 0;
+    fclose(f);
+    return s;
+}
+
+static void span(const char * name, uint64_t arg) {
+    JSDRV_TRACE_START(t_start);
+    JSDRV_TRACE_END(name, t_start, arg);
+}
+
+static void test_inactive(void ** state) {
+    (void) state;
+    span("skip", 0);
+    assert_false(jsdrv_trace_is_active());
+    assert_int_equal(0, jsdrv_trace_start(16));
+    jsdrv_trace_stop();
+    span("skip", 0);
+    assert_int_equal(0, jsdrv_trace_event_count());
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_trace_start(JSDRV_TRACE_EVENTS_MAX + 1));
+}
+
+static void test_write(void ** state) {
+    (void) state;
+    assert_int_equal(0, jsdrv_trace_start(0));
+    span("alpha", 1);
+    span("beta", 2);
+    span("alpha", 3);
+    assert_int_equal(3, jsdrv_trace_event_count());
+    assert_int_equal(JSDRV_ERROR_BUSY, jsdrv_trace_write(PATH));
+    jsdrv_trace_stop();
+    assert_int_equal(0, jsdrv_trace_write(PATH));
+    char * s = file_read(PATH);
+    assert_non_null(strstr(s, "\"traceEvents\":["));
+    assert_non_null(strstr(s, "\"args\":{\"name\":\"thread."));  // unregistered thread
+    assert_non_null(strstr(s, "\"name\":\"beta\",\"ph\":\"X\""));
+    assert_non_null(strstr(s, "\"args\":{\"n\":3}"));
+    free(s);
+    remove(PATH);
+}
+
+static void test_wrap(void ** state) {
+    (void) state;
+    assert_int_equal(0, jsdrv_trace_start(3));  // rounds up to 4
+    for (uint64_t i = 0; i < 10; ++i) {
+        span("wrap", i);
+    }
+    jsdrv_trace_stop();
+    assert_int_equal(3, jsdrv_trace_event_count());  // keeps the most recent, but the oldest
+    assert_int_equal(0, jsdrv_trace_write(PATH));
+    char * s = file_read(PATH);
+    assert_null(strstr(s, "\"n\":6}"));
+    assert_non_null(strstr(s, "\"n\":7}"));
+    assert_non_null(strstr(s, "\"n\":9}"));
+    free(s);
+    remove(PATH);
+}
+
+static THREAD_RETURN_TYPE usb_thread(THREAD_ARG_TYPE lpParam) {
+    (void) lpParam;
+    jsdrv_thread_register(JSDRV_THREAD_ROLE_USB);
+    span("usb_events", 0);
+    span("usb_events", 0);
+    jsdrv_thread_unregister();
+    THREAD_RETURN();
+}
+
+static void test_exited_thread(void ** state) {
+    (void) state;
+    jsdrv_thread_t thread;
+    assert_int_equal(0, jsdrv_trace_start(0));
+    assert_int_equal(0, jsdrv_thread_create(&thread, usb_thread, NULL, 0));
+    assert_int_equal(0, jsdrv_thread_join(&thread, 1000));
+    span("main", 0);
+    jsdrv_trace_stop();
+    assert_int_equal(3, jsdrv_trace_event_count());
+    assert_int_equal(0, jsdrv_trace_write(PATH));
+    char * s = file_read(PATH);
+    assert_non_null(strstr(s, "\"args\":{\"name\":\"usb."));
+    assert_non_null(strstr(s, "\"name\":\"usb_events\""));
+    free(s);
+    remove(PATH);
+
+    jsdrv_trace_release();
+    assert_int_equal(1, jsdrv_trace_event_count());  // only the running thread remains
+    assert_int_equal(0, jsdrv_trace_start(0));
+    jsdrv_trace_stop();
+    assert_int_equal(0, jsdrv_trace_event_count());
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_inactive),
+            cmocka_unit_test(test_write),
+            cmocka_unit_test(test_wrap),
+            cmocka_unit_test(test_exited_thread),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/trigger.h"
+#include "jsdrv_prv/buffer.h"
+#include "jsdrv/error_code.h"
+#include <math.h>
+#include <string.h>
+
+#define FS (2000000U)
+
+
+struct match_s {
+    uint32_t count;
+    uint64_t sample_id[16];
+    uint8_t edge[16];
+};
+
+static void add_f32(struct jsdrv_trigger_s * t, uint64_t sample_id, const float * x, uint32_t n,
+                    struct match_s * m) {
+    struct jsdrv_trigger_event_s * event = NULL;
+    uint32_t k = 0;
+    while (k < n) {
+        k += jsdrv_trigger_add_f32(t, sample_id + k, FS, 1, x + k, n - k, &event);
+        if (event) {
+            assert_true(m->count < 16);
+            m->sample_id[m->count] = event->sample_id;
+            m->edge[m->count] = event->edge;
+            ++m->count;
+        }
+    }
+}
+
+static void config(struct jsdrv_trigger_s * t, uint8_t edge, float level, float hyst, float dur) {
+    jsdrv_trigger_initialize(t, 0);
+    assert_int_equal(0, jsdrv_trigger_param(t, "h/trig/0/source", &jsdrv_union_u8(JSDRV_TRIGGER_SOURCE_CURRENT)));
+    assert_int_equal(0, jsdrv_trigger_param(t, "h/trig/0/edge", &jsdrv_union_u8(edge)));
+    assert_int_equal(0, jsdrv_trigger_param(t, "h/trig/0/level", &jsdrv_union_f32(level)));
+    assert_int_equal(0, jsdrv_trigger_param(t, "h/trig/0/hyst", &jsdrv_union_f32(hyst)));
+    assert_int_equal(0, jsdrv_trigger_param(t, "h/trig/0/dur", &jsdrv_union_f64(dur)));
+}
+
+static void test_param(void **state) {
+    (void) state;
+    struct jsdrv_trigger_s t[JSDRV_TRIGGER_COUNT];
+    for (uint32_t i = 0; i < JSDRV_TRIGGER_COUNT; ++i) {
+        jsdrv_trigger_initialize(&t[i], (uint8_t) i);
+    }
+    assert_int_equal(0, jsdrv_trigger_param(t, "h/trig/3/source", &jsdrv_union_u32(2)));
+    assert_int_equal(JSDRV_TRIGGER_SOURCE_VOLTAGE, t[3].source);
+    assert_int_equal(0, jsdrv_trigger_param(t, "h/trig/3/snap", &jsdrv_union_u8(JSDRV_BUFFER_COUNT_MAX)));
+    assert_int_equal(JSDRV_BUFFER_COUNT_MAX, t[3].snap);
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_trigger_param(t, "h/trig/4/source", &jsdrv_union_u8(1)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_trigger_param(t, "h/trig/0/source", &jsdrv_union_u8(6)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_trigger_param(t, "h/trig/0/edge", &jsdrv_union_u8(3)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_trigger_param(t, "h/trig/0/snap", &jsdrv_union_u8(JSDRV_BUFFER_COUNT_MAX + 1)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_trigger_param(t, "h/trig/0/hyst", &jsdrv_union_f32(-1.0f)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_trigger_param(t, "h/trig/0/level", &jsdrv_union_f32(NAN)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_trigger_param(t, "h/trig/0/other", &jsdrv_union_u8(0)));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_trigger_param(t, "h/trig/00/source", &jsdrv_union_u8(0)));
+    for (uint8_t field = 0; field < JSDRV_TRIGGER_FIELD_COUNT; ++field) {
+        assert_true(strlen(jsdrv_trigger_field_name(field)) <= 7);
+        assert_non_null(jsdrv_trigger_field_meta(field));
+    }
+    assert_null(jsdrv_trigger_field_name(JSDRV_TRIGGER_FIELD_COUNT));
+}
+
+static void test_rising(void **state) {
+    (void) state;
+    struct jsdrv_trigger_s t;
+    struct match_s m;
+    memset(&m, 0, sizeof(m));
+    float x[] = {1.0f, 0.0f, 0.2f, 0.6f, 0.4f, 0.6f, 0.0f, 0.5f, 1.0f};
+    config(&t, JSDRV_TRIGGER_EDGE_RISING, 0.5f, 0.0f, 0.0f);
+    add_f32(&t, 100, x, 9, &m);  // first sample establishes the state
+    assert_int_equal(3, m.count);
+    assert_int_equal(103, m.sample_id[0]);
+    assert_int_equal(105, m.sample_id[1]);
+    assert_int_equal(107, m.sample_id[2]);
+    assert_int_equal(JSDRV_TRIGGER_EDGE_RISING, m.edge[0]);
+}
+
+static void test_hysteresis(void **state) {
+    (void) state;
+    struct jsdrv_trigger_s t;
+    struct match_s m;
+    memset(&m, 0, sizeof(m));
+    float x[] = {0.0f, 0.6f, 0.47f, 0.6f, 0.35f, 0.6f, 0.65f, 0.2f};
+    config(&t, JSDRV_TRIGGER_EDGE_RISING, 0.5f, 0.1f, 0.0f);
+    add_f32(&t, 0, x, 8, &m);
+    assert_int_equal(2, m.count);
+    assert_int_equal(1, m.sample_id[0]);
+    assert_int_equal(5, m.sample_id[1]);
+
+    memset(&m, 0, sizeof(m));
+    config(&t, JSDRV_TRIGGER_EDGE_FALLING, 0.5f, 0.1f, 0.0f);
+    add_f32(&t, 0, x, 8, &m);
+    assert_int_equal(3, m.count);
+    assert_int_equal(2, m.sample_id[0]);
+    assert_int_equal(4, m.sample_id[1]);
+    assert_int_equal(7, m.sample_id[2]);
+    assert_int_equal(JSDRV_TRIGGER_EDGE_FALLING, m.edge[0]);
+
+    memset(&m, 0, sizeof(m));
+    config(&t, JSDRV_TRIGGER_EDGE_BOTH, 0.5f, 0.1f, 0.0f);
+    add_f32(&t, 0, x, 8, &m);
+    assert_int_equal(4, m.count);  // 0.47 stays within [0.45, 0.55)
+    assert_int_equal(1, m.sample_id[0]);
+    assert_int_equal(4, m.sample_id[1]);
+    assert_int_equal(5, m.sample_id[2]);
+    assert_int_equal(7, m.sample_id[3]);
+    assert_int_equal(JSDRV_TRIGGER_EDGE_FALLING, m.edge[1]);
+}
+
+static void test_duration(void **state) {
+    (void) state;
+    struct jsdrv_trigger_s t;
+    struct match_s m;
+    float x[64];
+    memset(&m, 0, sizeof(m));
+    for (uint32_t i = 0; i < 64; ++i) {
+        x[i] = ((i >= 10) && (i < 13)) || (i >= 20) ? 1.0f : 0.0f;
+    }
+    config(&t, JSDRV_TRIGGER_EDGE_RISING, 0.5f, 0.0f, 4.0f / FS);
+    add_f32(&t, 0, x, 16, &m);  // 3 samples high, too short
+    assert_int_equal(0, m.count);
+    add_f32(&t, 16, x + 16, 6, &m);  // match spans the calls
+    assert_int_equal(0, m.count);
+    add_f32(&t, 22, x + 22, 42, &m);
+    assert_int_equal(1, m.count);
+    assert_int_equal(20, m.sample_id[0]);
+}
+
+static void test_discontinuity_nan(void **state) {
+    (void) state;
+    struct jsdrv_trigger_s t;
+    struct match_s m;
+    memset(&m, 0, sizeof(m));
+    float lo[] = {0.0f, NAN, 0.0f};
+    float hi[] = {1.0f, 1.0f};
+    config(&t, JSDRV_TRIGGER_EDGE_RISING, 0.5f, 0.0f, 0.0f);
+    add_f32(&t, 0, lo, 3, &m);
+    add_f32(&t, 1000, hi, 2, &m);  // skip clears the state
+    assert_int_equal(0, m.count);
+    add_f32(&t, 2, lo, 3, &m);
+    add_f32(&t, 5, hi, 2, &m);
+    assert_int_equal(1, m.count);
+}
+
+static void test_u8(void **state) {
+    (void) state;
+    struct jsdrv_trigger_s t;
+    struct jsdrv_trigger_event_s * event = NULL;
+    uint8_t x[] = {0, 0, 1, 1, 0};
+    config(&t, JSDRV_TRIGGER_EDGE_FALLING, 0.5f, 0.0f, 0.0f);
+    assert_int_equal(5, jsdrv_trigger_add_u8(&t, 10, FS, 2, x, 5, &event));
+    assert_non_null(event);
+    assert_int_equal(18, event->sample_id);
+    assert_int_equal(2, event->decimate_factor);
+    assert_int_equal(FS, event->sample_rate);
+    assert_int_equal(JSDRV_TRIGGER_SOURCE_CURRENT, event->source);
+    assert_true(0.0f == event->value);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_param),
+            cmocka_unit_test(test_rising),
+            cmocka_unit_test(test_hysteresis),
+            cmocka_unit_test(test_duration),
+            cmocka_unit_test(test_discontinuity_nan),
+            cmocka_unit_test(test_u8),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
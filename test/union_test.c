@@ -135,6 +135,24 @@ static void test_eq_exact(void ** state) {
     assert_false(jsdrv_union_eq_exact(&v1, &v2));
 }
 
+static void test_eq_bounded(void ** state) {
+    (void) state;
+    uint8_t b1[16];
+    uint8_t b2[16];
+    memset(b1, 0x55, sizeof(b1));
+    memset(b2, 0x55, sizeof(b2));
+    assert_true(jsdrv_union_eq_bounded(&jsdrv_union_u32(8), &jsdrv_union_u32(8), 0));
+    assert_false(jsdrv_union_eq_bounded(&jsdrv_union_u32(8), &jsdrv_union_u32(9), 0));
+    assert_false(jsdrv_union_eq_bounded(&jsdrv_union_u32(8), &jsdrv_union_u16(8), 0));
+    assert_true(jsdrv_union_eq_bounded(&jsdrv_union_f64(1.5), &jsdrv_union_f64(1.5), 0));
+    assert_true(jsdrv_union_eq_bounded(&jsdrv_union_bin(b1, 16), &jsdrv_union_bin(b2, 16), 16));
+    assert_false(jsdrv_union_eq_bounded(&jsdrv_union_bin(b1, 16), &jsdrv_union_bin(b2, 16), 15));
+    assert_false(jsdrv_union_eq_bounded(&jsdrv_union_bin(b1, 16), &jsdrv_union_bin(b2, 15), 16));
+    b2[15] = 0;
+    assert_false(jsdrv_union_eq_bounded(&jsdrv_union_bin(b1, 16), &jsdrv_union_bin(b2, 16), 16));
+    assert_true(jsdrv_union_eq_bounded(&jsdrv_union_str("hello"), &jsdrv_union_str("hello"), 16));
+}
+
 static void test_widen(void ** state) {
     (void) state;
     struct jsdrv_union_s v;
@@ -222,6 +240,7 @@ int main(void) {
             cmocka_unit_test(test_str_to_bool),
             cmocka_unit_test(test_json_to_bool),
             cmocka_unit_test(test_eq_exact),
+            cmocka_unit_test(test_eq_bounded),
             cmocka_unit_test(test_widen),
             cmocka_unit_test(test_equiv),
             cmocka_unit_test(test_as_type),
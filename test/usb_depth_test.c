@@ -0,0 +1,83 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/usb_depth.h"
+
+
+#define T0 (1000 * JSDRV_TIME_SECOND)
+
+static void test_fixed(void ** state) {
+    (void) state;
+    struct jsdrv_usb_depth_s d;
+    jsdrv_usb_depth_init(&d, 4, 0, T0);
+    assert_false(jsdrv_usb_depth_is_adaptive(&d));
+    assert_int_equal(4, jsdrv_usb_depth_pressure(&d, T0 + JSDRV_TIME_SECOND));
+    assert_int_equal(4, jsdrv_usb_depth_update(&d, T0 + JSDRV_TIME_MINUTE));
+    jsdrv_usb_depth_init(&d, 8, 4, T0);
+    assert_false(jsdrv_usb_depth_is_adaptive(&d));
+    assert_int_equal(8, d.depth_max);
+}
+
+static void test_grow(void ** state) {
+    (void) state;
+    struct jsdrv_usb_depth_s d;
+    int64_t t = T0;
+    jsdrv_usb_depth_init(&d, 4, 20, t);
+    assert_true(jsdrv_usb_depth_is_adaptive(&d));
+    assert_int_equal(8, jsdrv_usb_depth_pressure(&d, t));
+    assert_int_equal(8, jsdrv_usb_depth_pressure(&d, t + JSDRV_USB_DEPTH_HOLD / 2));  // hold
+    t += JSDRV_USB_DEPTH_HOLD;
+    assert_int_equal(16, jsdrv_usb_depth_pressure(&d, t));
+    t += JSDRV_USB_DEPTH_HOLD;
+    assert_int_equal(20, jsdrv_usb_depth_pressure(&d, t));
+    t += JSDRV_USB_DEPTH_HOLD;
+    assert_int_equal(20, jsdrv_usb_depth_pressure(&d, t));
+}
+
+static void test_shrink(void ** state) {
+    (void) state;
+    struct jsdrv_usb_depth_s d;
+    int64_t t = T0;
+    jsdrv_usb_depth_init(&d, 4, 64, t);
+    jsdrv_usb_depth_pressure(&d, t);
+    assert_int_equal(8, jsdrv_usb_depth_update(&d, t + JSDRV_USB_DEPTH_QUIET - 1));
+    t += JSDRV_USB_DEPTH_QUIET;
+    assert_int_equal(7, jsdrv_usb_depth_update(&d, t));
+    assert_int_equal(7, jsdrv_usb_depth_update(&d, t + 1));
+    jsdrv_usb_depth_pressure(&d, t + JSDRV_USB_DEPTH_QUIET / 2);  // restarts the quiet time
+    assert_int_equal(14, d.depth);
+    t += JSDRV_USB_DEPTH_QUIET;
+    assert_int_equal(14, jsdrv_usb_depth_update(&d, t));
+    for (uint32_t k = 0; k < 20; ++k) {
+        t += JSDRV_USB_DEPTH_QUIET;
+        jsdrv_usb_depth_update(&d, t);
+    }
+    assert_int_equal(4, d.depth);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_fixed),
+            cmocka_unit_test(test_grow),
+            cmocka_unit_test(test_shrink),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <string.h>
+#include "jsdrv_prv/usb_trace.h"
+#include "jsdrv/error_code.h"
+
+
+#define PATH "usb_trace_test.usbtrace"
+#define PREFIX "u/js220/000415"
+#define BULK_COUNT (1000U)
+
+static uint8_t buf_[65536];
+
+static uint32_t bulk_fill(uint32_t k) {
+    uint32_t sz = 512U * (1 + (k * 37) % 64);
+    for (uint32_t i = 0; i < sz; ++i) {
+        buf_[i] = (uint8_t) (k + i);
+    }
+    return sz;
+}
+
+static void test_path(void **state) {
+    (void) state;
+    char path[64];
+    assert_int_equal(0, jsdrv_usb_trace_path("/tmp", PREFIX, path, sizeof(path)));
+    assert_string_equal("/tmp/js220_000415.usbtrace", path);
+    assert_int_equal(JSDRV_ERROR_TOO_SMALL, jsdrv_usb_trace_path("/tmp", PREFIX, path, 16));
+}
+
+static void test_roundtrip(void **state) {
+    (void) state;
+    struct jsdrv_usb_trace_header_s header;
+    struct jsdrv_usb_trace_record_s record;
+    struct jsdrv_usb_trace_status_s status;
+    const uint8_t * payload;
+    uint8_t ctrl[3] = {1, 2, 3};
+
+    struct jsdrv_usb_trace_s * t = jsdrv_usb_trace_open(PATH, PREFIX);
+    assert_non_null(t);
+    assert_int_equal(0, jsdrv_usb_trace_write(t, JSDRV_USB_TRACE_CTRL_IN, 0, 0x0003000000c0ULL, 0, ctrl, sizeof(ctrl)));
+    assert_int_equal(0, jsdrv_usb_trace_write(t, JSDRV_USB_TRACE_BULK_OUT, 0x01, 0, 0, ctrl, 2));
+    for (uint32_t k = 0; k < BULK_COUNT; ++k) {
+        assert_int_equal(0, jsdrv_usb_trace_write(t, JSDRV_USB_TRACE_BULK_IN, 0x82, 0, 0, buf_, bulk_fill(k)));
+    }
+    assert_int_equal(0, jsdrv_usb_trace_write(t, JSDRV_USB_TRACE_CTRL_OUT, 0, 1, JSDRV_ERROR_IO, NULL, 0));
+    assert_int_equal(JSDRV_ERROR_PARAMETER_INVALID, jsdrv_usb_trace_write(t, JSDRV_USB_TRACE_END, 0, 0, 0, NULL, 0));
+    assert_int_equal(0, jsdrv_usb_trace_write(NULL, JSDRV_USB_TRACE_BULK_IN, 0x82, 0, 0, buf_, 512));
+    jsdrv_usb_trace_status(t, &status);
+    assert_int_equal(BULK_COUNT + 3, status.record_count);
+    assert_int_equal(0, status.drop_count);
+    assert_int_equal(0, jsdrv_usb_trace_close(t));
+
+    struct jsdrv_usb_trace_reader_s * r = jsdrv_usb_trace_reader_open(PATH, &header);
+    assert_non_null(r);
+    assert_string_equal(PREFIX, header.prefix);
+    assert_int_equal(JSDRV_USB_TRACE_VERSION, header.version);
+    for (int pass = 0; pass < 2; ++pass) {
+        assert_int_equal(0, jsdrv_usb_trace_reader_next(r, &record, &payload));
+        assert_int_equal(JSDRV_USB_TRACE_CTRL_IN, record.type);
+        assert_int_equal(0x0003000000c0ULL, record.setup);
+        assert_int_equal(sizeof(ctrl), record.payload_size);
+        assert_memory_equal(ctrl, payload, sizeof(ctrl));
+        assert_int_equal(0, jsdrv_usb_trace_reader_next(r, &record, NULL));
+        assert_int_equal(JSDRV_USB_TRACE_BULK_OUT, record.type);
+        assert_int_equal(0x01, record.endpoint);
+        int64_t time_prev = record.time;
+        for (uint32_t k = 0; k < BULK_COUNT; ++k) {
+            assert_int_equal(0, jsdrv_usb_trace_reader_next(r, &record, pass ? NULL : &payload));
+            uint32_t sz = bulk_fill(k);
+            assert_int_equal(JSDRV_USB_TRACE_BULK_IN, record.type);
+            assert_int_equal(0x82, record.endpoint);
+            assert_int_equal(sz, record.payload_size);
+            assert_true(record.time >= time_prev);
+            if (!pass) {
+                assert_memory_equal(buf_, payload, sz);
+            }
+            time_prev = record.time;
+        }
+        assert_int_equal(0, jsdrv_usb_trace_reader_next(r, &record, &payload));
+        assert_int_equal(JSDRV_USB_TRACE_CTRL_OUT, record.type);
+        assert_int_equal(JSDRV_ERROR_IO, record.status);
+        assert_int_equal(0, record.payload_size);
+        assert_int_equal(0, jsdrv_usb_trace_reader_next(r, &record, &payload));
+        assert_int_equal(JSDRV_USB_TRACE_END, record.type);
+        memcpy(&status, payload, sizeof(status));
+        assert_int_equal(BULK_COUNT + 3, status.record_count);
+        assert_int_equal(0, status.drop_count);
+        assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_usb_trace_reader_next(r, &record, &payload));
+        assert_int_equal(0, jsdrv_usb_trace_reader_rewind(r));
+    }
+    jsdrv_usb_trace_reader_close(r);
+    remove(PATH);
+}
+
+static void test_truncated(void **state) {
+    (void) state;
+    struct jsdrv_usb_trace_header_s header;
+    struct jsdrv_usb_trace_record_s record;
+    const uint8_t * payload;
+    struct jsdrv_usb_trace_s * t = jsdrv_usb_trace_open(PATH, PREFIX);
+    assert_non_null(t);
+    assert_int_equal(0, jsdrv_usb_trace_write(t, JSDRV_USB_TRACE_BULK_IN, 0x82, 0, 0, buf_, bulk_fill(1)));
+    assert_int_equal(0, jsdrv_usb_trace_close(t));
+
+    FILE * f = fopen(PATH, "rb");
+    assert_non_null(f);
+    size_t n = fread(buf_, 1, sizeof(buf_), f);
+    fclose(f);
+    assert_true(n > 100);
+    f = fopen(PATH, "wb");
+    assert_non_null(f);
+    fwrite(buf_, 1, n - 100, f);  // truncate into the bulk in payload
+    fclose(f);
+
+    struct jsdrv_usb_trace_reader_s * r = jsdrv_usb_trace_reader_open(PATH, &header);
+    assert_non_null(r);
+    assert_int_equal(JSDRV_ERROR_IO, jsdrv_usb_trace_reader_next(r, &record, &payload));
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_usb_trace_reader_next(r, &record, &payload));
+    jsdrv_usb_trace_reader_close(r);
+
+    buf_[0] = 'x';  // corrupt magic
+    f = fopen(PATH, "wb");
+    assert_non_null(f);
+    fwrite(buf_, 1, n, f);
+    fclose(f);
+    assert_null(jsdrv_usb_trace_reader_open(PATH, &header));
+    assert_null(jsdrv_usb_trace_reader_open("usb_trace_test_missing.usbtrace", &header));
+    remove(PATH);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_path),
+            cmocka_unit_test(test_roundtrip),
+            cmocka_unit_test(test_truncated),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
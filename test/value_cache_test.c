@@ -0,0 +1,159 @@
+/*
+ * Copyright 2026 Jetperch LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include "jsdrv_prv/value_cache.h"
+#include "jsdrv_prv/atomic.h"
+#include "jsdrv_prv/pubsub.h"
+#include "jsdrv_prv/thread.h"
+#include "jsdrv/error_code.h"
+#include "tinyprintf.h"
+#include <string.h>
+
+
+#define WRITES (200000U)
+
+static void set(struct jsdrv_value_cache_s * c, const char * topic, const struct jsdrv_union_s * value) {
+    jsdrv_value_cache_set(c, topic, jsdrv_pubsub_topic_hash(topic), value);
+}
+
+static void test_set_get(void ** state) {
+    (void) state;
+    struct jsdrv_union_s v;
+    struct jsdrv_value_cache_s * c = jsdrv_value_cache_alloc();
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_value_cache_get(c, "u/js220/1/h/fs", &v));
+    set(c, "u/js220/1/h/fs", &jsdrv_union_u32_r(1000000));
+    assert_int_equal(0, jsdrv_value_cache_get(c, "u/js220/1/h/fs", &v));
+    assert_int_equal(JSDRV_UNION_U32, v.type);
+    assert_int_equal(1000000, v.value.u32);
+    set(c, "u/js220/1/h/fs", &jsdrv_union_u32_r(1000));
+    assert_int_equal(0, jsdrv_value_cache_get(c, "u/js220/1/h/fs", &v));
+    assert_int_equal(1000, v.value.u32);
+
+    set(c, "u/js220/1/h/fs", NULL);
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_value_cache_get(c, "u/js220/1/h/fs", &v));
+    set(c, "u/js220/1/h/fs", &jsdrv_union_u32_r(10));
+    assert_int_equal(0, jsdrv_value_cache_get(c, "u/js220/1/h/fs", &v));
+    assert_int_equal(10, v.value.u32);
+
+    set(c, "u/js220/1/c/name", &jsdrv_union_cstr_r("hello"));  // pointer values are not cached
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_value_cache_get(c, "u/js220/1/c/name", &v));
+    jsdrv_value_cache_free(c);
+}
+
+static void test_direct(void ** state) {
+    (void) state;
+    struct jsdrv_union_s v;
+    const char * topic = "u/js220/1/s/i/ctrl";
+    uint32_t hash = jsdrv_pubsub_topic_hash(topic);
+    struct jsdrv_value_cache_s * c = jsdrv_value_cache_alloc();
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_value_cache_direct_get(c, topic, &v));
+    jsdrv_value_cache_direct_set(c, topic, hash, false);  // no entry
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_value_cache_direct_get(c, topic, &v));
+
+    jsdrv_value_cache_direct_set(c, topic, hash, true);
+    assert_int_equal(0, jsdrv_value_cache_direct_get(c, topic, &v));
+    assert_int_equal(JSDRV_UNION_NULL, v.type);
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_value_cache_get(c, topic, &v));
+
+    set(c, topic, &jsdrv_union_u8_r(1));
+    assert_int_equal(0, jsdrv_value_cache_direct_get(c, topic, &v));
+    assert_int_equal(JSDRV_UNION_U8, v.type);
+    assert_int_equal(1, v.value.u8);
+    set(c, topic, NULL);  // keeps direct
+    assert_int_equal(0, jsdrv_value_cache_direct_get(c, topic, &v));
+    assert_int_equal(JSDRV_UNION_NULL, v.type);
+
+    jsdrv_value_cache_direct_set(c, topic, hash, false);
+    assert_int_equal(JSDRV_ERROR_UNAVAILABLE, jsdrv_value_cache_direct_get(c, topic, &v));
+    jsdrv_value_cache_free(c);
+}
+
+static void test_full(void ** state) {
+    (void) state;
+    char topic[32];
+    struct jsdrv_union_s v;
+    uint32_t cached = 0;
+    struct jsdrv_value_cache_s * c = jsdrv_value_cache_alloc();
+    for (uint32_t idx = 0; idx < JSDRV_VALUE_CACHE_SIZE; ++idx) {
+        tfp_snprintf(topic, sizeof(topic), "t/%u", (unsigned int) idx);
+        set(c, topic, &jsdrv_union_u32_r(idx));
+    }
+    for (uint32_t idx = 0; idx < JSDRV_VALUE_CACHE_SIZE; ++idx) {
+        tfp_snprintf(topic, sizeof(topic), "t/%u", (unsigned int) idx);
+        if (0 == jsdrv_value_cache_get(c, topic, &v)) {
+            assert_int_equal(idx, v.value.u32);
+            ++cached;
+        }
+    }
+    assert_true(cached >= (JSDRV_VALUE_CACHE_SIZE / 2));
+    assert_true(cached < JSDRV_VALUE_CACHE_SIZE);
+    jsdrv_value_cache_free(c);
+}
+
+struct reader_s {
+    struct jsdrv_value_cache_s * c;
+    volatile int32_t quit;
+    volatile int32_t torn;
+    volatile int32_t reads;
+};
+
+static THREAD_RETURN_TYPE reader_thread(THREAD_ARG_TYPE lpParam) {
+    struct reader_s * r = (struct reader_s *) lpParam;
+    struct jsdrv_union_s v;
+    while (!jsdrv_atomic_load(&r->quit)) {
+        if (0 == jsdrv_value_cache_get(r->c, "a/b/c", &v)) {
+            if (v.size != (uint32_t) v.value.u64) {
+                jsdrv_atomic_add(&r->torn, 1);
+            }
+            jsdrv_atomic_add(&r->reads, 1);
+        }
+    }
+    THREAD_RETURN();
+}
+
+static void test_concurrent(void ** state) {
+    (void) state;
+    jsdrv_thread_t thread;
+    struct reader_s r = {.c = jsdrv_value_cache_alloc()};
+    struct jsdrv_union_s v = jsdrv_union_u64(0);
+    set(r.c, "a/b/c", &v);
+    assert_int_equal(0, jsdrv_thread_create(&thread, reader_thread, &r, 0));
+    for (uint64_t k = 1; k <= WRITES; ++k) {
+        v.value.u64 = k;
+        v.size = (uint32_t) k;  // must always match value.u64
+        set(r.c, "a/b/c", &v);
+    }
+    jsdrv_atomic_store(&r.quit, 1);
+    jsdrv_thread_join(&thread, 1000);
+    assert_int_equal(0, r.torn);
+    assert_true(r.reads > 0);
+    jsdrv_value_cache_free(r.c);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+            cmocka_unit_test(test_set_get),
+            cmocka_unit_test(test_direct),
+            cmocka_unit_test(test_full),
+            cmocka_unit_test(test_concurrent),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}